@@ -0,0 +1,110 @@
+dnl ===================================================================
+dnl   Licensed to the Apache Software Foundation (ASF) under one
+dnl   or more contributor license agreements.  See the NOTICE file
+dnl   distributed with this work for additional information
+dnl   regarding copyright ownership.  The ASF licenses this file
+dnl   to you under the Apache License, Version 2.0 (the
+dnl   "License"); you may not use this file except in compliance
+dnl   with the License.  You may obtain a copy of the License at
+dnl
+dnl     http://www.apache.org/licenses/LICENSE-2.0
+dnl
+dnl   Unless required by applicable law or agreed to in writing,
+dnl   software distributed under the License is distributed on an
+dnl   "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+dnl   KIND, either express or implied.  See the License for the
+dnl   specific language governing permissions and limitations
+dnl   under the License.
+dnl ===================================================================
+dnl
+dnl SVN_OPENSSL
+dnl
+dnl Check for the optional OpenSSL library, which provides TLS for the
+dnl svn:// protocol.  The default behaviour is to use pkg-config to look
+dnl for libssl and if that fails to simply try linking -lssl -lcrypto.
+dnl TLS support is disabled if neither works.
+dnl
+dnl The user can specify --with-openssl=PREFIX to look in PREFIX or
+dnl --without-openssl to disable TLS support.
+
+AC_DEFUN(SVN_OPENSSL,
+[
+  AC_ARG_WITH([openssl],
+    [AS_HELP_STRING([--with-openssl=PREFIX],
+                    [look for the OpenSSL library in PREFIX to enable
+                     TLS for svn:// connections])],
+    [
+      if test "$withval" = yes; then
+        openssl_prefix=std
+      else
+        openssl_prefix="$withval"
+      fi
+      openssl_required=yes
+    ],
+    [
+      openssl_prefix=std
+      openssl_required=no
+    ])
+
+  openssl_found=no
+  if test "$openssl_prefix" = "no"; then
+    AC_MSG_NOTICE([OpenSSL support disabled])
+  else
+    if test "$openssl_prefix" = "std"; then
+      SVN_OPENSSL_STD
+    else
+      SVN_OPENSSL_PREFIX
+    fi
+    if test "$openssl_found" = "yes"; then
+      AC_DEFINE([SVN_HAVE_OPENSSL], [1],
+                [Defined if TLS support for svn:// is enabled])
+    elif test "$openssl_required" = "yes"; then
+      AC_MSG_ERROR([--with-openssl requested, but OpenSSL >= 1.1.1 not found])
+    fi
+  fi
+  AC_SUBST(SVN_OPENSSL_INCLUDES)
+  AC_SUBST(SVN_OPENSSL_LIBS)
+])
+
+AC_DEFUN(SVN_OPENSSL_STD,
+[
+  if test -n "$PKG_CONFIG"; then
+    AC_MSG_CHECKING([for OpenSSL library via pkg-config])
+    if $PKG_CONFIG openssl --atleast-version=1.1.1; then
+      AC_MSG_RESULT([yes])
+      openssl_found=yes
+      SVN_OPENSSL_INCLUDES=`$PKG_CONFIG openssl --cflags`
+      SVN_OPENSSL_LIBS=`$PKG_CONFIG openssl --libs`
+      SVN_OPENSSL_LIBS="`SVN_REMOVE_STANDARD_LIB_DIRS($SVN_OPENSSL_LIBS)`"
+    else
+      AC_MSG_RESULT([no])
+    fi
+  fi
+  if test "$openssl_found" != "yes"; then
+    AC_MSG_NOTICE([OpenSSL configuration without pkg-config])
+    AC_CHECK_HEADER(openssl/ssl.h, [
+      AC_CHECK_LIB(ssl, OPENSSL_init_ssl, [
+        openssl_found=yes
+        SVN_OPENSSL_LIBS="-lssl -lcrypto"
+      ], [], [-lcrypto])
+    ])
+  fi
+])
+
+AC_DEFUN(SVN_OPENSSL_PREFIX,
+[
+  AC_MSG_NOTICE([OpenSSL configuration via prefix])
+  save_cppflags="$CPPFLAGS"
+  CPPFLAGS="$CPPFLAGS -I$openssl_prefix/include"
+  save_ldflags="$LDFLAGS"
+  LDFLAGS="$LDFLAGS -L$openssl_prefix/lib"
+  AC_CHECK_HEADER(openssl/ssl.h, [
+    AC_CHECK_LIB(ssl, OPENSSL_init_ssl, [
+      openssl_found=yes
+      SVN_OPENSSL_INCLUDES="-I$openssl_prefix/include"
+      SVN_OPENSSL_LIBS="`SVN_REMOVE_STANDARD_LIB_DIRS(-L$openssl_prefix/lib)` -lssl -lcrypto"
+    ], [], [-lcrypto])
+  ])
+  LDFLAGS="$save_ldflags"
+  CPPFLAGS="$save_cppflags"
+])
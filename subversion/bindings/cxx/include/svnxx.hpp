@@ -30,6 +30,7 @@
 #include "svnxx/init.hpp"
 #include "svnxx/exception.hpp"
 #include "svnxx/revision.hpp"
+#include "svnxx/stream.hpp"
 #include "svnxx/tristate.hpp"
 
 #include "svnxx/client.hpp"
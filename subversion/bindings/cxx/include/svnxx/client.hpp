@@ -34,6 +34,7 @@
  * TODO: document this
  */
 
+#include "client/cat.hpp"
 #include "client/context.hpp"
 #include "client/status.hpp"
 
@@ -0,0 +1,99 @@
+/**
+ * @file svnxx/client/cat.hpp
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+#ifndef SVNXX_CLIENT_CAT_HPP
+#define SVNXX_CLIENT_CAT_HPP
+
+#include "svnxx/detail/future.hpp"
+#include "svnxx/client/context.hpp"
+
+#include "svnxx/revision.hpp"
+#include "svnxx/stream.hpp"
+
+namespace apache {
+namespace subversion {
+namespace svnxx {
+namespace client {
+
+/**
+ * @ingroup svnxx_client
+ * @brief Retrieve the contents of the file @a path_or_url.
+ *
+ * The contents are passed to @a callback in blocks as they are read
+ * from the repository or the working copy, without being copied into
+ * intermediate buffers.
+ *
+ * @param ctx the #context object to use for this operation
+ * @param path_or_url the working copy path or URL of the file
+ * @param peg the peg revision of @a path_or_url
+ * @param rev the revision of the file to retrieve
+ * @param expand_keywords whether to expand keywords in the contents
+ * @param callback a function that receives the file contents
+ * @see svn_client_cat3
+ */
+void
+cat(context& ctx, const char* path_or_url,
+    const revision& peg, const revision& rev, bool expand_keywords,
+    stream_callback callback);
+
+namespace async {
+
+/**
+ * @ingroup svnxx_client
+ * @brief Retrieve the contents of a file asynchronously.
+ *
+ * Behaves as if svn::client::cat() were invoked through
+ * <tt>std::async()</tt>, but runs the operation in its own pool
+ * and maintains the lifetime of internal state relevant to it.
+ * Any number of these operations can use the same @a ctx at the
+ * same time.
+ *
+ * @warning Any callbacks registered in @a ctx, as well as the
+ *          content @a callback itself, may be called in the context
+ *          of a different thread than the one that created this
+ *          asynchronous operation.
+ */
+svnxx::detail::future<void>
+cat(std::launch policy, context& ctx, const char* path_or_url,
+    const revision& peg, const revision& rev, bool expand_keywords,
+    stream_callback callback);
+
+/**
+ * @overload
+ * @ingroup svnxx_client
+ * @note Uses the <tt>std::launch</tt> @a policy set to
+ *       <tt>std::launch::async|std::launch::deferred</tt>.
+ */
+svnxx::detail::future<void>
+cat(context& ctx, const char* path_or_url,
+    const revision& peg, const revision& rev, bool expand_keywords,
+    stream_callback callback);
+
+} // namespace async
+} // namespace client
+} // namespace svnxx
+} // namespace subversion
+} // namespace apache
+
+#endif  // SVNXX_CLIENT_CAT_HPP
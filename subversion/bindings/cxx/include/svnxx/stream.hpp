@@ -0,0 +1,83 @@
+/**
+ * @file svnxx/stream.hpp
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+#ifndef SVNXX_STREAM_HPP
+#define SVNXX_STREAM_HPP
+
+#include <cstddef>
+#include <functional>
+
+namespace apache {
+namespace subversion {
+namespace svnxx {
+
+/**
+ * @brief A read-only view of a contiguous block of bytes.
+ *
+ * The view does not own the data it refers to. Views passed to a
+ * #stream_callback refer to buffers owned by the library and are
+ * only valid for the duration of the callback; copy the data if it
+ * is needed later.
+ */
+class buffer_view
+{
+public:
+  buffer_view() noexcept
+    : data_(nullptr), size_(0)
+    {}
+
+  buffer_view(const char* data, std::size_t size) noexcept
+    : data_(data), size_(size)
+    {}
+
+  /** Return a pointer to the first byte of the buffer. */
+  const char* data() const noexcept { return data_; }
+
+  /** Return the number of bytes in the buffer. */
+  std::size_t size() const noexcept { return size_; }
+
+  /** Return @c true if the buffer contains no data. */
+  bool empty() const noexcept { return size_ == 0; }
+
+  const char* begin() const noexcept { return data_; }
+  const char* end() const noexcept { return data_ + size_; }
+
+private:
+  const char* data_;
+  std::size_t size_;
+};
+
+/**
+ * @brief Receives the data written to a stream, one block at a time.
+ *
+ * The callback may throw svn::stop_iteration to abort the operation
+ * that produces the data.
+ */
+using stream_callback = std::function<void(const buffer_view& data)>;
+
+} // namespace svnxx
+} // namespace subversion
+} // namespace apache
+
+#endif  // SVNXX_STREAM_HPP
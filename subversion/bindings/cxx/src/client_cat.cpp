@@ -0,0 +1,108 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+#include "svnxx/client/cat.hpp"
+
+#include "aprwrap.hpp"
+#include "private.hpp"
+
+#include "svn_client.h"
+
+namespace apache {
+namespace subversion {
+namespace svnxx {
+
+namespace impl {
+
+void
+cat(svn_client_ctx_t* ctx, const char* path_or_url,
+    const svn_opt_revision_t* peg, const svn_opt_revision_t* rev,
+    bool expand_keywords, stream_callback& callback,
+    apr_pool_t* scratch_pool)
+{
+  svn_stream_t* const out = make_callback_stream(callback, scratch_pool);
+  impl::checked_call(
+      svn_client_cat3(nullptr, out, path_or_url, peg, rev,
+                      expand_keywords, ctx,
+                      scratch_pool, scratch_pool));
+}
+
+} // namespace impl
+namespace client {
+
+void
+cat(context& ctx_, const char* path_or_url,
+    const revision& peg_, const revision& rev_, bool expand_keywords,
+    stream_callback callback)
+{
+  const auto ctx = impl::unwrap(ctx_);
+  const auto peg = impl::convert(peg_);
+  const auto rev = impl::convert(rev_);
+  const auto scratch_pool = apr::pool(&ctx->get_pool());
+  impl::cat(ctx->get_ctx(), path_or_url, &peg, &rev, expand_keywords,
+            callback, scratch_pool.get());
+}
+
+namespace async {
+
+svnxx::detail::future<void>
+cat(std::launch policy, context& ctx_, const char* path_or_url,
+    const revision& peg_, const revision& rev_, bool expand_keywords,
+    stream_callback callback)
+{
+  detail::weak_context_ptr weak_ctx = impl::unwrap(ctx_);
+  return impl::future<void>(
+      std::async(
+          policy,
+          [weak_ctx, path_or_url, peg_, rev_, expand_keywords, callback]
+            () mutable
+            {
+              auto ctx = weak_ctx.lock();
+              if (!ctx)
+                return;
+
+              const auto peg = impl::convert(peg_);
+              const auto rev = impl::convert(rev_);
+              const auto scratch_pool = apr::pool(&ctx->get_pool());
+
+              impl::cat(ctx->get_ctx(), path_or_url, &peg, &rev,
+                        expand_keywords, callback, scratch_pool.get());
+            }),
+      impl::make_future_result());
+}
+
+svnxx::detail::future<void>
+cat(context& ctx_, const char* path_or_url,
+    const revision& peg_, const revision& rev_, bool expand_keywords,
+    stream_callback callback)
+{
+  constexpr std::launch policy = std::launch::async | std::launch::deferred;
+  return cat(policy, ctx_, path_or_url, peg_, rev_, expand_keywords,
+             callback);
+}
+
+} // namespace async
+} // namespace client
+} // namespace svnxx
+} // namespace subversion
+} // namespace apache
@@ -28,6 +28,7 @@
 #include "private/exception_private.hpp"
 #include "private/future_private.hpp"
 #include "private/revision_private.hpp"
+#include "private/stream_private.hpp"
 #include "private/strings_private.hpp"
 #include "private/tristate_private.hpp"
 
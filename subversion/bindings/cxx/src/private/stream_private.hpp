@@ -0,0 +1,49 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+#ifndef SVNXX_PRIVATE_STREAM_HPP
+#define SVNXX_PRIVATE_STREAM_HPP
+
+#include "svnxx/stream.hpp"
+
+#include "svn_io.h"
+
+namespace apache {
+namespace subversion {
+namespace svnxx {
+namespace impl {
+
+/**
+ * Create a write-only stream in @a result_pool that passes every
+ * block written to it directly to @a callback, without copying it.
+ * The @a callback object must outlive the stream.
+ */
+svn_stream_t* make_callback_stream(stream_callback& callback,
+                                   apr_pool_t* result_pool);
+
+} // namespace impl
+} // namespace svnxx
+} // namespace subversion
+} // namespace apache
+
+#endif // SVNXX_PRIVATE_STREAM_HPP
@@ -0,0 +1,62 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+#include "private/stream_private.hpp"
+#include "private/exception_private.hpp"
+
+namespace apache {
+namespace subversion {
+namespace svnxx {
+namespace impl {
+
+namespace {
+svn_error_t* write_handler(void* baton, const char* data, apr_size_t* len)
+{
+  const auto callback = static_cast<stream_callback*>(baton);
+  if (*callback)
+    {
+      try
+        {
+          (*callback)(buffer_view(data, *len));
+        }
+      catch (const stop_iteration&)
+        {
+          return impl::iteration_stopped();
+        }
+    }
+  return SVN_NO_ERROR;
+}
+} // anonymous namespace
+
+svn_stream_t* make_callback_stream(stream_callback& callback,
+                                   apr_pool_t* result_pool)
+{
+  svn_stream_t* const stream = svn_stream_create(&callback, result_pool);
+  svn_stream_set_write(stream, write_handler);
+  return stream;
+}
+
+} // namespace impl
+} // namespace svnxx
+} // namespace subversion
+} // namespace apache
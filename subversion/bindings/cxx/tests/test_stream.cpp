@@ -0,0 +1,88 @@
+/*
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+
+#include "fixture_init.hpp"
+
+#include "../src/aprwrap.hpp"
+#include "../src/private/exception_private.hpp"
+#include "../src/private/stream_private.hpp"
+
+namespace svn = ::apache::subversion::svnxx;
+namespace impl = ::apache::subversion::svnxx::impl;
+
+BOOST_AUTO_TEST_SUITE(stream,
+                      * boost::unit_test::fixture<init>());
+
+BOOST_AUTO_TEST_CASE(buffer_view)
+{
+  const char data[] = "abc";
+  const svn::buffer_view view(data, 3);
+  BOOST_TEST(view.data() == data);
+  BOOST_TEST(view.size() == 3);
+  BOOST_TEST(!view.empty());
+  BOOST_TEST(std::string(view.begin(), view.end()) == "abc");
+  BOOST_TEST(svn::buffer_view().empty());
+}
+
+BOOST_AUTO_TEST_CASE(callback_stream)
+{
+  const char data[] = "0123456789";
+  std::string received;
+  svn::stream_callback callback =
+    [&](const svn::buffer_view& view)
+      {
+        BOOST_TEST((view.data() == data || view.data() == data + 4));
+        received.append(view.begin(), view.end());
+      };
+
+  apr::pool scratch_pool;
+  svn_stream_t* const out = impl::make_callback_stream(callback,
+                                                       scratch_pool.get());
+  apr_size_t len = 4;
+  impl::checked_call(svn_stream_write(out, data, &len));
+  len = 6;
+  impl::checked_call(svn_stream_write(out, data + 4, &len));
+  impl::checked_call(svn_stream_close(out));
+  BOOST_TEST(received == data);
+}
+
+BOOST_AUTO_TEST_CASE(callback_stream_stop)
+{
+  svn::stream_callback callback =
+    [](const svn::buffer_view&)
+      {
+        throw svn::stop_iteration();
+      };
+
+  apr::pool scratch_pool;
+  svn_stream_t* const out = impl::make_callback_stream(callback,
+                                                       scratch_pool.get());
+  apr_size_t len = 1;
+  svn_error_t* const err = svn_stream_write(out, "x", &len);
+  BOOST_TEST((err && err->apr_err == SVN_ERR_ITER_BREAK));
+  svn_error_clear(err);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,224 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file LogMessageBatchCallback.cpp
+ * @brief Implementation of the class LogMessageBatchCallback
+ */
+
+#include "LogMessageBatchCallback.h"
+#include "JNIUtil.h"
+
+/**
+ * The number of bytes to collect before passing them to Java.
+ */
+#define BATCH_SIZE (64 * 1024)
+
+/**
+ * Create a LogMessageBatchCallback object
+ * @param jcallback the Java callback object.
+ */
+LogMessageBatchCallback::LogMessageBatchCallback(jobject jcallback)
+  : m_callback(jcallback), m_count(0)
+{
+  m_buffer.reserve(BATCH_SIZE);
+}
+
+/**
+ * Destroy a LogMessageBatchCallback object
+ */
+LogMessageBatchCallback::~LogMessageBatchCallback()
+{
+  // The m_callback does not need to be destroyed because it is the
+  // passed in parameter to the Java SVNClient.logMessageBatches
+  // method.
+}
+
+svn_error_t *
+LogMessageBatchCallback::callback(void *baton,
+                                  svn_log_entry_t *log_entry,
+                                  apr_pool_t *pool)
+{
+  if (baton)
+    return static_cast<LogMessageBatchCallback *>(baton)->singleMessage(
+            log_entry, pool);
+
+  return SVN_NO_ERROR;
+}
+
+void
+LogMessageBatchCallback::putByte(char value)
+{
+  m_buffer.push_back(value);
+}
+
+void
+LogMessageBatchCallback::putInt(apr_int32_t value)
+{
+  // Big-endian, which is the default byte order of a Java ByteBuffer.
+  apr_uint32_t bits = static_cast<apr_uint32_t>(value);
+  for (int shift = 24; shift >= 0; shift -= 8)
+    m_buffer.push_back(static_cast<char>((bits >> shift) & 0xff));
+}
+
+void
+LogMessageBatchCallback::putLong(apr_int64_t value)
+{
+  apr_uint64_t bits = static_cast<apr_uint64_t>(value);
+  for (int shift = 56; shift >= 0; shift -= 8)
+    m_buffer.push_back(static_cast<char>((bits >> shift) & 0xff));
+}
+
+void
+LogMessageBatchCallback::putBytes(const char *data, apr_size_t len)
+{
+  putInt(static_cast<apr_int32_t>(len));
+  m_buffer.insert(m_buffer.end(), data, data + len);
+}
+
+void
+LogMessageBatchCallback::putString(const char *str)
+{
+  if (str)
+    putBytes(str, strlen(str));
+  else
+    putInt(-1);
+}
+
+/**
+ * Map the svn_tristate_t value @a state to the ordinal of the Java
+ * Tristate enum.
+ */
+static char
+tristate_ordinal(svn_tristate_t state)
+{
+  switch (state)
+    {
+      case svn_tristate_false:
+        return 1;
+      case svn_tristate_true:
+        return 2;
+      default:
+        return 0;
+    }
+}
+
+/**
+ * Callback called for a single log message, which gets appended to the
+ * current batch.
+ */
+svn_error_t *
+LogMessageBatchCallback::singleMessage(svn_log_entry_t *log_entry,
+                                       apr_pool_t *pool)
+{
+  putLong(log_entry->revision);
+  putByte(log_entry->has_children ? 1 : 0);
+
+  if (log_entry->changed_paths2)
+    {
+      putInt(apr_hash_count(log_entry->changed_paths2));
+      for (apr_hash_index_t *hi = apr_hash_first(pool,
+                                                 log_entry->changed_paths2);
+           hi;
+           hi = apr_hash_next(hi))
+        {
+          const svn_log_changed_path2_t *log_item
+            = static_cast<const svn_log_changed_path2_t *>(
+                apr_hash_this_val(hi));
+
+          putString(static_cast<const char *>(apr_hash_this_key(hi)));
+          putByte(log_item->action);
+          putLong(log_item->copyfrom_rev);
+          putString(log_item->copyfrom_path);
+          putByte(static_cast<char>(log_item->node_kind));
+          putByte(tristate_ordinal(log_item->text_modified));
+          putByte(tristate_ordinal(log_item->props_modified));
+        }
+    }
+  else
+    putInt(-1);
+
+  if (log_entry->revprops && apr_hash_count(log_entry->revprops) > 0)
+    {
+      putInt(apr_hash_count(log_entry->revprops));
+      for (apr_hash_index_t *hi = apr_hash_first(pool, log_entry->revprops);
+           hi;
+           hi = apr_hash_next(hi))
+        {
+          const svn_string_t *value
+            = static_cast<const svn_string_t *>(apr_hash_this_val(hi));
+
+          putString(static_cast<const char *>(apr_hash_this_key(hi)));
+          putBytes(value->data, value->len);
+        }
+    }
+  else
+    putInt(-1);
+
+  ++m_count;
+  if (m_buffer.size() >= BATCH_SIZE)
+    return flush();
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+LogMessageBatchCallback::flush()
+{
+  if (m_count == 0)
+    return SVN_NO_ERROR;
+
+  JNIEnv *env = JNIUtil::getEnv();
+
+  // Create a local frame for our references
+  env->PushLocalFrame(LOCAL_FRAME_SIZE);
+  if (JNIUtil::isJavaExceptionThrown())
+    return SVN_NO_ERROR;
+
+  // The method id will not change during the time this library is
+  // loaded, so it can be cached.
+  static jmethodID sm_mid = 0;
+  if (sm_mid == 0)
+    {
+      jclass clazz = env->FindClass(
+          JAVAHL_CLASS("/callback/LogMessageBatchCallback"));
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(SVN_NO_ERROR);
+
+      sm_mid = env->GetMethodID(clazz, "messages",
+                                "(Ljava/nio/ByteBuffer;I)V");
+      if (JNIUtil::isJavaExceptionThrown())
+        POP_AND_RETURN(SVN_NO_ERROR);
+    }
+
+  // The Java side only sees the buffer for the duration of the call,
+  // so there is no need to copy it into the Java heap.
+  jobject jbatch = env->NewDirectByteBuffer(&m_buffer[0], m_buffer.size());
+  if (JNIUtil::isJavaExceptionThrown())
+    POP_AND_RETURN(SVN_NO_ERROR);
+
+  env->CallVoidMethod(m_callback, sm_mid, jbatch, m_count);
+
+  m_buffer.clear();
+  m_count = 0;
+
+  POP_AND_RETURN_EXCEPTION_AS_SVNERROR();
+}
@@ -0,0 +1,80 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file LogMessageBatchCallback.h
+ * @brief Interface of the class LogMessageBatchCallback
+ */
+
+#ifndef LOGMESSAGEBATCHCALLBACK_H
+#define LOGMESSAGEBATCHCALLBACK_H
+
+#include <jni.h>
+#include <vector>
+#include "svn_client.h"
+
+/**
+ * This class holds a Java callback object, which will receive the log
+ * messages in batches, encoded into a direct ByteBuffer as described in
+ * LogMessageBatchCallback.java.
+ */
+class LogMessageBatchCallback
+{
+ public:
+  LogMessageBatchCallback(jobject jcallback);
+  ~LogMessageBatchCallback();
+
+  static svn_error_t *callback(void *baton,
+                               svn_log_entry_t *log_entry,
+                               apr_pool_t *pool);
+
+  /**
+   * Pass the log messages encoded so far to the Java callback.
+   */
+  svn_error_t *flush();
+
+ protected:
+  svn_error_t *singleMessage(svn_log_entry_t *log_entry, apr_pool_t *pool);
+
+ private:
+  void putByte(char value);
+  void putInt(apr_int32_t value);
+  void putLong(apr_int64_t value);
+  void putBytes(const char *data, apr_size_t len);
+  void putString(const char *str);
+
+  /**
+   * A local reference to the corresponding Java object.
+   */
+  jobject m_callback;
+
+  /**
+   * The encoded log messages not yet passed to the Java callback.
+   */
+  std::vector<char> m_buffer;
+
+  /**
+   * The number of log messages in m_buffer.
+   */
+  jint m_count;
+};
+
+#endif  // LOGMESSAGEBATCHCALLBACK_H
@@ -269,7 +269,8 @@ void SVNClient::logMessages(const char *path, Revision &pegRevision,
                             bool stopOnCopy, bool discoverPaths,
                             bool includeMergedRevisions,
                             StringArray &revProps, bool allRevProps,
-                            int limit, LogMessageCallback *callback)
+                            int limit, svn_log_entry_receiver_t receiver,
+                            void *receiver_baton)
 {
     SVN::Pool subPool(pool);
 
@@ -295,7 +296,7 @@ void SVNClient::logMessages(const char *path, Revision &pegRevision,
     SVN_JNI_ERR(svn_client_log5(targets, pegRevision.revision(), ranges,
                                 limit, discoverPaths, stopOnCopy,
                                 includeMergedRevisions, revprops,
-                                LogMessageCallback::callback, callback, ctx,
+                                receiver, receiver_baton, ctx,
                                 subPool.getPool()), );
 }
 
@@ -173,7 +173,8 @@ class SVNClient :public SVNBase
                    std::vector<RevisionRange> &ranges, bool stopOnCopy,
                    bool discoverPaths, bool includeMergedRevisions,
                    StringArray &revProps, bool allRevProps,
-                   int limit, LogMessageCallback *callback);
+                   int limit, svn_log_entry_receiver_t receiver,
+                   void *receiver_baton);
   jobject getVersionExtended(bool verbose);
   jstring getAdminDirectoryName();
   jboolean isAdminDirectory(const char *name);
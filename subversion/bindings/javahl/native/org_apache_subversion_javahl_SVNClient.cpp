@@ -44,6 +44,7 @@
 #include "PatchCallback.h"
 #include "CommitCallback.h"
 #include "LogMessageCallback.h"
+#include "LogMessageBatchCallback.h"
 #include "InfoCallback.h"
 #include "StatusCallback.h"
 #include "ListCallback.h"
@@ -375,7 +376,74 @@ Java_org_apache_subversion_javahl_SVNClient_logMessages
                   jstopOnCopy ? true: false, jdisoverPaths ? true : false,
                   jincludeMergedRevisions ? true : false,
                   revProps, jallRevProps ? true : false,
-                  int(jlimit), &callback);
+                  int(jlimit), LogMessageCallback::callback, &callback);
+}
+
+JNIEXPORT void JNICALL
+Java_org_apache_subversion_javahl_SVNClient_logMessageBatches
+(JNIEnv *env, jobject jthis, jstring jpath, jobject jpegRevision,
+ jobject jranges, jboolean jstopOnCopy, jboolean jdisoverPaths,
+ jboolean jincludeMergedRevisions,
+ jobject jrevProps, jboolean jallRevProps,
+ jlong jlimit, jobject jlogMessageBatchCallback)
+{
+  JNIEntry(SVNClient, logMessageBatches);
+
+  if (jlong(int(jlimit)) != jlimit)
+    {
+      JNIUtil::raiseThrowable("java/lang/IllegalArgumentException",
+                              "The value of 'limit' is too large");
+      return;
+    }
+
+  SVNClient *cl = SVNClient::getCppObject(jthis);
+  if (cl == NULL)
+    {
+      JNIUtil::throwError(_("bad C++ this"));
+      return;
+    }
+  Revision pegRevision(jpegRevision, true);
+  if (JNIUtil::isExceptionThrown())
+    return;
+
+  JNIStringHolder path(jpath);
+  if (JNIUtil::isExceptionThrown())
+    return;
+
+  LogMessageBatchCallback callback(jlogMessageBatchCallback);
+
+  StringArray revProps(jrevProps);
+  if (JNIUtil::isExceptionThrown())
+    return;
+
+  // Build the revision range vector from the Java array.
+  Array ranges(jranges);
+  if (JNIUtil::isExceptionThrown())
+    return;
+
+  std::vector<RevisionRange> revisionRanges;
+  std::vector<jobject> rangeVec = ranges.vector();
+
+  for (std::vector<jobject>::const_iterator it = rangeVec.begin();
+        it < rangeVec.end(); ++it)
+    {
+      RevisionRange revisionRange(*it);
+      if (JNIUtil::isExceptionThrown())
+        return;
+
+      revisionRanges.push_back(revisionRange);
+    }
+
+  cl->logMessages(path, pegRevision, revisionRanges,
+                  jstopOnCopy ? true: false, jdisoverPaths ? true : false,
+                  jincludeMergedRevisions ? true : false,
+                  revProps, jallRevProps ? true : false,
+                  int(jlimit), LogMessageBatchCallback::callback, &callback);
+  if (JNIUtil::isExceptionThrown())
+    return;
+
+  // Deliver the messages of the last, incomplete batch.
+  SVN_JNI_ERR(callback.flush(), );
 }
 
 JNIEXPORT jlong JNICALL
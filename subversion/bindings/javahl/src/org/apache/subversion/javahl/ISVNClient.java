@@ -237,6 +237,25 @@ public interface ISVNClient
                      long limit, LogMessageCallback callback)
             throws ClientException;
 
+    /**
+     * Retrieve the log messages for an item in batches.
+     * <p>
+     * Behaves like {@link #logMessages(String, Revision, List, boolean,
+     * boolean, boolean, Set, boolean, long, LogMessageCallback)}, but
+     * passes the log messages to <code>callback</code> in compactly
+     * encoded batches, which is considerably cheaper for large logs.
+     * @param callback      the object to receive the batches of log
+     *                      messages
+     * @since 1.15
+     */
+    void logMessageBatches(String path, Revision pegRevision,
+                           List<RevisionRange> ranges, boolean stopOnCopy,
+                           boolean discoverPath,
+                           boolean includeMergedRevisions,
+                           Set<String> revProps, boolean allRevProps,
+                           long limit, LogMessageBatchCallback callback)
+            throws ClientException;
+
     /**
      * Executes a revision checkout.
      * @param moduleName name of the module to checkout.
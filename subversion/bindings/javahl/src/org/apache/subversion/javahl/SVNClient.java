@@ -206,6 +206,16 @@ public class SVNClient implements ISVNClient
                                    long limit, LogMessageCallback callback)
             throws ClientException;
 
+    public native void logMessageBatches(String path, Revision pegRevision,
+                                         List<RevisionRange> revisionRanges,
+                                         boolean stopOnCopy,
+                                         boolean discoverPath,
+                                         boolean includeMergedRevisions,
+                                         Set<String> revProps,
+                                         boolean allRevProps, long limit,
+                                         LogMessageBatchCallback callback)
+            throws ClientException;
+
     public native long checkout(String moduleName, String destPath,
                                 Revision revision, Revision pegRevision,
                                 Depth depth, boolean ignoreExternals,
@@ -0,0 +1,83 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+package org.apache.subversion.javahl.callback;
+
+import org.apache.subversion.javahl.ISVNClient;
+
+import java.nio.ByteBuffer;
+
+/**
+ * This interface is used to receive the log messages found by a
+ * {@link ISVNClient#logMessageBatches} call in batches, which saves
+ * creating Java objects for each message in the native code.
+ * <p>
+ * Each batch contains <code>count</code> consecutive log messages in the
+ * same order as they would be passed to
+ * {@link LogMessageCallback#singleMessage}, including the messages with
+ * the revision set to SVN_INVALID_REVNUM that terminate lists of merged
+ * revisions.  All numbers are big-endian, the default byte order of
+ * {@link ByteBuffer}.  A log message is encoded as:
+ * <pre>
+ *   long     revision
+ *   byte     hasChildren (0 or 1)
+ *   int      number of changed paths, or -1 if they were not requested,
+ *            followed by that many changed paths:
+ *     string   path
+ *     byte     action ('A', 'D', 'R' or 'M')
+ *     long     copy source revision (-1 if none)
+ *     string   copy source path
+ *     byte     node kind (ordinal of {@link
+ *              org.apache.subversion.javahl.types.NodeKind})
+ *     byte     text modified (ordinal of {@link
+ *              org.apache.subversion.javahl.types.Tristate})
+ *     byte     properties modified (ordinal of {@link
+ *              org.apache.subversion.javahl.types.Tristate})
+ *   int      number of revision properties, or -1 if there are none,
+ *            followed by that many revision properties:
+ *     string   name
+ *     bytes    value
+ * </pre>
+ * A <code>string</code> is encoded as an <code>int</code> length
+ * followed by that many bytes of UTF-8, with a length of -1 denoting
+ * <code>null</code>.  <code>bytes</code> are encoded the same way, but
+ * are never <code>null</code>.
+ * <p>
+ * {@link LogMessageBatchDecoder} decodes the batches and passes the
+ * messages on to a {@link LogMessageCallback}.
+ *
+ * @since 1.15
+ */
+public interface LogMessageBatchCallback
+{
+    /**
+     * The method will be called for every batch of log messages.
+     * <p>
+     * The buffer refers to native memory that is only valid during
+     * this call; it must not be used after the method returns.
+     *
+     * @param batch     the encoded log messages
+     * @param count     the number of log messages in <code>batch</code>
+     */
+    public void messages(ByteBuffer batch, int count);
+}
@@ -0,0 +1,138 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ */
+
+package org.apache.subversion.javahl.callback;
+
+import org.apache.subversion.javahl.types.ChangePath;
+import org.apache.subversion.javahl.types.NodeKind;
+import org.apache.subversion.javahl.types.Tristate;
+
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+import java.util.HashMap;
+import java.util.HashSet;
+import java.util.Map;
+import java.util.Set;
+
+/**
+ * Decodes the batches passed to a {@link LogMessageBatchCallback} and
+ * passes each log message on to a {@link LogMessageCallback}.
+ *
+ * @since 1.15
+ */
+public class LogMessageBatchDecoder implements LogMessageBatchCallback
+{
+    private static final NodeKind[] nodeKinds = NodeKind.values();
+    private static final Tristate[] tristates = Tristate.values();
+
+    private final LogMessageCallback callback;
+
+    /**
+     * @param callback  the object to receive the decoded log messages
+     */
+    public LogMessageBatchDecoder(LogMessageCallback callback)
+    {
+        this.callback = callback;
+    }
+
+    public void messages(ByteBuffer batch, int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            long revision = batch.getLong();
+            boolean hasChildren = (batch.get() != 0);
+
+            Set<ChangePath> changedPaths = null;
+            int pathCount = batch.getInt();
+            if (pathCount >= 0)
+            {
+                changedPaths = new HashSet<ChangePath>(pathCount * 2);
+                for (int j = 0; j < pathCount; ++j)
+                {
+                    String path = getString(batch);
+                    ChangePath.Action action = getAction(batch.get());
+                    long copySrcRevision = batch.getLong();
+                    String copySrcPath = getString(batch);
+                    NodeKind nodeKind = nodeKinds[batch.get()];
+                    Tristate textMods = tristates[batch.get()];
+                    Tristate propMods = tristates[batch.get()];
+
+                    changedPaths.add(new ChangePath(path, copySrcRevision,
+                                                    copySrcPath, action,
+                                                    nodeKind, textMods,
+                                                    propMods));
+                }
+            }
+
+            Map<String, byte[]> revprops = null;
+            int propCount = batch.getInt();
+            if (propCount >= 0)
+            {
+                revprops = new HashMap<String, byte[]>(propCount * 2);
+                for (int j = 0; j < propCount; ++j)
+                {
+                    String name = getString(batch);
+                    revprops.put(name, getBytes(batch));
+                }
+            }
+
+            callback.singleMessage(changedPaths, revision, revprops,
+                                   hasChildren);
+        }
+    }
+
+    private static byte[] getBytes(ByteBuffer batch)
+    {
+        byte[] bytes = new byte[batch.getInt()];
+        batch.get(bytes);
+        return bytes;
+    }
+
+    private static String getString(ByteBuffer batch)
+    {
+        int len = batch.getInt();
+        if (len < 0)
+            return null;
+
+        byte[] bytes = new byte[len];
+        batch.get(bytes);
+        return new String(bytes, StandardCharsets.UTF_8);
+    }
+
+    private static ChangePath.Action getAction(byte action)
+    {
+        switch (action)
+        {
+          case 'A':
+            return ChangePath.Action.add;
+          case 'D':
+            return ChangePath.Action.delete;
+          case 'R':
+            return ChangePath.Action.replace;
+          case 'M':
+            return ChangePath.Action.modify;
+          default:
+            return null;
+        }
+    }
+}
@@ -2489,6 +2489,73 @@ public class BasicTests extends SVNTests
                                               ranges, false, true, false, 0);
     }
 
+    /**
+     * Test that SVNClient.logMessageBatches returns the same log
+     * messages as SVNClient.logMessages.
+     * @throws Throwable
+     * @since 1.15
+     */
+    public void testLogMessageBatches() throws Throwable
+    {
+        OneTest thisTest = new OneTest();
+        addExpectedCommitItem(thisTest.getWCPath(),
+                              thisTest.getUrl().toString(), "iota",
+                              NodeKind.file,
+                              CommitItemStateFlags.TextMods);
+        File iota = new File(thisTest.getWorkingCopy(), "iota");
+        PrintWriter pw = new PrintWriter(new FileOutputStream(iota, true));
+        pw.print("more");
+        pw.close();
+        checkCommitRevision(thisTest, "wrong revision number from commit", 2,
+                            thisTest.getWCPathSet(), "log msg", Depth.infinity,
+                            false, false, null, null);
+
+        class Collector implements LogMessageCallback
+        {
+            List<Long> revisions = new ArrayList<Long>();
+            List<Set<ChangePath>> changedPaths =
+                new ArrayList<Set<ChangePath>>();
+            List<String> messages = new ArrayList<String>();
+
+            public void singleMessage(Set<ChangePath> paths, long revision,
+                                      Map<String, byte[]> revprops,
+                                      boolean hasChildren)
+            {
+                revisions.add(revision);
+                changedPaths.add(paths);
+                messages.add(new String(revprops.get("svn:log")));
+            }
+        }
+
+        List<RevisionRange> ranges = new ArrayList<RevisionRange>(1);
+        ranges.add(new RevisionRange(null, null));
+
+        Collector expected = new Collector();
+        client.logMessages(thisTest.getWCPath(), null, ranges, false, true,
+                           false, null, true, 0, expected);
+        Collector actual = new Collector();
+        client.logMessageBatches(thisTest.getWCPath(), null, ranges, false,
+                                 true, false, null, true, 0,
+                                 new LogMessageBatchDecoder(actual));
+
+        assertEquals("wrong revisions", expected.revisions, actual.revisions);
+        assertEquals("wrong messages", expected.messages, actual.messages);
+        for (int i = 0; i < expected.changedPaths.size(); ++i)
+        {
+            Set<String> expectedPaths = new HashSet<String>();
+            for (ChangePath cp : expected.changedPaths.get(i))
+                expectedPaths.add(cp.getPath() + " " + cp.getAction()
+                                  + " " + cp.getNodeKind()
+                                  + " " + cp.getTextMods());
+            Set<String> actualPaths = new HashSet<String>();
+            for (ChangePath cp : actual.changedPaths.get(i))
+                actualPaths.add(cp.getPath() + " " + cp.getAction()
+                                + " " + cp.getNodeKind()
+                                + " " + cp.getTextMods());
+            assertEquals("wrong changed paths", expectedPaths, actualPaths);
+        }
+    }
+
     /**
      * Test the basic SVNClient.getVersionInfo functionality.
      * @throws Throwable
@@ -54,6 +54,29 @@ typedef int (*authz_svn__subreq_bypass_func_t)(request_rec *r,
                                               const char *repos_path,
                                               const char *repos_name);
 
+/** Provider name for bulk subrequest bypass */
+#define AUTHZ_SVN__SUBREQ_BYPASS_BULK_PROV_NAME \
+  "mod_authz_svn_subreq_bypass_bulk"
+/** Provider version for bulk subrequest bypass */
+#define AUTHZ_SVN__SUBREQ_BYPASS_BULK_PROV_VER "00.00a"
+/** Like #authz_svn__subreq_bypass_func_t but for all paths in
+ * @a repos_paths, an array of <tt>const char *</tt>, at once.  This
+ * allows mod_dav_svn to authorize many paths for one request without
+ * setting up the authz lookup for each of them.
+ *
+ * Sets the respective element of @a allowed, which must have at least as
+ * many elements as @a repos_paths, to non-zero if the user making the
+ * request may read that path and to 0 if not.
+ *
+ * Returns @c OK if the access could be determined or @c HTTP_FORBIDDEN
+ * if not.  @a allowed is undefined in the latter case.
+ */
+typedef int (*authz_svn__subreq_bypass_bulk_func_t)(
+                                        request_rec *r,
+                                        const apr_array_header_t *repos_paths,
+                                        const char *repos_name,
+                                        int *allowed);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
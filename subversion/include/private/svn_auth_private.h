@@ -241,6 +241,19 @@ svn_auth__make_session_auth(svn_auth_baton_t **session_auth_baton,
                             apr_pool_t *result_pool,
                             apr_pool_t *scratch_pool);
 
+/* Let the credentials that AUTH_BATON keeps in memory expire TTL after
+   they have been obtained from the providers, after which they get
+   fetched from the providers again.  A TTL of 0, the default, keeps them
+   for the lifetime of AUTH_BATON.
+
+   Credentials rejected by the server are always dropped from memory and
+   those saved once are not passed to the providers for saving again.
+
+   Set this before deriving session batons from AUTH_BATON. */
+void
+svn_auth__set_credentials_cache_ttl(svn_auth_baton_t *auth_baton,
+                                    apr_interval_time_t ttl);
+
 #if (defined(WIN32) && !defined(__MINGW32__)) || defined(DOXYGEN)
 /**
  * Set @a *provider to an authentication provider that implements
@@ -148,6 +148,11 @@ typedef struct svn_cache__info_t
    */
   apr_uint64_t failures;
 
+  /** Number of entries that had to be removed to make room for new ones.
+   * May be 0 if that information is not available.
+   */
+  apr_uint64_t evictions;
+
   /** Size of the data currently stored in the cache.
    * May be 0 if that information is not available.
    */
@@ -270,6 +275,20 @@ svn_cache__make_memcache_from_config(svn_memcache_t **memcache_p,
                                      apr_pool_t *result_pool,
                                      apr_pool_t *scratch_pool);
 
+/**
+ * Make all caches using @a memcache send their writes to the memcached
+ * servers from a background thread instead of waiting for the servers'
+ * replies.  Writes may then get lost, e.g. when the backlog becomes too
+ * large; the respective entries will simply not be cached.  Calling this
+ * multiple times has no further effect.  Without thread support, this is
+ * a no-op.
+ *
+ * If Subversion was not built with apr_memcache support, always
+ * raises SVN_ERR_NO_APR_MEMCACHE.
+ */
+svn_error_t *
+svn_cache__memcache_enable_async_writes(svn_memcache_t *memcache);
+
 /**
  * Creates a new membuffer cache object in @a *cache. It will contain
  * up to @a total_size bytes of data, using @a directory_size bytes
@@ -310,6 +329,27 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
                                   svn_boolean_t allow_blocking_writes,
                                   apr_pool_t *result_pool);
 
+/**
+ * Like svn_cache__membuffer_cache_create() but place the cache contents
+ * in a shared memory region and use inter-process locks, such that all
+ * processes forked from the current one afterwards operate on the same
+ * cache.  The result is always thread-safe.
+ *
+ * Per-prefix statistics will not be available for shared caches.
+ *
+ * Returns #SVN_ERR_UNSUPPORTED_FEATURE if the platform does not support
+ * process-shared locks.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_cache__membuffer_cache_create_shared(svn_membuffer_t **cache,
+                                         apr_size_t total_size,
+                                         apr_size_t directory_size,
+                                         apr_size_t segment_count,
+                                         svn_boolean_t allow_blocking_writes,
+                                         apr_pool_t *result_pool);
+
 /**
  * @defgroup Standard priority classes for #svn_cache__create_membuffer_cache.
  * @{
@@ -364,6 +404,9 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
  * This flag is a mere hint and does not affect functionality.
  *
  * These caches do not support svn_cache__iter.
+ *
+ * Same as svn_cache__create_membuffer_cache2() with a
+ * @a compression_threshold of 0.
  */
 svn_error_t *
 svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
@@ -378,6 +421,34 @@ svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
                                   apr_pool_t *result_pool,
                                   apr_pool_t *scratch_pool);
 
+/**
+ * Like svn_cache__create_membuffer_cache() but store serialized items of
+ * @a compression_threshold or more bytes LZ4-compressed in @a membuffer.
+ * They will be decompressed on every access, trading CPU time for a
+ * larger number of items fitting into the cache.  Items that don't
+ * compress well are stored uncompressed.  A @a compression_threshold of 0
+ * disables compression.
+ *
+ * Entries written with and without compression enabled live in separate
+ * key spaces, i.e. they are never visible to caches of the respective
+ * other kind even if they use the same @a prefix.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_cache__create_membuffer_cache2(svn_cache__t **cache_p,
+                                   svn_membuffer_t *membuffer,
+                                   svn_cache__serialize_func_t serialize,
+                                   svn_cache__deserialize_func_t deserialize,
+                                   apr_ssize_t klen,
+                                   const char *prefix,
+                                   apr_uint32_t priority,
+                                   apr_size_t compression_threshold,
+                                   svn_boolean_t thread_safe,
+                                   svn_boolean_t short_lived,
+                                   apr_pool_t *result_pool,
+                                   apr_pool_t *scratch_pool);
+
 /**
  * Creates a null-cache instance in @a *cache_p, allocated from
  * @a result_pool.  The given @c id is the only data stored in it and can
@@ -391,6 +462,61 @@ svn_cache__create_null(svn_cache__t **cache_p,
                        const char *id,
                        apr_pool_t *result_pool);
 
+/**
+ * An append-only file that may back any number of caches and that keeps
+ * their contents across process restarts.  Instances are shared by all
+ * users within the process and live until the process terminates.
+ */
+typedef struct svn_cache__persistent_t svn_cache__persistent_t;
+
+/**
+ * Return the persistent cache store for the file at @a path in
+ * @a *store_p, creating the file if necessary.  The file will not grow
+ * beyond @a max_size bytes.  If @a path can only be opened for reading,
+ * the store will be read-only.
+ *
+ * Entries that have been added to the store become visible to
+ * svn_cache__create_persistent() caches only after the store has been
+ * re-opened by a new process.  Multiple processes may share the same file.
+ *
+ * If Subversion was built without memory mapping support, set
+ * @a *store_p to @c NULL.  Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_cache__get_persistent_store(svn_cache__persistent_t **store_p,
+                                const char *path,
+                                apr_uint64_t max_size,
+                                apr_pool_t *scratch_pool);
+
+/**
+ * Creates a new cache in @a *cache_p, allocated in @a result_pool, that
+ * uses @a l1_cache as its first level and @a store as the second level.
+ * Lookups that miss @a l1_cache will be answered from @a store and
+ * promoted to @a l1_cache.  New entries will be added to both levels.
+ *
+ * The keys in @a store will be prefixed with @a prefix, which must make
+ * them unique among all caches sharing the same @a store.  @a klen and
+ * the serialization functions, which must not be @c NULL, should be the
+ * same as for @a l1_cache.
+ *
+ * Since the entries in @a store can't be modified, the cached values
+ * must be immutable.  svn_cache__set_partial() will only modify
+ * @a l1_cache.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_cache__create_persistent(svn_cache__t **cache_p,
+                             svn_cache__t *l1_cache,
+                             svn_cache__persistent_t *store,
+                             svn_cache__serialize_func_t serialize_func,
+                             svn_cache__deserialize_func_t deserialize_func,
+                             apr_ssize_t klen,
+                             const char *prefix,
+                             apr_pool_t *result_pool);
+
 /**
  * Sets @a handler to be @a cache's error handling routine.  If any
  * error is returned from a call to svn_cache__get or svn_cache__set, @a
@@ -433,6 +559,23 @@ svn_cache__get(void **value,
                const void *key,
                apr_pool_t *result_pool);
 
+/**
+ * Fetches the values indexed by the <tt>const void *</tt> elements of
+ * @a keys from @a cache.  Sets @a *values to an array of <tt>void *</tt>
+ * with one element per key, which is the value as returned by
+ * svn_cache__get() or NULL if the key is NULL or not in the cache.
+ * The result will be allocated in @a result_pool.
+ *
+ * Caches that can look up multiple keys in a single request, e.g. the
+ * memcached based ones, will do so.  All other caches fall back to
+ * calling svn_cache__get() for each key.
+ */
+svn_error_t *
+svn_cache__get_many(apr_array_header_t **values,
+                    svn_cache__t *cache,
+                    const apr_array_header_t *keys,
+                    apr_pool_t *result_pool);
+
 /**
  * Looks for an entry indexed by @a key in @a cache,  setting @a *found
  * to TRUE if an entry has been found and FALSE otherwise.  @a key may be
@@ -534,6 +677,19 @@ svn_cache__get_info(svn_cache__t *cache,
                     svn_boolean_t reset,
                     apr_pool_t *result_pool);
 
+/**
+ * Add the number of getter calls on @a cache to @a *gets and the number
+ * of those that returned a cached item to @a *hits.  Unlike
+ * svn_cache__get_info(), this only reads counters local to @a cache and
+ * never touches any state shared with other cache instances.
+ *
+ * @since New in 1.15.
+ */
+void
+svn_cache__add_access_counts(apr_uint64_t *gets,
+                             apr_uint64_t *hits,
+                             const svn_cache__t *cache);
+
 /**
  * Return the information given in @a info formatted as a multi-line string.
  * If @a access_only has been set, size and fill-level statistics will be
@@ -554,6 +710,23 @@ svn_cache__format_info(const svn_cache__info_t *info,
 struct svn_membuffer_t *
 svn_cache__get_global_membuffer_cache(void);
 
+/**
+ * Create the process-global membuffer cache now, using the current cache
+ * config, and make it shared with all processes that will be forked from
+ * the current one afterwards.  Servers that fork a process per connection
+ * or request may call this before forking to hold the cached data only
+ * once instead of once per child process.
+ *
+ * This must be called before the first call to
+ * svn_cache__get_global_membuffer_cache() because the process-local cache
+ * can't be replaced later.  Returns #SVN_ERR_INCORRECT_PARAMS in that case.
+ * Repeated calls to this function will return the first call's result.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_cache__share_global_membuffer_cache(void);
+
 /**
  * Return total access and size stats over all membuffer caches as they
  * share the underlying data buffer.  The result will be allocated in POOL.
@@ -561,6 +734,21 @@ svn_cache__get_global_membuffer_cache(void);
 svn_cache__info_t *
 svn_cache__membuffer_get_global_info(apr_pool_t *pool);
 
+/**
+ * Return access, eviction and size stats of @a membuffer for each key
+ * prefix, i.e. summed up over all membuffer caches that use the same
+ * prefix, as an array of #svn_cache__info_t *.  The @c id of each element
+ * is the respective prefix.  Short-lived caches and prefixes beyond some
+ * internal limit are being reported under the id "(other)".  Data and
+ * total sizes are those of the whole @a membuffer.
+ *
+ * Prefixes without any accesses or entries will be omitted.
+ * The result will be allocated in @a pool.
+ */
+apr_array_header_t *
+svn_cache__membuffer_get_prefix_info(svn_membuffer_t *membuffer,
+                                     apr_pool_t *pool);
+
 /**
  * Remove all current contents from CACHE.
  *
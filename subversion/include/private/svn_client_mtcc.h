@@ -78,7 +78,9 @@ svn_client__mtcc_create(svn_client__mtcc_t **mtcc,
  * Perform temporary allocations in @a scratch_pool.
  *
  * @note The current implementation keeps @a src_stream open until @a mtcc
- * is committed.
+ * is committed.  When adding many files, pass streams created with
+ * svn_stream_lazyopen_create(), which are only opened while their contents
+ * are sent and closed right after that.
  *
  * @since New in 1.9.
  */
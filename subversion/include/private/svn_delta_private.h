@@ -108,6 +108,53 @@ svn_txdelta__read_raw_window_len(apr_size_t *window_len,
                                  svn_stream_t *stream,
                                  apr_pool_t *pool);
 
+/** Parse the svndiff window of version @a svndiff_version at the start
+    of the @a len bytes at @a data and return it in @a *window.  Set
+    @a *window_len to the number of bytes that the window occupies in
+    @a data.  If @a window is NULL, only determine the window length.
+
+    Unlike svn_txdelta_read_svndiff_window(), this does not copy the
+    raw window data.  @a *window will not refer to @a data, though.
+    Allocate @a *window in @a pool. */
+svn_error_t *
+svn_txdelta__parse_svndiff_window(svn_txdelta_window_t **window,
+                                  apr_size_t *window_len,
+                                  const char *data,
+                                  apr_size_t len,
+                                  int svndiff_version,
+                                  apr_pool_t *pool);
+
+/** Like svn_txdelta_to_svndiff3() but compress up to @a thread_count
+    windows concurrently in worker threads.  The windows are still being
+    written to @a output in order and the output is identical to what
+    svn_txdelta_to_svndiff3() produces.  The handler copies each window,
+    so the caller may release it after the handler returns.
+
+    If @a thread_count is 1 or less, if @a svndiff_version is 0 or if APR
+    does not support threads, this is equivalent to
+    svn_txdelta_to_svndiff3().  Worker threads are only started once a
+    second window comes in and they terminate when the handler gets the
+    final NULL window or when @a pool is being cleaned up. */
+svn_error_t *
+svn_txdelta__to_svndiff_parallel(svn_txdelta_window_handler_t *handler,
+                                 void **handler_baton,
+                                 svn_stream_t *output,
+                                 int svndiff_version,
+                                 int compression_level,
+                                 int thread_count,
+                                 apr_pool_t *pool);
+
+/** Like svn_txdelta_to_svndiff_stream() but encode the windows with
+    svn_txdelta__to_svndiff_parallel() using up to @a thread_count
+    threads.  Return the stream in @a *stream. */
+svn_error_t *
+svn_txdelta__to_svndiff_stream_parallel(svn_stream_t **stream,
+                                        svn_txdelta_stream_t *txstream,
+                                        int svndiff_version,
+                                        int compression_level,
+                                        int thread_count,
+                                        apr_pool_t *pool);
+
 /* Return a debug editor that wraps @a wrapped_editor.
  *
  * The debug editor simply prints an indication of what callbacks are being
@@ -126,6 +173,41 @@ svn_delta__get_debug_editor(const svn_delta_editor_t **editor,
                             const char *prefix,
                             apr_pool_t *pool);
 
+/* An editor drive recorded by the editor from
+ * svn_delta__get_recording_editor().
+ */
+typedef struct svn_delta__recording_t svn_delta__recording_t;
+
+/* Set @a *editor and @a *edit_baton to an editor that records all calls
+ * made upon it in @a *recording, for svn_delta__play_recording() to
+ * replay them later.  Closing and aborting the edit are not recorded.
+ *
+ * Text deltas are kept in memory up to a limit and spill to a temporary
+ * file beyond it.  If @a cancel_func is not @c NULL, it gets called with
+ * @a cancel_baton for each node being added or opened.
+ *
+ * Allocate the editor and the recording in @a result_pool.  Since
+ * nothing else refers to that pool, the recording may be made in one
+ * thread and played back in another one.
+ */
+svn_error_t *
+svn_delta__get_recording_editor(const svn_delta_editor_t **editor,
+                                void **edit_baton,
+                                svn_delta__recording_t **recording,
+                                svn_cancel_func_t cancel_func,
+                                void *cancel_baton,
+                                apr_pool_t *result_pool);
+
+/* Drive @a editor / @a edit_baton with the calls in @a recording, except
+ * for closing the edit.  A recording can be played back only once.
+ * Use @a pool for the batons and temporary allocations.
+ */
+svn_error_t *
+svn_delta__play_recording(svn_delta__recording_t *recording,
+                          const svn_delta_editor_t *editor,
+                          void *edit_baton,
+                          apr_pool_t *pool);
+
 
 #ifdef __cplusplus
 }
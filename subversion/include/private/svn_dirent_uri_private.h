@@ -26,6 +26,8 @@
 
 #include <apr_pools.h>
 
+#include "svn_types.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -46,6 +48,87 @@ svn_relpath__make_internal(const char **internal_style_relpath,
                            apr_pool_t *result_pool,
                            apr_pool_t *scratch_pool);
 
+/**
+ * @defgroup svn_relpath_intern Interned relpaths
+ *
+ * Interned relpaths exist only once per #svn_relpath__intern_pool_t.
+ * Two of them from the same pool are equal if and only if they are the
+ * same pointer, and ancestry tests need no string comparisons.  Joining
+ * a path that has been interned before does not allocate memory.
+ *
+ * @{
+ */
+
+/**
+ * An interned canonical relpath.
+ *
+ * @since New in 1.15.
+ */
+typedef struct svn_relpath__interned_t
+{
+  /** The parent path.  @c NULL only for the empty path. */
+  const struct svn_relpath__interned_t *parent;
+
+  /** The path itself, NUL-terminated. */
+  const char *data;
+
+  /** Length of @a data. */
+  apr_size_t len;
+
+  /** Number of path components.  0 for the empty path. */
+  int depth;
+} svn_relpath__interned_t;
+
+/**
+ * Opaque container of interned relpaths.
+ *
+ * @since New in 1.15.
+ */
+typedef struct svn_relpath__intern_pool_t svn_relpath__intern_pool_t;
+
+/**
+ * Return a new, empty container for interned relpaths, allocated in
+ * @a result_pool.  All paths interned in it will be allocated in
+ * @a result_pool as well.
+ *
+ * @since New in 1.15.
+ */
+svn_relpath__intern_pool_t *
+svn_relpath__intern_pool_create(apr_pool_t *result_pool);
+
+/**
+ * Return the interned version of the canonical @a relpath from @a ipool.
+ * Intern @a relpath and all its ancestors if they are not in @a ipool yet.
+ *
+ * @since New in 1.15.
+ */
+const svn_relpath__interned_t *
+svn_relpath__intern(svn_relpath__intern_pool_t *ipool,
+                    const char *relpath);
+
+/**
+ * Like svn_relpath__intern() for the result of joining @a parent, which
+ * must have been interned in @a ipool, and the single path @a component.
+ *
+ * @since New in 1.15.
+ */
+const svn_relpath__interned_t *
+svn_relpath__intern_join(svn_relpath__intern_pool_t *ipool,
+                         const svn_relpath__interned_t *parent,
+                         const char *component);
+
+/**
+ * Return TRUE if @a ancestor is @a path or one of its ancestors.  Both
+ * must have been interned in the same pool.
+ *
+ * @since New in 1.15.
+ */
+svn_boolean_t
+svn_relpath__interned_is_ancestor(const svn_relpath__interned_t *ancestor,
+                                  const svn_relpath__interned_t *path);
+
+/** @} */
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -179,6 +179,11 @@ typedef struct svn_fs_fs__stats_t
   /* number of revisions in the repository */
   apr_uint64_t revision_count;
 
+  /* number of revisions actually scanned.  If this is less than
+   * REVISION_COUNT, all other counts and sizes (except LARGEST_CHANGES)
+   * have been extrapolated from a sample of the repository. */
+  apr_uint64_t scanned_revision_count;
+
   /* total number of changed paths */
   apr_uint64_t change_count;
 
@@ -313,6 +318,12 @@ typedef struct svn_fs_fs__ioctl_get_stats_input_t
 {
   svn_fs_progress_notify_func_t progress_func;
   void *progress_baton;
+
+  /* Number of shards to scan concurrently.  0 and 1 mean sequential. */
+  int jobs;
+
+  /* If larger than 1, scan only every SAMPLE-th shard and extrapolate. */
+  int sample;
 } svn_fs_fs__ioctl_get_stats_input_t;
 
 typedef struct svn_fs_fs__ioctl_get_stats_output_t
@@ -359,11 +370,170 @@ typedef struct svn_fs_fs__ioctl_build_rep_cache_input_t
   svn_revnum_t end_rev;
   svn_fs_progress_notify_func_t progress_func;
   void *progress_baton;
+  int jobs;
+  svn_boolean_t incremental;
 } svn_fs_fs__ioctl_build_rep_cache_input_t;
 
 /* See svn_fs_fs__build_rep_cache(). */
 SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_BUILD_REP_CACHE, SVN_FS_TYPE_FSFS, 1004);
 
+typedef struct svn_fs_fs__ioctl_verify_fingerprint_input_t
+{
+  svn_revnum_t revision;
+} svn_fs_fs__ioctl_verify_fingerprint_input_t;
+
+typedef struct svn_fs_fs__ioctl_verify_fingerprint_output_t
+{
+  /* Range of revisions stored in the same rev / pack file as REVISION. */
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+
+  /* Changes whenever that file gets modified or replaced. */
+  const char *fingerprint;
+} svn_fs_fs__ioctl_verify_fingerprint_output_t;
+
+/* See svn_fs_fs__verify_fingerprint(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_VERIFY_FINGERPRINT, SVN_FS_TYPE_FSFS, 1005);
+
+typedef struct svn_fs_fs__ioctl_changed_revs_input_t
+{
+  const char *path;
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+  svn_boolean_t include_descendants;
+} svn_fs_fs__ioctl_changed_revs_input_t;
+
+typedef struct svn_fs_fs__ioctl_changed_revs_output_t
+{
+  /* Sorted array of svn_revnum_t. */
+  apr_array_header_t *revisions;
+} svn_fs_fs__ioctl_changed_revs_output_t;
+
+/* See svn_fs_fs__path_index_find(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_CHANGED_REVS, SVN_FS_TYPE_FSFS, 1006);
+
+typedef struct svn_fs_fs__ioctl_revision_proplists_input_t
+{
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+} svn_fs_fs__ioctl_revision_proplists_input_t;
+
+typedef struct svn_fs_fs__ioctl_revision_proplists_output_t
+{
+  /* Array of apr_hash_t *, one per revision. */
+  apr_array_header_t *proplists;
+} svn_fs_fs__ioctl_revision_proplists_output_t;
+
+/* See svn_fs_fs__get_revision_proplists(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_REVISION_PROPLISTS, SVN_FS_TYPE_FSFS, 1007);
+
+typedef struct svn_fs_fs__ioctl_contents_location_input_t
+{
+  svn_fs_root_t *root;
+  const char *path;
+} svn_fs_fs__ioctl_contents_location_input_t;
+
+typedef struct svn_fs_fs__ioctl_contents_location_output_t
+{
+  /* Rev or pack file containing the contents verbatim, or NULL if they
+   * are not stored that way.  Stays open until the result pool gets
+   * cleaned up. */
+  apr_file_t *file;
+
+  /* Location of the contents within FILE. */
+  apr_off_t offset;
+  svn_filesize_t length;
+} svn_fs_fs__ioctl_contents_location_output_t;
+
+/* See svn_fs_fs__file_contents_location(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_CONTENTS_LOCATION, SVN_FS_TYPE_FSFS, 1008);
+
+typedef struct svn_fs_fs__ioctl_revprop_generation_output_t
+{
+  apr_int64_t epoch;
+  apr_int64_t generation;
+} svn_fs_fs__ioctl_revprop_generation_output_t;
+
+/* See svn_fs_fs__get_revprop_generation().  Takes no input. */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_REVPROP_GENERATION, SVN_FS_TYPE_FSFS, 1009);
+
+typedef struct svn_fs_fs__ioctl_replay_trace_input_t
+{
+  /* Access trace file as written with the fsfs.conf "access-trace"
+   * option. */
+  const char *path;
+} svn_fs_fs__ioctl_replay_trace_input_t;
+
+typedef struct svn_fs_fs__ioctl_replay_trace_output_t
+{
+  /* Number of node revisions, changed paths lists and representations
+   * replayed and how many of them were cache hits when recorded. */
+  apr_uint64_t noderevs;
+  apr_uint64_t noderev_hits;
+  apr_uint64_t changes;
+  apr_uint64_t changes_hits;
+  apr_uint64_t contents;
+  apr_uint64_t contents_hits;
+
+  /* Number of reads in the trace and their total known size in bytes. */
+  apr_uint64_t reads;
+  apr_uint64_t bytes_read;
+
+  /* Number of records skipped because their revision does not exist. */
+  apr_uint64_t skipped;
+} svn_fs_fs__ioctl_replay_trace_output_t;
+
+/* See svn_fs_fs__replay_access_trace(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_REPLAY_TRACE, SVN_FS_TYPE_FSFS, 1010);
+
+typedef struct svn_fs_fs__ioctl_deflated_contents_input_t
+{
+  svn_fs_root_t *root;
+  const char *path;
+} svn_fs_fs__ioctl_deflated_contents_input_t;
+
+typedef struct svn_fs_fs__ioctl_deflated_contents_output_t
+{
+  /* The file contents as a raw deflate stream (RFC 1951), or NULL if
+   * they are not stored compressed that way. */
+  svn_string_t *deflated;
+} svn_fs_fs__ioctl_deflated_contents_output_t;
+
+/* See svn_fs_fs__file_deflated_contents(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_DEFLATED_CONTENTS, SVN_FS_TYPE_FSFS, 1011);
+
+typedef struct svn_fs_fs__ioctl_repack_input_t
+{
+  /* Revision whose tree shall be stored contiguously.
+   * SVN_INVALID_REVNUM for HEAD. */
+  svn_revnum_t revision;
+  svn_fs_progress_notify_func_t notify_func;
+  void *notify_baton;
+} svn_fs_fs__ioctl_repack_input_t;
+
+/* See svn_fs_fs__repack(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_REPACK, SVN_FS_TYPE_FSFS, 1012);
+
+typedef struct svn_fs_fs__ioctl_reshard_input_t
+{
+  /* Path of the resharded copy.  It gets created if it does not exist
+   * and brought up to date incrementally otherwise. */
+  const char *path;
+
+  /* Number of revisions per shard in the copy. */
+  int max_files_per_dir;
+
+  /* Number of shards to process concurrently. */
+  int jobs;
+
+  svn_fs_hotcopy_notify_t notify_func;
+  svn_fs_pack_notify_t pack_notify_func;
+  void *notify_baton;
+} svn_fs_fs__ioctl_reshard_input_t;
+
+/* See svn_fs_fs__reshard(). */
+SVN_FS_DECLARE_IOCTL_CODE(SVN_FS_FS__IOCTL_RESHARD, SVN_FS_TYPE_FSFS, 1013);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
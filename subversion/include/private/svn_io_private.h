@@ -84,6 +84,18 @@ svn_error_t *
 svn_io__file_lock_autocreate(const char *lock_file,
                              apr_pool_t *pool);
 
+/**
+ * Create @a to_path as a hard link to the existing file @a from_path.
+ * Fail if @a to_path already exists or if the filesystem does not support
+ * hard links between these two paths.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_io__file_link(const char *from_path,
+                  const char *to_path,
+                  apr_pool_t *scratch_pool);
+
 
 /** Return the underlying file, if any, associated with the stream, or
  * NULL if not available.  Accessing the file bypasses the stream.
@@ -91,6 +103,54 @@ svn_io__file_lock_autocreate(const char *lock_file,
 apr_file_t *
 svn_stream__aprfile(svn_stream_t *stream);
 
+/* Callback for streams that keep their content in memory anyway.  Set
+ * *DATA to up to *LEN bytes of that content, starting at the current
+ * position of the stream, advance the position accordingly and set *LEN
+ * to the number of bytes returned.  Fewer bytes than requested may be
+ * returned at any time but *LEN must only be 0 at the end of the stream.
+ * The returned data must remain valid until the next operation on the
+ * stream.
+ */
+typedef svn_error_t *
+(*svn_stream__read_buffer_fn_t)(void *baton,
+                                const char **data,
+                                apr_size_t *len);
+
+/* Make STREAM hand out its content through READ_BUFFER_FN in
+ * svn_stream__read_buffer().  STREAM must still support regular reads.
+ */
+void
+svn_stream__set_read_buffer(svn_stream_t *stream,
+                            svn_stream__read_buffer_fn_t read_buffer_fn);
+
+/* Read up to *LEN bytes from STREAM and set *DATA to them and *LEN to
+ * their number.  If STREAM supports it, *DATA will point to STREAM's
+ * internal buffers, valid until the next operation on STREAM.  Otherwise,
+ * read the data into BUFFER, which must provide space for *LEN bytes.
+ *
+ * Unlike svn_stream_read_full(), fewer than *LEN bytes may be returned
+ * before the end of STREAM.  *LEN will be 0 at the end of STREAM.
+ */
+svn_error_t *
+svn_stream__read_buffer(svn_stream_t *stream,
+                        const char **data,
+                        apr_size_t *len,
+                        char *buffer);
+
+/* Return a stream that calculates the MD5 and the SHA-1 checksum of all
+ * data written to STREAM in a single pass.  When the returned stream gets
+ * closed, store them in *MD5_CHECKSUM and *SHA1_CHECKSUM, respectively,
+ * allocated in POOL.  Either of these may be NULL.
+ *
+ * This is equivalent to but faster than wrapping STREAM twice with
+ * svn_stream_checksummed2().  The result supports reset if STREAM does.
+ */
+svn_stream_t *
+svn_stream__checksummed_md5_sha1(svn_stream_t *stream,
+                                 svn_checksum_t **md5_checksum,
+                                 svn_checksum_t **sha1_checksum,
+                                 apr_pool_t *pool);
+
 /* Creates as *INSTALL_STREAM a stream that once completed can be installed
    using Windows checkouts much slower than Unix.
 
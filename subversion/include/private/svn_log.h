@@ -96,6 +96,16 @@ svn_log__get_dir(const char *path, svn_revnum_t rev,
                  apr_uint32_t dirent_fields,
                  apr_pool_t *pool);
 
+/**
+ * Return a log string for a get-dirs action listing the directories
+ * @a paths (<tt>const char *</tt>) at @a rev.
+ *
+ * @since New in 1.15.
+ */
+const char *
+svn_log__get_dirs(const apr_array_header_t *paths, svn_revnum_t rev,
+                  apr_pool_t *pool);
+
 /**
  * Return a log string for a get-mergeinfo action.
  *
@@ -198,6 +208,15 @@ svn_log__get_file_revs(const char *path, svn_revnum_t start, svn_revnum_t end,
                        svn_boolean_t include_merged_revisions,
                        apr_pool_t *pool);
 
+/**
+ * Return a log string for a blame action.
+ *
+ * @since New in 1.15.
+ */
+const char *
+svn_log__blame(const char *path, svn_revnum_t start, svn_revnum_t end,
+               apr_pool_t *pool);
+
 /**
  * Return a log string for a lock action.
  *
@@ -287,6 +287,82 @@ svn_rangelist__merge_many(svn_rangelist_t *merged_rangelist,
                           apr_pool_t *result_pool,
                           apr_pool_t *scratch_pool);
 
+/* A rangelist stored in parallel arrays instead of an array of pointers
+ * to svn_merge_range_t.  The ranges must be forward ranges in ascending
+ * order that do not overlap, as in a canonical rangelist.
+ *
+ * The operations on packed rangelists below write to an existing output
+ * rangelist and don't allocate once its arrays are large enough, so a
+ * loop that reuses the same packed rangelists allocates nothing per range.
+ */
+typedef struct svn_rangelist__packed_t
+{
+  /* Number of ranges. */
+  int nelts;
+
+  /* Number of ranges the arrays below have room for. */
+  int nalloc;
+
+  /* The ranges: (STARTS[i], ENDS[i]], inheritable if INHERITABLE[i]. */
+  svn_revnum_t *starts;
+  svn_revnum_t *ends;
+  svn_boolean_t *inheritable;
+
+  /* The pool the arrays get (re)allocated in. */
+  apr_pool_t *pool;
+} svn_rangelist__packed_t;
+
+/* Return an empty packed rangelist with room for NALLOC ranges, allocated
+ * in RESULT_POOL. */
+svn_rangelist__packed_t *
+svn_rangelist__packed_create(int nalloc,
+                             apr_pool_t *result_pool);
+
+/* Replace the contents of PACKED with the ranges of RANGELIST.  Return an
+ * assertion error if RANGELIST is not sorted or has overlapping or
+ * reversed ranges. */
+svn_error_t *
+svn_rangelist__packed_set(svn_rangelist__packed_t *packed,
+                          const svn_rangelist_t *rangelist);
+
+/* Return a new rangelist with the ranges of PACKED, allocated in
+ * RESULT_POOL. */
+svn_rangelist_t *
+svn_rangelist__unpack(const svn_rangelist__packed_t *packed,
+                      apr_pool_t *result_pool);
+
+/* Set OUTPUT to the union of RANGELIST1 and RANGELIST2, like
+ * svn_rangelist_merge2().  OUTPUT must not be one of the inputs. */
+svn_error_t *
+svn_rangelist__packed_merge(svn_rangelist__packed_t *output,
+                            const svn_rangelist__packed_t *rangelist1,
+                            const svn_rangelist__packed_t *rangelist2);
+
+/* Set OUTPUT to the intersection of RANGELIST1 and RANGELIST2, like
+ * svn_rangelist_intersect().  OUTPUT must not be one of the inputs.
+ *
+ * If CONSIDER_INHERITANCE is TRUE, the result holds every revision that
+ * both inputs have with the same inheritability.  svn_rangelist_intersect()
+ * may miss some of these when ranges of differing inheritability
+ * interleave. */
+svn_error_t *
+svn_rangelist__packed_intersect(svn_rangelist__packed_t *output,
+                                const svn_rangelist__packed_t *rangelist1,
+                                const svn_rangelist__packed_t *rangelist2,
+                                svn_boolean_t consider_inheritance);
+
+/* Set OUTPUT to WHITEBOARD without the ranges of ERASER, like
+ * svn_rangelist_remove().  OUTPUT must not be one of the inputs.
+ *
+ * If CONSIDER_INHERITANCE is TRUE, only revisions that ERASER has with
+ * the same inheritability get removed, revision by revision, as for
+ * svn_rangelist__packed_intersect(). */
+svn_error_t *
+svn_rangelist__packed_remove(svn_rangelist__packed_t *output,
+                             const svn_rangelist__packed_t *eraser,
+                             const svn_rangelist__packed_t *whiteboard,
+                             svn_boolean_t consider_inheritance);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
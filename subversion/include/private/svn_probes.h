@@ -0,0 +1,99 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_probes.h
+ * @brief Static tracepoints for SystemTap and DTrace
+ */
+
+#ifndef SVN_PROBES_H
+#define SVN_PROBES_H
+
+/**
+ * Static probes mark the boundaries of hot code paths such that external
+ * tracers (SystemTap, DTrace, bpftrace, perf, ...) can attach to running
+ * processes without rebuilding or restarting them.  They are compiled in
+ * only if Subversion has been configured with --enable-sdt, which defines
+ * SVN_HAVE_SDT.  Even then, an inactive probe is a single NOP instruction
+ * plus a note in a non-loaded ELF section; only the probe arguments have
+ * to be available in registers or memory.
+ *
+ * All probes belong to the "svn" provider.  As with DTrace, double
+ * underscores in the probe names become dashes, e.g. "cache-get-done".
+ * Operations whose latency is of interest fire a pair of NAME__start and
+ * NAME__done probes on the same thread, so tracers can measure durations
+ * themselves.  Strings are passed as const char pointers, sizes and
+ * revisions as integers.
+ *
+ *   fsfs-item-offset-start (revision, item_index)
+ *   fsfs-item-offset-done  (revision, item_index, offset)
+ *   fsfs-rev-file-open-start (revision)
+ *   fsfs-rev-file-open-done  (revision, is_packed)
+ *   fsfs-rev-file-read     (revision, offset, length or 0 if unknown)
+ *   cache-get-start        ()
+ *   cache-get-done         (size, found)
+ *   cache-set-start        (size)
+ *   cache-set-done         (size)
+ *   cache-evict            (size, hit_count, priority)
+ *   delta-window-decode-start (svndiff_version, sview_len, tview_len,
+ *                              new_data_len)
+ *   delta-window-decode-done  (num_ops, tview_len)
+ *   sqlite-step-start      (statement_name or NULL)
+ *   sqlite-step-done       (statement_name or NULL, got_row)
+ *   wc-workqueue-item-start (item_name)
+ *   wc-workqueue-item-done  (item_name)
+ *   ra-svn-command-start   (command_name)
+ *   ra-svn-command-done    (command_name, bytes_in, bytes_out, failed)
+ *   dav-report-start       (report_name)
+ *   dav-report-done        (report_name, bytes_sent, failed)
+ */
+
+#ifdef SVN_HAVE_SDT
+
+#include <sys/sdt.h>
+
+#define SVN_PROBE0(name) \
+  DTRACE_PROBE(svn, name)
+#define SVN_PROBE1(name, a1) \
+  DTRACE_PROBE1(svn, name, a1)
+#define SVN_PROBE2(name, a1, a2) \
+  DTRACE_PROBE2(svn, name, a1, a2)
+#define SVN_PROBE3(name, a1, a2, a3) \
+  DTRACE_PROBE3(svn, name, a1, a2, a3)
+#define SVN_PROBE4(name, a1, a2, a3, a4) \
+  DTRACE_PROBE4(svn, name, a1, a2, a3, a4)
+
+#else
+
+#define SVN_PROBE0(name) \
+  do {} while (0)
+#define SVN_PROBE1(name, a1) \
+  do {} while (0)
+#define SVN_PROBE2(name, a1, a2) \
+  do {} while (0)
+#define SVN_PROBE3(name, a1, a2, a3) \
+  do {} while (0)
+#define SVN_PROBE4(name, a1, a2, a3, a4) \
+  do {} while (0)
+
+#endif /* SVN_HAVE_SDT */
+
+#endif /* SVN_PROBES_H */
@@ -0,0 +1,91 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_profile.h
+ * @brief Process-wide counters and timers for diagnosing slow operations
+ */
+
+#ifndef SVN_PROFILE_H
+#define SVN_PROFILE_H
+
+#include <apr_time.h>
+
+#include "svn_types.h"
+#include "svn_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * The libraries record how often, and for how long, interesting events
+ * happen: SQL statements, work queue items, fsyncs, network requests, ...
+ * Every event is identified by a @a category, e.g. "sqlite", and a
+ * @a label within that category, e.g. the name of the statement.
+ *
+ * Profiling is off by default, in which case recording an event costs
+ * no more than checking a flag.  Command line tools turn it on with
+ * svn_profile__enable() and print the totals with svn_profile__print()
+ * before they exit.
+ */
+
+/** Start recording events for the rest of the lifetime of this process.
+ */
+svn_error_t *
+svn_profile__enable(void);
+
+/** Return TRUE if svn_profile__enable() has been called.
+ */
+svn_boolean_t
+svn_profile__enabled(void);
+
+/** Return the current time if profiling is enabled, and 0 otherwise.
+ * The result is meant to be passed to svn_profile__record() as @a start.
+ */
+apr_time_t
+svn_profile__start(void);
+
+/** Record one event of @a label in @a category that processed @a amount
+ * units of data (e.g. bytes) and, if @a start is not 0, took from
+ * @a start until now.  Do nothing if profiling is not enabled.
+ *
+ * The strings get copied when they are recorded for the first time.
+ */
+void
+svn_profile__record(const char *category,
+                    const char *label,
+                    apr_time_t start,
+                    apr_uint64_t amount);
+
+/** Write a table of everything that has been recorded so far to
+ * @a stream, sorted by category and by decreasing time within each
+ * category.  Use @a scratch_pool for temporary allocations.
+ */
+svn_error_t *
+svn_profile__print(svn_stream_t *stream,
+                   apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_PROFILE_H */
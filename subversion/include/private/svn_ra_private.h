@@ -298,6 +298,32 @@ svn_ra__replay_range_ev2(svn_ra_session_t *session,
                          void *cb_baton,
                          apr_pool_t *scratch_pool);
 
+/* Like svn_ra_replay_range(), but fetch the replay reports of up to
+   SESSIONS->NELTS revisions in parallel, one per svn_ra_session_t * in
+   SESSIONS.  Each session must have been opened to the same URL in its
+   own root pool and will be used by a separate worker thread only.
+
+   The workers record the editor drives of their revisions, keeping the
+   text deltas in spill buffers.  REVSTART_FUNC, the editor drive and
+   REVFINISH_FUNC are then invoked from the calling thread, strictly in
+   revision order, while the workers already fetch the following
+   revisions.  Periodically call CANCEL_FUNC with CANCEL_BATON.
+
+   Without thread support, this simply calls svn_ra_replay_range() on
+   the first session in SESSIONS. */
+svn_error_t *
+svn_ra__replay_range_prefetched(apr_array_header_t *sessions,
+                                svn_revnum_t start_revision,
+                                svn_revnum_t end_revision,
+                                svn_revnum_t low_water_mark,
+                                svn_boolean_t send_deltas,
+                                svn_ra_replay_revstart_callback_t revstart_func,
+                                svn_ra_replay_revfinish_callback_t revfinish_func,
+                                void *replay_baton,
+                                svn_cancel_func_t cancel_func,
+                                void *cancel_baton,
+                                apr_pool_t *pool);
+
 /* Similar to svn_ra_replay(), but with an Ev2 editor. */
 svn_error_t *
 svn_ra__replay_ev2(svn_ra_session_t *session,
@@ -308,6 +334,56 @@ svn_ra__replay_ev2(svn_ra_session_t *session,
                    apr_pool_t *scratch_pool);
 
 
+/* A persistent on-disk cache for repository data that can never change,
+   e.g. the contents of a file in a given revision.  It is shared by all
+   processes that use the same directory.  Keys are arbitrary strings and
+   values are byte streams. */
+typedef struct svn_ra__cache_t svn_ra__cache_t;
+
+/* Set *CACHE_P to a cache stored in DIR_ABSPATH, which gets created if
+   needed.  The least recently used entries are removed once the entries
+   take up more than MAX_SIZE bytes.  Allocate the cache in RESULT_POOL. */
+svn_error_t *
+svn_ra__cache_create(svn_ra__cache_t **cache_p,
+                     const char *dir_abspath,
+                     apr_int64_t max_size,
+                     apr_pool_t *result_pool);
+
+/* Return a copy of CACHE, allocated in RESULT_POOL. */
+svn_ra__cache_t *
+svn_ra__cache_dup(const svn_ra__cache_t *cache,
+                  apr_pool_t *result_pool);
+
+/* Set *STREAM_P to a stream reading the value of KEY in CACHE, or to NULL
+   if CACHE has no such entry.  Allocate the stream in RESULT_POOL and use
+   SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_ra__cache_get(svn_stream_t **stream_p,
+                  svn_ra__cache_t *cache,
+                  const char *key,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool);
+
+/* Set *STREAM_P to a stream that sets the value of KEY in CACHE to what
+   gets written to it.  The entry is added once the stream gets closed;
+   if RESULT_POOL gets cleared before that, nothing changes.  The stream
+   never returns errors; if the entry cannot be written, it is simply not
+   added.  Allocate the
+   stream in RESULT_POOL and use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_ra__cache_put(svn_stream_t **stream_p,
+                  svn_ra__cache_t *cache,
+                  const char *key,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool);
+
+/* Return the cache that SESSION uses for immutable repository data, or
+   NULL if caching is disabled.  Callers may store derived data there as
+   long as their keys identify it by exact revisions. */
+svn_ra__cache_t *
+svn_ra__get_cache(svn_ra_session_t *session);
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -132,6 +132,67 @@ svn_ra_svn__set_capabilities(svn_ra_svn_conn_t *conn,
 int
 svn_ra_svn__svndiff_version(svn_ra_svn_conn_t *conn);
 
+/** If @a adaptive is TRUE, let @a conn choose the compression of each
+ * svndiff stream it sends from the throughput it measures on the wire:
+ * no compression on fast links, lz4 on medium ones and zlib or zstd at
+ * the configured compression level on slow ones.
+ * svn_ra_svn__svndiff_version() and svn_ra_svn_compression_level() will
+ * then return the current choice.
+ *
+ * @since New in 1.15.
+ */
+void
+svn_ra_svn__set_adaptive_compression(svn_ra_svn_conn_t *conn,
+                                     svn_boolean_t adaptive);
+
+/** Let the I/O buffers of @a conn grow up to @a size bytes each during
+ * sustained transfers.  Larger buffers reduce the number of system calls
+ * on fast links.  Sizes below the initial buffer size disable the growth.
+ *
+ * @since New in 1.15.
+ */
+void
+svn_ra_svn__set_max_buffer_size(svn_ra_svn_conn_t *conn,
+                                apr_size_t size);
+
+/** Server-side TLS configuration, shared by all connections of a server.
+ *
+ * @since New in 1.15.
+ */
+typedef struct svn_ra_svn__tls_server_t svn_ra_svn__tls_server_t;
+
+/** Set @a *server to a TLS configuration that presents the PEM encoded
+ * certificate chain in @a cert_file and uses the unencrypted private key
+ * in @a key_file.  Allocate the result in @a result_pool.
+ *
+ * Create this once, before forking any connection handlers, so they all
+ * share the keys used to encrypt session tickets and clients can resume
+ * their TLS sessions with any of them.
+ *
+ * Return #SVN_ERR_UNSUPPORTED_FEATURE if Subversion was built without
+ * TLS support.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_ra_svn__tls_server_create(svn_ra_svn__tls_server_t **server,
+                              const char *cert_file,
+                              const char *key_file,
+                              apr_pool_t *result_pool);
+
+/** Negotiate TLS on the freshly created server-side connection @a conn,
+ * which talks over @a sock, using the configuration in @a server.  All
+ * further traffic on @a conn will be encrypted.  Use @a scratch_pool for
+ * temporary allocations.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_ra_svn__tls_accept(svn_ra_svn_conn_t *conn,
+                       apr_socket_t *sock,
+                       svn_ra_svn__tls_server_t *server,
+                       apr_pool_t *scratch_pool);
+
 
 /**
  * Set the shim callbacks to be used by @a conn to @a shim_callbacks.
@@ -140,6 +201,28 @@ svn_error_t *
 svn_ra_svn__set_shim_callbacks(svn_ra_svn_conn_t *conn,
                                svn_delta_shim_callbacks_t *shim_callbacks);
 
+/** Callback invoked by svn_ra_svn__handle_command() once the handler
+ * for the known command @a cmdname has returned.  @a duration is the time the handler took,
+ * @a bytes_in and @a bytes_out are the number of bytes received and sent
+ * for the command, including the command itself.  @a failed is set if the
+ * command returned an error.
+ */
+typedef void (*svn_ra_svn__command_hook_t)(void *baton,
+                                           const char *cmdname,
+                                           apr_interval_time_t duration,
+                                           apr_uint64_t bytes_in,
+                                           apr_uint64_t bytes_out,
+                                           svn_boolean_t failed);
+
+/**
+ * Make svn_ra_svn__handle_command() call @a hook with @a baton for every
+ * command it handles on @a conn.  A NULL @a hook disables the callback.
+ */
+void
+svn_ra_svn__set_command_hook(svn_ra_svn_conn_t *conn,
+                             svn_ra_svn__command_hook_t hook,
+                             void *baton);
+
 /**
  * Return the memory pool used to allocate @a conn.
  */
@@ -178,6 +261,21 @@ svn_ra_svn__write_cstring(svn_ra_svn_conn_t *conn,
                           apr_pool_t *pool,
                           const char *s);
 
+/** Write the @a len bytes at @a offset in @a file as a string over the net.
+ *
+ * If the connection writes to a plain socket, this flushes the write
+ * buffer and lets the operating system send the data straight from
+ * @a file.  Otherwise, the data gets read and buffered as usual.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_ra_svn__write_file_string(svn_ra_svn_conn_t *conn,
+                              apr_pool_t *pool,
+                              apr_file_t *file,
+                              apr_off_t offset,
+                              apr_size_t len);
+
 /** Write a word over the net.
  *
  * Writes will be buffered until the next read or flush.
@@ -225,6 +323,40 @@ svn_error_t *
 svn_ra_svn__flush(svn_ra_svn_conn_t *conn,
                   apr_pool_t *pool);
 
+/** Flush the write buffer of @a conn and start recording a copy of
+ * everything written to @a conn from now on, up to @a limit bytes.
+ * Allocate the recording in @a result_pool and use @a scratch_pool for
+ * temporary allocations.
+ *
+ * This is meant for servers that want to replay a response later.
+ */
+svn_error_t *
+svn_ra_svn__start_capture(svn_ra_svn_conn_t *conn,
+                          apr_size_t limit,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
+/** Flush the write buffer of @a conn and stop the recording started by
+ * svn_ra_svn__start_capture().  Set @a *captured to everything written in
+ * the meantime, or to NULL if that exceeded the limit.  The recording
+ * stops even if this returns an error.  Use @a scratch_pool for temporary
+ * allocations.
+ */
+svn_error_t *
+svn_ra_svn__end_capture(svn_stringbuf_t **captured,
+                        svn_ra_svn_conn_t *conn,
+                        apr_pool_t *scratch_pool);
+
+/** Write the @a len bytes at @a data verbatim to @a conn, e.g. to replay
+ * a recording returned by svn_ra_svn__end_capture().  Use @a pool for
+ * temporary allocations.
+ */
+svn_error_t *
+svn_ra_svn__write_raw(svn_ra_svn_conn_t *conn,
+                      apr_pool_t *pool,
+                      const char *data,
+                      apr_size_t len);
+
 /** Write a tuple, using a printf-like interface.
  *
  * The format string @a fmt may contain:
@@ -687,6 +819,17 @@ svn_ra_svn__write_cmd_reparent(svn_ra_svn_conn_t *conn,
                                apr_pool_t *pool,
                                const char *url);
 
+/** Send a "trace-context" command with the W3C @a traceparent over
+ * connection @a conn.  The server does not respond to it.
+ * Use @a pool for allocations.
+ *
+ * @see svn_trace__traceparent for a description.
+ */
+svn_error_t *
+svn_ra_svn__write_cmd_trace_context(svn_ra_svn_conn_t *conn,
+                                    apr_pool_t *pool,
+                                    const char *traceparent);
+
 /** Send a "get-latest-rev" command over connection @a conn.
  * Use @a pool for allocations.
  *
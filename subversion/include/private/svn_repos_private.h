@@ -124,6 +124,140 @@ const char *
 svn_repos__post_commit_error_str(svn_error_t *err,
                                  apr_pool_t *pool);
 
+/* Return a string that identifies the rules of AUTHZ, allocated in
+ * RESULT_POOL.  It is the same for all authz objects read from files with
+ * the same contents and can be used e.g. in cache keys.  Return NULL if
+ * AUTHZ has not been read by svn_repos_authz_read4().
+ */
+const char *
+svn_repos__authz_id(const svn_authz_t *authz,
+                    apr_pool_t *result_pool);
+
+/* Make all subsequent authz reads in this process look up the compiled
+ * rules in the directory DIR_ABSPATH before parsing the authz files and
+ * store them there after parsing.  The files are named after the contents
+ * of the authz files, so any number of processes may share DIR_ABSPATH,
+ * sparing all but the first the parser run.  DIR_ABSPATH will be created
+ * as needed.  Pass NULL to disable this.  POOL must outlive the setting.
+ *
+ * Call this before any threads use authz.
+ */
+void
+svn_repos__authz_set_cache_dir(const char *dir_abspath,
+                               apr_pool_t *pool);
+
+/* Let the report REPORT_BATON, returned by svn_repos_begin_report3(),
+ * prepare the text deltas of up to FILES files on a separate thread, ahead
+ * of the editor drive.  The order of the editor calls does not change.
+ *
+ * That thread opens the repository again, using FS_CONFIG, which must
+ * live as long as the report.  Since both threads share the global FS
+ * caches, these must have been configured for multi-threaded use.
+ *
+ * FILES being 0, the default, disables the prefetching, as does a lack of
+ * thread support.
+ */
+void
+svn_repos__report_set_prefetch(void *report_baton,
+                               int files,
+                               apr_hash_t *fs_config);
+
+/* Let svn_repos_get_logs5() on REPOS fetch the histories of multiple
+ * paths on up to THREADS separate threads, while it sends the log entries
+ * found so far.  The results do not change.
+ *
+ * Those threads open the repository again, using FS_CONFIG, which must
+ * live as long as REPOS.  Since all threads share the global FS caches,
+ * these must have been configured for multi-threaded use.
+ *
+ * THREADS being 0, the default, disables this, as does a lack of thread
+ * support.
+ */
+void
+svn_repos__set_log_threads(svn_repos_t *repos,
+                           int threads,
+                           apr_hash_t *fs_config);
+
+/* Callback invoked by svn_repos__replay_range() before replaying
+ * REVISION with the readable revision properties REV_PROPS.  Set *EDITOR
+ * and *EDIT_BATON to the editor to drive.  REPLAY_BATON is the baton
+ * given to svn_repos__replay_range().  Use POOL for all allocations.
+ */
+typedef svn_error_t *(*svn_repos__replay_revstart_func_t)(
+  svn_revnum_t revision,
+  void *replay_baton,
+  const svn_delta_editor_t **editor,
+  void **edit_baton,
+  apr_hash_t *rev_props,
+  apr_pool_t *pool);
+
+/* Callback invoked by svn_repos__replay_range() after EDITOR / EDIT_BATON
+ * have been driven for REVISION.  Closing the edit is up to the callback.
+ * The other parameters are as for svn_repos__replay_revstart_func_t.
+ */
+typedef svn_error_t *(*svn_repos__replay_revfinish_func_t)(
+  svn_revnum_t revision,
+  void *replay_baton,
+  const svn_delta_editor_t *editor,
+  void *edit_baton,
+  apr_hash_t *rev_props,
+  apr_pool_t *pool);
+
+/* For each revision from START_REVISION to END_REVISION in REPOS, read
+ * the revision properties with svn_repos_fs_revision_proplist() and pass
+ * them to REVSTART_FUNC, replay the revision to the editor it returns
+ * with svn_repos_replay2() and call REVFINISH_FUNC.  If the replay fails,
+ * abort the edit and return the error.  BASE_DIR, LOW_WATER_MARK,
+ * SEND_DELTAS, AUTHZ_READ_FUNC and AUTHZ_READ_BATON are passed on to
+ * those functions.
+ *
+ * If THREADS is positive, up to THREADS worker threads replay the
+ * following revisions into memory while the editor drive of the current
+ * one is in progress.  The callbacks are still invoked by the calling
+ * thread, strictly in revision order, and see the same editor calls.
+ * The workers open REPOS again, using FS_CONFIG, and share the global FS
+ * caches, so these must have been configured for multi-threaded use.
+ * AUTHZ_READ_FUNC gets called from the workers, one call at a time.
+ *
+ * THREADS being 0 or a lack of thread support disables the look-ahead.
+ *
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_repos__replay_range(svn_repos_t *repos,
+                        const char *base_dir,
+                        svn_revnum_t start_revision,
+                        svn_revnum_t end_revision,
+                        svn_revnum_t low_water_mark,
+                        svn_boolean_t send_deltas,
+                        int threads,
+                        apr_hash_t *fs_config,
+                        svn_repos_authz_func_t authz_read_func,
+                        void *authz_read_baton,
+                        svn_repos__replay_revstart_func_t revstart_func,
+                        svn_repos__replay_revfinish_func_t revfinish_func,
+                        void *replay_baton,
+                        svn_cancel_func_t cancel_func,
+                        void *cancel_baton,
+                        apr_pool_t *scratch_pool);
+
+/* Bring the path index of REPOS up to date with the youngest revision,
+ * applying the changes of all revisions since the last update.  If the
+ * index does not exist yet, create it if CREATE is set and do nothing
+ * otherwise.
+ *
+ * The index lists all paths of the youngest revision and lets
+ * svn_repos_list() search for name patterns without walking the tree.
+ *
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_repos__path_index_update(svn_repos_t *repos,
+                             svn_boolean_t create,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *scratch_pool);
+
 /* A repos version of svn_fs_type */
 svn_error_t *
 svn_repos__fs_type(const char **fs_type,
@@ -230,6 +364,129 @@ svn_repos__config_pool_get(svn_config_t **cfg,
 
 /** @} */
 
+/**
+ * @defgroup svn_repos_pool Repository object pool API
+ * @{
+ */
+
+/* Opaque, optionally thread-safe container for opened repositories.
+ *
+ * Opening a repository reads a number of files and sets up the FS caches.
+ * Servers may instead borrow an instance that an earlier request has
+ * already opened.  Each instance is only ever lent to one user at a time.
+ */
+typedef struct svn_repos__repos_pool_t svn_repos__repos_pool_t;
+
+/* Create a new, empty repository pool object with a lifetime determined
+ * by POOL and return it in *REPOS_POOL.  POOL should not be used for
+ * anything else and must outlive all repositories borrowed from the
+ * repository pool.
+ *
+ * The THREAD_SAFE flag indicates whether the pool actually needs to be
+ * thread-safe and POOL must also be thread-safe if this flag is set.
+ */
+svn_error_t *
+svn_repos__repos_pool_create(svn_repos__repos_pool_t **repos_pool,
+                             svn_boolean_t thread_safe,
+                             apr_pool_t *pool);
+
+/* Set *REPOS_P to an opened repository at PATH as svn_repos_open3 would
+ * return it for FS_CONFIG, with the hooks environment set to HOOKS_ENV
+ * as per svn_repos_hooks_setenv.  Reuse an idle instance from REPOS_POOL
+ * unless the repository's format, UUID or FS configuration files changed
+ * since that instance has been opened.
+ *
+ * The caller has exclusive use of *REPOS_P until RESULT_POOL gets cleaned
+ * up.  Then, the instance will be returned to REPOS_POOL; its FS access
+ * context, warning function, client capabilities and log thread settings
+ * will be reset.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_repos__repos_pool_get(svn_repos_t **repos_p,
+                          svn_repos__repos_pool_t *repos_pool,
+                          const char *path,
+                          apr_hash_t *fs_config,
+                          const char *hooks_env,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool);
+
+/** @} */
+
+/**
+ * @defgroup svn_repos_scheduler Request scheduling API
+ * @{
+ */
+
+/* Expensive operations whose concurrency a scheduler may limit. */
+typedef enum svn_repos__sched_op_t
+{
+  /* svn_repos_get_logs5() reporting changed paths. */
+  svn_repos__sched_op_log_changed_paths = 0,
+
+  /* svn_repos_get_file_revs2(). */
+  svn_repos__sched_op_file_revs,
+
+  /* A report at depth infinity, i.e. updates, checkouts, switches,
+   * diffs and status requests of whole trees. */
+  svn_repos__sched_op_report
+} svn_repos__sched_op_t;
+
+/* Number of svn_repos__sched_op_t values. */
+#define SVN_REPOS__SCHED_OP_COUNT 3
+
+/* Priority classes of requests. */
+typedef enum svn_repos__sched_class_t
+{
+  /* Requests of users waiting for the result.  These get admitted before
+   * any bulk request. */
+  svn_repos__sched_interactive = 0,
+
+  /* Requests of mirrors, scrapers and the like.  These never take the
+   * last free slot of an operation and give up their slot from time to
+   * time while interactive requests are waiting for it. */
+  svn_repos__sched_bulk
+} svn_repos__sched_class_t;
+
+/* Opaque, thread-safe admission control for expensive operations shared
+ * by all requests of a server process.
+ */
+typedef struct svn_repos__scheduler_t svn_repos__scheduler_t;
+
+/* Create a scheduler with a lifetime determined by POOL and return it in
+ * *SCHEDULER.  LIMITS has SVN_REPOS__SCHED_OP_COUNT elements, giving the
+ * number of operations of each svn_repos__sched_op_t that may run
+ * concurrently; 0 means no limit.  Requests of the users listed in
+ * BULK_USERS (const char *) belong to the bulk class.  BULK_USERS may be
+ * NULL.
+ */
+svn_error_t *
+svn_repos__scheduler_create(svn_repos__scheduler_t **scheduler,
+                            const int *limits,
+                            const apr_array_header_t *bulk_users,
+                            apr_pool_t *pool);
+
+/* Return the priority class of requests of USER in SCHEDULER.  USER may
+ * be NULL for anonymous requests.
+ */
+svn_repos__sched_class_t
+svn_repos__scheduler_classify(svn_repos__scheduler_t *scheduler,
+                              const char *user);
+
+/* Wait until SCHEDULER admits an operation OP of priority SCHED_CLASS on
+ * REPOS.  The operation keeps its slot until RESULT_POOL gets cleaned up.
+ *
+ * While it runs, the log, file-revs and report code of REPOS will check
+ * whether a bulk request should let interactive ones go first.
+ */
+svn_error_t *
+svn_repos__scheduler_admit(svn_repos__scheduler_t *scheduler,
+                           svn_repos_t *repos,
+                           svn_repos__sched_op_t op,
+                           svn_repos__sched_class_t sched_class,
+                           apr_pool_t *result_pool);
+
+/** @} */
+
 /* Adjust mergeinfo paths and revisions in ways that are useful when loading
  * a dump stream.
  *
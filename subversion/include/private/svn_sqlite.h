@@ -96,6 +96,12 @@ svn_sqlite__insert(apr_int64_t *row_id, svn_sqlite__stmt_t *stmt);
 svn_error_t *
 svn_sqlite__update(int *affected_rows, svn_sqlite__stmt_t *stmt);
 
+/* Return the number of rows inserted, updated or deleted through DB since
+   it was opened.  Comparing two return values tells whether DB has been
+   modified in between. */
+int
+svn_sqlite__total_changes(svn_sqlite__db_t *db);
+
 /* Return in *VERSION the version of the schema in DB. Use SCRATCH_POOL
    for temporary allocations.  */
 svn_error_t *
@@ -129,6 +135,17 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
                  apr_int32_t timeout,
                  apr_pool_t *result_pool, apr_pool_t *scratch_pool);
 
+/* Let DB keep up to CACHE_SIZE bytes of database pages in memory and
+   access up to the first MMAP_SIZE bytes of the database file through a
+   memory map.  Values <= 0 keep the respective SQLite default.  SQLite
+   silently limits MMAP_SIZE to what it has been compiled to support.
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_sqlite__set_memory_limits(svn_sqlite__db_t *db,
+                              apr_int64_t cache_size,
+                              apr_int64_t mmap_size,
+                              apr_pool_t *scratch_pool);
+
 /* Explicitly close the connection in DB. */
 svn_error_t *
 svn_sqlite__close(svn_sqlite__db_t *db);
@@ -147,6 +164,14 @@ svn_sqlite__create_scalar_function(svn_sqlite__db_t *db,
                                    svn_sqlite__func_t func,
                                    void *baton);
 
+/* Use STATEMENT_INFO[STMT_IDX][0] as the name of the statement STMT_IDX
+   of DB in profiles (see svn_profile.h).  STATEMENT_INFO must be parallel
+   to the STATEMENTS array passed to svn_sqlite__open() and have the same
+   lifetime.  This must be called before any statement gets used. */
+void
+svn_sqlite__set_statement_info(svn_sqlite__db_t *db,
+                               const char * const statement_info[][2]);
+
 /* Execute the (multiple) statements in the STATEMENTS[STMT_IDX] string.  */
 svn_error_t *
 svn_sqlite__exec_statements(svn_sqlite__db_t *db, int stmt_idx);
@@ -272,6 +272,27 @@ svn_cstring__reverse_match_length(const char *a,
                                   const char *b,
                                   apr_size_t max_len);
 
+/** A list of glob patterns, prepared for matching many strings against
+ * it.  Patterns without wildcards, "*SUFFIX" and "PREFIX*" patterns are
+ * looked up in hashes, so that the cost of a match mostly depends on the
+ * number of other patterns.
+ */
+typedef struct svn_cstring__glob_list_t svn_cstring__glob_list_t;
+
+/** Return the glob patterns in @a patterns, an array of const char *,
+ * as a list allocated in @a result_pool.
+ */
+svn_cstring__glob_list_t *
+svn_cstring__glob_list_create(const apr_array_header_t *patterns,
+                              apr_pool_t *result_pool);
+
+/** Return TRUE if @a str matches any pattern in @a list, exactly like
+ * svn_cstring_match_glob_list() would for the original patterns.
+ */
+svn_boolean_t
+svn_cstring__glob_list_match(const svn_cstring__glob_list_t *list,
+                             const char *str);
+
 /** @} */
 
 /** Prefix trees.
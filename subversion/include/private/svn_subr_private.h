@@ -269,6 +269,57 @@ svn_checksum__from_digest_fnv1a_32x4(const unsigned char *digest,
                                      apr_pool_t *result_pool);
 
 
+/**
+ * A checksum context that calculates checksums of several kinds over the
+ * same data in a single pass.
+ *
+ * @since New in 1.15
+ */
+typedef struct svn_checksum__multi_ctx_t svn_checksum__multi_ctx_t;
+
+/**
+ * Return a context for calculating checksums of the @a count kinds given
+ * in @a kinds, allocated in @a pool.
+ *
+ * @since New in 1.15
+ */
+svn_checksum__multi_ctx_t *
+svn_checksum__multi_ctx_create(const svn_checksum_kind_t *kinds,
+                               int count,
+                               apr_pool_t *pool);
+
+/**
+ * Reset the multi-checksum context @a ctx to its initial state, as if it
+ * was just created.
+ *
+ * @since New in 1.15
+ */
+svn_error_t *
+svn_checksum__multi_ctx_reset(svn_checksum__multi_ctx_t *ctx);
+
+/**
+ * Update all checksums in @a ctx with @a len bytes from @a data.
+ *
+ * @since New in 1.15
+ */
+svn_error_t *
+svn_checksum__multi_update(svn_checksum__multi_ctx_t *ctx,
+                           const void *data,
+                           apr_size_t len);
+
+/**
+ * Finalize the checksums in @a ctx and return them in @a checksums, which
+ * must have room for as many elements as kinds were given when creating
+ * @a ctx.  The order is the same as in that list.  Allocate the checksums
+ * in @a pool.
+ *
+ * @since New in 1.15
+ */
+svn_error_t *
+svn_checksum__multi_final(svn_checksum_t **checksums,
+                          const svn_checksum__multi_ctx_t *ctx,
+                          apr_pool_t *pool);
+
 /**
  * Return a stream that calculates a checksum of type @a kind over all
  * data written to the @a inner_stream.  When the returned stream gets
@@ -428,6 +479,58 @@ svn_hash__read_entry(svn_hash__entry_t *entry,
                      svn_boolean_t incremental,
                      apr_pool_t *pool);
 
+/** Parse the serialized hash in the @a len bytes at @a data, which has
+ * been read into memory as a whole, e.g. from a cache or a file.  Set
+ * @a *entries to an array of #svn_hash__entry_t in the order in which they
+ * appear in @a data, stopping at @a terminator or, if that is NULL, at the
+ * end of @a data.  @a incremental is as for svn_hash__read_entry().
+ *
+ * Unlike svn_hash__read_entry(), this does not copy the keys and values.
+ * Instead, the new line following each of them gets replaced by a NUL in
+ * @a data and the entries point into @a data, which must therefore live
+ * at least as long as @a *entries.  Allocate @a *entries in
+ * @a result_pool.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_hash__parse_entries(apr_array_header_t **entries,
+                        char *data,
+                        apr_size_t len,
+                        const char *terminator,
+                        svn_boolean_t incremental,
+                        apr_pool_t *result_pool);
+
+/** Like svn_hash_read2() but parse the serialized hash in place in the
+ * @a len bytes at @a data, as described for svn_hash__parse_entries().
+ * The keys in @a hash and the #svn_string_t values, which get allocated
+ * in @a pool, point into @a data.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_hash__parse(apr_hash_t *hash,
+                char *data,
+                apr_size_t len,
+                const char *terminator,
+                apr_pool_t *pool);
+
+/** Like svn_hash__parse() but set @a *items to an array of
+ * #svn_sort__item_t holding #svn_string_t values, sorted as by
+ * svn_sort_compare_items_lexically().  This is the same as what
+ * svn_sort__hash() would return for the result of svn_hash__parse() but
+ * needs no apr_hash_t.  If a key occurs more than once, its last value
+ * wins.  Allocate @a *items in @a result_pool.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_hash__parse_sorted(apr_array_header_t **items,
+                       char *data,
+                       apr_size_t len,
+                       const char *terminator,
+                       apr_pool_t *result_pool);
+
 /** @} */
 
 /** @} */
@@ -591,6 +694,30 @@ svn__decompress_lz4(const void *data, apr_size_t len,
                     svn_stringbuf_t *out,
                     apr_size_t limit);
 
+/* Same as svn__compress_zlib(), but use Zstandard compression at
+ * COMPRESSION_LEVEL (1 .. SVN__ZSTD_MAX_LEVEL).  Return
+ * SVN_ERR_UNSUPPORTED_FEATURE if Subversion has been built without
+ * Zstandard support; see svn_zstd__is_available().
+ */
+svn_error_t *
+svn__compress_zstd(const void *data, apr_size_t len,
+                   svn_stringbuf_t *out,
+                   int compression_level);
+
+/* Same as svn__decompress_zlib(), but use Zstandard compression.
+ * Return SVN_ERR_UNSUPPORTED_FEATURE if Subversion has been built
+ * without Zstandard support.
+ */
+svn_error_t *
+svn__decompress_zstd(const void *data, apr_size_t len,
+                     svn_stringbuf_t *out,
+                     apr_size_t limit);
+
+/* The default and the highest Zstandard compression level that we
+ * support.  Higher levels cost much more memory for little gain. */
+#define SVN__ZSTD_DEFAULT_LEVEL 3
+#define SVN__ZSTD_MAX_LEVEL 19
+
 /** @} */
 
 /**
@@ -726,6 +853,80 @@ svn_dso__pool(void);
 /** @} */
 
 
+/**
+ * @defgroup svn_slab Allocator for fixed-size objects
+ * @{
+ */
+
+/* A slab allocator hands out objects of a fixed size from a pool.
+ *
+ * Unlike plain pool allocations, objects can be released individually
+ * and will be reused by later allocations.  This keeps the memory
+ * footprint of long-running loops that keep creating and discarding
+ * small objects bounded.  Like pools, slab allocators are not
+ * thread-safe.
+ */
+typedef struct svn_slab__t svn_slab__t;
+
+/* Return a new slab allocator for objects of OBJECT_SIZE bytes.  The
+ * allocator and all objects will be allocated in POOL and be released
+ * when it gets cleared.
+ */
+svn_slab__t *
+svn_slab__create(apr_size_t object_size,
+                 apr_pool_t *pool);
+
+/* Return an uninitialized object from SLAB.  The result will be aligned
+ * like the results of apr_palloc().
+ */
+void *
+svn_slab__alloc(svn_slab__t *slab);
+
+/* Return OBJECT, which must have been allocated from SLAB, to SLAB for
+ * reuse.
+ */
+void
+svn_slab__free(svn_slab__t *slab,
+               void *object);
+
+/** @} */
+
+/**
+ * @defgroup svn_pool_memory Process memory accounting
+ * @{
+ */
+
+/* Set *CURRENT to the resident set size of this process in bytes and
+ * *PEAK to its high-water mark.  Either may be NULL.  Values that the
+ * platform cannot provide will be reported as 0.
+ *
+ * APR pools do not expose their footprint outside of APR_POOL_DEBUG
+ * builds, so these are process-wide figures.  In a multi-threaded server,
+ * they cover all concurrent requests.
+ */
+void
+svn_pool__memory_usage(apr_uint64_t *current,
+                       apr_uint64_t *peak);
+
+/* Limit the resident set size of this process to BUDGET bytes as checked
+ * by svn_pool__check_memory_budget().  0 disables the check, which is the
+ * default.  This should be called during start-up, before any threads
+ * have been spawned.
+ */
+void
+svn_pool__set_memory_budget(apr_uint64_t budget);
+
+/* Return SVN_ERR_MEMORY_BUDGET_EXCEEDED if the resident set size of this
+ * process exceeds the configured budget.  Only every few calls actually
+ * sample the process size, so this is cheap enough to be called from
+ * inner loops such as network writes.
+ */
+svn_error_t *
+svn_pool__check_memory_budget(void);
+
+/** @} */
+
+
 /* Return the xml (expat) version we compiled against. */
 const char *svn_xml__compiled_version(void);
 
@@ -746,6 +947,17 @@ const char *svn_lz4__compiled_version(void);
  */
 int svn_lz4__runtime_version(void);
 
+/* Return TRUE if Subversion has been built with Zstandard support. */
+svn_boolean_t svn_zstd__is_available(void);
+
+/* Return the Zstandard version we compiled against or NULL if we have
+ * been built without Zstandard support. */
+const char *svn_zstd__compiled_version(void);
+
+/* Return the Zstandard version we run against or NULL if we have been
+ * built without Zstandard support. */
+const char *svn_zstd__runtime_version(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,123 @@
+/**
+ * @copyright
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ * @endcopyright
+ *
+ * @file svn_trace.h
+ * @brief Spans for following a single operation across client and server
+ */
+
+#ifndef SVN_TRACE_H
+#define SVN_TRACE_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * A span covers one operation, e.g. an "svn update" in the client, the
+ * REPORT request that it sends or the reporter drive on the server.
+ * Spans nest: every span begun while another one is active on the same
+ * thread becomes a child of that span.  All spans that descend from the
+ * same root share a trace ID.
+ *
+ * The IDs of the active span can be passed to another process in the
+ * W3C Trace Context "traceparent" format.  A server that continues that
+ * trace makes its own spans children of the client's span, so that the
+ * spans of both sides can later be merged into a single tree.
+ *
+ * Tracing is off by default, in which case beginning a span costs no
+ * more than checking a flag.  Once enabled with svn_trace__enable(),
+ * every finished span appends one line to the trace file:
+ *
+ *   {"trace_id":"<32 hex digits>","span_id":"<16 hex digits>",
+ *    "parent_id":"<16 hex digits, empty for roots>","pid":<process ID>,
+ *    "component":"<category>","name":"<label>",
+ *    "start_us":<start time>,"duration_us":<duration>}
+ *
+ * (without the line breaks).  Times are in microseconds since the epoch.
+ * Lines are appended with a single unbuffered write, so several processes
+ * may share the same trace file.
+ */
+
+/** Opaque type of an active span. */
+typedef struct svn_trace__span_t svn_trace__span_t;
+
+/** The size of a buffer that can hold a traceparent string including
+ * its terminating NUL. */
+#define SVN_TRACE__TRACEPARENT_SIZE 56
+
+/** Start tracing for the rest of the lifetime of this process and append
+ * the spans to the file at @a path, creating it if necessary.  Calling
+ * this again has no effect.  Use @a scratch_pool for temporaries.
+ */
+svn_error_t *
+svn_trace__enable(const char *path,
+                  apr_pool_t *scratch_pool);
+
+/** Return TRUE if svn_trace__enable() has been called.
+ */
+svn_boolean_t
+svn_trace__enabled(void);
+
+/** Begin a span for @a label in @a category, e.g. "repos" and
+ * "finish-report", and make it the active span of the current thread.
+ * Return NULL if tracing is not enabled.
+ *
+ * The span must be finished with svn_trace__end() before the next span
+ * begun before it.  If that does not happen, e.g. because of an error
+ * return, the span ends when @a pool gets cleaned up.  Both strings must
+ * remain valid until then.
+ */
+svn_trace__span_t *
+svn_trace__begin(const char *category,
+                 const char *label,
+                 apr_pool_t *pool);
+
+/** Finish @a span and record it.  Make its parent the active span again.
+ * @a span may be NULL, in which case this does nothing.
+ */
+void
+svn_trace__end(svn_trace__span_t *span);
+
+/** Return the traceparent string for the active span of the current
+ * thread, allocated in @a result_pool.  Return NULL if there is no active
+ * span, in particular if tracing is not enabled.
+ */
+const char *
+svn_trace__traceparent(apr_pool_t *result_pool);
+
+/** Continue the trace described by @a traceparent: root spans that the
+ * current thread begins from now on become children of the span given
+ * there.  If @a traceparent is NULL or malformed, new root spans start
+ * new traces again.  Do nothing if tracing is not enabled.
+ */
+void
+svn_trace__continue(const char *traceparent);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_TRACE_H */
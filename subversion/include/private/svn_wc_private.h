@@ -434,6 +434,25 @@ svn_wc__node_get_not_present_children(const apr_array_header_t **children,
                                       apr_pool_t *result_pool,
                                       apr_pool_t *scratch_pool);
 
+/**
+ * Set @a *children to a hash whose keys are the names of the immediate
+ * children of @a dir_abspath that svn_wc_add_from_disk3() would refuse
+ * with #SVN_ERR_ENTRY_EXISTS: those that are versioned, not deleted or
+ * not-present, and not in conflict.  The values are undefined.
+ *
+ * This lets bulk additions skip the versioned part of a tree after
+ * reading the working copy once per directory.
+ *
+ * Allocate @a *children in @a result_pool.  Use @a wc_ctx to access the
+ * working copy, and @a scratch_pool for all temporary allocations.
+ */
+svn_error_t *
+svn_wc__get_existing_children(apr_hash_t **children,
+                              svn_wc_context_t *wc_ctx,
+                              const char *dir_abspath,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
 /**
  * Fetch the repository information for the working version
  * of the node at @a local_abspath into @a *revision, @a *repos_relpath,
@@ -778,6 +797,25 @@ svn_wc__call_with_write_lock(svn_wc__with_write_lock_func_t func,
     SVN_ERR(svn_error_compose_create(svn_wc__err1, svn_wc__err2));            \
   } while (0)
 
+/** Call function @a func with @a baton, @a result_pool and @a scratch_pool
+ * within a single database transaction on the working copy of
+ * @a local_abspath, using @a wc_ctx for working copy access.
+ *
+ * Changes that @a func makes to that working copy through @a wc_ctx, e.g.
+ * with svn_wc_add_from_disk3(), get committed together, which is much
+ * cheaper for large batches than committing every change on its own.
+ * They get rolled back together if @a func returns an error.
+ *
+ * The caller should hold a write lock on the working copy.
+ */
+svn_error_t *
+svn_wc__call_in_txn(svn_wc__with_write_lock_func_t func,
+                    void *baton,
+                    svn_wc_context_t *wc_ctx,
+                    const char *local_abspath,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool);
+
 
 /** A callback invoked by svn_wc__prop_list_recursive().
  * It is equivalent to svn_proplist_receiver_t declared in svn_client.h,
@@ -987,6 +1025,55 @@ svn_wc__has_local_mods(svn_boolean_t *is_modified,
                        void *cancel_baton,
                        apr_pool_t *scratch_pool);
 
+/* Like svn_wc_revision_status2(), but set @a (*result_p)->modified from
+ * the local changes recorded in the working copy database and the kind,
+ * size and timestamp of the working files, without comparing any file
+ * contents.  A file that was touched without changing it is reported as
+ * modified.  If the working copy has a filesystem monitor configured,
+ * only the directories that it reports as changed are checked on disk.
+ */
+svn_error_t *
+svn_wc__revision_status_fast(svn_wc_revision_status_t **result_p,
+                             svn_wc_context_t *wc_ctx,
+                             const char *local_abspath,
+                             const char *trail_url,
+                             svn_boolean_t committed,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool);
+
+/* Find the nodes in the tree rooted at @a local_abspath that a commit
+ * of @a local_abspath with depth infinity may have to look at, without
+ * walking the tree.
+ *
+ * The nodes are read from the working copy database with a single query.
+ * Nodes with tree or property changes are always included.  Versioned
+ * files and directories are checked on disk, in parallel if threads are
+ * available, and included if their kind changed or the recorded size or
+ * timestamp of a file doesn't match its working file any more.  File
+ * externals below @a local_abspath are not included.
+ *
+ * Set @a *candidates to an array of const char * absolute paths of these
+ * nodes, sorted in depth-first order.  @a local_abspath is always the
+ * first element.  The array is a superset of the nodes for which a status
+ * walk would report a committable status.
+ *
+ * If the tree contains conflicts, set @a *candidates to @c NULL, as the
+ * commit has to be aborted and a full status walk reports why.
+ *
+ * Allocate @a *candidates in @a result_pool, use @a scratch_pool for
+ * temporary allocations.
+ */
+svn_error_t *
+svn_wc__find_commit_candidates(apr_array_header_t **candidates,
+                               svn_wc_context_t *wc_ctx,
+                               const char *local_abspath,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
 /* Renames a working copy from @a from_abspath to @a dst_abspath and makes sure
    open handles are closed to allow this on all platforms.
 
@@ -1008,6 +1095,84 @@ svn_wc__get_tmpdir(const char **tmpdir_abspath,
                    apr_pool_t *result_pool,
                    apr_pool_t *scratch_pool);
 
+/* The result of a three-way text merge that was computed ahead of
+   svn_wc__merge_precomputed() by svn_wc__merge_text_ahead(). */
+typedef struct svn_wc__text_merge_t
+{
+  /* The inputs the merge was computed from. */
+  const char *left_abspath;
+  const char *right_abspath;
+  const char *target_abspath;
+
+  /* The merged text, in repository normal form. */
+  const char *result_abspath;
+
+  /* Whether RESULT_ABSPATH contains conflict markers. */
+  svn_boolean_t contains_conflicts;
+} svn_wc__text_merge_t;
+
+/* Run the internal three-way text merge of the changes between
+   LEFT_ABSPATH and RIGHT_ABSPATH into the working file TARGET_ABSPATH,
+   as svn_wc_merge6() would do with a NULL diff3_cmd, and write the
+   result to a new unique file in TMPDIR_ABSPATH.  TMPDIR_ABSPATH should
+   be the directory returned by svn_wc__get_tmpdir() for TARGET_ABSPATH.
+   LEFT_LABEL, RIGHT_LABEL, TARGET_LABEL and MERGE_OPTIONS are as for
+   svn_wc_merge6().
+
+   This function does not access the working copy database, so several
+   merges may be computed in parallel from different threads.  The working
+   file is used as-is; if it needs translation into repository normal form
+   the result will not be used by svn_wc__merge_precomputed().
+
+   Set *RESULT to the outcome, allocated in RESULT_POOL.  The caller is
+   responsible for removing (*RESULT)->result_abspath when it is not
+   consumed by svn_wc__merge_precomputed().  */
+svn_error_t *
+svn_wc__merge_text_ahead(svn_wc__text_merge_t **result,
+                         const char *left_abspath,
+                         const char *right_abspath,
+                         const char *target_abspath,
+                         const char *left_label,
+                         const char *right_label,
+                         const char *target_label,
+                         const apr_array_header_t *merge_options,
+                         const char *tmpdir_abspath,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool);
+
+/* Like svn_wc_merge6(), but use the text merge PRECOMPUTED by
+   svn_wc__merge_text_ahead() with the same LEFT_ABSPATH, RIGHT_ABSPATH,
+   TARGET_ABSPATH, labels and MERGE_OPTIONS, when it still applies.
+   Otherwise the merge is computed as usual.  PRECOMPUTED may be NULL.
+
+   PRECOMPUTED->result_abspath may be consumed by the merge; callers
+   should remove it afterwards, ignoring a missing file. */
+svn_error_t *
+svn_wc__merge_precomputed(enum svn_wc_merge_outcome_t *merge_content_outcome,
+                          enum svn_wc_notify_state_t *merge_props_outcome,
+                          svn_wc_context_t *wc_ctx,
+                          const char *left_abspath,
+                          const char *right_abspath,
+                          const char *target_abspath,
+                          const char *left_label,
+                          const char *right_label,
+                          const char *target_label,
+                          const svn_wc_conflict_version_t *left_version,
+                          const svn_wc_conflict_version_t *right_version,
+                          svn_boolean_t dry_run,
+                          const char *diff3_cmd,
+                          const apr_array_header_t *merge_options,
+                          apr_hash_t *original_props,
+                          const apr_array_header_t *prop_diff,
+                          const svn_wc__text_merge_t *precomputed,
+                          svn_wc_conflict_resolver_func2_t conflict_func,
+                          void *conflict_baton,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool);
+
 /* Gets information needed by the commit harvester.
  *
  * ### Currently this API is work in progress and is designed for just this
@@ -2157,6 +2322,15 @@ svn_wc__working_file_writer_open(svn_wc__working_file_writer_t **writer_p,
 svn_stream_t *
 svn_wc__working_file_writer_get_stream(svn_wc__working_file_writer_t *writer);
 
+/* Return the svn_checksum_fnv1a_32x4 checksum of the contents written
+   through the stream of WRITER, as they are stored on disk (i.e. after
+   translation), or NULL if that is not available.  The checksum only
+   becomes available when that stream has been closed, and never for
+   special files. */
+const svn_checksum_t *
+svn_wc__working_file_writer_get_fingerprint(
+  svn_wc__working_file_writer_t *writer);
+
 /* Finalize the content, attributes and the timestamps of the underlying
    temporary file.  Return the properties of the finalized file in MTIME_P
    and SIZE_P.  MTIME_P and SIZE_P both may be NULL. */
@@ -2340,6 +2514,49 @@ svn_wc__get_settings(int *format_p,
                      const char *local_abspath,
                      apr_pool_t *scratch_pool);
 
+/* A text-base to fetch with a svn_wc__textbase_fetch_batch_cb_t. */
+typedef struct svn_wc__textbase_fetch_t
+{
+  const char *repos_root_url;
+  const char *repos_relpath;
+  svn_revnum_t revision;
+
+  /* The stream to write the contents to. */
+  svn_stream_t *contents;
+} svn_wc__textbase_fetch_t;
+
+/* The callback invoked by svn_wc__textbase_sync() to provide the contents
+   of the text-bases in FETCHES, an array of svn_wc__textbase_fetch_t *.
+
+   The callback is expected to write the contents of each text-base to its
+   stream and close all of the streams, also when returning an error. */
+typedef svn_error_t *(*svn_wc__textbase_fetch_batch_cb_t)(
+  void *baton,
+  const apr_array_header_t *fetches,
+  svn_cancel_func_t cancel_func,
+  void *cancel_baton,
+  apr_pool_t *scratch_pool);
+
+/* Like svn_wc_textbase_sync(), but fetch the missing text-bases in
+   batches through FETCH_CALLBACK and FETCH_BATON, so that the callback can
+   pipeline the requests for them.
+
+   After dehydrating, keep unreferenced text-bases up to the size
+   configured as SVN_CONFIG_OPTION_TEXTBASE_CACHE_SIZE, removing the least
+   recently used ones first. */
+svn_error_t *
+svn_wc__textbase_sync(svn_wc_context_t *wc_ctx,
+                      const char *local_abspath,
+                      svn_boolean_t allow_hydrate,
+                      svn_boolean_t allow_dehydrate,
+                      svn_wc__textbase_fetch_batch_cb_t fetch_callback,
+                      void *fetch_baton,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      svn_wc_notify_func2_t notify_func,
+                      void *notify_baton,
+                      apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
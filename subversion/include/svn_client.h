@@ -3020,6 +3020,49 @@ svn_client_blame6(svn_revnum_t *start_revnum_p,
                   svn_client_ctx_t *ctx,
                   apr_pool_t *pool);
 
+/**
+ * Similar to svn_client_blame6() with @a include_merged_revisions set to
+ * FALSE, but able to continue a blame computed before instead of
+ * processing all revisions again.
+ *
+ * If @a state is not @c NULL, it must have been returned by an earlier
+ * call for @a path_or_url.  Then @a start is ignored and only the
+ * revisions after the end revision of that call up to @a end get
+ * processed.  @a end must not resolve to an older revision than that.
+ * If @a state was made for another repository or another line of history
+ * return #SVN_ERR_CLIENT_UNRELATED_RESOURCES.
+ *
+ * If @a state_p is not @c NULL, set @a *state_p to a compact
+ * serialization of the blame up to @a end, allocated in @a result_pool,
+ * that may be cached and passed as @a state later.  Local modifications
+ * are not part of it.  In this case, @a start must not resolve to a
+ * revision younger than @a end.
+ *
+ * Of the revision properties, only #SVN_PROP_REVISION_AUTHOR and
+ * #SVN_PROP_REVISION_DATE are kept in the state, so @a receiver will see
+ * only these for lines blamed on revisions taken from @a state.
+ *
+ * Use @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_client_blame_incremental(svn_stringbuf_t **state_p,
+                             svn_revnum_t *start_revnum_p,
+                             svn_revnum_t *end_revnum_p,
+                             const char *path_or_url,
+                             const svn_opt_revision_t *peg_revision,
+                             const svn_opt_revision_t *start,
+                             const svn_opt_revision_t *end,
+                             const svn_string_t *state,
+                             const svn_diff_file_options_t *diff_options,
+                             svn_boolean_t ignore_mime_type,
+                             svn_client_blame_receiver4_t receiver,
+                             void *receiver_baton,
+                             svn_client_ctx_t *ctx,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool);
+
 
 /**
  * Similar to svn_client_blame6(), but with #svn_client_blame_receiver3_t
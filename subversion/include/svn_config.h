@@ -129,6 +129,8 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_KWALLET_SVN_APPLICATION_NAME_WITH_PID "kwallet-svn-application-name-with-pid"
 /** @since New in 1.8. */
 #define SVN_CONFIG_OPTION_SSL_CLIENT_CERT_FILE_PROMPT "ssl-client-cert-file-prompt"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_CREDENTIALS_CACHE_TTL     "credentials-cache-ttl"
 /* The majority of options of the "auth" section
  * has been moved to SVN_CONFIG_CATEGORY_SERVERS. */
 #define SVN_CONFIG_SECTION_HELPERS              "helpers"
@@ -161,6 +163,12 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_MEMORY_CACHE_SIZE         "memory-cache-size"
 /** @since New in 1.9. */
 #define SVN_CONFIG_OPTION_DIFF_IGNORE_CONTENT_TYPE  "diff-ignore-content-type"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_DELTA_SOURCE_TRACKING     "enable-delta-source-tracking"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_RA_CACHE_SIZE             "ra-cache-size"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_RA_CACHE_DIR              "ra-cache-dir"
 #define SVN_CONFIG_SECTION_TUNNELS              "tunnels"
 #define SVN_CONFIG_SECTION_AUTO_PROPS           "auto-props"
 /** @since New in 1.8. */
@@ -173,6 +181,22 @@ typedef struct svn_config_t svn_config_t;
 #define SVN_CONFIG_OPTION_SQLITE_BUSY_TIMEOUT       "busy-timeout"
 /** @since New in 1.15. */
 #define SVN_CONFIG_OPTION_COMPATIBLE_VERSION        "compatible-version"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_SQLITE_WAL                "write-ahead-logging"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_FSMONITOR_HOOK            "fsmonitor-hook"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_SQLITE_CACHE_SIZE         "sqlite-cache-size"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_SQLITE_MMAP_SIZE          "sqlite-mmap-size"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_TEXTBASE_CACHE_SIZE       "textbase-cache-size"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_SHARED_PRISTINE_STORE     "shared-pristine-store"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_EXTERNALS_PARALLELISM     "externals-parallelism"
+/** @since New in 1.15. */
+#define SVN_CONFIG_OPTION_RECLAIM_PRISTINES         "reclaim-pristines"
 /** @} */
 
 /** @name Repository conf directory configuration files strings
@@ -413,6 +413,15 @@ extern "C" {
 #define SVN_DAV_NS_DAV_SVN_SVNDIFF2\
             SVN_DAV_PROP_NS_DAV "svn/svndiff2"
 
+/** Presence of this in a DAV header in an OPTIONS response indicates
+ * that the transmitter (in this case, the server) knows how to handle
+ * svndiff3 format encoding.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_DAV_NS_DAV_SVN_SVNDIFF3\
+            SVN_DAV_PROP_NS_DAV "svn/svndiff3"
+
 /** Presence of this in a DAV header in an OPTIONS response indicates
  * that the transmitter (in this case, the server) sends the result
  * checksum in the response to a successful PUT request.
@@ -422,6 +431,46 @@ extern "C" {
 #define SVN_DAV_NS_DAV_SVN_PUT_RESULT_CHECKSUM\
             SVN_DAV_PROP_NS_DAV "svn/put-result-checksum"
 
+/** Presence of this in a DAV header in an OPTIONS response indicates
+ * that the transmitter (in this case, the server) knows how to handle
+ * 'blame' requests.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_DAV_NS_DAV_SVN_BLAME\
+            SVN_DAV_PROP_NS_DAV "svn/blame"
+
+/** Presence of this in a DAV header in an OPTIONS response indicates
+ * that the transmitter (in this case, the server) is prepared to serve
+ * hundreds of concurrent GET and PROPFIND requests of an update on a
+ * single HTTP/2 connection.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_DAV_NS_DAV_SVN_MULTIPLEXED_FETCHES\
+            SVN_DAV_PROP_NS_DAV "svn/multiplexed-fetches"
+
+/** Presence of this in a DAV header in an OPTIONS response indicates
+ * that the transmitter (in this case, the server) accepts an
+ * &lt;S:inline-contents-max&gt; element in 'list' requests and then
+ * sends the base64-encoded contents of all files not larger than the
+ * given number of bytes with their list items.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_DAV_NS_DAV_SVN_LIST_INLINE_CONTENTS\
+            SVN_DAV_PROP_NS_DAV "svn/list-inline-contents"
+
+/** Presence of this in a DAV header in an OPTIONS response indicates
+ * that the transmitter (in this case, the server) accepts multiple
+ * &lt;S:dir-path&gt; elements in 'list' requests and then sends the
+ * entries of each of these directories in an &lt;S:dir&gt; element.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_DAV_NS_DAV_SVN_LIST_DIRS\
+            SVN_DAV_PROP_NS_DAV "svn/list-dirs"
+
 /** @} */
 
 /** @} */
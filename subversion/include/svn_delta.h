@@ -383,10 +383,33 @@ svn_txdelta_md5_digest(svn_txdelta_stream_t *stream);
  * is set, you may call svn_txdelta_md5_digest() to get an MD5 checksum
  * for @a target.
  *
+ * If @a track_source is set, every delta window will use the part of
+ * @a source that best matches the respective target data, as found by a
+ * fingerprint index over the next few megabytes of @a source.  This finds
+ * matches even after large insertions or deletions, at the expense of
+ * additional memory and CPU usage.  Otherwise, every target window will
+ * only be compared to the source data at the same offset.  In both cases,
+ * the windows are valid for all svndiff consumers.
+ *
  * Do any necessary allocation in a sub-pool of @a pool.
  *
+ * @since New in 1.15.
+ */
+void
+svn_txdelta3(svn_txdelta_stream_t **stream,
+             svn_stream_t *source,
+             svn_stream_t *target,
+             svn_boolean_t calculate_checksum,
+             svn_boolean_t track_source,
+             apr_pool_t *pool);
+
+/** Similar to svn_txdelta3 but with @a track_source always set to
+ * @c FALSE.
+ *
  * @since New in 1.8.
+ * @deprecated Provided for backward compatibility with the 1.14 API.
  */
+SVN_DEPRECATED
 void
 svn_txdelta2(svn_txdelta_stream_t **stream,
              svn_stream_t *source,
@@ -414,8 +437,24 @@ svn_txdelta(svn_txdelta_stream_t **stream,
  * The stream handler functions will read data from @a source as
  * necessary.
  *
+ * @a track_source has the same meaning as in svn_txdelta3().
+ *
+ * @since New in 1.15.
+ */
+svn_stream_t *
+svn_txdelta_target_push2(svn_txdelta_window_handler_t handler,
+                         void *handler_baton,
+                         svn_stream_t *source,
+                         svn_boolean_t track_source,
+                         apr_pool_t *pool);
+
+/** Similar to svn_txdelta_target_push2() but with @a track_source always
+ * set to @c FALSE.
+ *
  * @since New in 1.1.
+ * @deprecated Provided for backward compatibility with the 1.14 API.
  */
+SVN_DEPRECATED
 svn_stream_t *
 svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
                         void *handler_baton,
@@ -545,7 +584,12 @@ svn_txdelta_apply(svn_stream_t *source,
  *
  * @since New in 1.7.  Since 1.10, @a svndiff_version can be 2 for the
  * svndiff2 format.  @a compression_level is currently ignored if
- * @a svndiff_version is set to 2.
+ * @a svndiff_version is set to 2.  Since 1.15, @a svndiff_version can be
+ * 3 for the Zstandard based svndiff3 format.  In that case,
+ * @a compression_level is the Zstandard compression level and values
+ * outside the range 1 to 19 are clamped to it.  Writing svndiff3 fails
+ * with #SVN_ERR_UNSUPPORTED_FEATURE if Subversion has been built without
+ * Zstandard support.
  */
 void
 svn_txdelta_to_svndiff3(svn_txdelta_window_handler_t *handler,
@@ -487,6 +487,14 @@ typedef struct svn_diff_file_options_t
    *
    * @since New in 1.9 */
   int context_size;
+
+  /** Use the histogram diff algorithm instead of the default one.  It
+   * produces a possibly non-minimal diff but runs in bounded time and
+   * memory, even on large inputs with many changes.  The default is
+   * @c FALSE.
+   *
+   * @since New in 1.15. */
+  svn_boolean_t histogram;
 } svn_diff_file_options_t;
 
 /** Allocate a @c svn_diff_file_options_t structure in @a pool, initializing
@@ -510,6 +518,7 @@ svn_diff_file_options_create(apr_pool_t *pool);
  * - --ignore-eol-style
  * - --show-c-function, -p @since New in 1.5.
  * - --context, -U ARG @since New in 1.9.
+ * - --histogram @since New in 1.15.
  * - --unified, -u (for compatibility, does nothing).
  */
 svn_error_t *
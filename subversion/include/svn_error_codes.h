@@ -1518,6 +1518,21 @@ SVN_ERROR_START
              SVN_ERR_MISC_CATEGORY_START + 47,
              "Could not canonicalize path or URI")
 
+  /** @since New in 1.15. */
+  SVN_ERRDEF(SVN_ERR_ZSTD_COMPRESSION_FAILED,
+             SVN_ERR_MISC_CATEGORY_START + 48,
+             "Zstandard compression failed")
+
+  /** @since New in 1.15. */
+  SVN_ERRDEF(SVN_ERR_ZSTD_DECOMPRESSION_FAILED,
+             SVN_ERR_MISC_CATEGORY_START + 49,
+             "Zstandard decompression failed")
+
+  /** @since New in 1.15. */
+  SVN_ERRDEF(SVN_ERR_MEMORY_BUDGET_EXCEEDED,
+             SVN_ERR_MISC_CATEGORY_START + 50,
+             "The process exceeded its configured memory budget")
+
   /* command-line client errors */
 
   SVN_ERRDEF(SVN_ERR_CL_ARG_PARSING_ERROR,
@@ -1623,6 +1638,16 @@ SVN_ERROR_START
              SVN_ERR_RA_SVN_CATEGORY_START + 10,
              "Server response too long")
 
+  /** @since New in 1.15  */
+  SVN_ERRDEF(SVN_ERR_RA_SVN_TLS_FAILED,
+             SVN_ERR_RA_SVN_CATEGORY_START + 11,
+             "TLS negotiation failed")
+
+  /** @since New in 1.15  */
+  SVN_ERRDEF(SVN_ERR_RA_SVN_TLS_CERT_UNTRUSTED,
+             SVN_ERR_RA_SVN_CATEGORY_START + 12,
+             "Server TLS certificate untrusted")
+
   /* libsvn_auth errors */
 
        /* this error can be used when an auth provider doesn't have
@@ -553,10 +553,34 @@ typedef void (*svn_fs_hotcopy_notify_t)(void *baton,
  * @a cancel_baton as usual to allow the user to preempt this potentially
  * lengthy operation.
  *
+ * Backends that support it will copy up to @a jobs independent units
+ * of data, e.g. FSFS shards, concurrently.  Values less than 2 select
+ * sequential processing.  Notifications will still be sent from the
+ * calling thread and in revision order.
+ *
  * Use @a scratch_pool for temporary allocations.
  *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_fs_hotcopy4(const char *src_path,
+                const char *dest_path,
+                svn_boolean_t clean,
+                svn_boolean_t incremental,
+                int jobs,
+                svn_fs_hotcopy_notify_t notify_func,
+                void *notify_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_fs_hotcopy4(), but with @a jobs set to 1.
+ *
  * @since New in 1.9.
+ * @deprecated Provided for backward compatibility with the 1.14 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_fs_hotcopy3(const char *src_path,
                 const char *dest_path,
@@ -2339,6 +2363,33 @@ svn_fs_dir_optimal_order(apr_array_header_t **ordered_p,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool);
 
+/** Compare the entries of the directory at @a source_path in
+ * @a source_root with those of the directory at @a target_path in
+ * @a target_root and return only those that differ.
+ *
+ * Set @a *source_entries_p and @a *target_entries_p to newly allocated
+ * APR hash tables like those returned by svn_fs_dir_entries(), except
+ * that all names referring to the same node revision on both sides are
+ * omitted from both tables.  Names missing from both tables are thus
+ * either unchanged or absent on both sides.  If both paths refer to the
+ * same directory node revision, the entries will not be read at all and
+ * both tables will be empty.
+ *
+ * Allocate the tables and their contents in @a result_pool and use
+ * @a scratch_pool for temporary allocations.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_fs_dir_entries_changed(apr_hash_t **source_entries_p,
+                           apr_hash_t **target_entries_p,
+                           svn_fs_root_t *source_root,
+                           const char *source_path,
+                           svn_fs_root_t *target_root,
+                           const char *target_path,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
 /** Create a new directory named @a path in @a root.  The new directory has
  * no entries, and no properties.  @a root must be the root of a transaction,
  * not a revision.
@@ -2502,6 +2553,24 @@ svn_fs_file_contents(svn_stream_t **contents,
                      const char *path,
                      apr_pool_t *pool);
 
+/** Like svn_fs_file_contents(), but let @a *contents start at byte
+ * @a offset of the file @a path in @a root.  If @a offset is beyond the
+ * end of the file, @a *contents will be empty.
+ *
+ * Backends may position the stream without reconstructing the data in
+ * front of @a offset.  FSFS, for instance, only combines the delta windows
+ * that cover @a offset and beyond.  Since the file is not read as a whole,
+ * its checksum will not be verified.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_fs_file_contents_at(svn_stream_t **contents,
+                        svn_fs_root_t *root,
+                        const char *path,
+                        svn_filesize_t offset,
+                        apr_pool_t *pool);
+
 /**
  * Callback function type used with svn_fs_try_process_file_contents()
  * that delivers the immutable, non-NULL @a contents of @a len bytes.
@@ -3304,8 +3373,29 @@ typedef svn_error_t *(*svn_fs_pack_notify_t)(void *baton,
  * Possibly update the filesystem located in the directory @a path
  * to use disk space more efficiently.
  *
+ * Backends that support it will process up to @a jobs independent units
+ * of work, e.g. FSFS shards, concurrently.  Values less than 2 select
+ * sequential processing.  Notifications will still be sent from the
+ * calling thread and in shard order.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_fs_pack2(const char *db_path,
+             int jobs,
+             svn_fs_pack_notify_t notify_func,
+             void *notify_baton,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *pool);
+
+/**
+ * Like svn_fs_pack2(), but with @a jobs set to 1.
+ *
  * @since New in 1.6.
+ * @deprecated Provided for backward compatibility with the 1.14 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_fs_pack(const char *db_path,
             svn_fs_pack_notify_t notify_func,
@@ -3503,6 +3593,58 @@ svn_fs_info_dup(const void *info,
                 apr_pool_t *result_pool,
                 apr_pool_t *scratch_pool);
 
+/**
+ * I/O statistics collected by a #svn_fs_t object over its lifetime.
+ * Callers may take two snapshots and subtract them to get the costs of
+ * the operations in between.
+ *
+ * @note Fields may be added to the end of this structure in future
+ * versions.  Therefore, users shouldn't allocate structures of this
+ * type, to preserve binary compatibility.
+ *
+ * @see svn_fs_get_io_stats
+ *
+ * @since New in 1.15.
+ */
+typedef struct svn_fs_io_stats_t
+{
+  /** Number of revision and pack files opened. */
+  apr_uint64_t files_opened;
+
+  /** Number of lookups in the log-to-phys and phys-to-log indexes. */
+  apr_uint64_t index_lookups;
+
+  /** Number of items (noderevs, changed paths lists, directories etc.)
+   * and delta windows read from revision and pack files. */
+  apr_uint64_t items_read;
+
+  /** Total on-disk size of the items in @c items_read, in bytes. */
+  apr_uint64_t bytes_read;
+
+  /** Total size of the delta window data that had to be decompressed
+   * after reading it from disk, in bytes. */
+  apr_uint64_t bytes_decompressed;
+
+  /** Number of lookups in the caches of this filesystem object. */
+  apr_uint64_t cache_gets;
+
+  /** Number of @c cache_gets that found the requested data. */
+  apr_uint64_t cache_hits;
+} svn_fs_io_stats_t;
+
+/**
+ * Set @a *stats to the I/O statistics collected by @a fs since it has
+ * been opened, allocated in @a result_pool.
+ *
+ * Backends that don't collect such statistics return all counters as 0.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_fs_get_io_stats(svn_fs_io_stats_t **stats,
+                    svn_fs_t *fs,
+                    apr_pool_t *result_pool);
+
 /**
  * A structure specifying the filesystem-specific input/output operation.
  *
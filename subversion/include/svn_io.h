@@ -345,6 +345,9 @@ svn_io_temp_dir(const char **dir,
  * Overwrite @a dst if it exists, else create it.  Both @a src and @a dst
  * are utf8-encoded filenames.  If @a copy_perms is TRUE, set @a dst's
  * permissions to match those of @a src.
+ *
+ * Where the platform and file system support it, @a dst will be a
+ * copy-on-write clone of @a src or be copied within the kernel.
  */
 svn_error_t *
 svn_io_copy_file(const char *src,
@@ -1898,6 +1898,62 @@ svn_ra_get_file_revs2(svn_ra_session_t *session,
                       void *handler_baton,
                       apr_pool_t *pool);
 
+/**
+ * Callback type to be used with svn_ra_get_blame().  It will be invoked
+ * once for every chunk of consecutive lines that have been last changed
+ * in the same revision, in the order of the lines in the file.
+ *
+ * The chunk starts at the zero-based line number @a start_line and
+ * extends up to the start of the next chunk or the end of the file.
+ * @a revision is the revision that last changed these lines and
+ * @a rev_props contains its #SVN_PROP_REVISION_AUTHOR and
+ * #SVN_PROP_REVISION_DATE, as far as they are available.  For lines that
+ * had not been changed within the requested revision range, @a revision
+ * will be #SVN_INVALID_REVNUM and @a rev_props will be @c NULL.
+ *
+ * @a baton is the user-provided receiver baton.  @a scratch_pool may be
+ * used for temporary allocations.
+ *
+ * @since New in 1.15.
+ */
+typedef svn_error_t *(*svn_ra_blame_receiver_t)(void *baton,
+                                                apr_int64_t start_line,
+                                                svn_revnum_t revision,
+                                                apr_hash_t *rev_props,
+                                                apr_pool_t *scratch_pool);
+
+/**
+ * Let the server calculate the blame for the file @a path as seen in
+ * revision @a end, i.e. which revision between @a start and @a end last
+ * changed each of its lines, and report it to @a receiver with
+ * @a receiver_baton.  Interpret @a path relative to the URL in @a session.
+ *
+ * This transmits only the result instead of all the file revisions that
+ * svn_ra_get_file_revs2() would send.  Merged revisions are not taken into
+ * account and @a start must not be larger than @a end.
+ *
+ * @a diff_options is an optional array of <tt>const char *</tt> that the
+ * server will pass to svn_diff_file_options_parse() when comparing the
+ * file revisions.
+ *
+ * If the server doesn't support the 'blame' command, return
+ * #SVN_ERR_UNSUPPORTED_FEATURE in preference to any other error that
+ * might otherwise be returned.
+ *
+ * Use @a scratch_pool for temporary memory allocation.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_ra_get_blame(svn_ra_session_t *session,
+                 const char *path,
+                 svn_revnum_t start,
+                 svn_revnum_t end,
+                 const apr_array_header_t *diff_options,
+                 svn_ra_blame_receiver_t receiver,
+                 void *receiver_baton,
+                 apr_pool_t *scratch_pool);
+
 /**
  * Similar to svn_ra_get_file_revs2(), but with @a include_merged_revisions
  * set to FALSE.
@@ -2186,6 +2242,91 @@ svn_ra_fetch_file_contents(svn_ra_session_t *session,
                            svn_stream_t *stream,
                            apr_pool_t *scratch_pool);
 
+/**
+ * A file to fetch with svn_ra_fetch_files_contents().
+ *
+ * @since New in 1.15.
+ */
+typedef struct svn_ra_file_fetch_t
+{
+  /** The path of the file, relative to the URL of the session. */
+  const char *path;
+
+  /** The revision to fetch @a path in.  Must be a valid revision number. */
+  svn_revnum_t revision;
+
+  /** The stream to push the contents of the file to. */
+  svn_stream_t *stream;
+} svn_ra_file_fetch_t;
+
+/**
+ * Like svn_ra_fetch_file_contents(), but fetch several files at once.
+ * @a fetches is an array of <tt>const svn_ra_file_fetch_t *</tt>.
+ *
+ * RA layers that support it send all requests before waiting for the
+ * responses, which avoids a network round trip per file.  The streams are
+ * closed in the order of @a fetches.  All of them are closed before this
+ * function returns, even if it returns an error.
+ *
+ * Use @a scratch_pool for scratch allocations.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_ra_fetch_files_contents(svn_ra_session_t *session,
+                            const apr_array_header_t *fetches,
+                            apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_ra_stat(), but for all of the @a paths (an array of
+ * <tt>const char *</tt>, relative to the URL of @a session) at once.  Set
+ * @a *dirents to a hash mapping each of the @a paths that exist in
+ * @a revision to its <tt>svn_dirent_t *</tt>.  If @a revision is
+ * #SVN_INVALID_REVNUM, look all of them up in the same, youngest revision.
+ *
+ * RA layers that support it send all requests before waiting for the
+ * responses, which avoids a network round trip per path.
+ *
+ * Allocate @a *dirents in @a result_pool and use @a scratch_pool for
+ * temporary allocations.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_ra_stat_many(svn_ra_session_t *session,
+                 apr_hash_t **dirents,
+                 const apr_array_header_t *paths,
+                 svn_revnum_t revision,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_ra_get_dir2() without the directory properties, but for all of
+ * the directories @a paths (an array of <tt>const char *</tt>, relative to
+ * the URL of @a session) at once.  Set @a *dirents to a hash mapping each
+ * of the @a paths to a hash of its entries as svn_ra_get_dir2() would
+ * return them, with the fields selected by @a dirent_fields filled in.
+ * If @a revision is #SVN_INVALID_REVNUM, list all of them in the same,
+ * youngest revision.
+ *
+ * RA layers that support it fetch all directories in a single request,
+ * which avoids a network round trip per directory.  Older servers get
+ * asked for one directory after the other.
+ *
+ * Allocate @a *dirents in @a result_pool and use @a scratch_pool for
+ * temporary allocations.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_ra_get_dirs(svn_ra_session_t *session,
+                apr_hash_t **dirents,
+                const apr_array_header_t *paths,
+                svn_revnum_t revision,
+                apr_uint32_t dirent_fields,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool);
+
 /**
  * @defgroup Capabilities Dynamically query the server's capabilities.
  *
@@ -2288,6 +2429,14 @@ svn_ra_has_capability(svn_ra_session_t *session,
  */
 #define SVN_RA_CAPABILITY_LIST "list"
 
+/**
+ * The capability of a server to calculate the blame of a file itself,
+ * see svn_ra_get_blame().
+ *
+ * @since New in 1.15.
+ */
+#define SVN_RA_CAPABILITY_BLAME "blame"
+
 
 /*       *** PLEASE READ THIS IF YOU ADD A NEW CAPABILITY ***
  *
@@ -46,10 +46,18 @@ extern "C" {
 /** The well-known svn port number. */
 #define SVN_RA_SVN_PORT 3690
 
+/** The default port number for svn:// over TLS, i.e. svns:// URLs.
+ *
+ * @since New in 1.15.
+ */
+#define SVN_RA_SVN_TLS_PORT 3691
+
 /** Currently-defined capabilities. */
 #define SVN_RA_SVN_CAP_EDIT_PIPELINE "edit-pipeline"
 #define SVN_RA_SVN_CAP_SVNDIFF1 "svndiff1"
 #define SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED "accepts-svndiff2"
+/** @since New in 1.15. */
+#define SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED "accepts-svndiff3"
 #define SVN_RA_SVN_CAP_ABSENT_ENTRIES "absent-entries"
 /* maps to SVN_RA_CAPABILITY_COMMIT_REVPROPS: */
 #define SVN_RA_SVN_CAP_COMMIT_REVPROPS "commit-revprops"
@@ -71,6 +79,17 @@ extern "C" {
 #define SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE "file-revs-reverse"
 /* maps to SVN_RA_CAPABILITY_LIST */
 #define SVN_RA_SVN_CAP_LIST "list"
+/* maps to SVN_RA_CAPABILITY_BLAME */
+#define SVN_RA_SVN_CAP_BLAME "blame"
+/** Commands may be sent before the responses to the previous ones have
+ * been read.  @since New in 1.15. */
+#define SVN_RA_SVN_CAP_PIPELINING "pipelining"
+/** The server continues traces passed with the trace-context command.
+ * @since New in 1.15. */
+#define SVN_RA_SVN_CAP_TRACE_CONTEXT "trace-context"
+/** The server lists multiple directories with the get-dirs command.
+ * @since New in 1.15. */
+#define SVN_RA_SVN_CAP_GET_DIRS "get-dirs"
 
 
 /** ra_svn passes @c svn_dirent_t fields over the wire as a list of
@@ -680,10 +680,32 @@ svn_repos_fs_type(svn_repos_t *repos,
  * @a cancel_baton as usual to allow the user to preempt this potentially
  * lengthy operation.
  *
+ * Use up to @a jobs concurrent jobs where supported by the backend,
+ * see svn_fs_hotcopy4().
+ *
  * Use @a scratch_pool for temporary allocations.
  *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_repos_hotcopy4(const char *src_path,
+                   const char *dst_path,
+                   svn_boolean_t clean_logs,
+                   svn_boolean_t incremental,
+                   int jobs,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_repos_hotcopy4(), but with @a jobs set to 1.
+ *
  * @since New in 1.9.
+ * @deprecated Provided for backward compatibility with the 1.14 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_hotcopy3(const char *src_path,
                    const char *dst_path,
@@ -728,10 +750,28 @@ svn_repos_hotcopy(const char *src_path,
 
 /**
  * Possibly update the repository, @a repos, to use a more efficient
- * filesystem representation.  Use @a pool for allocations.
+ * filesystem representation.  Use up to @a jobs concurrent jobs where
+ * supported by the backend, see svn_fs_pack2().  Use @a pool for
+ * allocations.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_repos_fs_pack3(svn_repos_t *repos,
+                   int jobs,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool);
+
+/**
+ * Like svn_repos_fs_pack3(), but with @a jobs set to 1.
  *
  * @since New in 1.7.
+ * @deprecated Provided for backward compatibility with the 1.14 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_fs_pack2(svn_repos_t *repos,
                    svn_repos_notify_func_t notify_func,
@@ -2428,6 +2468,67 @@ svn_repos_get_file_revs2(svn_repos_t *repos,
                          void *handler_baton,
                          apr_pool_t *pool);
 
+/**
+ * Callback type to be used with svn_repos_blame().  It will be invoked
+ * once for every chunk of consecutive lines that have been last changed
+ * in the same revision, in the order of the lines in the file.
+ *
+ * The chunk starts at the zero-based line number @a start_line and
+ * extends up to the start of the next chunk or the end of the file.  The
+ * lines have last been changed in @a revision, for which @a rev_props
+ * contains the revision properties.  If the lines had not been changed
+ * within the revision range requested, @a revision will be
+ * #SVN_INVALID_REVNUM and @a rev_props will be @c NULL.
+ *
+ * @a baton is the user-provided receiver baton.  @a scratch_pool may be
+ * used for temporary allocations.
+ *
+ * @since New in 1.15.
+ */
+typedef svn_error_t *(*svn_repos_blame_receiver_t)(void *baton,
+                                                   apr_int64_t start_line,
+                                                   svn_revnum_t revision,
+                                                   apr_hash_t *rev_props,
+                                                   apr_pool_t *scratch_pool);
+
+/**
+ * Determine for each line of the file @a path in @a repos as seen in
+ * revision @a end, which revision between @a start and @a end last
+ * changed it, and report the result to @a receiver with @a receiver_baton.
+ *
+ * This performs the same calculation as svn_client_blame6() does on the
+ * client side, but the file contents stay in the repository.  Only the
+ * history of @a path is followed; merged revisions are not taken into
+ * account.  @a start must not be larger than @a end.
+ *
+ * @a diff_options is an optional array of <tt>const char *</tt> that will
+ * be passed to svn_diff_file_options_parse() to control how the
+ * subsequent file revisions get compared.
+ *
+ * If @a authz_read_func is not @c NULL, it will be used together with
+ * @a authz_read_baton as in svn_repos_get_file_revs2().
+ *
+ * Cancellation support is provided in the usual way through the optional
+ * @a cancel_func and @a cancel_baton.
+ *
+ * Use @a scratch_pool for temporary memory allocation.
+ *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_repos_blame(svn_repos_t *repos,
+                const char *path,
+                svn_revnum_t start,
+                svn_revnum_t end,
+                const apr_array_header_t *diff_options,
+                svn_repos_authz_func_t authz_read_func,
+                void *authz_read_baton,
+                svn_repos_blame_receiver_t receiver,
+                void *receiver_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool);
+
 /**
  * Similar to #svn_file_rev_handler_t, but without the @a
  * result_of_merge parameter.
@@ -3138,10 +3239,10 @@ enum svn_repos_load_uuid
   svn_repos_load_uuid_force
 };
 
-/** Callback type for use with svn_repos_verify_fs3().  @a revision
+/** Callback type for use with svn_repos_verify_fs4().  @a revision
  * and @a verify_err are the details of a single verification failure
- * that occurred during the svn_repos_verify_fs3() call.  @a baton is
- * the same baton given to svn_repos_verify_fs3().  @a scratch_pool is
+ * that occurred during the svn_repos_verify_fs4() call.  @a baton is
+ * the same baton given to svn_repos_verify_fs4().  @a scratch_pool is
  * provided for the convenience of the implementor, who should not
  * expect it to live longer than a single callback call.
  *
@@ -3151,7 +3252,7 @@ enum svn_repos_load_uuid
  * should also call svn_error_dup() for @a verify_err.  Implementors of this
  * callback are forbidden to call svn_error_clear() for @a verify_err.
  *
- * @see svn_repos_verify_fs3
+ * @see svn_repos_verify_fs4
  *
  * @since New in 1.9.
  */
@@ -3220,6 +3321,13 @@ typedef svn_error_t *(*svn_repos_verify_callback_t)(void *baton,
  *            called has reached its end and is about to return?
  *        ### Not sent, currently, if a FS structure error is found.
  *
+ * Verify up to @a jobs revisions concurrently, each one using its own
+ * filesystem instance.  Values less than 2 select the single-threaded
+ * mode, which is also used if APR does not support threads.  Notifications
+ * and calls to @a verify_callback will always happen in the calling thread
+ * and in revision order, regardless of @a jobs.  Parallel execution requires
+ * the FS caches to be thread-safe, see #svn_cache_config_t.
+ *
  * If @a cancel_func is not @c NULL, call it periodically with @a
  * cancel_baton as argument to see if the caller wishes to cancel the
  * verification.
@@ -3228,8 +3336,30 @@ typedef svn_error_t *(*svn_repos_verify_callback_t)(void *baton,
  *
  * @see svn_repos_verify_callback_t
  *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_repos_verify_fs4(svn_repos_t *repos,
+                     svn_revnum_t start_rev,
+                     svn_revnum_t end_rev,
+                     svn_boolean_t check_normalization,
+                     svn_boolean_t metadata_only,
+                     int jobs,
+                     svn_repos_notify_func_t notify_func,
+                     void *notify_baton,
+                     svn_repos_verify_callback_t verify_callback,
+                     void *verify_baton,
+                     svn_cancel_func_t cancel,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_repos_verify_fs4(), but with @a jobs set to 1.
+ *
  * @since New in 1.9.
+ * @deprecated Provided for backward compatibility with the 1.14 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_verify_fs3(svn_repos_t *repos,
                      svn_revnum_t start_rev,
@@ -3287,7 +3417,7 @@ svn_repos_verify_fs(svn_repos_t *repos,
  * Dump the contents of the filesystem within already-open @a repos into
  * writable @a dumpstream.  If @a dumpstream is
  * @c NULL, this is effectively a primitive verify.  It is not complete,
- * however; see instead svn_repos_verify_fs3().
+ * however; see instead svn_repos_verify_fs4().
  *
  * Begin at revision @a start_rev, and dump every revision up through
  * @a end_rev.  If @a start_rev is #SVN_INVALID_REVNUM, start at revision
@@ -3338,14 +3468,49 @@ svn_repos_verify_fs(svn_repos_t *repos,
  * If @a filter_func is not @c NULL, it is called for each node being
  * dumped, allowing the caller to exclude it from dump.
  *
+ * Prepare up to @a jobs revisions concurrently, each one using its own
+ * filesystem instance, and buffer them until all previous revisions have
+ * been written.  Values less than 2 select the single-threaded mode, which
+ * is also used if APR does not support threads.  The dump @a stream,
+ * notifications and checks for cancellation will always happen in the
+ * calling thread and in revision order, regardless of @a jobs.  However,
+ * @a filter_func may be called from several threads at once.  Parallel
+ * execution requires the FS caches to be thread-safe, see
+ * #svn_cache_config_t.
+ *
  * If @a cancel_func is not @c NULL, it is called periodically with
  * @a cancel_baton as argument to see if the client wishes to cancel
  * the dump.
  *
  * Use @a scratch_pool for temporary allocation.
  *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_repos_dump_fs5(svn_repos_t *repos,
+                   svn_stream_t *stream,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   svn_boolean_t incremental,
+                   svn_boolean_t use_deltas,
+                   svn_boolean_t include_revprops,
+                   svn_boolean_t include_changes,
+                   int jobs,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_repos_dump_filter_func_t filter_func,
+                   void *filter_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *scratch_pool);
+
+/**
+ * Like svn_repos_dump_fs5(), but with @a jobs set to 1.
+ *
  * @since New in 1.10.
+ * @deprecated Provided for backward compatibility with the 1.14 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_dump_fs4(svn_repos_t *repos,
                    svn_stream_t *stream,
@@ -3479,12 +3644,43 @@ svn_repos_dump_fs(svn_repos_t *repos,
  * If non-NULL, use @a notify_func and @a notify_baton to send notification
  * of events to the caller.
  *
+ * If @a jobs is larger than 1, read and parse @a dumpstream - including
+ * the decoding of any deltas - in a separate thread, concurrently with
+ * committing the loaded revisions.  The result will be the same as for
+ * single-threaded loading.
+ *
  * If @a cancel_func is not @c NULL, it is called periodically with
  * @a cancel_baton as argument to see if the client wishes to cancel
  * the load.
  *
+ * @since New in 1.15.
+ */
+svn_error_t *
+svn_repos_load_fs7(svn_repos_t *repos,
+                   svn_stream_t *dumpstream,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   enum svn_repos_load_uuid uuid_action,
+                   const char *parent_dir,
+                   svn_boolean_t use_pre_commit_hook,
+                   svn_boolean_t use_post_commit_hook,
+                   svn_boolean_t validate_props,
+                   svn_boolean_t ignore_dates,
+                   svn_boolean_t normalize_props,
+                   int jobs,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool);
+
+/**
+ * Similar to svn_repos_load_fs7(), but with @a jobs always set to 1.
+ *
  * @since New in 1.10.
+ * @deprecated Provided for backward compatibility with the 1.14 API.
  */
+SVN_DEPRECATED
 svn_error_t *
 svn_repos_load_fs6(svn_repos_t *repos,
                    svn_stream_t *dumpstream,
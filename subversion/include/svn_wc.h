@@ -8218,7 +8218,8 @@ svn_wc_translated_stream(svn_stream_t **stream,
  *
  * If @a fulltext, send the untranslated copy of @a local_abspath through
  * @a editor as full-text; else send it as svndiff against the current text
- * base.
+ * base.  If @a track_source is set, the svndiff will be created with source
+ * tracking as described for svn_txdelta3().
  *
  * If sending a diff, and the recorded checksum for @a local_abspath's
  * text-base does not match the current actual checksum, then remove the tmp
@@ -8245,12 +8246,14 @@ svn_wc_transmit_text_deltas4(const svn_checksum_t **new_text_base_md5_checksum,
                              svn_wc_context_t *wc_ctx,
                              const char *local_abspath,
                              svn_boolean_t fulltext,
+                             svn_boolean_t track_source,
                              const svn_delta_editor_t *editor,
                              void *file_baton,
                              apr_pool_t *result_pool,
                              apr_pool_t *scratch_pool);
 
-/** Similar to svn_wc_transmit_text_deltas4(), but this function can only be
+/** Similar to svn_wc_transmit_text_deltas4(), but with @a track_source
+ * always set to @c FALSE.  Also, this function can only be
  * used for working copies that store local copies of all pristine contents.
  * Otherwise, an #SVN_ERR_WC_DEPRECATED_API_STORE_PRISTINE error will be
  * returned.
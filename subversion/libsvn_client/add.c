@@ -49,6 +49,7 @@
 #include "private/svn_wc_private.h"
 #include "private/svn_ra_private.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_string_private.h"
 #include "private/svn_magic.h"
 
 #include "svn_private_config.h"
@@ -324,12 +325,67 @@ add_file(const char *local_abspath,
   return SVN_NO_ERROR;
 }
 
+/* Baton for add_files(). */
+typedef struct add_files_baton_t
+{
+  /* The directory containing the files and the const char * names of
+     the files to add. */
+  const char *dir_abspath;
+  const apr_array_header_t *names;
+
+  svn_boolean_t force;
+  svn_boolean_t no_autoprops;
+  svn_magic__cookie_t *magic_cookie;
+  apr_hash_t *config_autoprops;
+  svn_client_ctx_t *ctx;
+} add_files_baton_t;
+
+/* Implements svn_wc__with_write_lock_func_t.  Schedule the files described
+ * by BATON, an add_files_baton_t, for addition as with add_file().
+ */
+static svn_error_t *
+add_files(void *baton,
+          apr_pool_t *result_pool,
+          apr_pool_t *scratch_pool)
+{
+  add_files_baton_t *b = baton;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < b->names->nelts; i++)
+    {
+      const char *name = APR_ARRAY_IDX(b->names, i, const char *);
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      /* Check cancellation so you can cancel during an
+       * add of a directory with lots of files. */
+      if (b->ctx->cancel_func)
+        SVN_ERR(b->ctx->cancel_func(b->ctx->cancel_baton));
+
+      err = add_file(svn_dirent_join(b->dir_abspath, name, iterpool),
+                     b->magic_cookie, b->config_autoprops, b->no_autoprops,
+                     b->ctx, iterpool);
+      if (err && err->apr_err == SVN_ERR_ENTRY_EXISTS && b->force)
+        svn_error_clear(err);
+      else
+        SVN_ERR(err);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Schedule directory DIR_ABSPATH, and some of the tree under it, for
  * addition.  DEPTH is the depth at this point in the descent (it may
  * be changed for recursive calls).
  *
  * If DIR_ABSPATH (or any item below DIR_ABSPATH) is already scheduled for
  * addition, add will fail and return an error unless FORCE is TRUE.
+ * If VERSIONED is TRUE, the caller already knows that DIR_ABSPATH is
+ * versioned, which is only allowed with FORCE.
  *
  * Use MAGIC_COOKIE (which may be NULL) to detect the mime-type of files
  * if necessary.
@@ -341,13 +397,17 @@ add_file(const char *local_abspath,
  * NULL and the config file and svn:auto-props autoprops are required by this
  * function, then such will be obtained.
  *
- * If IGNORES is not NULL, then it is an array of const char * ignore patterns
+ * If IGNORES is not NULL, then it is a compiled list of the ignore patterns
  * that apply to any children of DIR_ABSPATH.  If REFRESH_IGNORES is TRUE, then
  * the passed in value of IGNORES (if any) is itself ignored and this function
- * will gather all ignore patterns applicable to DIR_ABSPATH itself (allocated in
- * RESULT_POOL).  Any recursive calls to this function get the refreshed ignore
- * patterns.  If IGNORES is NULL and REFRESH_IGNORES is FALSE, then all children of DIR_ABSPATH
- * are unconditionally added.
+ * will gather all ignore patterns applicable to DIR_ABSPATH itself.  Any
+ * recursive calls to this function get the refreshed ignore patterns.  If
+ * IGNORES is NULL and REFRESH_IGNORES is FALSE, then all children of
+ * DIR_ABSPATH are unconditionally added.
+ *
+ * The files of each directory get added in a single working copy
+ * transaction.  Memory use is bounded by the depth of the tree and the
+ * size of its directories, not by the size of the tree.
  *
  * If CTX->CANCEL_FUNC is non-null, call it with CTX->CANCEL_BATON to allow
  * the user to cancel the operation.
@@ -358,20 +418,23 @@ static svn_error_t *
 add_dir_recursive(const char *dir_abspath,
                   svn_depth_t depth,
                   svn_boolean_t force,
+                  svn_boolean_t versioned,
                   svn_boolean_t no_autoprops,
                   svn_magic__cookie_t *magic_cookie,
                   apr_hash_t *config_autoprops,
                   svn_boolean_t refresh_ignores,
-                  apr_array_header_t *ignores,
+                  const svn_cstring__glob_list_t *ignores,
                   svn_client_ctx_t *ctx,
-                  apr_pool_t *result_pool,
                   apr_pool_t *scratch_pool)
 {
-  svn_error_t *err;
   apr_pool_t *iterpool;
   apr_hash_t *dirents;
+  apr_hash_t *existing = NULL;
   apr_hash_index_t *hi;
-  svn_boolean_t entry_exists = FALSE;
+  apr_array_header_t *subdirs;
+  add_files_baton_t files_baton;
+  svn_boolean_t entry_exists = versioned;
+  int i;
 
   /* Check cancellation; note that this catches recursive calls too. */
   if (ctx->cancel_func)
@@ -380,28 +443,33 @@ add_dir_recursive(const char *dir_abspath,
   iterpool = svn_pool_create(scratch_pool);
 
   /* Add this directory to revision control. */
-  err = svn_wc_add_from_disk3(ctx->wc_ctx, dir_abspath, NULL /*props*/,
-                              FALSE /* skip checks */,
-                              ctx->notify_func2, ctx->notify_baton2,
-                              iterpool);
-  if (err)
+  if (!entry_exists)
     {
-      if (err->apr_err == SVN_ERR_ENTRY_EXISTS && force)
+      svn_error_t *err;
+
+      err = svn_wc_add_from_disk3(ctx->wc_ctx, dir_abspath, NULL /*props*/,
+                                  FALSE /* skip checks */,
+                                  ctx->notify_func2, ctx->notify_baton2,
+                                  iterpool);
+      if (err && err->apr_err == SVN_ERR_ENTRY_EXISTS && force)
         {
           svn_error_clear(err);
           entry_exists = TRUE;
         }
-      else if (err)
-        {
-          return svn_error_trace(err);
-        }
+      else
+        SVN_ERR(err);
     }
 
   /* Fetch ignores after adding to handle ignores on the directory itself
      and ancestors via the single db optimization in libsvn_wc */
   if (refresh_ignores)
-    SVN_ERR(svn_wc_get_ignores2(&ignores, ctx->wc_ctx, dir_abspath,
-                                ctx->config, result_pool, iterpool));
+    {
+      apr_array_header_t *patterns;
+
+      SVN_ERR(svn_wc_get_ignores2(&patterns, ctx->wc_ctx, dir_abspath,
+                                  ctx->config, iterpool, iterpool));
+      ignores = svn_cstring__glob_list_create(patterns, scratch_pool);
+    }
 
   /* If DIR_ABSPATH is the root of an unversioned subtree then get the
      following "autoprops":
@@ -420,65 +488,76 @@ add_dir_recursive(const char *dir_abspath,
                                              ctx, scratch_pool, iterpool));
     }
 
+  /* When DIR_ABSPATH is the root of an unversioned subtree then
+     it and all of its children have the same set of ignores.  So
+     save any recursive calls the extra work of finding the same
+     set of ignores. */
+  if (refresh_ignores && !entry_exists)
+    refresh_ignores = FALSE;
+
   SVN_ERR(svn_io_get_dirents3(&dirents, dir_abspath, TRUE, scratch_pool,
                               iterpool));
 
-  /* Read the directory entries one by one and add those things to
-     version control. */
+  /* Within a versioned directory, read what is versioned at once rather
+     than letting every child fail to be added on its own. */
+  if (entry_exists)
+    SVN_ERR(svn_wc__get_existing_children(&existing, ctx->wc_ctx, dir_abspath,
+                                          scratch_pool, iterpool));
+
+  files_baton.dir_abspath = dir_abspath;
+  files_baton.names = apr_array_make(scratch_pool, apr_hash_count(dirents),
+                                     sizeof(const char *));
+  files_baton.force = force;
+  files_baton.no_autoprops = no_autoprops;
+  files_baton.magic_cookie = magic_cookie;
+  files_baton.config_autoprops = config_autoprops;
+  files_baton.ctx = ctx;
+  subdirs = apr_array_make(scratch_pool, 0, sizeof(const char *));
+
+  /* Sort the directory entries into the files to add and the directories
+     to recurse into. */
   for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
     {
       const char *name = apr_hash_this_key(hi);
       svn_io_dirent2_t *dirent = apr_hash_this_val(hi);
-      const char *abspath;
 
       svn_pool_clear(iterpool);
 
-      /* Check cancellation so you can cancel during an
-       * add of a directory with lots of files. */
-      if (ctx->cancel_func)
-        SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
-
       /* Skip over SVN admin directories. */
       if (svn_wc_is_adm_dir(name, iterpool))
         continue;
 
-      if (ignores
-          && svn_wc_match_ignore_list(name, ignores, iterpool))
+      if (ignores && svn_cstring__glob_list_match(ignores, name))
         continue;
 
-      /* Construct the full path of the entry. */
-      abspath = svn_dirent_join(dir_abspath, name, iterpool);
-
       /* Recurse on directories; add files; ignore the rest. */
       if (dirent->kind == svn_node_dir && depth >= svn_depth_immediates)
-        {
-          svn_depth_t depth_below_here = depth;
-          if (depth == svn_depth_immediates)
-            depth_below_here = svn_depth_empty;
-
-          /* When DIR_ABSPATH is the root of an unversioned subtree then
-             it and all of its children have the same set of ignores.  So
-             save any recursive calls the extra work of finding the same
-             set of ignores. */
-          if (refresh_ignores && !entry_exists)
-            refresh_ignores = FALSE;
-
-          SVN_ERR(add_dir_recursive(abspath, depth_below_here,
-                                    force, no_autoprops,
-                                    magic_cookie, config_autoprops,
-                                    refresh_ignores, ignores, ctx,
-                                    result_pool, iterpool));
-        }
+        APR_ARRAY_PUSH(subdirs, const char *) = name;
       else if ((dirent->kind == svn_node_file || dirent->special)
-               && depth >= svn_depth_files)
-        {
-          err = add_file(abspath, magic_cookie, config_autoprops,
-                         no_autoprops, ctx, iterpool);
-          if (err && err->apr_err == SVN_ERR_ENTRY_EXISTS && force)
-            svn_error_clear(err);
-          else
-            SVN_ERR(err);
-        }
+               && depth >= svn_depth_files
+               && !(existing && svn_hash_gets(existing, name)))
+        APR_ARRAY_PUSH(files_baton.names, const char *) = name;
+    }
+
+  if (files_baton.names->nelts)
+    SVN_ERR(svn_wc__call_in_txn(add_files, &files_baton, ctx->wc_ctx,
+                                dir_abspath, scratch_pool, iterpool));
+
+  for (i = 0; i < subdirs->nelts; i++)
+    {
+      const char *name = APR_ARRAY_IDX(subdirs, i, const char *);
+      svn_depth_t depth_below_here = depth;
+
+      svn_pool_clear(iterpool);
+
+      if (depth == svn_depth_immediates)
+        depth_below_here = svn_depth_empty;
+
+      SVN_ERR(add_dir_recursive(svn_dirent_join(dir_abspath, name, iterpool),
+                                depth_below_here, force,
+                                existing && svn_hash_gets(existing, name),
+                                no_autoprops, magic_cookie, config_autoprops,
+                                refresh_ignores, ignores, ctx, iterpool));
     }
 
   /* Destroy the per-iteration pool. */
@@ -786,7 +865,7 @@ add(const char *local_abspath,
   svn_node_kind_t kind;
   svn_error_t *err;
   svn_magic__cookie_t *magic_cookie;
-  apr_array_header_t *ignores = NULL;
+  const svn_cstring__glob_list_t *ignores = NULL;
 
   SVN_ERR(svn_magic__init(&magic_cookie, ctx->config, scratch_pool));
 
@@ -838,10 +917,9 @@ add(const char *local_abspath,
       /* We use add_dir_recursive for all directory targets
          and pass depth along no matter what it is, so that the
          target's depth will be set correctly. */
-      err = add_dir_recursive(local_abspath, depth, force,
+      err = add_dir_recursive(local_abspath, depth, force, FALSE,
                               no_autoprops, magic_cookie, NULL,
-                              !no_ignore, ignores, ctx,
-                              scratch_pool, scratch_pool);
+                              !no_ignore, ignores, ctx, scratch_pool);
     }
   else if (kind == svn_node_file)
     err = add_file(local_abspath, magic_cookie, NULL,
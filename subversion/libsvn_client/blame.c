@@ -38,6 +38,7 @@
 #include "svn_sorts.h"
 
 #include "private/svn_wc_private.h"
+#include "private/svn_skel.h"
 
 #include "svn_private_config.h"
 
@@ -106,6 +107,16 @@ struct file_rev_baton {
      happens when we move to the previous revision */
   svn_revnum_t last_revnum;
   apr_hash_t *last_props;
+
+  /* The repository path of the file in the last revision received. */
+  const char *last_path;
+
+  /* Set while CHAIN holds the blame of a previous run that ended at
+     BASE_REV with the file at BASE_PATH.  The first revision received is
+     the one that blame is based on and must not be processed again. */
+  svn_boolean_t reuse_base;
+  svn_revnum_t base_rev;
+  const char *base_path;
 };
 
 /* The baton used by the txdelta window handler. Allocated per revision */
@@ -341,12 +352,15 @@ update_blame(void *baton)
   else
     chain = frb->chain;
 
-  /* Process this file. */
-  SVN_ERR(add_file_blame(frb->last_filename,
-                         dbaton->filename, chain, dbaton->rev,
-                         frb->diff_options,
-                         frb->ctx->cancel_func, frb->ctx->cancel_baton,
-                         frb->currpool));
+  /* Process this file, unless CHAIN already covers it. */
+  if (frb->reuse_base)
+    frb->reuse_base = FALSE;
+  else
+    SVN_ERR(add_file_blame(frb->last_filename,
+                           dbaton->filename, chain, dbaton->rev,
+                           frb->diff_options,
+                           frb->ctx->cancel_func, frb->ctx->cancel_baton,
+                           frb->currpool));
 
   /* If we are including merged revisions, and the current revision is not a
      merged one, we need to add its blame info to the chain for the original
@@ -481,6 +495,19 @@ file_rev_handler(void *baton, const char *path, svn_revnum_t revnum,
   if (frb->ctx->cancel_func)
     SVN_ERR(frb->ctx->cancel_func(frb->ctx->cancel_baton));
 
+  /* The blame we continue must have been made for this very file. */
+  if (frb->reuse_base
+      && (revnum > frb->base_rev || strcmp(path, frb->base_path) != 0))
+    return svn_error_createf(
+              SVN_ERR_CLIENT_UNRELATED_RESOURCES, NULL,
+              _("The blame state does not match the history of '%s'"),
+              (svn_path_is_url(frb->target)
+                     ? frb->target
+                     : svn_dirent_local_style(frb->target, pool)));
+
+  if (!frb->last_path || strcmp(frb->last_path, path) != 0)
+    frb->last_path = apr_pstrdup(frb->mainpool, path);
+
   /* If there were no content changes and no (potential) merges, we couldn't
      care less about this revision now.  Note that we checked the mime type
      above, so things work if the user just changes the mime type in a commit.
@@ -593,6 +620,114 @@ file_rev_handler(void *baton, const char *path, svn_revnum_t revnum,
   return SVN_NO_ERROR;
 }
 
+/* The baton used by server_blame_receiver(). */
+struct server_blame_baton {
+  struct blame_chain *chain;
+  struct blame *last;     /* the last chunk appended to CHAIN */
+  apr_hash_t *revs;       /* svn_revnum_t -> struct rev */
+};
+
+/* Append the blame chunk received from the server to BATON->chain.
+ *
+ * Implements svn_ra_blame_receiver_t.
+ */
+static svn_error_t *
+server_blame_receiver(void *baton,
+                      apr_int64_t start_line,
+                      svn_revnum_t revision,
+                      apr_hash_t *rev_props,
+                      apr_pool_t *scratch_pool)
+{
+  struct server_blame_baton *sbb = baton;
+  apr_pool_t *pool = sbb->chain->pool;
+  struct rev *rev = apr_hash_get(sbb->revs, &revision, sizeof(revision));
+  struct blame *blame;
+
+  /* All chunks of the same revision share the same rev struct. */
+  if (!rev)
+    {
+      rev = apr_pcalloc(pool, sizeof(*rev));
+      rev->revision = revision;
+      rev->rev_props = rev_props ? svn_prop_hash_dup(rev_props, pool) : NULL;
+      apr_hash_set(sbb->revs, &rev->revision, sizeof(rev->revision), rev);
+    }
+
+  /* The chunks must cover the file in line order, starting at line 0. */
+  if (sbb->last ? start_line <= sbb->last->start : start_line != 0)
+    return svn_error_create(SVN_ERR_STREAM_MALFORMED_DATA, NULL,
+                            _("Malformed blame data from the server"));
+
+  blame = blame_create(sbb->chain, rev, (apr_off_t)start_line);
+  if (sbb->last)
+    sbb->last->next = blame;
+  else
+    sbb->chain->blame = blame;
+  sbb->last = blame;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return DIFF_OPTIONS as the arguments that svn_diff_file_options_parse()
+   understands, allocated in RESULT_POOL. */
+static apr_array_header_t *
+diff_options_to_args(const svn_diff_file_options_t *diff_options,
+                     apr_pool_t *result_pool)
+{
+  apr_array_header_t *args = apr_array_make(result_pool, 3,
+                                            sizeof(const char *));
+
+  if (diff_options->ignore_space == svn_diff_file_ignore_space_change)
+    APR_ARRAY_PUSH(args, const char *) = "-b";
+  else if (diff_options->ignore_space == svn_diff_file_ignore_space_all)
+    APR_ARRAY_PUSH(args, const char *) = "-w";
+
+  if (diff_options->ignore_eol_style)
+    APR_ARRAY_PUSH(args, const char *) = "--ignore-eol-style";
+
+  if (diff_options->histogram)
+    APR_ARRAY_PUSH(args, const char *) = "--histogram";
+
+  return args;
+}
+
+/* Let the server calculate the blame of the file at RA_SESSION's URL from
+   FRB->start_rev to FRB->end_rev and store the result in FRB->chain.  Fetch
+   the file contents of FRB->end_rev into FRB->last_filename, just like the
+   last call of file_rev_handler() would do.
+
+   Return SVN_ERR_UNSUPPORTED_FEATURE if the server can't do that.
+   Use POOL for temporary allocations. */
+static svn_error_t *
+server_blame(struct file_rev_baton *frb,
+             svn_ra_session_t *ra_session,
+             apr_pool_t *pool)
+{
+  struct server_blame_baton sbb;
+  svn_stream_t *stream;
+
+  sbb.chain = frb->chain;
+  sbb.last = NULL;
+  sbb.revs = apr_hash_make(pool);
+
+  SVN_ERR(svn_ra_get_blame(ra_session, "", frb->start_rev, frb->end_rev,
+                           diff_options_to_args(frb->diff_options, pool),
+                           server_blame_receiver, &sbb, pool));
+
+  SVN_ERR(svn_stream_open_unique(&stream, &frb->last_filename, NULL,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 frb->mainpool, pool));
+  SVN_ERR(svn_ra_get_file(ra_session, "", frb->end_rev, stream, NULL, NULL,
+                          pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  /* The server always reports at least one chunk, even for empty files. */
+  if (!frb->chain->blame)
+    return svn_error_create(SVN_ERR_STREAM_MALFORMED_DATA, NULL,
+                            _("Malformed blame data from the server"));
+
+  return SVN_NO_ERROR;
+}
+
 /* Ensure that CHAIN_ORIG and CHAIN_MERGED have the same number of chunks,
    and that for every chunk C, CHAIN_ORIG[C] and CHAIN_MERGED[C] have the
    same starting value.  Both CHAIN_ORIG and CHAIN_MERGED should not be
@@ -657,20 +792,247 @@ normalize_blames(struct blame_chain *chain,
     }
 }
 
-svn_error_t *
-svn_client_blame6(svn_revnum_t *start_revnum_p,
-                  svn_revnum_t *end_revnum_p,
-                  const char *target,
-                  const svn_opt_revision_t *peg_revision,
-                  const svn_opt_revision_t *start,
-                  const svn_opt_revision_t *end,
-                  const svn_diff_file_options_t *diff_options,
-                  svn_boolean_t ignore_mime_type,
-                  svn_boolean_t include_merged_revisions,
-                  svn_client_blame_receiver4_t receiver,
-                  void *receiver_baton,
-                  svn_client_ctx_t *ctx,
-                  apr_pool_t *pool)
+/* Version of the blame state format written by write_blame_state(). */
+#define BLAME_STATE_FORMAT 1
+
+/* Return the subset of REV_PROPS that gets stored in a blame state,
+   allocated in POOL.  REV_PROPS may be NULL. */
+static apr_hash_t *
+blame_state_rev_props(apr_hash_t *rev_props,
+                      apr_pool_t *pool)
+{
+  apr_hash_t *props = apr_hash_make(pool);
+  const svn_string_t *value;
+
+  if (rev_props == NULL)
+    return props;
+
+  value = svn_hash_gets(rev_props, SVN_PROP_REVISION_AUTHOR);
+  if (value)
+    svn_hash_sets(props, SVN_PROP_REVISION_AUTHOR, value);
+
+  value = svn_hash_gets(rev_props, SVN_PROP_REVISION_DATE);
+  if (value)
+    svn_hash_sets(props, SVN_PROP_REVISION_DATE, value);
+
+  return props;
+}
+
+/* Set *STATE_P to the serialized blame in CHAIN of the file at repository
+   path PATH in the repository with UUID, covering the revisions START_REV
+   to END_REV.  Allocate *STATE_P in RESULT_POOL.
+
+   The state is a skel of the form
+
+     (blame FORMAT UUID PATH START_REV END_REV
+            ((REV PROPLIST) ...) (LINE REV LINE REV ...))
+
+   where the second list holds the blame chunks in line order and REV is
+   -1 for lines older than START_REV. */
+static svn_error_t *
+write_blame_state(svn_stringbuf_t **state_p,
+                  const char *uuid,
+                  const char *path,
+                  svn_revnum_t start_rev,
+                  svn_revnum_t end_rev,
+                  const struct blame_chain *chain,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  svn_skel_t *skel = svn_skel__make_empty_list(scratch_pool);
+  svn_skel_t *revs = svn_skel__make_empty_list(scratch_pool);
+  svn_skel_t *chunks = svn_skel__make_empty_list(scratch_pool);
+  apr_array_header_t *blames = apr_array_make(scratch_pool, 16,
+                                              sizeof(struct blame *));
+  apr_hash_t *seen = apr_hash_make(scratch_pool);
+  struct blame *walk;
+  int i;
+
+  for (walk = chain->blame; walk; walk = walk->next)
+    APR_ARRAY_PUSH(blames, struct blame *) = walk;
+
+  /* Prepend in reverse, so the lists come out in line order. */
+  for (i = blames->nelts - 1; i >= 0; --i)
+    {
+      const struct rev *rev = APR_ARRAY_IDX(blames, i, struct blame *)->rev;
+      svn_revnum_t revnum = rev ? rev->revision : SVN_INVALID_REVNUM;
+
+      svn_skel__prepend_int(revnum, chunks, scratch_pool);
+      svn_skel__prepend_int(APR_ARRAY_IDX(blames, i, struct blame *)->start,
+                            chunks, scratch_pool);
+
+      if (SVN_IS_VALID_REVNUM(revnum)
+          && !apr_hash_get(seen, &rev->revision, sizeof(rev->revision)))
+        {
+          svn_skel_t *entry = svn_skel__make_empty_list(scratch_pool);
+          svn_skel_t *props;
+
+          SVN_ERR(svn_skel__unparse_proplist(&props,
+                                             blame_state_rev_props(
+                                               rev->rev_props, scratch_pool),
+                                             scratch_pool));
+          svn_skel__prepend(props, entry);
+          svn_skel__prepend_int(revnum, entry, scratch_pool);
+          svn_skel__prepend(entry, revs);
+
+          apr_hash_set(seen, &rev->revision, sizeof(rev->revision), rev);
+        }
+    }
+
+  svn_skel__prepend(chunks, skel);
+  svn_skel__prepend(revs, skel);
+  svn_skel__prepend_int(end_rev, skel, scratch_pool);
+  svn_skel__prepend_int(start_rev, skel, scratch_pool);
+  svn_skel__prepend_str(path, skel, scratch_pool);
+  svn_skel__prepend_str(uuid, skel, scratch_pool);
+  svn_skel__prepend_int(BLAME_STATE_FORMAT, skel, scratch_pool);
+  svn_skel__prepend_str("blame", skel, scratch_pool);
+
+  *state_p = svn_skel__unparse(skel, result_pool);
+  return SVN_NO_ERROR;
+}
+
+/* Return the error for a blame state that can't be parsed. */
+static svn_error_t *
+malformed_blame_state(void)
+{
+  return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                          _("Malformed blame state"));
+}
+
+/* Parse the blame state STATE written by write_blame_state() into *UUID,
+   *PATH, *START_REV and *END_REV and set CHAIN->blame to the blame chunks,
+   allocated in CHAIN->pool. */
+static svn_error_t *
+read_blame_state(const char **uuid,
+                 const char **path,
+                 svn_revnum_t *start_rev,
+                 svn_revnum_t *end_rev,
+                 struct blame_chain *chain,
+                 const svn_string_t *state,
+                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *pool = chain->pool;
+  svn_skel_t *skel = svn_skel__parse(state->data, state->len, scratch_pool);
+  svn_skel_t *elt;
+  apr_hash_t *revs = apr_hash_make(scratch_pool);
+  struct rev *no_rev;
+  struct blame *last = NULL;
+  apr_int64_t val;
+
+  if (skel == NULL
+      || svn_skel__list_length(skel) != 8
+      || !svn_skel__matches_atom(skel->children, "blame"))
+    return malformed_blame_state();
+
+  elt = skel->children->next;
+  SVN_ERR(svn_skel__parse_int(&val, elt, scratch_pool));
+  if (val != BLAME_STATE_FORMAT)
+    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                             _("Unsupported blame state format %d"),
+                             (int)val);
+
+  elt = elt->next;
+  if (!elt->is_atom || !elt->next->is_atom)
+    return malformed_blame_state();
+  *uuid = apr_pstrmemdup(pool, elt->data, elt->len);
+  elt = elt->next;
+  *path = apr_pstrmemdup(pool, elt->data, elt->len);
+
+  elt = elt->next;
+  SVN_ERR(svn_skel__parse_int(&val, elt, scratch_pool));
+  *start_rev = (svn_revnum_t)val;
+  elt = elt->next;
+  SVN_ERR(svn_skel__parse_int(&val, elt, scratch_pool));
+  *end_rev = (svn_revnum_t)val;
+  if (!SVN_IS_VALID_REVNUM(*start_rev) || *end_rev < *start_rev)
+    return malformed_blame_state();
+
+  /* Recreate the revisions referenced by the chunks. */
+  elt = elt->next;
+  if (elt->is_atom)
+    return malformed_blame_state();
+  for (skel = elt->children; skel; skel = skel->next)
+    {
+      struct rev *rev;
+
+      if (svn_skel__list_length(skel) != 2)
+        return malformed_blame_state();
+
+      rev = apr_pcalloc(pool, sizeof(*rev));
+      SVN_ERR(svn_skel__parse_int(&val, skel->children, scratch_pool));
+      rev->revision = (svn_revnum_t)val;
+      SVN_ERR(svn_skel__parse_proplist(&rev->rev_props,
+                                       skel->children->next, pool));
+
+      apr_hash_set(revs, &rev->revision, sizeof(rev->revision), rev);
+    }
+
+  /* Lines that predate START_REV. */
+  no_rev = apr_pcalloc(pool, sizeof(*no_rev));
+  no_rev->revision = SVN_INVALID_REVNUM;
+
+  elt = elt->next;
+  if (elt->is_atom || svn_skel__list_length(elt) % 2)
+    return malformed_blame_state();
+  for (skel = elt->children; skel; skel = skel->next->next)
+    {
+      apr_int64_t line;
+      const struct rev *rev = no_rev;
+      struct blame *blame;
+
+      SVN_ERR(svn_skel__parse_int(&line, skel, scratch_pool));
+      SVN_ERR(svn_skel__parse_int(&val, skel->next, scratch_pool));
+      if (SVN_IS_VALID_REVNUM((svn_revnum_t)val))
+        {
+          svn_revnum_t revnum = (svn_revnum_t)val;
+
+          rev = apr_hash_get(revs, &revnum, sizeof(revnum));
+          if (rev == NULL)
+            return malformed_blame_state();
+        }
+
+      /* Chunks must start at line 0 and be in ascending order. */
+      if (last ? line <= last->start : line != 0)
+        return malformed_blame_state();
+
+      blame = blame_create(chain, rev, (apr_off_t)line);
+      if (last)
+        last->next = blame;
+      else
+        chain->blame = blame;
+      last = blame;
+    }
+
+  if (chain->blame == NULL)
+    return malformed_blame_state();
+
+  return SVN_NO_ERROR;
+}
+
+/* The implementation of svn_client_blame6() and
+   svn_client_blame_incremental().
+
+   If STATE is not NULL, continue the blame recorded in it and ignore
+   START.  If STATE_P is not NULL, return the blame state in *STATE_P,
+   allocated in RESULT_POOL.  Use POOL for everything else. */
+static svn_error_t *
+blame_file(svn_stringbuf_t **state_p,
+           svn_revnum_t *start_revnum_p,
+           svn_revnum_t *end_revnum_p,
+           const char *target,
+           const svn_opt_revision_t *peg_revision,
+           const svn_opt_revision_t *start,
+           const svn_opt_revision_t *end,
+           const svn_string_t *state,
+           const svn_diff_file_options_t *diff_options,
+           svn_boolean_t ignore_mime_type,
+           svn_boolean_t include_merged_revisions,
+           svn_client_blame_receiver4_t receiver,
+           void *receiver_baton,
+           svn_client_ctx_t *ctx,
+           apr_pool_t *result_pool,
+           apr_pool_t *pool)
 {
   struct file_rev_baton frb;
   svn_ra_session_t *ra_session;
@@ -680,12 +1042,27 @@ svn_client_blame6(svn_revnum_t *start_revnum_p,
   svn_stream_t *last_stream;
   svn_stream_t *stream;
   const char *target_abspath_or_url;
+  const char *uuid = NULL;
+  const char *state_uuid = NULL;
+  const char *state_path = NULL;
+  svn_revnum_t state_end_rev = SVN_INVALID_REVNUM;
+  svn_boolean_t server_blamed = FALSE;
 
-  if (start->kind == svn_opt_revision_unspecified
+  if ((!state && start->kind == svn_opt_revision_unspecified)
       || end->kind == svn_opt_revision_unspecified)
     return svn_error_create
       (SVN_ERR_CLIENT_BAD_REVISION, NULL, NULL);
 
+  frb.chain = apr_palloc(pool, sizeof(*frb.chain));
+  frb.chain->blame = NULL;
+  frb.chain->avail = NULL;
+  frb.chain->pool = pool;
+
+  if (state)
+    SVN_ERR(read_blame_state(&state_uuid, &state_path,
+                             &start_revnum, &state_end_rev,
+                             frb.chain, state, pool));
+
   if (svn_path_is_url(target))
     target_abspath_or_url = target;
   else
@@ -697,9 +1074,10 @@ svn_client_blame6(svn_revnum_t *start_revnum_p,
                                             peg_revision,
                                             ctx, pool));
 
-  SVN_ERR(svn_client__get_revision_number(&start_revnum, NULL, ctx->wc_ctx,
-                                          target_abspath_or_url, ra_session,
-                                          start, pool));
+  if (!state)
+    SVN_ERR(svn_client__get_revision_number(&start_revnum, NULL, ctx->wc_ctx,
+                                            target_abspath_or_url, ra_session,
+                                            start, pool));
   if (start_revnum_p)
     *start_revnum_p = start_revnum;
   SVN_ERR(svn_client__get_revision_number(&end_revnum, NULL, ctx->wc_ctx,
@@ -708,6 +1086,30 @@ svn_client_blame6(svn_revnum_t *start_revnum_p,
   if (end_revnum_p)
     *end_revnum_p = end_revnum;
 
+  if (state || state_p)
+    {
+      SVN_ERR(svn_ra_get_uuid2(ra_session, &uuid, pool));
+
+      if (state && strcmp(uuid, state_uuid) != 0)
+        return svn_error_createf(
+                  SVN_ERR_CLIENT_UNRELATED_RESOURCES, NULL,
+                  _("The blame state does not belong to the repository "
+                    "of '%s'"),
+                  (svn_path_is_url(target)
+                   ? target : svn_dirent_local_style(target, pool)));
+
+      if (state && end_revnum < state_end_rev)
+        return svn_error_createf(
+                  SVN_ERR_CLIENT_BAD_REVISION, NULL,
+                  _("Can't continue a blame of r%ld back to r%ld"),
+                  state_end_rev, end_revnum);
+
+      if (start_revnum > end_revnum)
+        return svn_error_create(
+                  SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                  _("Can't record the state of a reverse blame"));
+    }
+
   {
     svn_client__pathrev_t *loc;
     svn_opt_revision_t younger_end;
@@ -774,7 +1176,8 @@ svn_client_blame6(svn_revnum_t *start_revnum_p,
         }
     }
 
-  frb.start_rev = start_revnum;
+  /* When continuing a blame, start right after the revisions it covers. */
+  frb.start_rev = state ? state_end_rev + 1 : start_revnum;
   frb.end_rev = end_revnum;
   frb.target = target;
   frb.ctx = ctx;
@@ -783,10 +1186,6 @@ svn_client_blame6(svn_revnum_t *start_revnum_p,
   frb.last_filename = NULL;
   frb.last_rev = NULL;
   frb.last_original_filename = NULL;
-  frb.chain = apr_palloc(pool, sizeof(*frb.chain));
-  frb.chain->blame = NULL;
-  frb.chain->avail = NULL;
-  frb.chain->pool = pool;
   if (include_merged_revisions)
     {
       frb.merged_chain = apr_palloc(pool, sizeof(*frb.merged_chain));
@@ -794,10 +1193,14 @@ svn_client_blame6(svn_revnum_t *start_revnum_p,
       frb.merged_chain->avail = NULL;
       frb.merged_chain->pool = pool;
     }
-  frb.backwards = (frb.start_rev > frb.end_rev);
+  frb.backwards = (start_revnum > end_revnum);
   frb.last_revnum = SVN_INVALID_REVNUM;
   frb.last_props = NULL;
   frb.check_mime_type = (frb.backwards && !ignore_mime_type);
+  frb.last_path = NULL;
+  frb.reuse_base = (state != NULL);
+  frb.base_rev = state_end_rev;
+  frb.base_path = state_path;
 
   SVN_ERR(svn_ra_get_repos_root2(ra_session, &frb.repos_root_url, pool));
 
@@ -813,16 +1216,46 @@ svn_client_blame6(svn_revnum_t *start_revnum_p,
       frb.prevfilepool = svn_pool_create(pool);
     }
 
+  /* Let the server do the work if it can, so that only the result and
+     a single file revision have to be transferred.  It can't continue
+     a blame state, though, and doesn't track merges. */
+  if (!state && !state_p && !include_merged_revisions && !frb.backwards)
+    {
+      svn_error_t *err = server_blame(&frb, ra_session, pool);
+
+      if (svn_error_find_cause(err, SVN_ERR_UNSUPPORTED_FEATURE))
+        {
+          svn_error_clear(err);
+          frb.chain->blame = NULL;
+          frb.last_filename = NULL;
+        }
+      else
+        {
+          SVN_ERR(err);
+          server_blamed = TRUE;
+        }
+    }
+
   /* Collect all blame information.
      We need to ensure that we get one revision before the start_rev,
      if available so that we can know what was actually changed in the start
      revision. */
-  SVN_ERR(svn_ra_get_file_revs2(ra_session, "",
-                                frb.backwards ? start_revnum
-                                              : MAX(0, start_revnum-1),
-                                end_revnum,
-                                include_merged_revisions,
-                                file_rev_handler, &frb, pool));
+  if (!server_blamed)
+    SVN_ERR(svn_ra_get_file_revs2(ra_session, "",
+                                  frb.backwards ? frb.start_rev
+                                                : MAX(0, frb.start_rev-1),
+                                  end_revnum,
+                                  include_merged_revisions,
+                                  file_rev_handler, &frb, pool));
+
+  /* Local modifications are not part of the state. */
+  if (state_p)
+    {
+      SVN_ERR_ASSERT(frb.last_path != NULL);
+      SVN_ERR(write_blame_state(state_p, uuid, frb.last_path,
+                                start_revnum, end_revnum, frb.chain,
+                                result_pool, pool));
+    }
 
   if (end->kind == svn_opt_revision_working)
     {
@@ -984,3 +1417,51 @@ svn_client_blame6(svn_revnum_t *start_revnum_p,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_client_blame6(svn_revnum_t *start_revnum_p,
+                  svn_revnum_t *end_revnum_p,
+                  const char *target,
+                  const svn_opt_revision_t *peg_revision,
+                  const svn_opt_revision_t *start,
+                  const svn_opt_revision_t *end,
+                  const svn_diff_file_options_t *diff_options,
+                  svn_boolean_t ignore_mime_type,
+                  svn_boolean_t include_merged_revisions,
+                  svn_client_blame_receiver4_t receiver,
+                  void *receiver_baton,
+                  svn_client_ctx_t *ctx,
+                  apr_pool_t *pool)
+{
+  return svn_error_trace(blame_file(NULL, start_revnum_p, end_revnum_p,
+                                    target, peg_revision, start, end, NULL,
+                                    diff_options, ignore_mime_type,
+                                    include_merged_revisions,
+                                    receiver, receiver_baton, ctx,
+                                    pool, pool));
+}
+
+svn_error_t *
+svn_client_blame_incremental(svn_stringbuf_t **state_p,
+                             svn_revnum_t *start_revnum_p,
+                             svn_revnum_t *end_revnum_p,
+                             const char *path_or_url,
+                             const svn_opt_revision_t *peg_revision,
+                             const svn_opt_revision_t *start,
+                             const svn_opt_revision_t *end,
+                             const svn_string_t *state,
+                             const svn_diff_file_options_t *diff_options,
+                             svn_boolean_t ignore_mime_type,
+                             svn_client_blame_receiver4_t receiver,
+                             void *receiver_baton,
+                             svn_client_ctx_t *ctx,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(blame_file(state_p, start_revnum_p, end_revnum_p,
+                                    path_or_url, peg_revision, start, end,
+                                    state, diff_options, ignore_mime_type,
+                                    FALSE /* include_merged_revisions */,
+                                    receiver, receiver_baton, ctx,
+                                    result_pool, scratch_pool));
+}
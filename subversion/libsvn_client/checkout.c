@@ -43,6 +43,7 @@
 
 #include "private/svn_subr_private.h"
 #include "private/svn_wc_private.h"
+#include "private/svn_trace.h"
 
 #include "svn_private_config.h"
 
@@ -299,9 +300,11 @@ svn_client_checkout4(svn_revnum_t *result_rev,
   const char *local_abspath;
   svn_error_t *err;
   svn_boolean_t sleep_here = FALSE;
+  svn_trace__span_t *span;
 
   SVN_ERR(svn_dirent_get_absolute(&local_abspath, path, pool));
 
+  span = svn_trace__begin("client", "checkout", pool);
   err = svn_client__checkout_internal(result_rev, &sleep_here,
                                       URL, local_abspath,
                                       peg_revision, revision, depth,
@@ -312,6 +315,7 @@ svn_client_checkout4(svn_revnum_t *result_rev,
                                       store_pristine,
                                       NULL /* ra_session */,
                                       ctx, pool);
+  svn_trace__end(span);
   if (sleep_here)
     svn_io_sleep_for_timestamps(local_abspath, pool);
 
@@ -63,6 +63,22 @@ typedef struct svn_client__private_ctx_t
   /* Total number of bytes transferred over network across all RA sessions. */
   apr_off_t total_progress;
 
+  /* Process externals one after another, even if the configuration
+     allows for more.  Set for the contexts of externals worker threads. */
+  svn_boolean_t serial_externals;
+
+  /* The pool the context was allocated in. */
+  apr_pool_t *pool;
+
+  /* RA sessions kept open for reuse by later operations, as
+     cached_ra_session_t * (see ra.c).  NULL until the first session
+     gets opened. */
+  apr_array_header_t *ra_sessions;
+
+  /* Repository history shared by the tree conflict detail searches of
+     this context, see conflicts.c.  NULL until first used. */
+  struct svn_client__conflict_history_t *conflict_history;
+
   /* The public context. */
   svn_client_ctx_t public_ctx;
 } svn_client__private_ctx_t;
@@ -46,6 +46,7 @@
 #include "private/svn_wc_private.h"
 #include "private/svn_ra_private.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_trace.h"
 
 #include "svn_private_config.h"
 
@@ -664,9 +665,13 @@ svn_client_commit6(const apr_array_header_t *targets,
   int depth_empty_after = -1;
   apr_hash_t *move_youngest = NULL;
   int i;
+  svn_trace__span_t *span;
 
   SVN_ERR_ASSERT(depth != svn_depth_unknown && depth != svn_depth_exclude);
 
+  /* Early error returns end the span when POOL gets cleaned up. */
+  span = svn_trace__begin("client", "commit", pool);
+
   /* Committing URLs doesn't make sense, so error if it's tried. */
   for (i = 0; i < targets->nelts; i++)
     {
@@ -1092,6 +1097,7 @@ svn_client_commit6(const apr_array_header_t *targets,
     }
 
   svn_pool_destroy(iterpool);
+  svn_trace__end(span);
 
   return svn_error_trace(reconcile_errors(cmt_err, unlock_err, bump_err,
                                           pool));
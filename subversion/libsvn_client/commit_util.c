@@ -437,6 +437,47 @@ harvest_committables(const char *local_abspath,
 
   baton.skip_below_abspath = NULL;
 
+  /* A plain commit of a whole tree only has to look at the nodes that
+     may have changed.  Find these from wc.db and stat() data instead of
+     walking the complete tree, unless a conflict will stop the commit
+     anyway.  Walking them in depth-first order keeps the harvester state
+     working as it does in a full walk. */
+  if (copy_mode_relpath == NULL && !just_locked
+      && depth == svn_depth_infinity)
+    {
+      apr_array_header_t *candidates;
+
+      SVN_ERR(svn_wc__find_commit_candidates(&candidates, wc_ctx,
+                                             local_abspath,
+                                             cancel_func, cancel_baton,
+                                             scratch_pool, scratch_pool));
+      if (candidates)
+        {
+          apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+          int i;
+
+          for (i = 0; i < candidates->nelts; i++)
+            {
+              svn_pool_clear(iterpool);
+              SVN_ERR(svn_wc_walk_status(wc_ctx,
+                                         APR_ARRAY_IDX(candidates, i,
+                                                       const char *),
+                                         svn_depth_empty,
+                                         FALSE /* get_all */,
+                                         FALSE /* no_ignore */,
+                                         FALSE /* ignore_text_mods */,
+                                         NULL /* ignore_patterns */,
+                                         harvest_status_callback,
+                                         &baton,
+                                         cancel_func, cancel_baton,
+                                         iterpool));
+            }
+
+          svn_pool_destroy(iterpool);
+          return SVN_NO_ERROR;
+        }
+    }
+
   SVN_ERR(svn_wc_walk_status(wc_ctx,
                              local_abspath,
                              depth,
@@ -1875,6 +1916,17 @@ svn_client__do_commit(const char *base_url,
   struct item_commit_baton cb_baton;
   apr_array_header_t *paths =
     apr_array_make(scratch_pool, commit_items->nelts, sizeof(const char *));
+  svn_config_t *cfg = ctx->config
+                      ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                      : NULL;
+  svn_boolean_t track_source;
+
+  /* See if the user wants us to search the whole vicinity of the base
+     text for matches. */
+  SVN_ERR(svn_config_get_bool(cfg, &track_source,
+                              SVN_CONFIG_SECTION_MISCELLANY,
+                              SVN_CONFIG_OPTION_DELTA_SOURCE_TRACKING,
+                              FALSE));
 
   /* Ditto for the checksums. */
   if (sha1_checksums)
@@ -1940,7 +1992,8 @@ svn_client__do_commit(const char *base_url,
       err = svn_wc_transmit_text_deltas4(&new_text_base_md5_checksum,
                                          &new_text_base_sha1_checksum,
                                          ctx->wc_ctx, item->path,
-                                         fulltext, editor, mod->file_baton,
+                                         fulltext, track_source,
+                                         editor, mod->file_baton,
                                          result_pool, iterpool);
 
       if (err)
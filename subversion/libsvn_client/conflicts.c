@@ -1700,6 +1700,211 @@ find_moves(void *baton, svn_log_entry_t *log_entry, apr_pool_t *scratch_pool)
   return SVN_NO_ERROR;
 }
 
+/* Swallow authz failures and return SVN_NO_ERROR in that case.
+ * Otherwise, return ERR unchanged. */
+static svn_error_t *
+ignore_authz_failures(svn_error_t *err)
+{
+  if (err && (   svn_error_find_cause(err, SVN_ERR_AUTHZ_UNREADABLE)
+              || svn_error_find_cause(err, SVN_ERR_RA_NOT_AUTHORIZED)
+              || svn_error_find_cause(err, SVN_ERR_RA_DAV_FORBIDDEN)))
+    {
+      svn_error_clear(err);
+      err = SVN_NO_ERROR;
+    }
+
+  return err;
+}
+
+/* Tree conflicts flagged by the same merge or update tend to ask for the
+ * history of the same revision range, typically once per conflict victim
+ * and for different paths.  Rather than asking the server for the log of
+ * each path, we fetch the log of the whole repository for that range once
+ * and derive the log of each path from it.  The result is kept in the
+ * client context for the following conflicts.
+ *
+ * This only pays off for limited revision ranges.  Longer ranges still
+ * get the log of the respective path from the server.
+ */
+#define MAX_SHARED_LOG_REVS 1000
+
+/* Drop all cached logs once there are that many. */
+#define MAX_SHARED_LOGS 8
+
+struct svn_client__conflict_history_t
+{
+  /* Maps "UUID:START_REV:END_REV" to an array of svn_log_entry_t *,
+   * youngest revision first. */
+  apr_hash_t *logs;
+
+  /* Pool holding LOGS and their contents. */
+  apr_pool_t *pool;
+};
+
+/* Implements svn_log_entry_receiver_t.  Add a copy of LOG_ENTRY to the
+ * array of svn_log_entry_t * BATON. */
+static svn_error_t *
+collect_log_entry(void *baton,
+                  svn_log_entry_t *log_entry,
+                  apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *entries = baton;
+
+  APR_ARRAY_PUSH(entries, svn_log_entry_t *)
+    = svn_log_entry_dup(log_entry, entries->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *ENTRIES to the log of the whole repository at REPOS_ROOT_URL from
+ * START_REV down to END_REV, with changed paths and authors.  Take it from
+ * the history cache of CTX if possible and add it there otherwise.
+ *
+ * The result remains valid until the next call to this function. */
+static svn_error_t *
+get_shared_log(const apr_array_header_t **entries,
+               const char *repos_root_url,
+               const char *repos_uuid,
+               svn_revnum_t start_rev,
+               svn_revnum_t end_rev,
+               svn_client_ctx_t *ctx,
+               apr_pool_t *scratch_pool)
+{
+  svn_client__private_ctx_t *private_ctx = svn_client__get_private_ctx(ctx);
+  struct svn_client__conflict_history_t *history;
+  svn_ra_session_t *ra_session;
+  apr_array_header_t *paths;
+  apr_array_header_t *revprops;
+  apr_array_header_t *log;
+  const char *key;
+
+  if (!private_ctx->conflict_history)
+    {
+      apr_pool_t *pool = svn_pool_create(private_ctx->pool);
+
+      history = apr_pcalloc(pool, sizeof(*history));
+      history->pool = pool;
+      history->logs = apr_hash_make(pool);
+      private_ctx->conflict_history = history;
+    }
+
+  history = private_ctx->conflict_history;
+  key = apr_psprintf(scratch_pool, "%s:%ld:%ld", repos_uuid, start_rev,
+                     end_rev);
+  *entries = svn_hash_gets(history->logs, key);
+  if (*entries)
+    return SVN_NO_ERROR;
+
+  if (apr_hash_count(history->logs) >= MAX_SHARED_LOGS)
+    {
+      svn_pool_clear(history->pool);
+      history->logs = apr_hash_make(history->pool);
+    }
+
+  SVN_ERR(svn_client__open_ra_session_internal(&ra_session, NULL,
+                                               repos_root_url, NULL, NULL,
+                                               FALSE, FALSE, ctx,
+                                               scratch_pool, scratch_pool));
+
+  paths = apr_array_make(scratch_pool, 1, sizeof(const char *));
+  APR_ARRAY_PUSH(paths, const char *) = "";
+
+  revprops = apr_array_make(scratch_pool, 1, sizeof(const char *));
+  APR_ARRAY_PUSH(revprops, const char *) = SVN_PROP_REVISION_AUTHOR;
+
+  /* Only complete logs go into the cache. */
+  log = apr_array_make(history->pool, 64, sizeof(svn_log_entry_t *));
+  SVN_ERR(svn_ra_get_log2(ra_session, paths, start_rev, end_rev,
+                          0, /* no limit */
+                          TRUE, /* need the changed paths list */
+                          FALSE, /* need to traverse copies */
+                          FALSE, /* no need for merged revisions */
+                          revprops,
+                          collect_log_entry, log,
+                          scratch_pool));
+
+  svn_hash_sets(history->logs, apr_pstrdup(history->pool, key), log);
+  *entries = log;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return those of the log ENTRIES of the whole repository, youngest first,
+ * that the log of REPOS_RELPATH, following copies, contains.  That is,
+ * the revisions that changed the node or anything below it, until the
+ * node was created.  Allocate the result in RESULT_POOL. */
+static apr_array_header_t *
+filter_shared_log(const apr_array_header_t *entries,
+                  const char *repos_relpath,
+                  apr_pool_t *result_pool)
+{
+  apr_array_header_t *filtered
+    = apr_array_make(result_pool, 16, sizeof(svn_log_entry_t *));
+  int i;
+
+  for (i = 0; i < entries->nelts && repos_relpath; i++)
+    {
+      svn_log_entry_t *log_entry = APR_ARRAY_IDX(entries, i,
+                                                 svn_log_entry_t *);
+      const char *next_relpath = repos_relpath;
+      apr_size_t added_len = 0;
+      svn_boolean_t relevant = FALSE;
+      apr_hash_index_t *hi;
+
+      if (! log_entry->changed_paths2)
+        continue;
+
+      for (hi = apr_hash_first(result_pool, log_entry->changed_paths2);
+           hi != NULL;
+           hi = apr_hash_next(hi))
+        {
+          const char *changed_path = apr_hash_this_key(hi);
+          svn_log_changed_path2_t *log_item = apr_hash_this_val(hi);
+          const char *below;
+
+          /* ### Remove leading slash from paths in log entries. */
+          if (changed_path[0] == '/')
+            changed_path++;
+
+          if (svn_relpath_skip_ancestor(repos_relpath, changed_path))
+            relevant = TRUE;
+
+          /* Did the node come into existence here, either by itself or
+           * along with one of its parents?  Then its older history is
+           * that of the copy source, if any.  The deepest add wins. */
+          below = svn_relpath_skip_ancestor(changed_path, repos_relpath);
+          if (below
+              && (log_item->action == 'A' || log_item->action == 'R')
+              && strlen(changed_path) + 1 > added_len)
+            {
+              relevant = TRUE;
+              added_len = strlen(changed_path) + 1;
+
+              if (log_item->copyfrom_path)
+                {
+                  const char *copyfrom_path = log_item->copyfrom_path;
+
+                  if (copyfrom_path[0] == '/')
+                    copyfrom_path++;
+                  next_relpath = svn_relpath_join(copyfrom_path, below,
+                                                  result_pool);
+                }
+              else
+                {
+                  next_relpath = NULL;
+                }
+            }
+        }
+
+      if (relevant)
+        APR_ARRAY_PUSH(filtered, svn_log_entry_t *) = log_entry;
+
+      repos_relpath = next_relpath;
+    }
+
+  return filtered;
+}
+
 /* Find all moves which occurred in repository history starting at
  * REPOS_RELPATH@START_REV until END_REV (where START_REV > END_REV).
  * Return results in *MOVES_TABLE (see struct find_moves_baton for details). */
@@ -1720,6 +1925,7 @@ find_moves_in_revision_range(struct apr_hash_t **moves_table,
   const char *corrected_url;
   apr_array_header_t *paths;
   apr_array_header_t *revprops;
+  const apr_array_header_t *entries = NULL;
   struct find_moves_baton b = { 0 };
 
   SVN_ERR_ASSERT(start_rev > end_rev);
@@ -1747,14 +1953,47 @@ find_moves_in_revision_range(struct apr_hash_t **moves_table,
   SVN_ERR(svn_ra__dup_session(&b.extra_ra_session, ra_session, NULL,
                               scratch_pool, scratch_pool));
 
-  SVN_ERR(svn_ra_get_log2(ra_session, paths, start_rev, end_rev,
-                          0, /* no limit */
-                          TRUE, /* need the changed paths list */
-                          FALSE, /* need to traverse copies */
-                          FALSE, /* no need for merged revisions */
-                          revprops,
-                          find_moves, &b,
-                          scratch_pool));
+  /* Derive the log of REPOS_RELPATH from that of the whole repository
+   * if possible.  Not being able to read the latter is no error. */
+  if (start_rev - end_rev <= MAX_SHARED_LOG_REVS)
+    {
+      svn_error_t *err = get_shared_log(&entries, repos_root_url, repos_uuid,
+                                        start_rev, end_rev, ctx,
+                                        scratch_pool);
+
+      if (err)
+        {
+          entries = NULL;
+          SVN_ERR(ignore_authz_failures(err));
+        }
+    }
+
+  if (entries)
+    {
+      apr_array_header_t *log = filter_shared_log(entries, repos_relpath,
+                                                  scratch_pool);
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      int i;
+
+      for (i = 0; i < log->nelts; i++)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(find_moves(&b, APR_ARRAY_IDX(log, i, svn_log_entry_t *),
+                             iterpool));
+        }
+      svn_pool_destroy(iterpool);
+    }
+  else
+    {
+      SVN_ERR(svn_ra_get_log2(ra_session, paths, start_rev, end_rev,
+                              0, /* no limit */
+                              TRUE, /* need the changed paths list */
+                              FALSE, /* need to traverse copies */
+                              FALSE, /* no need for merged revisions */
+                              revprops,
+                              find_moves, &b,
+                              scratch_pool));
+    }
 
   *moves_table = b.moves_table;
 
@@ -12615,22 +12854,6 @@ svn_client_conflict_tree_get_resolution_options(apr_array_header_t **options,
   return SVN_NO_ERROR;
 }
 
-/* Swallow authz failures and return SVN_NO_ERROR in that case.
- * Otherwise, return ERR unchanged. */
-static svn_error_t *
-ignore_authz_failures(svn_error_t *err)
-{
-  if (err && (   svn_error_find_cause(err, SVN_ERR_AUTHZ_UNREADABLE)
-              || svn_error_find_cause(err, SVN_ERR_RA_NOT_AUTHORIZED)
-              || svn_error_find_cause(err, SVN_ERR_RA_DAV_FORBIDDEN)))
-    {
-      svn_error_clear(err);
-      err = SVN_NO_ERROR;
-    }
-
-  return err;
-}
-
 svn_error_t *
 svn_client_conflict_tree_get_details(svn_client_conflict_t *conflict,
                                      svn_client_ctx_t *ctx,
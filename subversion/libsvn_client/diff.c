@@ -33,6 +33,7 @@
 #include <apr_strings.h>
 #include <apr_pools.h>
 #include <apr_hash.h>
+#include <apr_thread_proc.h>
 #include "svn_types.h"
 #include "svn_hash.h"
 #include "svn_wc.h"
@@ -57,6 +58,9 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_io_private.h"
 #include "private/svn_ra_private.h"
+#include "private/svn_string_private.h"
+#include "private/svn_mutex.h"
+#include "private/svn_thread_cond.h"
 
 #include "svn_private_config.h"
 
@@ -65,6 +69,14 @@
 
 #define DIFF_REVNUM_NONEXISTENT ((svn_revnum_t) -100)
 
+/* Number of worker threads computing file diffs for svn_client_diff7()
+   and svn_client_diff_peg7(). */
+#define DIFF_WORKER_COUNT 4
+
+/* Files larger than this are not loaded into memory to be diffed by a
+   worker thread but get diffed in-place by the thread driving the diff. */
+#define DIFF_WORKER_MAX_FILESIZE (1024 * 1024)
+
 #define MAKE_ERR_BAD_RELATIVE_PATH(path, relative_to_dir) \
         svn_error_createf(SVN_ERR_BAD_RELATIVE_PATH, NULL, \
                           _("Path '%s' must be an immediate child of " \
@@ -747,6 +759,10 @@ typedef struct diff_writer_info_t
   void *cancel_baton;
 
   struct diff_driver_info_t ddi;
+
+  /* Worker threads computing file diffs, or NULL if all output shall be
+     written immediately. */
+  struct diff_workers_t *workers;
 } diff_writer_info_t;
 
 /* An helper for diff_dir_props_changed, diff_file_changed and diff_file_added
@@ -861,12 +877,19 @@ transform_link_to_git(const char **new_tmpfile,
 
    If FORCE_DIFF is TRUE, always write a diff, even for empty diffs.
 
+   If CONTENTS1 and CONTENTS2 are not NULL, they are the contents of
+   TMPFILE1 and TMPFILE2, respectively, and the internal diff will be run
+   on them instead of the files.  This is not supported together with
+   DWI->use_git_diff_format.
+
    Set *WROTE_HEADER to TRUE if a diff header was written */
 static svn_error_t *
 diff_content_changed(svn_boolean_t *wrote_header,
                      const char *diff_relpath,
                      const char *tmpfile1,
                      const char *tmpfile2,
+                     const svn_string_t *contents1,
+                     const svn_string_t *contents2,
                      svn_revnum_t rev1,
                      svn_revnum_t rev2,
                      apr_hash_t *left_props,
@@ -1078,9 +1101,14 @@ diff_content_changed(svn_boolean_t *wrote_header,
     {
       svn_diff_t *diff;
 
-      SVN_ERR(svn_diff_file_diff_2(&diff, tmpfile1, tmpfile2,
-                                   dwi->options.for_internal,
-                                   scratch_pool));
+      if (contents1)
+        SVN_ERR(svn_diff_mem_string_diff(&diff, contents1, contents2,
+                                         dwi->options.for_internal,
+                                         scratch_pool));
+      else
+        SVN_ERR(svn_diff_file_diff_2(&diff, tmpfile1, tmpfile2,
+                                     dwi->options.for_internal,
+                                     scratch_pool));
 
       if (force_diff
           || dwi->use_git_diff_format
@@ -1106,7 +1134,18 @@ diff_content_changed(svn_boolean_t *wrote_header,
             }
 
           /* Output the actual diff */
-          if (force_diff || svn_diff_contains_diffs(diff))
+          if (contents1)
+            {
+              if (force_diff || svn_diff_contains_diffs(diff))
+                SVN_ERR(svn_diff_mem_string_output_unified3(outstream, diff,
+                         TRUE /* with_diff_header */, NULL /* "@@" */,
+                         label1, label2, dwi->header_encoding,
+                         contents1, contents2,
+                         dwi->options.for_internal->context_size,
+                         dwi->cancel_func, dwi->cancel_baton,
+                         scratch_pool));
+            }
+          else if (force_diff || svn_diff_contains_diffs(diff))
             SVN_ERR(svn_diff_file_output_unified4(outstream, diff,
                      tmpfile1, tmpfile2, label1, label2,
                      dwi->header_encoding, rel_to_dir,
@@ -1120,6 +1159,634 @@ diff_content_changed(svn_boolean_t *wrote_header,
   return SVN_NO_ERROR;
 }
 
+/* Everything needed to write the diff of a single node. */
+typedef struct node_diff_t
+{
+  /* The node and the revisions to show in the headers. */
+  const char *relpath;
+  svn_revnum_t rev1;
+  svn_revnum_t rev2;
+
+  /* If not NULL, only write an index header for RELPATH with this
+     suffix, e.g. " (added)", and ignore all members below. */
+  const char *header_suffix;
+
+  /* Whether to show the differences between TMPFILE1 and TMPFILE2.
+     The members down to COPYFROM_REV are only used if this is set. */
+  svn_boolean_t show_content;
+  const char *tmpfile1;
+  const char *tmpfile2;
+
+  /* The contents of TMPFILE1 and TMPFILE2, or NULL if not read, yet. */
+  const svn_string_t *contents1;
+  const svn_string_t *contents2;
+
+  svn_diff_operation_kind_t operation;
+  svn_boolean_t force_diff;
+  const char *copyfrom_path;
+  svn_revnum_t copyfrom_rev;
+
+  /* The properties of both sides and the changes to show.  Any of them
+     may be NULL. */
+  apr_hash_t *left_props;
+  apr_hash_t *right_props;
+  const apr_array_header_t *prop_changes;
+} node_diff_t;
+
+/* Write the diff described by ND to DWI->outstream. */
+static svn_error_t *
+write_node_diff(const node_diff_t *nd,
+                diff_writer_info_t *dwi,
+                apr_pool_t *scratch_pool)
+{
+  svn_boolean_t wrote_header = FALSE;
+
+  if (nd->header_suffix)
+    {
+      const char *index_path = nd->relpath;
+
+      if (dwi->ddi.anchor)
+        index_path = svn_dirent_join(dwi->ddi.anchor, nd->relpath,
+                                     scratch_pool);
+
+      return svn_error_trace(print_diff_index_header(dwi->outstream,
+                                                     dwi->header_encoding,
+                                                     index_path,
+                                                     nd->header_suffix,
+                                                     scratch_pool));
+    }
+
+  if (nd->show_content)
+    SVN_ERR(diff_content_changed(&wrote_header, nd->relpath,
+                                 nd->tmpfile1, nd->tmpfile2,
+                                 nd->contents1, nd->contents2,
+                                 nd->rev1, nd->rev2,
+                                 nd->left_props, nd->right_props,
+                                 nd->operation, nd->force_diff,
+                                 nd->copyfrom_path, nd->copyfrom_rev,
+                                 dwi, scratch_pool));
+
+  if (nd->prop_changes && nd->prop_changes->nelts > 0)
+    SVN_ERR(diff_props_changed(nd->relpath, nd->rev1, nd->rev2,
+                               nd->prop_changes,
+                               nd->left_props, nd->right_props,
+                               ! wrote_header, dwi, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/*-----------------------------------------------------------------*/
+
+/*** Computing file diffs in worker threads. ***/
+
+/* The diff drivers report one node after the other, each in a short-lived
+ * pool that also holds the temporary files to compare.  To run the text
+ * diffs in parallel, the writer reads both files of a modified node into
+ * memory and queues the rest of the work.  The output of each node gets
+ * collected in a buffer and is written to the real output stream strictly
+ * in the order the nodes have been reported.
+ *
+ * Nodes without text diff are rendered right away by the driving thread.
+ * They only need to be buffered if earlier nodes are still pending.
+ *
+ * This only works for the internal diff in the plain svn format because
+ * external diff tools and the git format need the files or the working
+ * copy context.  The thread driving the diff diffs large files itself. */
+
+#if APR_HAS_THREADS
+
+/* A node diff and the output produced for it. */
+typedef struct diff_job_t
+{
+  /* Next job to be written. */
+  struct diff_job_t *next;
+
+  /* Next job to be picked up by a worker. */
+  struct diff_job_t *next_queued;
+
+  /* All data of this job lives in this pool.  It uses its own allocator
+     because it gets filled by the worker and destroyed by the writer. */
+  apr_pool_t *pool;
+
+  /* Copy of the node diff to produce. */
+  node_diff_t nd;
+
+  /* Copy of the diff writer settings, with the output going to OUTPUT. */
+  diff_writer_info_t dwi;
+
+  /* The diff text and the error returned when producing it.
+     Only valid when DONE is set. */
+  svn_stringbuf_t *output;
+  svn_error_t *err;
+
+  /* Set once the job has been processed. */
+  svn_boolean_t done;
+} diff_job_t;
+
+/* The workers of a diff writer and the jobs in flight. */
+struct diff_workers_t
+{
+  /* Pool that this struct has been allocated in. */
+  apr_pool_t *pool;
+
+  /* The stream to write the diff to.  Writer thread only. */
+  svn_stream_t *outstream;
+
+  /* Worker threads, started on demand. */
+  apr_thread_t **threads;
+  int thread_count;
+  int threads_started;
+  apr_pool_t *thread_pool;
+
+  /* Serializes access to all members below. */
+  svn_mutex__t *mutex;
+
+  /* Signaled when a job has been queued or the workers shall exit. */
+  svn_thread_cond__t *job_queued;
+
+  /* Signaled when a worker finished a job. */
+  svn_thread_cond__t *job_done;
+
+  /* Jobs not written, yet, in path order.  These are only ever modified
+     by the writer thread. */
+  diff_job_t *first;
+  diff_job_t *last;
+  int pending;
+
+  /* Jobs not picked up by any worker, yet, in path order. */
+  diff_job_t *first_queued;
+  diff_job_t *last_queued;
+
+  /* Set when the workers shall terminate. */
+  svn_boolean_t shutdown;
+};
+
+/* Take the next job from the queue in WORKERS and return it in *JOB.
+   Block while the queue is empty.  Set *JOB to NULL after WORKERS has
+   been shut down.
+
+   This function must be called with WORKERS->MUTEX acquired. */
+static svn_error_t *
+take_job(diff_job_t **job,
+         struct diff_workers_t *workers)
+{
+  while (workers->first_queued == NULL && !workers->shutdown)
+    SVN_ERR(svn_thread_cond__wait(workers->job_queued, workers->mutex));
+
+  *job = workers->shutdown ? NULL : workers->first_queued;
+  if (*job)
+    {
+      workers->first_queued = (*job)->next_queued;
+      if (workers->first_queued == NULL)
+        workers->last_queued = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Mark JOB in WORKERS as processed and wake up the writer.
+
+   This function must be called with WORKERS->MUTEX acquired. */
+static svn_error_t *
+finish_job(struct diff_workers_t *workers,
+           diff_job_t *job)
+{
+  job->done = TRUE;
+  return svn_thread_cond__broadcast(workers->job_done);
+}
+
+/* Produce the output for JOB. */
+static void
+process_job(diff_job_t *job)
+{
+  job->err = write_node_diff(&job->nd, &job->dwi, job->pool);
+}
+
+/* Worker loop: process queued jobs in WORKERS until it gets shut down. */
+static svn_error_t *
+run_diff_worker(struct diff_workers_t *workers)
+{
+  while (TRUE)
+    {
+      diff_job_t *job;
+
+      SVN_MUTEX__WITH_LOCK(workers->mutex, take_job(&job, workers));
+      if (job == NULL)
+        break;
+
+      process_job(job);
+      SVN_MUTEX__WITH_LOCK(workers->mutex, finish_job(workers, job));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* The plain APR thread function running a worker.
+ * DATA is the diff_workers_t object to serve. */
+static void * APR_THREAD_FUNC
+diff_worker_thread(apr_thread_t *thread, void *data)
+{
+  svn_error_t *err = run_diff_worker(data);
+  apr_status_t result = APR_SUCCESS;
+
+  if (err)
+    {
+      result = err->apr_err;
+      svn_error_clear(err);
+    }
+
+  /* End thread explicitly to prevent APR_INCOMPLETE return codes in
+     apr_thread_join(). */
+  apr_thread_exit(thread, result);
+  return NULL;
+}
+
+/* Start all worker threads of WORKERS that are not running, yet.
+
+   This function must be called with WORKERS->MUTEX acquired. */
+static svn_error_t *
+ensure_diff_workers(struct diff_workers_t *workers)
+{
+  /* The thread objects can't share the allocator with the writer. */
+  if (workers->thread_pool == NULL)
+    workers->thread_pool
+      = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+
+  while (workers->threads_started < workers->thread_count)
+    {
+      apr_status_t status
+        = apr_thread_create(&workers->threads[workers->threads_started],
+                            NULL, diff_worker_thread, workers,
+                            workers->thread_pool);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't create diff thread"));
+
+      ++workers->threads_started;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Append JOB to the list of pending jobs in WORKERS.  Unless JOB has
+   already been processed, queue it for the workers as well.
+
+   This function must be called with WORKERS->MUTEX acquired. */
+static svn_error_t *
+queue_job(struct diff_workers_t *workers,
+          diff_job_t *job)
+{
+  if (workers->last)
+    workers->last->next = job;
+  else
+    workers->first = job;
+  workers->last = job;
+  ++workers->pending;
+
+  if (job->done)
+    return SVN_NO_ERROR;
+
+  if (workers->last_queued)
+    workers->last_queued->next_queued = job;
+  else
+    workers->first_queued = job;
+  workers->last_queued = job;
+
+  SVN_ERR(ensure_diff_workers(workers));
+  return svn_thread_cond__signal(workers->job_queued);
+}
+
+/* If the first job in WORKERS has not been picked up by any worker, yet,
+   remove it from the queue and return it in *JOB.  Set *JOB to NULL
+   otherwise.
+
+   This function must be called with WORKERS->MUTEX acquired. */
+static svn_error_t *
+claim_first_job(diff_job_t **job,
+                struct diff_workers_t *workers)
+{
+  *job = NULL;
+  if (workers->first && workers->first == workers->first_queued)
+    {
+      *job = workers->first;
+      workers->first_queued = (*job)->next_queued;
+      if (workers->first_queued == NULL)
+        workers->last_queued = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove the first job from the list of pending jobs in WORKERS and
+   return it in *JOB, if it has been processed.  If WAIT is set, block
+   until that is the case.  Set *JOB to NULL if there are no pending jobs
+   or if the first one is still being processed and WAIT is not set.
+
+   This function must be called with WORKERS->MUTEX acquired. */
+static svn_error_t *
+next_finished_job(diff_job_t **job,
+                  struct diff_workers_t *workers,
+                  svn_boolean_t wait)
+{
+  diff_job_t *head = workers->first;
+
+  *job = NULL;
+  if (head == NULL)
+    return SVN_NO_ERROR;
+
+  while (!head->done && wait)
+    SVN_ERR(svn_thread_cond__wait(workers->job_done, workers->mutex));
+
+  if (head->done)
+    {
+      workers->first = head->next;
+      if (workers->first == NULL)
+        workers->last = NULL;
+      --workers->pending;
+
+      *job = head;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the output of JOB to the output stream of WORKERS and release
+   JOB. */
+static svn_error_t *
+write_job(struct diff_workers_t *workers,
+          diff_job_t *job)
+{
+  svn_error_t *err = job->err;
+
+  if (!err && job->output->len)
+    err = svn_stream_write(workers->outstream, job->output->data,
+                           &job->output->len);
+
+  svn_pool_destroy(job->pool);
+  return svn_error_trace(err);
+}
+
+/* Write the output of all jobs that have been processed in WORKERS.
+   If WAIT is set, block until the first job has been processed.  If DRAIN
+   is set, write all jobs and help processing them. */
+static svn_error_t *
+write_finished_jobs(struct diff_workers_t *workers,
+                    svn_boolean_t wait,
+                    svn_boolean_t drain)
+{
+  while (TRUE)
+    {
+      diff_job_t *job;
+
+      /* Don't wait for a worker to pick up the job we need next. */
+      if (drain)
+        {
+          SVN_MUTEX__WITH_LOCK(workers->mutex,
+                               claim_first_job(&job, workers));
+          if (job)
+            {
+              /* No one else will access JOB anymore. */
+              process_job(job);
+              job->done = TRUE;
+            }
+        }
+
+      SVN_MUTEX__WITH_LOCK(workers->mutex,
+                           next_finished_job(&job, workers, wait || drain));
+      if (job == NULL)
+        break;
+
+      SVN_ERR(write_job(workers, job));
+      wait = FALSE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Tell the threads of WORKERS to terminate.
+
+   This function must be called with WORKERS->MUTEX acquired. */
+static svn_error_t *
+request_workers_shutdown(struct diff_workers_t *workers)
+{
+  workers->shutdown = TRUE;
+  return svn_thread_cond__broadcast(workers->job_queued);
+}
+
+/* Pool cleanup function terminating the threads of the diff_workers_t
+   given as BATON and releasing all jobs that have not been written. */
+static apr_status_t
+cleanup_diff_workers(void *baton)
+{
+  struct diff_workers_t *workers = baton;
+  svn_error_t *err = svn_mutex__lock(workers->mutex);
+  int i;
+
+  if (!err)
+    err = svn_mutex__unlock(workers->mutex,
+                            request_workers_shutdown(workers));
+  svn_error_clear(err);
+
+  for (i = 0; i < workers->threads_started; ++i)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, workers->threads[i]);
+    }
+  workers->threads_started = 0;
+
+  while (workers->first)
+    {
+      diff_job_t *job = workers->first;
+      workers->first = job->next;
+
+      svn_error_clear(job->err);
+      svn_pool_destroy(job->pool);
+    }
+  workers->last = NULL;
+
+  if (workers->thread_pool)
+    {
+      svn_pool_destroy(workers->thread_pool);
+      workers->thread_pool = NULL;
+    }
+
+  return APR_SUCCESS;
+}
+
+/* Copy ND into JOB, with both file contents read into memory. */
+static svn_error_t *
+init_content_job(diff_job_t *job,
+                 const node_diff_t *nd)
+{
+  svn_stringbuf_t *contents;
+
+  job->nd = *nd;
+  job->nd.relpath = apr_pstrdup(job->pool, nd->relpath);
+  job->nd.copyfrom_path = apr_pstrdup(job->pool, nd->copyfrom_path);
+
+  /* The files may be gone by the time the job gets processed. */
+  job->nd.tmpfile1 = NULL;
+  job->nd.tmpfile2 = NULL;
+
+  SVN_ERR(svn_stringbuf_from_file2(&contents, nd->tmpfile1, job->pool));
+  job->nd.contents1 = svn_stringbuf__morph_into_string(contents);
+  SVN_ERR(svn_stringbuf_from_file2(&contents, nd->tmpfile2, job->pool));
+  job->nd.contents2 = svn_stringbuf__morph_into_string(contents);
+
+  if (nd->left_props)
+    job->nd.left_props = svn_prop_hash_dup(nd->left_props, job->pool);
+  if (nd->right_props)
+    job->nd.right_props = svn_prop_hash_dup(nd->right_props, job->pool);
+  if (nd->prop_changes)
+    job->nd.prop_changes = svn_prop_array_dup(nd->prop_changes, job->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Arrange for the diff described by ND to be written by WORKERS after
+   all diffs queued before.  DWI is the diff writer to use. */
+static svn_error_t *
+queue_node_diff(struct diff_workers_t *workers,
+                const node_diff_t *nd,
+                diff_writer_info_t *dwi,
+                apr_pool_t *scratch_pool)
+{
+  diff_job_t *job;
+  apr_pool_t *job_pool;
+
+  /* Nothing to wait for? */
+  if (!nd->show_content && workers->first == NULL)
+    return svn_error_trace(write_node_diff(nd, dwi, scratch_pool));
+
+  if (nd->show_content)
+    {
+      apr_finfo_t finfo1, finfo2;
+
+      SVN_ERR(svn_io_stat(&finfo1, nd->tmpfile1, APR_FINFO_SIZE,
+                          scratch_pool));
+      SVN_ERR(svn_io_stat(&finfo2, nd->tmpfile2, APR_FINFO_SIZE,
+                          scratch_pool));
+
+      /* Don't keep large files in memory. */
+      if (   finfo1.size > DIFF_WORKER_MAX_FILESIZE
+          || finfo2.size > DIFF_WORKER_MAX_FILESIZE)
+        {
+          SVN_ERR(write_finished_jobs(workers, TRUE, TRUE));
+          return svn_error_trace(write_node_diff(nd, dwi, scratch_pool));
+        }
+    }
+
+  job_pool = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+  job = apr_pcalloc(job_pool, sizeof(*job));
+  job->pool = job_pool;
+  job->output = svn_stringbuf_create_empty(job_pool);
+
+  job->dwi = *dwi;
+  job->dwi.outstream = svn_stream_from_stringbuf(job->output, job_pool);
+  job->dwi.cancel_func = NULL;
+  job->dwi.cancel_baton = NULL;
+  job->dwi.workers = NULL;
+
+  if (nd->show_content)
+    {
+      svn_error_t *err = init_content_job(job, nd);
+      if (err)
+        {
+          svn_pool_destroy(job_pool);
+          return svn_error_trace(err);
+        }
+    }
+  else
+    {
+      /* Cheap enough to produce right away. */
+      job->err = write_node_diff(nd, &job->dwi, job_pool);
+      job->done = TRUE;
+    }
+
+  SVN_MUTEX__WITH_LOCK(workers->mutex, queue_job(workers, job));
+
+  /* Limit the number of files in flight, i.e. the memory usage. */
+  return svn_error_trace(write_finished_jobs(workers,
+                                             workers->pending
+                                               > 2 * workers->thread_count,
+                                             FALSE));
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Let worker threads compute the text diffs written by DWI, if its
+   settings allow for that.  The workers get terminated when DWI->pool
+   gets cleaned up or by finish_diff_workers(). */
+static svn_error_t *
+start_diff_workers(diff_writer_info_t *dwi)
+{
+#if APR_HAS_THREADS
+  struct diff_workers_t *workers;
+
+  if (dwi->diff_cmd
+      || dwi->use_git_diff_format
+      || dwi->properties_only
+      || dwi->options.for_internal->show_c_function)
+    return SVN_NO_ERROR;
+
+  workers = apr_pcalloc(dwi->pool, sizeof(*workers));
+  workers->pool = dwi->pool;
+  workers->outstream = dwi->outstream;
+  workers->thread_count = DIFF_WORKER_COUNT;
+  workers->threads = apr_pcalloc(dwi->pool, workers->thread_count
+                                              * sizeof(*workers->threads));
+
+  SVN_ERR(svn_mutex__init(&workers->mutex, TRUE, dwi->pool));
+  SVN_ERR(svn_thread_cond__create(&workers->job_queued, dwi->pool));
+  SVN_ERR(svn_thread_cond__create(&workers->job_done, dwi->pool));
+
+  apr_pool_cleanup_register(dwi->pool, workers, cleanup_diff_workers,
+                            apr_pool_cleanup_null);
+
+  dwi->workers = workers;
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Write all diffs still pending in DWI and terminate its workers.
+   If ERR is not SVN_NO_ERROR, discard the pending diffs instead and
+   return ERR. */
+static svn_error_t *
+finish_diff_workers(diff_writer_info_t *dwi,
+                    svn_error_t *err)
+{
+#if APR_HAS_THREADS
+  struct diff_workers_t *workers = dwi->workers;
+
+  if (workers == NULL)
+    return svn_error_trace(err);
+
+  if (!err)
+    err = write_finished_jobs(workers, TRUE, TRUE);
+
+  apr_pool_cleanup_run(workers->pool, workers, cleanup_diff_workers);
+  dwi->workers = NULL;
+#endif
+
+  return svn_error_trace(err);
+}
+
+/* Write the diff described by ND using DWI, either immediately or through
+   its workers. */
+static svn_error_t *
+process_node_diff(const node_diff_t *nd,
+                  diff_writer_info_t *dwi,
+                  apr_pool_t *scratch_pool)
+{
+#if APR_HAS_THREADS
+  if (dwi->workers)
+    return svn_error_trace(queue_node_diff(dwi->workers, nd, dwi,
+                                           scratch_pool));
+#endif
+
+  return svn_error_trace(write_node_diff(nd, dwi, scratch_pool));
+}
+
 /* An svn_diff_tree_processor_t callback. */
 static svn_error_t *
 diff_file_changed(const char *relpath,
@@ -1136,25 +1803,23 @@ diff_file_changed(const char *relpath,
                   apr_pool_t *scratch_pool)
 {
   diff_writer_info_t *dwi = processor->baton;
-  svn_boolean_t wrote_header = FALSE;
-
-  if (file_modified)
-    SVN_ERR(diff_content_changed(&wrote_header, relpath,
-                                 left_file, right_file,
-                                 left_source->revision,
-                                 right_source->revision,
-                                 left_props, right_props,
-                                 svn_diff_op_modified, FALSE,
-                                 NULL,
-                                 SVN_INVALID_REVNUM, dwi,
-                                 scratch_pool));
-  if (prop_changes->nelts > 0)
-    SVN_ERR(diff_props_changed(relpath,
-                               left_source->revision,
-                               right_source->revision, prop_changes,
-                               left_props, right_props, !wrote_header,
-                               dwi, scratch_pool));
-  return SVN_NO_ERROR;
+  node_diff_t nd = { 0 };
+
+  nd.relpath = relpath;
+  nd.rev1 = left_source->revision;
+  nd.rev2 = right_source->revision;
+  nd.show_content = file_modified;
+  nd.tmpfile1 = left_file;
+  nd.tmpfile2 = right_file;
+  nd.operation = svn_diff_op_modified;
+  nd.force_diff = FALSE;
+  nd.copyfrom_path = NULL;
+  nd.copyfrom_rev = SVN_INVALID_REVNUM;
+  nd.left_props = left_props;
+  nd.right_props = right_props;
+  nd.prop_changes = prop_changes;
+
+  return svn_error_trace(process_node_diff(&nd, dwi, scratch_pool));
 }
 
 /* Because the repos-diff editor passes at least one empty file to
@@ -1175,24 +1840,17 @@ diff_file_added(const char *relpath,
                 apr_pool_t *scratch_pool)
 {
   diff_writer_info_t *dwi = processor->baton;
-  svn_boolean_t wrote_header = FALSE;
+  node_diff_t nd = { 0 };
   const char *left_file;
   apr_hash_t *left_props;
   apr_array_header_t *prop_changes;
 
+  nd.relpath = relpath;
+
   if (dwi->no_diff_added)
     {
-      const char *index_path = relpath;
-
-      if (dwi->ddi.anchor)
-        index_path = svn_dirent_join(dwi->ddi.anchor, relpath,
-                                     scratch_pool);
-
-      SVN_ERR(print_diff_index_header(dwi->outstream, dwi->header_encoding,
-                                      index_path, " (added)",
-                                      scratch_pool));
-      wrote_header = TRUE;
-      return SVN_NO_ERROR;
+      nd.header_suffix = " (added)";
+      return svn_error_trace(process_node_diff(&nd, dwi, scratch_pool));
     }
 
   /* During repos->wc diff of a copy revision numbers obtained
@@ -1218,42 +1876,35 @@ diff_file_added(const char *relpath,
 
   SVN_ERR(svn_prop_diffs(&prop_changes, right_props, left_props, scratch_pool));
 
-  if (copyfrom_source && right_file)
-    SVN_ERR(diff_content_changed(&wrote_header, relpath,
-                                 left_file, right_file,
-                                 copyfrom_source->revision,
-                                 right_source->revision,
-                                 left_props, right_props,
-                                 copyfrom_source->moved_from_relpath
-                                    ? svn_diff_op_moved
-                                    : svn_diff_op_copied,
-                                 TRUE /* force diff output */,
-                                 copyfrom_source->moved_from_relpath
-                                    ? copyfrom_source->moved_from_relpath
-                                    : copyfrom_source->repos_relpath,
-                                 copyfrom_source->revision,
-                                 dwi, scratch_pool));
-  else if (right_file)
-    SVN_ERR(diff_content_changed(&wrote_header, relpath,
-                                 left_file, right_file,
-                                 DIFF_REVNUM_NONEXISTENT,
-                                 right_source->revision,
-                                 left_props, right_props,
-                                 svn_diff_op_added,
-                                 TRUE /* force diff output */,
-                                 NULL, SVN_INVALID_REVNUM,
-                                 dwi, scratch_pool));
-
-  if (prop_changes->nelts > 0)
-    SVN_ERR(diff_props_changed(relpath,
-                               copyfrom_source ? copyfrom_source->revision
-                                               : DIFF_REVNUM_NONEXISTENT,
-                               right_source->revision,
-                               prop_changes,
-                               left_props, right_props,
-                               ! wrote_header, dwi, scratch_pool));
+  nd.rev1 = copyfrom_source ? copyfrom_source->revision
+                            : DIFF_REVNUM_NONEXISTENT;
+  nd.rev2 = right_source->revision;
+  nd.show_content = (right_file != NULL);
+  nd.tmpfile1 = left_file;
+  nd.tmpfile2 = right_file;
+  nd.force_diff = TRUE;
+  nd.left_props = left_props;
+  nd.right_props = right_props;
+  nd.prop_changes = prop_changes;
+
+  if (copyfrom_source)
+    {
+      nd.operation = copyfrom_source->moved_from_relpath
+                       ? svn_diff_op_moved
+                       : svn_diff_op_copied;
+      nd.copyfrom_path = copyfrom_source->moved_from_relpath
+                           ? copyfrom_source->moved_from_relpath
+                           : copyfrom_source->repos_relpath;
+      nd.copyfrom_rev = copyfrom_source->revision;
+    }
+  else
+    {
+      nd.operation = svn_diff_op_added;
+      nd.copyfrom_path = NULL;
+      nd.copyfrom_rev = SVN_INVALID_REVNUM;
+    }
 
-  return SVN_NO_ERROR;
+  return svn_error_trace(process_node_diff(&nd, dwi, scratch_pool));
 }
 
 /* An svn_diff_tree_processor_t callback. */
@@ -1267,57 +1918,43 @@ diff_file_deleted(const char *relpath,
                   apr_pool_t *scratch_pool)
 {
   diff_writer_info_t *dwi = processor->baton;
+  node_diff_t nd = { 0 };
+
+  nd.relpath = relpath;
 
   if (dwi->no_diff_deleted)
     {
-      const char *index_path = relpath;
-
-      if (dwi->ddi.anchor)
-        index_path = svn_dirent_join(dwi->ddi.anchor, relpath,
-                                     scratch_pool);
-
-      SVN_ERR(print_diff_index_header(dwi->outstream, dwi->header_encoding,
-                                      index_path, " (deleted)",
-                                      scratch_pool));
+      nd.header_suffix = " (deleted)";
+      return svn_error_trace(process_node_diff(&nd, dwi, scratch_pool));
     }
-  else
-    {
-      svn_boolean_t wrote_header = FALSE;
-
-      if (!dwi->empty_file)
-        SVN_ERR(svn_io_open_unique_file3(NULL, &dwi->empty_file,
-                                         NULL, svn_io_file_del_on_pool_cleanup,
-                                         dwi->pool, scratch_pool));
-
-      if (left_file)
-        SVN_ERR(diff_content_changed(&wrote_header, relpath,
-                                     left_file, dwi->empty_file,
-                                     left_source->revision,
-                                     DIFF_REVNUM_NONEXISTENT,
-                                     left_props,
-                                     NULL,
-                                     svn_diff_op_deleted, FALSE,
-                                     NULL, SVN_INVALID_REVNUM,
-                                     dwi,
-                                     scratch_pool));
-
-      if (left_props && apr_hash_count(left_props))
-        {
-          apr_array_header_t *prop_changes;
 
-          SVN_ERR(svn_prop_diffs(&prop_changes, apr_hash_make(scratch_pool),
-                                 left_props, scratch_pool));
+  if (!dwi->empty_file)
+    SVN_ERR(svn_io_open_unique_file3(NULL, &dwi->empty_file,
+                                     NULL, svn_io_file_del_on_pool_cleanup,
+                                     dwi->pool, scratch_pool));
+
+  nd.rev1 = left_source->revision;
+  nd.rev2 = DIFF_REVNUM_NONEXISTENT;
+  nd.show_content = (left_file != NULL);
+  nd.tmpfile1 = left_file;
+  nd.tmpfile2 = dwi->empty_file;
+  nd.operation = svn_diff_op_deleted;
+  nd.force_diff = FALSE;
+  nd.copyfrom_path = NULL;
+  nd.copyfrom_rev = SVN_INVALID_REVNUM;
+  nd.left_props = left_props;
+  nd.right_props = NULL;
+
+  if (left_props && apr_hash_count(left_props))
+    {
+      apr_array_header_t *prop_changes;
 
-          SVN_ERR(diff_props_changed(relpath,
-                                     left_source->revision,
-                                     DIFF_REVNUM_NONEXISTENT,
-                                     prop_changes,
-                                     left_props, NULL,
-                                     ! wrote_header, dwi, scratch_pool));
-        }
+      SVN_ERR(svn_prop_diffs(&prop_changes, apr_hash_make(scratch_pool),
+                             left_props, scratch_pool));
+      nd.prop_changes = prop_changes;
     }
 
-  return SVN_NO_ERROR;
+  return svn_error_trace(process_node_diff(&nd, dwi, scratch_pool));
 }
 
 /* An svn_wc_diff_callbacks4_t function. */
@@ -1333,17 +1970,16 @@ diff_dir_changed(const char *relpath,
                  apr_pool_t *scratch_pool)
 {
   diff_writer_info_t *dwi = processor->baton;
+  node_diff_t nd = { 0 };
 
-  SVN_ERR(diff_props_changed(relpath,
-                             left_source->revision,
-                             right_source->revision,
-                             prop_changes,
-                             left_props, right_props,
-                             TRUE /* show_diff_header */,
-                             dwi,
-                             scratch_pool));
+  nd.relpath = relpath;
+  nd.rev1 = left_source->revision;
+  nd.rev2 = right_source->revision;
+  nd.left_props = left_props;
+  nd.right_props = right_props;
+  nd.prop_changes = prop_changes;
 
-  return SVN_NO_ERROR;
+  return svn_error_trace(process_node_diff(&nd, dwi, scratch_pool));
 }
 
 /* An svn_diff_tree_processor_t callback. */
@@ -1358,6 +1994,7 @@ diff_dir_added(const char *relpath,
                apr_pool_t *scratch_pool)
 {
   diff_writer_info_t *dwi = processor->baton;
+  node_diff_t nd = { 0 };
   apr_hash_t *left_props;
   apr_array_header_t *prop_changes;
 
@@ -1378,15 +2015,15 @@ diff_dir_added(const char *relpath,
   SVN_ERR(svn_prop_diffs(&prop_changes, right_props, left_props,
                          scratch_pool));
 
-  return svn_error_trace(diff_props_changed(relpath,
-                                            copyfrom_source ? copyfrom_source->revision
-                                                            : DIFF_REVNUM_NONEXISTENT,
-                                            right_source->revision,
-                                            prop_changes,
-                                            left_props, right_props,
-                                            TRUE /* show_diff_header */,
-                                            dwi,
-                                            scratch_pool));
+  nd.relpath = relpath;
+  nd.rev1 = copyfrom_source ? copyfrom_source->revision
+                            : DIFF_REVNUM_NONEXISTENT;
+  nd.rev2 = right_source->revision;
+  nd.left_props = left_props;
+  nd.right_props = right_props;
+  nd.prop_changes = prop_changes;
+
+  return svn_error_trace(process_node_diff(&nd, dwi, scratch_pool));
 }
 
 /* An svn_diff_tree_processor_t callback. */
@@ -1399,6 +2036,7 @@ diff_dir_deleted(const char *relpath,
                  apr_pool_t *scratch_pool)
 {
   diff_writer_info_t *dwi = processor->baton;
+  node_diff_t nd = { 0 };
   apr_array_header_t *prop_changes;
   apr_hash_t *right_props;
 
@@ -1409,16 +2047,14 @@ diff_dir_deleted(const char *relpath,
   SVN_ERR(svn_prop_diffs(&prop_changes, right_props,
                          left_props, scratch_pool));
 
-  SVN_ERR(diff_props_changed(relpath,
-                             left_source->revision,
-                             DIFF_REVNUM_NONEXISTENT,
-                             prop_changes,
-                             left_props, right_props,
-                             TRUE /* show_diff_header */,
-                             dwi,
-                             scratch_pool));
+  nd.relpath = relpath;
+  nd.rev1 = left_source->revision;
+  nd.rev2 = DIFF_REVNUM_NONEXISTENT;
+  nd.left_props = left_props;
+  nd.right_props = right_props;
+  nd.prop_changes = prop_changes;
 
-  return SVN_NO_ERROR;
+  return svn_error_trace(process_node_diff(&nd, dwi, scratch_pool));
 }
 
 /*-----------------------------------------------------------------*/
@@ -2631,12 +3267,12 @@ create_diff_writer_info(diff_writer_info_t *dwi,
   return SVN_NO_ERROR;
 }
 
-/* Set up *DIFF_PROCESSOR and *DDI for normal and git-style diffs (but not
- * summary diffs).
+/* Set up *DIFF_PROCESSOR and its diff writer *DWI_P for normal and
+ * git-style diffs (but not summary diffs).
  */
 static svn_error_t *
 get_diff_processor(svn_diff_tree_processor_t **diff_processor,
-                   struct diff_driver_info_t **ddi,
+                   diff_writer_info_t **dwi_p,
                    const apr_array_header_t *options,
                    const char *relative_to_dir,
                    svn_boolean_t no_diff_added,
@@ -2693,7 +3329,7 @@ get_diff_processor(svn_diff_tree_processor_t **diff_processor,
   processor->file_deleted = diff_file_deleted;
 
   *diff_processor = processor;
-  *ddi = &dwi->ddi;
+  *dwi_p = dwi;
   return SVN_NO_ERROR;
 }
 
@@ -2718,9 +3354,9 @@ svn_client__get_diff_writer_svn(
                 svn_client_ctx_t *ctx,
                 apr_pool_t *pool)
 {
-  struct diff_driver_info_t *ddi;
+  diff_writer_info_t *dwi;
 
-  SVN_ERR(get_diff_processor(diff_processor, &ddi,
+  SVN_ERR(get_diff_processor(diff_processor, &dwi,
                              options,
                              relative_to_dir,
                              no_diff_added,
@@ -2734,9 +3370,9 @@ svn_client__get_diff_writer_svn(
                              header_encoding,
                              outstream, errstream,
                              ctx, pool));
-  ddi->anchor = anchor;
-  ddi->orig_path_1 = orig_path_1;
-  ddi->orig_path_2 = orig_path_2;
+  dwi->ddi.anchor = anchor;
+  dwi->ddi.orig_path_1 = orig_path_1;
+  dwi->ddi.orig_path_2 = orig_path_2;
   return SVN_NO_ERROR;
 }
 
@@ -2802,7 +3438,8 @@ svn_client_diff7(const apr_array_header_t *options,
 {
   svn_opt_revision_t peg_revision;
   svn_diff_tree_processor_t *diff_processor;
-  struct diff_driver_info_t *ddi;
+  diff_writer_info_t *dwi;
+  svn_error_t *err;
 
   if (ignore_properties && properties_only)
     return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
@@ -2816,7 +3453,7 @@ svn_client_diff7(const apr_array_header_t *options,
   if (show_copies_as_adds || use_git_diff_format)
     ignore_ancestry = FALSE;
 
-  SVN_ERR(get_diff_processor(&diff_processor, &ddi,
+  SVN_ERR(get_diff_processor(&diff_processor, &dwi,
                              options,
                              relative_to_dir,
                              no_diff_added,
@@ -2830,14 +3467,17 @@ svn_client_diff7(const apr_array_header_t *options,
                              header_encoding,
                              outstream, errstream,
                              ctx, pool));
+  SVN_ERR(start_diff_workers(dwi));
 
-  return svn_error_trace(do_diff(ddi,
-                                 path_or_url1, path_or_url2,
-                                 revision1, revision2,
-                                 &peg_revision, TRUE /* no_peg_revision */,
-                                 depth, ignore_ancestry, changelists,
-                                 TRUE /* text_deltas */,
-                                 diff_processor, ctx, pool, pool));
+  err = do_diff(&dwi->ddi,
+                path_or_url1, path_or_url2,
+                revision1, revision2,
+                &peg_revision, TRUE /* no_peg_revision */,
+                depth, ignore_ancestry, changelists,
+                TRUE /* text_deltas */,
+                diff_processor, ctx, pool, pool);
+
+  return svn_error_trace(finish_diff_workers(dwi, err));
 }
 
 svn_error_t *
@@ -2865,7 +3505,8 @@ svn_client_diff_peg7(const apr_array_header_t *options,
                      apr_pool_t *pool)
 {
   svn_diff_tree_processor_t *diff_processor;
-  struct diff_driver_info_t *ddi;
+  diff_writer_info_t *dwi;
+  svn_error_t *err;
 
   if (ignore_properties && properties_only)
     return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
@@ -2876,7 +3517,7 @@ svn_client_diff_peg7(const apr_array_header_t *options,
   if (show_copies_as_adds || use_git_diff_format)
     ignore_ancestry = FALSE;
 
-  SVN_ERR(get_diff_processor(&diff_processor, &ddi,
+  SVN_ERR(get_diff_processor(&diff_processor, &dwi,
                              options,
                              relative_to_dir,
                              no_diff_added,
@@ -2890,14 +3531,17 @@ svn_client_diff_peg7(const apr_array_header_t *options,
                              header_encoding,
                              outstream, errstream,
                              ctx, pool));
+  SVN_ERR(start_diff_workers(dwi));
 
-  return svn_error_trace(do_diff(ddi,
-                                 path_or_url, path_or_url,
-                                 start_revision, end_revision,
-                                 peg_revision, FALSE /* no_peg_revision */,
-                                 depth, ignore_ancestry, changelists,
-                                 TRUE /* text_deltas */,
-                                 diff_processor, ctx, pool, pool));
+  err = do_diff(&dwi->ddi,
+                path_or_url, path_or_url,
+                start_revision, end_revision,
+                peg_revision, FALSE /* no_peg_revision */,
+                depth, ignore_ancestry, changelists,
+                TRUE /* text_deltas */,
+                diff_processor, ctx, pool, pool);
+
+  return svn_error_trace(finish_diff_workers(dwi, err));
 }
 
 svn_error_t *
@@ -29,6 +29,7 @@
 
 #include <apr_file_io.h>
 #include <apr_md5.h>
+#include <apr_thread_proc.h>
 #include "svn_types.h"
 #include "svn_client.h"
 #include "svn_string.h"
@@ -40,17 +41,25 @@
 #include "svn_subst.h"
 #include "svn_time.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
 #include "client.h"
 
 #include "svn_private_config.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_delta_private.h"
+#include "private/svn_mutex.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_thread_cond.h"
 #include "private/svn_wc_private.h"
 
 #ifndef ENABLE_EV2_IMPL
 #define ENABLE_EV2_IMPL 0
 #endif
 
+/* Number of worker threads fetching and writing files when exporting
+   a directory from a file:// URL. */
+#define EXPORT_WORKER_COUNT 4
+
 
 /*** Code. ***/
 
@@ -581,19 +590,13 @@ open_root(void *edit_baton,
 }
 
 
-/* Ensure the directory exists, and send feedback. */
+/* Create the directory FULL_PATH for EB.  An existing directory is only
+   acceptable if EB allows overwriting. */
 static svn_error_t *
-add_directory(const char *path,
-              void *parent_baton,
-              const char *copyfrom_path,
-              svn_revnum_t copyfrom_revision,
-              apr_pool_t *pool,
-              void **baton)
+make_directory(const char *full_path,
+               struct edit_baton *eb,
+               apr_pool_t *pool)
 {
-  struct dir_baton *pb = parent_baton;
-  struct dir_baton *db = apr_pcalloc(pool, sizeof(*db));
-  struct edit_baton *eb = pb->edit_baton;
-  const char *full_path = svn_dirent_join(eb->root_path, path, pool);
   svn_node_kind_t kind;
 
   SVN_ERR(svn_io_check_path(full_path, &kind, pool));
@@ -608,6 +611,25 @@ add_directory(const char *path,
                              _("'%s' already exists"),
                              svn_dirent_local_style(full_path, pool));
 
+  return SVN_NO_ERROR;
+}
+
+/* Ensure the directory exists, and send feedback. */
+static svn_error_t *
+add_directory(const char *path,
+              void *parent_baton,
+              const char *copyfrom_path,
+              svn_revnum_t copyfrom_revision,
+              apr_pool_t *pool,
+              void **baton)
+{
+  struct dir_baton *pb = parent_baton;
+  struct dir_baton *db = apr_pcalloc(pool, sizeof(*db));
+  struct edit_baton *eb = pb->edit_baton;
+  const char *full_path = svn_dirent_join(eb->root_path, path, pool);
+
+  SVN_ERR(make_directory(full_path, eb, pool));
+
   if (eb->notify_func)
     {
       svn_wc_notify_t *notify = svn_wc_create_notify(full_path,
@@ -807,6 +829,23 @@ change_dir_prop(void *dir_baton,
 }
 
 
+/* Move the file written by FB->FILE_WRITER into place at FB->PATH. */
+static svn_error_t *
+install_file(struct file_baton *fb,
+             apr_pool_t *scratch_pool)
+{
+  const char *target_abspath;
+
+  SVN_ERR(svn_dirent_get_absolute(&target_abspath, fb->path, scratch_pool));
+
+  SVN_ERR(svn_wc__working_file_writer_finalize(NULL, NULL, fb->file_writer,
+                                               scratch_pool));
+  SVN_ERR(svn_wc__working_file_writer_install(fb->file_writer, target_abspath,
+                                              scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Install the file, and send feedback. */
 static svn_error_t *
 close_file(void *file_baton,
@@ -816,7 +855,6 @@ close_file(void *file_baton,
   struct file_baton *fb = file_baton;
   svn_checksum_t *text_checksum;
   svn_checksum_t *actual_checksum;
-  const char *target_abspath;
 
   /* Was a txdelta even sent? */
   if (! fb->file_writer)
@@ -834,12 +872,7 @@ close_file(void *file_baton,
                                      _("Checksum mismatch for '%s'"),
                                      svn_dirent_local_style(fb->path, pool));
 
-  SVN_ERR(svn_dirent_get_absolute(&target_abspath, fb->path, pool));
-
-  SVN_ERR(svn_wc__working_file_writer_finalize(NULL, NULL, fb->file_writer,
-                                               pool));
-  SVN_ERR(svn_wc__working_file_writer_install(fb->file_writer, target_abspath,
-                                              pool));
+  SVN_ERR(install_file(fb, pool));
 
   if (fb->edit_baton->notify_func)
     {
@@ -1187,6 +1220,44 @@ export_file_ev2(const char *from_url,
   return SVN_NO_ERROR;
 }
 
+/* Write the contents of the file at RELPATH in REVISION, as read through
+ * RA_SESSION, to a temporary file for FB, translated as its properties
+ * PROPS dictate.  FB must have been set up like add_file() does.  The
+ * caller still has to install the file.
+ */
+static svn_error_t *
+fetch_file(struct file_baton *fb,
+           svn_ra_session_t *ra_session,
+           const char *relpath,
+           svn_revnum_t revision,
+           apr_hash_t *props,
+           apr_pool_t *scratch_pool)
+{
+  apr_hash_index_t *hi;
+  svn_stream_t *stream;
+
+  /* Push the props into change_file_prop(), to update the file_baton
+   * with information. */
+  for (hi = apr_hash_first(scratch_pool, props); hi; hi = apr_hash_next(hi))
+    {
+      const char *propname = apr_hash_this_key(hi);
+      const svn_string_t *propval = apr_hash_this_val(hi);
+
+      SVN_ERR(change_file_prop(fb, propname, propval, scratch_pool));
+    }
+
+  /* Step outside the editor-likeness for a moment, to open the file writer
+   * and to actually talk to the repository. */
+  SVN_ERR(open_working_file_writer(&fb->file_writer, fb, fb->pool,
+                                   scratch_pool));
+  stream = svn_wc__working_file_writer_get_stream(fb->file_writer);
+  SVN_ERR(svn_ra_get_file(ra_session, relpath, revision, stream, NULL, NULL,
+                          scratch_pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 export_file(const char *from_url,
             const char *to_path,
@@ -1196,11 +1267,9 @@ export_file(const char *from_url,
             apr_pool_t *scratch_pool)
 {
   apr_hash_t *props;
-  apr_hash_index_t *hi;
   struct file_baton *fb = apr_pcalloc(scratch_pool, sizeof(*fb));
   svn_node_kind_t to_kind;
   svn_revnum_t target_rev;
-  svn_stream_t *stream;
 
   SVN_ERR_ASSERT(svn_path_is_url(from_url));
 
@@ -1255,27 +1324,619 @@ export_file(const char *from_url,
                               &target_rev, &props, scratch_pool));
     }
 
-  /* Push the props into change_file_prop(), to update the file_baton
-   * with information. */
-  for (hi = apr_hash_first(scratch_pool, props); hi; hi = apr_hash_next(hi))
+  SVN_ERR(fetch_file(fb, ra_session, "", target_rev, props, scratch_pool));
+
+  /* And now just use close_file() to put the file into place. */
+  SVN_ERR(close_file(fb, NULL, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/*** Exporting from file:// URLs in worker threads. ***/
+
+/* With ra_local, the update editor gets driven on the calling thread,
+ * which reconstructs and writes one file after the other.  For local
+ * repositories, we rather walk the tree ourselves and let a few worker
+ * threads fetch and install the files, each through its own RA session
+ * and thus its own FS instance.  Directories get created by the walking
+ * thread before any of their files are queued.  Notifications are sent
+ * by the walking thread, strictly in tree order.
+ */
+
+#if APR_HAS_THREADS
+
+/* A directory or file to export and the result of doing so. */
+typedef struct export_job_t
+{
+  /* Next job to be notified about. */
+  struct export_job_t *next;
+
+  /* Next job to be picked up by a worker. */
+  struct export_job_t *next_queued;
+
+  /* All data of this job lives in this pool.  It uses its own allocator
+     because it gets filled by a worker and destroyed by the walker. */
+  apr_pool_t *pool;
+
+  /* Path of the node relative to the export root, its kind and the path
+     to write it to. */
+  const char *relpath;
+  svn_node_kind_t kind;
+  const char *path;
+
+  /* Error returned when exporting the node.  Only valid if DONE is set. */
+  svn_error_t *err;
+
+  /* Set once the job has been processed. */
+  svn_boolean_t done;
+} export_job_t;
+
+/* A worker thread and its private RA session. */
+typedef struct export_worker_t
+{
+  /* The workers that this one belongs to. */
+  struct export_workers_t *workers;
+
+  /* Session to read file contents from.  Lives in POOL. */
+  svn_ra_session_t *ra_session;
+
+  /* Pool used by this worker only, with its own allocator. */
+  apr_pool_t *pool;
+
+  /* The thread running this worker.  NULL if it has not been started. */
+  apr_thread_t *thread;
+} export_worker_t;
+
+/* The workers of a directory export and the jobs in flight. */
+typedef struct export_workers_t
+{
+  /* Export parameters, read-only. */
+  struct edit_baton *eb;
+  svn_revnum_t revision;
+
+  /* Worker threads, started when the first file gets queued. */
+  export_worker_t *workers;
+  int worker_count;
+  int workers_started;
+  apr_pool_t *thread_pool;
+
+  /* Serializes access to all members below. */
+  svn_mutex__t *mutex;
+
+  /* Signaled when a job has been queued or the workers shall exit. */
+  svn_thread_cond__t *job_queued;
+
+  /* Signaled when a worker finished a job. */
+  svn_thread_cond__t *job_done;
+
+  /* Jobs not notified, yet, in tree order.  These are only ever modified
+     by the walking thread. */
+  export_job_t *first;
+  export_job_t *last;
+  int pending;
+
+  /* Jobs not picked up by any worker, yet, in tree order. */
+  export_job_t *first_queued;
+  export_job_t *last_queued;
+
+  /* Set when the workers shall terminate. */
+  svn_boolean_t shutdown;
+} export_workers_t;
+
+/* Fetch the file described by JOB for WORKERS through RA_SESSION and
+   install it. */
+static svn_error_t *
+export_file_job(export_job_t *job,
+                export_workers_t *workers,
+                svn_ra_session_t *ra_session)
+{
+  struct edit_baton *eb = workers->eb;
+  struct file_baton *fb = apr_pcalloc(job->pool, sizeof(*fb));
+  apr_hash_t *props;
+
+  /* This is the equivalent of add_file(). */
+  fb->edit_baton = eb;
+  fb->path = job->path;
+  fb->url = svn_path_url_add_component2(eb->root_url, job->relpath,
+                                        job->pool);
+  fb->repos_root_url = eb->repos_root_url;
+  fb->pool = job->pool;
+
+  SVN_ERR(svn_ra_get_file(ra_session, job->relpath, workers->revision,
+                          NULL, NULL, &props, job->pool));
+  SVN_ERR(fetch_file(fb, ra_session, job->relpath, workers->revision,
+                     props, job->pool));
+
+  return svn_error_trace(install_file(fb, job->pool));
+}
+
+/* Take the next job from the queue in WORKERS and return it in *JOB.
+   Block while the queue is empty.  Set *JOB to NULL after WORKERS has
+   been shut down.
+
+   This function must be called with WORKERS->MUTEX acquired. */
+static svn_error_t *
+take_export_job(export_job_t **job,
+                export_workers_t *workers)
+{
+  while (workers->first_queued == NULL && !workers->shutdown)
+    SVN_ERR(svn_thread_cond__wait(workers->job_queued, workers->mutex));
+
+  *job = workers->shutdown ? NULL : workers->first_queued;
+  if (*job)
     {
-      const char *propname = apr_hash_this_key(hi);
-      const svn_string_t *propval = apr_hash_this_val(hi);
+      workers->first_queued = (*job)->next_queued;
+      if (workers->first_queued == NULL)
+        workers->last_queued = NULL;
+    }
 
-      SVN_ERR(change_file_prop(fb, propname, propval, scratch_pool));
+  return SVN_NO_ERROR;
+}
+
+/* Mark JOB in WORKERS as processed and wake up the walker.
+
+   This function must be called with WORKERS->MUTEX acquired. */
+static svn_error_t *
+finish_export_job(export_workers_t *workers,
+                  export_job_t *job)
+{
+  job->done = TRUE;
+  return svn_thread_cond__broadcast(workers->job_done);
+}
+
+/* Worker loop: process queued jobs of WORKER until it gets shut down. */
+static svn_error_t *
+run_export_worker(export_worker_t *worker)
+{
+  export_workers_t *workers = worker->workers;
+
+  while (TRUE)
+    {
+      export_job_t *job;
+
+      SVN_MUTEX__WITH_LOCK(workers->mutex, take_export_job(&job, workers));
+      if (job == NULL)
+        break;
+
+      job->err = export_file_job(job, workers, worker->ra_session);
+      SVN_MUTEX__WITH_LOCK(workers->mutex, finish_export_job(workers, job));
     }
 
-  /* Step outside the editor-likeness for a moment, to open the file writer
-   * and to actually talk to the repository. */
-  SVN_ERR(open_working_file_writer(&fb->file_writer, fb, fb->pool,
-                                   scratch_pool));
-  stream = svn_wc__working_file_writer_get_stream(fb->file_writer);
-  SVN_ERR(svn_ra_get_file(ra_session, "", target_rev, stream, NULL, NULL,
+  return SVN_NO_ERROR;
+}
+
+/* The plain APR thread function running a worker.
+ * DATA is the export_worker_t object to run. */
+static void * APR_THREAD_FUNC
+export_worker_thread(apr_thread_t *thread, void *data)
+{
+  svn_error_t *err = run_export_worker(data);
+  apr_status_t result = APR_SUCCESS;
+
+  if (err)
+    {
+      result = err->apr_err;
+      svn_error_clear(err);
+    }
+
+  /* End thread explicitly to prevent APR_INCOMPLETE return codes in
+     apr_thread_join(). */
+  apr_thread_exit(thread, result);
+  return NULL;
+}
+
+/* Open the RA sessions for all workers of WORKERS that are not running,
+   yet, and start them.  Use CTX to open the sessions.
+
+   This must only be called by the walking thread. */
+static svn_error_t *
+start_export_workers(export_workers_t *workers,
+                     svn_client_ctx_t *ctx)
+{
+  /* The thread objects can't share the allocator with the walker. */
+  if (workers->thread_pool == NULL)
+    workers->thread_pool
+      = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+
+  while (workers->workers_started < workers->worker_count)
+    {
+      export_worker_t *worker = &workers->workers[workers->workers_started];
+      apr_status_t status;
+
+      worker->workers = workers;
+      worker->pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+      SVN_ERR(svn_client_open_ra_session2(&worker->ra_session,
+                                          workers->eb->root_url, NULL, ctx,
+                                          worker->pool, worker->pool));
+
+      status = apr_thread_create(&worker->thread, NULL, export_worker_thread,
+                                 worker, workers->thread_pool);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't create export thread"));
+
+      ++workers->workers_started;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Append JOB to the list of pending jobs in WORKERS.  Unless JOB has
+   already been processed, queue it for the workers as well.
+
+   This function must be called with WORKERS->MUTEX acquired. */
+static svn_error_t *
+queue_export_job(export_workers_t *workers,
+                 export_job_t *job)
+{
+  if (workers->last)
+    workers->last->next = job;
+  else
+    workers->first = job;
+  workers->last = job;
+  ++workers->pending;
+
+  if (job->done)
+    return SVN_NO_ERROR;
+
+  if (workers->last_queued)
+    workers->last_queued->next_queued = job;
+  else
+    workers->first_queued = job;
+  workers->last_queued = job;
+
+  return svn_thread_cond__signal(workers->job_queued);
+}
+
+/* If the first job in WORKERS has not been picked up by any worker, yet,
+   remove it from the queue and return it in *JOB.  Set *JOB to NULL
+   otherwise.
+
+   This function must be called with WORKERS->MUTEX acquired. */
+static svn_error_t *
+claim_first_export_job(export_job_t **job,
+                       export_workers_t *workers)
+{
+  *job = NULL;
+  if (workers->first && workers->first == workers->first_queued)
+    {
+      *job = workers->first;
+      workers->first_queued = (*job)->next_queued;
+      if (workers->first_queued == NULL)
+        workers->last_queued = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove the first job from the list of pending jobs in WORKERS and
+   return it in *JOB, if it has been processed.  If WAIT is set, block
+   until that is the case.  Set *JOB to NULL if there are no pending jobs
+   or if the first one is still being processed and WAIT is not set.
+
+   This function must be called with WORKERS->MUTEX acquired. */
+static svn_error_t *
+next_finished_export_job(export_job_t **job,
+                         export_workers_t *workers,
+                         svn_boolean_t wait)
+{
+  export_job_t *head = workers->first;
+
+  *job = NULL;
+  if (head == NULL)
+    return SVN_NO_ERROR;
+
+  while (!head->done && wait)
+    SVN_ERR(svn_thread_cond__wait(workers->job_done, workers->mutex));
+
+  if (head->done)
+    {
+      workers->first = head->next;
+      if (workers->first == NULL)
+        workers->last = NULL;
+      --workers->pending;
+
+      *job = head;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Send the notification for JOB in WORKERS, unless exporting it failed,
+   and release JOB. */
+static svn_error_t *
+notify_export_job(export_workers_t *workers,
+                  export_job_t *job)
+{
+  svn_error_t *err = job->err;
+  struct edit_baton *eb = workers->eb;
+
+  if (!err && eb->notify_func)
+    {
+      svn_wc_notify_t *notify = svn_wc_create_notify(job->path,
+                                                     svn_wc_notify_update_add,
+                                                     job->pool);
+      notify->kind = job->kind;
+      (*eb->notify_func)(eb->notify_baton, notify, job->pool);
+    }
+
+  svn_pool_destroy(job->pool);
+  return svn_error_trace(err);
+}
+
+/* Notify about all jobs that have been processed in WORKERS.  If WAIT is
+   set, block until the first job has been processed.  If DRAIN is set,
+   notify about all jobs and help processing them through RA_SESSION. */
+static svn_error_t *
+notify_finished_export_jobs(export_workers_t *workers,
+                            svn_ra_session_t *ra_session,
+                            svn_boolean_t wait,
+                            svn_boolean_t drain)
+{
+  while (TRUE)
+    {
+      export_job_t *job;
+
+      /* Don't wait for a worker to pick up the job we need next. */
+      if (drain)
+        {
+          SVN_MUTEX__WITH_LOCK(workers->mutex,
+                               claim_first_export_job(&job, workers));
+          if (job)
+            {
+              /* No one else will access JOB anymore. */
+              job->err = export_file_job(job, workers, ra_session);
+              job->done = TRUE;
+            }
+        }
+
+      SVN_MUTEX__WITH_LOCK(workers->mutex,
+                           next_finished_export_job(&job, workers,
+                                                    wait || drain));
+      if (job == NULL)
+        break;
+
+      SVN_ERR(notify_export_job(workers, job));
+      wait = FALSE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Tell the threads of WORKERS to terminate.
+
+   This function must be called with WORKERS->MUTEX acquired. */
+static svn_error_t *
+request_export_workers_shutdown(export_workers_t *workers)
+{
+  workers->shutdown = TRUE;
+  return svn_thread_cond__broadcast(workers->job_queued);
+}
+
+/* Pool cleanup function terminating the threads of the export_workers_t
+   given as BATON and releasing all jobs that have not been notified. */
+static apr_status_t
+cleanup_export_workers(void *baton)
+{
+  export_workers_t *workers = baton;
+  svn_error_t *err = svn_mutex__lock(workers->mutex);
+  int i;
+
+  if (!err)
+    err = svn_mutex__unlock(workers->mutex,
+                            request_export_workers_shutdown(workers));
+  svn_error_clear(err);
+
+  for (i = 0; i < workers->workers_started; ++i)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, workers->workers[i].thread);
+    }
+
+  /* Sessions of workers that failed to start need cleaning up, too. */
+  for (i = 0; i < workers->worker_count; ++i)
+    if (workers->workers[i].pool)
+      {
+        svn_pool_destroy(workers->workers[i].pool);
+        workers->workers[i].pool = NULL;
+      }
+  workers->workers_started = 0;
+
+  while (workers->first)
+    {
+      export_job_t *job = workers->first;
+      workers->first = job->next;
+
+      svn_error_clear(job->err);
+      svn_pool_destroy(job->pool);
+    }
+  workers->last = NULL;
+
+  if (workers->thread_pool)
+    {
+      svn_pool_destroy(workers->thread_pool);
+      workers->thread_pool = NULL;
+    }
+
+  return APR_SUCCESS;
+}
+
+/* Add a job for the node of KIND at RELPATH to WORKERS.  Directories are
+   created right away.  Files get queued for the workers, which will be
+   started through CTX if necessary.  Throttle the walk through RA_SESSION
+   if too many jobs are pending. */
+static svn_error_t *
+add_export_job(export_workers_t *workers,
+               const char *relpath,
+               svn_node_kind_t kind,
+               svn_ra_session_t *ra_session,
+               svn_client_ctx_t *ctx,
+               apr_pool_t *scratch_pool)
+{
+  apr_pool_t *pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  export_job_t *job = apr_pcalloc(pool, sizeof(*job));
+  svn_error_t *err;
+
+  job->pool = pool;
+  job->relpath = apr_pstrdup(pool, relpath);
+  job->kind = kind;
+  job->path = svn_dirent_join(workers->eb->root_path, relpath, pool);
+
+  if (kind == svn_node_dir)
+    {
+      job->err = make_directory(job->path, workers->eb, scratch_pool);
+      job->done = TRUE;
+    }
+  else
+    {
+      err = start_export_workers(workers, ctx);
+      if (err)
+        {
+          svn_pool_destroy(pool);
+          return svn_error_trace(err);
+        }
+    }
+
+  SVN_MUTEX__WITH_LOCK(workers->mutex, queue_export_job(workers, job));
+
+  /* Don't let the walk get too far ahead of the workers. */
+  return svn_error_trace(notify_finished_export_jobs(
+                            workers, ra_session,
+                            workers->pending > 4 * workers->worker_count,
+                            FALSE));
+}
+
+/* Add jobs for the contents of the directory RELPATH in WORKERS, up to
+   DEPTH, reading the tree through RA_SESSION.  Add the svn:externals
+   definitions found on the way to WORKERS->EB->EXTERNALS.  Start workers
+   through CTX as needed. */
+static svn_error_t *
+walk_export_tree(export_workers_t *workers,
+                 const char *relpath,
+                 svn_depth_t depth,
+                 svn_ra_session_t *ra_session,
+                 svn_client_ctx_t *ctx,
+                 apr_pool_t *scratch_pool)
+{
+  apr_hash_t *dirents;
+  apr_hash_t *props;
+  const svn_string_t *externals;
+  apr_array_header_t *sorted;
+  apr_pool_t *iterpool;
+  int i;
+
+  if (ctx->cancel_func)
+    SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
+
+  SVN_ERR(svn_ra_get_dir2(ra_session, &dirents, NULL, &props, relpath,
+                          workers->revision, SVN_DIRENT_KIND,
                           scratch_pool));
-  SVN_ERR(svn_stream_close(stream));
 
-  /* And now just use close_file() to put the file into place. */
-  SVN_ERR(close_file(fb, NULL, scratch_pool));
+  externals = svn_hash_gets(props, SVN_PROP_EXTERNALS);
+  if (externals)
+    SVN_ERR(add_externals(workers->eb->externals,
+                          svn_dirent_join(workers->eb->root_path, relpath,
+                                          scratch_pool),
+                          externals));
+
+  if (depth == svn_depth_empty)
+    return SVN_NO_ERROR;
+
+  iterpool = svn_pool_create(scratch_pool);
+  sorted = svn_sort__hash(dirents, svn_sort_compare_items_lexically,
+                          scratch_pool);
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      const svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i,
+                                                    svn_sort__item_t);
+      const svn_dirent_t *dirent = item->value;
+      const char *child_relpath;
+
+      if (dirent->kind == svn_node_dir && depth == svn_depth_files)
+        continue;
+
+      svn_pool_clear(iterpool);
+      child_relpath = svn_relpath_join(relpath, item->key, iterpool);
+      SVN_ERR(add_export_job(workers, child_relpath, dirent->kind,
+                             ra_session, ctx, iterpool));
+
+      if (dirent->kind == svn_node_dir)
+        SVN_ERR(walk_export_tree(workers, child_relpath,
+                                 depth == svn_depth_infinity
+                                   ? svn_depth_infinity
+                                   : svn_depth_empty,
+                                 ra_session, ctx, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Export the tree at the root of RA_SESSION in REVISION down to DEPTH
+   as described by EB, with the files being fetched and written by
+   worker threads.  The export root must already exist.  Use CTX to open
+   further RA sessions to the same URL. */
+static svn_error_t *
+export_tree_in_parallel(struct edit_baton *eb,
+                        svn_revnum_t revision,
+                        svn_ra_session_t *ra_session,
+                        svn_depth_t depth,
+                        svn_client_ctx_t *ctx,
+                        apr_pool_t *scratch_pool)
+{
+  export_workers_t *workers = apr_pcalloc(scratch_pool, sizeof(*workers));
+  svn_error_t *err;
+
+  workers->eb = eb;
+  workers->revision = revision;
+  workers->worker_count = EXPORT_WORKER_COUNT;
+  workers->workers = apr_pcalloc(scratch_pool,
+                                 workers->worker_count
+                                   * sizeof(*workers->workers));
+  SVN_ERR(svn_mutex__init(&workers->mutex, TRUE, scratch_pool));
+  SVN_ERR(svn_thread_cond__create(&workers->job_queued, scratch_pool));
+  SVN_ERR(svn_thread_cond__create(&workers->job_done, scratch_pool));
+  apr_pool_cleanup_register(scratch_pool, workers, cleanup_export_workers,
+                            apr_pool_cleanup_null);
+
+  err = walk_export_tree(workers, "", depth, ra_session, ctx, scratch_pool);
+  if (!err)
+    err = notify_finished_export_jobs(workers, ra_session, TRUE, TRUE);
+
+  /* Terminate the threads before our caller continues with the
+     externals. */
+  apr_pool_cleanup_run(scratch_pool, workers, cleanup_export_workers);
+
+  return svn_error_trace(err);
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Export the externals collected in EB for the directory export of
+   FROM_URL to TO_PATH, unless IGNORE_EXTERNALS is set or DEPTH is not
+   infinity.  The other parameters are as for export_directory(). */
+static svn_error_t *
+export_externals(struct edit_baton *eb,
+                 const char *from_url,
+                 const char *to_path,
+                 svn_boolean_t ignore_externals,
+                 svn_boolean_t ignore_keywords,
+                 svn_depth_t depth,
+                 const char *native_eol,
+                 svn_client_ctx_t *ctx,
+                 apr_pool_t *scratch_pool)
+{
+  if (! ignore_externals && depth == svn_depth_infinity)
+    {
+      const char *to_abspath;
+
+      SVN_ERR(svn_dirent_get_absolute(&to_abspath, to_path, scratch_pool));
+      SVN_ERR(svn_client__export_externals(eb->externals,
+                                           from_url,
+                                           to_abspath, eb->repos_root_url,
+                                           depth, native_eol,
+                                           ignore_keywords,
+                                           ctx, scratch_pool));
+    }
 
   return SVN_NO_ERROR;
 }
@@ -1301,6 +1962,25 @@ export_directory(const char *from_url,
 
   SVN_ERR_ASSERT(svn_path_is_url(from_url));
 
+#if APR_HAS_THREADS
+  /* Local repositories are cheap to open more than once, so let several
+     threads reconstruct and write the files. */
+  if (!ENABLE_EV2_IMPL && strncmp(loc->url, "file://", 7) == 0)
+    {
+      SVN_ERR(open_root_internal(to_path, eb->overwrite, eb->notify_func,
+                                 eb->notify_baton, scratch_pool));
+      *eb->target_revision = loc->rev;
+      SVN_ERR(export_tree_in_parallel(eb, loc->rev, ra_session, depth, ctx,
+                                      scratch_pool));
+
+      return svn_error_trace(export_externals(eb, from_url, to_path,
+                                              ignore_externals,
+                                              ignore_keywords, depth,
+                                              native_eol, ctx,
+                                              scratch_pool));
+    }
+#endif
+
   if (!ENABLE_EV2_IMPL)
     SVN_ERR(get_editor_ev1(&export_editor, &edit_baton, eb, ctx,
                            scratch_pool, scratch_pool));
@@ -1343,20 +2023,10 @@ export_directory(const char *from_url,
             (to_path, eb->overwrite, ctx->notify_func2,
              ctx->notify_baton2, scratch_pool));
 
-  if (! ignore_externals && depth == svn_depth_infinity)
-    {
-      const char *to_abspath;
-
-      SVN_ERR(svn_dirent_get_absolute(&to_abspath, to_path, scratch_pool));
-      SVN_ERR(svn_client__export_externals(eb->externals,
-                                           from_url,
-                                           to_abspath, eb->repos_root_url,
-                                           depth, native_eol,
-                                           ignore_keywords,
-                                           ctx, scratch_pool));
-    }
-
-  return SVN_NO_ERROR;
+  return svn_error_trace(export_externals(eb, from_url, to_path,
+                                          ignore_externals, ignore_keywords,
+                                          depth, native_eol, ctx,
+                                          scratch_pool));
 }
 
 
@@ -38,9 +38,12 @@
 #include "svn_path.h"
 #include "svn_props.h"
 #include "svn_config.h"
+#include "svn_sorts.h"
 #include "client.h"
 
 #include "svn_private_config.h"
+#include "private/svn_mutex.h"
+#include "private/svn_task.h"
 #include "private/svn_wc_private.h"
 
 
@@ -747,6 +750,12 @@ handle_external_item_removal(const svn_client_ctx_t *ctx,
   return svn_error_trace(err);
 }
 
+/* Bring the external NEW_ITEM defined on PARENT_DIR_ABSPATH up to date
+   at LOCAL_ABSPATH.
+
+   If DEFER_FILE is not NULL, only handle directory externals: set
+   *DEFER_FILE to TRUE and do nothing if NEW_ITEM turns out to be a file
+   external, and to FALSE otherwise. */
 static svn_error_t *
 handle_external_item_change(svn_client_ctx_t *ctx,
                             const char *repos_root_url,
@@ -757,6 +766,7 @@ handle_external_item_change(svn_client_ctx_t *ctx,
                             const svn_wc_external_item2_t *new_item,
                             svn_ra_session_t *ra_session,
                             svn_boolean_t *timestamp_sleep,
+                            svn_boolean_t *defer_file,
                             apr_pool_t *scratch_pool)
 {
   svn_client__pathrev_t *new_loc;
@@ -827,6 +837,14 @@ handle_external_item_change(svn_client_ctx_t *ctx,
                                "or a directory"),
                              new_loc->url, new_loc->rev);
 
+  /* File externals live in the defining working copy and need its
+     write lock. */
+  if (defer_file)
+    {
+      *defer_file = (ext_kind == svn_node_file);
+      if (*defer_file)
+        return SVN_NO_ERROR;
+    }
 
   /* Not protecting against recursive externals.  Detecting them in
      the global case is hard, and it should be pretty obvious to a
@@ -960,25 +978,50 @@ wrap_external_error(const svn_client_ctx_t *ctx,
   return err;
 }
 
+/* Default for SVN_CONFIG_OPTION_EXTERNALS_PARALLELISM. */
+#define EXTERNALS_DEFAULT_PARALLELISM 4
+
+/* Upper limit for SVN_CONFIG_OPTION_EXTERNALS_PARALLELISM, such that a
+   typo won't open hundreds of connections. */
+#define EXTERNALS_MAX_PARALLELISM 16
+
+/* A single external definition to bring up to date. */
+typedef struct external_job_t
+{
+  const char *repos_root_url;
+
+  /* The directory defining the external and its URL. */
+  const char *parent_dir_abspath;
+  const char *parent_dir_url;
+
+  const char *target_abspath;
+  const char *old_defining_abspath;
+  const svn_wc_external_item2_t *new_item;
+
+  /* Process this external in the thread driving the update, because its
+     target overlaps the one of another external. */
+  svn_boolean_t serial;
+} external_job_t;
+
+/* Append an external_job_t, allocated in RESULT_POOL, to JOBS for every
+   external defined in NEW_DESC_TEXT on LOCAL_ABSPATH and remove their
+   targets from OLD_EXTERNALS. */
 static svn_error_t *
-handle_externals_change(svn_client_ctx_t *ctx,
-                        const char *repos_root_url,
-                        svn_boolean_t *timestamp_sleep,
-                        const char *local_abspath,
-                        const char *new_desc_text,
-                        apr_hash_t *old_externals,
-                        svn_depth_t ambient_depth,
-                        svn_depth_t requested_depth,
-                        svn_ra_session_t *ra_session,
-                        apr_pool_t *scratch_pool)
+collect_externals_change(apr_array_header_t *jobs,
+                         svn_client_ctx_t *ctx,
+                         const char *repos_root_url,
+                         const char *local_abspath,
+                         const char *new_desc_text,
+                         apr_hash_t *old_externals,
+                         svn_depth_t ambient_depth,
+                         svn_depth_t requested_depth,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
 {
   apr_array_header_t *new_desc;
   int i;
-  apr_pool_t *iterpool;
   const char *url;
 
-  iterpool = svn_pool_create(scratch_pool);
-
   SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
 
   /* Bag out if the depth here is too shallow for externals action. */
@@ -991,32 +1034,29 @@ handle_externals_change(svn_client_ctx_t *ctx,
   if (new_desc_text)
     SVN_ERR(svn_wc_parse_externals_description3(&new_desc, local_abspath,
                                                 new_desc_text,
-                                                FALSE, scratch_pool));
+                                                FALSE, result_pool));
   else
     new_desc = NULL;
 
   SVN_ERR(svn_wc__node_get_url(&url, ctx->wc_ctx, local_abspath,
-                               scratch_pool, iterpool));
+                               result_pool, scratch_pool));
 
   SVN_ERR_ASSERT(url);
 
   for (i = 0; new_desc && (i < new_desc->nelts); i++)
     {
-      const char *old_defining_abspath;
-      svn_wc_external_item2_t *new_item;
-      const char *target_abspath;
+      external_job_t *job = apr_pcalloc(result_pool, sizeof(*job));
       svn_boolean_t under_root;
 
-      new_item = APR_ARRAY_IDX(new_desc, i, svn_wc_external_item2_t *);
-
-      svn_pool_clear(iterpool);
+      job->repos_root_url = repos_root_url;
+      job->parent_dir_abspath = local_abspath;
+      job->parent_dir_url = url;
+      job->new_item = APR_ARRAY_IDX(new_desc, i, svn_wc_external_item2_t *);
 
-      if (ctx->cancel_func)
-        SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
-
-      SVN_ERR(svn_dirent_is_under_root(&under_root, &target_abspath,
-                                       local_abspath, new_item->target_dir,
-                                       iterpool));
+      SVN_ERR(svn_dirent_is_under_root(&under_root, &job->target_abspath,
+                                       local_abspath,
+                                       job->new_item->target_dir,
+                                       result_pool));
 
       if (! under_root)
         {
@@ -1024,28 +1064,57 @@ handle_externals_change(svn_client_ctx_t *ctx,
                     SVN_ERR_WC_OBSTRUCTED_UPDATE, NULL,
                     _("Path '%s' is not in the working copy"),
                     svn_dirent_local_style(
-                        svn_dirent_join(local_abspath, new_item->target_dir,
-                                        iterpool),
-                        iterpool));
+                        svn_dirent_join(local_abspath,
+                                        job->new_item->target_dir,
+                                        scratch_pool),
+                        scratch_pool));
         }
 
-      old_defining_abspath = svn_hash_gets(old_externals, target_abspath);
+      job->old_defining_abspath = svn_hash_gets(old_externals,
+                                                job->target_abspath);
+
+      /* And remove the items to process from the to-remove hash */
+      if (job->old_defining_abspath)
+        svn_hash_sets(old_externals, job->target_abspath, NULL);
+
+      APR_ARRAY_PUSH(jobs, external_job_t *) = job;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Process the external_job_t * in JOBS one after another. */
+static svn_error_t *
+run_externals_serially(const apr_array_header_t *jobs,
+                       svn_boolean_t *timestamp_sleep,
+                       svn_ra_session_t *ra_session,
+                       svn_client_ctx_t *ctx,
+                       apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = 0; i < jobs->nelts; i++)
+    {
+      const external_job_t *job = APR_ARRAY_IDX(jobs, i, external_job_t *);
+
+      svn_pool_clear(iterpool);
+
+      if (ctx->cancel_func)
+        SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
 
       SVN_ERR(wrap_external_error(
-                      ctx, target_abspath,
+                      ctx, job->target_abspath,
                       handle_external_item_change(ctx,
-                                                  repos_root_url,
-                                                  local_abspath, url,
-                                                  target_abspath,
-                                                  old_defining_abspath,
-                                                  new_item, ra_session,
-                                                  timestamp_sleep,
+                                                  job->repos_root_url,
+                                                  job->parent_dir_abspath,
+                                                  job->parent_dir_url,
+                                                  job->target_abspath,
+                                                  job->old_defining_abspath,
+                                                  job->new_item, ra_session,
+                                                  timestamp_sleep, NULL,
                                                   iterpool),
                       iterpool));
-
-      /* And remove already processed items from the to-remove hash */
-      if (old_defining_abspath)
-        svn_hash_sets(old_externals, target_abspath, NULL);
     }
 
   svn_pool_destroy(iterpool);
@@ -1053,6 +1122,342 @@ handle_externals_change(svn_client_ctx_t *ctx,
   return SVN_NO_ERROR;
 }
 
+/* Return the number of externals that CTX allows us to bring up to date
+   concurrently. */
+static int
+externals_parallelism(svn_client_ctx_t *ctx)
+{
+  svn_config_t *cfg = ctx->config
+                      ? svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG)
+                      : NULL;
+  svn_boolean_t exclusive;
+  apr_int64_t parallelism;
+  svn_error_t *err;
+
+  if (svn_client__get_private_ctx(ctx)->serial_externals)
+    return 1;
+
+  /* Workers open the defining working copy through their own connections,
+     which an exclusive lock would keep out. */
+  err = svn_config_get_bool(cfg, &exclusive, SVN_CONFIG_SECTION_WORKING_COPY,
+                            SVN_CONFIG_OPTION_SQLITE_EXCLUSIVE, FALSE);
+  if (err || exclusive)
+    {
+      svn_error_clear(err);
+      return 1;
+    }
+
+  err = svn_config_get_int64(cfg, &parallelism,
+                             SVN_CONFIG_SECTION_WORKING_COPY,
+                             SVN_CONFIG_OPTION_EXTERNALS_PARALLELISM,
+                             EXTERNALS_DEFAULT_PARALLELISM);
+  if (err)
+    {
+      svn_error_clear(err);
+      return 1;
+    }
+
+  return (int)MAX(1, MIN(parallelism, EXTERNALS_MAX_PARALLELISM));
+}
+
+/* Shared state of the concurrent processing of some externals. */
+typedef struct externals_run_baton_t
+{
+  /* The context and session of the update that defines the externals. */
+  svn_client_ctx_t *ctx;
+  svn_ra_session_t *ra_session;
+  svn_boolean_t *timestamp_sleep;
+
+  /* Serializes calls to the conflict resolver of CTX. */
+  svn_mutex__t *conflict_mutex;
+
+  /* The external_job_t * to process. */
+  const apr_array_header_t *jobs;
+} externals_run_baton_t;
+
+/* What a worker thread did for a single external_job_t. */
+typedef struct external_job_result_t
+{
+  const external_job_t *job;
+
+  /* The svn_wc_notify_t * that the worker would have sent. */
+  apr_array_header_t *notifications;
+
+  /* Set if the worker left this external to the main thread. */
+  svn_boolean_t deferred;
+
+  svn_boolean_t timestamp_sleep;
+  svn_error_t *err;
+} external_job_result_t;
+
+/* Implements svn_wc_notify_func2_t.  BATON is an
+   external_job_result_t; queue a copy of NOTIFY in it. */
+static void
+queue_notification(void *baton,
+                   const svn_wc_notify_t *notify,
+                   apr_pool_t *pool)
+{
+  external_job_result_t *result = baton;
+  apr_pool_t *result_pool = result->notifications->pool;
+
+  APR_ARRAY_PUSH(result->notifications, svn_wc_notify_t *)
+    = svn_wc_dup_notify(notify, result_pool);
+}
+
+/* Implements svn_wc_conflict_resolver_func2_t.  BATON is an
+   externals_run_baton_t; call the conflict resolver of the main context
+   while no other thread does. */
+static svn_error_t *
+resolve_conflict_serially(svn_wc_conflict_result_t **result,
+                          const svn_wc_conflict_description2_t *description,
+                          void *baton,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  externals_run_baton_t *rb = baton;
+
+  SVN_MUTEX__WITH_LOCK(rb->conflict_mutex,
+                       rb->ctx->conflict_func2(result, description,
+                                               rb->ctx->conflict_baton2,
+                                               result_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__thread_context_constructor_t.  CONTEXT_BATON is
+   the externals_run_baton_t.  Create a client context for a worker that
+   has its own working copy context and configuration but otherwise
+   behaves like the main one. */
+static svn_error_t *
+make_worker_ctx(void **thread_context,
+                void *context_baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  externals_run_baton_t *rb = context_baton;
+  svn_client_ctx_t *ctx;
+  apr_hash_t *config = NULL;
+  svn_wc_context_t *wc_ctx;
+
+  /* Config lookups cache their expanded values, so don't share them. */
+  if (rb->ctx->config)
+    SVN_ERR(svn_config_copy_config(&config, rb->ctx->config, result_pool));
+
+  SVN_ERR(svn_client_create_context2(&ctx, config, result_pool));
+  wc_ctx = ctx->wc_ctx;
+
+  *ctx = *rb->ctx;
+  ctx->wc_ctx = wc_ctx;
+  ctx->config = config;
+
+  /* Notifications are queued per external and progress gets reported
+     by the main thread only. */
+  ctx->notify_func = NULL;
+  ctx->notify_baton = NULL;
+  ctx->progress_func = NULL;
+  ctx->progress_baton = NULL;
+
+  if (ctx->conflict_func2)
+    {
+      ctx->conflict_func2 = resolve_conflict_serially;
+      ctx->conflict_baton2 = rb;
+    }
+  ctx->conflict_func = NULL;
+  ctx->conflict_baton = NULL;
+
+  /* Externals of externals are handled within the same worker. */
+  svn_client__get_private_ctx(ctx)->serial_externals = TRUE;
+
+  *thread_context = ctx;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  PROCESS_BATON is the
+   external_job_t to execute and THREAD_CONTEXT the worker's client
+   context.  Runs in a worker thread. */
+static svn_error_t *
+external_job_process(void **result,
+                     svn_task__t *task,
+                     void *thread_context,
+                     void *process_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  svn_client_ctx_t *ctx = thread_context;
+  const external_job_t *job = process_baton;
+  external_job_result_t *job_result = apr_pcalloc(result_pool,
+                                                  sizeof(*job_result));
+
+  job_result->job = job;
+  job_result->notifications = apr_array_make(result_pool, 16,
+                                             sizeof(svn_wc_notify_t *));
+  *result = job_result;
+
+  if (job->serial)
+    {
+      job_result->deferred = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  ctx->notify_func2 = queue_notification;
+  ctx->notify_baton2 = job_result;
+  ctx->cancel_func = cancel_func;
+  ctx->cancel_baton = cancel_baton;
+
+  /* Errors get reported by the output function, in order. */
+  job_result->err = handle_external_item_change(ctx,
+                                                job->repos_root_url,
+                                                job->parent_dir_abspath,
+                                                job->parent_dir_url,
+                                                job->target_abspath,
+                                                job->old_defining_abspath,
+                                                job->new_item, NULL,
+                                                &job_result->timestamp_sleep,
+                                                &job_result->deferred,
+                                                scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  RESULT is the
+   external_job_result_t and OUTPUT_BATON the externals_run_baton_t.
+   Runs in the main thread, in the order of the jobs. */
+static svn_error_t *
+external_job_output(svn_task__t *task,
+                    void *result,
+                    void *output_baton,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  external_job_result_t *job_result = result;
+  externals_run_baton_t *rb = output_baton;
+  const external_job_t *job = job_result->job;
+  svn_client_ctx_t *ctx = rb->ctx;
+  svn_error_t *err = job_result->err;
+  int i;
+
+  if (ctx->notify_func2)
+    for (i = 0; i < job_result->notifications->nelts; i++)
+      {
+        const svn_wc_notify_t *notify
+          = APR_ARRAY_IDX(job_result->notifications, i, svn_wc_notify_t *);
+
+        ctx->notify_func2(ctx->notify_baton2, notify, scratch_pool);
+      }
+
+  if (job_result->timestamp_sleep)
+    *rb->timestamp_sleep = TRUE;
+
+  if (!err && job_result->deferred)
+    {
+      if (ctx->cancel_func)
+        SVN_ERR(ctx->cancel_func(ctx->cancel_baton));
+
+      err = handle_external_item_change(ctx,
+                                        job->repos_root_url,
+                                        job->parent_dir_abspath,
+                                        job->parent_dir_url,
+                                        job->target_abspath,
+                                        job->old_defining_abspath,
+                                        job->new_item, rb->ra_session,
+                                        rb->timestamp_sleep, NULL,
+                                        scratch_pool);
+    }
+
+  return svn_error_trace(wrap_external_error(ctx, job->target_abspath, err,
+                                             scratch_pool));
+}
+
+/* Implements svn_task__process_func_t.  PROCESS_BATON is the
+   externals_run_baton_t; add a sub-task for each of its jobs. */
+static svn_error_t *
+externals_run_process(void **result,
+                      svn_task__t *task,
+                      void *thread_context,
+                      void *process_baton,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  externals_run_baton_t *rb = process_baton;
+  int i;
+
+  for (i = 0; i < rb->jobs->nelts; i++)
+    {
+      apr_pool_t *process_pool = svn_task__create_process_pool(task);
+      external_job_t *job
+        = apr_pmemdup(process_pool,
+                      APR_ARRAY_IDX(rb->jobs, i, external_job_t *),
+                      sizeof(*job));
+
+      SVN_ERR(svn_task__add(task, process_pool, NULL,
+                            external_job_process, job,
+                            external_job_output, rb));
+    }
+
+  *result = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Process the external_job_t * in JOBS using up to THREAD_COUNT worker
+   threads, each with its own working copy context and RA session.
+   Notifications and errors get reported by the main thread, grouped per
+   external and in the order of JOBS.
+
+   File externals and externals whose targets overlap with another one
+   are processed by the main thread, using RA_SESSION. */
+static svn_error_t *
+run_externals_concurrently(const apr_array_header_t *jobs,
+                           int thread_count,
+                           svn_boolean_t *timestamp_sleep,
+                           svn_ra_session_t *ra_session,
+                           svn_client_ctx_t *ctx,
+                           apr_pool_t *scratch_pool)
+{
+  externals_run_baton_t rb;
+  int i, k;
+
+  for (i = 0; i < jobs->nelts; i++)
+    {
+      external_job_t *job = APR_ARRAY_IDX(jobs, i, external_job_t *);
+
+      for (k = i + 1; k < jobs->nelts; k++)
+        {
+          external_job_t *other = APR_ARRAY_IDX(jobs, k, external_job_t *);
+
+          if (svn_dirent_is_ancestor(job->target_abspath,
+                                     other->target_abspath)
+              || svn_dirent_is_ancestor(other->target_abspath,
+                                        job->target_abspath))
+            {
+              job->serial = TRUE;
+              other->serial = TRUE;
+            }
+        }
+    }
+
+  rb.ctx = ctx;
+  rb.ra_session = ra_session;
+  rb.timestamp_sleep = timestamp_sleep;
+  rb.jobs = jobs;
+  SVN_ERR(svn_mutex__init(&rb.conflict_mutex, TRUE, scratch_pool));
+
+  SVN_ERR(svn_task__run(MIN(thread_count, jobs->nelts),
+                        externals_run_process, &rb,
+                        NULL, NULL,
+                        make_worker_ctx, &rb,
+                        ctx->cancel_func, ctx->cancel_baton,
+                        scratch_pool, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
 
 svn_error_t *
 svn_client__handle_externals(apr_hash_t *externals_new,
@@ -1066,8 +1471,10 @@ svn_client__handle_externals(apr_hash_t *externals_new,
                              apr_pool_t *scratch_pool)
 {
   apr_hash_t *old_external_defs;
+  apr_array_header_t *jobs;
   apr_hash_index_t *hi;
   apr_pool_t *iterpool;
+  int thread_count;
 
   SVN_ERR_ASSERT(repos_root_url);
 
@@ -1077,6 +1484,9 @@ svn_client__handle_externals(apr_hash_t *externals_new,
                                           ctx->wc_ctx, target_abspath,
                                           scratch_pool, iterpool));
 
+  jobs = apr_array_make(scratch_pool, apr_hash_count(externals_new),
+                        sizeof(external_job_t *));
+
   for (hi = apr_hash_first(scratch_pool, externals_new);
        hi;
        hi = apr_hash_next(hi))
@@ -1107,13 +1517,21 @@ svn_client__handle_externals(apr_hash_t *externals_new,
             }
         }
 
-      SVN_ERR(handle_externals_change(ctx, repos_root_url, timestamp_sleep,
-                                      local_abspath,
-                                      desc_text, old_external_defs,
-                                      ambient_depth, requested_depth,
-                                      ra_session, iterpool));
+      SVN_ERR(collect_externals_change(jobs, ctx, repos_root_url,
+                                       local_abspath,
+                                       desc_text, old_external_defs,
+                                       ambient_depth, requested_depth,
+                                       scratch_pool, iterpool));
     }
 
+  thread_count = externals_parallelism(ctx);
+  if (thread_count > 1 && jobs->nelts > 1)
+    SVN_ERR(run_externals_concurrently(jobs, thread_count, timestamp_sleep,
+                                       ra_session, ctx, iterpool));
+  else
+    SVN_ERR(run_externals_serially(jobs, timestamp_sleep, ra_session, ctx,
+                                   iterpool));
+
   /* Remove the remaining externals */
   for (hi = apr_hash_first(scratch_pool, old_external_defs);
        hi;
@@ -58,8 +58,11 @@
 #include "private/svn_fspath.h"
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_client_private.h"
+#include "private/svn_ra_private.h"
+#include "private/svn_skel.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_task.h"
 #include "private/svn_wc_private.h"
 
 #include "svn_private_config.h"
@@ -344,6 +347,11 @@ typedef struct merge_cmd_baton_t {
   void *notify_baton;
   struct notify_begin_state_t notify_begin;
 
+  /* Text merges queued by merge_file_changed() to be computed in parallel,
+     or NULL if text merges are applied immediately.  Only set while
+     drive_merge_report_editor() drives the merge editor. */
+  struct text_merge_batch_t *text_merges;
+
 } merge_cmd_baton_t;
 
 
@@ -1747,6 +1755,334 @@ mark_dir_edited(merge_cmd_baton_t *merge_b,
   return SVN_NO_ERROR;
 }
 
+/* Maximum number of threads that compute text merges in parallel. */
+#define MERGE_TEXT_THREAD_COUNT 4
+
+/* Maximum number of text merges queued before they get applied. */
+#define MERGE_TEXT_BATCH_SIZE 32
+
+/* Largest left or right file (in bytes) of a text merge that we queue. */
+#define MERGE_TEXT_MAX_SIZE (1024 * 1024)
+
+/* A text merge queued by merge_file_changed().  The text gets merged by
+   svn_wc__merge_text_ahead() in a worker thread; svn_wc__merge_precomputed()
+   then applies the result and updates the working copy in the thread that
+   drives the merge, in queue order. */
+typedef struct text_merge_job_t
+{
+  merge_cmd_baton_t *merge_b;
+  const char *local_abspath;
+
+  /* Private copies of the left and right files in TMPDIR_ABSPATH.  They
+     are removed when the batch pool gets cleared. */
+  const char *left_file;
+  const char *right_file;
+  const char *tmpdir_abspath;
+
+  const char *left_label;
+  const char *right_label;
+  const char *target_label;
+  const svn_wc_conflict_version_t *left;
+  const svn_wc_conflict_version_t *right;
+  apr_hash_t *left_props;
+  const apr_array_header_t *prop_changes;
+  svn_boolean_t has_local_mods;
+} text_merge_job_t;
+
+/* The text merges queued during a merge editor drive. */
+typedef struct text_merge_batch_t
+{
+  /* Holds the jobs and their files.  Cleared after each run. */
+  apr_pool_t *pool;
+
+  /* The text_merge_job_t * to run, in queue order. */
+  apr_array_header_t *jobs;
+} text_merge_batch_t;
+
+/* Return the notification state for a text merge into a file that
+   resulted in CONTENT_OUTCOME.  HAS_LOCAL_MODS tells whether the file had
+   local text modifications before the merge. */
+static svn_wc_notify_state_t
+text_merge_notify_state(enum svn_wc_merge_outcome_t content_outcome,
+                        svn_boolean_t has_local_mods)
+{
+  if (content_outcome == svn_wc_merge_conflict)
+    return svn_wc_notify_state_conflicted;
+  else if (has_local_mods
+           && content_outcome != svn_wc_merge_unchanged)
+    return svn_wc_notify_state_merged;
+  else if (content_outcome == svn_wc_merge_merged)
+    return svn_wc_notify_state_changed;
+  else if (content_outcome == svn_wc_merge_no_merge)
+    return svn_wc_notify_state_missing;
+  else /* merge_outcome == svn_wc_merge_unchanged */
+    return svn_wc_notify_state_unchanged;
+}
+
+/* Record conflicts and produce the notification for a change to the file
+   LOCAL_ABSPATH that was merged with TEXT_STATE and PROPERTY_STATE. */
+static svn_error_t *
+record_file_merge(merge_cmd_baton_t *merge_b,
+                  const char *local_abspath,
+                  svn_wc_notify_state_t text_state,
+                  svn_wc_notify_state_t property_state,
+                  apr_pool_t *scratch_pool)
+{
+  if (text_state == svn_wc_notify_state_conflicted
+      || property_state == svn_wc_notify_state_conflicted)
+    {
+      alloc_and_store_path(&merge_b->conflicted_paths, local_abspath,
+                           merge_b->pool);
+    }
+
+  if (text_state == svn_wc_notify_state_conflicted
+      || text_state == svn_wc_notify_state_merged
+      || text_state == svn_wc_notify_state_changed
+      || property_state == svn_wc_notify_state_conflicted
+      || property_state == svn_wc_notify_state_merged
+      || property_state == svn_wc_notify_state_changed)
+    {
+      SVN_ERR(record_update_update(merge_b, local_abspath, svn_node_file,
+                                   text_state, property_state,
+                                   scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  PROCESS_BATON is the
+   text_merge_job_t to compute.  Runs in a worker thread. */
+static svn_error_t *
+text_merge_job_process(void **result,
+                       svn_task__t *task,
+                       void *thread_context,
+                       void *process_baton,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  const text_merge_job_t *job = process_baton;
+  svn_wc__text_merge_t *merge;
+
+  SVN_ERR(svn_wc__merge_text_ahead(&merge, job->left_file, job->right_file,
+                                   job->local_abspath,
+                                   job->left_label, job->right_label,
+                                   job->target_label,
+                                   job->merge_b->merge_options,
+                                   job->tmpdir_abspath,
+                                   cancel_func, cancel_baton,
+                                   result_pool, scratch_pool));
+
+  *result = merge;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  OUTPUT_BATON is the
+   text_merge_job_t that produced RESULT.  Runs in the thread that drives
+   the merge, in queue order. */
+static svn_error_t *
+text_merge_job_output(svn_task__t *task,
+                      void *result,
+                      void *output_baton,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  const text_merge_job_t *job = output_baton;
+  const svn_wc__text_merge_t *merge = result;
+  merge_cmd_baton_t *merge_b = job->merge_b;
+  enum svn_wc_merge_outcome_t content_outcome;
+  svn_wc_notify_state_t property_state = svn_wc_notify_state_unchanged;
+  svn_error_t *err;
+
+  err = svn_wc__merge_precomputed(&content_outcome, &property_state,
+                                  merge_b->ctx->wc_ctx,
+                                  job->left_file, job->right_file,
+                                  job->local_abspath,
+                                  job->left_label, job->right_label,
+                                  job->target_label,
+                                  job->left, job->right,
+                                  merge_b->dry_run, NULL,
+                                  merge_b->merge_options,
+                                  job->left_props, job->prop_changes,
+                                  merge, NULL, NULL,
+                                  cancel_func, cancel_baton,
+                                  scratch_pool);
+
+  /* The result is gone if the merge installed it. */
+  SVN_ERR(svn_error_compose_create(
+            err,
+            svn_io_remove_file2(merge->result_abspath, TRUE, scratch_pool)));
+
+  return svn_error_trace(record_file_merge(
+                           merge_b, job->local_abspath,
+                           text_merge_notify_state(content_outcome,
+                                                   job->has_local_mods),
+                           property_state, scratch_pool));
+}
+
+/* Implements svn_task__process_func_t.  PROCESS_BATON is the
+   text_merge_batch_t; add a sub-task for each of its jobs. */
+static svn_error_t *
+text_merge_batch_process(void **result,
+                         svn_task__t *task,
+                         void *thread_context,
+                         void *process_baton,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  text_merge_batch_t *batch = process_baton;
+  int i;
+
+  for (i = 0; i < batch->jobs->nelts; i++)
+    {
+      text_merge_job_t *job = APR_ARRAY_IDX(batch->jobs, i,
+                                            text_merge_job_t *);
+
+      SVN_ERR(svn_task__add(task, svn_task__create_process_pool(task), NULL,
+                            text_merge_job_process, job,
+                            text_merge_job_output, job));
+    }
+
+  *result = NULL;
+  return SVN_NO_ERROR;
+}
+
+/* Compute the text merges queued in MERGE_B->TEXT_MERGES, if any, and
+   apply them to the working copy in the order they were queued.
+
+   This must be called before any other change to the working copy or
+   any notification, so that those keep their order relative to the
+   queued merges. */
+static svn_error_t *
+flush_text_merges(merge_cmd_baton_t *merge_b,
+                  apr_pool_t *scratch_pool)
+{
+  text_merge_batch_t *batch = merge_b->text_merges;
+  svn_error_t *err;
+
+  if (!batch || batch->jobs->nelts == 0)
+    return SVN_NO_ERROR;
+
+  err = svn_task__run(MERGE_TEXT_THREAD_COUNT,
+                      text_merge_batch_process, batch,
+                      NULL, NULL, NULL, NULL,
+                      merge_b->ctx->cancel_func, merge_b->ctx->cancel_baton,
+                      scratch_pool, scratch_pool);
+
+  apr_array_clear(batch->jobs);
+  svn_pool_clear(batch->pool);
+
+  return svn_error_trace(err);
+}
+
+/* Set *MERGE_AHEAD to TRUE if the change from LEFT_FILE to RIGHT_FILE can
+   be queued for merging by text_merge_job_process().  LEFT_PROPS and
+   PROP_CHANGES are as passed to merge_file_changed(). */
+static svn_error_t *
+can_merge_text_ahead(svn_boolean_t *merge_ahead,
+                     merge_cmd_baton_t *merge_b,
+                     const char *left_file,
+                     const char *right_file,
+                     apr_hash_t *left_props,
+                     const apr_array_header_t *prop_changes,
+                     apr_pool_t *scratch_pool)
+{
+  const char *mime_type = svn_prop_get_value(left_props, SVN_PROP_MIME_TYPE);
+  const svn_io_dirent2_t *left_dirent;
+  const svn_io_dirent2_t *right_dirent;
+  int i;
+
+  *merge_ahead = FALSE;
+
+  if (!merge_b->text_merges || merge_b->record_only
+      || !left_file || !right_file)
+    return SVN_NO_ERROR;
+
+  for (i = 0; i < prop_changes->nelts; i++)
+    {
+      const svn_prop_t *change = &APR_ARRAY_IDX(prop_changes, i, svn_prop_t);
+
+      if (strcmp(change->name, SVN_PROP_MIME_TYPE) == 0)
+        mime_type = change->value ? change->value->data : NULL;
+    }
+
+  /* Binary files only get a conflict; no use merging them ahead. */
+  if (mime_type && svn_mime_type_is_binary(mime_type))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io_stat_dirent2(&left_dirent, left_file, FALSE, FALSE,
+                              scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_stat_dirent2(&right_dirent, right_file, FALSE, FALSE,
+                              scratch_pool, scratch_pool));
+
+  *merge_ahead = (left_dirent->filesize <= MERGE_TEXT_MAX_SIZE
+                  && right_dirent->filesize <= MERGE_TEXT_MAX_SIZE);
+  return SVN_NO_ERROR;
+}
+
+/* Queue the text merge of the change from LEFT_FILE to RIGHT_FILE into
+   LOCAL_ABSPATH, which merge_file_changed() would otherwise have applied
+   by calling svn_wc_merge6() with the other arguments.  Run the queue if
+   it is full. */
+static svn_error_t *
+queue_text_merge(merge_cmd_baton_t *merge_b,
+                 const char *local_abspath,
+                 const char *left_file,
+                 const char *right_file,
+                 const char *left_label,
+                 const char *right_label,
+                 const char *target_label,
+                 const svn_wc_conflict_version_t *left,
+                 const svn_wc_conflict_version_t *right,
+                 apr_hash_t *left_props,
+                 const apr_array_header_t *prop_changes,
+                 svn_boolean_t has_local_mods,
+                 apr_pool_t *scratch_pool)
+{
+  text_merge_batch_t *batch = merge_b->text_merges;
+  apr_pool_t *pool = batch->pool;
+  text_merge_job_t *job = apr_pcalloc(pool, sizeof(*job));
+
+  job->merge_b = merge_b;
+  job->local_abspath = apr_pstrdup(pool, local_abspath);
+  job->left_label = apr_pstrdup(pool, left_label);
+  job->right_label = apr_pstrdup(pool, right_label);
+  job->target_label = apr_pstrdup(pool, target_label);
+  job->left = svn_wc_conflict_version_dup(left, pool);
+  job->right = svn_wc_conflict_version_dup(right, pool);
+  job->left_props = svn_prop_hash_dup(left_props, pool);
+  job->prop_changes = svn_prop_array_dup(prop_changes, pool);
+  job->has_local_mods = has_local_mods;
+
+  /* The diff driver removes its files when we return, so keep copies in
+     the working copy's temp area until the job has been applied. */
+  SVN_ERR(svn_wc__get_tmpdir(&job->tmpdir_abspath, merge_b->ctx->wc_ctx,
+                             local_abspath, pool, scratch_pool));
+  SVN_ERR(svn_io_open_unique_file3(NULL, &job->left_file,
+                                   job->tmpdir_abspath,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   pool, scratch_pool));
+  SVN_ERR(svn_io_copy_file(left_file, job->left_file, FALSE, scratch_pool));
+  SVN_ERR(svn_io_open_unique_file3(NULL, &job->right_file,
+                                   job->tmpdir_abspath,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   pool, scratch_pool));
+  SVN_ERR(svn_io_copy_file(right_file, job->right_file, FALSE,
+                           scratch_pool));
+
+  APR_ARRAY_PUSH(batch->jobs, text_merge_job_t *) = job;
+
+  if (batch->jobs->nelts >= MERGE_TEXT_BATCH_SIZE)
+    SVN_ERR(flush_text_merges(merge_b, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Helper function for the merge_file_*() functions.
 
    Installs and notifies pre-recorded tree conflicts and skips for
@@ -1762,6 +2098,9 @@ mark_file_edited(merge_cmd_baton_t *merge_b,
   if (fb->edited)
     return SVN_NO_ERROR;
 
+  if ((fb->parent_baton && !fb->parent_baton->edited) || fb->shadowed)
+    SVN_ERR(flush_text_merges(merge_b, scratch_pool));
+
   if (fb->parent_baton && !fb->parent_baton->edited)
     {
       const char *dir_abspath = svn_dirent_dirname(local_abspath,
@@ -1987,6 +2326,8 @@ merge_file_opened(void **new_file_baton,
     {
       const svn_wc_conflict_description2_t *old_tc = NULL;
 
+      SVN_ERR(flush_text_merges(merge_b, scratch_pool));
+
       /* The node doesn't exist pre-merge: We have an addition */
       fb->added = TRUE;
       fb->tree_conflict_action = svn_wc_conflict_action_add;
@@ -2104,6 +2445,7 @@ merge_file_changed(const char *relpath,
   const svn_wc_conflict_version_t *right;
   svn_wc_notify_state_t text_state;
   svn_wc_notify_state_t property_state;
+  svn_boolean_t merge_ahead;
 
   SVN_ERR_ASSERT(local_abspath && svn_dirent_is_absolute(local_abspath));
   SVN_ERR_ASSERT(!left_file || svn_dirent_is_absolute(left_file));
@@ -2115,6 +2457,8 @@ merge_file_changed(const char *relpath,
     {
       if (fb->tree_conflict_reason == CONFLICT_REASON_NONE)
         {
+          SVN_ERR(flush_text_merges(merge_b, scratch_pool));
+
           /* We haven't notified for this node yet: report a skip */
           SVN_ERR(record_skip(merge_b, local_abspath, svn_node_file,
                               svn_wc_notify_update_shadowed_update,
@@ -2142,6 +2486,12 @@ merge_file_changed(const char *relpath,
                                  &merge_b->merge_source, merge_b->target,
                                  scratch_pool, scratch_pool));
 
+  /* Unless this text merge can be queued, apply the queued ones first. */
+  SVN_ERR(can_merge_text_ahead(&merge_ahead, merge_b, left_file, right_file,
+                               left_props, prop_changes, scratch_pool));
+  if (!merge_ahead)
+    SVN_ERR(flush_text_merges(merge_b, scratch_pool));
+
   /* Do property merge now, if we are not going to perform a text merge */
   if ((merge_b->record_only || !left_file) && prop_changes->nelts)
     {
@@ -2152,11 +2502,6 @@ merge_file_changed(const char *relpath,
                                   NULL, NULL,
                                   ctx->cancel_func, ctx->cancel_baton,
                                   scratch_pool));
-      if (property_state == svn_wc_notify_state_conflicted)
-        {
-          alloc_and_store_path(&merge_b->conflicted_paths, local_abspath,
-                               merge_b->pool);
-        }
     }
 
   /* Easy out: We are only applying mergeinfo differences. */
@@ -2202,6 +2547,15 @@ merge_file_changed(const char *relpath,
       SVN_ERR(svn_wc_text_modified_p2(&has_local_mods, ctx->wc_ctx,
                                       local_abspath, FALSE, scratch_pool));
 
+      if (merge_ahead)
+        return svn_error_trace(queue_text_merge(merge_b, local_abspath,
+                                                left_file, right_file,
+                                                left_label, right_label,
+                                                target_label, left, right,
+                                                left_props, prop_changes,
+                                                has_local_mods,
+                                                scratch_pool));
+
       /* Do property merge and text merge in one step so that keyword expansion
          takes into account the new property values. */
       SVN_ERR(svn_wc_merge6(&content_outcome, &property_state, ctx->wc_ctx,
@@ -2216,39 +2570,12 @@ merge_file_changed(const char *relpath,
                             ctx->cancel_baton,
                             scratch_pool));
 
-      if (content_outcome == svn_wc_merge_conflict
-          || property_state == svn_wc_notify_state_conflicted)
-        {
-          alloc_and_store_path(&merge_b->conflicted_paths, local_abspath,
-                               merge_b->pool);
-        }
-
-      if (content_outcome == svn_wc_merge_conflict)
-        text_state = svn_wc_notify_state_conflicted;
-      else if (has_local_mods
-               && content_outcome != svn_wc_merge_unchanged)
-        text_state = svn_wc_notify_state_merged;
-      else if (content_outcome == svn_wc_merge_merged)
-        text_state = svn_wc_notify_state_changed;
-      else if (content_outcome == svn_wc_merge_no_merge)
-        text_state = svn_wc_notify_state_missing;
-      else /* merge_outcome == svn_wc_merge_unchanged */
-        text_state = svn_wc_notify_state_unchanged;
-    }
-
-  if (text_state == svn_wc_notify_state_conflicted
-      || text_state == svn_wc_notify_state_merged
-      || text_state == svn_wc_notify_state_changed
-      || property_state == svn_wc_notify_state_conflicted
-      || property_state == svn_wc_notify_state_merged
-      || property_state == svn_wc_notify_state_changed)
-    {
-      SVN_ERR(record_update_update(merge_b, local_abspath, svn_node_file,
-                                   text_state, property_state,
-                                   scratch_pool));
+      text_state = text_merge_notify_state(content_outcome, has_local_mods);
     }
 
-  return SVN_NO_ERROR;
+  return svn_error_trace(record_file_merge(merge_b, local_abspath,
+                                           text_state, property_state,
+                                           scratch_pool));
 }
 
 /* An svn_diff_tree_processor_t function.
@@ -2280,6 +2607,8 @@ merge_file_added(const char *relpath,
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
 
+  SVN_ERR(flush_text_merges(merge_b, scratch_pool));
+
   SVN_ERR(mark_file_edited(merge_b, fb, local_abspath, scratch_pool));
 
   if (fb->shadowed)
@@ -2518,6 +2847,8 @@ merge_file_deleted(const char *relpath,
                                               relpath, scratch_pool);
   svn_boolean_t same;
 
+  SVN_ERR(flush_text_merges(merge_b, scratch_pool));
+
   SVN_ERR(mark_file_edited(merge_b, fb, local_abspath, scratch_pool));
 
   if (fb->shadowed)
@@ -2636,6 +2967,8 @@ merge_dir_opened(void **new_dir_baton,
   const char *local_abspath = svn_dirent_join(merge_b->target->abspath,
                                               relpath, scratch_pool);
 
+  SVN_ERR(flush_text_merges(merge_b, scratch_pool));
+
   db = apr_pcalloc(result_pool, sizeof(*db));
   db->pool = result_pool;
   db->tree_conflict_reason = CONFLICT_REASON_NONE;
@@ -3033,6 +3366,7 @@ merge_dir_changed(const char *relpath,
   const char *local_abspath = svn_dirent_join(merge_b->target->abspath,
                                               relpath, scratch_pool);
 
+  SVN_ERR(flush_text_merges(merge_b, scratch_pool));
   SVN_ERR(handle_pending_notifications(merge_b, db, scratch_pool));
 
   SVN_ERR(mark_dir_edited(merge_b, db, local_abspath, scratch_pool));
@@ -3120,6 +3454,7 @@ merge_dir_added(const char *relpath,
                                               relpath, scratch_pool);
 
   /* For consistency; usually a no-op from _dir_added() */
+  SVN_ERR(flush_text_merges(merge_b, scratch_pool));
   SVN_ERR(handle_pending_notifications(merge_b, db, scratch_pool));
   SVN_ERR(mark_dir_edited(merge_b, db, local_abspath, scratch_pool));
 
@@ -3288,6 +3623,7 @@ merge_dir_deleted(const char *relpath,
   svn_boolean_t same;
   apr_hash_t *working_props;
 
+  SVN_ERR(flush_text_merges(merge_b, scratch_pool));
   SVN_ERR(handle_pending_notifications(merge_b, db, scratch_pool));
   SVN_ERR(mark_dir_edited(merge_b, db, local_abspath, scratch_pool));
 
@@ -3456,6 +3792,7 @@ merge_dir_closed(const char *relpath,
   merge_cmd_baton_t *merge_b = processor->baton;
   struct merge_dir_baton_t *db = dir_baton;
 
+  SVN_ERR(flush_text_merges(merge_b, scratch_pool));
   SVN_ERR(handle_pending_notifications(merge_b, db, scratch_pool));
 
   return SVN_NO_ERROR;
@@ -3486,6 +3823,8 @@ merge_node_absent(const char *relpath,
   const char *local_abspath = svn_dirent_join(merge_b->target->abspath,
                                               relpath, scratch_pool);
 
+  SVN_ERR(flush_text_merges(merge_b, scratch_pool));
+
   SVN_ERR(record_skip(merge_b, local_abspath, svn_node_unknown,
                       svn_wc_notify_skip, svn_wc_notify_state_missing,
                       db, scratch_pool));
@@ -6003,7 +6342,30 @@ drive_merge_report_editor(const char *target_abspath,
         }
       svn_pool_destroy(iterpool);
     }
-  SVN_ERR(reporter->finish_report(report_baton, scratch_pool));
+
+  /* Let merge_file_changed() queue text merges to compute them in
+     parallel, unless an external merge tool is configured. */
+  if (!merge_b->diff3_cmd)
+    {
+      text_merge_batch_t batch;
+      svn_error_t *err;
+
+      batch.pool = svn_pool_create(scratch_pool);
+      batch.jobs = apr_array_make(scratch_pool, MERGE_TEXT_BATCH_SIZE,
+                                  sizeof(text_merge_job_t *));
+      merge_b->text_merges = &batch;
+
+      err = reporter->finish_report(report_baton, scratch_pool);
+      if (!err)
+        err = flush_text_merges(merge_b, scratch_pool);
+
+      /* On error, this discards the merges still queued. */
+      merge_b->text_merges = NULL;
+      svn_pool_destroy(batch.pool);
+      SVN_ERR(err);
+    }
+  else
+    SVN_ERR(reporter->finish_report(report_baton, scratch_pool));
 
   /* Point the merge baton's RA sessions back where they were. */
   SVN_ERR(svn_ra_reparent(merge_b->ra_session1, old_sess1_url, scratch_pool));
@@ -9225,7 +9587,10 @@ remove_noop_subtree_ranges(const merge_source_t *source,
   svn_merge_range_t *oldest_gap_rev;
   svn_merge_range_t *youngest_gap_rev;
   svn_rangelist_t *inoperative_ranges;
-  apr_pool_t *iterpool;
+  svn_rangelist__packed_t *packed_ranges;
+  svn_rangelist__packed_t *packed_child_ranges;
+  svn_rangelist__packed_t *packed_result;
+  svn_rangelist__packed_t *packed_swap;
   const char *longest_common_subtree_ancestor = NULL;
   svn_error_t *err;
 
@@ -9239,9 +9604,6 @@ remove_noop_subtree_ranges(const merge_source_t *source,
   if (children_with_mergeinfo->nelts < 2)
     return SVN_NO_ERROR;
 
-  subtree_remaining_ranges = apr_array_make(scratch_pool, 1,
-                                            sizeof(svn_merge_range_t *));
-
   /* Given the requested merge of SOURCE->rev1:rev2 might there be any
      part of this range required for subtrees but not for the target? */
   requested_ranges = svn_rangelist__initialize(MIN(source->loc1->rev,
@@ -9257,15 +9619,17 @@ remove_noop_subtree_ranges(const merge_source_t *source,
   if (!subtree_gap_ranges->nelts)
     return SVN_NO_ERROR;
 
-  /* Create a rangelist describing every range required across all subtrees. */
-  iterpool = svn_pool_create(scratch_pool);
+  /* Create a rangelist describing every range required across all subtrees.
+     With many subtrees this is the bulk of the rangelist work, so use
+     packed rangelists that get reused for every child. */
+  packed_ranges = svn_rangelist__packed_create(0, scratch_pool);
+  packed_child_ranges = svn_rangelist__packed_create(0, scratch_pool);
+  packed_result = svn_rangelist__packed_create(0, scratch_pool);
   for (i = 1; i < children_with_mergeinfo->nelts; i++)
     {
       svn_client__merge_path_t *child =
         APR_ARRAY_IDX(children_with_mergeinfo, i, svn_client__merge_path_t *);
 
-      svn_pool_clear(iterpool);
-
       /* CHILD->REMAINING_RANGES will be NULL if child is absent. */
       if (child->remaining_ranges && child->remaining_ranges->nelts)
         {
@@ -9279,12 +9643,17 @@ remove_noop_subtree_ranges(const merge_source_t *source,
           else
             longest_common_subtree_ancestor = child->abspath;
 
-          SVN_ERR(svn_rangelist_merge2(subtree_remaining_ranges,
-                                       child->remaining_ranges,
-                                       scratch_pool, iterpool));
+          SVN_ERR(svn_rangelist__packed_set(packed_child_ranges,
+                                            child->remaining_ranges));
+          SVN_ERR(svn_rangelist__packed_merge(packed_result, packed_ranges,
+                                              packed_child_ranges));
+          packed_swap = packed_ranges;
+          packed_ranges = packed_result;
+          packed_result = packed_swap;
         }
     }
-  svn_pool_destroy(iterpool);
+  subtree_remaining_ranges = svn_rangelist__unpack(packed_ranges,
+                                                   scratch_pool);
 
   /* It's possible that none of the subtrees had any remaining ranges. */
   if (!subtree_remaining_ranges->nelts)
@@ -9366,6 +9735,8 @@ remove_noop_subtree_ranges(const merge_source_t *source,
                                    scratch_pool, scratch_pool));
     }
 
+  SVN_ERR(svn_rangelist__packed_set(packed_ranges,
+                                    log_gap_baton.merged_ranges));
   for (i = 1; i < children_with_mergeinfo->nelts; i++)
     {
       svn_client__merge_path_t *child =
@@ -9376,10 +9747,12 @@ remove_noop_subtree_ranges(const merge_source_t *source,
         {
           /* Remove inoperative ranges from all children so we don't perform
              inoperative editor drives. */
-          SVN_ERR(svn_rangelist_remove(&(child->remaining_ranges),
-                                       log_gap_baton.merged_ranges,
-                                       child->remaining_ranges,
-                                       FALSE, result_pool));
+          SVN_ERR(svn_rangelist__packed_set(packed_child_ranges,
+                                            child->remaining_ranges));
+          SVN_ERR(svn_rangelist__packed_remove(packed_result, packed_ranges,
+                                               packed_child_ranges, FALSE));
+          child->remaining_ranges = svn_rangelist__unpack(packed_result,
+                                                          result_pool);
         }
     }
 
@@ -12611,6 +12984,127 @@ find_base_on_target(svn_client__pathrev_t **base_p,
   return SVN_NO_ERROR;
 }
 
+/* Return the key of the automatic merge base of S_T in the RA cache,
+ * allocated in RESULT_POOL.  Both ends are identified by exact revisions
+ * and only their repository history and mergeinfo go into the result,
+ * so an entry never becomes stale. */
+static const char *
+automatic_merge_cache_key(const source_and_target_t *s_t,
+                          apr_pool_t *result_pool)
+{
+  return apr_psprintf(result_pool, "automatic-merge %s %s@%ld %s@%ld",
+                      s_t->source->repos_uuid,
+                      svn_client__pathrev_relpath(s_t->source, result_pool),
+                      s_t->source->rev,
+                      svn_client__pathrev_relpath(&s_t->target->loc,
+                                                  result_pool),
+                      s_t->target->loc.rev);
+}
+
+/* Look up the result of find_automatic_merge() for S_T in CACHE.  If it
+ * is there, set S_T->yca, *BASE_P and *IS_REINTEGRATE_LIKE and set
+ * *FOUND to TRUE, else set *FOUND to FALSE.  Allocate the results in
+ * RESULT_POOL. */
+static svn_error_t *
+get_cached_automatic_merge(svn_boolean_t *found,
+                           svn_client__pathrev_t **base_p,
+                           svn_boolean_t *is_reintegrate_like,
+                           source_and_target_t *s_t,
+                           svn_ra__cache_t *cache,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  svn_stream_t *stream;
+  svn_stringbuf_t *buf;
+  svn_skel_t *skel;
+  const svn_skel_t *field;
+  apr_int64_t values[3];
+  const char *relpaths[2];
+  int i;
+
+  *found = FALSE;
+
+  SVN_ERR(svn_ra__cache_get(&stream, cache,
+                            automatic_merge_cache_key(s_t, scratch_pool),
+                            scratch_pool, scratch_pool));
+  if (!stream)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_stringbuf_from_stream(&buf, stream, 0, scratch_pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  /* (IS_REINTEGRATE YCA_REV YCA_RELPATH BASE_REV BASE_RELPATH).  A corrupt
+   * entry is just a miss. */
+  skel = svn_skel__parse(buf->data, buf->len, scratch_pool);
+  if (!skel || svn_skel__list_length(skel) != 5)
+    return SVN_NO_ERROR;
+
+  field = skel->children;
+  for (i = 0; i < 5; i++, field = field->next)
+    {
+      if (!field->is_atom)
+        return SVN_NO_ERROR;
+
+      if (i % 2)
+        {
+          relpaths[i / 2] = apr_pstrmemdup(scratch_pool, field->data,
+                                           field->len);
+        }
+      else
+        {
+          svn_error_t *err = svn_skel__parse_int(&values[i / 2], field,
+                                                 scratch_pool);
+
+          if (err)
+            {
+              svn_error_clear(err);
+              return SVN_NO_ERROR;
+            }
+        }
+    }
+
+  s_t->yca = svn_client__pathrev_create_with_relpath(
+               s_t->source->repos_root_url, s_t->source->repos_uuid,
+               (svn_revnum_t)values[1], relpaths[0], result_pool);
+  *base_p = svn_client__pathrev_create_with_relpath(
+              s_t->source->repos_root_url, s_t->source->repos_uuid,
+              (svn_revnum_t)values[2], relpaths[1], result_pool);
+  *is_reintegrate_like = (values[0] != 0);
+  *found = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Store the result of find_automatic_merge() for S_T, i.e. S_T->yca,
+ * BASE and IS_REINTEGRATE_LIKE, in CACHE. */
+static svn_error_t *
+put_cached_automatic_merge(const svn_client__pathrev_t *base,
+                           svn_boolean_t is_reintegrate_like,
+                           const source_and_target_t *s_t,
+                           svn_ra__cache_t *cache,
+                           apr_pool_t *scratch_pool)
+{
+  svn_skel_t *skel = svn_skel__make_empty_list(scratch_pool);
+  svn_stringbuf_t *buf;
+  svn_stream_t *stream;
+
+  svn_skel__prepend_str(svn_client__pathrev_relpath(base, scratch_pool),
+                        skel, scratch_pool);
+  svn_skel__prepend_int(base->rev, skel, scratch_pool);
+  svn_skel__prepend_str(svn_client__pathrev_relpath(s_t->yca, scratch_pool),
+                        skel, scratch_pool);
+  svn_skel__prepend_int(s_t->yca->rev, skel, scratch_pool);
+  svn_skel__prepend_int(is_reintegrate_like ? 1 : 0, skel, scratch_pool);
+  buf = svn_skel__unparse(skel, scratch_pool);
+
+  SVN_ERR(svn_ra__cache_put(&stream, cache,
+                            automatic_merge_cache_key(s_t, scratch_pool),
+                            scratch_pool, scratch_pool));
+  SVN_ERR(svn_stream_write(stream, buf->data, &buf->len));
+
+  return svn_error_trace(svn_stream_close(stream));
+}
+
 /* Find the last point at which the branch at S_T->source was completely
  * merged to the branch at S_T->target or vice-versa.
  *
@@ -12631,6 +13125,26 @@ find_automatic_merge(svn_client__pathrev_t **base_p,
                      apr_pool_t *scratch_pool)
 {
   svn_client__pathrev_t *base_on_source, *base_on_target;
+  svn_ra__cache_t *cache = svn_ra__get_cache(s_t->source_ra_session);
+
+  /* A previous merge between the same locations may have done all the
+   * work below already. */
+  if (cache)
+    {
+      svn_boolean_t found;
+
+      SVN_ERR(get_cached_automatic_merge(&found, base_p, is_reintegrate_like,
+                                         s_t, cache,
+                                         result_pool, scratch_pool));
+      if (found)
+        {
+          s_t->source_branch.tip = s_t->source;
+          s_t->source_branch.history = NULL;
+          s_t->target_branch.tip = &s_t->target->loc;
+          s_t->target_branch.history = NULL;
+          return SVN_NO_ERROR;
+        }
+    }
 
   /* Get the location-history of each branch. */
   s_t->source_branch.tip = s_t->source;
@@ -12681,6 +13195,10 @@ find_automatic_merge(svn_client__pathrev_t **base_p,
       *is_reintegrate_like = TRUE;
     }
 
+  if (cache)
+    SVN_ERR(put_cached_automatic_merge(*base_p, *is_reintegrate_like, s_t,
+                                       cache, scratch_pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -56,6 +56,7 @@ typedef struct mtcc_op_t
   mtcc_kind_t kind;                 /* editor operation */
 
   apr_array_header_t *children;     /* List of mtcc_op_t * */
+  apr_hash_t *child_index;          /* Last child per name, or NULL */
 
   const char *src_relpath;              /* For ADD_DIR, ADD_FILE */
   svn_revnum_t src_rev;                 /* For ADD_DIR, ADD_FILE */
@@ -89,8 +90,28 @@ struct svn_client__mtcc_t
   svn_client_ctx_t *ctx;
 
   mtcc_op_t *root_op;
+
+  /* Listings of repository directories below which paths were checked,
+     as const char * "REV/RELPATH" -> mtcc_dir_listing_t * */
+  apr_hash_t *dir_listings;
 };
 
+/* Number of children of an operation from which on they get indexed by
+   name, so that adding many files to one directory stays linear. */
+#define CHILD_INDEX_THRESHOLD 16
+
+/* Number of path checks below the same repository directory after which
+   that directory gets listed once instead of checking each path. */
+#define DIR_LISTING_THRESHOLD 4
+
+/* Repository directory checked by svn_client__mtcc_check_path() */
+typedef struct mtcc_dir_listing_t
+{
+  int checks;               /* Number of paths checked in it, -1 if it can't
+                               be listed */
+  apr_hash_t *dirents;      /* const char * -> svn_dirent_t *, or NULL */
+} mtcc_dir_listing_t;
+
 static mtcc_op_t *
 mtcc_op_create(const char *name,
                svn_boolean_t add,
@@ -115,6 +136,67 @@ mtcc_op_create(const char *name,
   return op;
 }
 
+/* Append COP to the children of OP, indexing them by name once there
+   are CHILD_INDEX_THRESHOLD of them. */
+static void
+mtcc_op_add_child(mtcc_op_t *op,
+                  mtcc_op_t *cop)
+{
+  APR_ARRAY_PUSH(op->children, mtcc_op_t *) = cop;
+
+  if (op->child_index)
+    {
+      svn_hash_sets(op->child_index, cop->name, cop);
+    }
+  else if (op->children->nelts >= CHILD_INDEX_THRESHOLD)
+    {
+      int i;
+
+      op->child_index = apr_hash_make(op->children->pool);
+      for (i = 0; i < op->children->nelts; i++)
+        {
+          mtcc_op_t *child = APR_ARRAY_IDX(op->children, i, mtcc_op_t *);
+
+          svn_hash_sets(op->child_index, child->name, child);
+        }
+    }
+}
+
+/* Return the last child of OP named NAME, or NULL if there is none.
+   Skip deletions unless FIND_DELETES is TRUE. */
+static mtcc_op_t *
+mtcc_op_find_child(const mtcc_op_t *op,
+                   const char *name,
+                   svn_boolean_t find_deletes)
+{
+  int i;
+
+  if (op->child_index)
+    {
+      mtcc_op_t *cop = svn_hash_gets(op->child_index, name);
+
+      if (!cop)
+        return NULL;
+      if (find_deletes || cop->kind != OP_DELETE)
+        return cop;
+
+      /* An earlier child of the same name may still match. */
+    }
+
+  for (i = op->children->nelts-1; i >= 0 ; i--)
+    {
+      mtcc_op_t *cop;
+
+      cop = APR_ARRAY_IDX(op->children, i, mtcc_op_t *);
+
+      if (! strcmp(cop->name, name)
+          && (find_deletes || cop->kind != OP_DELETE))
+        return cop;
+    }
+
+  return NULL;
+}
+
 static svn_error_t *
 mtcc_op_find(mtcc_op_t **op,
              svn_boolean_t *created,
@@ -128,7 +210,7 @@ mtcc_op_find(mtcc_op_t **op,
 {
   const char *name;
   const char *child;
-  int i;
+  mtcc_op_t *cop;
 
   assert(svn_relpath_is_canonical(relpath));
   if (created)
@@ -168,21 +250,12 @@ mtcc_op_find(mtcc_op_t **op,
                                  name, base_op->name);
     }
 
-  for (i = base_op->children->nelts-1; i >= 0 ; i--)
-    {
-      mtcc_op_t *cop;
-
-      cop = APR_ARRAY_IDX(base_op->children, i, mtcc_op_t *);
-
-      if (! strcmp(cop->name, name)
-          && (find_deletes || cop->kind != OP_DELETE))
-        {
-          return svn_error_trace(
-                        mtcc_op_find(op, created, child ? child : "", cop,
-                                     find_existing, find_deletes, create_file,
-                                     result_pool, scratch_pool));
-        }
-    }
+  cop = mtcc_op_find_child(base_op, name, find_deletes);
+  if (cop)
+    return svn_error_trace(
+                    mtcc_op_find(op, created, child ? child : "", cop,
+                                 find_existing, find_deletes, create_file,
+                                 result_pool, scratch_pool));
 
   if (!created)
     {
@@ -191,11 +264,9 @@ mtcc_op_find(mtcc_op_t **op,
     }
 
   {
-    mtcc_op_t *cop;
-
     cop = mtcc_op_create(name, FALSE, child || !create_file, result_pool);
 
-    APR_ARRAY_PUSH(base_op->children, mtcc_op_t *) = cop;
+    mtcc_op_add_child(base_op, cop);
 
     if (!child)
       {
@@ -246,31 +317,22 @@ get_origin(svn_boolean_t *done,
 
   if (op->children && op->children->nelts)
     {
-      int i;
+      mtcc_op_t *cop = mtcc_op_find_child(op, name, TRUE);
 
-      for (i = op->children->nelts-1; i >= 0; i--)
+      if (cop)
         {
-           mtcc_op_t *cop;
-
-           cop = APR_ARRAY_IDX(op->children, i, mtcc_op_t *);
-
-           if (! strcmp(cop->name, name))
+          if (cop->kind == OP_DELETE)
             {
-              if (cop->kind == OP_DELETE)
-                {
-                  *done = TRUE;
-                  return SVN_NO_ERROR;
-                }
-
-              SVN_ERR(get_origin(done, origin_relpath, rev,
-                                 cop, child ? child : "",
-                                 result_pool, scratch_pool));
+              *done = TRUE;
+              return SVN_NO_ERROR;
+            }
 
-              if (*origin_relpath || *done)
-                return SVN_NO_ERROR;
+          SVN_ERR(get_origin(done, origin_relpath, rev,
+                             cop, child ? child : "",
+                             result_pool, scratch_pool));
 
-              break;
-            }
+          if (*origin_relpath || *done)
+            return SVN_NO_ERROR;
         }
     }
 
@@ -339,6 +401,7 @@ svn_client__mtcc_create(svn_client__mtcc_t **mtcc,
   (*mtcc)->pool = mtcc_pool;
 
   (*mtcc)->root_op = mtcc_op_create(NULL, FALSE, TRUE, mtcc_pool);
+  (*mtcc)->dir_listings = apr_hash_make(mtcc_pool);
 
   (*mtcc)->ctx = ctx;
 
@@ -415,6 +478,9 @@ mtcc_reparent(const char *new_anchor_url,
   /* Update copy origins recursively...:( */
   SVN_ERR(update_copy_src(mtcc->root_op, up, mtcc->pool));
 
+  /* The listings are keyed by session relative paths. */
+  apr_hash_clear(mtcc->dir_listings);
+
   SVN_ERR(svn_ra_reparent(mtcc->ra_session, new_anchor_url, scratch_pool));
 
   /* Create directory open operations for new ancestors */
@@ -427,7 +493,7 @@ mtcc_reparent(const char *new_anchor_url,
 
       root_op = mtcc_op_create(NULL, FALSE, TRUE, mtcc->pool);
 
-      APR_ARRAY_PUSH(root_op->children, mtcc_op_t *) = mtcc->root_op;
+      mtcc_op_add_child(root_op, mtcc->root_op);
 
       mtcc->root_op = root_op;
     }
@@ -657,6 +723,7 @@ mtcc_add_delete(const char *relpath,
 
   op->kind = OP_DELETE;
   op->children = NULL;
+  op->child_index = NULL;
   op->prop_mods = NULL;
 
   return SVN_NO_ERROR;
@@ -985,6 +1052,72 @@ svn_client__mtcc_add_update_file(const char *relpath,
   return SVN_NO_ERROR;
 }
 
+/* Set *KIND to the kind of ORIGIN_RELPATH in ORIGIN_REV.  Once
+   DIR_LISTING_THRESHOLD paths below the same directory were checked, list
+   that directory and answer further checks below it from the listing,
+   saving a round trip per path when adding many files.  Use SCRATCH_POOL
+   for temporary allocations. */
+static svn_error_t *
+mtcc_check_origin(svn_node_kind_t *kind,
+                  const char *origin_relpath,
+                  svn_revnum_t origin_rev,
+                  svn_client__mtcc_t *mtcc,
+                  apr_pool_t *scratch_pool)
+{
+  const char *dir_relpath;
+  const char *name;
+  const char *key;
+  mtcc_dir_listing_t *listing;
+
+  if (SVN_PATH_IS_EMPTY(origin_relpath))
+    return svn_error_trace(svn_ra_check_path(mtcc->ra_session, "",
+                                             origin_rev, kind,
+                                             scratch_pool));
+
+  svn_relpath_split(&dir_relpath, &name, origin_relpath, scratch_pool);
+  key = apr_psprintf(scratch_pool, "%ld/%s", origin_rev, dir_relpath);
+  listing = svn_hash_gets(mtcc->dir_listings, key);
+
+  if (!listing)
+    {
+      listing = apr_pcalloc(mtcc->pool, sizeof(*listing));
+      svn_hash_sets(mtcc->dir_listings, apr_pstrdup(mtcc->pool, key),
+                    listing);
+    }
+
+  if (!listing->dirents && listing->checks >= 0
+      && ++listing->checks >= DIR_LISTING_THRESHOLD)
+    {
+      svn_error_t *err;
+
+      err = svn_ra_get_dir2(mtcc->ra_session, &listing->dirents, NULL, NULL,
+                            dir_relpath, origin_rev, SVN_DIRENT_KIND,
+                            mtcc->pool);
+
+      if (err && err->apr_err == SVN_ERR_CANCELLED)
+        return svn_error_trace(err);
+      else if (err)
+        {
+          /* Not a directory, or not listable.  Leave the error handling
+             to svn_ra_check_path(). */
+          svn_error_clear(err);
+          listing->dirents = NULL;
+          listing->checks = -1;
+        }
+    }
+
+  if (listing->dirents)
+    {
+      svn_dirent_t *dirent = svn_hash_gets(listing->dirents, name);
+
+      *kind = dirent ? dirent->kind : svn_node_none;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(svn_ra_check_path(mtcc->ra_session, origin_relpath,
+                                           origin_rev, kind, scratch_pool));
+}
+
 svn_error_t *
 svn_client__mtcc_check_path(svn_node_kind_t *kind,
                             const char *relpath,
@@ -1010,6 +1143,7 @@ svn_client__mtcc_check_path(svn_node_kind_t *kind,
         {
           mtcc->root_op->kind = OP_OPEN_FILE;
           mtcc->root_op->children = NULL;
+          mtcc->root_op->child_index = NULL;
         }
       return SVN_NO_ERROR;
     }
@@ -1026,8 +1160,8 @@ svn_client__mtcc_check_path(svn_node_kind_t *kind,
       if (!origin_relpath)
         *kind = svn_node_none;
       else
-        SVN_ERR(svn_ra_check_path(mtcc->ra_session, origin_relpath,
-                                  origin_rev, kind, scratch_pool));
+        SVN_ERR(mtcc_check_origin(kind, origin_relpath, origin_rev, mtcc,
+                                  scratch_pool));
 
       if (op && *kind == svn_node_dir)
         {
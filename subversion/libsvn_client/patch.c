@@ -98,6 +98,12 @@ typedef struct target_content_t {
   /* An array containing hunk_info_t structures for hunks already matched. */
   apr_array_header_t *hunks;
 
+  /* Maps the svn__fnv1a_32() checksums of the lines of the unpatched
+   * content, with keywords contracted, to arrays of the svn_linenum_t
+   * numbers of the lines with that checksum, in ascending order.
+   * NULL until index_lines() has been called. */
+  apr_hash_t *line_index;
+
   /* True if end-of-file was reached while reading from the unpatched
    * content. */
   svn_boolean_t eof;
@@ -1550,6 +1556,70 @@ seek_to_line(target_content_t *content, svn_linenum_t line,
   return SVN_NO_ERROR;
 }
 
+/* Read all of CONTENT and build CONTENT->LINE_INDEX.
+ * When this function returns, neither CONTENT->CURRENT_LINE nor the file
+ * offset in the target file will have changed.
+ * Do temporary allocations in SCRATCH_POOL. */
+static svn_error_t *
+index_lines(target_content_t *content,
+            apr_pool_t *scratch_pool)
+{
+  apr_pool_t *result_pool = apr_hash_pool_get(content->keywords);
+  svn_linenum_t saved_line = content->current_line;
+  svn_boolean_t saved_eof = content->eof;
+  apr_pool_t *iterpool;
+
+  content->line_index = apr_hash_make(result_pool);
+  if (content->readline == NULL)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(seek_to_line(content, 1, scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  while (! content->eof)
+    {
+      svn_linenum_t line_number = content->current_line;
+      apr_array_header_t *line_numbers;
+      const char *line;
+      apr_uint32_t key;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(readline(content, &line, iterpool, iterpool));
+      if (content->current_line == line_number)
+        break;
+
+      key = svn__fnv1a_32(line, strlen(line));
+      line_numbers = apr_hash_get(content->line_index, &key, sizeof(key));
+      if (line_numbers == NULL)
+        {
+          line_numbers = apr_array_make(result_pool, 1,
+                                        sizeof(svn_linenum_t));
+          apr_hash_set(content->line_index,
+                       apr_pmemdup(result_pool, &key, sizeof(key)),
+                       sizeof(key), line_numbers);
+        }
+      APR_ARRAY_PUSH(line_numbers, svn_linenum_t) = line_number;
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Restore the previous position, including the EOF indicator, which
+   * seek_to_line() does not do for the line we ended up at. */
+  if (saved_line <= (svn_linenum_t)content->lines->nelts)
+    {
+      SVN_ERR(content->seek(content->read_baton,
+                            APR_ARRAY_IDX(content->lines, saved_line - 1,
+                                          apr_off_t),
+                            scratch_pool));
+      content->current_line = saved_line;
+      content->eof = saved_eof;
+    }
+  else
+    SVN_ERR(seek_to_line(content, saved_line, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Indicate in *MATCHED whether the original text of HUNK matches the patch
  * CONTENT at its current line. Lines within FUZZ lines of the start or
  * end of HUNK will always match. If IGNORE_WHITESPACE is set, we ignore
@@ -1665,6 +1735,120 @@ match_hunk(svn_boolean_t *matched, target_content_t *content,
   return SVN_NO_ERROR;
 }
 
+/* Find a line of HUNK that match_hunk() with FUZZ and IGNORE_WHITESPACE
+ * compares exactly, and thus must be found in CONTENT for HUNK to match.
+ * Return its 1-based number within HUNK in *ANCHOR and the svn__fnv1a_32()
+ * checksum of its text, with keywords contracted, in *KEY.  Set *ANCHOR to
+ * zero if there is no such line.  If MATCH_MODIFIED is TRUE, use the
+ * modified hunk text, rather than the original hunk text.
+ * Do temporary allocations in SCRATCH_POOL. */
+static svn_error_t *
+find_anchor(svn_linenum_t *anchor,
+            apr_uint32_t *key,
+            target_content_t *content,
+            svn_diff_hunk_t *hunk,
+            svn_linenum_t fuzz,
+            svn_boolean_t ignore_whitespace,
+            svn_boolean_t match_modified,
+            apr_pool_t *scratch_pool)
+{
+  svn_linenum_t hunk_length;
+  svn_linenum_t leading_context;
+  svn_linenum_t trailing_context;
+  svn_linenum_t lines_read;
+  apr_pool_t *iterpool;
+
+  *anchor = 0;
+
+  /* Whitespace-insensitive matches can't be found through the index. */
+  if (ignore_whitespace)
+    return SVN_NO_ERROR;
+
+  /* The same fuzz rules as in match_hunk() apply. */
+  fuzz -= svn_diff_hunk__get_fuzz_penalty(hunk);
+  leading_context = svn_diff_hunk_get_leading_context(hunk);
+  trailing_context = svn_diff_hunk_get_trailing_context(hunk);
+  if (match_modified)
+    {
+      svn_diff_hunk_reset_modified_text(hunk);
+      hunk_length = svn_diff_hunk_get_modified_length(hunk);
+    }
+  else
+    {
+      svn_diff_hunk_reset_original_text(hunk);
+      hunk_length = svn_diff_hunk_get_original_length(hunk);
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (lines_read = 1; lines_read <= hunk_length; lines_read++)
+    {
+      svn_stringbuf_t *hunk_line;
+      const char *hunk_line_translated;
+      svn_boolean_t hunk_eof;
+
+      svn_pool_clear(iterpool);
+
+      if (match_modified)
+        SVN_ERR(svn_diff_hunk_readline_modified_text(hunk, &hunk_line,
+                                                     NULL, &hunk_eof,
+                                                     iterpool, iterpool));
+      else
+        SVN_ERR(svn_diff_hunk_readline_original_text(hunk, &hunk_line,
+                                                     NULL, &hunk_eof,
+                                                     iterpool, iterpool));
+      if (hunk_eof && hunk_line->len == 0)
+        break;
+
+      if ((lines_read <= fuzz && leading_context > fuzz) ||
+          (lines_read > hunk_length - fuzz && trailing_context > fuzz))
+        continue;
+
+      SVN_ERR(svn_subst_translate_cstring2(hunk_line->data,
+                                           &hunk_line_translated,
+                                           NULL, FALSE,
+                                           content->keywords, FALSE,
+                                           iterpool));
+      *anchor = lines_read;
+      *key = svn__fnv1a_32(hunk_line_translated,
+                           strlen(hunk_line_translated));
+      break;
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if LINE in CONTENT lies within a hunk that has already been
+ * matched.  If MATCH_MODIFIED is TRUE, use the lengths of the modified
+ * hunk texts, rather than the original hunk texts. */
+static svn_boolean_t
+line_is_taken(const target_content_t *content,
+              svn_linenum_t line,
+              svn_boolean_t match_modified)
+{
+  int i;
+
+  for (i = 0; i < content->hunks->nelts; i++)
+    {
+      const hunk_info_t *hi;
+      svn_linenum_t length;
+
+      hi = APR_ARRAY_IDX(content->hunks, i, const hunk_info_t *);
+
+      if (match_modified)
+        length = svn_diff_hunk_get_modified_length(hi->hunk);
+      else
+        length = svn_diff_hunk_get_original_length(hi->hunk);
+
+      if (! hi->rejected &&
+          line >= hi->matched_line &&
+          line < (hi->matched_line + length))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
 /* Scan lines of CONTENT for a match of the original text of HUNK,
  * up to but not including the specified UPPER_LINE. Use fuzz factor FUZZ.
  * If UPPER_LINE is zero scan until EOF occurs when reading from TARGET.
@@ -1677,6 +1861,8 @@ match_hunk(svn_boolean_t *matched, target_content_t *content,
  * If IGNORE_WHITESPACE is set, ignore whitespace during the matching.
  * If MATCH_MODIFIED is TRUE, match the modified hunk text,
  * rather than the original hunk text.
+ * Lines that can't start a match according to CONTENT->LINE_INDEX are
+ * skipped without reading them.
  * Call cancel CANCEL_FUNC with baton CANCEL_BATON to trigger cancellation.
  * Do all allocations in POOL. */
 static svn_error_t *
@@ -1690,54 +1876,98 @@ scan_for_match(svn_linenum_t *matched_line,
                apr_pool_t *pool)
 {
   apr_pool_t *iterpool;
+  svn_linenum_t anchor;
+  apr_uint32_t key;
 
   *matched_line = 0;
+
+  /* Such a hunk never matches, see match_hunk(). */
+  if (svn_diff_hunk__get_fuzz_penalty(hunk) > fuzz)
+    return SVN_NO_ERROR;
+
   iterpool = svn_pool_create(pool);
-  while ((content->current_line < upper_line || upper_line == 0) &&
-         ! content->eof)
+
+  /* Unless we only need to try a single line, only try the lines where
+   * the anchor line of HUNK would end up at a line with the same text.
+   * Without an anchor line, we need to try all lines. */
+  if (upper_line == 0 || upper_line > content->current_line + 1)
+    SVN_ERR(find_anchor(&anchor, &key, content, hunk, fuzz,
+                        ignore_whitespace, match_modified, iterpool));
+  else
+    anchor = 0;
+
+  if (anchor > 0)
     {
-      svn_boolean_t matched;
+      svn_linenum_t start_line = content->current_line;
+      const apr_array_header_t *line_numbers;
+      int i;
 
-      svn_pool_clear(iterpool);
+      if (content->eof)
+        {
+          svn_pool_destroy(iterpool);
+          return SVN_NO_ERROR;
+        }
 
-      if (cancel_func)
-        SVN_ERR(cancel_func(cancel_baton));
+      if (content->line_index == NULL)
+        SVN_ERR(index_lines(content, iterpool));
 
-      SVN_ERR(match_hunk(&matched, content, hunk, fuzz, ignore_whitespace,
-                         match_modified, iterpool));
-      if (matched)
+      line_numbers = apr_hash_get(content->line_index, &key, sizeof(key));
+      for (i = 0; line_numbers && i < line_numbers->nelts; i++)
         {
-          svn_boolean_t taken = FALSE;
-          int i;
+          svn_linenum_t line = APR_ARRAY_IDX(line_numbers, i, svn_linenum_t);
+          svn_boolean_t matched;
 
-          /* Don't allow hunks to match at overlapping locations. */
-          for (i = 0; i < content->hunks->nelts; i++)
-            {
-              const hunk_info_t *hi;
-              svn_linenum_t length;
+          if (line < anchor || line - (anchor - 1) < start_line)
+            continue;
 
-              hi = APR_ARRAY_IDX(content->hunks, i, const hunk_info_t *);
+          line -= anchor - 1;
+          if (upper_line != 0 && line >= upper_line)
+            break;
 
-              if (match_modified)
-                length = svn_diff_hunk_get_modified_length(hi->hunk);
-              else
-                length = svn_diff_hunk_get_original_length(hi->hunk);
+          svn_pool_clear(iterpool);
 
-              taken = (! hi->rejected &&
-                       content->current_line >= hi->matched_line &&
-                       content->current_line < (hi->matched_line + length));
-              if (taken)
-                break;
-            }
+          if (cancel_func)
+            SVN_ERR(cancel_func(cancel_baton));
+
+          SVN_ERR(seek_to_line(content, line, iterpool));
+          SVN_ERR(match_hunk(&matched, content, hunk, fuzz,
+                             ignore_whitespace, match_modified, iterpool));
 
-          if (! taken)
+          /* Don't allow hunks to match at overlapping locations. */
+          if (matched && ! line_is_taken(content, line, match_modified))
             {
-              *matched_line = content->current_line;
+              *matched_line = line;
               if (match_first)
                 break;
             }
         }
 
+      svn_pool_destroy(iterpool);
+      return SVN_NO_ERROR;
+    }
+
+  while ((content->current_line < upper_line || upper_line == 0) &&
+         ! content->eof)
+    {
+      svn_boolean_t matched;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(match_hunk(&matched, content, hunk, fuzz, ignore_whitespace,
+                         match_modified, iterpool));
+
+      /* Don't allow hunks to match at overlapping locations. */
+      if (matched
+          && ! line_is_taken(content, content->current_line, match_modified))
+        {
+          *matched_line = content->current_line;
+          if (match_first)
+            break;
+        }
+
       if (! content->eof)
         SVN_ERR(seek_to_line(content, content->current_line + 1,
                              iterpool));
@@ -316,30 +316,58 @@ progress_func(apr_off_t progress,
     }
 }
 
-#define SVN_CLIENT__MAX_REDIRECT_ATTEMPTS 3 /* ### TODO:  Make configurable. */
-
-svn_error_t *
-svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
-                                     const char **corrected_url,
-                                     const char *base_url,
-                                     const char *base_dir_abspath,
-                                     const apr_array_header_t *commit_items,
-                                     svn_boolean_t write_dav_props,
-                                     svn_boolean_t read_dav_props,
-                                     svn_client_ctx_t *ctx,
-                                     apr_pool_t *result_pool,
-                                     apr_pool_t *scratch_pool)
+/* A session kept open by a client context for later operations on the
+   same repository. */
+typedef struct cached_ra_session_t
 {
+  svn_ra_session_t *session;
+
+  /* The pool of SESSION and of the callbacks below. */
+  apr_pool_t *pool;
+
+  /* The callbacks SESSION was opened with.  They get filled in again
+     whenever the session gets reused. */
   svn_ra_callbacks2_t *cbtable;
-  callback_baton_t *cb = apr_pcalloc(result_pool, sizeof(*cb));
-  const char *uuid = NULL;
+  callback_baton_t *cb;
 
-  SVN_ERR_ASSERT(!write_dav_props || read_dav_props);
-  SVN_ERR_ASSERT(!read_dav_props || base_dir_abspath != NULL);
-  SVN_ERR_ASSERT(base_dir_abspath == NULL
-                        || svn_dirent_is_absolute(base_dir_abspath));
+  const char *repos_root_url;
+  const char *uuid;
+
+  /* What SESSION depends on in the client context at the time it was
+     opened. */
+  svn_auth_baton_t *auth_baton;
+  apr_hash_t *config;
+  svn_boolean_t cancellable;
+
+  /* Is an operation using SESSION?  If not, since when is it idle? */
+  svn_boolean_t in_use;
+  apr_time_t released;
+} cached_ra_session_t;
+
+/* Close idle sessions after this time. */
+#define RA_SESSION_IDLE_TIMEOUT apr_time_from_sec(60)
+
+/* Don't keep more idle sessions than this per client context. */
+#define MAX_IDLE_RA_SESSIONS 8
+
+/* Fill in CBTABLE and CB for a session opened by
+   svn_client__open_ra_session_internal() with the arguments of the
+   same names.  Set *UUID to the UUID of the working copy at
+   BASE_DIR_ABSPATH or to NULL if the DAV properties are not used. */
+static svn_error_t *
+setup_callbacks(const char **uuid,
+                svn_ra_callbacks2_t *cbtable,
+                callback_baton_t *cb,
+                const char *base_dir_abspath,
+                const apr_array_header_t *commit_items,
+                svn_boolean_t write_dav_props,
+                svn_boolean_t read_dav_props,
+                svn_client_ctx_t *ctx,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  *uuid = NULL;
 
-  SVN_ERR(svn_ra_create_callbacks(&cbtable, result_pool));
   cbtable->open_tmp_file = open_tmp_file;
   cbtable->get_wc_prop = read_dav_props ? get_wc_prop : NULL;
   cbtable->set_wc_prop = (write_dav_props && read_dav_props)
@@ -352,18 +380,20 @@ svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
   cbtable->progress_baton = cb;
   cbtable->cancel_func = ctx->cancel_func ? cancel_callback : NULL;
   cbtable->get_client_string = get_client_string;
-  if (base_dir_abspath)
-    cbtable->get_wc_contents = get_wc_contents;
+  cbtable->get_wc_contents = base_dir_abspath ? get_wc_contents : NULL;
   cbtable->check_tunnel_func = ctx->check_tunnel_func;
   cbtable->open_tunnel_func = ctx->open_tunnel_func;
   cbtable->tunnel_baton = ctx->tunnel_baton;
 
   cb->commit_items = commit_items;
   cb->ctx = ctx;
+  cb->base_dir_abspath = NULL;
+  cb->base_dir_isversioned = FALSE;
+  cb->wcroot_abspath = NULL;
 
   if (base_dir_abspath && (read_dav_props || write_dav_props))
     {
-      svn_error_t *err = svn_wc__node_get_repos_info(NULL, NULL, NULL, &uuid,
+      svn_error_t *err = svn_wc__node_get_repos_info(NULL, NULL, NULL, uuid,
                                                      ctx->wc_ctx,
                                                      base_dir_abspath,
                                                      result_pool,
@@ -374,7 +404,7 @@ svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
                   || err->apr_err == SVN_ERR_WC_UPGRADE_REQUIRED))
         {
           svn_error_clear(err);
-          uuid = NULL;
+          *uuid = NULL;
         }
       else
         {
@@ -402,6 +432,204 @@ svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
         }
     }
 
+  return SVN_NO_ERROR;
+}
+
+/* Pool cleanup handler that makes the cached_ra_session_t BATON
+   available for reuse.  This may run after the pool of the session has
+   been destroyed as part of the pool of the client context, so it must
+   not touch anything but BATON itself. */
+static apr_status_t
+release_ra_session(void *baton)
+{
+  cached_ra_session_t *cached = baton;
+
+  cached->in_use = FALSE;
+  cached->released = apr_time_now();
+
+  return APR_SUCCESS;
+}
+
+/* Close the cached session at index IDX of SESSIONS. */
+static svn_error_t *
+close_cached_ra_session(apr_array_header_t *sessions,
+                        int idx)
+{
+  cached_ra_session_t *cached = APR_ARRAY_IDX(sessions, idx,
+                                              cached_ra_session_t *);
+
+  svn_pool_destroy(cached->pool);
+
+  return svn_error_trace(svn_sort__array_delete2(sessions, idx, 1));
+}
+
+/* Mark CACHED as used until RESULT_POOL gets cleared. */
+static void
+acquire_ra_session(cached_ra_session_t *cached,
+                   apr_pool_t *result_pool)
+{
+  cached->in_use = TRUE;
+  apr_pool_cleanup_register(result_pool, cached, release_ra_session,
+                            apr_pool_cleanup_null);
+}
+
+/* Set *RA_SESSION to an idle session of CTX that can serve BASE_URL,
+   reparented to BASE_URL and set up like svn_client__open_ra_session_internal()
+   would for the other arguments.  The session is in use until RESULT_POOL
+   gets cleared.  Set *RA_SESSION to NULL if there is no such session.
+
+   Close sessions that have been idle for too long. */
+static svn_error_t *
+reuse_ra_session(svn_ra_session_t **ra_session,
+                 const char *base_url,
+                 const char *base_dir_abspath,
+                 svn_boolean_t write_dav_props,
+                 svn_boolean_t read_dav_props,
+                 svn_client_ctx_t *ctx,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *sessions = svn_client__get_private_ctx(ctx)->ra_sessions;
+  apr_time_t now = apr_time_now();
+  int i;
+
+  *ra_session = NULL;
+
+  if (!sessions)
+    return SVN_NO_ERROR;
+
+  for (i = 0; i < sessions->nelts; i++)
+    {
+      cached_ra_session_t *cached = APR_ARRAY_IDX(sessions, i,
+                                                  cached_ra_session_t *);
+      const char *uuid;
+      svn_error_t *err;
+
+      if (cached->in_use)
+        continue;
+
+      if (now - cached->released > RA_SESSION_IDLE_TIMEOUT)
+        {
+          SVN_ERR(close_cached_ra_session(sessions, i--));
+          continue;
+        }
+
+      if (*ra_session
+          || cached->auth_baton != ctx->auth_baton
+          || cached->config != ctx->config
+          || cached->cancellable != (ctx->cancel_func != NULL)
+          || !svn_uri__is_ancestor(cached->repos_root_url, base_url))
+        continue;
+
+      SVN_ERR(setup_callbacks(&uuid, cached->cbtable, cached->cb,
+                              base_dir_abspath, NULL, write_dav_props,
+                              read_dav_props, ctx, result_pool,
+                              scratch_pool));
+
+      /* Leave reporting the mismatch to svn_ra_open5(). */
+      if (uuid && strcmp(uuid, cached->uuid) != 0)
+        continue;
+
+      /* The connection may have gone bad while the session was idle. */
+      err = svn_ra_reparent(cached->session, base_url, scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          SVN_ERR(close_cached_ra_session(sessions, i--));
+          continue;
+        }
+
+      acquire_ra_session(cached, result_pool);
+      *ra_session = cached->session;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Add RA_SESSION, allocated in SESSION_POOL and opened with CBTABLE and
+   CB, to the cached sessions of CTX and mark it in use until RESULT_POOL
+   gets cleared.  Close the longest idle sessions if there are too many. */
+static svn_error_t *
+add_cached_ra_session(svn_ra_session_t *ra_session,
+                      svn_ra_callbacks2_t *cbtable,
+                      callback_baton_t *cb,
+                      apr_pool_t *session_pool,
+                      svn_client_ctx_t *ctx,
+                      apr_pool_t *result_pool)
+{
+  svn_client__private_ctx_t *private_ctx = svn_client__get_private_ctx(ctx);
+  cached_ra_session_t *cached;
+  int idle = 0;
+  int i;
+
+  /* The entry must survive SESSION_POOL, see release_ra_session(). */
+  cached = apr_pcalloc(private_ctx->pool, sizeof(*cached));
+  cached->session = ra_session;
+  cached->pool = session_pool;
+  cached->cbtable = cbtable;
+  cached->cb = cb;
+  cached->auth_baton = ctx->auth_baton;
+  cached->config = ctx->config;
+  cached->cancellable = (ctx->cancel_func != NULL);
+
+  SVN_ERR(svn_ra_get_repos_root2(ra_session, &cached->repos_root_url,
+                                 session_pool));
+  SVN_ERR(svn_ra_get_uuid2(ra_session, &cached->uuid, session_pool));
+
+  if (!private_ctx->ra_sessions)
+    private_ctx->ra_sessions = apr_array_make(private_ctx->pool, 4,
+                                              sizeof(cached));
+
+  for (i = 0; i < private_ctx->ra_sessions->nelts; i++)
+    if (!APR_ARRAY_IDX(private_ctx->ra_sessions, i,
+                       cached_ra_session_t *)->in_use)
+      idle++;
+
+  while (idle >= MAX_IDLE_RA_SESSIONS)
+    {
+      int oldest = -1;
+
+      for (i = 0; i < private_ctx->ra_sessions->nelts; i++)
+        {
+          cached_ra_session_t *other
+            = APR_ARRAY_IDX(private_ctx->ra_sessions, i,
+                            cached_ra_session_t *);
+
+          if (!other->in_use
+              && (oldest < 0
+                  || other->released < APR_ARRAY_IDX(private_ctx->ra_sessions,
+                                                     oldest,
+                                                     cached_ra_session_t *)
+                                         ->released))
+            oldest = i;
+        }
+
+      SVN_ERR(close_cached_ra_session(private_ctx->ra_sessions, oldest));
+      idle--;
+    }
+
+  acquire_ra_session(cached, result_pool);
+  APR_ARRAY_PUSH(private_ctx->ra_sessions, cached_ra_session_t *) = cached;
+
+  return SVN_NO_ERROR;
+}
+
+#define SVN_CLIENT__MAX_REDIRECT_ATTEMPTS 3 /* ### TODO:  Make configurable. */
+
+/* Open *RA_SESSION for BASE_URL with CBTABLE and CB, following redirects
+   if CORRECTED_URL is not NULL, like svn_client__open_ra_session_internal()
+   does.  Allocate the session in RESULT_POOL. */
+static svn_error_t *
+open_ra_session(svn_ra_session_t **ra_session,
+                const char **corrected_url,
+                const char *base_url,
+                const char *uuid,
+                svn_ra_callbacks2_t *cbtable,
+                callback_baton_t *cb,
+                svn_client_ctx_t *ctx,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
   /* If the caller allows for auto-following redirections, try the new URL.
      We'll do this in a loop up to some maximum number follow-and-retry
      attempts.  */
@@ -471,6 +699,70 @@ svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
 }
 #undef SVN_CLIENT__MAX_REDIRECT_ATTEMPTS
 
+svn_error_t *
+svn_client__open_ra_session_internal(svn_ra_session_t **ra_session,
+                                     const char **corrected_url,
+                                     const char *base_url,
+                                     const char *base_dir_abspath,
+                                     const apr_array_header_t *commit_items,
+                                     svn_boolean_t write_dav_props,
+                                     svn_boolean_t read_dav_props,
+                                     svn_client_ctx_t *ctx,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool)
+{
+  svn_client__private_ctx_t *private_ctx = svn_client__get_private_ctx(ctx);
+  apr_pool_t *session_pool = result_pool;
+  svn_ra_callbacks2_t *cbtable;
+  callback_baton_t *cb;
+  const char *uuid;
+  svn_error_t *err;
+
+  SVN_ERR_ASSERT(!write_dav_props || read_dav_props);
+  SVN_ERR_ASSERT(!read_dav_props || base_dir_abspath != NULL);
+  SVN_ERR_ASSERT(base_dir_abspath == NULL
+                        || svn_dirent_is_absolute(base_dir_abspath));
+
+  /* Keep the session open for later operations of CTX, unless it is bound
+     to the items of a commit or it could outlive CTX. */
+  if (!commit_items && apr_pool_is_ancestor(private_ctx->pool, result_pool))
+    {
+      SVN_ERR(reuse_ra_session(ra_session, base_url, base_dir_abspath,
+                               write_dav_props, read_dav_props, ctx,
+                               result_pool, scratch_pool));
+      if (*ra_session)
+        {
+          if (corrected_url)
+            *corrected_url = NULL;
+
+          return SVN_NO_ERROR;
+        }
+
+      session_pool = svn_pool_create(private_ctx->pool);
+    }
+
+  SVN_ERR(svn_ra_create_callbacks(&cbtable, session_pool));
+  cb = apr_pcalloc(session_pool, sizeof(*cb));
+
+  err = setup_callbacks(&uuid, cbtable, cb, base_dir_abspath, commit_items,
+                        write_dav_props, read_dav_props, ctx, result_pool,
+                        scratch_pool);
+  if (!err)
+    err = open_ra_session(ra_session, corrected_url, base_url, uuid,
+                          cbtable, cb, ctx, session_pool, scratch_pool);
+
+  if (session_pool != result_pool)
+    {
+      if (!err && *ra_session)
+        err = add_cached_ra_session(*ra_session, cbtable, cb, session_pool,
+                                    ctx, result_pool);
+      else
+        svn_pool_destroy(session_pool);
+    }
+
+  return svn_error_trace(err);
+}
+
 
 svn_error_t *
 svn_client_open_ra_session2(svn_ra_session_t **session,
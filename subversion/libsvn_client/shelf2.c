@@ -43,6 +43,7 @@
 #include "client.h"
 #include "private/svn_client_shelf2.h"
 #include "private/svn_client_private.h"
+#include "private/svn_io_private.h"
 #include "private/svn_wc_private.h"
 #include "private/svn_sorts_private.h"
 #include "svn_private_config.h"
@@ -260,6 +261,141 @@ get_working_props_abspath(char **work_abspath,
   return SVN_NO_ERROR;
 }
 
+/* File texts are stored only once per shelves directory, in the "blobs"
+ * subdirectory, named after the SHA-1 checksum of their contents.  The
+ * '.base' and '.work' files of the shelf versions are hard links to these
+ * blobs, so that unchanged files in a new shelf version cost neither disk
+ * space nor a copy.  Blobs that are no longer linked from any shelf
+ * version get removed by blobs_cleanup().  If the filesystem does not
+ * support hard links, the shelf versions get copies of the blobs.
+ */
+
+/* Return the abspath of the blobs directory in SHELVES_DIR. */
+static const char *
+get_blobs_dir(const char *shelves_dir,
+              apr_pool_t *result_pool)
+{
+  return svn_dirent_join(shelves_dir, "blobs", result_pool);
+}
+
+/* Store the text of STORED_ABSPATH in SHELF_VERSION.  If WC_ABSPATH is
+ * not NULL, the text is that of the working file WC_ABSPATH; otherwise it
+ * is that of the pristine PRISTINE_ABSPATH, opened through CTX.  Only
+ * copy the text into the blob store if it is not there already.
+ */
+static svn_error_t *
+store_text(const char *stored_abspath,
+           const char *wc_abspath,
+           const char *pristine_abspath,
+           svn_client__shelf2_version_t *shelf_version,
+           svn_client_ctx_t *ctx,
+           apr_pool_t *scratch_pool)
+{
+  const char *blobs_dir = get_blobs_dir(shelf_version->shelf->shelves_dir,
+                                        scratch_pool);
+  const char *blob_abspath;
+  svn_checksum_t *checksum;
+  svn_stream_t *stream;
+  svn_node_kind_t kind;
+  svn_error_t *err;
+
+  if (wc_abspath)
+    SVN_ERR(svn_io_file_checksum2(&checksum, wc_abspath, svn_checksum_sha1,
+                                  scratch_pool));
+  else
+    {
+      SVN_ERR(svn_wc_get_pristine_contents2(&stream, ctx->wc_ctx,
+                                            pristine_abspath,
+                                            scratch_pool, scratch_pool));
+      SVN_ERR(svn_stream_contents_checksum(&checksum, stream,
+                                           svn_checksum_sha1,
+                                           scratch_pool, scratch_pool));
+    }
+
+  blob_abspath = svn_dirent_join(blobs_dir,
+                                 svn_checksum_to_cstring_display(checksum,
+                                                                 scratch_pool),
+                                 scratch_pool);
+  SVN_ERR(svn_io_check_path(blob_abspath, &kind, scratch_pool));
+  if (kind == svn_node_none)
+    {
+      SVN_ERR(svn_io_make_dir_recursively(blobs_dir, scratch_pool));
+      if (wc_abspath)
+        {
+          /* This goes through a temporary file, so no one will see a
+             partially written blob. */
+          SVN_ERR(svn_io_copy_file(wc_abspath, blob_abspath,
+                                   TRUE /*copy_perms*/, scratch_pool));
+        }
+      else
+        {
+          svn_stream_t *blob_stream;
+          const char *tmp_abspath;
+
+          SVN_ERR(svn_wc_get_pristine_contents2(&stream, ctx->wc_ctx,
+                                                pristine_abspath,
+                                                scratch_pool, scratch_pool));
+          SVN_ERR(svn_stream_open_unique(&blob_stream, &tmp_abspath,
+                                         blobs_dir, svn_io_file_del_none,
+                                         scratch_pool, scratch_pool));
+          SVN_ERR(svn_stream_copy3(stream, blob_stream, NULL, NULL,
+                                   scratch_pool));
+          SVN_ERR(svn_io_file_rename2(tmp_abspath, blob_abspath, FALSE,
+                                      scratch_pool));
+        }
+    }
+
+  err = svn_io__file_link(blob_abspath, stored_abspath, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      SVN_ERR(svn_io_copy_file(blob_abspath, stored_abspath,
+                               TRUE /*copy_perms*/, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove the blobs in SHELVES_DIR that are not linked from any shelf
+ * version anymore.
+ */
+static svn_error_t *
+blobs_cleanup(const char *shelves_dir,
+              apr_pool_t *scratch_pool)
+{
+  const char *blobs_dir = get_blobs_dir(shelves_dir, scratch_pool);
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool;
+  svn_error_t *err;
+
+  err = svn_io_get_dirents3(&dirents, blobs_dir, TRUE /*only_check_type*/,
+                            scratch_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *abspath;
+      apr_finfo_t finfo;
+
+      svn_pool_clear(iterpool);
+      abspath = svn_dirent_join(blobs_dir, apr_hash_this_key(hi), iterpool);
+      SVN_ERR(svn_io_stat(&finfo, abspath, APR_FINFO_NLINK, iterpool));
+      if (finfo.nlink <= 1)
+        SVN_ERR(svn_io_remove_file2(abspath, TRUE /*ignore_enoent*/,
+                                    iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Delete the storage for SHELF:VERSION. */
 static svn_error_t *
 shelf_version_delete(svn_client__shelf2_t *shelf,
@@ -927,8 +1063,8 @@ read_props_from_shelf(apr_hash_t **base_props,
 
 /* Store metadata for any node, and base and working files if it's a file.
  *
- * Copy the WC base and working files at FROM_WC_ABSPATH to the storage
- * area in SHELF_VERSION.
+ * Store the WC base and working files at FROM_WC_ABSPATH in the storage
+ * area of SHELF_VERSION, sharing their texts with other shelf versions.
  */
 static svn_error_t *
 store_file(const char *from_wc_abspath,
@@ -965,31 +1101,28 @@ store_file(const char *from_wc_abspath,
       svn_stream_t *wc_base_stream;
       svn_node_kind_t work_kind;
 
-      /* Copy the base file (copy-from base, if copied/moved), if present */
+      /* Store the base file (copy-from base, if copied/moved), if present */
       SVN_ERR(svn_wc_get_pristine_contents2(&wc_base_stream,
                                             ctx->wc_ctx, from_wc_abspath,
                                             scratch_pool, scratch_pool));
       if (wc_base_stream)
         {
           char *stored_base_abspath;
-          svn_stream_t *stored_base_stream;
 
+          SVN_ERR(svn_stream_close(wc_base_stream));
           SVN_ERR(get_base_file_abspath(&stored_base_abspath,
                                         shelf_version, wc_relpath,
                                         scratch_pool, scratch_pool));
-          SVN_ERR(svn_stream_open_writable(&stored_base_stream,
-                                           stored_base_abspath,
-                                           scratch_pool, scratch_pool));
-          SVN_ERR(svn_stream_copy3(wc_base_stream, stored_base_stream,
-                                   NULL, NULL, scratch_pool));
+          SVN_ERR(store_text(stored_base_abspath, NULL, from_wc_abspath,
+                             shelf_version, ctx, scratch_pool));
         }
 
-      /* Copy the working file, if present */
+      /* Store the working file, if present */
       SVN_ERR(svn_io_check_path(from_wc_abspath, &work_kind, scratch_pool));
       if (work_kind == svn_node_file)
         {
-          SVN_ERR(svn_io_copy_file(from_wc_abspath, stored_abspath,
-                                   TRUE /*copy_perms*/, scratch_pool));
+          SVN_ERR(store_text(stored_abspath, from_wc_abspath, NULL,
+                             shelf_version, ctx, scratch_pool));
         }
     }
   return SVN_NO_ERROR;
@@ -1284,6 +1417,7 @@ svn_client__shelf2_delete(const char *name,
     {
       SVN_ERR(shelf_version_delete(shelf, i, scratch_pool));
     }
+  SVN_ERR(blobs_cleanup(shelf->shelves_dir, scratch_pool));
 
   /* Remove the other files */
   SVN_ERR(get_log_abspath(&abspath, shelf, scratch_pool, scratch_pool));
@@ -1915,6 +2049,7 @@ svn_client__shelf2_delete_newer_versions(svn_client__shelf2_t *shelf,
     {
       SVN_ERR(shelf_version_delete(shelf, i, scratch_pool));
     }
+  SVN_ERR(blobs_cleanup(shelf->shelves_dir, scratch_pool));
 
   shelf->max_version = previous_version;
   SVN_ERR(shelf_write_current(shelf, scratch_pool));
@@ -39,6 +39,7 @@
 
 #include "svn_private_config.h"
 #include "private/svn_wc_private.h"
+#include "private/svn_trace.h"
 
 
 /*** Code. ***/
@@ -471,16 +472,19 @@ svn_client_switch3(svn_revnum_t *result_rev,
 {
   svn_error_t *err;
   svn_boolean_t sleep_here = FALSE;
+  svn_trace__span_t *span;
 
   if (svn_path_is_url(path))
     return svn_error_createf(SVN_ERR_ILLEGAL_TARGET, NULL,
                              _("'%s' is not a local path"), path);
 
+  span = svn_trace__begin("client", "switch", pool);
   err = svn_client__switch_internal(result_rev, path, switch_url,
                                     peg_revision, revision, depth,
                                     depth_is_sticky, ignore_externals,
                                     allow_unver_obstructions,
                                     ignore_ancestry, &sleep_here, ctx, pool);
+  svn_trace__end(span);
 
   /* Sleep to ensure timestamp integrity (we do this regardless of
      errors in the actual switch operation(s)). */
@@ -24,6 +24,8 @@
 #include "svn_path.h"
 #include "svn_wc.h"
 
+#include "private/svn_wc_private.h"
+
 #include "client.h"
 
 /* A baton for use with textbase_fetch_cb(). */
@@ -35,41 +37,90 @@ typedef struct textbase_fetch_baton_t
   svn_ra_session_t *ra_session;
 } textbase_fetch_baton_t;
 
-/* Implements svn_wc_textbase_fetch_cb_t. */
+/* Implements svn_wc__textbase_fetch_batch_cb_t. */
 static svn_error_t *
 textbase_fetch_cb(void *baton,
-                  const char *repos_root_url,
-                  const char *repos_relpath,
-                  svn_revnum_t revision,
-                  svn_stream_t *contents,
+                  const apr_array_header_t *fetches,
                   svn_cancel_func_t cancel_func,
                   void *cancel_baton,
                   apr_pool_t *scratch_pool)
 {
   struct textbase_fetch_baton_t *b = baton;
+  const svn_wc__textbase_fetch_t *fetch;
+  apr_array_header_t *ra_fetches;
+  const char *parent_relpath;
   const char *url;
   const char *old_url;
+  svn_error_t *err;
+  int i;
+
+  if (fetches->nelts == 0)
+    return SVN_NO_ERROR;
+
+  /* Fetch everything relative to the closest common parent, so that a
+     single file is still fetched from its own URL as before. */
+  fetch = APR_ARRAY_IDX(fetches, 0, const svn_wc__textbase_fetch_t *);
+  parent_relpath = fetch->repos_relpath;
+  for (i = 1; i < fetches->nelts; i++)
+    {
+      fetch = APR_ARRAY_IDX(fetches, i, const svn_wc__textbase_fetch_t *);
+      parent_relpath = svn_relpath_get_longest_ancestor(parent_relpath,
+                                                        fetch->repos_relpath,
+                                                        scratch_pool);
+    }
 
-  url = svn_path_url_add_component2(repos_root_url, repos_relpath,
+  url = svn_path_url_add_component2(fetch->repos_root_url, parent_relpath,
                                     scratch_pool);
 
   if (!b->ra_session)
     {
       svn_ra_session_t *session;
 
-      SVN_ERR(svn_client__open_ra_session_internal(&session, NULL,
-                                                   url, b->base_abspath,
-                                                   NULL, TRUE, TRUE, b->ctx,
-                                                   b->result_pool, scratch_pool));
+      err = svn_client__open_ra_session_internal(&session, NULL,
+                                                 url, b->base_abspath,
+                                                 NULL, TRUE, TRUE, b->ctx,
+                                                 b->result_pool,
+                                                 scratch_pool);
+      if (err)
+        goto close_streams;
+
       b->ra_session = session;
     }
 
-  SVN_ERR(svn_client__ensure_ra_session_url(&old_url, b->ra_session, url,
-                                            scratch_pool));
-  SVN_ERR(svn_ra_fetch_file_contents(b->ra_session, "", revision, contents,
-                                     scratch_pool));
+  err = svn_client__ensure_ra_session_url(&old_url, b->ra_session, url,
+                                          scratch_pool);
+  if (err)
+    goto close_streams;
 
-  return SVN_NO_ERROR;
+  ra_fetches = apr_array_make(scratch_pool, fetches->nelts,
+                              sizeof(svn_ra_file_fetch_t *));
+  for (i = 0; i < fetches->nelts; i++)
+    {
+      svn_ra_file_fetch_t *ra_fetch = apr_pcalloc(scratch_pool,
+                                                  sizeof(*ra_fetch));
+
+      fetch = APR_ARRAY_IDX(fetches, i, const svn_wc__textbase_fetch_t *);
+      ra_fetch->path = svn_relpath_skip_ancestor(parent_relpath,
+                                                 fetch->repos_relpath);
+      ra_fetch->revision = fetch->revision;
+      ra_fetch->stream = fetch->contents;
+
+      APR_ARRAY_PUSH(ra_fetches, svn_ra_file_fetch_t *) = ra_fetch;
+    }
+
+  /* This closes all of the streams. */
+  return svn_error_trace(svn_ra_fetch_files_contents(b->ra_session,
+                                                     ra_fetches,
+                                                     scratch_pool));
+
+ close_streams:
+  for (i = 0; i < fetches->nelts; i++)
+    {
+      fetch = APR_ARRAY_IDX(fetches, i, const svn_wc__textbase_fetch_t *);
+      err = svn_error_compose_create(err, svn_stream_close(fetch->contents));
+    }
+
+  return svn_error_trace(err);
 }
 
 svn_error_t *
@@ -102,12 +153,12 @@ svn_client__textbase_sync(svn_ra_session_t **ra_session_p,
   if (ra_session)
     SVN_ERR(svn_ra_get_session_url(ra_session, &old_session_url, scratch_pool));
 
-  SVN_ERR(svn_wc_textbase_sync(ctx->wc_ctx, local_abspath,
-                               allow_hydrate, allow_dehydrate,
-                               textbase_fetch_cb, &fetch_baton,
-                               ctx->cancel_func, ctx->cancel_baton,
-                               ctx->notify_func2, ctx->notify_baton2,
-                               scratch_pool));
+  SVN_ERR(svn_wc__textbase_sync(ctx->wc_ctx, local_abspath,
+                                allow_hydrate, allow_dehydrate,
+                                textbase_fetch_cb, &fetch_baton,
+                                ctx->cancel_func, ctx->cancel_baton,
+                                ctx->notify_func2, ctx->notify_baton2,
+                                scratch_pool));
 
   if (ra_session)
     SVN_ERR(svn_ra_reparent(ra_session, old_session_url, scratch_pool));
@@ -41,6 +41,7 @@
 
 #include "svn_private_config.h"
 #include "private/svn_wc_private.h"
+#include "private/svn_trace.h"
 
 /* Implements svn_wc_dirents_func_t for update and switch handling. Assumes
    a struct svn_client__dirent_fetcher_baton_t * baton */
@@ -759,6 +760,7 @@ svn_client_update4(apr_array_header_t **result_revs,
     {
       svn_revnum_t result_rev;
       const char *local_abspath;
+      svn_trace__span_t *span;
       path = APR_ARRAY_IDX(paths, i, const char *);
 
       svn_pool_clear(iterpool);
@@ -773,6 +775,8 @@ svn_client_update4(apr_array_header_t **result_revs,
       err = svn_dirent_get_absolute(&local_abspath, path, iterpool);
       if (err)
         goto cleanup;
+
+      span = svn_trace__begin("client", "update", iterpool);
       err = svn_client__update_internal(&result_rev, &sleep, local_abspath,
                                         revision, depth, depth_is_sticky,
                                         ignore_externals,
@@ -781,6 +785,7 @@ svn_client_update4(apr_array_header_t **result_revs,
                                         make_parents,
                                         FALSE, NULL, ctx,
                                         iterpool);
+      svn_trace__end(span);
 
       if (err)
         {
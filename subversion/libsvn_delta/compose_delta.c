@@ -24,11 +24,10 @@
 
 #include <assert.h>
 
-#include <apr_general.h>        /* For APR_INLINE */
-
 #include "svn_delta.h"
 #include "svn_pools.h"
 #include "delta.h"
+#include "private/svn_subr_private.h"
 
 /* Define a MIN macro if this platform doesn't already have one. */
 #ifndef MIN
@@ -89,41 +88,11 @@ struct range_list_node_t
 
 
 /* This is what will be allocated: */
-typedef union alloc_block_t alloc_block_t;
-union alloc_block_t
+typedef union alloc_block_t
 {
   range_index_node_t index_node;
   range_list_node_t list_node;
-
-  /* Links free blocks into a freelist. */
-  alloc_block_t *next_free;
-};
-
-
-/* Allocate a block. */
-static APR_INLINE void *
-alloc_block(apr_pool_t *pool, alloc_block_t **free_list)
-{
-  alloc_block_t *block;
-  if (*free_list == NULL)
-    block = apr_palloc(pool, sizeof(*block));
-  else
-    {
-      block = *free_list;
-      *free_list = block->next_free;
-    }
-  return block;
-}
-
-/* Return the block back to the free list. */
-static APR_INLINE void
-free_block(void *ptr, alloc_block_t **free_list)
-{
-  /* Wrapper functions take care of type safety. */
-  alloc_block_t *const block = ptr;
-  block->next_free = *free_list;
-  *free_list = block;
-}
+} alloc_block_t;
 
 
 
@@ -216,8 +185,9 @@ search_offset_index(const offset_index_t *ndx,
 typedef struct range_index_t
 {
   range_index_node_t *tree;
-  alloc_block_t *free_list;
-  apr_pool_t *pool;
+
+  /* Allocates and recycles the nodes of the tree and of range lists. */
+  svn_slab__t *blocks;
 } range_index_t;
 
 /* Create a range index tree. Allocate from POOL. */
@@ -226,8 +196,7 @@ create_range_index(apr_pool_t *pool)
 {
   range_index_t *ndx = apr_palloc(pool, sizeof(*ndx));
   ndx->tree = NULL;
-  ndx->pool = pool;
-  ndx->free_list = NULL;
+  ndx->blocks = svn_slab__create(sizeof(alloc_block_t), pool);
   return ndx;
 }
 
@@ -238,7 +207,7 @@ alloc_range_index_node(range_index_t *ndx,
                        apr_size_t limit,
                        apr_size_t target_offset)
 {
-  range_index_node_t *const node = alloc_block(ndx->pool, &ndx->free_list);
+  range_index_node_t *const node = svn_slab__alloc(ndx->blocks);
   node->offset = offset;
   node->limit = limit;
   node->target_offset = target_offset;
@@ -255,7 +224,7 @@ free_range_index_node(range_index_t *ndx, range_index_node_t *node)
     node->next->prev = node->prev;
   if (node->prev)
     node->prev->next = node->next;
-  free_block(node, &ndx->free_list);
+  svn_slab__free(ndx->blocks, node);
 }
 
 
@@ -526,7 +495,7 @@ alloc_range_list(range_list_node_t **list,
                  apr_size_t limit,
                  apr_size_t target_offset)
 {
-  range_list_node_t *const node = alloc_block(ndx->pool, &ndx->free_list);
+  range_list_node_t *const node = svn_slab__alloc(ndx->blocks);
   node->kind = kind;
   node->offset = offset;
   node->limit = limit;
@@ -554,7 +523,7 @@ free_range_list(range_list_node_t *list, range_index_t *ndx)
     {
       range_list_node_t *const node = list;
       list = node->next;
-      free_block(node, &ndx->free_list);
+      svn_slab__free(ndx->blocks, node);
     }
 }
 
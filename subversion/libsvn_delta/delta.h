@@ -89,6 +89,41 @@ void svn_txdelta__xdelta(svn_txdelta__ops_baton_t *build_baton,
                          apr_pool_t *pool);
 
 
+/* Fingerprint index over a range of source data.  It is used to find the
+   part of the source that a given target window is most similar to. */
+typedef struct svn_txdelta__source_index_t svn_txdelta__source_index_t;
+
+/* Return a new, empty source index in POOL, suitable for covering about
+   CAPACITY bytes of source data. */
+svn_txdelta__source_index_t *
+svn_txdelta__source_index_create(apr_size_t capacity,
+                                 apr_pool_t *pool);
+
+/* Add fingerprints for the LEN bytes of source DATA to INDEX.  DATA starts
+   at OFFSET within the source.  Blocks that don't fit into LEN completely
+   are ignored.  Return the number of bytes that have been indexed. */
+apr_size_t
+svn_txdelta__source_index_add(svn_txdelta__source_index_t *index,
+                              const char *data,
+                              apr_size_t len,
+                              svn_filesize_t offset);
+
+/* Look up TARGET_LEN bytes of TARGET data in INDEX and return the source
+   offset that most of the matching blocks agree to correspond to the
+   beginning of TARGET in *OFFSET.  SOURCE_LEN bytes of SOURCE data,
+   starting at SOURCE_OFFSET, are available to verify the matches; index
+   entries outside that range will be ignored.  Return FALSE, if no match
+   could be found. */
+svn_boolean_t
+svn_txdelta__source_index_find(svn_filesize_t *offset,
+                               const svn_txdelta__source_index_t *index,
+                               const char *source,
+                               svn_filesize_t source_offset,
+                               apr_size_t source_len,
+                               const char *target,
+                               apr_size_t target_len);
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -30,6 +30,35 @@
 #include "svn_sorts.h"
 
 
+void
+svn_txdelta2(svn_txdelta_stream_t **stream,
+             svn_stream_t *source,
+             svn_stream_t *target,
+             svn_boolean_t calculate_checksum,
+             apr_pool_t *pool)
+{
+  svn_txdelta3(stream, source, target, calculate_checksum, FALSE, pool);
+}
+
+void
+svn_txdelta(svn_txdelta_stream_t **stream,
+            svn_stream_t *source,
+            svn_stream_t *target,
+            apr_pool_t *pool)
+{
+  svn_txdelta3(stream, source, target, TRUE, FALSE, pool);
+}
+
+svn_stream_t *
+svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
+                        void *handler_baton,
+                        svn_stream_t *source,
+                        apr_pool_t *pool)
+{
+  return svn_txdelta_target_push2(handler, handler_baton, source, FALSE,
+                                  pool);
+}
+
 struct path_driver_2_to_3_baton_t
 {
   svn_delta_path_driver_cb_func_t callback_func;
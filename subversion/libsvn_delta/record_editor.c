@@ -0,0 +1,596 @@
+/*
+ * record_editor.c :  recording editor drives for later playback
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+#include "svn_delta.h"
+#include "svn_io.h"
+#include "svn_sorts.h"
+#include "svn_string.h"
+
+#include "private/svn_delta_private.h"
+#include "private/svn_subr_private.h"
+
+#include "svn_private_config.h"
+
+/* Block size and in-memory limit of the spill buffer holding the text
+   deltas of a recording.  Larger recordings spill to disk. */
+#define SPILL_BLOCKSIZE (16 * 1024)
+#define SPILL_MAXSIZE (1024 * 1024)
+
+/* The editor calls that we record. */
+typedef enum op_kind_t
+{
+  op_set_target_revision,
+  op_open_root,
+  op_delete_entry,
+  op_add_directory,
+  op_open_directory,
+  op_change_dir_prop,
+  op_close_directory,
+  op_absent_directory,
+  op_add_file,
+  op_open_file,
+  op_apply_textdelta,
+  op_change_file_prop,
+  op_close_file,
+  op_absent_file
+} op_kind_t;
+
+/* A single recorded editor call.  Batons are identified by their index
+   in the order in which they were created. */
+typedef struct recorded_op_t
+{
+  op_kind_t kind;
+
+  /* Baton that the call was made upon, i.e. the parent directory for
+     adding, opening, deleting and absent nodes and the node itself for
+     everything else. */
+  int baton;
+
+  /* Baton created by add and open calls. */
+  int new_baton;
+
+  /* Call parameters, as far as applicable to KIND.  REVISION is also
+     used for base and copy-from revisions and CHECKSUM for base and
+     text checksums. */
+  const char *path;
+  const char *copyfrom_path;
+  svn_revnum_t revision;
+  const char *name;
+  const svn_string_t *value;
+  const char *checksum;
+
+  /* Number of svndiff bytes in the recording's delta spill buffer that
+     belong to this op_apply_textdelta call. */
+  svn_filesize_t delta_len;
+
+  struct recorded_op_t *next;
+} recorded_op_t;
+
+struct svn_delta__recording_t
+{
+  /* The recorded editor calls. */
+  recorded_op_t *first;
+  recorded_op_t *last;
+
+  /* Number of batons created by the editor drive. */
+  int baton_count;
+
+  /* The text deltas in svndiff format, in the order of the
+     op_apply_textdelta calls. */
+  svn_spillbuf_reader_t *deltas;
+
+  /* Checked before recording new nodes. */
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* Pool containing all of the above. */
+  apr_pool_t *pool;
+};
+
+/* Baton for directories and files of the recording editor. */
+typedef struct node_baton_t
+{
+  svn_delta__recording_t *rec;
+  int id;
+} node_baton_t;
+
+/* Baton for the svndiff output stream of a recorded text delta. */
+typedef struct delta_baton_t
+{
+  recorded_op_t *op;
+  svn_spillbuf_reader_t *deltas;
+  apr_pool_t *pool;
+} delta_baton_t;
+
+/* Append a new op of KIND upon BATON to REC and return it. */
+static recorded_op_t *
+add_op(svn_delta__recording_t *rec,
+       op_kind_t kind,
+       int baton)
+{
+  recorded_op_t *op = apr_pcalloc(rec->pool, sizeof(*op));
+  op->kind = kind;
+  op->baton = baton;
+  op->revision = SVN_INVALID_REVNUM;
+
+  if (rec->last)
+    rec->last->next = op;
+  else
+    rec->first = op;
+  rec->last = op;
+
+  return op;
+}
+
+/* Set OP's NEW_BATON to a new node baton for REC and return that
+   baton in *CHILD_BATON. */
+static void
+add_baton(void **child_baton,
+          svn_delta__recording_t *rec,
+          recorded_op_t *op)
+{
+  node_baton_t *nb = apr_palloc(rec->pool, sizeof(*nb));
+  nb->rec = rec;
+  nb->id = rec->baton_count++;
+
+  op->new_baton = nb->id;
+  *child_baton = nb;
+}
+
+/* Record an add or open call of KIND for PATH in PARENT_BATON with
+   the copy-from info or base revision COPYFROM_PATH and REVISION.
+   Return the new node baton in *CHILD_BATON. */
+static svn_error_t *
+record_node(op_kind_t kind,
+            const char *path,
+            void *parent_baton,
+            const char *copyfrom_path,
+            svn_revnum_t revision,
+            void **child_baton)
+{
+  node_baton_t *pb = parent_baton;
+  recorded_op_t *op;
+
+  if (pb->rec->cancel_func)
+    SVN_ERR(pb->rec->cancel_func(pb->rec->cancel_baton));
+
+  op = add_op(pb->rec, kind, pb->id);
+  op->path = apr_pstrdup(pb->rec->pool, path);
+  if (copyfrom_path)
+    op->copyfrom_path = apr_pstrdup(pb->rec->pool, copyfrom_path);
+  op->revision = revision;
+  add_baton(child_baton, pb->rec, op);
+
+  return SVN_NO_ERROR;
+}
+
+/* Record a property change of KIND for NAME to VALUE upon BATON. */
+static svn_error_t *
+record_prop(op_kind_t kind,
+            void *baton,
+            const char *name,
+            const svn_string_t *value)
+{
+  node_baton_t *nb = baton;
+  recorded_op_t *op = add_op(nb->rec, kind, nb->id);
+
+  op->name = apr_pstrdup(nb->rec->pool, name);
+  op->value = value ? svn_string_dup(value, nb->rec->pool) : NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* An svn_delta_editor_t function. */
+static svn_error_t *
+record_set_target_revision(void *edit_baton,
+                           svn_revnum_t target_revision,
+                           apr_pool_t *pool)
+{
+  svn_delta__recording_t *rec = edit_baton;
+  recorded_op_t *op = add_op(rec, op_set_target_revision, 0);
+
+  op->revision = target_revision;
+  return SVN_NO_ERROR;
+}
+
+/* An svn_delta_editor_t function. */
+static svn_error_t *
+record_open_root(void *edit_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *pool,
+                 void **root_baton)
+{
+  svn_delta__recording_t *rec = edit_baton;
+  recorded_op_t *op = add_op(rec, op_open_root, 0);
+
+  op->revision = base_revision;
+  add_baton(root_baton, rec, op);
+
+  return SVN_NO_ERROR;
+}
+
+/* An svn_delta_editor_t function. */
+static svn_error_t *
+record_delete_entry(const char *path,
+                    svn_revnum_t revision,
+                    void *parent_baton,
+                    apr_pool_t *pool)
+{
+  node_baton_t *pb = parent_baton;
+  recorded_op_t *op = add_op(pb->rec, op_delete_entry, pb->id);
+
+  op->path = apr_pstrdup(pb->rec->pool, path);
+  op->revision = revision;
+
+  return SVN_NO_ERROR;
+}
+
+/* An svn_delta_editor_t function. */
+static svn_error_t *
+record_add_directory(const char *path,
+                     void *parent_baton,
+                     const char *copyfrom_path,
+                     svn_revnum_t copyfrom_revision,
+                     apr_pool_t *pool,
+                     void **child_baton)
+{
+  return svn_error_trace(record_node(op_add_directory, path, parent_baton,
+                                     copyfrom_path, copyfrom_revision,
+                                     child_baton));
+}
+
+/* An svn_delta_editor_t function. */
+static svn_error_t *
+record_open_directory(const char *path,
+                      void *parent_baton,
+                      svn_revnum_t base_revision,
+                      apr_pool_t *pool,
+                      void **child_baton)
+{
+  return svn_error_trace(record_node(op_open_directory, path, parent_baton,
+                                     NULL, base_revision, child_baton));
+}
+
+/* An svn_delta_editor_t function. */
+static svn_error_t *
+record_change_dir_prop(void *dir_baton,
+                       const char *name,
+                       const svn_string_t *value,
+                       apr_pool_t *pool)
+{
+  return svn_error_trace(record_prop(op_change_dir_prop, dir_baton, name,
+                                     value));
+}
+
+/* An svn_delta_editor_t function. */
+static svn_error_t *
+record_close_directory(void *dir_baton,
+                       apr_pool_t *pool)
+{
+  node_baton_t *db = dir_baton;
+  add_op(db->rec, op_close_directory, db->id);
+
+  return SVN_NO_ERROR;
+}
+
+/* An svn_delta_editor_t function. */
+static svn_error_t *
+record_absent_directory(const char *path,
+                        void *parent_baton,
+                        apr_pool_t *pool)
+{
+  node_baton_t *pb = parent_baton;
+  recorded_op_t *op = add_op(pb->rec, op_absent_directory, pb->id);
+
+  op->path = apr_pstrdup(pb->rec->pool, path);
+  return SVN_NO_ERROR;
+}
+
+/* An svn_delta_editor_t function. */
+static svn_error_t *
+record_add_file(const char *path,
+                void *parent_baton,
+                const char *copyfrom_path,
+                svn_revnum_t copyfrom_revision,
+                apr_pool_t *pool,
+                void **file_baton)
+{
+  return svn_error_trace(record_node(op_add_file, path, parent_baton,
+                                     copyfrom_path, copyfrom_revision,
+                                     file_baton));
+}
+
+/* An svn_delta_editor_t function. */
+static svn_error_t *
+record_open_file(const char *path,
+                 void *parent_baton,
+                 svn_revnum_t base_revision,
+                 apr_pool_t *pool,
+                 void **file_baton)
+{
+  return svn_error_trace(record_node(op_open_file, path, parent_baton,
+                                     NULL, base_revision, file_baton));
+}
+
+/* Implements svn_write_fn_t.  Append the svndiff data to the delta
+   spill buffer and count it for the op_apply_textdelta call. */
+static svn_error_t *
+write_delta(void *baton,
+            const char *data,
+            apr_size_t *len)
+{
+  delta_baton_t *db = baton;
+
+  SVN_ERR(svn_spillbuf__reader_write(db->deltas, data, *len, db->pool));
+  db->op->delta_len += *len;
+
+  return SVN_NO_ERROR;
+}
+
+/* An svn_delta_editor_t function. */
+static svn_error_t *
+record_apply_textdelta(void *file_baton,
+                       const char *base_checksum,
+                       apr_pool_t *pool,
+                       svn_txdelta_window_handler_t *handler,
+                       void **handler_baton)
+{
+  node_baton_t *fb = file_baton;
+  delta_baton_t *db = apr_pcalloc(pool, sizeof(*db));
+  svn_stream_t *stream;
+
+  db->op = add_op(fb->rec, op_apply_textdelta, fb->id);
+  if (base_checksum)
+    db->op->checksum = apr_pstrdup(fb->rec->pool, base_checksum);
+  db->deltas = fb->rec->deltas;
+  db->pool = pool;
+
+  /* The data is local and will be parsed again soon.  Don't waste time
+     compressing it. */
+  stream = svn_stream_create(db, pool);
+  svn_stream_set_write(stream, write_delta);
+  svn_txdelta_to_svndiff3(handler, handler_baton, stream, 0,
+                          SVN_DELTA_COMPRESSION_LEVEL_NONE, pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* An svn_delta_editor_t function. */
+static svn_error_t *
+record_change_file_prop(void *file_baton,
+                        const char *name,
+                        const svn_string_t *value,
+                        apr_pool_t *pool)
+{
+  return svn_error_trace(record_prop(op_change_file_prop, file_baton, name,
+                                     value));
+}
+
+/* An svn_delta_editor_t function. */
+static svn_error_t *
+record_close_file(void *file_baton,
+                  const char *text_checksum,
+                  apr_pool_t *pool)
+{
+  node_baton_t *fb = file_baton;
+  recorded_op_t *op = add_op(fb->rec, op_close_file, fb->id);
+
+  if (text_checksum)
+    op->checksum = apr_pstrdup(fb->rec->pool, text_checksum);
+
+  return SVN_NO_ERROR;
+}
+
+/* An svn_delta_editor_t function. */
+static svn_error_t *
+record_absent_file(const char *path,
+                   void *parent_baton,
+                   apr_pool_t *pool)
+{
+  node_baton_t *pb = parent_baton;
+  recorded_op_t *op = add_op(pb->rec, op_absent_file, pb->id);
+
+  op->path = apr_pstrdup(pb->rec->pool, path);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_delta__get_recording_editor(const svn_delta_editor_t **editor_p,
+                                void **edit_baton,
+                                svn_delta__recording_t **recording,
+                                svn_cancel_func_t cancel_func,
+                                void *cancel_baton,
+                                apr_pool_t *result_pool)
+{
+  svn_delta_editor_t *editor = svn_delta_default_editor(result_pool);
+  svn_delta__recording_t *rec = apr_pcalloc(result_pool, sizeof(*rec));
+
+  rec->deltas = svn_spillbuf__reader_create(SPILL_BLOCKSIZE, SPILL_MAXSIZE,
+                                            result_pool);
+  rec->cancel_func = cancel_func;
+  rec->cancel_baton = cancel_baton;
+  rec->pool = result_pool;
+
+  editor->set_target_revision = record_set_target_revision;
+  editor->open_root = record_open_root;
+  editor->delete_entry = record_delete_entry;
+  editor->add_directory = record_add_directory;
+  editor->open_directory = record_open_directory;
+  editor->change_dir_prop = record_change_dir_prop;
+  editor->close_directory = record_close_directory;
+  editor->absent_directory = record_absent_directory;
+  editor->add_file = record_add_file;
+  editor->open_file = record_open_file;
+  editor->apply_textdelta = record_apply_textdelta;
+  editor->change_file_prop = record_change_file_prop;
+  editor->close_file = record_close_file;
+  editor->absent_file = record_absent_file;
+
+  *editor_p = editor;
+  *edit_baton = rec;
+  *recording = rec;
+
+  return SVN_NO_ERROR;
+}
+
+/* Copy LEN bytes from READER to STREAM, using BUFFER of
+   SVN__STREAM_CHUNK_SIZE bytes.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+copy_delta(svn_stream_t *stream,
+           svn_spillbuf_reader_t *reader,
+           svn_filesize_t len,
+           char *buffer,
+           apr_pool_t *scratch_pool)
+{
+  while (len > 0)
+    {
+      apr_size_t amt;
+
+      SVN_ERR(svn_spillbuf__reader_read(&amt, reader, buffer,
+                                        (apr_size_t)MIN(len,
+                                                 SVN__STREAM_CHUNK_SIZE),
+                                        scratch_pool));
+      if (amt == 0)
+        return svn_error_create(SVN_ERR_STREAM_UNEXPECTED_EOF, NULL,
+                                _("Unexpected end of recorded text delta"));
+
+      SVN_ERR(svn_stream_write(stream, buffer, &amt));
+      len -= amt;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_delta__play_recording(svn_delta__recording_t *rec,
+                          const svn_delta_editor_t *editor,
+                          void *edit_baton,
+                          apr_pool_t *pool)
+{
+  void **batons = apr_pcalloc(pool, rec->baton_count * sizeof(*batons));
+  apr_pool_t **file_pools = apr_pcalloc(pool,
+                                        rec->baton_count
+                                          * sizeof(*file_pools));
+  char *buffer = apr_palloc(pool, SVN__STREAM_CHUNK_SIZE);
+  const recorded_op_t *op;
+
+  for (op = rec->first; op; op = op->next)
+    {
+      void *baton = rec->baton_count ? batons[op->baton] : NULL;
+      apr_pool_t *file_pool = rec->baton_count ? file_pools[op->baton]
+                                               : NULL;
+
+      switch (op->kind)
+        {
+          case op_set_target_revision:
+            SVN_ERR(editor->set_target_revision(edit_baton, op->revision,
+                                                pool));
+            break;
+
+          case op_open_root:
+            SVN_ERR(editor->open_root(edit_baton, op->revision, pool,
+                                      &batons[op->new_baton]));
+            break;
+
+          case op_delete_entry:
+            SVN_ERR(editor->delete_entry(op->path, op->revision, baton,
+                                         pool));
+            break;
+
+          case op_add_directory:
+            SVN_ERR(editor->add_directory(op->path, baton, op->copyfrom_path,
+                                          op->revision, pool,
+                                          &batons[op->new_baton]));
+            break;
+
+          case op_open_directory:
+            SVN_ERR(editor->open_directory(op->path, baton, op->revision,
+                                           pool, &batons[op->new_baton]));
+            break;
+
+          case op_change_dir_prop:
+            SVN_ERR(editor->change_dir_prop(baton, op->name, op->value,
+                                            pool));
+            break;
+
+          case op_close_directory:
+            SVN_ERR(editor->close_directory(baton, pool));
+            break;
+
+          case op_absent_directory:
+            SVN_ERR(editor->absent_directory(op->path, baton, pool));
+            break;
+
+          case op_add_file:
+            file_pools[op->new_baton] = svn_pool_create(pool);
+            SVN_ERR(editor->add_file(op->path, baton, op->copyfrom_path,
+                                     op->revision, file_pools[op->new_baton],
+                                     &batons[op->new_baton]));
+            break;
+
+          case op_open_file:
+            file_pools[op->new_baton] = svn_pool_create(pool);
+            SVN_ERR(editor->open_file(op->path, baton, op->revision,
+                                      file_pools[op->new_baton],
+                                      &batons[op->new_baton]));
+            break;
+
+          case op_apply_textdelta:
+            {
+              svn_txdelta_window_handler_t handler;
+              void *handler_baton;
+              svn_stream_t *stream;
+
+              SVN_ERR(editor->apply_textdelta(baton, op->checksum, file_pool,
+                                              &handler, &handler_baton));
+              stream = svn_txdelta_parse_svndiff(handler, handler_baton,
+                                                 TRUE, file_pool);
+              SVN_ERR(copy_delta(stream, rec->deltas, op->delta_len, buffer,
+                                 file_pool));
+              SVN_ERR(svn_stream_close(stream));
+            }
+            break;
+
+          case op_change_file_prop:
+            SVN_ERR(editor->change_file_prop(baton, op->name, op->value,
+                                             file_pool));
+            break;
+
+          case op_close_file:
+            SVN_ERR(editor->close_file(baton, op->checksum, file_pool));
+            svn_pool_destroy(file_pool);
+            file_pools[op->baton] = NULL;
+            break;
+
+          case op_absent_file:
+            SVN_ERR(editor->absent_file(op->path, baton, pool));
+            break;
+
+          default:
+            SVN_ERR_MALFUNCTION();
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
@@ -24,14 +24,21 @@
 
 #include <assert.h>
 #include <string.h>
+
+#include <apr_thread_proc.h>
+
 #include "svn_delta.h"
 #include "svn_io.h"
 #include "delta.h"
 #include "svn_pools.h"
+#include "svn_sorts.h"
 #include "svn_private_config.h"
 
 #include "private/svn_error_private.h"
 #include "private/svn_delta_private.h"
+#include "private/svn_mutex.h"
+#include "private/svn_probes.h"
+#include "private/svn_thread_cond.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_dep_compat.h"
@@ -39,13 +46,16 @@
 static const char SVNDIFF_V0[] = { 'S', 'V', 'N', 0 };
 static const char SVNDIFF_V1[] = { 'S', 'V', 'N', 1 };
 static const char SVNDIFF_V2[] = { 'S', 'V', 'N', 2 };
+static const char SVNDIFF_V3[] = { 'S', 'V', 'N', 3 };
 
 #define SVNDIFF_HEADER_SIZE (sizeof(SVNDIFF_V0))
 
 static const char *
 get_svndiff_header(int version)
 {
-  if (version == 2)
+  if (version == 3)
+    return SVNDIFF_V3;
+  else if (version == 2)
     return SVNDIFF_V2;
   else if (version == 1)
     return SVNDIFF_V1;
@@ -198,7 +208,15 @@ encode_window(svn_stringbuf_t **instructions_p,
   append_encoded_int(header, window->sview_offset);
   append_encoded_int(header, window->sview_len);
   append_encoded_int(header, window->tview_len);
-  if (version == 2)
+  if (version == 3)
+    {
+      svn_stringbuf_t *compressed_instructions;
+      compressed_instructions = svn_stringbuf_create_empty(pool);
+      SVN_ERR(svn__compress_zstd(instructions->data, instructions->len,
+                                 compressed_instructions, compression_level));
+      instructions = compressed_instructions;
+    }
+  else if (version == 2)
     {
       svn_stringbuf_t *compressed_instructions;
       compressed_instructions = svn_stringbuf_create_empty(pool);
@@ -217,7 +235,16 @@ encode_window(svn_stringbuf_t **instructions_p,
   append_encoded_int(header, instructions->len);
 
   /* Encode the data. */
-  if (version == 2)
+  if (version == 3)
+    {
+      svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
+
+      SVN_ERR(svn__compress_zstd(window->new_data->data,
+                                 window->new_data->len,
+                                 compressed, compression_level));
+      newdata = svn_stringbuf__morph_into_string(compressed);
+    }
+  else if (version == 2)
     {
       svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
 
@@ -245,13 +272,59 @@ encode_window(svn_stringbuf_t **instructions_p,
   return SVN_NO_ERROR;
 }
 
+/* Write the svndiff stream header to the output of EB, unless that has
+   already been done. */
+static svn_error_t *
+write_svndiff_header(struct encoder_baton *eb)
+{
+  apr_size_t len;
+
+  if (!eb->header_done)
+    {
+      len = SVNDIFF_HEADER_SIZE;
+      SVN_ERR(svn_stream_write(eb->output, get_svndiff_header(eb->version),
+                               &len));
+      eb->header_done = TRUE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the window given by HEADER, INSTRUCTIONS and NEWDATA as returned
+   by encode_window() to the output of EB.  Write the stream header first
+   if necessary. */
+static svn_error_t *
+write_encoded_window(struct encoder_baton *eb,
+                     const svn_stringbuf_t *header,
+                     const svn_stringbuf_t *instructions,
+                     const svn_string_t *newdata)
+{
+  apr_size_t len;
+
+  SVN_ERR(write_svndiff_header(eb));
+
+  len = header->len;
+  SVN_ERR(svn_stream_write(eb->output, header->data, &len));
+  if (instructions->len > 0)
+    {
+      len = instructions->len;
+      SVN_ERR(svn_stream_write(eb->output, instructions->data, &len));
+    }
+  if (newdata->len > 0)
+    {
+      len = newdata->len;
+      SVN_ERR(svn_stream_write(eb->output, newdata->data, &len));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Note: When changing things here, check the related comment in
-   the svn_txdelta_to_svndiff_stream() function.  */
+   the svn_txdelta__to_svndiff_stream_parallel() function.  */
 static svn_error_t *
 window_handler(svn_txdelta_window_t *window, void *baton)
 {
   struct encoder_baton *eb = baton;
-  apr_size_t len;
   svn_stringbuf_t *instructions;
   svn_stringbuf_t *header;
   const svn_string_t *newdata;
@@ -261,13 +334,7 @@ window_handler(svn_txdelta_window_t *window, void *baton)
     return svn_error_trace(send_simple_insertion_window(window, eb));
 
   /* Make sure we write the header.  */
-  if (!eb->header_done)
-    {
-      len = SVNDIFF_HEADER_SIZE;
-      SVN_ERR(svn_stream_write(eb->output, get_svndiff_header(eb->version),
-                               &len));
-      eb->header_done = TRUE;
-    }
+  SVN_ERR(write_svndiff_header(eb));
 
   if (window == NULL)
     {
@@ -286,20 +353,29 @@ window_handler(svn_txdelta_window_t *window, void *baton)
                         eb->scratch_pool));
 
   /* Write out the window.  */
-  len = header->len;
-  SVN_ERR(svn_stream_write(eb->output, header->data, &len));
-  if (instructions->len > 0)
-    {
-      len = instructions->len;
-      SVN_ERR(svn_stream_write(eb->output, instructions->data, &len));
-    }
-  if (newdata->len > 0)
-    {
-      len = newdata->len;
-      SVN_ERR(svn_stream_write(eb->output, newdata->data, &len));
-    }
+  return svn_error_trace(write_encoded_window(eb, header, instructions,
+                                              newdata));
+}
 
-  return SVN_NO_ERROR;
+/* Initialize *EB to write svndiff of version SVNDIFF_VERSION with the
+   given COMPRESSION_LEVEL to OUTPUT.  Allocate the scratch pool in POOL. */
+static void
+init_encoder_baton(struct encoder_baton *eb,
+                   svn_stream_t *output,
+                   int svndiff_version,
+                   int compression_level,
+                   apr_pool_t *pool)
+{
+  eb->output = output;
+  eb->header_done = FALSE;
+  eb->scratch_pool = svn_pool_create(pool);
+  eb->version = svndiff_version;
+  eb->compression_level = compression_level;
+
+  /* Zstandard has a different range of levels than zlib. */
+  if (svndiff_version == 3)
+    eb->compression_level = MAX(1, MIN(compression_level,
+                                       SVN__ZSTD_MAX_LEVEL));
 }
 
 void
@@ -313,11 +389,7 @@ svn_txdelta_to_svndiff3(svn_txdelta_window_handler_t *handler,
   struct encoder_baton *eb;
 
   eb = apr_palloc(pool, sizeof(*eb));
-  eb->output = output;
-  eb->header_done = FALSE;
-  eb->scratch_pool = svn_pool_create(pool);
-  eb->version = svndiff_version;
-  eb->compression_level = compression_level;
+  init_encoder_baton(eb, output, svndiff_version, compression_level, pool);
 
   *handler = window_handler;
   *handler_baton = eb;
@@ -344,6 +416,448 @@ svn_txdelta_to_svndiff(svn_stream_t *output,
                           SVN_DELTA_COMPRESSION_LEVEL_DEFAULT, pool);
 }
 
+
+/* ----- Text delta to svndiff, compressing in worker threads ----- */
+
+#if APR_HAS_THREADS
+
+/* A delta window to encode and its encoded form. */
+typedef struct encoder_job_t
+{
+  /* Next job to be written, i.e. the following window. */
+  struct encoder_job_t *next;
+
+  /* Next job to be picked up by a worker. */
+  struct encoder_job_t *next_queued;
+
+  /* All data of this job lives in this pool.  It uses its own allocator
+     because it gets filled by the worker and destroyed by the writer. */
+  apr_pool_t *pool;
+
+  /* Copy of the window handed in by the caller. */
+  svn_txdelta_window_t *window;
+
+  /* Result of encode_window().  Only valid when DONE is set. */
+  svn_stringbuf_t *instructions;
+  svn_stringbuf_t *header;
+  const svn_string_t *newdata;
+  svn_error_t *err;
+
+  /* Set once the job has been encoded. */
+  svn_boolean_t done;
+} encoder_job_t;
+
+/* Baton for parallel_window_handler(). */
+typedef struct parallel_encoder_baton_t
+{
+  /* Output stream, svndiff version and compression settings.
+     Writer thread only. */
+  struct encoder_baton eb;
+
+  /* Pool that this baton has been allocated in. */
+  apr_pool_t *pool;
+
+  /* Worker threads, started on demand. */
+  apr_thread_t **threads;
+  int thread_count;
+  int threads_started;
+  apr_pool_t *thread_pool;
+
+  /* Serializes access to all members below. */
+  svn_mutex__t *mutex;
+
+  /* Signaled when a job has been queued or the workers shall exit. */
+  svn_thread_cond__t *job_queued;
+
+  /* Signaled when a worker finished encoding a job. */
+  svn_thread_cond__t *job_done;
+
+  /* Jobs not written, yet, in window order. */
+  encoder_job_t *first;
+  encoder_job_t *last;
+  int pending;
+
+  /* Jobs not picked up by any worker, yet, in window order. */
+  encoder_job_t *first_queued;
+  encoder_job_t *last_queued;
+
+  /* Set when the workers shall terminate. */
+  svn_boolean_t shutdown;
+} parallel_encoder_baton_t;
+
+/* Take the next job from the queue in PB and return it in *JOB.
+   Block while the queue is empty.  Set *JOB to NULL after PB has been
+   shut down.
+
+   This function must be called with PB->MUTEX acquired. */
+static svn_error_t *
+take_job(encoder_job_t **job,
+         parallel_encoder_baton_t *pb)
+{
+  while (pb->first_queued == NULL && !pb->shutdown)
+    SVN_ERR(svn_thread_cond__wait(pb->job_queued, pb->mutex));
+
+  *job = pb->shutdown ? NULL : pb->first_queued;
+  if (*job)
+    {
+      pb->first_queued = (*job)->next_queued;
+      if (pb->first_queued == NULL)
+        pb->last_queued = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Mark JOB in PB as encoded and wake up the writer.
+
+   This function must be called with PB->MUTEX acquired. */
+static svn_error_t *
+finish_job(parallel_encoder_baton_t *pb,
+           encoder_job_t *job)
+{
+  job->done = TRUE;
+  return svn_thread_cond__broadcast(pb->job_done);
+}
+
+/* Encode the window in JOB using the settings in PB. */
+static void
+process_job(parallel_encoder_baton_t *pb,
+            encoder_job_t *job)
+{
+  job->err = encode_window(&job->instructions, &job->header, &job->newdata,
+                           job->window, pb->eb.version,
+                           pb->eb.compression_level, job->pool);
+}
+
+/* Worker loop: encode queued jobs in PB until PB gets shut down. */
+static svn_error_t *
+run_encoder(parallel_encoder_baton_t *pb)
+{
+  while (TRUE)
+    {
+      encoder_job_t *job;
+
+      SVN_MUTEX__WITH_LOCK(pb->mutex, take_job(&job, pb));
+      if (job == NULL)
+        break;
+
+      process_job(pb, job);
+      SVN_MUTEX__WITH_LOCK(pb->mutex, finish_job(pb, job));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* The plain APR thread function running a worker.
+ * DATA is the parallel_encoder_baton_t object to serve. */
+static void * APR_THREAD_FUNC
+encoder_thread(apr_thread_t *thread, void *data)
+{
+  svn_error_t *err = run_encoder(data);
+  apr_status_t result = APR_SUCCESS;
+
+  if (err)
+    {
+      result = err->apr_err;
+      svn_error_clear(err);
+    }
+
+  /* End thread explicitly to prevent APR_INCOMPLETE return codes in
+     apr_thread_join(). */
+  apr_thread_exit(thread, result);
+  return NULL;
+}
+
+/* Start all worker threads of PB that are not running, yet.
+
+   This function must be called with PB->MUTEX acquired. */
+static svn_error_t *
+ensure_encoders(parallel_encoder_baton_t *pb)
+{
+  /* The thread objects can't share the allocator with the writer. */
+  if (pb->thread_pool == NULL)
+    pb->thread_pool
+      = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+
+  while (pb->threads_started < pb->thread_count)
+    {
+      apr_status_t status
+        = apr_thread_create(&pb->threads[pb->threads_started], NULL,
+                            encoder_thread, pb, pb->thread_pool);
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't create svndiff encoder thread"));
+
+      ++pb->threads_started;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Append JOB to both lists in PB and make sure there is someone to
+   encode it.
+
+   This function must be called with PB->MUTEX acquired. */
+static svn_error_t *
+queue_job(parallel_encoder_baton_t *pb,
+          encoder_job_t *job)
+{
+  if (pb->last)
+    pb->last->next = job;
+  else
+    pb->first = job;
+  pb->last = job;
+  ++pb->pending;
+
+  if (pb->last_queued)
+    pb->last_queued->next_queued = job;
+  else
+    pb->first_queued = job;
+  pb->last_queued = job;
+
+  /* Single-window deltas are not worth the hand-over.  They get encoded
+     by the writer itself. */
+  if (pb->pending > 1)
+    SVN_ERR(ensure_encoders(pb));
+
+  return svn_thread_cond__signal(pb->job_queued);
+}
+
+/* If the first job in PB has not been picked up by any worker, yet,
+   remove it from the queue and return it in *JOB.  Set *JOB to NULL
+   otherwise.
+
+   This function must be called with PB->MUTEX acquired. */
+static svn_error_t *
+claim_first_job(encoder_job_t **job,
+                parallel_encoder_baton_t *pb)
+{
+  *job = NULL;
+  if (pb->first && pb->first == pb->first_queued)
+    {
+      *job = pb->first;
+      pb->first_queued = (*job)->next_queued;
+      if (pb->first_queued == NULL)
+        pb->last_queued = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove the first job from the list of pending jobs in PB and return it
+   in *JOB, if it has been encoded.  If WAIT is set, block until that is
+   the case.  Set *JOB to NULL if there are no pending jobs or if the first
+   one is still being encoded and WAIT is not set.
+
+   This function must be called with PB->MUTEX acquired. */
+static svn_error_t *
+next_finished_job(encoder_job_t **job,
+                  parallel_encoder_baton_t *pb,
+                  svn_boolean_t wait)
+{
+  encoder_job_t *head = pb->first;
+
+  *job = NULL;
+  if (head == NULL)
+    return SVN_NO_ERROR;
+
+  while (!head->done && wait)
+    SVN_ERR(svn_thread_cond__wait(pb->job_done, pb->mutex));
+
+  if (head->done)
+    {
+      pb->first = head->next;
+      if (pb->first == NULL)
+        pb->last = NULL;
+      --pb->pending;
+
+      *job = head;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the encoded JOB to the output stream of PB and release JOB. */
+static svn_error_t *
+write_job(parallel_encoder_baton_t *pb,
+          encoder_job_t *job)
+{
+  svn_error_t *err = job->err;
+
+  if (!err)
+    err = write_encoded_window(&pb->eb, job->header, job->instructions,
+                               job->newdata);
+
+  svn_pool_destroy(job->pool);
+  return svn_error_trace(err);
+}
+
+/* Write all jobs that have been encoded in PB.  If WAIT is set, block
+   until the first job has been encoded.  If DRAIN is set, write all jobs
+   and help encoding them. */
+static svn_error_t *
+write_finished_jobs(parallel_encoder_baton_t *pb,
+                    svn_boolean_t wait,
+                    svn_boolean_t drain)
+{
+  while (TRUE)
+    {
+      encoder_job_t *job;
+
+      /* Don't wait for a worker to pick up the job we need next. */
+      if (drain)
+        {
+          SVN_MUTEX__WITH_LOCK(pb->mutex, claim_first_job(&job, pb));
+          if (job)
+            {
+              /* No one else will access JOB anymore. */
+              process_job(pb, job);
+              job->done = TRUE;
+            }
+        }
+
+      SVN_MUTEX__WITH_LOCK(pb->mutex,
+                           next_finished_job(&job, pb, wait || drain));
+      if (job == NULL)
+        break;
+
+      SVN_ERR(write_job(pb, job));
+      wait = FALSE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Tell the workers of PB to terminate.
+
+   This function must be called with PB->MUTEX acquired. */
+static svn_error_t *
+request_encoder_shutdown(parallel_encoder_baton_t *pb)
+{
+  pb->shutdown = TRUE;
+  return svn_thread_cond__broadcast(pb->job_queued);
+}
+
+/* Pool cleanup function terminating the workers of the
+   parallel_encoder_baton_t given as BATON and releasing all jobs that
+   have not been written. */
+static apr_status_t
+cleanup_parallel_encoder(void *baton)
+{
+  parallel_encoder_baton_t *pb = baton;
+  svn_error_t *err = svn_mutex__lock(pb->mutex);
+  int i;
+
+  if (!err)
+    err = svn_mutex__unlock(pb->mutex, request_encoder_shutdown(pb));
+  svn_error_clear(err);
+
+  for (i = 0; i < pb->threads_started; ++i)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, pb->threads[i]);
+    }
+  pb->threads_started = 0;
+
+  while (pb->first)
+    {
+      encoder_job_t *job = pb->first;
+      pb->first = job->next;
+
+      svn_error_clear(job->err);
+      svn_pool_destroy(job->pool);
+    }
+  pb->last = NULL;
+
+  if (pb->thread_pool)
+    {
+      svn_pool_destroy(pb->thread_pool);
+      pb->thread_pool = NULL;
+    }
+
+  return APR_SUCCESS;
+}
+
+/* Implements svn_txdelta_window_handler_t for parallel_encoder_baton_t. */
+static svn_error_t *
+parallel_window_handler(svn_txdelta_window_t *window, void *baton)
+{
+  parallel_encoder_baton_t *pb = baton;
+  encoder_job_t *job;
+  apr_pool_t *job_pool;
+
+  if (window == NULL)
+    {
+      SVN_ERR(write_finished_jobs(pb, TRUE, TRUE));
+      SVN_ERR(write_svndiff_header(&pb->eb));
+      SVN_ERR(svn_stream_close(pb->eb.output));
+
+      /* We're done; terminate the workers. */
+      apr_pool_cleanup_run(pb->pool, pb, cleanup_parallel_encoder);
+
+      return SVN_NO_ERROR;
+    }
+
+  job_pool = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+  job = apr_pcalloc(job_pool, sizeof(*job));
+  job->pool = job_pool;
+  job->window = svn_txdelta_window_dup(window, job_pool);
+
+  SVN_MUTEX__WITH_LOCK(pb->mutex, queue_job(pb, job));
+
+  /* Limit the number of windows in flight, i.e. the memory usage. */
+  return svn_error_trace(write_finished_jobs(pb,
+                                             pb->pending
+                                               > 2 * pb->thread_count,
+                                             FALSE));
+}
+
+#endif /* APR_HAS_THREADS */
+
+svn_error_t *
+svn_txdelta__to_svndiff_parallel(svn_txdelta_window_handler_t *handler,
+                                 void **handler_baton,
+                                 svn_stream_t *output,
+                                 int svndiff_version,
+                                 int compression_level,
+                                 int thread_count,
+                                 apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  parallel_encoder_baton_t *pb;
+
+  /* There is nothing to compress in svndiff0. */
+  if (thread_count <= 1 || svndiff_version == 0)
+#endif
+    {
+      svn_txdelta_to_svndiff3(handler, handler_baton, output,
+                              svndiff_version, compression_level, pool);
+      return SVN_NO_ERROR;
+    }
+
+#if APR_HAS_THREADS
+  pb = apr_pcalloc(pool, sizeof(*pb));
+  init_encoder_baton(&pb->eb, output, svndiff_version, compression_level,
+                     pool);
+  pb->pool = pool;
+  pb->thread_count = thread_count;
+  pb->threads = apr_pcalloc(pool, thread_count * sizeof(*pb->threads));
+
+  SVN_ERR(svn_mutex__init(&pb->mutex, TRUE, pool));
+  SVN_ERR(svn_thread_cond__create(&pb->job_queued, pool));
+  SVN_ERR(svn_thread_cond__create(&pb->job_done, pool));
+
+  apr_pool_cleanup_register(pool, pb, cleanup_parallel_encoder,
+                            apr_pool_cleanup_null);
+
+  *handler = parallel_window_handler;
+  *handler_baton = pb;
+
+  return SVN_NO_ERROR;
+#endif
+}
+
+
 
 /* ----- svndiff to text delta ----- */
 
@@ -403,7 +917,16 @@ decode_file_offset(svn_filesize_t *val,
                    const unsigned char *end)
 {
   apr_uint64_t temp = 0;
-  const unsigned char *result = svn__decode_uint(&temp, p, end);
+  const unsigned char *result;
+
+  /* Most values fit into a single byte.  Don't call out for those. */
+  if (SVN__PREDICT_TRUE(p < end && *p < 0x80))
+    {
+      *val = *p;
+      return p + 1;
+    }
+
+  result = svn__decode_uint(&temp, p, end);
   *val = (svn_filesize_t)temp;
 
   return result;
@@ -416,7 +939,17 @@ decode_size(apr_size_t *val,
             const unsigned char *end)
 {
   apr_uint64_t temp = 0;
-  const unsigned char *result = svn__decode_uint(&temp, p, end);
+  const unsigned char *result;
+
+  /* Same shortcut as for file offsets.  Instruction lengths and offsets
+     are often small enough to hit it. */
+  if (SVN__PREDICT_TRUE(p < end && *p < 0x80))
+    {
+      *val = *p;
+      return p + 1;
+    }
+
+  result = svn__decode_uint(&temp, p, end);
   if (temp > APR_SIZE_MAX)
     return NULL;
 
@@ -559,13 +1092,32 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
   svn_txdelta_op_t *ops, *op;
   svn_string_t *new_data;
 
+  SVN_PROBE4(delta__window__decode__start, version, sview_len, tview_len,
+             newlen);
+
   window->sview_offset = sview_offset;
   window->sview_len = sview_len;
   window->tview_len = tview_len;
 
   insend = data + inslen;
 
-  if (version == 2)
+  if (version == 3)
+    {
+      svn_stringbuf_t *instout = svn_stringbuf_create_empty(pool);
+      svn_stringbuf_t *ndout = svn_stringbuf_create_empty(pool);
+
+      SVN_ERR(svn__decompress_zstd(insend, newlen, ndout,
+                                   SVN_DELTA_WINDOW_SIZE));
+      SVN_ERR(svn__decompress_zstd(data, insend - data, instout,
+                                   MAX_INSTRUCTION_SECTION_LEN));
+
+      newlen = ndout->len;
+      data = (unsigned char *)instout->data;
+      insend = (unsigned char *)instout->data + instout->len;
+
+      new_data = svn_stringbuf__morph_into_string(ndout);
+    }
+  else if (version == 2)
     {
       svn_stringbuf_t *instout = svn_stringbuf_create_empty(pool);
       svn_stringbuf_t *ndout = svn_stringbuf_create_empty(pool);
@@ -629,6 +1181,7 @@ decode_window(svn_txdelta_window_t *window, svn_filesize_t sview_offset,
   window->num_ops = ninst;
   window->new_data = new_data;
 
+  SVN_PROBE2(delta__window__decode__done, ninst, tview_len);
   return SVN_NO_ERROR;
 }
 
@@ -653,6 +1206,8 @@ write_handler(void *baton,
         db->version = 1;
       else if (memcmp(buffer, SVNDIFF_V2 + db->header_bytes, nheader) == 0)
         db->version = 2;
+      else if (memcmp(buffer, SVNDIFF_V3 + db->header_bytes, nheader) == 0)
+        db->version = 3;
       else
         return svn_error_create(SVN_ERR_SVNDIFF_INVALID_HEADER, NULL,
                                 _("Svndiff has invalid header"));
@@ -995,6 +1550,43 @@ svn_txdelta__read_raw_window_len(apr_size_t *window_len,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_txdelta__parse_svndiff_window(svn_txdelta_window_t **window,
+                                  apr_size_t *window_len,
+                                  const char *data,
+                                  apr_size_t len,
+                                  int svndiff_version,
+                                  apr_pool_t *pool)
+{
+  svn_string_t header_data;
+  svn_stream_t *stream;
+  svn_filesize_t sview_offset;
+  apr_size_t sview_len, tview_len, inslen, newlen, header_len;
+
+  /* The header is at most 5 numbers, each well within our limit. */
+  header_data.data = data;
+  header_data.len = MIN(len, 5 * SVN__MAX_ENCODED_UINT_LEN);
+  stream = svn_stream_from_string(&header_data, pool);
+
+  SVN_ERR(read_window_header(stream, &sview_offset, &sview_len, &tview_len,
+                             &inslen, &newlen, &header_len));
+  if (len - header_len < inslen + newlen)
+    return svn_error_create(SVN_ERR_SVNDIFF_UNEXPECTED_END, NULL,
+                            _("Unexpected end of svndiff input"));
+
+  *window_len = header_len + inslen + newlen;
+  if (window)
+    {
+      *window = apr_palloc(pool, sizeof(**window));
+      SVN_ERR(decode_window(*window, sview_offset, sview_len, tview_len,
+                            inslen, newlen,
+                            (const unsigned char *)data + header_len,
+                            pool, svndiff_version));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 typedef struct svndiff_stream_baton_t
 {
   apr_pool_t *scratch_pool;
@@ -1012,8 +1604,9 @@ svndiff_stream_write_fn(void *baton, const char *data, apr_size_t *len)
   svndiff_stream_baton_t *b = baton;
 
   /* The memory usage here is limited, as this buffer doesn't grow
-     beyond the (header size + max window size in svndiff format).
-     See the comment in svn_txdelta_to_svndiff_stream().  */
+     beyond the (header size + max window size in svndiff format) times
+     the number of windows that the encoder keeps in flight.
+     See the comment in svn_txdelta__to_svndiff_stream_parallel().  */
   svn_stringbuf_appendbytes(b->window_buffer, data, *len);
 
   return SVN_NO_ERROR;
@@ -1050,8 +1643,14 @@ svndiff_stream_read_fn(void *baton, char *buffer, apr_size_t *len)
       else
         chunk_size = left;
 
+      /* A parallel encoder may not produce output for every window. */
       if (!chunk_size)
-          break;
+        {
+          if (b->hit_eof)
+            break;
+          else
+            continue;
+        }
 
       memcpy(buffer, b->window_buffer->data + b->read_pos, chunk_size);
       b->read_pos += chunk_size;
@@ -1064,11 +1663,13 @@ svndiff_stream_read_fn(void *baton, char *buffer, apr_size_t *len)
   return SVN_NO_ERROR;
 }
 
-svn_stream_t *
-svn_txdelta_to_svndiff_stream(svn_txdelta_stream_t *txstream,
-                              int svndiff_version,
-                              int compression_level,
-                              apr_pool_t *pool)
+svn_error_t *
+svn_txdelta__to_svndiff_stream_parallel(svn_stream_t **stream,
+                                        svn_txdelta_stream_t *txstream,
+                                        int svndiff_version,
+                                        int compression_level,
+                                        int thread_count,
+                                        apr_pool_t *pool)
 {
   svndiff_stream_baton_t *baton;
   svn_stream_t *push_stream;
@@ -1089,13 +1690,34 @@ svn_txdelta_to_svndiff_stream(svn_txdelta_stream_t *txstream,
      As long as it writes one svndiff window at a time to the target
      stream, the memory usage of this function (in other words, how
      much data can be accumulated in the internal 'window_buffer')
-     is limited.  */
-  svn_txdelta_to_svndiff3(&baton->handler, &baton->handler_baton,
-                          push_stream, svndiff_version,
-                          compression_level, pool);
+     is limited.  The parallel encoder keeps a bounded number of windows
+     in flight and may write several of them at once.  */
+  SVN_ERR(svn_txdelta__to_svndiff_parallel(&baton->handler,
+                                           &baton->handler_baton,
+                                           push_stream, svndiff_version,
+                                           compression_level, thread_count,
+                                           pool));
 
   pull_stream = svn_stream_create(baton, pool);
   svn_stream_set_read2(pull_stream, NULL, svndiff_stream_read_fn);
 
-  return pull_stream;
+  *stream = pull_stream;
+  return SVN_NO_ERROR;
+}
+
+svn_stream_t *
+svn_txdelta_to_svndiff_stream(svn_txdelta_stream_t *txstream,
+                              int svndiff_version,
+                              int compression_level,
+                              apr_pool_t *pool)
+{
+  svn_stream_t *stream;
+
+  /* With a single thread, this can't fail. */
+  svn_error_clear(svn_txdelta__to_svndiff_stream_parallel(&stream,
+                                                          txstream,
+                                                          svndiff_version,
+                                                          compression_level,
+                                                          1, pool));
+  return stream;
 }
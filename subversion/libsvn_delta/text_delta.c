@@ -61,6 +61,9 @@ struct txdelta_baton {
                                    the checksum. */
   svn_checksum_t *checksum;     /* If non-NULL, the checksum of TARGET. */
 
+  struct source_tracker_t *tracker; /* If not NULL, read the source through
+                                       this source tracker. */
+
   apr_pool_t *result_pool;      /* For results (e.g. checksum) */
 };
 
@@ -80,6 +83,10 @@ struct tpush_baton {
   apr_size_t source_len;
   svn_boolean_t source_done;
   apr_size_t target_len;
+
+  /* If not NULL, read the source through this tracker and use BUF for
+     target data only. */
+  struct source_tracker_t *tracker;
 };
 
 
@@ -319,6 +326,154 @@ svn_txdelta__remove_copy(svn_txdelta__ops_baton_t *build_baton,
 }
 
 
+
+/* Source tracking.
+ *
+ * Normal deltas compare each target window with the source data at the
+ * same offset.  If data has been inserted into or removed from a large
+ * file, the matching source data moves out of reach after a few windows.
+ * Source-tracking deltas keep a larger range of source data in memory
+ * and select the source view of each window by looking up the target
+ * data in a fingerprint index over that range.
+ *
+ * Source views still never move backwards and never exceed the standard
+ * window size, so the result can be read by any svndiff consumer.
+ */
+
+/* Amount of source data that source-tracking deltas keep in memory and
+   search for matches.  Must be at least twice SVN_DELTA_WINDOW_SIZE. */
+#define SOURCE_TRACKING_RANGE (64 * SVN_DELTA_WINDOW_SIZE)
+
+/* Source data buffer and index for source-tracking deltas. */
+typedef struct source_tracker_t
+{
+  /* The source stream and whether we hit its EOF. */
+  svn_stream_t *source;
+  svn_boolean_t source_done;
+
+  /* Buffer of SOURCE_TRACKING_RANGE bytes.  The first BUF_LEN bytes hold
+     the source data starting at BUF_OFFSET. */
+  char *buf;
+  svn_filesize_t buf_offset;
+  apr_size_t buf_len;
+
+  /* Fingerprints of the first INDEXED_LEN bytes in BUF. */
+  svn_txdelta__source_index_t *index;
+  apr_size_t indexed_len;
+
+  /* Source view of the last window. */
+  svn_filesize_t sview_offset;
+  apr_size_t sview_len;
+
+  /* Room for the source view and the target data of one window, laid
+     out as expected by compute_window(). */
+  char *window_buf;
+} source_tracker_t;
+
+/* Return a new source tracker for SOURCE, allocated in POOL. */
+static source_tracker_t *
+create_source_tracker(svn_stream_t *source,
+                      apr_pool_t *pool)
+{
+  source_tracker_t *tracker = apr_pcalloc(pool, sizeof(*tracker));
+
+  tracker->source = source;
+  tracker->buf = apr_palloc(pool, SOURCE_TRACKING_RANGE);
+  tracker->index = svn_txdelta__source_index_create(SOURCE_TRACKING_RANGE,
+                                                    pool);
+  tracker->window_buf = apr_palloc(pool, 2 * SVN_DELTA_WINDOW_SIZE);
+
+  return tracker;
+}
+
+/* Discard all data in TRACKER's buffer that future windows cannot use
+ * anymore, read as much new source data as fits and index it. */
+static svn_error_t *
+fill_source_tracker(source_tracker_t *tracker)
+{
+  apr_size_t unused = (apr_size_t)(tracker->sview_offset
+                                   - tracker->buf_offset);
+
+  /* Only move data around if that frees a significant part of the
+     buffer.  This limits the copying overhead. */
+  if (unused >= SOURCE_TRACKING_RANGE / 2)
+    {
+      memmove(tracker->buf, tracker->buf + unused, tracker->buf_len - unused);
+      tracker->buf_offset += unused;
+      tracker->buf_len -= unused;
+      tracker->indexed_len = tracker->indexed_len > unused
+                           ? tracker->indexed_len - unused
+                           : 0;
+    }
+
+  if (!tracker->source_done && tracker->buf_len < SOURCE_TRACKING_RANGE)
+    {
+      apr_size_t requested = SOURCE_TRACKING_RANGE - tracker->buf_len;
+      apr_size_t len = requested;
+
+      SVN_ERR(svn_stream_read_full(tracker->source,
+                                   tracker->buf + tracker->buf_len, &len));
+      tracker->source_done = (len < requested);
+      tracker->buf_len += len;
+    }
+
+  tracker->indexed_len
+    += svn_txdelta__source_index_add(tracker->index,
+                                     tracker->buf + tracker->indexed_len,
+                                     tracker->buf_len - tracker->indexed_len,
+                                     tracker->buf_offset
+                                       + tracker->indexed_len);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *WINDOW to the delta window for the TARGET_LEN bytes of TARGET
+ * data against the best matching source view available in TRACKER.
+ * Allocate the window in POOL. */
+static svn_error_t *
+compute_tracked_window(svn_txdelta_window_t **window,
+                       source_tracker_t *tracker,
+                       const char *target,
+                       apr_size_t target_len,
+                       apr_pool_t *pool)
+{
+  svn_filesize_t offset = tracker->sview_offset;
+  svn_filesize_t candidate;
+  apr_size_t source_len;
+
+  SVN_ERR(fill_source_tracker(tracker));
+
+  /* Move the source view to where the target data seems to come from.
+     If there is no match, the target data is probably new.  Then, keep
+     the source view where it is because the remainder of the target may
+     still match the source data following it. */
+  if (svn_txdelta__source_index_find(&candidate, tracker->index,
+                                     tracker->buf, tracker->buf_offset,
+                                     tracker->buf_len, target, target_len)
+      && candidate > offset)
+    offset = candidate;
+
+  /* The source view must not end before the previous one did.  That is
+     guaranteed because it either has the full window size or extends to
+     the end of the buffered data. */
+  source_len = (apr_size_t)(tracker->buf_offset + tracker->buf_len - offset);
+  if (source_len > SVN_DELTA_WINDOW_SIZE)
+    source_len = SVN_DELTA_WINDOW_SIZE;
+
+  memcpy(tracker->window_buf,
+         tracker->buf + (apr_size_t)(offset - tracker->buf_offset),
+         source_len);
+  memcpy(tracker->window_buf + source_len, target, target_len);
+
+  *window = compute_window(tracker->window_buf, source_len, target_len,
+                           offset, pool);
+  tracker->sview_offset = offset;
+  tracker->sview_len = source_len;
+
+  return SVN_NO_ERROR;
+}
+
+
 
 /* Generic delta stream functions. */
 
@@ -362,8 +517,12 @@ txdelta_next_window(svn_txdelta_window_t **window,
   apr_size_t source_len = SVN_DELTA_WINDOW_SIZE;
   apr_size_t target_len = SVN_DELTA_WINDOW_SIZE;
 
+  /* The source tracker reads the source on its own. */
+  if (b->tracker)
+    source_len = 0;
+
   /* Read the source stream. */
-  if (b->more_source)
+  else if (b->more_source)
     {
       SVN_ERR(svn_stream_read_full(b->source, b->buf, &source_len));
       b->more_source = (source_len == SVN_DELTA_WINDOW_SIZE);
@@ -388,8 +547,12 @@ txdelta_next_window(svn_txdelta_window_t **window,
   else if (b->context != NULL)
     SVN_ERR(svn_checksum_update(b->context, b->buf + source_len, target_len));
 
-  *window = compute_window(b->buf, source_len, target_len,
-                           b->pos - source_len, pool);
+  if (b->tracker)
+    SVN_ERR(compute_tracked_window(window, b->tracker, b->buf, target_len,
+                                   pool));
+  else
+    *window = compute_window(b->buf, source_len, target_len,
+                             b->pos - source_len, pool);
 
   /* That's it. */
   return SVN_NO_ERROR;
@@ -467,10 +630,11 @@ svn_txdelta_run(svn_stream_t *source,
 
 
 void
-svn_txdelta2(svn_txdelta_stream_t **stream,
+svn_txdelta3(svn_txdelta_stream_t **stream,
              svn_stream_t *source,
              svn_stream_t *target,
              svn_boolean_t calculate_checksum,
+             svn_boolean_t track_source,
              apr_pool_t *pool)
 {
   struct txdelta_baton *b = apr_pcalloc(pool, sizeof(*b));
@@ -483,21 +647,13 @@ svn_txdelta2(svn_txdelta_stream_t **stream,
   b->context = calculate_checksum
              ? svn_checksum_ctx_create(svn_checksum_md5, pool)
              : NULL;
+  b->tracker = track_source ? create_source_tracker(source, pool) : NULL;
   b->result_pool = pool;
 
   *stream = svn_txdelta_stream_create(b, txdelta_next_window,
                                       txdelta_md5_digest, pool);
 }
 
-void
-svn_txdelta(svn_txdelta_stream_t **stream,
-            svn_stream_t *source,
-            svn_stream_t *target,
-            apr_pool_t *pool)
-{
-  svn_txdelta2(stream, source, target, TRUE, pool);
-}
-
 
 
 /* Functions for implementing a "target push" delta. */
@@ -517,8 +673,9 @@ tpush_write_handler(void *baton, const char *data, apr_size_t *len)
     {
       svn_pool_clear(pool);
 
-      /* Make sure we're all full up on source data, if possible. */
-      if (tb->source_len == 0 && !tb->source_done)
+      /* Make sure we're all full up on source data, if possible.
+         The source tracker reads the source on its own. */
+      if (tb->source_len == 0 && !tb->source_done && !tb->tracker)
         {
           tb->source_len = SVN_DELTA_WINDOW_SIZE;
           SVN_ERR(svn_stream_read_full(tb->source, tb->buf, &tb->source_len));
@@ -538,8 +695,12 @@ tpush_write_handler(void *baton, const char *data, apr_size_t *len)
       /* If we're full of target data, compute and fire off a window. */
       if (tb->target_len == SVN_DELTA_WINDOW_SIZE)
         {
-          window = compute_window(tb->buf, tb->source_len, tb->target_len,
-                                  tb->source_offset, pool);
+          if (tb->tracker)
+            SVN_ERR(compute_tracked_window(&window, tb->tracker, tb->buf,
+                                           tb->target_len, pool));
+          else
+            window = compute_window(tb->buf, tb->source_len, tb->target_len,
+                                    tb->source_offset, pool);
           SVN_ERR(tb->wh(window, tb->whb));
           tb->source_offset += tb->source_len;
           tb->source_len = 0;
@@ -564,8 +725,12 @@ tpush_close_handler(void *baton)
   /* Send a final window if we have any residual target data. */
   if (tb->target_len > 0)
     {
-      window = compute_window(tb->buf, tb->source_len, tb->target_len,
-                              tb->source_offset, tb->pool);
+      if (tb->tracker)
+        SVN_ERR(compute_tracked_window(&window, tb->tracker, tb->buf,
+                                       tb->target_len, tb->pool));
+      else
+        window = compute_window(tb->buf, tb->source_len, tb->target_len,
+                                tb->source_offset, tb->pool);
       SVN_ERR(tb->wh(window, tb->whb));
     }
 
@@ -575,9 +740,11 @@ tpush_close_handler(void *baton)
 
 
 svn_stream_t *
-svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
-                        void *handler_baton, svn_stream_t *source,
-                        apr_pool_t *pool)
+svn_txdelta_target_push2(svn_txdelta_window_handler_t handler,
+                         void *handler_baton,
+                         svn_stream_t *source,
+                         svn_boolean_t track_source,
+                         apr_pool_t *pool)
 {
   struct tpush_baton *tb;
   svn_stream_t *stream;
@@ -593,6 +760,7 @@ svn_txdelta_target_push(svn_txdelta_window_handler_t handler,
   tb->source_len = 0;
   tb->source_done = FALSE;
   tb->target_len = 0;
+  tb->tracker = track_source ? create_source_tracker(source, pool) : NULL;
 
   /* Create and return writable stream. */
   stream = svn_stream_create(tb, pool);
@@ -633,12 +801,26 @@ patterning_copy(char *target, const char *source, apr_size_t len)
      presumably it will be in the L1 cache after the first iteration
      and doing this should avoid pipeline stalls due to write/read
      dependencies. */
-  const apr_size_t overlap = target - source;
+  apr_size_t overlap = target - source;
+
+  /* Runs of a single byte value are the most common short pattern. */
+  if (overlap == 1)
+    {
+      memset(target, *source, len);
+      return target + len;
+    }
+
+  /* After each copy, the range from SOURCE up to TARGET contains the
+     pattern one more time.  That range is still a valid (non-overlapping)
+     copy source and its period is that of the original pattern.  Hence,
+     we can double the chunk size with every iteration and get along with
+     only O(log(LEN / OVERLAP)) memcpy() calls. */
   while (len > overlap)
     {
       memcpy(target, source, overlap);
       target += overlap;
       len -= overlap;
+      overlap *= 2;
     }
 
   /* Copy any remaining source pattern. */
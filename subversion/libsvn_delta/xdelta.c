@@ -31,6 +31,13 @@
 #include "svn_delta.h"
 #include "private/svn_string_private.h"
 #include "delta.h"
+
+/* SSE2 is part of the x86-64 base ISA, so it is always safe to use if the
+   compiler targets it. */
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define SVN_XDELTA__USE_SSE2 1
+#endif
 
 /* This is pseudo-adler32. It is adler32 without the prime modulus.
    The idea is borrowed from monotone, and is a translation of the C++
@@ -79,6 +86,52 @@ adler32_replace(apr_uint32_t adler32, const char c_out, const char c_in)
 /* Calculate an pseudo-adler32 checksum for MATCH_BLOCKSIZE bytes starting
    at DATA.  Return the checksum value.  */
 
+#ifdef SVN_XDELTA__USE_SSE2
+
+/* Return the sum of the four 32 bit values in V. */
+static APR_INLINE apr_uint32_t
+horizontal_sum(__m128i v)
+{
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+
+  return (apr_uint32_t)_mm_cvtsi128_si32(v);
+}
+
+/* S2 is the sum of all bytes, each weighted with its distance from the
+ * end of the block.  Process 16 bytes at a time:  weight each byte with
+ * its distance from the end of its chunk and add the sum of all previous
+ * chunks 16 times for every further chunk.  All sums are exact, so the
+ * result is the same as for the byte-wise code below. */
+static APR_INLINE apr_uint32_t
+init_adler32(const char *data)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i weights_lo = _mm_set_epi16(9, 10, 11, 12, 13, 14, 15, 16);
+  const __m128i weights_hi = _mm_set_epi16(1, 2, 3, 4, 5, 6, 7, 8);
+  __m128i s1 = zero;
+  __m128i s2 = zero;
+  __m128i previous = zero;
+  int i;
+
+  for (i = 0; i < MATCH_BLOCKSIZE; i += sizeof(__m128i))
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *)(data + i));
+
+      previous = _mm_add_epi32(previous, s1);
+      s1 = _mm_add_epi32(s1, _mm_sad_epu8(chunk, zero));
+      s2 = _mm_add_epi32(s2, _mm_madd_epi16(_mm_unpacklo_epi8(chunk, zero),
+                                            weights_lo));
+      s2 = _mm_add_epi32(s2, _mm_madd_epi16(_mm_unpackhi_epi8(chunk, zero),
+                                            weights_hi));
+    }
+
+  return (horizontal_sum(s2) + horizontal_sum(previous) * 16)
+       * 0x10000 + horizontal_sum(s1);
+}
+
+#else
+
 static APR_INLINE apr_uint32_t
 init_adler32(const char *data)
 {
@@ -103,6 +156,8 @@ init_adler32(const char *data)
   return s2 * 0x10000 + s1;
 }
 
+#endif
+
 /* Information for a block of the delta source.  The length of the
    block is the smaller of MATCH_BLOCKSIZE and the difference between
    the size of the source data and the position of this block. */
@@ -278,7 +333,7 @@ find_match(const struct blocks *blocks,
            apr_size_t pending_insert_start)
 {
   apr_size_t apos, bpos = *bposp;
-  apr_size_t delta, max_delta;
+  apr_size_t delta, max_delta, back;
 
   apos = find_block(blocks, rolling, b + bpos);
 
@@ -296,12 +351,13 @@ find_match(const struct blocks *blocks,
 
   /* See if we can extend backwards (max MATCH_BLOCKSIZE-1 steps because A's
      content has been sampled only every MATCH_BLOCKSIZE positions).  */
-  while (apos > 0 && bpos > pending_insert_start && a[apos-1] == b[bpos-1])
-    {
-      --apos;
-      --bpos;
-      ++delta;
-    }
+  back = svn_cstring__reverse_match_length(a + apos, b + bpos,
+                                           apos < bpos - pending_insert_start
+                                           ? apos
+                                           : bpos - pending_insert_start);
+  apos -= back;
+  bpos -= back;
+  delta += back;
 
   *aposp = apos;
   *bposp = bpos;
@@ -494,3 +550,160 @@ svn_txdelta__xdelta(svn_txdelta__ops_baton_t *build_baton,
                 data + source_len, target_len,
                 pool);
 }
+
+
+/* Source index. */
+
+/* Stop looking for further matches in a target window after that many
+   blocks have been found in the source index. */
+#define SOURCE_INDEX_MAX_HITS 32
+
+/* Number of distinct source positions that we consider per target
+   window. */
+#define SOURCE_INDEX_MAX_CANDIDATES 8
+
+/* An entry in the source index. */
+struct source_block
+{
+  /* Position of the block within the source.  -1 for unused entries. */
+  svn_filesize_t offset;
+
+  /* Checksum of the block. */
+  apr_uint32_t adlersum;
+};
+
+struct svn_txdelta__source_index_t
+{
+  /* The largest valid index of SLOTS.  SLOTS is a lossy hash table, i.e.
+     colliding blocks simply replace older entries. */
+  apr_uint32_t max;
+
+  /* The blocks, addressed by HASH_FUNC of their checksum. */
+  struct source_block *slots;
+};
+
+svn_txdelta__source_index_t *
+svn_txdelta__source_index_create(apr_size_t capacity,
+                                 apr_pool_t *pool)
+{
+  svn_txdelta__source_index_t *index = apr_palloc(pool, sizeof(*index));
+  apr_size_t nslots = 1;
+  apr_size_t i;
+
+  /* Twice as many slots as there will be blocks keeps collisions low. */
+  while (nslots <= capacity / MATCH_BLOCKSIZE)
+    nslots *= 2;
+  nslots *= 2;
+
+  index->max = (apr_uint32_t)(nslots - 1);
+  index->slots = apr_palloc(pool, nslots * sizeof(*index->slots));
+  for (i = 0; i < nslots; ++i)
+    {
+      index->slots[i].offset = -1;
+      index->slots[i].adlersum = 0;
+    }
+
+  return index;
+}
+
+apr_size_t
+svn_txdelta__source_index_add(svn_txdelta__source_index_t *index,
+                              const char *data,
+                              apr_size_t len,
+                              svn_filesize_t offset)
+{
+  apr_size_t i;
+
+  for (i = 0; i + MATCH_BLOCKSIZE <= len; i += MATCH_BLOCKSIZE)
+    {
+      apr_uint32_t adlersum = init_adler32(data + i);
+      struct source_block *slot
+        = &index->slots[hash_func(adlersum) & index->max];
+
+      slot->offset = offset + i;
+      slot->adlersum = adlersum;
+    }
+
+  return i;
+}
+
+svn_boolean_t
+svn_txdelta__source_index_find(svn_filesize_t *offset,
+                               const svn_txdelta__source_index_t *index,
+                               const char *source,
+                               svn_filesize_t source_offset,
+                               apr_size_t source_len,
+                               const char *target,
+                               apr_size_t target_len)
+{
+  svn_filesize_t candidates[SOURCE_INDEX_MAX_CANDIDATES];
+  int votes[SOURCE_INDEX_MAX_CANDIDATES];
+  int candidate_count = 0;
+  int hits = 0;
+  int best, i;
+  apr_size_t pos = 0;
+  apr_uint32_t rolling;
+
+  if (target_len < MATCH_BLOCKSIZE)
+    return FALSE;
+
+  rolling = init_adler32(target);
+  while (TRUE)
+    {
+      const struct source_block *slot
+        = &index->slots[hash_func(rolling) & index->max];
+
+      if (   slot->adlersum == rolling
+          && slot->offset >= source_offset
+          && slot->offset + MATCH_BLOCKSIZE <= source_offset + source_len
+          && memcmp(source + (apr_size_t)(slot->offset - source_offset),
+                    target + pos, MATCH_BLOCKSIZE) == 0)
+        {
+          /* Vote for the source position that corresponds to the start
+             of TARGET. */
+          svn_filesize_t candidate = slot->offset - (svn_filesize_t)pos;
+          for (i = 0; i < candidate_count; ++i)
+            if (candidates[i] == candidate)
+              break;
+
+          if (i < candidate_count)
+            ++votes[i];
+          else if (candidate_count < SOURCE_INDEX_MAX_CANDIDATES)
+            {
+              candidates[candidate_count] = candidate;
+              votes[candidate_count] = 1;
+              ++candidate_count;
+            }
+
+          if (++hits == SOURCE_INDEX_MAX_HITS)
+            break;
+
+          /* Continue behind the matching block. */
+          pos += MATCH_BLOCKSIZE;
+          if (pos + MATCH_BLOCKSIZE > target_len)
+            break;
+
+          rolling = init_adler32(target + pos);
+        }
+      else
+        {
+          if (pos + MATCH_BLOCKSIZE >= target_len)
+            break;
+
+          rolling = adler32_replace(rolling, target[pos],
+                                    target[pos + MATCH_BLOCKSIZE]);
+          ++pos;
+        }
+    }
+
+  if (candidate_count == 0)
+    return FALSE;
+
+  best = 0;
+  for (i = 1; i < candidate_count; ++i)
+    if (votes[i] > votes[best])
+      best = i;
+
+  *offset = candidates[best];
+  return TRUE;
+}
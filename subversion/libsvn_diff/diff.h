@@ -101,6 +101,10 @@ typedef enum svn_diff__normalize_state_t
  * equal and be excluded from the comparison process. Similarly, SUFFIX_LINES
  * at the end of both sequences will be skipped.
  *
+ * If HISTOGRAM is set, use the histogram diff algorithm instead of the
+ * default O(NP) one.  It does not guarantee a minimal result but has a
+ * bounded run time, even for large and very different inputs.
+ *
  * The resulting lcs structure will be the return value of this function.
  * Allocations will be made from POOL.
  */
@@ -112,6 +116,7 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
               svn_diff__token_index_t num_tokens, /* length of count arrays */
               apr_off_t prefix_lines,
               apr_off_t suffix_lines,
+              svn_boolean_t histogram,
               apr_pool_t *pool);
 
 
@@ -163,8 +168,34 @@ svn_diff__resolve_conflict(svn_diff_t *hunk,
                            svn_diff__position_t **position_list1,
                            svn_diff__position_t **position_list2,
                            svn_diff__token_index_t num_tokens,
+                           svn_boolean_t histogram,
                            apr_pool_t *pool);
 
+/* Like svn_diff_diff_2(), svn_diff_diff3_2() and svn_diff_diff4_2(),
+ * respectively, but use the histogram diff algorithm if HISTOGRAM is set.
+ * See svn_diff__lcs().
+ */
+svn_error_t *
+svn_diff__diff_2(svn_diff_t **diff,
+                 void *diff_baton,
+                 const svn_diff_fns2_t *vtable,
+                 svn_boolean_t histogram,
+                 apr_pool_t *pool);
+
+svn_error_t *
+svn_diff__diff3_2(svn_diff_t **diff,
+                  void *diff_baton,
+                  const svn_diff_fns2_t *vtable,
+                  svn_boolean_t histogram,
+                  apr_pool_t *pool);
+
+svn_error_t *
+svn_diff__diff4_2(svn_diff_t **diff,
+                  void *diff_baton,
+                  const svn_diff_fns2_t *vtable,
+                  svn_boolean_t histogram,
+                  apr_pool_t *pool);
+
 
 /* Normalize the characters pointed to by the buffer BUF (of length *LENGTHP)
  * according to the options *OPTS, starting in the state *STATEP.
@@ -80,6 +80,10 @@ typedef struct svn_diff__file_baton_t
     apr_file_t *file;  /* handle of this file */
     apr_off_t size;    /* total raw size in bytes of this file */
 
+    /* The whole file contents, if the file has been memory-mapped.
+       The chunk buffer will then simply point into it. */
+    char *map;
+
     /* The current chunk: CHUNK_SIZE bytes except for the last chunk. */
     int chunk;     /* the current chunk number, zero-based */
     char *buffer;  /* a buffer containing the current chunk */
@@ -152,6 +156,27 @@ read_chunk(apr_file_t *file,
 }
 
 
+/* Make LENGTH bytes of FILE, starting at OFFSET, available in
+ * FILE->BUFFER.  If FILE has been memory-mapped, this merely points
+ * FILE->BUFFER into the mapping.
+ */
+static APR_INLINE svn_error_t *
+load_chunk(struct file_info *file,
+           apr_off_t length,
+           apr_off_t offset,
+           apr_pool_t *scratch_pool)
+{
+  if (file->map)
+    {
+      file->buffer = file->map + offset;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(read_chunk(file->file, file->buffer, length, offset,
+                                    scratch_pool));
+}
+
+
 /* Map or read a file at PATH. *BUFFER will point to the file
  * contents; if the file was mapped, *FILE and *MM will contain the
  * mmap context; otherwise they will be NULL.  SIZE will contain the
@@ -288,9 +313,7 @@ increment_chunk(struct file_info *file, apr_pool_t *pool)
       file->chunk++;
       length = file->chunk == last_chunk ?
         offset_in_chunk(file->size) : CHUNK_SIZE;
-      SVN_ERR(read_chunk(file->file, file->buffer,
-                         length, chunk_to_offset(file->chunk),
-                         pool));
+      SVN_ERR(load_chunk(file, length, chunk_to_offset(file->chunk), pool));
       file->endp = file->buffer + length;
       file->curp = file->buffer;
     }
@@ -315,8 +338,7 @@ decrement_chunk(struct file_info *file, apr_pool_t *pool)
     {
       /* Read previous chunk and reset pointers. */
       file->chunk--;
-      SVN_ERR(read_chunk(file->file, file->buffer,
-                         CHUNK_SIZE, chunk_to_offset(file->chunk),
+      SVN_ERR(load_chunk(file, CHUNK_SIZE, chunk_to_offset(file->chunk),
                          pool));
       file->endp = file->buffer + CHUNK_SIZE;
       file->curp = file->endp - 1;
@@ -553,6 +575,7 @@ find_identical_suffix(apr_off_t *suffix_lines, struct file_info file[],
     {
       file_for_suffix[i].path = file[i].path;
       file_for_suffix[i].file = file[i].file;
+      file_for_suffix[i].map = file[i].map;
       file_for_suffix[i].size = file[i].size;
       file_for_suffix[i].chunk =
         (int) offset_to_chunk(file_for_suffix[i].size); /* last chunk */
@@ -573,9 +596,9 @@ find_identical_suffix(apr_off_t *suffix_lines, struct file_info file[],
         {
           /* There is at least more than 1 chunk,
              so allocate full chunk size buffer */
-          file_for_suffix[i].buffer = apr_palloc(pool, CHUNK_SIZE);
-          SVN_ERR(read_chunk(file_for_suffix[i].file,
-                             file_for_suffix[i].buffer, length[i],
+          if (! file_for_suffix[i].map)
+            file_for_suffix[i].buffer = apr_palloc(pool, CHUNK_SIZE);
+          SVN_ERR(load_chunk(&file_for_suffix[i], length[i],
                              chunk_to_offset(file_for_suffix[i].chunk),
                              pool));
         }
@@ -757,8 +780,9 @@ find_identical_suffix(apr_off_t *suffix_lines, struct file_info file[],
  * BATON's type is (svn_diff__file_baton_t *).
  *
  * For each file in the FILE array, open the file at FILE.path; initialize
- * FILE.file, FILE.size, FILE.buffer, FILE.curp and FILE.endp; allocate a
- * buffer and read the first chunk.  Then find the prefix and suffix lines
+ * FILE.file, FILE.size, FILE.map, FILE.buffer, FILE.curp and FILE.endp;
+ * memory-map the file or allocate a buffer and read the first chunk.
+ * Then find the prefix and suffix lines
  * which are identical between all the files.  Return the number of identical
  * prefix lines in PREFIX_LINES, and the number of identical suffix lines in
  * SUFFIX_LINES.
@@ -782,6 +806,14 @@ datasources_open(void *baton,
   svn_boolean_t reached_one_eof;
 #endif
   apr_size_t i;
+#if APR_HAS_MMAP
+  /* Normalization modifies the chunk buffers in place, so we can only
+   * tokenize (read-only) mapped files directly if there is nothing to
+   * normalize. */
+  svn_boolean_t use_mmap
+    = (file_baton->options->ignore_space == svn_diff_file_ignore_space_none
+       && !file_baton->options->ignore_eol_style);
+#endif
 
   /* Make sure prefix_lines and suffix_lines are set correctly, even if we
    * exit early because one of the files is empty. */
@@ -799,9 +831,29 @@ datasources_open(void *baton,
       SVN_ERR(svn_io_file_size_get(&filesize, file->file, file_baton->pool));
       file->size = filesize;
       length[i] = filesize > CHUNK_SIZE ? CHUNK_SIZE : filesize;
-      file->buffer = apr_palloc(file_baton->pool, (apr_size_t) length[i]);
-      SVN_ERR(read_chunk(file->file, file->buffer,
-                         length[i], 0, file_baton->pool));
+
+      /* Tokenize large files in place instead of copying them chunk by
+       * chunk.  This saves memory as well as the I/O calls that would
+       * otherwise be needed to compare tokens outside the current chunk. */
+      file->map = NULL;
+#if APR_HAS_MMAP
+      if (use_mmap
+          && filesize > APR_MMAP_THRESHOLD
+          && filesize <= APR_SIZE_MAX)
+        {
+          apr_mmap_t *mm;
+
+          /* On failure we just fall back to reading the chunks. */
+          if (apr_mmap_create(&mm, file->file, 0, (apr_size_t) filesize,
+                              APR_MMAP_READ, file_baton->pool)
+              == APR_SUCCESS)
+            file->map = mm->mm;
+        }
+#endif
+
+      if (! file->map)
+        file->buffer = apr_palloc(file_baton->pool, (apr_size_t) length[i]);
+      SVN_ERR(load_chunk(file, length[i], 0, file_baton->pool));
       file->endp = file->buffer + length[i];
       file->curp = file->buffer;
       /* Set suffix_start_chunk to a guard value, so if suffix scanning is
@@ -953,12 +1005,9 @@ datasource_get_next_token(apr_uint32_t *hash, void **token, void *baton,
         h = svn__adler32(h, c, length);
       }
 
-      curp = endp = file->buffer;
       file->chunk++;
       length = file->chunk == last_chunk ?
         offset_in_chunk(file->size) : CHUNK_SIZE;
-      endp += length;
-      file->endp = endp;
 
       /* Issue #4283: Normally we should have checked for reaching the skipped
          suffix here, but because we assume that a suffix always starts on a
@@ -968,10 +1017,11 @@ datasource_get_next_token(apr_uint32_t *hash, void **token, void *baton,
          When changing things here, make sure the whitespace settings are
          applied, or we might not reach the exact suffix boundary as token
          boundary. */
-      SVN_ERR(read_chunk(file->file,
-                         curp, length,
-                         chunk_to_offset(file->chunk),
+      SVN_ERR(load_chunk(file, length, chunk_to_offset(file->chunk),
                          file_baton->pool));
+      curp = file->buffer;
+      endp = curp + length;
+      file->endp = endp;
 
       /* If the last chunk ended in a CR, we're done. */
       if (had_cr)
@@ -1062,7 +1112,17 @@ token_compare(void *baton, void *token1, void *token2, int *compare)
       offset[i] = file_token[i]->norm_offset;
       state[i] = svn_diff__normalize_state_normal;
 
-      if (offset_to_chunk(offset[i]) == file[i]->chunk)
+      if (file[i]->map)
+        {
+          /* The whole file is in memory and, as there is no normalization
+           * for mapped files, the token can be compared as is.
+           */
+          bufp[i] = file[i]->map + offset[i];
+
+          length[i] = total_length;
+          raw_length[i] = 0;
+        }
+      else if (offset_to_chunk(offset[i]) == file[i]->chunk)
         {
           /* If the start of the token is in memory, the entire token is
            * in memory.
@@ -1182,6 +1242,9 @@ static const svn_diff_fns2_t svn_diff__file_vtable =
 /* Id for the --ignore-eol-style option, which doesn't have a short name. */
 #define SVN_DIFF__OPT_IGNORE_EOL_STYLE 256
 
+/* Id for the --histogram option, which doesn't have a short name. */
+#define SVN_DIFF__OPT_HISTOGRAM 257
+
 /* Options supported by svn_diff_file_options_parse(). */
 static const apr_getopt_option_t diff_options[] =
 {
@@ -1193,6 +1256,7 @@ static const apr_getopt_option_t diff_options[] =
    * ### we don't have optional argument support. */
   { "unified", 'u', 0, NULL },
   { "context", 'U', 1, NULL },
+  { "histogram", SVN_DIFF__OPT_HISTOGRAM, 0, NULL },
   { NULL, 0, 0, NULL }
 };
 
@@ -1295,6 +1359,9 @@ svn_diff_file_options_parse(svn_diff_file_options_t *options,
         case 'p':
           options->show_c_function = TRUE;
           break;
+        case SVN_DIFF__OPT_HISTOGRAM:
+          options->histogram = TRUE;
+          break;
         case 'U':
           SVN_ERR(svn_cstring_atoi(&options->context_size, opt_arg));
           break;
@@ -1326,7 +1393,8 @@ svn_diff_file_diff_2(svn_diff_t **diff,
   baton.files[1].path = modified;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff_2(diff, &baton, &svn_diff__file_vtable,
+                           options->histogram, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -1348,7 +1416,8 @@ svn_diff_file_diff3_2(svn_diff_t **diff,
   baton.files[2].path = latest;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff3_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff3_2(diff, &baton, &svn_diff__file_vtable,
+                            options->histogram, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -1372,7 +1441,8 @@ svn_diff_file_diff4_2(svn_diff_t **diff,
   baton.files[3].path = ancestor;
   baton.pool = svn_pool_create(pool);
 
-  SVN_ERR(svn_diff_diff4_2(diff, &baton, &svn_diff__file_vtable, pool));
+  SVN_ERR(svn_diff__diff4_2(diff, &baton, &svn_diff__file_vtable,
+                            options->histogram, pool));
 
   svn_pool_destroy(baton.pool);
   return SVN_NO_ERROR;
@@ -26,6 +26,8 @@
 #include <apr_pools.h>
 #include <apr_general.h>
 
+#include "svn_pools.h"
+#include "svn_sorts.h"
 #include "diff.h"
 
 
@@ -228,6 +230,376 @@ prepend_lcs(svn_diff__lcs_t *lcs, apr_off_t lines,
 }
 
 
+/*
+ * Histogram diff.
+ *
+ * An alternative to the O(NP) algorithm above, modelled after the
+ * histogram diff of JGit, which itself is an extension of Bram Cohen's
+ * patience diff.  Within a region of both sequences, we look for the run
+ * of matching tokens that contains the token with the fewest occurrences
+ * in the first sequence (preferring longer runs on ties).  That run
+ * becomes part of the LCS and the regions before and after it are being
+ * processed the same way.
+ *
+ * Only the first HISTOGRAM_MAX_CHAIN occurrences of any token within a
+ * region are considered as match candidates.  Together with an overall
+ * budget of token comparisons that is proportional to M + N, this bounds
+ * the run time to O((M + N) * HISTOGRAM_MAX_CHAIN).  Once the budget has
+ * been used up, all remaining regions will simply be reported as changed
+ * (minus their common prefix and suffix).  Memory usage is linear in
+ * M + N plus the number of distinct tokens.
+ *
+ * The result is not necessarily minimal but it is often easier to read
+ * because rare lines, like function headers, are preferred over blank
+ * lines and braces as sync points.
+ */
+
+/* Maximum number of occurrences of a token to check within a region. */
+#define HISTOGRAM_MAX_CHAIN 64
+
+/* An entry on the work stack of histogram_lcs(): either a REGION
+ * [START[0], END[0]) x [START[1], END[1]) still to be compared, or a run
+ * of matching tokens of length END[0] - START[0] to be added to the LCS.
+ * All indexes are relative to the beginning of the compared sequences. */
+typedef struct histogram_item_t
+{
+  svn_boolean_t is_match;
+  apr_off_t start[2];
+  apr_off_t end[2];
+} histogram_item_t;
+
+/* State of the histogram diff. */
+typedef struct histogram_t
+{
+  /* The positions of both sequences as arrays. */
+  svn_diff__position_t **positions[2];
+
+  /* For every position in the first sequence, the index of the next
+   * occurrence of the same token within the current region, or -1. */
+  apr_off_t *next;
+
+  /* For every token, the index of its first occurrence in the first
+   * sequence within the current region, or -1. */
+  apr_off_t *head;
+
+  /* For every token, the number of its occurrences in the first sequence
+   * within the current region. */
+  apr_off_t *count;
+
+  /* Number of token comparisons we may still do. */
+  apr_int64_t budget;
+
+  /* The LCS built so far and its last element. */
+  svn_diff__lcs_t *lcs;
+  svn_diff__lcs_t *lcs_tail;
+
+  /* Pool to allocate the LCS from. */
+  apr_pool_t *pool;
+} histogram_t;
+
+#define HISTOGRAM_TOKEN(h, i, idx) ((h)->positions[i][idx]->token_index)
+
+/* Append the run of LENGTH matching tokens at indexes START0 and START1
+ * to the LCS in H. */
+static void
+histogram_append_match(histogram_t *h,
+                       apr_off_t start0,
+                       apr_off_t start1,
+                       apr_off_t length)
+{
+  svn_diff__lcs_t *lcs = h->lcs_tail;
+
+  if (length == 0)
+    return;
+
+  /* Extend the previous run, if this one is adjacent to it. */
+  if (lcs
+      && lcs->position[0]->offset + lcs->length
+           == h->positions[0][start0]->offset
+      && lcs->position[1]->offset + lcs->length
+           == h->positions[1][start1]->offset)
+    {
+      lcs->length += length;
+      return;
+    }
+
+  lcs = apr_palloc(h->pool, sizeof(*lcs));
+  lcs->position[0] = h->positions[0][start0];
+  lcs->position[1] = h->positions[1][start1];
+  lcs->length = length;
+  lcs->refcount = 1;
+  lcs->next = NULL;
+
+  if (h->lcs_tail)
+    h->lcs_tail->next = lcs;
+  else
+    h->lcs = lcs;
+
+  h->lcs_tail = lcs;
+}
+
+/* Find the best anchor run of matching tokens within REGION for the
+ * histogram diff H.  Return its length and set *START0 and *START1 to
+ * its indexes in the respective sequence.  Return 0 if there is no
+ * match. */
+static apr_off_t
+histogram_find_anchor(apr_off_t *start0,
+                      apr_off_t *start1,
+                      histogram_t *h,
+                      const histogram_item_t *region)
+{
+  const apr_off_t a_start = region->start[0];
+  const apr_off_t a_end = region->end[0];
+  const apr_off_t b_start = region->start[1];
+  const apr_off_t b_end = region->end[1];
+  apr_off_t best_count = 0;
+  apr_off_t best_length = 0;
+  apr_off_t a, b;
+
+  /* Build the histogram of the first sequence.  Iterate backwards such
+   * that the chains list the occurrences in ascending order. */
+  for (a = a_end; a-- > a_start; )
+    {
+      svn_diff__token_index_t token = HISTOGRAM_TOKEN(h, 0, a);
+
+      h->next[a] = h->head[token];
+      h->head[token] = a;
+      h->count[token]++;
+    }
+
+  h->budget -= (a_end - a_start);
+
+  for (b = b_start; b < b_end && h->budget > 0; )
+    {
+      svn_diff__token_index_t token = HISTOGRAM_TOKEN(h, 1, b);
+      apr_off_t b_next = b + 1;
+      int chain_length;
+
+      /* Tokens that are unknown to the first sequence and ones that are
+       * more frequent than our best candidate so far can be skipped. */
+      if (h->count[token] == 0
+          || (best_length && h->count[token] > best_count))
+        {
+          b++;
+          continue;
+        }
+
+      for (a = h->head[token], chain_length = 0;
+           a >= 0 && chain_length < HISTOGRAM_MAX_CHAIN;
+           a = h->next[a], chain_length++)
+        {
+          apr_off_t match_count = h->count[token];
+          apr_off_t a_first = a, b_first = b;
+          apr_off_t a_last = a + 1, b_last = b + 1;
+
+          while (a_first > a_start && b_first > b_start
+                 && HISTOGRAM_TOKEN(h, 0, a_first - 1)
+                      == HISTOGRAM_TOKEN(h, 1, b_first - 1))
+            {
+              a_first--;
+              b_first--;
+              match_count = MIN(match_count,
+                                h->count[HISTOGRAM_TOKEN(h, 0, a_first)]);
+            }
+
+          while (a_last < a_end && b_last < b_end
+                 && HISTOGRAM_TOKEN(h, 0, a_last)
+                      == HISTOGRAM_TOKEN(h, 1, b_last))
+            {
+              match_count = MIN(match_count,
+                                h->count[HISTOGRAM_TOKEN(h, 0, a_last)]);
+              a_last++;
+              b_last++;
+            }
+
+          h->budget -= a_last - a_first;
+
+          if (best_length == 0
+              || match_count < best_count
+              || (match_count == best_count
+                  && a_last - a_first > best_length))
+            {
+              best_count = match_count;
+              best_length = a_last - a_first;
+              *start0 = a_first;
+              *start1 = b_first;
+            }
+
+          /* Don't look for longer runs within the one we just found. */
+          b_next = MAX(b_next, b_last);
+        }
+
+      b = b_next;
+    }
+
+  /* Reset the histogram for the next region. */
+  for (a = a_start; a < a_end; a++)
+    {
+      svn_diff__token_index_t token = HISTOGRAM_TOKEN(h, 0, a);
+
+      h->head[token] = -1;
+      h->count[token] = 0;
+    }
+
+  return best_length;
+}
+
+/* Push a new entry onto the work STACK. */
+static void
+histogram_push(apr_array_header_t *stack,
+               svn_boolean_t is_match,
+               apr_off_t start0, apr_off_t end0,
+               apr_off_t start1, apr_off_t end1)
+{
+  histogram_item_t *item = apr_array_push(stack);
+
+  item->is_match = is_match;
+  item->start[0] = start0;
+  item->end[0] = end0;
+  item->start[1] = start1;
+  item->end[1] = end1;
+}
+
+/* Implement svn_diff__lcs() for non-empty POSITION_LIST1 and
+ * POSITION_LIST2 using the histogram diff.  EOF_LCS is the EOF sentinel
+ * element to terminate the result with. */
+static svn_diff__lcs_t *
+histogram_lcs(svn_diff__lcs_t *eof_lcs,
+              svn_diff__position_t *position_list1,
+              svn_diff__position_t *position_list2,
+              svn_diff__token_index_t num_tokens,
+              apr_off_t prefix_lines,
+              apr_off_t suffix_lines,
+              apr_pool_t *pool)
+{
+  apr_pool_t *scratch_pool = svn_pool_create(pool);
+  svn_diff__position_t *position_list[2];
+  apr_off_t length[2];
+  apr_array_header_t *stack;
+  histogram_t h = { { NULL } };
+  svn_diff__token_index_t token_index;
+  svn_diff__lcs_t *lcs;
+  int i;
+
+  position_list[0] = position_list1;
+  position_list[1] = position_list2;
+
+  /* Convert the rings into arrays for random access. */
+  for (i = 0; i < 2; i++)
+    {
+      svn_diff__position_t *position = position_list[i]->next;
+      apr_off_t k;
+
+      length[i] = position_list[i]->offset - position->offset + 1;
+      h.positions[i] = apr_palloc(scratch_pool,
+                                  sizeof(*h.positions[i])
+                                    * (apr_size_t)length[i]);
+      for (k = 0; k < length[i]; k++, position = position->next)
+        h.positions[i][k] = position;
+    }
+
+  h.next = apr_palloc(scratch_pool, sizeof(*h.next) * (apr_size_t)length[0]);
+  h.head = apr_palloc(scratch_pool, sizeof(*h.head) * (apr_size_t)num_tokens);
+  h.count = apr_pcalloc(scratch_pool,
+                        sizeof(*h.count) * (apr_size_t)num_tokens);
+  for (token_index = 0; token_index < num_tokens; token_index++)
+    h.head[token_index] = -1;
+
+  h.budget = ((apr_int64_t)length[0] + length[1]) * HISTOGRAM_MAX_CHAIN * 2;
+  h.pool = pool;
+
+  /* Process the regions depth-first, left to right.  Popping a region
+   * means that all matches before it have already been added to the
+   * LCS.  So, we push the parts of a region in reverse order. */
+  stack = apr_array_make(scratch_pool, 64, sizeof(histogram_item_t));
+  histogram_push(stack, FALSE, 0, length[0], 0, length[1]);
+
+  while (stack->nelts)
+    {
+      histogram_item_t item = *(histogram_item_t *)apr_array_pop(stack);
+      apr_off_t common;
+      apr_off_t anchor_length;
+      apr_off_t anchor[2];
+
+      if (item.is_match)
+        {
+          histogram_append_match(&h, item.start[0], item.start[1],
+                                 item.end[0] - item.start[0]);
+          continue;
+        }
+
+      /* Strip the common prefix ... */
+      for (common = 0;
+           item.start[0] + common < item.end[0]
+             && item.start[1] + common < item.end[1]
+             && HISTOGRAM_TOKEN(&h, 0, item.start[0] + common)
+                  == HISTOGRAM_TOKEN(&h, 1, item.start[1] + common);
+           common++)
+        ;
+
+      histogram_append_match(&h, item.start[0], item.start[1], common);
+      item.start[0] += common;
+      item.start[1] += common;
+
+      /* ... and suffix of the region. */
+      for (common = 0;
+           item.end[0] - common > item.start[0]
+             && item.end[1] - common > item.start[1]
+             && HISTOGRAM_TOKEN(&h, 0, item.end[0] - common - 1)
+                  == HISTOGRAM_TOKEN(&h, 1, item.end[1] - common - 1);
+           common++)
+        ;
+
+      item.end[0] -= common;
+      item.end[1] -= common;
+      if (common)
+        histogram_push(stack, TRUE, item.end[0], item.end[0] + common,
+                       item.end[1], item.end[1] + common);
+
+      if (item.start[0] == item.end[0] || item.start[1] == item.end[1]
+          || h.budget <= 0)
+        continue;
+
+      anchor_length = histogram_find_anchor(&anchor[0], &anchor[1],
+                                            &h, &item);
+      if (anchor_length == 0)
+        continue;
+
+      histogram_push(stack, FALSE,
+                     anchor[0] + anchor_length, item.end[0],
+                     anchor[1] + anchor_length, item.end[1]);
+      histogram_push(stack, TRUE,
+                     anchor[0], anchor[0] + anchor_length,
+                     anchor[1], anchor[1] + anchor_length);
+      histogram_push(stack, FALSE,
+                     item.start[0], anchor[0],
+                     item.start[1], anchor[1]);
+    }
+
+  svn_pool_destroy(scratch_pool);
+
+  /* Terminate the LCS with the common suffix and the EOF element. */
+  if (suffix_lines)
+    lcs = prepend_lcs(eof_lcs, suffix_lines,
+                      eof_lcs->position[0]->offset - suffix_lines,
+                      eof_lcs->position[1]->offset - suffix_lines,
+                      pool);
+  else
+    lcs = eof_lcs;
+
+  if (h.lcs_tail)
+    {
+      h.lcs_tail->next = lcs;
+      lcs = h.lcs;
+    }
+
+  if (prefix_lines)
+    return prepend_lcs(lcs, prefix_lines, 1, 1, pool);
+  else
+    return lcs;
+}
+
+
 svn_diff__lcs_t *
 svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
               svn_diff__position_t *position_list2, /* pointer to tail (ring) */
@@ -236,6 +608,7 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
               svn_diff__token_index_t num_tokens,
               apr_off_t prefix_lines,
               apr_off_t suffix_lines,
+              svn_boolean_t histogram,
               apr_pool_t *pool)
 {
   apr_off_t length[2];
@@ -279,6 +652,10 @@ svn_diff__lcs(svn_diff__position_t *position_list1, /* pointer to tail (ring) */
       return lcs;
     }
 
+  if (histogram)
+    return histogram_lcs(lcs, position_list1, position_list2, num_tokens,
+                         prefix_lines, suffix_lines, pool);
+
   unique_count[1] = unique_count[0] = 0;
   for (token_index = 0; token_index < num_tokens; token_index++)
     {
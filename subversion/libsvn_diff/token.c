@@ -34,30 +34,68 @@
 
 
 /*
- * Prime number to use as the size of the hash table.  This number was
- * not selected by testing of any kind and may need tweaking.
+ * The tokens are being kept in an open-addressing hash table with linear
+ * probing.  Compared to a tree of nodes, lookups touch only one or two
+ * adjacent cache lines and there is no per-node allocation.
  */
-#define SVN_DIFF__HASH_SIZE 127
+
+/* Initial number of slots in the hash table, as a power of 2. */
+#define SVN_DIFF__TABLE_INITIAL_BITS 10
 
 struct svn_diff__node_t
 {
-  svn_diff__node_t       *parent;
-  svn_diff__node_t       *left;
-  svn_diff__node_t       *right;
-
   apr_uint32_t            hash;
   svn_diff__token_index_t index;
+
+  /* NULL for unused slots. */
   void                   *token;
 };
 
 struct svn_diff__tree_t
 {
-  svn_diff__node_t       *root[SVN_DIFF__HASH_SIZE];
+  /* The hash table with SIZE == 1 << BITS slots. */
+  svn_diff__node_t       *nodes;
+  apr_size_t              size;
+  int                     bits;
   apr_pool_t             *pool;
   svn_diff__token_index_t node_count;
 };
 
 
+/* Return the slot in TREE at which to start looking for HASH. */
+static APR_INLINE apr_size_t
+first_slot(const svn_diff__tree_t *tree, apr_uint32_t hash)
+{
+  /* The hashes provided by the datasources may not be evenly distributed;
+   * spread them with a multiplicative hash and use its upper bits. */
+  return (apr_uint32_t)(hash * 0x9E3779B1u) >> (32 - tree->bits);
+}
+
+/* Double the number of slots in TREE. */
+static void
+grow_table(svn_diff__tree_t *tree)
+{
+  svn_diff__node_t *old_nodes = tree->nodes;
+  apr_size_t old_size = tree->size;
+  apr_size_t i;
+
+  tree->bits++;
+  tree->size *= 2;
+  tree->nodes = apr_pcalloc(tree->pool, tree->size * sizeof(*tree->nodes));
+
+  for (i = 0; i < old_size; i++)
+    if (old_nodes[i].token)
+      {
+        apr_size_t slot = first_slot(tree, old_nodes[i].hash);
+
+        while (tree->nodes[slot].token)
+          slot = (slot + 1) & (tree->size - 1);
+
+        tree->nodes[slot] = old_nodes[i];
+      }
+}
+
+
 /*
  * Returns number of tokens in a tree
  */
@@ -75,68 +113,63 @@ void
 svn_diff__tree_create(svn_diff__tree_t **tree, apr_pool_t *pool)
 {
   *tree = apr_pcalloc(pool, sizeof(**tree));
+  (*tree)->bits = SVN_DIFF__TABLE_INITIAL_BITS;
+  (*tree)->size = (apr_size_t)1 << SVN_DIFF__TABLE_INITIAL_BITS;
+  (*tree)->nodes = apr_pcalloc(pool, (*tree)->size
+                                       * sizeof(*(*tree)->nodes));
   (*tree)->pool = pool;
   (*tree)->node_count = 0;
 }
 
 
 static svn_error_t *
-tree_insert_token(svn_diff__node_t **node, svn_diff__tree_t *tree,
+tree_insert_token(svn_diff__token_index_t *index, svn_diff__tree_t *tree,
                   void *diff_baton,
                   const svn_diff_fns2_t *vtable,
                   apr_uint32_t hash, void *token)
 {
-  svn_diff__node_t *new_node;
-  svn_diff__node_t **node_ref;
-  svn_diff__node_t *parent;
-  int rv;
+  svn_diff__node_t *node;
+  apr_size_t slot;
 
   SVN_ERR_ASSERT(token);
 
-  parent = NULL;
-  node_ref = &tree->root[hash % SVN_DIFF__HASH_SIZE];
+  /* Keep the load factor below 1/2. */
+  if ((apr_size_t)tree->node_count * 2 >= tree->size)
+    grow_table(tree);
 
-  while (*node_ref != NULL)
+  for (slot = first_slot(tree, hash);
+       tree->nodes[slot].token;
+       slot = (slot + 1) & (tree->size - 1))
     {
-      parent = *node_ref;
+      int rv;
 
-      rv = hash - parent->hash;
-      if (!rv)
-        SVN_ERR(vtable->token_compare(diff_baton, parent->token, token, &rv));
+      node = &tree->nodes[slot];
+      if (node->hash != hash)
+        continue;
 
+      SVN_ERR(vtable->token_compare(diff_baton, node->token, token, &rv));
       if (rv == 0)
         {
           /* Discard the previous token.  This helps in cases where
            * only recently read tokens are still in memory.
            */
           if (vtable->token_discard != NULL)
-            vtable->token_discard(diff_baton, parent->token);
+            vtable->token_discard(diff_baton, node->token);
 
-          parent->token = token;
-          *node = parent;
+          node->token = token;
+          *index = node->index;
 
           return SVN_NO_ERROR;
         }
-      else if (rv > 0)
-        {
-          node_ref = &parent->left;
-        }
-      else
-        {
-          node_ref = &parent->right;
-        }
     }
 
-  /* Create a new node */
-  new_node = apr_palloc(tree->pool, sizeof(*new_node));
-  new_node->parent = parent;
-  new_node->left = NULL;
-  new_node->right = NULL;
-  new_node->hash = hash;
-  new_node->token = token;
-  new_node->index = tree->node_count++;
+  /* Use the empty slot */
+  node = &tree->nodes[slot];
+  node->hash = hash;
+  node->token = token;
+  node->index = tree->node_count++;
 
-  *node = *node_ref = new_node;
+  *index = node->index;
 
   return SVN_NO_ERROR;
 }
@@ -158,7 +191,7 @@ svn_diff__get_tokens(svn_diff__position_t **position_list,
   svn_diff__position_t *start_position;
   svn_diff__position_t *position = NULL;
   svn_diff__position_t **position_ref;
-  svn_diff__node_t *node;
+  svn_diff__token_index_t token_index;
   void *token;
   apr_off_t offset;
   apr_uint32_t hash;
@@ -176,12 +209,13 @@ svn_diff__get_tokens(svn_diff__position_t **position_list,
         break;
 
       offset++;
-      SVN_ERR(tree_insert_token(&node, tree, diff_baton, vtable, hash, token));
+      SVN_ERR(tree_insert_token(&token_index, tree, diff_baton, vtable,
+                                hash, token));
 
       /* Create a new position */
       position = apr_palloc(pool, sizeof(*position));
       position->next = NULL;
-      position->token_index = node->index;
+      position->token_index = token_index;
       position->offset = offset;
 
       *position_ref = position;
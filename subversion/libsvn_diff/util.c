@@ -43,6 +43,13 @@
 
 #include "svn_private_config.h"
 
+/* Use SSE2 to skip over non-whitespace 16 bytes at a time.  SSE2 is part
+ * of the x86-64 base ISA, so there is no need for a runtime check. */
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define SVN_DIFF__USE_SSE2 1
+#endif
+
 
 svn_boolean_t
 svn_diff_contains_conflicts(svn_diff_t *diff)
@@ -143,6 +150,33 @@ svn_diff_output2(svn_diff_t *diff,
 }
 
 
+/* Return a pointer to the first character in the buffer [BUF, END) that
+ * is a whitespace or control character, i.e. that is <= ' '.  Return END
+ * if there is none.  All other characters are never being normalized. */
+static APR_INLINE const char *
+skip_plain_chars(const char *buf, const char *end)
+{
+#ifdef SVN_DIFF__USE_SSE2
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i zero = _mm_setzero_si128();
+
+  for (; end - buf >= (apr_ssize_t)sizeof(__m128i); buf += sizeof(__m128i))
+    {
+      /* A byte becomes 0 iff it was <= ' ' (unsigned comparison). */
+      __m128i chunk = _mm_loadu_si128((const __m128i *)buf);
+      int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(chunk, space),
+                                                  zero));
+      if (mask)
+        return buf + __builtin_ctz(mask);
+    }
+#endif
+
+  while (buf < end && (unsigned char)*buf > ' ')
+    ++buf;
+
+  return buf;
+}
+
 void
 svn_diff__normalize_buffer(char **tgt,
                            apr_off_t *lengthp,
@@ -311,6 +345,16 @@ svn_diff__normalize_buffer(char **tgt,
                  svn_diff_file_ignore_space_none mode. */
               INCLUDE;
               state = svn_diff__normalize_state_normal;
+
+              /* Include the rest of a run of plain characters en bloc.
+                 This is what virtually all line content consists of. */
+              if ((unsigned char)*curp > ' ')
+                {
+                  const char *run_end = skip_plain_chars(curp + 1, endp);
+
+                  include_len += run_end - curp - 1;
+                  curp = run_end - 1;
+                }
             }
         }
     }
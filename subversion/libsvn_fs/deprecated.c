@@ -38,6 +38,34 @@ svn_fs_upgrade(const char *path, apr_pool_t *pool)
   return svn_error_trace(svn_fs_upgrade2(path, NULL, NULL, NULL, NULL, pool));
 }
 
+svn_error_t *
+svn_fs_pack(const char *path,
+            svn_fs_pack_notify_t notify_func,
+            void *notify_baton,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *pool)
+{
+  return svn_error_trace(svn_fs_pack2(path, 1, notify_func, notify_baton,
+                                      cancel_func, cancel_baton, pool));
+}
+
+svn_error_t *
+svn_fs_hotcopy3(const char *src_path, const char *dest_path,
+                svn_boolean_t clean, svn_boolean_t incremental,
+                svn_fs_hotcopy_notify_t notify_func,
+                void *notify_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_fs_hotcopy4(src_path, dest_path, clean,
+                                         incremental, 1,
+                                         notify_func, notify_baton,
+                                         cancel_func, cancel_baton,
+                                         scratch_pool));
+}
+
 svn_error_t *
 svn_fs_hotcopy2(const char *src_path, const char *dest_path,
                 svn_boolean_t clean, svn_boolean_t incremental,
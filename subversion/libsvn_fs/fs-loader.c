@@ -49,6 +49,7 @@
 #include "private/svn_utf_private.h"
 #include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_trace.h"
 
 #include "fs-loader.h"
 
@@ -555,11 +556,17 @@ svn_fs_open2(svn_fs_t **fs_p, const char *path, apr_hash_t *fs_config,
              apr_pool_t *scratch_pool)
 {
   fs_library_vtable_t *vtable;
+  svn_trace__span_t *span;
+  svn_error_t *err;
 
   SVN_ERR(fs_library_vtable(&vtable, path, scratch_pool));
   *fs_p = fs_new(fs_config, result_pool);
-  SVN_ERR(vtable->open_fs(*fs_p, path, common_pool_lock, scratch_pool,
-                          common_pool));
+
+  span = svn_trace__begin("fs", "open", scratch_pool);
+  err = vtable->open_fs(*fs_p, path, common_pool_lock, scratch_pool,
+                        common_pool);
+  svn_trace__end(span);
+  SVN_ERR(err);
   SVN_ERR(vtable->set_svn_fs_open(*fs_p, svn_fs_open2));
 
   return SVN_NO_ERROR;
@@ -645,8 +652,9 @@ svn_fs_delete_fs(const char *path, apr_pool_t *pool)
 }
 
 svn_error_t *
-svn_fs_hotcopy3(const char *src_path, const char *dst_path,
+svn_fs_hotcopy4(const char *src_path, const char *dst_path,
                 svn_boolean_t clean, svn_boolean_t incremental,
+                int jobs,
                 svn_fs_hotcopy_notify_t notify_func,
                 void *notify_baton,
                 svn_cancel_func_t cancel_func,
@@ -703,19 +711,20 @@ svn_fs_hotcopy3(const char *src_path, const char *dst_path,
     }
 
   SVN_ERR(vtable->hotcopy(src_fs, dst_fs, src_path, dst_path, clean,
-                          incremental, notify_func, notify_baton,
+                          incremental, jobs, notify_func, notify_baton,
                           cancel_func, cancel_baton, common_pool_lock,
                           scratch_pool, common_pool));
   return svn_error_trace(write_fs_type(dst_path, src_fs_type, scratch_pool));
 }
 
 svn_error_t *
-svn_fs_pack(const char *path,
-            svn_fs_pack_notify_t notify_func,
-            void *notify_baton,
-            svn_cancel_func_t cancel_func,
-            void *cancel_baton,
-            apr_pool_t *pool)
+svn_fs_pack2(const char *path,
+             int jobs,
+             svn_fs_pack_notify_t notify_func,
+             void *notify_baton,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *pool)
 {
   fs_library_vtable_t *vtable;
   svn_fs_t *fs;
@@ -723,7 +732,7 @@ svn_fs_pack(const char *path,
   SVN_ERR(fs_library_vtable(&vtable, path, pool));
   fs = fs_new(NULL, pool);
 
-  SVN_ERR(vtable->pack_fs(fs, path, notify_func, notify_baton,
+  SVN_ERR(vtable->pack_fs(fs, path, jobs, notify_func, notify_baton,
                           cancel_func, cancel_baton, common_pool_lock,
                           pool, common_pool));
   return SVN_NO_ERROR;
@@ -816,8 +825,8 @@ svn_error_t *
 svn_fs_hotcopy_berkeley(const char *src_path, const char *dest_path,
                         svn_boolean_t clean_logs, apr_pool_t *pool)
 {
-  return svn_error_trace(svn_fs_hotcopy3(src_path, dest_path, clean_logs,
-                                         FALSE, NULL, NULL, NULL, NULL,
+  return svn_error_trace(svn_fs_hotcopy4(src_path, dest_path, clean_logs,
+                                         FALSE, 1, NULL, NULL, NULL, NULL,
                                          pool));
 }
 
@@ -1458,8 +1467,66 @@ svn_error_t *
 svn_fs_dir_entries(apr_hash_t **entries_p, svn_fs_root_t *root,
                    const char *path, apr_pool_t *pool)
 {
-  return svn_error_trace(root->vtable->dir_entries(entries_p, root, path,
-                                                   pool));
+  svn_trace__span_t *span = svn_trace__begin("fs", "dir-entries", pool);
+  svn_error_t *err = root->vtable->dir_entries(entries_p, root, path, pool);
+
+  svn_trace__end(span);
+  return svn_error_trace(err);
+}
+
+svn_error_t *
+svn_fs_dir_entries_changed(apr_hash_t **source_entries_p,
+                           apr_hash_t **target_entries_p,
+                           svn_fs_root_t *source_root,
+                           const char *source_path,
+                           svn_fs_root_t *target_root,
+                           const char *target_path,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  apr_hash_t *source_entries;
+  apr_hash_t *target_entries;
+  apr_hash_index_t *hi;
+  svn_fs_node_relation_t relation;
+
+  /* Two directories sharing the same node revision can't differ. */
+  SVN_ERR(svn_fs_node_relation(&relation, source_root, source_path,
+                               target_root, target_path, scratch_pool));
+  if (relation == svn_fs_node_unchanged)
+    {
+      *source_entries_p = apr_hash_make(result_pool);
+      *target_entries_p = apr_hash_make(result_pool);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_fs_dir_entries(&source_entries, source_root, source_path,
+                             result_pool));
+  SVN_ERR(svn_fs_dir_entries(&target_entries, target_root, target_path,
+                             result_pool));
+
+  /* Drop all entries that did not change from both sides in one pass. */
+  for (hi = apr_hash_first(scratch_pool, target_entries);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const void *name = apr_hash_this_key(hi);
+      apr_ssize_t klen = apr_hash_this_key_len(hi);
+      svn_fs_dirent_t *target_entry = apr_hash_this_val(hi);
+      svn_fs_dirent_t *source_entry = apr_hash_get(source_entries, name,
+                                                   klen);
+
+      if (source_entry
+          && svn_fs_compare_ids(source_entry->id, target_entry->id) == 0)
+        {
+          apr_hash_set(source_entries, name, klen, NULL);
+          apr_hash_set(target_entries, name, klen, NULL);
+        }
+    }
+
+  *source_entries_p = source_entries;
+  *target_entries_p = target_entries;
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -1543,6 +1610,28 @@ svn_fs_file_contents(svn_stream_t **contents, svn_fs_root_t *root,
                                                      pool));
 }
 
+svn_error_t *
+svn_fs_file_contents_at(svn_stream_t **contents, svn_fs_root_t *root,
+                        const char *path, svn_filesize_t offset,
+                        apr_pool_t *pool)
+{
+  SVN_ERR(root->vtable->file_contents(contents, root, path, pool));
+
+  /* The backend's stream implements skipping as efficiently as it can.
+     Skip in steps that fit into an apr_size_t. */
+  while (offset > 0)
+    {
+      apr_size_t to_skip = offset > APR_SIZE_MAX / 2
+                         ? APR_SIZE_MAX / 2
+                         : (apr_size_t)offset;
+
+      SVN_ERR(svn_stream_skip(*contents, to_skip));
+      offset -= to_skip;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_try_process_file_contents(svn_boolean_t *success,
                                  svn_fs_root_t *root,
@@ -2221,6 +2310,18 @@ svn_fs_info_dup(const void *info_void,
     return apr_pmemdup(result_pool, info, sizeof(*info));
 }
 
+svn_error_t *
+svn_fs_get_io_stats(svn_fs_io_stats_t **stats,
+                    svn_fs_t *fs,
+                    apr_pool_t *result_pool)
+{
+  *stats = apr_pcalloc(result_pool, sizeof(**stats));
+  if (fs->vtable->get_io_stats)
+    SVN_ERR(fs->vtable->get_io_stats(*stats, fs));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_ioctl(svn_fs_t *fs,
              svn_fs_ioctl_code_t ctlcode,
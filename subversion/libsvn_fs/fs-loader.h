@@ -118,6 +118,7 @@ typedef struct fs_library_vtable_t
                           const char *dst_path,
                           svn_boolean_t clean,
                           svn_boolean_t incremental,
+                          int jobs,
                           svn_fs_hotcopy_notify_t notify_func,
                           void *notify_baton,
                           svn_cancel_func_t cancel_func,
@@ -129,7 +130,7 @@ typedef struct fs_library_vtable_t
   svn_error_t *(*recover)(svn_fs_t *fs,
                           svn_cancel_func_t cancel_func, void *cancel_baton,
                           apr_pool_t *pool);
-  svn_error_t *(*pack_fs)(svn_fs_t *fs, const char *path,
+  svn_error_t *(*pack_fs)(svn_fs_t *fs, const char *path, int jobs,
                           svn_fs_pack_notify_t notify_func, void *notify_baton,
                           svn_cancel_func_t cancel_func, void *cancel_baton,
                           svn_mutex__t *common_pool_lock,
@@ -279,6 +280,8 @@ typedef struct fs_vtable_t
                         void *cancel_baton,
                         apr_pool_t *result_pool,
                         apr_pool_t *scratch_pool);
+  svn_error_t *(*get_io_stats)(svn_fs_io_stats_t *stats,
+                               svn_fs_t *fs);
 } fs_vtable_t;
 
 
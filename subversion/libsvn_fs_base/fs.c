@@ -574,7 +574,8 @@ static fs_vtable_t fs_vtable = {
   base_bdb_verify_root,
   base_bdb_freeze,
   base_bdb_set_errcall,
-  NULL /* ioctl */
+  NULL, /* ioctl */
+  NULL /* get_io_stats */
 };
 
 /* Where the format number is stored. */
@@ -1025,6 +1026,7 @@ base_bdb_recover(svn_fs_t *fs,
 static svn_error_t *
 base_bdb_pack(svn_fs_t *fs,
               const char *path,
+              int jobs,
               svn_fs_pack_notify_t notify_func,
               void *notify_baton,
               svn_cancel_func_t cancel,
@@ -1302,6 +1304,7 @@ base_hotcopy(svn_fs_t *src_fs,
              const char *dest_path,
              svn_boolean_t clean_logs,
              svn_boolean_t incremental,
+             int jobs,
              svn_fs_hotcopy_notify_t notify_func,
              void *notify_baton,
              svn_cancel_func_t cancel_func,
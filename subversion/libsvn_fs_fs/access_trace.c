@@ -0,0 +1,456 @@
+/* access_trace.c : recording and replaying FSFS read accesses
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+
+#include "private/svn_subr_private.h"
+#include "private/svn_probes.h"
+
+#include "access_trace.h"
+#include "cached_data.h"
+#include "fs_fs.h"
+#include "id.h"
+
+#include "svn_private_config.h"
+
+/* Maximum number of numbers in a trace record. */
+#define MAX_RECORD_VALUES 4
+
+/* Upper limit for the size of a single trace record. */
+#define MAX_RECORD_SIZE \
+  (1 + MAX_RECORD_VALUES * SVN__MAX_ENCODED_UINT_LEN + APR_MD5_DIGESTSIZE)
+
+/* Size of the buffer used to read trace files. */
+#define READ_BUFFER_SIZE 0x10000
+
+/* A parsed trace record. */
+typedef struct trace_record_t
+{
+  /* Type of the record. */
+  svn_fs_fs__trace_kind_t kind;
+
+  /* Whether the item was found in the cache when it was recorded. */
+  svn_boolean_t cache_hit;
+
+  /* The numbers in the order given in access_trace.h. */
+  apr_uint64_t values[MAX_RECORD_VALUES];
+
+  /* MD5 digest of the representation for CONTENTS records. */
+  unsigned char md5_digest[APR_MD5_DIGESTSIZE];
+} trace_record_t;
+
+/* Return the number of numbers in a record of type KIND. */
+static int
+value_count(svn_fs_fs__trace_kind_t kind)
+{
+  switch (kind)
+    {
+      case svn_fs_fs__trace_noderev:  return 2;
+      case svn_fs_fs__trace_changes:  return 1;
+      case svn_fs_fs__trace_contents: return 4;
+      case svn_fs_fs__trace_read:     return 3;
+      default:                        return -1;
+    }
+}
+
+/* Append a record of type KIND with the given CACHE_HIT flag, the first
+ * value_count(KIND) numbers in VALUES and, for CONTENTS records, the
+ * MD5_DIGEST to the access trace of FS.  Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+write_record(svn_fs_t *fs,
+             svn_fs_fs__trace_kind_t kind,
+             svn_boolean_t cache_hit,
+             const apr_uint64_t *values,
+             const unsigned char *md5_digest,
+             apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  unsigned char buffer[MAX_RECORD_SIZE];
+  unsigned char *p = buffer;
+  int count = value_count(kind);
+  int i;
+
+  *p++ = (unsigned char)(kind | (cache_hit ? SVN_FS_FS__TRACE_CACHE_HIT
+                                           : 0));
+  for (i = 0; i < count; ++i)
+    p = svn__encode_uint(p, values[i]);
+
+  if (kind == svn_fs_fs__trace_contents)
+    {
+      memcpy(p, md5_digest, APR_MD5_DIGESTSIZE);
+      p += APR_MD5_DIGESTSIZE;
+    }
+
+  /* A single write to an unbuffered file in append mode. */
+  return svn_error_trace(svn_io_file_write_full(ffd->access_trace, buffer,
+                                                p - buffer, NULL,
+                                                scratch_pool));
+}
+
+svn_error_t *
+svn_fs_fs__access_trace_open(apr_file_t **file,
+                             const char *path,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  svn_filesize_t size;
+
+  SVN_ERR(svn_io_file_open(file, path, APR_WRITE | APR_CREATE | APR_APPEND,
+                           APR_OS_DEFAULT, result_pool));
+
+  /* Concurrent writers might both write the header.  The reader skips
+   * repeated headers. */
+  SVN_ERR(svn_io_file_size_get(&size, *file, scratch_pool));
+  if (size == 0)
+    SVN_ERR(svn_io_file_write_full(*file, SVN_FS_FS__ACCESS_TRACE_MAGIC,
+                                   sizeof(SVN_FS_FS__ACCESS_TRACE_MAGIC) - 1,
+                                   NULL, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__trace_noderev(svn_fs_t *fs,
+                         svn_revnum_t revision,
+                         apr_uint64_t item_index,
+                         svn_boolean_t cache_hit,
+                         apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_uint64_t values[2];
+
+  if (!ffd->access_trace)
+    return SVN_NO_ERROR;
+
+  values[0] = (apr_uint64_t)revision;
+  values[1] = item_index;
+
+  return svn_error_trace(write_record(fs, svn_fs_fs__trace_noderev,
+                                      cache_hit, values, NULL,
+                                      scratch_pool));
+}
+
+svn_error_t *
+svn_fs_fs__trace_changes(svn_fs_t *fs,
+                         svn_revnum_t revision,
+                         svn_boolean_t cache_hit,
+                         apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_uint64_t value = (apr_uint64_t)revision;
+
+  if (!ffd->access_trace)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(write_record(fs, svn_fs_fs__trace_changes,
+                                      cache_hit, &value, NULL,
+                                      scratch_pool));
+}
+
+svn_error_t *
+svn_fs_fs__trace_contents(svn_fs_t *fs,
+                          const representation_t *rep,
+                          svn_boolean_t cache_hit,
+                          apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_uint64_t values[4];
+
+  /* Only committed representations can be replayed. */
+  if (!ffd->access_trace || !SVN_IS_VALID_REVNUM(rep->revision))
+    return SVN_NO_ERROR;
+
+  values[0] = (apr_uint64_t)rep->revision;
+  values[1] = rep->item_index;
+  values[2] = (apr_uint64_t)rep->size;
+  values[3] = (apr_uint64_t)rep->expanded_size;
+
+  return svn_error_trace(write_record(fs, svn_fs_fs__trace_contents,
+                                      cache_hit, values, rep->md5_digest,
+                                      scratch_pool));
+}
+
+svn_error_t *
+svn_fs_fs__trace_read(svn_fs_t *fs,
+                      svn_revnum_t revision,
+                      apr_off_t offset,
+                      apr_off_t length,
+                      apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_uint64_t values[3];
+
+  SVN_PROBE3(fsfs__rev__file__read, revision, offset, length);
+  if (!ffd->access_trace || !SVN_IS_VALID_REVNUM(revision))
+    return SVN_NO_ERROR;
+
+  values[0] = (apr_uint64_t)revision;
+  values[1] = (apr_uint64_t)offset;
+  values[2] = (apr_uint64_t)length;
+
+  return svn_error_trace(write_record(fs, svn_fs_fs__trace_read, FALSE,
+                                      values, NULL, scratch_pool));
+}
+
+/* Parse the trace record in the buffer between P and END into *RECORD
+ * and return a pointer to the first byte after the record.  Return NULL
+ * if the data is not a valid record.
+ */
+static const unsigned char *
+parse_record(trace_record_t *record,
+             const unsigned char *p,
+             const unsigned char *end)
+{
+  int count;
+  int i;
+
+  if (p == end)
+    return NULL;
+
+  record->kind = *p & ~SVN_FS_FS__TRACE_CACHE_HIT;
+  record->cache_hit = (*p & SVN_FS_FS__TRACE_CACHE_HIT) != 0;
+  ++p;
+
+  count = value_count(record->kind);
+  if (count < 0)
+    return NULL;
+
+  for (i = 0; i < count && p; ++i)
+    p = svn__decode_uint(&record->values[i], p, end);
+
+  if (p && record->kind == svn_fs_fs__trace_contents)
+    {
+      if (end - p < APR_MD5_DIGESTSIZE)
+        return NULL;
+
+      memcpy(record->md5_digest, p, APR_MD5_DIGESTSIZE);
+      p += APR_MD5_DIGESTSIZE;
+    }
+
+  return p;
+}
+
+/* Request the item described by RECORD from FS and update the summary in
+ * STATS.  Skip records for revisions after YOUNGEST.  Use SCRATCH_POOL
+ * for temporaries.
+ */
+static svn_error_t *
+replay_record(svn_fs_fs__ioctl_replay_trace_output_t *stats,
+              svn_fs_t *fs,
+              svn_revnum_t youngest,
+              const trace_record_t *record,
+              apr_pool_t *scratch_pool)
+{
+  svn_revnum_t revision = (svn_revnum_t)record->values[0];
+
+  if (record->kind == svn_fs_fs__trace_read)
+    {
+      stats->reads++;
+      stats->bytes_read += record->values[2];
+      return SVN_NO_ERROR;
+    }
+
+  if (revision > youngest)
+    {
+      stats->skipped++;
+      return SVN_NO_ERROR;
+    }
+
+  switch (record->kind)
+    {
+      case svn_fs_fs__trace_noderev:
+        {
+          svn_fs_fs__id_part_t node_id = { 0 };
+          svn_fs_fs__id_part_t copy_id = { 0 };
+          svn_fs_fs__id_part_t rev_item;
+          node_revision_t *noderev;
+
+          rev_item.revision = revision;
+          rev_item.number = record->values[1];
+          SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs,
+                                               svn_fs_fs__id_rev_create(
+                                                 &node_id, &copy_id,
+                                                 &rev_item, scratch_pool),
+                                               scratch_pool, scratch_pool));
+
+          stats->noderevs++;
+          if (record->cache_hit)
+            stats->noderev_hits++;
+        }
+        break;
+
+      case svn_fs_fs__trace_changes:
+        {
+          svn_fs_fs__changes_context_t *context;
+          apr_array_header_t *changes;
+
+          SVN_ERR(svn_fs_fs__create_changes_context(&context, fs, revision,
+                                                    scratch_pool));
+          do
+            SVN_ERR(svn_fs_fs__get_changes(&changes, context, scratch_pool,
+                                           scratch_pool));
+          while (!context->eol);
+
+          stats->changes++;
+          if (record->cache_hit)
+            stats->changes_hits++;
+        }
+        break;
+
+      case svn_fs_fs__trace_contents:
+        {
+          representation_t rep;
+          svn_stream_t *contents;
+
+          memset(&rep, 0, sizeof(rep));
+          rep.revision = revision;
+          rep.item_index = record->values[1];
+          rep.size = (svn_filesize_t)record->values[2];
+          rep.expanded_size = (svn_filesize_t)record->values[3];
+          memcpy(rep.md5_digest, record->md5_digest, sizeof(rep.md5_digest));
+          svn_fs_fs__id_txn_reset(&rep.txn_id);
+
+          SVN_ERR(svn_fs_fs__get_contents(&contents, fs, &rep, TRUE,
+                                          scratch_pool));
+          SVN_ERR(svn_stream_copy3(contents, svn_stream_empty(scratch_pool),
+                                   NULL, NULL, scratch_pool));
+
+          stats->contents++;
+          if (record->cache_hit)
+            stats->contents_hits++;
+        }
+        break;
+
+      default:
+        break;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Replay the access trace at PATH against FS and update STATS.  Use
+ * SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+replay_trace_file(svn_fs_fs__ioctl_replay_trace_output_t *stats,
+                  svn_fs_t *fs,
+                  const char *path,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  unsigned char *buffer = apr_palloc(scratch_pool, READ_BUFFER_SIZE);
+  const apr_size_t magic_len = sizeof(SVN_FS_FS__ACCESS_TRACE_MAGIC) - 1;
+  apr_size_t pos = 0;
+  apr_size_t len = 0;
+  svn_boolean_t eof = FALSE;
+  svn_revnum_t youngest;
+  apr_file_t *file;
+
+  SVN_ERR(svn_io_file_open(&file, path, APR_READ | APR_BUFFERED,
+                           APR_OS_DEFAULT, scratch_pool));
+  SVN_ERR(svn_fs_fs__youngest_rev(&youngest, fs, scratch_pool));
+
+  while (TRUE)
+    {
+      trace_record_t record;
+      const unsigned char *next;
+
+      /* Make sure that the buffer contains at least one complete record
+       * unless we are at the end of the file. */
+      if (!eof && len - pos < MAX_RECORD_SIZE)
+        {
+          apr_size_t count;
+
+          memmove(buffer, buffer + pos, len - pos);
+          len -= pos;
+          pos = 0;
+
+          SVN_ERR(svn_io_file_read_full2(file, buffer + len,
+                                         READ_BUFFER_SIZE - len, &count,
+                                         &eof, scratch_pool));
+          len += count;
+        }
+
+      if (pos == len)
+        break;
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      /* Skip the file header as well as headers written by concurrent
+       * writers. */
+      if (   len - pos >= magic_len
+          && memcmp(buffer + pos, SVN_FS_FS__ACCESS_TRACE_MAGIC,
+                    magic_len) == 0)
+        {
+          pos += magic_len;
+          continue;
+        }
+
+      next = parse_record(&record, buffer + pos, buffer + len);
+      if (next == NULL)
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                 _("Corrupt access trace '%s'"),
+                                 svn_dirent_local_style(path, scratch_pool));
+
+      SVN_ERR(replay_record(stats, fs, youngest, &record, iterpool));
+      pos = next - buffer;
+    }
+
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__replay_access_trace(svn_fs_fs__ioctl_replay_trace_output_t **result,
+                               svn_fs_t *fs,
+                               const char *path,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_file_t *access_trace = ffd->access_trace;
+  svn_error_t *err;
+
+  *result = apr_pcalloc(result_pool, sizeof(**result));
+
+  /* Don't record the replay, in particular not into the trace that we
+   * are reading. */
+  ffd->access_trace = NULL;
+  err = replay_trace_file(*result, fs, path, cancel_func, cancel_baton,
+                          scratch_pool);
+  ffd->access_trace = access_trace;
+
+  return svn_error_trace(err);
+}
@@ -0,0 +1,135 @@
+/* access_trace.h : recording and replaying FSFS read accesses
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS__ACCESS_TRACE_H
+#define SVN_LIBSVN_FS__ACCESS_TRACE_H
+
+#include "fs.h"
+#include "private/svn_fs_fs_private.h"
+
+/* When the "access-trace" option in the [debug] section of fsfs.conf
+ * names a file, every FS object appends a record to it for each node
+ * revision, changed paths list and representation requested from the
+ * repository as well as for each block read from a rev or pack file.
+ *
+ * The file starts with SVN_FS_FS__ACCESS_TRACE_MAGIC followed by the
+ * records.  Each record consists of a kind byte (svn_fs_fs__trace_kind_t,
+ * plus SVN_FS_FS__TRACE_CACHE_HIT if the item was found in the cache)
+ * followed by a kind-specific sequence of numbers in svn__encode_uint
+ * format:
+ *
+ *   noderev:   REVISION ITEM_INDEX
+ *   changes:   REVISION
+ *   contents:  REVISION ITEM_INDEX SIZE EXPANDED_SIZE, followed by the
+ *              16 bytes of the MD5 digest
+ *   read:      REVISION OFFSET LENGTH   (LENGTH is 0 if not known)
+ *
+ * Records are appended with a single unbuffered write, so concurrent
+ * writers, e.g. the processes of a pre-forking server, don't garble each
+ * other's records.  Tracing costs one system call per record and is meant
+ * to capture representative access patterns for a limited time only.
+ */
+
+/* Magic string at the start of every access trace file. */
+#define SVN_FS_FS__ACCESS_TRACE_MAGIC "FSFS-TRACE-1\n"
+
+/* Flag added to the kind byte of a record if the item came from cache. */
+#define SVN_FS_FS__TRACE_CACHE_HIT 0x80
+
+/* Kinds of records in an access trace. */
+typedef enum svn_fs_fs__trace_kind_t
+{
+  svn_fs_fs__trace_noderev = 1,
+  svn_fs_fs__trace_changes = 2,
+  svn_fs_fs__trace_contents = 3,
+  svn_fs_fs__trace_read = 4
+} svn_fs_fs__trace_kind_t;
+
+/* Open the access trace file at PATH for appending, creating it if
+ * necessary, and return it in *FILE.  Allocate the file in RESULT_POOL
+ * and use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__access_trace_open(apr_file_t **file,
+                             const char *path,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool);
+
+/* If FS records an access trace, add a record for the node revision at
+ * REVISION, ITEM_INDEX.  CACHE_HIT tells whether it came from the cache.
+ * Use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__trace_noderev(svn_fs_t *fs,
+                         svn_revnum_t revision,
+                         apr_uint64_t item_index,
+                         svn_boolean_t cache_hit,
+                         apr_pool_t *scratch_pool);
+
+/* If FS records an access trace, add a record for the changed paths list
+ * of REVISION.  CACHE_HIT tells whether it came from the cache.
+ * Use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__trace_changes(svn_fs_t *fs,
+                         svn_revnum_t revision,
+                         svn_boolean_t cache_hit,
+                         apr_pool_t *scratch_pool);
+
+/* If FS records an access trace, add a record for the contents of REP.
+ * CACHE_HIT tells whether the fulltext is in the cache.
+ * Use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__trace_contents(svn_fs_t *fs,
+                          const representation_t *rep,
+                          svn_boolean_t cache_hit,
+                          apr_pool_t *scratch_pool);
+
+/* If FS records an access trace, add a record for reading LENGTH bytes
+ * at OFFSET from the rev or pack file containing REVISION.  LENGTH may
+ * be 0 if it is not known in advance.  Use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__trace_read(svn_fs_t *fs,
+                      svn_revnum_t revision,
+                      apr_off_t offset,
+                      apr_off_t length,
+                      apr_pool_t *scratch_pool);
+
+/* Request all node revisions, changed paths lists and representation
+ * contents recorded in the access trace at PATH from FS, in the order in
+ * which they were recorded, and return a summary of the trace in
+ * *RESULT, allocated in RESULT_POOL.  Records for revisions that don't
+ * exist in FS are skipped.  The replay itself is not recorded.
+ * Use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__replay_access_trace(svn_fs_fs__ioctl_replay_trace_output_t **result,
+                               svn_fs_t *fs,
+                               const char *path,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool);
+
+#endif
@@ -26,6 +26,7 @@
 
 #include "svn_hash.h"
 #include "svn_ctype.h"
+#include "svn_dirent_uri.h"
 #include "svn_sorts.h"
 #include "private/svn_delta_private.h"
 #include "private/svn_io_private.h"
@@ -33,6 +34,7 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_temp_serializer.h"
 
+#include "access_trace.h"
 #include "fs_fs.h"
 #include "id.h"
 #include "index.h"
@@ -133,6 +135,11 @@ dbg_log_access(svn_fs_t *fs,
         description = "  PLAIN";
       else if (header->type == svn_fs_fs__rep_self_delta)
         description = "  DELTA";
+      else if (header->type == svn_fs_fs__rep_shared)
+        description = apr_psprintf(scratch_pool,
+                                   "  SHARED %ld/%" APR_UINT64_T_FMT,
+                                   header->base_revision,
+                                   header->base_item_index);
       else
         description = apr_psprintf(scratch_pool,
                                    "  DELTA against %ld/%" APR_UINT64_T_FMT,
@@ -228,6 +235,8 @@ open_and_seek_revision(svn_fs_fs__revision_file_t **file,
                                  pool));
 
   SVN_ERR(aligned_seek(fs, rev_file->file, NULL, offset, pool));
+  if (!use_block_read(fs))
+    SVN_ERR(svn_fs_fs__trace_read(fs, rev, offset, 0, pool));
 
   *file = rev_file;
 
@@ -454,15 +463,16 @@ get_node_revision_body(node_revision_t **noderev_p,
       /* Not found or not applicable. Try a noderev cache lookup.
        * If that succeeds, we are done here. */
       if (ffd->node_revision_cache)
-        {
-          SVN_ERR(svn_cache__get((void **) noderev_p,
-                                 &is_cached,
-                                 ffd->node_revision_cache,
-                                 &key,
-                                 result_pool));
-          if (is_cached)
-            return SVN_NO_ERROR;
-        }
+        SVN_ERR(svn_cache__get((void **) noderev_p,
+                               &is_cached,
+                               ffd->node_revision_cache,
+                               &key,
+                               result_pool));
+
+      SVN_ERR(svn_fs_fs__trace_noderev(fs, key.revision, key.second,
+                                       is_cached, scratch_pool));
+      if (is_cached)
+        return SVN_NO_ERROR;
 
       /* read the data from disk */
       SVN_ERR(open_and_seek_revision(&revision_file, fs,
@@ -488,6 +498,7 @@ get_node_revision_body(node_revision_t **noderev_p,
                                           revision_file->stream,
                                           result_pool,
                                           scratch_pool));
+          ffd->io_stats.items_read++;
           SVN_ERR(fixup_node_revision(fs, *noderev_p, scratch_pool));
 
           /* The noderev is not in cache, yet. Add it, if caching has been enabled. */
@@ -765,6 +776,9 @@ rs_aligned_seek(rep_state_t *rs,
                 apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = rs->sfile->fs->fsap_data;
+
+  SVN_ERR(svn_fs_fs__trace_read(rs->sfile->fs, rs->revision, offset, 0,
+                                pool));
   return svn_error_trace(svn_io_file_aligned_seek(rs->sfile->rfile->file,
                                                   ffd->block_size,
                                                   buffer_start, offset,
@@ -808,9 +822,19 @@ auto_read_diff_version(rep_state_t *rs, apr_pool_t *pool)
   if (rs->ver == -1)
     {
       char buf[4];
-      SVN_ERR(rs_aligned_seek(rs, NULL, rs->start, pool));
-      SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, buf,
-                                     sizeof(buf), NULL, NULL, pool));
+      const char *mapped_data = svn_fs_fs__rev_file_mapped(rs->sfile->rfile,
+                                                           rs->start,
+                                                           sizeof(buf));
+      if (mapped_data)
+        {
+          memcpy(buf, mapped_data, sizeof(buf));
+        }
+      else
+        {
+          SVN_ERR(rs_aligned_seek(rs, NULL, rs->start, pool));
+          SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, buf,
+                                         sizeof(buf), NULL, NULL, pool));
+        }
 
       /* ### Layering violation */
       if (! ((buf[0] == 'S') && (buf[1] == 'V') && (buf[2] == 'N')))
@@ -1197,6 +1221,11 @@ struct rep_read_baton
 
   svn_boolean_t checksum_finalized;
 
+  /* Set once the caller skipped parts of the rep.  From then on, the PLAIN
+     base rep gets positioned by the delta windows' source view offsets
+     instead of being read sequentially. */
+  svn_boolean_t random_access;
+
   /* The stored checksum of the representation we are reading, its
      length, and the amount we've read so far.  Some of this
      information is redundant with rs_list and src_state, but it's
@@ -1422,12 +1451,31 @@ set_cached_combined_window(svn_stringbuf_t *window,
   return SVN_NO_ERROR;
 }
 
+/* Return the group store of FS in *GROUP_STORE.  Unlike
+   svn_fs_fs__get_group_store(), fail if FS has none because we just
+   found a reference into it.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+get_group_store(svn_fs_t **group_store,
+                svn_fs_t *fs,
+                apr_pool_t *scratch_pool)
+{
+  SVN_ERR(svn_fs_fs__get_group_store(group_store, fs, scratch_pool));
+  if (*group_store == NULL)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                             _("Filesystem '%s' refers to a group store "
+                               "but none has been configured"),
+                             svn_dirent_local_style(fs->path, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Build an array of rep_state structures in *LIST giving the delta
    reps from first_rep to a plain-text or self-compressed rep.  Set
    *SRC_STATE to the plain-text rep we find at the end of the chain,
    or to NULL if the final delta representation is self-compressed.
    The representation to start from is designated by filesystem FS, id
-   ID, and representation REP.
+   ID, and representation REP.  References into the group store are
+   followed transparently.
    Also, set *WINDOW_P to the base window content for *LIST, if it
    could be found in cache. Otherwise, *LIST will contain the base
    representation for the whole delta chain. */
@@ -1461,6 +1509,21 @@ build_rep_list(apr_array_header_t **list,
         SVN_ERR(create_rep_state(&rs, &rep_header, &shared_file,
                                  &rep, fs, pool, iterpool));
 
+      /* References into the group store continue the chain over there.
+       * Its revision and pack files are not ours to share. */
+      if (rep_header->type == svn_fs_fs__rep_shared)
+        {
+          SVN_ERR(get_group_store(&fs, fs, iterpool));
+          rep.revision = rep_header->base_revision;
+          rep.item_index = rep_header->base_item_index;
+          rep.size = rep_header->base_length;
+          svn_fs_fs__id_txn_reset(&rep.txn_id);
+
+          shared_file = NULL;
+          rs = NULL;
+          continue;
+        }
+
       /* for txn reps, there won't be a cached combined window */
       if (   !svn_fs_fs__id_txn_used(&rep.txn_id)
           && rep.expanded_size < SVN_DELTA_WINDOW_SIZE)
@@ -1525,6 +1588,7 @@ rep_read_get_baton(struct rep_read_baton **rb_p,
   b->buf = NULL;
   b->md5_checksum_ctx = svn_checksum_ctx_create(svn_checksum_md5, pool);
   b->checksum_finalized = FALSE;
+  b->random_access = FALSE;
   memcpy(b->md5_digest, rep->md5_digest, sizeof(rep->md5_digest));
   b->len = rep->expanded_size;
   b->off = 0;
@@ -1541,6 +1605,66 @@ rep_read_get_baton(struct rep_read_baton **rb_p,
   return SVN_NO_ERROR;
 }
 
+/* Implement read_delta_window() for the case that the remainder of the
+   representation RS has been mapped into memory at DATA.  Parse the
+   windows directly from there instead of reading them from file. */
+static svn_error_t *
+read_mapped_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
+                         rep_state_t *rs, const char *data,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  apr_size_t len = (apr_size_t)(rs->size - rs->current);
+  apr_size_t window_len;
+
+  /* Skip windows to reach the current chunk if we aren't there yet. */
+  while (rs->chunk_index < this_chunk)
+    {
+      SVN_ERR(svn_txdelta__parse_svndiff_window(NULL, &window_len, data, len,
+                                                rs->ver, scratch_pool));
+      data += window_len;
+      len -= window_len;
+      rs->chunk_index++;
+      rs->current += window_len;
+      if (rs->current >= rs->size)
+        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                _("Reading one svndiff window read "
+                                  "beyond the end of the "
+                                  "representation"));
+    }
+
+  /* Actually read the next window.  The parser makes sure that it does
+     not extend beyond LEN. */
+  SVN_ERR(svn_txdelta__parse_svndiff_window(nwin, &window_len, data, len,
+                                            rs->ver, result_pool));
+  rs->current += window_len;
+  count_window_read(rs, *nwin, window_len);
+
+  /* the window has not been cached before, thus cache it now
+   * (if caching is used for them at all) */
+  if (SVN_IS_VALID_REVNUM(rs->revision))
+    SVN_ERR(set_cached_window(*nwin, rs, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Account for the delta WINDOW of on-disk SIZE bytes that we just read
+   from RS in the I/O statistics of RS's filesystem. */
+static void
+count_window_read(rep_state_t *rs,
+                  const svn_txdelta_window_t *window,
+                  apr_off_t size)
+{
+  fs_fs_data_t *ffd = rs->sfile->fs->fsap_data;
+
+  ffd->io_stats.items_read++;
+  ffd->io_stats.bytes_read += size;
+
+  /* svndiff1 and later compress the window contents. */
+  if (rs->ver > 0 && window->new_data)
+    ffd->io_stats.bytes_decompressed += window->new_data->len;
+}
+
 /* Skip forwards to THIS_CHUNK in REP_STATE and then read the next delta
    window into *NWIN.  Note that RS->CHUNK_INDEX will be THIS_CHUNK rather
    than THIS_CHUNK + 1 when this function returns. */
@@ -1553,6 +1677,7 @@ read_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
   apr_off_t start_offset;
   apr_off_t end_offset;
   apr_pool_t *iterpool;
+  const char *mapped_data;
 
   SVN_ERR_ASSERT(rs->chunk_index <= this_chunk);
 
@@ -1592,6 +1717,16 @@ read_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
   SVN_ERR(auto_set_start_offset(rs, scratch_pool));
   SVN_ERR(auto_read_diff_version(rs, scratch_pool));
 
+  /* Pack files may have been mapped into memory. */
+  mapped_data = svn_fs_fs__rev_file_mapped(rs->sfile->rfile,
+                                           rs->start + rs->current,
+                                           rs->size - rs->current);
+  if (mapped_data)
+    return svn_error_trace(read_mapped_delta_window(nwin, this_chunk, rs,
+                                                    mapped_data,
+                                                    result_pool,
+                                                    scratch_pool));
+
   /* RS->FILE may be shared between RS instances -> make sure we point
    * to the right data. */
   start_offset = rs->start + rs->current;
@@ -1624,6 +1759,7 @@ read_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
     return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
                             _("Reading one svndiff window read beyond "
                               "the end of the representation"));
+  count_window_read(rs, *nwin, end_offset - start_offset);
 
   /* the window has not been cached before, thus cache it now
    * (if caching is used for them at all) */
@@ -1639,7 +1775,9 @@ read_plain_window(svn_stringbuf_t **nwin, rep_state_t *rs,
                   apr_size_t size, apr_pool_t *result_pool,
                   apr_pool_t *scratch_pool)
 {
+  fs_fs_data_t *ffd = rs->sfile->fs->fsap_data;
   apr_off_t offset;
+  const char *mapped_data;
 
   /* RS->FILE may be shared between RS instances -> make sure we point
    * to the right data. */
@@ -1647,17 +1785,29 @@ read_plain_window(svn_stringbuf_t **nwin, rep_state_t *rs,
   SVN_ERR(auto_set_start_offset(rs, scratch_pool));
 
   offset = rs->start + rs->current;
-  SVN_ERR(rs_aligned_seek(rs, NULL, offset, scratch_pool));
+  mapped_data = svn_fs_fs__rev_file_mapped(rs->sfile->rfile, offset, size);
+  if (mapped_data)
+    {
+      /* Pack files may have been mapped into memory. */
+      *nwin = svn_stringbuf_ncreate(mapped_data, size, result_pool);
+    }
+  else
+    {
+      SVN_ERR(rs_aligned_seek(rs, NULL, offset, scratch_pool));
 
-  /* Read the plain data. */
-  *nwin = svn_stringbuf_create_ensure(size, result_pool);
-  SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, (*nwin)->data, size,
-                                 NULL, NULL, result_pool));
-  (*nwin)->data[size] = 0;
+      /* Read the plain data. */
+      *nwin = svn_stringbuf_create_ensure(size, result_pool);
+      SVN_ERR(svn_io_file_read_full2(rs->sfile->rfile->file, (*nwin)->data,
+                                     size, NULL, NULL, result_pool));
+      (*nwin)->data[size] = 0;
+    }
 
   /* Update RS. */
   rs->current += (apr_off_t)size;
 
+  ffd->io_stats.items_read++;
+  ffd->io_stats.bytes_read += size;
+
   return SVN_NO_ERROR;
 }
 
@@ -1672,6 +1822,104 @@ skip_plain_window(rep_state_t *rs,
   return SVN_NO_ERROR;
 }
 
+/* Read the composed delta window for the current chunk of the rep
+ * described by RB from the current FSFS session's cache and return it in
+ * *WINDOW_P.  IS_CACHED will inform the caller about the success of the
+ * lookup.  On success, the state of the first delta rep in RB will be
+ * updated as if the window had just been read.  Allocations (of the
+ * window in particular) will be made from RESULT_POOL.
+ */
+static svn_error_t *
+get_cached_composed_window(svn_txdelta_window_t **window_p,
+                           svn_boolean_t *is_cached,
+                           struct rep_read_baton *rb,
+                           apr_pool_t *result_pool)
+{
+  rep_state_t *rs = APR_ARRAY_IDX(rb->rs_list, 0, rep_state_t *);
+  fs_fs_data_t *ffd = rs->sfile->fs->fsap_data;
+  svn_fs_fs__txdelta_cached_window_t *cached_window;
+  window_cache_key_t key = { 0 };
+
+  /* We only cache composed windows that don't need a PLAIN base rep. */
+  *is_cached = FALSE;
+  if (   !ffd->composed_window_cache
+      || rb->src_state != NULL
+      || !SVN_IS_VALID_REVNUM(rs->revision))
+    return SVN_NO_ERROR;
+
+  get_window_key(&key, rs);
+  key.chunk_index = rb->chunk_index;
+  SVN_ERR(svn_cache__get((void **)&cached_window, is_cached,
+                         ffd->composed_window_cache, &key, result_pool));
+
+  if (*is_cached)
+    {
+      /* The other reps in the chain don't need to be touched.  They will
+       * skip the windows they missed should we ever need them again. */
+      *window_p = cached_window->window;
+      rs->current = cached_window->end_offset;
+      rs->chunk_index = rb->chunk_index + 1;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Store the composed delta WINDOW for the current chunk of the rep
+ * described by RB in the current FSFS session's cache.  This will be a
+ * no-op if no cache has been given or if WINDOW can't be applied without
+ * further source data.  Temporary allocations will be made from
+ * SCRATCH_POOL.
+ */
+static svn_error_t *
+set_cached_composed_window(svn_txdelta_window_t *window,
+                           struct rep_read_baton *rb,
+                           apr_pool_t *scratch_pool)
+{
+  rep_state_t *rs = APR_ARRAY_IDX(rb->rs_list, 0, rep_state_t *);
+  fs_fs_data_t *ffd = rs->sfile->fs->fsap_data;
+  svn_fs_fs__txdelta_cached_window_t cached_window;
+  window_cache_key_t key = { 0 };
+
+  if (   !ffd->composed_window_cache
+      || rb->src_state != NULL
+      || window->src_ops != 0
+      || !SVN_IS_VALID_REVNUM(rs->revision))
+    return SVN_NO_ERROR;
+
+  /* RS->CHUNK_INDEX has already been moved to the next chunk. */
+  get_window_key(&key, rs);
+  key.chunk_index = rb->chunk_index;
+
+  cached_window.window = window;
+  cached_window.end_offset = rs->current;
+
+  return svn_error_trace(svn_cache__set(ffd->composed_window_cache, &key,
+                                        &cached_window, scratch_pool));
+}
+
+/* Apply the delta WINDOW to SOURCE and return the result in *RESULT,
+   allocated in RESULT_POOL. */
+static svn_error_t *
+apply_window(svn_stringbuf_t **result,
+             svn_txdelta_window_t *window,
+             svn_stringbuf_t *source,
+             apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *buf = svn_stringbuf_create_ensure(window->tview_len,
+                                                     result_pool);
+  buf->len = window->tview_len;
+
+  svn_txdelta_apply_instructions(window, source ? source->data : NULL,
+                                 buf->data, &buf->len);
+  if (buf->len != window->tview_len)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("svndiff window length is "
+                              "corrupt"));
+
+  *result = buf;
+  return SVN_NO_ERROR;
+}
+
 /* Get the undeltified window that is a result of combining all deltas
    from the current desired representation identified in *RB with its
    base representation.  Store the window in *RESULT. */
@@ -1680,12 +1928,20 @@ get_combined_window(svn_stringbuf_t **result,
                     struct rep_read_baton *rb)
 {
   apr_pool_t *pool, *new_pool, *window_pool;
-  int i;
+  int i, k;
   apr_array_header_t *windows;
   svn_stringbuf_t *source, *buf = rb->base_window;
+  svn_txdelta_window_t *composite;
+  svn_boolean_t is_cached, compose;
   rep_state_t *rs;
   apr_pool_t *iterpool;
 
+  /* Short-cut the whole delta chain if we composed its windows for this
+     chunk before. */
+  SVN_ERR(get_cached_composed_window(&composite, &is_cached, rb, rb->pool));
+  if (is_cached)
+    return svn_error_trace(apply_window(result, composite, NULL, rb->pool));
+
   /* Read all windows that we need to combine. This is fine because
      the size of each window is relatively small (100kB) and skip-
      delta limits the number of deltas in a chain to well under 100.
@@ -1711,6 +1967,58 @@ get_combined_window(svn_stringbuf_t **result,
         }
     }
 
+  /* Applying every window of the chain in turn costs O(window size) per
+     level while composing them only depends on the number of instructions.
+     So, compose the windows unless we get to cache the intermediate
+     fulltexts, i.e. unless some of the reps consist of this chunk only. */
+  compose = i > 1;
+  if (compose && rb->chunk_index == 0)
+    for (k = 0; k < i; ++k)
+      {
+        rs = APR_ARRAY_IDX(rb->rs_list, k, rep_state_t *);
+        if (   rs->combined_cache && (rs->current == rs->size)
+            && SVN_IS_VALID_REVNUM(rs->revision))
+          compose = FALSE;
+      }
+
+  if (compose)
+    {
+      composite = APR_ARRAY_IDX(windows, i - 1, svn_txdelta_window_t *);
+      for (k = i - 2; k >= 0; --k)
+        composite = svn_txdelta_compose_windows(composite,
+                          APR_ARRAY_IDX(windows, k, svn_txdelta_window_t *),
+                          window_pool);
+
+      /* Same as for the first combination step below. */
+      pool = svn_pool_create(rb->pool);
+      source = buf;
+      if (source == NULL && rb->src_state != NULL)
+        {
+          if (rb->random_access)
+            rb->src_state->current = composite->sview_offset;
+
+          if (composite->src_ops)
+            SVN_ERR(read_plain_window(&source, rb->src_state,
+                                      composite->sview_len,
+                                      pool, iterpool));
+          else
+            SVN_ERR(skip_plain_window(rb->src_state, composite->sview_len));
+        }
+
+      SVN_ERR(apply_window(&buf, composite, source, rb->pool));
+      for (k = 0; k < i; ++k)
+        APR_ARRAY_IDX(rb->rs_list, k, rep_state_t *)->chunk_index++;
+
+      SVN_ERR(set_cached_composed_window(composite, rb, iterpool));
+
+      svn_pool_destroy(pool);
+      svn_pool_destroy(iterpool);
+      svn_pool_destroy(window_pool);
+
+      *result = buf;
+      return SVN_NO_ERROR;
+    }
+
   /* Combine in the windows from the other delta reps. */
   pool = svn_pool_create(rb->pool);
   for (--i; i >= 0; --i)
@@ -1733,7 +2041,11 @@ get_combined_window(svn_stringbuf_t **result,
         {
           /* Even if we don't need the source rep now, we still must keep
            * its read offset in sync with what we might need for the next
-           * window. */
+           * window.  After skipping chunks, the offset has to be taken
+           * from the window itself. */
+          if (rb->random_access)
+            rb->src_state->current = window->sview_offset;
+
           if (window->src_ops)
             SVN_ERR(read_plain_window(&source, rb->src_state,
                                       window->sview_len,
@@ -1744,15 +2056,7 @@ get_combined_window(svn_stringbuf_t **result,
 
       /* Combine this window with the current one. */
       new_pool = svn_pool_create(rb->pool);
-      buf = svn_stringbuf_create_ensure(window->tview_len, new_pool);
-      buf->len = window->tview_len;
-
-      svn_txdelta_apply_instructions(window, source ? source->data : NULL,
-                                     buf->data, &buf->len);
-      if (buf->len != window->tview_len)
-        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
-                                _("svndiff window length is "
-                                  "corrupt"));
+      SVN_ERR(apply_window(&buf, window, source, new_pool));
 
       /* Cache windows only if the whole rep content could be read as a
          single chunk.  Only then will no other chunk need a deeper RS
@@ -2101,6 +2405,95 @@ skip_contents(struct rep_read_baton *baton,
   return svn_error_trace(err);
 }
 
+/* Move the window stream in BATON forward to the absolute position
+ * TARGET without reconstructing the data in between.  Chunks before the
+ * one covering TARGET only get their top-level delta window read to find
+ * their size; the rest of the delta chain will skip them on demand.
+ * BATON->RANDOM_ACCESS must be set.
+ */
+static svn_error_t *
+seek_contents(struct rep_read_baton *baton,
+              svn_filesize_t target)
+{
+  svn_filesize_t pos = baton->off;
+  rep_state_t *rs;
+  apr_pool_t *iterpool;
+
+  SVN_ERR_ASSERT(baton->random_access);
+  if (target > baton->len)
+    target = baton->len;
+  if (target <= pos)
+    return SVN_NO_ERROR;
+
+  /* Without deltas, we can simply move the read offset. */
+  if (baton->rs_list->nelts == 0)
+    {
+      baton->src_state->current += target - pos;
+      baton->off = target;
+      return SVN_NO_ERROR;
+    }
+
+  /* Use or drop the rest of the current chunk. */
+  if (baton->buf)
+    {
+      apr_size_t available = baton->buf_len - baton->buf_pos;
+      if (target - pos < available)
+        {
+          baton->buf_pos += (apr_size_t)(target - pos);
+          baton->off = target;
+          return SVN_NO_ERROR;
+        }
+
+      pos += available;
+      svn_pool_clear(baton->pool);
+      baton->buf = NULL;
+    }
+
+  /* Skip whole chunks.  Restore the state of the top-level rep for the
+   * chunk that covers TARGET, so get_combined_window() will read it. */
+  rs = APR_ARRAY_IDX(baton->rs_list, 0, rep_state_t *);
+  iterpool = svn_pool_create(baton->pool);
+  while (pos < target && rs->current < rs->size)
+    {
+      svn_txdelta_window_t *window;
+      apr_off_t current = rs->current;
+      int chunk_index = rs->chunk_index;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(read_delta_window(&window, baton->chunk_index, rs,
+                                iterpool, iterpool));
+      if (pos + window->tview_len > target)
+        {
+          rs->current = current;
+          rs->chunk_index = chunk_index;
+          break;
+        }
+
+      pos += window->tview_len;
+      rs->chunk_index++;
+      baton->chunk_index++;
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Reconstruct the covering chunk and position ourselves within it. */
+  if (pos < target && rs->current < rs->size)
+    {
+      svn_stringbuf_t *sbuf;
+
+      SVN_ERR(get_combined_window(&sbuf, baton));
+
+      baton->chunk_index++;
+      baton->buf_len = sbuf->len;
+      baton->buf = sbuf->data;
+      baton->buf_pos = (apr_size_t)(target - pos);
+      pos = target;
+    }
+
+  baton->off = pos;
+
+  return SVN_NO_ERROR;
+}
+
 /* BATON is of type `rep_read_baton'; read the next *LEN bytes of the
    representation and store them in *BUF.  Sum as we read and verify
    the MD5 sum at the end.  This is a READ_FULL_FN for svn_stream_t. */
@@ -2137,7 +2530,10 @@ rep_read_contents(void *baton,
       /* In case we did read from the fulltext cache before, make the
        * window stream catch up.  Also, initialize the fulltext buffer
        * if we want to cache the fulltext at the end. */
-      SVN_ERR(skip_contents(rb, rb->fulltext_delivered));
+      if (rb->random_access)
+        SVN_ERR(seek_contents(rb, rb->fulltext_delivered));
+      else
+        SVN_ERR(skip_contents(rb, rb->fulltext_delivered));
     }
 
   /* Get the next block of data.
@@ -2210,6 +2606,41 @@ rep_read_contents(void *baton,
   return SVN_NO_ERROR;
 }
 
+/* BATON is of type `rep_read_baton'; skip the next LEN bytes of the
+   representation without reconstructing them.  Since we won't see all
+   of the data, disable checksum verification and fulltext caching.
+   This is a SKIP_FN for svn_stream_t. */
+static svn_error_t *
+rep_read_skip(void *baton,
+              apr_size_t len)
+{
+  struct rep_read_baton *rb = baton;
+
+  rb->random_access = TRUE;
+  rb->checksum_finalized = TRUE;
+  rb->fulltext_cache_key.revision = SVN_INVALID_REVNUM;
+  rb->current_fulltext = NULL;
+
+  /* While we are served from the fulltext cache, simply move on in
+   * there.  rep_read_contents() will seek to that position if the cache
+   * lookup fails later. */
+  if (rb->fulltext_cache)
+    {
+      rb->fulltext_delivered = MIN(rb->fulltext_delivered + len, rb->len);
+      return SVN_NO_ERROR;
+    }
+
+  if (!rb->rs_list)
+    {
+      rb->len = rb->rep.expanded_size;
+      SVN_ERR(build_rep_list(&rb->rs_list, &rb->base_window,
+                             &rb->src_state, rb->fs, &rb->rep,
+                             rb->filehandle_pool));
+    }
+
+  return svn_error_trace(seek_contents(rb, rb->off + len));
+}
+
 svn_error_t *
 svn_fs_fs__get_contents(svn_stream_t **contents_p,
                         svn_fs_t *fs,
@@ -2250,9 +2681,20 @@ svn_fs_fs__get_contents(svn_stream_t **contents_p,
           rb->fulltext_cache_key.revision = SVN_INVALID_REVNUM;
         }
 
+      if (ffd->access_trace)
+        {
+          svn_boolean_t is_cached = FALSE;
+
+          if (rb->fulltext_cache)
+            SVN_ERR(svn_cache__has_key(&is_cached, rb->fulltext_cache,
+                                       &fulltext_cache_key, pool));
+          SVN_ERR(svn_fs_fs__trace_contents(fs, rep, is_cached, pool));
+        }
+
       *contents_p = svn_stream_create(rb, pool);
       svn_stream_set_read2(*contents_p, NULL /* only full read support */,
                            rep_read_contents);
+      svn_stream_set_skip(*contents_p, rep_read_skip);
       svn_stream_set_close(*contents_p, rep_read_contents_close);
     }
 
@@ -2318,6 +2760,22 @@ svn_fs_fs__get_contents_from_file(svn_stream_t **contents_p,
       APR_ARRAY_PUSH(rb->rs_list, rep_state_t *) = rs;
       rb->src_state = NULL;
     }
+  else if (rh->type == svn_fs_fs__rep_shared)
+    {
+      representation_t group_rep = { 0 };
+      svn_fs_t *group_store;
+
+      /* The contents themselves live in the group store. */
+      SVN_ERR(get_group_store(&group_store, fs, pool));
+      group_rep.revision = rh->base_revision;
+      group_rep.item_index = rh->base_item_index;
+      group_rep.size = rh->base_length;
+      svn_fs_fs__id_txn_reset(&group_rep.txn_id);
+
+      SVN_ERR(build_rep_list(&rb->rs_list, &rb->base_window,
+                             &rb->src_state, group_store, &group_rep,
+                             rb->filehandle_pool));
+    }
   else
     {
       representation_t next_rep = { 0 };
@@ -2349,6 +2807,181 @@ svn_fs_fs__get_contents_from_file(svn_stream_t **contents_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__get_contents_location(apr_file_t **file_p,
+                                 apr_off_t *offset,
+                                 svn_filesize_t *length,
+                                 svn_fs_t *fs,
+                                 representation_t *rep,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__revision_file_t *rev_file;
+  svn_fs_fs__rep_header_t *header;
+  apr_off_t rep_offset;
+
+  *file_p = NULL;
+
+  /* Empty files have no rep and txn data may still change. */
+  if (rep == NULL || svn_fs_fs__id_txn_used(&rep->txn_id))
+    return SVN_NO_ERROR;
+
+  /* Keep the file open in RESULT_POOL.  Even if the revision gets packed
+   * in the meantime, the data in that file will remain valid. */
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(rep->revision, fs, scratch_pool));
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rep->revision,
+                                           result_pool, scratch_pool));
+  SVN_ERR(svn_fs_fs__item_offset(&rep_offset, fs, rev_file, rep->revision,
+                                 NULL, rep->item_index, scratch_pool));
+  SVN_ERR(aligned_seek(fs, rev_file->file, NULL, rep_offset, scratch_pool));
+  SVN_ERR(svn_fs_fs__read_rep_header(&header, rev_file->stream,
+                                     scratch_pool, scratch_pool));
+  if (header->type != svn_fs_fs__rep_plain)
+    return svn_error_trace(svn_fs_fs__close_revision_file(rev_file));
+
+  *file_p = rev_file->file;
+  *offset = rep_offset + header->header_size;
+  *length = rep->size;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *DEFLATED to the raw deflate stream within the zlib-compressed,
+   svndiff1 window section DATA of LEN bytes that expands to EXPANDED_SIZE
+   bytes.  Set it to NULL if that section is stored uncompressed.
+   Allocate the result in RESULT_POOL. */
+static void
+get_deflate_stream(svn_string_t **deflated,
+                   const unsigned char *data,
+                   apr_size_t len,
+                   apr_uint64_t expanded_size,
+                   apr_pool_t *result_pool)
+{
+  const unsigned char *end = data + len;
+  apr_uint64_t size;
+
+  *deflated = NULL;
+
+  /* The section starts with the expanded size.  If the remainder has
+     that size as well, compression did not pay off. */
+  data = svn__decode_uint(&size, data, end);
+  if (   data == NULL || size != expanded_size
+      || (apr_uint64_t)(end - data) == size)
+    return;
+
+  /* Strip the zlib header and its Adler-32 trailer.  We only support
+     the header that compress2() writes, i.e. deflate without a preset
+     dictionary. */
+  if (end - data < 6 || (data[0] & 0x0f) != 8 || (data[1] & 0x20))
+    return;
+
+  *deflated = svn_string_ncreate((const char *)data + 2, end - data - 6,
+                                 result_pool);
+}
+
+svn_error_t *
+svn_fs_fs__get_deflated_contents(svn_string_t **deflated,
+                                 svn_fs_t *fs,
+                                 representation_t *rep,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__revision_file_t *rev_file;
+  svn_fs_fs__rep_header_t *header;
+  apr_off_t rep_offset;
+  svn_stringbuf_t *data;
+  svn_stringbuf_t *instructions;
+  const unsigned char *p, *end;
+  apr_uint64_t sview_offset, sview_len, tview_len, ins_len, new_len;
+  apr_uint64_t op_len;
+  apr_size_t len;
+
+  *deflated = NULL;
+
+  /* Only committed texts that fit into a single window may qualify. */
+  if (   rep == NULL
+      || svn_fs_fs__id_txn_used(&rep->txn_id)
+      || rep->expanded_size == 0
+      || rep->expanded_size > SVN_DELTA_WINDOW_SIZE
+      || rep->size > SVN_DELTA_WINDOW_SIZE)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(rep->revision, fs, scratch_pool));
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rep->revision,
+                                           scratch_pool, scratch_pool));
+  SVN_ERR(svn_fs_fs__item_offset(&rep_offset, fs, rev_file, rep->revision,
+                                 NULL, rep->item_index, scratch_pool));
+  SVN_ERR(aligned_seek(fs, rev_file->file, NULL, rep_offset, scratch_pool));
+  SVN_ERR(svn_fs_fs__read_rep_header(&header, rev_file->stream,
+                                     scratch_pool, scratch_pool));
+  if (header->type != svn_fs_fs__rep_self_delta)
+    return svn_error_trace(svn_fs_fs__close_revision_file(rev_file));
+
+  /* Read the whole svndiff data, i.e. the single window. */
+  len = (apr_size_t)rep->size;
+  data = svn_stringbuf_create_ensure(len, scratch_pool);
+  SVN_ERR(aligned_seek(fs, rev_file->file, NULL,
+                       rep_offset + header->header_size, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(rev_file->file, data->data, len, NULL,
+                                 NULL, scratch_pool));
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  /* Only svndiff1 uses zlib. */
+  p = (const unsigned char *)data->data;
+  end = p + len;
+  if (len < 4 || memcmp(p, "SVN\1", 4) != 0)
+    return SVN_NO_ERROR;
+
+  /* The window must produce the fulltext from its new data alone. */
+  p += 4;
+  p = svn__decode_uint(&sview_offset, p, end);
+  if (p)
+    p = svn__decode_uint(&sview_len, p, end);
+  if (p)
+    p = svn__decode_uint(&tview_len, p, end);
+  if (p)
+    p = svn__decode_uint(&ins_len, p, end);
+  if (p)
+    p = svn__decode_uint(&new_len, p, end);
+  if (   p == NULL
+      || sview_len != 0
+      || tview_len != rep->expanded_size
+      || ins_len > (apr_uint64_t)(end - p)
+      || new_len != (apr_uint64_t)(end - p) - ins_len)
+    return SVN_NO_ERROR;
+
+  /* That requires a single "new data" instruction covering it all. */
+  instructions = svn_stringbuf_create_empty(scratch_pool);
+  SVN_ERR(svn__decompress_zlib(p, (apr_size_t)ins_len, instructions,
+                               SVN_DELTA_WINDOW_SIZE));
+  if (   instructions->len == 0
+      || ((unsigned char)instructions->data[0] >> 6) != svn_txdelta_new)
+    return SVN_NO_ERROR;
+
+  op_len = (unsigned char)instructions->data[0] & 0x3f;
+  if (op_len == 0)
+    {
+      const unsigned char *ip = (const unsigned char *)instructions->data;
+      const unsigned char *iend = ip + instructions->len;
+
+      ip = svn__decode_uint(&op_len, ip + 1, iend);
+      if (ip != iend)
+        return SVN_NO_ERROR;
+    }
+  else if (instructions->len != 1)
+    {
+      return SVN_NO_ERROR;
+    }
+
+  if (op_len != tview_len)
+    return SVN_NO_ERROR;
+
+  get_deflate_stream(deflated, p + ins_len, (apr_size_t)new_len, tview_len,
+                     result_pool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Baton for cache_access_wrapper. Wraps the original parameters of
  * svn_fs_fs__try_process_file_content().
  */
@@ -2472,6 +3105,153 @@ get_storaged_delta_stream(rep_state_t *rep_state,
                                    delta_read_md5_digest, pool);
 }
 
+/* Maximum number of stored deltas that we are willing to compose into
+   a single delta instead of computing a new one from the fulltexts. */
+#define MAX_COMPOSED_CHAIN 4
+
+/* Baton used when composing the stored delta windows of a short chain. */
+struct compose_read_baton
+{
+  /* rep_state_t * for the delta reps, starting with the target and
+     ending with the one stored against the delta source. */
+  apr_array_header_t *rs_list;
+
+  /* Index of the next window to read from each rep. */
+  int chunk_index;
+
+  /* End of the source view of the windows returned so far. */
+  svn_filesize_t sview_end;
+
+  unsigned char md5_digest[APR_MD5_DIGESTSIZE];
+};
+
+/* This implements the svn_txdelta_next_window_fn_t interface. */
+static svn_error_t *
+compose_read_next_window(svn_txdelta_window_t **window, void *baton,
+                         apr_pool_t *pool)
+{
+  struct compose_read_baton *crb = baton;
+  rep_state_t *rs = APR_ARRAY_IDX(crb->rs_list, 0, rep_state_t *);
+  svn_txdelta_window_t *composite = NULL;
+  apr_pool_t *scratch_pool;
+  int i;
+
+  *window = NULL;
+  if (rs->current >= rs->size)
+    return SVN_NO_ERROR;
+
+  /* Windows of the same chunk line up across the whole delta chain.
+     Stop at the first window that does not depend on its base. */
+  scratch_pool = svn_pool_create(pool);
+  for (i = 0; i < crb->rs_list->nelts; ++i)
+    {
+      svn_txdelta_window_t *nwin;
+
+      rs = APR_ARRAY_IDX(crb->rs_list, i, rep_state_t *);
+      SVN_ERR(read_delta_window(&nwin, crb->chunk_index, rs, scratch_pool,
+                                scratch_pool));
+      rs->chunk_index++;
+
+      composite = composite
+                ? svn_txdelta_compose_windows(nwin, composite, scratch_pool)
+                : nwin;
+      if (nwin->src_ops == 0)
+        break;
+    }
+
+  *window = svn_txdelta_window_dup(composite, pool);
+  crb->chunk_index++;
+
+  /* If we stopped early, the source view refers to some intermediate
+     fulltext.  It is not used, so make it an empty view that does not
+     move backwards within the delta source. */
+  if (i + 1 < crb->rs_list->nelts)
+    {
+      (*window)->sview_offset = crb->sview_end;
+      (*window)->sview_len = 0;
+    }
+  else
+    crb->sview_end = (*window)->sview_offset + (*window)->sview_len;
+
+  svn_pool_destroy(scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* This implements the svn_txdelta_md5_digest_fn_t interface. */
+static const unsigned char *
+compose_read_md5_digest(void *baton)
+{
+  struct compose_read_baton *crb = baton;
+  return crb->md5_digest;
+}
+
+/* If the delta rep REP_STATE of TARGET in FS with header REP_HEADER
+   reaches the data rep of SOURCE within MAX_COMPOSED_CHAIN deltas, set
+   *STREAM_P to a txdelta stream that composes the stored windows of
+   that chain.  Otherwise, set *STREAM_P to NULL.  Allocate the result
+   in POOL. */
+static svn_error_t *
+get_composed_delta_stream(svn_txdelta_stream_t **stream_p,
+                          rep_state_t *rep_state,
+                          svn_fs_fs__rep_header_t *rep_header,
+                          svn_fs_t *fs,
+                          node_revision_t *source,
+                          node_revision_t *target,
+                          apr_pool_t *pool)
+{
+  struct compose_read_baton *crb;
+  apr_array_header_t *rs_list;
+  shared_file_t *shared_file = rep_state->sfile;
+  representation_t rep = *target->data_rep;
+  rep_state_t *rs;
+  int i;
+
+  *stream_p = NULL;
+  rs_list = apr_array_make(pool, MAX_COMPOSED_CHAIN, sizeof(rep_state_t *));
+  APR_ARRAY_PUSH(rs_list, rep_state_t *) = rep_state;
+
+  while (rs_list->nelts < MAX_COMPOSED_CHAIN)
+    {
+      rep.revision = rep_header->base_revision;
+      rep.item_index = rep_header->base_item_index;
+      rep.size = rep_header->base_length;
+      svn_fs_fs__id_txn_reset(&rep.txn_id);
+
+      SVN_ERR(create_rep_state(&rs, &rep_header, &shared_file, &rep, fs,
+                               pool, pool));
+      APR_ARRAY_PUSH(rs_list, rep_state_t *) = rs;
+      if (rep_header->type != svn_fs_fs__rep_delta)
+        break;
+
+      if (   rep_header->base_revision == source->data_rep->revision
+          && rep_header->base_item_index == source->data_rep->item_index)
+        {
+          crb = apr_pcalloc(pool, sizeof(*crb));
+          crb->rs_list = rs_list;
+          memcpy(crb->md5_digest, target->data_rep->md5_digest,
+                 sizeof(crb->md5_digest));
+          *stream_p = svn_txdelta_stream_create(crb, compose_read_next_window,
+                                                compose_read_md5_digest,
+                                                pool);
+          return SVN_NO_ERROR;
+        }
+    }
+
+  /* Don't keep file handles open for longer than necessary. */
+  for (i = 1; i < rs_list->nelts; ++i)
+    {
+      rs = APR_ARRAY_IDX(rs_list, i, rep_state_t *);
+      if (rs->sfile->rfile && rs->sfile != rep_state->sfile)
+        {
+          SVN_ERR(svn_fs_fs__close_revision_file(rs->sfile->rfile));
+          rs->sfile->rfile = NULL;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__get_file_delta_stream(svn_txdelta_stream_t **stream_p,
                                  svn_fs_t *fs,
@@ -2505,6 +3285,19 @@ svn_fs_fs__get_file_delta_stream(svn_txdelta_stream_t **stream_p,
               *stream_p = get_storaged_delta_stream(rep_state, target, pool);
               return SVN_NO_ERROR;
             }
+
+          /* Skip-deltas often put the source only a few steps down the
+             delta chain.  Composing those windows is still much cheaper
+             than reconstructing both fulltexts. */
+          if (   rep_header->type == svn_fs_fs__rep_delta
+              && SVN_IS_VALID_REVNUM(source->data_rep->revision))
+            {
+              SVN_ERR(get_composed_delta_stream(stream_p, rep_state,
+                                                rep_header, fs, source,
+                                                target, pool));
+              if (*stream_p)
+                return SVN_NO_ERROR;
+            }
         }
       else if (!source)
         {
@@ -2538,7 +3331,7 @@ svn_fs_fs__get_file_delta_stream(svn_txdelta_stream_t **stream_p,
   /* Because source and target stream will already verify their content,
    * there is no need to do this once more.  In particular if the stream
    * content is being fetched from cache. */
-  svn_txdelta2(stream_p, source_stream, target_stream, FALSE, pool);
+  svn_txdelta3(stream_p, source_stream, target_stream, FALSE, FALSE, pool);
 
   return SVN_NO_ERROR;
 }
@@ -2578,6 +3371,55 @@ compare_dirent_name(const void *a, const void *b)
   return strcmp(lhs->name, rhs);
 }
 
+/* Convert the hash dump ENTRY of the directory with the given ID into
+ * *DIRENT, allocated in RESULT_POOL.  ENTRY's value will be modified.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+parse_dir_entry(svn_fs_dirent_t **dirent,
+                svn_hash__entry_t *entry,
+                const svn_fs_id_t *id,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  svn_fs_dirent_t *result = apr_pcalloc(result_pool, sizeof(*result));
+  char *str;
+
+  result->name = apr_pstrmemdup(result_pool, entry->key, entry->keylen);
+
+  str = svn_cstring_tokenize(" ", &entry->val);
+  if (str == NULL)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                       _("Directory entry corrupt in '%s'"),
+                       svn_fs_fs__id_unparse(id, scratch_pool)->data);
+
+  if (strcmp(str, SVN_FS_FS__KIND_FILE) == 0)
+    {
+      result->kind = svn_node_file;
+    }
+  else if (strcmp(str, SVN_FS_FS__KIND_DIR) == 0)
+    {
+      result->kind = svn_node_dir;
+    }
+  else
+    {
+      return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                       _("Directory entry corrupt in '%s'"),
+                       svn_fs_fs__id_unparse(id, scratch_pool)->data);
+    }
+
+  str = svn_cstring_tokenize(" ", &entry->val);
+  if (str == NULL)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                       _("Directory entry corrupt in '%s'"),
+                       svn_fs_fs__id_unparse(id, scratch_pool)->data);
+
+  SVN_ERR(svn_fs_fs__id_parse(&result->id, str, result_pool));
+  *dirent = result;
+
+  return SVN_NO_ERROR;
+}
+
 /* Into *ENTRIES_P, read all directories entries from the key-value text in
  * STREAM.  If INCREMENTAL is TRUE, read until the end of the STREAM and
  * update the data.  ID is provided for nicer error messages.
@@ -2607,7 +3449,6 @@ read_dir_entries(apr_array_header_t **entries_p,
     {
       svn_hash__entry_t entry;
       svn_fs_dirent_t *dirent;
-      char *str;
 
       svn_pool_clear(iterpool);
       SVN_ERR_W(svn_hash__read_entry(&entry, stream, terminator,
@@ -2637,37 +3478,8 @@ read_dir_entries(apr_array_header_t **entries_p,
         }
 
       /* Add a new directory entry. */
-      dirent = apr_pcalloc(result_pool, sizeof(*dirent));
-      dirent->name = apr_pstrmemdup(result_pool, entry.key, entry.keylen);
-
-      str = svn_cstring_tokenize(" ", &entry.val);
-      if (str == NULL)
-        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                           _("Directory entry corrupt in '%s'"),
-                           svn_fs_fs__id_unparse(id, scratch_pool)->data);
-
-      if (strcmp(str, SVN_FS_FS__KIND_FILE) == 0)
-        {
-          dirent->kind = svn_node_file;
-        }
-      else if (strcmp(str, SVN_FS_FS__KIND_DIR) == 0)
-        {
-          dirent->kind = svn_node_dir;
-        }
-      else
-        {
-          return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                           _("Directory entry corrupt in '%s'"),
-                           svn_fs_fs__id_unparse(id, scratch_pool)->data);
-        }
-
-      str = svn_cstring_tokenize(" ", &entry.val);
-      if (str == NULL)
-        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
-                           _("Directory entry corrupt in '%s'"),
-                           svn_fs_fs__id_unparse(id, scratch_pool)->data);
-
-      SVN_ERR(svn_fs_fs__id_parse(&dirent->id, str, result_pool));
+      SVN_ERR(parse_dir_entry(&dirent, &entry, id, result_pool,
+                              scratch_pool));
 
       /* In incremental mode, update the hash; otherwise, write to the
        * final array.  Be sure to use hash keys that survive this iteration.
@@ -2698,6 +3510,48 @@ read_dir_entries(apr_array_header_t **entries_p,
   return SVN_NO_ERROR;
 }
 
+/* Like read_dir_entries() in non-incremental mode but parse the key-value
+ * text in TEXT in place, i.e. without copying the individual entries.
+ * TEXT will be modified.
+ */
+static svn_error_t *
+parse_dir_entries(apr_array_header_t **entries_p,
+                  svn_stringbuf_t *text,
+                  const svn_fs_id_t *id,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *hash_entries;
+  apr_array_header_t *entries;
+  int i;
+
+  SVN_ERR_W(svn_hash__parse_entries(&hash_entries, text->data, text->len,
+                                    SVN_HASH_TERMINATOR, FALSE,
+                                    scratch_pool),
+            apr_psprintf(scratch_pool,
+                         _("Directory representation corrupt in '%s'"),
+                         svn_fs_fs__id_unparse(id, scratch_pool)->data));
+
+  entries = apr_array_make(result_pool, hash_entries->nelts,
+                           sizeof(svn_fs_dirent_t *));
+  for (i = 0; i < hash_entries->nelts; ++i)
+    {
+      svn_hash__entry_t *entry = &APR_ARRAY_IDX(hash_entries, i,
+                                                svn_hash__entry_t);
+      svn_fs_dirent_t *dirent;
+
+      SVN_ERR(parse_dir_entry(&dirent, entry, id, result_pool,
+                              scratch_pool));
+      APR_ARRAY_PUSH(entries, svn_fs_dirent_t *) = dirent;
+    }
+
+  if (!sorted(entries))
+    svn_sort__array(entries, compare_dirents);
+
+  *entries_p = entries;
+  return SVN_NO_ERROR;
+}
+
 /* For directory NODEREV in FS, return the *FILESIZE of its in-txn
  * representation.  If the directory representation is committed data,
  * set *FILESIZE to SVN_INVALID_FILESIZE. Use SCRATCH_POOL for temporaries.
@@ -2782,9 +3636,8 @@ get_dir_contents(svn_fs_fs__dir_data_t *dir,
       SVN_ERR(svn_stream_close(contents));
 
       /* de-serialize hash */
-      contents = svn_stream_from_stringbuf(text, scratch_pool);
-      SVN_ERR(read_dir_entries(&dir->entries, contents, FALSE, noderev->id,
-                               result_pool, scratch_pool));
+      SVN_ERR(parse_dir_entries(&dir->entries, text, noderev->id,
+                                result_pool, scratch_pool));
     }
   else
     {
@@ -2896,6 +3749,197 @@ svn_fs_fs__find_dir_entry(apr_array_header_t *entries,
   return result ? *result : NULL;
 }
 
+/* Directory representations smaller than this will not be probed for a
+ * name index.  Reading them in full is cheap enough. */
+#define DIR_INDEX_MIN_PROBE_SIZE 0x4000
+
+/* Maximum length of the SVN_FS_FS__DIR_INDEX_MARKER line including the
+ * newline. */
+#define DIR_INDEX_TRAILER_MAX (sizeof(SVN_FS_FS__DIR_INDEX_MARKER) \
+                               + 3 * SVN_INT64_BUFFER_SIZE)
+
+/* Read LEN bytes starting at OFFSET in REV_FILE of FS into BUFFER.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_dir_index_data(char *buffer,
+                    svn_fs_t *fs,
+                    svn_fs_fs__revision_file_t *rev_file,
+                    apr_off_t offset,
+                    apr_size_t len,
+                    apr_pool_t *scratch_pool)
+{
+  SVN_ERR(aligned_seek(fs, rev_file->file, NULL, offset, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(rev_file->file, buffer, len, NULL, NULL,
+                                 scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return an error indicating that the name index of directory ID is
+ * corrupt. */
+static svn_error_t *
+dir_index_corrupt(const svn_fs_id_t *id,
+                  apr_pool_t *scratch_pool)
+{
+  return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                           _("Directory index corrupt in '%s'"),
+                           svn_fs_fs__id_unparse(id, scratch_pool)->data);
+}
+
+/* If the committed directory NODEREV in FS has a name index, look up the
+ * entry called NAME through it, set *INDEXED to TRUE and return the entry
+ * in *DIRENT, allocated in RESULT_POOL.  *DIRENT will be NULL if there is
+ * no such entry.  Otherwise, set *INDEXED to FALSE.
+ *
+ * This reads only the index trailer, a logarithmic number of index
+ * entries and directory entries instead of the whole directory.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+read_indexed_dir_entry(svn_fs_dirent_t **dirent,
+                       svn_boolean_t *indexed,
+                       svn_fs_t *fs,
+                       node_revision_t *noderev,
+                       const char *name,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  representation_t *rep = noderev->data_rep;
+  svn_fs_fs__revision_file_t *rev_file;
+  svn_fs_fs__rep_header_t *header;
+  apr_off_t offset;
+  apr_off_t data_start;
+  char trailer[DIR_INDEX_TRAILER_MAX + 1];
+  apr_size_t trailer_len;
+  char *line;
+  char *token;
+  apr_uint64_t values[3];
+  apr_uint64_t count, width, index_offset;
+  apr_uint64_t lower, upper;
+  apr_pool_t *iterpool;
+  int i;
+
+  *dirent = NULL;
+  *indexed = FALSE;
+
+  /* Indexed directories are always large PLAIN reps, i.e. their on-disk
+   * size matches their expanded size. */
+  if (   ffd->format < SVN_FS_FS__MIN_DIR_INDEX_FORMAT
+      || rep == NULL
+      || svn_fs_fs__id_txn_used(&rep->txn_id)
+      || rep->expanded_size < DIR_INDEX_MIN_PROBE_SIZE
+      || rep->size != rep->expanded_size)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(rep->revision, fs, scratch_pool));
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rep->revision,
+                                           scratch_pool, scratch_pool));
+  SVN_ERR(svn_fs_fs__item_offset(&offset, fs, rev_file, rep->revision, NULL,
+                                 rep->item_index, scratch_pool));
+  SVN_ERR(aligned_seek(fs, rev_file->file, NULL, offset, scratch_pool));
+  SVN_ERR(svn_fs_fs__read_rep_header(&header, rev_file->stream,
+                                     scratch_pool, scratch_pool));
+  if (header->type != svn_fs_fs__rep_plain)
+    return svn_error_trace(svn_fs_fs__close_revision_file(rev_file));
+
+  /* Read the last line of the rep and check for the index marker. */
+  data_start = offset + header->header_size;
+  trailer_len = (apr_size_t)MIN(rep->size, DIR_INDEX_TRAILER_MAX);
+  SVN_ERR(read_dir_index_data(trailer, fs, rev_file,
+                              data_start + rep->size - trailer_len,
+                              trailer_len, scratch_pool));
+  trailer[trailer_len] = '\0';
+
+  if (trailer_len == 0 || trailer[trailer_len - 1] != '\n')
+    return svn_error_trace(svn_fs_fs__close_revision_file(rev_file));
+
+  trailer[trailer_len - 1] = '\0';
+  line = strrchr(trailer, '\n');
+  if (   line == NULL
+      || strncmp(line + 1, SVN_FS_FS__DIR_INDEX_MARKER " ",
+                 sizeof(SVN_FS_FS__DIR_INDEX_MARKER)) != 0)
+    return svn_error_trace(svn_fs_fs__close_revision_file(rev_file));
+
+  /* Parse the index parameters. */
+  line += sizeof(SVN_FS_FS__DIR_INDEX_MARKER) + 1;
+  for (i = 0; i < 3; ++i)
+    {
+      token = svn_cstring_tokenize(" ", &line);
+      if (token == NULL)
+        return svn_error_trace(dir_index_corrupt(noderev->id, scratch_pool));
+
+      SVN_ERR_W(svn_cstring_strtoui64(&values[i], token, 0, rep->size, 10),
+                apr_psprintf(scratch_pool,
+                             _("Directory index corrupt in '%s'"),
+                             svn_fs_fs__id_unparse(noderev->id,
+                                                   scratch_pool)->data));
+    }
+
+  count = values[0];
+  width = values[1];
+  index_offset = values[2];
+  if (   width == 0
+      || width >= SVN_INT64_BUFFER_SIZE
+      || index_offset + count * (width + 1) > rep->size)
+    return svn_error_trace(dir_index_corrupt(noderev->id, scratch_pool));
+
+  /* Binary search over the index. */
+  iterpool = svn_pool_create(scratch_pool);
+  lower = 0;
+  upper = count;
+  while (lower < upper)
+    {
+      apr_uint64_t middle = lower + (upper - lower) / 2;
+      apr_uint64_t entry_offset;
+      char digits[SVN_INT64_BUFFER_SIZE];
+      svn_hash__entry_t entry;
+      int diff;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(read_dir_index_data(digits, fs, rev_file,
+                                  data_start + index_offset
+                                    + middle * (width + 1),
+                                  (apr_size_t)width, iterpool));
+      digits[width] = '\0';
+      SVN_ERR_W(svn_cstring_strtoui64(&entry_offset, digits, 0,
+                                      index_offset, 10),
+                apr_psprintf(iterpool, _("Directory index corrupt in '%s'"),
+                             svn_fs_fs__id_unparse(noderev->id,
+                                                   iterpool)->data));
+
+      SVN_ERR(aligned_seek(fs, rev_file->file, NULL,
+                           data_start + entry_offset, iterpool));
+      SVN_ERR_W(svn_hash__read_entry(&entry, rev_file->stream,
+                                     SVN_HASH_TERMINATOR, FALSE, iterpool),
+                apr_psprintf(iterpool,
+                             _("Directory representation corrupt in '%s'"),
+                             svn_fs_fs__id_unparse(noderev->id,
+                                                   iterpool)->data));
+      if (entry.key == NULL || entry.val == NULL)
+        return svn_error_trace(dir_index_corrupt(noderev->id, iterpool));
+
+      diff = strcmp(entry.key, name);
+      if (diff == 0)
+        {
+          SVN_ERR(parse_dir_entry(dirent, &entry, noderev->id, result_pool,
+                                  iterpool));
+          break;
+        }
+
+      if (diff < 0)
+        lower = middle + 1;
+      else
+        upper = middle;
+    }
+
+  svn_pool_destroy(iterpool);
+  *indexed = TRUE;
+
+  return svn_error_trace(svn_fs_fs__close_revision_file(rev_file));
+}
+
 svn_error_t *
 svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
                                   svn_fs_t *fs,
@@ -2935,6 +3979,13 @@ svn_fs_fs__rep_contents_dir_entry(svn_fs_dirent_t **dirent,
       svn_fs_dirent_t *entry;
       svn_fs_dirent_t *entry_copy = NULL;
       svn_fs_fs__dir_data_t dir;
+      svn_boolean_t indexed;
+
+      /* Large directories may allow us to read just the entry we need. */
+      SVN_ERR(read_indexed_dir_entry(dirent, &indexed, fs, noderev, name,
+                                     result_pool, scratch_pool));
+      if (indexed)
+        return SVN_NO_ERROR;
 
       /* Read in the directory contents. */
       SVN_ERR(get_dir_contents(&dir, fs, noderev, scratch_pool,
@@ -3083,6 +4134,11 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
       found = FALSE;
     }
 
+  /* Record each list only once, not every block of it. */
+  if (context->next == 0)
+    SVN_ERR(svn_fs_fs__trace_changes(context->fs, context->revision, found,
+                                     scratch_pool));
+
   if (!found)
     {
       /* read changes from revision file */
@@ -3119,6 +4175,7 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
       if (!found)
         {
           apr_off_t changes_offset;
+          svn_boolean_t eol;
 
           /* Addressing is very different for old formats
            * (needs to read the revision trailer). */
@@ -3146,7 +4203,7 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
                                NULL, changes_offset + context->next_offset,
                                scratch_pool));
 
-          SVN_ERR(svn_fs_fs__read_changes(changes,
+          SVN_ERR(svn_fs_fs__read_changes(changes, &eol,
                                           context->revision_file->stream,
                                           SVN_FS_FS__CHANGES_BLOCK_SIZE,
                                           result_pool, scratch_pool));
@@ -3160,7 +4217,7 @@ svn_fs_fs__get_changes(apr_array_header_t **changes,
           changes_list->start_offset = context->next_offset;
           changes_list->count = (*changes)->nelts;
           changes_list->changes = (change_t **)(*changes)->elts;
-          changes_list->eol = changes_list->count < SVN_FS_FS__CHANGES_BLOCK_SIZE;
+          changes_list->eol = eol;
 
           /* cache for future reference */
 
@@ -3490,8 +4547,11 @@ block_read_contents(svn_fs_t *fs,
 
   SVN_ERR(read_rep_header(&rep_header, fs, rev_file->stream, &header_key,
                           scratch_pool, scratch_pool));
-  SVN_ERR(block_read_windows(rep_header, fs, rev_file, entry, max_offset,
-                             scratch_pool, scratch_pool));
+
+  /* References into the group store have no windows of their own. */
+  if (rep_header->type != svn_fs_fs__rep_shared)
+    SVN_ERR(block_read_windows(rep_header, fs, rev_file, entry, max_offset,
+                               scratch_pool, scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -3560,6 +4620,7 @@ block_read_changes(svn_fs_t *fs,
   fs_fs_data_t *ffd = fs->fsap_data;
   svn_stream_t *stream;
   apr_array_header_t *changes;
+  svn_boolean_t eol;
 
   pair_cache_key_t key;
   key.revision = entry->item.revision;
@@ -3585,14 +4646,15 @@ block_read_changes(svn_fs_t *fs,
 
      Note: A 100 entries block is already > 10kB on disk.  With a 4kB default
            disk block size, this function won't even be called for larger
-           changed paths lists. */
-  SVN_ERR(svn_fs_fs__read_changes(&changes, stream,
+           changed paths lists.  Packed lists are read in whole chunks. */
+  SVN_ERR(svn_fs_fs__read_changes(&changes, &eol, stream,
                                   SVN_FS_FS__CHANGES_BLOCK_SIZE + 1,
                                   scratch_pool, scratch_pool));
 
   /* We can only cache small lists that don't need to be split up.
-     For longer lists, we miss the file offset info for the respective */
-  if (changes->nelts <= SVN_FS_FS__CHANGES_BLOCK_SIZE)
+     For longer lists, we miss the file offset info for the respective
+     blocks. */
+  if (eol)
     {
       svn_fs_fs__changes_list_t changes_list;
 
@@ -3658,6 +4720,44 @@ block_read_noderev(node_revision_t **noderev_p,
   return SVN_NO_ERROR;
 }
 
+/* Having just read the block ending at BLOCK_END from REVISION_FILE in FS,
+ * ask the OS to read the next few blocks ahead, if configured to do so.
+ * Requests are made in multiples of half the read-ahead window such that
+ * sequential access patterns don't cause a system call for every block.
+ */
+static svn_error_t *
+block_read_ahead(svn_fs_t *fs,
+                 svn_fs_fs__revision_file_t *revision_file,
+                 apr_off_t block_end)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_off_t window = ffd->read_ahead_blocks * ffd->block_size;
+  apr_off_t start = block_end;
+  apr_off_t end = block_end + window;
+
+  if (window == 0)
+    return SVN_NO_ERROR;
+
+  /* Still well within the range we requested before? */
+  if (   revision_file->read_ahead_end - block_end > window / 2
+      && revision_file->read_ahead_end - block_end <= window)
+    return SVN_NO_ERROR;
+
+  /* Don't request the same data twice. */
+  if (   revision_file->read_ahead_end > start
+      && revision_file->read_ahead_end <= end)
+    start = revision_file->read_ahead_end;
+
+  /* Only read ahead within the revision contents, i.e. not the indexes. */
+  SVN_ERR(svn_fs_fs__auto_read_footer(revision_file));
+  end = MIN(end, revision_file->l2p_offset);
+
+  if (start < end)
+    svn_fs_fs__rev_file_read_ahead(revision_file, start, end - start);
+
+  return SVN_NO_ERROR;
+}
+
 /* Read the whole (e.g. 64kB) block containing ITEM_INDEX of REVISION in FS
  * and put all data into cache.  If necessary and depending on heuristics,
  * neighboring blocks may also get read.  The data is being read from
@@ -3720,6 +4820,8 @@ block_read(void **result,
 
       SVN_ERR(aligned_seek(fs, revision_file->file, &block_start, offset,
                            iterpool));
+      SVN_ERR(svn_fs_fs__trace_read(fs, revision, block_start,
+                                    ffd->block_size, iterpool));
 
       /* read all items from the block */
       for (i = 0; i < entries->nelts; ++i)
@@ -3783,6 +4885,9 @@ block_read(void **result,
                     break;
                 }
 
+              ffd->io_stats.items_read++;
+              ffd->io_stats.bytes_read += entry->size;
+
               if (is_result)
                 *result = item;
 
@@ -3798,6 +4903,9 @@ block_read(void **result,
   while(run_count++ == 1); /* can only be true once and only if a block
                             * boundary got crossed */
 
+  /* Prepare for the next blocks to be read. */
+  SVN_ERR(block_read_ahead(fs, revision_file, block_start + ffd->block_size));
+
   /* if the caller requested a result, we must have provided one by now */
   assert(!result || *result);
   svn_pool_destroy(iterpool);
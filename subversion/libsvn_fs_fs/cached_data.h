@@ -105,6 +105,34 @@ svn_fs_fs__get_contents_from_file(svn_stream_t **contents_p,
                                   apr_off_t offset,
                                   apr_pool_t *pool);
 
+/* If the text representation REP in filesystem FS is stored verbatim
+   in a committed revision, i.e. as a PLAIN rep, set *FILE_P to the open
+   rev or pack file containing it and *OFFSET and *LENGTH to the location
+   of the contents within that file.  Otherwise, set *FILE_P to NULL.
+   The file remains open until RESULT_POOL gets cleaned up.  Use
+   SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__get_contents_location(apr_file_t **file_p,
+                                 apr_off_t *offset,
+                                 svn_filesize_t *length,
+                                 svn_fs_t *fs,
+                                 representation_t *rep,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool);
+
+/* If the text representation REP in filesystem FS is stored in a
+   committed revision as a single svndiff1 window whose new data alone
+   make up the zlib-compressed fulltext, set *DEFLATED to those data as
+   a raw deflate stream, i.e. without the zlib header and trailer.
+   Otherwise, set *DEFLATED to NULL.  Allocate the result in RESULT_POOL
+   and use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_fs_fs__get_deflated_contents(svn_string_t **deflated,
+                                 svn_fs_t *fs,
+                                 representation_t *rep,
+                                 apr_pool_t *result_pool,
+                                 apr_pool_t *scratch_pool);
+
 /* Attempt to fetch the text representation of node-revision NODEREV as
    seen in filesystem FS and pass it along with the BATON to the PROCESSOR.
    Set *SUCCESS only of the data could be provided and the processing
@@ -35,8 +35,10 @@
 #include "svn_private_config.h"
 #include "svn_hash.h"
 #include "svn_pools.h"
+#include "svn_dirent_uri.h"
 
 #include "private/svn_debug.h"
+#include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
 
 /* Take the ORIGINAL string and replace all occurrences of ":" without
@@ -248,6 +250,8 @@ init_callbacks(svn_cache__t *cache,
 {
   if (cache != NULL)
     {
+      fs_fs_data_t *ffd = fs->fsap_data;
+
 #ifdef SVN_DEBUG_CACHE_DUMP_STATS
 
       /* schedule printing the access statistics upon pool cleanup,
@@ -271,6 +275,10 @@ init_callbacks(svn_cache__t *cache,
                                              fs,
                                              pool));
 
+      /* Remember it for svn_fs_get_io_stats(). */
+      if (ffd->caches == NULL)
+        ffd->caches = apr_array_make(fs->pool, 32, sizeof(cache));
+      APR_ARRAY_PUSH(ffd->caches, svn_cache__t *) = cache;
     }
 
   return SVN_NO_ERROR;
@@ -281,8 +289,10 @@ init_callbacks(svn_cache__t *cache,
  * MEMBUFFER is not NULL. Fallbacks to inprocess cache if MEMCACHE and
  * MEMBUFFER are NULL and pages is non-zero.  Sets *CACHE_P to NULL
  * otherwise.  Use the given PRIORITY class for the new cache.  If it
- * is 0, then use the default priority class.  HAS_NAMESPACE indicates
- * whether we prefixed this cache instance with a namespace.
+ * is 0, then use the default priority class.  Membuffer caches will store
+ * serialized items of COMPRESSION_THRESHOLD or more bytes compressed; 0
+ * disables that.  HAS_NAMESPACE indicates whether we prefixed this cache
+ * instance with a namespace.
  *
  * Unless NO_HANDLER is true, register an error handler that reports errors
  * as warnings to the FS warning callback.
@@ -300,6 +310,7 @@ create_cache(svn_cache__t **cache_p,
              apr_ssize_t klen,
              const char *prefix,
              apr_uint32_t priority,
+             apr_size_t compression_threshold,
              svn_boolean_t has_namespace,
              svn_fs_t *fs,
              svn_boolean_t no_handler,
@@ -325,10 +336,10 @@ create_cache(svn_cache__t **cache_p,
     {
       /* We assume caches with namespaces to be relatively short-lived,
        * i.e. their data will not be needed after a while. */
-      SVN_ERR(svn_cache__create_membuffer_cache(
+      SVN_ERR(svn_cache__create_membuffer_cache2(
                 cache_p, membuffer, serializer, deserializer,
-                klen, prefix, priority, FALSE, has_namespace,
-                result_pool, scratch_pool));
+                klen, prefix, priority, compression_threshold,
+                FALSE, has_namespace, result_pool, scratch_pool));
     }
   else if (pages)
     {
@@ -346,6 +357,90 @@ create_cache(svn_cache__t **cache_p,
   return SVN_NO_ERROR;
 }
 
+/* Return the on-disk cache store for FS in *STORE_P, or NULL if that has
+ * not been enabled or cannot be used.  Errors are reported as warnings
+ * through FS's warning callback unless NO_HANDLER is set.  Use POOL for
+ * temporary allocations.
+ */
+static svn_error_t *
+get_persistent_store(svn_cache__persistent_t **store_p,
+                     svn_fs_t *fs,
+                     svn_boolean_t no_handler,
+                     apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *err;
+
+  *store_p = NULL;
+  if (ffd->persistent_cache_size == 0)
+    return SVN_NO_ERROR;
+
+  err = svn_cache__get_persistent_store(store_p,
+                                        svn_dirent_join(fs->path,
+                                                        PATH_PERSISTENT_CACHE,
+                                                        pool),
+                                        ffd->persistent_cache_size,
+                                        pool);
+  if (err && no_handler)
+    return svn_error_trace(err);
+
+  if (err)
+    {
+      /* Caching is optional. */
+      SVN_ERR(warn_and_continue_on_cache_errors(err, fs, pool));
+      *store_p = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* If STORE is not NULL, put a persistent second level for the existing
+ * *CACHE_P into it.  SERIALIZER, DESERIALIZER and KLEN must be the same as
+ * for *CACHE_P and NAME must be unique within FS.  The data in *CACHE_P
+ * must be immutable.  Error handling is the same as for create_cache().
+ *
+ * Allocate the new cache in RESULT_POOL.
+ */
+static svn_error_t *
+add_persistent_tier(svn_cache__t **cache_p,
+                    svn_cache__persistent_t *store,
+                    svn_cache__serialize_func_t serializer,
+                    svn_cache__deserialize_func_t deserializer,
+                    apr_ssize_t klen,
+                    const char *name,
+                    svn_fs_t *fs,
+                    svn_boolean_t no_handler,
+                    apr_pool_t *result_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  int i;
+
+  if (store == NULL || *cache_p == NULL)
+    return SVN_NO_ERROR;
+
+  /* The persistent tier will replace the wrapped cache in the stats. */
+  for (i = ffd->caches->nelts - 1; i >= 0; --i)
+    if (APR_ARRAY_IDX(ffd->caches, i, svn_cache__t *) == *cache_p)
+      {
+        SVN_ERR(svn_sort__array_delete2(ffd->caches, i, 1));
+        break;
+      }
+
+  /* Repository copies may reuse the same UUID but not the instance ID. */
+  SVN_ERR(svn_cache__create_persistent(cache_p, *cache_p, store,
+                                       serializer, deserializer, klen,
+                                       apr_pstrcat(result_pool,
+                                                   ffd->instance_id, ":",
+                                                   name, ":", SVN_VA_NULL),
+                                       result_pool));
+
+  return svn_error_trace(init_callbacks(*cache_p, fs,
+                                        no_handler
+                                          ? NULL
+                                          : warn_and_fail_on_cache_errors,
+                                        result_pool));
+}
+
 svn_error_t *
 svn_fs_fs__initialize_caches(svn_fs_t *fs,
                              apr_pool_t *pool)
@@ -363,6 +458,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
   svn_boolean_t cache_nodeprops;
   const char *cache_namespace;
   svn_boolean_t has_namespace;
+  svn_cache__persistent_t *store;
 
   /* Evaluating the cache configuration. */
   SVN_ERR(read_config(&cache_namespace,
@@ -376,6 +472,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
   has_namespace = strlen(cache_namespace) > 0;
 
   membuffer = svn_cache__get_global_membuffer_cache();
+  SVN_ERR(get_persistent_store(&store, fs, no_handler, pool));
 
   /* General rules for assigning cache priorities:
    *
@@ -414,6 +511,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        sizeof(svn_revnum_t),
                        apr_pstrcat(pool, prefix, "RRI", SVN_VA_NULL),
                        0,
+                       0,
                        has_namespace,
                        fs,
                        no_handler,
@@ -430,6 +528,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        APR_HASH_KEY_STRING,
                        apr_pstrcat(pool, prefix, "DAG", SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_LOW_PRIORITY,
+                       0,
                        has_namespace,
                        fs,
                        no_handler,
@@ -448,6 +547,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        sizeof(pair_cache_key_t),
                        apr_pstrcat(pool, prefix, "DIR", SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       ffd->dir_cache_compression,
                        has_namespace,
                        fs,
                        no_handler,
@@ -465,6 +565,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(pool, prefix, "PACK-MANIFEST",
                                    SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       0,
                        has_namespace,
                        fs,
                        no_handler,
@@ -480,10 +581,20 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        sizeof(pair_cache_key_t),
                        apr_pstrcat(pool, prefix, "NODEREVS", SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       0,
                        has_namespace,
                        fs,
                        no_handler,
                        fs->pool, pool));
+  SVN_ERR(add_persistent_tier(&(ffd->node_revision_cache),
+                              store,
+                              svn_fs_fs__serialize_node_revision,
+                              svn_fs_fs__deserialize_node_revision,
+                              sizeof(pair_cache_key_t),
+                              "NODEREVS",
+                              fs,
+                              no_handler,
+                              fs->pool));
 
   /* initialize representation header cache, if caching has been enabled */
   SVN_ERR(create_cache(&(ffd->rep_header_cache),
@@ -495,6 +606,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        sizeof(pair_cache_key_t),
                        apr_pstrcat(pool, prefix, "REPHEADER", SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                       0,
                        has_namespace,
                        fs,
                        no_handler,
@@ -510,10 +622,20 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        sizeof(pair_cache_key_t),
                        apr_pstrcat(pool, prefix, "CHANGES", SVN_VA_NULL),
                        0,
+                       0,
                        has_namespace,
                        fs,
                        no_handler,
                        fs->pool, pool));
+  SVN_ERR(add_persistent_tier(&(ffd->changes_cache),
+                              store,
+                              svn_fs_fs__serialize_changes,
+                              svn_fs_fs__deserialize_changes,
+                              sizeof(pair_cache_key_t),
+                              "CHANGES",
+                              fs,
+                              no_handler,
+                              fs->pool));
 
   /* if enabled, cache revprops */
   SVN_ERR(create_cache(&(ffd->revprop_cache),
@@ -525,6 +647,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        sizeof(pair_cache_key_t),
                        apr_pstrcat(pool, prefix, "REVPROP", SVN_VA_NULL),
                        SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                       0,
                        TRUE, /* contents is short-lived */
                        fs,
                        no_handler,
@@ -542,6 +665,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            sizeof(pair_cache_key_t),
                            apr_pstrcat(pool, prefix, "TEXT", SVN_VA_NULL),
                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                           ffd->fulltext_cache_compression,
                            has_namespace,
                            fs,
                            no_handler,
@@ -557,6 +681,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            apr_pstrcat(pool, prefix, "MERGEINFO",
                                        SVN_VA_NULL),
                            0,
+                           0,
                            has_namespace,
                            fs,
                            no_handler,
@@ -572,6 +697,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            apr_pstrcat(pool, prefix, "HAS_MERGEINFO",
                                        SVN_VA_NULL),
                            0,
+                           0,
                            has_namespace,
                            fs,
                            no_handler,
@@ -597,6 +723,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            apr_pstrcat(pool, prefix, "PROP",
                                        SVN_VA_NULL),
                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                           0,
                            has_namespace,
                            fs,
                            no_handler,
@@ -620,6 +747,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            apr_pstrcat(pool, prefix, "RAW_WINDOW",
                                        SVN_VA_NULL),
                            SVN_CACHE__MEMBUFFER_LOW_PRIORITY,
+                           0,
                            has_namespace,
                            fs,
                            no_handler,
@@ -635,10 +763,20 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            apr_pstrcat(pool, prefix, "TXDELTA_WINDOW",
                                        SVN_VA_NULL),
                            SVN_CACHE__MEMBUFFER_LOW_PRIORITY,
+                           0,
                            has_namespace,
                            fs,
                            no_handler,
                            fs->pool, pool));
+      SVN_ERR(add_persistent_tier(&(ffd->txdelta_window_cache),
+                                  store,
+                                  svn_fs_fs__serialize_txdelta_window,
+                                  svn_fs_fs__deserialize_txdelta_window,
+                                  sizeof(window_cache_key_t),
+                                  "TXDELTA_WINDOW",
+                                  fs,
+                                  no_handler,
+                                  fs->pool));
 
       SVN_ERR(create_cache(&(ffd->combined_window_cache),
                            NULL,
@@ -650,6 +788,23 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                            apr_pstrcat(pool, prefix, "COMBINED_WINDOW",
                                        SVN_VA_NULL),
                            SVN_CACHE__MEMBUFFER_LOW_PRIORITY,
+                           0,
+                           has_namespace,
+                           fs,
+                           no_handler,
+                           fs->pool, pool));
+
+      SVN_ERR(create_cache(&(ffd->composed_window_cache),
+                           NULL,
+                           membuffer,
+                           0, 0, /* Do not use the inprocess cache */
+                           svn_fs_fs__serialize_txdelta_window,
+                           svn_fs_fs__deserialize_txdelta_window,
+                           sizeof(window_cache_key_t),
+                           apr_pstrcat(pool, prefix, "COMPOSED_WINDOW",
+                                       SVN_VA_NULL),
+                           SVN_CACHE__MEMBUFFER_LOW_PRIORITY,
+                           0,
                            has_namespace,
                            fs,
                            no_handler,
@@ -659,6 +814,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
     {
       ffd->txdelta_window_cache = NULL;
       ffd->combined_window_cache = NULL;
+      ffd->composed_window_cache = NULL;
     }
 
   SVN_ERR(create_cache(&(ffd->l2p_header_cache),
@@ -674,6 +830,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(pool, prefix, "L2P_HEADER",
                                    (char *)NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       0,
                        has_namespace,
                        fs,
                        no_handler,
@@ -691,6 +848,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(pool, prefix, "L2P_PAGE",
                                    (char *)NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       0,
                        has_namespace,
                        fs,
                        no_handler,
@@ -705,6 +863,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(pool, prefix, "P2L_HEADER",
                                    (char *)NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       0,
                        has_namespace,
                        fs,
                        no_handler,
@@ -719,6 +878,7 @@ svn_fs_fs__initialize_caches(svn_fs_t *fs,
                        apr_pstrcat(pool, prefix, "P2L_PAGE",
                                    (char *)NULL),
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       0,
                        has_namespace,
                        fs,
                        no_handler,
@@ -877,6 +1037,7 @@ svn_fs_fs__initialize_txn_caches(svn_fs_t *fs,
                        APR_HASH_KEY_STRING,
                        prefix,
                        SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       0,
                        TRUE, /* The TXN-ID is our namespace. */
                        fs,
                        TRUE,
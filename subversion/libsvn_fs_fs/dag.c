@@ -972,6 +972,55 @@ svn_fs_fs__dag_get_contents(svn_stream_t **contents_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__dag_get_contents_location(apr_file_t **file_p,
+                                     apr_off_t *offset,
+                                     svn_filesize_t *length,
+                                     dag_node_t *file,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool)
+{
+  node_revision_t *noderev;
+
+  /* Make sure our node is a file. */
+  if (file->kind != svn_node_file)
+    return svn_error_createf
+      (SVN_ERR_FS_NOT_FILE, NULL,
+       "Attempted to get textual contents of a *non*-file node");
+
+  SVN_ERR(get_node_revision(&noderev, file));
+
+  return svn_error_trace(svn_fs_fs__get_contents_location(file_p, offset,
+                                                          length, file->fs,
+                                                          noderev->data_rep,
+                                                          result_pool,
+                                                          scratch_pool));
+}
+
+svn_error_t *
+svn_fs_fs__dag_get_deflated_contents(svn_string_t **deflated,
+                                     dag_node_t *file,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool)
+{
+  node_revision_t *noderev;
+
+  /* Make sure our node is a file. */
+  if (file->kind != svn_node_file)
+    return svn_error_createf
+      (SVN_ERR_FS_NOT_FILE, NULL,
+       "Attempted to get textual contents of a *non*-file node");
+
+  SVN_ERR(get_node_revision(&noderev, file));
+
+  return svn_error_trace(svn_fs_fs__get_deflated_contents(deflated,
+                                                          file->fs,
+                                                          noderev->data_rep,
+                                                          result_pool,
+                                                          scratch_pool));
+}
+
+
 
 svn_error_t *
 svn_fs_fs__dag_get_file_delta_stream(svn_txdelta_stream_t **stream_p,
@@ -1090,6 +1139,36 @@ svn_fs_fs__dag_get_edit_stream(svn_stream_t **contents,
 }
 
 
+svn_error_t *
+svn_fs_fs__dag_get_edit_delta_handler(svn_txdelta_window_handler_t *handler,
+                                      void **handler_baton,
+                                      dag_node_t *file,
+                                      apr_pool_t *pool)
+{
+  node_revision_t *noderev;
+
+  /* Make sure our node is a file. */
+  if (file->kind != svn_node_file)
+    return svn_error_createf
+      (SVN_ERR_FS_NOT_FILE, NULL,
+       "Attempted to set textual contents of a *non*-file node");
+
+  /* Make sure our node is mutable. */
+  if (! svn_fs_fs__dag_check_mutable(file))
+    return svn_error_createf
+      (SVN_ERR_FS_NOT_MUTABLE, NULL,
+       "Attempted to set textual contents of an immutable node");
+
+  /* Get the node revision. */
+  SVN_ERR(get_node_revision(&noderev, file));
+
+  return svn_error_trace(svn_fs_fs__set_contents_delta(handler,
+                                                       handler_baton,
+                                                       file->fs, noderev,
+                                                       pool));
+}
+
+
 
 svn_error_t *
 svn_fs_fs__dag_finalize_edits(dag_node_t *file,
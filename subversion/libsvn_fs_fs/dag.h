@@ -413,6 +413,36 @@ svn_error_t *svn_fs_fs__dag_get_contents(svn_stream_t **contents,
                                          dag_node_t *file,
                                          apr_pool_t *pool);
 
+/* Set *FILE_P, *OFFSET and *LENGTH to the location of the contents of
+   FILE within its rev or pack file, if they are stored verbatim there.
+   Otherwise, set *FILE_P to NULL.  See svn_fs_fs__get_contents_location().
+
+   If FILE is not a file, return SVN_ERR_FS_NOT_FILE.
+
+   Allocate *FILE_P in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__dag_get_contents_location(apr_file_t **file_p,
+                                     apr_off_t *offset,
+                                     svn_filesize_t *length,
+                                     dag_node_t *file,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool);
+
+/* Set *DEFLATED to the contents of FILE as a raw deflate stream if they
+   are stored that way.  Otherwise, set *DEFLATED to NULL.  See
+   svn_fs_fs__get_deflated_contents().
+
+   If FILE is not a file, return SVN_ERR_FS_NOT_FILE.
+
+   Allocate *DEFLATED in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__dag_get_deflated_contents(svn_string_t **deflated,
+                                     dag_node_t *file,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool);
+
 /* Attempt to fetch the contents of NODE and pass it along with the BATON
    to the PROCESSOR.   Set *SUCCESS only of the data could be provided
    and the processor had been called.
@@ -451,6 +481,19 @@ svn_error_t *svn_fs_fs__dag_get_edit_stream(svn_stream_t **contents,
                                             dag_node_t *file,
                                             apr_pool_t *pool);
 
+/* Like svn_fs_fs__dag_get_edit_stream() but return a window handler in
+   *HANDLER and its baton in *HANDLER_BATON that stores a text delta
+   against the current contents of FILE directly.  If that is not
+   possible for the delta base FILE would use, set *HANDLER to NULL.
+
+   Use POOL for all allocations.
+ */
+svn_error_t *svn_fs_fs__dag_get_edit_delta_handler(
+  svn_txdelta_window_handler_t *handler,
+  void **handler_baton,
+  dag_node_t *file,
+  apr_pool_t *pool);
+
 
 /* Signify the completion of edits to FILE made using the stream
    returned by svn_fs_fs__dag_get_edit_stream, allocating from POOL.
@@ -32,13 +32,17 @@
 #include "svn_delta.h"
 #include "svn_version.h"
 #include "svn_pools.h"
+#include "svn_dirent_uri.h"
 #include "fs.h"
+#include "access_trace.h"
+#include "batch_fsync.h"
 #include "fs_fs.h"
 #include "tree.h"
 #include "lock.h"
 #include "hotcopy.h"
 #include "id.h"
 #include "pack.h"
+#include "path_index.h"
 #include "recovery.h"
 #include "rep-cache.h"
 #include "revprops.h"
@@ -124,6 +128,11 @@ fs_serialized_init(svn_fs_t *fs, apr_pool_t *common_pool, apr_pool_t *pool)
          transaction list and free transaction pointer. */
       SVN_ERR(svn_mutex__init(&ffsd->txn_list_lock, TRUE, common_pool));
 
+      /* Concurrent commits may share the flush of 'current'. */
+      SVN_ERR(svn_mutex__init(&ffsd->group_commit_lock, TRUE, common_pool));
+      SVN_ERR(svn_thread_cond__create(&ffsd->group_commit_cond,
+                                      common_pool));
+
       key = apr_pstrdup(common_pool, key);
       status = apr_pool_userdata_set(ffsd, key, NULL, common_pool);
       if (status)
@@ -242,6 +251,23 @@ fs_info(const void **fsfs_info,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+fs_get_io_stats(svn_fs_io_stats_t *stats,
+                svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  int i;
+
+  *stats = ffd->io_stats;
+  if (ffd->caches)
+    for (i = 0; i < ffd->caches->nelts; ++i)
+      svn_cache__add_access_counts(&stats->cache_gets, &stats->cache_hits,
+                                   APR_ARRAY_IDX(ffd->caches, i,
+                                                 svn_cache__t *));
+
+  return SVN_NO_ERROR;
+}
+
 /* Wrapper around svn_fs_fs__set_uuid() adapting between function
    signatures. */
 static svn_error_t *
@@ -274,6 +300,7 @@ fs_ioctl(svn_fs_t *fs, svn_fs_ioctl_code_t ctlcode,
           SVN_ERR(svn_fs_fs__get_stats(&output->stats, fs,
                                        input->progress_func,
                                        input->progress_baton,
+                                       input->jobs, input->sample,
                                        cancel_func, cancel_baton,
                                        result_pool, scratch_pool));
           *output_p = output;
@@ -312,6 +339,20 @@ fs_ioctl(svn_fs_t *fs, svn_fs_ioctl_code_t ctlcode,
           *output_p = output;
           return SVN_NO_ERROR;
         }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_VERIFY_FINGERPRINT.code)
+        {
+          svn_fs_fs__ioctl_verify_fingerprint_input_t *input = input_void;
+          svn_fs_fs__ioctl_verify_fingerprint_output_t *output
+            = apr_pcalloc(result_pool, sizeof(*output));
+
+          SVN_ERR(svn_fs_fs__verify_fingerprint(&output->start_rev,
+                                                &output->end_rev,
+                                                &output->fingerprint,
+                                                fs, input->revision,
+                                                result_pool, scratch_pool));
+          *output_p = output;
+          return SVN_NO_ERROR;
+        }
       else if (ctlcode.code == SVN_FS_FS__IOCTL_BUILD_REP_CACHE.code)
         {
           svn_fs_fs__ioctl_build_rep_cache_input_t *input = input_void;
@@ -319,6 +360,8 @@ fs_ioctl(svn_fs_t *fs, svn_fs_ioctl_code_t ctlcode,
           SVN_ERR(svn_fs_fs__build_rep_cache(fs,
                                              input->start_rev,
                                              input->end_rev,
+                                             input->jobs,
+                                             input->incremental,
                                              input->progress_func,
                                              input->progress_baton,
                                              cancel_func,
@@ -328,6 +371,115 @@ fs_ioctl(svn_fs_t *fs, svn_fs_ioctl_code_t ctlcode,
           *output_p = NULL;
           return SVN_NO_ERROR;
         }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_CHANGED_REVS.code)
+        {
+          svn_fs_fs__ioctl_changed_revs_input_t *input = input_void;
+          svn_fs_fs__ioctl_changed_revs_output_t *output
+            = apr_pcalloc(result_pool, sizeof(*output));
+
+          SVN_ERR(svn_fs_fs__path_index_find(&output->revisions, fs,
+                                             input->path,
+                                             input->start_rev,
+                                             input->end_rev,
+                                             input->include_descendants,
+                                             cancel_func, cancel_baton,
+                                             result_pool, scratch_pool));
+          *output_p = output;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_REVISION_PROPLISTS.code)
+        {
+          svn_fs_fs__ioctl_revision_proplists_input_t *input = input_void;
+          svn_fs_fs__ioctl_revision_proplists_output_t *output
+            = apr_pcalloc(result_pool, sizeof(*output));
+
+          SVN_ERR(svn_fs_fs__get_revision_proplists(&output->proplists, fs,
+                                                    input->start_rev,
+                                                    input->end_rev,
+                                                    result_pool,
+                                                    scratch_pool));
+          *output_p = output;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_CONTENTS_LOCATION.code)
+        {
+          svn_fs_fs__ioctl_contents_location_input_t *input = input_void;
+          svn_fs_fs__ioctl_contents_location_output_t *output
+            = apr_pcalloc(result_pool, sizeof(*output));
+
+          SVN_ERR(svn_fs_fs__file_contents_location(&output->file,
+                                                    &output->offset,
+                                                    &output->length,
+                                                    input->root,
+                                                    input->path,
+                                                    result_pool,
+                                                    scratch_pool));
+          *output_p = output;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_DEFLATED_CONTENTS.code)
+        {
+          svn_fs_fs__ioctl_deflated_contents_input_t *input = input_void;
+          svn_fs_fs__ioctl_deflated_contents_output_t *output
+            = apr_pcalloc(result_pool, sizeof(*output));
+
+          SVN_ERR(svn_fs_fs__file_deflated_contents(&output->deflated,
+                                                    input->root,
+                                                    input->path,
+                                                    result_pool,
+                                                    scratch_pool));
+          *output_p = output;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_REVPROP_GENERATION.code)
+        {
+          svn_fs_fs__ioctl_revprop_generation_output_t *output
+            = apr_pcalloc(result_pool, sizeof(*output));
+
+          SVN_ERR(svn_fs_fs__get_revprop_generation(&output->epoch,
+                                                    &output->generation,
+                                                    fs, scratch_pool));
+          *output_p = output;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_REPLAY_TRACE.code)
+        {
+          svn_fs_fs__ioctl_replay_trace_input_t *input = input_void;
+          svn_fs_fs__ioctl_replay_trace_output_t *output;
+
+          SVN_ERR(svn_fs_fs__replay_access_trace(&output, fs, input->path,
+                                                 cancel_func, cancel_baton,
+                                                 result_pool, scratch_pool));
+          *output_p = output;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_REPACK.code)
+        {
+          svn_fs_fs__ioctl_repack_input_t *input = input_void;
+
+          SVN_ERR(svn_fs_fs__repack(fs, input->revision,
+                                    input->notify_func, input->notify_baton,
+                                    cancel_func, cancel_baton,
+                                    scratch_pool));
+          *output_p = NULL;
+          return SVN_NO_ERROR;
+        }
+      else if (ctlcode.code == SVN_FS_FS__IOCTL_RESHARD.code)
+        {
+          svn_fs_fs__ioctl_reshard_input_t *input = input_void;
+          svn_fs_t *dst_fs;
+
+          SVN_ERR(svn_fs_fs__new_instance(&dst_fs, fs, scratch_pool));
+          SVN_ERR(svn_fs_fs__reshard(fs, dst_fs, input->path,
+                                     input->max_files_per_dir, input->jobs,
+                                     input->notify_func,
+                                     input->pack_notify_func,
+                                     input->notify_baton,
+                                     cancel_func, cancel_baton,
+                                     scratch_pool));
+          *output_p = NULL;
+          return SVN_NO_ERROR;
+        }
     }
 
   return svn_error_create(SVN_ERR_FS_UNRECOGNIZED_IOCTL_CODE, NULL, NULL);
@@ -358,7 +510,8 @@ static fs_vtable_t fs_vtable = {
   svn_fs_fs__verify_root,
   fs_freeze,
   fs_set_errcall,
-  fs_ioctl
+  fs_ioctl,
+  fs_get_io_stats
 };
 
 
@@ -370,7 +523,6 @@ initialize_fs_struct(svn_fs_t *fs)
 {
   fs_fs_data_t *ffd = apr_pcalloc(fs->pool, sizeof(*ffd));
   ffd->use_log_addressing = FALSE;
-  ffd->revprop_prefix = 0;
   ffd->flush_to_disk = TRUE;
 
   fs->vtable = &fs_vtable;
@@ -446,6 +598,86 @@ fs_open(svn_fs_t *fs,
 
 
 
+svn_error_t *
+svn_fs_fs__new_instance(svn_fs_t **new_fs,
+                        svn_fs_t *fs,
+                        apr_pool_t *result_pool)
+{
+  svn_fs_t *instance = apr_pcalloc(result_pool, sizeof(*instance));
+
+  instance->pool = result_pool;
+  instance->warning = fs->warning;
+  instance->warning_baton = fs->warning_baton;
+  instance->config = fs->config ? apr_hash_copy(result_pool, fs->config)
+                                : NULL;
+
+  SVN_ERR(initialize_fs_struct(instance));
+
+  *new_fs = instance;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__open_instance(svn_fs_t **new_fs,
+                         svn_fs_t *fs,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_data_t *new_ffd;
+  svn_fs_t *instance;
+
+  SVN_ERR(svn_fs_fs__new_instance(&instance, fs, result_pool));
+  SVN_ERR(svn_fs_fs__open(instance, fs->path, scratch_pool));
+  SVN_ERR(svn_fs_fs__initialize_caches(instance, scratch_pool));
+
+  /* FS has already been registered in the common pool, so we can simply
+     use the same shared data without further synchronization. */
+  new_ffd = instance->fsap_data;
+  new_ffd->shared = ffd->shared;
+
+  *new_fs = instance;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_group_store(svn_fs_t **group_store,
+                           svn_fs_t *fs,
+                           apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (!ffd->group_store && ffd->group_store_path)
+    {
+      svn_fs_t *store = apr_pcalloc(fs->pool, sizeof(*store));
+      svn_error_t *err;
+
+      store->pool = fs->pool;
+      store->warning = fs->warning;
+      store->warning_baton = fs->warning_baton;
+      store->config = fs->config;
+
+      /* We only read from the group store, so it does not need the
+         process-wide data (locks etc.) of a regularly opened FS. */
+      SVN_ERR(initialize_fs_struct(store));
+      err = svn_fs_fs__open(store, ffd->group_store_path, scratch_pool);
+      if (err)
+        return svn_error_createf(err->apr_err, err,
+                                 _("Can't open group store '%s'"),
+                                 svn_dirent_local_style(ffd->group_store_path,
+                                                        scratch_pool));
+
+      SVN_ERR(svn_fs_fs__initialize_caches(store, scratch_pool));
+
+      ffd->group_store = store;
+    }
+
+  *group_store = ffd->group_store;
+  return SVN_NO_ERROR;
+}
+
+
+
 /* This implements the fs_library_vtable_t.open_for_recovery() API. */
 static svn_error_t *
 fs_open_for_recovery(svn_fs_t *fs,
@@ -545,6 +777,7 @@ fs_verify(svn_fs_t *fs, const char *path,
 static svn_error_t *
 fs_pack(svn_fs_t *fs,
         const char *path,
+        int jobs,
         svn_fs_pack_notify_t notify_func,
         void *notify_baton,
         svn_cancel_func_t cancel_func,
@@ -554,7 +787,7 @@ fs_pack(svn_fs_t *fs,
         apr_pool_t *common_pool)
 {
   SVN_ERR(fs_open(fs, path, common_pool_lock, pool, common_pool));
-  return svn_fs_fs__pack(fs, 0, notify_func, notify_baton,
+  return svn_fs_fs__pack(fs, 0, jobs, notify_func, notify_baton,
                          cancel_func, cancel_baton, pool);
 }
 
@@ -575,6 +808,7 @@ fs_hotcopy(svn_fs_t *src_fs,
            const char *dst_path,
            svn_boolean_t clean_logs,
            svn_boolean_t incremental,
+           int jobs,
            svn_fs_hotcopy_notify_t notify_func,
            void *notify_baton,
            svn_cancel_func_t cancel_func,
@@ -593,7 +827,7 @@ fs_hotcopy(svn_fs_t *src_fs,
      can't be opened.
    */
   return svn_fs_fs__hotcopy(src_fs, dst_fs, src_path, dst_path,
-                            incremental, notify_func, notify_baton,
+                            incremental, jobs, notify_func, notify_baton,
                             cancel_func, cancel_baton, common_pool_lock,
                             pool, common_pool);
 }
@@ -704,6 +938,7 @@ svn_fs_fs__init(const svn_version_t *loader_version,
                              _("Unsupported FS loader version (%d) for fsfs"),
                              loader_version->major);
   SVN_ERR(svn_ver_check_list2(fs_version(), checklist, svn_ver_equal));
+  SVN_ERR(svn_fs_fs__batch_fsync_init(common_pool));
 
   *vtable = &library_vtable;
   return SVN_NO_ERROR;
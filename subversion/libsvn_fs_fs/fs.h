@@ -28,6 +28,7 @@
 #include <apr_network_io.h>
 #include <apr_md5.h>
 #include <apr_sha1.h>
+#include <apr_portable.h>
 
 #include "svn_fs.h"
 #include "svn_config.h"
@@ -36,6 +37,7 @@
 #include "private/svn_fs_private.h"
 #include "private/svn_sqlite.h"
 #include "private/svn_mutex.h"
+#include "private/svn_thread_cond.h"
 
 #include "rev_file.h"
 
@@ -68,8 +70,14 @@ extern "C" {
                                                     has not been packed. */
 #define PATH_REVPROP_GENERATION "revprop-generation"
                                                  /* Current revprop generation*/
+#define PATH_REVPROP_GENERATIONS "revprop-generations"
+                                                 /* Per-shard revprop
+                                                    generations */
+#define PATH_PERSISTENT_CACHE "persistent-cache" /* On-disk cache contents */
 #define PATH_MANIFEST         "manifest"         /* Manifest file name */
 #define PATH_PACKED           "pack"             /* Packed revision data file */
+#define PATH_CHANGED_PATHS    "changed-paths"    /* Per-shard index of the
+                                                    changed paths */
 #define PATH_EXT_PACKED_SHARD ".pack"            /* Extension for packed
                                                     shards */
 #define PATH_EXT_L2P_INDEX    ".l2p"             /* extension of the log-
@@ -100,13 +108,24 @@ extern "C" {
 /* Names of sections and options in fsfs.conf. */
 #define CONFIG_SECTION_CACHES            "caches"
 #define CONFIG_OPTION_FAIL_STOP          "fail-stop"
+#define CONFIG_OPTION_PERSISTENT_CACHE_SIZE "persistent-cache-size"
+#define CONFIG_OPTION_MEMCACHED_ASYNC_WRITES "memcached-async-writes"
+#define CONFIG_OPTION_FULLTEXT_CACHE_COMPRESSION "fulltext-cache-compression"
+#define CONFIG_OPTION_DIR_CACHE_COMPRESSION "dir-cache-compression"
 #define CONFIG_SECTION_REP_SHARING       "rep-sharing"
 #define CONFIG_OPTION_ENABLE_REP_SHARING "enable-rep-sharing"
+#define CONFIG_OPTION_REP_CACHE_MEMORY_SIZE "rep-cache-memory-size"
+#define CONFIG_OPTION_REP_CACHE_MMAP_SIZE "rep-cache-mmap-size"
+#define CONFIG_OPTION_GROUP_STORE        "group-store"
 #define CONFIG_SECTION_DELTIFICATION     "deltification"
 #define CONFIG_OPTION_ENABLE_DIR_DELTIFICATION   "enable-dir-deltification"
+#define CONFIG_OPTION_ENABLE_FILE_DELTIFICATION  "enable-file-deltification"
+#define CONFIG_OPTION_DIR_INDEX_MIN_ENTRIES      "directory-index-min-entries"
 #define CONFIG_OPTION_ENABLE_PROPS_DELTIFICATION "enable-props-deltification"
 #define CONFIG_OPTION_MAX_DELTIFICATION_WALK     "max-deltification-walk"
 #define CONFIG_OPTION_MAX_LINEAR_DELTIFICATION   "max-linear-deltification"
+#define CONFIG_OPTION_ENABLE_SOURCE_TRACKING     "enable-source-tracking"
+#define CONFIG_OPTION_ENABLE_SIMILAR_DELTA_BASES "enable-similar-delta-bases"
 #define CONFIG_OPTION_COMPRESSION_LEVEL  "compression-level"
 #define CONFIG_SECTION_PACKED_REVPROPS   "packed-revprops"
 #define CONFIG_OPTION_REVPROP_PACK_SIZE  "revprop-pack-size"
@@ -115,10 +134,15 @@ extern "C" {
 #define CONFIG_OPTION_BLOCK_SIZE         "block-size"
 #define CONFIG_OPTION_L2P_PAGE_SIZE      "l2p-page-size"
 #define CONFIG_OPTION_P2L_PAGE_SIZE      "p2l-page-size"
+#define CONFIG_OPTION_MMAP_PACK_FILES    "memory-map-pack-files"
+#define CONFIG_OPTION_READ_AHEAD_BLOCKS  "read-ahead-blocks"
+#define CONFIG_OPTION_GROUP_COMMIT       "group-commit"
 #define CONFIG_SECTION_DEBUG             "debug"
 #define CONFIG_OPTION_PACK_AFTER_COMMIT  "pack-after-commit"
 #define CONFIG_OPTION_VERIFY_BEFORE_COMMIT "verify-before-commit"
+#define CONFIG_OPTION_ACCESS_TRACE       "access-trace"
 #define CONFIG_OPTION_COMPRESSION        "compression"
+#define CONFIG_OPTION_COMPRESSION_THREADS "compression-threads"
 
 /* The format number of this filesystem.
    This is independent of the repository format number, and
@@ -127,7 +151,7 @@ extern "C" {
    Note: If you bump this, please update the switch statement in
          svn_fs_fs__create() as well.
  */
-#define SVN_FS_FS__FORMAT_NUMBER   8
+#define SVN_FS_FS__FORMAT_NUMBER   9
 
 /* The minimum format number that supports svndiff version 1.  */
 #define SVN_FS_FS__MIN_SVNDIFF1_FORMAT 2
@@ -188,6 +212,18 @@ extern "C" {
 /* The minimum format number that supports svndiff version 2. */
 #define SVN_FS_FS__MIN_SVNDIFF2_FORMAT 8
 
+/* The minimum format number that supports svndiff version 3. */
+#define SVN_FS_FS__MIN_SVNDIFF3_FORMAT 9
+
+/* The minimum format number that supports directory representations
+   with a name index, see SVN_FS_FS__DIR_INDEX_MARKER. */
+#define SVN_FS_FS__MIN_DIR_INDEX_FORMAT 9
+
+/* The minimum format number that stores the changed paths lists in rev
+   files in the packed binary encoding, see svn_fs_fs__write_packed_changes.
+ */
+#define SVN_FS_FS__MIN_PACKED_CHANGES_FORMAT 9
+
 /* The minimum format number that supports the special notation ("-")
    for optional values that are not present in the representation strings,
    such as SHA1 or the uniquifier.  For example:
@@ -234,6 +270,11 @@ typedef struct fs_fs_shared_txn_data_t
      a non-recursive mutex. */
   svn_boolean_t being_written;
 
+#if APR_HAS_THREADS
+  /* The thread that set BEING_WRITTEN.  Only valid while that is set. */
+  apr_os_thread_t writer;
+#endif
+
   /* The pool in which this object has been allocated; a subpool of the
      common pool. */
   apr_pool_t *pool;
@@ -275,6 +316,20 @@ typedef struct fs_fs_shared_data_t
      txn-current file. */
   svn_mutex__t *txn_current_lock;
 
+  /* Group commit state.  CURRENT_WRITTEN counts the updates of the
+     'current' file made by this process and CURRENT_DURABLE is the
+     number of those known to be on disk.  CURRENT_FLUSHING is set while
+     some thread flushes 'current' on behalf of everybody else.
+
+     All of this is synchronised under GROUP_COMMIT_LOCK, which may be
+     taken while holding any of the locks above but never the other way
+     around.  GROUP_COMMIT_COND gets signalled whenever a flush ends. */
+  svn_mutex__t *group_commit_lock;
+  svn_thread_cond__t *group_commit_cond;
+  apr_uint64_t current_written;
+  apr_uint64_t current_durable;
+  svn_boolean_t current_flushing;
+
   /* The common pool, under which this object is allocated, subpools
      of which are used to allocate the transaction objects. */
   apr_pool_t *common_pool;
@@ -315,7 +370,8 @@ typedef enum compression_type_t
 {
   compression_type_none,
   compression_type_zlib,
-  compression_type_lz4
+  compression_type_lz4,
+  compression_type_zstd
 } compression_type_t;
 
 /* Private (non-shared) FSFS-specific data for each svn_fs_t object.
@@ -347,6 +403,14 @@ typedef struct fs_fs_data_t
    * (not just the one bit that we need, atm). */
   svn_boolean_t use_block_read;
 
+  /* If set, map pack files into memory and read their contents and
+   * indexes directly from the mapping. */
+  svn_boolean_t mmap_pack_files;
+
+  /* Number of blocks following the current one that block_read() asks
+   * the OS to read ahead.  0 disables read-ahead. */
+  apr_int64_t read_ahead_blocks;
+
   /* The revision that was youngest, last time we checked. */
   svn_revnum_t youngest_rev_cache;
 
@@ -360,6 +424,14 @@ typedef struct fs_fs_data_t
      e.g. memcached may be ignored as caching is an optional feature. */
   svn_boolean_t fail_stop;
 
+  /* Maximum size of the on-disk cache file in bytes.  0 disables it. */
+  apr_int64_t persistent_cache_size;
+
+  /* Fulltexts and directories of at least this size in bytes are kept
+     LZ4-compressed in the membuffer cache.  0 disables compression. */
+  apr_size_t fulltext_cache_compression;
+  apr_size_t dir_cache_compression;
+
   /* A cache of revision root IDs, mapping from (svn_revnum_t *) to
      (svn_fs_id_t *).  (Not threadsafe.) */
   svn_cache__t *rev_root_id_cache;
@@ -380,9 +452,17 @@ typedef struct fs_fs_data_t
      rep key (revision/offset) to svn_stringbuf_t. */
   svn_cache__t *fulltext_cache;
 
-  /* The current prefix to be used for revprop cache entries.
-     If this is 0, a new unique prefix must be chosen. */
-  apr_uint64_t revprop_prefix;
+  /* Revprop cache state per shard, indexed by shard number.  Each entry
+     holds the shard's generation and the prefix to be used for its
+     revprop cache entries.  See revprops.c for details. */
+  apr_array_header_t *revprop_shards;
+
+  /* Epoch found in the revprop generations file. */
+  apr_int64_t revprop_epoch;
+
+  /* If FALSE, REVPROP_SHARDS must be synchronized with the revprop
+     generations file before accessing the revprop cache again. */
+  svn_boolean_t revprop_shards_valid;
 
   /* Revision property cache.  Maps from (rev,prefix) to apr_hash_t.
      Unparsed svn_string_t representations of the serialized hash
@@ -409,6 +489,11 @@ typedef struct fs_fs_data_t
      the key is window_cache_key_t */
   svn_cache__t *combined_window_cache;
 
+  /* Cache for svn_fs_fs__txdelta_cached_window_t objects that combine
+     all delta windows of a chunk across the whole delta chain;
+     the key is window_cache_key_t */
+  svn_cache__t *composed_window_cache;
+
   /* Cache for node_revision_t objects; the key is (revision, item_index) */
   svn_cache__t *node_revision_cache;
 
@@ -465,6 +550,22 @@ typedef struct fs_fs_data_t
   /* Thread-safe boolean */
   svn_atomic_t rep_cache_db_opened;
 
+  /* In-memory front-end to REP_CACHE_DB, created on demand.
+     See rep-cache.c. */
+  struct rep_cache_front_t *rep_cache_front;
+
+  /* The sqlite database of the mergeinfo index, see mergeinfo_index.h. */
+  svn_sqlite__db_t *mergeinfo_index_db;
+
+  /* Thread-safe boolean */
+  svn_atomic_t mergeinfo_index_db_opened;
+
+  /* The sqlite database of the lock index, see lock_index.h. */
+  svn_sqlite__db_t *lock_index_db;
+
+  /* Thread-safe boolean */
+  svn_atomic_t lock_index_db_opened;
+
   /* The oldest revision not in a pack file.  It also applies to revprops
    * if revprop packing has been enabled by the FSFS format version. */
   svn_revnum_t min_unpacked_rev;
@@ -473,6 +574,19 @@ typedef struct fs_fs_data_t
    * and allowed by the configuration. */
   svn_boolean_t rep_sharing_allowed;
 
+  /* Path of the filesystem that serves as the shared content store for
+   * a group of repositories, or NULL if none has been configured. */
+  const char *group_store_path;
+
+  /* The filesystem at GROUP_STORE_PATH.  Opened on demand by
+   * svn_fs_fs__get_group_store(). */
+  svn_fs_t *group_store;
+
+  /* Page cache and memory map sizes in bytes for the rep-cache database.
+   * 0 for the SQLite defaults. */
+  apr_int64_t rep_cache_memory_size;
+  apr_int64_t rep_cache_mmap_size;
+
   /* File size limit in bytes up to which multiple revprops shall be packed
    * into a single file. */
   apr_int64_t revprop_pack_size;
@@ -483,9 +597,17 @@ typedef struct fs_fs_data_t
   /* Whether directory nodes shall be deltified just like file nodes. */
   svn_boolean_t deltify_directories;
 
+  /* Directories with at least this many entries will be stored with a
+   * name index and without deltification.  0 disables the index. */
+  apr_int64_t dir_index_min_entries;
+
   /* Whether nodes properties shall be deltified. */
   svn_boolean_t deltify_properties;
 
+  /* Whether file contents shall be stored as deltas.  If not, they get
+   * stored verbatim, which allows servers to send them without decoding. */
+  svn_boolean_t deltify_files;
+
   /* Restart deltification histories after each multiple of this value */
   apr_int64_t max_deltification_walk;
 
@@ -493,18 +615,38 @@ typedef struct fs_fs_data_t
    * deltification history after which skip deltas will be used. */
   apr_int64_t max_linear_deltification;
 
+  /* Whether file deltas shall look for matching source data beyond the
+   * current delta window. */
+  svn_boolean_t track_delta_source;
+
+  /* Whether file contents shall be deltified against the most similar
+   * of several candidate bases instead of the skip-delta base only. */
+  svn_boolean_t similar_delta_bases;
+
   /* Compression type to use with txdelta storage format in new revs. */
   compression_type_t delta_compression_type;
 
-  /* Compression level (currently, only used with compression_type_zlib). */
+  /* Compression level (only used with compression_type_zlib and
+     compression_type_zstd). */
   int delta_compression_level;
 
+  /* Number of threads to compress file contents with (1 = no threads). */
+  int delta_compression_threads;
+
   /* Pack after every commit. */
   svn_boolean_t pack_after_commit;
 
   /* Verify each new revision before commit. */
   svn_boolean_t verify_before_commit;
 
+  /* Append a record for each item read to this file, if not NULL.
+     See access_trace.h. */
+  apr_file_t *access_trace;
+
+  /* Release the write lock before flushing 'current' and let concurrent
+     commits share that flush. */
+  svn_boolean_t group_commit;
+
   /* Per-instance filesystem ID, which provides an additional level of
      uniqueness for filesystems that share the same UUID, but should
      still be distinguishable (e.g. backups produced by svn_fs_hotcopy()
@@ -517,6 +659,22 @@ typedef struct fs_fs_data_t
   /* Pointer to svn_fs_open. */
   svn_error_t *(*svn_fs_open_)(svn_fs_t **, const char *, apr_hash_t *,
                                apr_pool_t *, apr_pool_t *);
+
+  /* I/O statistics of this FS object.  The cache access counts are not
+     tracked here but collected from CACHES on demand. */
+  svn_fs_io_stats_t io_stats;
+
+  /* Read-only revision / pack files that are not in use but kept open
+     for reuse, least recently used first (svn_fs_fs__revision_file_t *).
+     NULL until the first file gets released.  See rev_file.c. */
+  apr_array_header_t *idle_rev_files;
+
+  /* Incremented by svn_fs_fs__rev_file_cache_clear.  Files opened before
+     that will not be kept open after their release. */
+  apr_uint32_t rev_file_cache_epoch;
+
+  /* All svn_cache__t instances created for this FS object. */
+  apr_array_header_t *caches;
 } fs_fs_data_t;
 
 
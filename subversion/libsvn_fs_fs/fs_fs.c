@@ -34,6 +34,7 @@
 #include "svn_sorts.h"
 #include "svn_version.h"
 
+#include "access_trace.h"
 #include "cached_data.h"
 #include "id.h"
 #include "index.h"
@@ -48,6 +49,7 @@
 #include "private/svn_io_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_task.h"
 #include "../libsvn_fs/fs-loader.h"
 
 /* The default maximum number of files per directory to store in the
@@ -73,6 +75,10 @@
    Values < 1 disable deltification. */
 #define SVN_FS_FS_MAX_DELTIFICATION_WALK 1023
 
+/* Upper limit for the number of threads used to compress the contents
+   of a single file. */
+#define SVN_FS_FS_MAX_COMPRESSION_THREADS 64
+
 /* Notes:
 
 To avoid opening and closing the rev-files all the time, it would
@@ -693,7 +699,8 @@ parse_compression_option(compression_type_t *compression_type_p,
   int level;
   svn_boolean_t is_valid = TRUE;
 
-  /* compression = none | lz4 | zlib | zlib-1 ... zlib-9 */
+  /* compression = none | lz4 | zlib | zlib-1 ... zlib-9
+   *               | zstd | zstd-1 ... zstd-19 */
   if (strcmp(value, "none") == 0)
     {
       type = compression_type_none;
@@ -723,6 +730,25 @@ parse_compression_option(compression_type_t *compression_type_p,
       else
         is_valid = FALSE;
     }
+  else if (strncmp(value, "zstd", 4) == 0)
+    {
+      const char *p = value + 4;
+
+      type = compression_type_zstd;
+      if (*p == 0)
+        {
+          level = SVN__ZSTD_DEFAULT_LEVEL;
+        }
+      else if (*p == '-')
+        {
+          p++;
+          SVN_ERR(svn_cstring_atoi(&level, p));
+          if (level < 1 || level > SVN__ZSTD_MAX_LEVEL)
+            is_valid = FALSE;
+        }
+      else
+        is_valid = FALSE;
+    }
   else
     {
       is_valid = FALSE;
@@ -748,6 +774,9 @@ read_config(fs_fs_data_t *ffd,
             apr_pool_t *scratch_pool)
 {
   svn_config_t *config;
+  const char *access_trace_path;
+  const char *group_store_path;
+  apr_int64_t compression_threshold;
 
   SVN_ERR(svn_config_read3(&config,
                            svn_dirent_join(fs_path, PATH_CONFIG, scratch_pool),
@@ -761,6 +790,24 @@ read_config(fs_fs_data_t *ffd,
   else
     ffd->rep_sharing_allowed = FALSE;
 
+  SVN_ERR(svn_config_get_int64(config, &ffd->rep_cache_memory_size,
+                               CONFIG_SECTION_REP_SHARING,
+                               CONFIG_OPTION_REP_CACHE_MEMORY_SIZE, 0));
+  ffd->rep_cache_memory_size = MAX(ffd->rep_cache_memory_size, 0) * 0x100000;
+  SVN_ERR(svn_config_get_int64(config, &ffd->rep_cache_mmap_size,
+                               CONFIG_SECTION_REP_SHARING,
+                               CONFIG_OPTION_REP_CACHE_MMAP_SIZE, 0));
+  ffd->rep_cache_mmap_size = MAX(ffd->rep_cache_mmap_size, 0) * 0x100000;
+
+  /* References into the group store must remain readable even when
+   * rep-sharing gets disabled later on. */
+  svn_config_get(config, &group_store_path, CONFIG_SECTION_REP_SHARING,
+                 CONFIG_OPTION_GROUP_STORE, NULL);
+  ffd->group_store_path = group_store_path && *group_store_path
+                        ? svn_dirent_join(fs_path, group_store_path,
+                                          result_pool)
+                        : NULL;
+
   /* Initialize deltification settings in ffd. */
   if (ffd->format >= SVN_FS_FS__MIN_DELTIFICATION_FORMAT)
     {
@@ -772,6 +819,10 @@ read_config(fs_fs_data_t *ffd,
                                   CONFIG_SECTION_DELTIFICATION,
                                   CONFIG_OPTION_ENABLE_PROPS_DELTIFICATION,
                                   TRUE));
+      SVN_ERR(svn_config_get_bool(config, &ffd->deltify_files,
+                                  CONFIG_SECTION_DELTIFICATION,
+                                  CONFIG_OPTION_ENABLE_FILE_DELTIFICATION,
+                                  TRUE));
       SVN_ERR(svn_config_get_int64(config, &ffd->max_deltification_walk,
                                    CONFIG_SECTION_DELTIFICATION,
                                    CONFIG_OPTION_MAX_DELTIFICATION_WALK,
@@ -780,13 +831,38 @@ read_config(fs_fs_data_t *ffd,
                                    CONFIG_SECTION_DELTIFICATION,
                                    CONFIG_OPTION_MAX_LINEAR_DELTIFICATION,
                                    SVN_FS_FS_MAX_LINEAR_DELTIFICATION));
+      SVN_ERR(svn_config_get_bool(config, &ffd->track_delta_source,
+                                  CONFIG_SECTION_DELTIFICATION,
+                                  CONFIG_OPTION_ENABLE_SOURCE_TRACKING,
+                                  FALSE));
+      SVN_ERR(svn_config_get_bool(config, &ffd->similar_delta_bases,
+                                  CONFIG_SECTION_DELTIFICATION,
+                                  CONFIG_OPTION_ENABLE_SIMILAR_DELTA_BASES,
+                                  FALSE));
     }
   else
     {
       ffd->deltify_directories = FALSE;
       ffd->deltify_properties = FALSE;
+      ffd->deltify_files = TRUE;
       ffd->max_deltification_walk = SVN_FS_FS_MAX_DELTIFICATION_WALK;
       ffd->max_linear_deltification = SVN_FS_FS_MAX_LINEAR_DELTIFICATION;
+      ffd->track_delta_source = FALSE;
+      ffd->similar_delta_bases = FALSE;
+    }
+
+  if (ffd->format >= SVN_FS_FS__MIN_DIR_INDEX_FORMAT)
+    {
+      SVN_ERR(svn_config_get_int64(config, &ffd->dir_index_min_entries,
+                                   CONFIG_SECTION_DELTIFICATION,
+                                   CONFIG_OPTION_DIR_INDEX_MIN_ENTRIES,
+                                   0));
+      if (ffd->dir_index_min_entries < 0)
+        ffd->dir_index_min_entries = 0;
+    }
+  else
+    {
+      ffd->dir_index_min_entries = 0;
     }
 
   /* Initialize revprop packing settings in ffd. */
@@ -825,6 +901,10 @@ read_config(fs_fs_data_t *ffd,
                                    CONFIG_SECTION_IO,
                                    CONFIG_OPTION_P2L_PAGE_SIZE,
                                    0x400));
+      SVN_ERR(svn_config_get_int64(config, &ffd->read_ahead_blocks,
+                                   CONFIG_SECTION_IO,
+                                   CONFIG_OPTION_READ_AHEAD_BLOCKS,
+                                   0));
 
       /* Don't accept unreasonable or illegal values.
        * Block size and P2L page size are in kbytes;
@@ -835,6 +915,14 @@ read_config(fs_fs_data_t *ffd,
                                 CONFIG_OPTION_P2L_PAGE_SIZE, scratch_pool));
       SVN_ERR(verify_block_size(ffd->l2p_page_size, sizeof(apr_off_t),
                                 CONFIG_OPTION_L2P_PAGE_SIZE, scratch_pool));
+      if (ffd->read_ahead_blocks < 0 || ffd->read_ahead_blocks > 0x400)
+        return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                 _("%s is invalid for fsfs.conf setting "
+                                   "'%s'; must be between 0 and 1024."),
+                                 apr_psprintf(scratch_pool,
+                                              "%" APR_INT64_T_FMT,
+                                              ffd->read_ahead_blocks),
+                                 CONFIG_OPTION_READ_AHEAD_BLOCKS);
 
       /* convert kBytes to bytes */
       ffd->block_size *= 0x400;
@@ -847,6 +935,7 @@ read_config(fs_fs_data_t *ffd,
       ffd->block_size = 0x1000; /* Matches default APR file buffer size. */
       ffd->l2p_page_size = 0x2000;    /* Matches above default. */
       ffd->p2l_page_size = 0x100000;  /* Matches above default in bytes. */
+      ffd->read_ahead_blocks = 0;
     }
 
   if (ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
@@ -855,10 +944,15 @@ read_config(fs_fs_data_t *ffd,
                                   CONFIG_SECTION_DEBUG,
                                   CONFIG_OPTION_PACK_AFTER_COMMIT,
                                   FALSE));
+      SVN_ERR(svn_config_get_bool(config, &ffd->mmap_pack_files,
+                                  CONFIG_SECTION_IO,
+                                  CONFIG_OPTION_MMAP_PACK_FILES,
+                                  FALSE));
     }
   else
     {
       ffd->pack_after_commit = FALSE;
+      ffd->mmap_pack_files = FALSE;
     }
 
   /* Initialize compression settings in ffd. */
@@ -891,6 +985,18 @@ read_config(fs_fs_data_t *ffd,
                                       _("Compression type 'lz4' requires "
                                         "filesystem format 8 or higher"));
             }
+          if (ffd->delta_compression_type == compression_type_zstd)
+            {
+              if (ffd->format < SVN_FS_FS__MIN_SVNDIFF3_FORMAT)
+                return svn_error_create(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                        _("Compression type 'zstd' requires "
+                                          "filesystem format 9 or higher"));
+              if (!svn_zstd__is_available())
+                return svn_error_create(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                                        _("Compression type 'zstd' is not "
+                                          "supported by this build of "
+                                          "Subversion"));
+            }
         }
       else if (compression_level_val)
         {
@@ -926,6 +1032,26 @@ read_config(fs_fs_data_t *ffd,
       ffd->delta_compression_level = SVN_DELTA_COMPRESSION_LEVEL_NONE;
     }
 
+  if (ffd->delta_compression_type != compression_type_none)
+    {
+      apr_int64_t compression_threads;
+      SVN_ERR(svn_config_get_int64(config, &compression_threads,
+                                   CONFIG_SECTION_DELTIFICATION,
+                                   CONFIG_OPTION_COMPRESSION_THREADS, 1));
+      ffd->delta_compression_threads
+        = (int)MIN(MAX(1, compression_threads),
+                   SVN_FS_FS_MAX_COMPRESSION_THREADS);
+    }
+  else
+    {
+      ffd->delta_compression_threads = 1;
+    }
+
+  SVN_ERR(svn_config_get_bool(config, &ffd->group_commit,
+                              CONFIG_SECTION_IO,
+                              CONFIG_OPTION_GROUP_COMMIT,
+                              FALSE));
+
 #ifdef SVN_DEBUG
   SVN_ERR(svn_config_get_bool(config, &ffd->verify_before_commit,
                               CONFIG_SECTION_DEBUG,
@@ -938,14 +1064,55 @@ read_config(fs_fs_data_t *ffd,
                               FALSE));
 #endif
 
+  svn_config_get(config, &access_trace_path, CONFIG_SECTION_DEBUG,
+                 CONFIG_OPTION_ACCESS_TRACE, NULL);
+  if (access_trace_path && *access_trace_path)
+    SVN_ERR(svn_fs_fs__access_trace_open(&ffd->access_trace,
+                                         svn_dirent_join(fs_path,
+                                                         access_trace_path,
+                                                         scratch_pool),
+                                         result_pool, scratch_pool));
+  else
+    ffd->access_trace = NULL;
+
   /* memcached configuration */
   SVN_ERR(svn_cache__make_memcache_from_config(&ffd->memcache, config,
                                                result_pool, scratch_pool));
+  if (ffd->memcache)
+    {
+      svn_boolean_t async_writes;
+      SVN_ERR(svn_config_get_bool(config, &async_writes,
+                                  CONFIG_SECTION_CACHES,
+                                  CONFIG_OPTION_MEMCACHED_ASYNC_WRITES,
+                                  FALSE));
+      if (async_writes)
+        SVN_ERR(svn_cache__memcache_enable_async_writes(ffd->memcache));
+    }
 
   SVN_ERR(svn_config_get_bool(config, &ffd->fail_stop,
                               CONFIG_SECTION_CACHES, CONFIG_OPTION_FAIL_STOP,
                               FALSE));
 
+  SVN_ERR(svn_config_get_int64(config, &ffd->persistent_cache_size,
+                               CONFIG_SECTION_CACHES,
+                               CONFIG_OPTION_PERSISTENT_CACHE_SIZE,
+                               0));
+  ffd->persistent_cache_size = MAX(ffd->persistent_cache_size, 0) * 0x100000;
+
+  SVN_ERR(svn_config_get_int64(config, &compression_threshold,
+                               CONFIG_SECTION_CACHES,
+                               CONFIG_OPTION_FULLTEXT_CACHE_COMPRESSION,
+                               0));
+  ffd->fulltext_cache_compression
+    = (apr_size_t)MIN(MAX(compression_threshold, 0), 0x100000) * 0x400;
+
+  SVN_ERR(svn_config_get_int64(config, &compression_threshold,
+                               CONFIG_SECTION_CACHES,
+                               CONFIG_OPTION_DIR_CACHE_COMPRESSION,
+                               0));
+  ffd->dir_cache_compression
+    = (apr_size_t)MIN(MAX(compression_threshold, 0), 0x100000) * 0x400;
+
   return SVN_NO_ERROR;
 }
 
@@ -978,6 +1145,25 @@ write_config(svn_fs_t *fs,
 "### configured (and ignoring it with file:// access).  To make"             NL
 "### Subversion never ignore cache errors, uncomment this line."             NL
 "# " CONFIG_OPTION_FAIL_STOP " = true"                                       NL
+"### Parsed node revisions, changed path lists and text deltas may also be"  NL
+"### kept in a file that survives server restarts, so that a restarted"      NL
+"### server does not have to read all of them from the revision files"       NL
+"### again.  The following parameter sets the maximum size of that file in"  NL
+"### MB.  It will stop growing when that limit is reached.  Delete the"      NL
+"### file at 'db/persistent-cache' to reset it.  Disabled by default."       NL
+"# " CONFIG_OPTION_PERSISTENT_CACHE_SIZE " = 0"                              NL
+"### Writes to the memcached servers configured above normally wait for"     NL
+"### the servers to reply.  Uncomment the following line to send them from"  NL
+"### a background thread instead.  Writes that cannot be sent quickly"       NL
+"### enough will then be dropped, causing some additional cache misses."     NL
+"# " CONFIG_OPTION_MEMCACHED_ASYNC_WRITES " = true"                          NL
+"### Fulltexts and directories can be kept LZ4-compressed in the in-memory"  NL
+"### cache, so that more of them fit into it at the expense of some CPU"     NL
+"### time on every access.  The following parameters set the minimum size"   NL
+"### in kB from which on items get compressed.  Items that don't compress"   NL
+"### well are stored uncompressed.  0 disables compression (default)."       NL
+"# " CONFIG_OPTION_FULLTEXT_CACHE_COMPRESSION " = 0"                         NL
+"# " CONFIG_OPTION_DIR_CACHE_COMPRESSION " = 0"                              NL
 ""                                                                           NL
 "[" CONFIG_SECTION_REP_SHARING "]"                                           NL
 "### To conserve space, the filesystem can optionally avoid storing"         NL
@@ -994,6 +1180,28 @@ write_config(svn_fs_t *fs,
 "### 'svnadmin verify' will check the rep-cache regardless of this setting." NL
 "### rep-sharing is enabled by default."                                     NL
 "# " CONFIG_OPTION_ENABLE_REP_SHARING " = true"                              NL
+"###"                                                                        NL
+"### The following parameters set how many MB of the rep-cache database"     NL
+"### SQLite keeps in memory and how many MB of it are accessed through a"    NL
+"### memory map instead of file reads.  Large repositories with a large"     NL
+"### rep-cache.db may commit faster when they can hold all of it in"         NL
+"### memory.  By default, the SQLite defaults of a few MB are used."         NL
+"# " CONFIG_OPTION_REP_CACHE_MEMORY_SIZE " = 0"                              NL
+"# " CONFIG_OPTION_REP_CACHE_MMAP_SIZE " = 0"                                NL
+"###"                                                                        NL
+"### Repositories hosted side by side often contain the same files, e.g."    NL
+"### vendor drops or copied third-party trees.  The following parameter"     NL
+"### names the filesystem directory ('db') of another FSFS repository that"  NL
+"### serves as a shared content store for a group of repositories."          NL
+"### Relative paths are relative to this filesystem's directory.  When a"    NL
+"### commit adds contents that the rep-cache of the group store already"     NL
+"### knows, only a small reference to the group store gets written.  The"    NL
+"### group store must never be removed, replaced or reloaded as long as"     NL
+"### any repository refers to it, and it must have rep-sharing enabled."     NL
+"### Fill it by committing or loading the shared contents into it."          NL
+"### Older versions of Subversion can't read such references."               NL
+"### No group store is used by default."                                     NL
+"# " CONFIG_OPTION_GROUP_STORE " = ../../group-store/db"                     NL
 ""                                                                           NL
 "[" CONFIG_SECTION_DELTIFICATION "]"                                         NL
 "### To conserve space, the filesystem stores data as differences against"   NL
@@ -1017,6 +1225,18 @@ write_config(svn_fs_t *fs,
 "### directory deltification is enabled by default."                         NL
 "# " CONFIG_OPTION_ENABLE_DIR_DELTIFICATION " = true"                        NL
 "###"                                                                        NL
+"### Looking up a single entry in a directory that is not in the cache"      NL
+"### requires the whole directory to be read and parsed.  For directories"   NL
+"### with very many entries, this may dominate the cost of e.g. 'svn info'." NL
+"### Directories with at least the following number of entries will be"      NL
+"### stored with a name index and without deltification, such that single"  NL
+"### entries can be found with only a few small reads.  This trades disk"    NL
+"### space for lookup speed because each change to such a directory stores" NL
+"### a full copy of it.  Values of 10000 or more are recommended.  This"     NL
+"### option requires format 9 repositories.  The default is 0, i.e."         NL
+"### directories are not indexed."                                           NL
+"# " CONFIG_OPTION_DIR_INDEX_MIN_ENTRIES " = 0"                              NL
+"###"                                                                        NL
 "### The following parameter enables deltification for properties on files"  NL
 "### and directories.  Overall, this is a minor tuning option but can save"  NL
 "### some disk space if you merge frequently or frequently change node"      NL
@@ -1025,6 +1245,14 @@ write_config(svn_fs_t *fs,
 "### property deltification is enabled by default."                          NL
 "# " CONFIG_OPTION_ENABLE_PROPS_DELTIFICATION " = true"                      NL
 "###"                                                                        NL
+"### The following parameter enables deltification and compression of file"  NL
+"### contents.  If disabled, file contents get stored verbatim.  This costs" NL
+"### a lot of disk space but allows svnserve to send large files straight"   NL
+"### from the repository, without any decoding or copying.  Consider this"   NL
+"### only for repositories of large, incompressible files that rarely"       NL
+"### change.  file deltification is enabled by default."                     NL
+"# " CONFIG_OPTION_ENABLE_FILE_DELTIFICATION " = true"                       NL
+"###"                                                                        NL
 "### During commit, the server may need to walk the whole change history of" NL
 "### of a given node to find a suitable deltification base.  This linear"    NL
 "### process can impact commit times, svnadmin load and similar operations." NL
@@ -1056,22 +1284,52 @@ write_config(svn_fs_t *fs,
 "### For 1.8, the default value is 16; earlier versions use 1."              NL
 "# " CONFIG_OPTION_MAX_LINEAR_DELTIFICATION " = 16"                          NL
 "###"                                                                        NL
+"### Normally, a file is deltified in windows of 100 kB and every window"    NL
+"### is compared only to the data at the same offset in the delta base."     NL
+"### If data gets inserted into or removed from a large file, most of the"   NL
+"### remaining data will not be found and the delta becomes large.  With"    NL
+"### this option enabled, every window will be compared to the part of"      NL
+"### the delta base it most likely originates from, as long as it is in"     NL
+"### range of a few MB.  That greatly reduces the size of deltas of large"   NL
+"### binaries but requires an extra 10 MB of memory per commit."             NL
+"### The deltas can be read by all Subversion versions."                     NL
+"### The default is false."                                                  NL
+"# " CONFIG_OPTION_ENABLE_SOURCE_TRACKING " = false"                         NL
+"###"                                                                        NL
+"### Files that alternate between a few variants, e.g. generated sources"    NL
+"### or assets that differ between branches, often get large deltas"         NL
+"### because the skip-delta base is the wrong variant.  With this option"    NL
+"### enabled, commits compare the new contents to a few recent versions"     NL
+"### of the file using cheap fingerprints and store the delta against the"   NL
+"### most similar one if that delta turns out to be smaller.  This costs"    NL
+"### reading those versions during the commit.  The limits set by"           NL
+"### max-deltification-walk and the maximum delta chain length still"        NL
+"### apply.  The deltas can be read by all Subversion versions."             NL
+"### The default is false."                                                  NL
+"# " CONFIG_OPTION_ENABLE_SIMILAR_DELTA_BASES " = false"                     NL
+"###"                                                                        NL
 "### After deltification, we compress the data to minimize on-disk size."    NL
 "### This setting controls the compression algorithm, which will be used in" NL
 "### future revisions.  It can be used to either disable compression or to"  NL
-"### select between available algorithms (zlib, lz4).  zlib is a general-"   NL
-"### purpose compression algorithm.  lz4 is a fast compression algorithm"    NL
-"### which should be preferred for repositories with large and, possibly,"   NL
-"### incompressible files.  Note that the compression ratio of lz4 is"       NL
-"### usually lower than the one provided by zlib, but using it can"          NL
+"### select between available algorithms (zlib, lz4, zstd).  zlib is a"      NL
+"### general-purpose compression algorithm.  lz4 is a fast compression"      NL
+"### algorithm which should be preferred for repositories with large and,"   NL
+"### possibly, incompressible files.  Note that the compression ratio of"    NL
+"### lz4 is usually lower than the one provided by zlib, but using it can"   NL
 "### significantly speed up commits as well as reading the data."            NL
 "### lz4 compression algorithm is supported, starting from format 8"         NL
 "### repositories, available in Subversion 1.10 and higher."                 NL
+"### zstd (Zstandard) decompresses almost as fast as lz4 while achieving"    NL
+"### compression ratios similar to or better than zlib.  It is supported,"   NL
+"### starting from format 9 repositories, available in Subversion 1.15 and"  NL
+"### higher, if Subversion has been built with Zstandard support."           NL
 "### The syntax of this option is:"                                          NL
 "###   " CONFIG_OPTION_COMPRESSION " = none | lz4 | zlib | zlib-1 ... zlib-9" NL
+"###                 | zstd | zstd-1 ... zstd-19"                            NL
 "### Versions prior to Subversion 1.10 will ignore this option."             NL
 "### The default value is 'lz4' if supported by the repository format and"   NL
-"### 'zlib' otherwise.  'zlib' is currently equivalent to 'zlib-5'."         NL
+"### 'zlib' otherwise.  'zlib' is currently equivalent to 'zlib-5' and"      NL
+"### 'zstd' is equivalent to 'zstd-3'."                                      NL
 "# " CONFIG_OPTION_COMPRESSION " = lz4"                                      NL
 "###"                                                                        NL
 "### DEPRECATED: The new '" CONFIG_OPTION_COMPRESSION "' option deprecates previously used" NL
@@ -1080,6 +1338,13 @@ write_config(svn_fs_t *fs,
 "### still be used (and it will result in zlib compression with the"         NL
 "### corresponding compression level)."                                      NL
 "###   " CONFIG_OPTION_COMPRESSION_LEVEL " = 0 ... 9 (default is 5)"         NL
+"###"                                                                        NL
+"### When committing large files, compression may take considerably longer"  NL
+"### than all other processing.  This parameter sets the number of threads"  NL
+"### that compress the delta windows of a single file concurrently.  The"    NL
+"### stored data is the same, regardless of this setting.  The default of"   NL
+"### 1 compresses in the thread that processes the commit."                  NL
+"# " CONFIG_OPTION_COMPRESSION_THREADS " = 1"                                NL
 ""                                                                           NL
 "[" CONFIG_SECTION_PACKED_REVPROPS "]"                                       NL
 "### This parameter controls the size (in kBytes) of packed revprop files."  NL
@@ -1148,6 +1413,38 @@ write_config(svn_fs_t *fs,
 "### Must be a power of 2."                                                  NL
 "### p2l-page-size is given in kBytes and with a default of 1024 kBytes."    NL
 "# " CONFIG_OPTION_P2L_PAGE_SIZE " = 1024"                                   NL
+"###"                                                                        NL
+"### Pack files never change once they have been written.  Enabling this"    NL
+"### option maps them into memory and reads their contents and indexes"      NL
+"### directly from the mapping, saving system calls and data copies when"    NL
+"### the pack files are in the OS file cache.  Non-packed revisions are"     NL
+"### always read through regular file I/O.  Do not enable this for"          NL
+"### repositories on network file systems, where accessing a mapping may"    NL
+"### crash the process if the server becomes unavailable."                   NL
+"### This is disabled by default."                                           NL
+"# " CONFIG_OPTION_MMAP_PACK_FILES " = false"                                NL
+"###"                                                                        NL
+"### When reading a block of data from a revision or pack file on a cache"   NL
+"### miss, FSFS may ask the operating system to load the following blocks"   NL
+"### into its file cache in the background.  This speeds up long sequential" NL
+"### reads such as 'svn export' or 'svn log -v' on cold disks."              NL
+"### read-ahead-blocks is the number of blocks to request ahead of the"      NL
+"### current one.  This is only supported on systems that provide"           NL
+"### posix_fadvise().  The default is 0, i.e. no read-ahead."                NL
+"# " CONFIG_OPTION_READ_AHEAD_BLOCKS " = 0"                                  NL
+"###"                                                                        NL
+"### Every commit normally flushes the 'current' file to disk before it"    NL
+"### releases the repository write lock.  With group-commit enabled, the"   NL
+"### write lock is released right after 'current' has been updated and"     NL
+"### commits that queue up in the meantime get their revision numbers"      NL
+"### while that flush is still in progress.  A single flush of 'current'"   NL
+"### then makes a whole group of commits durable.  This can increase the"   NL
+"### throughput of servers that receive many small commits at once."        NL
+"### A commit still returns only after its revision is on disk.  However,"  NL
+"### other clients may see a new revision a moment before that and a"       NL
+"### system crash may then roll back to the preceding revision."            NL
+"### This is disabled by default."                                           NL
+"# " CONFIG_OPTION_GROUP_COMMIT " = false"                                   NL
 ""                                                                           NL
 "[" CONFIG_SECTION_DEBUG "]"                                                 NL
 "###"                                                                        NL
@@ -1155,6 +1452,14 @@ write_config(svn_fs_t *fs,
 "### the commit.  This is disabled by default except in maintainer-mode"     NL
 "### builds."                                                                NL
 "# " CONFIG_OPTION_VERIFY_BEFORE_COMMIT " = false"                           NL
+"###"                                                                        NL
+"### If set, append a record for every node revision, changed paths list"   NL
+"### and representation read from the repository to the file given here."  NL
+"### Relative paths are relative to the 'db' directory.  The trace can be"  NL
+"### replayed with 'svnfsfs replay-trace' against a copy of the"            NL
+"### repository with different cache and block sizes.  Tracing slows down"  NL
+"### all reads and is disabled by default."                                  NL
+"# " CONFIG_OPTION_ACCESS_TRACE " = access-trace"                            NL
 ;
 #undef NL
   return svn_io_file_create(svn_dirent_join(fs->path, PATH_CONFIG, pool),
@@ -1952,6 +2257,13 @@ svn_fs_fs__create(svn_fs_t *fs,
           case 9: format = 7;
                   break;
 
+          case 10:
+          case 11:
+          case 12:
+          case 13:
+          case 14: format = 8;
+                   break;
+
           default:format = SVN_FS_FS__FORMAT_NUMBER;
         }
 
@@ -2323,8 +2635,11 @@ svn_fs_fs__info_format(int *fs_format,
     case 8:
       (*supports_version)->minor = 10;
       break;
+    case 9:
+      (*supports_version)->minor = 15;
+      break;
 #ifdef SVN_DEBUG
-# if SVN_FS_FS__FORMAT_NUMBER != 8
+# if SVN_FS_FS__FORMAT_NUMBER != 9
 #  error "Need to add a 'case' statement here"
 # endif
 #endif
@@ -2368,11 +2683,12 @@ ensure_representation_sha1(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
-/* Recursively index (in the rep-cache) the filesystem node with the
- * given ID, located in revision REV and its matching REV_FILE (if the
- * node ID cannot be found in this revision, do nothing).
- * Compute the SHA1 checksum of the node's representation and add
- * a corresponding entry to the repository's rep-cache.
+/* Recursively index the filesystem node with the given ID, located in
+ * revision REV and its matching REV_FILE (if the node ID cannot be found
+ * in this revision, do nothing).
+ * Compute the SHA1 checksum of the node's representation and append
+ * a copy of it, allocated in the pool of REPS, to the representation_t *
+ * array REPS for the repository's rep-cache.
  * If the node represents a directory this function will recurse and
  * index all children of this directory as well. */
 static svn_error_t *
@@ -2380,6 +2696,7 @@ reindex_node(svn_fs_t *fs,
              const svn_fs_id_t *id,
              svn_revnum_t rev,
              svn_fs_fs__revision_file_t *rev_file,
+             apr_array_header_t *reps,
              svn_cancel_func_t cancel_func,
              void *cancel_baton,
              apr_pool_t *pool)
@@ -2427,7 +2744,7 @@ reindex_node(svn_fs_t *fs,
 
               dirent = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
 
-              SVN_ERR(reindex_node(fs, dirent->id, rev, rev_file,
+              SVN_ERR(reindex_node(fs, dirent->id, rev, rev_file, reps,
                                    cancel_func, cancel_baton, iterpool));
             }
           svn_pool_destroy(iterpool);
@@ -2438,15 +2755,215 @@ reindex_node(svn_fs_t *fs,
       noderev->kind == svn_node_file)
     {
       SVN_ERR(ensure_representation_sha1(fs, noderev->data_rep, pool));
-      SVN_ERR(svn_fs_fs__set_rep_reference(fs, noderev->data_rep, pool));
+      APR_ARRAY_PUSH(reps, representation_t *)
+        = svn_fs_fs__rep_copy(noderev->data_rep, reps->pool);
     }
 
   if (noderev->prop_rep && noderev->prop_rep->revision == rev)
     {
       SVN_ERR(ensure_representation_sha1(fs, noderev->prop_rep, pool));
-      SVN_ERR(svn_fs_fs__set_rep_reference(fs, noderev->prop_rep, pool));
+      APR_ARRAY_PUSH(reps, representation_t *)
+        = svn_fs_fs__rep_copy(noderev->prop_rep, reps->pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* State shared by all tasks of a svn_fs_fs__build_rep_cache() run.
+ * Only the output function, i.e. the main thread, may modify it. */
+typedef struct build_rep_cache_baton_t
+{
+  /* The filesystem whose rep-cache gets written. */
+  svn_fs_t *fs;
+
+  /* Number of worker threads. */
+  int jobs;
+
+  svn_fs_progress_notify_func_t progress_func;
+  void *progress_baton;
+} build_rep_cache_baton_t;
+
+/* Process baton of a task indexing the revisions START to END
+ * (inclusive) for the run described by BB. */
+typedef struct build_rep_cache_range_t
+{
+  build_rep_cache_baton_t *bb;
+  svn_revnum_t start;
+  svn_revnum_t end;
+} build_rep_cache_range_t;
+
+/* Result of indexing the revisions START to END (inclusive). */
+typedef struct build_rep_cache_result_t
+{
+  svn_revnum_t start;
+  svn_revnum_t end;
+
+  /* All representations created in these revisions, in revision order,
+   * as representation_t *. */
+  apr_array_header_t *reps;
+} build_rep_cache_result_t;
+
+/* Implements svn_task__thread_context_constructor_t.  The thread context
+ * is the svn_fs_t instance to read from.  CONTEXT_BATON is the
+ * build_rep_cache_baton_t *.
+ */
+static svn_error_t *
+build_rep_cache_context_constructor(void **thread_context,
+                                    void *context_baton,
+                                    apr_pool_t *result_pool,
+                                    apr_pool_t *scratch_pool)
+{
+  build_rep_cache_baton_t *bb = context_baton;
+  svn_fs_t *fs = bb->fs;
+
+  /* Worker threads must not share the svn_fs_t with the main thread. */
+  if (bb->jobs > 1)
+    SVN_ERR(svn_fs_fs__open_instance(&fs, bb->fs, result_pool,
+                                     scratch_pool));
+
+  *thread_context = fs;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  PROCESS_BATON is a
+ * build_rep_cache_range_t and THREAD_CONTEXT the svn_fs_t to read from.
+ *
+ * Return the representations created in the range in a
+ * build_rep_cache_result_t.  This is where the SHA1 sums get calculated,
+ * i.e. the bulk of the work happens.
+ */
+static svn_error_t *
+build_rep_cache_process(void **result,
+                        svn_task__t *task,
+                        void *thread_context,
+                        void *process_baton,
+                        svn_cancel_func_t cancel_func,
+                        void *cancel_baton,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  const build_rep_cache_range_t *range = process_baton;
+  svn_fs_t *fs = thread_context;
+  build_rep_cache_result_t *range_result
+    = apr_pcalloc(result_pool, sizeof(*range_result));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t rev;
+
+  range_result->start = range->start;
+  range_result->end = range->end;
+  range_result->reps = apr_array_make(result_pool, 64,
+                                      sizeof(representation_t *));
+
+  for (rev = range->start; rev <= range->end; rev++)
+    {
+      svn_fs_id_t *root_id;
+      svn_fs_fs__revision_file_t *file;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&file, fs, rev,
+                                               iterpool, iterpool));
+      SVN_ERR(svn_fs_fs__rev_get_root(&root_id, fs, rev, iterpool, iterpool));
+      SVN_ERR(reindex_node(fs, root_id, rev, file, range_result->reps,
+                           cancel_func, cancel_baton, iterpool));
+      SVN_ERR(svn_fs_fs__close_revision_file(file));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  *result = range_result;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  RESULT is the
+ * build_rep_cache_result_t produced by build_rep_cache_process and
+ * OUTPUT_BATON the build_rep_cache_baton_t *.  Since this gets called in
+ * revision order, the rep-cache ends up with the same entries as a
+ * sequential run would write.
+ */
+static svn_error_t *
+build_rep_cache_output(svn_task__t *task,
+                       void *result,
+                       void *output_baton,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  build_rep_cache_baton_t *bb = output_baton;
+  fs_fs_data_t *ffd = bb->fs->fsap_data;
+  const build_rep_cache_result_t *range_result = result;
+  const apr_array_header_t *reps = range_result->reps;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_revnum_t rev;
+  int i;
+
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  /* One transaction for the whole range. */
+  SVN_ERR(svn_sqlite__begin_transaction(ffd->rep_cache_db));
+  for (i = 0; i < reps->nelts && !err; i++)
+    {
+      representation_t *rep = APR_ARRAY_IDX(reps, i, representation_t *);
+
+      svn_pool_clear(iterpool);
+      err = svn_fs_fs__set_rep_reference(bb->fs, rep, iterpool);
+    }
+  SVN_ERR(svn_sqlite__finish_transaction(ffd->rep_cache_db, err));
+
+  if (bb->progress_func)
+    for (rev = range_result->start; rev <= range_result->end; rev++)
+      {
+        svn_pool_clear(iterpool);
+        bb->progress_func(rev, bb->progress_baton, iterpool);
+      }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  PROCESS_BATON is the
+ * build_rep_cache_range_t covering all revisions to index.
+ *
+ * Split it into shards (or runs of 1000 revisions in unsharded
+ * repositories) and add a sub-task for each of them.
+ */
+static svn_error_t *
+build_rep_cache_root_process(void **result,
+                             svn_task__t *task,
+                             void *thread_context,
+                             void *process_baton,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  const build_rep_cache_range_t *all = process_baton;
+  fs_fs_data_t *ffd = all->bb->fs->fsap_data;
+  int step = ffd->max_files_per_dir ? ffd->max_files_per_dir : 1000;
+  svn_revnum_t start, end;
+
+  for (start = all->start; start <= all->end; start = end + 1)
+    {
+      apr_pool_t *process_pool = svn_task__create_process_pool(task);
+      build_rep_cache_range_t *range
+        = apr_pcalloc(process_pool, sizeof(*range));
+
+      end = MIN(all->end, start - start % step + step - 1);
+
+      range->bb = all->bb;
+      range->start = start;
+      range->end = end;
+
+      SVN_ERR(svn_task__add(task, process_pool, NULL,
+                            build_rep_cache_process, range,
+                            build_rep_cache_output, all->bb));
     }
 
+  *result = NULL;
   return SVN_NO_ERROR;
 }
 
@@ -2454,6 +2971,8 @@ svn_error_t *
 svn_fs_fs__build_rep_cache(svn_fs_t *fs,
                            svn_revnum_t start_rev,
                            svn_revnum_t end_rev,
+                           int jobs,
+                           svn_boolean_t incremental,
                            svn_fs_progress_notify_func_t progress_func,
                            void *progress_baton,
                            svn_cancel_func_t cancel_func,
@@ -2461,8 +2980,9 @@ svn_fs_fs__build_rep_cache(svn_fs_t *fs,
                            apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  apr_pool_t *iterpool;
-  svn_revnum_t rev;
+  build_rep_cache_baton_t bb = { 0 };
+  build_rep_cache_range_t all;
+  apr_pool_t *task_pool;
 
   if (ffd->format < SVN_FS_FS__MIN_REP_SHARING_FORMAT)
     {
@@ -2486,39 +3006,44 @@ svn_fs_fs__build_rep_cache(svn_fs_t *fs,
   if (end_rev == SVN_INVALID_REVNUM)
     SVN_ERR(svn_fs_fs__youngest_rev(&end_rev, fs, pool));
 
-  /* Do nothing for empty FS. */
-  if (start_rev > end_rev)
-    {
-      return SVN_NO_ERROR;
-    }
-
   if (!ffd->rep_cache_db)
     SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
 
-  iterpool = svn_pool_create(pool);
-  for (rev = start_rev; rev <= end_rev; rev++)
+  /* Continue after the youngest revision already in the rep-cache. */
+  if (incremental)
     {
-      svn_fs_id_t *root_id;
-      svn_fs_fs__revision_file_t *file;
-      svn_error_t *err;
-
-      svn_pool_clear(iterpool);
-
-      if (progress_func)
-        progress_func(rev, progress_baton, iterpool);
-
-      SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&file, fs, rev,
-                                               iterpool, iterpool));
-      SVN_ERR(svn_fs_fs__rev_get_root(&root_id, fs, rev, iterpool, iterpool));
+      svn_revnum_t max_rev;
 
-      SVN_ERR(svn_sqlite__begin_transaction(ffd->rep_cache_db));
-      err = reindex_node(fs, root_id, rev, file, cancel_func, cancel_baton, iterpool);
-      SVN_ERR(svn_sqlite__finish_transaction(ffd->rep_cache_db, err));
+      SVN_ERR(svn_fs_fs__get_rep_cache_max_rev(&max_rev, fs, pool));
+      if (SVN_IS_VALID_REVNUM(max_rev) && max_rev >= start_rev)
+        start_rev = max_rev + 1;
+    }
 
-      SVN_ERR(svn_fs_fs__close_revision_file(file));
+  /* Do nothing for empty FS. */
+  if (start_rev > end_rev)
+    {
+      return SVN_NO_ERROR;
     }
 
-  svn_pool_destroy(iterpool);
+  bb.fs = fs;
+  bb.jobs = MAX(jobs, 1);
+  bb.progress_func = progress_func;
+  bb.progress_baton = progress_baton;
+
+  all.bb = &bb;
+  all.start = start_rev;
+  all.end = end_rev;
+
+  /* Workers compute the SHA1 sums of whole shards while the main thread
+   * writes the results to the rep-cache, one transaction per shard. */
+  task_pool = svn_pool_create(pool);
+  SVN_ERR(svn_task__run(bb.jobs,
+                        build_rep_cache_root_process, &all,
+                        NULL, NULL,
+                        build_rep_cache_context_constructor, &bb,
+                        cancel_func, cancel_baton,
+                        pool, task_pool));
+  svn_pool_destroy(task_pool);
 
   return SVN_NO_ERROR;
 }
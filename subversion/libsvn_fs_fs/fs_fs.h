@@ -48,6 +48,31 @@ svn_error_t *svn_fs_fs__initialize_shared_data(svn_fs_t *fs,
                                                apr_pool_t *pool,
                                                apr_pool_t *common_pool);
 
+/* Return in *NEW_FS a new FSFS filesystem object that uses the same
+   configuration and warning callback as FS but has not been opened or
+   created yet.  Allocate it in RESULT_POOL. */
+svn_error_t *svn_fs_fs__new_instance(svn_fs_t **new_fs,
+                                     svn_fs_t *fs,
+                                     apr_pool_t *result_pool);
+
+/* Open another instance of the already open filesystem FS and return it
+   in *NEW_FS, allocated in RESULT_POOL.  The new instance uses the same
+   configuration and shares the process-wide data (locks etc.) with FS but
+   has its own caches and file handles.  Therefore, it may be used in a
+   different thread than FS.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *svn_fs_fs__open_instance(svn_fs_t **new_fs,
+                                      svn_fs_t *fs,
+                                      apr_pool_t *result_pool,
+                                      apr_pool_t *scratch_pool);
+
+/* Return the group store configured for filesystem FS in *GROUP_STORE,
+   opening it on first use, or NULL if FS has no group store.  The group
+   store lives as long as FS and is only ever read from.  Use SCRATCH_POOL
+   for temporary allocations. */
+svn_error_t *svn_fs_fs__get_group_store(svn_fs_t **group_store,
+                                        svn_fs_t *fs,
+                                        apr_pool_t *scratch_pool);
+
 /* Upgrade the fsfs filesystem FS.  Indicate progress via the optional
  * NOTIFY_FUNC callback using NOTIFY_BATON.  The optional CANCEL_FUNC
  * will periodically be called with CANCEL_BATON to allow for preemption.
@@ -307,6 +332,11 @@ svn_fs_fs__reset_txn_caches(svn_fs_t *fs);
 /* Scan all contents of the repository FS and return statistics in *STATS,
  * allocated in RESULT_POOL.  Report progress through PROGRESS_FUNC with
  * PROGRESS_BATON, if PROGRESS_FUNC is not NULL.
+ *
+ * Scan up to JOBS shards concurrently.  If SAMPLE is larger than 1, scan
+ * only every SAMPLE-th shard and extrapolate the results to the whole
+ * repository.  Values of 0 for either are treated as 1.
+ *
  * Use SCRATCH_POOL for temporary allocations.
  */
 svn_error_t *
@@ -314,6 +344,8 @@ svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
                      svn_fs_t *fs,
                      svn_fs_progress_notify_func_t progress_func,
                      void *progress_baton,
+                     int jobs,
+                     int sample,
                      svn_cancel_func_t cancel_func,
                      void *cancel_baton,
                      apr_pool_t *result_pool,
@@ -360,6 +392,11 @@ svn_fs_fs__revision_size(apr_off_t *rev_size,
  * in revisions START_REV through END_REV inclusive. If START_REV is
  * SVN_INVALID_REVNUM, start at revision 1; if END_REV is SVN_INVALID_REVNUM,
  * end at the head revision. If the rep-cache does not exist, then create it.
+ * If INCREMENTAL is TRUE, skip the revisions up to the youngest one already
+ * referenced by the rep-cache.
+ *
+ * Read up to JOBS shards concurrently.  The entries of each shard get
+ * written in a single SQLite transaction.
  *
  * Indicate progress via the optional PROGRESS_FUNC callback using
  * PROGRESS_BATON. The optional CANCEL_FUNC will periodically be called with
@@ -369,6 +406,8 @@ svn_error_t *
 svn_fs_fs__build_rep_cache(svn_fs_t *fs,
                            svn_revnum_t start_rev,
                            svn_revnum_t end_rev,
+                           int jobs,
+                           svn_boolean_t incremental,
                            svn_fs_progress_notify_func_t progress_func,
                            void *progress_baton,
                            svn_cancel_func_t cancel_func,
@@ -22,10 +22,16 @@
 #include "svn_pools.h"
 #include "svn_path.h"
 #include "svn_dirent_uri.h"
+#include "svn_sorts.h"
+
+#include "private/svn_sorts_private.h"
+#include "private/svn_task.h"
 
 #include "fs_fs.h"
 #include "hotcopy.h"
 #include "util.h"
+#include "index.h"
+#include "pack.h"
 #include "recovery.h"
 #include "revprops.h"
 #include "rep-cache.h"
@@ -279,15 +285,17 @@ hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
 
 /* Copy a packed shard containing revision REV, and which contains
  * MAX_FILES_PER_DIR revisions, from SRC_FS to DST_FS.
- * Update *DST_MIN_UNPACKED_REV in case the shard is new in DST_FS.
  * Do not re-copy data which already exists in DST_FS.
  * Set *SKIPPED_P to FALSE only if at least one part of the shard
  * was copied, do not change the value in *SKIPPED_P otherwise.
  * SKIPPED_P may be NULL if not required.
+ *
+ * This only reads constant members of SRC_FS and DST_FS and may therefore
+ * be called from multiple threads at once.  The shard will not become
+ * visible in DST_FS before hotcopy_install_packed_shard() is called.
  * Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
 hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
-                          svn_revnum_t *dst_min_unpacked_rev,
                           svn_fs_t *src_fs,
                           svn_fs_t *dst_fs,
                           svn_revnum_t rev,
@@ -357,14 +365,141 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
                                               scratch_pool));
     }
 
-  /* If necessary, update the min-unpacked rev file in the hotcopy. */
-  if (*dst_min_unpacked_rev < rev + max_files_per_dir)
+  return SVN_NO_ERROR;
+}
+
+/* Copy the un-packed revision and revprop files for revisions START_REV
+ * to END_REV (inclusive) from SRC_REVS_DIR and SRC_REVPROPS_DIR to
+ * DST_REVS_DIR and DST_REVPROPS_DIR, respectively.  Assume a sharding
+ * layout based on MAX_FILES_PER_DIR.  Set *SKIPPED_P to FALSE only if at
+ * least one file was copied, do not change the value in *SKIPPED_P
+ * otherwise.  This may be called from multiple threads at once as long
+ * as the revision ranges cover disjoint shards.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+hotcopy_copy_unpacked_revs(svn_boolean_t *skipped_p,
+                           const char *src_revs_dir,
+                           const char *dst_revs_dir,
+                           const char *src_revprops_dir,
+                           const char *dst_revprops_dir,
+                           svn_revnum_t start_rev,
+                           svn_revnum_t end_rev,
+                           int max_files_per_dir,
+                           apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t rev;
+
+  for (rev = start_rev; rev <= end_rev; rev++)
     {
-      *dst_min_unpacked_rev = rev + max_files_per_dir;
-      SVN_ERR(svn_fs_fs__write_min_unpacked_rev(dst_fs,
-                                                *dst_min_unpacked_rev,
-                                                scratch_pool));
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(hotcopy_copy_shard_file(skipped_p,
+                                      src_revs_dir, dst_revs_dir, rev,
+                                      max_files_per_dir,
+                                      iterpool));
+      SVN_ERR(hotcopy_copy_shard_file(skipped_p,
+                                      src_revprops_dir, dst_revprops_dir,
+                                      rev, max_files_per_dir,
+                                      iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Flush all files directly within DIR_PATH, if that exists, as well as
+ * the directory itself and its parent to disk.  This is a no-op on
+ * non-POSIX systems where we can't fsync directories and the copied files
+ * are likely to be read-only.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+hotcopy_flush_dir(const char *dir_path,
+                  apr_pool_t *scratch_pool)
+{
+#ifdef SVN_ON_POSIX
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+  apr_file_t *file;
+  svn_node_kind_t kind;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(svn_io_check_path(dir_path, &kind, scratch_pool));
+  if (kind != svn_node_dir)
+    return SVN_NO_ERROR;
+
+  /* Schedule all writes first, then wait for all of them.  That gives the
+   * OS and the storage a chance to combine the physical I/O. */
+  SVN_ERR(svn_io_get_dirents3(&dirents, dir_path, TRUE,
+                              scratch_pool, scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const svn_io_dirent2_t *dirent = apr_hash_this_val(hi);
+
+      svn_pool_clear(iterpool);
+      if (dirent->kind != svn_node_file)
+        continue;
+
+      SVN_ERR(svn_io_file_open(&file,
+                               svn_dirent_join(dir_path, name, iterpool),
+                               APR_READ, APR_OS_DEFAULT, iterpool));
+      SVN_ERR(svn_io_file_flush_to_disk(file, iterpool));
+      SVN_ERR(svn_io_file_close(file, iterpool));
     }
+  svn_pool_destroy(iterpool);
+
+  /* The file names are stored in the directory and the directory name
+   * in its parent. */
+  SVN_ERR(svn_io_file_open(&file, dir_path, APR_READ, APR_OS_DEFAULT,
+                           scratch_pool));
+  SVN_ERR(svn_io_file_flush_to_disk(file, scratch_pool));
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+
+  SVN_ERR(svn_io_file_open(&file, svn_dirent_dirname(dir_path, scratch_pool),
+                           APR_READ, APR_OS_DEFAULT, scratch_pool));
+  SVN_ERR(svn_io_file_flush_to_disk(file, scratch_pool));
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Flush all files in DST_FS that belong to the shard starting at revision
+ * REV to disk.  This works for packed as well as non-packed shards.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+hotcopy_flush_shard(svn_fs_t *dst_fs,
+                    svn_revnum_t rev,
+                    apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
+  const char *shard = apr_psprintf(scratch_pool, "%ld",
+                                   rev / dst_ffd->max_files_per_dir);
+  const char *packed_shard = apr_pstrcat(scratch_pool, shard,
+                                         PATH_EXT_PACKED_SHARD, SVN_VA_NULL);
+  const char *revs_dir = svn_dirent_join(dst_fs->path, PATH_REVS_DIR,
+                                         scratch_pool);
+  const char *revprops_dir = svn_dirent_join(dst_fs->path, PATH_REVPROPS_DIR,
+                                             scratch_pool);
+
+  /* Not all of these will exist.  Note that we must not use the path
+   * functions of DST_FS here because they depend on its current
+   * min-unpacked-rev. */
+  SVN_ERR(hotcopy_flush_dir(svn_dirent_join(revs_dir, packed_shard,
+                                            scratch_pool),
+                            scratch_pool));
+  SVN_ERR(hotcopy_flush_dir(svn_dirent_join(revs_dir, shard, scratch_pool),
+                            scratch_pool));
+  SVN_ERR(hotcopy_flush_dir(svn_dirent_join(revprops_dir, packed_shard,
+                                            scratch_pool),
+                            scratch_pool));
+  SVN_ERR(hotcopy_flush_dir(svn_dirent_join(revprops_dir, shard,
+                                            scratch_pool),
+                            scratch_pool));
 
   return SVN_NO_ERROR;
 }
@@ -475,10 +610,11 @@ hotcopy_remove_revprop_files(svn_fs_t *dst_fs,
 }
 
 /* Verify that DST_FS is a suitable destination for an incremental
- * hotcopy from SRC_FS. */
+ * hotcopy from SRC_FS that uses MAX_FILES_PER_DIR revisions per shard. */
 static svn_error_t *
 hotcopy_incremental_check_preconditions(svn_fs_t *src_fs,
                                         svn_fs_t *dst_fs,
+                                        int max_files_per_dir,
                                         apr_pool_t *pool)
 {
   fs_fs_data_t *src_ffd = src_fs->fsap_data;
@@ -500,8 +636,8 @@ hotcopy_incremental_check_preconditions(svn_fs_t *src_fs,
                               "not match the UUID of the hotcopy "
                               "destination"));
 
-  /* Also require same shard size. */
-  if (src_ffd->max_files_per_dir != dst_ffd->max_files_per_dir)
+  /* Also require the expected shard size. */
+  if (max_files_per_dir != dst_ffd->max_files_per_dir)
     return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
                             _("The sharding layout configuration "
                               "of the hotcopy source does not match "
@@ -532,13 +668,269 @@ remove_folder(const char *path,
   return svn_error_trace(err);
 }
 
+/* The packed shard starting at revision REV has been copied from SRC_FS
+ * to DST_FS.  Make it visible in DST_FS by updating *DST_MIN_UNPACKED_REV,
+ * the min-unpacked-rev file and - if the shard is new - the 'current' file
+ * in DST_FS, then clean up the non-packed revisions that the shard replaces.
+ * DST_YOUNGEST is the youngest revision in DST_FS before the hotcopy.
+ * SKIPPED tells whether all files of the shard already existed in DST_FS.
+ * Shards must be installed strictly in revision order.
+ *
+ * MAX_FILES_PER_DIR, INCREMENTAL, NOTIFY_FUNC, NOTIFY_BATON, CANCEL_FUNC
+ * and CANCEL_BATON are the same as for hotcopy_revisions().
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+hotcopy_install_packed_shard(svn_revnum_t *dst_min_unpacked_rev,
+                             svn_fs_t *dst_fs,
+                             svn_revnum_t rev,
+                             svn_revnum_t dst_youngest,
+                             svn_boolean_t skipped,
+                             int max_files_per_dir,
+                             svn_boolean_t incremental,
+                             svn_fs_hotcopy_notify_t notify_func,
+                             void* notify_baton,
+                             svn_cancel_func_t cancel_func,
+                             void* cancel_baton,
+                             apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
+  svn_revnum_t pack_end_rev = rev + max_files_per_dir - 1;
+
+  /* If necessary, update the min-unpacked rev file in the hotcopy. */
+  if (*dst_min_unpacked_rev < rev + max_files_per_dir)
+    {
+      *dst_min_unpacked_rev = rev + max_files_per_dir;
+      SVN_ERR(svn_fs_fs__write_min_unpacked_rev(dst_fs,
+                                                *dst_min_unpacked_rev,
+                                                scratch_pool));
+    }
+
+  /* Whenever this pack did not previously exist in the destination,
+   * update 'current' to the most recent packed rev (so readers can see
+   * new revisions which arrived in this pack). */
+  if (pack_end_rev > dst_youngest)
+    {
+      SVN_ERR(svn_fs_fs__write_current(dst_fs, pack_end_rev, 0, 0,
+                                       scratch_pool));
+    }
+
+  /* When notifying about packed shards, make things simpler by either
+   * reporting a full revision range, i.e [pack start, pack end] or
+   * reporting nothing. There is one case when this approach might not
+   * be exact (incremental hotcopy with a pack replacing last unpacked
+   * revisions), but generally this is good enough. */
+  if (notify_func && !skipped)
+    notify_func(notify_baton, rev, pack_end_rev, scratch_pool);
+
+  /* Remove revision files which are now packed. */
+  if (incremental)
+    {
+      SVN_ERR(hotcopy_remove_rev_files(dst_fs, rev,
+                                       rev + max_files_per_dir,
+                                       max_files_per_dir, scratch_pool));
+      if (dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
+        SVN_ERR(hotcopy_remove_revprop_files(dst_fs, rev,
+                                             rev + max_files_per_dir,
+                                             max_files_per_dir,
+                                             scratch_pool));
+    }
+
+  /* Now that all revisions have moved into the pack, the original
+   * rev dir can be removed. */
+  SVN_ERR(remove_folder(svn_fs_fs__path_rev_shard(dst_fs, rev, scratch_pool),
+                        cancel_func, cancel_baton, scratch_pool));
+  if (rev > 0 && dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
+    SVN_ERR(remove_folder(svn_fs_fs__path_revprops_shard(dst_fs, rev,
+                                                         scratch_pool),
+                          cancel_func, cancel_baton, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* State shared by all tasks of a parallel hotcopy_revisions() run.
+ * Only the output function, i.e. the main thread, may modify it. */
+typedef struct hotcopy_revs_baton_t
+{
+  svn_fs_t *src_fs;
+  svn_fs_t *dst_fs;
+  svn_revnum_t src_youngest;
+  svn_revnum_t dst_youngest;
+  svn_revnum_t src_min_unpacked_rev;
+  svn_revnum_t dst_min_unpacked_rev;
+  svn_boolean_t incremental;
+  const char *src_revs_dir;
+  const char *dst_revs_dir;
+  const char *src_revprops_dir;
+  const char *dst_revprops_dir;
+  svn_fs_hotcopy_notify_t notify_func;
+  void* notify_baton;
+  svn_cancel_func_t cancel_func;
+  void* cancel_baton;
+} hotcopy_revs_baton_t;
+
+/* Process baton of a parallel hotcopy task covering the shards FIRST to
+ * LAST (inclusive) of the hotcopy described by HRB.
+ */
+typedef struct hotcopy_range_t
+{
+  hotcopy_revs_baton_t *hrb;
+  apr_int64_t first;
+  apr_int64_t last;
+} hotcopy_range_t;
+
+/* Result of copying a single shard in a parallel hotcopy. */
+typedef struct hotcopy_shard_result_t
+{
+  /* First revision in the shard. */
+  svn_revnum_t rev;
+
+  /* All files already existed in the destination. */
+  svn_boolean_t skipped;
+} hotcopy_shard_result_t;
+
+/* Add a sub-task to TASK that will copy the shards FIRST to LAST
+ * (inclusive) for the hotcopy HRB.
+ */
+static svn_error_t *
+add_hotcopy_range(svn_task__t *task,
+                  hotcopy_revs_baton_t *hrb,
+                  apr_int64_t first,
+                  apr_int64_t last)
+{
+  apr_pool_t *process_pool = svn_task__create_process_pool(task);
+  hotcopy_range_t *range = apr_pcalloc(process_pool, sizeof(*range));
+
+  range->hrb = hrb;
+  range->first = first;
+  range->last = last;
+
+  return svn_error_trace(svn_task__add_similar(task, process_pool, NULL,
+                                               range));
+}
+
+/* Implements svn_task__process_func_t.  PROCESS_BATON is a
+ * hotcopy_range_t.
+ *
+ * Ranges of more than one shard get split in halves and turned into
+ * sub-tasks.  Single shards get copied, packed or not, and flushed to
+ * disk.  Making them visible in the destination is left to the output
+ * function.
+ */
+static svn_error_t *
+hotcopy_range_process(void **result,
+                      svn_task__t *task,
+                      void *thread_context,
+                      void *process_baton,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  const hotcopy_range_t *range = process_baton;
+  const hotcopy_revs_baton_t *hrb = range->hrb;
+  fs_fs_data_t *src_ffd = hrb->src_fs->fsap_data;
+  fs_fs_data_t *dst_ffd = hrb->dst_fs->fsap_data;
+  int max_files_per_dir = src_ffd->max_files_per_dir;
+  hotcopy_shard_result_t *shard_result;
+  svn_revnum_t rev;
+
+  if (range->first < range->last)
+    {
+      apr_int64_t mid = range->first + (range->last - range->first) / 2;
+
+      SVN_ERR(add_hotcopy_range(task, range->hrb, range->first, mid));
+      SVN_ERR(add_hotcopy_range(task, range->hrb, mid + 1, range->last));
+
+      *result = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  shard_result = apr_pcalloc(result_pool, sizeof(*shard_result));
+  shard_result->skipped = TRUE;
+  rev = (svn_revnum_t)(range->first * max_files_per_dir);
+  shard_result->rev = rev;
+
+  if (rev < hrb->src_min_unpacked_rev)
+    SVN_ERR(hotcopy_copy_packed_shard(&shard_result->skipped,
+                                      hrb->src_fs, hrb->dst_fs,
+                                      rev, max_files_per_dir,
+                                      scratch_pool));
+  else
+    SVN_ERR(hotcopy_copy_unpacked_revs(&shard_result->skipped,
+                                       hrb->src_revs_dir, hrb->dst_revs_dir,
+                                       hrb->src_revprops_dir,
+                                       hrb->dst_revprops_dir,
+                                       rev,
+                                       MIN(rev + max_files_per_dir - 1,
+                                           hrb->src_youngest),
+                                       max_files_per_dir, scratch_pool));
+
+  /* Everything must be on disk before the output function makes the new
+   * revisions visible in the destination. */
+  if (dst_ffd->flush_to_disk && !shard_result->skipped)
+    SVN_ERR(hotcopy_flush_shard(hrb->dst_fs, rev, scratch_pool));
+
+  *result = shard_result;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  RESULT is the
+ * hotcopy_shard_result_t of a shard that has been copied and OUTPUT_BATON
+ * the hotcopy_revs_baton_t.  Since this gets called in shard order, we
+ * update min-unpacked-rev and 'current' in the same order as a sequential
+ * hotcopy would.
+ */
+static svn_error_t *
+hotcopy_range_output(svn_task__t *task,
+                     void *result,
+                     void *output_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  hotcopy_revs_baton_t *hrb = output_baton;
+  const hotcopy_shard_result_t *shard_result = result;
+  fs_fs_data_t *src_ffd = hrb->src_fs->fsap_data;
+  int max_files_per_dir = src_ffd->max_files_per_dir;
+  svn_revnum_t rev = shard_result->rev;
+  svn_revnum_t end_rev;
+
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  if (rev < hrb->src_min_unpacked_rev)
+    return svn_error_trace(hotcopy_install_packed_shard(
+                             &hrb->dst_min_unpacked_rev, hrb->dst_fs, rev,
+                             hrb->dst_youngest, shard_result->skipped,
+                             max_files_per_dir, hrb->incremental,
+                             hrb->notify_func, hrb->notify_baton,
+                             hrb->cancel_func, hrb->cancel_baton,
+                             scratch_pool));
+
+  /* Checkpoint the progress via 'current' once new revisions arrived. */
+  end_rev = MIN(rev + max_files_per_dir - 1, hrb->src_youngest);
+  if (end_rev > hrb->dst_youngest)
+    SVN_ERR(svn_fs_fs__write_current(hrb->dst_fs, end_rev, 0, 0,
+                                     scratch_pool));
+
+  if (hrb->notify_func && !shard_result->skipped)
+    hrb->notify_func(hrb->notify_baton, rev, end_rev, scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Copy the revision and revprop files (possibly sharded / packed) from
  * SRC_FS to DST_FS.  Do not re-copy data which already exists in DST_FS.
  * When copying packed or unpacked shards, checkpoint the result in DST_FS
  * for every shard by updating the 'current' file if necessary.  Assume
  * the >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT filesystem format without
- * global next-ID counters.  Indicate progress via the optional NOTIFY_FUNC
- * callback using NOTIFY_BATON.  Use POOL for temporary allocations.
+ * global next-ID counters.  Copy up to JOBS shards concurrently.
+ * Indicate progress via the optional NOTIFY_FUNC callback using
+ * NOTIFY_BATON.  Use POOL for temporary allocations.
  */
 static svn_error_t *
 hotcopy_revisions(svn_fs_t *src_fs,
@@ -546,6 +938,7 @@ hotcopy_revisions(svn_fs_t *src_fs,
                   svn_revnum_t src_youngest,
                   svn_revnum_t dst_youngest,
                   svn_boolean_t incremental,
+                  int jobs,
                   const char *src_revs_dir,
                   const char *dst_revs_dir,
                   const char *src_revprops_dir,
@@ -557,7 +950,6 @@ hotcopy_revisions(svn_fs_t *src_fs,
                   apr_pool_t *pool)
 {
   fs_fs_data_t *src_ffd = src_fs->fsap_data;
-  fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
   int max_files_per_dir = src_ffd->max_files_per_dir;
   svn_revnum_t src_min_unpacked_rev;
   svn_revnum_t dst_min_unpacked_rev;
@@ -601,63 +993,67 @@ hotcopy_revisions(svn_fs_t *src_fs,
    */
 
   iterpool = svn_pool_create(pool);
+
+  /* Copy whole shards concurrently but make them visible in the
+   * destination strictly in revision order. */
+  if (jobs > 1 && max_files_per_dir)
+    {
+      hotcopy_revs_baton_t *hrb = apr_pcalloc(pool, sizeof(*hrb));
+      hotcopy_range_t *range = apr_pcalloc(pool, sizeof(*range));
+
+      hrb->src_fs = src_fs;
+      hrb->dst_fs = dst_fs;
+      hrb->src_youngest = src_youngest;
+      hrb->dst_youngest = dst_youngest;
+      hrb->src_min_unpacked_rev = src_min_unpacked_rev;
+      hrb->dst_min_unpacked_rev = dst_min_unpacked_rev;
+      hrb->incremental = incremental;
+      hrb->src_revs_dir = src_revs_dir;
+      hrb->dst_revs_dir = dst_revs_dir;
+      hrb->src_revprops_dir = src_revprops_dir;
+      hrb->dst_revprops_dir = dst_revprops_dir;
+      hrb->notify_func = notify_func;
+      hrb->notify_baton = notify_baton;
+      hrb->cancel_func = cancel_func;
+      hrb->cancel_baton = cancel_baton;
+
+      range->hrb = hrb;
+      range->first = 0;
+      range->last = src_youngest / max_files_per_dir;
+
+      SVN_ERR(svn_task__run(jobs,
+                            hotcopy_range_process, range,
+                            hotcopy_range_output, hrb,
+                            NULL, NULL,
+                            cancel_func, cancel_baton,
+                            pool, iterpool));
+      svn_pool_destroy(iterpool);
+
+      SVN_ERR_ASSERT(src_min_unpacked_rev == hrb->dst_min_unpacked_rev);
+
+      return SVN_NO_ERROR;
+    }
+
   /* First, copy packed shards. */
   for (rev = 0; rev < src_min_unpacked_rev; rev += max_files_per_dir)
     {
       svn_boolean_t skipped = TRUE;
-      svn_revnum_t pack_end_rev;
 
       svn_pool_clear(iterpool);
 
       if (cancel_func)
         SVN_ERR(cancel_func(cancel_baton));
 
-      /* Copy the packed shard. */
-      SVN_ERR(hotcopy_copy_packed_shard(&skipped, &dst_min_unpacked_rev,
-                                        src_fs, dst_fs,
+      /* Copy the packed shard and make it visible in the destination. */
+      SVN_ERR(hotcopy_copy_packed_shard(&skipped, src_fs, dst_fs,
                                         rev, max_files_per_dir,
                                         iterpool));
-
-      pack_end_rev = rev + max_files_per_dir - 1;
-
-      /* Whenever this pack did not previously exist in the destination,
-       * update 'current' to the most recent packed rev (so readers can see
-       * new revisions which arrived in this pack). */
-      if (pack_end_rev > dst_youngest)
-        {
-          SVN_ERR(svn_fs_fs__write_current(dst_fs, pack_end_rev, 0, 0,
+      SVN_ERR(hotcopy_install_packed_shard(&dst_min_unpacked_rev, dst_fs,
+                                           rev, dst_youngest, skipped,
+                                           max_files_per_dir, incremental,
+                                           notify_func, notify_baton,
+                                           cancel_func, cancel_baton,
                                            iterpool));
-        }
-
-      /* When notifying about packed shards, make things simpler by either
-       * reporting a full revision range, i.e [pack start, pack end] or
-       * reporting nothing. There is one case when this approach might not
-       * be exact (incremental hotcopy with a pack replacing last unpacked
-       * revisions), but generally this is good enough. */
-      if (notify_func && !skipped)
-        notify_func(notify_baton, rev, pack_end_rev, iterpool);
-
-      /* Remove revision files which are now packed. */
-      if (incremental)
-        {
-          SVN_ERR(hotcopy_remove_rev_files(dst_fs, rev,
-                                           rev + max_files_per_dir,
-                                           max_files_per_dir, iterpool));
-          if (dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
-            SVN_ERR(hotcopy_remove_revprop_files(dst_fs, rev,
-                                                 rev + max_files_per_dir,
-                                                 max_files_per_dir,
-                                                 iterpool));
-        }
-
-      /* Now that all revisions have moved into the pack, the original
-       * rev dir can be removed. */
-      SVN_ERR(remove_folder(svn_fs_fs__path_rev_shard(dst_fs, rev, iterpool),
-                            cancel_func, cancel_baton, iterpool));
-      if (rev > 0 && dst_ffd->format >= SVN_FS_FS__MIN_PACKED_REVPROP_FORMAT)
-        SVN_ERR(remove_folder(svn_fs_fs__path_revprops_shard(dst_fs, rev,
-                                                             iterpool),
-                              cancel_func, cancel_baton, iterpool));
     }
 
   if (cancel_func)
@@ -775,11 +1171,482 @@ hotcopy_revisions_old(svn_fs_t *src_fs,
     return SVN_NO_ERROR;
 }
 
+/* Copy SIZE bytes starting at OFFSET in SOURCE to the current position
+ * in DEST.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+reshard_copy_range(apr_file_t *dest,
+                   apr_file_t *source,
+                   apr_off_t offset,
+                   apr_off_t size,
+                   apr_pool_t *scratch_pool)
+{
+  char *buffer = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
+
+  SVN_ERR(svn_io_file_seek(source, APR_SET, &offset, scratch_pool));
+  while (size > 0)
+    {
+      apr_size_t to_copy = (apr_size_t)MIN(size, SVN__STREAM_CHUNK_SIZE);
+
+      SVN_ERR(svn_io_file_read_full2(source, buffer, to_copy, NULL, NULL,
+                                     scratch_pool));
+      SVN_ERR(svn_io_file_write_full(dest, buffer, to_copy, NULL,
+                                     scratch_pool));
+      size -= to_copy;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* svn_sort__array() comparator ordering svn_fs_fs__p2l_entry_t * by
+ * offset. */
+static int
+compare_p2l_entry_offsets(const void *lhs,
+                          const void *rhs)
+{
+  const svn_fs_fs__p2l_entry_t *lhs_entry
+    = *(const svn_fs_fs__p2l_entry_t *const *)lhs;
+  const svn_fs_fs__p2l_entry_t *rhs_entry
+    = *(const svn_fs_fs__p2l_entry_t *const *)rhs;
+
+  if (lhs_entry->offset < rhs_entry->offset)
+    return -1;
+
+  return lhs_entry->offset == rhs_entry->offset ? 0 : 1;
+}
+
+/* Write the items of revision REV, found in the logically addressed pack
+ * file REV_FILE of SRC_FS, back-to-back to FILE, which will become the
+ * non-packed rev file of REV in DST_FS.  Keep their relative order as well
+ * as their item numbers and checksums, and append the L2P and P2L indexes
+ * for the new offsets.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+reshard_copy_packed_items(apr_file_t *file,
+                          svn_fs_t *src_fs,
+                          svn_fs_fs__revision_file_t *rev_file,
+                          svn_fs_t *dst_fs,
+                          svn_revnum_t rev,
+                          apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_array_header_t *max_ids;
+  apr_array_header_t *item_indexes;
+  apr_array_header_t *offsets;
+  apr_array_header_t *entries;
+  apr_file_t *proto_index;
+  const char *l2p_proto_index;
+  const char *p2l_proto_index;
+  apr_uint64_t item_count;
+  apr_uint64_t item_index;
+  apr_off_t offset = 0;
+  int i;
+
+  /* Locate all items of REV within the pack file. */
+  SVN_ERR(svn_fs_fs__l2p_get_max_ids(&max_ids, src_fs, rev, 1,
+                                     scratch_pool, scratch_pool));
+  item_count = APR_ARRAY_IDX(max_ids, 0, apr_uint64_t);
+  item_indexes = apr_array_make(scratch_pool, (int)item_count,
+                                sizeof(apr_uint64_t));
+  for (item_index = 0; item_index < item_count; ++item_index)
+    APR_ARRAY_PUSH(item_indexes, apr_uint64_t) = item_index;
+
+  SVN_ERR(svn_fs_fs__item_offsets(&offsets, src_fs, rev_file, rev,
+                                  item_indexes, scratch_pool, scratch_pool));
+
+  entries = apr_array_make(scratch_pool, offsets->nelts,
+                           sizeof(svn_fs_fs__p2l_entry_t *));
+  for (i = 0; i < offsets->nelts; ++i)
+    {
+      apr_off_t item_offset = APR_ARRAY_IDX(offsets, i, apr_off_t);
+      svn_fs_fs__p2l_entry_t *entry;
+
+      /* Skip unused item indexes. */
+      if (item_offset < 0)
+        continue;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__p2l_entry_lookup(&entry, src_fs, rev_file, rev,
+                                          item_offset, scratch_pool,
+                                          iterpool));
+      if (entry == NULL)
+        return svn_error_createf(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
+                                 _("No P2L index entry for item %d of "
+                                   "revision %ld"), i, rev);
+
+      APR_ARRAY_PUSH(entries, svn_fs_fs__p2l_entry_t *) = entry;
+    }
+
+  /* Copy the items in pack file order and describe them in a new P2L
+   * proto index as we go.  This covers FILE without gaps. */
+  svn_sort__array(entries, compare_p2l_entry_offsets);
+
+  SVN_ERR(svn_io_open_unique_file3(NULL, &p2l_proto_index, NULL,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   scratch_pool, scratch_pool));
+  SVN_ERR(svn_fs_fs__p2l_proto_index_open(&proto_index, p2l_proto_index,
+                                          scratch_pool));
+
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      svn_fs_fs__p2l_entry_t *entry
+        = APR_ARRAY_IDX(entries, i, svn_fs_fs__p2l_entry_t *);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(reshard_copy_range(file, rev_file->file, entry->offset,
+                                 entry->size, iterpool));
+
+      entry->offset = offset;
+      offset += entry->size;
+      SVN_ERR(svn_fs_fs__p2l_proto_index_add_entry(proto_index, entry,
+                                                   iterpool));
+    }
+
+  SVN_ERR(svn_io_file_close(proto_index, scratch_pool));
+  svn_pool_destroy(iterpool);
+
+  /* The item numbers don't change, so the L2P index can be derived from
+   * the same entries.  Note that this reorders ENTRIES. */
+  SVN_ERR(svn_fs_fs__l2p_index_from_p2l_entries(&l2p_proto_index, dst_fs,
+                                                entries, scratch_pool,
+                                                scratch_pool));
+  SVN_ERR(svn_fs_fs__add_index_data(dst_fs, file, l2p_proto_index,
+                                    p2l_proto_index, rev, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Write revision REV of SRC_FS as a non-packed rev file to DST_FS,
+ * replacing any file left over from an interrupted run.  Non-packed
+ * source revisions get copied as-is.  Packed ones are cut out of their
+ * pack file and, for logical addressing, get new indexes.
+ *
+ * SRC_FS must be used by the current thread only.  This only reads
+ * constant members of DST_FS.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+reshard_copy_rev_file(svn_fs_t *src_fs,
+                      svn_fs_t *dst_fs,
+                      svn_revnum_t rev,
+                      apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *src_ffd = src_fs->fsap_data;
+  svn_fs_fs__revision_file_t *rev_file;
+  const char *final_path = svn_fs_fs__path_rev(dst_fs, rev, scratch_pool);
+  const char *tmp_path;
+  apr_file_t *file;
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, src_fs, rev,
+                                           scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_open_unique_file3(&file, &tmp_path,
+                                   svn_dirent_dirname(final_path,
+                                                      scratch_pool),
+                                   svn_io_file_del_none,
+                                   scratch_pool, scratch_pool));
+
+  if (!rev_file->is_packed)
+    {
+      apr_off_t size = 0;
+
+      SVN_ERR(svn_io_file_seek(rev_file->file, APR_END, &size,
+                               scratch_pool));
+      SVN_ERR(reshard_copy_range(file, rev_file->file, 0, size,
+                                 scratch_pool));
+    }
+  else if (svn_fs_fs__use_log_addressing(src_fs))
+    {
+      SVN_ERR(reshard_copy_packed_items(file, src_fs, rev_file, dst_fs, rev,
+                                        scratch_pool));
+    }
+  else
+    {
+      /* Physical pack files simply concatenate the original rev files. */
+      apr_off_t start;
+      apr_off_t end = 0;
+
+      SVN_ERR(svn_fs_fs__get_packed_offset(&start, src_fs, rev,
+                                           scratch_pool));
+      if ((rev + 1) % src_ffd->max_files_per_dir)
+        SVN_ERR(svn_fs_fs__get_packed_offset(&end, src_fs, rev + 1,
+                                             scratch_pool));
+      else
+        SVN_ERR(svn_io_file_seek(rev_file->file, APR_END, &end,
+                                 scratch_pool));
+
+      SVN_ERR(reshard_copy_range(file, rev_file->file, start, end - start,
+                                 scratch_pool));
+    }
+
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  SVN_ERR(hotcopy_remove_file(final_path, scratch_pool));
+  SVN_ERR(svn_io_file_rename2(tmp_path, final_path, FALSE, scratch_pool));
+  SVN_ERR(svn_io_set_file_read_only(final_path, FALSE, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* State shared by all tasks of a reshard_revisions() run.
+ * Only the output function, i.e. the main thread, may modify it. */
+typedef struct reshard_revs_baton_t
+{
+  svn_fs_t *src_fs;
+  svn_fs_t *dst_fs;
+  svn_revnum_t first_rev;
+  svn_revnum_t src_youngest;
+  int jobs;
+  svn_fs_hotcopy_notify_t notify_func;
+  void* notify_baton;
+} reshard_revs_baton_t;
+
+/* Process baton of a reshard task covering the destination shards FIRST
+ * to LAST (inclusive) of the run described by RRB.
+ */
+typedef struct reshard_range_t
+{
+  reshard_revs_baton_t *rrb;
+  apr_int64_t first;
+  apr_int64_t last;
+} reshard_range_t;
+
+/* Result of writing a single destination shard: the revisions
+ * START_REV to END_REV (inclusive). */
+typedef struct reshard_shard_result_t
+{
+  svn_revnum_t start_rev;
+  svn_revnum_t end_rev;
+} reshard_shard_result_t;
+
+/* Implements svn_task__thread_context_constructor_t.  The thread context
+ * is the source svn_fs_t instance to read from.  CONTEXT_BATON is the
+ * reshard_revs_baton_t *.
+ */
+static svn_error_t *
+reshard_context_constructor(void **thread_context,
+                            void *context_baton,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  reshard_revs_baton_t *rrb = context_baton;
+  svn_fs_t *fs = rrb->src_fs;
+
+  /* Worker threads must not share the svn_fs_t with the main thread. */
+  if (rrb->jobs > 1)
+    SVN_ERR(svn_fs_fs__open_instance(&fs, rrb->src_fs, result_pool,
+                                     scratch_pool));
+
+  *thread_context = fs;
+  return SVN_NO_ERROR;
+}
+
+/* Add a sub-task to TASK that will write the destination shards FIRST to
+ * LAST (inclusive) for the reshard run RRB.
+ */
+static svn_error_t *
+add_reshard_range(svn_task__t *task,
+                  reshard_revs_baton_t *rrb,
+                  apr_int64_t first,
+                  apr_int64_t last)
+{
+  apr_pool_t *process_pool = svn_task__create_process_pool(task);
+  reshard_range_t *range = apr_pcalloc(process_pool, sizeof(*range));
+
+  range->rrb = rrb;
+  range->first = first;
+  range->last = last;
+
+  return svn_error_trace(svn_task__add_similar(task, process_pool, NULL,
+                                               range));
+}
+
+/* Implements svn_task__process_func_t.  PROCESS_BATON is a
+ * reshard_range_t and THREAD_CONTEXT the source svn_fs_t to read from.
+ *
+ * Ranges of more than one shard get split in halves and turned into
+ * sub-tasks.  For single shards, write all their revisions and revprops
+ * that are still missing in the destination and flush them to disk.
+ * Making them visible is left to the output function.
+ */
+static svn_error_t *
+reshard_range_process(void **result,
+                      svn_task__t *task,
+                      void *thread_context,
+                      void *process_baton,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  const reshard_range_t *range = process_baton;
+  const reshard_revs_baton_t *rrb = range->rrb;
+  svn_fs_t *src_fs = thread_context;
+  svn_fs_t *dst_fs = rrb->dst_fs;
+  fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
+  int max_files_per_dir = dst_ffd->max_files_per_dir;
+  reshard_shard_result_t *shard_result;
+  apr_array_header_t *proplists;
+  const char *shard_path;
+  apr_pool_t *iterpool;
+  svn_revnum_t rev;
+
+  if (range->first < range->last)
+    {
+      apr_int64_t mid = range->first + (range->last - range->first) / 2;
+
+      SVN_ERR(add_reshard_range(task, range->rrb, range->first, mid));
+      SVN_ERR(add_reshard_range(task, range->rrb, mid + 1, range->last));
+
+      *result = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  shard_result = apr_pcalloc(result_pool, sizeof(*shard_result));
+  shard_result->start_rev
+    = (svn_revnum_t)MAX(range->first * max_files_per_dir, rrb->first_rev);
+  shard_result->end_rev
+    = (svn_revnum_t)MIN((range->first + 1) * max_files_per_dir - 1,
+                        rrb->src_youngest);
+
+  /* Create the shard folders. */
+  shard_path = svn_fs_fs__path_rev_shard(dst_fs, shard_result->start_rev,
+                                         scratch_pool);
+  SVN_ERR(svn_io_make_dir_recursively(shard_path, scratch_pool));
+  SVN_ERR(svn_io_copy_perms(svn_dirent_dirname(shard_path, scratch_pool),
+                            shard_path, scratch_pool));
+
+  shard_path = svn_fs_fs__path_revprops_shard(dst_fs,
+                                              shard_result->start_rev,
+                                              scratch_pool);
+  SVN_ERR(svn_io_make_dir_recursively(shard_path, scratch_pool));
+  SVN_ERR(svn_io_copy_perms(svn_dirent_dirname(shard_path, scratch_pool),
+                            shard_path, scratch_pool));
+
+  /* Write the revisions and their revprops. */
+  SVN_ERR(svn_fs_fs__get_revision_proplists(&proplists, src_fs,
+                                            shard_result->start_rev,
+                                            shard_result->end_rev,
+                                            scratch_pool, scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (rev = shard_result->start_rev; rev <= shard_result->end_rev; ++rev)
+    {
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(reshard_copy_rev_file(src_fs, dst_fs, rev, iterpool));
+      SVN_ERR(svn_fs_fs__write_non_packed_revprop(
+                dst_fs, rev,
+                APR_ARRAY_IDX(proplists, rev - shard_result->start_rev,
+                              apr_hash_t *),
+                iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Everything must be on disk before the output function makes the new
+   * revisions visible in the destination. */
+  if (dst_ffd->flush_to_disk)
+    SVN_ERR(hotcopy_flush_shard(dst_fs, shard_result->start_rev,
+                                scratch_pool));
+
+  *result = shard_result;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  RESULT is the
+ * reshard_shard_result_t of a shard that has been written and
+ * OUTPUT_BATON the reshard_revs_baton_t.  Since this gets called in shard
+ * order, 'current' in the destination only ever covers complete shards.
+ */
+static svn_error_t *
+reshard_range_output(svn_task__t *task,
+                     void *result,
+                     void *output_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  reshard_revs_baton_t *rrb = output_baton;
+  const reshard_shard_result_t *shard_result = result;
+
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  SVN_ERR(svn_fs_fs__write_current(rrb->dst_fs, shard_result->end_rev, 0, 0,
+                                   scratch_pool));
+
+  if (rrb->notify_func)
+    rrb->notify_func(rrb->notify_baton, shard_result->start_rev,
+                     shard_result->end_rev, scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Like hotcopy_revisions() but for a DST_FS with a different shard size
+ * than SRC_FS.  Write all revisions and revprops after DST_YOUNGEST (all of
+ * them, if INCREMENTAL is not set) up to SRC_YOUNGEST as non-packed files
+ * into DST_FS.  Packing the result is left to the caller.
+ *
+ * Process up to JOBS destination shards concurrently and checkpoint the
+ * progress in DST_FS' 'current' file after each of them.  Indicate
+ * progress via the optional NOTIFY_FUNC callback using NOTIFY_BATON.
+ * Use POOL for temporary allocations.
+ */
+static svn_error_t *
+reshard_revisions(svn_fs_t *src_fs,
+                  svn_fs_t *dst_fs,
+                  svn_revnum_t src_youngest,
+                  svn_revnum_t dst_youngest,
+                  svn_boolean_t incremental,
+                  int jobs,
+                  svn_fs_hotcopy_notify_t notify_func,
+                  void* notify_baton,
+                  svn_cancel_func_t cancel_func,
+                  void* cancel_baton,
+                  apr_pool_t *pool)
+{
+  fs_fs_data_t *dst_ffd = dst_fs->fsap_data;
+  int max_files_per_dir = dst_ffd->max_files_per_dir;
+  reshard_revs_baton_t *rrb = apr_pcalloc(pool, sizeof(*rrb));
+  reshard_range_t *range = apr_pcalloc(pool, sizeof(*range));
+  apr_pool_t *iterpool;
+
+  rrb->src_fs = src_fs;
+  rrb->dst_fs = dst_fs;
+  rrb->first_rev = incremental ? dst_youngest + 1 : 0;
+  rrb->src_youngest = src_youngest;
+  rrb->jobs = MAX(jobs, 1);
+  rrb->notify_func = notify_func;
+  rrb->notify_baton = notify_baton;
+
+  if (rrb->first_rev > src_youngest)
+    return SVN_NO_ERROR;
+
+  range->rrb = rrb;
+  range->first = rrb->first_rev / max_files_per_dir;
+  range->last = src_youngest / max_files_per_dir;
+
+  iterpool = svn_pool_create(pool);
+  SVN_ERR(svn_task__run(rrb->jobs,
+                        reshard_range_process, range,
+                        reshard_range_output, rrb,
+                        reshard_context_constructor, rrb,
+                        cancel_func, cancel_baton,
+                        pool, iterpool));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Baton for hotcopy_body(). */
 struct hotcopy_body_baton {
   svn_fs_t *src_fs;
   svn_fs_t *dst_fs;
   svn_boolean_t incremental;
+  int jobs;
   svn_fs_hotcopy_notify_t notify_func;
   void *notify_baton;
   svn_cancel_func_t cancel_func;
@@ -924,11 +1791,21 @@ hotcopy_body(void *baton, apr_pool_t *pool)
   /* Split the logic for new and old FS formats. The latter is much simpler
    * due to the absence of sharding and packing. However, it requires special
    * care when updating the 'current' file (which contains not just the
-   * revision number, but also the next-ID counters). */
-  if (src_ffd->format >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
+   * revision number, but also the next-ID counters).  Copies with a
+   * different shard size have to write every revision anew. */
+  if (src_ffd->max_files_per_dir != dst_ffd->max_files_per_dir)
+    {
+      SVN_ERR(reshard_revisions(src_fs, dst_fs, src_youngest, dst_youngest,
+                                incremental, hbb->jobs,
+                                notify_func, notify_baton,
+                                cancel_func, cancel_baton, pool));
+      SVN_ERR(svn_fs_fs__write_current(dst_fs, src_youngest, 0, 0, pool));
+    }
+  else if (src_ffd->format >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
     {
       SVN_ERR(hotcopy_revisions(src_fs, dst_fs, src_youngest, dst_youngest,
-                                incremental, src_revs_dir, dst_revs_dir,
+                                incremental, hbb->jobs,
+                                src_revs_dir, dst_revs_dir,
                                 src_revprops_dir, dst_revprops_dir,
                                 notify_func, notify_baton,
                                 cancel_func, cancel_baton, pool));
@@ -967,6 +1844,11 @@ hotcopy_body(void *baton, apr_pool_t *pool)
                                             PATH_NODE_ORIGINS_DIR, TRUE,
                                             cancel_func, cancel_baton, pool));
 
+  /* Readers of an incrementally updated destination may have cached
+   * revprops that we just replaced. */
+  if (hbb->incremental)
+    SVN_ERR(svn_fs_fs__invalidate_revprop_generations(dst_fs, pool));
+
   /*
    * NB: Data copied below is only read by writers, not readers.
    *     Writers are still locked out at this point.
@@ -1001,27 +1883,27 @@ hotcopy_body(void *baton, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_fs_fs__hotcopy(svn_fs_t *src_fs,
-                   svn_fs_t *dst_fs,
-                   const char *src_path,
-                   const char *dst_path,
-                   svn_boolean_t incremental,
-                   svn_fs_hotcopy_notify_t notify_func,
-                   void *notify_baton,
-                   svn_cancel_func_t cancel_func,
-                   void *cancel_baton,
-                   svn_mutex__t *common_pool_lock,
-                   apr_pool_t *pool,
-                   apr_pool_t *common_pool)
+/* Copy the open filesystem SRC_FS into DST_FS at DST_PATH, using
+ * MAX_FILES_PER_DIR revisions per shard in the destination.  The other
+ * parameters are as for svn_fs_fs__hotcopy().
+ */
+static svn_error_t *
+hotcopy_to_layout(svn_fs_t *src_fs,
+                  svn_fs_t *dst_fs,
+                  const char *dst_path,
+                  int max_files_per_dir,
+                  svn_boolean_t incremental,
+                  int jobs,
+                  svn_fs_hotcopy_notify_t notify_func,
+                  void *notify_baton,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  svn_mutex__t *common_pool_lock,
+                  apr_pool_t *pool,
+                  apr_pool_t *common_pool)
 {
   struct hotcopy_body_baton hbb;
 
-  if (cancel_func)
-    SVN_ERR(cancel_func(cancel_baton));
-
-  SVN_ERR(svn_fs_fs__open(src_fs, src_path, pool));
-
   if (incremental)
     {
       const char *dst_format_abspath;
@@ -1042,7 +1924,9 @@ svn_fs_fs__hotcopy(svn_fs_t *src_fs,
     {
       /* Check the existing repository. */
       SVN_ERR(svn_fs_fs__open(dst_fs, dst_path, pool));
-      SVN_ERR(hotcopy_incremental_check_preconditions(src_fs, dst_fs, pool));
+      SVN_ERR(hotcopy_incremental_check_preconditions(src_fs, dst_fs,
+                                                      max_files_per_dir,
+                                                      pool));
 
       SVN_ERR(svn_fs_fs__initialize_shared_data(dst_fs, common_pool_lock,
                                                 pool, common_pool));
@@ -1054,9 +1938,9 @@ svn_fs_fs__hotcopy(svn_fs_t *src_fs,
        * as the source. */
       fs_fs_data_t *src_ffd = src_fs->fsap_data;
 
-      /* Create the DST_FS repository with the same layout as SRC_FS. */
+      /* Create the DST_FS repository with the requested layout. */
       SVN_ERR(svn_fs_fs__create_file_tree(dst_fs, dst_path, src_ffd->format,
-                                          src_ffd->max_files_per_dir,
+                                          max_files_per_dir,
                                           src_ffd->use_log_addressing,
                                           pool));
 
@@ -1082,6 +1966,7 @@ svn_fs_fs__hotcopy(svn_fs_t *src_fs,
   hbb.src_fs = src_fs;
   hbb.dst_fs = dst_fs;
   hbb.incremental = incremental;
+  hbb.jobs = jobs;
   hbb.notify_func = notify_func;
   hbb.notify_baton = notify_baton;
   hbb.cancel_func = cancel_func;
@@ -1098,3 +1983,83 @@ svn_fs_fs__hotcopy(svn_fs_t *src_fs,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_fs_fs__hotcopy(svn_fs_t *src_fs,
+                   svn_fs_t *dst_fs,
+                   const char *src_path,
+                   const char *dst_path,
+                   svn_boolean_t incremental,
+                   int jobs,
+                   svn_fs_hotcopy_notify_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   svn_mutex__t *common_pool_lock,
+                   apr_pool_t *pool,
+                   apr_pool_t *common_pool)
+{
+  fs_fs_data_t *src_ffd;
+
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  SVN_ERR(svn_fs_fs__open(src_fs, src_path, pool));
+  src_ffd = src_fs->fsap_data;
+
+  return svn_error_trace(hotcopy_to_layout(src_fs, dst_fs, dst_path,
+                                           src_ffd->max_files_per_dir,
+                                           incremental, jobs,
+                                           notify_func, notify_baton,
+                                           cancel_func, cancel_baton,
+                                           common_pool_lock, pool,
+                                           common_pool));
+}
+
+svn_error_t *
+svn_fs_fs__reshard(svn_fs_t *src_fs,
+                   svn_fs_t *dst_fs,
+                   const char *dst_path,
+                   int max_files_per_dir,
+                   int jobs,
+                   svn_fs_hotcopy_notify_t notify_func,
+                   svn_fs_pack_notify_t pack_notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool)
+{
+  fs_fs_data_t *src_ffd = src_fs->fsap_data;
+  svn_revnum_t min_unpacked_rev = 0;
+
+  if (src_ffd->format < SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
+    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                             _("FSFS format (%d) too old to reshard; "
+                               "please upgrade the filesystem."),
+                             src_ffd->format);
+
+  if (max_files_per_dir <= 0)
+    return svn_error_createf(SVN_ERR_INCORRECT_PARAMS, NULL,
+                             _("Invalid shard size %d"), max_files_per_dir);
+
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  if (src_ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT)
+    SVN_ERR(svn_fs_fs__read_min_unpacked_rev(&min_unpacked_rev, src_fs,
+                                             pool));
+
+  /* Create or catch up with the destination.  Without a format file,
+   * this falls back to a non-incremental copy. */
+  SVN_ERR(hotcopy_to_layout(src_fs, dst_fs, dst_path, max_files_per_dir,
+                            TRUE, jobs, notify_func, notify_baton,
+                            cancel_func, cancel_baton, NULL, pool, pool));
+
+  /* All revisions have been written to non-packed shards.  If the source
+   * was packed, pack the new shards as well. */
+  if (min_unpacked_rev > 0)
+    SVN_ERR(svn_fs_fs__pack(dst_fs, 0, jobs, pack_notify_func, notify_baton,
+                            cancel_func, cancel_baton, pool));
+
+  return SVN_NO_ERROR;
+}
@@ -27,7 +27,9 @@
 
 /* Copy the fsfs filesystem SRC_FS at SRC_PATH into a new copy DST_FS at
  * DST_PATH.  If INCREMENTAL is TRUE, do not re-copy data which already
- * exists in DST_FS.  Indicate progress via the optional NOTIFY_FUNC
+ * exists in DST_FS.  Copy up to JOBS shards concurrently; 'current'
+ * and the min-unpacked-rev file in DST_FS still get updated strictly in
+ * revision order.  Indicate progress via the optional NOTIFY_FUNC
  * callback using NOTIFY_BATON.  Use COMMON_POOL for process-wide and
  * POOL for temporary allocations.  Use COMMON_POOL_LOCK to ensure
  * that the initialization of the shared data is serialized. */
@@ -36,6 +38,7 @@ svn_error_t * svn_fs_fs__hotcopy(svn_fs_t *src_fs,
                                  const char *src_path,
                                  const char *dst_path,
                                  svn_boolean_t incremental,
+                                 int jobs,
                                  svn_fs_hotcopy_notify_t notify_func,
                                  void *notify_baton,
                                  svn_cancel_func_t cancel_func,
@@ -44,4 +47,27 @@ svn_error_t * svn_fs_fs__hotcopy(svn_fs_t *src_fs,
                                  apr_pool_t *pool,
                                  apr_pool_t *common_pool);
 
+/* Bring the fsfs filesystem at DST_PATH up to date with the open
+ * filesystem SRC_FS, using MAX_FILES_PER_DIR revisions per shard in the
+ * destination.  If there is no filesystem at DST_PATH yet, create it in
+ * DST_FS like a hotcopy would.  Otherwise, open it in DST_FS and only
+ * add the revisions that it is still missing.  Finally, pack the
+ * destination if SRC_FS has been packed.
+ *
+ * Revisions are cut out of the source pack files and get new indexes
+ * where necessary.  Process up to JOBS shards concurrently.  Indicate
+ * progress via the optional NOTIFY_FUNC and PACK_NOTIFY_FUNC callbacks,
+ * both using NOTIFY_BATON.  Use POOL for temporary allocations. */
+svn_error_t * svn_fs_fs__reshard(svn_fs_t *src_fs,
+                                 svn_fs_t *dst_fs,
+                                 const char *dst_path,
+                                 int max_files_per_dir,
+                                 int jobs,
+                                 svn_fs_hotcopy_notify_t notify_func,
+                                 svn_fs_pack_notify_t pack_notify_func,
+                                 void *notify_baton,
+                                 svn_cancel_func_t cancel_func,
+                                 void *cancel_baton,
+                                 apr_pool_t *pool);
+
 #endif
@@ -31,6 +31,7 @@
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_temp_serializer.h"
+#include "private/svn_probes.h"
 
 #include "index.h"
 #include "pack.h"
@@ -40,6 +41,14 @@
 
 #include "../libsvn_fs/fs-loader.h"
 
+/* Use SSE2 to find runs of single-byte numbers 16 bytes at a time.  SSE2
+ * is part of the x86-64 base ISA, so there is no need for a runtime check.
+ */
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define SVN_FS_FS__INDEX_USE_SSE2 1
+#endif
+
 /* maximum length of a uint64 in an 7/8b encoding */
 #define ENCODED_INT_LENGTH 10
 
@@ -186,6 +195,10 @@ struct svn_fs_fs__packed_number_stream_t
   /* underlying data file containing the packed values */
   apr_file_t *file;
 
+  /* FILE contents from STREAM_START to STREAM_END mapped into memory,
+   * indexed by file offset.  NULL if FILE is not mapped. */
+  const unsigned char *mapped_data;
+
   /* Offset within FILE at which the stream data starts
    * (i.e. which offset will reported as offset 0 by packed_stream_offset). */
   apr_off_t stream_start;
@@ -250,43 +263,56 @@ SVN__PREVENT_INLINE
 static svn_error_t *
 packed_stream_read(svn_fs_fs__packed_number_stream_t *stream)
 {
-  unsigned char buffer[MAX_NUMBER_PREFETCH];
+  unsigned char file_buffer[MAX_NUMBER_PREFETCH];
+  const unsigned char *buffer = file_buffer;
   apr_size_t bytes_read = 0;
   apr_size_t i;
   value_position_pair_t *target;
   apr_off_t block_start = 0;
   apr_off_t block_left = 0;
-  apr_status_t err;
+  apr_status_t err = APR_SUCCESS;
 
   /* all buffered data will have been read starting here */
   stream->start_offset = stream->next_offset;
 
-  /* packed numbers are usually not aligned to MAX_NUMBER_PREFETCH blocks,
-   * i.e. the last number has been incomplete (and not buffered in stream)
-   * and need to be re-read.  Therefore, always correct the file pointer.
-   */
-  SVN_ERR(svn_io_file_aligned_seek(stream->file, stream->block_size,
-                                   &block_start, stream->next_offset,
-                                   stream->pool));
+  if (stream->mapped_data)
+    {
+      /* Parse the data directly from the mapped file contents, without
+       * any system calls.  Block boundaries don't matter here. */
+      buffer = stream->mapped_data + stream->next_offset;
+      bytes_read = (apr_size_t)MIN(sizeof(file_buffer),
+                                   stream->stream_end - stream->next_offset);
+    }
+  else
+    {
+      /* packed numbers are usually not aligned to MAX_NUMBER_PREFETCH
+       * blocks, i.e. the last number has been incomplete (and not buffered
+       * in stream) and need to be re-read.  Therefore, always correct the
+       * file pointer.
+       */
+      SVN_ERR(svn_io_file_aligned_seek(stream->file, stream->block_size,
+                                       &block_start, stream->next_offset,
+                                       stream->pool));
 
-  /* prefetch at least one number but, if feasible, don't cross block
-   * boundaries.  This shall prevent jumping back and forth between two
-   * blocks because the extra data was not actually request _now_.
-   */
-  bytes_read = sizeof(buffer);
-  block_left = stream->block_size - (stream->next_offset - block_start);
-  if (block_left >= 10 && block_left < bytes_read)
-    bytes_read = (apr_size_t)block_left;
-
-  /* Don't read beyond the end of the file section that belongs to this
-   * index / stream. */
-  bytes_read = (apr_size_t)MIN(bytes_read,
-                               stream->stream_end - stream->next_offset);
-
-  err = apr_file_read(stream->file, buffer, &bytes_read);
-  if (err && !APR_STATUS_IS_EOF(err))
-    return stream_error_create(stream, err,
-      _("Can't read index file '%s' at offset 0x%s"));
+      /* prefetch at least one number but, if feasible, don't cross block
+       * boundaries.  This shall prevent jumping back and forth between two
+       * blocks because the extra data was not actually request _now_.
+       */
+      bytes_read = sizeof(file_buffer);
+      block_left = stream->block_size - (stream->next_offset - block_start);
+      if (block_left >= 10 && block_left < bytes_read)
+        bytes_read = (apr_size_t)block_left;
+
+      /* Don't read beyond the end of the file section that belongs to this
+       * index / stream. */
+      bytes_read = (apr_size_t)MIN(bytes_read,
+                                   stream->stream_end - stream->next_offset);
+
+      err = apr_file_read(stream->file, file_buffer, &bytes_read);
+      if (err && !APR_STATUS_IS_EOF(err))
+        return stream_error_create(stream, err,
+          _("Can't read index file '%s' at offset 0x%s"));
+    }
 
   /* if the last number is incomplete, trim it from the buffer */
   while (bytes_read > 0 && buffer[bytes_read-1] >= 0x80)
@@ -302,6 +328,28 @@ packed_stream_read(svn_fs_fs__packed_number_stream_t *stream)
   target = stream->buffer;
   for (i = 0; i < bytes_read;)
     {
+#ifdef SVN_FS_FS__INDEX_USE_SSE2
+      /* Expand whole runs of numbers < 128 at once.  Bit N in MASK is set
+       * iff byte N is a continuation byte. */
+      if (i + sizeof(__m128i) <= bytes_read)
+        {
+          __m128i chunk = _mm_loadu_si128((const __m128i *)(buffer + i));
+          unsigned int mask = (unsigned int)_mm_movemask_epi8(chunk);
+          apr_size_t run_end = i + __builtin_ctz(mask | 0x10000);
+
+          while (i < run_end)
+            {
+              target->value = buffer[i];
+              ++i;
+              target->total_len = i;
+              ++target;
+            }
+
+          if (i >= bytes_read || buffer[i] < 0x80)
+            continue;
+        }
+#endif
+
       if (buffer[i] < 0x80)
         {
           /* numbers < 128 are relatively frequent and particularly easy
@@ -344,13 +392,14 @@ packed_stream_read(svn_fs_fs__packed_number_stream_t *stream)
 }
 
 /* Create and open a packed number stream reading from offsets START to
- * END in FILE and return it in *STREAM.  Access the file in chunks of
- * BLOCK_SIZE bytes.  Expect the stream to be prefixed by STREAM_PREFIX.
- * Allocate *STREAM in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ * END in REV_FILE and return it in *STREAM.  Access the file in chunks of
+ * BLOCK_SIZE bytes, unless it has been mapped into memory.  Expect the
+ * stream to be prefixed by STREAM_PREFIX.  Allocate *STREAM in RESULT_POOL
+ * and use SCRATCH_POOL for temporaries.
  */
 static svn_error_t *
 packed_stream_open(svn_fs_fs__packed_number_stream_t **stream,
-                   apr_file_t *file,
+                   svn_fs_fs__revision_file_t *rev_file,
                    apr_off_t start,
                    apr_off_t end,
                    const char *stream_prefix,
@@ -361,16 +410,26 @@ packed_stream_open(svn_fs_fs__packed_number_stream_t **stream,
   char buffer[STREAM_PREFIX_LEN + 1] = { 0 };
   apr_size_t len = strlen(stream_prefix);
   svn_fs_fs__packed_number_stream_t *result;
+  const char *mapped_data;
 
   /* If this is violated, we forgot to adjust STREAM_PREFIX_LEN after
    * changing the index header prefixes. */
   SVN_ERR_ASSERT(len < sizeof(buffer));
 
   /* Read the header prefix and compare it with the expected prefix */
-  SVN_ERR(svn_io_file_aligned_seek(file, block_size, NULL, start,
-                                   scratch_pool));
-  SVN_ERR(svn_io_file_read_full2(file, buffer, len, NULL, NULL,
-                                 scratch_pool));
+  mapped_data = svn_fs_fs__rev_file_mapped(rev_file, start, end - start);
+  if (mapped_data && end - start >= (apr_off_t)len)
+    {
+      memcpy(buffer, mapped_data, len);
+    }
+  else
+    {
+      mapped_data = NULL;
+      SVN_ERR(svn_io_file_aligned_seek(rev_file->file, block_size, NULL,
+                                       start, scratch_pool));
+      SVN_ERR(svn_io_file_read_full2(rev_file->file, buffer, len, NULL,
+                                     NULL, scratch_pool));
+    }
 
   if (strncmp(buffer, stream_prefix, len))
     return svn_error_createf(SVN_ERR_FS_INDEX_CORRUPTION, NULL,
@@ -382,7 +441,10 @@ packed_stream_open(svn_fs_fs__packed_number_stream_t **stream,
   result = apr_palloc(result_pool, sizeof(*result));
 
   result->pool = result_pool;
-  result->file = file;
+  result->file = rev_file->file;
+  result->mapped_data = mapped_data
+                      ? (const unsigned char *)rev_file->mapped_data
+                      : NULL;
   result->stream_start = start + len;
   result->stream_end = end;
 
@@ -932,6 +994,18 @@ svn_fs_fs__l2p_index_append(svn_checksum_t **checksum,
   return SVN_NO_ERROR;
 }
 
+/* Return the value to use as the "is packed" part of index cache keys
+ * for REV_FILE.  For pack files, it is non-zero and includes the file's
+ * generation, so that a pack file replaced by svn_fs_fs__repack never
+ * picks up index data cached for its predecessor.
+ */
+static svn_boolean_t
+cache_key_packed(const svn_fs_fs__revision_file_t *rev_file)
+{
+  return rev_file->is_packed ? (svn_boolean_t)(rev_file->generation | 1)
+                             : FALSE;
+}
+
 /* If REV_FILE->L2P_STREAM is NULL, create a new stream for the log-to-phys
  * index for REVISION in FS and return it in REV_FILE.
  */
@@ -946,7 +1020,7 @@ auto_open_l2p_index(svn_fs_fs__revision_file_t *rev_file,
 
       SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
       SVN_ERR(packed_stream_open(&rev_file->l2p_stream,
-                                 rev_file->file,
+                                 rev_file,
                                  rev_file->l2p_offset,
                                  rev_file->p2l_offset,
                                  L2P_STREAM_PREFIX,
@@ -981,7 +1055,7 @@ get_l2p_header_body(l2p_header_t **header,
 
   pair_cache_key_t key;
   key.revision = rev_file->start_revision;
-  key.second = rev_file->is_packed;
+  key.second = cache_key_packed(rev_file);
 
   SVN_ERR(auto_open_l2p_index(rev_file, fs, revision));
   packed_stream_seek(rev_file->l2p_stream, 0);
@@ -1213,7 +1287,7 @@ get_l2p_page_info(l2p_page_info_baton_t *baton,
   /* try to find the info in the cache */
   pair_cache_key_t key;
   key.revision = rev_file->start_revision;
-  key.second = rev_file->is_packed;
+  key.second = cache_key_packed(rev_file);
   SVN_ERR(svn_cache__get_partial((void**)&dummy, &is_cached,
                                  ffd->l2p_header_cache, &key,
                                  l2p_page_info_access_func, baton,
@@ -1303,7 +1377,7 @@ get_l2p_page_table(apr_array_header_t *pages,
 
   pair_cache_key_t key;
   key.revision = rev_file->start_revision;
-  key.second = rev_file->is_packed;
+  key.second = cache_key_packed(rev_file);
 
   apr_array_clear(pages);
   baton.revision = revision;
@@ -1415,7 +1489,7 @@ prefetch_l2p_pages(svn_boolean_t *end,
   iterpool = svn_pool_create(scratch_pool);
   assert(revision <= APR_UINT32_MAX);
   key.revision = (apr_uint32_t)revision;
-  key.is_packed = rev_file->is_packed;
+  key.is_packed = cache_key_packed(rev_file);
 
   for (i = 0; i < pages->nelts && !*end; ++i)
     {
@@ -1521,6 +1595,85 @@ l2p_entry_access_func(void **out,
   return l2p_page_get_entry(baton, page, offsets, result_pool);
 }
 
+/* Request data structure for l2p_entries_access_func.
+ */
+typedef struct l2p_entries_baton_t
+{
+  /* in data */
+  /* revision. Used for error messages only */
+  svn_revnum_t revision;
+
+  /* item indexes to look up, the first one of which is on the page */
+  const apr_uint64_t *item_indexes;
+
+  /* number of elements in ITEM_INDEXES */
+  int count;
+
+  /* item index of the first entry in the cached page */
+  apr_uint64_t first_item;
+
+  /* out data */
+  /* receives the absolute item or container offsets in rev / pack file */
+  apr_off_t *offsets;
+
+  /* number of leading ITEM_INDEXES that have been resolved */
+  int found;
+} l2p_entries_baton_t;
+
+/* Resolve the longest prefix of BATON->ITEM_INDEXES that is covered by
+ * PAGE with the given OFFSETS into BATON->OFFSETS.
+ */
+static svn_error_t *
+l2p_page_get_entries(l2p_entries_baton_t *baton,
+                     const l2p_page_t *page,
+                     const apr_uint64_t *offsets,
+                     apr_pool_t *scratch_pool)
+{
+  int i;
+  for (i = 0; i < baton->count; ++i)
+    {
+      apr_uint64_t item_index = baton->item_indexes[i];
+      if (   item_index < baton->first_item
+          || item_index - baton->first_item >= page->entry_count)
+        break;
+
+      baton->offsets[i] = (apr_off_t)offsets[item_index - baton->first_item];
+    }
+
+  /* overflow check.  The first item has been mapped to this page. */
+  if (i == 0)
+    return svn_error_createf(SVN_ERR_FS_INDEX_OVERFLOW , NULL,
+                             _("Item index %s"
+                               " too large in revision %ld"),
+                             apr_psprintf(scratch_pool, "%" APR_UINT64_T_FMT,
+                                          baton->item_indexes[0]),
+                             baton->revision);
+
+  baton->found = i;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_cache__partial_getter_func_t: copy the data requested in
+ * l2p_entries_baton_t *BATON from l2p_page_t *DATA into BATON->OFFSETS.
+ * *OUT remains unchanged.
+ */
+static svn_error_t *
+l2p_entries_access_func(void **out,
+                        const void *data,
+                        apr_size_t data_len,
+                        void *baton,
+                        apr_pool_t *result_pool)
+{
+  /* resolve all in-cache pointers */
+  const l2p_page_t *page = data;
+  const apr_uint64_t *offsets
+    = svn_temp_deserializer__ptr(page, (const void *const *)&page->offsets);
+
+  /* return the requested data */
+  return l2p_page_get_entries(baton, page, offsets, result_pool);
+}
+
 /* Using the log-to-phys indexes in FS, find the absolute offset in the
  * rev file for (REVISION, ITEM_INDEX) and return it in *OFFSET.
  * Use SCRATCH_POOL for temporary allocations.
@@ -1554,7 +1707,7 @@ l2p_index_lookup(apr_off_t *offset,
 
   assert(revision <= APR_UINT32_MAX);
   key.revision = (apr_uint32_t)revision;
-  key.is_packed = svn_fs_fs__is_packed_rev(fs, revision);
+  key.is_packed = cache_key_packed(rev_file);
   key.page = info_baton.page_no;
 
   SVN_ERR(svn_cache__get_partial(&dummy, &is_cached,
@@ -1632,6 +1785,76 @@ l2p_index_lookup(apr_off_t *offset,
   return SVN_NO_ERROR;
 }
 
+/* Like l2p_index_lookup but resolve all COUNT ITEM_INDEXES of REVISION
+ * into the respective elements of OFFSETS.  Consecutive items on the same
+ * index page are resolved with a single page and header lookup.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+l2p_index_lookup_batch(apr_off_t *offsets,
+                       svn_fs_t *fs,
+                       svn_fs_fs__revision_file_t *rev_file,
+                       svn_revnum_t revision,
+                       const apr_uint64_t *item_indexes,
+                       int count,
+                       apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_fs_fs__page_cache_key_t key = { 0 };
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i = 0;
+
+  assert(revision <= APR_UINT32_MAX);
+  key.revision = (apr_uint32_t)revision;
+  key.is_packed = cache_key_packed(rev_file);
+
+  while (i < count)
+    {
+      l2p_page_info_baton_t info_baton;
+      l2p_entries_baton_t page_baton;
+      svn_boolean_t is_cached = FALSE;
+      void *dummy = NULL;
+
+      svn_pool_clear(iterpool);
+
+      /* locate the page that contains the next item */
+      info_baton.revision = revision;
+      info_baton.item_index = item_indexes[i];
+      SVN_ERR(get_l2p_page_info(&info_baton, rev_file, fs, iterpool));
+
+      /* resolve all following items on that page */
+      page_baton.revision = revision;
+      page_baton.item_indexes = item_indexes + i;
+      page_baton.count = count - i;
+      page_baton.first_item = item_indexes[i] - info_baton.page_offset;
+      page_baton.offsets = offsets + i;
+      page_baton.found = 0;
+
+      key.page = info_baton.page_no;
+      SVN_ERR(svn_cache__get_partial(&dummy, &is_cached,
+                                     ffd->l2p_page_cache, &key,
+                                     l2p_entries_access_func, &page_baton,
+                                     iterpool));
+
+      if (is_cached)
+        {
+          i += page_baton.found;
+        }
+      else
+        {
+          /* Let the standard lookup read, cache and prefetch the page.
+           * The next items on it will then be found in the cache. */
+          SVN_ERR(l2p_index_lookup(&offsets[i], fs, rev_file, revision,
+                                   item_indexes[i], iterpool));
+          ++i;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Using the log-to-phys proto index in transaction TXN_ID in FS, find the
  * absolute offset in the proto rev file for the given ITEM_INDEX and return
  * it in *OFFSET.  Use SCRATCH_POOL for temporary allocations.
@@ -1693,7 +1916,7 @@ get_l2p_header(l2p_header_t **header,
   /* first, try cache lookop */
   pair_cache_key_t key;
   key.revision = rev_file->start_revision;
-  key.second = rev_file->is_packed;
+  key.second = cache_key_packed(rev_file);
   SVN_ERR(svn_cache__get((void**)header, &is_cached, ffd->l2p_header_cache,
                          &key, result_pool));
   if (is_cached)
@@ -1777,6 +2000,8 @@ svn_fs_fs__item_offset(apr_off_t *absolute_position,
                        apr_pool_t *scratch_pool)
 {
   svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_PROBE2(fsfs__item__offset__start, revision, item_index);
   if (txn_id)
     {
       if (svn_fs_fs__use_log_addressing(fs))
@@ -1794,9 +2019,12 @@ svn_fs_fs__item_offset(apr_off_t *absolute_position,
     }
   else if (svn_fs_fs__use_log_addressing(fs))
     {
+      fs_fs_data_t *ffd = fs->fsap_data;
+
       /* ordinary index lookup */
       SVN_ERR(l2p_index_lookup(absolute_position, fs, rev_file, revision,
                                item_index, scratch_pool));
+      ffd->io_stats.index_lookups++;
     }
   else if (rev_file->is_packed)
     {
@@ -1813,9 +2041,53 @@ svn_fs_fs__item_offset(apr_off_t *absolute_position,
       *absolute_position = item_index;
     }
 
+  SVN_PROBE3(fsfs__item__offset__done, revision, item_index,
+             *absolute_position);
   return svn_error_trace(err);
 }
 
+svn_error_t *
+svn_fs_fs__item_offsets(apr_array_header_t **absolute_positions,
+                        svn_fs_t *fs,
+                        svn_fs_fs__revision_file_t *rev_file,
+                        svn_revnum_t revision,
+                        const apr_array_header_t *item_indexes,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  apr_off_t *positions;
+  int i;
+
+  *absolute_positions = apr_array_make(result_pool, item_indexes->nelts,
+                                       sizeof(apr_off_t));
+  (*absolute_positions)->nelts = item_indexes->nelts;
+  positions = (apr_off_t *)(*absolute_positions)->elts;
+
+  if (svn_fs_fs__use_log_addressing(fs))
+    {
+      fs_fs_data_t *ffd = fs->fsap_data;
+
+      SVN_ERR(l2p_index_lookup_batch(positions, fs, rev_file, revision,
+                                     (const apr_uint64_t *)item_indexes->elts,
+                                     item_indexes->nelts, scratch_pool));
+      ffd->io_stats.index_lookups += item_indexes->nelts;
+    }
+  else
+    {
+      /* physical addressing: item indexes are offsets within the rev */
+      apr_off_t rev_offset = 0;
+      if (rev_file->is_packed)
+        SVN_ERR(svn_fs_fs__get_packed_offset(&rev_offset, fs, revision,
+                                             scratch_pool));
+
+      for (i = 0; i < item_indexes->nelts; ++i)
+        positions[i] = rev_offset
+                     + APR_ARRAY_IDX(item_indexes, i, apr_uint64_t);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /*
  * phys-to-log index
  */
@@ -2138,7 +2410,7 @@ auto_open_p2l_index(svn_fs_fs__revision_file_t *rev_file,
 
       SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
       SVN_ERR(packed_stream_open(&rev_file->p2l_stream,
-                                 rev_file->file,
+                                 rev_file,
                                  rev_file->p2l_offset,
                                  rev_file->footer_offset,
                                  P2L_STREAM_PREFIX,
@@ -2173,7 +2445,7 @@ get_p2l_header(p2l_header_t **header,
   /* look for the header data in our cache */
   pair_cache_key_t key;
   key.revision = rev_file->start_revision;
-  key.second = rev_file->is_packed;
+  key.second = cache_key_packed(rev_file);
 
   SVN_ERR(svn_cache__get((void**)header, &is_cached, ffd->p2l_header_cache,
                          &key, result_pool));
@@ -2348,7 +2620,7 @@ get_p2l_page_info(p2l_page_info_baton_t *baton,
   /* look for the header data in our cache */
   pair_cache_key_t key;
   key.revision = rev_file->start_revision;
-  key.second = rev_file->is_packed;
+  key.second = cache_key_packed(rev_file);
 
   SVN_ERR(svn_cache__get_partial(&dummy, &is_cached, ffd->p2l_header_cache,
                                  &key, p2l_page_info_func, baton,
@@ -2555,7 +2827,7 @@ prefetch_p2l_page(svn_boolean_t *end,
   /* do we have that page in our caches already? */
   assert(baton->first_revision <= APR_UINT32_MAX);
   key.revision = (apr_uint32_t)baton->first_revision;
-  key.is_packed = svn_fs_fs__is_packed_rev(fs, baton->first_revision);
+  key.is_packed = cache_key_packed(rev_file);
   key.page = baton->page_no;
   SVN_ERR(svn_cache__has_key(&already_cached, ffd->p2l_page_cache,
                              &key, scratch_pool));
@@ -2626,7 +2898,7 @@ get_p2l_keys(p2l_page_info_baton_t *page_info_p,
       svn_fs_fs__page_cache_key_t key = { 0 };
       assert(page_info.first_revision <= APR_UINT32_MAX);
       key.revision = (apr_uint32_t)page_info.first_revision;
-      key.is_packed = rev_file->is_packed;
+      key.is_packed = cache_key_packed(rev_file);
       key.page = page_info.page_no;
 
       *key_p = key;
@@ -2885,6 +3157,7 @@ svn_fs_fs__p2l_index_lookup(apr_array_header_t **entries,
                             apr_pool_t *result_pool,
                             apr_pool_t *scratch_pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   apr_off_t block_end = block_start + block_size;
 
   /* the receiving container */
@@ -2920,6 +3193,7 @@ svn_fs_fs__p2l_index_lookup(apr_array_header_t **entries,
       last_count = result->nelts;
     }
 
+  ffd->io_stats.index_lookups++;
   *entries = result;
   return SVN_NO_ERROR;
 }
@@ -3001,6 +3275,7 @@ svn_fs_fs__p2l_entry_lookup(svn_fs_fs__p2l_entry_t **entry_p,
   p2l_page_info_baton_t page_info;
 
   *entry_p = NULL;
+  ffd->io_stats.index_lookups++;
 
   /* look for this info in our cache */
   SVN_ERR(get_p2l_keys(&page_info, &key, rev_file, fs, revision, offset,
@@ -3060,7 +3335,7 @@ p2l_get_max_offset(apr_off_t *offset,
   /* look for the header data in our cache */
   pair_cache_key_t key;
   key.revision = rev_file->start_revision;
-  key.second = rev_file->is_packed;
+  key.second = cache_key_packed(rev_file);
 
   SVN_ERR(svn_cache__get_partial((void **)&offset_p, &is_cached,
                                  ffd->p2l_header_cache, &key,
@@ -200,6 +200,25 @@ svn_fs_fs__item_offset(apr_off_t *absolute_position,
                        apr_uint64_t item_index,
                        apr_pool_t *scratch_pool);
 
+/* Like svn_fs_fs__item_offset but for all apr_uint64_t elements in
+ * ITEM_INDEXES of the committed revision REV at once.  Return the
+ * positions as an array of apr_off_t with the same number of elements in
+ * *ABSOLUTE_POSITIONS, allocated in RESULT_POOL.
+ *
+ * ITEM_INDEXES should be sorted in ascending order.  Consecutive items on
+ * the same index page will then be resolved in a single pass over that
+ * page.  REV_FILE must not be NULL.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__item_offsets(apr_array_header_t **absolute_positions,
+                        svn_fs_t *fs,
+                        svn_fs_fs__revision_file_t *rev_file,
+                        svn_revnum_t revision,
+                        const apr_array_header_t *item_indexes,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool);
+
 /* Use the log-to-phys indexes in FS to determine the maximum item indexes
  * assigned to revision START_REV to START_REV + COUNT - 1.  That is a
  * close upper limit to the actual number of items in the respective revs.
@@ -269,7 +288,8 @@ typedef struct svn_fs_fs__page_cache_key_t
      in p2l: this is the start revision identifying the pack / rev file */
   apr_uint32_t revision;
 
-  /* if TRUE, this is the index to a pack file
+  /* if non-zero, this is the index to a pack file.  The value also
+   * identifies the generation of that pack file.
    */
   svn_boolean_t is_packed;
 
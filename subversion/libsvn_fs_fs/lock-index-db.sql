@@ -0,0 +1,76 @@
+/* lock-index-db.sql -- schema of the FSFS lock index
+ *   This is intended for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+/* Every lock in the repository.  CREATION_DATE and EXPIRATION_DATE are
+   apr_time_t values, EXPIRATION_DATE being 0 for locks that don't
+   expire. */
+CREATE TABLE locks (
+  path TEXT NOT NULL PRIMARY KEY,
+  token TEXT NOT NULL,
+  owner TEXT NOT NULL,
+  comment TEXT,
+  is_dav_comment INTEGER NOT NULL,
+  creation_date INTEGER NOT NULL,
+  expiration_date INTEGER NOT NULL
+  );
+
+/* The single row of this table identifies the state of the lock digest
+   files that the LOCKS table matches.  See lock_index.h. */
+CREATE TABLE stamp (
+  id INTEGER NOT NULL PRIMARY KEY CHECK (id = 0),
+  stamp TEXT NOT NULL
+  );
+
+PRAGMA USER_VERSION = 1;
+
+-- STMT_GET_STAMP
+SELECT stamp
+FROM stamp
+WHERE id = 0
+
+-- STMT_SET_STAMP
+INSERT OR REPLACE INTO stamp (id, stamp)
+VALUES (0, ?1)
+
+-- STMT_CLEAR_LOCKS
+DELETE FROM locks
+
+-- STMT_INSERT_LOCK
+INSERT OR REPLACE INTO locks (path, token, owner, comment, is_dav_comment,
+                              creation_date, expiration_date)
+VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7)
+
+-- STMT_DELETE_LOCK
+DELETE FROM locks
+WHERE path = ?1
+
+-- STMT_GET_LOCKS
+/* The lock on ?1 and, unless ?2 is NULL, the locks below it.  ?2 is ?1
+   but empty for the root.  In path order. */
+SELECT path, token, owner, comment, is_dav_comment, creation_date,
+       expiration_date
+FROM locks
+WHERE path = ?1
+  OR (path > ?2 || '/' AND path < ?2 || '0')
+ORDER BY path
@@ -34,6 +34,7 @@
 #include <apr_file_info.h>
 
 #include "lock.h"
+#include "lock_index.h"
 #include "tree.h"
 #include "fs_fs.h"
 #include "util.h"
@@ -330,6 +331,185 @@ read_digest_file(apr_hash_t **children_p,
   return SVN_NO_ERROR;
 }
 
+/* Set *LOCKS to an array of all svn_lock_t * in FS, including expired
+   ones.  ROOT_LOCK and ROOT_CHILDREN are the contents of the root digest
+   file of FS, which lists every lock in the repository.  Use POOL for
+   all allocations. */
+static svn_error_t *
+read_locks_of_root(apr_array_header_t **locks,
+                   svn_fs_t *fs,
+                   svn_lock_t *root_lock,
+                   apr_hash_t *root_children,
+                   apr_pool_t *pool)
+{
+  apr_hash_index_t *hi;
+  svn_lock_t *lock;
+
+  *locks = apr_array_make(pool, apr_hash_count(root_children) + 1,
+                          sizeof(svn_lock_t *));
+  if (root_lock)
+    APR_ARRAY_PUSH(*locks, svn_lock_t *) = root_lock;
+
+  for (hi = apr_hash_first(pool, root_children); hi; hi = apr_hash_next(hi))
+    {
+      const char *digest = apr_hash_this_key(hi);
+
+      SVN_ERR(read_digest_file(NULL, &lock, fs->path,
+                               digest_path_from_digest(fs->path, digest,
+                                                       pool),
+                               pool));
+      if (lock)
+        APR_ARRAY_PUSH(*locks, svn_lock_t *) = lock;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *LOCKS to an array of all svn_lock_t * in FS, read from the digest
+   files, including expired ones.  Use POOL for all allocations. */
+static svn_error_t *
+read_all_locks(apr_array_header_t **locks,
+               svn_fs_t *fs,
+               apr_pool_t *pool)
+{
+  apr_hash_t *children;
+  const char *digest_path;
+  svn_lock_t *lock;
+
+  SVN_ERR(digest_path_from_path(&digest_path, fs->path, "/", pool));
+  SVN_ERR(read_digest_file(&children, &lock, fs->path, digest_path, pool));
+
+  return svn_error_trace(read_locks_of_root(locks, fs, lock, children,
+                                            pool));
+}
+
+
+
+/*** Lock index handling functions.  See lock_index.h. ***/
+
+/* The stamp of a repository without any locks. */
+#define NO_LOCKS_STAMP "none"
+
+/* Set *STAMP to a string that identifies the current state of the root
+   digest file of FS, which every lock and unlock that changes the set of
+   locked paths rewrites.  Use POOL for all allocations. */
+static svn_error_t *
+root_digest_stamp(const char **stamp,
+                  svn_fs_t *fs,
+                  apr_pool_t *pool)
+{
+  const char *digest_path;
+  apr_finfo_t finfo;
+  svn_error_t *err;
+
+  SVN_ERR(digest_path_from_path(&digest_path, fs->path, "/", pool));
+  err = svn_io_stat(&finfo, digest_path, APR_FINFO_SIZE | APR_FINFO_MTIME,
+                    pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *stamp = NO_LOCKS_STAMP;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  *stamp = apr_psprintf(pool, "%" APR_OFF_T_FMT " %" APR_TIME_T_FMT,
+                        finfo.size, finfo.mtime);
+  return SVN_NO_ERROR;
+}
+
+/* Set *USABLE to TRUE if the lock index of FS matches its digest files.
+   HAVE_WRITE_LOCK should be TRUE if the caller (or one of its callers)
+   has taken out the repository-wide write lock; in that case, rebuild a
+   stale index.  The index is advisory, so failures to read or rebuild it
+   just set *USABLE to FALSE.  Use POOL for temporary allocations. */
+static svn_error_t *
+lock_index_usable(svn_boolean_t *usable,
+                  svn_fs_t *fs,
+                  svn_boolean_t have_write_lock,
+                  apr_pool_t *pool)
+{
+  const char *index_stamp, *stamp;
+  apr_array_header_t *locks;
+  svn_error_t *err;
+
+  *usable = FALSE;
+
+  err = svn_fs_fs__lock_index_get_stamp(&index_stamp, fs, pool, pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(root_digest_stamp(&stamp, fs, pool));
+  if (index_stamp && strcmp(index_stamp, stamp) == 0)
+    {
+      *usable = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  /* Only writers may rebuild the index.  Don't create it just to find
+     out that there are no locks. */
+  if (!have_write_lock
+      || (!index_stamp && strcmp(stamp, NO_LOCKS_STAMP) == 0))
+    return SVN_NO_ERROR;
+
+  /* Nobody can change the digest files while we hold the write lock. */
+  SVN_ERR(read_all_locks(&locks, fs, pool));
+  err = svn_fs_fs__lock_index_update(fs, TRUE, NULL, locks, stamp, pool);
+  if (err)
+    svn_error_clear(err);
+  else
+    *usable = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Prepare the lock index of FS for a lock or unlock operation that is
+   about to change the digest files: bring the index up to date and mark
+   it stale until finish_lock_index() records the new state.  The caller
+   must hold the write lock.  Use POOL for temporary allocations. */
+static svn_error_t *
+prepare_lock_index(svn_fs_t *fs,
+                   apr_pool_t *pool)
+{
+  const char *index_stamp, *stamp;
+  apr_array_header_t *locks = NULL;
+  svn_boolean_t reset;
+
+  SVN_ERR(svn_fs_fs__lock_index_get_stamp(&index_stamp, fs, pool, pool));
+  SVN_ERR(root_digest_stamp(&stamp, fs, pool));
+
+  reset = !index_stamp || strcmp(index_stamp, stamp) != 0;
+  if (reset)
+    SVN_ERR(read_all_locks(&locks, fs, pool));
+
+  /* An empty stamp matches no state of the digest files. */
+  return svn_error_trace(svn_fs_fs__lock_index_update(fs, reset, NULL,
+                                                      locks, "", pool));
+}
+
+/* Remove the locks on the const char * paths in DELETED_PATHS from the
+   lock index of FS, add the svn_lock_t * in LOCKS and record the new state
+   of the digest files.  Either array may be NULL.  Errors are not fatal
+   because prepare_lock_index() left the index marked stale.  The caller
+   must hold the write lock.  Use POOL for temporary allocations. */
+static svn_error_t *
+finish_lock_index(svn_fs_t *fs,
+                  apr_array_header_t *deleted_paths,
+                  apr_array_header_t *locks,
+                  apr_pool_t *pool)
+{
+  const char *stamp;
+
+  SVN_ERR(root_digest_stamp(&stamp, fs, pool));
+  svn_error_clear(svn_fs_fs__lock_index_update(fs, FALSE, deleted_paths,
+                                               locks, stamp, pool));
+
+  return SVN_NO_ERROR;
+}
+
 
 
 /*** Lock helper functions (path here are still FS paths, not on-disk
@@ -534,16 +714,16 @@ get_lock_helper(svn_fs_t *fs,
 
 
 /* A function that calls GET_LOCKS_FUNC/GET_LOCKS_BATON for
-   all locks in and under PATH in FS.
+   all locks in and under the path with the digest file DIGEST_PATH in FS.
    HAVE_WRITE_LOCK should be true if the caller (directly or indirectly)
    has the FS write lock. */
 static svn_error_t *
-walk_locks(svn_fs_t *fs,
-           const char *digest_path,
-           svn_fs_get_locks_callback_t get_locks_func,
-           void *get_locks_baton,
-           svn_boolean_t have_write_lock,
-           apr_pool_t *pool)
+walk_digest_files(svn_fs_t *fs,
+                  const char *digest_path,
+                  svn_fs_get_locks_callback_t get_locks_func,
+                  void *get_locks_baton,
+                  svn_boolean_t have_write_lock,
+                  apr_pool_t *pool)
 {
   apr_hash_index_t *hi;
   apr_hash_t *children;
@@ -594,6 +774,63 @@ walk_locks(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* Like walk_digest_files() but for all locks in and under PATH.  Take
+   them from the lock index if that is up to date. */
+static svn_error_t *
+walk_locks(svn_fs_t *fs,
+           const char *path,
+           svn_fs_get_locks_callback_t get_locks_func,
+           void *get_locks_baton,
+           svn_boolean_t have_write_lock,
+           apr_pool_t *pool)
+{
+  const char *digest_path;
+  svn_boolean_t usable;
+
+  SVN_ERR(lock_index_usable(&usable, fs, have_write_lock, pool));
+  if (usable)
+    {
+      apr_array_header_t *locks;
+      svn_error_t *err;
+
+      err = svn_fs_fs__lock_index_find(&locks, fs, path, TRUE, pool, pool);
+      if (!err && locks)
+        {
+          apr_pool_t *iterpool = svn_pool_create(pool);
+          int i;
+
+          for (i = 0; i < locks->nelts; ++i)
+            {
+              svn_lock_t *lock = APR_ARRAY_IDX(locks, i, svn_lock_t *);
+
+              svn_pool_clear(iterpool);
+              if (lock_expired(lock))
+                {
+                  /* Only remove the lock if we have the write lock.
+                     Read operations shouldn't change the filesystem. */
+                  if (have_write_lock)
+                    SVN_ERR(unlock_single(fs, lock, iterpool));
+                }
+              else
+                {
+                  SVN_ERR(get_locks_func(get_locks_baton, lock, iterpool));
+                }
+            }
+          svn_pool_destroy(iterpool);
+
+          return SVN_NO_ERROR;
+        }
+
+      /* The index is advisory; fall back to the digest files. */
+      svn_error_clear(err);
+    }
+
+  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
+  return svn_error_trace(walk_digest_files(fs, digest_path, get_locks_func,
+                                           get_locks_baton, have_write_lock,
+                                           pool));
+}
+
 
 /* Utility function:  verify that a lock can be used.  Interesting
    errors returned from this function:
@@ -652,9 +889,7 @@ svn_fs_fs__allow_locked_operation(const char *path,
   if (recurse)
     {
       /* Discover all locks at or below the path. */
-      const char *digest_path;
-      SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-      SVN_ERR(walk_locks(fs, digest_path, get_locks_callback,
+      SVN_ERR(walk_locks(fs, path, get_locks_callback,
                          fs, have_write_lock, pool));
     }
   else
@@ -668,6 +903,147 @@ svn_fs_fs__allow_locked_operation(const char *path,
   return SVN_NO_ERROR;
 }
 
+/* Verify all locks in the array LOCKS of svn_lock_t * in FS with
+   verify_lock().  LOCKS may be NULL.  Use POOL for temporary
+   allocations. */
+static svn_error_t *
+verify_lock_array(svn_fs_t *fs,
+                  apr_array_header_t *locks,
+                  apr_pool_t *pool)
+{
+  int i;
+
+  for (i = 0; locks && i < locks->nelts; ++i)
+    SVN_ERR(verify_lock(fs, APR_ARRAY_IDX(locks, i, svn_lock_t *), pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Add LOCK to the array in LOCKS_BY_PATH stored under PATH, creating the
+   array in the hash pool if necessary. */
+static void
+add_lock_to_index(apr_hash_t *locks_by_path,
+                  const char *path,
+                  svn_lock_t *lock)
+{
+  apr_array_header_t *locks = svn_hash_gets(locks_by_path, path);
+
+  if (!locks)
+    {
+      apr_pool_t *hash_pool = apr_hash_pool_get(locks_by_path);
+      locks = apr_array_make(hash_pool, 1, sizeof(svn_lock_t *));
+      svn_hash_sets(locks_by_path, path, locks);
+    }
+
+  APR_ARRAY_PUSH(locks, svn_lock_t *) = lock;
+}
+
+svn_error_t *
+svn_fs_fs__allow_locked_operations(svn_fs_t *fs,
+                                   apr_array_header_t *paths,
+                                   apr_array_header_t *recursive_paths,
+                                   svn_boolean_t have_write_lock,
+                                   apr_pool_t *pool)
+{
+  apr_hash_t *children = NULL;
+  apr_array_header_t *all_locks;
+  apr_hash_t *locks_at;
+  apr_hash_t *locks_below;
+  apr_pool_t *iterpool;
+  const char *digest_path;
+  svn_lock_t *lock = NULL;
+  svn_boolean_t use_index;
+  int i;
+
+  /* With an up-to-date lock index, recursive checks are cheap range
+     queries and we don't need to look at the root digest file. */
+  SVN_ERR(lock_index_usable(&use_index, fs, have_write_lock, pool));
+  if (!use_index)
+    {
+      /* The root's entries list every lock in the repository. */
+      SVN_ERR(digest_path_from_path(&digest_path, fs->path, "/", pool));
+      SVN_ERR(read_digest_file(&children, &lock, fs->path, digest_path,
+                               pool));
+      if (!lock && apr_hash_count(children) == 0)
+        return SVN_NO_ERROR;
+    }
+
+  /* With only a few paths to check, probing their digest files
+     individually is cheaper than reading all locks. */
+  if (use_index
+      || apr_hash_count(children)
+         >= (unsigned int)(paths->nelts + recursive_paths->nelts))
+    {
+      iterpool = svn_pool_create(pool);
+      for (i = 0; i < paths->nelts; ++i)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(svn_fs_fs__allow_locked_operation(
+                    APR_ARRAY_IDX(paths, i, const char *), fs, FALSE,
+                    have_write_lock, iterpool));
+        }
+      for (i = 0; i < recursive_paths->nelts; ++i)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(svn_fs_fs__allow_locked_operation(
+                    APR_ARRAY_IDX(recursive_paths, i, const char *), fs,
+                    TRUE, have_write_lock, iterpool));
+        }
+      svn_pool_destroy(iterpool);
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Read all locks once. */
+  SVN_ERR(read_locks_of_root(&all_locks, fs, lock, children, pool));
+
+  /* Index them by their path as well as by the paths of all their
+     parents. */
+  locks_at = apr_hash_make(pool);
+  locks_below = apr_hash_make(pool);
+  for (i = 0; i < all_locks->nelts; ++i)
+    {
+      const char *parent_path;
+
+      lock = APR_ARRAY_IDX(all_locks, i, svn_lock_t *);
+      if (lock_expired(lock))
+        {
+          /* Only remove the lock if we have the write lock.
+             Read operations shouldn't change the filesystem. */
+          if (have_write_lock)
+            SVN_ERR(unlock_single(fs, lock, pool));
+          continue;
+        }
+
+      add_lock_to_index(locks_at, lock->path, lock);
+      for (parent_path = lock->path;
+           !svn_fspath__is_root(parent_path, strlen(parent_path)); )
+        {
+          parent_path = svn_fspath__dirname(parent_path, pool);
+          add_lock_to_index(locks_below, parent_path, lock);
+        }
+    }
+
+  /* Now check all paths against the index. */
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      const char *path = svn_fs__canonicalize_abspath(
+                           APR_ARRAY_IDX(paths, i, const char *), pool);
+      SVN_ERR(verify_lock_array(fs, svn_hash_gets(locks_at, path), pool));
+    }
+
+  for (i = 0; i < recursive_paths->nelts; ++i)
+    {
+      const char *path = svn_fs__canonicalize_abspath(
+                           APR_ARRAY_IDX(recursive_paths, i, const char *),
+                           pool);
+      SVN_ERR(verify_lock_array(fs, svn_hash_gets(locks_at, path), pool));
+      SVN_ERR(verify_lock_array(fs, svn_hash_gets(locks_below, path), pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Helper function called from the lock and unlock code.
    UPDATES is a map from "const char *" parent paths to "apr_array_header_t *"
    arrays of child paths.  For all of the parent paths of PATH this function
@@ -843,6 +1219,7 @@ lock_body(void *baton, apr_pool_t *pool)
   const char *rev_0_path;
   int i;
   apr_hash_t *index_updates = apr_hash_make(pool);
+  apr_array_header_t *new_locks;
   apr_hash_index_t *hi;
   apr_pool_t *iterpool = svn_pool_create(pool);
 
@@ -876,6 +1253,14 @@ lock_body(void *baton, apr_pool_t *pool)
       APR_ARRAY_PUSH(lb->infos, struct lock_info_t) = info;
     }
 
+  /* Nothing to do if all targets failed their checks. */
+  if (apr_hash_count(index_updates) == 0)
+    {
+      svn_pool_destroy(iterpool);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(prepare_lock_index(lb->fs, pool));
   rev_0_path = svn_fs_fs__path_rev_absolute(lb->fs, 0, pool);
 
   /* We apply the scheduled index updates before writing the actual locks.
@@ -930,6 +1315,18 @@ lock_body(void *baton, apr_pool_t *pool)
         }
     }
 
+  new_locks = apr_array_make(pool, lb->infos->nelts, sizeof(svn_lock_t *));
+  for (i = 0; i < lb->infos->nelts; ++i)
+    {
+      struct lock_info_t *info = &APR_ARRAY_IDX(lb->infos, i,
+                                                struct lock_info_t);
+
+      if (! info->fs_err)
+        APR_ARRAY_PUSH(new_locks, svn_lock_t *) = info->lock;
+    }
+
+  SVN_ERR(finish_lock_index(lb->fs, NULL, new_locks, pool));
+
   svn_pool_destroy(iterpool);
   return SVN_NO_ERROR;
 }
@@ -995,6 +1392,7 @@ unlock_body(void *baton, apr_pool_t *pool)
   const char *rev_0_path;
   int i;
   apr_hash_t *indices_updates = apr_hash_make(pool);
+  apr_array_header_t *deleted_paths;
   apr_hash_index_t *hi;
   apr_pool_t *iterpool = svn_pool_create(pool);
 
@@ -1026,11 +1424,21 @@ unlock_body(void *baton, apr_pool_t *pool)
       APR_ARRAY_PUSH(ub->infos, struct unlock_info_t) = info;
     }
 
+  /* Nothing to do if all targets failed their checks. */
+  if (apr_hash_count(indices_updates) == 0)
+    {
+      svn_pool_destroy(iterpool);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(prepare_lock_index(ub->fs, pool));
   rev_0_path = svn_fs_fs__path_rev_absolute(ub->fs, 0, pool);
 
   /* Unlike the lock_body(), we need to delete locks *before* we start to
      update indices. */
 
+  deleted_paths = apr_array_make(pool, ub->infos->nelts,
+                                 sizeof(const char *));
   for (i = 0; i < ub->infos->nelts; ++i)
     {
       struct unlock_info_t *info = &APR_ARRAY_IDX(ub->infos, i,
@@ -1042,6 +1450,7 @@ unlock_body(void *baton, apr_pool_t *pool)
         {
           SVN_ERR(delete_lock(ub->fs->path, info->path, iterpool));
           info->done = TRUE;
+          APR_ARRAY_PUSH(deleted_paths, const char *) = info->path;
         }
     }
 
@@ -1055,6 +1464,8 @@ unlock_body(void *baton, apr_pool_t *pool)
                                  iterpool));
     }
 
+  SVN_ERR(finish_lock_index(ub->fs, deleted_paths, NULL, pool));
+
   svn_pool_destroy(iterpool);
   return SVN_NO_ERROR;
 }
@@ -1348,7 +1759,6 @@ svn_fs_fs__get_locks(svn_fs_t *fs,
                      void *get_locks_baton,
                      apr_pool_t *pool)
 {
-  const char *digest_path;
   get_locks_filter_baton_t glfb;
 
   SVN_ERR(svn_fs__check_fs(fs, TRUE));
@@ -1359,9 +1769,7 @@ svn_fs_fs__get_locks(svn_fs_t *fs,
   glfb.get_locks_func = get_locks_func;
   glfb.get_locks_baton = get_locks_baton;
 
-  /* Get the top digest path in our tree of interest, and then walk it. */
-  SVN_ERR(digest_path_from_path(&digest_path, fs->path, path, pool));
-  SVN_ERR(walk_locks(fs, digest_path, get_locks_filter_func, &glfb,
+  SVN_ERR(walk_locks(fs, path, get_locks_filter_func, &glfb,
                      FALSE, pool));
   return SVN_NO_ERROR;
 }
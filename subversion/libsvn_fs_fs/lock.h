@@ -103,6 +103,21 @@ svn_error_t *svn_fs_fs__allow_locked_operation(const char *path,
                                                svn_boolean_t have_write_lock,
                                                apr_pool_t *pool);
 
+/* Like svn_fs_fs__allow_locked_operation() but check all paths in the
+   array PATHS non-recursively and all paths in RECURSIVE_PATHS
+   recursively.  Both contain const char * paths.
+
+   If the lock index is up to date, look up each path in it.  Otherwise,
+   if there are fewer locks in FS than paths to check, read all locks
+   once instead of looking up each path individually.  Use POOL for
+   temporary allocations. */
+svn_error_t *svn_fs_fs__allow_locked_operations(
+                                      svn_fs_t *fs,
+                                      apr_array_header_t *paths,
+                                      apr_array_header_t *recursive_paths,
+                                      svn_boolean_t have_write_lock,
+                                      apr_pool_t *pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
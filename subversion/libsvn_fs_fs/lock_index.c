@@ -0,0 +1,281 @@
+/* lock_index.c --- index of the locks in an FSFS repository
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+
+#include "private/svn_sqlite.h"
+
+#include "fs_fs.h"
+#include "lock_index.h"
+
+#include "svn_private_config.h"
+
+#include "lock-index-db.h"
+
+LOCK_INDEX_DB_SQL_DECLARE_STATEMENTS(statements);
+
+
+
+/** Helper functions. **/
+static APR_INLINE const char *
+path_lock_index_db(const char *fs_path,
+                   apr_pool_t *result_pool)
+{
+  return svn_dirent_join(fs_path, LOCK_INDEX_DB_NAME, result_pool);
+}
+
+/* Set *EXISTS to TRUE if FS has a lock index DB file. */
+static svn_error_t *
+index_exists(svn_boolean_t *exists,
+             svn_fs_t *fs,
+             apr_pool_t *scratch_pool)
+{
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_io_check_path(path_lock_index_db(fs->path, scratch_pool),
+                            &kind, scratch_pool));
+  *exists = (kind != svn_node_none);
+
+  return SVN_NO_ERROR;
+}
+
+/* Body of open_index().
+   Implements svn_atomic__init_once().init_func.
+ */
+static svn_error_t *
+open_index_db(void *baton,
+              apr_pool_t *pool)
+{
+  svn_fs_t *fs = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *sdb;
+  const char *db_path;
+  int version;
+
+  /* Open (or create) the sqlite database.  It will be automatically
+     closed when fs->pool is destroyed. */
+  db_path = path_lock_index_db(fs->path, pool);
+#ifndef WIN32
+  {
+    /* Like the rep-cache, use the permissions of the repository rather
+       than the umask. */
+    svn_boolean_t exists;
+
+    SVN_ERR(index_exists(&exists, fs, pool));
+    if (!exists)
+      {
+        const char *current = svn_fs_fs__path_current(fs, pool);
+        svn_error_t *err = svn_io_file_create_empty(db_path, pool);
+
+        if (err && !APR_STATUS_IS_EEXIST(err->apr_err))
+          return svn_error_trace(err);
+        else if (err)
+          svn_error_clear(err);
+        else
+          SVN_ERR(svn_io_copy_perms(current, db_path, pool));
+      }
+  }
+#endif
+  SVN_ERR(svn_sqlite__open(&sdb, db_path,
+                           svn_sqlite__mode_rwcreate, statements,
+                           0, NULL, 0,
+                           fs->pool, pool));
+
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__read_schema_version(&version, sdb, pool),
+                        sdb);
+  if (version <= 0)
+    SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(sdb,
+                                                      STMT_CREATE_SCHEMA),
+                          sdb);
+
+  /* This is used as a flag that the database is available so don't
+     set it earlier. */
+  ffd->lock_index_db = sdb;
+
+  return SVN_NO_ERROR;
+}
+
+/* Open the lock index DB of FS, creating it if necessary. */
+static svn_error_t *
+open_index(svn_fs_t *fs,
+           apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *err = svn_atomic__init_once(&ffd->lock_index_db_opened,
+                                           open_index_db, fs, scratch_pool);
+  return svn_error_quick_wrapf(err,
+                               _("Couldn't open lock index '%s'"),
+                               svn_dirent_local_style(
+                                 path_lock_index_db(fs->path, scratch_pool),
+                                 scratch_pool));
+}
+
+/* Set *STAMP to the stamp recorded in SDB, allocated in RESULT_POOL.
+ * Set it to NULL if no stamp has been recorded yet. */
+static svn_error_t *
+get_stamp(const char **stamp,
+          svn_sqlite__db_t *sdb,
+          apr_pool_t *result_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_GET_STAMP));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  *stamp = have_row ? svn_sqlite__column_text(stmt, 0, result_pool) : NULL;
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+svn_error_t *
+svn_fs_fs__lock_index_get_stamp(const char **stamp,
+                                svn_fs_t *fs,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_boolean_t exists;
+
+  *stamp = NULL;
+
+  /* Don't create the DB just to find out that it is empty. */
+  SVN_ERR(index_exists(&exists, fs, scratch_pool));
+  if (!exists)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(open_index(fs, scratch_pool));
+  return svn_error_trace(get_stamp(stamp, ffd->lock_index_db, result_pool));
+}
+
+svn_error_t *
+svn_fs_fs__lock_index_find(apr_array_header_t **locks,
+                           svn_fs_t *fs,
+                           const char *path,
+                           svn_boolean_t subtree,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t exists;
+  svn_boolean_t have_row;
+  const char *subtree_path = NULL;
+
+  *locks = NULL;
+
+  SVN_ERR(index_exists(&exists, fs, scratch_pool));
+  if (!exists)
+    return SVN_NO_ERROR;
+
+  /* The statement selects the paths below ?2 with a range condition, so
+   * the root has to be passed as "". */
+  if (subtree)
+    subtree_path = strcmp(path, "/") ? path : "";
+
+  SVN_ERR(open_index(fs, scratch_pool));
+  *locks = apr_array_make(result_pool, 16, sizeof(svn_lock_t *));
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->lock_index_db,
+                                    STMT_GET_LOCKS));
+  SVN_ERR(svn_sqlite__bindf(stmt, "ss", path, subtree_path));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      svn_lock_t *lock = svn_lock_create(result_pool);
+
+      lock->path = svn_sqlite__column_text(stmt, 0, result_pool);
+      lock->token = svn_sqlite__column_text(stmt, 1, result_pool);
+      lock->owner = svn_sqlite__column_text(stmt, 2, result_pool);
+      lock->comment = svn_sqlite__column_text(stmt, 3, result_pool);
+      lock->is_dav_comment = svn_sqlite__column_boolean(stmt, 4);
+      lock->creation_date = svn_sqlite__column_int64(stmt, 5);
+      lock->expiration_date = svn_sqlite__column_int64(stmt, 6);
+
+      APR_ARRAY_PUSH(*locks, svn_lock_t *) = lock;
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Body of svn_fs_fs__lock_index_update(), to be run within an SQLite
+ * transaction. */
+static svn_error_t *
+update_index(svn_sqlite__db_t *sdb,
+             svn_boolean_t reset,
+             apr_array_header_t *deleted_paths,
+             apr_array_header_t *locks,
+             const char *stamp)
+{
+  svn_sqlite__stmt_t *stmt;
+  int i;
+
+  if (reset)
+    SVN_ERR(svn_sqlite__exec_statements(sdb, STMT_CLEAR_LOCKS));
+
+  for (i = 0; deleted_paths && i < deleted_paths->nelts; ++i)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_DELETE_LOCK));
+      SVN_ERR(svn_sqlite__bindf(stmt, "s",
+                                APR_ARRAY_IDX(deleted_paths, i,
+                                              const char *)));
+      SVN_ERR(svn_sqlite__update(NULL, stmt));
+    }
+
+  for (i = 0; locks && i < locks->nelts; ++i)
+    {
+      const svn_lock_t *lock = APR_ARRAY_IDX(locks, i, const svn_lock_t *);
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_LOCK));
+      SVN_ERR(svn_sqlite__bindf(stmt, "ssssdLL", lock->path, lock->token,
+                                lock->owner, lock->comment,
+                                lock->is_dav_comment ? 1 : 0,
+                                (apr_int64_t)lock->creation_date,
+                                (apr_int64_t)lock->expiration_date));
+      SVN_ERR(svn_sqlite__insert(NULL, stmt));
+    }
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SET_STAMP));
+  SVN_ERR(svn_sqlite__bindf(stmt, "s", stamp));
+
+  return svn_error_trace(svn_sqlite__update(NULL, stmt));
+}
+
+svn_error_t *
+svn_fs_fs__lock_index_update(svn_fs_t *fs,
+                             svn_boolean_t reset,
+                             apr_array_header_t *deleted_paths,
+                             apr_array_header_t *locks,
+                             const char *stamp,
+                             apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  SVN_ERR(open_index(fs, scratch_pool));
+  SVN_SQLITE__WITH_TXN(update_index(ffd->lock_index_db, reset,
+                                    deleted_paths, locks, stamp),
+                       ffd->lock_index_db);
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,89 @@
+/* lock_index.h : index of the locks in an FSFS repository
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS__LOCK_INDEX_H
+#define SVN_LIBSVN_FS__LOCK_INDEX_H
+
+#include "fs.h"
+
+/* The lock index is an SQLite database that holds a copy of every lock
+ * in the repository, keyed by path.  It answers queries for the locks
+ * at or below some path with a single range query instead of reading
+ * the digest files of the whole subtree (see lock.c).
+ *
+ * The digest files remain authoritative.  The index records a stamp
+ * that identifies the state of the digest files it matches, derived from
+ * the root digest file which lists every lock.  Lock and unlock clear
+ * the stamp before touching the digest files and set the new one after
+ * updating the index, so an interrupted operation leaves the index
+ * stale rather than wrong.  Readers ignore a stale index and read the
+ * digest files as before; the next operation under the write lock that
+ * needs the index rebuilds it.
+ *
+ * The index is advisory and may be removed at any time.
+ */
+
+#define LOCK_INDEX_DB_NAME "lock-index.db"
+
+/* Set *STAMP to the stamp recorded in the lock index of FS, or to NULL
+ * if FS has no lock index.  Allocate *STAMP in RESULT_POOL and use
+ * SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__lock_index_get_stamp(const char **stamp,
+                                svn_fs_t *fs,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool);
+
+/* Set *LOCKS to an array of the svn_lock_t * in the lock index of FS
+ * that are on PATH or, if SUBTREE is set, below it, sorted by path.
+ * Set it to NULL if FS has no lock index.  The caller should check the
+ * stamp of the index first.
+ *
+ * PATH must be canonical.  Expired locks are included.  Allocate *LOCKS
+ * in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__lock_index_find(apr_array_header_t **locks,
+                           svn_fs_t *fs,
+                           const char *path,
+                           svn_boolean_t subtree,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
+/* In the lock index of FS, remove all locks if RESET is set, remove the
+ * locks on the const char * paths in DELETED_PATHS, add the svn_lock_t *
+ * in LOCKS and record STAMP, all within one SQLite transaction.  Create
+ * the index if necessary.  LOCKS and DELETED_PATHS may be NULL.
+ *
+ * The caller must hold the FS write lock.  Use SCRATCH_POOL for
+ * temporaries.
+ */
+svn_error_t *
+svn_fs_fs__lock_index_update(svn_fs_t *fs,
+                             svn_boolean_t reset,
+                             apr_array_header_t *deleted_paths,
+                             apr_array_header_t *locks,
+                             const char *stamp,
+                             apr_pool_t *scratch_pool);
+
+#endif
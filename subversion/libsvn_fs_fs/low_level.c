@@ -28,6 +28,7 @@
 #include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_fspath.h"
+#include "private/svn_packed_data.h"
 
 #include "../libsvn_fs/fs-loader.h"
 
@@ -58,9 +59,32 @@
 #define FLAG_TRUE          "true"
 #define FLAG_FALSE         "false"
 
+/* First line of a changed paths list in packed binary encoding. */
+#define CHANGES_PACKED     "PACKED"
+
+/* Bits and bit fields of the flags value of a packed change entry. */
+#define CHANGE_TEXT_MOD       0x00001
+#define CHANGE_PROP_MOD       0x00002
+#define CHANGE_MERGEINFO_KNOWN 0x00004
+#define CHANGE_MERGEINFO_MOD  0x00008
+
+#define CHANGE_NODE_MASK      0x00030
+
+#define CHANGE_NODE_UNKNOWN   0x00000
+#define CHANGE_NODE_FILE      0x00010
+#define CHANGE_NODE_DIR       0x00020
+
+#define CHANGE_KIND_SHIFT     6
+#define CHANGE_KIND_MASK      0x001C0
+
+#define CHANGE_HAS_ID         0x00200
+#define CHANGE_TXN_ID         0x00400
+#define CHANGE_HAS_COPYFROM   0x00800
+
 /* Kinds of representation. */
 #define REP_PLAIN          "PLAIN"
 #define REP_DELTA          "DELTA"
+#define REP_SHARED         "SHARED"
 
 /* An arbitrary maximum path length, so clients can't run us out of memory
  * by giving us arbitrarily large paths. */
@@ -291,17 +315,19 @@ svn_fs_fs__unparse_footer(apr_off_t l2p_offset,
                                                        scratch_pool));
 }
 
-/* Read the next entry in the changes record from file FILE and store
-   the resulting change in *CHANGE_P.  If there is no next record,
-   store NULL there.  Perform all allocations from POOL. */
+/* Parse the changes record entry starting with LINE, read from STREAM,
+   and store the resulting change in *CHANGE_P.  EOF is the end-of-file
+   flag returned when reading LINE.  Read the remainder of the entry from
+   STREAM.  If LINE does not start a record, store NULL in *CHANGE_P.
+   Allocate the result in RESULT_POOL and temporaries in SCRATCH_POOL. */
 static svn_error_t *
-read_change(change_t **change_p,
-            svn_stream_t *stream,
-            apr_pool_t *result_pool,
-            apr_pool_t *scratch_pool)
+parse_change(change_t **change_p,
+             svn_stringbuf_t *line,
+             svn_boolean_t eof,
+             svn_stream_t *stream,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
 {
-  svn_stringbuf_t *line;
-  svn_boolean_t eof = TRUE;
   change_t *change;
   char *str, *last_str, *kind_str;
   svn_fs_path_change2_t *info;
@@ -309,8 +335,6 @@ read_change(change_t **change_p,
   /* Default return value. */
   *change_p = NULL;
 
-  SVN_ERR(svn_stream_readline(stream, &line, "\n", &eof, scratch_pool));
-
   /* Check for a blank line. */
   if (eof || (line->len == 0))
     return SVN_NO_ERROR;
@@ -479,8 +503,153 @@ read_change(change_t **change_p,
   return SVN_NO_ERROR;
 }
 
+/* Read the next entry in the changes record from file FILE and store
+   the resulting change in *CHANGE_P.  If there is no next record,
+   store NULL there.  Perform all allocations from POOL. */
+static svn_error_t *
+read_change(change_t **change_p,
+            svn_stream_t *stream,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *line;
+  svn_boolean_t eof = TRUE;
+
+  SVN_ERR(svn_stream_readline(stream, &line, "\n", &eof, scratch_pool));
+  return svn_error_trace(parse_change(change_p, line, eof, stream,
+                                      result_pool, scratch_pool));
+}
+
+/* Set *PART to the id part read from the two sub-streams of STREAM
+   starting at the current position of the round-robin. */
+static void
+read_packed_id_part(svn_fs_fs__id_part_t *part,
+                    svn_packed__int_stream_t *stream)
+{
+  part->revision = (svn_revnum_t)svn_packed__get_int(stream);
+  part->number = svn_packed__get_uint(stream);
+}
+
+/* Read the packed chunk of a changed paths list that follows the
+   CHANGES_PACKED line in STREAM and append all its entries to CHANGES.
+   Allocate the entries in RESULT_POOL and temporaries in SCRATCH_POOL. */
+static svn_error_t *
+read_packed_chunk(apr_array_header_t *changes,
+                    svn_stream_t *stream,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  svn_packed__data_root_t *root;
+  svn_packed__int_stream_t *changes_stream;
+  svn_packed__byte_stream_t *paths_stream;
+  svn_packed__byte_stream_t *copyfrom_paths_stream;
+  apr_size_t i, count;
+
+  SVN_ERR(svn_packed__data_read(&root, stream, scratch_pool, scratch_pool));
+
+  changes_stream = svn_packed__first_int_stream(root);
+  paths_stream = svn_packed__first_byte_stream(root);
+  copyfrom_paths_stream = paths_stream
+                        ? svn_packed__next_byte_stream(paths_stream)
+                        : NULL;
+  if (   !changes_stream
+      || !svn_packed__first_int_substream(changes_stream)
+      || !copyfrom_paths_stream)
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Invalid packed changes list in rev-file"));
+
+  count = svn_packed__int_count(
+            svn_packed__first_int_substream(changes_stream));
+  if (count != svn_packed__byte_block_count(paths_stream))
+    return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                            _("Invalid packed changes list in rev-file"));
+
+  for (i = 0; i < count; ++i)
+    {
+      change_t *change = apr_pcalloc(result_pool, sizeof(*change));
+      svn_fs_path_change2_t *info = &change->info;
+      svn_fs_fs__id_part_t node_id, copy_id, location;
+      apr_uint64_t flags;
+      svn_revnum_t copyfrom_rev;
+      const char *path;
+      apr_size_t len;
+
+      /* The round-robin order must match svn_fs_fs__write_packed_changes. */
+      flags = svn_packed__get_uint(changes_stream);
+      read_packed_id_part(&node_id, changes_stream);
+      read_packed_id_part(&copy_id, changes_stream);
+      read_packed_id_part(&location, changes_stream);
+      copyfrom_rev = (svn_revnum_t)svn_packed__get_int(changes_stream);
+
+      if (flags & CHANGE_HAS_ID)
+        info->node_rev_id
+          = flags & CHANGE_TXN_ID
+          ? svn_fs_fs__id_txn_create(&node_id, &copy_id, &location,
+                                     result_pool)
+          : svn_fs_fs__id_rev_create(&node_id, &copy_id, &location,
+                                     result_pool);
+
+      info->change_kind = (svn_fs_path_change_kind_t)
+        ((flags & CHANGE_KIND_MASK) >> CHANGE_KIND_SHIFT);
+      if (info->change_kind > svn_fs_path_change_reset)
+        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                _("Invalid change kind in rev file"));
+
+      switch (flags & CHANGE_NODE_MASK)
+        {
+          case CHANGE_NODE_FILE:
+            info->node_kind = svn_node_file;
+            break;
+          case CHANGE_NODE_DIR:
+            info->node_kind = svn_node_dir;
+            break;
+          default:
+            info->node_kind = svn_node_unknown;
+            break;
+        }
+
+      info->text_mod = (flags & CHANGE_TEXT_MOD) != 0;
+      info->prop_mod = (flags & CHANGE_PROP_MOD) != 0;
+      if (flags & CHANGE_MERGEINFO_KNOWN)
+        info->mergeinfo_mod = (flags & CHANGE_MERGEINFO_MOD)
+                            ? svn_tristate_true
+                            : svn_tristate_false;
+      else
+        info->mergeinfo_mod = svn_tristate_unknown;
+
+      path = svn_packed__get_bytes(paths_stream, &len);
+      change->path.data = apr_pstrmemdup(result_pool, path, len);
+      change->path.len = len;
+      if (!svn_fspath__is_canonical(change->path.data))
+        return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                                _("Invalid path in changes line"));
+
+      info->copyfrom_known = TRUE;
+      if (flags & CHANGE_HAS_COPYFROM)
+        {
+          path = svn_packed__get_bytes(copyfrom_paths_stream, &len);
+          info->copyfrom_rev = copyfrom_rev;
+          info->copyfrom_path = apr_pstrmemdup(result_pool, path, len);
+          if (   !SVN_IS_VALID_REVNUM(copyfrom_rev)
+              || !svn_fspath__is_canonical(info->copyfrom_path))
+            return svn_error_create(SVN_ERR_FS_CORRUPT, NULL,
+                              _("Invalid copy-from path in changes line"));
+        }
+      else
+        {
+          info->copyfrom_rev = SVN_INVALID_REVNUM;
+          info->copyfrom_path = NULL;
+        }
+
+      APR_ARRAY_PUSH(changes, change_t *) = change;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__read_changes(apr_array_header_t **changes,
+                        svn_boolean_t *eol,
                         svn_stream_t *stream,
                         int max_count,
                         apr_pool_t *result_pool,
@@ -498,14 +667,33 @@ svn_fs_fs__read_changes(apr_array_header_t **changes,
    */
   *changes = apr_array_make(result_pool, 63, sizeof(change_t *));
 
+  *eol = FALSE;
+
   iterpool = svn_pool_create(scratch_pool);
-  for (; max_count > 0; --max_count)
+  while ((*changes)->nelts < max_count)
     {
       change_t *change;
+      svn_stringbuf_t *line;
+      svn_boolean_t eof = TRUE;
+
       svn_pool_clear(iterpool);
-      SVN_ERR(read_change(&change, stream, result_pool, iterpool));
+      SVN_ERR(svn_stream_readline(stream, &line, "\n", &eof, iterpool));
+
+      /* Packed chunks can only be read as a whole. */
+      if (!eof && strcmp(line->data, CHANGES_PACKED) == 0)
+        {
+          SVN_ERR(read_packed_chunk(*changes, stream, result_pool,
+                                    iterpool));
+          continue;
+        }
+
+      SVN_ERR(parse_change(&change, line, eof, stream, result_pool,
+                           iterpool));
       if (!change)
-        break;
+        {
+          *eol = TRUE;
+          break;
+        }
 
       APR_ARRAY_PUSH(*changes, change_t*) = change;
     }
@@ -677,6 +865,140 @@ svn_fs_fs__write_changes(svn_stream_t *stream,
   return SVN_NO_ERROR;
 }
 
+/* Add the id part PART to the two sub-streams of STREAM starting at the
+   current position of the round-robin.  PART may be NULL. */
+static void
+add_packed_id_part(svn_packed__int_stream_t *stream,
+                   const svn_fs_fs__id_part_t *part)
+{
+  svn_packed__add_int(stream, part ? part->revision : 0);
+  svn_packed__add_uint(stream, part ? part->number : 0);
+}
+
+/* Write COUNT elements of the svn_sort__item_t array SORTED_CHANGED_PATHS,
+   starting at index FIRST, as one packed chunk to STREAM.  Use SCRATCH_POOL
+   for temporary allocations. */
+static svn_error_t *
+write_packed_chunk(svn_stream_t *stream,
+                   apr_array_header_t *sorted_changed_paths,
+                   int first,
+                   int count,
+                   apr_pool_t *scratch_pool)
+{
+  svn_packed__data_root_t *root = svn_packed__data_create_root(scratch_pool);
+  svn_packed__int_stream_t *changes_stream
+    = svn_packed__create_int_stream(root, FALSE, FALSE);
+  svn_packed__byte_stream_t *paths_stream
+    = svn_packed__create_bytes_stream(root);
+  svn_packed__byte_stream_t *copyfrom_paths_stream
+    = svn_packed__create_bytes_stream(root);
+  int i;
+
+  /* Flags, node-id, copy-id, rev-item resp. txn-id, copyfrom rev. */
+  svn_packed__create_int_substream(changes_stream, FALSE, FALSE);
+  svn_packed__create_int_substream(changes_stream, FALSE, TRUE);
+  svn_packed__create_int_substream(changes_stream, FALSE, FALSE);
+  svn_packed__create_int_substream(changes_stream, FALSE, TRUE);
+  svn_packed__create_int_substream(changes_stream, FALSE, FALSE);
+  svn_packed__create_int_substream(changes_stream, FALSE, TRUE);
+  svn_packed__create_int_substream(changes_stream, FALSE, FALSE);
+  svn_packed__create_int_substream(changes_stream, FALSE, TRUE);
+
+  for (i = first; i < first + count; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted_changed_paths, i,
+                                              svn_sort__item_t);
+      svn_fs_path_change2_t *change = item->value;
+      const svn_fs_id_t *id = change->node_rev_id;
+      apr_uint64_t flags = 0;
+
+      if (change->change_kind > svn_fs_path_change_reset)
+        return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                                 _("Invalid change type %d"),
+                                 change->change_kind);
+
+      flags |= (apr_uint64_t)change->change_kind << CHANGE_KIND_SHIFT;
+      if (change->node_kind == svn_node_file)
+        flags |= CHANGE_NODE_FILE;
+      else if (change->node_kind == svn_node_dir)
+        flags |= CHANGE_NODE_DIR;
+
+      if (change->text_mod)
+        flags |= CHANGE_TEXT_MOD;
+      if (change->prop_mod)
+        flags |= CHANGE_PROP_MOD;
+      if (change->mergeinfo_mod != svn_tristate_unknown)
+        flags |= CHANGE_MERGEINFO_KNOWN;
+      if (change->mergeinfo_mod == svn_tristate_true)
+        flags |= CHANGE_MERGEINFO_MOD;
+
+      if (id)
+        flags |= svn_fs_fs__id_is_txn(id)
+               ? CHANGE_HAS_ID | CHANGE_TXN_ID
+               : CHANGE_HAS_ID;
+      if (SVN_IS_VALID_REVNUM(change->copyfrom_rev))
+        flags |= CHANGE_HAS_COPYFROM;
+
+      svn_packed__add_uint(changes_stream, flags);
+      add_packed_id_part(changes_stream, id ? svn_fs_fs__id_node_id(id)
+                                            : NULL);
+      add_packed_id_part(changes_stream, id ? svn_fs_fs__id_copy_id(id)
+                                            : NULL);
+      add_packed_id_part(changes_stream,
+                         !id ? NULL
+                             : svn_fs_fs__id_is_txn(id)
+                             ? svn_fs_fs__id_txn_id(id)
+                             : svn_fs_fs__id_rev_item(id));
+      svn_packed__add_int(changes_stream,
+                          (flags & CHANGE_HAS_COPYFROM)
+                            ? change->copyfrom_rev
+                            : 0);
+
+      svn_packed__add_bytes(paths_stream, item->key, item->klen);
+      if (flags & CHANGE_HAS_COPYFROM)
+        svn_packed__add_bytes(copyfrom_paths_stream, change->copyfrom_path,
+                              strlen(change->copyfrom_path));
+    }
+
+  SVN_ERR(svn_stream_puts(stream, CHANGES_PACKED "\n"));
+  SVN_ERR(svn_packed__data_write(stream, root, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__write_packed_changes(svn_stream_t *stream,
+                                apr_hash_t *changes,
+                                apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_array_header_t *sorted_changed_paths;
+  int i;
+
+  /* Same order as in the text representation. */
+  sorted_changed_paths = svn_sort__hash(changes,
+                                        svn_sort_compare_items_lexically,
+                                        scratch_pool);
+
+  /* One chunk per block such that readers never need to decode more
+     than that to serve a single svn_fs_fs__get_changes call. */
+  for (i = 0; i < sorted_changed_paths->nelts;
+       i += SVN_FS_FS__CHANGES_BLOCK_SIZE)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(write_packed_chunk(stream, sorted_changed_paths, i,
+                                 MIN(SVN_FS_FS__CHANGES_BLOCK_SIZE,
+                                     sorted_changed_paths->nelts - i),
+                                 iterpool));
+    }
+
+  /* Terminate the list just like text lists. */
+  SVN_ERR(svn_stream_puts(stream, "\n"));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Given a revision file FILE that has been pre-positioned at the
    beginning of a Node-Rev header block, read in that header block and
    store it in the apr_hash_t HEADERS.  All allocations will be from
@@ -1273,12 +1595,15 @@ svn_fs_fs__read_rep_header(svn_fs_fs__rep_header_t **header,
       return SVN_NO_ERROR;
     }
 
-  (*header)->type = svn_fs_fs__rep_delta;
-
-  /* We have hopefully a DELTA vs. a non-empty base revision. */
+  /* We have hopefully a DELTA vs. a non-empty base revision or a
+   * reference into the group store. */
   last_str = buffer->data;
   str = svn_cstring_tokenize(" ", &last_str);
-  if (! str || (strcmp(str, REP_DELTA) != 0))
+  if (str && strcmp(str, REP_DELTA) == 0)
+    (*header)->type = svn_fs_fs__rep_delta;
+  else if (str && strcmp(str, REP_SHARED) == 0)
+    (*header)->type = svn_fs_fs__rep_shared;
+  else
     goto error;
 
   SVN_ERR(parse_revnum(&(*header)->base_revision, (const char **)&last_str));
@@ -1319,6 +1644,13 @@ svn_fs_fs__write_rep_header(svn_fs_fs__rep_header_t *header,
         text = REP_DELTA "\n";
         break;
 
+      case svn_fs_fs__rep_shared:
+        text = apr_psprintf(scratch_pool, REP_SHARED " %ld %" APR_OFF_T_FMT
+                                          " %" SVN_FILESIZE_T_FMT "\n",
+                            header->base_revision, header->base_item_index,
+                            header->base_length);
+        break;
+
       default:
         text = apr_psprintf(scratch_pool, REP_DELTA " %ld %" APR_OFF_T_FMT
                                           " %" SVN_FILESIZE_T_FMT "\n",
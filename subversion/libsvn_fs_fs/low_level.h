@@ -29,6 +29,22 @@
 #define SVN_FS_FS__KIND_FILE          "file"
 #define SVN_FS_FS__KIND_DIR           "dir"
 
+/* Directory representations may be followed by a name index after the
+ * hash terminator, allowing single entries to be looked up without
+ * reading the whole directory.  Since readers of the hash dump stop at
+ * the terminator, indexed directories remain valid directory reps.
+ *
+ * The index is a list of the offsets of all "K" lines, relative to the
+ * start of the representation, in the order of the entries' names.  Each
+ * offset is padded with leading zeros to the same width and followed by
+ * a newline.  The last line of the representation is
+ *
+ *   DIRINDEX <entry count> <offset width> <start of the offset list>
+ *
+ * Indexed directories are only ever stored as PLAIN representations in
+ * repository formats SVN_FS_FS__MIN_DIR_INDEX_FORMAT and newer. */
+#define SVN_FS_FS__DIR_INDEX_MARKER   "DIRINDEX"
+
 /* The functions are grouped as follows:
  *
  * - revision trailer (up to format 6)
@@ -98,10 +114,13 @@ svn_fs_fs__unparse_footer(apr_off_t l2p_offset,
                           apr_pool_t *scratch_pool);
 
 /* Read up to MAX_COUNT of the changes from STREAM and store them in
-   *CHANGES, allocated in RESULT_POOL.  Do temporary allocations in
-   SCRATCH_POOL. */
+   *CHANGES, allocated in RESULT_POOL.  Set *EOL if the end of the list
+   has been reached.  Chunks of lists in packed encoding are always read
+   completely, so up to one chunk more than MAX_COUNT may be returned.
+   Do temporary allocations in SCRATCH_POOL. */
 svn_error_t *
 svn_fs_fs__read_changes(apr_array_header_t **changes,
+                        svn_boolean_t *eol,
                         svn_stream_t *stream,
                         int max_count,
                         apr_pool_t *result_pool,
@@ -139,6 +158,19 @@ svn_fs_fs__write_changes(svn_stream_t *stream,
                          svn_boolean_t terminate_list,
                          apr_pool_t *scratch_pool);
 
+/* Write the changed path info from CHANGES to STREAM as a complete
+   changed paths list in the packed binary encoding used by FS formats
+   SVN_FS_FS__MIN_PACKED_CHANGES_FORMAT and newer.  The entries will be
+   split into independent chunks of SVN_FS_FS__CHANGES_BLOCK_SIZE entries
+   each, so readers may start at any chunk boundary.  In contrast to
+   svn_fs_fs__write_changes, this can only be used for the final list
+   in a rev file.  Perform temporary allocations in SCRATCH_POOL.
+ */
+svn_error_t *
+svn_fs_fs__write_packed_changes(svn_stream_t *stream,
+                                apr_hash_t *changes,
+                                apr_pool_t *scratch_pool);
+
 /* Read a node-revision from STREAM. Set *NODEREV to the new structure,
    allocated in RESULT_POOL. */
 svn_error_t *
@@ -189,7 +221,11 @@ typedef enum svn_fs_fs__rep_type_t
   svn_fs_fs__rep_self_delta,
 
   /* this is a DELTA representation against some base representation */
-  svn_fs_fs__rep_delta
+  svn_fs_fs__rep_delta,
+
+  /* this is a reference to a representation in the group store, see
+   * svn_fs_fs__get_group_store() */
+  svn_fs_fs__rep_shared
 } svn_fs_fs__rep_type_t;
 
 /* This structure is used to hold the information stored in a representation
@@ -200,7 +236,8 @@ typedef struct svn_fs_fs__rep_header_t
   svn_fs_fs__rep_type_t type;
 
   /* if this rep is a delta against some other rep, that base rep can
-   * be found in this revision.  Should be 0 if there is no base rep. */
+   * be found in this revision.  Should be 0 if there is no base rep.
+   * For shared reps, the base_* members describe the referenced rep. */
   svn_revnum_t base_revision;
 
   /* if this rep is a delta against some other rep, that base rep can
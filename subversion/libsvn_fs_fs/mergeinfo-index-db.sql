@@ -0,0 +1,87 @@
+/* mergeinfo-index-db.sql -- schema of the FSFS mergeinfo index
+ *   This is intended for use with SQLite 3
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+-- STMT_CREATE_SCHEMA
+/* The explicit mergeinfo of PATH in the revisions START_REV up to, but not
+   including, END_REV.  END_REV is NULL for mergeinfo that is still present
+   in the youngest indexed revision.  MERGEINFO is the canonical string
+   representation. */
+CREATE TABLE mergeinfo (
+  path TEXT NOT NULL,
+  start_rev INTEGER NOT NULL,
+  end_rev INTEGER,
+  mergeinfo TEXT NOT NULL,
+  PRIMARY KEY (path, start_rev)
+  );
+
+/* The single row of this table holds the range of revisions that the
+   index covers. */
+CREATE TABLE indexed_revs (
+  id INTEGER NOT NULL PRIMARY KEY CHECK (id = 0),
+  first_rev INTEGER NOT NULL,
+  last_rev INTEGER NOT NULL
+  );
+
+PRAGMA USER_VERSION = 1;
+
+-- STMT_GET_INDEXED_REVS
+SELECT first_rev, last_rev
+FROM indexed_revs
+WHERE id = 0
+
+-- STMT_SET_INDEXED_REVS
+INSERT OR REPLACE INTO indexed_revs (id, first_rev, last_rev)
+VALUES (0, ?1, ?2)
+
+-- STMT_CLEAR_INDEX
+DELETE FROM mergeinfo;
+DELETE FROM indexed_revs;
+
+-- STMT_INSERT_MERGEINFO
+INSERT OR REPLACE INTO mergeinfo (path, start_rev, end_rev, mergeinfo)
+VALUES (?1, ?2, NULL, ?3)
+
+/* The next two statements end the mergeinfo of PATH ?1, and of its
+   descendants if ?3 is not NULL, at revision ?2.  Descendants are the
+   paths starting with ?3 followed by '/', i.e. ?3 is PATH but empty
+   for the root.  Rows that start at ?2 itself get removed by the second
+   statement. */
+-- STMT_END_MERGEINFO
+UPDATE mergeinfo SET end_rev = ?2
+WHERE end_rev IS NULL AND start_rev < ?2
+  AND (path = ?1
+       OR (?3 IS NOT NULL AND path > ?3 || '/' AND path < ?3 || '0'))
+
+-- STMT_DELETE_NEW_MERGEINFO
+DELETE FROM mergeinfo
+WHERE start_rev = ?2
+  AND (path = ?1
+       OR (?3 IS NOT NULL AND path > ?3 || '/' AND path < ?3 || '0'))
+
+-- STMT_GET_DESCENDANT_MERGEINFO
+/* ?1 is the path as in STMT_END_MERGEINFO's ?3. */
+SELECT path, mergeinfo
+FROM mergeinfo
+WHERE path > ?1 || '/' AND path < ?1 || '0'
+  AND start_rev <= ?2 AND (end_rev IS NULL OR end_rev > ?2)
+ORDER BY path
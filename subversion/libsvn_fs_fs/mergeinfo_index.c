@@ -0,0 +1,492 @@
+/* mergeinfo_index.c --- index of the explicit mergeinfo in FSFS revisions
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include "svn_pools.h"
+#include "svn_hash.h"
+#include "svn_dirent_uri.h"
+#include "svn_mergeinfo.h"
+#include "svn_sorts.h"
+
+#include "private/svn_fspath.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_sqlite.h"
+
+#include "fs_fs.h"
+#include "mergeinfo_index.h"
+#include "tree.h"
+
+#include "svn_private_config.h"
+
+#include "mergeinfo-index-db.h"
+
+MERGEINFO_INDEX_DB_SQL_DECLARE_STATEMENTS(statements);
+
+
+
+/** Helper functions. **/
+static APR_INLINE const char *
+path_mergeinfo_index_db(const char *fs_path,
+                        apr_pool_t *result_pool)
+{
+  return svn_dirent_join(fs_path, MERGEINFO_INDEX_DB_NAME, result_pool);
+}
+
+/* Set *EXISTS to TRUE if FS has a mergeinfo index DB file. */
+static svn_error_t *
+index_exists(svn_boolean_t *exists,
+             svn_fs_t *fs,
+             apr_pool_t *scratch_pool)
+{
+  svn_node_kind_t kind;
+
+  SVN_ERR(svn_io_check_path(path_mergeinfo_index_db(fs->path, scratch_pool),
+                            &kind, scratch_pool));
+  *exists = (kind != svn_node_none);
+
+  return SVN_NO_ERROR;
+}
+
+/* Body of open_index().
+   Implements svn_atomic__init_once().init_func.
+ */
+static svn_error_t *
+open_index_db(void *baton,
+              apr_pool_t *pool)
+{
+  svn_fs_t *fs = baton;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *sdb;
+  const char *db_path;
+  int version;
+
+  /* Open (or create) the sqlite database.  It will be automatically
+     closed when fs->pool is destroyed. */
+  db_path = path_mergeinfo_index_db(fs->path, pool);
+#ifndef WIN32
+  {
+    /* Like the rep-cache, use the permissions of the repository rather
+       than the umask. */
+    svn_boolean_t exists;
+
+    SVN_ERR(index_exists(&exists, fs, pool));
+    if (!exists)
+      {
+        const char *current = svn_fs_fs__path_current(fs, pool);
+        svn_error_t *err = svn_io_file_create_empty(db_path, pool);
+
+        if (err && !APR_STATUS_IS_EEXIST(err->apr_err))
+          return svn_error_trace(err);
+        else if (err)
+          svn_error_clear(err);
+        else
+          SVN_ERR(svn_io_copy_perms(current, db_path, pool));
+      }
+  }
+#endif
+  SVN_ERR(svn_sqlite__open(&sdb, db_path,
+                           svn_sqlite__mode_rwcreate, statements,
+                           0, NULL, 0,
+                           fs->pool, pool));
+
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__read_schema_version(&version, sdb, pool),
+                        sdb);
+  if (version <= 0)
+    SVN_SQLITE__ERR_CLOSE(svn_sqlite__exec_statements(sdb,
+                                                      STMT_CREATE_SCHEMA),
+                          sdb);
+
+  /* This is used as a flag that the database is available so don't
+     set it earlier. */
+  ffd->mergeinfo_index_db = sdb;
+
+  return SVN_NO_ERROR;
+}
+
+/* Open the mergeinfo index DB of FS, creating it if necessary. */
+static svn_error_t *
+open_index(svn_fs_t *fs,
+           apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_error_t *err = svn_atomic__init_once(&ffd->mergeinfo_index_db_opened,
+                                           open_index_db, fs, scratch_pool);
+  return svn_error_quick_wrapf(err,
+                               _("Couldn't open mergeinfo index '%s'"),
+                               svn_dirent_local_style(
+                                 path_mergeinfo_index_db(fs->path,
+                                                         scratch_pool),
+                                 scratch_pool));
+}
+
+/* Set *FIRST and *LAST to the range of revisions covered by the index in
+ * SDB.  Set both to SVN_INVALID_REVNUM if the index is empty. */
+static svn_error_t *
+get_indexed_revs(svn_revnum_t *first,
+                 svn_revnum_t *last,
+                 svn_sqlite__db_t *sdb)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  *first = SVN_INVALID_REVNUM;
+  *last = SVN_INVALID_REVNUM;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_GET_INDEXED_REVS));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  if (have_row)
+    {
+      *first = svn_sqlite__column_revnum(stmt, 0);
+      *last = svn_sqlite__column_revnum(stmt, 1);
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Record that the index in SDB covers revisions FIRST to LAST. */
+static svn_error_t *
+set_indexed_revs(svn_sqlite__db_t *sdb,
+                 svn_revnum_t first,
+                 svn_revnum_t last)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_SET_INDEXED_REVS));
+  SVN_ERR(svn_sqlite__bindf(stmt, "rr", first, last));
+
+  return svn_error_trace(svn_sqlite__update(NULL, stmt));
+}
+
+/* Add the explicit MERGEINFO_STRING of PATH, starting at revision REV,
+ * to the index in SDB. */
+static svn_error_t *
+insert_mergeinfo(svn_sqlite__db_t *sdb,
+                 const char *path,
+                 svn_revnum_t rev,
+                 const char *mergeinfo_string)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_INSERT_MERGEINFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "srs", path, rev, mergeinfo_string));
+
+  return svn_error_trace(svn_sqlite__insert(NULL, stmt));
+}
+
+/* Let the mergeinfo of PATH and, if SUBTREE is set, of everything below
+ * it end before revision REV in the index in SDB. */
+static svn_error_t *
+end_mergeinfo(svn_sqlite__db_t *sdb,
+              const char *path,
+              svn_boolean_t subtree,
+              svn_revnum_t rev)
+{
+  svn_sqlite__stmt_t *stmt;
+  const char *subtree_path = NULL;
+
+  /* The statements select the paths below ?3 with a range condition, so
+   * the root has to be passed as "". */
+  if (subtree)
+    subtree_path = strcmp(path, "/") ? path : "";
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_END_MERGEINFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "srs", path, rev, subtree_path));
+  SVN_ERR(svn_sqlite__update(NULL, stmt));
+
+  /* Rows added in REV itself, e.g. for an earlier change to the same
+   * path, would now be empty. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, sdb, STMT_DELETE_NEW_MERGEINFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "srs", path, rev, subtree_path));
+
+  return svn_error_trace(svn_sqlite__update(NULL, stmt));
+}
+
+/* Baton for insert_receiver(). */
+typedef struct insert_baton_t
+{
+  svn_sqlite__db_t *sdb;
+  svn_revnum_t rev;
+} insert_baton_t;
+
+/* Implements svn_fs_mergeinfo_receiver_t.  Add MERGEINFO of PATH to the
+ * index as described by the insert_baton_t BATON. */
+static svn_error_t *
+insert_receiver(const char *path,
+                svn_mergeinfo_t mergeinfo,
+                void *baton,
+                apr_pool_t *scratch_pool)
+{
+  insert_baton_t *b = baton;
+  svn_string_t *mergeinfo_string;
+
+  SVN_ERR(svn_mergeinfo_to_string(&mergeinfo_string, mergeinfo,
+                                  scratch_pool));
+
+  return svn_error_trace(insert_mergeinfo(b->sdb, path, b->rev,
+                                          mergeinfo_string->data));
+}
+
+/* Body of svn_fs_fs__mergeinfo_index_add_revision(), to be run within
+ * an SQLite transaction. */
+static svn_error_t *
+add_revision(svn_fs_t *fs,
+             svn_revnum_t rev,
+             apr_hash_t *changed_paths,
+             apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__db_t *sdb = ffd->mergeinfo_index_db;
+  svn_revnum_t first, last;
+  svn_fs_root_t *root;
+  apr_array_header_t *changes;
+  const char *refreshed_path = NULL;
+  insert_baton_t b;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR(get_indexed_revs(&first, &last, sdb));
+
+  /* In a new repository, the index starts with the empty r0. */
+  if (!SVN_IS_VALID_REVNUM(first))
+    {
+      if (rev != 1)
+        return SVN_NO_ERROR;
+
+      first = 0;
+      last = 0;
+    }
+
+  /* We missed a revision.  Drop the index; it gets created again by the
+   * next query that crawls the whole tree. */
+  if (last != rev - 1)
+    return svn_error_trace(svn_sqlite__exec_statements(sdb,
+                                                       STMT_CLEAR_INDEX));
+
+  SVN_ERR(svn_fs_fs__revision_root(&root, fs, rev, scratch_pool));
+  b.sdb = sdb;
+  b.rev = rev;
+
+  /* Parents sort before their children, so changes below a path whose
+   * whole subtree we refreshed come right after it. */
+  changes = svn_sort__hash(changed_paths, svn_sort_compare_items_as_paths,
+                           scratch_pool);
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < changes->nelts; i++)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(changes, i, svn_sort__item_t);
+      const char *path = item->key;
+      svn_fs_path_change2_t *change = item->value;
+
+      svn_pool_clear(iterpool);
+
+      if (refreshed_path && svn_fspath__skip_ancestor(refreshed_path, path))
+        continue;
+
+      switch (change->change_kind)
+        {
+          case svn_fs_path_change_delete:
+            SVN_ERR(end_mergeinfo(sdb, path, TRUE, rev));
+            refreshed_path = path;
+            break;
+
+          case svn_fs_path_change_add:
+          case svn_fs_path_change_replace:
+            /* Copies bring the mergeinfo of their whole subtree. */
+            SVN_ERR(end_mergeinfo(sdb, path, TRUE, rev));
+            SVN_ERR(svn_fs_fs__get_explicit_mergeinfo(root, path, TRUE,
+                                                      insert_receiver, &b,
+                                                      iterpool));
+            refreshed_path = path;
+            break;
+
+          default:
+            if (change->prop_mod
+                && change->mergeinfo_mod != svn_tristate_false)
+              {
+                SVN_ERR(end_mergeinfo(sdb, path, FALSE, rev));
+                SVN_ERR(svn_fs_fs__get_explicit_mergeinfo(root, path, FALSE,
+                                                          insert_receiver,
+                                                          &b, iterpool));
+              }
+            break;
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(set_indexed_revs(sdb, first, rev));
+}
+
+svn_error_t *
+svn_fs_fs__mergeinfo_index_add_revision(svn_fs_t *fs,
+                                        svn_revnum_t rev,
+                                        apr_hash_t *changed_paths,
+                                        apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_boolean_t exists;
+
+  if (! svn_fs_fs__fs_supports_mergeinfo(fs))
+    return SVN_NO_ERROR;
+
+  /* Only new repositories get the index with their first commit. */
+  SVN_ERR(index_exists(&exists, fs, scratch_pool));
+  if (!exists && rev != 1)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(open_index(fs, scratch_pool));
+  SVN_SQLITE__WITH_TXN(add_revision(fs, rev, changed_paths, scratch_pool),
+                       ffd->mergeinfo_index_db);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__mergeinfo_index_find(apr_hash_t **catalog,
+                                svn_boolean_t *missing,
+                                svn_fs_t *fs,
+                                svn_revnum_t rev,
+                                const char *path,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_revnum_t first, last;
+  svn_boolean_t exists;
+  svn_boolean_t have_row;
+
+  *catalog = NULL;
+  *missing = FALSE;
+
+  /* Don't create the DB just to find out that it is empty. */
+  SVN_ERR(index_exists(&exists, fs, scratch_pool));
+  if (!exists)
+    {
+      *missing = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(open_index(fs, scratch_pool));
+  SVN_ERR(get_indexed_revs(&first, &last, ffd->mergeinfo_index_db));
+  if (!SVN_IS_VALID_REVNUM(first))
+    {
+      *missing = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  if (rev < first || rev > last)
+    return SVN_NO_ERROR;
+
+  *catalog = apr_hash_make(result_pool);
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->mergeinfo_index_db,
+                                    STMT_GET_DESCENDANT_MERGEINFO));
+  SVN_ERR(svn_sqlite__bindf(stmt, "sr", strcmp(path, "/") ? path : "", rev));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      const char *child_path = svn_sqlite__column_text(stmt, 0, result_pool);
+      const char *mergeinfo = svn_sqlite__column_text(stmt, 1, result_pool);
+
+      svn_hash_sets(*catalog, child_path,
+                    svn_string_create(mergeinfo, result_pool));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+/* Baton for create_index(). */
+typedef struct create_baton_t
+{
+  svn_fs_t *fs;
+  svn_revnum_t rev;
+  apr_hash_t *catalog;
+} create_baton_t;
+
+/* Body of create_index(), to be run within an SQLite transaction. */
+static svn_error_t *
+write_catalog(create_baton_t *b,
+              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = b->fs->fsap_data;
+  svn_revnum_t first, last;
+  apr_hash_index_t *hi;
+
+  /* A commit or another query may have been faster. */
+  SVN_ERR(get_indexed_revs(&first, &last, ffd->mergeinfo_index_db));
+  if (SVN_IS_VALID_REVNUM(first))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_sqlite__exec_statements(ffd->mergeinfo_index_db,
+                                      STMT_CLEAR_INDEX));
+  for (hi = apr_hash_first(scratch_pool, b->catalog);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const svn_string_t *mergeinfo = apr_hash_this_val(hi);
+
+      SVN_ERR(insert_mergeinfo(ffd->mergeinfo_index_db, apr_hash_this_key(hi),
+                               b->rev, mergeinfo->data));
+    }
+
+  return svn_error_trace(set_indexed_revs(ffd->mergeinfo_index_db,
+                                          b->rev, b->rev));
+}
+
+/* Implements the body of svn_fs_fs__with_write_lock() for
+ * svn_fs_fs__mergeinfo_index_create().  BATON is a create_baton_t *. */
+static svn_error_t *
+create_index(void *baton,
+             apr_pool_t *pool)
+{
+  create_baton_t *b = baton;
+  fs_fs_data_t *ffd = b->fs->fsap_data;
+  svn_revnum_t youngest;
+
+  /* Holding the write lock, nobody can commit and extend the index while
+   * we fill it.  But they may have done so after our caller crawled. */
+  SVN_ERR(svn_fs_fs__youngest_rev(&youngest, b->fs, pool));
+  if (youngest != b->rev)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(open_index(b->fs, pool));
+  SVN_SQLITE__WITH_TXN(write_catalog(b, pool), ffd->mergeinfo_index_db);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__mergeinfo_index_create(svn_fs_t *fs,
+                                  svn_revnum_t rev,
+                                  apr_hash_t *catalog,
+                                  apr_pool_t *scratch_pool)
+{
+  create_baton_t b;
+
+  b.fs = fs;
+  b.rev = rev;
+  b.catalog = catalog;
+
+  return svn_error_trace(svn_fs_fs__with_write_lock(fs, create_index, &b,
+                                                    scratch_pool));
+}
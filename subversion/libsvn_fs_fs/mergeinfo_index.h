@@ -0,0 +1,85 @@
+/* mergeinfo_index.h : index of the explicit mergeinfo in FSFS revisions
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS__MERGEINFO_INDEX_H
+#define SVN_LIBSVN_FS__MERGEINFO_INDEX_H
+
+#include "fs.h"
+
+/* The mergeinfo index is an SQLite database that maps every path with
+ * explicit mergeinfo to that mergeinfo, for each range of revisions in
+ * which it stays the same.  It answers queries for the mergeinfo below
+ * some path without crawling the tree.
+ *
+ * The index covers a contiguous range of revisions.  New repositories
+ * get it with their first commit.  For others, it gets created by the
+ * first query for the mergeinfo below the root in the youngest revision,
+ * which has to crawl the whole tree anyway.  From then on, every commit
+ * extends it by one revision.
+ *
+ * The index is advisory.  Revisions that it does not cover get crawled
+ * as before, and a commit that finds a gap in the index drops it, so
+ * that it gets created again later.
+ */
+
+#define MERGEINFO_INDEX_DB_NAME "mergeinfo-index.db"
+
+/* Extend the mergeinfo index of FS by the just committed revision REV,
+ * given the CHANGED_PATHS (mapping const char * to svn_fs_path_change2_t *)
+ * of that revision.  The caller must hold the FS write lock.  Use
+ * SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__mergeinfo_index_add_revision(svn_fs_t *fs,
+                                        svn_revnum_t rev,
+                                        apr_hash_t *changed_paths,
+                                        apr_pool_t *scratch_pool);
+
+/* If the mergeinfo index of FS covers REV, set *CATALOG to a hash mapping
+ * every path below PATH with explicit mergeinfo in REV to that mergeinfo
+ * as svn_string_t *.  Otherwise, set *CATALOG to NULL.  Set *MISSING to
+ * TRUE if FS has no mergeinfo index at all.
+ *
+ * PATH must be canonical.  Allocate *CATALOG in RESULT_POOL and use
+ * SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__mergeinfo_index_find(apr_hash_t **catalog,
+                                svn_boolean_t *missing,
+                                svn_fs_t *fs,
+                                svn_revnum_t rev,
+                                const char *path,
+                                apr_pool_t *result_pool,
+                                apr_pool_t *scratch_pool);
+
+/* Create the mergeinfo index of FS from the CATALOG of all explicit
+ * mergeinfo in revision REV, which maps paths to svn_string_t *.  Do
+ * nothing if FS has an index already or REV is not the youngest revision.
+ * Use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__mergeinfo_index_create(svn_fs_t *fs,
+                                  svn_revnum_t rev,
+                                  apr_hash_t *catalog,
+                                  apr_pool_t *scratch_pool);
+
+#endif
@@ -30,9 +30,13 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_io_private.h"
+#include "private/svn_task.h"
 
+#include "batch_fsync.h"
+#include "cached_data.h"
 #include "fs_fs.h"
 #include "pack.h"
+#include "path_index.h"
 #include "util.h"
 #include "id.h"
 #include "index.h"
@@ -1724,6 +1728,7 @@ pack_phys_addressed(const char *pack_file_dir,
   apr_file_t *pack_file;
   apr_file_t *manifest_file;
   svn_stream_t *manifest_stream;
+  svn_fs_fs__batch_fsync_t *batch;
   svn_revnum_t end_rev, rev;
   apr_pool_t *iterpool;
 
@@ -1781,20 +1786,20 @@ pack_phys_addressed(const char *pack_file_dir,
 
   /* Close stream over APR file. */
   SVN_ERR(svn_stream_close(manifest_stream));
-
-  /* Ensure that pack file is written to disk. */
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(manifest_file, pool));
   SVN_ERR(svn_io_file_close(manifest_file, pool));
+  SVN_ERR(svn_io_file_close(pack_file, pool));
+
+  /* Ensure that both files and their names are written to disk.
+   * The fsyncs are independent of each other, so run them concurrently. */
+  SVN_ERR(svn_fs_fs__batch_fsync_create(&batch, flush_to_disk, pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_add_file(batch, manifest_file_path, pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_add_file(batch, pack_file_path, pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, pack_file_path, pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_run(batch, pool));
 
   /* disallow write access to the manifest file */
   SVN_ERR(svn_io_set_file_read_only(manifest_file_path, FALSE, iterpool));
 
-  /* Ensure that pack file is written to disk. */
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(pack_file, pool));
-  SVN_ERR(svn_io_file_close(pack_file, pool));
-
   svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
@@ -1847,6 +1852,10 @@ pack_rev_shard(svn_fs_t *fs,
                                 max_files_per_dir, flush_to_disk,
                                 cancel_func, cancel_baton, pool));
 
+  /* Changed paths index. */
+  SVN_ERR(svn_fs_fs__path_index_pack(fs, pack_file_dir, shard_rev,
+                                     cancel_func, cancel_baton, pool));
+
   SVN_ERR(svn_io_copy_perms(shard_path, pack_file_dir, pool));
   SVN_ERR(svn_io_set_file_read_only(pack_file_path, FALSE, pool));
 
@@ -1865,6 +1874,7 @@ struct pack_baton
   svn_cancel_func_t cancel_func;
   void *cancel_baton;
   size_t max_mem;
+  int jobs;
 
   /* Additional entries valid when entering pack_shard(). */
   const char *revs_dir;
@@ -1928,6 +1938,7 @@ synced_pack_shard(void *baton,
   /* Finally, remove the existing shard directories.
    * For revprops, clean up older obsolete shards as well as they might
    * have been left over from an interrupted FS upgrade. */
+  svn_fs_fs__rev_file_cache_clear(pb->fs);
   SVN_ERR(svn_io_remove_dir2(pb->rev_shard_path, TRUE,
                              pb->cancel_func, pb->cancel_baton, pool));
   if (pb->revsprops_dir)
@@ -1957,6 +1968,53 @@ synced_pack_shard(void *baton,
   return SVN_NO_ERROR;
 }
 
+/* Set *REV_PACK_FILE_DIR to the pack folder and BATON->REV_SHARD_PATH
+ * to the non-packed folder of the shard described by BATON.
+ * Allocate the results in POOL.
+ */
+static void
+get_shard_paths(const char **rev_pack_file_dir,
+                struct pack_baton *baton,
+                apr_pool_t *pool)
+{
+  *rev_pack_file_dir = svn_dirent_join(baton->revs_dir,
+                  apr_psprintf(pool,
+                               "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
+                               baton->shard),
+                  pool);
+  baton->rev_shard_path = svn_dirent_join(baton->revs_dir,
+                                          apr_psprintf(pool,
+                                                       "%" APR_INT64_T_FMT,
+                                                       baton->shard),
+                                          pool);
+}
+
+/* The revision contents of the shard described by BATON has been packed.
+ * Switch the repository over to that packed data.
+ */
+static svn_error_t *
+switch_to_packed_shard(struct pack_baton *baton,
+                       apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = baton->fs->fsap_data;
+
+  /* For newer repo formats, we only acquired the pack lock so far.
+     Before modifying the repo state by switching over to the packed
+     data, we need to acquire the global (write) lock. */
+  if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
+    SVN_ERR(svn_fs_fs__with_write_lock(baton->fs, synced_pack_shard, baton,
+                                       pool));
+  else
+    SVN_ERR(synced_pack_shard(baton, pool));
+
+  /* Notify caller we're done packing this shard. */
+  if (baton->notify_func)
+    SVN_ERR(baton->notify_func(baton->notify_baton, baton->shard,
+                               svn_fs_pack_notify_end, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Pack the shard described by BATON.
  *
  * If for some reason we detect a partial packing already performed,
@@ -1975,16 +2033,7 @@ pack_shard(struct pack_baton *baton,
                                svn_fs_pack_notify_start, pool));
 
   /* Some useful paths. */
-  rev_pack_file_dir = svn_dirent_join(baton->revs_dir,
-                  apr_psprintf(pool,
-                               "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
-                               baton->shard),
-                  pool);
-  baton->rev_shard_path = svn_dirent_join(baton->revs_dir,
-                                          apr_psprintf(pool,
-                                                       "%" APR_INT64_T_FMT,
-                                                       baton->shard),
-                                          pool);
+  get_shard_paths(&rev_pack_file_dir, baton, pool);
 
   /* pack the revision content */
   SVN_ERR(pack_rev_shard(baton->fs, rev_pack_file_dir, baton->rev_shard_path,
@@ -1992,23 +2041,155 @@ pack_shard(struct pack_baton *baton,
                          baton->max_mem, ffd->flush_to_disk,
                          baton->cancel_func, baton->cancel_baton, pool));
 
-  /* For newer repo formats, we only acquired the pack lock so far.
-     Before modifying the repo state by switching over to the packed
-     data, we need to acquire the global (write) lock. */
-  if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
-    SVN_ERR(svn_fs_fs__with_write_lock(baton->fs, synced_pack_shard, baton,
-                                       pool));
-  else
-    SVN_ERR(synced_pack_shard(baton, pool));
+  return svn_error_trace(switch_to_packed_shard(baton, pool));
+}
 
-  /* Notify caller we're starting to pack this shard. */
-  if (baton->notify_func)
-    SVN_ERR(baton->notify_func(baton->notify_baton, baton->shard,
-                               svn_fs_pack_notify_end, pool));
+/* Process baton of a parallel pack task covering the shards FIRST to LAST
+ * (inclusive).  The shared state is in PB and must not be modified by the
+ * process function.
+ */
+typedef struct pack_range_t
+{
+  struct pack_baton *pb;
+  apr_int64_t first;
+  apr_int64_t last;
+} pack_range_t;
+
+/* Implements svn_task__thread_context_constructor_t.  The thread context
+ * is the svn_fs_t instance to read from.  CONTEXT_BATON is the
+ * struct pack_baton *.
+ */
+static svn_error_t *
+pack_context_constructor(void **thread_context,
+                         void *context_baton,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  struct pack_baton *pb = context_baton;
+  svn_fs_t *fs = pb->fs;
+
+  /* Worker threads must not share the svn_fs_t with the main thread. */
+  if (pb->jobs > 1)
+    SVN_ERR(svn_fs_fs__open_instance(&fs, pb->fs, result_pool,
+                                     scratch_pool));
+
+  *thread_context = fs;
+  return SVN_NO_ERROR;
+}
+
+/* Add a sub-task to TASK that will pack the shards FIRST to LAST
+ * (inclusive) for the pack operation PB.
+ */
+static svn_error_t *
+add_pack_range(svn_task__t *task,
+               struct pack_baton *pb,
+               apr_int64_t first,
+               apr_int64_t last)
+{
+  apr_pool_t *process_pool = svn_task__create_process_pool(task);
+  pack_range_t *range = apr_pcalloc(process_pool, sizeof(*range));
+
+  range->pb = pb;
+  range->first = first;
+  range->last = last;
+
+  return svn_error_trace(svn_task__add_similar(task, process_pool, NULL,
+                                               range));
+}
+
+/* Implements svn_task__process_func_t.  PROCESS_BATON is a pack_range_t
+ * and THREAD_CONTEXT the svn_fs_t to read from.
+ *
+ * Ranges of more than one shard get split in halves and turned into
+ * sub-tasks.  For single shards, create the pack file and indexes and
+ * return the shard number as the result.  Switching the repository over
+ * to the packed shard is left to the output function.
+ */
+static svn_error_t *
+pack_range_process(void **result,
+                   svn_task__t *task,
+                   void *thread_context,
+                   void *process_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  const pack_range_t *range = process_baton;
+  svn_fs_t *fs = thread_context;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_int64_t *shard;
+  const char *rev_pack_file_dir, *rev_shard_path;
+
+  if (range->first < range->last)
+    {
+      apr_int64_t mid = range->first + (range->last - range->first) / 2;
+
+      SVN_ERR(add_pack_range(task, range->pb, range->first, mid));
+      SVN_ERR(add_pack_range(task, range->pb, mid + 1, range->last));
+
+      *result = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  rev_pack_file_dir = svn_dirent_join(range->pb->revs_dir,
+                  apr_psprintf(scratch_pool,
+                               "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
+                               range->first),
+                  scratch_pool);
+  rev_shard_path = svn_dirent_join(range->pb->revs_dir,
+                                   apr_psprintf(scratch_pool,
+                                                "%" APR_INT64_T_FMT,
+                                                range->first),
+                                   scratch_pool);
+
+  /* All jobs share the same memory budget. */
+  SVN_ERR(pack_rev_shard(fs, rev_pack_file_dir, rev_shard_path,
+                         range->first, ffd->max_files_per_dir,
+                         range->pb->max_mem / range->pb->jobs,
+                         ffd->flush_to_disk,
+                         cancel_func, cancel_baton, scratch_pool));
+
+  shard = apr_palloc(result_pool, sizeof(*shard));
+  *shard = range->first;
+  *result = shard;
 
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_task__output_func_t.  RESULT is the number of the shard
+ * whose revision contents got packed and OUTPUT_BATON the struct
+ * pack_baton *.  Since this gets called in shard order, we atomically
+ * install the packed shards in the same order as a sequential pack would.
+ */
+static svn_error_t *
+pack_range_output(svn_task__t *task,
+                  void *result,
+                  void *output_baton,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  struct pack_baton *pb = output_baton;
+  const char *rev_pack_file_dir;
+
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  pb->shard = *(apr_int64_t *)result;
+
+  /* In parallel mode, we can only report a shard once it has been
+   * processed. */
+  if (pb->notify_func)
+    SVN_ERR(pb->notify_func(pb->notify_baton, pb->shard,
+                            svn_fs_pack_notify_start, scratch_pool));
+
+  get_shard_paths(&rev_pack_file_dir, pb, scratch_pool);
+
+  return svn_error_trace(switch_to_packed_shard(pb, scratch_pool));
+}
+
 /* Read the youngest rev and the first non-packed rev info for FS from disk.
    Set *FULLY_PACKED when there is no completed unpacked shard.
    Use SCRATCH_POOL for temporary allocations.
@@ -2081,16 +2262,35 @@ pack_body(void *baton,
                                         pool);
 
   iterpool = svn_pool_create(pool);
-  for (pb->shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
-       pb->shard < completed_shards;
-       pb->shard++)
+  if (pb->jobs > 1)
     {
-      svn_pool_clear(iterpool);
+      /* Pack the revision contents of multiple shards at once but switch
+       * over to the packed data strictly in order. */
+      pack_range_t *range = apr_pcalloc(pool, sizeof(*range));
+      range->pb = pb;
+      range->first = ffd->min_unpacked_rev / ffd->max_files_per_dir;
+      range->last = completed_shards - 1;
+
+      SVN_ERR(svn_task__run(pb->jobs,
+                            pack_range_process, range,
+                            pack_range_output, pb,
+                            pack_context_constructor, pb,
+                            pb->cancel_func, pb->cancel_baton,
+                            pool, iterpool));
+    }
+  else
+    {
+      for (pb->shard = ffd->min_unpacked_rev / ffd->max_files_per_dir;
+           pb->shard < completed_shards;
+           pb->shard++)
+        {
+          svn_pool_clear(iterpool);
 
-      if (pb->cancel_func)
-        SVN_ERR(pb->cancel_func(pb->cancel_baton));
+          if (pb->cancel_func)
+            SVN_ERR(pb->cancel_func(pb->cancel_baton));
 
-      SVN_ERR(pack_shard(pb, iterpool));
+          SVN_ERR(pack_shard(pb, iterpool));
+        }
     }
 
   svn_pool_destroy(iterpool);
@@ -2100,6 +2300,7 @@ pack_body(void *baton,
 svn_error_t *
 svn_fs_fs__pack(svn_fs_t *fs,
                 apr_size_t max_mem,
+                int jobs,
                 svn_fs_pack_notify_t notify_func,
                 void *notify_baton,
                 svn_cancel_func_t cancel_func,
@@ -2146,6 +2347,7 @@ svn_fs_fs__pack(svn_fs_t *fs,
   pb.cancel_func = cancel_func;
   pb.cancel_baton = cancel_baton;
   pb.max_mem = max_mem ? max_mem : DEFAULT_MAX_MEM;
+  pb.jobs = MAX(jobs, 1);
 
   if (ffd->format >= SVN_FS_FS__MIN_PACK_LOCK_FORMAT)
     {
@@ -2166,3 +2368,470 @@ svn_fs_fs__pack(svn_fs_t *fs,
 
   return svn_error_trace(err);
 }
+
+
+/* Head locality repacking logic:
+ *
+ * Items never move between pack files because their addresses are
+ * resolved per pack file.  But within each pack file, we may change their
+ * order at will as long as we write matching indexes.
+ *
+ * To make the tree of a given revision cheap to read, we first walk that
+ * tree and collect the noderevs and representations it uses, grouped by
+ * the shard that contains them.  Then we rewrite every packed shard that
+ * contains any of these "hot" items:  hot items come first, in tree order,
+ * each representation followed by its delta bases within the same shard.
+ * All other items follow in their previous order.  Delta bases in older
+ * shards become hot items of those shards, so we process shards from the
+ * newest to the oldest.
+ *
+ * The new pack file replaces the old one atomically.  Readers that still
+ * have the old file open continue to use it.  Since pack files are
+ * identified by their generation in all index cache keys, readers opening
+ * the new file will never use index data cached for the old one.
+ */
+
+/* Repack state shared by all shards. */
+typedef struct repack_baton_t
+{
+  /* file system to repack */
+  svn_fs_t *fs;
+
+  /* revision whose tree shall be placed contiguously */
+  svn_revnum_t revision;
+
+  /* number of packed shards */
+  apr_int64_t shard_count;
+
+  /* All items encountered so far, including those in non-packed
+   * revisions.  Maps svn_fs_fs__id_part_t to itself. */
+  apr_hash_t *seen;
+
+  /* For each packed shard, NULL or the array of svn_fs_fs__id_part_t of
+   * its hot items in placement order. */
+  apr_array_header_t **hot_items;
+
+  /* progress notification */
+  svn_fs_progress_notify_func_t notify_func;
+  void *notify_baton;
+
+  /* cancellation support */
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  /* pool for SEEN and HOT_ITEMS */
+  apr_pool_t *pool;
+} repack_baton_t;
+
+/* Set *KEY to (REVISION, NUMBER) such that it may be used as a binary
+ * hash key.
+ */
+static void
+init_item_key(svn_fs_fs__id_part_t *key,
+              svn_revnum_t revision,
+              apr_uint64_t number)
+{
+  memset(key, 0, sizeof(*key));
+  key->revision = revision;
+  key->number = number;
+}
+
+/* Record item NUMBER of REVISION as used by the tree in RB.  If it is in
+ * a packed shard, append it to that shard's hot items.  Set *IS_NEW to
+ * FALSE, if the item has already been recorded before.
+ */
+static void
+add_hot_item(svn_boolean_t *is_new,
+             repack_baton_t *rb,
+             svn_revnum_t revision,
+             apr_uint64_t number)
+{
+  fs_fs_data_t *ffd = rb->fs->fsap_data;
+  apr_int64_t shard = revision / ffd->max_files_per_dir;
+  svn_fs_fs__id_part_t key;
+  svn_fs_fs__id_part_t *copy;
+
+  init_item_key(&key, revision, number);
+  *is_new = apr_hash_get(rb->seen, &key, sizeof(key)) == NULL;
+  if (!*is_new)
+    return;
+
+  copy = apr_pmemdup(rb->pool, &key, sizeof(key));
+  apr_hash_set(rb->seen, copy, sizeof(*copy), copy);
+
+  if (shard < rb->shard_count)
+    {
+      if (rb->hot_items[shard] == NULL)
+        rb->hot_items[shard] = apr_array_make(rb->pool, 16, sizeof(key));
+
+      APR_ARRAY_PUSH(rb->hot_items[shard], svn_fs_fs__id_part_t) = key;
+    }
+}
+
+/* Record the committed representation REP, if not NULL, in RB.
+ */
+static void
+add_hot_rep(repack_baton_t *rb,
+            const representation_t *rep)
+{
+  svn_boolean_t is_new;
+
+  if (rep && SVN_IS_VALID_REVNUM(rep->revision))
+    add_hot_item(&is_new, rb, rep->revision, rep->item_index);
+}
+
+/* Record the node revision ID, its representations and, for directories,
+ * the whole sub-tree below it in RB.  Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+collect_tree_items(repack_baton_t *rb,
+                   const svn_fs_id_t *id,
+                   apr_pool_t *scratch_pool)
+{
+  const svn_fs_fs__id_part_t *rev_item = svn_fs_fs__id_rev_item(id);
+  node_revision_t *noderev;
+  apr_array_header_t *entries;
+  apr_pool_t *iterpool;
+  svn_boolean_t is_new;
+  int i;
+
+  /* Unchanged sub-trees are shared between branches.  Walk them once. */
+  add_hot_item(&is_new, rb, rev_item->revision, rev_item->number);
+  if (!is_new)
+    return SVN_NO_ERROR;
+
+  if (rb->cancel_func)
+    SVN_ERR(rb->cancel_func(rb->cancel_baton));
+
+  SVN_ERR(svn_fs_fs__get_node_revision(&noderev, rb->fs, id, scratch_pool,
+                                       scratch_pool));
+  add_hot_rep(rb, noderev->prop_rep);
+  add_hot_rep(rb, noderev->data_rep);
+
+  if (noderev->kind != svn_node_dir)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_fs__rep_contents_dir(&entries, rb->fs, noderev,
+                                      scratch_pool, scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      svn_fs_dirent_t *dirent = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(collect_tree_items(rb, dirent->id, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Read all non-empty P2L index entries of the pack file REV_FILE for the
+ * shard starting at SHARD_REV in FS and return them in *ENTRIES as an
+ * array of svn_fs_fs__p2l_entry_t *, allocated in RESULT_POOL.  Use
+ * SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+read_pack_entries(apr_array_header_t **entries,
+                  svn_fs_t *fs,
+                  svn_fs_fs__revision_file_t *rev_file,
+                  svn_revnum_t shard_rev,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_array_header_t *result
+    = apr_array_make(result_pool, 16, sizeof(svn_fs_fs__p2l_entry_t *));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_off_t offset = 0;
+
+  SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
+  while (offset < rev_file->l2p_offset)
+    {
+      apr_array_header_t *page;
+      int i;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__p2l_index_lookup(&page, fs, rev_file, shard_rev,
+                                          offset, ffd->p2l_page_size,
+                                          iterpool, iterpool));
+
+      for (i = 0; i < page->nelts; ++i)
+        {
+          svn_fs_fs__p2l_entry_t *entry
+            = &APR_ARRAY_IDX(page, i, svn_fs_fs__p2l_entry_t);
+
+          /* skip first entry if that was duplicated due crossing a
+             cluster boundary */
+          if (offset > entry->offset || entry->offset >= rev_file->l2p_offset)
+            continue;
+
+          offset = entry->offset + entry->size;
+          if (entry->type != SVN_FS_FS__ITEM_TYPE_UNUSED)
+            APR_ARRAY_PUSH(result, svn_fs_fs__p2l_entry_t *)
+              = apr_pmemdup(result_pool, entry, sizeof(*entry));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  *entries = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Copy the item identified by KEY from REV_FILE to CONTEXT's pack file,
+ * unless it has already been placed, i.e. is no longer in UNPLACED.  If it
+ * is a delta representation, place its base right behind it or, if that
+ * is in an older shard, record the base as hot item in RB.  Use
+ * SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+place_hot_item(pack_context_t *context,
+               repack_baton_t *rb,
+               svn_fs_fs__revision_file_t *rev_file,
+               apr_hash_t *unplaced,
+               const svn_fs_fs__id_part_t *key,
+               apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__p2l_entry_t *entry = apr_hash_get(unplaced, key, sizeof(*key));
+  svn_fs_fs__rep_header_t *header = NULL;
+  svn_fs_fs__id_part_t base_key;
+  svn_boolean_t is_new;
+
+  if (entry == NULL)
+    return SVN_NO_ERROR;
+
+  apr_hash_set(unplaced, key, sizeof(*key), NULL);
+
+  /* Read the rep header before STORE_ITEM updates the item offset. */
+  if (   entry->type == SVN_FS_FS__ITEM_TYPE_FILE_REP
+      || entry->type == SVN_FS_FS__ITEM_TYPE_DIR_REP
+      || entry->type == SVN_FS_FS__ITEM_TYPE_FILE_PROPS
+      || entry->type == SVN_FS_FS__ITEM_TYPE_DIR_PROPS)
+    {
+      apr_off_t offset = entry->offset;
+      SVN_ERR(svn_io_file_seek(rev_file->file, APR_SET, &offset,
+                               scratch_pool));
+      SVN_ERR(svn_fs_fs__read_rep_header(&header, rev_file->stream,
+                                         scratch_pool, scratch_pool));
+    }
+
+  SVN_ERR(store_item(context, rev_file->file, entry, scratch_pool));
+
+  if (header == NULL || header->type != svn_fs_fs__rep_delta)
+    return SVN_NO_ERROR;
+
+  if (header->base_revision >= context->shard_rev)
+    {
+      init_item_key(&base_key, header->base_revision,
+                    header->base_item_index);
+      SVN_ERR(place_hot_item(context, rb, rev_file, unplaced, &base_key,
+                             scratch_pool));
+    }
+  else
+    {
+      add_hot_item(&is_new, rb, header->base_revision,
+                   header->base_item_index);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Rewrite the pack file of SHARD in RB such that its hot items come
+ * first.  Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+repack_shard(repack_baton_t *rb,
+             apr_int64_t shard,
+             apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = rb->fs;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_array_header_t *hot_items = rb->hot_items[shard];
+  pack_context_t context = { 0 };
+  svn_fs_fs__revision_file_t *rev_file;
+  apr_array_header_t *entries;
+  apr_hash_t *unplaced = apr_hash_make(scratch_pool);
+  const char *temp_path;
+  const char *l2p_proto_path;
+  const char *p2l_proto_path;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  context.fs = fs;
+  context.cancel_func = rb->cancel_func;
+  context.cancel_baton = rb->cancel_baton;
+  context.shard_rev = (svn_revnum_t)(shard * ffd->max_files_per_dir);
+  context.shard_end_rev = context.shard_rev + ffd->max_files_per_dir;
+  context.flush_to_disk = ffd->flush_to_disk;
+  context.pack_file_path = svn_fs_fs__path_rev_packed(fs, context.shard_rev,
+                                                      PATH_PACKED,
+                                                      scratch_pool);
+  context.pack_file_dir = svn_dirent_dirname(context.pack_file_path,
+                                             scratch_pool);
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, context.shard_rev,
+                                           scratch_pool, iterpool));
+  SVN_ERR(read_pack_entries(&entries, fs, rev_file, context.shard_rev,
+                            scratch_pool, iterpool));
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      svn_fs_fs__p2l_entry_t *entry
+        = APR_ARRAY_IDX(entries, i, svn_fs_fs__p2l_entry_t *);
+      svn_fs_fs__id_part_t *key = apr_palloc(scratch_pool, sizeof(*key));
+
+      init_item_key(key, entry->item.revision, entry->item.number);
+      apr_hash_set(unplaced, key, sizeof(*key), entry);
+    }
+
+  /* Remove leftovers from an interrupted repack. */
+  temp_path = svn_dirent_join(context.pack_file_dir,
+                              PATH_PACKED ".repack", scratch_pool);
+  l2p_proto_path = svn_dirent_join(context.pack_file_dir,
+                                   PATH_INDEX PATH_EXT_L2P_INDEX,
+                                   scratch_pool);
+  p2l_proto_path = svn_dirent_join(context.pack_file_dir,
+                                   PATH_INDEX PATH_EXT_P2L_INDEX,
+                                   scratch_pool);
+  SVN_ERR(svn_io_remove_file2(temp_path, TRUE, iterpool));
+  SVN_ERR(svn_io_remove_file2(l2p_proto_path, TRUE, iterpool));
+  SVN_ERR(svn_io_remove_file2(p2l_proto_path, TRUE, iterpool));
+
+  SVN_ERR(svn_io_file_open(&context.pack_file, temp_path,
+                           APR_WRITE | APR_BUFFERED | APR_BINARY | APR_EXCL
+                             | APR_CREATE, APR_OS_DEFAULT, scratch_pool));
+  SVN_ERR(svn_fs_fs__l2p_proto_index_open(&context.proto_l2p_index,
+                                          l2p_proto_path, scratch_pool));
+  SVN_ERR(svn_fs_fs__p2l_proto_index_open(&context.proto_p2l_index,
+                                          p2l_proto_path, scratch_pool));
+  context.reps = apr_array_make(scratch_pool, entries->nelts,
+                                sizeof(svn_fs_fs__p2l_entry_t *));
+
+  /* Hot items first.  Placing them may add more hot items. */
+  for (i = 0; i < hot_items->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      if (rb->cancel_func && i % 1000 == 0)
+        SVN_ERR(rb->cancel_func(rb->cancel_baton));
+
+      SVN_ERR(place_hot_item(&context, rb, rev_file, unplaced,
+                             &APR_ARRAY_IDX(hot_items, i,
+                                            svn_fs_fs__id_part_t),
+                             iterpool));
+    }
+
+  /* All other items keep their relative order. */
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      svn_fs_fs__p2l_entry_t *entry
+        = APR_ARRAY_IDX(entries, i, svn_fs_fs__p2l_entry_t *);
+      svn_fs_fs__id_part_t key;
+
+      init_item_key(&key, entry->item.revision, entry->item.number);
+      if (apr_hash_get(unplaced, &key, sizeof(key)))
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(store_item(&context, rev_file->file, entry, iterpool));
+        }
+    }
+
+  SVN_ERR(write_l2p_index(&context, iterpool));
+  SVN_ERR(close_pack_context(&context, iterpool));
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+  svn_fs_fs__rev_file_cache_clear(rb->fs);
+
+  /* Atomically replace the old pack file. */
+  SVN_ERR(svn_io_set_file_read_only(temp_path, FALSE, iterpool));
+  SVN_ERR(svn_fs_fs__move_into_place(temp_path, context.pack_file_path,
+                                     context.pack_file_path,
+                                     ffd->flush_to_disk, iterpool));
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* The work-horse for svn_fs_fs__repack, called with the pack lock.
+ * BATON is a repack_baton_t *.  Use POOL for allocations.
+ */
+static svn_error_t *
+repack_body(void *baton,
+            apr_pool_t *pool)
+{
+  repack_baton_t *rb = baton;
+  fs_fs_data_t *ffd = rb->fs->fsap_data;
+  svn_fs_id_t *root_id;
+  apr_pool_t *iterpool;
+  apr_int64_t shard;
+
+  /* Another process might have packed more shards in the meantime. */
+  SVN_ERR(svn_fs_fs__read_min_unpacked_rev(&ffd->min_unpacked_rev, rb->fs,
+                                           pool));
+  rb->shard_count = ffd->min_unpacked_rev / ffd->max_files_per_dir;
+  if (rb->shard_count == 0)
+    return SVN_NO_ERROR;
+
+  rb->pool = pool;
+  rb->seen = apr_hash_make(pool);
+  rb->hot_items = apr_pcalloc(pool, (apr_size_t)rb->shard_count
+                                    * sizeof(*rb->hot_items));
+
+  SVN_ERR(svn_fs_fs__rev_get_root(&root_id, rb->fs, rb->revision, pool,
+                                  pool));
+  SVN_ERR(collect_tree_items(rb, root_id, pool));
+
+  /* Newest first, so delta bases in older shards get picked up. */
+  iterpool = svn_pool_create(pool);
+  for (shard = rb->shard_count - 1; shard >= 0; --shard)
+    {
+      if (rb->hot_items[shard] == NULL)
+        continue;
+
+      svn_pool_clear(iterpool);
+      if (rb->notify_func)
+        rb->notify_func((svn_revnum_t)(shard * ffd->max_files_per_dir),
+                        rb->notify_baton, iterpool);
+
+      SVN_ERR(repack_shard(rb, shard, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__repack(svn_fs_t *fs,
+                  svn_revnum_t revision,
+                  svn_fs_progress_notify_func_t notify_func,
+                  void *notify_baton,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  repack_baton_t rb = { 0 };
+
+  if (!svn_fs_fs__use_log_addressing(fs))
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("Repacking requires a logically addressed "
+                              "FSFS repository (format 7)."));
+
+  if (!ffd->max_files_per_dir)
+    return SVN_NO_ERROR;
+
+  if (!SVN_IS_VALID_REVNUM(revision))
+    SVN_ERR(svn_fs_fs__youngest_rev(&revision, fs, pool));
+  else
+    SVN_ERR(svn_fs_fs__ensure_revision_exists(revision, fs, pool));
+
+  rb.fs = fs;
+  rb.revision = revision;
+  rb.notify_func = notify_func;
+  rb.notify_baton = notify_baton;
+  rb.cancel_func = cancel_func;
+  rb.cancel_baton = cancel_baton;
+
+  return svn_error_trace(svn_fs_fs__with_pack_lock(fs, repack_body, &rb,
+                                                   pool));
+}
@@ -32,6 +32,10 @@
    MAX_MEM limits the size of in-memory data structures needed for reordering
    items in format 7 repositories.  0 means use the built-in default.
 
+   Pack up to JOBS shards concurrently.  The MAX_MEM budget will be shared
+   between all of them.  Shards still get switched over to their packed
+   state strictly in order.
+
    If given, NOTIFY_FUNC will be called with NOTIFY_BATON to report progress.
    Use optional CANCEL_FUNC/CANCEL_BATON for cancellation support.
 
@@ -39,12 +43,36 @@
 svn_error_t *
 svn_fs_fs__pack(svn_fs_t *fs,
                 apr_size_t max_mem,
+                int jobs,
                 svn_fs_pack_notify_t notify_func,
                 void *notify_baton,
                 svn_cancel_func_t cancel_func,
                 void *cancel_baton,
                 apr_pool_t *pool);
 
+/* Rewrite the existing pack files of FS such that the node revisions and
+   representations needed to read the tree of REVISION, as well as the
+   delta bases of these representations, are stored contiguously in tree
+   order at the start of each pack file.  All other items follow in their
+   previous order.  If REVISION is SVN_INVALID_REVNUM, use the youngest
+   revision.
+
+   Pack files get replaced atomically and the repository remains fully
+   usable while this runs.  Only logically addressed repositories can be
+   repacked.
+
+   If given, NOTIFY_FUNC will be called with NOTIFY_BATON and the first
+   revision of each shard before it gets rewritten.
+   Use optional CANCEL_FUNC/CANCEL_BATON for cancellation support.  */
+svn_error_t *
+svn_fs_fs__repack(svn_fs_t *fs,
+                  svn_revnum_t revision,
+                  svn_fs_progress_notify_func_t notify_func,
+                  void *notify_baton,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *pool);
+
 /**
  * For the packed revision @a rev in @a fs,  determine the offset within
  * the revision pack file and return it in @a rev_offset.  Use @a pool for
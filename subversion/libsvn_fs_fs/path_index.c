@@ -0,0 +1,440 @@
+/* path_index.c --- per-shard index of the paths changed in each revision
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include "svn_pools.h"
+#include "svn_hash.h"
+#include "svn_dirent_uri.h"
+#include "svn_sorts.h"
+
+#include "private/svn_fspath.h"
+#include "private/svn_sorts_private.h"
+
+#include "fs_fs.h"
+#include "path_index.h"
+#include "transaction.h"
+#include "util.h"
+
+#include "svn_private_config.h"
+
+/* Return TRUE, if a change to CHANGED_PATH may affect the node at PATH.
+ * That is the case for PATH itself and all its parents and, if
+ * INCLUDE_DESCENDANTS is set, for all paths below PATH. */
+static svn_boolean_t
+is_relevant(const char *changed_path,
+            const char *path,
+            svn_boolean_t include_descendants)
+{
+  if (svn_fspath__skip_ancestor(changed_path, path))
+    return TRUE;
+
+  return include_descendants
+      && svn_fspath__skip_ancestor(path, changed_path) != NULL;
+}
+
+svn_error_t *
+svn_fs_fs__path_index_add_revision(svn_fs_t *fs,
+                                   svn_revnum_t rev,
+                                   apr_hash_t *changed_paths,
+                                   apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_stringbuf_t *lines;
+  apr_hash_index_t *hi;
+  apr_file_t *file;
+  const char *index_path;
+
+  if (!ffd->max_files_per_dir)
+    return SVN_NO_ERROR;
+
+  /* Write all lines at once, terminated by the "complete" marker. */
+  lines = svn_stringbuf_create_empty(scratch_pool);
+  for (hi = apr_hash_first(scratch_pool, changed_paths);
+       hi;
+       hi = apr_hash_next(hi))
+    svn_stringbuf_appendcstr(lines,
+                             apr_psprintf(scratch_pool, "%ld %s\n", rev,
+                                          (const char *)apr_hash_this_key(hi)));
+  svn_stringbuf_appendcstr(lines, apr_psprintf(scratch_pool, "%ld\n", rev));
+
+  index_path = svn_dirent_join(svn_fs_fs__path_rev_shard(fs, rev,
+                                                         scratch_pool),
+                               PATH_CHANGED_PATHS, scratch_pool);
+  SVN_ERR(svn_io_file_open(&file, index_path,
+                           APR_WRITE | APR_CREATE | APR_APPEND
+                           | APR_BUFFERED,
+                           APR_OS_DEFAULT, scratch_pool));
+  SVN_ERR(svn_io_file_write_full(file, lines->data, lines->len, NULL,
+                                 scratch_pool));
+
+  return svn_error_trace(svn_io_file_close(file, scratch_pool));
+}
+
+/* Implements svn_sort__array() compare function for C strings. */
+static int
+compare_lines(const void *lhs,
+              const void *rhs)
+{
+  return strcmp(*(const char * const *)lhs, *(const char * const *)rhs);
+}
+
+svn_error_t *
+svn_fs_fs__path_index_pack(svn_fs_t *fs,
+                           const char *pack_file_dir,
+                           svn_revnum_t shard_rev,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_array_header_t *lines = apr_array_make(scratch_pool, 1024,
+                                             sizeof(const char *));
+  svn_stringbuf_t *contents;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t rev;
+  int i;
+
+  for (rev = shard_rev; rev < shard_rev + ffd->max_files_per_dir; ++rev)
+    {
+      apr_hash_t *changed_paths;
+      apr_hash_index_t *hi;
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_fs_fs__paths_changed(&changed_paths, fs, rev, iterpool));
+      for (hi = apr_hash_first(iterpool, changed_paths);
+           hi;
+           hi = apr_hash_next(hi))
+        APR_ARRAY_PUSH(lines, const char *)
+          = apr_psprintf(scratch_pool, "%s\t%ld\n",
+                         (const char *)apr_hash_this_key(hi), rev);
+    }
+
+  /* Control characters are not allowed in paths.  Hence, all entries of
+   * a path as well as the entries of all paths below it form contiguous
+   * ranges in this order. */
+  svn_sort__array(lines, compare_lines);
+
+  contents = svn_stringbuf_create_empty(scratch_pool);
+  for (i = 0; i < lines->nelts; ++i)
+    svn_stringbuf_appendcstr(contents, APR_ARRAY_IDX(lines, i, const char *));
+
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_io_file_create(
+                           svn_dirent_join(pack_file_dir, PATH_CHANGED_PATHS,
+                                           scratch_pool),
+                           contents->data, scratch_pool));
+}
+
+/* Read the file at PATH into *CONTENTS.  Set it to NULL if the file does
+ * not exist.  Allocate the result in POOL. */
+static svn_error_t *
+read_index_file(svn_stringbuf_t **contents,
+                const char *path,
+                apr_pool_t *pool)
+{
+  svn_error_t *err = svn_stringbuf_from_file2(contents, path, pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *contents = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Set the MATCHED flags for all revisions in the packed index of the shard
+ * containing START and END in FS, that changed PATH, its parents or - if
+ * INCLUDE_DESCENDANTS is set - any path below it.  Set the COVERED flags
+ * for all revisions answered by the index.  The flags are indexed by
+ * revision - START.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+find_in_packed_index(svn_boolean_t *covered,
+                     svn_boolean_t *matched,
+                     svn_fs_t *fs,
+                     const char *path,
+                     svn_revnum_t start,
+                     svn_revnum_t end,
+                     svn_boolean_t include_descendants,
+                     apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  apr_array_header_t *lines;
+  apr_array_header_t *prefixes;
+  char *line;
+  int i;
+
+  SVN_ERR(read_index_file(&contents,
+                          svn_fs_fs__path_rev_packed(fs, start,
+                                                     PATH_CHANGED_PATHS,
+                                                     scratch_pool),
+                          scratch_pool));
+  if (!contents || (contents->len && contents->data[contents->len-1] != '\n'))
+    return SVN_NO_ERROR;
+
+  /* Split into lines. */
+  lines = apr_array_make(scratch_pool, 1024, sizeof(const char *));
+  for (line = contents->data; *line; )
+    {
+      char *eol = strchr(line, '\n');
+      *eol = '\0';
+      APR_ARRAY_PUSH(lines, const char *) = line;
+      line = eol + 1;
+    }
+
+  /* The key prefixes to look for. */
+  prefixes = apr_array_make(scratch_pool, 8, sizeof(const char *));
+  if (include_descendants)
+    APR_ARRAY_PUSH(prefixes, const char *)
+      = strcmp(path, "/") ? apr_pstrcat(scratch_pool, path, "/", SVN_VA_NULL)
+                          : "/";
+  while (TRUE)
+    {
+      APR_ARRAY_PUSH(prefixes, const char *)
+        = apr_pstrcat(scratch_pool, path, "\t", SVN_VA_NULL);
+      if (strcmp(path, "/") == 0)
+        break;
+
+      path = svn_fspath__dirname(path, scratch_pool);
+    }
+
+  for (i = 0; i < prefixes->nelts; ++i)
+    {
+      const char *prefix = APR_ARRAY_IDX(prefixes, i, const char *);
+      apr_size_t len = strlen(prefix);
+      int idx = svn_sort__bsearch_lower_bound(lines, &prefix, compare_lines);
+
+      for (; idx < lines->nelts; ++idx)
+        {
+          const char *entry = APR_ARRAY_IDX(lines, idx, const char *);
+          const char *tab;
+          svn_revnum_t rev;
+          svn_error_t *err;
+
+          if (strncmp(entry, prefix, len))
+            break;
+
+          /* Treat a malformed index like a missing one. */
+          tab = strrchr(entry, '\t');
+          if (!tab)
+            return SVN_NO_ERROR;
+
+          err = svn_revnum_parse(&rev, tab + 1, NULL);
+          if (err)
+            {
+              svn_error_clear(err);
+              return SVN_NO_ERROR;
+            }
+
+          if (rev >= start && rev <= end)
+            matched[rev - start] = TRUE;
+        }
+    }
+
+  for (i = 0; i <= end - start; ++i)
+    covered[i] = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Same as find_in_packed_index but for the append-only index of a
+ * non-packed shard.  Only revisions whose entries are known to be
+ * complete will be flagged as COVERED. */
+static svn_error_t *
+find_in_unpacked_index(svn_boolean_t *covered,
+                       svn_boolean_t *matched,
+                       svn_fs_t *fs,
+                       const char *path,
+                       svn_revnum_t start,
+                       svn_revnum_t end,
+                       svn_boolean_t include_descendants,
+                       apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  svn_boolean_t *found;
+  char *line;
+
+  SVN_ERR(read_index_file(&contents,
+                          svn_dirent_join(svn_fs_fs__path_rev_shard(
+                                            fs, start, scratch_pool),
+                                          PATH_CHANGED_PATHS, scratch_pool),
+                          scratch_pool));
+  if (!contents)
+    return SVN_NO_ERROR;
+
+  /* Collect matches separately because we may only report them once we
+   * have seen the "complete" marker. */
+  found = apr_pcalloc(scratch_pool, (end - start + 1) * sizeof(*found));
+
+  /* Stop at the first line that is incomplete or otherwise unexpected. */
+  for (line = contents->data; *line; )
+    {
+      char *eol = strchr(line, '\n');
+      const char *tail;
+      svn_revnum_t rev;
+      svn_error_t *err;
+
+      if (!eol)
+        break;
+
+      *eol = '\0';
+      err = svn_revnum_parse(&rev, line, &tail);
+      if (err)
+        {
+          svn_error_clear(err);
+          break;
+        }
+
+      if (rev >= start && rev <= end)
+        {
+          if (*tail == '\0')
+            {
+              covered[rev - start] = TRUE;
+              matched[rev - start] = found[rev - start];
+            }
+          else if (tail[0] == ' ' && tail[1] == '/')
+            {
+              if (is_relevant(tail + 1, path, include_descendants))
+                found[rev - start] = TRUE;
+            }
+          else
+            {
+              break;
+            }
+        }
+
+      line = eol + 1;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *MATCHED to whether the changes list of REV in FS contains PATH,
+ * one of its parents or - if INCLUDE_DESCENDANTS is set - any path below
+ * it.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+find_in_changes(svn_boolean_t *matched,
+                svn_fs_t *fs,
+                const char *path,
+                svn_revnum_t rev,
+                svn_boolean_t include_descendants,
+                apr_pool_t *scratch_pool)
+{
+  apr_hash_t *changed_paths;
+  apr_hash_index_t *hi;
+
+  *matched = FALSE;
+  SVN_ERR(svn_fs_fs__paths_changed(&changed_paths, fs, rev, scratch_pool));
+  for (hi = apr_hash_first(scratch_pool, changed_paths);
+       hi && !*matched;
+       hi = apr_hash_next(hi))
+    *matched = is_relevant(apr_hash_this_key(hi), path, include_descendants);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__path_index_find(apr_array_header_t **revisions,
+                           svn_fs_t *fs,
+                           const char *path,
+                           svn_revnum_t start,
+                           svn_revnum_t end,
+                           svn_boolean_t include_descendants,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_array_header_t *result = apr_array_make(result_pool, 16,
+                                              sizeof(svn_revnum_t));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_pool_t *revpool = svn_pool_create(scratch_pool);
+  svn_revnum_t youngest, shard_start, shard_end;
+
+  path = svn_fspath__canonicalize(path, scratch_pool);
+  SVN_ERR(svn_fs_fs__youngest_rev(&youngest, fs, scratch_pool));
+  end = MIN(end, youngest);
+
+  for (shard_start = start; shard_start <= end; shard_start = shard_end + 1)
+    {
+      svn_boolean_t *covered, *matched;
+      svn_revnum_t rev;
+
+      svn_pool_clear(iterpool);
+
+      /* Limit the range to the current shard. */
+      shard_end = end;
+      if (ffd->max_files_per_dir)
+        shard_end = MIN(end, shard_start
+                             - shard_start % ffd->max_files_per_dir
+                             + ffd->max_files_per_dir - 1);
+
+      covered = apr_pcalloc(iterpool,
+                            (shard_end - shard_start + 1) * sizeof(*covered));
+      matched = apr_pcalloc(iterpool,
+                            (shard_end - shard_start + 1) * sizeof(*matched));
+
+      if (ffd->max_files_per_dir)
+        {
+          if (svn_fs_fs__is_packed_rev(fs, shard_start))
+            SVN_ERR(find_in_packed_index(covered, matched, fs, path,
+                                         shard_start, shard_end,
+                                         include_descendants, iterpool));
+          else
+            SVN_ERR(find_in_unpacked_index(covered, matched, fs, path,
+                                           shard_start, shard_end,
+                                           include_descendants, iterpool));
+        }
+
+      /* Fill the gaps the index did not cover. */
+      for (rev = shard_start; rev <= shard_end; ++rev)
+        {
+          if (!covered[rev - shard_start])
+            {
+              svn_pool_clear(revpool);
+              if (cancel_func)
+                SVN_ERR(cancel_func(cancel_baton));
+
+              SVN_ERR(find_in_changes(&matched[rev - shard_start], fs, path,
+                                      rev, include_descendants, revpool));
+            }
+
+          if (matched[rev - shard_start])
+            APR_ARRAY_PUSH(result, svn_revnum_t) = rev;
+        }
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+    }
+
+  svn_pool_destroy(revpool);
+  svn_pool_destroy(iterpool);
+
+  *revisions = result;
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,94 @@
+/* path_index.h : per-shard index of the paths changed in each revision
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS__PATH_INDEX_H
+#define SVN_LIBSVN_FS__PATH_INDEX_H
+
+#include "fs.h"
+
+/* In sharded repositories, every shard may have a CHANGED_PATHS file
+ * that maps changed paths to the revisions that changed them.  It lets
+ * us find the few revisions of a shard that touched some path without
+ * reading the changes lists of all the others.
+ *
+ * Non-packed shards have an append-only version of the index in the rev
+ * shard folder that gets extended by every commit:
+ *
+ *   <rev> <path>\n     for every changed path, followed by
+ *   <rev>\n            once all paths of <rev> have been written.
+ *
+ * Packing the shard writes a sorted version into the pack folder:
+ *
+ *   <path>\t<rev>\n
+ *
+ * The index is advisory.  Revisions that it does not cover, e.g. because
+ * they have been committed or packed by older code or because updating
+ * the index failed, will be handled by reading their changes lists.
+ */
+
+/* Append the paths in CHANGED_PATHS (mapping const char * to
+ * svn_fs_path_change2_t *) to the index of the just committed revision
+ * REV in FS.  The caller must hold the FS write lock.  This is a no-op
+ * for non-sharded repositories.  Use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__path_index_add_revision(svn_fs_t *fs,
+                                   svn_revnum_t rev,
+                                   apr_hash_t *changed_paths,
+                                   apr_pool_t *scratch_pool);
+
+/* Write the sorted index for the shard starting at SHARD_REV in FS into
+ * the folder PACK_FILE_DIR.  The shard must not have been packed yet.
+ * CANCEL_FUNC and CANCEL_BATON are what you think they are.
+ * Use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__path_index_pack(svn_fs_t *fs,
+                           const char *pack_file_dir,
+                           svn_revnum_t shard_rev,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *scratch_pool);
+
+/* Set *REVISIONS to the sorted array of all svn_revnum_t in START to END
+ * of FS whose changes list contains PATH itself or any of its parents.
+ * If INCLUDE_DESCENDANTS is set, also include revisions that changed
+ * paths below PATH.  These are all revisions in which the node at PATH
+ * may have been modified, added, replaced, copied or deleted.  Revisions
+ * after HEAD are ignored.
+ *
+ * CANCEL_FUNC and CANCEL_BATON are what you think they are.  Allocate
+ * the result in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ */
+svn_error_t *
+svn_fs_fs__path_index_find(apr_array_header_t **revisions,
+                           svn_fs_t *fs,
+                           const char *path,
+                           svn_revnum_t start,
+                           svn_revnum_t end,
+                           svn_boolean_t include_descendants,
+                           svn_cancel_func_t cancel_func,
+                           void *cancel_baton,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
+#endif
@@ -21,6 +21,7 @@
  */
 
 #include "svn_pools.h"
+#include "svn_hash.h"
 
 #include "svn_private_config.h"
 
@@ -48,6 +49,194 @@ path_rep_cache_db(const char *fs_path,
   return svn_dirent_join(fs_path, REP_CACHE_DB_NAME, result_pool);
 }
 
+
+/** In-memory front-end.
+ *
+ * Every rep-cache lookup used to be an SQLite query.  Large commits and
+ * loads do so many of them that the statement overhead becomes visible.
+ * Once an FS instance has been doing a fair number of lookups, we build
+ * a Bloom filter over all hashes in the DB, which lets us answer most
+ * misses without asking SQLite.  Recent hits are kept in a small hash.
+ *
+ * The filter covers all revisions up to FILTER_REV.  As soon as we learn
+ * that HEAD has moved beyond that due to commits that were not made
+ * through this FS instance, we drop the filter and build it again later.
+ * Rows written by other processes after that check may be missed - just
+ * as they would be missed by a lookup that happened slightly earlier.
+ * Missing a row only means that a representation will not be shared.
+ **/
+
+/* Number of DB lookups after which building the filter pays off. */
+#define FILTER_THRESHOLD 128
+
+/* Filter size in bits per DB row and its lower and upper limits.
+ * 10 bits and 4 probes per hash give about 1% false positives. */
+#define FILTER_BITS_PER_ROW 10
+#define FILTER_MIN_BITS 0x10000
+#define FILTER_MAX_BITS 0x10000000
+#define FILTER_PROBES 4
+
+/* Start over when we have cached that many hits. */
+#define MAX_HITS 1024
+
+struct rep_cache_front_t
+{
+  /* Bloom filter over all hashes in the DB.  BITS is a power of 2.
+     FILTER is NULL and BITS is 0 while there is no filter. */
+  unsigned char *filter;
+  apr_size_t bits;
+
+  /* FILTER contains the hashes of all rows up to this revision. */
+  svn_revnum_t filter_rev;
+
+  /* Number of lookups that had to go to the DB. */
+  int db_lookups;
+
+  /* Pool holding FILTER. */
+  apr_pool_t *filter_pool;
+
+  /* Recent hits, mapping the hex SHA1 to a representation_t *.
+     Everything is allocated in HITS_POOL. */
+  apr_hash_t *hits;
+  apr_pool_t *hits_pool;
+};
+
+/* Return the front-end for the rep-cache of FS, creating it on demand. */
+static struct rep_cache_front_t *
+get_front(svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  if (!ffd->rep_cache_front)
+    {
+      struct rep_cache_front_t *front = apr_pcalloc(fs->pool,
+                                                    sizeof(*front));
+      front->filter_rev = SVN_INVALID_REVNUM;
+      front->filter_pool = svn_pool_create(fs->pool);
+      front->hits_pool = svn_pool_create(fs->pool);
+      front->hits = apr_hash_make(front->hits_pool);
+
+      ffd->rep_cache_front = front;
+    }
+
+  return ffd->rep_cache_front;
+}
+
+/* Drop the filter in FRONT, keeping the lookup statistics. */
+static void
+drop_filter(struct rep_cache_front_t *front)
+{
+  svn_pool_clear(front->filter_pool);
+  front->filter = NULL;
+  front->bits = 0;
+  front->filter_rev = SVN_INVALID_REVNUM;
+}
+
+/* Forget all hits in FRONT. */
+static void
+drop_hits(struct rep_cache_front_t *front)
+{
+  svn_pool_clear(front->hits_pool);
+  front->hits = apr_hash_make(front->hits_pool);
+}
+
+/* Return the value of the 8 hex digits at HEX.  Stop at the end of the
+ * string and treat non-hex characters as 0. */
+static apr_uint32_t
+hex_to_uint32(const char *hex)
+{
+  apr_uint32_t result = 0;
+  int i;
+
+  for (i = 0; i < 8 && hex[i]; ++i)
+    {
+      char c = hex[i];
+      apr_uint32_t digit = 0;
+
+      if (c >= '0' && c <= '9')
+        digit = c - '0';
+      else if (c >= 'a' && c <= 'f')
+        digit = c - 'a' + 10;
+
+      result = result * 16 + digit;
+    }
+
+  return result;
+}
+
+/* If ADD is set, add the hex SHA1 digest HEX to the filter in FRONT and
+ * return TRUE.  Otherwise, return whether HEX may be in the filter.
+ * SHA1 is uniformly distributed, so we simply use parts of the digest
+ * as probe positions. */
+static svn_boolean_t
+filter_op(struct rep_cache_front_t *front,
+          const char *hex,
+          svn_boolean_t add)
+{
+  int i;
+  apr_size_t len = strlen(hex);
+
+  for (i = 0; i < FILTER_PROBES; ++i)
+    {
+      apr_size_t pos = (8 * i < len) ? hex_to_uint32(hex + 8 * i) : 0;
+      unsigned char mask;
+
+      pos &= front->bits - 1;
+      mask = (unsigned char)(1 << (pos % 8));
+      if (add)
+        front->filter[pos / 8] |= mask;
+      else if ((front->filter[pos / 8] & mask) == 0)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Build the filter in FRONT from all rows in the rep-cache of FS.
+ * Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+build_filter(struct rep_cache_front_t *front,
+             svn_fs_t *fs,
+             apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  apr_int64_t count;
+  apr_size_t bits = FILTER_MIN_BITS;
+
+  /* Rows for revisions up to this one will be in the DB already. */
+  svn_revnum_t youngest = ffd->youngest_rev_cache;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_GET_REP_COUNT));
+  SVN_ERR(svn_sqlite__step_row(stmt));
+  count = svn_sqlite__column_int64(stmt, 0);
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  while (bits < FILTER_MAX_BITS
+         && (apr_int64_t)bits < count * FILTER_BITS_PER_ROW)
+    bits *= 2;
+
+  drop_filter(front);
+  front->filter = apr_pcalloc(front->filter_pool, bits / 8);
+  front->bits = bits;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_GET_ALL_HASHES));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      filter_op(front, svn_sqlite__column_text(stmt, 0, NULL), TRUE);
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  front->filter_rev = youngest;
+
+  return SVN_NO_ERROR;
+}
+
 
 /** Library-private API's. **/
 
@@ -96,6 +285,10 @@ open_rep_cache(void *baton,
                            svn_sqlite__mode_rwcreate, statements,
                            0, NULL, 0,
                            fs->pool, pool));
+  SVN_SQLITE__ERR_CLOSE(svn_sqlite__set_memory_limits(
+                          sdb, ffd->rep_cache_memory_size,
+                          ffd->rep_cache_mmap_size, pool),
+                        sdb);
 
   SVN_SQLITE__ERR_CLOSE(svn_sqlite__read_schema_version(&version, sdb, pool),
                         sdb);
@@ -160,6 +353,26 @@ svn_fs_fs__exists_rep_cache(svn_boolean_t *exists,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__get_rep_cache_max_rev(svn_revnum_t *max_rev,
+                                 svn_fs_t *fs,
+                                 apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  if (! ffd->rep_cache_db)
+    SVN_ERR(svn_fs_fs__open_rep_cache(fs, pool));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                    STMT_GET_MAX_REV));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  *max_rev = svn_sqlite__column_revnum(stmt, 0);
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
 svn_error_t *
 svn_fs_fs__walk_rep_reference(svn_fs_t *fs,
                               svn_revnum_t start,
@@ -270,6 +483,8 @@ svn_fs_fs__get_rep_reference(representation_t **rep_p,
   svn_sqlite__stmt_t *stmt;
   svn_boolean_t have_row;
   representation_t *rep;
+  const char *hex;
+  struct rep_cache_front_t *front;
 
   SVN_ERR_ASSERT(ffd->rep_sharing_allowed);
   if (! ffd->rep_cache_db)
@@ -281,33 +496,67 @@ svn_fs_fs__get_rep_reference(representation_t **rep_p,
                             _("Only SHA1 checksums can be used as keys in the "
                               "rep_cache table.\n"));
 
-  SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db, STMT_GET_REP));
-  SVN_ERR(svn_sqlite__bindf(stmt, "s",
-                            svn_checksum_to_cstring(checksum, pool)));
+  hex = svn_checksum_to_cstring(checksum, pool);
+  front = get_front(fs);
 
-  SVN_ERR(svn_sqlite__step(&have_row, stmt));
-  if (have_row)
+  /* Somebody else committed since we built the filter? */
+  if (front->filter && front->filter_rev < ffd->youngest_rev_cache)
+    drop_filter(front);
+
+  rep = svn_hash_gets(front->hits, hex);
+  if (rep)
     {
-      rep = apr_pcalloc(pool, sizeof(*rep));
-      svn_fs_fs__id_txn_reset(&(rep->txn_id));
-      memcpy(rep->sha1_digest, checksum->digest, sizeof(rep->sha1_digest));
-      rep->has_sha1 = TRUE;
-      rep->revision = svn_sqlite__column_revnum(stmt, 0);
-      rep->item_index = svn_sqlite__column_int64(stmt, 1);
-      rep->size = svn_sqlite__column_int64(stmt, 2);
-      rep->expanded_size = svn_sqlite__column_int64(stmt, 3);
+      rep = apr_pmemdup(pool, rep, sizeof(*rep));
+    }
+  else if (front->filter && !filter_op(front, hex, FALSE))
+    {
+      /* Definitely not in the DB. */
+      *rep_p = NULL;
+      return SVN_NO_ERROR;
     }
   else
-    rep = NULL;
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db,
+                                        STMT_GET_REP));
+      SVN_ERR(svn_sqlite__bindf(stmt, "s", hex));
 
-  SVN_ERR(svn_sqlite__reset(stmt));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      if (have_row)
+        {
+          rep = apr_pcalloc(pool, sizeof(*rep));
+          svn_fs_fs__id_txn_reset(&(rep->txn_id));
+          memcpy(rep->sha1_digest, checksum->digest,
+                 sizeof(rep->sha1_digest));
+          rep->has_sha1 = TRUE;
+          rep->revision = svn_sqlite__column_revnum(stmt, 0);
+          rep->item_index = svn_sqlite__column_int64(stmt, 1);
+          rep->size = svn_sqlite__column_int64(stmt, 2);
+          rep->expanded_size = svn_sqlite__column_int64(stmt, 3);
+        }
+      else
+        rep = NULL;
+
+      SVN_ERR(svn_sqlite__reset(stmt));
+
+      if (rep)
+        {
+          SVN_ERR(svn_fs_fs__fixup_expanded_size(fs, rep, pool));
+
+          if (apr_hash_count(front->hits) >= MAX_HITS)
+            drop_hits(front);
+          svn_hash_sets(front->hits, apr_pstrdup(front->hits_pool, hex),
+                        apr_pmemdup(front->hits_pool, rep, sizeof(*rep)));
+        }
+
+      /* Lots of lookups going on?  Then avoid the DB for misses. */
+      if (!front->filter && ++front->db_lookups >= FILTER_THRESHOLD)
+        SVN_ERR(build_filter(front, fs, pool));
+    }
 
   if (rep)
     {
       svn_error_t *err;
 
-      SVN_ERR(svn_fs_fs__fixup_expanded_size(fs, rep, pool));
-
       /* Check that REP refers to a revision that exists in FS. */
       err = svn_fs_fs__ensure_revision_exists(rep->revision, fs, pool);
       if (err)
@@ -329,6 +578,7 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
   fs_fs_data_t *ffd = fs->fsap_data;
   svn_sqlite__stmt_t *stmt;
   svn_checksum_t checksum;
+  const char *hex;
   checksum.kind = svn_checksum_sha1;
   checksum.digest = rep->sha1_digest;
 
@@ -342,9 +592,10 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
                             _("Only SHA1 checksums can be used as keys in the "
                               "rep_cache table.\n"));
 
+  hex = svn_checksum_to_cstring(&checksum, pool);
   SVN_ERR(svn_sqlite__get_statement(&stmt, ffd->rep_cache_db, STMT_SET_REP));
   SVN_ERR(svn_sqlite__bindf(stmt, "siiii",
-                            svn_checksum_to_cstring(&checksum, pool),
+                            hex,
                             (apr_int64_t) rep->revision,
                             (apr_int64_t) rep->item_index,
                             (apr_int64_t) rep->size,
@@ -352,9 +603,25 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
 
   SVN_ERR(svn_sqlite__insert(NULL, stmt));
 
+  /* Keep the filter complete. */
+  if (ffd->rep_cache_front && ffd->rep_cache_front->filter)
+    filter_op(ffd->rep_cache_front, hex, TRUE);
+
   return SVN_NO_ERROR;
 }
 
+void
+svn_fs_fs__rep_cache_revision_added(svn_fs_t *fs,
+                                    svn_revnum_t revision)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  struct rep_cache_front_t *front = ffd->rep_cache_front;
+
+  /* If the filter was complete before, it still is. */
+  if (front && front->filter && front->filter_rev == revision - 1)
+    front->filter_rev = revision;
+}
+
 
 svn_error_t *
 svn_fs_fs__del_rep_reference(svn_fs_t *fs,
@@ -373,6 +640,10 @@ svn_fs_fs__del_rep_reference(svn_fs_t *fs,
   SVN_ERR(svn_sqlite__bindf(stmt, "r", youngest));
   SVN_ERR(svn_sqlite__step_done(stmt));
 
+  /* Stale hits must not survive. */
+  if (ffd->rep_cache_front)
+    drop_hits(ffd->rep_cache_front);
+
   return SVN_NO_ERROR;
 }
 
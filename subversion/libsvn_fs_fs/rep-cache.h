@@ -49,6 +49,14 @@ svn_error_t *
 svn_fs_fs__exists_rep_cache(svn_boolean_t *exists,
                             svn_fs_t *fs, apr_pool_t *pool);
 
+/* Set *MAX_REV to the youngest revision referenced by FS's rep-cache,
+   or to SVN_INVALID_REVNUM if it is empty.  Use POOL for temporary
+   allocations. */
+svn_error_t *
+svn_fs_fs__get_rep_cache_max_rev(svn_revnum_t *max_rev,
+                                 svn_fs_t *fs,
+                                 apr_pool_t *pool);
+
 /* Iterate all representations currently in FS's cache. */
 svn_error_t *
 svn_fs_fs__walk_rep_reference(svn_fs_t *fs,
@@ -83,6 +91,13 @@ svn_fs_fs__set_rep_reference(svn_fs_t *fs,
                              representation_t *rep,
                              apr_pool_t *pool);
 
+/* Tell the in-memory front-end of FS's rep-cache that this FS instance
+   has just written all references of REVISION to the database, i.e. no
+   other process can have stored any for that revision. */
+void
+svn_fs_fs__rep_cache_revision_added(svn_fs_t *fs,
+                                    svn_revnum_t revision);
+
 /* Delete from the cache all reps corresponding to revisions younger
    than YOUNGEST. */
 svn_error_t *
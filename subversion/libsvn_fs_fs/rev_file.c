@@ -28,9 +28,24 @@
 
 #include "../libsvn_fs/fs-loader.h"
 
+#include "svn_pools.h"
+
 #include "private/svn_io_private.h"
+#include "private/svn_probes.h"
+#include "private/svn_sorts_private.h"
 #include "svn_private_config.h"
 
+#ifdef HAVE_POSIX_FADVISE
+#include <fcntl.h>
+#endif
+
+/* Maximum number of idle revision / pack files kept open per svn_fs_t. */
+#define REV_FILE_CACHE_SIZE 16
+
+/* Files that have been open for longer than this will not be reused.
+ * That way, pack files replaced by other processes get picked up. */
+#define REV_FILE_CACHE_MAX_AGE (10 * APR_USEC_PER_SEC)
+
 /* Initialize the *FILE structure for REVISION in filesystem FS.  Set its
  * pool member to the provided POOL. */
 static void
@@ -42,10 +57,14 @@ init_revision_file(svn_fs_fs__revision_file_t *file,
   fs_fs_data_t *ffd = fs->fsap_data;
 
   file->is_packed = svn_fs_fs__is_packed_rev(fs, revision);
+  file->generation = 0;
   file->start_revision = svn_fs_fs__packed_base_rev(fs, revision);
 
   file->file = NULL;
   file->stream = NULL;
+  file->mapped_data = NULL;
+  file->mapped_size = 0;
+  file->mmap = NULL;
   file->p2l_stream = NULL;
   file->l2p_stream = NULL;
   file->block_size = ffd->block_size;
@@ -54,7 +73,32 @@ init_revision_file(svn_fs_fs__revision_file_t *file,
   file->p2l_offset = -1;
   file->p2l_checksum = NULL;
   file->footer_offset = -1;
+  file->read_ahead_end = 0;
   file->pool = pool;
+  file->fs = NULL;
+  file->owner_pool = NULL;
+  file->opened = 0;
+  file->cache_epoch = 0;
+}
+
+/* Set *GENERATION to a value identifying the version of the pack file
+ * FILE.  A pack file rewritten by svn_fs_fs__repack is a new file and
+ * gets a new inode and modification time.  Use SCRATCH_POOL for
+ * temporaries. */
+static svn_error_t *
+get_generation(apr_uint32_t *generation,
+               apr_file_t *file,
+               apr_pool_t *scratch_pool)
+{
+  apr_finfo_t finfo;
+  apr_uint64_t value;
+
+  SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_INODE | APR_FINFO_MTIME,
+                               file, scratch_pool));
+  value = (apr_uint64_t)finfo.inode ^ ((apr_uint64_t)finfo.mtime << 16);
+  *generation = (apr_uint32_t)(value ^ (value >> 32));
+
+  return SVN_NO_ERROR;
 }
 
 /* Baton type for set_read_only() */
@@ -120,6 +164,40 @@ auto_make_writable(const char *path,
   return SVN_NO_ERROR;
 }
 
+/* Map the whole of the already open FILE->FILE into memory.  Failure to
+ * do so is not an error, we simply keep using the APR file functions.
+ * Use SCRATCH_POOL for temporary allocations. */
+static void
+auto_map_file(svn_fs_fs__revision_file_t *file,
+              apr_pool_t *scratch_pool)
+{
+#if APR_HAS_MMAP
+  svn_filesize_t size;
+  apr_mmap_t *mmap;
+  svn_error_t *err;
+
+  err = svn_io_file_size_get(&size, file->file, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return;
+    }
+
+  /* Empty files can't be mapped and on 32 bit systems, large pack files
+   * may not fit into our address space. */
+  if (size == 0 || size > APR_SIZE_MAX)
+    return;
+
+  if (apr_mmap_create(&mmap, file->file, 0, (apr_size_t)size, APR_MMAP_READ,
+                      file->pool) == APR_SUCCESS)
+    {
+      file->mmap = mmap;
+      file->mapped_data = mmap->mm;
+      file->mapped_size = (apr_size_t)size;
+    }
+#endif
+}
+
 /* Core implementation of svn_fs_fs__open_pack_or_rev_file working on an
  * existing, initialized FILE structure.  If WRITABLE is TRUE, give write
  * access to the file - temporarily resetting the r/o state if necessary.
@@ -136,6 +214,7 @@ open_pack_or_rev_file(svn_fs_fs__revision_file_t *file,
   svn_error_t *err;
   svn_boolean_t retry = FALSE;
 
+  SVN_PROBE1(fsfs__rev__file__open__start, rev);
   do
     {
       const char *path = svn_fs_fs__path_rev_absolute(fs, rev, scratch_pool);
@@ -153,6 +232,10 @@ open_pack_or_rev_file(svn_fs_fs__revision_file_t *file,
         err = svn_io_file_open(&apr_file, path, flags, APR_OS_DEFAULT,
                                result_pool);
 
+      /* Pack files may get replaced while we keep them open. */
+      if (!err && svn_fs_fs__is_packed_rev(fs, rev))
+        err = get_generation(&file->generation, apr_file, scratch_pool);
+
       if (!err)
         {
           file->file = apr_file;
@@ -160,6 +243,12 @@ open_pack_or_rev_file(svn_fs_fs__revision_file_t *file,
                                                   result_pool);
           file->is_packed = svn_fs_fs__is_packed_rev(fs, rev);
 
+          /* Pack files are never modified, so it is safe to map them. */
+          if (!writable && file->is_packed && ffd->mmap_pack_files)
+            auto_map_file(file, scratch_pool);
+
+          ffd->io_stats.files_opened++;
+          SVN_PROBE2(fsfs__rev__file__open__done, rev, file->is_packed);
           return SVN_NO_ERROR;
         }
 
@@ -199,6 +288,124 @@ open_pack_or_rev_file(svn_fs_fs__revision_file_t *file,
   return svn_error_trace(err);
 }
 
+/* Return TRUE if the cacheable FILE must not be reused anymore. */
+static svn_boolean_t
+is_stale(svn_fs_fs__revision_file_t *file,
+         apr_time_t now)
+{
+  fs_fs_data_t *ffd = file->fs->fsap_data;
+
+  return ffd == NULL
+      || file->cache_epoch != ffd->rev_file_cache_epoch
+      || now - file->opened > REV_FILE_CACHE_MAX_AGE;
+}
+
+/* Add the idle FILE to the cache of its file system or close it, if it
+ * may not be reused. */
+static void
+cache_rev_file(svn_fs_fs__revision_file_t *file)
+{
+  fs_fs_data_t *ffd = file->fs->fsap_data;
+
+  if (is_stale(file, apr_time_now()))
+    {
+      svn_pool_destroy(file->pool);
+      return;
+    }
+
+  if (ffd->idle_rev_files == NULL)
+    ffd->idle_rev_files = apr_array_make(file->fs->pool, REV_FILE_CACHE_SIZE,
+                                         sizeof(file));
+
+  /* Evict the least recently used file. */
+  if (ffd->idle_rev_files->nelts >= REV_FILE_CACHE_SIZE)
+    {
+      svn_pool_destroy(APR_ARRAY_IDX(ffd->idle_rev_files, 0,
+                                     svn_fs_fs__revision_file_t *)->pool);
+      svn_error_clear(svn_sort__array_delete2(ffd->idle_rev_files, 0, 1));
+    }
+
+  APR_ARRAY_PUSH(ffd->idle_rev_files, svn_fs_fs__revision_file_t *) = file;
+}
+
+/* APR pool cleanup handler returning the svn_fs_fs__revision_file_t
+ * BATON to its file system's cache when the pool it has been handed out
+ * to gets cleaned up. */
+static apr_status_t
+release_rev_file(void *baton)
+{
+  svn_fs_fs__revision_file_t *file = baton;
+
+  file->owner_pool = NULL;
+  cache_rev_file(file);
+
+  return APR_SUCCESS;
+}
+
+/* APR pool cleanup handler for the pool of the cacheable
+ * svn_fs_fs__revision_file_t BATON.  If the file system gets closed while
+ * the file is still in use, make sure we won't try to release it later. */
+static apr_status_t
+detach_rev_file(void *baton)
+{
+  svn_fs_fs__revision_file_t *file = baton;
+
+  if (file->owner_pool)
+    apr_pool_cleanup_kill(file->owner_pool, file, release_rev_file);
+  file->owner_pool = NULL;
+
+  return APR_SUCCESS;
+}
+
+/* Hand out FILE to RESULT_POOL. */
+static void
+hand_out_rev_file(svn_fs_fs__revision_file_t *file,
+                  apr_pool_t *result_pool)
+{
+  file->owner_pool = result_pool;
+  apr_pool_cleanup_register(result_pool, file, release_rev_file,
+                            apr_pool_cleanup_null);
+}
+
+/* Remove the idle revision / pack file for REV from the cache of FS and
+ * return it in *FILE.  Set *FILE to NULL if there is no such file. */
+static void
+take_cached_rev_file(svn_fs_fs__revision_file_t **file,
+                     svn_fs_t *fs,
+                     svn_revnum_t rev)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_boolean_t is_packed = svn_fs_fs__is_packed_rev(fs, rev);
+  svn_revnum_t start_revision = svn_fs_fs__packed_base_rev(fs, rev);
+  apr_time_t now;
+  int i;
+
+  *file = NULL;
+  if (ffd->idle_rev_files == NULL || ffd->idle_rev_files->nelts == 0)
+    return;
+
+  now = apr_time_now();
+  for (i = ffd->idle_rev_files->nelts - 1; i >= 0; --i)
+    {
+      svn_fs_fs__revision_file_t *candidate
+        = APR_ARRAY_IDX(ffd->idle_rev_files, i, svn_fs_fs__revision_file_t *);
+
+      if (   candidate->start_revision != start_revision
+          || candidate->is_packed != is_packed)
+        continue;
+
+      svn_error_clear(svn_sort__array_delete2(ffd->idle_rev_files, i, 1));
+      if (is_stale(candidate, now))
+        {
+          svn_pool_destroy(candidate->pool);
+          return;
+        }
+
+      *file = candidate;
+      return;
+    }
+}
+
 svn_error_t *
 svn_fs_fs__open_pack_or_rev_file(svn_fs_fs__revision_file_t **file,
                                  svn_fs_t *fs,
@@ -206,11 +413,48 @@ svn_fs_fs__open_pack_or_rev_file(svn_fs_fs__revision_file_t **file,
                                  apr_pool_t *result_pool,
                                  apr_pool_t *scratch_pool)
 {
-  *file = apr_palloc(result_pool, sizeof(**file));
-  init_revision_file(*file, fs, rev, result_pool);
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_pool_t *file_pool;
+  svn_error_t *err;
 
-  return svn_error_trace(open_pack_or_rev_file(*file, fs, rev, FALSE,
-                                               result_pool, scratch_pool));
+  take_cached_rev_file(file, fs, rev);
+  if (*file)
+    {
+      /* Callers expect a freshly opened file. */
+      apr_off_t offset = 0;
+      err = svn_io_file_seek((*file)->file, APR_SET, &offset, scratch_pool);
+      if (err)
+        {
+          svn_pool_destroy((*file)->pool);
+          return svn_error_trace(err);
+        }
+
+      hand_out_rev_file(*file, result_pool);
+      return SVN_NO_ERROR;
+    }
+
+  /* The file and everything allocated from its pool may outlive
+   * RESULT_POOL. */
+  file_pool = svn_pool_create(fs->pool);
+  *file = apr_palloc(file_pool, sizeof(**file));
+  init_revision_file(*file, fs, rev, file_pool);
+
+  err = open_pack_or_rev_file(*file, fs, rev, FALSE, file_pool,
+                              scratch_pool);
+  if (err)
+    {
+      svn_pool_destroy(file_pool);
+      return svn_error_trace(err);
+    }
+
+  (*file)->fs = fs;
+  (*file)->opened = apr_time_now();
+  (*file)->cache_epoch = ffd->rev_file_cache_epoch;
+  apr_pool_cleanup_register(file_pool, *file, detach_rev_file,
+                            apr_pool_cleanup_null);
+  hand_out_rev_file(*file, result_pool);
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -220,6 +464,10 @@ svn_fs_fs__open_pack_or_rev_file_writable(svn_fs_fs__revision_file_t** file,
                                           apr_pool_t* result_pool,
                                           apr_pool_t *scratch_pool)
 {
+  /* Writers may change the file, so don't read it through any stale
+   * cached handles afterwards. */
+  svn_fs_fs__rev_file_cache_clear(fs);
+
   *file = apr_palloc(result_pool, sizeof(**file));
   init_revision_file(*file, fs, rev, result_pool);
 
@@ -235,25 +483,46 @@ svn_fs_fs__auto_read_footer(svn_fs_fs__revision_file_t *file)
       apr_off_t filesize = 0;
       unsigned char footer_length;
       svn_stringbuf_t *footer;
+      const char *mapped_footer = NULL;
+
+      if (file->mapped_data)
+        {
+          /* Take the footer directly from the mapped file contents. */
+          filesize = file->mapped_size;
+          footer_length = (unsigned char)file->mapped_data[filesize - 1];
+          mapped_footer
+            = svn_fs_fs__rev_file_mapped(file, filesize - 1 - footer_length,
+                                         footer_length);
+        }
 
-      /* Determine file size. */
-      SVN_ERR(svn_io_file_seek(file->file, APR_END, &filesize, file->pool));
-
-      /* Read last byte (containing the length of the footer). */
-      SVN_ERR(svn_io_file_aligned_seek(file->file, file->block_size, NULL,
-                                       filesize - 1, file->pool));
-      SVN_ERR(svn_io_file_read_full2(file->file, &footer_length,
-                                     sizeof(footer_length), NULL, NULL,
-                                     file->pool));
-
-      /* Read footer. */
-      footer = svn_stringbuf_create_ensure(footer_length, file->pool);
-      SVN_ERR(svn_io_file_aligned_seek(file->file, file->block_size, NULL,
-                                       filesize - 1 - footer_length,
-                                       file->pool));
-      SVN_ERR(svn_io_file_read_full2(file->file, footer->data, footer_length,
-                                     &footer->len, NULL, file->pool));
-      footer->data[footer->len] = '\0';
+      if (mapped_footer)
+        {
+          footer = svn_stringbuf_ncreate(mapped_footer, footer_length,
+                                         file->pool);
+        }
+      else
+        {
+          /* Determine file size. */
+          SVN_ERR(svn_io_file_seek(file->file, APR_END, &filesize,
+                                   file->pool));
+
+          /* Read last byte (containing the length of the footer). */
+          SVN_ERR(svn_io_file_aligned_seek(file->file, file->block_size, NULL,
+                                           filesize - 1, file->pool));
+          SVN_ERR(svn_io_file_read_full2(file->file, &footer_length,
+                                         sizeof(footer_length), NULL, NULL,
+                                         file->pool));
+
+          /* Read footer. */
+          footer = svn_stringbuf_create_ensure(footer_length, file->pool);
+          SVN_ERR(svn_io_file_aligned_seek(file->file, file->block_size, NULL,
+                                           filesize - 1 - footer_length,
+                                           file->pool));
+          SVN_ERR(svn_io_file_read_full2(file->file, footer->data,
+                                         footer_length, &footer->len, NULL,
+                                         file->pool));
+          footer->data[footer->len] = '\0';
+        }
 
       /* Extract index locations. */
       SVN_ERR(svn_fs_fs__parse_footer(&file->l2p_offset, &file->l2p_checksum,
@@ -267,6 +536,38 @@ svn_fs_fs__auto_read_footer(svn_fs_fs__revision_file_t *file)
   return SVN_NO_ERROR;
 }
 
+const char *
+svn_fs_fs__rev_file_mapped(svn_fs_fs__revision_file_t *file,
+                           apr_off_t offset,
+                           apr_off_t len)
+{
+  if (   file->mapped_data == NULL
+      || offset < 0
+      || len < 0
+      || offset > file->mapped_size
+      || len > file->mapped_size - offset)
+    return NULL;
+
+  return file->mapped_data + offset;
+}
+
+void
+svn_fs_fs__rev_file_read_ahead(svn_fs_fs__revision_file_t *file,
+                               apr_off_t offset,
+                               apr_off_t len)
+{
+#ifdef HAVE_POSIX_FADVISE
+  apr_os_file_t fd;
+
+  /* This is only a hint.  Failures simply mean that there will be no
+   * read-ahead, so don't report them. */
+  if (file->file && apr_os_file_get(&fd, file->file) == APR_SUCCESS)
+    posix_fadvise(fd, offset, len, POSIX_FADV_WILLNEED);
+#endif
+
+  file->read_ahead_end = offset + len;
+}
+
 svn_error_t *
 svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
                                svn_fs_t *fs,
@@ -293,6 +594,27 @@ svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
 svn_error_t *
 svn_fs_fs__close_revision_file(svn_fs_fs__revision_file_t *file)
 {
+  /* Cacheable files get closed when their pool gets destroyed. */
+  if (file->fs)
+    {
+      if (file->owner_pool)
+        {
+          apr_pool_cleanup_kill(file->owner_pool, file, release_rev_file);
+          release_rev_file(file);
+        }
+
+      return SVN_NO_ERROR;
+    }
+
+#if APR_HAS_MMAP
+  if (file->mmap)
+    {
+      apr_status_t status = apr_mmap_delete(file->mmap);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't unmap revision file"));
+    }
+#endif
+
   if (file->stream)
     SVN_ERR(svn_stream_close(file->stream));
   if (file->file)
@@ -300,8 +622,28 @@ svn_fs_fs__close_revision_file(svn_fs_fs__revision_file_t *file)
 
   file->file = NULL;
   file->stream = NULL;
+  file->mapped_data = NULL;
+  file->mapped_size = 0;
+  file->mmap = NULL;
   file->l2p_stream = NULL;
   file->p2l_stream = NULL;
 
   return SVN_NO_ERROR;
 }
+
+void
+svn_fs_fs__rev_file_cache_clear(svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  int i;
+
+  ++ffd->rev_file_cache_epoch;
+  if (ffd->idle_rev_files == NULL)
+    return;
+
+  for (i = 0; i < ffd->idle_rev_files->nelts; ++i)
+    svn_pool_destroy(APR_ARRAY_IDX(ffd->idle_rev_files, i,
+                                   svn_fs_fs__revision_file_t *)->pool);
+
+  apr_array_clear(ffd->idle_rev_files);
+}
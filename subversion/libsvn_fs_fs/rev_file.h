@@ -23,6 +23,8 @@
 #ifndef SVN_LIBSVN_FS__REV_FILE_H
 #define SVN_LIBSVN_FS__REV_FILE_H
 
+#include <apr_mmap.h>
+
 #include "svn_fs.h"
 #include "id.h"
 
@@ -51,12 +53,28 @@ typedef struct svn_fs_fs__revision_file_t
   /* the revision was packed when the first file / stream got opened */
   svn_boolean_t is_packed;
 
+  /* Derived from the identity of the pack file opened.  Changes when the
+   * pack file gets replaced, e.g. by svn_fs_fs__repack.  0 for non-packed
+   * files. */
+  apr_uint32_t generation;
+
   /* rev / pack file */
   apr_file_t *file;
 
   /* stream based on FILE and not NULL exactly when FILE is not NULL */
   svn_stream_t *stream;
 
+  /* The whole of FILE mapped into memory or NULL.  Only read-only pack
+   * files get mapped and only if enabled in fsfs.conf.  FILE and STREAM
+   * remain fully functional and independent of the mapping. */
+  const char *mapped_data;
+
+  /* Number of bytes in MAPPED_DATA.  0 if FILE has not been mapped. */
+  apr_size_t mapped_size;
+
+  /* The APR object owning MAPPED_DATA.  NULL if FILE has not been mapped. */
+  apr_mmap_t *mmap;
+
   /* the opened P2L index stream or NULL.  Always NULL for txns. */
   svn_fs_fs__packed_number_stream_t *p2l_stream;
 
@@ -85,6 +103,10 @@ typedef struct svn_fs_fs__revision_file_t
    * NULL if svn_fs_fs__auto_read_footer has not been called, yet. */
   svn_checksum_t *p2l_checksum;
 
+  /* End of the range within FILE for which the OS has been asked to read
+   * data ahead.  0 if no read-ahead has been requested, yet. */
+  apr_off_t read_ahead_end;
+
   /* Offset within FILE at which the P2L index ends and the footer starts.
    * Greater than P2L_OFFSET. -1 if svn_fs_fs__auto_read_footer has not
    * been called, yet. */
@@ -92,13 +114,31 @@ typedef struct svn_fs_fs__revision_file_t
 
   /* pool containing this object */
   apr_pool_t *pool;
+
+  /* File system whose idle file cache this object will be returned to
+   * when released.  NULL if the file is not to be reused. */
+  svn_fs_t *fs;
+
+  /* The pool this object has been handed out to and whose cleanup will
+   * release it.  NULL while the file is idle.  Only used if FS is set. */
+  apr_pool_t *owner_pool;
+
+  /* Time at which the file got opened and value of the file system's
+   * REV_FILE_CACHE_EPOCH at that time.  Only used if FS is set. */
+  apr_time_t opened;
+  apr_uint32_t cache_epoch;
 } svn_fs_fs__revision_file_t;
 
 /* Open the correct revision file for REV.  If the filesystem FS has
  * been packed, *FILE will be set to the packed file; otherwise, set *FILE
  * to the revision file for REV.  Return SVN_ERR_FS_NO_SUCH_REVISION if the
- * file doesn't exist.  Allocate *FILE in RESULT_POOL and use SCRATCH_POOL
- * for temporaries. */
+ * file doesn't exist.  *FILE will remain valid until RESULT_POOL gets
+ * cleaned up or svn_fs_fs__close_revision_file gets called on it.  Use
+ * SCRATCH_POOL for temporaries.
+ *
+ * Released files are kept open by FS for a short while, together with
+ * their footer data and index streams, and will be handed out again by
+ * later calls for the same file. */
 svn_error_t *
 svn_fs_fs__open_pack_or_rev_file(svn_fs_fs__revision_file_t **file,
                                  svn_fs_t *fs,
@@ -128,6 +168,26 @@ svn_fs_fs__open_pack_or_rev_file_writable(svn_fs_fs__revision_file_t **file,
 svn_error_t *
 svn_fs_fs__auto_read_footer(svn_fs_fs__revision_file_t *file);
 
+/* If FILE has been mapped into memory and the LEN bytes starting at
+ * OFFSET are all within FILE, return a pointer to the mapped bytes.
+ * Otherwise, return NULL and the caller shall read the data from
+ * FILE->FILE instead.
+ */
+const char *
+svn_fs_fs__rev_file_mapped(svn_fs_fs__revision_file_t *file,
+                           apr_off_t offset,
+                           apr_off_t len);
+
+/* Tell the OS that the LEN bytes starting at OFFSET in FILE will be read
+ * soon, such that it may start loading them into its file cache in the
+ * background.  This is merely a hint and a no-op on platforms that do
+ * not support it.  Remember OFFSET + LEN as FILE->READ_AHEAD_END.
+ */
+void
+svn_fs_fs__rev_file_read_ahead(svn_fs_fs__revision_file_t *file,
+                               apr_off_t offset,
+                               apr_off_t len);
+
 /* Open the proto-rev file of transaction TXN_ID in FS and return it in *FILE.
  * Allocate *FILE in RESULT_POOL use and SCRATCH_POOL for temporaries.. */
 svn_error_t *
@@ -137,9 +197,18 @@ svn_fs_fs__open_proto_rev_file(svn_fs_fs__revision_file_t **file,
                                apr_pool_t* result_pool,
                                apr_pool_t *scratch_pool);
 
-/* Close all files and streams in FILE.
+/* Close all files and streams in FILE.  Files opened by
+ * svn_fs_fs__open_pack_or_rev_file may be kept open for later reuse
+ * instead.  In that case, FILE must not be accessed anymore.
  */
 svn_error_t *
 svn_fs_fs__close_revision_file(svn_fs_fs__revision_file_t *file);
 
+/* Close all revision / pack files that FS keeps open for reuse.  Files
+ * currently in use will be closed upon their release.  Call this before
+ * removing or replacing rev / pack files.
+ */
+void
+svn_fs_fs__rev_file_cache_clear(svn_fs_t *fs);
+
 #endif
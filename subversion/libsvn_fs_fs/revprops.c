@@ -21,6 +21,8 @@
  */
 
 #include <assert.h>
+#include <string.h>
+#include <apr_time.h>
 
 #include "svn_pools.h"
 #include "svn_hash.h"
@@ -207,23 +209,311 @@ parse_revprop(apr_hash_t **properties,
   return SVN_NO_ERROR;
 }
 
+/* Revprop caching is safe only as long as nobody modifies the cached
+ * revprops.  Since other processes may do that at any time, the revprop
+ * cache is only consulted between calls to svn_fs_fs__reset_revprop_cache,
+ * e.g. triggered by svn_fs_refresh_revision_props.
+ *
+ * To not throw away all cached revprops whenever someone changes a single
+ * svn:log, every writer bumps the generation of the respective shard in
+ * the PATH_REVPROP_GENERATIONS file before releasing the write lock:
+ *
+ *   <epoch>\n
+ *   <shard> <generation>\n     for every shard with a non-0 generation
+ *
+ * A cache reset merely requires us to re-read that file.  Only the shards
+ * whose generations have changed get a new cache key prefix.  Writers that
+ * may modify revprops in bulk, e.g. hotcopy, replace the EPOCH instead,
+ * which invalidates all shards.
+ */
+
+/* Revprop cache state of a single shard, as stored in
+ * fs_fs_data_t.REVPROP_SHARDS. */
+typedef struct revprop_shard_t
+{
+  /* Generation of this shard in the revprop generations file. */
+  apr_int64_t generation;
+
+  /* The prefix to be used for revprop cache entries of this shard.
+   * If this is 0, a new unique prefix must be chosen. */
+  apr_uint64_t prefix;
+} revprop_shard_t;
+
+/* Return the number of the shard containing revision REV in FS, for the
+ * purpose of revprop generations.  Non-sharded repositories have only a
+ * single shard. */
+static apr_int64_t
+revprop_shard(svn_fs_t *fs,
+              svn_revnum_t rev)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  return ffd->max_files_per_dir ? rev / ffd->max_files_per_dir : 0;
+}
+
+/* Read the revprop generations file of FS and return its epoch in
+ * *EPOCH and the shard generations (apr_int64_t, indexed by shard number)
+ * in *GENERATIONS.  A missing file is equivalent to all 0s.
+ *
+ * Allocate *GENERATIONS in RESULT_POOL and use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+read_revprop_generations(apr_int64_t *epoch,
+                         apr_array_header_t **generations,
+                         svn_fs_t *fs,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  const char *path = svn_fs_fs__path_revprop_generations(fs, scratch_pool);
+  svn_stringbuf_t *content;
+  apr_array_header_t *lines;
+  svn_error_t *err;
+  int i;
+
+  *epoch = 0;
+  *generations = apr_array_make(result_pool, 16, sizeof(apr_int64_t));
+
+  err = svn_stringbuf_from_file2(&content, path, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  lines = svn_cstring_split(content->data, "\n", TRUE, scratch_pool);
+  if (lines->nelts == 0)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                             _("Revprop generations file '%s' is empty"),
+                             svn_dirent_local_style(path, scratch_pool));
+
+  err = svn_cstring_atoi64(epoch, APR_ARRAY_IDX(lines, 0, const char *));
+  for (i = 1; !err && i < lines->nelts; ++i)
+    {
+      const char *line = APR_ARRAY_IDX(lines, i, const char *);
+      const char *space = strchr(line, ' ');
+      apr_int64_t shard, generation;
+
+      if (!space)
+        {
+          err = svn_error_create(SVN_ERR_BAD_NUMBER, NULL, NULL);
+          break;
+        }
+
+      err = svn_cstring_strtoi64(&shard,
+                                 apr_pstrmemdup(scratch_pool, line,
+                                                space - line),
+                                 0, APR_INT32_MAX, 10);
+      if (!err)
+        err = svn_cstring_atoi64(&generation, space + 1);
+      if (!err)
+        {
+          while ((*generations)->nelts <= shard)
+            APR_ARRAY_PUSH(*generations, apr_int64_t) = 0;
+          APR_ARRAY_IDX(*generations, shard, apr_int64_t) = generation;
+        }
+    }
+
+  if (err)
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, err,
+                             _("Revprop generations file '%s' is corrupt"),
+                             svn_dirent_local_style(path, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Replace the revprop generations file of FS with EPOCH and GENERATIONS
+ * (apr_int64_t, indexed by shard number).  The caller must hold the FS
+ * write lock.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+write_revprop_generations(svn_fs_t *fs,
+                          apr_int64_t epoch,
+                          apr_array_header_t *generations,
+                          apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_stringbuf_t *content
+    = svn_stringbuf_createf(scratch_pool, "%" APR_INT64_T_FMT "\n", epoch);
+  int i;
+
+  for (i = 0; i < generations->nelts; ++i)
+    {
+      apr_int64_t generation = APR_ARRAY_IDX(generations, i, apr_int64_t);
+      if (generation)
+        svn_stringbuf_appendcstr(content,
+                                 apr_psprintf(scratch_pool,
+                                              "%d %" APR_INT64_T_FMT "\n",
+                                              i, generation));
+    }
+
+  SVN_ERR(svn_io_write_atomic2(svn_fs_fs__path_revprop_generations(
+                                 fs, scratch_pool),
+                               content->data, content->len,
+                               svn_fs_fs__path_current(fs, scratch_pool),
+                               ffd->flush_to_disk, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Bump the revprop generation of the shard that contains REV in FS.
+ * The caller must hold the FS write lock.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+bump_revprop_generation(svn_fs_t *fs,
+                        svn_revnum_t rev,
+                        apr_pool_t *scratch_pool)
+{
+  apr_int64_t epoch;
+  apr_array_header_t *generations;
+  apr_int64_t shard = revprop_shard(fs, rev);
+
+  SVN_ERR(read_revprop_generations(&epoch, &generations, fs, scratch_pool,
+                                   scratch_pool));
+  while (generations->nelts <= shard)
+    APR_ARRAY_PUSH(generations, apr_int64_t) = 0;
+  ++APR_ARRAY_IDX(generations, shard, apr_int64_t);
+
+  return svn_error_trace(write_revprop_generations(fs, epoch, generations,
+                                                   scratch_pool));
+}
+
+svn_error_t *
+svn_fs_fs__invalidate_revprop_generations(svn_fs_t *fs,
+                                          apr_pool_t *scratch_pool)
+{
+  apr_int64_t epoch;
+  apr_array_header_t *generations;
+
+  /* Make sure the new epoch differs from the current one.  Any corrupted
+   * contents will simply be replaced. */
+  svn_error_t *err = read_revprop_generations(&epoch, &generations, fs,
+                                              scratch_pool, scratch_pool);
+  if (err && err->apr_err == SVN_ERR_FS_CORRUPT)
+    {
+      svn_error_clear(err);
+      epoch = 0;
+    }
+  else
+    {
+      SVN_ERR(err);
+    }
+
+  epoch = MAX(epoch + 1, apr_time_now());
+  generations = apr_array_make(scratch_pool, 0, sizeof(apr_int64_t));
+
+  SVN_ERR(write_revprop_generations(fs, epoch, generations, scratch_pool));
+  svn_fs_fs__reset_revprop_cache(fs);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__get_revprop_generation(apr_int64_t *epoch_p,
+                                  apr_int64_t *generation_p,
+                                  svn_fs_t *fs,
+                                  apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *generations;
+  int i;
+
+  SVN_ERR(read_revprop_generations(epoch_p, &generations, fs, scratch_pool,
+                                   scratch_pool));
+
+  /* Shard generations only ever grow between epoch changes. */
+  *generation_p = 0;
+  for (i = 0; i < generations->nelts; ++i)
+    *generation_p += APR_ARRAY_IDX(generations, i, apr_int64_t);
+
+  return SVN_NO_ERROR;
+}
+
 void
 svn_fs_fs__reset_revprop_cache(svn_fs_t *fs)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  ffd->revprop_prefix = 0;
+  ffd->revprop_shards_valid = FALSE;
 }
 
-/* If FS has not a revprop cache prefix set, generate one.
- * Always call this before accessing the revprop cache.
+/* Synchronize FS's per-shard revprop cache state with the revprop
+ * generations file, if necessary.  Shards whose generation has changed
+ * will get new revprop cache prefixes.  Use SCRATCH_POOL for temporary
+ * allocations.
  */
 static svn_error_t *
-prepare_revprop_cache(svn_fs_t *fs,
+update_revprop_shards(svn_fs_t *fs,
                       apr_pool_t *scratch_pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
-  if (!ffd->revprop_prefix)
-    SVN_ERR(svn_atomic__unique_counter(&ffd->revprop_prefix));
+  apr_int64_t epoch;
+  apr_array_header_t *generations;
+  int i;
+
+  if (ffd->revprop_shards_valid)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(read_revprop_generations(&epoch, &generations, fs, scratch_pool,
+                                   scratch_pool));
+
+  if (!ffd->revprop_shards)
+    ffd->revprop_shards = apr_array_make(fs->pool, generations->nelts,
+                                         sizeof(revprop_shard_t));
+  while (ffd->revprop_shards->nelts < generations->nelts)
+    {
+      revprop_shard_t *shard = apr_array_push(ffd->revprop_shards);
+      shard->generation = 0;
+      shard->prefix = 0;
+    }
+
+  for (i = 0; i < ffd->revprop_shards->nelts; ++i)
+    {
+      revprop_shard_t *shard = &APR_ARRAY_IDX(ffd->revprop_shards, i,
+                                              revprop_shard_t);
+      apr_int64_t generation = i < generations->nelts
+                             ? APR_ARRAY_IDX(generations, i, apr_int64_t)
+                             : 0;
+
+      if (epoch != ffd->revprop_epoch || generation != shard->generation)
+        {
+          shard->generation = generation;
+          shard->prefix = 0;
+        }
+    }
+
+  ffd->revprop_epoch = epoch;
+  ffd->revprop_shards_valid = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *PREFIX to the revprop cache key prefix to use for revision REV in
+ * FS.  Auto-allocate one if necessary.  Always call this before accessing
+ * the revprop cache.  Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+get_revprop_prefix(apr_uint64_t *prefix,
+                   svn_fs_t *fs,
+                   svn_revnum_t rev,
+                   apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_int64_t shard_no = revprop_shard(fs, rev);
+  revprop_shard_t *shard;
+
+  SVN_ERR(update_revprop_shards(fs, scratch_pool));
+  while (ffd->revprop_shards->nelts <= shard_no)
+    {
+      shard = apr_array_push(ffd->revprop_shards);
+      shard->generation = 0;
+      shard->prefix = 0;
+    }
+
+  shard = &APR_ARRAY_IDX(ffd->revprop_shards, shard_no, revprop_shard_t);
+  if (!shard->prefix)
+    SVN_ERR(svn_atomic__unique_counter(&shard->prefix));
+
+  *prefix = shard->prefix;
 
   return SVN_NO_ERROR;
 }
@@ -241,11 +531,11 @@ cache_revprops(svn_boolean_t *is_cached,
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   pair_cache_key_t key;
+  apr_uint64_t prefix;
 
-  /* Make sure prepare_revprop_cache() has been called. */
-  SVN_ERR_ASSERT(ffd->revprop_prefix);
+  SVN_ERR(get_revprop_prefix(&prefix, fs, revision, scratch_pool));
   key.revision = revision;
-  key.second = ffd->revprop_prefix;
+  key.second = prefix;
 
   if (is_cached)
     {
@@ -765,11 +1055,12 @@ svn_fs_fs__get_revision_proplist(apr_hash_t **proplist_p,
       /* Try cache lookup first. */
       svn_boolean_t is_cached;
       pair_cache_key_t key;
+      apr_uint64_t prefix;
 
       /* Auto-alloc prefix and construct the key. */
-      SVN_ERR(prepare_revprop_cache(fs, scratch_pool));
+      SVN_ERR(get_revprop_prefix(&prefix, fs, rev, scratch_pool));
       key.revision = rev;
-      key.second = ffd->revprop_prefix;
+      key.second = prefix;
 
       /* The only way that this might error out is due to parser error. */
       SVN_ERR_W(svn_cache__get((void **) proplist_p, &is_cached,
@@ -819,6 +1110,89 @@ svn_fs_fs__get_revision_proplist(apr_hash_t **proplist_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__get_revision_proplists(apr_array_header_t **proplists_p,
+                                  svn_fs_t *fs,
+                                  svn_revnum_t start,
+                                  svn_revnum_t end,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_array_header_t *proplists;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t rev;
+
+  if (start > end)
+    return svn_error_createf(SVN_ERR_FS_NO_SUCH_REVISION, NULL,
+                             _("Invalid revision range r%ld:%ld"),
+                             start, end);
+
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(start, fs, scratch_pool));
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(end, fs, scratch_pool));
+
+  proplists = apr_array_make(result_pool, (int)(end - start + 1),
+                             sizeof(apr_hash_t *));
+  for (rev = start; rev <= end; )
+    {
+      svn_boolean_t is_cached;
+      pair_cache_key_t key;
+      apr_uint64_t prefix;
+      apr_hash_t *proplist;
+      packed_revprops_t *revprops;
+      svn_revnum_t pack_end;
+
+      svn_pool_clear(iterpool);
+
+      /* Try cache lookup first. */
+      SVN_ERR(get_revprop_prefix(&prefix, fs, rev, iterpool));
+      key.revision = rev;
+      key.second = prefix;
+      SVN_ERR_W(svn_cache__get((void **) &proplist, &is_cached,
+                               ffd->revprop_cache, &key, result_pool),
+                apr_psprintf(iterpool, "Failed to parse revprops for r%ld.",
+                             rev));
+      if (is_cached)
+        {
+          APR_ARRAY_PUSH(proplists, apr_hash_t *) = proplist;
+          ++rev;
+          continue;
+        }
+
+      /* Non-packed revprops are stored in individual files anyway. */
+      if (!svn_fs_fs__is_packed_revprop(fs, rev))
+        {
+          SVN_ERR(svn_fs_fs__get_revision_proplist(&proplist, fs, rev, FALSE,
+                                                   result_pool, iterpool));
+          APR_ARRAY_PUSH(proplists, apr_hash_t *) = proplist;
+          ++rev;
+          continue;
+        }
+
+      /* Take everything we need from this pack file. */
+      SVN_ERR(read_pack_revprop(&revprops, fs, rev, TRUE, TRUE, iterpool));
+      pack_end = MIN(end, revprops->start_revision
+                          + revprops->sizes->nelts - 1);
+      for (; rev <= pack_end; ++rev)
+        {
+          int idx = (int)(rev - revprops->start_revision);
+          svn_string_t serialized;
+
+          serialized.data = revprops->packed_revprops->data
+                          + APR_ARRAY_IDX(revprops->offsets, idx, apr_size_t);
+          serialized.len = APR_ARRAY_IDX(revprops->sizes, idx, apr_size_t);
+          SVN_ERR(parse_revprop(&proplist, fs, rev, &serialized,
+                                result_pool, iterpool));
+          APR_ARRAY_PUSH(proplists, apr_hash_t *) = proplist;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  *proplists_p = proplists;
+
+  return SVN_NO_ERROR;
+}
+
 /* Serialize the revision property list PROPLIST of revision REV in
  * filesystem FS to a non-packed file.  Return the name of that temporary
  * file in *TMP_PATH and the file path that it must be moved to in
@@ -1247,9 +1621,6 @@ svn_fs_fs__set_revision_proplist(svn_fs_t *fs,
     SVN_ERR(write_non_packed_revprop(&final_path, &tmp_path,
                                      fs, rev, proplist, pool));
 
-  /* Previous cache contents is invalid now. */
-  svn_fs_fs__reset_revprop_cache(fs);
-
   /* We use the rev file of this revision as the perms reference,
    * because when setting revprops for the first time, the revprop
    * file won't exist and therefore can't serve as its own reference.
@@ -1261,6 +1632,34 @@ svn_fs_fs__set_revision_proplist(svn_fs_t *fs,
   SVN_ERR(switch_to_new_revprop(fs, final_path, tmp_path, perms_reference,
                                 files_to_delete, pool));
 
+  /* Invalidate cached revprops of this shard for everybody, including
+   * ourselves.  This must happen after the new data became visible.
+   * Otherwise, a refreshing reader might still cache the old contents
+   * under the new generation. */
+  SVN_ERR(bump_revprop_generation(fs, rev, pool));
+  svn_fs_fs__reset_revprop_cache(fs);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__write_non_packed_revprop(svn_fs_t *fs,
+                                    svn_revnum_t rev,
+                                    apr_hash_t *proplist,
+                                    apr_pool_t *pool)
+{
+  const char *final_path;
+  const char *tmp_path;
+
+  SVN_ERR(write_non_packed_revprop(&final_path, &tmp_path,
+                                   fs, rev, proplist, pool));
+
+  /* As in svn_fs_fs__set_revision_proplist(), the rev file is the
+   * perms reference. */
+  SVN_ERR(switch_to_new_revprop(fs, final_path, tmp_path,
+                                svn_fs_fs__path_rev(fs, rev, pool),
+                                NULL, pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -58,10 +58,33 @@ svn_fs_fs__upgrade_cleanup_pack_revprops(svn_fs_t *fs,
                                          void *cancel_baton,
                                          apr_pool_t *scratch_pool);
 
-/* Invalidate the revprop cache in FS. */
+/* Invalidate the revprop cache in FS.  Revprops of shards that have not
+ * been modified since will be re-used from the cache.
+ */
 void
 svn_fs_fs__reset_revprop_cache(svn_fs_t *fs);
 
+/* Make all readers of FS drop all their cached revprops at their next
+ * cache reset.  Use this after modifying revprops without going through
+ * svn_fs_fs__set_revision_proplist().  The caller must hold the FS write
+ * lock.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__invalidate_revprop_generations(svn_fs_t *fs,
+                                          apr_pool_t *scratch_pool);
+
+/* Set *EPOCH_P and *GENERATION_P to the current revprop generation of FS.
+ * Every revprop change increases *GENERATION_P, while bulk changes that
+ * invalidate all revprop caches replace *EPOCH_P.  So as long as both
+ * values are unchanged, no revprops in FS have been modified.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__get_revprop_generation(apr_int64_t *epoch_p,
+                                  apr_int64_t *generation_p,
+                                  svn_fs_t *fs,
+                                  apr_pool_t *scratch_pool);
+
 /* Set *PROPS_SIZE_P to the size in bytes on disk of the revprops for
  * revision REV in FS. The size excludes indexes.
  */
@@ -85,6 +108,22 @@ svn_fs_fs__get_revision_proplist(apr_hash_t **proplist_p,
                                  apr_pool_t *result_pool,
                                  apr_pool_t *scratch_pool);
 
+/* Read the revprops for all revisions START to END in FS and return them
+ * in *PROPLISTS_P as an array of apr_hash_t *, in revision order.  Each
+ * revprop pack file will be read at most once and all its contents will
+ * be put into the revprop cache.
+ *
+ * The result will be allocated in RESULT_POOL; SCRATCH_POOL is used for
+ * temporaries.
+ */
+svn_error_t *
+svn_fs_fs__get_revision_proplists(apr_array_header_t **proplists_p,
+                                  svn_fs_t *fs,
+                                  svn_revnum_t start,
+                                  svn_revnum_t end,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool);
+
 /* Set the revision property list of revision REV in filesystem FS to
    PROPLIST.  Use POOL for temporary allocations. */
 svn_error_t *
@@ -93,6 +132,18 @@ svn_fs_fs__set_revision_proplist(svn_fs_t *fs,
                                  apr_hash_t *proplist,
                                  apr_pool_t *pool);
 
+/* Write PROPLIST as the revision properties of revision REV in FS to a
+   non-packed revprop file, replacing any existing one.  Unlike
+   svn_fs_fs__set_revision_proplist(), this neither checks for packed
+   revprops nor bumps the revprop generation.  It is therefore only suitable
+   for filesystems that are still being assembled.  Use POOL for temporary
+   allocations. */
+svn_error_t *
+svn_fs_fs__write_non_packed_revprop(svn_fs_t *fs,
+                                    svn_revnum_t rev,
+                                    apr_hash_t *proplist,
+                                    apr_pool_t *pool);
+
 
 /* Return TRUE, if for REVISION in FS, we can find the revprop pack file.
  * Use POOL for temporary allocations.
@@ -0,0 +1,212 @@
+/* sketch.c : content fingerprints for choosing delta bases
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include "svn_pools.h"
+
+#include "sketch.h"
+
+/* A chunk ends where the top bits of the rolling hash are all 0.
+ * With 7 bits, chunks are 128 bytes long on average. */
+#define CHUNK_BOUNDARY_MASK 0xfe000000
+
+/* Chunks are at least this long.  This avoids degenerated sketches for
+ * contents like long runs of the same byte. */
+#define MIN_CHUNK_SIZE 16
+
+/* FNV-1a parameters for the chunk hashes. */
+#define FNV1A_BASE 0x811c9dc5
+#define FNV1A_PRIME 0x01000193
+
+struct svn_fs_fs__sketch_t
+{
+  /* The COUNT smallest chunk hashes seen so far in ascending order. */
+  apr_uint32_t values[SVN_FS_FS__SKETCH_SIZE];
+  int count;
+
+  /* Rolling hash over the last 32 bytes.  Each shift removes the oldest
+   * byte's contribution from the top bits. */
+  apr_uint32_t rolling;
+
+  /* Hash and length of the chunk that is not complete, yet. */
+  apr_uint32_t chunk_hash;
+  apr_size_t chunk_len;
+};
+
+/* Return a pseudo-random value for byte C to feed into the rolling
+ * hash. */
+static APR_INLINE apr_uint32_t
+gear(unsigned char c)
+{
+  apr_uint32_t value = ((apr_uint32_t)c + 1) * 0x9e3779b1;
+  return value ^ (value >> 15);
+}
+
+/* Insert VALUE into the ascending list of *COUNT unique VALUES that may
+ * hold up to CAPACITY entries.  If the list is full, drop the largest
+ * entry in favor of VALUE or drop VALUE itself. */
+static void
+insert_value(apr_uint32_t *values,
+             int *count,
+             int capacity,
+             apr_uint32_t value)
+{
+  int lower = 0;
+  int upper = *count;
+
+  if (*count == capacity && value >= values[capacity - 1])
+    return;
+
+  while (lower < upper)
+    {
+      int middle = lower + (upper - lower) / 2;
+      if (values[middle] < value)
+        lower = middle + 1;
+      else
+        upper = middle;
+    }
+
+  if (lower < *count && values[lower] == value)
+    return;
+
+  if (*count < capacity)
+    ++*count;
+
+  memmove(values + lower + 1, values + lower,
+          (*count - 1 - lower) * sizeof(*values));
+  values[lower] = value;
+}
+
+svn_fs_fs__sketch_t *
+svn_fs_fs__sketch_create(apr_pool_t *result_pool)
+{
+  svn_fs_fs__sketch_t *sketch = apr_pcalloc(result_pool, sizeof(*sketch));
+  sketch->chunk_hash = FNV1A_BASE;
+
+  return sketch;
+}
+
+void
+svn_fs_fs__sketch_update(svn_fs_fs__sketch_t *sketch,
+                         const char *data,
+                         apr_size_t len)
+{
+  apr_uint32_t rolling = sketch->rolling;
+  apr_uint32_t chunk_hash = sketch->chunk_hash;
+  apr_size_t chunk_len = sketch->chunk_len;
+  apr_size_t i;
+
+  for (i = 0; i < len; ++i)
+    {
+      unsigned char c = (unsigned char)data[i];
+
+      rolling = (rolling << 1) + gear(c);
+      chunk_hash = (chunk_hash ^ c) * FNV1A_PRIME;
+      ++chunk_len;
+
+      if (   chunk_len >= MIN_CHUNK_SIZE
+          && (rolling & CHUNK_BOUNDARY_MASK) == 0)
+        {
+          insert_value(sketch->values, &sketch->count,
+                       SVN_FS_FS__SKETCH_SIZE, chunk_hash);
+          chunk_hash = FNV1A_BASE;
+          chunk_len = 0;
+        }
+    }
+
+  sketch->rolling = rolling;
+  sketch->chunk_hash = chunk_hash;
+  sketch->chunk_len = chunk_len;
+}
+
+svn_error_t *
+svn_fs_fs__sketch_stream(svn_fs_fs__sketch_t **sketch,
+                         svn_stream_t *stream,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  svn_fs_fs__sketch_t *result = svn_fs_fs__sketch_create(result_pool);
+  char *buffer = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
+  apr_size_t len;
+
+  do
+    {
+      len = SVN__STREAM_CHUNK_SIZE;
+      SVN_ERR(svn_stream_read_full(stream, buffer, &len));
+      svn_fs_fs__sketch_update(result, buffer, len);
+    }
+  while (len == SVN__STREAM_CHUNK_SIZE);
+
+  *sketch = result;
+  return SVN_NO_ERROR;
+}
+
+/* Copy the chunk hashes of SKETCH, including the one of the incomplete
+ * last chunk, to VALUES and return their number. */
+static int
+get_values(apr_uint32_t values[SVN_FS_FS__SKETCH_SIZE],
+           const svn_fs_fs__sketch_t *sketch)
+{
+  int count = sketch->count;
+
+  memcpy(values, sketch->values, count * sizeof(*values));
+  if (sketch->chunk_len)
+    insert_value(values, &count, SVN_FS_FS__SKETCH_SIZE, sketch->chunk_hash);
+
+  return count;
+}
+
+int
+svn_fs_fs__sketch_similarity(const svn_fs_fs__sketch_t *lhs,
+                             const svn_fs_fs__sketch_t *rhs)
+{
+  apr_uint32_t lhs_values[SVN_FS_FS__SKETCH_SIZE];
+  apr_uint32_t rhs_values[SVN_FS_FS__SKETCH_SIZE];
+  int lhs_count = get_values(lhs_values, lhs);
+  int rhs_count = get_values(rhs_values, rhs);
+  int i = 0, k = 0;
+  int seen = 0, common = 0;
+
+  /* Empty contents are identical. */
+  if (lhs_count == 0 && rhs_count == 0)
+    return 100;
+
+  /* Walk the smallest values of the union of both sketches. */
+  while (seen < SVN_FS_FS__SKETCH_SIZE && (i < lhs_count || k < rhs_count))
+    {
+      if (k == rhs_count || (i < lhs_count && lhs_values[i] < rhs_values[k]))
+        ++i;
+      else if (i == lhs_count || rhs_values[k] < lhs_values[i])
+        ++k;
+      else
+        {
+          ++common;
+          ++i;
+          ++k;
+        }
+
+      ++seen;
+    }
+
+  return common * 100 / seen;
+}
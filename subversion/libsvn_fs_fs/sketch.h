@@ -0,0 +1,76 @@
+/* sketch.h : content fingerprints for choosing delta bases
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_FS_FS__SKETCH_H
+#define SVN_LIBSVN_FS_FS__SKETCH_H
+
+#include "svn_io.h"
+
+/* A sketch is a small fingerprint of some contents that allows for
+ * estimating how similar two contents are without comparing them.
+ *
+ * The contents get cut into chunks at content-defined boundaries, i.e.
+ * insertions and deletions only affect the chunks around them.  The
+ * sketch keeps the SVN_FS_FS__SKETCH_SIZE smallest hash values of all
+ * chunks ("bottom-k" min-hashing).  The fraction of common values among
+ * the smallest values of two sketches combined is an estimate for the
+ * fraction of chunks that both contents have in common.
+ *
+ * Building a sketch costs a few operations per byte and its size does
+ * not depend on the size of the contents.
+ */
+
+/* Maximum number of chunk hashes kept in a sketch. */
+#define SVN_FS_FS__SKETCH_SIZE 64
+
+/* Opaque sketch type. */
+typedef struct svn_fs_fs__sketch_t svn_fs_fs__sketch_t;
+
+/* Return a new sketch for empty contents, allocated in RESULT_POOL. */
+svn_fs_fs__sketch_t *
+svn_fs_fs__sketch_create(apr_pool_t *result_pool);
+
+/* Add the LEN bytes at DATA to the contents described by SKETCH. */
+void
+svn_fs_fs__sketch_update(svn_fs_fs__sketch_t *sketch,
+                         const char *data,
+                         apr_size_t len);
+
+/* Read STREAM until EOF and return the sketch of its contents in *SKETCH,
+ * allocated in RESULT_POOL.  STREAM will not be closed.  Use SCRATCH_POOL
+ * for temporary allocations.
+ */
+svn_error_t *
+svn_fs_fs__sketch_stream(svn_fs_fs__sketch_t **sketch,
+                         svn_stream_t *stream,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool);
+
+/* Return the estimated percentage (0 .. 100) of contents that the
+ * sketches LHS and RHS have in common.  Either sketch may still be
+ * updated afterwards.
+ */
+int
+svn_fs_fs__sketch_similarity(const svn_fs_fs__sketch_t *lhs,
+                             const svn_fs_fs__sketch_t *rhs);
+
+#endif
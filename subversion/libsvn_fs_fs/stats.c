@@ -26,6 +26,7 @@
 #include "svn_sorts.h"
 
 #include "private/svn_cache.h"
+#include "private/svn_task.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
 
@@ -123,6 +124,31 @@ typedef struct rep_ref_t
 
 } rep_ref_t;
 
+/* Represents a noderev's reference to a representation in some revision
+ * that is not covered by the partial scan finding it.  We resolve these
+ * when merging the partial scan results. */
+typedef struct foreign_ref_t
+{
+  /* Revision that contains the representation. */
+  svn_revnum_t revision;
+
+  /* Item index of the rep within REVISION. */
+  apr_uint64_t item_index;
+
+  /* On-disk and expanded size of the representation. */
+  apr_uint64_t size;
+  apr_uint64_t expanded_size;
+
+  /* Path of the referencing node. */
+  const char *path;
+
+  /* Kind of the representation as implied by the referencing node. */
+  rep_kind_t kind;
+
+  /* Whether the referencing node has no deltification predecessor. */
+  svn_boolean_t plain_added;
+} foreign_ref_t;
+
 /* Represents a single revision.
  * There will be only one instance per revision. */
 typedef struct revision_info_t
@@ -182,9 +208,22 @@ typedef struct query_t
   /* First non-packed revision. */
   svn_revnum_t min_unpacked_rev;
 
-  /* all revisions */
+  /* First revision in REVISIONS.  This is 0 unless the query covers only
+   * part of the repository, i.e. it is a partial scan. */
+  svn_revnum_t first_revision;
+
+  /* all revisions, starting at FIRST_REVISION.  Revisions that have not
+   * been scanned are NULL. */
   apr_array_header_t *revisions;
 
+  /* If not NULL, this is a partial scan and we collect all delta chain
+   * links as rep_ref_t * here instead of resolving them. */
+  apr_array_header_t *rep_refs;
+
+  /* References to representations in revisions before FIRST_REVISION
+   * as foreign_ref_t *.  Only used for partial scans. */
+  apr_array_header_t *foreign_refs;
+
   /* empty representation.
    * Used as a dummy base for DELTA reps without base. */
   rep_stats_t *null_base;
@@ -255,20 +294,37 @@ add_to_histogram(svn_fs_fs__histogram_t *histogram,
   histogram->lines[(apr_size_t)shift].sum += size;
 }
 
-/* Update data aggregators in STATS with this representation of type KIND,
- * on-disk REP_SIZE and expanded node size EXPANDED_SIZE for PATH in REVSION.
- * PLAIN_ADDED indicates whether the node has a deltification predecessor.
+/* Return the entry for EXTENSION in STATS.  Auto-insert it if necessary.
+ */
+static svn_fs_fs__extension_info_t *
+get_extension_info(svn_fs_fs__stats_t *stats,
+                   const char *extension)
+{
+  svn_fs_fs__extension_info_t *info
+    = apr_hash_get(stats->by_extension, extension, APR_HASH_KEY_STRING);
+
+  if (info == NULL)
+    {
+      apr_pool_t *pool = apr_hash_pool_get(stats->by_extension);
+      info = apr_pcalloc(pool, sizeof(*info));
+      info->extension = apr_pstrdup(pool, extension);
+
+      apr_hash_set(stats->by_extension, info->extension,
+                   APR_HASH_KEY_STRING, info);
+    }
+
+  return info;
+}
+
+/* Add the representation with on-disk REP_SIZE for PATH in REVISION to
+ * the largest changes in STATS, if it is large enough.
  */
 static void
-add_change(svn_fs_fs__stats_t *stats,
-           apr_uint64_t rep_size,
-           apr_uint64_t expanded_size,
-           svn_revnum_t revision,
-           const char *path,
-           rep_kind_t kind,
-           svn_boolean_t plain_added)
+add_largest_change(svn_fs_fs__stats_t *stats,
+                   apr_uint64_t rep_size,
+                   svn_revnum_t revision,
+                   const char *path)
 {
-  /* identify largest reps */
   if (rep_size >= stats->largest_changes->min_size)
     {
       apr_size_t i;
@@ -291,6 +347,23 @@ add_change(svn_fs_fs__stats_t *stats,
       largest_changes->min_size
         = largest_changes->changes[largest_changes->count-1]->size;
     }
+}
+
+/* Update data aggregators in STATS with this representation of type KIND,
+ * on-disk REP_SIZE and expanded node size EXPANDED_SIZE for PATH in REVSION.
+ * PLAIN_ADDED indicates whether the node has a deltification predecessor.
+ */
+static void
+add_change(svn_fs_fs__stats_t *stats,
+           apr_uint64_t rep_size,
+           apr_uint64_t expanded_size,
+           svn_revnum_t revision,
+           const char *path,
+           rep_kind_t kind,
+           svn_boolean_t plain_added)
+{
+  /* identify largest reps */
+  add_largest_change(stats, rep_size, revision, path);
 
   /* global histograms */
   add_to_histogram(&stats->rep_size_histogram, rep_size);
@@ -337,24 +410,47 @@ add_change(svn_fs_fs__stats_t *stats,
       if (extension == NULL || extension == file_name + 1)
         extension = "(none)";
 
-      /* get / auto-insert entry for this extension */
-      info = apr_hash_get(stats->by_extension, extension, APR_HASH_KEY_STRING);
-      if (info == NULL)
-        {
-          apr_pool_t *pool = apr_hash_pool_get(stats->by_extension);
-          info = apr_pcalloc(pool, sizeof(*info));
-          info->extension = apr_pstrdup(pool, extension);
-
-          apr_hash_set(stats->by_extension, info->extension,
-                       APR_HASH_KEY_STRING, info);
-        }
-
       /* update per-extension histogram */
+      info = get_extension_info(stats, extension);
       add_to_histogram(&info->node_histogram, expanded_size);
       add_to_histogram(&info->rep_histogram, rep_size);
     }
 }
 
+/* Count another reference of a node at PATH to REP in STATS.  If this is
+ * the first one, REP becomes of type KIND and gets added to the histograms.
+ * PLAIN_ADDED indicates whether the node has a deltification predecessor.
+ */
+static void
+add_rep_reference(svn_fs_fs__stats_t *stats,
+                  rep_stats_t *rep,
+                  rep_kind_t kind,
+                  const char *path,
+                  svn_boolean_t plain_added)
+{
+  if (++rep->ref_count == 1)
+    {
+      rep->kind = kind;
+      add_change(stats, rep->size, rep->expanded_size, rep->revision, path,
+                 kind, plain_added);
+    }
+}
+
+/* Return the revision_info_t for REVISION in QUERY or NULL, if REVISION
+ * is not covered by QUERY or has not been scanned.
+ */
+static revision_info_t *
+get_revision_info(query_t *query,
+                  svn_revnum_t revision)
+{
+  if (   revision < query->first_revision
+      || revision - query->first_revision >= query->revisions->nelts)
+    return NULL;
+
+  return APR_ARRAY_IDX(query->revisions, revision - query->first_revision,
+                       revision_info_t *);
+}
+
 /* Comparator used for binary search comparing the absolute file offset
  * of a representation to some other offset. DATA is a *rep_stats_t,
  * KEY is a pointer to an apr_uint64_t.
@@ -393,7 +489,7 @@ find_representation(int *idx,
   info = revision_info ? *revision_info : NULL;
   if (info == NULL || info->revision != revision)
     {
-      info = APR_ARRAY_IDX(query->revisions, revision, revision_info_t*);
+      info = get_revision_info(query, revision);
       if (revision_info)
         *revision_info = info;
     }
@@ -470,8 +566,30 @@ parse_representation(rep_stats_t **representation,
 
           result->header_size = header->header_size;
 
-          /* Determine length of the delta chain. */
-          if (header->type == svn_fs_fs__rep_delta)
+          /* Determine length of the delta chain.  Partial scans may not
+           * know the base rep and leave that to the merge step. */
+          if (query->rep_refs)
+            {
+              rep_ref_t *ref = apr_pcalloc(query->rep_refs->pool,
+                                           sizeof(*ref));
+              ref->header_size = header->header_size;
+              ref->revision = rep->revision;
+              ref->item_index = rep->item_index;
+
+              if (header->type == svn_fs_fs__rep_delta)
+                {
+                  ref->base_item_index = header->base_item_index;
+                  ref->base_revision = header->base_revision;
+                }
+              else
+                {
+                  ref->base_item_index = SVN_FS_FS__ITEM_INDEX_UNUSED;
+                  ref->base_revision = SVN_INVALID_REVNUM;
+                }
+
+              APR_ARRAY_PUSH(query->rep_refs, rep_ref_t *) = ref;
+            }
+          else if (header->type == svn_fs_fs__rep_delta)
             {
               int base_idx;
               rep_stats_t *base_rep
@@ -596,6 +714,51 @@ parse_dir(query_t *query,
   return SVN_NO_ERROR;
 }
 
+/* Count the reference of NODEREV to its representation REP of type KIND
+ * in QUERY and return the respective rep stats in *REP_STATS.  If REP
+ * lies outside the revisions covered by a partial scan, record it as a
+ * foreign reference and return NULL.
+ *
+ * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
+ * temporaries.
+ */
+static svn_error_t *
+count_noderev_rep(rep_stats_t **rep_stats,
+                  query_t *query,
+                  representation_t *rep,
+                  rep_kind_t kind,
+                  node_revision_t *noderev,
+                  revision_info_t *revision_info,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  if (rep->revision < query->first_revision)
+    {
+      apr_pool_t *pool = query->foreign_refs->pool;
+      foreign_ref_t *ref = apr_pcalloc(pool, sizeof(*ref));
+
+      ref->revision = rep->revision;
+      ref->item_index = rep->item_index;
+      ref->size = rep->size;
+      ref->expanded_size = rep->expanded_size;
+      ref->path = apr_pstrdup(pool, noderev->created_path);
+      ref->kind = kind;
+      ref->plain_added = !noderev->predecessor_id;
+
+      APR_ARRAY_PUSH(query->foreign_refs, foreign_ref_t *) = ref;
+      *rep_stats = NULL;
+
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(parse_representation(rep_stats, query, rep, revision_info,
+                               result_pool, scratch_pool));
+  add_rep_reference(query->stats, *rep_stats, kind, noderev->created_path,
+                    !noderev->predecessor_id);
+
+  return SVN_NO_ERROR;
+}
+
 /* Parse the noderev given as NODEREV_STR and store the info in QUERY and
  * REVISION_INFO.  In phys. addressing mode, continue reading all DAG nodes,
  * directories and representations linked in that tree structure.
@@ -622,37 +785,22 @@ read_noderev(query_t *query,
   SVN_ERR(svn_fs_fs__fixup_expanded_size(query->fs, noderev->prop_rep,
                                          scratch_pool));
 
+  /* if we are the first to use these reps, mark them as "text rep" and
+   * "prop rep", respectively, and record them as changes */
   if (noderev->data_rep)
-    {
-      SVN_ERR(parse_representation(&text, query,
-                                   noderev->data_rep, revision_info,
-                                   result_pool, scratch_pool));
-
-      /* if we are the first to use this rep, mark it as "text rep" */
-      if (++text->ref_count == 1)
-        text->kind = noderev->kind == svn_node_dir ? dir_rep : file_rep;
-    }
+    SVN_ERR(count_noderev_rep(&text, query, noderev->data_rep,
+                              noderev->kind == svn_node_dir ? dir_rep
+                                                            : file_rep,
+                              noderev, revision_info,
+                              result_pool, scratch_pool));
 
   if (noderev->prop_rep)
-    {
-      SVN_ERR(parse_representation(&props, query,
-                                   noderev->prop_rep, revision_info,
-                                   result_pool, scratch_pool));
-
-      /* if we are the first to use this rep, mark it as "prop rep" */
-      if (++props->ref_count == 1)
-        props->kind = noderev->kind == svn_node_dir ? dir_property_rep
-                                                    : file_property_rep;
-    }
-
-  /* record largest changes */
-  if (text && text->ref_count == 1)
-    add_change(query->stats, text->size, text->expanded_size, text->revision,
-               noderev->created_path, text->kind, !noderev->predecessor_id);
-  if (props && props->ref_count == 1)
-    add_change(query->stats, props->size, props->expanded_size,
-               props->revision, noderev->created_path, props->kind,
-               !noderev->predecessor_id);
+    SVN_ERR(count_noderev_rep(&props, query, noderev->prop_rep,
+                              noderev->kind == svn_node_dir
+                                ? dir_property_rep
+                                : file_property_rep,
+                              noderev, revision_info,
+                              result_pool, scratch_pool));
 
   /* if this is a directory and has not been processed, yet, read and
    * process it recursively */
@@ -700,7 +848,7 @@ get_phys_change_count(query_t *query,
 
       svn_pool_clear(iterpool);
       SVN_ERR(svn_fs_fs__get_changes(&changes, context, iterpool, iterpool));
-      revision_info->change_count = changes->nelts;
+      revision_info->change_count += changes->nelts;
     }
 
   svn_pool_destroy(iterpool);
@@ -878,24 +1026,54 @@ read_phys_revision_file(query_t *query,
   return SVN_NO_ERROR;
 }
 
-/* Given the unparsed changes list in CHANGES with LEN chars, return the
- * number of changed paths encoded in it.  Only used in log. addressing
- * mode.
+/* Given the unparsed changes list in CHANGES, return the number of
+ * changed paths encoded in it in *COUNT.  Only used in log. addressing
+ * mode.  Use SCRATCH_POOL for temporary allocations.
  */
-static apr_uint64_t
-get_log_change_count(const char *changes,
-                     apr_size_t len)
+static svn_error_t *
+get_log_change_count(apr_uint64_t *count,
+                     query_t *query,
+                     svn_stringbuf_t *changes,
+                     apr_pool_t *scratch_pool)
 {
+  fs_fs_data_t *ffd = query->fs->fsap_data;
   apr_size_t lines = 0;
-  const char *end = changes + len;
+  const char *p = changes->data;
+  const char *end = changes->data + changes->len;
+
+  /* Packed lists have no line structure.  Parse them block by block. */
+  if (ffd->format >= SVN_FS_FS__MIN_PACKED_CHANGES_FORMAT)
+    {
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      svn_stream_t *stream = svn_stream_from_stringbuf(changes,
+                                                       scratch_pool);
+      svn_boolean_t eol = FALSE;
+
+      *count = 0;
+      while (!eol)
+        {
+          apr_array_header_t *block;
+
+          svn_pool_clear(iterpool);
+          SVN_ERR(svn_fs_fs__read_changes(&block, &eol, stream,
+                                          SVN_FS_FS__CHANGES_BLOCK_SIZE,
+                                          iterpool, iterpool));
+          *count += block->nelts;
+        }
+
+      svn_pool_destroy(iterpool);
+      return SVN_NO_ERROR;
+    }
 
   /* line count */
-  for (; changes < end; ++changes)
-    if (*changes == '\n')
+  for (; p < end; ++p)
+    if (*p == '\n')
       ++lines;
 
   /* two lines per change */
-  return lines / 2;
+  *count = lines / 2;
+
+  return SVN_NO_ERROR;
 }
 
 /* Read the item described by ENTRY from the REV_FILE and return the
@@ -940,11 +1118,14 @@ compare_representation_refs(const void *lhs, const void *rhs)
 
 /* Given all the presentations found in a single rev / pack file as
  * rep_ref_t * in REP_REFS, update the delta chain lengths in QUERY.
- * REP_REFS and its contents can then be discarded.
+ * REP_REFS and its contents can then be discarded.  If SAMPLED is set,
+ * QUERY may not contain all base reps and we simply end the delta chains
+ * at the missing ones.
  */
 static svn_error_t *
 resolve_representation_refs(query_t *query,
-                            apr_array_header_t *rep_refs)
+                            apr_array_header_t *rep_refs,
+                            svn_boolean_t sampled)
 {
   int i;
 
@@ -978,6 +1159,12 @@ resolve_representation_refs(query_t *query,
 
           base = find_representation(&idx, query, NULL, ref->base_revision,
                                      ref->base_item_index);
+          if (sampled && !base)
+            {
+              rep->chain_length = 1;
+              continue;
+            }
+
           SVN_ERR_ASSERT(base);
           SVN_ERR_ASSERT(base->chain_length);
 
@@ -1010,9 +1197,10 @@ read_log_rev_or_packfile(query_t *query,
 
   /* We collect the delta chain links as we scan the file.  Afterwards,
    * we determine the lengths of those delta chains and throw this
-   * temporary container away. */
-  apr_array_header_t *rep_refs = apr_array_make(scratch_pool, 64,
-                                                sizeof(rep_ref_t *));
+   * temporary container away.  Partial scans keep them for later. */
+  apr_array_header_t *rep_refs
+    = query->rep_refs ? query->rep_refs
+                      : apr_array_make(scratch_pool, 64, sizeof(rep_ref_t *));
 
   /* we will process every revision in the rev / pack file */
   for (i = 0; i < count; ++i)
@@ -1034,7 +1222,7 @@ read_log_rev_or_packfile(query_t *query,
 
   /* record the whole pack size in the first rev so the total sum will
      still be correct */
-  APR_ARRAY_IDX(query->revisions, base, revision_info_t*)->end = max_offset;
+  get_revision_info(query, base)->end = max_offset;
 
   /* for all offsets in the file, get the P2L index entries and process
      the interesting items (change lists, noderevs) */
@@ -1070,8 +1258,7 @@ read_log_rev_or_packfile(query_t *query,
             continue;
 
           /* read and process interesting items */
-          info = APR_ARRAY_IDX(query->revisions, entry->item.revision,
-                               revision_info_t*);
+          info = get_revision_info(query, entry->item.revision);
 
           if (entry->type == SVN_FS_FS__ITEM_TYPE_NODEREV)
             {
@@ -1081,8 +1268,8 @@ read_log_rev_or_packfile(query_t *query,
           else if (entry->type == SVN_FS_FS__ITEM_TYPE_CHANGES)
             {
               SVN_ERR(read_item(&item, rev_file, entry, iterpool, iterpool));
-              info->change_count
-                = get_log_change_count(item->data + 0, item->len);
+              SVN_ERR(get_log_change_count(&info->change_count, query, item,
+                                           iterpool));
               info->changes_len += entry->size;
             }
           else if (   (entry->type == SVN_FS_FS__ITEM_TYPE_FILE_REP)
@@ -1092,7 +1279,7 @@ read_log_rev_or_packfile(query_t *query,
             {
               /* Collect the delta chain link. */
               svn_fs_fs__rep_header_t *header;
-              rep_ref_t *ref = apr_pcalloc(scratch_pool, sizeof(*ref));
+              rep_ref_t *ref = apr_pcalloc(rep_refs->pool, sizeof(*ref));
 
               SVN_ERR(svn_io_file_aligned_seek(rev_file->file,
                                                rev_file->block_size,
@@ -1126,7 +1313,8 @@ read_log_rev_or_packfile(query_t *query,
     }
 
   /* Resolve the delta chain links. */
-  SVN_ERR(resolve_representation_refs(query, rep_refs));
+  if (!query->rep_refs)
+    SVN_ERR(resolve_representation_refs(query, rep_refs, FALSE));
 
   /* clean up and close file handles */
   svn_pool_destroy(iterpool);
@@ -1183,13 +1371,17 @@ read_log_revision_file(query_t *query,
   return SVN_NO_ERROR;
 }
 
-/* Read the repository and collect the stats info in QUERY.
+/* Read the revisions START to END of the repository and collect the stats
+ * info in QUERY.  If START is a packed revision, it must be the first
+ * revision in its shard.
  *
  * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
  * temporaries.
  */
 static svn_error_t *
 read_revisions(query_t *query,
+               svn_revnum_t start,
+               svn_revnum_t end,
                apr_pool_t *result_pool,
                apr_pool_t *scratch_pool)
 {
@@ -1197,8 +1389,8 @@ read_revisions(query_t *query,
   svn_revnum_t revision;
 
   /* read all packed revs */
-  for ( revision = 0
-      ; revision < query->min_unpacked_rev
+  for ( revision = start
+      ; revision < MIN(query->min_unpacked_rev, end + 1)
       ; revision += query->shard_size)
     {
       svn_pool_clear(iterpool);
@@ -1210,7 +1402,7 @@ read_revisions(query_t *query,
     }
 
   /* read non-packed revs */
-  for ( ; revision <= query->head; ++revision)
+  for ( ; revision <= end; ++revision)
     {
       svn_pool_clear(iterpool);
 
@@ -1258,7 +1450,7 @@ add_rep_stats(svn_fs_fs__representation_stats_t *stats,
 }
 
 /* Aggregate the info the in revision_info_t * array REVISIONS into the
- * respectve fields of STATS.
+ * respectve fields of STATS.  NULL entries are revisions not scanned.
  */
 static void
 aggregate_stats(const apr_array_header_t *revisions,
@@ -1272,6 +1464,10 @@ aggregate_stats(const apr_array_header_t *revisions,
     {
       revision_info_t *revision = APR_ARRAY_IDX(revisions, i,
                                                 revision_info_t *);
+      if (revision == NULL)
+        continue;
+
+      stats->scanned_revision_count++;
 
       /* data gathered on a revision level */
       stats->change_count += revision->change_count;
@@ -1376,11 +1572,451 @@ create_query(query_t **query,
   return SVN_NO_ERROR;
 }
 
+/* Return VALUE scaled by FACTOR.
+ */
+static apr_uint64_t
+scale_value(apr_uint64_t value,
+            double factor)
+{
+  return (apr_uint64_t)(value * factor + 0.5);
+}
+
+/* Scale all entries in HISTOGRAM by FACTOR.
+ */
+static void
+scale_histogram(svn_fs_fs__histogram_t *histogram,
+                double factor)
+{
+  int i;
+
+  histogram->total.count = scale_value(histogram->total.count, factor);
+  histogram->total.sum = scale_value(histogram->total.sum, factor);
+  for (i = 0; i < 64; ++i)
+    {
+      histogram->lines[i].count = scale_value(histogram->lines[i].count,
+                                              factor);
+      histogram->lines[i].sum = scale_value(histogram->lines[i].sum, factor);
+    }
+}
+
+/* Scale all entries in STATS by FACTOR.
+ */
+static void
+scale_rep_pack_stats(svn_fs_fs__rep_pack_stats_t *stats,
+                     double factor)
+{
+  stats->count = scale_value(stats->count, factor);
+  stats->packed_size = scale_value(stats->packed_size, factor);
+  stats->expanded_size = scale_value(stats->expanded_size, factor);
+  stats->overhead_size = scale_value(stats->overhead_size, factor);
+}
+
+/* Scale all entries in STATS by FACTOR.
+ */
+static void
+scale_rep_stats(svn_fs_fs__representation_stats_t *stats,
+                double factor)
+{
+  scale_rep_pack_stats(&stats->total, factor);
+  scale_rep_pack_stats(&stats->uniques, factor);
+  scale_rep_pack_stats(&stats->shared, factor);
+
+  stats->references = scale_value(stats->references, factor);
+  stats->expanded_size = scale_value(stats->expanded_size, factor);
+  stats->chain_len = scale_value(stats->chain_len, factor);
+}
+
+/* Scale all entries in STATS by FACTOR.
+ */
+static void
+scale_node_stats(svn_fs_fs__node_stats_t *stats,
+                 double factor)
+{
+  stats->count = scale_value(stats->count, factor);
+  stats->size = scale_value(stats->size, factor);
+}
+
+/* Extrapolate the sampled STATS to the whole repository.  The list of
+ * largest changes remains as is.  Use SCRATCH_POOL for temporaries.
+ */
+static void
+extrapolate_stats(svn_fs_fs__stats_t *stats,
+                  apr_pool_t *scratch_pool)
+{
+  apr_hash_index_t *hi;
+  double factor = (double)stats->revision_count
+                / (double)stats->scanned_revision_count;
+
+  stats->total_size = scale_value(stats->total_size, factor);
+  stats->change_count = scale_value(stats->change_count, factor);
+  stats->change_len = scale_value(stats->change_len, factor);
+
+  scale_rep_stats(&stats->total_rep_stats, factor);
+  scale_rep_stats(&stats->file_rep_stats, factor);
+  scale_rep_stats(&stats->dir_rep_stats, factor);
+  scale_rep_stats(&stats->file_prop_rep_stats, factor);
+  scale_rep_stats(&stats->dir_prop_rep_stats, factor);
+
+  scale_node_stats(&stats->total_node_stats, factor);
+  scale_node_stats(&stats->file_node_stats, factor);
+  scale_node_stats(&stats->dir_node_stats, factor);
+
+  scale_histogram(&stats->rep_size_histogram, factor);
+  scale_histogram(&stats->node_size_histogram, factor);
+  scale_histogram(&stats->added_rep_size_histogram, factor);
+  scale_histogram(&stats->added_node_size_histogram, factor);
+  scale_histogram(&stats->unused_rep_histogram, factor);
+  scale_histogram(&stats->file_histogram, factor);
+  scale_histogram(&stats->file_rep_histogram, factor);
+  scale_histogram(&stats->file_prop_histogram, factor);
+  scale_histogram(&stats->file_prop_rep_histogram, factor);
+  scale_histogram(&stats->dir_histogram, factor);
+  scale_histogram(&stats->dir_rep_histogram, factor);
+  scale_histogram(&stats->dir_prop_histogram, factor);
+  scale_histogram(&stats->dir_prop_rep_histogram, factor);
+
+  for (hi = apr_hash_first(scratch_pool, stats->by_extension);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      svn_fs_fs__extension_info_t *info = apr_hash_this_val(hi);
+
+      scale_histogram(&info->rep_histogram, factor);
+      scale_histogram(&info->node_histogram, factor);
+    }
+}
+
+/* Add the contents of histogram SOURCE to TARGET.
+ */
+static void
+merge_histogram(svn_fs_fs__histogram_t *target,
+                const svn_fs_fs__histogram_t *source)
+{
+  int i;
+
+  target->total.count += source->total.count;
+  target->total.sum += source->total.sum;
+  for (i = 0; i < 64; ++i)
+    {
+      target->lines[i].count += source->lines[i].count;
+      target->lines[i].sum += source->lines[i].sum;
+    }
+}
+
+/* Add the histograms, per-extension data and largest changes collected
+ * in SOURCE to TARGET.  Use SCRATCH_POOL for temporaries.
+ */
+static void
+merge_stats(svn_fs_fs__stats_t *target,
+            const svn_fs_fs__stats_t *source,
+            apr_pool_t *scratch_pool)
+{
+  apr_hash_index_t *hi;
+  apr_size_t i;
+
+  merge_histogram(&target->rep_size_histogram, &source->rep_size_histogram);
+  merge_histogram(&target->node_size_histogram,
+                  &source->node_size_histogram);
+  merge_histogram(&target->added_rep_size_histogram,
+                  &source->added_rep_size_histogram);
+  merge_histogram(&target->added_node_size_histogram,
+                  &source->added_node_size_histogram);
+  merge_histogram(&target->unused_rep_histogram,
+                  &source->unused_rep_histogram);
+  merge_histogram(&target->file_histogram, &source->file_histogram);
+  merge_histogram(&target->file_rep_histogram, &source->file_rep_histogram);
+  merge_histogram(&target->file_prop_histogram,
+                  &source->file_prop_histogram);
+  merge_histogram(&target->file_prop_rep_histogram,
+                  &source->file_prop_rep_histogram);
+  merge_histogram(&target->dir_histogram, &source->dir_histogram);
+  merge_histogram(&target->dir_rep_histogram, &source->dir_rep_histogram);
+  merge_histogram(&target->dir_prop_histogram, &source->dir_prop_histogram);
+  merge_histogram(&target->dir_prop_rep_histogram,
+                  &source->dir_prop_rep_histogram);
+
+  for (hi = apr_hash_first(scratch_pool, source->by_extension);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const svn_fs_fs__extension_info_t *info = apr_hash_this_val(hi);
+      svn_fs_fs__extension_info_t *target_info
+        = get_extension_info(target, info->extension);
+
+      merge_histogram(&target_info->rep_histogram, &info->rep_histogram);
+      merge_histogram(&target_info->node_histogram, &info->node_histogram);
+    }
+
+  /* SOURCE's list is sorted by size, unused entries being at the end. */
+  for (i = 0; i < source->largest_changes->count; ++i)
+    {
+      const svn_fs_fs__large_change_info_t *info
+        = source->largest_changes->changes[i];
+      if (info->revision == SVN_INVALID_REVNUM)
+        break;
+
+      add_largest_change(target, info->size, info->revision,
+                         info->path->data);
+    }
+}
+
+/* Return a copy of INFO and all its representations, allocated in
+ * RESULT_POOL.
+ */
+static revision_info_t *
+copy_revision_info(const revision_info_t *info,
+                   apr_pool_t *result_pool)
+{
+  int i;
+  revision_info_t *copy = apr_pmemdup(result_pool, info, sizeof(*info));
+
+  copy->representations = apr_array_make(result_pool,
+                                         info->representations->nelts,
+                                         sizeof(rep_stats_t *));
+  for (i = 0; i < info->representations->nelts; ++i)
+    {
+      const rep_stats_t *rep = APR_ARRAY_IDX(info->representations, i,
+                                             rep_stats_t *);
+      APR_ARRAY_PUSH(copy->representations, rep_stats_t *)
+        = apr_pmemdup(result_pool, rep, sizeof(*rep));
+    }
+
+  return copy;
+}
+
+/* Merge the results of the partial scan PARTIAL into QUERY.  All earlier
+ * partial scans must already have been merged.  SAMPLED indicates that
+ * some parts of the repository will not be scanned at all.
+ *
+ * Use RESULT_POOL for persistent allocations and SCRATCH_POOL for
+ * temporaries.
+ */
+static svn_error_t *
+merge_partial_scan(query_t *query,
+                   query_t *partial,
+                   svn_boolean_t sampled,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  int i;
+
+  /* Revisions skipped by sampling remain NULL. */
+  while (query->revisions->nelts < partial->first_revision)
+    APR_ARRAY_PUSH(query->revisions, revision_info_t *) = NULL;
+
+  for (i = 0; i < partial->revisions->nelts; ++i)
+    APR_ARRAY_PUSH(query->revisions, revision_info_t *)
+      = copy_revision_info(APR_ARRAY_IDX(partial->revisions, i,
+                                         revision_info_t *),
+                           result_pool);
+
+  /* Now, all delta bases are known - unless they have not been sampled. */
+  SVN_ERR(resolve_representation_refs(query, partial->rep_refs, sampled));
+
+  /* Count the references to reps in older shards. */
+  for (i = 0; i < partial->foreign_refs->nelts; ++i)
+    {
+      int idx;
+      revision_info_t *info = NULL;
+      foreign_ref_t *ref = APR_ARRAY_IDX(partial->foreign_refs, i,
+                                         foreign_ref_t *);
+      rep_stats_t *rep = find_representation(&idx, query, &info,
+                                             ref->revision,
+                                             ref->item_index);
+
+      /* Not sampled? */
+      if (info == NULL)
+        continue;
+
+      if (rep == NULL)
+        {
+          rep = apr_pcalloc(result_pool, sizeof(*rep));
+          rep->revision = ref->revision;
+          rep->item_index = ref->item_index;
+          rep->size = ref->size;
+          rep->expanded_size = ref->expanded_size;
+
+          SVN_ERR(svn_sort__array_insert2(info->representations, &rep, idx));
+        }
+
+      add_rep_reference(query->stats, rep, ref->kind, ref->path,
+                        ref->plain_added);
+    }
+
+  merge_stats(query->stats, partial->stats, scratch_pool);
+
+  /* one more shard processed */
+  if (query->progress_func)
+    query->progress_func(partial->first_revision, query->progress_baton,
+                         scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Shared state of a parallel and / or sampled scan.
+ */
+typedef struct scan_baton_t
+{
+  /* The query to merge all partial results into. */
+  query_t *query;
+
+  /* Number of worker threads to use. */
+  int jobs;
+
+  /* Scan only every SAMPLE-th shard. */
+  int sample;
+} scan_baton_t;
+
+/* Process baton of a partial scan task covering the revisions START to
+ * END (inclusive).
+ */
+typedef struct scan_range_t
+{
+  scan_baton_t *sb;
+  svn_revnum_t start;
+  svn_revnum_t end;
+} scan_range_t;
+
+/* Implements svn_task__thread_context_constructor_t.  The thread context
+ * is the svn_fs_t instance to read from.  CONTEXT_BATON is the
+ * scan_baton_t *.
+ */
+static svn_error_t *
+scan_context_constructor(void **thread_context,
+                         void *context_baton,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  scan_baton_t *sb = context_baton;
+  svn_fs_t *fs = sb->query->fs;
+
+  /* Worker threads must not share the svn_fs_t with the main thread. */
+  if (sb->jobs > 1)
+    SVN_ERR(svn_fs_fs__open_instance(&fs, sb->query->fs, result_pool,
+                                     scratch_pool));
+
+  *thread_context = fs;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  PROCESS_BATON is a scan_range_t
+ * and THREAD_CONTEXT the svn_fs_t to read from.
+ *
+ * Scan the given range of revisions into a new partial query_t and
+ * return that as the result.
+ */
+static svn_error_t *
+scan_range_process(void **result,
+                   svn_task__t *task,
+                   void *thread_context,
+                   void *process_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  const scan_range_t *range = process_baton;
+  const query_t *main_query = range->sb->query;
+  query_t *query = apr_pcalloc(result_pool, sizeof(*query));
+
+  query->fs = thread_context;
+  query->head = main_query->head;
+  query->shard_size = main_query->shard_size;
+  query->min_unpacked_rev = main_query->min_unpacked_rev;
+  query->first_revision = range->start;
+  query->revisions = apr_array_make(result_pool,
+                                    (int)(range->end - range->start + 1),
+                                    sizeof(revision_info_t *));
+  query->rep_refs = apr_array_make(result_pool, 64, sizeof(rep_ref_t *));
+  query->foreign_refs = apr_array_make(result_pool, 16,
+                                       sizeof(foreign_ref_t *));
+  query->stats = create_stats(result_pool);
+  query->cancel_func = cancel_func;
+  query->cancel_baton = cancel_baton;
+
+  SVN_ERR(read_revisions(query, range->start, range->end, result_pool,
+                         scratch_pool));
+
+  *result = query;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  RESULT is the partial query_t
+ * produced by scan_range_process and OUTPUT_BATON the scan_baton_t *.
+ * Since this gets called in revision order, all delta bases and foreign
+ * references can be resolved against the data merged so far.
+ */
+static svn_error_t *
+scan_range_output(svn_task__t *task,
+                  void *result,
+                  void *output_baton,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  scan_baton_t *sb = output_baton;
+
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  return svn_error_trace(merge_partial_scan(sb->query, result,
+                                            sb->sample > 1,
+                                            result_pool, scratch_pool));
+}
+
+/* Implements svn_task__process_func_t.  PROCESS_BATON is the
+ * scan_baton_t *.
+ *
+ * Split the repository into packed shards and runs of non-packed
+ * revisions within the same shard and add a sub-task for every
+ * SAMPLE-th of them.
+ */
+static svn_error_t *
+scan_root_process(void **result,
+                  svn_task__t *task,
+                  void *thread_context,
+                  void *process_baton,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  scan_baton_t *sb = process_baton;
+  svn_revnum_t head = sb->query->head;
+  int step = sb->query->shard_size ? sb->query->shard_size : 1000;
+  svn_revnum_t start, end;
+  int unit;
+
+  for (start = 0, unit = 0; start <= head; start = end + 1, ++unit)
+    {
+      end = MIN(head, start - start % step + step - 1);
+      if (unit % sb->sample == 0)
+        {
+          apr_pool_t *process_pool = svn_task__create_process_pool(task);
+          scan_range_t *range = apr_pcalloc(process_pool, sizeof(*range));
+
+          range->sb = sb;
+          range->start = start;
+          range->end = end;
+
+          SVN_ERR(svn_task__add(task, process_pool, NULL,
+                                scan_range_process, range,
+                                scan_range_output, sb));
+        }
+    }
+
+  *result = NULL;
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
                      svn_fs_t *fs,
                      svn_fs_progress_notify_func_t progress_func,
                      void *progress_baton,
+                     int jobs,
+                     int sample,
                      svn_cancel_func_t cancel_func,
                      void *cancel_baton,
                      apr_pool_t *result_pool,
@@ -1392,8 +2028,37 @@ svn_fs_fs__get_stats(svn_fs_fs__stats_t **stats,
   SVN_ERR(create_query(&query, fs, *stats, progress_func, progress_baton,
                        cancel_func, cancel_baton, scratch_pool,
                        scratch_pool));
-  SVN_ERR(read_revisions(query, scratch_pool, scratch_pool));
+
+  if (jobs > 1 || sample > 1)
+    {
+      apr_pool_t *task_pool = svn_pool_create(scratch_pool);
+      scan_baton_t *sb = apr_pcalloc(scratch_pool, sizeof(*sb));
+
+      sb->query = query;
+      sb->jobs = MAX(jobs, 1);
+      sb->sample = MAX(sample, 1);
+
+      SVN_ERR(svn_task__run(sb->jobs,
+                            scan_root_process, sb,
+                            NULL, NULL,
+                            scan_context_constructor, sb,
+                            cancel_func, cancel_baton,
+                            scratch_pool, task_pool));
+      svn_pool_destroy(task_pool);
+
+      /* The latest revisions may not have been sampled. */
+      while (query->revisions->nelts <= query->head)
+        APR_ARRAY_PUSH(query->revisions, revision_info_t *) = NULL;
+    }
+  else
+    {
+      SVN_ERR(read_revisions(query, 0, query->head, scratch_pool,
+                             scratch_pool));
+    }
+
   aggregate_stats(query->revisions, *stats);
+  if ((*stats)->scanned_revision_count < (*stats)->revision_count)
+    extrapolate_stats(*stats, scratch_pool);
 
   return SVN_NO_ERROR;
 }
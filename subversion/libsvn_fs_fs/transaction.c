@@ -32,6 +32,7 @@
 #include "svn_time.h"
 #include "svn_dirent_uri.h"
 
+#include "batch_fsync.h"
 #include "fs_fs.h"
 #include "index.h"
 #include "tree.h"
@@ -41,8 +42,12 @@
 #include "temp_serializer.h"
 #include "cached_data.h"
 #include "lock.h"
+#include "mergeinfo_index.h"
+#include "path_index.h"
 #include "rep-cache.h"
+#include "sketch.h"
 
+#include "private/svn_delta_private.h"
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
 #include "private/svn_sorts_private.h"
@@ -296,6 +301,10 @@ struct get_writable_proto_rev_baton
 {
   void **lockcookie;
   svn_fs_fs__id_part_t txn_id;
+
+  /* Set if the proto-rev file is locked by another thread or process,
+     i.e. if the caller may wait for the lock to be released. */
+  svn_boolean_t *may_wait;
 };
 
 /* Callback used in the implementation of get_writable_proto_rev(). */
@@ -309,12 +318,20 @@ get_writable_proto_rev_body(svn_fs_t *fs, const void *baton, apr_pool_t *pool)
   /* First, ensure that no thread in this process (including this one)
      is currently writing to this transaction's proto-rev file. */
   if (txn->being_written)
-    return svn_error_createf(SVN_ERR_FS_REP_BEING_WRITTEN, NULL,
+    {
+#if APR_HAS_THREADS
+      if (b->may_wait)
+        *b->may_wait = !apr_os_thread_equal(txn->writer,
+                                            apr_os_thread_current());
+#endif
+
+      return svn_error_createf(SVN_ERR_FS_REP_BEING_WRITTEN, NULL,
                              _("Cannot write to the prototype revision file "
                                "of transaction '%s' because a previous "
                                "representation is currently being written by "
                                "this process"),
                              svn_fs_fs__id_txn_unparse(&b->txn_id, pool));
+    }
 
 
   /* We know that no thread in this process is writing to the proto-rev
@@ -346,13 +363,18 @@ get_writable_proto_rev_body(svn_fs_t *fs, const void *baton, apr_pool_t *pool)
         svn_error_clear(svn_io_file_close(lockfile, pool));
 
         if (APR_STATUS_IS_EAGAIN(apr_err))
-          return svn_error_createf(SVN_ERR_FS_REP_BEING_WRITTEN, NULL,
+          {
+            if (b->may_wait)
+              *b->may_wait = TRUE;
+
+            return svn_error_createf(SVN_ERR_FS_REP_BEING_WRITTEN, NULL,
                                    _("Cannot write to the prototype revision "
                                      "file of transaction '%s' because a "
                                      "previous representation is currently "
                                      "being written by another process"),
                                    svn_fs_fs__id_txn_unparse(&b->txn_id,
                                                              pool));
+          }
 
         return svn_error_wrap_apr(apr_err,
                                   _("Can't get exclusive lock on file '%s'"),
@@ -364,6 +386,9 @@ get_writable_proto_rev_body(svn_fs_t *fs, const void *baton, apr_pool_t *pool)
 
   /* We've successfully locked the transaction; mark it as such. */
   txn->being_written = TRUE;
+#if APR_HAS_THREADS
+  txn->writer = apr_os_thread_current();
+#endif
 
   return SVN_NO_ERROR;
 }
@@ -420,12 +445,16 @@ auto_truncate_proto_rev(svn_fs_t *fs,
    has been closed.
 
    If the prototype revision file is already locked, return error
-   SVN_ERR_FS_REP_BEING_WRITTEN.
+   SVN_ERR_FS_REP_BEING_WRITTEN.  In that case, set *MAY_WAIT to TRUE if
+   the lock is held by another thread or process, such that the caller
+   may wait for it to be released, and to FALSE otherwise.  MAY_WAIT may
+   be NULL.
 
    Perform all allocations in POOL. */
 static svn_error_t *
 get_writable_proto_rev(apr_file_t **file,
                        void **lockcookie,
+                       svn_boolean_t *may_wait,
                        svn_fs_t *fs,
                        const svn_fs_fs__id_part_t *txn_id,
                        apr_pool_t *pool)
@@ -436,6 +465,9 @@ get_writable_proto_rev(apr_file_t **file,
 
   b.lockcookie = lockcookie;
   b.txn_id = *txn_id;
+  b.may_wait = may_wait;
+  if (may_wait)
+    *may_wait = FALSE;
 
   SVN_ERR(with_txnlist_lock(fs, get_writable_proto_rev_body, &b, pool));
 
@@ -475,6 +507,40 @@ get_writable_proto_rev(apr_file_t **file,
   return svn_error_trace(err);
 }
 
+/* Longest time to sleep between two attempts to lock a proto-rev file. */
+#define MAX_PROTO_REV_RETRY_DELAY 25000
+
+/* Like get_writable_proto_rev() but if the prototype revision file is
+   locked by another thread or process, wait until we get the lock.
+
+   Perform all allocations in POOL. */
+static svn_error_t *
+wait_for_writable_proto_rev(apr_file_t **file,
+                            void **lockcookie,
+                            svn_fs_t *fs,
+                            const svn_fs_fs__id_part_t *txn_id,
+                            apr_pool_t *pool)
+{
+  apr_interval_time_t delay = 1000;
+
+  while (TRUE)
+    {
+      svn_boolean_t may_wait;
+      svn_error_t *err = get_writable_proto_rev(file, lockcookie, &may_wait,
+                                                fs, txn_id, pool);
+
+      if (!err || err->apr_err != SVN_ERR_FS_REP_BEING_WRITTEN || !may_wait)
+        return svn_error_trace(err);
+
+      /* Other writers only hold the lock while appending a segment or
+         streaming a single representation. */
+      svn_error_clear(err);
+      apr_sleep(delay);
+      if (delay < MAX_PROTO_REV_RETRY_DELAY)
+        delay *= 2;
+    }
+}
+
 /* Callback used in the implementation of purge_shared_txn(). */
 static svn_error_t *
 purge_shared_txn_body(svn_fs_t *fs, const void *baton, apr_pool_t *pool)
@@ -571,9 +637,13 @@ store_sha1_rep_mapping(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* Write DIRENT as a hash dump entry to STREAM.  If WRITTEN is not NULL,
+   set *WRITTEN to the number of bytes written.
+   Perform temporary allocations in POOL. */
 static svn_error_t *
 unparse_dir_entry(svn_fs_dirent_t *dirent,
                   svn_stream_t *stream,
+                  apr_size_t *written,
                   apr_pool_t *pool)
 {
   apr_size_t to_write;
@@ -632,6 +702,9 @@ unparse_dir_entry(svn_fs_dirent_t *dirent,
   /* Add the entry to the output stream. */
   to_write = p - buffer;
   SVN_ERR(svn_stream_write(stream, buffer, &to_write));
+  if (written)
+    *written = to_write;
+
   return SVN_NO_ERROR;
 }
 
@@ -650,7 +723,7 @@ unparse_dir_entries(apr_array_header_t *entries,
 
       svn_pool_clear(iterpool);
       dirent = APR_ARRAY_IDX(entries, i, svn_fs_dirent_t *);
-      SVN_ERR(unparse_dir_entry(dirent, stream, iterpool));
+      SVN_ERR(unparse_dir_entry(dirent, stream, NULL, iterpool));
     }
 
   SVN_ERR(svn_stream_printf(stream, pool, "%s\n", SVN_HASH_TERMINATOR));
@@ -1641,7 +1714,7 @@ svn_fs_fs__set_entry(svn_fs_t *fs,
       entry.id = id;
       entry.kind = kind;
 
-      SVN_ERR(unparse_dir_entry(&entry, out, subpool));
+      SVN_ERR(unparse_dir_entry(&entry, out, NULL, subpool));
     }
   else
     {
@@ -1935,12 +2008,24 @@ struct rep_write_baton
      writing to it. */
   void *lockcookie;
 
+  /* Set while FILE is a private segment file rather than the proto-rev
+     file.  LOCKCOOKIE is NULL in that case. */
+  svn_boolean_t in_segment;
+
   svn_checksum_ctx_t *md5_checksum_ctx;
   svn_checksum_ctx_t *sha1_checksum_ctx;
 
   /* calculate a modified FNV-1a checksum of the on-disk representation */
   svn_checksum_ctx_t *fnv1a_checksum_ctx;
 
+  /* The delta base chosen by choose_delta_base().  NULL for self-deltas
+     and PLAIN reps. */
+  representation_t *base_rep;
+
+  /* Fingerprint of the fulltext written so far.  NULL unless we shall
+     look for more similar delta bases than BASE_REP. */
+  svn_fs_fs__sketch_t *sketch;
+
   /* Local / scratch pool, available for temporary allocations. */
   apr_pool_t *scratch_pool;
 
@@ -1962,6 +2047,9 @@ rep_write_contents(void *baton,
   SVN_ERR(svn_checksum_update(b->sha1_checksum_ctx, data, *len));
   b->rep_size += *len;
 
+  if (b->sketch)
+    svn_fs_fs__sketch_update(b->sketch, data, *len);
+
   /* If we are writing a delta, use that stream. */
   if (b->delta_stream)
     return svn_stream_write(b->delta_stream, data, len);
@@ -2005,6 +2093,50 @@ shards_spanned(int *spanned,
   return SVN_NO_ERROR;
 }
 
+/* Reset *REP to NULL if it is not suitable as a delta base in FS, e.g.
+   because it is very short or its own delta chain is already too long.
+   Use POOL for temporary allocations. */
+static svn_error_t *
+check_delta_base(representation_t **rep,
+                 svn_fs_t *fs,
+                 apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  int chain_length = 0;
+  int shard_count = 0;
+
+  /* Very short rep bases are simply not worth it as we are unlikely
+   * to re-coup the deltification space overhead of 20+ bytes. */
+  svn_filesize_t rep_size = (*rep)->expanded_size;
+  if (rep_size < 64)
+    {
+      *rep = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  /* Check whether the length of the deltification chain is acceptable.
+   * Otherwise, shared reps may form a non-skipping delta chain in
+   * extreme cases. */
+  SVN_ERR(svn_fs_fs__rep_chain_length(&chain_length, &shard_count,
+                                      *rep, fs, pool));
+
+  /* Some reasonable limit, depending on how acceptable longer linear
+   * chains are in this repo.  Also, allow for some minimal chain. */
+  if (chain_length >= 2 * (int)ffd->max_linear_deltification + 2)
+    *rep = NULL;
+  else
+    /* To make it worth opening additional shards / pack files, we
+     * require that the reps have a certain minimal size.  To deltify
+     * against a rep in different shard, the lower limit is 512 bytes
+     * and doubles with every extra shard to visit along the delta
+     * chain. */
+    if (   shard_count > 1
+        && ((svn_filesize_t)128 << shard_count) >= rep_size)
+      *rep = NULL;
+
+  return SVN_NO_ERROR;
+}
+
 /* Given a node-revision NODEREV in filesystem FS, return the
    representation in *REP to use as the base for a text representation
    delta if PROPS is FALSE.  If PROPS has been set, a suitable props
@@ -2089,39 +2221,7 @@ choose_delta_base(representation_t **rep,
   /* if we encountered a shared rep, its parent chain may be different
    * from the node-rev parent chain. */
   if (*rep)
-    {
-      int chain_length = 0;
-      int shard_count = 0;
-
-      /* Very short rep bases are simply not worth it as we are unlikely
-       * to re-coup the deltification space overhead of 20+ bytes. */
-      svn_filesize_t rep_size = (*rep)->expanded_size;
-      if (rep_size < 64)
-        {
-          *rep = NULL;
-          return SVN_NO_ERROR;
-        }
-
-      /* Check whether the length of the deltification chain is acceptable.
-       * Otherwise, shared reps may form a non-skipping delta chain in
-       * extreme cases. */
-      SVN_ERR(svn_fs_fs__rep_chain_length(&chain_length, &shard_count,
-                                          *rep, fs, pool));
-
-      /* Some reasonable limit, depending on how acceptable longer linear
-       * chains are in this repo.  Also, allow for some minimal chain. */
-      if (chain_length >= 2 * (int)ffd->max_linear_deltification + 2)
-        *rep = NULL;
-      else
-        /* To make it worth opening additional shards / pack files, we
-         * require that the reps have a certain minimal size.  To deltify
-         * against a rep in different shard, the lower limit is 512 bytes
-         * and doubles with every extra shard to visit along the delta
-         * chain. */
-        if (   shard_count > 1
-            && ((svn_filesize_t)128 << shard_count) >= rep_size)
-          *rep = NULL;
-    }
+    SVN_ERR(check_delta_base(rep, fs, pool));
 
   return SVN_NO_ERROR;
 }
@@ -2144,11 +2244,13 @@ rep_write_cleanup(void *data)
   /* Remove our lock regardless of any preceding errors so that the
      being_written flag is always removed and stays consistent with the
      file lock which will be removed no matter what since the pool is
-     going away. */
-  err = svn_error_compose_create(err,
-                                 unlock_proto_rev(b->fs,
-                                     svn_fs_fs__id_txn_id(b->noderev->id),
-                                     b->lockcookie, b->scratch_pool));
+     going away.  Segment files get removed with the pool and have no
+     lock to release. */
+  if (!b->in_segment)
+    err = svn_error_compose_create(err,
+                                   unlock_proto_rev(b->fs,
+                                       svn_fs_fs__id_txn_id(b->noderev->id),
+                                       b->lockcookie, b->scratch_pool));
   if (err)
     {
       apr_status_t rc = err->apr_err;
@@ -2159,17 +2261,27 @@ rep_write_cleanup(void *data)
   return APR_SUCCESS;
 }
 
-static void
+/* Return in *HANDLER and *HANDLER_BATON a window handler that writes
+   svndiff to OUTPUT, using the svndiff version and compression configured
+   for FS.  If THREAD_COUNT > 1, compress the windows in that many worker
+   threads.  Allocate the result in POOL. */
+static svn_error_t *
 txdelta_to_svndiff(svn_txdelta_window_handler_t *handler,
                    void **handler_baton,
                    svn_stream_t *output,
                    svn_fs_t *fs,
+                   int thread_count,
                    apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
   int svndiff_version;
 
-  if (ffd->delta_compression_type == compression_type_lz4)
+  if (ffd->delta_compression_type == compression_type_zstd)
+    {
+      SVN_ERR_ASSERT_NO_RETURN(ffd->format >= SVN_FS_FS__MIN_SVNDIFF3_FORMAT);
+      svndiff_version = 3;
+    }
+  else if (ffd->delta_compression_type == compression_type_lz4)
     {
       SVN_ERR_ASSERT_NO_RETURN(ffd->format >= SVN_FS_FS__MIN_SVNDIFF2_FORMAT);
       svndiff_version = 2;
@@ -2184,27 +2296,35 @@ txdelta_to_svndiff(svn_txdelta_window_handler_t *handler,
       svndiff_version = 0;
     }
 
-  svn_txdelta_to_svndiff3(handler, handler_baton, output, svndiff_version,
-                          ffd->delta_compression_level, pool);
+  return svn_error_trace(
+           svn_txdelta__to_svndiff_parallel(handler, handler_baton, output,
+                                            svndiff_version,
+                                            ffd->delta_compression_level,
+                                            thread_count, pool));
 }
 
 /* Get a rep_write_baton and store it in *WB_P for the representation
-   indicated by NODEREV in filesystem FS.  Perform allocations in
-   POOL.  Only appropriate for file contents, not for props or
-   directory contents. */
+   indicated by NODEREV in filesystem FS.  Open the proto-rev file but
+   don't write anything to it, yet.
+
+   If another thread or process is currently writing to the proto-rev
+   file, open a new segment file in the transaction directory instead.
+   The representation will be streamed into that file, such that
+   concurrent writers don't block each other, and rep_write_contents_close()
+   will append it to the proto-rev file.
+
+   Perform allocations in POOL. */
 static svn_error_t *
-rep_write_get_baton(struct rep_write_baton **wb_p,
-                    svn_fs_t *fs,
-                    node_revision_t *noderev,
-                    apr_pool_t *pool)
+rep_write_open(struct rep_write_baton **wb_p,
+               svn_fs_t *fs,
+               node_revision_t *noderev,
+               apr_pool_t *pool)
 {
   struct rep_write_baton *b;
   apr_file_t *file;
-  representation_t *base_rep;
-  svn_stream_t *source;
-  svn_txdelta_window_handler_t wh;
-  void *whb;
-  svn_fs_fs__rep_header_t header = { 0 };
+  const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__id_txn_id(noderev->id);
+  svn_boolean_t may_wait;
+  svn_error_t *err;
 
   b = apr_pcalloc(pool, sizeof(*b));
 
@@ -2218,9 +2338,21 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
   b->noderev = noderev;
 
   /* Open the prototype rev file and seek to its end. */
-  SVN_ERR(get_writable_proto_rev(&file, &b->lockcookie,
-                                 fs, svn_fs_fs__id_txn_id(noderev->id),
-                                 b->scratch_pool));
+  err = get_writable_proto_rev(&file, &b->lockcookie, &may_wait,
+                               fs, txn_id, b->scratch_pool);
+  if (err && err->apr_err == SVN_ERR_FS_REP_BEING_WRITTEN && may_wait)
+    {
+      svn_error_clear(err);
+      SVN_ERR(svn_io_open_unique_file3(&file, NULL,
+                                       svn_fs_fs__path_txn_dir(fs, txn_id,
+                                                          b->scratch_pool),
+                                       svn_io_file_del_on_pool_cleanup,
+                                       b->scratch_pool, b->scratch_pool));
+      b->lockcookie = NULL;
+      b->in_segment = TRUE;
+    }
+  else
+    SVN_ERR(err);
 
   b->file = file;
   b->rep_stream = svn_stream_from_aprfile2(file, TRUE, b->scratch_pool);
@@ -2230,11 +2362,57 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
 
   SVN_ERR(svn_io_file_get_offset(&b->rep_offset, file, b->scratch_pool));
 
+  *wb_p = b;
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the representation header for B, which must have been returned
+   by rep_write_open(), and prepare B for receiving the fulltext through
+   rep_write_contents().  The fulltext will be deltified against the base
+   that choose_delta_base() selects.  Perform allocations in POOL. */
+static svn_error_t *
+rep_write_start(struct rep_write_baton *b,
+                apr_pool_t *pool)
+{
+  svn_fs_t *fs = b->fs;
+  fs_fs_data_t *ffd = fs->fsap_data;
+  apr_file_t *file = b->file;
+  representation_t *base_rep;
+  svn_stream_t *source;
+  svn_txdelta_window_handler_t wh;
+  void *whb;
+  svn_fs_fs__rep_header_t header = { 0 };
+
+  /* Without deltification, write the contents verbatim. */
+  if (!ffd->deltify_files)
+    {
+      header.type = svn_fs_fs__rep_plain;
+      SVN_ERR(svn_fs_fs__write_rep_header(&header, b->rep_stream,
+                                          b->scratch_pool));
+      SVN_ERR(svn_io_file_get_offset(&b->delta_start, file,
+                                     b->scratch_pool));
+
+      /* Cleanup in case something goes wrong. */
+      apr_pool_cleanup_register(b->scratch_pool, b, rep_write_cleanup,
+                                apr_pool_cleanup_null);
+
+      /* rep_write_contents() will write to REP_STREAM directly. */
+      return SVN_NO_ERROR;
+    }
+
   /* Get the base for this delta. */
-  SVN_ERR(choose_delta_base(&base_rep, fs, noderev, FALSE, b->scratch_pool));
+  SVN_ERR(choose_delta_base(&base_rep, fs, b->noderev, FALSE,
+                            b->scratch_pool));
   SVN_ERR(svn_fs_fs__get_contents(&source, fs, base_rep, TRUE,
                                   b->scratch_pool));
 
+  /* Fingerprint the fulltext to later look for better bases. */
+  b->base_rep = base_rep;
+  b->sketch = base_rep && ffd->similar_delta_bases
+            ? svn_fs_fs__sketch_create(b->scratch_pool)
+            : NULL;
+
   /* Write out the rep header. */
   if (base_rep)
     {
@@ -2259,12 +2437,28 @@ rep_write_get_baton(struct rep_write_baton **wb_p,
                             apr_pool_cleanup_null);
 
   /* Prepare to write the svndiff data. */
-  txdelta_to_svndiff(&wh, &whb, b->rep_stream, fs, pool);
+  SVN_ERR(txdelta_to_svndiff(&wh, &whb, b->rep_stream, fs,
+                             ffd->delta_compression_threads, pool));
 
-  b->delta_stream = svn_txdelta_target_push(wh, whb, source,
-                                            b->scratch_pool);
+  b->delta_stream = svn_txdelta_target_push2(wh, whb, source,
+                                             ffd->track_delta_source,
+                                             b->scratch_pool);
 
-  *wb_p = b;
+  return SVN_NO_ERROR;
+}
+
+/* Get a rep_write_baton and store it in *WB_P for the representation
+   indicated by NODEREV in filesystem FS.  Perform allocations in
+   POOL.  Only appropriate for file contents, not for props or
+   directory contents. */
+static svn_error_t *
+rep_write_get_baton(struct rep_write_baton **wb_p,
+                    svn_fs_t *fs,
+                    node_revision_t *noderev,
+                    apr_pool_t *pool)
+{
+  SVN_ERR(rep_write_open(wb_p, fs, noderev, pool));
+  SVN_ERR(rep_write_start(*wb_p, pool));
 
   return SVN_NO_ERROR;
 }
@@ -2483,6 +2677,316 @@ get_shared_rep(representation_t **old_rep,
   return SVN_NO_ERROR;
 }
 
+/* Representations up to this size in the proto-rev file are not worth
+   being replaced by a reference into the group store. */
+#define GROUP_REP_MIN_SIZE 64
+
+/* For REP->SHA1_CHECKSUM, try to find an existing representation in the
+   group store of FS and return it in *GROUP_REP.  If FS has no group
+   store, if rep sharing has been disabled for either of them or if no
+   such representation exists, NULL will be returned.
+
+   Just as in get_shared_rep(), the contents of both representations will
+   be compared, taking REP's content from FILE at OFFSET.  Because storing
+   the contents locally is always a safe option, problems with the group
+   store are reported as warnings only.
+
+   Use RESULT_POOL for *GROUP_REP allocations and SCRATCH_POOL for
+   temporaries.
+ */
+static svn_error_t *
+get_group_rep(representation_t **group_rep,
+              svn_fs_t *fs,
+              representation_t *rep,
+              apr_file_t *file,
+              apr_off_t offset,
+              apr_pool_t *result_pool,
+              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_fs_t *group_store;
+  representation_t *candidate = NULL;
+  svn_checksum_t checksum;
+  apr_off_t old_position;
+  svn_stream_t *contents;
+  svn_stream_t *group_contents;
+  svn_boolean_t same = FALSE;
+  svn_error_t *err;
+
+  *group_rep = NULL;
+
+  if (   !ffd->rep_sharing_allowed
+      || !ffd->group_store_path
+      || !rep->has_sha1
+      || rep->size <= GROUP_REP_MIN_SIZE)
+    return SVN_NO_ERROR;
+
+  checksum.digest = rep->sha1_digest;
+  checksum.kind = svn_checksum_sha1;
+
+  err = svn_fs_fs__get_group_store(&group_store, fs, scratch_pool);
+  if (!err)
+    {
+      fs_fs_data_t *group_ffd = group_store->fsap_data;
+      if (group_ffd->rep_sharing_allowed)
+        err = svn_fs_fs__get_rep_reference(&candidate, group_store,
+                                           &checksum, scratch_pool);
+    }
+
+  if (!err && candidate && candidate->expanded_size == rep->expanded_size)
+    {
+      /* Make sure we can later restore FILE's current position. */
+      SVN_ERR(svn_io_file_get_offset(&old_position, file, scratch_pool));
+
+      SVN_ERR(svn_fs_fs__get_contents_from_file(&contents, fs, rep, file,
+                                                offset, scratch_pool));
+      err = svn_fs_fs__get_contents(&group_contents, group_store, candidate,
+                                    FALSE, scratch_pool);
+      if (!err)
+        err = svn_stream_contents_same2(&same, contents, group_contents,
+                                        scratch_pool);
+      if (!err && !same)
+        err = svn_error_createf(SVN_ERR_FS_AMBIGUOUS_CHECKSUM_REP, NULL,
+                                "SHA1 %s matches a rep in the group store "
+                                "but the contents differ",
+                                svn_checksum_to_cstring_display(&checksum,
+                                                              scratch_pool));
+
+      SVN_ERR(svn_io_file_seek(file, APR_SET, &old_position, scratch_pool));
+    }
+
+  if (err)
+    {
+      /* Make the problem show up in the server log. */
+      (fs->warning)(fs->warning_baton, err);
+      svn_error_clear(err);
+    }
+  else if (same)
+    {
+      *group_rep = apr_pmemdup(result_pool, candidate, sizeof(*candidate));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Discard everything written through B so far and prepare B->REP_STREAM
+   for writing a replacement.  The low-level checksum will only cover the
+   replacement.
+ */
+static svn_error_t *
+restart_rep_stream(struct rep_write_baton *b)
+{
+  apr_off_t offset = b->rep_offset;
+
+  SVN_ERR(svn_io_file_trunc(b->file, b->rep_offset, b->scratch_pool));
+  SVN_ERR(svn_io_file_seek(b->file, APR_SET, &offset, b->scratch_pool));
+
+  b->rep_stream = svn_stream_from_aprfile2(b->file, TRUE, b->scratch_pool);
+  if (svn_fs_fs__use_log_addressing(b->fs))
+    b->rep_stream = fnv1a_wrap_stream(&b->fnv1a_checksum_ctx, b->rep_stream,
+                                      b->scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Replace the representation data written through B by a reference to
+   GROUP_REP in the group store and update REP accordingly.  The caller
+   still needs to write the end marker.
+ */
+static svn_error_t *
+write_group_reference(struct rep_write_baton *b,
+                      representation_t *rep,
+                      const representation_t *group_rep)
+{
+  svn_fs_fs__rep_header_t header = { 0 };
+
+  SVN_ERR(restart_rep_stream(b));
+
+  header.type = svn_fs_fs__rep_shared;
+  header.base_revision = group_rep->revision;
+  header.base_item_index = group_rep->item_index;
+  header.base_length = group_rep->size;
+  SVN_ERR(svn_fs_fs__write_rep_header(&header, b->rep_stream,
+                                      b->scratch_pool));
+
+  /* The reference has no data of its own. */
+  rep->size = 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Number of recent versions of a file that we compare with its new
+   contents if similar_delta_bases has been enabled. */
+#define SIMILAR_BASE_CANDIDATES 4
+
+/* A candidate must be this many percentage points more similar to the
+   new contents than the regular delta base to be worth a second delta. */
+#define SIMILAR_BASE_MIN_GAIN 10
+
+/* Return in *BEST the data rep of one of the last few predecessors of
+   B->NODEREV that is most similar to the contents written through B,
+   according to B->SKETCH.  Set *BEST to NULL if none of them is
+   significantly more similar than B->BASE_REP or acceptable as a delta
+   base.  Allocate *BEST in RESULT_POOL and use SCRATCH_POOL for
+   temporary allocations.
+ */
+static svn_error_t *
+find_similar_base(representation_t **best,
+                  struct rep_write_baton *b,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = b->fs->fsap_data;
+  node_revision_t *noderev = b->noderev;
+  apr_array_header_t *seen
+    = apr_array_make(scratch_pool, SIMILAR_BASE_CANDIDATES + 1,
+                     sizeof(representation_t *));
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_fs_fs__sketch_t *sketch;
+  svn_stream_t *contents;
+  int best_similarity;
+  int i;
+
+  *best = NULL;
+
+  /* The regular delta base sets the bar. */
+  SVN_ERR(svn_fs_fs__get_contents(&contents, b->fs, b->base_rep, TRUE,
+                                  scratch_pool));
+  SVN_ERR(svn_fs_fs__sketch_stream(&sketch, contents, scratch_pool,
+                                   scratch_pool));
+  SVN_ERR(svn_stream_close(contents));
+  best_similarity = svn_fs_fs__sketch_similarity(b->sketch, sketch)
+                  + SIMILAR_BASE_MIN_GAIN;
+  APR_ARRAY_PUSH(seen, representation_t *) = b->base_rep;
+
+  /* Deltifying against a predecessor beyond max-deltification-walk would
+     defeat the purpose of that limit. */
+  for (i = 1;
+       i <= SIMILAR_BASE_CANDIDATES
+         && i <= ffd->max_deltification_walk
+         && noderev->predecessor_id;
+       ++i)
+    {
+      representation_t *candidate;
+      int similarity;
+      int k;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_fs__get_node_revision(&noderev, b->fs,
+                                           noderev->predecessor_id,
+                                           scratch_pool, iterpool));
+
+      /* Alternating contents tend to share reps. */
+      candidate = noderev->data_rep;
+      for (k = 0; candidate && k < seen->nelts; ++k)
+        if (svn_fs_fs__noderev_same_rep_key(candidate,
+                                APR_ARRAY_IDX(seen, k, representation_t *)))
+          candidate = NULL;
+
+      if (!candidate)
+        continue;
+
+      APR_ARRAY_PUSH(seen, representation_t *) = candidate;
+      SVN_ERR(check_delta_base(&candidate, b->fs, iterpool));
+      if (!candidate)
+        continue;
+
+      SVN_ERR(svn_fs_fs__get_contents(&contents, b->fs, candidate, TRUE,
+                                      iterpool));
+      SVN_ERR(svn_fs_fs__sketch_stream(&sketch, contents, iterpool,
+                                       iterpool));
+      SVN_ERR(svn_stream_close(contents));
+
+      similarity = svn_fs_fs__sketch_similarity(b->sketch, sketch);
+      if (similarity > best_similarity)
+        {
+          best_similarity = similarity;
+          *best = apr_pmemdup(result_pool, candidate, sizeof(*candidate));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* If B->SKETCH suggests that one of the recent versions of the file makes
+   a better delta base than B->BASE_REP, deltify the contents of REP just
+   written through B against that version.  If the result is smaller,
+   replace the stored delta with it and update REP accordingly.  The
+   caller still needs to write the end marker.  Use SCRATCH_POOL for
+   temporary allocations.
+ */
+static svn_error_t *
+try_similar_base(struct rep_write_baton *b,
+                 representation_t *rep,
+                 apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = b->fs->fsap_data;
+  representation_t *base_rep;
+  svn_stream_t *source;
+  svn_stream_t *target;
+  svn_stream_t *svndiff;
+  const char *svndiff_path;
+  svn_txdelta_window_handler_t wh;
+  void *whb;
+  apr_finfo_t finfo;
+  apr_off_t old_position;
+  svn_fs_fs__rep_header_t header = { 0 };
+
+  SVN_ERR(find_similar_base(&base_rep, b, scratch_pool, scratch_pool));
+  if (!base_rep)
+    return SVN_NO_ERROR;
+
+  /* Make sure we can later restore FILE's current position. */
+  SVN_ERR(svn_io_file_get_offset(&old_position, b->file, scratch_pool));
+
+  /* Deltify the fulltext that we just stored into a temporary file. */
+  SVN_ERR(svn_stream_open_unique(&svndiff, &svndiff_path,
+                                 svn_fs_fs__path_txn_dir(b->fs, &rep->txn_id,
+                                                         scratch_pool),
+                                 svn_io_file_del_on_pool_cleanup,
+                                 scratch_pool, scratch_pool));
+  SVN_ERR(txdelta_to_svndiff(&wh, &whb, svndiff, b->fs,
+                             ffd->delta_compression_threads, scratch_pool));
+
+  SVN_ERR(svn_fs_fs__get_contents(&source, b->fs, base_rep, TRUE,
+                                  scratch_pool));
+  SVN_ERR(svn_fs_fs__get_contents_from_file(&target, b->fs, rep, b->file,
+                                            b->rep_offset, scratch_pool));
+  SVN_ERR(svn_stream_copy3(target,
+                           svn_txdelta_target_push2(wh, whb, source,
+                                                    ffd->track_delta_source,
+                                                    scratch_pool),
+                           NULL, NULL, scratch_pool));
+
+  SVN_ERR(svn_io_stat(&finfo, svndiff_path, APR_FINFO_SIZE, scratch_pool));
+  if (finfo.size >= rep->size)
+    return svn_error_trace(svn_io_file_seek(b->file, APR_SET, &old_position,
+                                            scratch_pool));
+
+  /* Replace the stored delta with the smaller one. */
+  SVN_ERR(restart_rep_stream(b));
+
+  header.type = svn_fs_fs__rep_delta;
+  header.base_revision = base_rep->revision;
+  header.base_item_index = base_rep->item_index;
+  header.base_length = base_rep->size;
+  SVN_ERR(svn_fs_fs__write_rep_header(&header, b->rep_stream,
+                                      scratch_pool));
+  SVN_ERR(svn_io_file_get_offset(&b->delta_start, b->file, scratch_pool));
+
+  SVN_ERR(svn_stream_open_readonly(&svndiff, svndiff_path, scratch_pool,
+                                   scratch_pool));
+  SVN_ERR(svn_stream_copy3(svndiff,
+                           svn_stream_disown(b->rep_stream, scratch_pool),
+                           NULL, NULL, scratch_pool));
+
+  rep->size = finfo.size;
+
+  return SVN_NO_ERROR;
+}
+
 /* Copy the hash sum calculation results from MD5_CTX, SHA1_CTX into REP.
  * SHA1 results are only be set if SHA1_CTX is not NULL.
  * Use POOL for allocations.
@@ -2507,6 +3011,51 @@ digests_final(representation_t *rep,
   return SVN_NO_ERROR;
 }
 
+/* Append the representation that B has written to its segment file to
+   the end of the proto-rev file, waiting for other writers to release
+   the latter.  Continue with B as if the representation had been written
+   to the proto-rev file directly. */
+static svn_error_t *
+append_segment(struct rep_write_baton *b)
+{
+  const svn_fs_fs__id_part_t *txn_id = svn_fs_fs__id_txn_id(b->noderev->id);
+  apr_file_t *segment = b->file;
+  apr_file_t *proto_file;
+  void *lockcookie;
+  apr_off_t offset = 0;
+  svn_error_t *err;
+
+  SVN_ERR(svn_io_file_seek(segment, APR_SET, &offset, b->scratch_pool));
+  SVN_ERR(wait_for_writable_proto_rev(&proto_file, &lockcookie, b->fs,
+                                      txn_id, b->scratch_pool));
+
+  err = svn_io_file_get_offset(&offset, proto_file, b->scratch_pool);
+  if (err)
+    {
+      err = svn_error_compose_create(err, svn_io_file_close(proto_file,
+                                                            b->scratch_pool));
+      return svn_error_compose_create(err,
+                                      unlock_proto_rev(b->fs, txn_id,
+                                                       lockcookie,
+                                                       b->scratch_pool));
+    }
+
+  /* From here on, rep_write_cleanup() takes care of the proto-rev file. */
+  b->file = proto_file;
+  b->lockcookie = lockcookie;
+  b->rep_offset = offset;
+  b->in_segment = FALSE;
+
+  SVN_ERR(svn_stream_copy3(svn_stream_from_aprfile2(segment, TRUE,
+                                                    b->scratch_pool),
+                           svn_stream_from_aprfile2(proto_file, TRUE,
+                                                    b->scratch_pool),
+                           NULL, NULL, b->scratch_pool));
+
+  /* The segment file gets removed together with B->SCRATCH_POOL. */
+  return svn_error_trace(svn_io_file_close(segment, b->scratch_pool));
+}
+
 /* Close handler for the representation write stream.  BATON is a
    rep_write_baton.  Writes out a new node-rev that correctly
    references the representation we just finished writing. */
@@ -2554,8 +3103,24 @@ rep_write_contents_close(void *baton)
     }
   else
     {
+      representation_t *group_rep;
+
+      /* Other repositories of the same group may have that content. */
+      SVN_ERR(get_group_rep(&group_rep, b->fs, rep, b->file, b->rep_offset,
+                            b->scratch_pool, b->scratch_pool));
+      if (group_rep)
+        SVN_ERR(write_group_reference(b, rep, group_rep));
+      else if (b->sketch)
+        SVN_ERR(try_similar_base(b, rep, b->scratch_pool));
+
       /* Write out our cosmetic end marker. */
       SVN_ERR(svn_stream_puts(b->rep_stream, "ENDREP\n"));
+
+      /* The representation data does not depend on its position, so we
+         can simply move it from our segment to the proto-rev file. */
+      if (b->in_segment)
+        SVN_ERR(append_segment(b));
+
       SVN_ERR(allocate_item_index(&rep->item_index, b->fs, &rep->txn_id,
                                   b->rep_offset, b->scratch_pool));
 
@@ -2593,8 +3158,9 @@ rep_write_contents_close(void *baton)
   if (!old_rep)
     SVN_ERR(store_sha1_rep_mapping(b->fs, b->noderev, b->scratch_pool));
 
-  SVN_ERR(unlock_proto_rev(b->fs, &rep->txn_id, b->lockcookie,
-                           b->scratch_pool));
+  if (!b->in_segment)
+    SVN_ERR(unlock_proto_rev(b->fs, &rep->txn_id, b->lockcookie,
+                             b->scratch_pool));
   svn_pool_destroy(b->scratch_pool);
 
   return SVN_NO_ERROR;
@@ -2640,6 +3206,257 @@ svn_fs_fs__set_contents(svn_stream_t **stream,
   return set_representation(stream, fs, noderev, pool);
 }
 
+/* Baton for the window handler returned by svn_fs_fs__set_contents_delta().
+ */
+typedef struct delta_write_baton_t
+{
+  /* The representation being written. */
+  struct rep_write_baton *rep;
+
+  /* Representation that the incoming windows apply to. */
+  representation_t *source_rep;
+
+  /* Encodes the incoming windows into REP's proto-rev file. */
+  svn_txdelta_window_handler_t svndiff_handler;
+  void *svndiff_baton;
+
+  /* Reconstructs the fulltext and sends it to a stream that only updates
+     the checksums and size of REP. */
+  svn_txdelta_window_handler_t apply_handler;
+  void *apply_baton;
+
+  /* Size of the fulltext covered by the windows that we stored. */
+  svn_filesize_t target_offset;
+
+  /* Set after we stored a window shorter than SVN_DELTA_WINDOW_SIZE. */
+  svn_boolean_t got_last_window;
+
+  /* If the incoming windows turned out to be unsuitable for storing them
+     directly, reconstruct the fulltext with this handler and write it to
+     REP through rep_write_contents() as usual.  NULL until then. */
+  svn_txdelta_window_handler_t fallback_handler;
+  void *fallback_baton;
+
+  /* Pool for the handlers above. */
+  apr_pool_t *pool;
+} delta_write_baton_t;
+
+/* Implements svn_write_fn_t.  Like rep_write_contents() but only
+   calculate the checksums and size of the fulltext in the
+   rep_write_baton BATON without writing any data. */
+static svn_error_t *
+rep_write_checksums(void *baton,
+                    const char *data,
+                    apr_size_t *len)
+{
+  struct rep_write_baton *b = baton;
+
+  SVN_ERR(svn_checksum_update(b->md5_checksum_ctx, data, *len));
+  SVN_ERR(svn_checksum_update(b->sha1_checksum_ctx, data, *len));
+  b->rep_size += *len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if the representation reader can combine WINDOW with the
+   windows of its delta base, i.e. if WINDOW is laid out as if
+   svn_txdelta_target_push2() had created it without source tracking.
+   B tells us what came before WINDOW. */
+static svn_boolean_t
+is_aligned_window(const delta_write_baton_t *b,
+                  const svn_txdelta_window_t *window)
+{
+  /* Only the last window may be shorter than usual. */
+  if (b->got_last_window || window->tview_len > SVN_DELTA_WINDOW_SIZE)
+    return FALSE;
+
+  /* Windows that don't need the source can't be misaligned. */
+  if (window->sview_len == 0 || window->src_ops == 0)
+    return TRUE;
+
+  return window->sview_len <= SVN_DELTA_WINDOW_SIZE
+      && window->sview_offset == b->target_offset;
+}
+
+/* Discard the data stored for the delta representation being written by
+   B so far and write the fulltext through rep_write_contents() instead.
+   Reconstruct the part of the fulltext covered by the windows already
+   seen from the stored svndiff data.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+fall_back_to_fulltext(delta_write_baton_t *b,
+                      apr_pool_t *scratch_pool)
+{
+  struct rep_write_baton *rb = b->rep;
+  svn_stream_t *source;
+  svn_stream_t *target;
+  svn_stream_t *parser;
+  svn_stringbuf_t *svndiff;
+  apr_off_t offset;
+  apr_size_t len;
+
+  /* Read the svndiff data for the windows we stored so far. */
+  SVN_ERR(svn_io_file_get_offset(&offset, rb->file, scratch_pool));
+  len = (apr_size_t)(offset - rb->delta_start);
+  svndiff = svn_stringbuf_create_ensure(len, scratch_pool);
+  SVN_ERR(svn_io_file_seek(rb->file, APR_SET, &rb->delta_start,
+                           scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(rb->file, svndiff->data, len,
+                                 &svndiff->len, NULL, scratch_pool));
+  svndiff->data[svndiff->len] = '\0';
+
+  /* Remove the representation from the proto-rev file and start over. */
+  apr_pool_cleanup_kill(rb->scratch_pool, rb, rep_write_cleanup);
+  SVN_ERR(svn_io_file_trunc(rb->file, rb->rep_offset, scratch_pool));
+  offset = rb->rep_offset;
+  SVN_ERR(svn_io_file_seek(rb->file, APR_SET, &offset, scratch_pool));
+
+  rb->md5_checksum_ctx = svn_checksum_ctx_create(svn_checksum_md5,
+                                                 rb->result_pool);
+  rb->sha1_checksum_ctx = svn_checksum_ctx_create(svn_checksum_sha1,
+                                                  rb->result_pool);
+  rb->rep_size = 0;
+  rb->rep_stream = svn_stream_from_aprfile2(rb->file, TRUE,
+                                            rb->scratch_pool);
+  if (svn_fs_fs__use_log_addressing(rb->fs))
+    rb->rep_stream = fnv1a_wrap_stream(&rb->fnv1a_checksum_ctx,
+                                       rb->rep_stream, rb->scratch_pool);
+
+  SVN_ERR(rep_write_start(rb, b->pool));
+
+  /* Apply all windows to the original source and send the result through
+     the regular deltification. */
+  SVN_ERR(svn_fs_fs__get_contents(&source, rb->fs, b->source_rep, TRUE,
+                                  b->pool));
+  target = svn_stream_create(rb, b->pool);
+  svn_stream_set_write(target, rep_write_contents);
+  svn_stream_set_close(target, rep_write_contents_close);
+  svn_txdelta_apply2(source, target, NULL, NULL, b->pool,
+                     &b->fallback_handler, &b->fallback_baton);
+
+  /* Replay the windows that we already stored.  Don't close the parser
+     as that would finalize the target. */
+  parser = svn_txdelta_parse_svndiff(b->fallback_handler, b->fallback_baton,
+                                     TRUE, scratch_pool);
+  len = svndiff->len;
+  SVN_ERR(svn_stream_write(parser, svndiff->data, &len));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_txdelta_window_handler_t for delta_write_baton_t BATON.
+ */
+static svn_error_t *
+delta_write_window(svn_txdelta_window_t *window,
+                   void *baton)
+{
+  delta_write_baton_t *b = baton;
+
+  if (!b->fallback_handler && window && !is_aligned_window(b, window))
+    {
+      apr_pool_t *scratch_pool = svn_pool_create(b->pool);
+      SVN_ERR(fall_back_to_fulltext(b, scratch_pool));
+      svn_pool_destroy(scratch_pool);
+    }
+
+  /* This will close REP upon the final NULL window. */
+  if (b->fallback_handler)
+    return svn_error_trace(b->fallback_handler(window, b->fallback_baton));
+
+  SVN_ERR(b->svndiff_handler(window, b->svndiff_baton));
+  SVN_ERR(b->apply_handler(window, b->apply_baton));
+
+  if (window)
+    {
+      b->target_offset += window->tview_len;
+      if (window->tview_len < SVN_DELTA_WINDOW_SIZE)
+        b->got_last_window = TRUE;
+    }
+  else
+    {
+      SVN_ERR(rep_write_contents_close(b->rep));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_fs_fs__set_contents_delta(svn_txdelta_window_handler_t *handler,
+                              void **handler_baton,
+                              svn_fs_t *fs,
+                              node_revision_t *noderev,
+                              apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  representation_t *source_rep = noderev->data_rep;
+  representation_t *base_rep;
+  delta_write_baton_t *b;
+  struct rep_write_baton *rb;
+  svn_stream_t *source;
+  svn_stream_t *checksum_stream;
+  svn_fs_fs__rep_header_t header = { 0 };
+
+  *handler = NULL;
+  *handler_baton = NULL;
+
+  if (noderev->kind != svn_node_file)
+    return svn_error_create(SVN_ERR_FS_NOT_FILE, NULL,
+                            _("Can't set text contents of a directory"));
+
+  if (! svn_fs_fs__id_is_txn(noderev->id))
+    return svn_error_createf(SVN_ERR_FS_CORRUPT, NULL,
+                             _("Attempted to write to non-transaction '%s'"),
+                             svn_fs_fs__id_unparse(noderev->id, pool)->data);
+
+  /* The incoming delta must be against a committed representation. */
+  if (!ffd->deltify_files || !source_rep || is_txn_rep(source_rep))
+    return SVN_NO_ERROR;
+
+  /* And that must be the base that we would choose ourselves. */
+  SVN_ERR(choose_delta_base(&base_rep, fs, noderev, FALSE, pool));
+  if (   !base_rep
+      || base_rep->revision != source_rep->revision
+      || base_rep->item_index != source_rep->item_index)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(rep_write_open(&rb, fs, noderev, pool));
+
+  header.base_revision = base_rep->revision;
+  header.base_item_index = base_rep->item_index;
+  header.base_length = base_rep->size;
+  header.type = svn_fs_fs__rep_delta;
+  SVN_ERR(svn_fs_fs__write_rep_header(&header, rb->rep_stream,
+                                      rb->scratch_pool));
+  SVN_ERR(svn_io_file_get_offset(&rb->delta_start, rb->file,
+                                 rb->scratch_pool));
+
+  /* Cleanup in case something goes wrong. */
+  apr_pool_cleanup_register(rb->scratch_pool, rb, rep_write_cleanup,
+                            apr_pool_cleanup_null);
+
+  b = apr_pcalloc(pool, sizeof(*b));
+  b->rep = rb;
+  b->source_rep = apr_pmemdup(pool, source_rep, sizeof(*source_rep));
+  b->pool = pool;
+
+  /* The windows must be written as soon as they come in or we could not
+     read them back in fall_back_to_fulltext(). */
+  SVN_ERR(txdelta_to_svndiff(&b->svndiff_handler, &b->svndiff_baton,
+                             rb->rep_stream, fs, 1, pool));
+
+  /* We still need the fulltext checksums and size. */
+  SVN_ERR(svn_fs_fs__get_contents(&source, fs, source_rep, TRUE, pool));
+  checksum_stream = svn_stream_create(rb, pool);
+  svn_stream_set_write(checksum_stream, rep_write_checksums);
+  svn_txdelta_apply2(source, checksum_stream, NULL, NULL, pool,
+                     &b->apply_handler, &b->apply_baton);
+
+  *handler = delta_write_window;
+  *handler_baton = b;
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_fs_fs__create_successor(const svn_fs_id_t **new_id_p,
                             svn_fs_t *fs,
@@ -2769,6 +3586,58 @@ write_directory_to_stream(svn_stream_t *stream,
   return SVN_NO_ERROR;
 }
 
+/* Implement collection_writer_t writing the svn_fs_dirent_t* array given
+   as BATON followed by a name index, see SVN_FS_FS__DIR_INDEX_MARKER.
+   The array must be sorted by entry name. */
+static svn_error_t *
+write_indexed_directory_to_stream(svn_stream_t *stream,
+                                  void *baton,
+                                  apr_pool_t *pool)
+{
+  apr_array_header_t *dir = baton;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_off_t *offsets = apr_palloc(pool, (dir->nelts + 1) * sizeof(*offsets));
+  apr_off_t offset = 0;
+  apr_off_t index_offset;
+  apr_off_t rest;
+  int width;
+  int i;
+
+  /* The entries themselves, remembering where each one starts. */
+  for (i = 0; i < dir->nelts; ++i)
+    {
+      svn_fs_dirent_t *dirent = APR_ARRAY_IDX(dir, i, svn_fs_dirent_t *);
+      apr_size_t written;
+
+      svn_pool_clear(iterpool);
+      offsets[i] = offset;
+      SVN_ERR(unparse_dir_entry(dirent, stream, &written, iterpool));
+      offset += written;
+    }
+
+  SVN_ERR(svn_stream_printf(stream, pool, "%s\n", SVN_HASH_TERMINATOR));
+  index_offset = offset + strlen(SVN_HASH_TERMINATOR) + 1;
+
+  /* Fixed-width offsets allow for a binary search. */
+  for (width = 1, rest = offset; rest >= 10; rest /= 10)
+    ++width;
+
+  for (i = 0; i < dir->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_stream_printf(stream, iterpool, "%0*" APR_OFF_T_FMT "\n",
+                                width, offsets[i]));
+    }
+
+  SVN_ERR(svn_stream_printf(stream, pool,
+                            SVN_FS_FS__DIR_INDEX_MARKER " %d %d %"
+                            APR_OFF_T_FMT "\n",
+                            dir->nelts, width, index_offset));
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
 /* Write out the COLLECTION as a text representation to file FILE using
    WRITER.  In the process, record position, the total size of the dump and
    MD5 as well as SHA1 in REP.   Add the representation of type ITEM_TYPE to
@@ -2947,11 +3816,12 @@ write_container_delta_rep(representation_t *rep,
   SVN_ERR(svn_io_file_get_offset(&delta_start, file, scratch_pool));
 
   /* Prepare to write the svndiff data. */
-  txdelta_to_svndiff(&diff_wh, &diff_whb, file_stream, fs, scratch_pool);
+  SVN_ERR(txdelta_to_svndiff(&diff_wh, &diff_whb, file_stream, fs, 1,
+                             scratch_pool));
 
   whb = apr_pcalloc(scratch_pool, sizeof(*whb));
-  whb->stream = svn_txdelta_target_push(diff_wh, diff_whb, source,
-                                        scratch_pool);
+  whb->stream = svn_txdelta_target_push2(diff_wh, diff_whb, source, FALSE,
+                                         scratch_pool);
   whb->size = 0;
   whb->md5_ctx = svn_checksum_ctx_create(svn_checksum_md5, scratch_pool);
   if (item_type != SVN_FS_FS__ITEM_TYPE_DIR_REP)
@@ -3194,7 +4064,13 @@ write_final_rev(const svn_fs_id_t **new_id_p,
 
           /* Write out the contents of this directory as a text rep. */
           noderev->data_rep->revision = rev;
-          if (ffd->deltify_directories)
+          if (   ffd->dir_index_min_entries
+              && entries->nelts >= ffd->dir_index_min_entries)
+            SVN_ERR(write_container_rep(noderev->data_rep, file, entries,
+                                        write_indexed_directory_to_stream,
+                                        fs, NULL, FALSE,
+                                        SVN_FS_FS__ITEM_TYPE_DIR_REP, pool));
+          else if (ffd->deltify_directories)
             SVN_ERR(write_container_delta_rep(noderev->data_rep, file,
                                               entries,
                                               write_directory_to_stream,
@@ -3407,6 +4283,7 @@ write_final_changed_path_info(apr_off_t *offset_p,
                               apr_hash_t *changed_paths,
                               apr_pool_t *pool)
 {
+  fs_fs_data_t *ffd = fs->fsap_data;
   apr_off_t offset;
   svn_stream_t *stream;
   svn_checksum_ctx_t *fnv1a_checksum_ctx;
@@ -3420,7 +4297,10 @@ write_final_changed_path_info(apr_off_t *offset_p,
   else
     fnv1a_checksum_ctx = NULL;
 
-  SVN_ERR(svn_fs_fs__write_changes(stream, fs, changed_paths, TRUE, pool));
+  if (ffd->format >= SVN_FS_FS__MIN_PACKED_CHANGES_FORMAT)
+    SVN_ERR(svn_fs_fs__write_packed_changes(stream, changed_paths, pool));
+  else
+    SVN_ERR(svn_fs_fs__write_changes(stream, fs, changed_paths, TRUE, pool));
 
   *offset_p = offset;
 
@@ -3493,13 +4373,15 @@ verify_before_commit(svn_fs_t *fs,
 
 /* Update the 'current' file to hold the correct next node and copy_ids
    from transaction TXN_ID in filesystem FS.  The current revision is
-   set to REV.  Perform temporary allocations in POOL. */
+   set to REV.  Flush it to disk only if FLUSH_TO_DISK is set.
+   Perform temporary allocations in POOL. */
 static svn_error_t *
 write_final_current(svn_fs_t *fs,
                     const svn_fs_fs__id_part_t *txn_id,
                     svn_revnum_t rev,
                     apr_uint64_t start_node_id,
                     apr_uint64_t start_copy_id,
+                    svn_boolean_t flush_to_disk,
                     apr_pool_t *pool)
 {
   apr_uint64_t txn_node_id;
@@ -3507,7 +4389,7 @@ write_final_current(svn_fs_t *fs,
   fs_fs_data_t *ffd = fs->fsap_data;
 
   if (ffd->format >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT)
-    return svn_fs_fs__write_current(fs, rev, 0, 0, pool);
+    return svn_fs_fs__write_current2(fs, rev, 0, 0, flush_to_disk, pool);
 
   /* To find the next available ids, we add the id that used to be in
      the 'current' file, to the next ids from the transaction file. */
@@ -3516,8 +4398,90 @@ write_final_current(svn_fs_t *fs,
   start_node_id += txn_node_id;
   start_copy_id += txn_copy_id;
 
-  return svn_fs_fs__write_current(fs, rev, start_node_id, start_copy_id,
-                                  pool);
+  return svn_fs_fs__write_current2(fs, rev, start_node_id, start_copy_id,
+                                   flush_to_disk, pool);
+}
+
+/* Flush the 'current' file of FS and its name to disk.
+   Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+flush_current(svn_fs_t *fs,
+              apr_pool_t *scratch_pool)
+{
+  const char *path = svn_fs_fs__path_current(fs, scratch_pool);
+  svn_fs_fs__batch_fsync_t *batch;
+
+  SVN_ERR(svn_fs_fs__batch_fsync_create(&batch, TRUE, scratch_pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_add_file(batch, path, scratch_pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, path, scratch_pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_run(batch, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Register a new, not yet flushed update of the 'current' file in FS.
+   Return its sequence number in *GENERATION. */
+static svn_error_t *
+register_current_update(apr_uint64_t *generation,
+                        svn_fs_t *fs)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_shared_data_t *ffsd = ffd->shared;
+
+  SVN_ERR(svn_mutex__lock(ffsd->group_commit_lock));
+  *generation = ++ffsd->current_written;
+  SVN_ERR(svn_mutex__unlock(ffsd->group_commit_lock, SVN_NO_ERROR));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return once the 'current' update with sequence number GENERATION in FS
+   is on disk.  Of all threads calling this concurrently, the first one
+   flushes 'current' on behalf of all updates registered so far while the
+   others wait for it.  Updates registered during that flush will be
+   covered by the next one.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+wait_for_current_flush(svn_fs_t *fs,
+                       apr_uint64_t generation,
+                       apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  fs_fs_shared_data_t *ffsd = ffd->shared;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(ffsd->group_commit_lock));
+  while (!err && ffsd->current_durable < generation)
+    {
+      apr_uint64_t target;
+
+      /* Somebody else is flushing.  Wait for them and check again since
+         the flush may not cover GENERATION or may have failed. */
+      if (ffsd->current_flushing)
+        {
+          err = svn_thread_cond__wait(ffsd->group_commit_cond,
+                                      ffsd->group_commit_lock);
+          continue;
+        }
+
+      /* Become the group leader and flush without holding the mutex,
+         so that others may register their updates meanwhile. */
+      target = ffsd->current_written;
+      ffsd->current_flushing = TRUE;
+
+      SVN_ERR(svn_mutex__unlock(ffsd->group_commit_lock, SVN_NO_ERROR));
+      err = flush_current(fs, scratch_pool);
+      SVN_ERR(svn_error_compose_create(
+                err, svn_mutex__lock(ffsd->group_commit_lock)));
+
+      ffsd->current_flushing = FALSE;
+      if (!err && ffsd->current_durable < target)
+        ffsd->current_durable = target;
+
+      err = svn_error_compose_create(
+              err, svn_thread_cond__broadcast(ffsd->group_commit_cond));
+    }
+
+  return svn_error_trace(svn_mutex__unlock(ffsd->group_commit_lock, err));
 }
 
 /* Verify that the user registered with FS has all the locks necessary to
@@ -3529,9 +4493,10 @@ verify_locks(svn_fs_t *fs,
              apr_hash_t *changed_paths,
              apr_pool_t *pool)
 {
-  apr_pool_t *iterpool;
   apr_array_header_t *changed_paths_sorted;
-  svn_stringbuf_t *last_recursed = NULL;
+  apr_array_header_t *paths;
+  apr_array_header_t *recursive_paths;
+  const char *last_recursed = NULL;
   int i;
 
   /* Make an array of the changed paths, and sort them depth-first-ily.  */
@@ -3539,18 +4504,18 @@ verify_locks(svn_fs_t *fs,
                                         svn_sort_compare_items_as_paths,
                                         pool);
 
-  /* Now, traverse the array of changed paths, verify locks.  Note
-     that if we need to do a recursive verification a path, we'll skip
-     over children of that path when we get to them. */
-  iterpool = svn_pool_create(pool);
+  /* Now, traverse the array of changed paths and collect the paths whose
+     locks we need to verify.  Note that if we need to do a recursive
+     verification a path, we'll skip over children of that path when we
+     get to them. */
+  paths = apr_array_make(pool, changed_paths_sorted->nelts,
+                         sizeof(const char *));
+  recursive_paths = apr_array_make(pool, 16, sizeof(const char *));
   for (i = 0; i < changed_paths_sorted->nelts; i++)
     {
       const svn_sort__item_t *item;
       const char *path;
       svn_fs_path_change2_t *change;
-      svn_boolean_t recurse = TRUE;
-
-      svn_pool_clear(iterpool);
 
       item = &APR_ARRAY_IDX(changed_paths_sorted, i, svn_sort__item_t);
 
@@ -3561,7 +4526,7 @@ verify_locks(svn_fs_t *fs,
       /* If this path has already been verified as part of a recursive
          check of one of its parents, no need to do it again.  */
       if (last_recursed
-          && svn_fspath__skip_ancestor(last_recursed->data, path))
+          && svn_fspath__skip_ancestor(last_recursed, path))
         continue;
 
       /* What does it mean to succeed at lock verification for a given
@@ -3574,32 +4539,34 @@ verify_locks(svn_fs_t *fs,
          of deleted items, but fortunately we are going to do a
          recursive check on deleted paths regardless of their kind.  */
       if (change->change_kind == svn_fs_path_change_modify)
-        recurse = FALSE;
-      SVN_ERR(svn_fs_fs__allow_locked_operation(path, fs, recurse, TRUE,
-                                                iterpool));
-
-      /* If we just did a recursive check, remember the path we
-         checked (so children can be skipped).  */
-      if (recurse)
         {
-          if (! last_recursed)
-            last_recursed = svn_stringbuf_create(path, pool);
-          else
-            svn_stringbuf_set(last_recursed, path);
+          APR_ARRAY_PUSH(paths, const char *) = path;
+        }
+      else
+        {
+          /* Remember the path we check recursively (so children can
+             be skipped).  */
+          APR_ARRAY_PUSH(recursive_paths, const char *) = path;
+          last_recursed = path;
         }
     }
-  svn_pool_destroy(iterpool);
-  return SVN_NO_ERROR;
+
+  /* Check them all at once, so large commits don't need to look up the
+     locks for each path individually. */
+  return svn_error_trace(svn_fs_fs__allow_locked_operations(fs, paths,
+                                                            recursive_paths,
+                                                            TRUE, pool));
 }
 
 /* Writes final revision properties to file PATH applying permissions
    from file PERMS_REFERENCE. This involves setting svn:date and
-   removing any temporary properties associated with the commit flags. */
+   removing any temporary properties associated with the commit flags.
+   The file will be scheduled for fsync in BATCH. */
 static svn_error_t *
 write_final_revprop(const char *path,
                     const char *perms_reference,
                     svn_fs_txn_t *txn,
-                    svn_boolean_t flush_to_disk,
+                    svn_fs_fs__batch_fsync_t *batch,
                     apr_pool_t *pool)
 {
   apr_hash_t *txnprops;
@@ -3629,19 +4596,19 @@ write_final_revprop(const char *path,
       svn_hash_sets(txnprops, SVN_PROP_REVISION_DATE, &date);
     }
 
-  /* Create new revprops file. Tell OS to truncate existing file,
-     since  file may already exists from failed transaction. */
-  SVN_ERR(svn_io_file_open(&revprop_file, path,
-                           APR_WRITE | APR_CREATE | APR_TRUNCATE
-                           | APR_BUFFERED, APR_OS_DEFAULT, pool));
+  /* Create new revprops file. Truncate any existing file, since file
+     may already exists from failed transaction. */
+  SVN_ERR(svn_fs_fs__batch_fsync_open_file(&revprop_file, batch, path,
+                                           pool));
+  SVN_ERR(svn_io_file_trunc(revprop_file, 0, pool));
 
   stream = svn_stream_from_aprfile2(revprop_file, TRUE, pool);
   SVN_ERR(svn_hash_write2(txnprops, stream, SVN_HASH_TERMINATOR, pool));
   SVN_ERR(svn_stream_close(stream));
 
-  if (flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(revprop_file, pool));
-  SVN_ERR(svn_io_file_close(revprop_file, pool));
+  /* The file remains open until BATCH gets run.  Hand the data over to
+     the OS now, so that others can read it before that. */
+  SVN_ERR(svn_io_file_flush(revprop_file, pool));
 
   SVN_ERR(svn_io_copy_perms(perms_reference, path, pool));
 
@@ -3732,6 +4699,10 @@ struct commit_baton {
   apr_array_header_t *reps_to_cache;
   apr_hash_t *reps_hash;
   apr_pool_t *reps_pool;
+
+  /* With group commit, the sequence number of the 'current' update that
+     still needs to be flushed.  0 if there is none. */
+  apr_uint64_t current_generation;
 };
 
 /* The work-horse for svn_fs_fs__commit, called with the FS write lock.
@@ -3755,6 +4726,7 @@ commit_body(void *baton, apr_pool_t *pool)
   apr_hash_t *changed_paths;
   apr_array_header_t *directory_ids = apr_array_make(pool, 4,
                                                      sizeof(pair_cache_key_t));
+  svn_fs_fs__batch_fsync_t *batch;
 
   /* Re-Read the current repository format.  All our repo upgrade and
      config evaluation strategies are such that existing information in
@@ -3799,8 +4771,12 @@ commit_body(void *baton, apr_pool_t *pool)
   /* We are going to be one better than this puny old revision. */
   new_rev = old_rev + 1;
 
+  /* Collect all files and folders of the new revision and flush them to
+     disk concurrently just before bumping 'current'. */
+  SVN_ERR(svn_fs_fs__batch_fsync_create(&batch, ffd->flush_to_disk, pool));
+
   /* Get a write handle on the proto revision file. */
-  SVN_ERR(get_writable_proto_rev(&proto_file, &proto_file_lockcookie,
+  SVN_ERR(get_writable_proto_rev(&proto_file, &proto_file_lockcookie, NULL,
                                  cb->fs, txn_id, pool));
   SVN_ERR(svn_io_file_get_offset(&initial_offset, proto_file, pool));
 
@@ -3837,8 +4813,6 @@ commit_body(void *baton, apr_pool_t *pool)
                                      NULL, pool));
     }
 
-  if (ffd->flush_to_disk)
-    SVN_ERR(svn_io_file_flush_to_disk(proto_file, pool));
   SVN_ERR(svn_io_file_close(proto_file, pool));
 
   /* We don't unlock the prototype revision file immediately to avoid a
@@ -3859,6 +4833,7 @@ commit_body(void *baton, apr_pool_t *pool)
           if (err && !APR_STATUS_IS_EEXIST(err->apr_err))
             return svn_error_trace(err);
           svn_error_clear(err);
+          SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, new_dir, pool));
           SVN_ERR(svn_io_copy_perms(svn_dirent_join(cb->fs->path,
                                                     PATH_REVS_DIR,
                                                     pool),
@@ -3875,6 +4850,7 @@ commit_body(void *baton, apr_pool_t *pool)
           if (err && !APR_STATUS_IS_EEXIST(err->apr_err))
             return svn_error_trace(err);
           svn_error_clear(err);
+          SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, new_dir, pool));
           SVN_ERR(svn_io_copy_perms(svn_dirent_join(cb->fs->path,
                                                     PATH_REVPROPS_DIR,
                                                     pool),
@@ -3891,8 +4867,12 @@ commit_body(void *baton, apr_pool_t *pool)
   rev_filename = svn_fs_fs__path_rev(cb->fs, new_rev, pool);
   proto_filename = svn_fs_fs__path_txn_proto_rev(cb->fs, txn_id, pool);
   SVN_ERR(svn_fs_fs__move_into_place(proto_filename, rev_filename,
-                                     old_rev_filename, ffd->flush_to_disk,
-                                     pool));
+                                     old_rev_filename, FALSE, pool));
+
+  /* The rev file has already been made read-only, so we can't use
+     svn_fs_fs__batch_fsync_open_file() here. */
+  SVN_ERR(svn_fs_fs__batch_fsync_add_file(batch, rev_filename, pool));
+  SVN_ERR(svn_fs_fs__batch_fsync_new_path(batch, rev_filename, pool));
 
   /* Now that we've moved the prototype revision file out of the way,
      we can unlock it (since further attempts to write to the file
@@ -3904,7 +4884,7 @@ commit_body(void *baton, apr_pool_t *pool)
   SVN_ERR_ASSERT(! svn_fs_fs__is_packed_revprop(cb->fs, new_rev));
   revprop_filename = svn_fs_fs__path_revprops(cb->fs, new_rev, pool);
   SVN_ERR(write_final_revprop(revprop_filename, old_rev_filename,
-                              cb->txn, ffd->flush_to_disk, pool));
+                              cb->txn, batch, pool));
 
   /* Run paranoia checks. */
   if (ffd->verify_before_commit)
@@ -3912,9 +4892,23 @@ commit_body(void *baton, apr_pool_t *pool)
       SVN_ERR(verify_before_commit(cb->fs, new_rev, pool));
     }
 
-  /* Update the 'current' file. */
-  SVN_ERR(write_final_current(cb->fs, txn_id, new_rev, start_node_id,
-                              start_copy_id, pool));
+  /* Make sure that all data of the new revision is on disk before we
+     make it visible by bumping 'current'. */
+  SVN_ERR(svn_fs_fs__batch_fsync_run(batch, pool));
+
+  /* Update the 'current' file.  With group commit, our caller will make
+     sure that it has been flushed to disk before it returns. */
+  if (ffd->group_commit && ffd->flush_to_disk)
+    {
+      SVN_ERR(write_final_current(cb->fs, txn_id, new_rev, start_node_id,
+                                  start_copy_id, FALSE, pool));
+      SVN_ERR(register_current_update(&cb->current_generation, cb->fs));
+    }
+  else
+    {
+      SVN_ERR(write_final_current(cb->fs, txn_id, new_rev, start_node_id,
+                                  start_copy_id, ffd->flush_to_disk, pool));
+    }
 
   /* At this point the new revision is committed and globally visible
      so let the caller know it succeeded by giving it the new revision
@@ -3925,6 +4919,17 @@ commit_body(void *baton, apr_pool_t *pool)
 
   ffd->youngest_rev_cache = new_rev;
 
+  /* The changed-paths index is advisory, i.e. readers fall back to the
+   * changes list if we fail to update it here. */
+  svn_error_clear(svn_fs_fs__path_index_add_revision(cb->fs, new_rev,
+                                                     changed_paths, pool));
+
+  /* Same for the mergeinfo index.  Queries simply crawl the tree for
+   * revisions that it does not cover. */
+  svn_error_clear(svn_fs_fs__mergeinfo_index_add_revision(cb->fs, new_rev,
+                                                          changed_paths,
+                                                          pool));
+
   /* Make the directory contents alreday cached for the new revision
    * visible. */
   SVN_ERR(promote_cached_directories(cb->fs, directory_ids, pool));
@@ -3966,6 +4971,7 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
   cb.new_rev_p = new_rev_p;
   cb.fs = fs;
   cb.txn = txn;
+  cb.current_generation = 0;
 
   if (ffd->rep_sharing_allowed)
     {
@@ -3985,6 +4991,11 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
   /* At this point, *NEW_REV_P has been set, so errors below won't affect
      the success of the commit.  (See svn_fs_commit_txn().)  */
 
+  /* With group commit, the new revision has already been made visible
+     but maybe not durable.  Share the flush with concurrent commits. */
+  if (cb.current_generation)
+    SVN_ERR(wait_for_current_flush(fs, cb.current_generation, pool));
+
   if (ffd->rep_sharing_allowed)
     {
       svn_error_t *err;
@@ -4014,6 +5025,8 @@ svn_fs_fs__commit(svn_revnum_t *new_rev_p,
         }
       else if (err)
         return svn_error_trace(err);
+
+      svn_fs_fs__rep_cache_revision_added(fs, *new_rev_p);
     }
 
   return SVN_NO_ERROR;
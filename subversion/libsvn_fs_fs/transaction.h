@@ -167,6 +167,20 @@ svn_fs_fs__set_contents(svn_stream_t **stream,
                         node_revision_t *noderev,
                         apr_pool_t *pool);
 
+/* Like svn_fs_fs__set_contents() but return a window handler in *HANDLER
+   and its baton in *HANDLER_BATON that accepts a text delta against the
+   current contents of NODEREV.  If the representation would be deltified
+   against those contents anyway, the windows will be stored more or less
+   as they come in, without reconstructing and re-deltifying the fulltext.
+   Otherwise, set *HANDLER to NULL and don't do anything.
+   Allocations are from POOL. */
+svn_error_t *
+svn_fs_fs__set_contents_delta(svn_txdelta_window_handler_t *handler,
+                              void **handler_baton,
+                              svn_fs_t *fs,
+                              node_revision_t *noderev,
+                              apr_pool_t *pool);
+
 /* Create a node revision in FS which is an immediate successor of
    OLD_ID, whose contents are NEW_NR.  Set *NEW_ID_P to the new node
    revision's ID.  Use POOL for any temporary allocation.
@@ -55,6 +55,7 @@
 #include "cached_data.h"
 #include "dag.h"
 #include "lock.h"
+#include "mergeinfo_index.h"
 #include "tree.h"
 #include "fs_fs.h"
 #include "id.h"
@@ -67,6 +68,7 @@
 #include "private/svn_subr_private.h"
 #include "private/svn_fs_util.h"
 #include "private/svn_fspath.h"
+#include "private/svn_sorts_private.h"
 #include "../libsvn_fs/fs-loader.h"
 
 
@@ -2382,7 +2384,7 @@ svn_fs_fs__commit_txn(const char **conflict_p,
 
   if (ffd->pack_after_commit)
     {
-      SVN_ERR(svn_fs_fs__pack(fs, 0, NULL, NULL, NULL, NULL, pool));
+      SVN_ERR(svn_fs_fs__pack(fs, 0, 1, NULL, NULL, NULL, NULL, pool));
     }
 
   return SVN_NO_ERROR;
@@ -2963,6 +2965,41 @@ fs_file_contents(svn_stream_t **contents,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__file_contents_location(apr_file_t **file_p,
+                                  apr_off_t *offset,
+                                  svn_filesize_t *length,
+                                  svn_fs_root_t *root,
+                                  const char *path,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool)
+{
+  dag_node_t *node;
+
+  SVN_ERR(get_dag(&node, root, path, scratch_pool));
+
+  return svn_error_trace(svn_fs_fs__dag_get_contents_location(file_p, offset,
+                                                              length, node,
+                                                              result_pool,
+                                                              scratch_pool));
+}
+
+svn_error_t *
+svn_fs_fs__file_deflated_contents(svn_string_t **deflated,
+                                  svn_fs_root_t *root,
+                                  const char *path,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool)
+{
+  dag_node_t *node;
+
+  SVN_ERR(get_dag(&node, root, path, scratch_pool));
+
+  return svn_error_trace(svn_fs_fs__dag_get_deflated_contents(deflated, node,
+                                                              result_pool,
+                                                              scratch_pool));
+}
+
 /* --- End machinery for svn_fs_file_contents() ---  */
 
 
@@ -3078,25 +3115,36 @@ apply_textdelta(void *baton, apr_pool_t *pool)
                                          tb->path);
     }
 
-  /* Make a readable "source" stream out of the current contents of
-     ROOT/PATH; obviously, this must done in the context of a db_txn.
-     The stream is returned in tb->source_stream. */
-  SVN_ERR(svn_fs_fs__dag_get_contents(&(tb->source_stream),
-                                      tb->node, tb->pool));
-
-  /* Make a writable "target" stream */
-  SVN_ERR(svn_fs_fs__dag_get_edit_stream(&(tb->target_stream), tb->node,
-                                         tb->pool));
-
-  /* Now, create a custom window handler that uses our two streams. */
-  /* Keep historical behavior by disowning the stream; adjust if needed. */
-  svn_txdelta_apply2(svn_stream_disown(tb->source_stream, tb->pool),
-                     tb->target_stream,
-                     NULL,
-                     tb->path,
-                     tb->pool,
-                     &(tb->interpreter),
-                     &(tb->interpreter_baton));
+  /* If the delta is against the same base that we would use to store the
+     new contents, store it right away.  This saves us reconstructing the
+     fulltext only to deltify it again, e.g. when loading dump files that
+     contain deltas. */
+  SVN_ERR(svn_fs_fs__dag_get_edit_delta_handler(&(tb->interpreter),
+                                                &(tb->interpreter_baton),
+                                                tb->node, tb->pool));
+  if (! tb->interpreter)
+    {
+      /* Make a readable "source" stream out of the current contents of
+         ROOT/PATH; obviously, this must done in the context of a db_txn.
+         The stream is returned in tb->source_stream. */
+      SVN_ERR(svn_fs_fs__dag_get_contents(&(tb->source_stream),
+                                          tb->node, tb->pool));
+
+      /* Make a writable "target" stream */
+      SVN_ERR(svn_fs_fs__dag_get_edit_stream(&(tb->target_stream), tb->node,
+                                             tb->pool));
+
+      /* Now, create a custom window handler that uses our two streams. */
+      /* Keep historical behavior by disowning the stream; adjust if
+         needed. */
+      svn_txdelta_apply2(svn_stream_disown(tb->source_stream, tb->pool),
+                         tb->target_stream,
+                         NULL,
+                         tb->path,
+                         tb->pool,
+                         &(tb->interpreter),
+                         &(tb->interpreter_baton));
+    }
 
   /* Make a record of this modification in the changes table. */
   return add_change(tb->root->fs, txn_id, tb->path,
@@ -4478,6 +4526,148 @@ add_descendant_mergeinfo(svn_fs_root_t *root,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__get_explicit_mergeinfo(svn_fs_root_t *root,
+                                  const char *path,
+                                  svn_boolean_t include_descendants,
+                                  svn_fs_mergeinfo_receiver_t receiver,
+                                  void *baton,
+                                  apr_pool_t *scratch_pool)
+{
+  svn_mergeinfo_t mergeinfo;
+
+  SVN_ERR(get_mergeinfo_for_path(&mergeinfo, root, path,
+                                 svn_mergeinfo_explicit, FALSE,
+                                 scratch_pool, scratch_pool));
+  if (mergeinfo)
+    SVN_ERR(receiver(path, mergeinfo, baton, scratch_pool));
+  if (include_descendants)
+    SVN_ERR(add_descendant_mergeinfo(root, path, receiver, baton,
+                                     scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for collect_mergeinfo(). */
+typedef struct collect_mergeinfo_baton_t
+{
+  /* Where the mergeinfo gets passed on to. */
+  svn_fs_mergeinfo_receiver_t receiver;
+  void *baton;
+
+  /* Maps const char * paths to svn_string_t * mergeinfo. */
+  apr_hash_t *catalog;
+} collect_mergeinfo_baton_t;
+
+/* Implements svn_fs_mergeinfo_receiver_t.  Add MERGEINFO of PATH to the
+   catalog in the collect_mergeinfo_baton_t BATON and pass it on. */
+static svn_error_t *
+collect_mergeinfo(const char *path,
+                  svn_mergeinfo_t mergeinfo,
+                  void *baton,
+                  apr_pool_t *scratch_pool)
+{
+  collect_mergeinfo_baton_t *b = baton;
+  apr_pool_t *pool = apr_hash_pool_get(b->catalog);
+  svn_string_t *mergeinfo_string;
+
+  SVN_ERR(svn_mergeinfo_to_string(&mergeinfo_string, mergeinfo, pool));
+  svn_hash_sets(b->catalog, apr_pstrdup(pool, path), mergeinfo_string);
+
+  return svn_error_trace(b->receiver(path, mergeinfo, b->baton,
+                                     scratch_pool));
+}
+
+/* Like add_descendant_mergeinfo() but use the mergeinfo index of the
+   filesystem if it covers ROOT.  If there is no index yet and we have
+   to crawl the whole youngest revision anyway, create the index from
+   the result. */
+static svn_error_t *
+get_descendant_mergeinfo(svn_fs_root_t *root,
+                         const char *path,
+                         svn_fs_mergeinfo_receiver_t receiver,
+                         void *baton,
+                         apr_pool_t *scratch_pool)
+{
+  apr_hash_t *catalog;
+  svn_boolean_t missing;
+  svn_revnum_t youngest;
+  svn_error_t *err;
+
+  path = svn_fs__canonicalize_abspath(path, scratch_pool);
+
+  /* The index is advisory; fall back to crawling if it fails. */
+  err = svn_fs_fs__mergeinfo_index_find(&catalog, &missing, root->fs,
+                                        root->rev, path,
+                                        scratch_pool, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      catalog = NULL;
+      missing = FALSE;
+    }
+
+  if (catalog)
+    {
+      apr_array_header_t *sorted
+        = svn_sort__hash(catalog, svn_sort_compare_items_as_paths,
+                         scratch_pool);
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      int i;
+
+      for (i = 0; i < sorted->nelts; i++)
+        {
+          svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i,
+                                                  svn_sort__item_t);
+          const svn_string_t *mergeinfo_string = item->value;
+          svn_mergeinfo_t mergeinfo;
+
+          svn_pool_clear(iterpool);
+
+          err = svn_mergeinfo_parse(&mergeinfo, mergeinfo_string->data,
+                                    iterpool);
+          if (err && err->apr_err == SVN_ERR_MERGEINFO_PARSE_ERROR)
+            {
+              svn_error_clear(err);
+              continue;
+            }
+          SVN_ERR(err);
+
+          SVN_ERR(receiver(item->key, mergeinfo, baton, iterpool));
+        }
+      svn_pool_destroy(iterpool);
+
+      return SVN_NO_ERROR;
+    }
+
+  if (missing && strcmp(path, "/") == 0)
+    SVN_ERR(svn_fs_fs__youngest_rev(&youngest, root->fs, scratch_pool));
+  else
+    youngest = SVN_INVALID_REVNUM;
+
+  if (root->rev == youngest)
+    {
+      collect_mergeinfo_baton_t b;
+
+      b.receiver = receiver;
+      b.baton = baton;
+      b.catalog = apr_hash_make(scratch_pool);
+
+      SVN_ERR(add_descendant_mergeinfo(root, path, collect_mergeinfo, &b,
+                                       scratch_pool));
+      svn_error_clear(svn_fs_fs__mergeinfo_index_create(root->fs, root->rev,
+                                                        b.catalog,
+                                                        scratch_pool));
+    }
+  else
+    {
+      SVN_ERR(add_descendant_mergeinfo(root, path, receiver, baton,
+                                       scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Find all the mergeinfo for a set of PATHS under ROOT and report it
    through RECEIVER with BATON.  INHERITED, INCLUDE_DESCENDANTS and
@@ -4525,7 +4715,7 @@ get_mergeinfos_for_paths(svn_fs_root_t *root,
       if (path_mergeinfo)
         SVN_ERR(receiver(path, path_mergeinfo, baton, iterpool));
       if (include_descendants)
-        SVN_ERR(add_descendant_mergeinfo(root, path, receiver, baton,
+        SVN_ERR(get_descendant_mergeinfo(root, path, receiver, baton,
                                          iterpool));
     }
   svn_pool_destroy(iterpool);
@@ -84,6 +84,44 @@ svn_fs_fs__node_created_rev(svn_revnum_t *revision,
                             const char *path,
                             apr_pool_t *pool);
 
+/* Set *FILE_P, *OFFSET and *LENGTH to the location of the contents of
+   the file PATH under ROOT within its rev or pack file, if they are stored
+   verbatim there.  Otherwise, set *FILE_P to NULL.  This allows for
+   sending the contents without reading them through a stream first.
+   Allocate *FILE_P in RESULT_POOL and use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_fs_fs__file_contents_location(apr_file_t **file_p,
+                                  apr_off_t *offset,
+                                  svn_filesize_t *length,
+                                  svn_fs_root_t *root,
+                                  const char *path,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool);
+
+/* Set *DEFLATED to the contents of the file PATH under ROOT as a raw
+   deflate stream, if they are stored zlib-compressed in a single svndiff
+   window.  Otherwise, set *DEFLATED to NULL.  This allows for sending the
+   contents with "Content-Encoding: deflate" without recompressing them.
+   Allocate *DEFLATED in RESULT_POOL and use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_fs_fs__file_deflated_contents(svn_string_t **deflated,
+                                  svn_fs_root_t *root,
+                                  const char *path,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool);
+
+/* Invoke RECEIVER with BATON for the explicit mergeinfo of PATH in the
+   revision ROOT and, if INCLUDE_DESCENDANTS is set, for that of all paths
+   below it.  Skip invalid mergeinfo.  Unlike svn_fs_get_mergeinfo3(),
+   this always crawls the tree.  Use SCRATCH_POOL for temporaries. */
+svn_error_t *
+svn_fs_fs__get_explicit_mergeinfo(svn_fs_root_t *root,
+                                  const char *path,
+                                  svn_boolean_t include_descendants,
+                                  svn_fs_mergeinfo_receiver_t receiver,
+                                  void *baton,
+                                  apr_pool_t *scratch_pool);
+
 /* Verify metadata for ROOT.
    ### Currently only implemented for revision roots. */
 svn_error_t *
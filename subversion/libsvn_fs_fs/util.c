@@ -28,6 +28,7 @@
 
 #include "fs_fs.h"
 #include "pack.h"
+#include "rev_file.h"
 #include "util.h"
 
 #include "../libsvn_fs/fs-loader.h"
@@ -100,6 +101,13 @@ svn_fs_fs__path_revprop_generation(svn_fs_t *fs,
   return svn_dirent_join(fs->path, PATH_REVPROP_GENERATION, pool);
 }
 
+const char *
+svn_fs_fs__path_revprop_generations(svn_fs_t *fs,
+                                    apr_pool_t *pool)
+{
+  return svn_dirent_join(fs->path, PATH_REVPROP_GENERATIONS, pool);
+}
+
 const char *
 svn_fs_fs__path_rev_packed(svn_fs_t *fs,
                            svn_revnum_t rev,
@@ -417,10 +425,17 @@ svn_fs_fs__update_min_unpacked_rev(svn_fs_t *fs,
                                    apr_pool_t *pool)
 {
   fs_fs_data_t *ffd = fs->fsap_data;
+  svn_revnum_t old_min_unpacked_rev = ffd->min_unpacked_rev;
 
   SVN_ERR_ASSERT(ffd->format >= SVN_FS_FS__MIN_PACKED_FORMAT);
 
-  return svn_fs_fs__read_min_unpacked_rev(&ffd->min_unpacked_rev, fs, pool);
+  SVN_ERR(svn_fs_fs__read_min_unpacked_rev(&ffd->min_unpacked_rev, fs, pool));
+
+  /* Don't keep files of since packed revisions open. */
+  if (ffd->min_unpacked_rev != old_min_unpacked_rev)
+    svn_fs_fs__rev_file_cache_clear(fs);
+
+  return SVN_NO_ERROR;
 }
 
 svn_error_t *
@@ -493,11 +508,12 @@ svn_fs_fs__read_current(svn_revnum_t *rev,
 }
 
 svn_error_t *
-svn_fs_fs__write_current(svn_fs_t *fs,
-                         svn_revnum_t rev,
-                         apr_uint64_t next_node_id,
-                         apr_uint64_t next_copy_id,
-                         apr_pool_t *pool)
+svn_fs_fs__write_current2(svn_fs_t *fs,
+                          svn_revnum_t rev,
+                          apr_uint64_t next_node_id,
+                          apr_uint64_t next_copy_id,
+                          svn_boolean_t flush_to_disk,
+                          apr_pool_t *pool)
 {
   char *buf;
   const char *name;
@@ -521,11 +537,26 @@ svn_fs_fs__write_current(svn_fs_t *fs,
   name = svn_fs_fs__path_current(fs, pool);
   SVN_ERR(svn_io_write_atomic2(name, buf, strlen(buf),
                                name /* copy_perms_path */,
-                               ffd->flush_to_disk, pool));
+                               flush_to_disk, pool));
 
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_fs_fs__write_current(svn_fs_t *fs,
+                         svn_revnum_t rev,
+                         apr_uint64_t next_node_id,
+                         apr_uint64_t next_copy_id,
+                         apr_pool_t *pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+
+  return svn_error_trace(svn_fs_fs__write_current2(fs, rev, next_node_id,
+                                                   next_copy_id,
+                                                   ffd->flush_to_disk,
+                                                   pool));
+}
+
 svn_error_t *
 svn_fs_fs__try_stringbuf_from_file(svn_stringbuf_t **content,
                                    svn_boolean_t *missing,
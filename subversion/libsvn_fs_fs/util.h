@@ -143,6 +143,13 @@ const char *
 svn_fs_fs__path_revprop_generation(svn_fs_t *fs,
                                    apr_pool_t *pool);
 
+/* Return the full path of the per-shard revprop generations file in FS.
+ * Allocate the result in POOL.
+ */
+const char *
+svn_fs_fs__path_revprop_generations(svn_fs_t *fs,
+                                    apr_pool_t *pool);
+
 /* Return the full path of the revision properties pack shard directory
  * that will contain the packed properties of revision REV in FS.
  * Allocate the result in POOL.
@@ -339,8 +346,19 @@ svn_fs_fs__read_current(svn_revnum_t *rev,
 /* Atomically update the 'current' file to hold the specified REV,
    NEXT_NODE_ID, and NEXT_COPY_ID.  (The two next-ID parameters are
    ignored and may be 0 if the FS format does not use them.)
+   Flush the new contents to disk only if FLUSH_TO_DISK is set.
    Perform temporary allocations in POOL. */
 svn_error_t *
+svn_fs_fs__write_current2(svn_fs_t *fs,
+                          svn_revnum_t rev,
+                          apr_uint64_t next_node_id,
+                          apr_uint64_t next_copy_id,
+                          svn_boolean_t flush_to_disk,
+                          apr_pool_t *pool);
+
+/* Like svn_fs_fs__write_current2 but flush the contents to disk as
+   configured for FS. */
+svn_error_t *
 svn_fs_fs__write_current(svn_fs_t *fs,
                          svn_revnum_t rev,
                          apr_uint64_t next_node_id,
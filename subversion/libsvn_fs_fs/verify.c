@@ -261,9 +261,14 @@ compare_l2p_to_p2l_index(svn_fs_t *fs,
                          void *cancel_baton,
                          apr_pool_t *pool)
 {
+  enum { BATCH_SIZE = 1024 };
+
   svn_revnum_t i;
   apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_pool_t *batch_pool = svn_pool_create(pool);
   apr_array_header_t *max_ids;
+  apr_array_header_t *item_indexes
+    = apr_array_make(pool, BATCH_SIZE, sizeof(apr_uint64_t));
 
   /* common file access structure */
   svn_fs_fs__revision_file_t *rev_file;
@@ -280,16 +285,32 @@ compare_l2p_to_p2l_index(svn_fs_t *fs,
       apr_uint64_t k;
       apr_uint64_t max_id = APR_ARRAY_IDX(max_ids, i, apr_uint64_t);
       svn_revnum_t revision = start + i;
+      apr_array_header_t *offsets = NULL;
 
       for (k = 0; k < max_id; ++k)
         {
           apr_off_t offset;
           svn_fs_fs__p2l_entry_t *p2l_entry;
+          int batch_index = (int)(k % BATCH_SIZE);
           svn_pool_clear(iterpool);
 
-          /* get L2P entry.  Ignore unused entries. */
-          SVN_ERR(svn_fs_fs__item_offset(&offset, fs, rev_file, revision,
-                                         NULL, k, iterpool));
+          /* get L2P entries for the next batch of items at once */
+          if (batch_index == 0)
+            {
+              apr_uint64_t item;
+
+              svn_pool_clear(batch_pool);
+              apr_array_clear(item_indexes);
+              for (item = k; item < max_id && item < k + BATCH_SIZE; ++item)
+                APR_ARRAY_PUSH(item_indexes, apr_uint64_t) = item;
+
+              SVN_ERR(svn_fs_fs__item_offsets(&offsets, fs, rev_file,
+                                              revision, item_indexes,
+                                              batch_pool, iterpool));
+            }
+
+          /* Ignore unused entries. */
+          offset = APR_ARRAY_IDX(offsets, batch_index, apr_off_t);
           if (offset == -1)
             continue;
 
@@ -323,6 +344,7 @@ compare_l2p_to_p2l_index(svn_fs_t *fs,
         SVN_ERR(cancel_func(cancel_baton));
     }
 
+  svn_pool_destroy(batch_pool);
   svn_pool_destroy(iterpool);
 
   SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
@@ -924,3 +946,56 @@ svn_fs_fs__verify(svn_fs_t *fs,
 
   return SVN_NO_ERROR;
 }
+
+/* Number of bytes at the end of a rev / pack file to include in its
+ * fingerprint.  This covers the footer in all formats. */
+#define FINGERPRINT_TAIL_SIZE 256
+
+svn_error_t *
+svn_fs_fs__verify_fingerprint(svn_revnum_t *start_rev,
+                              svn_revnum_t *end_rev,
+                              const char **fingerprint,
+                              svn_fs_t *fs,
+                              svn_revnum_t revision,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  fs_fs_data_t *ffd = fs->fsap_data;
+  svn_fs_fs__revision_file_t *rev_file;
+  apr_finfo_t finfo;
+  apr_off_t offset;
+  apr_size_t tail_len;
+  char tail[FINGERPRINT_TAIL_SIZE];
+  svn_checksum_t *checksum;
+
+  SVN_ERR(svn_fs_fs__ensure_revision_exists(revision, fs, scratch_pool));
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, revision,
+                                           scratch_pool, scratch_pool));
+
+  *start_rev = rev_file->start_revision;
+  *end_rev = rev_file->is_packed
+           ? rev_file->start_revision + ffd->max_files_per_dir - 1
+           : revision;
+
+  /* The file's footer contains the index checksums (format 7) or the
+   * root noderev and changed paths offsets (older formats).  Together
+   * with the file size, this changes whenever the file gets rewritten. */
+  SVN_ERR(svn_io_file_info_get(&finfo, APR_FINFO_SIZE | APR_FINFO_MTIME,
+                               rev_file->file, scratch_pool));
+  tail_len = (apr_size_t)MIN(finfo.size, FINGERPRINT_TAIL_SIZE);
+  offset = finfo.size - tail_len;
+  SVN_ERR(svn_io_file_seek(rev_file->file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(rev_file->file, tail, tail_len, NULL, NULL,
+                                 scratch_pool));
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_md5, tail, tail_len,
+                       scratch_pool));
+  *fingerprint = apr_psprintf(result_pool,
+                              "%" APR_OFF_T_FMT ":%" APR_TIME_T_FMT ":%s",
+                              finfo.size, finfo.mtime,
+                              svn_checksum_to_cstring_display(checksum,
+                                                              scratch_pool));
+
+  return SVN_NO_ERROR;
+}
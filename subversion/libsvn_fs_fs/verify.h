@@ -39,4 +39,21 @@ svn_error_t *svn_fs_fs__verify(svn_fs_t *fs,
                                void *cancel_baton,
                                apr_pool_t *pool);
 
+/* Return in *START_REV and *END_REV the range of revisions that are
+ * stored in the same rev or pack file as REVISION in FS.  Set
+ * *FINGERPRINT to a string that identifies the current contents of that
+ * file, i.e. that changes whenever the file gets replaced or modified.
+ * It is derived from the file's size, modification time and footer.
+ *
+ * Allocate *FINGERPRINT in RESULT_POOL and use SCRATCH_POOL for
+ * temporary allocations. */
+svn_error_t *
+svn_fs_fs__verify_fingerprint(svn_revnum_t *start_rev,
+                              svn_revnum_t *end_rev,
+                              const char **fingerprint,
+                              svn_fs_t *fs,
+                              svn_revnum_t revision,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool);
+
 #endif
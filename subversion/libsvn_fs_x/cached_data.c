@@ -1284,6 +1284,7 @@ read_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
                   rep_state_t *rs, apr_pool_t *result_pool,
                   apr_pool_t *scratch_pool)
 {
+  svn_fs_x__data_t *ffd = rs->sfile->fs->fsap_data;
   svn_boolean_t is_cached;
   apr_off_t start_offset;
   apr_off_t end_offset;
@@ -1370,6 +1371,13 @@ read_delta_window(svn_txdelta_window_t **nwin, int this_chunk,
                             _("Reading one svndiff window read beyond "
                               "the end of the representation"));
 
+  ffd->io_stats.items_read++;
+  ffd->io_stats.bytes_read += end_offset - start_offset;
+
+  /* svndiff1 and later compress the window contents. */
+  if (rs->ver > 0 && (*nwin)->new_data)
+    ffd->io_stats.bytes_decompressed += (*nwin)->new_data->len;
+
   /* the window has not been cached before, thus cache it now
    * (if caching is used for them at all) */
   if (cacheable)
@@ -2437,7 +2445,8 @@ svn_fs_x__get_file_delta_stream(svn_txdelta_stream_t **stream_p,
   /* Because source and target stream will already verify their content,
    * there is no need to do this once more.  In particular if the stream
    * content is being fetched from cache. */
-  svn_txdelta2(stream_p, source_stream, target_stream, FALSE, result_pool);
+  svn_txdelta3(stream_p, source_stream, target_stream, FALSE, FALSE,
+               result_pool);
 
   return SVN_NO_ERROR;
 }
@@ -3512,6 +3521,9 @@ block_read(void **result,
                     break;
                 }
 
+              ffd->io_stats.items_read++;
+              ffd->io_stats.bytes_read += entry->size;
+
               if (is_result)
                 *result = item;
 
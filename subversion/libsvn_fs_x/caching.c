@@ -286,12 +286,19 @@ init_callbacks(svn_cache__t *cache,
                             apr_pool_cleanup_null);
 #endif
 
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+
   if (error_handler)
     SVN_ERR(svn_cache__set_error_handler(cache,
                                           error_handler,
                                           fs,
                                           pool));
 
+  /* Remember it for svn_fs_get_io_stats(). */
+  if (ffd->caches == NULL)
+    ffd->caches = apr_array_make(fs->pool, 32, sizeof(cache));
+  APR_ARRAY_PUSH(ffd->caches, svn_cache__t *) = cache;
+
   return SVN_NO_ERROR;
 }
 
@@ -433,6 +440,23 @@ svn_fs_x__initialize_caches(svn_fs_t *fs,
   /* 1st level DAG node cache */
   ffd->dag_node_cache = svn_fs_x__create_dag_cache(fs->pool);
 
+  /* 2nd level DAG path lookup cache.  Committed paths never change their
+     node, so this may be shared with all other FS instances. */
+  SVN_ERR(create_cache(&(ffd->dag_path_cache),
+                       NULL,
+                       membuffer,
+                       1, 1000, /* ~60 bytes / entry; 1k entries total */
+                       svn_fs_x__serialize_id,
+                       svn_fs_x__deserialize_id,
+                       APR_HASH_KEY_STRING,
+                       apr_pstrcat(scratch_pool, prefix, "DAGPATH",
+                                   SVN_VA_NULL),
+                       SVN_CACHE__MEMBUFFER_HIGH_PRIORITY,
+                       has_namespace,
+                       fs,
+                       no_handler, FALSE,
+                       fs->pool, scratch_pool));
+
   /* Very rough estimate: 1K per directory. */
   SVN_ERR(create_cache(&(ffd->dir_cache),
                        NULL,
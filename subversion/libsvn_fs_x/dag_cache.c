@@ -638,6 +638,78 @@ get_root_node(dag_node_t **node_p,
   return SVN_NO_ERROR;
 }
 
+/* Return the key for PATH within the committed ROOT in the 2nd level
+   DAG path cache.  Allocate it in RESULT_POOL. */
+static const char *
+dag_path_cache_key(svn_fs_root_t *root,
+                   const svn_string_t *path,
+                   apr_pool_t *result_pool)
+{
+  return apr_psprintf(result_pool, "%ld:%.*s", root->rev,
+                      (int)path->len, path->data);
+}
+
+/* Look up PATH within the committed ROOT in the DAG path cache that is
+   shared between all FS instances.  If found, add the node to the 1st
+   level DAG cache and return a reference to it in *NODE_P.  Otherwise,
+   set *NODE_P to NULL.  Use SCRATCH_POOL for temporary allocations.
+
+   NOTE: *NODE_P will live within the DAG cache and we merely return a
+   reference to it.  Hence, it will invalid upon the next cache insertion.
+   Callers must create a copy if they want a non-temporary object.
+*/
+static svn_error_t *
+dag_path_cache_get(dag_node_t **node_p,
+                   svn_fs_root_t *root,
+                   const svn_string_t *path,
+                   apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = root->fs;
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+  svn_fs_x__change_set_t change_set = svn_fs_x__root_change_set(root);
+  cache_entry_t *bucket;
+  svn_fs_x__id_t *node_id;
+  svn_boolean_t found;
+
+  SVN_ERR(svn_cache__get((void **)&node_id, &found, ffd->dag_path_cache,
+                         dag_path_cache_key(root, path, scratch_pool),
+                         scratch_pool));
+  if (!found)
+    {
+      *node_p = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  /* Construct the DAG node object for NODE_ID. Let it live in the cache. */
+  auto_clear_dag_cache(ffd->dag_node_cache);
+  bucket = cache_lookup(ffd->dag_node_cache, change_set, path);
+  if (bucket->node == NULL)
+    SVN_ERR(svn_fs_x__dag_get_node(&bucket->node, fs, node_id,
+                                   ffd->dag_node_cache->pool,
+                                   scratch_pool));
+
+  *node_p = bucket->node;
+  return SVN_NO_ERROR;
+}
+
+/* Remember that PATH within the committed ROOT refers to NODE in the DAG
+   path cache that is shared between all FS instances.  Use SCRATCH_POOL
+   for temporary allocations. */
+static svn_error_t *
+dag_path_cache_set(svn_fs_root_t *root,
+                   const svn_string_t *path,
+                   dag_node_t *node,
+                   apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = root->fs->fsap_data;
+  svn_fs_x__id_t node_id = *svn_fs_x__dag_get_id(node);
+
+  return svn_error_trace(svn_cache__set(ffd->dag_path_cache,
+                                        dag_path_cache_key(root, path,
+                                                           scratch_pool),
+                                        &node_id, scratch_pool));
+}
+
 /* Walk the DAG starting at ROOT, following PATH and return a reference to
    the target node in *NODE_P.   Use SCRATCH_POOL for temporary allocations.
 
@@ -699,9 +771,24 @@ walk_dag_path(dag_node_t **node_p,
 
       /* Did the shortcut work? */
       if (here)
-        return svn_error_trace(dag_step(node_p, root, here,
-                                        entry_buffer->data, path,
-                                        change_set, FALSE, scratch_pool));
+        {
+          SVN_ERR(dag_step(node_p, root, here, entry_buffer->data, path,
+                           change_set, FALSE, scratch_pool));
+          if (!root->is_txn_root)
+            SVN_ERR(dag_path_cache_set(root, path, *node_p, scratch_pool));
+
+          return SVN_NO_ERROR;
+        }
+    }
+
+  /* Third attempt: Some other FS instance, e.g. serving a parallel request
+     for the same repository, may already have resolved that path.  This
+     costs a single hash lookup in the shared membuffer cache. */
+  if (!root->is_txn_root)
+    {
+      SVN_ERR(dag_path_cache_get(node_p, root, path, scratch_pool));
+      if (*node_p)
+        return SVN_NO_ERROR;
     }
 
   /* Now there is something to iterate over. Thus, create the ITERPOOL. */
@@ -725,6 +812,10 @@ walk_dag_path(dag_node_t **node_p,
                        iterpool));
     }
 
+  /* Let other FS instances skip the walk next time. */
+  if (!root->is_txn_root)
+    SVN_ERR(dag_path_cache_set(root, path, here, iterpool));
+
   svn_pool_destroy(iterpool);
   *node_p = here;
 
@@ -230,6 +230,23 @@ x_info(const void **fsx_info,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+x_get_io_stats(svn_fs_io_stats_t *stats,
+               svn_fs_t *fs)
+{
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+  int i;
+
+  *stats = ffd->io_stats;
+  if (ffd->caches)
+    for (i = 0; i < ffd->caches->nelts; ++i)
+      svn_cache__add_access_counts(&stats->cache_gets, &stats->cache_hits,
+                                   APR_ARRAY_IDX(ffd->caches, i,
+                                                 svn_cache__t *));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 x_refresh_revprops(svn_fs_t *fs,
                    apr_pool_t *scratch_pool)
@@ -311,7 +328,8 @@ static fs_vtable_t fs_vtable = {
   svn_fs_x__verify_root,
   x_freeze,
   x_set_errcall,
-  NULL /* ioctl */
+  NULL, /* ioctl */
+  x_get_io_stats
 };
 
 
@@ -400,6 +418,37 @@ x_open(svn_fs_t *fs,
 
 
 
+svn_error_t *
+svn_fs_x__open_instance(svn_fs_t **new_fs,
+                        svn_fs_t *fs,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+  svn_fs_x__data_t *new_ffd;
+  svn_fs_t *instance = apr_pcalloc(result_pool, sizeof(*instance));
+
+  instance->pool = result_pool;
+  instance->warning = fs->warning;
+  instance->warning_baton = fs->warning_baton;
+  instance->config = fs->config ? apr_hash_copy(result_pool, fs->config)
+                                : NULL;
+
+  SVN_ERR(initialize_fs_struct(instance));
+  SVN_ERR(svn_fs_x__open(instance, fs->path, scratch_pool));
+  SVN_ERR(svn_fs_x__initialize_caches(instance, scratch_pool));
+
+  /* FS has already been registered in the common pool, so we can simply
+     use the same shared data without further synchronization. */
+  new_ffd = instance->fsap_data;
+  new_ffd->shared = ffd->shared;
+
+  *new_fs = instance;
+  return SVN_NO_ERROR;
+}
+
+
+
 /* This implements the fs_library_vtable_t.open_for_recovery() API. */
 static svn_error_t *
 x_open_for_recovery(svn_fs_t *fs,
@@ -500,6 +549,7 @@ x_verify(svn_fs_t *fs,
 static svn_error_t *
 x_pack(svn_fs_t *fs,
        const char *path,
+       int jobs,
        svn_fs_pack_notify_t notify_func,
        void *notify_baton,
        svn_cancel_func_t cancel_func,
@@ -509,7 +559,7 @@ x_pack(svn_fs_t *fs,
        apr_pool_t *common_pool)
 {
   SVN_ERR(x_open(fs, path, common_pool_lock, scratch_pool, common_pool));
-  return svn_fs_x__pack(fs, 0, notify_func, notify_baton,
+  return svn_fs_x__pack(fs, 0, jobs, notify_func, notify_baton,
                         cancel_func, cancel_baton, scratch_pool);
 }
 
@@ -531,6 +581,7 @@ x_hotcopy(svn_fs_t *src_fs,
           const char *dst_path,
           svn_boolean_t clean_logs,
           svn_boolean_t incremental,
+          int jobs,
           svn_fs_hotcopy_notify_t notify_func,
           void *notify_baton,
           svn_cancel_func_t cancel_func,
@@ -553,7 +604,7 @@ x_hotcopy(svn_fs_t *src_fs,
      can't be opened.
    */
   return svn_fs_x__hotcopy(src_fs, dst_fs, src_path, dst_path,
-                            incremental, notify_func, notify_baton,
+                            incremental, jobs, notify_func, notify_baton,
                             cancel_func, cancel_baton, common_pool_lock,
                             scratch_pool, common_pool);
 }
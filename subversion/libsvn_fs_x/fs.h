@@ -290,6 +290,11 @@ typedef struct svn_fs_x__data_t
   /* Caches native dag_node_t* instances */
   svn_fs_x__dag_cache_t *dag_node_cache;
 
+  /* 2nd level DAG lookup cache, shared between all svn_fs_t instances of
+     the same repository.  Maps "<rev>:<normalized path>" to the
+     svn_fs_x__id_t of the node found at that path in that revision. */
+  svn_cache__t *dag_path_cache;
+
   /* A cache of the contents of immutable directories; maps from
      unparsed FS ID to a apr_hash_t * mapping (const char *) dirent
      names to (svn_fs_x__dirent_t *). */
@@ -410,6 +415,13 @@ typedef struct svn_fs_x__data_t
   svn_error_t *(*svn_fs_open_)(svn_fs_t **, const char *, apr_hash_t *,
                                apr_pool_t *, apr_pool_t *);
 
+  /* I/O statistics of this FS object.  The cache access counts are not
+     tracked here but collected from CACHES on demand. */
+  svn_fs_io_stats_t io_stats;
+
+  /* All svn_cache__t instances created for this FS object. */
+  apr_array_header_t *caches;
+
 } svn_fs_x__data_t;
 
 
@@ -22,6 +22,9 @@
 #include "svn_pools.h"
 #include "svn_path.h"
 #include "svn_dirent_uri.h"
+#include "svn_sorts.h"
+
+#include "private/svn_task.h"
 
 #include "fs_x.h"
 #include "hotcopy.h"
@@ -281,15 +284,17 @@ hotcopy_copy_shard_file(svn_boolean_t *skipped_p,
 
 /* Copy a packed shard containing revision REV, and which contains
  * MAX_FILES_PER_DIR revisions, from SRC_FS to DST_FS.
- * Update *DST_MIN_UNPACKED_REV in case the shard is new in DST_FS.
  * Do not re-copy data which already exists in DST_FS.
  * Set *SKIPPED_P to FALSE only if at least one part of the shard
  * was copied, do not change the value in *SKIPPED_P otherwise.
  * SKIPPED_P may be NULL if not required.
+ *
+ * This only reads constant members of SRC_FS and DST_FS and may therefore
+ * be called from multiple threads at once.  The shard will not become
+ * visible in DST_FS before hotcopy_install_packed_shard() is called.
  * Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
 hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
-                          svn_revnum_t *dst_min_unpacked_rev,
                           svn_fs_t *src_fs,
                           svn_fs_t *dst_fs,
                           svn_revnum_t rev,
@@ -314,15 +319,102 @@ hotcopy_copy_packed_shard(svn_boolean_t *skipped_p,
                                           NULL /* cancel_func */, NULL,
                                           scratch_pool));
 
-  /* If necessary, update the min-unpacked rev file in the hotcopy. */
-  if (*dst_min_unpacked_rev < rev + max_files_per_dir)
+  return SVN_NO_ERROR;
+}
+
+/* Copy the un-packed revision and revprop files for revisions START_REV
+ * to END_REV (inclusive) from SRC_REVS_DIR to DST_REVS_DIR.  Assume a
+ * sharding layout based on MAX_FILES_PER_DIR.  Set *SKIPPED_P to FALSE
+ * only if at least one file was copied, do not change the value in
+ * *SKIPPED_P otherwise.  This may be called from multiple threads at once
+ * as long as the revision ranges cover disjoint shards.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+hotcopy_copy_unpacked_revs(svn_boolean_t *skipped_p,
+                           const char *src_revs_dir,
+                           const char *dst_revs_dir,
+                           svn_revnum_t start_rev,
+                           svn_revnum_t end_rev,
+                           int max_files_per_dir,
+                           apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t rev;
+
+  for (rev = start_rev; rev <= end_rev; rev++)
     {
-      *dst_min_unpacked_rev = rev + max_files_per_dir;
-      SVN_ERR(svn_fs_x__write_min_unpacked_rev(dst_fs,
-                                               *dst_min_unpacked_rev,
-                                               scratch_pool));
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(hotcopy_copy_shard_file(skipped_p, src_revs_dir, dst_revs_dir,
+                                      rev, max_files_per_dir, FALSE,
+                                      iterpool));
+      SVN_ERR(hotcopy_copy_shard_file(skipped_p, src_revs_dir, dst_revs_dir,
+                                      rev, max_files_per_dir, TRUE,
+                                      iterpool));
     }
 
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Flush all files directly within DIR_PATH, if that exists, as well as
+ * the directory itself and its parent to disk.  This is a no-op on
+ * non-POSIX systems where we can't fsync directories and the copied files
+ * are likely to be read-only.  Use SCRATCH_POOL for temporary allocations.
+ *
+ * Note that svn_fs_x__batch_fsync_t can't be used here because it opens
+ * all files for writing.
+ */
+static svn_error_t *
+hotcopy_flush_dir(const char *dir_path,
+                  apr_pool_t *scratch_pool)
+{
+#ifdef SVN_ON_POSIX
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+  apr_file_t *file;
+  svn_node_kind_t kind;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(svn_io_check_path(dir_path, &kind, scratch_pool));
+  if (kind != svn_node_dir)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io_get_dirents3(&dirents, dir_path, TRUE,
+                              scratch_pool, scratch_pool));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const svn_io_dirent2_t *dirent = apr_hash_this_val(hi);
+
+      svn_pool_clear(iterpool);
+      if (dirent->kind != svn_node_file)
+        continue;
+
+      SVN_ERR(svn_io_file_open(&file,
+                               svn_dirent_join(dir_path, name, iterpool),
+                               APR_READ, APR_OS_DEFAULT, iterpool));
+      SVN_ERR(svn_io_file_flush_to_disk(file, iterpool));
+      SVN_ERR(svn_io_file_close(file, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* The file names are stored in the directory and the directory name
+   * in its parent. */
+  SVN_ERR(svn_io_file_open(&file, dir_path, APR_READ, APR_OS_DEFAULT,
+                           scratch_pool));
+  SVN_ERR(svn_io_file_flush_to_disk(file, scratch_pool));
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+
+  SVN_ERR(svn_io_file_open(&file, svn_dirent_dirname(dir_path, scratch_pool),
+                           APR_READ, APR_OS_DEFAULT, scratch_pool));
+  SVN_ERR(svn_io_file_flush_to_disk(file, scratch_pool));
+  SVN_ERR(svn_io_file_close(file, scratch_pool));
+#endif
+
   return SVN_NO_ERROR;
 }
 
@@ -374,13 +466,250 @@ hotcopy_incremental_check_preconditions(svn_fs_t *src_fs,
   return SVN_NO_ERROR;
 }
 
+/* The packed shard starting at revision REV has been copied from SRC_FS
+ * to DST_FS.  Make it visible in DST_FS by updating *DST_MIN_UNPACKED_REV,
+ * the min-unpacked-rev file and - if the shard is new - the 'current' file
+ * in DST_FS, then remove the non-packed revisions that the shard replaces.
+ * DST_YOUNGEST is the youngest revision in DST_FS before the hotcopy.
+ * SKIPPED tells whether all files of the shard already existed in DST_FS.
+ * Shards must be installed strictly in revision order.
+ *
+ * MAX_FILES_PER_DIR, NOTIFY_FUNC, NOTIFY_BATON, CANCEL_FUNC and
+ * CANCEL_BATON are the same as for hotcopy_revisions().
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+hotcopy_install_packed_shard(svn_revnum_t *dst_min_unpacked_rev,
+                             svn_fs_t *dst_fs,
+                             svn_revnum_t rev,
+                             svn_revnum_t dst_youngest,
+                             svn_boolean_t skipped,
+                             int max_files_per_dir,
+                             svn_fs_hotcopy_notify_t notify_func,
+                             void* notify_baton,
+                             svn_cancel_func_t cancel_func,
+                             void* cancel_baton,
+                             apr_pool_t *scratch_pool)
+{
+  svn_revnum_t pack_end_rev = rev + max_files_per_dir - 1;
+
+  /* If necessary, update the min-unpacked rev file in the hotcopy. */
+  if (*dst_min_unpacked_rev < rev + max_files_per_dir)
+    {
+      *dst_min_unpacked_rev = rev + max_files_per_dir;
+      SVN_ERR(svn_fs_x__write_min_unpacked_rev(dst_fs,
+                                               *dst_min_unpacked_rev,
+                                               scratch_pool));
+    }
+
+  /* Whenever this pack did not previously exist in the destination,
+   * update 'current' to the most recent packed rev (so readers can see
+   * new revisions which arrived in this pack). */
+  if (pack_end_rev > dst_youngest)
+    {
+      SVN_ERR(svn_fs_x__write_current(dst_fs, pack_end_rev, scratch_pool));
+    }
+
+  /* When notifying about packed shards, make things simpler by either
+   * reporting a full revision range, i.e [pack start, pack end] or
+   * reporting nothing. There is one case when this approach might not
+   * be exact (incremental hotcopy with a pack replacing last unpacked
+   * revisions), but generally this is good enough. */
+  if (notify_func && !skipped)
+    notify_func(notify_baton, rev, pack_end_rev, scratch_pool);
+
+  /* Now that all revisions have moved into the pack, the original
+   * rev dir can be removed. */
+  SVN_ERR(svn_io_remove_dir2(svn_fs_x__path_shard(dst_fs, rev, scratch_pool),
+                             TRUE, cancel_func, cancel_baton, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* State shared by all tasks of a parallel hotcopy_revisions() run.
+ * Only the output function, i.e. the main thread, may modify it. */
+typedef struct hotcopy_revs_baton_t
+{
+  svn_fs_t *src_fs;
+  svn_fs_t *dst_fs;
+  svn_revnum_t src_youngest;
+  svn_revnum_t dst_youngest;
+  svn_revnum_t src_min_unpacked_rev;
+  svn_revnum_t dst_min_unpacked_rev;
+  const char *src_revs_dir;
+  const char *dst_revs_dir;
+  svn_fs_hotcopy_notify_t notify_func;
+  void* notify_baton;
+  svn_cancel_func_t cancel_func;
+  void* cancel_baton;
+} hotcopy_revs_baton_t;
+
+/* Process baton of a parallel hotcopy task covering the shards FIRST to
+ * LAST (inclusive) of the hotcopy described by HRB.
+ */
+typedef struct hotcopy_range_t
+{
+  hotcopy_revs_baton_t *hrb;
+  apr_int64_t first;
+  apr_int64_t last;
+} hotcopy_range_t;
+
+/* Result of copying a single shard in a parallel hotcopy. */
+typedef struct hotcopy_shard_result_t
+{
+  /* First revision in the shard. */
+  svn_revnum_t rev;
+
+  /* All files already existed in the destination. */
+  svn_boolean_t skipped;
+} hotcopy_shard_result_t;
+
+/* Add a sub-task to TASK that will copy the shards FIRST to LAST
+ * (inclusive) for the hotcopy HRB.
+ */
+static svn_error_t *
+add_hotcopy_range(svn_task__t *task,
+                  hotcopy_revs_baton_t *hrb,
+                  apr_int64_t first,
+                  apr_int64_t last)
+{
+  apr_pool_t *process_pool = svn_task__create_process_pool(task);
+  hotcopy_range_t *range = apr_pcalloc(process_pool, sizeof(*range));
+
+  range->hrb = hrb;
+  range->first = first;
+  range->last = last;
+
+  return svn_error_trace(svn_task__add_similar(task, process_pool, NULL,
+                                               range));
+}
+
+/* Implements svn_task__process_func_t.  PROCESS_BATON is a
+ * hotcopy_range_t.
+ *
+ * Ranges of more than one shard get split in halves and turned into
+ * sub-tasks.  Single shards get copied, packed or not, and flushed to
+ * disk.  Making them visible in the destination is left to the output
+ * function.
+ */
+static svn_error_t *
+hotcopy_range_process(void **result,
+                      svn_task__t *task,
+                      void *thread_context,
+                      void *process_baton,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  const hotcopy_range_t *range = process_baton;
+  const hotcopy_revs_baton_t *hrb = range->hrb;
+  svn_fs_x__data_t *src_ffd = hrb->src_fs->fsap_data;
+  svn_fs_x__data_t *dst_ffd = hrb->dst_fs->fsap_data;
+  int max_files_per_dir = src_ffd->max_files_per_dir;
+  hotcopy_shard_result_t *shard_result;
+  svn_revnum_t rev;
+
+  if (range->first < range->last)
+    {
+      apr_int64_t mid = range->first + (range->last - range->first) / 2;
+
+      SVN_ERR(add_hotcopy_range(task, range->hrb, range->first, mid));
+      SVN_ERR(add_hotcopy_range(task, range->hrb, mid + 1, range->last));
+
+      *result = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  shard_result = apr_pcalloc(result_pool, sizeof(*shard_result));
+  shard_result->skipped = TRUE;
+  rev = (svn_revnum_t)(range->first * max_files_per_dir);
+  shard_result->rev = rev;
+
+  if (rev < hrb->src_min_unpacked_rev)
+    SVN_ERR(hotcopy_copy_packed_shard(&shard_result->skipped,
+                                      hrb->src_fs, hrb->dst_fs,
+                                      rev, max_files_per_dir,
+                                      scratch_pool));
+  else
+    SVN_ERR(hotcopy_copy_unpacked_revs(&shard_result->skipped,
+                                       hrb->src_revs_dir, hrb->dst_revs_dir,
+                                       rev,
+                                       MIN(rev + max_files_per_dir - 1,
+                                           hrb->src_youngest),
+                                       max_files_per_dir, scratch_pool));
+
+  /* Everything must be on disk before the output function makes the new
+   * revisions visible in the destination. */
+  if (dst_ffd->flush_to_disk && !shard_result->skipped)
+    {
+      SVN_ERR(hotcopy_flush_dir(svn_fs_x__path_pack_shard(hrb->dst_fs, rev,
+                                                          scratch_pool),
+                                scratch_pool));
+      SVN_ERR(hotcopy_flush_dir(svn_fs_x__path_shard(hrb->dst_fs, rev,
+                                                     scratch_pool),
+                                scratch_pool));
+    }
+
+  *result = shard_result;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  RESULT is the
+ * hotcopy_shard_result_t of a shard that has been copied and OUTPUT_BATON
+ * the hotcopy_revs_baton_t.  Since this gets called in shard order, we
+ * update min-unpacked-rev and 'current' in the same order as a sequential
+ * hotcopy would.
+ */
+static svn_error_t *
+hotcopy_range_output(svn_task__t *task,
+                     void *result,
+                     void *output_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  hotcopy_revs_baton_t *hrb = output_baton;
+  const hotcopy_shard_result_t *shard_result = result;
+  svn_fs_x__data_t *src_ffd = hrb->src_fs->fsap_data;
+  int max_files_per_dir = src_ffd->max_files_per_dir;
+  svn_revnum_t rev = shard_result->rev;
+  svn_revnum_t end_rev;
+
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  if (rev < hrb->src_min_unpacked_rev)
+    return svn_error_trace(hotcopy_install_packed_shard(
+                             &hrb->dst_min_unpacked_rev, hrb->dst_fs, rev,
+                             hrb->dst_youngest, shard_result->skipped,
+                             max_files_per_dir,
+                             hrb->notify_func, hrb->notify_baton,
+                             hrb->cancel_func, hrb->cancel_baton,
+                             scratch_pool));
+
+  /* Checkpoint the progress via 'current' once new revisions arrived. */
+  end_rev = MIN(rev + max_files_per_dir - 1, hrb->src_youngest);
+  if (end_rev > hrb->dst_youngest)
+    SVN_ERR(svn_fs_x__write_current(hrb->dst_fs, end_rev, scratch_pool));
+
+  if (hrb->notify_func && !shard_result->skipped)
+    hrb->notify_func(hrb->notify_baton, rev, end_rev, scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Copy the revision and revprop files (possibly sharded / packed) from
  * SRC_FS to DST_FS.  Do not re-copy data which already exists in DST_FS.
  * When copying packed or unpacked shards, checkpoint the result in DST_FS
  * for every shard by updating the 'current' file if necessary.  Assume
  * the >= SVN_FS_FS__MIN_NO_GLOBAL_IDS_FORMAT filesystem format without
- * global next-ID counters.  Indicate progress via the optional NOTIFY_FUNC
- * callback using NOTIFY_BATON.  Use SCRATCH_POOL for temporary allocations.
+ * global next-ID counters.  Copy up to JOBS shards concurrently.
+ * Indicate progress via the optional NOTIFY_FUNC callback using
+ * NOTIFY_BATON.  Use SCRATCH_POOL for temporary allocations.
  */
 static svn_error_t *
 hotcopy_revisions(svn_fs_t *src_fs,
@@ -388,6 +717,7 @@ hotcopy_revisions(svn_fs_t *src_fs,
                   svn_revnum_t src_youngest,
                   svn_revnum_t dst_youngest,
                   svn_boolean_t incremental,
+                  int jobs,
                   const char *src_revs_dir,
                   const char *dst_revs_dir,
                   svn_fs_hotcopy_notify_t notify_func,
@@ -432,45 +762,64 @@ hotcopy_revisions(svn_fs_t *src_fs,
    */
 
   iterpool = svn_pool_create(scratch_pool);
+
+  /* Copy whole shards concurrently but make them visible in the
+   * destination strictly in revision order. */
+  if (jobs > 1)
+    {
+      hotcopy_revs_baton_t *hrb = apr_pcalloc(scratch_pool, sizeof(*hrb));
+      hotcopy_range_t *range = apr_pcalloc(scratch_pool, sizeof(*range));
+
+      hrb->src_fs = src_fs;
+      hrb->dst_fs = dst_fs;
+      hrb->src_youngest = src_youngest;
+      hrb->dst_youngest = dst_youngest;
+      hrb->src_min_unpacked_rev = src_min_unpacked_rev;
+      hrb->dst_min_unpacked_rev = dst_min_unpacked_rev;
+      hrb->src_revs_dir = src_revs_dir;
+      hrb->dst_revs_dir = dst_revs_dir;
+      hrb->notify_func = notify_func;
+      hrb->notify_baton = notify_baton;
+      hrb->cancel_func = cancel_func;
+      hrb->cancel_baton = cancel_baton;
+
+      range->hrb = hrb;
+      range->first = 0;
+      range->last = src_youngest / max_files_per_dir;
+
+      SVN_ERR(svn_task__run(jobs,
+                            hotcopy_range_process, range,
+                            hotcopy_range_output, hrb,
+                            NULL, NULL,
+                            cancel_func, cancel_baton,
+                            scratch_pool, iterpool));
+      svn_pool_destroy(iterpool);
+
+      SVN_ERR_ASSERT(src_min_unpacked_rev == hrb->dst_min_unpacked_rev);
+
+      return SVN_NO_ERROR;
+    }
+
   /* First, copy packed shards. */
   for (rev = 0; rev < src_min_unpacked_rev; rev += max_files_per_dir)
     {
       svn_boolean_t skipped = TRUE;
-      svn_revnum_t pack_end_rev;
 
       svn_pool_clear(iterpool);
 
       if (cancel_func)
         SVN_ERR(cancel_func(cancel_baton));
 
-      /* Copy the packed shard. */
-      SVN_ERR(hotcopy_copy_packed_shard(&skipped, &dst_min_unpacked_rev,
-                                        src_fs, dst_fs,
+      /* Copy the packed shard and make it visible in the destination. */
+      SVN_ERR(hotcopy_copy_packed_shard(&skipped, src_fs, dst_fs,
                                         rev, max_files_per_dir,
                                         iterpool));
-
-      pack_end_rev = rev + max_files_per_dir - 1;
-
-      /* Whenever this pack did not previously exist in the destination,
-       * update 'current' to the most recent packed rev (so readers can see
-       * new revisions which arrived in this pack). */
-      if (pack_end_rev > dst_youngest)
-        {
-          SVN_ERR(svn_fs_x__write_current(dst_fs, pack_end_rev, iterpool));
-        }
-
-      /* When notifying about packed shards, make things simpler by either
-       * reporting a full revision range, i.e [pack start, pack end] or
-       * reporting nothing. There is one case when this approach might not
-       * be exact (incremental hotcopy with a pack replacing last unpacked
-       * revisions), but generally this is good enough. */
-      if (notify_func && !skipped)
-        notify_func(notify_baton, rev, pack_end_rev, iterpool);
-
-      /* Now that all revisions have moved into the pack, the original
-       * rev dir can be removed. */
-      SVN_ERR(svn_io_remove_dir2(svn_fs_x__path_shard(dst_fs, rev, iterpool),
-                                 TRUE, cancel_func, cancel_baton, iterpool));
+      SVN_ERR(hotcopy_install_packed_shard(&dst_min_unpacked_rev, dst_fs,
+                                           rev, dst_youngest, skipped,
+                                           max_files_per_dir,
+                                           notify_func, notify_baton,
+                                           cancel_func, cancel_baton,
+                                           iterpool));
     }
 
   if (cancel_func)
@@ -540,6 +889,7 @@ typedef struct hotcopy_body_baton_t {
   svn_fs_t *src_fs;
   svn_fs_t *dst_fs;
   svn_boolean_t incremental;
+  int jobs;
   svn_fs_hotcopy_notify_t notify_func;
   void *notify_baton;
   svn_cancel_func_t cancel_func;
@@ -629,7 +979,8 @@ hotcopy_body(void *baton,
    * care when updating the 'current' file (which contains not just the
    * revision number, but also the next-ID counters). */
   SVN_ERR(hotcopy_revisions(src_fs, dst_fs, src_youngest, dst_youngest,
-                            incremental, src_revs_dir, dst_revs_dir,
+                            incremental, hbb->jobs,
+                            src_revs_dir, dst_revs_dir,
                             notify_func, notify_baton,
                             cancel_func, cancel_baton, scratch_pool));
   SVN_ERR(svn_fs_x__write_current(dst_fs, src_youngest, scratch_pool));
@@ -694,6 +1045,7 @@ svn_fs_x__hotcopy(svn_fs_t *src_fs,
                   const char *src_path,
                   const char *dst_path,
                   svn_boolean_t incremental,
+                  int jobs,
                   svn_fs_hotcopy_notify_t notify_func,
                   void *notify_baton,
                   svn_cancel_func_t cancel_func,
@@ -773,6 +1125,7 @@ svn_fs_x__hotcopy(svn_fs_t *src_fs,
   hbb.src_fs = src_fs;
   hbb.dst_fs = dst_fs;
   hbb.incremental = incremental;
+  hbb.jobs = jobs;
   hbb.notify_func = notify_func;
   hbb.notify_baton = notify_baton;
   hbb.cancel_func = cancel_func;
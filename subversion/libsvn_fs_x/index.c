@@ -3113,6 +3113,7 @@ svn_fs_x__p2l_index_lookup(apr_array_header_t **entries,
                            apr_pool_t *result_pool,
                            apr_pool_t *scratch_pool)
 {
+  svn_fs_x__data_t *ffd = fs->fsap_data;
   apr_off_t block_end = block_start + block_size;
 
   /* the receiving container */
@@ -3148,6 +3149,7 @@ svn_fs_x__p2l_index_lookup(apr_array_header_t **entries,
       last_count = result->nelts;
     }
 
+  ffd->io_stats.index_lookups++;
   *entries = result;
   return SVN_NO_ERROR;
 }
@@ -3272,6 +3274,9 @@ svn_fs_x__p2l_entry_lookup(svn_fs_x__p2l_entry_t **entry_p,
                            apr_pool_t *result_pool,
                            apr_pool_t *scratch_pool)
 {
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+  ffd->io_stats.index_lookups++;
+
   /* look for this info in our cache */
   SVN_ERR(p2l_entry_lookup(entry_p, rev_file, fs, revision, offset,
                            result_pool, scratch_pool));
@@ -3426,9 +3431,14 @@ svn_fs_x__item_offset(apr_off_t *absolute_position,
                                    svn_fs_x__get_txn_id(item_id->change_set),
                                    item_id->number, scratch_pool));
   else
-    SVN_ERR(l2p_index_lookup(absolute_position, sub_item, fs, rev_file,
-                             svn_fs_x__get_revnum(item_id->change_set),
-                             item_id->number, scratch_pool));
+    {
+      svn_fs_x__data_t *ffd = fs->fsap_data;
+
+      SVN_ERR(l2p_index_lookup(absolute_position, sub_item, fs, rev_file,
+                               svn_fs_x__get_revnum(item_id->change_set),
+                               item_id->number, scratch_pool));
+      ffd->io_stats.index_lookups++;
+    }
 
   return SVN_NO_ERROR;
 }
@@ -27,6 +27,7 @@
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
+#include "private/svn_task.h"
 #include "private/svn_temp_serializer.h"
 
 #include "fs_x.h"
@@ -2049,6 +2050,27 @@ pack_rev_shard(svn_fs_t *fs,
   return SVN_NO_ERROR;
 }
 
+/* Return the paths of the pack directory *PACK_FILE_DIR and of the
+ * non-packed *SHARD_PATH for SHARD in the revs folder DIR.  Allocate
+ * the results in RESULT_POOL.
+ */
+static void
+get_shard_paths(const char **pack_file_dir,
+                const char **shard_path,
+                const char *dir,
+                apr_int64_t shard,
+                apr_pool_t *result_pool)
+{
+  *pack_file_dir = svn_dirent_join(dir,
+                  apr_psprintf(result_pool,
+                               "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
+                               shard),
+                  result_pool);
+  *shard_path = svn_dirent_join(dir,
+                      apr_psprintf(result_pool, "%" APR_INT64_T_FMT, shard),
+                      result_pool);
+}
+
 /* In the file system at FS_PATH, pack the SHARD in DIR containing exactly
  * MAX_FILES_PER_DIR revisions, using SCRATCH_POOL temporary for allocations.
  * COMPRESSION_LEVEL and MAX_PACK_SIZE will be ignored in that case.
@@ -2059,6 +2081,9 @@ pack_rev_shard(svn_fs_t *fs,
  *
  * If for some reason we detect a partial packing already performed, we
  * remove the pack file and start again.
+ *
+ * If CONTENT_PACKED is set, the revision contents have already been packed
+ * and made durable by some worker and only the remaining steps are left.
  */
 static svn_error_t *
 pack_shard(const char *dir,
@@ -2068,6 +2093,7 @@ pack_shard(const char *dir,
            apr_off_t max_pack_size,
            int compression_level,
            apr_size_t max_mem,
+           svn_boolean_t content_packed,
            svn_fs_pack_notify_t notify_func,
            void *notify_baton,
            svn_cancel_func_t cancel_func,
@@ -2088,19 +2114,13 @@ pack_shard(const char *dir,
                                        scratch_pool));
 
   /* Some useful paths. */
-  pack_file_dir = svn_dirent_join(dir,
-                  apr_psprintf(scratch_pool,
-                               "%" APR_INT64_T_FMT PATH_EXT_PACKED_SHARD,
-                               shard),
-                  scratch_pool);
-  shard_path = svn_dirent_join(dir,
-                      apr_psprintf(scratch_pool, "%" APR_INT64_T_FMT, shard),
-                      scratch_pool);
+  get_shard_paths(&pack_file_dir, &shard_path, dir, shard, scratch_pool);
 
   /* pack the revision content */
-  SVN_ERR(pack_rev_shard(fs, pack_file_dir, shard_path,
-                         shard, max_files_per_dir, max_mem, batch,
-                         cancel_func, cancel_baton, scratch_pool));
+  if (!content_packed)
+    SVN_ERR(pack_rev_shard(fs, pack_file_dir, shard_path,
+                           shard, max_files_per_dir, max_mem, batch,
+                           cancel_func, cancel_baton, scratch_pool));
 
   /* pack the revprops in an equivalent way */
   SVN_ERR(svn_fs_x__pack_revprops_shard(fs,
@@ -2165,12 +2185,156 @@ typedef struct pack_baton_t
 {
   svn_fs_t *fs;
   apr_size_t max_mem;
+  int jobs;
+  const char *data_path;
   svn_fs_pack_notify_t notify_func;
   void *notify_baton;
   svn_cancel_func_t cancel_func;
   void *cancel_baton;
 } pack_baton_t;
 
+/* Process baton of a parallel pack task covering the shards FIRST to LAST
+ * (inclusive).  The shared state is in PB and must not be modified by the
+ * process function.
+ */
+typedef struct pack_range_t
+{
+  pack_baton_t *pb;
+  apr_int64_t first;
+  apr_int64_t last;
+} pack_range_t;
+
+/* Implements svn_task__thread_context_constructor_t.  The thread context
+ * is the svn_fs_t instance to read from.  CONTEXT_BATON is the
+ * pack_baton_t *.
+ */
+static svn_error_t *
+pack_context_constructor(void **thread_context,
+                         void *context_baton,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  pack_baton_t *pb = context_baton;
+  svn_fs_t *fs = pb->fs;
+
+  /* Worker threads must not share the svn_fs_t with the main thread. */
+  if (pb->jobs > 1)
+    SVN_ERR(svn_fs_x__open_instance(&fs, pb->fs, result_pool,
+                                    scratch_pool));
+
+  *thread_context = fs;
+  return SVN_NO_ERROR;
+}
+
+/* Add a sub-task to TASK that will pack the shards FIRST to LAST
+ * (inclusive) for the pack operation PB.
+ */
+static svn_error_t *
+add_pack_range(svn_task__t *task,
+               pack_baton_t *pb,
+               apr_int64_t first,
+               apr_int64_t last)
+{
+  apr_pool_t *process_pool = svn_task__create_process_pool(task);
+  pack_range_t *range = apr_pcalloc(process_pool, sizeof(*range));
+
+  range->pb = pb;
+  range->first = first;
+  range->last = last;
+
+  return svn_error_trace(svn_task__add_similar(task, process_pool, NULL,
+                                               range));
+}
+
+/* Implements svn_task__process_func_t.  PROCESS_BATON is a pack_range_t
+ * and THREAD_CONTEXT the svn_fs_t to read from.
+ *
+ * Ranges of more than one shard get split in halves and turned into
+ * sub-tasks.  For single shards, create the pack file with all its
+ * containers and indexes, make it durable and return the shard number
+ * as the result.  Packing the revprops and switching the repository over
+ * to the packed shard is left to the output function.
+ */
+static svn_error_t *
+pack_range_process(void **result,
+                   svn_task__t *task,
+                   void *thread_context,
+                   void *process_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  const pack_range_t *range = process_baton;
+  svn_fs_t *fs = thread_context;
+  svn_fs_x__data_t *ffd = fs->fsap_data;
+  svn_fs_x__batch_fsync_t *batch;
+  apr_int64_t *shard;
+  const char *pack_file_dir, *shard_path;
+
+  if (range->first < range->last)
+    {
+      apr_int64_t mid = range->first + (range->last - range->first) / 2;
+
+      SVN_ERR(add_pack_range(task, range->pb, range->first, mid));
+      SVN_ERR(add_pack_range(task, range->pb, mid + 1, range->last));
+
+      *result = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_fs_x__batch_fsync_create(&batch, ffd->flush_to_disk,
+                                       scratch_pool));
+  get_shard_paths(&pack_file_dir, &shard_path, range->pb->data_path,
+                  range->first, scratch_pool);
+
+  /* All jobs share the same memory budget. */
+  SVN_ERR(pack_rev_shard(fs, pack_file_dir, shard_path,
+                         range->first, ffd->max_files_per_dir,
+                         range->pb->max_mem / range->pb->jobs, batch,
+                         cancel_func, cancel_baton, scratch_pool));
+  SVN_ERR(svn_fs_x__batch_fsync_run(batch, scratch_pool));
+
+  shard = apr_palloc(result_pool, sizeof(*shard));
+  *shard = range->first;
+  *result = shard;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  RESULT is the number of the shard
+ * whose revision contents got packed and OUTPUT_BATON the pack_baton_t *.
+ * Since this gets called in shard order, we finish the shards in the same
+ * order as a sequential pack would.
+ */
+static svn_error_t *
+pack_range_output(svn_task__t *task,
+                  void *result,
+                  void *output_baton,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  pack_baton_t *pb = output_baton;
+  svn_fs_x__data_t *ffd = pb->fs->fsap_data;
+
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  return svn_error_trace(pack_shard(pb->data_path,
+                                    pb->fs, *(apr_int64_t *)result,
+                                    ffd->max_files_per_dir,
+                                    ffd->revprop_pack_size,
+                                    ffd->compress_packed_revprops
+                                      ? SVN__COMPRESSION_ZLIB_DEFAULT
+                                      : SVN__COMPRESSION_NONE,
+                                    pb->max_mem, TRUE,
+                                    pb->notify_func, pb->notify_baton,
+                                    cancel_func, cancel_baton,
+                                    scratch_pool));
+}
+
 
 /* The work-horse for svn_fs_x__pack, called with the FS write lock.
    This implements the svn_fs_x__with_write_lock() 'body' callback
@@ -2195,7 +2359,6 @@ pack_body(void *baton,
   apr_int64_t completed_shards;
   apr_int64_t i;
   apr_pool_t *iterpool;
-  const char *data_path;
   svn_boolean_t fully_packed;
 
   /* Since another process might have already packed the repo,
@@ -2212,27 +2375,46 @@ pack_body(void *baton,
     }
 
   completed_shards = (ffd->youngest_rev_cache + 1) / ffd->max_files_per_dir;
-  data_path = svn_dirent_join(pb->fs->path, PATH_REVS_DIR, scratch_pool);
+  pb->data_path = svn_dirent_join(pb->fs->path, PATH_REVS_DIR, scratch_pool);
 
   iterpool = svn_pool_create(scratch_pool);
-  for (i = ffd->min_unpacked_rev / ffd->max_files_per_dir;
-       i < completed_shards;
-       i++)
+  if (pb->jobs > 1)
     {
-      svn_pool_clear(iterpool);
+      /* Build the pack files of multiple shards at once but switch over
+       * to the packed data strictly in order. */
+      pack_range_t *range = apr_pcalloc(scratch_pool, sizeof(*range));
+      range->pb = pb;
+      range->first = ffd->min_unpacked_rev / ffd->max_files_per_dir;
+      range->last = completed_shards - 1;
+
+      SVN_ERR(svn_task__run(pb->jobs,
+                            pack_range_process, range,
+                            pack_range_output, pb,
+                            pack_context_constructor, pb,
+                            pb->cancel_func, pb->cancel_baton,
+                            scratch_pool, iterpool));
+    }
+  else
+    {
+      for (i = ffd->min_unpacked_rev / ffd->max_files_per_dir;
+           i < completed_shards;
+           i++)
+        {
+          svn_pool_clear(iterpool);
 
-      if (pb->cancel_func)
-        SVN_ERR(pb->cancel_func(pb->cancel_baton));
-
-      SVN_ERR(pack_shard(data_path,
-                         pb->fs, i, ffd->max_files_per_dir,
-                         ffd->revprop_pack_size,
-                         ffd->compress_packed_revprops
-                           ? SVN__COMPRESSION_ZLIB_DEFAULT
-                           : SVN__COMPRESSION_NONE,
-                         pb->max_mem,
-                         pb->notify_func, pb->notify_baton,
-                         pb->cancel_func, pb->cancel_baton, iterpool));
+          if (pb->cancel_func)
+            SVN_ERR(pb->cancel_func(pb->cancel_baton));
+
+          SVN_ERR(pack_shard(pb->data_path,
+                             pb->fs, i, ffd->max_files_per_dir,
+                             ffd->revprop_pack_size,
+                             ffd->compress_packed_revprops
+                               ? SVN__COMPRESSION_ZLIB_DEFAULT
+                               : SVN__COMPRESSION_NONE,
+                             pb->max_mem, FALSE,
+                             pb->notify_func, pb->notify_baton,
+                             pb->cancel_func, pb->cancel_baton, iterpool));
+        }
     }
 
   svn_pool_destroy(iterpool);
@@ -2242,6 +2424,7 @@ pack_body(void *baton,
 svn_error_t *
 svn_fs_x__pack(svn_fs_t *fs,
                apr_size_t max_mem,
+               int jobs,
                svn_fs_pack_notify_t notify_func,
                void *notify_baton,
                svn_cancel_func_t cancel_func,
@@ -2272,6 +2455,7 @@ svn_fs_x__pack(svn_fs_t *fs,
   pb.cancel_func = cancel_func;
   pb.cancel_baton = cancel_baton;
   pb.max_mem = max_mem ? max_mem : DEFAULT_MAX_MEM;
+  pb.jobs = MAX(jobs, 1);
 
   return svn_fs_x__with_pack_lock(fs, pack_body, &pb, scratch_pool);
 }
@@ -32,6 +32,9 @@
    MAX_MEM limits the size of in-memory data structures needed for reordering
    items.  0 means use the built-in default.
 
+   Up to JOBS shards will be packed concurrently, sharing the MAX_MEM
+   budget.  Shards still get switched over in order.
+
    Use optional CANCEL_FUNC/CANCEL_BATON for cancellation support.
    Use SCRATCH_POOL for temporary allocations.
 
@@ -39,6 +42,7 @@
 svn_error_t *
 svn_fs_x__pack(svn_fs_t *fs,
                apr_size_t max_mem,
+               int jobs,
                svn_fs_pack_notify_t notify_func,
                void *notify_baton,
                svn_cancel_func_t cancel_func,
@@ -226,10 +226,13 @@ open_pack_or_rev_file(svn_fs_x__revision_file_t *file,
 
       if (!err)
         {
+          svn_fs_x__data_t *ffd = fs->fsap_data;
+
           file->file = apr_file;
           file->stream = svn_stream_from_aprfile2(apr_file, TRUE,
                                                   file_pool);
 
+          ffd->io_stats.files_opened++;
           return SVN_NO_ERROR;
         }
 
@@ -170,6 +170,27 @@ match_length(const svn_string_t *lhs,
   return (apr_uint16_t)svn_cstring__match_length(lhs->data, rhs->data, len);
 }
 
+/* Compare LHS and RHS in byte-wise lexicographical order and return the
+   result like strcmp would.  Set *MATCH_LEN to the length of their common
+   prefix.  Avoids scanning the strings a second time for the match length
+   and lets us profit from the chunky svn_cstring__match_length.  Unlike
+   strcmp, this also handles strings with embedded NULs correctly. */
+static int
+compare_strings(apr_uint16_t *match_len,
+                const svn_string_t *lhs,
+                const svn_string_t *rhs)
+{
+  apr_size_t len = MIN(lhs->len, rhs->len);
+  apr_size_t matched = svn_cstring__match_length(lhs->data, rhs->data, len);
+  *match_len = (apr_uint16_t)matched;
+
+  if (matched < len)
+    return (int)(unsigned char)lhs->data[matched]
+         - (int)(unsigned char)rhs->data[matched];
+
+  return lhs->len < rhs->len ? -1 : (lhs->len > rhs->len ? 1 : 0);
+}
+
 static apr_uint16_t
 insert_string(builder_table_t *table,
               builder_string_t **parent,
@@ -177,7 +198,9 @@ insert_string(builder_table_t *table,
 {
   apr_uint16_t result;
   builder_string_t *current = *parent;
-  int diff = strcmp(current->string.data, to_insert->string.data);
+  apr_uint16_t current_match_len;
+  int diff = compare_strings(&current_match_len, &current->string,
+                             &to_insert->string);
   if (diff == 0)
     {
       apr_array_pop(table->short_strings);
@@ -208,8 +231,7 @@ insert_string(builder_table_t *table,
             }
 
           current->previous = to_insert;
-          to_insert->next_match_len
-            = match_length(&current->string, &to_insert->string);
+          to_insert->next_match_len = current_match_len;
           current->previous_match_len = to_insert->next_match_len;
 
           table->max_data_size -= to_insert->string.len;
@@ -248,8 +270,7 @@ insert_string(builder_table_t *table,
             }
 
           current->next = current->right;
-          to_insert->previous_match_len
-            = match_length(&current->string, &to_insert->string);
+          to_insert->previous_match_len = current_match_len;
           current->next_match_len = to_insert->previous_match_len;
 
           table->max_data_size -= to_insert->string.len;
@@ -2316,8 +2316,8 @@ rep_write_get_baton(rep_write_baton_t **wb_p,
                           ffd->delta_compression_level,
                           result_pool);
 
-  b->delta_stream = svn_txdelta_target_push(wh, whb, source,
-                                            b->result_pool);
+  b->delta_stream = svn_txdelta_target_push2(wh, whb, source, FALSE,
+                                             b->result_pool);
 
   *wb_p = b;
 
@@ -2926,8 +2926,8 @@ write_container_delta_rep(svn_fs_x__representation_t *rep,
                           scratch_pool);
 
   whb = apr_pcalloc(scratch_pool, sizeof(*whb));
-  whb->stream = svn_txdelta_target_push(diff_wh, diff_whb, source,
-                                        scratch_pool);
+  whb->stream = svn_txdelta_target_push2(diff_wh, diff_whb, source, FALSE,
+                                         scratch_pool);
   whb->size = 0;
   whb->md5_ctx = svn_checksum_ctx_create(svn_checksum_md5, scratch_pool);
   if (item_type != SVN_FS_X__ITEM_TYPE_DIR_REP)
@@ -0,0 +1,385 @@
+/*
+ * cache.c:  persistent client-side cache of immutable repository data
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_pools.h>
+
+#include "svn_checksum.h"
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+
+#include "private/svn_ra_private.h"
+#include "private/svn_sorts_private.h"
+
+#include "svn_private_config.h"
+
+/* Every entry is a file named after the SHA1 of its key, in a sub-
+ * directory named after the first two digits of that checksum.  Entries
+ * get written to a temporary file in the cache directory first and then
+ * renamed into place, so readers never see partial entries, not even
+ * from other processes.
+ *
+ * The mtime of an entry is the time it was last used.  Once the entries
+ * exceed the size limit, the least recently used ones get removed until
+ * the total size has dropped to EVICT_TO_PERCENT of the limit.
+ */
+#define EVICT_TO_PERCENT 75
+
+struct svn_ra__cache_t
+{
+  /* Directory of the cache. */
+  const char *dir_abspath;
+
+  /* Size limit in bytes. */
+  apr_int64_t max_size;
+
+  /* Total size of the entries in bytes, or -1 if we have not looked yet.
+   * Other processes may add or remove entries, so this is an estimate. */
+  apr_int64_t size;
+};
+
+svn_error_t *
+svn_ra__cache_create(svn_ra__cache_t **cache_p,
+                     const char *dir_abspath,
+                     apr_int64_t max_size,
+                     apr_pool_t *result_pool)
+{
+  svn_ra__cache_t *cache = apr_pcalloc(result_pool, sizeof(*cache));
+
+  SVN_ERR(svn_io_make_dir_recursively(dir_abspath, result_pool));
+
+  cache->dir_abspath = apr_pstrdup(result_pool, dir_abspath);
+  cache->max_size = max_size;
+  cache->size = -1;
+
+  *cache_p = cache;
+
+  return SVN_NO_ERROR;
+}
+
+svn_ra__cache_t *
+svn_ra__cache_dup(const svn_ra__cache_t *cache,
+                  apr_pool_t *result_pool)
+{
+  svn_ra__cache_t *new_cache = apr_pmemdup(result_pool, cache,
+                                           sizeof(*cache));
+
+  new_cache->dir_abspath = apr_pstrdup(result_pool, cache->dir_abspath);
+
+  return new_cache;
+}
+
+/* Set *SUBDIR_ABSPATH and *ENTRY_ABSPATH to the location of the entry
+ * for KEY in CACHE, allocated in RESULT_POOL. */
+static svn_error_t *
+entry_path(const char **subdir_abspath,
+           const char **entry_abspath,
+           svn_ra__cache_t *cache,
+           const char *key,
+           apr_pool_t *result_pool)
+{
+  svn_checksum_t *checksum;
+  const char *digest;
+
+  SVN_ERR(svn_checksum(&checksum, svn_checksum_sha1, key, strlen(key),
+                       result_pool));
+  digest = svn_checksum_to_cstring_display(checksum, result_pool);
+
+  *subdir_abspath = svn_dirent_join(cache->dir_abspath,
+                                    apr_pstrmemdup(result_pool, digest, 2),
+                                    result_pool);
+  *entry_abspath = svn_dirent_join(*subdir_abspath, digest, result_pool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra__cache_get(svn_stream_t **stream_p,
+                  svn_ra__cache_t *cache,
+                  const char *key,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  const char *subdir_abspath;
+  const char *entry_abspath;
+  svn_error_t *err;
+
+  SVN_ERR(entry_path(&subdir_abspath, &entry_abspath, cache, key,
+                     scratch_pool));
+
+  err = svn_stream_open_readonly(stream_p, entry_abspath, result_pool,
+                                 scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *stream_p = NULL;
+
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  /* Remember the use for eviction.  This is just a hint, so don't let
+   * it fail the read. */
+  svn_error_clear(svn_io_set_file_affected_time(apr_time_now(),
+                                                entry_abspath,
+                                                scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* An entry for the cache directory in the LRU order. */
+typedef struct cache_entry_t
+{
+  const char *abspath;
+  svn_filesize_t size;
+  apr_time_t mtime;
+} cache_entry_t;
+
+/* Order cache_entry_t * by increasing MTIME. */
+static int
+compare_entries(const void *a, const void *b)
+{
+  const cache_entry_t *lhs = *(const cache_entry_t * const *)a;
+  const cache_entry_t *rhs = *(const cache_entry_t * const *)b;
+
+  if (lhs->mtime == rhs->mtime)
+    return 0;
+
+  return lhs->mtime < rhs->mtime ? -1 : 1;
+}
+
+/* Set *ENTRIES to all entries in CACHE and *SIZE to their total size.
+ * Allocate the result in RESULT_POOL. */
+static svn_error_t *
+read_entries(apr_array_header_t **entries,
+             apr_int64_t *size,
+             svn_ra__cache_t *cache,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  apr_hash_t *subdirs;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  *entries = apr_array_make(result_pool, 64, sizeof(cache_entry_t *));
+  *size = 0;
+
+  SVN_ERR(svn_io_get_dirents3(&subdirs, cache->dir_abspath, TRUE,
+                              scratch_pool, scratch_pool));
+
+  for (hi = apr_hash_first(scratch_pool, subdirs); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const svn_io_dirent2_t *dirent = apr_hash_this_val(hi);
+      const char *subdir_abspath;
+      apr_hash_t *files;
+      apr_hash_index_t *hi2;
+      svn_error_t *err;
+
+      /* Skip the temporary files of entries being written. */
+      if (dirent->kind != svn_node_dir)
+        continue;
+
+      svn_pool_clear(iterpool);
+
+      subdir_abspath = svn_dirent_join(cache->dir_abspath, name, iterpool);
+      err = svn_io_get_dirents3(&files, subdir_abspath, FALSE,
+                                iterpool, iterpool);
+
+      /* Another process might have emptied and removed the directory. */
+      if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+        {
+          svn_error_clear(err);
+          continue;
+        }
+      SVN_ERR(err);
+
+      for (hi2 = apr_hash_first(iterpool, files); hi2; hi2 = apr_hash_next(hi2))
+        {
+          const svn_io_dirent2_t *file = apr_hash_this_val(hi2);
+          cache_entry_t *entry;
+
+          if (file->kind != svn_node_file)
+            continue;
+
+          entry = apr_palloc(result_pool, sizeof(*entry));
+          entry->abspath = svn_dirent_join(subdir_abspath,
+                                           apr_hash_this_key(hi2),
+                                           result_pool);
+          entry->size = file->filesize;
+          entry->mtime = file->mtime;
+
+          APR_ARRAY_PUSH(*entries, cache_entry_t *) = entry;
+          *size += entry->size;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove the least recently used entries from CACHE until it is well
+ * below its size limit.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+evict_entries(svn_ra__cache_t *cache,
+              apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *entries;
+  apr_int64_t target = cache->max_size / 100 * EVICT_TO_PERCENT;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  SVN_ERR(read_entries(&entries, &cache->size, cache,
+                       scratch_pool, scratch_pool));
+  svn_sort__array(entries, compare_entries);
+
+  for (i = 0; i < entries->nelts && cache->size > target; i++)
+    {
+      const cache_entry_t *entry = APR_ARRAY_IDX(entries, i, cache_entry_t *);
+
+      svn_pool_clear(iterpool);
+
+      /* Another process may have been faster. */
+      SVN_ERR(svn_io_remove_file2(entry->abspath, TRUE, iterpool));
+      cache->size -= entry->size;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton of the stream returned by svn_ra__cache_put(). */
+typedef struct put_baton_t
+{
+  svn_ra__cache_t *cache;
+  svn_stream_t *tmp_stream;
+  const char *tmp_abspath;
+  const char *subdir_abspath;
+  const char *entry_abspath;
+  apr_int64_t size;
+
+  /* Set once writing the temporary file failed. */
+  svn_boolean_t failed;
+
+  apr_pool_t *pool;
+} put_baton_t;
+
+/* Implements svn_write_fn_t.  A full disk or the like only means that
+ * the entry does not get added, so don't pass errors on. */
+static svn_error_t *
+put_write(void *baton,
+          const char *data,
+          apr_size_t *len)
+{
+  put_baton_t *b = baton;
+  apr_size_t written = *len;
+  svn_error_t *err;
+
+  if (b->failed)
+    return SVN_NO_ERROR;
+
+  err = svn_stream_write(b->tmp_stream, data, &written);
+  if (err)
+    {
+      svn_error_clear(err);
+      b->failed = TRUE;
+    }
+
+  b->size += written;
+
+  return SVN_NO_ERROR;
+}
+
+/* Move the temporary file of B into place and evict entries if needed. */
+static svn_error_t *
+install_entry(put_baton_t *b)
+{
+  svn_ra__cache_t *cache = b->cache;
+
+  SVN_ERR(svn_stream_close(b->tmp_stream));
+
+  if (b->failed)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io_make_dir_recursively(b->subdir_abspath, b->pool));
+  SVN_ERR(svn_io_file_rename2(b->tmp_abspath, b->entry_abspath, FALSE,
+                              b->pool));
+
+  if (cache->size < 0)
+    {
+      apr_array_header_t *entries;
+
+      SVN_ERR(read_entries(&entries, &cache->size, cache, b->pool, b->pool));
+    }
+  else
+    {
+      cache->size += b->size;
+    }
+
+  if (cache->size > cache->max_size)
+    SVN_ERR(evict_entries(cache, b->pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t.  Like put_write(), this never fails. */
+static svn_error_t *
+put_close(void *baton)
+{
+  svn_error_clear(install_entry(baton));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra__cache_put(svn_stream_t **stream_p,
+                  svn_ra__cache_t *cache,
+                  const char *key,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  put_baton_t *b = apr_pcalloc(result_pool, sizeof(*b));
+
+  b->cache = cache;
+  b->pool = result_pool;
+  SVN_ERR(entry_path(&b->subdir_abspath, &b->entry_abspath, cache, key,
+                     result_pool));
+
+  /* The temporary file disappears with RESULT_POOL unless the stream gets
+   * closed and it was renamed into place. */
+  SVN_ERR(svn_stream_open_unique(&b->tmp_stream, &b->tmp_abspath,
+                                 cache->dir_abspath,
+                                 svn_io_file_del_on_pool_cleanup,
+                                 result_pool, scratch_pool));
+
+  *stream_p = svn_stream_create(b, result_pool);
+  svn_stream_set_write(*stream_p, put_write);
+  svn_stream_set_close(*stream_p, put_close);
+
+  return SVN_NO_ERROR;
+}
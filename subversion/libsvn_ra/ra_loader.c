@@ -41,6 +41,7 @@
 #include "svn_error_codes.h"
 #include "svn_pools.h"
 #include "svn_delta.h"
+#include "svn_dirent_uri.h"
 #include "svn_ra.h"
 #include "svn_xml.h"
 #include "svn_path.h"
@@ -54,6 +55,7 @@
 
 #include "private/svn_auth_private.h"
 #include "private/svn_ra_private.h"
+#include "private/svn_skel.h"
 #include "svn_private_config.h"
 
 
@@ -65,7 +67,7 @@
  * (Currently, this applies to the https scheme, which is only
  * available if SSL is supported.) */
 static const char * const dav_schemes[] = { "http", "https", NULL };
-static const char * const svn_schemes[] = { "svn", NULL };
+static const char * const svn_schemes[] = { "svn", "svns", NULL };
 static const char * const local_schemes[] = { "file", NULL };
 
 static const struct ra_lib_defn {
@@ -256,6 +258,57 @@ svn_ra_create_callbacks(svn_ra_callbacks2_t **callbacks,
   return SVN_NO_ERROR;
 }
 
+/* Set SESSION->CACHE as configured in CONFIG for a session to REPOS_URL.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+open_cache(svn_ra_session_t *session,
+           const char *repos_URL,
+           apr_hash_t *config,
+           apr_pool_t *scratch_pool)
+{
+  svn_config_t *cfg = config ? svn_hash_gets(config,
+                                             SVN_CONFIG_CATEGORY_CONFIG)
+                             : NULL;
+  apr_int64_t cache_size;
+  const char *cache_dir;
+  svn_error_t *err;
+
+  /* Reading a local repository is about as fast as reading the cache. */
+  if (has_scheme_of(local_schemes, repos_URL))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_config_get_int64(cfg, &cache_size,
+                               SVN_CONFIG_SECTION_MISCELLANY,
+                               SVN_CONFIG_OPTION_RA_CACHE_SIZE, 0));
+  if (cache_size <= 0)
+    return SVN_NO_ERROR;
+
+  svn_config_get(cfg, &cache_dir, SVN_CONFIG_SECTION_MISCELLANY,
+                 SVN_CONFIG_OPTION_RA_CACHE_DIR, NULL);
+  if (cache_dir)
+    SVN_ERR(svn_dirent_get_absolute(&cache_dir,
+                                    svn_dirent_internal_style(cache_dir,
+                                                              scratch_pool),
+                                    scratch_pool));
+  else
+    SVN_ERR(svn_config_get_user_config_path(&cache_dir, NULL, "ra-cache",
+                                            scratch_pool));
+
+  if (!cache_dir)
+    return SVN_NO_ERROR;
+
+  /* Work without the cache rather than not at all. */
+  err = svn_ra__cache_create(&session->cache, cache_dir,
+                             cache_size * 1024 * 1024, session->pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      session->cache = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *svn_ra_open5(svn_ra_session_t **session_p,
                           const char **corrected_url_p,
                           const char **redirect_url_p,
@@ -434,6 +487,8 @@ svn_error_t *svn_ra_open5(svn_ra_session_t **session_p,
         }
     }
 
+  SVN_ERR(open_cache(session, repos_URL, config, scratch_pool));
+
   svn_pool_destroy(scratch_pool);
   *session_p = session;
   return SVN_NO_ERROR;
@@ -468,6 +523,9 @@ svn_ra__dup_session(svn_ra_session_t **new_session,
   session->vtable = old_session->vtable;
   session->pool = result_pool;
 
+  if (old_session->cache)
+    session->cache = svn_ra__cache_dup(old_session->cache, result_pool);
+
   SVN_ERR(old_session->vtable->dup_session(session,
                                            old_session,
                                            session_url,
@@ -621,6 +679,144 @@ svn_error_t *svn_ra_get_commit_editor3(svn_ra_session_t *session,
                                             lock_tokens, keep_locks, pool);
 }
 
+/* Set *KEY to the key of the data of kind KIND for PATH in REVISION in
+   the cache of SESSION.  PATH is relative to the session URL.  Allocate
+   the result in POOL. */
+static svn_error_t *
+get_cache_key(const char **key,
+              svn_ra_session_t *session,
+              const char *kind,
+              const char *path,
+              svn_revnum_t revision,
+              apr_pool_t *pool)
+{
+  const char *uuid;
+  const char *session_url;
+  const char *repos_relpath;
+
+  SVN_ERR(session->vtable->get_uuid(session, &uuid, pool));
+  SVN_ERR(session->vtable->get_session_url(session, &session_url, pool));
+  SVN_ERR(svn_ra_get_path_relative_to_root(
+            session, &repos_relpath,
+            svn_path_url_add_component2(session_url, path, pool), pool));
+
+  *key = apr_psprintf(pool, "%s %s %ld %s", kind, uuid, revision,
+                      repos_relpath);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *SKEL to the skel stored as KEY in CACHE, or to NULL if there is
+   no such entry.  Allocate the result in POOL. */
+static svn_error_t *
+get_cached_skel(svn_skel_t **skel,
+                svn_ra__cache_t *cache,
+                const char *key,
+                apr_pool_t *pool)
+{
+  svn_stream_t *stream;
+  svn_stringbuf_t *buf;
+
+  SVN_ERR(svn_ra__cache_get(&stream, cache, key, pool, pool));
+  if (!stream)
+    {
+      *skel = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_stringbuf_from_stream(&buf, stream, 0, pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  /* A corrupt entry is just a miss. */
+  *skel = svn_skel__parse(buf->data, buf->len, pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Store SKEL as KEY in CACHE.  Use POOL for temporary allocations. */
+static svn_error_t *
+put_cached_skel(svn_ra__cache_t *cache,
+                const char *key,
+                const svn_skel_t *skel,
+                apr_pool_t *pool)
+{
+  svn_stream_t *stream;
+  svn_stringbuf_t *buf = svn_skel__unparse(skel, pool);
+
+  SVN_ERR(svn_ra__cache_put(&stream, cache, key, pool, pool));
+  SVN_ERR(svn_stream_write(stream, buf->data, &buf->len));
+
+  return svn_error_trace(svn_stream_close(stream));
+}
+
+/* Like svn_ra_get_file() for a valid REVISION, but through the cache of
+   SESSION. */
+static svn_error_t *
+cached_get_file(svn_ra_session_t *session,
+                const char *path,
+                svn_revnum_t revision,
+                svn_stream_t *stream,
+                svn_revnum_t *fetched_rev,
+                apr_hash_t **props,
+                apr_pool_t *pool)
+{
+  const char *text_key;
+  const char *props_key;
+  svn_stream_t *cached_text = NULL;
+  svn_skel_t *cached_props = NULL;
+  svn_stream_t *text_put = NULL;
+
+  SVN_ERR(get_cache_key(&text_key, session, "file", path, revision, pool));
+  SVN_ERR(get_cache_key(&props_key, session, "file-props", path, revision,
+                        pool));
+
+  if (props)
+    SVN_ERR(get_cached_skel(&cached_props, session->cache, props_key, pool));
+
+  if (stream && (cached_props || !props))
+    SVN_ERR(svn_ra__cache_get(&cached_text, session->cache, text_key,
+                              pool, pool));
+
+  if ((cached_text || !stream) && (cached_props || !props))
+    {
+      if (cached_props)
+        SVN_ERR(svn_skel__parse_proplist(props, cached_props, pool));
+
+      if (cached_text)
+        SVN_ERR(svn_stream_copy3(cached_text, svn_stream_disown(stream, pool),
+                                 session->cancel_func, session->cancel_baton,
+                                 pool));
+
+      if (fetched_rev)
+        *fetched_rev = revision;
+
+      return SVN_NO_ERROR;
+    }
+
+  if (stream)
+    {
+      SVN_ERR(svn_ra__cache_put(&text_put, session->cache, text_key,
+                                pool, pool));
+      stream = svn_stream_tee(stream, text_put, pool);
+    }
+
+  SVN_ERR(session->vtable->get_file(session, path, revision, stream,
+                                    fetched_rev, props, pool));
+
+  if (text_put)
+    SVN_ERR(svn_stream_close(text_put));
+
+  if (props)
+    {
+      svn_skel_t *skel;
+
+      SVN_ERR(svn_skel__unparse_proplist(&skel, *props, pool));
+      SVN_ERR(put_cached_skel(session->cache, props_key, skel, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *svn_ra_get_file(svn_ra_session_t *session,
                              const char *path,
                              svn_revnum_t revision,
@@ -630,10 +826,171 @@ svn_error_t *svn_ra_get_file(svn_ra_session_t *session,
                              apr_pool_t *pool)
 {
   SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+
+  if (session->cache && SVN_IS_VALID_REVNUM(revision))
+    return svn_error_trace(cached_get_file(session, path, revision, stream,
+                                           fetched_rev, props, pool));
+
   return session->vtable->get_file(session, path, revision, stream,
                                    fetched_rev, props, pool);
 }
 
+/* Return DIRENTS, a hash of const char * names to svn_dirent_t *, as a
+   skel allocated in POOL. */
+static svn_skel_t *
+unparse_dirents(apr_hash_t *dirents,
+                apr_pool_t *pool)
+{
+  svn_skel_t *skel = svn_skel__make_empty_list(pool);
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const svn_dirent_t *dirent = apr_hash_this_val(hi);
+      svn_skel_t *entry = svn_skel__make_empty_list(pool);
+
+      if (dirent->last_author)
+        svn_skel__prepend_str(dirent->last_author, entry, pool);
+      svn_skel__prepend_int(dirent->time, entry, pool);
+      svn_skel__prepend_int(dirent->created_rev, entry, pool);
+      svn_skel__prepend_int(dirent->has_props, entry, pool);
+      svn_skel__prepend_int(dirent->size, entry, pool);
+      svn_skel__prepend_str(svn_node_kind_to_word(dirent->kind), entry, pool);
+      svn_skel__prepend_str(apr_hash_this_key(hi), entry, pool);
+
+      svn_skel__prepend(entry, skel);
+    }
+
+  return skel;
+}
+
+/* Parse SKEL as created by unparse_dirents() into *DIRENTS, allocated in
+   POOL.  Set *DIRENTS to NULL if SKEL is malformed. */
+static svn_error_t *
+parse_dirents(apr_hash_t **dirents,
+              const svn_skel_t *skel,
+              apr_pool_t *pool)
+{
+  const svn_skel_t *entry;
+
+  *dirents = apr_hash_make(pool);
+
+  if (skel->is_atom)
+    {
+      *dirents = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  for (entry = skel->children; entry; entry = entry->next)
+    {
+      int len = svn_skel__list_length(entry);
+      svn_dirent_t *dirent;
+      const svn_skel_t *field;
+      apr_int64_t val;
+
+      if (len != 6 && len != 7)
+        {
+          *dirents = NULL;
+          return SVN_NO_ERROR;
+        }
+
+      dirent = svn_dirent_create(pool);
+
+      field = entry->children->next;
+      dirent->kind = svn_node_kind_from_word(
+                       apr_pstrmemdup(pool, field->data, field->len));
+      field = field->next;
+      SVN_ERR(svn_skel__parse_int(&val, field, pool));
+      dirent->size = (svn_filesize_t)val;
+      field = field->next;
+      SVN_ERR(svn_skel__parse_int(&val, field, pool));
+      dirent->has_props = (val != 0);
+      field = field->next;
+      SVN_ERR(svn_skel__parse_int(&val, field, pool));
+      dirent->created_rev = (svn_revnum_t)val;
+      field = field->next;
+      SVN_ERR(svn_skel__parse_int(&val, field, pool));
+      dirent->time = (apr_time_t)val;
+      field = field->next;
+      if (field)
+        dirent->last_author = apr_pstrmemdup(pool, field->data, field->len);
+
+      svn_hash_sets(*dirents,
+                    apr_pstrmemdup(pool, entry->children->data,
+                                   entry->children->len),
+                    dirent);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Like svn_ra_get_dir2() for a valid REVISION, but through the cache of
+   SESSION. */
+static svn_error_t *
+cached_get_dir(svn_ra_session_t *session,
+               apr_hash_t **dirents,
+               svn_revnum_t *fetched_rev,
+               apr_hash_t **props,
+               const char *path,
+               svn_revnum_t revision,
+               apr_uint32_t dirent_fields,
+               apr_pool_t *pool)
+{
+  const char *dirents_key;
+  const char *props_key;
+  svn_skel_t *cached_props = NULL;
+  svn_skel_t *cached_dirents = NULL;
+  apr_hash_t *parsed_dirents = NULL;
+
+  SVN_ERR(get_cache_key(&dirents_key, session,
+                        apr_psprintf(pool, "dir-%x", dirent_fields),
+                        path, revision, pool));
+  SVN_ERR(get_cache_key(&props_key, session, "dir-props", path, revision,
+                        pool));
+
+  if (props)
+    SVN_ERR(get_cached_skel(&cached_props, session->cache, props_key, pool));
+
+  if (dirents && (cached_props || !props))
+    {
+      SVN_ERR(get_cached_skel(&cached_dirents, session->cache, dirents_key,
+                              pool));
+      if (cached_dirents)
+        SVN_ERR(parse_dirents(&parsed_dirents, cached_dirents, pool));
+    }
+
+  if ((parsed_dirents || !dirents) && (cached_props || !props))
+    {
+      if (cached_props)
+        SVN_ERR(svn_skel__parse_proplist(props, cached_props, pool));
+
+      if (dirents)
+        *dirents = parsed_dirents;
+
+      if (fetched_rev)
+        *fetched_rev = revision;
+
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(session->vtable->get_dir(session, dirents, fetched_rev, props,
+                                   path, revision, dirent_fields, pool));
+
+  if (dirents)
+    SVN_ERR(put_cached_skel(session->cache, dirents_key,
+                            unparse_dirents(*dirents, pool), pool));
+
+  if (props)
+    {
+      svn_skel_t *skel;
+
+      SVN_ERR(svn_skel__unparse_proplist(&skel, *props, pool));
+      SVN_ERR(put_cached_skel(session->cache, props_key, skel, pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *svn_ra_get_dir2(svn_ra_session_t *session,
                              apr_hash_t **dirents,
                              svn_revnum_t *fetched_rev,
@@ -644,6 +1001,12 @@ svn_error_t *svn_ra_get_dir2(svn_ra_session_t *session,
                              apr_pool_t *pool)
 {
   SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+
+  if (session->cache && SVN_IS_VALID_REVNUM(revision))
+    return svn_error_trace(cached_get_dir(session, dirents, fetched_rev,
+                                          props, path, revision,
+                                          dirent_fields, pool));
+
   return session->vtable->get_dir(session, dirents, fetched_rev, props,
                                   path, revision, dirent_fields, pool);
 }
@@ -1001,19 +1364,19 @@ svn_error_t *svn_ra_get_locations(svn_ra_session_t *session,
   return err;
 }
 
-svn_error_t *
-svn_ra_get_location_segments(svn_ra_session_t *session,
-                             const char *path,
-                             svn_revnum_t peg_revision,
-                             svn_revnum_t start_rev,
-                             svn_revnum_t end_rev,
-                             svn_location_segment_receiver_t receiver,
-                             void *receiver_baton,
-                             apr_pool_t *pool)
+/* Implement svn_ra_get_location_segments() without the cache. */
+static svn_error_t *
+get_location_segments(svn_ra_session_t *session,
+                      const char *path,
+                      svn_revnum_t peg_revision,
+                      svn_revnum_t start_rev,
+                      svn_revnum_t end_rev,
+                      svn_location_segment_receiver_t receiver,
+                      void *receiver_baton,
+                      apr_pool_t *pool)
 {
   svn_error_t *err;
 
-  SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
   err = session->vtable->get_location_segments(session, path, peg_revision,
                                                start_rev, end_rev,
                                                receiver, receiver_baton, pool);
@@ -1030,6 +1393,190 @@ svn_ra_get_location_segments(svn_ra_session_t *session,
   return err;
 }
 
+/* Baton for collect_segment(). */
+typedef struct collect_segments_baton_t
+{
+  svn_location_segment_receiver_t receiver;
+  void *receiver_baton;
+
+  /* List of (RANGE_START RANGE_END [PATH]) entries, youngest first. */
+  svn_skel_t *segments;
+  apr_pool_t *pool;
+} collect_segments_baton_t;
+
+/* Implements svn_location_segment_receiver_t.  Add SEGMENT to the list
+   in the collect_segments_baton_t BATON and pass it on. */
+static svn_error_t *
+collect_segment(svn_location_segment_t *segment,
+                void *baton,
+                apr_pool_t *pool)
+{
+  collect_segments_baton_t *b = baton;
+  svn_skel_t *entry = svn_skel__make_empty_list(b->pool);
+
+  if (segment->path)
+    svn_skel__prepend_str(apr_pstrdup(b->pool, segment->path), entry,
+                          b->pool);
+  svn_skel__prepend_int(segment->range_end, entry, b->pool);
+  svn_skel__prepend_int(segment->range_start, entry, b->pool);
+  svn_skel__append(b->segments, entry);
+
+  return svn_error_trace(b->receiver(segment, b->receiver_baton, pool));
+}
+
+/* Parse SKEL as created by collect_segment() into *SEGMENTS, an array of
+   svn_location_segment_t *, allocated in POOL.  Set *SEGMENTS to NULL if
+   SKEL is malformed. */
+static svn_error_t *
+parse_segments(apr_array_header_t **segments,
+               const svn_skel_t *skel,
+               apr_pool_t *pool)
+{
+  const svn_skel_t *entry;
+
+  *segments = NULL;
+  if (skel->is_atom)
+    return SVN_NO_ERROR;
+
+  *segments = apr_array_make(pool, svn_skel__list_length(skel),
+                             sizeof(svn_location_segment_t *));
+  for (entry = skel->children; entry; entry = entry->next)
+    {
+      int len = svn_skel__list_length(entry);
+      svn_location_segment_t *segment;
+      const svn_skel_t *field;
+      apr_int64_t val = 0;
+      svn_error_t *err;
+
+      if (len != 2 && len != 3)
+        {
+          *segments = NULL;
+          return SVN_NO_ERROR;
+        }
+
+      segment = apr_pcalloc(pool, sizeof(*segment));
+
+      field = entry->children;
+      err = svn_skel__parse_int(&val, field, pool);
+      segment->range_start = (svn_revnum_t)val;
+      field = field->next;
+      if (!err)
+        err = svn_skel__parse_int(&val, field, pool);
+      segment->range_end = (svn_revnum_t)val;
+      field = field->next;
+      if (!err && field && !field->is_atom)
+        err = svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, NULL);
+
+      if (err)
+        {
+          svn_error_clear(err);
+          *segments = NULL;
+          return SVN_NO_ERROR;
+        }
+
+      if (field)
+        segment->path = apr_pstrmemdup(pool, field->data, field->len);
+
+      APR_ARRAY_PUSH(*segments, svn_location_segment_t *) = segment;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Like svn_ra_get_location_segments() for a valid PEG_REVISION, but
+   through the cache of SESSION.  The history of a node at a given
+   revision never changes, so its segments can be reused. */
+static svn_error_t *
+cached_get_location_segments(svn_ra_session_t *session,
+                             const char *path,
+                             svn_revnum_t peg_revision,
+                             svn_revnum_t start_rev,
+                             svn_revnum_t end_rev,
+                             svn_location_segment_receiver_t receiver,
+                             void *receiver_baton,
+                             apr_pool_t *pool)
+{
+  const char *key;
+  svn_skel_t *cached_segments;
+  apr_array_header_t *segments = NULL;
+  collect_segments_baton_t b;
+
+  /* Use the same key for the defaults and explicit values. */
+  if (!SVN_IS_VALID_REVNUM(start_rev))
+    start_rev = peg_revision;
+  if (!SVN_IS_VALID_REVNUM(end_rev))
+    end_rev = 0;
+
+  SVN_ERR(get_cache_key(&key, session,
+                        apr_psprintf(pool, "segments %ld %ld",
+                                     start_rev, end_rev),
+                        path, peg_revision, pool));
+
+  SVN_ERR(get_cached_skel(&cached_segments, session->cache, key, pool));
+  if (cached_segments)
+    SVN_ERR(parse_segments(&segments, cached_segments, pool));
+
+  if (segments)
+    {
+      apr_pool_t *iterpool = svn_pool_create(pool);
+      int i;
+
+      for (i = 0; i < segments->nelts; i++)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(receiver(APR_ARRAY_IDX(segments, i,
+                                         svn_location_segment_t *),
+                           receiver_baton, iterpool));
+        }
+      svn_pool_destroy(iterpool);
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Only cache complete results, i.e. if neither the server nor RECEIVER
+     stopped early. */
+  b.receiver = receiver;
+  b.receiver_baton = receiver_baton;
+  b.segments = svn_skel__make_empty_list(pool);
+  b.pool = pool;
+  SVN_ERR(get_location_segments(session, path, peg_revision, start_rev,
+                                end_rev, collect_segment, &b, pool));
+
+  return svn_error_trace(put_cached_skel(session->cache, key, b.segments,
+                                         pool));
+}
+
+svn_error_t *
+svn_ra_get_location_segments(svn_ra_session_t *session,
+                             const char *path,
+                             svn_revnum_t peg_revision,
+                             svn_revnum_t start_rev,
+                             svn_revnum_t end_rev,
+                             svn_location_segment_receiver_t receiver,
+                             void *receiver_baton,
+                             apr_pool_t *pool)
+{
+  SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+
+  if (session->cache && SVN_IS_VALID_REVNUM(peg_revision))
+    return svn_error_trace(cached_get_location_segments(session, path,
+                                                        peg_revision,
+                                                        start_rev, end_rev,
+                                                        receiver,
+                                                        receiver_baton,
+                                                        pool));
+
+  return svn_error_trace(get_location_segments(session, path, peg_revision,
+                                               start_rev, end_rev, receiver,
+                                               receiver_baton, pool));
+}
+
+svn_ra__cache_t *
+svn_ra__get_cache(svn_ra_session_t *session)
+{
+  return session->cache;
+}
+
 svn_error_t *svn_ra_get_file_revs2(svn_ra_session_t *session,
                                    const char *path,
                                    svn_revnum_t start,
@@ -1068,6 +1615,30 @@ svn_error_t *svn_ra_get_file_revs2(svn_ra_session_t *session,
   return svn_error_trace(err);
 }
 
+svn_error_t *
+svn_ra_get_blame(svn_ra_session_t *session,
+                 const char *path,
+                 svn_revnum_t start,
+                 svn_revnum_t end,
+                 const apr_array_header_t *diff_options,
+                 svn_ra_blame_receiver_t receiver,
+                 void *receiver_baton,
+                 apr_pool_t *scratch_pool)
+{
+  SVN_ERR_ASSERT(svn_relpath_is_canonical(path));
+  SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(start) && SVN_IS_VALID_REVNUM(end));
+  SVN_ERR_ASSERT(start <= end);
+
+  if (!session->vtable->get_blame)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL, NULL);
+
+  SVN_ERR(svn_ra__assert_capable_server(session, SVN_RA_CAPABILITY_BLAME,
+                                        NULL, scratch_pool));
+
+  return session->vtable->get_blame(session, path, start, end, diff_options,
+                                    receiver, receiver_baton, scratch_pool);
+}
+
 svn_error_t *svn_ra_lock(svn_ra_session_t *session,
                          apr_hash_t *path_revs,
                          const char *comment,
@@ -1380,6 +1951,147 @@ svn_ra_fetch_file_contents(svn_ra_session_t *session,
                                               scratch_pool);
 }
 
+svn_error_t *
+svn_ra_fetch_files_contents(svn_ra_session_t *session,
+                            const apr_array_header_t *fetches,
+                            apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  for (i = 0; i < fetches->nelts; i++)
+    {
+      const svn_ra_file_fetch_t *fetch
+        = APR_ARRAY_IDX(fetches, i, const svn_ra_file_fetch_t *);
+
+      SVN_ERR_ASSERT(svn_relpath_is_canonical(fetch->path));
+      SVN_ERR_ASSERT(SVN_IS_VALID_REVNUM(fetch->revision));
+    }
+
+  if (session->vtable->fetch_files_contents)
+    return session->vtable->fetch_files_contents(session, fetches,
+                                                 scratch_pool);
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < fetches->nelts; i++)
+    {
+      const svn_ra_file_fetch_t *fetch
+        = APR_ARRAY_IDX(fetches, i, const svn_ra_file_fetch_t *);
+
+      svn_pool_clear(iterpool);
+
+      /* Once a fetch failed, only close the streams that are left. */
+      if (err)
+        err = svn_error_compose_create(err, svn_stream_close(fetch->stream));
+      else
+        err = session->vtable->fetch_file_contents(session, fetch->path,
+                                                   fetch->revision,
+                                                   fetch->stream, iterpool);
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+svn_error_t *
+svn_ra_stat_many(svn_ra_session_t *session,
+                 apr_hash_t **dirents,
+                 const apr_array_header_t *paths,
+                 svn_revnum_t revision,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  int i;
+
+  for (i = 0; i < paths->nelts; i++)
+    SVN_ERR_ASSERT(svn_relpath_is_canonical(APR_ARRAY_IDX(paths, i,
+                                                          const char *)));
+
+  /* HEAD may move while we are looking up the paths. */
+  if (!SVN_IS_VALID_REVNUM(revision))
+    SVN_ERR(svn_ra_get_latest_revnum(session, &revision, scratch_pool));
+
+  if (session->vtable->stat_many)
+    {
+      svn_error_t *err = session->vtable->stat_many(session, dirents, paths,
+                                                    revision, result_pool,
+                                                    scratch_pool);
+
+      if (!err || err->apr_err != SVN_ERR_RA_NOT_IMPLEMENTED)
+        return svn_error_trace(err);
+
+      svn_error_clear(err);
+    }
+
+  *dirents = apr_hash_make(result_pool);
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_dirent_t *dirent;
+
+      svn_pool_clear(iterpool);
+
+      /* svn_ra_stat() knows how to deal with old servers. */
+      SVN_ERR(svn_ra_stat(session, path, revision, &dirent, iterpool));
+      if (dirent)
+        svn_hash_sets(*dirents, apr_pstrdup(result_pool, path),
+                      svn_dirent_dup(dirent, result_pool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_get_dirs(svn_ra_session_t *session,
+                apr_hash_t **dirents,
+                const apr_array_header_t *paths,
+                svn_revnum_t revision,
+                apr_uint32_t dirent_fields,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  int i;
+
+  for (i = 0; i < paths->nelts; i++)
+    SVN_ERR_ASSERT(svn_relpath_is_canonical(APR_ARRAY_IDX(paths, i,
+                                                          const char *)));
+
+  /* HEAD may move while we are listing the directories. */
+  if (!SVN_IS_VALID_REVNUM(revision))
+    SVN_ERR(svn_ra_get_latest_revnum(session, &revision, scratch_pool));
+
+  if (session->vtable->get_dirs)
+    {
+      svn_error_t *err = session->vtable->get_dirs(session, dirents, paths,
+                                                   revision, dirent_fields,
+                                                   result_pool,
+                                                   scratch_pool);
+
+      if (!err || err->apr_err != SVN_ERR_RA_NOT_IMPLEMENTED)
+        return svn_error_trace(err);
+
+      svn_error_clear(err);
+    }
+
+  /* svn_ra_get_dir2() allocates everything in a single pool. */
+  *dirents = apr_hash_make(result_pool);
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      apr_hash_t *entries;
+
+      SVN_ERR(svn_ra_get_dir2(session, &entries, NULL, NULL, path, revision,
+                              dirent_fields, result_pool));
+      svn_hash_sets(*dirents, apr_pstrdup(result_pool, path), entries);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_ra__get_commit_ev2(svn_editor_t **editor,
                        svn_ra_session_t *session,
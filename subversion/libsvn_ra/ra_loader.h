@@ -352,6 +352,41 @@ typedef struct svn_ra__vtable_t {
                                       svn_stream_t *stream,
                                       apr_pool_t *scratch_pool);
 
+  /* See svn_ra_get_blame(). */
+  svn_error_t *(*get_blame)(svn_ra_session_t *session,
+                            const char *path,
+                            svn_revnum_t start,
+                            svn_revnum_t end,
+                            const apr_array_header_t *diff_options,
+                            svn_ra_blame_receiver_t receiver,
+                            void *receiver_baton,
+                            apr_pool_t *scratch_pool);
+
+  /* See svn_ra_fetch_files_contents().  May be NULL, in which case the
+     files get fetched one by one using fetch_file_contents(). */
+  svn_error_t *(*fetch_files_contents)(svn_ra_session_t *session,
+                                       const apr_array_header_t *fetches,
+                                       apr_pool_t *scratch_pool);
+
+  /* See svn_ra_stat_many().  May be NULL, in which case the paths get
+     looked up one by one using stat().  REVISION is always valid. */
+  svn_error_t *(*stat_many)(svn_ra_session_t *session,
+                            apr_hash_t **dirents,
+                            const apr_array_header_t *paths,
+                            svn_revnum_t revision,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
+  /* See svn_ra_get_dirs().  May be NULL, in which case the directories get
+     listed one by one using get_dir().  REVISION is always valid. */
+  svn_error_t *(*get_dirs)(svn_ra_session_t *session,
+                           apr_hash_t **dirents,
+                           const apr_array_header_t *paths,
+                           svn_revnum_t revision,
+                           apr_uint32_t dirent_fields,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
   /* Experimental support below here */
 
   /* See svn_ra__register_editor_shim_callbacks() */
@@ -402,6 +437,9 @@ struct svn_ra_session_t {
 
   /* Private data for the RA implementation. */
   void *priv;
+
+  /* Cache for data of fixed revisions, or NULL. */
+  svn_ra__cache_t *cache;
 };
 
 /* Each libsvn_ra_foo defines a function named svn_ra_foo__init of this type.
@@ -0,0 +1,430 @@
+/*
+ * replay_prefetch.c :  replaying revision ranges over parallel sessions
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+#include "svn_delta.h"
+#include "svn_ra.h"
+
+#include "private/svn_delta_private.h"
+#include "private/svn_mutex.h"
+#include "private/svn_ra_private.h"
+#include "private/svn_thread_cond.h"
+
+#include "svn_private_config.h"
+
+#if APR_HAS_THREADS
+#include <apr_thread_proc.h>
+
+/* Everything fetched for a single revision. */
+typedef struct revision_t
+{
+  svn_revnum_t revision;
+
+  /* Revision properties as sent to the replay callbacks. */
+  apr_hash_t *rev_props;
+
+  /* The recorded editor drive. */
+  svn_delta__recording_t *recording;
+
+  /* Error fetching this revision. */
+  svn_error_t *err;
+
+  /* The prefetcher that this revision belongs to. */
+  struct prefetcher_t *prefetcher;
+
+  /* Root pool containing all of the above. */
+  apr_pool_t *pool;
+} revision_t;
+
+/* State shared between the workers and the consumer. */
+typedef struct prefetcher_t
+{
+  /* Protects all other members. */
+  svn_mutex__t *mutex;
+
+  /* Broadcast whenever any of the members below changes. */
+  svn_thread_cond__t *changed;
+
+  /* Next revision to be fetched by a worker. */
+  svn_revnum_t next_revision;
+
+  /* Last revision to fetch. */
+  svn_revnum_t end_revision;
+
+  /* Parameters to svn_ra_replay(). */
+  svn_revnum_t low_water_mark;
+  svn_boolean_t send_deltas;
+
+  /* Next revision to be played back by the consumer. */
+  svn_revnum_t next_to_play;
+
+  /* Ring of fetched revisions, indexed by revision modulo SLOT_COUNT.
+     Workers never fetch more than SLOT_COUNT revisions ahead of
+     NEXT_TO_PLAY. */
+  revision_t **slots;
+  int slot_count;
+
+  /* Set when the consumer gave up. */
+  svn_boolean_t aborted;
+} prefetcher_t;
+
+/* A prefetching thread and its session to the source repository. */
+typedef struct worker_t
+{
+  prefetcher_t *prefetcher;
+  svn_ra_session_t *session;
+  apr_thread_t *thread;
+} worker_t;
+
+/* Set *ABORTED to whether the consumer of PREFETCHER gave up.
+
+   This function must be called with PREFETCHER->MUTEX acquired. */
+static svn_error_t *
+get_aborted(svn_boolean_t *aborted,
+            prefetcher_t *prefetcher)
+{
+  *aborted = prefetcher->aborted;
+  return SVN_NO_ERROR;
+}
+
+/* Return SVN_ERR_CANCELLED if the consumer of the prefetcher of BATON,
+   a revision_t, gave up.  Implements svn_cancel_func_t. */
+static svn_error_t *
+check_aborted(void *baton)
+{
+  revision_t *rev = baton;
+  svn_boolean_t aborted;
+
+  SVN_MUTEX__WITH_LOCK(rev->prefetcher->mutex,
+                       get_aborted(&aborted, rev->prefetcher));
+  if (aborted)
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Fetch REVISION through WORKER's session and return it in a new root
+   pool.  Errors are returned in the ERR member of the result. */
+static revision_t *
+fetch_revision(worker_t *worker,
+               svn_revnum_t revision)
+{
+  apr_pool_t *pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  revision_t *rev = apr_pcalloc(pool, sizeof(*rev));
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+
+  rev->revision = revision;
+  rev->prefetcher = worker->prefetcher;
+  rev->pool = pool;
+
+  rev->err = svn_delta__get_recording_editor(&editor, &edit_baton,
+                                             &rev->recording, check_aborted,
+                                             rev, pool);
+  if (!rev->err)
+    rev->err = svn_ra_rev_proplist(worker->session, revision,
+                                   &rev->rev_props, pool);
+  if (!rev->err)
+    rev->err = svn_ra_replay(worker->session, revision,
+                             worker->prefetcher->low_water_mark,
+                             worker->prefetcher->send_deltas,
+                             editor, edit_baton, pool);
+
+  return rev;
+}
+
+/* Set *REVISION to the next revision that a worker of PREFETCHER shall
+   fetch, waiting until it may be fetched without overtaking the
+   consumer by more than the available slots.  Set *REVISION to
+   SVN_INVALID_REVNUM if the worker shall terminate.
+
+   This function must be called with PREFETCHER->MUTEX acquired. */
+static svn_error_t *
+claim_revision(svn_revnum_t *revision,
+               prefetcher_t *prefetcher)
+{
+  while (!prefetcher->aborted
+         && prefetcher->next_revision <= prefetcher->end_revision
+         && prefetcher->next_revision
+              >= prefetcher->next_to_play + prefetcher->slot_count)
+    SVN_ERR(svn_thread_cond__wait(prefetcher->changed, prefetcher->mutex));
+
+  if (prefetcher->aborted
+      || prefetcher->next_revision > prefetcher->end_revision)
+    *revision = SVN_INVALID_REVNUM;
+  else
+    *revision = prefetcher->next_revision++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Hand REV over to the consumer of PREFETCHER.
+
+   This function must be called with PREFETCHER->MUTEX acquired. */
+static svn_error_t *
+store_revision(prefetcher_t *prefetcher,
+               revision_t *rev)
+{
+  prefetcher->slots[rev->revision % prefetcher->slot_count] = rev;
+  return svn_thread_cond__broadcast(prefetcher->changed);
+}
+
+/* Set *REV to REVISION as fetched by the workers of PREFETCHER, waiting
+   for it as necessary, and free its slot.
+
+   This function must be called with PREFETCHER->MUTEX acquired. */
+static svn_error_t *
+take_revision(revision_t **rev,
+              prefetcher_t *prefetcher,
+              svn_revnum_t revision)
+{
+  revision_t **slot = &prefetcher->slots[revision % prefetcher->slot_count];
+
+  while (*slot == NULL || (*slot)->revision != revision)
+    SVN_ERR(svn_thread_cond__wait(prefetcher->changed, prefetcher->mutex));
+
+  *rev = *slot;
+  *slot = NULL;
+  prefetcher->next_to_play = revision + 1;
+
+  return svn_thread_cond__broadcast(prefetcher->changed);
+}
+
+/* Tell the workers of PREFETCHER that we gave up.
+
+   This function must be called with PREFETCHER->MUTEX acquired. */
+static svn_error_t *
+set_aborted(prefetcher_t *prefetcher)
+{
+  prefetcher->aborted = TRUE;
+  return svn_thread_cond__broadcast(prefetcher->changed);
+}
+
+/* The plain APR thread function of a prefetch worker.
+ * DATA is the worker_t. */
+static void * APR_THREAD_FUNC
+worker_thread(apr_thread_t *thread, void *data)
+{
+  worker_t *worker = data;
+  prefetcher_t *prefetcher = worker->prefetcher;
+  apr_status_t result = APR_SUCCESS;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  while (!err)
+    {
+      svn_revnum_t revision;
+      revision_t *rev;
+
+      err = svn_mutex__lock(prefetcher->mutex);
+      if (err)
+        break;
+
+      err = svn_mutex__unlock(prefetcher->mutex,
+                              claim_revision(&revision, prefetcher));
+      if (err || !SVN_IS_VALID_REVNUM(revision))
+        break;
+
+      /* Fetch errors are reported by the consumer when it gets to this
+         revision. */
+      rev = fetch_revision(worker, revision);
+
+      err = svn_mutex__lock(prefetcher->mutex);
+      if (err)
+        {
+          svn_error_clear(rev->err);
+          svn_pool_destroy(rev->pool);
+          break;
+        }
+
+      err = svn_mutex__unlock(prefetcher->mutex,
+                              store_revision(prefetcher, rev));
+    }
+
+  if (err)
+    {
+      result = err->apr_err;
+      svn_error_clear(err);
+    }
+
+  /* End thread explicitly to prevent APR_INCOMPLETE return codes in
+     apr_thread_join(). */
+  apr_thread_exit(thread, result);
+  return NULL;
+}
+
+/* Pass the prefetched REV on to REVSTART_FUNC, the editor it returns
+   and REVFINISH_FUNC with REPLAY_BATON.  Use POOL for all of them. */
+static svn_error_t *
+commit_revision(revision_t *rev,
+                svn_ra_replay_revstart_callback_t revstart_func,
+                svn_ra_replay_revfinish_callback_t revfinish_func,
+                void *replay_baton,
+                apr_pool_t *pool)
+{
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+
+  SVN_ERR(revstart_func(rev->revision, replay_baton, &editor, &edit_baton,
+                        rev->rev_props, pool));
+  SVN_ERR(svn_delta__play_recording(rev->recording, editor, edit_baton,
+                                    pool));
+  SVN_ERR(revfinish_func(rev->revision, replay_baton, editor, edit_baton,
+                         rev->rev_props, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
+svn_error_t *
+svn_ra__replay_range_prefetched(apr_array_header_t *sessions,
+                                svn_revnum_t start_revision,
+                                svn_revnum_t end_revision,
+                                svn_revnum_t low_water_mark,
+                                svn_boolean_t send_deltas,
+                                svn_ra_replay_revstart_callback_t revstart_func,
+                                svn_ra_replay_revfinish_callback_t revfinish_func,
+                                void *replay_baton,
+                                svn_cancel_func_t cancel_func,
+                                void *cancel_baton,
+                                apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+
+  prefetcher_t *prefetcher = apr_pcalloc(pool, sizeof(*prefetcher));
+  worker_t *workers = apr_pcalloc(pool, sessions->nelts * sizeof(*workers));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_revnum_t revision;
+  svn_error_t *err = SVN_NO_ERROR;
+  svn_error_t *sync_err;
+  int threads_started = 0;
+  int i;
+
+  /* The thread objects can't share the allocator with POOL. */
+  apr_pool_t *thread_pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+
+  SVN_ERR(svn_mutex__init(&prefetcher->mutex, TRUE, pool));
+  SVN_ERR(svn_thread_cond__create(&prefetcher->changed, pool));
+  prefetcher->next_revision = start_revision;
+  prefetcher->end_revision = end_revision;
+  prefetcher->low_water_mark = low_water_mark;
+  prefetcher->send_deltas = send_deltas;
+  prefetcher->next_to_play = start_revision;
+  prefetcher->slot_count = sessions->nelts;
+  prefetcher->slots = apr_pcalloc(pool, sessions->nelts
+                                          * sizeof(*prefetcher->slots));
+
+  for (i = 0; i < sessions->nelts && !err; ++i)
+    {
+      apr_status_t status;
+      worker_t *worker = &workers[i];
+
+      worker->prefetcher = prefetcher;
+      worker->session = APR_ARRAY_IDX(sessions, i, svn_ra_session_t *);
+
+      status = apr_thread_create(&worker->thread, NULL, worker_thread,
+                                 worker, thread_pool);
+      if (status)
+        err = svn_error_wrap_apr(status, _("Can't create prefetch thread"));
+      else
+        ++threads_started;
+    }
+
+  /* Commit all revisions strictly in order, while the workers fetch
+     the following ones. */
+  for (revision = start_revision; revision <= end_revision && !err;
+       ++revision)
+    {
+      revision_t *rev;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        err = cancel_func(cancel_baton);
+      if (!err)
+        err = svn_mutex__lock(prefetcher->mutex);
+      if (err)
+        break;
+
+      err = svn_mutex__unlock(prefetcher->mutex,
+                              take_revision(&rev, prefetcher, revision));
+      if (err)
+        break;
+
+      err = rev->err;
+      if (!err)
+        err = commit_revision(rev, revstart_func, revfinish_func,
+                              replay_baton, iterpool);
+
+      svn_pool_destroy(rev->pool);
+    }
+
+  /* Stop the workers.  They finish their current revision first. */
+  sync_err = svn_mutex__lock(prefetcher->mutex);
+  if (!sync_err)
+    sync_err = svn_mutex__unlock(prefetcher->mutex,
+                                 set_aborted(prefetcher));
+  err = svn_error_compose_create(err, sync_err);
+
+  for (i = 0; i < threads_started; ++i)
+    {
+      apr_status_t retval;
+      apr_status_t status = apr_thread_join(&retval, workers[i].thread);
+
+      if (status)
+        err = svn_error_compose_create(err,
+                                       svn_error_wrap_apr(status,
+                                         _("Can't join prefetch thread")));
+      else if (retval)
+        err = svn_error_compose_create(err,
+                                       svn_error_wrap_apr(retval,
+                                         _("Prefetch thread returned error")));
+    }
+
+  /* Release whatever the workers fetched in vain. */
+  for (i = 0; i < prefetcher->slot_count; ++i)
+    if (prefetcher->slots[i])
+      {
+        svn_error_clear(prefetcher->slots[i]->err);
+        svn_pool_destroy(prefetcher->slots[i]->pool);
+      }
+
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(thread_pool);
+
+  return svn_error_trace(err);
+
+#else
+
+  return svn_error_trace(svn_ra_replay_range(APR_ARRAY_IDX(sessions, 0,
+                                                           svn_ra_session_t *),
+                                             start_revision, end_revision,
+                                             low_water_mark, send_deltas,
+                                             revstart_func,
+                                             revfinish_func, replay_baton,
+                                             pool));
+
+#endif
+}
@@ -734,6 +734,27 @@ svn_ra_local__get_file_revs(svn_ra_session_t *session,
                                   handler, handler_baton, pool);
 }
 
+static svn_error_t *
+svn_ra_local__get_blame(svn_ra_session_t *session,
+                        const char *path,
+                        svn_revnum_t start,
+                        svn_revnum_t end,
+                        const apr_array_header_t *diff_options,
+                        svn_ra_blame_receiver_t receiver,
+                        void *receiver_baton,
+                        apr_pool_t *pool)
+{
+  svn_ra_local__session_baton_t *sess = session->priv;
+  const char *abs_path = svn_fspath__join(sess->fs_path->data, path, pool);
+  return svn_error_trace(svn_repos_blame(sess->repos, abs_path, start, end,
+                                         diff_options, NULL, NULL,
+                                         receiver, receiver_baton,
+                                         sess->callbacks
+                                           ? sess->callbacks->cancel_func
+                                           : NULL,
+                                         sess->callback_baton, pool));
+}
+
 static svn_error_t *
 svn_ra_local__get_dated_revision(svn_ra_session_t *session,
                                  svn_revnum_t *revision,
@@ -1673,6 +1694,7 @@ svn_ra_local__has_capability(svn_ra_session_t *session,
       || strcmp(capability, SVN_RA_CAPABILITY_EPHEMERAL_TXNPROPS) == 0
       || strcmp(capability, SVN_RA_CAPABILITY_GET_FILE_REVS_REVERSE) == 0
       || strcmp(capability, SVN_RA_CAPABILITY_LIST) == 0
+      || strcmp(capability, SVN_RA_CAPABILITY_BLAME) == 0
       )
     {
       *has = TRUE;
@@ -1947,6 +1969,10 @@ static const svn_ra__vtable_t ra_local_vtable =
   NULL /* set_svn_ra_open */,
   svn_ra_local__list ,
   svn_ra_local__fetch_file_contents,
+  svn_ra_local__get_blame,
+  NULL /* fetch_files_contents */,
+  NULL /* stat_many */,
+  NULL /* get_dirs */,
   svn_ra_local__register_editor_shim_callbacks,
   svn_ra_local__get_commit_ev2,
   NULL /* replay_range_ev2 */
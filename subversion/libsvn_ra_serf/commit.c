@@ -37,9 +37,11 @@
 #include "svn_props.h"
 
 #include "svn_private_config.h"
+#include "private/svn_delta_private.h"
 #include "private/svn_dep_compat.h"
 #include "private/svn_fspath.h"
 #include "private/svn_skel.h"
+#include "private/svn_subr_private.h"
 
 #include "ra_serf.h"
 #include "../libsvn_ra/ra_loader.h"
@@ -72,10 +74,25 @@ typedef struct commit_context_t {
   const char *vcc_url;           /* vcc url */
 
   int open_batons;               /* Number of open batons */
+
+  /* Parent of the pools of the queued PUT requests (HTTP v2 only). */
+  apr_pool_t *puts_pool;
+  int pending_puts;              /* Number of PUTs and PROPPATCHes in flight */
 } commit_context_t;
 
 #define USING_HTTPV2_COMMIT_SUPPORT(commit_ctx) ((commit_ctx)->txn_url != NULL)
 
+/* With HTTP v2, close_file() queues the PUT of a file instead of waiting
+   for its response, so that a commit of many small files is not bound by
+   the round trip time.  Every queued request keeps its svndiff (at most
+   SVN_RA_SERF__REQUEST_BODY_IN_MEM_SIZE in memory, the rest spills to disk)
+   until the server responded, so limit the number of requests in flight. */
+#define MAX_PENDING_PUTS 32
+
+/* Open another connection for every PUTS_PER_CONN queued PUTs, up to
+   the configured maximum, unless we talk HTTP/2. */
+#define PUTS_PER_CONN 8
+
 /* Structure associated with a PROPPATCH request. */
 typedef struct proppatch_context_t {
   apr_pool_t *pool;
@@ -194,6 +211,9 @@ typedef struct file_context_t {
   /* URL to PUT the file at. */
   const char *url;
 
+  /* Pool of the queued PUT request, or NULL. */
+  apr_pool_t *put_pool;
+
 } file_context_t;
 
 
@@ -829,13 +849,13 @@ create_proppatch_body(serf_bucket_t **bkt,
   return SVN_NO_ERROR;
 }
 
-static svn_error_t*
-proppatch_resource(svn_ra_serf__session_t *session,
-                   proppatch_context_t *proppatch,
-                   apr_pool_t *pool)
+/* Create a PROPPATCH handler for PROPPATCH in SESSION, allocated in POOL. */
+static svn_ra_serf__handler_t *
+create_proppatch_handler(svn_ra_serf__session_t *session,
+                         proppatch_context_t *proppatch,
+                         apr_pool_t *pool)
 {
   svn_ra_serf__handler_t *handler;
-  svn_error_t *err;
 
   handler = svn_ra_serf__create_handler(session, pool);
 
@@ -852,8 +872,15 @@ proppatch_resource(svn_ra_serf__session_t *session,
   handler->response_handler = svn_ra_serf__handle_multistatus_only;
   handler->response_baton = handler;
 
-  err = svn_ra_serf__context_run_one(handler, pool);
+  return handler;
+}
 
+/* Return the result of the completed PROPPATCH HANDLER, given ERR as
+   returned by running it. */
+static svn_error_t *
+proppatch_result(svn_ra_serf__handler_t *handler,
+                 svn_error_t *err)
+{
   if (!err && handler->sline.code != 207)
     err = svn_error_trace(svn_ra_serf__unexpected_status(handler));
 
@@ -873,6 +900,20 @@ proppatch_resource(svn_ra_serf__session_t *session,
   return svn_error_trace(err);
 }
 
+static svn_error_t*
+proppatch_resource(svn_ra_serf__session_t *session,
+                   proppatch_context_t *proppatch,
+                   apr_pool_t *pool)
+{
+  svn_ra_serf__handler_t *handler;
+  svn_error_t *err;
+
+  handler = create_proppatch_handler(session, proppatch, pool);
+  err = svn_ra_serf__context_run_one(handler, pool);
+
+  return svn_error_trace(proppatch_result(handler, err));
+}
+
 /* Implements svn_ra_serf__request_body_delegate_t */
 static svn_error_t *
 create_empty_put_body(serf_bucket_t **body_bkt,
@@ -1886,6 +1927,8 @@ negotiate_put_encoding(int *svndiff_version_p,
       if (session->supports_svndiff2 &&
           svn_ra_serf__is_low_latency_connection(session))
         svndiff_version = 2;
+      else if (session->supports_svndiff3)
+        svndiff_version = 3;
       else if (session->supports_svndiff1)
         svndiff_version = 1;
       else if (session->supports_svndiff2)
@@ -1898,12 +1941,15 @@ negotiate_put_encoding(int *svndiff_version_p,
       /* Otherwise, prefer svndiff1, as svndiff2 is not a reasonable
        * substitute for svndiff1 with default compression level.  (It gives
        * better speed and compression ratio comparable to svndiff1 with
-       * compression level 1, but not 5).
+       * compression level 1, but not 5).  Svndiff3 is better than both,
+       * in terms of speed and compression ratio.
        *
        * Note: For future compatibility, we also handle a theoretically
        * possible case where the server has advertised only svndiff2 support.
        */
-      if (session->supports_svndiff1)
+      if (session->supports_svndiff3)
+        svndiff_version = 3;
+      else if (session->supports_svndiff1)
         svndiff_version = 1;
       else if (session->supports_svndiff2)
         svndiff_version = 2;
@@ -1927,6 +1973,8 @@ negotiate_put_encoding(int *svndiff_version_p,
 
   if (svndiff_version == 0)
     compression_level = SVN_DELTA_COMPRESSION_LEVEL_NONE;
+  else if (svndiff_version == 3)
+    compression_level = SVN__ZSTD_DEFAULT_LEVEL;
   else
     compression_level = SVN_DELTA_COMPRESSION_LEVEL_DEFAULT;
 
@@ -1955,18 +2003,29 @@ apply_textdelta(void *file_baton,
    * It will be used with most recent servers having the "send result checksum
    * in response to a PUT" capability, and only if the editor driver uses the
    * new callback.
+   *
+   * With HTTP v2 the PUT gets queued by close_file() and may complete after
+   * the file baton is gone, so allocate the body in a pool of its own.
    */
+  if (USING_HTTPV2_COMMIT_SUPPORT(ctx->commit_ctx))
+    ctx->put_pool = svn_pool_create(ctx->commit_ctx->puts_pool);
+
   ctx->svndiff =
     svn_ra_serf__request_body_create(SVN_RA_SERF__REQUEST_BODY_IN_MEM_SIZE,
-                                     ctx->pool);
+                                     ctx->put_pool ? ctx->put_pool
+                                                   : ctx->pool);
   ctx->stream = svn_ra_serf__request_body_get_stream(ctx->svndiff);
 
   negotiate_put_encoding(&svndiff_version, &compression_level,
                          ctx->commit_ctx->session);
   /* Disown the stream; we'll close it explicitly in close_file(). */
-  svn_txdelta_to_svndiff3(handler, handler_baton,
-                          svn_stream_disown(ctx->stream, pool),
-                          svndiff_version, compression_level, pool);
+  SVN_ERR(svn_txdelta__to_svndiff_parallel(handler, handler_baton,
+                                           svn_stream_disown(ctx->stream,
+                                                             pool),
+                                           svndiff_version,
+                                           compression_level,
+                                           SVN_RA_SERF__SVNDIFF_THREADS,
+                                           pool));
 
   if (base_checksum)
     ctx->base_checksum = apr_pstrdup(ctx->pool, base_checksum);
@@ -2011,8 +2070,11 @@ create_body_from_txdelta_stream(serf_bucket_t **body_bkt,
   SVN_ERR(b->open_func(&txdelta_stream, b->open_baton, pool, scratch_pool));
 
   negotiate_put_encoding(&svndiff_version, &compression_level, b->session);
-  stream = svn_txdelta_to_svndiff_stream(txdelta_stream, svndiff_version,
-                                         compression_level, pool);
+  SVN_ERR(svn_txdelta__to_svndiff_stream_parallel(&stream, txdelta_stream,
+                                                  svndiff_version,
+                                                  compression_level,
+                                                  SVN_RA_SERF__SVNDIFF_THREADS,
+                                                  pool));
   *body_bkt = svn_ra_serf__create_stream_bucket(stream, alloc,
                                                 txdelta_stream_errfunc, b);
 
@@ -2133,6 +2195,265 @@ change_file_prop(void *file_baton,
   return SVN_NO_ERROR;
 }
 
+/* Run the context of CTX until no more than MAX_PENDING requests queued
+   by queue_put() are in flight.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+wait_for_pending_puts(commit_context_t *ctx,
+                      int max_pending,
+                      apr_pool_t *scratch_pool)
+{
+  apr_interval_time_t waittime_left = ctx->session->timeout;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (ctx->pending_puts > max_pending)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_ra_serf__context_run(ctx->session, &waittime_left,
+                                       iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_ra_serf__response_done_delegate_t for the PROPPATCH
+   that follows a queued PUT. */
+static svn_error_t *
+queued_proppatch_done(serf_request_t *request,
+                      void *baton,
+                      apr_pool_t *scratch_pool)
+{
+  svn_ra_serf__handler_t *handler = baton;
+  proppatch_context_t *proppatch = handler->header_delegate_baton;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  proppatch->commit_ctx->pending_puts--;
+
+  if (handler->server_error)
+    err = svn_ra_serf__server_error_create(handler, scratch_pool);
+
+  SVN_ERR(proppatch_result(handler, err));
+
+  /* Destroying the pool of the handler is only valid in this callback,
+     as only after this our serf plumbing assumes the request is done. */
+  svn_pool_destroy(proppatch->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Handler baton for a PUT request queued by queue_put(). */
+typedef struct queued_put_t
+{
+  svn_ra_serf__handler_t *handler;
+  file_context_t *file_ctx;
+} queued_put_t;
+
+/* Implements svn_ra_serf__response_done_delegate_t for a queued PUT. */
+static svn_error_t *
+queued_put_done(serf_request_t *request,
+                void *baton,
+                apr_pool_t *scratch_pool)
+{
+  queued_put_t *put = baton;
+  svn_ra_serf__handler_t *handler = put->handler;
+  file_context_t *ctx = put->file_ctx;
+  commit_context_t *commit_ctx = ctx->commit_ctx;
+  int expected_result;
+
+  commit_ctx->pending_puts--;
+
+  if (handler->server_error)
+    return svn_error_trace(svn_ra_serf__server_error_create(handler,
+                                                            scratch_pool));
+
+  if (ctx->added && ! ctx->copy_path)
+    expected_result = 201; /* Created */
+  else
+    expected_result = 204; /* Updated */
+
+  if (handler->sline.code != expected_result)
+    return svn_error_trace(svn_ra_serf__unexpected_status(handler));
+
+  if (ctx->svndiff)
+    SVN_ERR(svn_ra_serf__request_body_cleanup(ctx->svndiff, scratch_pool));
+
+  if (ctx->result_checksum && ctx->remote_result_checksum)
+    {
+      svn_checksum_t *result_checksum;
+
+      SVN_ERR(svn_checksum_parse_hex(&result_checksum, svn_checksum_md5,
+                                     ctx->result_checksum, scratch_pool));
+
+      if (!svn_checksum_match(result_checksum, ctx->remote_result_checksum))
+        return svn_checksum_mismatch_err(result_checksum,
+                                         ctx->remote_result_checksum,
+                                         scratch_pool,
+                                         _("Checksum mismatch for '%s'"),
+                                         svn_dirent_local_style(ctx->relpath,
+                                                                scratch_pool));
+    }
+
+  /* The properties can only be changed once the file exists, so send
+     the PROPPATCH now.  It takes over the pool of the PUT. */
+  if (apr_hash_count(ctx->prop_changes))
+    {
+      proppatch_context_t *proppatch;
+      svn_ra_serf__handler_t *proppatch_handler;
+
+      proppatch = apr_pcalloc(ctx->pool, sizeof(*proppatch));
+      proppatch->pool = ctx->pool;
+      proppatch->relpath = ctx->relpath;
+      proppatch->path = ctx->url;
+      proppatch->commit_ctx = commit_ctx;
+      proppatch->prop_changes = ctx->prop_changes;
+      proppatch->base_revision = ctx->base_revision;
+
+      proppatch_handler = create_proppatch_handler(commit_ctx->session,
+                                                   proppatch, ctx->pool);
+      proppatch_handler->conn = handler->conn;
+      proppatch_handler->done_delegate = queued_proppatch_done;
+      proppatch_handler->done_delegate_baton = proppatch_handler;
+
+      svn_ra_serf__request_create(proppatch_handler);
+      commit_ctx->pending_puts++;
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Destroying the pool of the handler is only valid in this callback,
+     as only after this our serf plumbing assumes the request is done. */
+  svn_pool_destroy(ctx->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the connection of the session of CTX to send the next queued
+   PUT on, opening another connection if that makes sense. */
+static svn_error_t *
+get_put_connection(svn_ra_serf__connection_t **conn,
+                   commit_context_t *ctx)
+{
+  svn_ra_serf__session_t *sess = ctx->session;
+
+  /* All requests share a single connection with HTTP/2. */
+  if (sess->http20)
+    {
+      *conn = sess->conns[0];
+      return SVN_NO_ERROR;
+    }
+
+  if (sess->num_conns < sess->max_connections
+      && ctx->pending_puts / PUTS_PER_CONN >= sess->num_conns)
+    SVN_ERR(svn_ra_serf__add_connection(sess));
+
+  *conn = sess->conns[sess->cur_conn];
+  sess->cur_conn++;
+
+  if (sess->cur_conn >= sess->num_conns)
+    sess->cur_conn = 0;
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue the PUT of the file FILE, without waiting for its response.  If
+   PUT_EMPTY_FILE is TRUE, send an empty body instead of FILE's svndiff.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+queue_put(file_context_t *file,
+          svn_boolean_t put_empty_file,
+          apr_pool_t *scratch_pool)
+{
+  commit_context_t *commit_ctx = file->commit_ctx;
+  apr_pool_t *put_pool;
+  file_context_t *ctx;
+  queued_put_t *put;
+  svn_ra_serf__handler_t *handler;
+  apr_hash_index_t *hi;
+
+  SVN_ERR(wait_for_pending_puts(commit_ctx, MAX_PENDING_PUTS - 1,
+                                scratch_pool));
+
+  put_pool = file->put_pool ? file->put_pool
+                            : svn_pool_create(commit_ctx->puts_pool);
+  file->put_pool = NULL;
+
+  /* The request outlives FILE, so copy what it needs into PUT_POOL. */
+  ctx = apr_pmemdup(put_pool, file, sizeof(*ctx));
+  ctx->pool = put_pool;
+  ctx->parent_dir = NULL;
+  ctx->stream = NULL;
+  ctx->relpath = apr_pstrdup(put_pool, file->relpath);
+  ctx->name = svn_relpath_basename(ctx->relpath, NULL);
+  ctx->working_url = apr_pstrdup(put_pool, file->working_url);
+  ctx->copy_path = apr_pstrdup(put_pool, file->copy_path);
+  ctx->base_checksum = apr_pstrdup(put_pool, file->base_checksum);
+  ctx->result_checksum = apr_pstrdup(put_pool, file->result_checksum);
+  ctx->url = apr_pstrdup(put_pool, file->url);
+  ctx->prop_changes = apr_hash_make(put_pool);
+
+  for (hi = apr_hash_first(scratch_pool, file->prop_changes);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      svn_prop_t *prop = svn_prop_dup(apr_hash_this_val(hi), put_pool);
+
+      svn_hash_sets(ctx->prop_changes, prop->name, prop);
+    }
+
+  handler = svn_ra_serf__create_handler(commit_ctx->session, put_pool);
+  SVN_ERR(get_put_connection(&handler->conn, commit_ctx));
+
+  handler->method = "PUT";
+  handler->path = ctx->url;
+
+  put = apr_pcalloc(put_pool, sizeof(*put));
+  put->handler = handler;
+  put->file_ctx = ctx;
+
+  if (commit_ctx->session->supports_put_result_checksum)
+    {
+      put_response_ctx_t *prc = apr_pcalloc(put_pool, sizeof(*prc));
+
+      prc->handler = handler;
+      prc->file_ctx = ctx;
+      handler->response_handler = put_response_handler;
+      handler->response_baton = prc;
+    }
+  else
+    {
+      handler->response_handler = svn_ra_serf__expect_empty_body;
+      handler->response_baton = handler;
+    }
+
+  if (put_empty_file)
+    {
+      handler->body_delegate = create_empty_put_body;
+      handler->body_delegate_baton = ctx;
+      handler->body_type = "text/plain";
+    }
+  else
+    {
+      svn_ra_serf__request_body_get_delegate(&handler->body_delegate,
+                                             &handler->body_delegate_baton,
+                                             ctx->svndiff);
+      handler->body_type = SVN_SVNDIFF_MIME_TYPE;
+    }
+
+  handler->header_delegate = setup_put_headers;
+  handler->header_delegate_baton = ctx;
+
+  handler->done_delegate = queued_put_done;
+  handler->done_delegate_baton = put;
+
+  svn_ra_serf__request_create(handler);
+  commit_ctx->pending_puts++;
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 close_file(void *file_baton,
            const char *text_checksum,
@@ -2149,6 +2470,20 @@ close_file(void *file_baton,
   if ((!ctx->svndiff) && ctx->added && (!ctx->copy_path))
     put_empty_file = TRUE;
 
+  /* With HTTP v2, queue the PUT and the PROPPATCH that follows it. */
+  if ((ctx->svndiff || put_empty_file) && !ctx->svndiff_sent
+      && USING_HTTPV2_COMMIT_SUPPORT(ctx->commit_ctx))
+    {
+      if (ctx->svndiff)
+        SVN_ERR(svn_stream_close(ctx->stream));
+
+      SVN_ERR(queue_put(ctx, put_empty_file, scratch_pool));
+
+      ctx->commit_ctx->open_batons--;
+
+      return SVN_NO_ERROR;
+    }
+
   /* If we have a stream of changes, push them to the server... */
   if ((ctx->svndiff || put_empty_file) && !ctx->svndiff_sent)
     {
@@ -2251,6 +2586,9 @@ close_edit(void *edit_baton,
               SVN_ERR_FS_INCORRECT_EDITOR_COMPLETION, NULL,
               _("Closing editor with directories or files open"));
 
+  /* Let all queued PUTs complete before the MERGE. */
+  SVN_ERR(wait_for_pending_puts(ctx, 0, pool));
+
   /* MERGE our activity */
   SVN_ERR(svn_ra_serf__run_merge(&commit_info,
                                  ctx->session,
@@ -2261,6 +2599,9 @@ close_edit(void *edit_baton,
 
   ctx->txn_url = NULL; /* If HTTPv2, the txn is now done */
 
+  /* Any youngest revision we remember predates our commit. */
+  ctx->session->youngest_rev_hint = SVN_INVALID_REVNUM;
+
   /* Inform the WC that we did a commit.  */
   if (ctx->callback)
     err = ctx->callback(commit_info, ctx->callback_baton, pool);
@@ -2305,6 +2646,11 @@ abort_edit(void *edit_baton,
   if (! (ctx->activity_url || ctx->txn_url))
     return SVN_NO_ERROR;
 
+  /* Forget about the queued PUTs.  Destroying their pools resets the
+     connections they are still scheduled on. */
+  svn_pool_clear(ctx->puts_pool);
+  ctx->pending_puts = 0;
+
   /* An error occurred on conns[0]. serf 0.4.0 remembers that the connection
      had a problem. We need to reset it, in order to use it again.  */
   serf_connection_reset(ctx->session->conns[0]->conn);
@@ -2391,6 +2737,7 @@ svn_ra_serf__get_commit_editor(svn_ra_session_t *ra_session,
   ctx->keep_locks = keep_locks;
 
   ctx->deleted_entries = apr_hash_make(ctx->pool);
+  ctx->puts_pool = svn_pool_create(ctx->pool);
 
   editor = svn_delta_default_editor(pool);
   editor->open_root = open_root;
@@ -2409,8 +2756,12 @@ svn_ra_serf__get_commit_editor(svn_ra_session_t *ra_session,
   /* Only install the callback that allows streaming PUT request bodies
    * if the server has the necessary capability.  Otherwise, this will
    * fallback to the default implementation using the temporary files.
-   * See default_editor.c:apply_textdelta_stream(). */
-  if (session->supports_put_result_checksum)
+   * See default_editor.c:apply_textdelta_stream().
+   *
+   * With HTTP v2 we prefer queueing the PUTs in close_file(), which needs
+   * the svndiff of apply_textdelta(). */
+  if (session->supports_put_result_checksum
+      && !SVN_RA_SERF__HAVE_HTTPV2_SUPPORT(session))
     editor->apply_textdelta_stream = apply_textdelta_stream;
 
   *ret_editor = editor;
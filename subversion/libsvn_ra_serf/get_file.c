@@ -88,9 +88,12 @@ headers_fetch(serf_bucket_t *headers,
 {
   stream_ctx_t *fetch_ctx = baton;
 
+  /* Accept "deflate" as well, such that the server may send file
+     contents that it stores zlib-compressed as they are.  serf decodes
+     both transparently. */
   if (fetch_ctx->session->using_compression != svn_tristate_false)
     {
-      serf_bucket_headers_setn(headers, "Accept-Encoding", "gzip");
+      serf_bucket_headers_setn(headers, "Accept-Encoding", "gzip,deflate");
     }
 
   return SVN_NO_ERROR;
@@ -429,32 +432,36 @@ svn_ra_serf__get_file(svn_ra_session_t *ra_session,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_ra_serf__fetch_file_contents(svn_ra_session_t *ra_session,
-                                 const char *path,
-                                 svn_revnum_t revision,
-                                 svn_stream_t *stream,
-                                 apr_pool_t *scratch_pool)
+/* Set *HANDLER_P to a handler that GETs PATH, relative to the session URL
+ * of SESSION, as it exists in REVISION and pushes its contents to STREAM.
+ * Allocate the handler in RESULT_POOL.
+ */
+static svn_error_t *
+create_fetch_handler(svn_ra_serf__handler_t **handler_p,
+                     svn_ra_serf__session_t *session,
+                     const char *path,
+                     svn_revnum_t revision,
+                     svn_stream_t *stream,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
 {
-  svn_ra_serf__session_t *session = ra_session->priv;
   const char *fetch_url;
   stream_ctx_t *stream_ctx;
   svn_ra_serf__handler_t *handler;
-  svn_error_t *err;
 
   fetch_url = svn_path_url_add_component2(session->session_url.path, path,
                                           scratch_pool);
 
   SVN_ERR(svn_ra_serf__get_stable_url(&fetch_url, NULL, session,
                                       fetch_url, revision,
-                                      scratch_pool, scratch_pool));
+                                      result_pool, scratch_pool));
 
   /* Create the fetch context. */
-  stream_ctx = apr_pcalloc(scratch_pool, sizeof(*stream_ctx));
+  stream_ctx = apr_pcalloc(result_pool, sizeof(*stream_ctx));
   stream_ctx->result_stream = stream;
   stream_ctx->session = session;
 
-  handler = svn_ra_serf__create_handler(session, scratch_pool);
+  handler = svn_ra_serf__create_handler(session, result_pool);
 
   handler->method = "GET";
   handler->path = fetch_url;
@@ -473,6 +480,26 @@ svn_ra_serf__fetch_file_contents(svn_ra_session_t *ra_session,
 
   stream_ctx->handler = handler;
 
+  *handler_p = handler;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_serf__fetch_file_contents(svn_ra_session_t *ra_session,
+                                 const char *path,
+                                 svn_revnum_t revision,
+                                 svn_stream_t *stream,
+                                 apr_pool_t *scratch_pool)
+{
+  svn_ra_serf__session_t *session = ra_session->priv;
+  svn_ra_serf__handler_t *handler;
+  svn_error_t *err;
+
+  err = create_fetch_handler(&handler, session, path, revision, stream,
+                             scratch_pool, scratch_pool);
+  if (err)
+    return svn_error_compose_create(err, svn_stream_close(stream));
+
   err = svn_ra_serf__context_run_one(handler, scratch_pool);
 
   err = svn_error_compose_create(err, svn_stream_close(stream));
@@ -484,3 +511,78 @@ svn_ra_serf__fetch_file_contents(svn_ra_session_t *ra_session,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_ra_serf__fetch_files_contents(svn_ra_session_t *ra_session,
+                                  const apr_array_header_t *fetches,
+                                  apr_pool_t *scratch_pool)
+{
+  svn_ra_serf__session_t *session = ra_session->priv;
+  apr_interval_time_t waittime_left = session->timeout;
+  svn_ra_serf__handler_t **handlers;
+  apr_pool_t *iterpool;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+  int done_count;
+
+  handlers = apr_pcalloc(scratch_pool, fetches->nelts * sizeof(*handlers));
+
+  /* Queue all GETs at once, such that they get pipelined over the
+     connections of SESSION instead of paying a round trip per file. */
+  for (i = 0; i < fetches->nelts && !err; i++)
+    {
+      const svn_ra_file_fetch_t *fetch
+        = APR_ARRAY_IDX(fetches, i, const svn_ra_file_fetch_t *);
+
+      err = create_fetch_handler(&handlers[i], session, fetch->path,
+                                 fetch->revision, fetch->stream,
+                                 scratch_pool, scratch_pool);
+      if (!err)
+        svn_ra_serf__request_create(handlers[i]);
+    }
+
+  iterpool = svn_pool_create(scratch_pool);
+  done_count = 0;
+  while (!err && done_count < fetches->nelts)
+    {
+      svn_pool_clear(iterpool);
+
+      err = svn_ra_serf__context_run(session, &waittime_left, iterpool);
+
+      /* Finish the fetches in order, so that the caller sees its streams
+         closed in the order it passed them. */
+      while (!err && done_count < fetches->nelts
+             && handlers[done_count]->done)
+        {
+          const svn_ra_file_fetch_t *fetch
+            = APR_ARRAY_IDX(fetches, done_count, const svn_ra_file_fetch_t *);
+          svn_ra_serf__handler_t *handler = handlers[done_count];
+
+          done_count++;
+          waittime_left = session->timeout;
+
+          err = svn_stream_close(fetch->stream);
+          if (!err && handler->sline.code != 200)
+            err = svn_ra_serf__unexpected_status(handler);
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  if (err)
+    {
+      /* Drop whatever is still in flight and close the remaining streams,
+         as promised by svn_ra_fetch_files_contents(). */
+      for (i = done_count; i < fetches->nelts; i++)
+        {
+          const svn_ra_file_fetch_t *fetch
+            = APR_ARRAY_IDX(fetches, i, const svn_ra_file_fetch_t *);
+
+          if (handlers[i] && !handlers[i]->done)
+            svn_ra_serf__unschedule_handler(handlers[i]);
+
+          err = svn_error_compose_create(err, svn_stream_close(fetch->stream));
+        }
+    }
+
+  return svn_error_trace(err);
+}
@@ -30,6 +30,8 @@
 
 #include "svn_private_config.h"
 
+#include "private/svn_fspath.h"
+
 #include "ra_serf.h"
 #include "../libsvn_ra/ra_loader.h"
 
@@ -42,7 +44,8 @@ enum list_state_e {
   INITIAL = XML_STATE_INITIAL,
   REPORT,
   ITEM,
-  AUTHOR
+  AUTHOR,
+  DIR
 };
 
 typedef struct list_context_t {
@@ -65,8 +68,27 @@ typedef struct list_context_t {
   /* log receiver function and baton */
   svn_ra_dirent_receiver_t receiver;
   void *receiver_baton;
+
+  /* The directories to list with svn_ra_serf__get_dirs().  NULL for
+     svn_ra_serf__list(). */
+  const apr_array_header_t *dir_paths;
 } list_context_t;
 
+/* State of svn_ra_serf__get_dirs(). */
+typedef struct dirs_context_t {
+  /* The underlying list report. */
+  list_context_t list;
+
+  /* The result: maps the relpath of each directory to its entries. */
+  apr_hash_t *dirents;
+
+  /* The entries of the current <S:dir> element. */
+  apr_hash_t *entries;
+
+  /* Where to allocate DIRENTS and its contents. */
+  apr_pool_t *result_pool;
+} dirs_context_t;
+
 #define D_ "DAV:"
 #define S_ SVN_XML_NAMESPACE
 static const svn_ra_serf__xml_transition_t log_ttable[] = {
@@ -83,6 +105,23 @@ static const svn_ra_serf__xml_transition_t log_ttable[] = {
   { 0 }
 };
 
+static const svn_ra_serf__xml_transition_t dirs_ttable[] = {
+  { INITIAL, S_, "list-report", REPORT,
+    FALSE, { NULL }, FALSE },
+
+  { REPORT, S_, "dir", DIR,
+    FALSE, { "path", NULL }, TRUE },
+
+  { DIR, S_, "item", ITEM,
+    TRUE, { "node-kind", "?size", "?has-props", "?created-rev",
+             "?date", NULL }, TRUE },
+
+  { ITEM, D_, "creator-displayname", AUTHOR,
+    TRUE, { "?encoding", NULL }, TRUE },
+
+  { 0 }
+};
+
 /* Conforms to svn_ra_serf__xml_closed_t  */
 static svn_error_t *
 item_closed(svn_ra_serf__xml_estate_t *xes,
@@ -183,16 +222,29 @@ create_list_body(serf_bucket_t **body_bkt,
                                     "xmlns:S", SVN_XML_NAMESPACE,
                                     SVN_VA_NULL);
 
-  svn_ra_serf__add_tag_buckets(buckets,
-                               "S:path", list_ctx->path,
-                               alloc);
+  if (list_ctx->dir_paths)
+    {
+      for (i = 0; i < list_ctx->dir_paths->nelts; i++)
+        svn_ra_serf__add_tag_buckets(buckets, "S:dir-path",
+                                     APR_ARRAY_IDX(list_ctx->dir_paths, i,
+                                                   const char *),
+                                     alloc);
+    }
+  else
+    {
+      svn_ra_serf__add_tag_buckets(buckets,
+                                   "S:path", list_ctx->path,
+                                   alloc);
+    }
   svn_ra_serf__add_tag_buckets(buckets,
                                "S:revision",
                                apr_ltoa(pool, list_ctx->revision),
                                alloc);
-  svn_ra_serf__add_tag_buckets(buckets,
-                               "S:depth", svn_depth_to_word(list_ctx->depth),
-                               alloc);
+  if (!list_ctx->dir_paths)
+    svn_ra_serf__add_tag_buckets(buckets,
+                                 "S:depth",
+                                 svn_depth_to_word(list_ctx->depth),
+                                 alloc);
 
   if (list_ctx->patterns)
     {
@@ -286,3 +338,125 @@ svn_ra_serf__list(svn_ra_session_t *ra_session,
 
   return SVN_NO_ERROR;
 }
+
+/* Implements svn_ra_dirent_receiver_t, adding DIRENT to the entries of the
+ * current directory of the dirs_context_t BATON. */
+static svn_error_t *
+dirs_receiver(const char *rel_path,
+              svn_dirent_t *dirent,
+              void *baton,
+              apr_pool_t *scratch_pool)
+{
+  dirs_context_t *dirs_ctx = baton;
+
+  if (!svn_fspath__is_canonical(rel_path))
+    return svn_error_createf(SVN_ERR_RA_DAV_MALFORMED_DATA, NULL,
+                             _("Invalid directory entry path '%s'"),
+                             rel_path);
+
+  svn_hash_sets(dirs_ctx->entries,
+                apr_pstrdup(dirs_ctx->result_pool,
+                            svn_fspath__basename(rel_path, scratch_pool)),
+                svn_dirent_dup(dirent, dirs_ctx->result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Conforms to svn_ra_serf__xml_closed_t  */
+static svn_error_t *
+dir_closed(svn_ra_serf__xml_estate_t *xes,
+           void *baton,
+           int leaving_state,
+           const svn_string_t *cdata,
+           apr_hash_t *attrs,
+           apr_pool_t *scratch_pool)
+{
+  dirs_context_t *dirs_ctx = baton;
+
+  if (leaving_state == DIR)
+    {
+      const char *path = svn_hash_gets(attrs, "path");
+
+      svn_hash_sets(dirs_ctx->dirents,
+                    apr_pstrdup(dirs_ctx->result_pool, path),
+                    dirs_ctx->entries);
+      dirs_ctx->entries = apr_hash_make(dirs_ctx->result_pool);
+
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(item_closed(xes, &dirs_ctx->list, leaving_state,
+                                     cdata, attrs, scratch_pool));
+}
+
+svn_error_t *
+svn_ra_serf__get_dirs(svn_ra_session_t *ra_session,
+                      apr_hash_t **dirents,
+                      const apr_array_header_t *paths,
+                      svn_revnum_t revision,
+                      apr_uint32_t dirent_fields,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  dirs_context_t *dirs_ctx;
+  svn_ra_serf__session_t *session = ra_session->priv;
+  svn_ra_serf__handler_t *handler;
+  svn_ra_serf__xml_context_t *xmlctx;
+  const char *req_url;
+  int i;
+
+  if (!session->supports_list_dirs)
+    return svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, NULL,
+                            _("Server does not support listing multiple "
+                              "directories at once"));
+
+  dirs_ctx = apr_pcalloc(scratch_pool, sizeof(*dirs_ctx));
+  dirs_ctx->dirents = apr_hash_make(result_pool);
+  dirs_ctx->entries = apr_hash_make(result_pool);
+  dirs_ctx->result_pool = result_pool;
+
+  dirs_ctx->list.pool = scratch_pool;
+  dirs_ctx->list.receiver = dirs_receiver;
+  dirs_ctx->list.receiver_baton = dirs_ctx;
+  dirs_ctx->list.dir_paths = paths;
+  dirs_ctx->list.revision = revision;
+  dirs_ctx->list.dirent_fields = dirent_fields;
+  dirs_ctx->list.props = svn_ra_serf__get_dirent_props(dirent_fields,
+                                                       session,
+                                                       scratch_pool);
+  dirs_ctx->list.author_buf = svn_stringbuf_create_empty(scratch_pool);
+
+  SVN_ERR(svn_ra_serf__get_stable_url(&req_url, NULL /* latest_revnum */,
+                                      session,
+                                      NULL /* url */, revision,
+                                      scratch_pool, scratch_pool));
+
+  xmlctx = svn_ra_serf__xml_context_create(dirs_ttable,
+                                           NULL, dir_closed, NULL,
+                                           dirs_ctx,
+                                           scratch_pool);
+  handler = svn_ra_serf__create_expat_handler(session, xmlctx, NULL,
+                                              scratch_pool);
+
+  handler->method = "REPORT";
+  handler->path = req_url;
+  handler->body_delegate = create_list_body;
+  handler->body_delegate_baton = &dirs_ctx->list;
+  handler->body_type = "text/xml";
+
+  SVN_ERR(svn_ra_serf__context_run_one(handler, scratch_pool));
+
+  if (handler->sline.code != 200)
+    SVN_ERR(svn_ra_serf__unexpected_status(handler));
+
+  /* Every directory must have been answered. */
+  for (i = 0; i < paths->nelts; i++)
+    if (!svn_hash_gets(dirs_ctx->dirents,
+                       APR_ARRAY_IDX(paths, i, const char *)))
+      return svn_error_createf(SVN_ERR_RA_DAV_MALFORMED_DATA, NULL,
+                               _("Missing directory '%s' in list response"),
+                               APR_ARRAY_IDX(paths, i, const char *));
+
+  *dirents = dirs_ctx->dirents;
+  return SVN_NO_ERROR;
+}
@@ -39,6 +39,7 @@
 #include "../libsvn_ra/ra_loader.h"
 #include "svn_private_config.h"
 #include "private/svn_fspath.h"
+#include "private/svn_subr_private.h"
 
 #include "ra_serf.h"
 
@@ -242,15 +243,33 @@ capabilities_headers_iterator_callback(void *baton,
           svn_hash_sets(session->capabilities,
                         SVN_RA_CAPABILITY_LIST, capability_yes);
         }
+      if (svn_cstring_match_list(SVN_DAV_NS_DAV_SVN_BLAME, vals))
+        {
+          svn_hash_sets(session->capabilities,
+                        SVN_RA_CAPABILITY_BLAME, capability_yes);
+        }
       if (svn_cstring_match_list(SVN_DAV_NS_DAV_SVN_SVNDIFF2, vals))
         {
           /* Same for svndiff2. */
           session->supports_svndiff2 = TRUE;
         }
+      if (svn_cstring_match_list(SVN_DAV_NS_DAV_SVN_SVNDIFF3, vals))
+        {
+          /* We can only use svndiff3 if we have Zstandard support. */
+          session->supports_svndiff3 = svn_zstd__is_available();
+        }
       if (svn_cstring_match_list(SVN_DAV_NS_DAV_SVN_PUT_RESULT_CHECKSUM, vals))
         {
           session->supports_put_result_checksum = TRUE;
         }
+      if (svn_cstring_match_list(SVN_DAV_NS_DAV_SVN_MULTIPLEXED_FETCHES, vals))
+        {
+          session->supports_multiplexed_fetches = TRUE;
+        }
+      if (svn_cstring_match_list(SVN_DAV_NS_DAV_SVN_LIST_DIRS, vals))
+        {
+          session->supports_list_dirs = TRUE;
+        }
     }
 
   /* SVN-specific headers -- if present, server supports HTTP protocol v2 */
@@ -396,6 +415,8 @@ options_response_handler(serf_request_t *request,
                     capability_no);
       svn_hash_sets(session->capabilities, SVN_RA_CAPABILITY_LIST,
                     capability_no);
+      svn_hash_sets(session->capabilities, SVN_RA_CAPABILITY_BLAME,
+                    capability_no);
 
       /* Then see which ones we can discover. */
       serf_bucket_headers_do(hdrs, capabilities_headers_iterator_callback,
@@ -480,6 +501,20 @@ svn_ra_serf__v2_get_youngest_revnum(svn_revnum_t *youngest,
 
   SVN_ERR_ASSERT(SVN_RA_SERF__HAVE_HTTPV2_SUPPORT(session));
 
+  /* Right after opening the session, we already know the answer. */
+  if (SVN_IS_VALID_REVNUM(session->youngest_rev_hint))
+    {
+      svn_revnum_t hint = session->youngest_rev_hint;
+
+      session->youngest_rev_hint = SVN_INVALID_REVNUM;
+      if (apr_time_now() - session->youngest_rev_hint_time
+            < SVN_RA_SERF__YOUNGEST_REV_HINT_TTL)
+        {
+          *youngest = hint;
+          return SVN_NO_ERROR;
+        }
+    }
+
   SVN_ERR(create_options_req(&opt_ctx, session, scratch_pool));
   SVN_ERR(svn_ra_serf__context_run_one(opt_ctx->handler, scratch_pool));
 
@@ -627,6 +662,10 @@ svn_ra_serf__exchange_capabilities(svn_ra_serf__session_t *serf_sess,
         apr_pstrdup(serf_sess->pool, opt_ctx->activity_collection);
     }
 
+  /* Likewise, keep the youngest revision for an immediate HEAD lookup. */
+  serf_sess->youngest_rev_hint = opt_ctx->youngest_rev;
+  serf_sess->youngest_rev_hint_time = apr_time_now();
+
   return SVN_NO_ERROR;
 }
 
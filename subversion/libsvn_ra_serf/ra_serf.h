@@ -269,13 +269,37 @@ struct svn_ra_serf__session_t {
   /* Indicates whether the server can understand svndiff version 2. */
   svn_boolean_t supports_svndiff2;
 
+  /* Indicates whether both, the server and we, can understand svndiff
+     version 3. */
+  svn_boolean_t supports_svndiff3;
+
   /* Indicates whether the server sends the result checksum in the response
    * to a successful PUT request. */
   svn_boolean_t supports_put_result_checksum;
 
+  /* Indicates whether the server wants the GETs and PROPFINDs of an update
+   * to be multiplexed on a single HTTP/2 connection. */
+  svn_boolean_t supports_multiplexed_fetches;
+
+  /* Indicates whether the server lists multiple directories in a single
+   * list REPORT. */
+  svn_boolean_t supports_list_dirs;
+
   apr_interval_time_t conn_latency;
+
+  /* The youngest revision reported by the OPTIONS request that opened
+     this session and when we received it.  The first youngest revision
+     query within SVN_RA_SERF__YOUNGEST_REV_HINT_TTL will use and reset
+     it, sparing short-lived sessions a round trip.  SVN_INVALID_REVNUM
+     if not available. */
+  svn_revnum_t youngest_rev_hint;
+  apr_time_t youngest_rev_hint_time;
 };
 
+/* How long the youngest revision reported while opening a session may be
+   given out in place of asking the server again. */
+#define SVN_RA_SERF__YOUNGEST_REV_HINT_TTL apr_time_from_sec(2)
+
 #define SVN_RA_SERF__HAVE_HTTPV2_SUPPORT(sess) ((sess)->me_resource != NULL)
 
 /*
@@ -349,6 +373,12 @@ svn_ra_serf__conn_closed(serf_connection_t *conn,
                          apr_status_t why,
                          apr_pool_t *pool);
 
+/* Open one more connection for SESS to its server, to be used for
+   requests that can run in parallel.  SESS must have less than
+   SVN_RA_SERF__MAX_CONNECTIONS_LIMIT connections. */
+svn_error_t *
+svn_ra_serf__add_connection(svn_ra_serf__session_t *sess);
+
 
 /* Helper function to provide SSL client certificates.
  *
@@ -583,7 +613,8 @@ typedef svn_error_t *
 /* Called just before the parser leaves LEAVING_STATE.
 
    If cdata collection was enabled for this state, then CDATA will be
-   non-NULL and contain the collected cdata.
+   non-NULL and contain the collected cdata.  CDATA points into a buffer
+   that will be reused after this call, so copy what needs to be kept.
 
    If attribute collection was enabled for this state, then ATTRS will
    contain the attributes collected for this element only, along with
@@ -693,6 +724,16 @@ svn_ra_serf__xml_context_create(
   void *baton,
   apr_pool_t *result_pool);
 
+/* Tell XMLCTX that the response may embed binary frames between its XML
+   tokens: a NUL byte, the length of the data as a 4 byte big-endian
+   number and the data itself.  The data gets passed unencoded to the
+   CDATA_CB of the state that is current when the frame starts.
+
+   mod_dav_svn sends svndiff data this way when the client asked for it
+   with an S:binary-txdelta element, as XML never contains NUL bytes. */
+void
+svn_ra_serf__xml_context_accept_frames(svn_ra_serf__xml_context_t *xmlctx);
+
 /* Verifies if the parsing completed successfully and destroys
    all subpools. */
 svn_error_t *
@@ -1443,6 +1484,27 @@ svn_ra_serf__list(svn_ra_session_t *ra_session,
                   void *receiver_baton,
                   apr_pool_t *scratch_pool);
 
+/* Implements svn_ra__vtable_t.get_dirs(). */
+svn_error_t *
+svn_ra_serf__get_dirs(svn_ra_session_t *ra_session,
+                      apr_hash_t **dirents,
+                      const apr_array_header_t *paths,
+                      svn_revnum_t revision,
+                      apr_uint32_t dirent_fields,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool);
+
+/* Implements svn_ra__vtable_t.get_blame(). */
+svn_error_t *
+svn_ra_serf__get_blame(svn_ra_session_t *ra_session,
+                       const char *path,
+                       svn_revnum_t start,
+                       svn_revnum_t end,
+                       const apr_array_header_t *diff_options,
+                       svn_ra_blame_receiver_t receiver,
+                       void *receiver_baton,
+                       apr_pool_t *scratch_pool);
+
 /* Request a mergeinfo-report from the URL attached to SESSION,
    and fill in the MERGEINFO hash with the results.
 
@@ -1519,6 +1581,12 @@ svn_ra_serf__fetch_file_contents(svn_ra_session_t *session,
                                  svn_stream_t *stream,
                                  apr_pool_t *scratch_pool);
 
+/* Implements svn_ra__vtable_t.fetch_files_contents(). */
+svn_error_t *
+svn_ra_serf__fetch_files_contents(svn_ra_session_t *session,
+                                  const apr_array_header_t *fetches,
+                                  apr_pool_t *scratch_pool);
+
 /*** Authentication handler declarations ***/
 
 /**
@@ -1624,6 +1692,10 @@ svn_ra_serf__get_dirent_props(apr_uint32_t dirent_fields,
 /* Default limit for in-memory size of a request body. */
 #define SVN_RA_SERF__REQUEST_BODY_IN_MEM_SIZE 256 * 1024
 
+/* Maximum number of threads compressing the svndiff windows of a single
+   file that we send to the server. */
+#define SVN_RA_SERF__SVNDIFF_THREADS 4
+
 /* An opaque structure used to prepare a request body. */
 typedef struct svn_ra_serf__request_body_t svn_ra_serf__request_body_t;
 
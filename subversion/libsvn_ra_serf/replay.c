@@ -107,7 +107,7 @@ static const svn_ra_serf__xml_transition_t replay_ttable[] = {
     TRUE, { "name", "?del", NULL }, TRUE },
 
   { REPLAY_REPORT, S_, "apply-textdelta", REPLAY_APPLY_TEXTDELTA,
-    FALSE, { "?checksum", NULL }, TRUE },
+    FALSE, { "?checksum", "?encoding", NULL }, TRUE },
 
   { 0 }
 };
@@ -200,6 +200,7 @@ replay_opened(svn_ra_serf__xml_estate_t *xes,
        struct replay_node_t *node = ctx->current_node;
        apr_hash_t *attrs;
        const char *checksum;
+       const char *encoding;
        svn_txdelta_window_handler_t handler;
        void *handler_baton;
 
@@ -209,18 +210,19 @@ replay_opened(svn_ra_serf__xml_estate_t *xes,
        /* ### Is there a better way to access a specific attr here? */
        attrs = svn_ra_serf__xml_gather_since(xes, REPLAY_APPLY_TEXTDELTA);
        checksum = svn_hash_gets(attrs, "checksum");
+       encoding = svn_hash_gets(attrs, "encoding");
 
        SVN_ERR(ctx->editor->apply_textdelta(node->baton, checksum, node->pool,
                                             &handler, &handler_baton));
 
        if (handler != svn_delta_noop_window_handler)
          {
-            node->stream = svn_base64_decode(
-                                    svn_txdelta_parse_svndiff(handler,
-                                                              handler_baton,
-                                                              TRUE,
-                                                              node->pool),
-                                    node->pool);
+            node->stream = svn_txdelta_parse_svndiff(handler, handler_baton,
+                                                     TRUE, node->pool);
+
+            /* Binary frames carry the svndiff data as is. */
+            if (! encoding || strcmp(encoding, "binary") != 0)
+              node->stream = svn_base64_decode(node->stream, node->pool);
          }
     }
 
@@ -516,6 +518,9 @@ create_replay_body(serf_bucket_t **bkt,
                                apr_ltoa(pool, ctx->send_deltas),
                                alloc);
 
+  /* Let servers that know how send svndiff data without base64. */
+  svn_ra_serf__add_tag_buckets(body_bkt, "S:binary-txdelta", "yes", alloc);
+
   svn_ra_serf__add_close_tag_buckets(body_bkt, alloc, "S:replay-report");
 
   *bkt = body_bkt;
@@ -554,6 +559,7 @@ svn_ra_serf__replay(svn_ra_session_t *ra_session,
                                            replay_cdata,
                                            &ctx,
                                            scratch_pool);
+  svn_ra_serf__xml_context_accept_frames(xmlctx);
 
   handler = svn_ra_serf__create_expat_handler(session, xmlctx, NULL,
                                               scratch_pool);
@@ -785,6 +791,7 @@ svn_ra_serf__replay_range(svn_ra_session_t *ra_session,
                                            replay_opened, replay_closed,
                                            replay_cdata, rev_ctx,
                                            rev_pool);
+          svn_ra_serf__xml_context_accept_frames(xmlctx);
 
           handler = svn_ra_serf__create_expat_handler(session, xmlctx, NULL,
                                                       rev_pool);
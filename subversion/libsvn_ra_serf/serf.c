@@ -600,6 +600,7 @@ svn_ra_serf__open(svn_ra_session_t *session,
   /* The actual latency will be determined as a part of the initial
      OPTIONS request. */
   serf_sess->conn_latency = -1;
+  serf_sess->youngest_rev_hint = SVN_INVALID_REVNUM;
 
   err = svn_ra_serf__exchange_capabilities(serf_sess, corrected_url,
                                            redirect_url,
@@ -762,9 +763,14 @@ ra_serf_dup_session(svn_ra_session_t *new_session,
   /* supports_rev_rsrc_replay */
   /* supports_svndiff1 */
   /* supports_svndiff2 */
+  /* supports_svndiff3 */
   /* supports_put_result_checksum */
+  /* supports_multiplexed_fetches */
+  /* supports_list_dirs */
   /* conn_latency */
 
+  new_sess->youngest_rev_hint = SVN_INVALID_REVNUM;
+
   new_sess->context = serf_context_create(result_pool);
 
   SVN_ERR(load_config(new_sess, old_sess->config,
@@ -1069,6 +1075,10 @@ static const svn_ra__vtable_t serf_vtable = {
   NULL /* set_svn_ra_open */,
   svn_ra_serf__list,
   svn_ra_serf__fetch_file_contents,
+  svn_ra_serf__get_blame,
+  svn_ra_serf__fetch_files_contents,
+  NULL /* stat_many */,
+  svn_ra_serf__get_dirs,
   svn_ra_serf__register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
   NULL /* replay_range_ev2 */
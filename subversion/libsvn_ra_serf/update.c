@@ -40,6 +40,7 @@
 #include "svn_path.h"
 #include "svn_base64.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
 
 #include "svn_private_config.h"
 #include "private/svn_dep_compat.h"
@@ -103,7 +104,7 @@ typedef enum report_state_e {
 #define V_ SVN_DAV_PROP_NS_DAV
 static const svn_ra_serf__xml_transition_t update_ttable[] = {
   { INITIAL, S_, "update-report", UPDATE_REPORT,
-    FALSE, { "?inline-props", "?send-all", NULL }, TRUE },
+    FALSE, { "?inline-props", "?send-all", "?inline-contents", NULL }, TRUE },
 
   { UPDATE_REPORT, S_, "target-revision", TARGET_REVISION,
     FALSE, { "rev", NULL }, TRUE },
@@ -206,10 +207,10 @@ static const svn_ra_serf__xml_transition_t update_ttable[] = {
     FALSE, { NULL }, FALSE },
 
   { OPEN_FILE, S_, "txdelta", TXDELTA,
-    FALSE, { "?base-checksum" }, TRUE },
+    FALSE, { "?base-checksum", "?encoding", NULL }, TRUE },
 
   { ADD_FILE, S_, "txdelta", TXDELTA,
-    FALSE, { "?base-checksum" }, TRUE },
+    FALSE, { "?base-checksum", "?encoding", NULL }, TRUE },
 
   { OPEN_FILE, S_, "fetch-file", FETCH_FILE,
     FALSE, { "?base-checksum", "?sha1-checksum", NULL }, TRUE},
@@ -255,6 +256,21 @@ static const svn_ra_serf__xml_transition_t update_ttable[] = {
 #define REQUEST_COUNT_TO_PAUSE 50
 #define REQUEST_COUNT_TO_RESUME 40
 
+/* When the server accepts many concurrent streams on one HTTP/2
+   connection, the number of outstanding requests is not bounded by
+   the number of connections.  Instead we adapt the window between
+   these limits to the round trip times we observe: it grows by one
+   for every fetch that completes close to the fastest one seen so far
+   and shrinks by a quarter when fetches start queueing up.  */
+#define MULTIPLEXED_WINDOW_MIN REQUEST_COUNT_TO_RESUME
+#define MULTIPLEXED_WINDOW_MAX 512
+
+/* In skelta mode, ask the server to send the contents of files up to this
+   size inline in the REPORT response.  For small files one extra round
+   trip costs far more than transferring the data in the single stream,
+   while larger files are still fetched in parallel.  */
+#define INLINE_CONTENTS_MAX_SIZE 16384
+
 #define SPILLBUF_BLOCKSIZE 4096
 #define SPILLBUF_MAXBUFFSIZE 131072
 
@@ -388,6 +404,9 @@ typedef struct fetch_ctx_t {
   /* The base-rev header  */
   const char *delta_base;
 
+  /* When the request was created. */
+  apr_time_t start_time;
+
 } fetch_ctx_t;
 
 /*
@@ -426,6 +445,10 @@ struct report_context_t {
      files/dirs? */
   svn_boolean_t add_props_included;
 
+  /* Is the server sending the contents of small files inline, even
+     though it is not in "send-all" mode? */
+  svn_boolean_t inline_contents;
+
   /* Path -> const char *repos_relpath mapping */
   apr_hash_t *switched_paths;
 
@@ -445,6 +468,16 @@ struct report_context_t {
   /* number of pending PROPFIND requests */
   unsigned int num_active_propfinds;
 
+  /* Are GETs and PROPFINDs multiplexed on a single HTTP/2 connection? */
+  svn_boolean_t multiplexed;
+
+  /* Stop parsing the REPORT response while this many GET and PROPFIND
+     requests are pending. */
+  unsigned int fetch_window;
+
+  /* The shortest time a GET took so far, or 0 if none completed yet. */
+  apr_interval_time_t min_fetch_time;
+
   /* Are we done parsing the REPORT response? */
   svn_boolean_t done;
 
@@ -559,32 +592,37 @@ open_connection_if_needed(svn_ra_serf__session_t *sess, int num_active_reqs)
    * a minimum of 1 extra connection. */
   if (sess->num_conns == 1 ||
       ((num_active_reqs / REQS_PER_CONN) > sess->num_conns))
-    {
-      int cur = sess->num_conns;
-      apr_status_t status;
-
-      sess->conns[cur] = apr_pcalloc(sess->pool, sizeof(*sess->conns[cur]));
-      sess->conns[cur]->bkt_alloc = serf_bucket_allocator_create(sess->pool,
-                                                                 NULL, NULL);
-      sess->conns[cur]->last_status_code = -1;
-      sess->conns[cur]->session = sess;
-      status = serf_connection_create2(&sess->conns[cur]->conn,
-                                       sess->context,
-                                       sess->session_url,
-                                       svn_ra_serf__conn_setup,
-                                       sess->conns[cur],
-                                       svn_ra_serf__conn_closed,
-                                       sess->conns[cur],
-                                       sess->pool);
-      if (status)
-        return svn_ra_serf__wrap_err(status, NULL);
-
-      sess->num_conns++;
-    }
+    SVN_ERR(svn_ra_serf__add_connection(sess));
 
   return SVN_NO_ERROR;
 }
 
+/* Adjust the FETCH_WINDOW of CTX, now that a GET request that was created
+   at START_TIME completed. */
+static void
+update_fetch_window(report_context_t *ctx,
+                    apr_time_t start_time)
+{
+  apr_interval_time_t fetch_time = apr_time_now() - start_time;
+
+  if (!ctx->multiplexed)
+    return;
+
+  if (!ctx->min_fetch_time || fetch_time < ctx->min_fetch_time)
+    ctx->min_fetch_time = MAX(fetch_time, 1);
+
+  if (fetch_time <= 2 * ctx->min_fetch_time)
+    {
+      if (ctx->fetch_window < MULTIPLEXED_WINDOW_MAX)
+        ctx->fetch_window++;
+    }
+  else if (fetch_time > 4 * ctx->min_fetch_time)
+    {
+      ctx->fetch_window -= ctx->fetch_window / 4;
+      ctx->fetch_window = MAX(ctx->fetch_window, MULTIPLEXED_WINDOW_MIN);
+    }
+}
+
 /* Returns best connection for fetching files/properties. */
 static svn_ra_serf__connection_t *
 get_best_connection(report_context_t *ctx)
@@ -801,7 +839,8 @@ headers_fetch(serf_bucket_t *headers,
     }
   else if (fetch_ctx->session->using_compression != svn_tristate_false)
     {
-      serf_bucket_headers_setn(headers, "Accept-Encoding", "gzip");
+      /* See headers_fetch() in get_file.c. */
+      serf_bucket_headers_setn(headers, "Accept-Encoding", "gzip,deflate");
     }
 
   return SVN_NO_ERROR;
@@ -1190,6 +1229,7 @@ file_fetch_done(serf_request_t *request,
     return svn_error_trace(svn_ra_serf__unexpected_status(handler));
 
   file->parent_dir->ctx->num_active_fetches--;
+  update_fetch_window(file->parent_dir->ctx, fetch_ctx->start_time);
 
   file->fetch_file = FALSE;
 
@@ -1215,8 +1255,9 @@ fetch_for_file(file_baton_t *file,
   svn_ra_serf__connection_t *conn;
   svn_ra_serf__handler_t *handler;
 
-  /* Open extra connections if we have enough requests to send. */
-  if (ctx->sess->num_conns < ctx->sess->max_connections)
+  /* Open extra connections if we have enough requests to send.  A
+     multiplexed connection doesn't need any help. */
+  if (ctx->sess->num_conns < ctx->sess->max_connections && !ctx->multiplexed)
     SVN_ERR(open_connection_if_needed(ctx->sess, ctx->num_active_fetches +
                                                  ctx->num_active_propfinds));
 
@@ -1346,6 +1387,7 @@ fetch_for_file(file_baton_t *file,
           handler->done_delegate_baton = fetch_ctx;
 
           fetch_ctx->handler = handler;
+          fetch_ctx->start_time = apr_time_now();
 
           svn_ra_serf__request_create(handler);
 
@@ -1443,8 +1485,9 @@ fetch_for_dir(dir_baton_t *dir,
   report_context_t *ctx = dir->ctx;
   svn_ra_serf__connection_t *conn;
 
-  /* Open extra connections if we have enough requests to send. */
-  if (ctx->sess->num_conns < ctx->sess->max_connections)
+  /* Open extra connections if we have enough requests to send.  A
+     multiplexed connection doesn't need any help. */
+  if (ctx->sess->num_conns < ctx->sess->max_connections && !ctx->multiplexed)
     SVN_ERR(open_connection_if_needed(ctx->sess, ctx->num_active_fetches +
                                                  ctx->num_active_propfinds));
 
@@ -1511,6 +1554,11 @@ update_opened(svn_ra_serf__xml_estate_t *xes,
               /* All properties are included in send-all mode. */
               ctx->add_props_included = TRUE;
             }
+
+          val = svn_hash_gets(attrs, "inline-contents");
+
+          if (val && (strcmp(val, "true") == 0))
+            ctx->inline_contents = TRUE;
         }
         break;
 
@@ -1640,8 +1688,9 @@ update_opened(svn_ra_serf__xml_estate_t *xes,
           /* Pre 1.2, mod_dav_svn was using <txdelta> tags (in
              addition to <fetch-file>s and such) when *not* in
              "send-all" mode.  As a client, we're smart enough to know
-             that's wrong, so we'll just ignore these tags. */
-          if (! ctx->send_all_mode)
+             that's wrong, so we'll just ignore these tags.  Unless
+             we asked for the contents of small files to be inlined. */
+          if (! ctx->send_all_mode && ! ctx->inline_contents)
             break;
 
           file->fetch_file = FALSE;
@@ -1659,13 +1708,19 @@ update_opened(svn_ra_serf__xml_estate_t *xes,
           if (ctx->cur_file->txdelta != svn_delta_noop_window_handler)
             {
               svn_stream_t *decoder;
+              const char *encoding = svn_hash_gets(attrs, "encoding");
 
               decoder = svn_txdelta_parse_svndiff(file->txdelta,
                                                   file->txdelta_baton,
                                                   TRUE /* error early close*/,
                                                   file->pool);
 
-              file->txdelta_stream = svn_base64_decode(decoder, file->pool);
+              /* Binary frames carry the svndiff data as is. */
+              if (encoding && strcmp(encoding, "binary") == 0)
+                file->txdelta_stream = decoder;
+              else
+                file->txdelta_stream = svn_base64_decode(decoder,
+                                                         file->pool);
             }
         }
         break;
@@ -2251,7 +2306,7 @@ update_delay_handler(serf_request_t *request,
         }
 
       while ((udb->report->num_active_fetches + udb->report->num_active_propfinds)
-                 < REQUEST_COUNT_TO_RESUME)
+                 < udb->report->fetch_window)
         {
           const char *data;
           apr_size_t len;
@@ -2335,7 +2390,7 @@ process_pending(update_delay_baton_t *udb,
   serf_bucket_alloc_t *alloc = NULL;
 
   while ((udb->report->num_active_fetches + udb->report->num_active_propfinds)
-            < REQUEST_COUNT_TO_RESUME)
+            < udb->report->fetch_window)
     {
       const char *data;
       apr_size_t len;
@@ -2406,6 +2461,12 @@ process_editor_report(report_context_t *ctx,
   handler->response_handler = update_delay_handler;
   handler->response_baton = ud;
 
+  /* With HTTP/2 all fetches share one connection, which the server may
+     allow to carry far more streams than we would otherwise queue. */
+  ctx->multiplexed = (sess->http20 && sess->supports_multiplexed_fetches);
+  ctx->fetch_window = ctx->multiplexed ? MULTIPLEXED_WINDOW_MIN
+                                       : REQUEST_COUNT_TO_RESUME;
+
   /* Open the first extra connection. */
   SVN_ERR(open_connection_if_needed(sess, 0));
 
@@ -2486,6 +2547,7 @@ finish_report(void *report_baton,
                                            update_cdata,
                                            report,
                                            scratch_pool);
+  svn_ra_serf__xml_context_accept_frames(xmlctx);
   handler = svn_ra_serf__create_expat_handler(sess, xmlctx, NULL,
                                               scratch_pool);
 
@@ -2688,8 +2750,18 @@ make_update_reporter(svn_ra_session_t *ra_session,
       /* Subversion 1.8+ servers can be told to send properties for newly
          added items inline even when doing a skelta response. */
       make_simple_xml_tag(&buf, "S:include-props", "yes", scratch_pool);
+
+      /* Newer servers can also send the contents of small files inline,
+         leaving only the larger ones to separate requests. */
+      if (text_deltas)
+        make_simple_xml_tag(&buf, "S:inline-max-size",
+                            apr_ltoa(scratch_pool, INLINE_CONTENTS_MAX_SIZE),
+                            scratch_pool);
     }
 
+  /* Let servers that know how send svndiff data without base64. */
+  make_simple_xml_tag(&buf, "S:binary-txdelta", "yes", scratch_pool);
+
   make_simple_xml_tag(&buf, "S:src-path", report->source, scratch_pool);
 
   if (SVN_IS_VALID_REVNUM(report->target_rev))
@@ -45,6 +45,9 @@
 #include "private/svn_fspath.h"
 #include "private/svn_auth_private.h"
 #include "private/svn_cert.h"
+#include "private/svn_profile.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_trace.h"
 
 #include "ra_serf.h"
 
@@ -670,6 +673,35 @@ svn_ra_serf__conn_closed(serf_connection_t *conn,
   (void) save_error(ra_conn->session, err);
 }
 
+svn_error_t *
+svn_ra_serf__add_connection(svn_ra_serf__session_t *sess)
+{
+  int cur = sess->num_conns;
+  apr_status_t status;
+
+  SVN_ERR_ASSERT(cur < SVN_RA_SERF__MAX_CONNECTIONS_LIMIT);
+
+  sess->conns[cur] = apr_pcalloc(sess->pool, sizeof(*sess->conns[cur]));
+  sess->conns[cur]->bkt_alloc = serf_bucket_allocator_create(sess->pool,
+                                                             NULL, NULL);
+  sess->conns[cur]->last_status_code = -1;
+  sess->conns[cur]->session = sess;
+  status = serf_connection_create2(&sess->conns[cur]->conn,
+                                   sess->context,
+                                   sess->session_url,
+                                   svn_ra_serf__conn_setup,
+                                   sess->conns[cur],
+                                   svn_ra_serf__conn_closed,
+                                   sess->conns[cur],
+                                   sess->pool);
+  if (status)
+    return svn_ra_serf__wrap_err(status, NULL);
+
+  sess->num_conns++;
+
+  return SVN_NO_ERROR;
+}
+
 
 /* Implementation of svn_ra_serf__handle_client_cert */
 static svn_error_t *
@@ -818,6 +850,7 @@ setup_serf_req(serf_request_t *request,
                apr_pool_t *scratch_pool)
 {
   serf_bucket_alloc_t *allocator = serf_request_get_alloc(request);
+  const char *traceparent;
 
   svn_spillbuf_t *buf;
   svn_boolean_t set_CL = session->http10 || !session->using_chunked_requests;
@@ -880,6 +913,14 @@ setup_serf_req(serf_request_t *request,
       serf_bucket_headers_setn(*hdrs_bkt, "Accept-Encoding", accept_encoding);
     }
 
+  /* Let the server continue the trace of the operation that we are
+     part of. */
+  traceparent = svn_trace__traceparent(request_pool);
+  if (traceparent)
+    {
+      serf_bucket_headers_setn(*hdrs_bkt, "traceparent", traceparent);
+    }
+
   /* These headers need to be sent with every request that might need
      capability processing (e.g. during commit, reports, etc.), see
      issue #3255 ("mod_dav_svn does not pass client capabilities to
@@ -905,14 +946,17 @@ svn_ra_serf__context_run(svn_ra_serf__session_t *sess,
 {
   apr_status_t status;
   svn_error_t *err;
+  apr_time_t start;
   assert(sess->pending_error == SVN_NO_ERROR);
 
   if (sess->cancel_func)
     SVN_ERR(sess->cancel_func(sess->cancel_baton));
 
+  start = svn_profile__start();
   status = serf_context_run(sess->context,
                             SVN_RA_SERF__CONTEXT_RUN_DURATION,
                             scratch_pool);
+  svn_profile__record("ra_serf", "network wait", start, 0);
 
   err = sess->pending_error;
   sess->pending_error = SVN_NO_ERROR;
@@ -1667,6 +1711,8 @@ svn_ra_serf__request_create(svn_ra_serf__handler_t *handler)
   handler->discard_body = FALSE;
   handler->scheduled = TRUE;
 
+  svn_profile__record("ra_serf", handler->method, 0, 0);
+
   /* Keeping track of the returned request object would be nice, but doesn't
      work the way we would expect in ra_serf..
 
@@ -2060,9 +2106,14 @@ svn_ra_serf__setup_svndiff_accept_encoding(serf_bucket_t *headers,
          to svndiff1 with a low latency connection (assuming the underlying
          network has high bandwidth), as it is faster and in this case, we
          don't care about worse compression ratio. */
-      serf_bucket_headers_setn(
-        headers, "Accept-Encoding",
-        "gzip,svndiff2;q=0.9,svndiff1;q=0.8,svndiff;q=0.7");
+      if (svn_zstd__is_available())
+        serf_bucket_headers_setn(
+          headers, "Accept-Encoding",
+          "gzip,svndiff2;q=0.9,svndiff3;q=0.8,svndiff1;q=0.7,svndiff;q=0.6");
+      else
+        serf_bucket_headers_setn(
+          headers, "Accept-Encoding",
+          "gzip,svndiff2;q=0.9,svndiff1;q=0.8,svndiff;q=0.7");
     }
   else
     {
@@ -2070,10 +2121,16 @@ svn_ra_serf__setup_svndiff_accept_encoding(serf_bucket_t *headers,
          svndiff2 is not a reasonable substitute for svndiff1 with default
          compression level, because, while it is faster, it also gives worse
          compression ratio.  While we can use svndiff2 in some cases (see
-         above), we can't do this generally. */
-      serf_bucket_headers_setn(
-        headers, "Accept-Encoding",
-        "gzip,svndiff1;q=0.9,svndiff2;q=0.8,svndiff;q=0.7");
+         above), we can't do this generally.  Svndiff3 beats svndiff1 in
+         speed as well as compression ratio, so prefer it if we can. */
+      if (svn_zstd__is_available())
+        serf_bucket_headers_setn(
+          headers, "Accept-Encoding",
+          "gzip,svndiff3;q=0.9,svndiff1;q=0.8,svndiff2;q=0.7,svndiff;q=0.6");
+      else
+        serf_bucket_headers_setn(
+          headers, "Accept-Encoding",
+          "gzip,svndiff1;q=0.9,svndiff2;q=0.8,svndiff;q=0.7");
     }
 }
 
@@ -35,6 +35,7 @@
 #include "svn_config.h"
 #include "svn_delta.h"
 #include "svn_path.h"
+#include "svn_sorts.h"
 
 #include "svn_private_config.h"
 #include "private/svn_string_private.h"
@@ -45,6 +46,13 @@
 /* Read/write chunks of this size into the spillbuf.  */
 #define PARSE_CHUNK_SIZE 8000
 
+/* Size of the header of a binary frame: a NUL byte and a 4 byte length. */
+#define FRAME_HEADER_SIZE 5
+
+/* Closed states keep their cdata buffer for reuse unless it grew beyond
+   this many bytes.  */
+#define MAX_RECYCLED_CDATA 0x10000
+
 
 struct svn_ra_serf__xml_context_t {
   /* Current state information.  */
@@ -65,9 +73,16 @@ struct svn_ra_serf__xml_context_t {
   svn_ra_serf__xml_cdata_t cdata_cb;
   void *baton;
 
-  /* Linked list of free states.  */
+  /* Linked list of closed states, to be recycled by the next opening
+     elements.  */
   svn_ra_serf__xml_estate_t *free_states;
 
+  /* The pool that all states and their buffers are allocated in.  */
+  apr_pool_t *pool;
+
+  /* Does the response contain binary frames?  */
+  svn_boolean_t accept_frames;
+
 #ifdef SVN_DEBUG
   /* Used to verify we are not re-entering a callback, specifically to
      ensure SCRATCH_POOL is not cleared while an outer callback is
@@ -110,9 +125,19 @@ struct svn_ra_serf__xml_estate_t {
      this tag is closed?  */
   svn_boolean_t custom_close;
 
-  /* A pool may be constructed for this state.  */
+  /* A pool may be constructed for this state.  It gets cleared when the
+     element closes and then reused along with this structure.  */
   apr_pool_t *state_pool;
 
+  /* Parent pool of STATE_POOL and the buffers below.  Unlike STATE_POOL,
+     this one survives the recycling of this structure.  NULL for the
+     initial state.  */
+  apr_pool_t *buf_pool;
+
+  /* Reusable buffers for the element name in TAG and the cdata.  */
+  svn_stringbuf_t *tag_buf;
+  svn_stringbuf_t *cdata_buf;
+
   /* The namespaces extent for this state/element. This will start with
      the parent's NS_LIST, and we will push new namespaces into our
      local list. The parent will be unaffected by our locally-scoped data. */
@@ -122,7 +147,8 @@ struct svn_ra_serf__xml_estate_t {
      if no attributes have been collected.  */
   apr_hash_t *attrs;
 
-  /* Any collected cdata. May be NULL if no cdata is being collected.  */
+  /* Any collected cdata. May be NULL if no cdata is being collected.
+     Otherwise, this is CDATA_BUF.  */
   svn_stringbuf_t *cdata;
 
   /* Previous/outer state.  */
@@ -139,6 +165,13 @@ struct expat_ctx_t {
   /* Do not use this pool for allocation. It is merely recorded for running
      the cleanup handler.  */
   apr_pool_t *cleanup_pool;
+
+  /* The part of a binary frame header that we received so far.  */
+  unsigned char frame_header[FRAME_HEADER_SIZE];
+  apr_size_t frame_header_len;
+
+  /* The number of bytes of the current binary frame still to come.  */
+  apr_size_t frame_remaining;
 };
 
 
@@ -442,23 +475,13 @@ void svn_ra_serf__add_tag_buckets(serf_bucket_t *agg_bucket, const char *tag,
   svn_ra_serf__add_close_tag_buckets(agg_bucket, bkt_alloc, tag);
 }
 
-/* Return a pool for XES to use for self-alloc (and other specifics).  */
-static apr_pool_t *
-xes_pool(const svn_ra_serf__xml_estate_t *xes)
-{
-  /* Move up through parent states looking for one with a pool. This
-     will always terminate since the initial state has a pool.  */
-  while (xes->state_pool == NULL)
-    xes = xes->prev;
-  return xes->state_pool;
-}
-
-
+/* Make sure that XES has a STATE_POOL.  The initial state always has
+   one, so only recycleable states will create a new pool.  */
 static void
 ensure_pool(svn_ra_serf__xml_estate_t *xes)
 {
   if (xes->state_pool == NULL)
-    xes->state_pool = svn_pool_create(xes_pool(xes));
+    xes->state_pool = svn_pool_create(xes->buf_pool);
 }
 
 
@@ -537,14 +560,13 @@ svn_ra_serf__xml_context_create(
   xmlctx->closed_cb = closed_cb;
   xmlctx->cdata_cb = cdata_cb;
   xmlctx->baton = baton;
+  xmlctx->pool = result_pool;
   xmlctx->scratch_pool = svn_pool_create(result_pool);
 
   xes = apr_pcalloc(result_pool, sizeof(*xes));
   /* XES->STATE == 0  */
 
-  /* Child states may use this pool to allocate themselves. If a child
-     needs to collect information, then it will construct a subpool and
-     will use that to allocate itself and its collected data.  */
+  /* The initial state is never closed and may simply use RESULT_POOL.  */
   xes->state_pool = result_pool;
 
   xmlctx->current = xes;
@@ -552,6 +574,12 @@ svn_ra_serf__xml_context_create(
   return xmlctx;
 }
 
+void
+svn_ra_serf__xml_context_accept_frames(svn_ra_serf__xml_context_t *xmlctx)
+{
+  xmlctx->accept_frames = TRUE;
+}
+
 
 apr_hash_t *
 svn_ra_serf__xml_gather_since(svn_ra_serf__xml_estate_t *xes,
@@ -639,7 +667,6 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
   svn_ra_serf__xml_estate_t *current = xmlctx->current;
   svn_ra_serf__dav_props_t elemname;
   const svn_ra_serf__xml_transition_t *scan;
-  apr_pool_t *new_pool;
   svn_ra_serf__xml_estate_t *new_xes;
 
   /* If we're waiting for an element to close, then just ignore all
@@ -690,73 +717,84 @@ xml_cb_start(svn_ra_serf__xml_context_t *xmlctx,
 
   /* Found a transition. Make it happen.  */
 
-  /* ### todo. push state  */
+  /* Reports nest only a few levels deep but contain many elements.
+     Recycle the structures, pools and buffers of closed states, so that
+     we don't allocate anything per element once the deepest level has
+     been reached.  */
+  if (xmlctx->free_states)
+    {
+      new_xes = xmlctx->free_states;
+      xmlctx->free_states = new_xes->prev;
+    }
+  else
+    {
+      new_xes = apr_pcalloc(xmlctx->pool, sizeof(*new_xes));
+      new_xes->buf_pool = svn_pool_create(xmlctx->pool);
+    }
 
-  /* ### how to use free states?  */
-  /* This state should be allocated in the extent pool. If we will be
-     collecting information for this state, then construct a subpool.
+  if (new_xes->tag_buf == NULL)
+    new_xes->tag_buf = svn_stringbuf_create_empty(new_xes->buf_pool);
 
-     ### potentially optimize away the subpool if none of the
-     ### attributes are present. subpools are cheap, tho...  */
-  new_pool = xes_pool(current);
-  if (scan->collect_cdata || scan->collect_attrs[0])
+  /* If we're supposed to collect cdata, then set up a buffer for this.
+     The existence of this buffer will instruct our cdata callback to
+     collect the cdata.  */
+  if (scan->collect_cdata)
     {
-      new_pool = svn_pool_create(new_pool);
+      if (new_xes->cdata_buf == NULL)
+        new_xes->cdata_buf = svn_stringbuf_create_empty(new_xes->buf_pool);
+      else
+        svn_stringbuf_setempty(new_xes->cdata_buf);
 
-      /* Prep the new state.  */
-      new_xes = apr_pcalloc(new_pool, sizeof(*new_xes));
-      new_xes->state_pool = new_pool;
+      new_xes->cdata = new_xes->cdata_buf;
+    }
+  else
+    {
+      new_xes->cdata = NULL;
+    }
 
-      /* If we're supposed to collect cdata, then set up a buffer for
-         this. The existence of this buffer will instruct our cdata
-         callback to collect the cdata.  */
-      if (scan->collect_cdata)
-        new_xes->cdata = svn_stringbuf_create_empty(new_pool);
+  new_xes->attrs = NULL;
+  if (scan->collect_attrs[0] != NULL)
+    {
+      const char *const *saveattr = &scan->collect_attrs[0];
+      apr_pool_t *new_pool;
 
-      if (scan->collect_attrs[0] != NULL)
+      ensure_pool(new_xes);
+      new_pool = new_xes->state_pool;
+      new_xes->attrs = apr_hash_make(new_pool);
+      for (; *saveattr != NULL; ++saveattr)
         {
-          const char *const *saveattr = &scan->collect_attrs[0];
+          const char *name;
+          const char *value;
 
-          new_xes->attrs = apr_hash_make(new_pool);
-          for (; *saveattr != NULL; ++saveattr)
+          if (**saveattr == '?')
             {
-              const char *name;
-              const char *value;
-
-              if (**saveattr == '?')
-                {
-                  name = *saveattr + 1;
-                  value = svn_xml_get_attr_value(name, attrs);
-                }
-              else
-                {
-                  name = *saveattr;
-                  value = svn_xml_get_attr_value(name, attrs);
-                  if (value == NULL)
-                    return svn_error_createf(
-                                SVN_ERR_XML_ATTRIB_NOT_FOUND,
-                                NULL,
-                                _("Missing XML attribute '%s' on '%s' element"),
-                                name, scan->name);
-                }
-
-              if (value)
-                svn_hash_sets(new_xes->attrs, name,
-                              apr_pstrdup(new_pool, value));
+              name = *saveattr + 1;
+              value = svn_xml_get_attr_value(name, attrs);
+            }
+          else
+            {
+              name = *saveattr;
+              value = svn_xml_get_attr_value(name, attrs);
+              if (value == NULL)
+                return svn_error_createf(
+                            SVN_ERR_XML_ATTRIB_NOT_FOUND,
+                            NULL,
+                            _("Missing XML attribute '%s' on '%s' element"),
+                            name, scan->name);
             }
+
+          if (value)
+            svn_hash_sets(new_xes->attrs, name,
+                          apr_pstrdup(new_pool, value));
         }
     }
-  else
-    {
-      /* Prep the new state.  */
-      new_xes = apr_pcalloc(new_pool, sizeof(*new_xes));
-      /* STATE_POOL remains NULL.  */
-    }
 
-  /* Some basic copies to set up the new estate.  */
+  /* Some basic copies to set up the new estate.  The namespace URL
+     belongs to our parent states and will outlive this state.  */
   new_xes->state = scan->to_state;
-  new_xes->tag.name = apr_pstrdup(new_pool, elemname.name);
-  new_xes->tag.xmlns = apr_pstrdup(new_pool, elemname.xmlns);
+  svn_stringbuf_set(new_xes->tag_buf, elemname.name);
+  new_xes->tag.name = new_xes->tag_buf->data;
+  new_xes->tag.xmlns = elemname.xmlns;
   new_xes->custom_close = scan->custom_close;
 
   /* Start with the parent's namespace set.  */
@@ -794,24 +832,19 @@ xml_cb_end(svn_ra_serf__xml_context_t *xmlctx,
 
   if (xes->custom_close)
     {
-      const svn_string_t *cdata;
+      svn_string_t cdata;
 
+      /* Hand out a view of our buffer instead of a copy.  It is only
+         valid during the callback.  */
       if (xes->cdata)
         {
-          cdata = svn_stringbuf__morph_into_string(xes->cdata);
-#ifdef SVN_DEBUG
-          /* We might toss the pool holding this structure, but it could also
-             be within a parent pool. In any case, for safety's sake, disable
-             the stringbuf against future Badness.  */
-          xes->cdata->pool = NULL;
-#endif
+          cdata.data = xes->cdata->data;
+          cdata.len = xes->cdata->len;
         }
-      else
-        cdata = NULL;
 
       START_CALLBACK(xmlctx);
       SVN_ERR(xmlctx->closed_cb(xes, xmlctx->baton, xes->state,
-                                cdata, xes->attrs,
+                                xes->cdata ? &cdata : NULL, xes->attrs,
                                 xmlctx->scratch_pool));
       END_CALLBACK(xmlctx);
       svn_pool_clear(xmlctx->scratch_pool);
@@ -820,17 +853,28 @@ xml_cb_end(svn_ra_serf__xml_context_t *xmlctx,
   /* Pop the state.  */
   xmlctx->current = xes->prev;
 
-  /* ### not everything should go on the free state list. XES may go
-     ### away with the state pool.  */
+  /* Release everything allocated for this element but keep the pool
+     itself for the next element that will reuse XES.  */
+  if (xes->state_pool)
+    svn_pool_clear(xes->state_pool);
+
+  /* Don't let a single large value pin its buffer for the rest of the
+     response.  Releasing BUF_POOL also releases the STATE_POOL child. */
+  if (xes->cdata_buf && xes->cdata_buf->blocksize > MAX_RECYCLED_CDATA)
+    {
+      svn_pool_clear(xes->buf_pool);
+      xes->state_pool = NULL;
+      xes->tag_buf = NULL;
+      xes->cdata_buf = NULL;
+    }
+
+  xes->cdata = NULL;
+  xes->attrs = NULL;
+
+  /* Make XES available for recycling.  */
   xes->prev = xmlctx->free_states;
   xmlctx->free_states = xes;
 
-  /* If there is a STATE_POOL, then toss it. This will get rid of as much
-     memory as possible. Potentially the XES (if we didn't create a pool
-     right away, then XES may be in a parent pool).  */
-  if (xes->state_pool)
-    svn_pool_destroy(xes->state_pool);
-
   return SVN_NO_ERROR;
 }
 
@@ -880,6 +924,80 @@ parse_xml(struct expat_ctx_t *ectx, const char *data, apr_size_t len, svn_boolea
   return err;
 }
 
+/* Like parse_xml(), but pass the contents of binary frames in the LEN
+   bytes at DATA directly to the cdata callback of the current state. */
+static svn_error_t *
+parse_framed(struct expat_ctx_t *ectx,
+             const char *data,
+             apr_size_t len,
+             svn_boolean_t is_final)
+{
+  while (len > 0)
+    {
+      if (ectx->frame_remaining)
+        {
+          apr_size_t chunk = MIN(len, ectx->frame_remaining);
+
+          SVN_ERR(xml_cb_cdata(ectx->xmlctx, data, chunk));
+          ectx->frame_remaining -= chunk;
+          data += chunk;
+          len -= chunk;
+        }
+      else if (ectx->frame_header_len)
+        {
+          apr_size_t chunk = MIN(len,
+                                 FRAME_HEADER_SIZE - ectx->frame_header_len);
+          const unsigned char *header = ectx->frame_header;
+
+          memcpy(ectx->frame_header + ectx->frame_header_len, data, chunk);
+          ectx->frame_header_len += chunk;
+          data += chunk;
+          len -= chunk;
+
+          if (ectx->frame_header_len == FRAME_HEADER_SIZE)
+            {
+              ectx->frame_remaining = ((apr_size_t)header[1] << 24)
+                                      | ((apr_size_t)header[2] << 16)
+                                      | ((apr_size_t)header[3] << 8)
+                                      | (apr_size_t)header[4];
+              ectx->frame_header_len = 0;
+            }
+        }
+      else
+        {
+          /* XML never contains NUL bytes, so each one starts a frame. */
+          const char *frame = memchr(data, '\0', len);
+          apr_size_t text_len = frame ? (apr_size_t)(frame - data) : len;
+
+          if (text_len)
+            SVN_ERR(parse_xml(ectx, data, text_len, FALSE));
+
+          data += text_len;
+          len -= text_len;
+
+          if (frame)
+            {
+              ectx->frame_header[0] = '\0';
+              ectx->frame_header_len = 1;
+              data++;
+              len--;
+            }
+        }
+    }
+
+  if (is_final)
+    {
+      if (ectx->frame_remaining || ectx->frame_header_len)
+        return svn_error_create(SVN_ERR_RA_DAV_MALFORMED_DATA, NULL,
+                                _("The response ends within a binary "
+                                  "frame"));
+
+      SVN_ERR(parse_xml(ectx, "", 0, TRUE));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Implements svn_xml_start_elem callback */
 static void
 expat_start(void *baton, const char *raw_name, const char **attrs)
@@ -986,7 +1104,10 @@ expat_response_handler(serf_request_t *request,
       else if (APR_STATUS_IS_EOF(status))
         at_eof = TRUE;
 
-      SVN_ERR(parse_xml(ectx, data, len, at_eof /* isFinal */));
+      if (ectx->xmlctx->accept_frames)
+        SVN_ERR(parse_framed(ectx, data, len, at_eof /* isFinal */));
+      else
+        SVN_ERR(parse_xml(ectx, data, len, at_eof /* isFinal */));
 
       /* The parsing went fine. What has the bucket told us?  */
       if (at_eof)
@@ -249,7 +249,80 @@ static svn_error_t *handle_auth_request(svn_ra_svn__session_baton_t *sess,
   SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "lc", &mechlist, &realm));
   if (mechlist->nelts == 0)
     return SVN_NO_ERROR;
-  return DO_AUTH(sess, mechlist, realm, pool);
+  SVN_ERR(DO_AUTH(sess, mechlist, realm, pool));
+
+  /* The server won't ask again once it knows our username, which is not
+     the case if we may have used the ANONYMOUS mechanism. */
+  if (!svn_ra_svn__find_mech(mechlist, "ANONYMOUS")
+      || (sess->is_tunneled && svn_ra_svn__find_mech(mechlist, "EXTERNAL")))
+    sess->authenticated = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* If we are part of a trace and the server of SESS continues traces,
+ * tell it about the span that the next command belongs to, unless it
+ * already knows.  The server does not answer.  Use POOL for temporaries.
+ */
+static svn_error_t *
+send_trace_context(svn_ra_svn__session_baton_t *sess,
+                   apr_pool_t *pool)
+{
+  const char *traceparent = svn_trace__traceparent(pool);
+
+  if (   !traceparent
+      || !svn_ra_svn_has_capability(sess->conn, SVN_RA_SVN_CAP_TRACE_CONTEXT)
+      || strcmp(traceparent, sess->conn->trace_context) == 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_ra_svn__write_cmd_trace_context(sess->conn, pool,
+                                              traceparent));
+  apr_cpystrn(sess->conn->trace_context, traceparent,
+              sizeof(sess->conn->trace_context));
+
+  return SVN_NO_ERROR;
+}
+
+/* Maximum number of commands that we keep in flight on a pipelined
+ * connection.  The server starts answering while we are still sending,
+ * so all of them have to fit into the socket buffers or both sides
+ * might block. */
+#define PIPELINE_WINDOW 32
+
+/* Return the number of commands that we may send over the connection of
+ * SESS before reading their responses. */
+static int
+pipeline_window(svn_ra_svn__session_baton_t *sess)
+{
+  /* The server would take pipelined commands as the answer to an auth
+   * request, and it only sends those to anonymous clients. */
+  if (sess->authenticated
+      && svn_ra_svn_has_capability(sess->conn, SVN_RA_SVN_CAP_PIPELINING))
+    return PIPELINE_WINDOW;
+
+  return 1;
+}
+
+/* Return TRUE if ERR means that we can't read the responses to further
+ * commands from the connection, e.g. because it got closed or the server
+ * sent something unexpected.  Most errors come from the server's failure
+ * response to a single command, which leaves the connection usable. */
+static svn_boolean_t
+is_connection_error(svn_error_t *err)
+{
+  switch (err->apr_err)
+    {
+      case SVN_ERR_RA_SVN_CONNECTION_CLOSED:
+      case SVN_ERR_RA_SVN_IO_ERROR:
+      case SVN_ERR_RA_SVN_MALFORMED_DATA:
+      case SVN_ERR_RA_SVN_REQUEST_SIZE:
+      case SVN_ERR_RA_SVN_RESPONSE_SIZE:
+      case SVN_ERR_RA_NOT_AUTHORIZED:
+        return TRUE;
+
+      default:
+        return FALSE;
+    }
 }
 
 /* --- REPORTER IMPLEMENTATION --- */
@@ -648,6 +721,7 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
   sess->callbacks = callbacks;
   sess->callbacks_baton = callbacks_baton;
   sess->bytes_read = sess->bytes_written = 0;
+  sess->authenticated = FALSE;
   sess->auth_baton = auth_baton;
 
   if (config)
@@ -687,6 +761,24 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
           SVN_ERR(svn_ra_svn__skip_leading_garbage(conn, pool));
         }
     }
+  else if (uri->scheme && svn_cstring_casecmp(uri->scheme, "svns") == 0)
+    {
+      apr_port_t port = uri->port ? uri->port : SVN_RA_SVN_TLS_PORT;
+
+      sess->realm_prefix = apr_psprintf(pool, "<svns://%s:%d>", uri->hostname,
+                                        port);
+
+      SVN_ERR(make_connection(uri->hostname, port, &sock, pool));
+      conn = svn_ra_svn_create_conn5(sock, NULL, NULL,
+                                     SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                                     0, 0, 0, 0, pool);
+      SVN_ERR(svn_ra_svn__tls_connect(conn, sock, sess, port,
+                                      config
+                                        ? svn_hash_gets(config,
+                                              SVN_CONFIG_CATEGORY_SERVERS)
+                                        : NULL,
+                                      scratch_pool));
+    }
   else
     {
       sess->realm_prefix = apr_psprintf(pool, "<svn://%s:%d>", uri->hostname,
@@ -747,7 +839,7 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
    * capability list, and the URL, and subsequently there is an auth
    * request. */
   /* Client-side capabilities list: */
-  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwwww)cc(?c)",
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "n(wwwwwww?w)cc(?c)",
                                   (apr_uint64_t) 2,
                                   SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                   SVN_RA_SVN_CAP_SVNDIFF1,
@@ -756,6 +848,9 @@ static svn_error_t *open_session(svn_ra_svn__session_baton_t **sess_p,
                                   SVN_RA_SVN_CAP_DEPTH,
                                   SVN_RA_SVN_CAP_MERGEINFO,
                                   SVN_RA_SVN_CAP_LOG_REVPROPS,
+                                  svn_zstd__is_available()
+                                    ? SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED
+                                    : NULL,
                                   url,
                                   SVN_RA_SVN__DEFAULT_USERAGENT,
                                   client_string));
@@ -806,7 +901,7 @@ static const char *ra_svn_get_description(apr_pool_t *pool)
 static const char * const *
 ra_svn_get_schemes(apr_pool_t *pool)
 {
-  static const char *schemes[] = { "svn", NULL };
+  static const char *schemes[] = { "svn", "svns", NULL };
 
   return schemes;
 }
@@ -864,6 +959,12 @@ static svn_error_t *ra_svn_open(svn_ra_session_t *session,
 
   SVN_ERR(parse_url(url, &uri, sess_pool));
 
+  /* Tunnels bring their own security. */
+  if (uri.scheme && strncasecmp(uri.scheme, "svns+", 5) == 0)
+    return svn_error_createf(SVN_ERR_BAD_URL, NULL,
+                             _("TLS over tunnels is not supported in URL "
+                               "'%s'"), url);
+
   parse_tunnel(url, &tunnel, result_pool);
 
   /* Use the default tunnel implementation if we got a tunnel name,
@@ -1328,6 +1429,7 @@ static svn_error_t *ra_svn_commit(svn_ra_session_t *session,
   /* Tell the server we're starting the commit.
      Send log message here for backwards compatibility with servers
      before 1.5. */
+  SVN_ERR(send_trace_context(sess_baton, pool));
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w(c(!", "commit",
                                   log_msg->data));
   if (lock_tokens)
@@ -1436,24 +1538,30 @@ parse_iproplist(apr_array_header_t **inherited_props,
   return SVN_NO_ERROR;
 }
 
-static svn_error_t *get_file(svn_ra_session_t *session, const char *path,
-                             svn_revnum_t rev, svn_stream_t *stream,
-                             svn_revnum_t *fetched_rev,
-                             apr_hash_t **props,
-                             apr_pool_t *pool)
+/* Read the response to a get-file command for PATH from the connection
+ * of SESS.  Set *FETCHED_REV and *PROPS unless they are NULL.  If STREAM
+ * is not NULL, push the contents of the file to it but don't close it.
+ * The parameters must match the ones of the command.  Allocate results
+ * in POOL.
+ */
+static svn_error_t *
+read_get_file_response(svn_ra_svn__session_baton_t *sess,
+                       const char *path,
+                       svn_stream_t *stream,
+                       svn_revnum_t *fetched_rev,
+                       apr_hash_t **props,
+                       apr_pool_t *pool)
 {
-  svn_ra_svn__session_baton_t *sess_baton = session->priv;
-  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  svn_ra_svn_conn_t *conn = sess->conn;
   svn_ra_svn__list_t *proplist;
   const char *expected_digest;
   svn_checksum_t *expected_checksum = NULL;
   svn_checksum_ctx_t *checksum_ctx;
+  svn_revnum_t rev;
   apr_pool_t *iterpool;
+  svn_error_t *err = SVN_NO_ERROR;
 
-  path = reparent_path(session, path, pool);
-  SVN_ERR(svn_ra_svn__write_cmd_get_file(conn, pool, path, rev,
-                                         (props != NULL), (stream != NULL)));
-  SVN_ERR(handle_auth_request(sess_baton, pool));
+  SVN_ERR(handle_auth_request(sess, pool));
   SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "(?c)rl",
                                         &expected_digest,
                                         &rev, &proplist));
@@ -1492,14 +1600,16 @@ static svn_error_t *get_file(svn_ra_session_t *session, const char *path,
         SVN_ERR(svn_checksum_update(checksum_ctx, item->u.string.data,
                                     item->u.string.len));
 
-      SVN_ERR(svn_stream_write(stream, item->u.string.data,
-                               &item->u.string.len));
+      /* Keep reading after write errors, so that the connection
+       * stays usable. */
+      if (!err)
+        err = svn_stream_write(stream, item->u.string.data,
+                               &item->u.string.len);
     }
   svn_pool_destroy(iterpool);
 
-  SVN_ERR(svn_stream_close(stream));
-
-  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, ""));
+  SVN_ERR(svn_error_compose_create(
+            svn_ra_svn__read_cmd_response(conn, pool, ""), err));
 
   if (expected_checksum)
     {
@@ -1515,6 +1625,27 @@ static svn_error_t *get_file(svn_ra_session_t *session, const char *path,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *get_file(svn_ra_session_t *session, const char *path,
+                             svn_revnum_t rev, svn_stream_t *stream,
+                             svn_revnum_t *fetched_rev,
+                             apr_hash_t **props,
+                             apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+
+  path = reparent_path(session, path, pool);
+  SVN_ERR(send_trace_context(sess_baton, pool));
+  SVN_ERR(svn_ra_svn__write_cmd_get_file(sess_baton->conn, pool, path, rev,
+                                         (props != NULL), (stream != NULL)));
+
+  SVN_ERR(read_get_file_response(sess_baton, path, stream, fetched_rev,
+                                 props, pool));
+  if (stream)
+    SVN_ERR(svn_stream_close(stream));
+
+  return SVN_NO_ERROR;
+}
+
 /* Write the protocol words that correspond to DIRENT_FIELDS to CONN
  * and use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
@@ -1544,44 +1675,15 @@ send_dirent_fields(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
-static svn_error_t *ra_svn_get_dir(svn_ra_session_t *session,
-                                   apr_hash_t **dirents,
-                                   svn_revnum_t *fetched_rev,
-                                   apr_hash_t **props,
-                                   const char *path,
-                                   svn_revnum_t rev,
-                                   apr_uint32_t dirent_fields,
-                                   apr_pool_t *pool)
+/* Set *DIRENTS to the entries in DIRLIST, which are dirent tuples as sent
+ * in response to get-dir.  Allocate the result in POOL. */
+static svn_error_t *
+parse_dirlist(apr_hash_t **dirents,
+              svn_ra_svn__list_t *dirlist,
+              apr_pool_t *pool)
 {
-  svn_ra_svn__session_baton_t *sess_baton = session->priv;
-  svn_ra_svn_conn_t *conn = sess_baton->conn;
-  svn_ra_svn__list_t *proplist, *dirlist;
   int i;
 
-  path = reparent_path(session, path, pool);
-  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w(c(?r)bb(!", "get-dir", path,
-                                  rev, (props != NULL), (dirents != NULL)));
-  SVN_ERR(send_dirent_fields(conn, dirent_fields, pool));
-
-  /* Always send the, nominally optional, want-iprops as "false" to
-     workaround a bug in svnserve 1.8.0-1.8.8 that causes the server
-     to see "true" if it is omitted. */
-  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!)b)", FALSE));
-
-  SVN_ERR(handle_auth_request(sess_baton, pool));
-  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "rll", &rev, &proplist,
-                                        &dirlist));
-
-  if (fetched_rev)
-    *fetched_rev = rev;
-  if (props)
-    SVN_ERR(svn_ra_svn__parse_proplist(proplist, pool, props));
-
-  /* We're done if dirents aren't wanted. */
-  if (!dirents)
-    return SVN_NO_ERROR;
-
-  /* Interpret the directory list. */
   *dirents = svn_hash__make(pool);
   for (i = 0; i < dirlist->nelts; i++)
     {
@@ -1630,6 +1732,108 @@ static svn_error_t *ra_svn_get_dir(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *ra_svn_get_dir(svn_ra_session_t *session,
+                                   apr_hash_t **dirents,
+                                   svn_revnum_t *fetched_rev,
+                                   apr_hash_t **props,
+                                   const char *path,
+                                   svn_revnum_t rev,
+                                   apr_uint32_t dirent_fields,
+                                   apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  svn_ra_svn__list_t *proplist, *dirlist;
+
+  path = reparent_path(session, path, pool);
+  SVN_ERR(send_trace_context(sess_baton, pool));
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w(c(?r)bb(!", "get-dir", path,
+                                  rev, (props != NULL), (dirents != NULL)));
+  SVN_ERR(send_dirent_fields(conn, dirent_fields, pool));
+
+  /* Always send the, nominally optional, want-iprops as "false" to
+     workaround a bug in svnserve 1.8.0-1.8.8 that causes the server
+     to see "true" if it is omitted. */
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!)b)", FALSE));
+
+  SVN_ERR(handle_auth_request(sess_baton, pool));
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "rll", &rev, &proplist,
+                                        &dirlist));
+
+  if (fetched_rev)
+    *fetched_rev = rev;
+  if (props)
+    SVN_ERR(svn_ra_svn__parse_proplist(proplist, pool, props));
+
+  /* We're done if dirents aren't wanted. */
+  if (!dirents)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(parse_dirlist(dirents, dirlist, pool));
+}
+
+static svn_error_t *
+ra_svn_get_dirs(svn_ra_session_t *session,
+                apr_hash_t **dirents,
+                const apr_array_header_t *paths,
+                svn_revnum_t revision,
+                apr_uint32_t dirent_fields,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  svn_ra_svn__list_t *dirs;
+  int i;
+
+  if (!svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_GET_DIRS))
+    return svn_error_create(SVN_ERR_RA_NOT_IMPLEMENTED, NULL,
+                            _("'get-dirs' not implemented"));
+
+  SVN_ERR(send_trace_context(sess_baton, scratch_pool));
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w((!", "get-dirs"));
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      SVN_ERR(svn_ra_svn__write_cstring(conn, scratch_pool,
+                                        reparent_path(session, path,
+                                                      scratch_pool)));
+    }
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!)(r)(!", revision));
+  SVN_ERR(send_dirent_fields(conn, dirent_fields, scratch_pool));
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!))"));
+
+  SVN_ERR(handle_auth_request(sess_baton, scratch_pool));
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, result_pool, "l", &dirs));
+
+  if (dirs->nelts != paths->nelts)
+    return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                            _("Wrong number of directories in "
+                              "get-dirs response"));
+
+  /* The server answers in the order of the request. */
+  *dirents = apr_hash_make(result_pool);
+  for (i = 0; i < dirs->nelts; i++)
+    {
+      svn_ra_svn__item_t *elt = &SVN_RA_SVN__LIST_ITEM(dirs, i);
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      const char *returned_path;
+      svn_ra_svn__list_t *dirlist;
+      apr_hash_t *entries;
+
+      if (elt->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Directory element not a list"));
+      SVN_ERR(svn_ra_svn__parse_tuple(&elt->u.list, "cl", &returned_path,
+                                      &dirlist));
+
+      SVN_ERR(parse_dirlist(&entries, dirlist, result_pool));
+      svn_hash_sets(*dirents, apr_pstrdup(result_pool, path), entries);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Converts a apr_uint64_t with values TRUE, FALSE or
    SVN_RA_SVN_UNSPECIFIED_NUMBER as provided by svn_ra_svn__parse_tuple
    to a svn_tristate_t */
@@ -1727,6 +1931,7 @@ static svn_error_t *ra_svn_update(svn_ra_session_t *session,
   SVN_ERR(ensure_exact_server_parent(session, scratch_pool));
 
   /* Tell the server we want to start an update. */
+  SVN_ERR(send_trace_context(sess_baton, pool));
   SVN_ERR(svn_ra_svn__write_cmd_update(conn, pool, rev, target, recurse,
                                        depth, send_copyfrom_args,
                                        ignore_ancestry));
@@ -1761,6 +1966,7 @@ ra_svn_switch(svn_ra_session_t *session,
   SVN_ERR(ensure_exact_server_parent(session, scratch_pool));
 
   /* Tell the server we want to start a switch. */
+  SVN_ERR(send_trace_context(sess_baton, pool));
   SVN_ERR(svn_ra_svn__write_cmd_switch(conn, pool, rev, target, recurse,
                                        switch_url, depth,
                                        send_copyfrom_args, ignore_ancestry));
@@ -1789,6 +1995,7 @@ static svn_error_t *ra_svn_status(svn_ra_session_t *session,
   SVN_ERR(ensure_exact_server_parent(session, pool));
 
   /* Tell the server we want to start a status operation. */
+  SVN_ERR(send_trace_context(sess_baton, pool));
   SVN_ERR(svn_ra_svn__write_cmd_status(conn, pool, target, recurse, rev,
                                        depth));
   SVN_ERR(handle_auth_request(sess_baton, pool));
@@ -1819,6 +2026,7 @@ static svn_error_t *ra_svn_diff(svn_ra_session_t *session,
   SVN_ERR(ensure_exact_server_parent(session, pool));
 
   /* Tell the server we want to start a diff. */
+  SVN_ERR(send_trace_context(sess_baton, pool));
   SVN_ERR(svn_ra_svn__write_cmd_diff(conn, pool, rev, target, recurse,
                                      ignore_ancestry, versus_url,
                                      text_deltas, depth));
@@ -1869,6 +2077,7 @@ perform_ra_svn_log(svn_error_t **outer_error,
   svn_boolean_t want_date = FALSE;
   int nreceived = 0;
 
+  SVN_ERR(send_trace_context(sess_baton, pool));
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w((!", "log"));
   if (paths)
     {
@@ -2138,20 +2347,20 @@ static svn_error_t *handle_unsupported_cmd(svn_error_t *err,
 }
 
 
-static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
-                                const char *path, svn_revnum_t rev,
-                                svn_dirent_t **dirent, apr_pool_t *pool)
+/* Read the response to a stat command from the connection of SESS_BATON
+ * and set *DIRENT accordingly.  Allocate the result in POOL. */
+static svn_error_t *
+read_stat_response(svn_dirent_t **dirent,
+                   svn_ra_svn__session_baton_t *sess_baton,
+                   apr_pool_t *pool)
 {
-  svn_ra_svn__session_baton_t *sess_baton = session->priv;
-  svn_ra_svn_conn_t *conn = sess_baton->conn;
   svn_ra_svn__list_t *list = NULL;
   svn_dirent_t *the_dirent;
 
-  path = reparent_path(session, path, pool);
-  SVN_ERR(svn_ra_svn__write_cmd_stat(conn, pool, path, rev));
   SVN_ERR(handle_unsupported_cmd(handle_auth_request(sess_baton, pool),
                                  N_("'stat' not implemented")));
-  SVN_ERR(svn_ra_svn__read_cmd_response(conn, pool, "(?l)", &list));
+  SVN_ERR(svn_ra_svn__read_cmd_response(sess_baton->conn, pool, "(?l)",
+                                        &list));
 
   if (! list)
     {
@@ -2182,6 +2391,75 @@ static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *ra_svn_stat(svn_ra_session_t *session,
+                                const char *path, svn_revnum_t rev,
+                                svn_dirent_t **dirent, apr_pool_t *pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+
+  path = reparent_path(session, path, pool);
+  SVN_ERR(svn_ra_svn__write_cmd_stat(sess_baton->conn, pool, path, rev));
+
+  return svn_error_trace(read_stat_response(dirent, sess_baton, pool));
+}
+
+static svn_error_t *
+ra_svn_stat_many(svn_ra_session_t *session,
+                 apr_hash_t **dirents,
+                 const apr_array_header_t *paths,
+                 svn_revnum_t revision,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  int window = pipeline_window(sess_baton);
+  int to_send = paths->nelts;
+  int sent = 0;
+  int received = 0;
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  *dirents = apr_hash_make(result_pool);
+  while (received < to_send)
+    {
+      const char *path;
+      svn_dirent_t *dirent;
+      svn_error_t *read_err;
+
+      svn_pool_clear(iterpool);
+
+      for (; sent < to_send && sent - received < window; sent++)
+        {
+          path = APR_ARRAY_IDX(paths, sent, const char *);
+          SVN_ERR(svn_ra_svn__write_cmd_stat(sess_baton->conn, iterpool,
+                                             reparent_path(session, path,
+                                                           iterpool),
+                                             revision));
+        }
+
+      path = APR_ARRAY_IDX(paths, received, const char *);
+      received++;
+
+      read_err = read_stat_response(&dirent, sess_baton, result_pool);
+      if (read_err)
+        {
+          /* Read the responses to the commands already sent, unless
+           * the connection is out of sync anyway. */
+          if (is_connection_error(read_err))
+            return svn_error_compose_create(err, read_err);
+
+          err = svn_error_compose_create(err, read_err);
+          to_send = sent;
+        }
+      else if (dirent)
+        {
+          svn_hash_sets(*dirents, apr_pstrdup(result_pool, path), dirent);
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
 
 static svn_error_t *ra_svn_get_locations(svn_ra_session_t *session,
                                          apr_hash_t **locations,
@@ -2367,6 +2645,7 @@ static svn_error_t *ra_svn_get_file_revs(svn_ra_session_t *session,
   chunk_pool = svn_pool_create(pool);
 
   path = reparent_path(session, path, pool);
+  SVN_ERR(send_trace_context(sess_baton, pool));
   SVN_ERR(svn_ra_svn__write_cmd_get_file_revs(sess_baton->conn, pool,
                                               path, start, end,
                                               include_merged_revisions));
@@ -2964,6 +3243,7 @@ static svn_error_t *ra_svn_replay(svn_ra_session_t *session,
   /* Complex EDITOR callbacks may rely on client and server parent path
      being in sync. */
   SVN_ERR(ensure_exact_server_parent(session, pool));
+  SVN_ERR(send_trace_context(sess, pool));
   SVN_ERR(svn_ra_svn__write_cmd_replay(sess->conn, pool, revision,
                                        low_water_mark, send_deltas));
 
@@ -2997,6 +3277,7 @@ ra_svn_replay_range(svn_ra_session_t *session,
   /* Complex EDITOR callbacks may rely on client and server parent path
      being in sync. */
   SVN_ERR(ensure_exact_server_parent(session, pool));
+  SVN_ERR(send_trace_context(sess, pool));
   SVN_ERR(svn_ra_svn__write_cmd_replay_range(sess->conn, pool,
                                              start_revision, end_revision,
                                              low_water_mark, send_deltas));
@@ -3078,6 +3359,7 @@ ra_svn_has_capability(svn_ra_session_t *session,
       {SVN_RA_CAPABILITY_GET_FILE_REVS_REVERSE,
                                        SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE},
       {SVN_RA_CAPABILITY_LIST, SVN_RA_SVN_CAP_LIST},
+      {SVN_RA_CAPABILITY_BLAME, SVN_RA_SVN_CAP_BLAME},
 
       {NULL, NULL} /* End of list marker */
   };
@@ -3202,6 +3484,7 @@ ra_svn_list(svn_ra_session_t *session,
   path = reparent_path(session, path, scratch_pool);
 
   /* Send the list request. */
+  SVN_ERR(send_trace_context(sess_baton, scratch_pool));
   SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w(c(?r)w(!", "list",
                                   path, revision, svn_depth_to_word(depth)));
   SVN_ERR(send_dirent_fields(conn, dirent_fields, scratch_pool));
@@ -3260,6 +3543,74 @@ ra_svn_list(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+ra_svn_get_blame(svn_ra_session_t *session,
+                 const char *path,
+                 svn_revnum_t start,
+                 svn_revnum_t end,
+                 const apr_array_header_t *diff_options,
+                 svn_ra_blame_receiver_t receiver,
+                 void *receiver_baton,
+                 apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  svn_ra_svn_conn_t *conn = sess_baton->conn;
+  int i;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  path = reparent_path(session, path, scratch_pool);
+
+  /* Send the blame request. */
+  SVN_ERR(send_trace_context(sess_baton, scratch_pool));
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "w(crr(!", "blame",
+                                  path, start, end));
+  if (diff_options)
+    for (i = 0; i < diff_options->nelts; ++i)
+      {
+        const char *option = APR_ARRAY_IDX(diff_options, i, const char *);
+        SVN_ERR(svn_ra_svn__write_cstring(conn, scratch_pool, option));
+      }
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "!))"));
+
+  /* Handle auth request by server */
+  SVN_ERR(handle_auth_request(sess_baton, scratch_pool));
+
+  /* Read and process the blame chunks. */
+  while (1)
+    {
+      svn_ra_svn__item_t *item;
+      apr_uint64_t start_line;
+      svn_revnum_t revision;
+      svn_ra_svn__list_t *rev_proplist;
+      apr_hash_t *rev_props = NULL;
+
+      svn_pool_clear(iterpool);
+
+      /* Read the next chunk or bail out on "done", respectively */
+      SVN_ERR(svn_ra_svn__read_item(conn, iterpool, &item));
+      if (is_done_response(item))
+        break;
+      if (item->kind != SVN_RA_SVN_LIST)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Blame entry not a list"));
+      SVN_ERR(svn_ra_svn__parse_tuple(&item->u.list, "n(?r)l",
+                                      &start_line, &revision,
+                                      &rev_proplist));
+
+      if (SVN_IS_VALID_REVNUM(revision))
+        SVN_ERR(svn_ra_svn__parse_proplist(rev_proplist, iterpool,
+                                           &rev_props));
+
+      SVN_ERR(receiver(receiver_baton, (apr_int64_t) start_line, revision,
+                       rev_props, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Read the actual command response. */
+  SVN_ERR(svn_ra_svn__read_cmd_response(conn, scratch_pool, ""));
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *ra_svn_get_file(svn_ra_session_t *session, const char *path,
                                     svn_revnum_t rev, svn_stream_t *stream,
                                     svn_revnum_t *fetched_rev,
@@ -3288,6 +3639,82 @@ static svn_error_t *ra_svn_fetch_file_contents(svn_ra_session_t *session,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+ra_svn_fetch_files_contents(svn_ra_session_t *session,
+                            const apr_array_header_t *fetches,
+                            apr_pool_t *scratch_pool)
+{
+  svn_ra_svn__session_baton_t *sess_baton = session->priv;
+  int window = pipeline_window(sess_baton);
+  int to_send = fetches->nelts;
+  int sent = 0;
+  int received = 0;
+  int i;
+  svn_error_t *err = SVN_NO_ERROR;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+
+  while (received < to_send)
+    {
+      const svn_ra_file_fetch_t *fetch;
+      svn_error_t *write_err = SVN_NO_ERROR;
+      svn_error_t *read_err;
+
+      svn_pool_clear(iterpool);
+
+      for (; sent < to_send && sent - received < window; sent++)
+        {
+          fetch = APR_ARRAY_IDX(fetches, sent, const svn_ra_file_fetch_t *);
+          write_err = svn_ra_svn__write_cmd_get_file(
+                        sess_baton->conn, iterpool,
+                        reparent_path(session, fetch->path, iterpool),
+                        fetch->revision, FALSE, TRUE);
+          if (write_err)
+            break;
+        }
+
+      if (write_err)
+        {
+          err = svn_error_compose_create(err, write_err);
+          break;
+        }
+
+      fetch = APR_ARRAY_IDX(fetches, received, const svn_ra_file_fetch_t *);
+      received++;
+
+      read_err = read_get_file_response(sess_baton,
+                                        reparent_path(session, fetch->path,
+                                                      iterpool),
+                                        fetch->stream, NULL, NULL,
+                                        iterpool);
+      read_err = svn_error_compose_create(read_err,
+                                          svn_stream_close(fetch->stream));
+      if (read_err)
+        {
+          err = svn_error_compose_create(err, read_err);
+
+          /* Read the responses to the commands already sent, unless
+           * the connection is out of sync anyway. */
+          if (is_connection_error(read_err))
+            break;
+
+          to_send = sent;
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  /* As promised by svn_ra_fetch_files_contents(), close the streams of
+   * all fetches that we did not get to. */
+  for (i = received; i < fetches->nelts; i++)
+    {
+      const svn_ra_file_fetch_t *fetch
+        = APR_ARRAY_IDX(fetches, i, const svn_ra_file_fetch_t *);
+
+      err = svn_error_compose_create(err, svn_stream_close(fetch->stream));
+    }
+
+  return svn_error_trace(err);
+}
+
 static const svn_ra__vtable_t ra_svn_vtable = {
   svn_ra_svn_version,
   ra_svn_get_description,
@@ -3329,6 +3756,10 @@ static const svn_ra__vtable_t ra_svn_vtable = {
   NULL /* ra_set_svn_ra_open */,
   ra_svn_list,
   ra_svn_fetch_file_contents,
+  ra_svn_get_blame,
+  ra_svn_fetch_files_contents,
+  ra_svn_stat_many,
+  ra_svn_get_dirs,
   ra_svn_register_editor_shim_callbacks,
   NULL /* commit_ev2 */,
   NULL /* replay_range_ev2 */
@@ -353,7 +353,7 @@ static svn_error_t *ra_svn_apply_textdelta(void *file_baton,
 
   svn_txdelta_to_svndiff3(wh, wh_baton, diff_stream,
                           svn_ra_svn__svndiff_version(b->conn),
-                          b->conn->compression_level, pool);
+                          svn_ra_svn_compression_level(b->conn), pool);
   return SVN_NO_ERROR;
 }
 
@@ -48,6 +48,9 @@
 #include "private/svn_string_private.h"
 #include "private/svn_dep_compat.h"
 #include "private/svn_error_private.h"
+#include "private/svn_profile.h"
+#include "private/svn_probes.h"
+#include "private/svn_trace.h"
 #include "private/svn_subr_private.h"
 
 #define svn_iswhitespace(c) ((c) == ' ' || (c) == '\n')
@@ -72,6 +75,15 @@
  */
 #define ITEM_NESTING_LIMIT 64
 
+/* With adaptive compression, links faster than this many bytes per second
+ * get uncompressed data and links slower than ADAPTIVE_SLOW_LINK get the
+ * strongest compression.  lz4 is used in between. */
+#define ADAPTIVE_FAST_LINK (50 * 1024 * 1024)
+#define ADAPTIVE_SLOW_LINK (5 * 1024 * 1024)
+
+/* Amount of data to send before updating the throughput estimate. */
+#define ADAPTIVE_SAMPLE_SIZE (0x100000)
+
 /* The protocol words for booleans. */
 static const svn_string_t str_true = SVN__STATIC_STRING("true");
 static const svn_string_t str_false = SVN__STATIC_STRING("false");
@@ -200,6 +212,12 @@ svn_ra_svn_conn_t *svn_ra_svn_create_conn5(apr_socket_t *sock,
   conn->encrypted = FALSE;
 #endif
   conn->session = NULL;
+  conn->trace_context[0] = '\0';
+  conn->write_buf_size = SVN_RA_SVN__WRITEBUF_SIZE;
+  conn->read_buf_size = SVN_RA_SVN__READBUF_SIZE;
+  conn->max_buf_size = SVN_RA_SVN__MAX_BUF_SIZE;
+  conn->write_buf = apr_palloc(result_pool, conn->write_buf_size);
+  conn->read_buf = apr_palloc(result_pool, conn->read_buf_size);
   conn->read_ptr = conn->read_buf;
   conn->read_end = conn->read_buf;
   conn->write_pos = 0;
@@ -210,11 +228,22 @@ svn_ra_svn_conn_t *svn_ra_svn_create_conn5(apr_socket_t *sock,
   conn->current_in = 0;
   conn->max_out = max_out;
   conn->current_out = 0;
+  conn->total_in = 0;
+  conn->total_out = 0;
+  conn->command_hook = NULL;
+  conn->command_hook_baton = NULL;
+  conn->capture = NULL;
+  conn->capture_limit = 0;
+  conn->capture_overflow = FALSE;
   conn->block_handler = NULL;
   conn->block_baton = NULL;
   conn->capabilities = apr_hash_make(result_pool);
   conn->compression_level = compression_level;
   conn->zero_copy_limit = zero_copy_limit;
+  conn->adaptive_compression = FALSE;
+  conn->throughput = 0;
+  conn->sample_bytes = 0;
+  conn->sample_time = 0;
   conn->pool = result_pool;
 
   if (sock != NULL)
@@ -273,13 +302,38 @@ svn_ra_svn__svndiff_version(svn_ra_svn_conn_t *conn)
   if (svn_ra_svn_compression_level(conn) <= 0)
     return 0;
 
-  /* Prefer SVNDIFF2 over SVNDIFF1. */
+  /* On medium-speed links, the speed of lz4 beats the better compression
+   * of the others.  On slow links, it's the other way around. */
+  if (conn->adaptive_compression && conn->throughput)
+    {
+      if (   conn->throughput >= ADAPTIVE_SLOW_LINK
+          && svn_ra_svn_has_capability(conn,
+                                       SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED))
+        return 2;
+
+      if (   conn->throughput < ADAPTIVE_SLOW_LINK
+          && svn_zstd__is_available()
+          && svn_ra_svn_has_capability(conn,
+                                       SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED))
+        return 3;
+
+      if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF1))
+        return 1;
+
+      return 0;
+    }
+
+  /* Prefer SVNDIFF3 over SVNDIFF2 over SVNDIFF1.  We can only produce
+   * SVNDIFF3 if we have been built with Zstandard support. */
+  if (svn_zstd__is_available()
+      && svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED))
+    return 3;
   if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF2_ACCEPTED))
     return 2;
   if (svn_ra_svn_has_capability(conn, SVN_RA_SVN_CAP_SVNDIFF1))
     return 1;
 
-  /* The connection does not support SVNDIFF1/2; default to "version 0". */
+  /* The connection does not support SVNDIFF1/2/3; default to "version 0". */
   return 0;
 }
 
@@ -303,9 +357,36 @@ svn_boolean_t svn_ra_svn_has_capability(svn_ra_svn_conn_t *conn,
   return (svn_hash_gets(conn->capabilities, capability) != NULL);
 }
 
+void
+svn_ra_svn__set_adaptive_compression(svn_ra_svn_conn_t *conn,
+                                     svn_boolean_t adaptive)
+{
+  conn->adaptive_compression = adaptive;
+}
+
+void
+svn_ra_svn__set_max_buffer_size(svn_ra_svn_conn_t *conn,
+                                apr_size_t size)
+{
+  conn->max_buf_size = size;
+}
+
 int
 svn_ra_svn_compression_level(svn_ra_svn_conn_t *conn)
 {
+  /* Until we know the link speed, use the configured level. */
+  if (   !conn->adaptive_compression
+      || !conn->throughput
+      || conn->compression_level <= SVN_DELTA_COMPRESSION_LEVEL_NONE)
+    return conn->compression_level;
+
+  if (conn->throughput >= ADAPTIVE_FAST_LINK)
+    return SVN_DELTA_COMPRESSION_LEVEL_NONE;
+
+  /* Even if lz4 is not available, keep zlib as cheap as possible. */
+  if (conn->throughput >= ADAPTIVE_SLOW_LINK)
+    return 1;
+
   return conn->compression_level;
 }
 
@@ -343,10 +424,20 @@ svn_ra_svn__reset_command_io_counters(svn_ra_svn_conn_t *conn)
   conn->current_out = 0;
 }
 
+void
+svn_ra_svn__set_command_hook(svn_ra_svn_conn_t *conn,
+                             svn_ra_svn__command_hook_t hook,
+                             void *baton)
+{
+  conn->command_hook = hook;
+  conn->command_hook_baton = baton;
+}
+
 
 /* --- WRITE BUFFER MANAGEMENT --- */
 
-/* Return an error object if CONN exceeded its send or receive limits. */
+/* Return an error object if CONN exceeded its send or receive limits
+ * or the process exceeded its memory budget. */
 static svn_error_t *
 check_io_limits(svn_ra_svn_conn_t *conn)
 {
@@ -360,32 +451,82 @@ check_io_limits(svn_ra_svn_conn_t *conn)
                             "The server response size exceeds the "
                             "configured limit");
 
-  return SVN_NO_ERROR;
+  return svn_error_trace(svn_pool__check_memory_budget());
 }
 
-/* Write data to socket or output file as appropriate. */
-static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
-                                    const char *data, apr_size_t len)
-{
-  const char *end = data + len;
+/* Add the LEN bytes that CONN just sent within DURATION to the current
+ * throughput sample.  Once the sample is large enough, fold it into
+ * CONN's throughput estimate.
+ *
+ * Writes only take time once the OS send buffers are full, i.e. when the
+ * link is the bottleneck.  Short bursts will therefore look fast, which
+ * is fine because compression hardly matters for them. */
+static void
+update_throughput(svn_ra_svn_conn_t *conn,
+                  apr_size_t len,
+                  apr_interval_time_t duration)
+{
+  apr_uint64_t sample;
+
+  conn->sample_bytes += len;
+  conn->sample_time += duration;
+  if (conn->sample_bytes < ADAPTIVE_SAMPLE_SIZE)
+    return;
+
+  /* A sample that took no measurable time came from a very fast link. */
+  sample = conn->sample_time > 0
+         ? conn->sample_bytes * APR_USEC_PER_SEC / conn->sample_time
+         : 2 * ADAPTIVE_FAST_LINK;
+
+  /* Smooth out the estimate but follow changes within a few samples. */
+  conn->throughput = conn->throughput
+                   ? (conn->throughput * 3 + sample) / 4
+                   : sample;
+  conn->sample_bytes = 0;
+  conn->sample_time = 0;
+}
+
+/* Write the NVEC buffers in VEC to socket or output file as appropriate.
+ * VEC will be modified. */
+static svn_error_t *writebuf_outputv(svn_ra_svn_conn_t *conn,
+                                     apr_pool_t *pool,
+                                     struct iovec *vec, int nvec)
+{
+  apr_size_t len = 0;
   apr_size_t count;
   apr_pool_t *subpool = NULL;
   svn_ra_svn__session_baton_t *session = conn->session;
+  apr_time_t start = conn->adaptive_compression ? apr_time_now() : 0;
+  int i;
+
+  for (i = 0; i < nvec; ++i)
+    len += vec[i].iov_len;
 
   /* Limit the size of the response, if a limit has been configured.
    * This is to limit the server load in case users e.g. accidentally ran
    * an export on the root folder. */
   conn->current_out += len;
+  conn->total_out += len;
   SVN_ERR(check_io_limits(conn));
 
-  while (data < end)
+  if (conn->capture && !conn->capture_overflow)
     {
-      count = end - data;
+      if (conn->capture->len + len <= conn->capture_limit)
+        for (i = 0; i < nvec; ++i)
+          svn_stringbuf_appendbytes(conn->capture, vec[i].iov_base,
+                                    vec[i].iov_len);
+      else
+        conn->capture_overflow = TRUE;
+    }
 
+  i = 0;
+  while (i < nvec)
+    {
       if (session && session->callbacks && session->callbacks->cancel_func)
         SVN_ERR((session->callbacks->cancel_func)(session->callbacks_baton));
 
-      SVN_ERR(svn_ra_svn__stream_write(conn->stream, data, &count));
+      SVN_ERR(svn_ra_svn__stream_writev(conn->stream, vec + i, nvec - i,
+                                        &count));
       if (count == 0)
         {
           if (!subpool)
@@ -394,7 +535,6 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
             svn_pool_clear(subpool);
           SVN_ERR(conn->block_handler(conn, subpool, conn->block_baton));
         }
-      data += count;
 
       if (session)
         {
@@ -405,17 +545,41 @@ static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
             (cb->progress_func)(session->bytes_written + session->bytes_read,
                                 -1, cb->progress_baton, subpool);
         }
+
+      /* Skip what has been written. */
+      while (i < nvec && count >= vec[i].iov_len)
+        count -= vec[i++].iov_len;
+      if (i < nvec)
+        {
+          vec[i].iov_base = (char *)vec[i].iov_base + count;
+          vec[i].iov_len -= count;
+        }
     }
 
   conn->written_since_error_check += len;
   conn->may_check_for_error
     = conn->written_since_error_check >= conn->error_check_interval;
 
+  if (conn->adaptive_compression)
+    update_throughput(conn, len, apr_time_now() - start);
+
   if (subpool)
     svn_pool_destroy(subpool);
   return SVN_NO_ERROR;
 }
 
+/* Write data to socket or output file as appropriate. */
+static svn_error_t *writebuf_output(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
+                                    const char *data, apr_size_t len)
+{
+  struct iovec vec;
+
+  vec.iov_base = (void *)data;
+  vec.iov_len = len;
+
+  return svn_error_trace(writebuf_outputv(conn, pool, &vec, 1));
+}
+
 /* Write data from the write buffer out to the socket. */
 static svn_error_t *writebuf_flush(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
 {
@@ -427,21 +591,51 @@ static svn_error_t *writebuf_flush(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Like writebuf_flush but called when the write buffer ran out of space.
+ * As this indicates a sustained transfer, double the buffer size until it
+ * reaches CONN->MAX_BUF_SIZE. */
+static svn_error_t *writebuf_flush_full(svn_ra_svn_conn_t *conn,
+                                        apr_pool_t *pool)
+{
+  SVN_ERR(writebuf_flush(conn, pool));
+
+  /* The buffer is empty, so there is nothing to copy. */
+  if (conn->write_buf_size < conn->max_buf_size)
+    {
+      conn->write_buf_size = MIN(2 * conn->write_buf_size,
+                                 conn->max_buf_size);
+      conn->write_buf = apr_palloc(conn->pool, conn->write_buf_size);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *writebuf_write(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
                                    const char *data, apr_size_t len)
 {
-  /* data >= 8k is sent immediately */
-  if (len >= sizeof(conn->write_buf) / 2)
+  /* large data is sent immediately */
+  if (len >= conn->write_buf_size / 2)
     {
-      if (conn->write_pos > 0)
-        SVN_ERR(writebuf_flush(conn, pool));
-
-      return writebuf_output(conn, pool, data, len);
+      struct iovec vec[2];
+      apr_size_t write_pos = conn->write_pos;
+
+      /* Send the buffered data along with DATA in one system call.
+       * Clear conn->write_pos first in case the block handler does a
+       * read. */
+      conn->write_pos = 0;
+      vec[0].iov_base = conn->write_buf;
+      vec[0].iov_len = write_pos;
+      vec[1].iov_base = (void *)data;
+      vec[1].iov_len = len;
+
+      return svn_error_trace(write_pos ? writebuf_outputv(conn, pool, vec, 2)
+                                       : writebuf_outputv(conn, pool,
+                                                          vec + 1, 1));
     }
 
   /* ensure room for the data to add */
-  if (conn->write_pos + len > sizeof(conn->write_buf))
-    SVN_ERR(writebuf_flush(conn, pool));
+  if (conn->write_pos + len > conn->write_buf_size)
+    SVN_ERR(writebuf_flush_full(conn, pool));
 
   /* buffer the new data block as well */
   memcpy(conn->write_buf + conn->write_pos, data, len);
@@ -461,7 +655,7 @@ static svn_error_t *writebuf_write(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
 static APR_INLINE svn_error_t *
 writebuf_writechar(svn_ra_svn_conn_t *conn, apr_pool_t *pool, char data)
 {
-  if (conn->write_pos < sizeof(conn->write_buf))
+  if (conn->write_pos < conn->write_buf_size)
   {
     conn->write_buf[conn->write_pos] = data;
     conn->write_pos++;
@@ -509,6 +703,7 @@ static svn_error_t *readbuf_input(svn_ra_svn_conn_t *conn, char *data,
   if (*len == 0)
     return svn_error_create(SVN_ERR_RA_SVN_CONNECTION_CLOSED, NULL, NULL);
   conn->current_in += *len;
+  conn->total_in += *len;
 
   if (session)
     {
@@ -535,7 +730,7 @@ static svn_error_t *readbuf_skip(svn_ra_svn_conn_t *conn, apr_uint64_t len)
     if (len == 0)
       break;
 
-    buflen = sizeof(conn->read_buf);
+    buflen = conn->read_buf_size;
     SVN_ERR(svn_ra_svn__stream_read(conn->stream, conn->read_buf, &buflen));
     if (buflen == 0)
       return svn_error_create(SVN_ERR_RA_SVN_CONNECTION_CLOSED, NULL, NULL);
@@ -560,8 +755,17 @@ static svn_error_t *readbuf_fill(svn_ra_svn_conn_t *conn, apr_pool_t *pool)
   if (conn->write_pos)
     SVN_ERR(writebuf_flush(conn, pool));
 
+  /* If the last read filled the whole buffer, more data is likely to
+   * follow.  The buffer is empty, so we may simply replace it. */
+  if (   conn->read_end == conn->read_buf + conn->read_buf_size
+      && conn->read_buf_size < conn->max_buf_size)
+    {
+      conn->read_buf_size = MIN(2 * conn->read_buf_size, conn->max_buf_size);
+      conn->read_buf = apr_palloc(conn->pool, conn->read_buf_size);
+    }
+
   /* Fill (some of the) buffer. */
-  len = sizeof(conn->read_buf);
+  len = conn->read_buf_size;
   SVN_ERR(readbuf_input(conn, conn->read_buf, &len, pool));
   conn->read_ptr = conn->read_buf;
   conn->read_end = conn->read_buf + len;
@@ -602,7 +806,7 @@ static svn_error_t *readbuf_read(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
   data = readbuf_drain(conn, data, end);
 
   /* Read large chunks directly into buffer. */
-  while (end - data > (apr_ssize_t)sizeof(conn->read_buf))
+  while (end - data > (apr_ssize_t)conn->read_buf_size)
     {
       SVN_ERR(writebuf_flush(conn, pool));
       count = end - data;
@@ -624,7 +828,7 @@ static svn_error_t *readbuf_read(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
 static svn_error_t *readbuf_skip_leading_garbage(svn_ra_svn_conn_t *conn,
                                                  apr_pool_t *pool)
 {
-  char buf[256];  /* Must be smaller than sizeof(conn->read_buf) - 1. */
+  char buf[256];  /* Must be smaller than CONN->READ_BUF_SIZE - 1. */
   const char *p, *end;
   apr_size_t len;
   svn_boolean_t lparen = FALSE;
@@ -668,8 +872,8 @@ static svn_error_t *write_number(svn_ra_svn_conn_t *conn, apr_pool_t *pool,
 
   /* SVN_INT64_BUFFER_SIZE includes space for a terminating NUL that
    * svn__ui64toa will always append. */
-  if (conn->write_pos + SVN_INT64_BUFFER_SIZE >= sizeof(conn->write_buf))
-    SVN_ERR(writebuf_flush(conn, pool));
+  if (conn->write_pos + SVN_INT64_BUFFER_SIZE >= conn->write_buf_size)
+    SVN_ERR(writebuf_flush_full(conn, pool));
 
   written = svn__ui64toa(conn->write_buf + conn->write_pos, number);
   conn->write_buf[conn->write_pos + written] = follow;
@@ -728,7 +932,7 @@ svn_ra_svn__write_ncstring(svn_ra_svn_conn_t *conn,
 {
   /* Apart from LEN bytes of string contents, we need room for a number,
      a colon and a space. */
-  apr_size_t max_fill = sizeof(conn->write_buf) - SVN_INT64_BUFFER_SIZE - 2;
+  apr_size_t max_fill = conn->write_buf_size - SVN_INT64_BUFFER_SIZE - 2;
 
   /* In most cases, there is enough left room in the WRITE_BUF
      the we can serialize directly into it.  On platforms with
@@ -771,6 +975,72 @@ svn_ra_svn__write_cstring(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_svn__write_file_string(svn_ra_svn_conn_t *conn,
+                              apr_pool_t *pool,
+                              apr_file_t *file,
+                              apr_off_t offset,
+                              apr_size_t len)
+{
+  SVN_ERR(write_number(conn, pool, len, ':'));
+
+  /* The kernel would bypass any capture. */
+  if (!conn->capture && svn_ra_svn__stream_can_sendfile(conn->stream))
+    {
+      apr_pool_t *subpool = NULL;
+
+      /* The string length must go out before the contents. */
+      SVN_ERR(writebuf_flush(conn, pool));
+
+      conn->current_out += len;
+      conn->total_out += len;
+      SVN_ERR(check_io_limits(conn));
+
+      conn->written_since_error_check += len;
+      conn->may_check_for_error
+        = conn->written_since_error_check >= conn->error_check_interval;
+
+      while (len > 0)
+        {
+          apr_size_t count = len;
+
+          SVN_ERR(svn_ra_svn__stream_sendfile(conn->stream, file, offset,
+                                              &count));
+          if (count == 0 && conn->block_handler)
+            {
+              if (!subpool)
+                subpool = svn_pool_create(pool);
+              else
+                svn_pool_clear(subpool);
+              SVN_ERR(conn->block_handler(conn, subpool, conn->block_baton));
+            }
+
+          offset += count;
+          len -= count;
+        }
+
+      if (subpool)
+        svn_pool_destroy(subpool);
+    }
+  else
+    {
+      char *buffer = apr_palloc(pool, SVN__STREAM_CHUNK_SIZE);
+
+      SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+      while (len > 0)
+        {
+          apr_size_t count = MIN(len, SVN__STREAM_CHUNK_SIZE);
+
+          SVN_ERR(svn_io_file_read_full2(file, buffer, count, NULL, NULL,
+                                         pool));
+          SVN_ERR(writebuf_write(conn, pool, buffer, count));
+          len -= count;
+        }
+    }
+
+  return writebuf_writechar(conn, pool, ' ');
+}
+
 svn_error_t *
 svn_ra_svn__write_word(svn_ra_svn_conn_t *conn,
                        apr_pool_t *pool,
@@ -830,7 +1100,7 @@ svn_error_t *
 svn_ra_svn__start_list(svn_ra_svn_conn_t *conn,
                        apr_pool_t *pool)
 {
-  if (conn->write_pos + 2 <= sizeof(conn->write_buf))
+  if (conn->write_pos + 2 <= conn->write_buf_size)
     {
       conn->write_buf[conn->write_pos] = '(';
       conn->write_buf[conn->write_pos+1] = ' ';
@@ -845,7 +1115,7 @@ svn_error_t *
 svn_ra_svn__end_list(svn_ra_svn_conn_t *conn,
                      apr_pool_t *pool)
 {
-  if (conn->write_pos + 2 <= sizeof(conn->write_buf))
+  if (conn->write_pos + 2 <= conn->write_buf_size)
   {
     conn->write_buf[conn->write_pos] = ')';
     conn->write_buf[conn->write_pos+1] = ' ';
@@ -866,6 +1136,44 @@ svn_ra_svn__flush(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_svn__start_capture(svn_ra_svn_conn_t *conn,
+                          apr_size_t limit,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  /* Earlier output must not end up in the capture. */
+  SVN_ERR(writebuf_flush(conn, scratch_pool));
+
+  conn->capture = svn_stringbuf_create_empty(result_pool);
+  conn->capture_limit = limit;
+  conn->capture_overflow = FALSE;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_svn__end_capture(svn_stringbuf_t **captured,
+                        svn_ra_svn_conn_t *conn,
+                        apr_pool_t *scratch_pool)
+{
+  svn_error_t *err = writebuf_flush(conn, scratch_pool);
+
+  *captured = conn->capture_overflow ? NULL : conn->capture;
+  conn->capture = NULL;
+
+  return svn_error_trace(err);
+}
+
+svn_error_t *
+svn_ra_svn__write_raw(svn_ra_svn_conn_t *conn,
+                      apr_pool_t *pool,
+                      const char *data,
+                      apr_size_t len)
+{
+  return svn_error_trace(writebuf_write(conn, pool, data, len));
+}
+
 /* --- WRITING TUPLES --- */
 
 static svn_error_t *
@@ -990,7 +1298,7 @@ write_tuple_string_opt_list(svn_ra_svn_conn_t *conn,
 
   /* If this how far we can fill the WRITE_BUF with string data and still
      guarantee that the length info will fit in as well. */
-  max_fill = sizeof(conn->write_buf)
+  max_fill = conn->write_buf_size
            - 2                       /* open list */
            - SVN_INT64_BUFFER_SIZE   /* string length + separator */
            - 2;                      /* close list */
@@ -1861,8 +2169,11 @@ svn_ra_svn__read_cmd_response(svn_ra_svn_conn_t *conn,
   const char *status;
   svn_ra_svn__list_t *params;
   svn_error_t *err;
+  apr_time_t start = svn_profile__start();
 
   SVN_ERR(svn_ra_svn__read_tuple(conn, pool, "wl", &status, &params));
+  svn_profile__record("ra_svn", "command response", start, 0);
+
   if (strcmp(status, "success") == 0)
     {
       va_start(ap, fmt);
@@ -1915,6 +2226,10 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
   svn_error_t *err, *write_err;
   svn_ra_svn__list_t *params;
   const svn_ra_svn__cmd_entry_t *command;
+  apr_uint64_t total_in = conn->total_in;
+  apr_uint64_t total_out = conn->total_out;
+  apr_time_t start;
+  svn_trace__span_t *span;
 
   *terminate = FALSE;
 
@@ -1934,9 +2249,38 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
       return err;
     }
 
+  /* The client tells us which of its trace spans the following commands
+     belong to.  This command has no response, not even on errors. */
+  if (strcmp(cmdname, "trace-context") == 0)
+    {
+      const char *traceparent;
+
+      err = svn_ra_svn__parse_tuple(params, "c", &traceparent);
+      if (err)
+        {
+          svn_error_clear(err);
+          conn->trace_context[0] = '\0';
+        }
+      else
+        apr_cpystrn(conn->trace_context, traceparent,
+                    sizeof(conn->trace_context));
+
+      return SVN_NO_ERROR;
+    }
+
+  /* Don't count the time we waited for the command to arrive. */
+  start = conn->command_hook ? apr_time_now() : 0;
+  SVN_PROBE1(ra__svn__command__start, cmdname);
+
   command = svn_hash_gets(cmd_hash, cmdname);
   if (command)
     {
+      /* Connections may move between threads from one command to the
+         next, so continue the client's trace for every command. */
+      svn_trace__continue(conn->trace_context[0] ? conn->trace_context
+                                                 : NULL);
+      span = svn_trace__begin("ra_svn", cmdname, pool);
+
       /* Call the standard command handler.
        * If that is not set, then this is a lecagy API call and we invoke
        * the legacy command handler. */
@@ -1958,6 +2302,7 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
        * So, check again for the limit violations and exit the command
        * processing quickly if we may have truncated data. */
       err = svn_error_compose_create(check_io_limits(conn), err);
+      svn_trace__end(span);
 
       *terminate = command->terminate;
     }
@@ -1968,6 +2313,17 @@ svn_ra_svn__handle_command(svn_boolean_t *terminate,
       err = svn_error_create(SVN_ERR_RA_SVN_CMD_ERR, err, NULL);
     }
 
+  SVN_PROBE4(ra__svn__command__done, cmdname, conn->total_in - total_in,
+             conn->total_out - total_out, err != NULL);
+
+  /* Unknown command names are up to the client; don't pass them on. */
+  if (conn->command_hook && command)
+    conn->command_hook(conn->command_hook_baton, cmdname,
+                       apr_time_now() - start,
+                       conn->total_in - total_in,
+                       conn->total_out - total_out,
+                       err != NULL);
+
   if (err && err->apr_err == SVN_ERR_RA_SVN_CMD_ERR)
     {
       write_err = svn_ra_svn__write_cmd_failure(
@@ -2348,6 +2704,18 @@ svn_ra_svn__write_cmd_reparent(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_ra_svn__write_cmd_trace_context(svn_ra_svn_conn_t *conn,
+                                    apr_pool_t *pool,
+                                    const char *traceparent)
+{
+  SVN_ERR(writebuf_write_literal(conn, pool, "( trace-context ( "));
+  SVN_ERR(write_tuple_cstring(conn, pool, traceparent));
+  SVN_ERR(writebuf_write_literal(conn, pool, ") ) "));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_ra_svn__write_cmd_get_latest_rev(svn_ra_svn_conn_t *conn,
                                    apr_pool_t *pool)
@@ -2845,7 +3213,7 @@ svn_ra_svn__write_data_log_changed_path(svn_ra_svn_conn_t *conn,
   apr_size_t flags_len = flags_str->len;
 
   /* How much buffer space can we use for non-string data (worst case)? */
-  apr_size_t max_fill = sizeof(conn->write_buf)
+  apr_size_t max_fill = conn->write_buf_size
                       - 2                          /* list start */
                       - 2 - SVN_INT64_BUFFER_SIZE  /* path */
                       - 2                          /* action */
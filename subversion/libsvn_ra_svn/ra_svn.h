@@ -37,6 +37,7 @@ extern "C" {
 #include "svn_ra_svn.h"
 
 #include "private/svn_ra_svn_private.h"
+#include "private/svn_trace.h"
 
 /* Callback function that indicates if a svn_ra_svn__stream_t has pending
  * data.
@@ -62,10 +63,13 @@ typedef svn_error_t *(*ra_svn_block_handler_t)(svn_ra_svn_conn_t *conn,
 #define SVN_RA_SVN__DEFAULT_USERAGENT  "SVN/" SVN_VER_NUMBER\
                                        " (" SVN_BUILD_TARGET ")"
 
-/* The size of our per-connection read and write buffers. */
+/* The initial size of our per-connection read and write buffers.
+ * They double in size during sustained transfers up to a per-connection
+ * limit that defaults to SVN_RA_SVN__MAX_BUF_SIZE. */
 #define SVN_RA_SVN__PAGE_SIZE 4096
 #define SVN_RA_SVN__READBUF_SIZE (4 * SVN_RA_SVN__PAGE_SIZE)
 #define SVN_RA_SVN__WRITEBUF_SIZE (4 * SVN_RA_SVN__PAGE_SIZE)
+#define SVN_RA_SVN__MAX_BUF_SIZE (64 * SVN_RA_SVN__PAGE_SIZE)
 
 /* Create forward reference */
 typedef struct svn_ra_svn__session_baton_t svn_ra_svn__session_baton_t;
@@ -75,8 +79,11 @@ typedef struct svn_ra_svn__session_baton_t svn_ra_svn__session_baton_t;
 struct svn_ra_svn_conn_st {
 
   /* I/O buffers */
-  char write_buf[SVN_RA_SVN__WRITEBUF_SIZE];
-  char read_buf[SVN_RA_SVN__READBUF_SIZE];
+  char *write_buf;
+  char *read_buf;
+  apr_size_t write_buf_size;
+  apr_size_t read_buf_size;
+  apr_size_t max_buf_size;
   char *read_ptr;
   char *read_end;
   apr_size_t write_pos;
@@ -102,6 +109,24 @@ struct svn_ra_svn_conn_st {
   apr_uint64_t max_out;
   apr_uint64_t current_out;
 
+  /* I/O totals over the lifetime of the connection */
+  apr_uint64_t total_in;
+  apr_uint64_t total_out;
+
+  /* called for every command handled by svn_ra_svn__handle_command */
+  svn_ra_svn__command_hook_t command_hook;
+  void *command_hook_baton;
+
+  /* The last traceparent sent by the client with a trace-context command,
+     or empty. */
+  char trace_context[SVN_TRACE__TRACEPARENT_SIZE];
+
+  /* if not NULL, a copy of everything written since
+     svn_ra_svn__start_capture, unless that exceeded CAPTURE_LIMIT */
+  svn_stringbuf_t *capture;
+  apr_size_t capture_limit;
+  svn_boolean_t capture_overflow;
+
   /* repository info */
   const char *uuid;
   const char *repos_root;
@@ -115,6 +140,13 @@ struct svn_ra_svn_conn_st {
   int compression_level;
   apr_size_t zero_copy_limit;
 
+  /* adaptive compression: the send throughput in bytes per second
+     (0 if unknown) and the sample currently being collected */
+  svn_boolean_t adaptive_compression;
+  apr_uint64_t throughput;
+  apr_uint64_t sample_bytes;
+  apr_interval_time_t sample_time;
+
   /* who's on the other side of the connection? */
   char *remote_ip;
 
@@ -160,6 +192,10 @@ struct svn_ra_svn__session_baton_t {
   apr_off_t bytes_read, bytes_written; /* apr_off_t's because that's what
                                           the callback interface uses */
   const char *useragent;
+
+  /* Whether we told the server who we are.  Until then, it may answer any
+     command with an auth request. */
+  svn_boolean_t authenticated;
 };
 
 /* Set a callback for blocked writes on conn.  This handler may
@@ -222,6 +258,30 @@ svn_ra_svn__stream_t *svn_ra_svn__stream_create(svn_stream_t *in_stream,
 svn_error_t *svn_ra_svn__stream_write(svn_ra_svn__stream_t *stream,
                                       const char *data, apr_size_t *len);
 
+/* Write the NVEC buffers in VEC to STREAM in that order, returning the
+ * number of bytes written in *LEN.  Sockets write as many of them as
+ * possible in one system call.  Other streams write at most one buffer.
+ */
+svn_error_t *svn_ra_svn__stream_writev(svn_ra_svn__stream_t *stream,
+                                       const struct iovec *vec,
+                                       int nvec,
+                                       apr_size_t *len);
+
+/* Return TRUE if svn_ra_svn__stream_sendfile() may be used on STREAM,
+ * i.e. if STREAM writes unmodified data to a socket and the platform
+ * supports sendfile.
+ */
+svn_boolean_t svn_ra_svn__stream_can_sendfile(svn_ra_svn__stream_t *stream);
+
+/* Send up to *LEN bytes from FILE, starting at OFFSET, to STREAM without
+ * copying them through user space, returning the number of bytes sent in
+ * *LEN.  STREAM must support this, see svn_ra_svn__stream_can_sendfile().
+ */
+svn_error_t *svn_ra_svn__stream_sendfile(svn_ra_svn__stream_t *stream,
+                                         apr_file_t *file,
+                                         apr_off_t offset,
+                                         apr_size_t *len);
+
 /* Read *LEN bytes from STREAM into DATA, returning the number of bytes
  * read in *LEN.
  */
@@ -275,6 +335,19 @@ svn_boolean_t svn_ra_svn__find_mech(const svn_ra_svn__list_t *mechlist,
 /* Initialize the SASL library. */
 svn_error_t *svn_ra_svn__sasl_init(void);
 
+/* Negotiate TLS as the client on CONN, which talks over SOCK to port PORT
+ * of SESS->hostname.  Verify the server certificate against the trust
+ * settings in SERVERS (which may be NULL) and ask SESS->auth_baton about
+ * any failures.  Resume an earlier TLS session with the same server if
+ * possible.  Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_ra_svn__tls_connect(svn_ra_svn_conn_t *conn,
+                        apr_socket_t *sock,
+                        svn_ra_svn__session_baton_t *sess,
+                        apr_port_t port,
+                        svn_config_t *servers,
+                        apr_pool_t *scratch_pool);
+
 
 #ifdef __cplusplus
 }
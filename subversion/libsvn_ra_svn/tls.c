@@ -0,0 +1,959 @@
+/*
+ * tls.c :  TLS encryption for the ra_svn protocol
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_private_config.h"
+
+#include <limits.h>
+
+#include <apr_network_io.h>
+#include <apr_poll.h>
+#include <apr_strings.h>
+
+#include "svn_types.h"
+#include "svn_error.h"
+#include "svn_pools.h"
+#include "svn_hash.h"
+#include "svn_auth.h"
+#include "svn_base64.h"
+#include "svn_checksum.h"
+#include "svn_config.h"
+#include "svn_dirent_uri.h"
+#include "svn_sorts.h"
+#include "svn_string.h"
+#include "svn_time.h"
+#include "svn_utf.h"
+#include "svn_x509.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+
+#include "ra_svn.h"
+
+#ifdef SVN_HAVE_OPENSSL
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+
+/* The session ID context of all svnserve TLS sessions. */
+#define SESSION_ID_CONTEXT "svnserve"
+
+struct svn_ra_svn__tls_server_t
+{
+  SSL_CTX *ctx;
+};
+
+/* State of one TLS connection. */
+typedef struct tls_baton_t
+{
+  SSL *ssl;
+  apr_socket_t *sock;
+
+  /* The status of the last socket operation. */
+  apr_status_t status;
+
+  /* Client only: key of this server in the session cache, the
+     certificate verification failures found during the handshake, whether
+     we trust the server, and a session that arrived before we did. */
+  const char *session_key;
+  apr_uint32_t failures;
+  svn_boolean_t trusted;
+  SSL_SESSION *pending_session;
+
+  /* Used for polling the socket. */
+  apr_pool_t *pool;
+} tls_baton_t;
+
+
+/*** The BIO connecting OpenSSL to an apr_socket_t. ***/
+
+/* Implements the BIO write method for a BIO whose data is a tls_baton_t. */
+static int
+bio_apr_socket_write(BIO *bio, const char *data, int len)
+{
+  tls_baton_t *b = BIO_get_data(bio);
+  apr_size_t written = len;
+
+  BIO_clear_retry_flags(bio);
+  b->status = apr_socket_send(b->sock, data, &written);
+  if (written > 0)
+    return (int)written;
+
+  /* With a timeout set, the socket may not accept anything right now. */
+  if (APR_STATUS_IS_EAGAIN(b->status) || APR_STATUS_IS_TIMEUP(b->status))
+    BIO_set_retry_write(bio);
+
+  return -1;
+}
+
+/* Implements the BIO read method for a BIO whose data is a tls_baton_t. */
+static int
+bio_apr_socket_read(BIO *bio, char *data, int len)
+{
+  tls_baton_t *b = BIO_get_data(bio);
+  apr_size_t read = len;
+
+  BIO_clear_retry_flags(bio);
+  b->status = apr_socket_recv(b->sock, data, &read);
+  if (read > 0)
+    return (int)read;
+
+  if (APR_STATUS_IS_EOF(b->status))
+    {
+      b->status = APR_SUCCESS;
+      return 0;
+    }
+
+  if (APR_STATUS_IS_EAGAIN(b->status) || APR_STATUS_IS_TIMEUP(b->status))
+    BIO_set_retry_read(bio);
+
+  return -1;
+}
+
+/* Implements the BIO ctrl method.  There is nothing to configure and
+   the socket has no buffer to flush. */
+static long
+bio_apr_socket_ctrl(BIO *bio, int cmd, long num, void *ptr)
+{
+  return cmd == BIO_CTRL_FLUSH ? 1 : 0;
+}
+
+/* Implements the BIO create method. */
+static int
+bio_apr_socket_create(BIO *bio)
+{
+  BIO_set_init(bio, 1);
+  return 1;
+}
+
+/* Implements the BIO destroy method.  The socket belongs to our caller. */
+static int
+bio_apr_socket_destroy(BIO *bio)
+{
+  return 1;
+}
+
+/* The BIO method table, created once. */
+static BIO_METHOD *bio_apr_socket_method = NULL;
+static volatile svn_atomic_t bio_apr_socket_method_status = 0;
+
+/* svn_atomic__err_init_func_t implementation that creates
+ * BIO_APR_SOCKET_METHOD.  Both arguments are unused. */
+static svn_error_t *
+init_bio_apr_socket_method(void *null_baton,
+                           apr_pool_t *null_pool)
+{
+  BIO_METHOD *method = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK,
+                                    "apr_socket_t");
+  if (!method)
+    return svn_error_create(SVN_ERR_RA_SVN_TLS_FAILED, NULL,
+                            _("Can't create TLS socket layer"));
+
+  BIO_meth_set_write(method, bio_apr_socket_write);
+  BIO_meth_set_read(method, bio_apr_socket_read);
+  BIO_meth_set_ctrl(method, bio_apr_socket_ctrl);
+  BIO_meth_set_create(method, bio_apr_socket_create);
+  BIO_meth_set_destroy(method, bio_apr_socket_destroy);
+  bio_apr_socket_method = method;
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** Error handling. ***/
+
+/* Return an SVN_ERR_RA_SVN_TLS_FAILED error with MESSAGE, wrapping the
+ * last socket error of B, if any, and OpenSSL's error queue. */
+static svn_error_t *
+tls_error(tls_baton_t *b,
+          const char *message)
+{
+  svn_error_t *err = NULL;
+  unsigned long code;
+
+  if (b && b->status)
+    err = svn_error_create(b->status, NULL, NULL);
+
+  while ((code = ERR_get_error()) != 0)
+    {
+      char buf[256];
+
+      ERR_error_string_n(code, buf, sizeof(buf));
+      err = svn_error_create(SVN_ERR_RA_SVN_TLS_FAILED, err, buf);
+    }
+
+  return svn_error_create(SVN_ERR_RA_SVN_TLS_FAILED, err, message);
+}
+
+
+/*** A TLS encrypted svn_ra_svn__stream_t. ***/
+
+/* Implements svn_read_fn_t. */
+static svn_error_t *
+tls_read_cb(void *baton, char *buffer, apr_size_t *len)
+{
+  tls_baton_t *b = baton;
+  apr_interval_time_t interval;
+  apr_status_t status;
+  int result;
+  int ssl_err = SSL_ERROR_NONE;
+
+  status = apr_socket_timeout_get(b->sock, &interval);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't get socket timeout"));
+
+  /* Always block on read, see sock_read_cb(). */
+  apr_socket_timeout_set(b->sock, -1);
+  ERR_clear_error();
+  b->status = APR_SUCCESS;
+  result = SSL_read(b->ssl, buffer, (int)MIN(*len, INT_MAX));
+  if (result <= 0)
+    ssl_err = SSL_get_error(b->ssl, result);
+  apr_socket_timeout_set(b->sock, interval);
+
+  if (result > 0)
+    {
+      *len = result;
+      return SVN_NO_ERROR;
+    }
+
+  /* A connection closed without close_notify is fine as well;
+     the protocol knows where its messages end. */
+  if (ssl_err == SSL_ERROR_ZERO_RETURN
+      || (ssl_err == SSL_ERROR_SYSCALL && b->status == APR_SUCCESS))
+    {
+      ERR_clear_error();
+      *len = 0;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(tls_error(b, _("Can't read from connection")));
+}
+
+/* Implements svn_write_fn_t.  Like sock_write_cb(), report a write that
+ * would block as 0 bytes written.  OpenSSL then expects the same data
+ * again, which is what the marshaller does. */
+static svn_error_t *
+tls_write_cb(void *baton, const char *buffer, apr_size_t *len)
+{
+  tls_baton_t *b = baton;
+  int result;
+  int ssl_err;
+
+  ERR_clear_error();
+  b->status = APR_SUCCESS;
+  result = SSL_write(b->ssl, buffer, (int)MIN(*len, INT_MAX));
+  if (result > 0)
+    {
+      *len = result;
+      return SVN_NO_ERROR;
+    }
+
+  ssl_err = SSL_get_error(b->ssl, result);
+  if (ssl_err == SSL_ERROR_WANT_WRITE || ssl_err == SSL_ERROR_WANT_READ)
+    {
+      *len = 0;
+      return SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(tls_error(b, _("Can't write to connection")));
+}
+
+/* Implements ra_svn_timeout_fn_t. */
+static void
+tls_timeout_cb(void *baton, apr_interval_time_t interval)
+{
+  tls_baton_t *b = baton;
+  apr_socket_timeout_set(b->sock, interval);
+}
+
+/* Implements svn_stream_data_available_fn_t.  Data on the socket may be
+ * a protocol message, e.g. a session ticket, rather than payload, so let
+ * OpenSSL process whatever arrived without blocking. */
+static svn_error_t *
+tls_data_available_cb(void *baton, svn_boolean_t *data_available)
+{
+  tls_baton_t *b = baton;
+  apr_pollfd_t pfd = { 0 };
+  apr_interval_time_t interval;
+  apr_status_t status;
+  char c;
+  int n, result, ssl_err;
+
+  if (SSL_pending(b->ssl) > 0)
+    {
+      *data_available = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  pfd.p = b->pool;
+  pfd.desc_type = APR_POLL_SOCKET;
+  pfd.desc.s = b->sock;
+  pfd.reqevents = APR_POLLIN;
+  status = apr_poll(&pfd, 1, &n, 0);
+  svn_pool_clear(b->pool);
+
+  if (status || !n)
+    {
+      *data_available = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  status = apr_socket_timeout_get(b->sock, &interval);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't get socket timeout"));
+
+  apr_socket_timeout_set(b->sock, 0);
+  ERR_clear_error();
+  b->status = APR_SUCCESS;
+  result = SSL_peek(b->ssl, &c, 1);
+  ssl_err = result > 0 ? SSL_ERROR_NONE : SSL_get_error(b->ssl, result);
+  ERR_clear_error();
+  apr_socket_timeout_set(b->sock, interval);
+
+  /* EOF and errors count as data, so the next read will report them. */
+  *data_available = ssl_err != SSL_ERROR_WANT_READ
+                 && ssl_err != SSL_ERROR_WANT_WRITE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Pool cleanup function for a tls_baton_t. */
+static apr_status_t
+cleanup_tls_baton(void *data)
+{
+  tls_baton_t *b = data;
+
+  if (b->pending_session)
+    SSL_SESSION_free(b->pending_session);
+
+  /* Don't send close_notify, the socket may already be gone.  A quiet
+     shutdown still keeps the session resumable. */
+  SSL_set_quiet_shutdown(b->ssl, 1);
+  SSL_shutdown(b->ssl);
+  SSL_free(b->ssl);
+
+  return APR_SUCCESS;
+}
+
+/* Set *B to the state of a new TLS connection over SOCK using CTX,
+ * allocated in RESULT_POOL. */
+static svn_error_t *
+tls_baton_create(tls_baton_t **b_p,
+                 SSL_CTX *ctx,
+                 apr_socket_t *sock,
+                 apr_pool_t *result_pool)
+{
+  tls_baton_t *b = apr_pcalloc(result_pool, sizeof(*b));
+  BIO *bio;
+
+  SVN_ERR(svn_atomic__init_once(&bio_apr_socket_method_status,
+                                init_bio_apr_socket_method, NULL, NULL));
+
+  b->sock = sock;
+  b->pool = svn_pool_create(result_pool);
+  b->ssl = SSL_new(ctx);
+  if (!b->ssl)
+    return svn_error_trace(tls_error(NULL, _("Can't create TLS connection")));
+
+  apr_pool_cleanup_register(result_pool, b, cleanup_tls_baton,
+                            apr_pool_cleanup_null);
+
+  bio = BIO_new(bio_apr_socket_method);
+  if (!bio)
+    return svn_error_trace(tls_error(NULL, _("Can't create TLS connection")));
+
+  BIO_set_data(bio, b);
+  SSL_set_bio(b->ssl, bio, bio);
+  SSL_set_app_data(b->ssl, b);
+
+  *b_p = b;
+
+  return SVN_NO_ERROR;
+}
+
+/* Run the TLS handshake of B to completion, blocking as needed. */
+static svn_error_t *
+tls_handshake(tls_baton_t *b)
+{
+  apr_interval_time_t interval;
+  apr_status_t status;
+  int result;
+
+  status = apr_socket_timeout_get(b->sock, &interval);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't get socket timeout"));
+
+  apr_socket_timeout_set(b->sock, -1);
+  ERR_clear_error();
+  b->status = APR_SUCCESS;
+  result = SSL_do_handshake(b->ssl);
+  apr_socket_timeout_set(b->sock, interval);
+
+  if (result != 1)
+    return svn_error_trace(tls_error(b, _("TLS handshake failed")));
+
+  return SVN_NO_ERROR;
+}
+
+/* Make CONN send and receive everything through the TLS connection B. */
+static void
+tls_enable(svn_ra_svn_conn_t *conn,
+           tls_baton_t *b)
+{
+  svn_stream_t *stream = svn_stream_create(b, conn->pool);
+
+  svn_stream_set_read2(stream, tls_read_cb, NULL /* use default */);
+  svn_stream_set_write(stream, tls_write_cb);
+  svn_stream_set_data_available(stream, tls_data_available_cb);
+
+  conn->stream = svn_ra_svn__stream_create(stream, stream, b, tls_timeout_cb,
+                                           conn->pool);
+}
+
+/* Set the options that CTX needs for use with tls_write_cb(). */
+static void
+init_ctx(SSL_CTX *ctx)
+{
+  SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+  SSL_CTX_set_mode(ctx, SSL_MODE_ENABLE_PARTIAL_WRITE
+                        | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+#ifdef SSL_OP_IGNORE_UNEXPECTED_EOF
+  SSL_CTX_set_options(ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
+#endif
+}
+
+/* Set *NATIVE to PATH in local style and native encoding. */
+static svn_error_t *
+native_path(const char **native,
+            const char *path,
+            apr_pool_t *result_pool)
+{
+  return svn_error_trace(svn_utf_cstring_from_utf8(
+                           native, svn_dirent_local_style(path, result_pool),
+                           result_pool));
+}
+
+
+/*** Server side. ***/
+
+/* Pool cleanup function for a svn_ra_svn__tls_server_t. */
+static apr_status_t
+cleanup_tls_server(void *data)
+{
+  svn_ra_svn__tls_server_t *server = data;
+
+  SSL_CTX_free(server->ctx);
+
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_ra_svn__tls_server_create(svn_ra_svn__tls_server_t **server_p,
+                              const char *cert_file,
+                              const char *key_file,
+                              apr_pool_t *result_pool)
+{
+  svn_ra_svn__tls_server_t *server = apr_pcalloc(result_pool,
+                                                 sizeof(*server));
+  const char *native_cert_file, *native_key_file;
+
+  SVN_ERR(native_path(&native_cert_file, cert_file, result_pool));
+  SVN_ERR(native_path(&native_key_file, key_file, result_pool));
+
+  ERR_clear_error();
+  server->ctx = SSL_CTX_new(TLS_server_method());
+  if (!server->ctx)
+    return svn_error_trace(tls_error(NULL, _("Can't initialize TLS")));
+
+  apr_pool_cleanup_register(result_pool, server, cleanup_tls_server,
+                            apr_pool_cleanup_null);
+  init_ctx(server->ctx);
+
+  if (SSL_CTX_use_certificate_chain_file(server->ctx, native_cert_file) != 1)
+    return svn_error_trace(tls_error(NULL,
+             apr_psprintf(result_pool,
+                          _("Can't load TLS certificate from '%s'"),
+                          svn_dirent_local_style(cert_file, result_pool))));
+
+  if (SSL_CTX_use_PrivateKey_file(server->ctx, native_key_file,
+                                  SSL_FILETYPE_PEM) != 1
+      || SSL_CTX_check_private_key(server->ctx) != 1)
+    return svn_error_trace(tls_error(NULL,
+             apr_psprintf(result_pool,
+                          _("Can't load TLS private key from '%s'"),
+                          svn_dirent_local_style(key_file, result_pool))));
+
+  /* Session tickets are on by default and OpenSSL creates their keys
+     right here.  Thus, they survive fork() and any connection handler
+     can resume the session of any other.  The stateful cache helps
+     the connections served by this process. */
+  SSL_CTX_set_session_id_context(server->ctx,
+                                 (const unsigned char *)SESSION_ID_CONTEXT,
+                                 sizeof(SESSION_ID_CONTEXT) - 1);
+  SSL_CTX_set_session_cache_mode(server->ctx, SSL_SESS_CACHE_SERVER);
+
+  *server_p = server;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_svn__tls_accept(svn_ra_svn_conn_t *conn,
+                       apr_socket_t *sock,
+                       svn_ra_svn__tls_server_t *server,
+                       apr_pool_t *scratch_pool)
+{
+  tls_baton_t *b;
+
+  SVN_ERR(tls_baton_create(&b, server->ctx, sock, conn->pool));
+  SSL_set_accept_state(b->ssl);
+  SVN_ERR(tls_handshake(b));
+  tls_enable(conn, b);
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** Client side. ***/
+
+/* Sessions of the servers we talked to, so we can resume them. */
+static volatile svn_atomic_t session_cache_status = 0;
+
+/* Serializes all access to SESSION_CACHE. */
+static svn_mutex__t *session_cache_mutex = NULL;
+
+/* Global pool holding SESSION_CACHE. */
+static apr_pool_t *session_cache_pool = NULL;
+
+/* Map of const char * "host:port" to SSL_SESSION *. */
+static apr_hash_t *session_cache = NULL;
+
+/* svn_atomic__err_init_func_t implementation that initializes the
+ * session cache globals.  Both arguments are unused. */
+static svn_error_t *
+init_session_cache(void *null_baton,
+                   apr_pool_t *null_pool)
+{
+  /* Sessions stay usable for the rest of the process. */
+  session_cache_pool = svn_pool_create(NULL);
+  SVN_ERR(svn_mutex__init(&session_cache_mutex, TRUE, session_cache_pool));
+  session_cache = apr_hash_make(session_cache_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Make SESSION the one to resume for KEY, taking over our reference to
+ * it.  Call this only while holding SESSION_CACHE_MUTEX. */
+static svn_error_t *
+put_session(const char *key,
+            SSL_SESSION *session)
+{
+  SSL_SESSION *old = svn_hash_gets(session_cache, key);
+
+  if (old)
+    SSL_SESSION_free(old);
+  else
+    key = apr_pstrdup(session_cache_pool, key);
+
+  svn_hash_sets(session_cache, key, session);
+
+  return SVN_NO_ERROR;
+}
+
+/* Add SESSION for KEY to the session cache, taking over our reference to
+ * it.  Failing to do so only means that it can't be resumed. */
+static void
+cache_session(const char *key,
+              SSL_SESSION *session)
+{
+  svn_error_t *err = svn_mutex__lock(session_cache_mutex);
+
+  if (!err)
+    err = svn_mutex__unlock(session_cache_mutex, put_session(key, session));
+  else
+    SSL_SESSION_free(session);
+
+  svn_error_clear(err);
+}
+
+/* Let B resume the cached session for its server, if there is one.
+ * Call this only while holding SESSION_CACHE_MUTEX. */
+static svn_error_t *
+get_session(tls_baton_t *b)
+{
+  SSL_SESSION *session = svn_hash_gets(session_cache, b->session_key);
+
+  /* This takes a reference of its own. */
+  if (session)
+    SSL_set_session(b->ssl, session);
+
+  return SVN_NO_ERROR;
+}
+
+/* OpenSSL's new session callback.  Unless the server has been verified,
+ * keep the session until it is, so we never resume a session with a server
+ * we did not trust. */
+static int
+new_session_cb(SSL *ssl, SSL_SESSION *session)
+{
+  tls_baton_t *b = SSL_get_app_data(ssl);
+
+  if (b->trusted)
+    {
+      cache_session(b->session_key, session);
+    }
+  else
+    {
+      if (b->pending_session)
+        SSL_SESSION_free(b->pending_session);
+      b->pending_session = session;
+    }
+
+  /* We keep the reference. */
+  return 1;
+}
+
+/* OpenSSL's certificate verification callback.  Collect the failures as
+ * SVN_AUTH_SSL_* flags so we can ask the user about them later. */
+static int
+verify_cb(int preverify_ok, X509_STORE_CTX *store)
+{
+  SSL *ssl;
+  tls_baton_t *b;
+
+  if (preverify_ok)
+    return 1;
+
+  ssl = X509_STORE_CTX_get_ex_data(store,
+                                   SSL_get_ex_data_X509_STORE_CTX_idx());
+  b = SSL_get_app_data(ssl);
+
+  switch (X509_STORE_CTX_get_error(store))
+    {
+      case X509_V_ERR_CERT_NOT_YET_VALID:
+        b->failures |= SVN_AUTH_SSL_NOTYETVALID;
+        break;
+
+      case X509_V_ERR_CERT_HAS_EXPIRED:
+        b->failures |= SVN_AUTH_SSL_EXPIRED;
+        break;
+
+      case X509_V_ERR_DEPTH_ZERO_SELF_SIGNED_CERT:
+      case X509_V_ERR_SELF_SIGNED_CERT_IN_CHAIN:
+      case X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT:
+      case X509_V_ERR_UNABLE_TO_GET_ISSUER_CERT_LOCALLY:
+      case X509_V_ERR_UNABLE_TO_VERIFY_LEAF_SIGNATURE:
+      case X509_V_ERR_CERT_UNTRUSTED:
+        b->failures |= SVN_AUTH_SSL_UNKNOWNCA;
+        break;
+
+      default:
+        b->failures |= SVN_AUTH_SSL_OTHER;
+        break;
+    }
+
+  /* Decide later. */
+  return 1;
+}
+
+/* Make CTX trust the certificate authorities given by SERVERS for the
+ * server group in AUTH_BATON.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+load_authorities(SSL_CTX *ctx,
+                 svn_config_t *servers,
+                 svn_auth_baton_t *auth_baton,
+                 apr_pool_t *scratch_pool)
+{
+  svn_boolean_t trust_default_ca = TRUE;
+  const char *authorities = NULL;
+  const char *server_group;
+
+  if (servers)
+    {
+      SVN_ERR(svn_config_get_bool(servers, &trust_default_ca,
+                                  SVN_CONFIG_SECTION_GLOBAL,
+                                  SVN_CONFIG_OPTION_SSL_TRUST_DEFAULT_CA,
+                                  TRUE));
+      svn_config_get(servers, &authorities, SVN_CONFIG_SECTION_GLOBAL,
+                     SVN_CONFIG_OPTION_SSL_AUTHORITY_FILES, NULL);
+
+      server_group = svn_auth_get_parameter(auth_baton,
+                                            SVN_AUTH_PARAM_SERVER_GROUP);
+      if (server_group)
+        {
+          SVN_ERR(svn_config_get_bool(servers, &trust_default_ca,
+                                      server_group,
+                                      SVN_CONFIG_OPTION_SSL_TRUST_DEFAULT_CA,
+                                      trust_default_ca));
+          svn_config_get(servers, &authorities, server_group,
+                         SVN_CONFIG_OPTION_SSL_AUTHORITY_FILES, authorities);
+        }
+    }
+
+  if (trust_default_ca)
+    SSL_CTX_set_default_verify_paths(ctx);
+
+  if (authorities)
+    {
+      apr_array_header_t *files = svn_cstring_split(authorities, ";", TRUE,
+                                                    scratch_pool);
+      int i;
+
+      for (i = 0; i < files->nelts; i++)
+        {
+          const char *file = APR_ARRAY_IDX(files, i, const char *);
+          const char *native_file;
+
+          SVN_ERR(native_path(&native_file, file, scratch_pool));
+          if (SSL_CTX_load_verify_locations(ctx, native_file, NULL) != 1)
+            {
+              ERR_clear_error();
+              return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                        _("Invalid config: unable to load certificate file "
+                          "'%s'"),
+                        svn_dirent_local_style(file, scratch_pool));
+            }
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Fill *CERT_INFO with the details of the DER encoded certificate DER,
+ * allocated in RESULT_POOL. */
+static svn_error_t *
+get_cert_info(svn_auth_ssl_server_cert_info_t *cert_info,
+              const svn_string_t *der,
+              apr_pool_t *result_pool)
+{
+  svn_x509_certinfo_t *certinfo;
+  const apr_array_header_t *hostnames;
+
+  SVN_ERR(svn_x509_parse_cert(&certinfo, der->data, der->len,
+                              result_pool, result_pool));
+
+  hostnames = svn_x509_certinfo_get_hostnames(certinfo);
+  if (hostnames && hostnames->nelts > 0)
+    cert_info->hostname = APR_ARRAY_IDX(hostnames, 0, const char *);
+  else
+    cert_info->hostname = svn_x509_certinfo_get_subject(certinfo,
+                                                        result_pool);
+
+  cert_info->fingerprint
+    = svn_checksum_to_cstring_display(svn_x509_certinfo_get_digest(certinfo),
+                                      result_pool);
+  cert_info->valid_from
+    = svn_time_to_human_cstring(svn_x509_certinfo_get_valid_from(certinfo),
+                                result_pool);
+  cert_info->valid_until
+    = svn_time_to_human_cstring(svn_x509_certinfo_get_valid_to(certinfo),
+                                result_pool);
+  cert_info->issuer_dname = svn_x509_certinfo_get_issuer(certinfo,
+                                                         result_pool);
+  cert_info->ascii_cert = svn_base64_encode_string2(der, FALSE,
+                                                    result_pool)->data;
+
+  return SVN_NO_ERROR;
+}
+
+/* Decide whether we trust the server B talks to, which is HOSTNAME,
+ * asking the providers in AUTH_BATON about any failures found for REALM.
+ * Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+check_server_cert(tls_baton_t *b,
+                  const char *hostname,
+                  const char *realm,
+                  svn_auth_baton_t *auth_baton,
+                  apr_pool_t *scratch_pool)
+{
+  X509 *cert = SSL_get_peer_certificate(b->ssl);
+  apr_uint32_t failures = b->failures;
+  svn_auth_ssl_server_cert_info_t cert_info;
+  svn_auth_iterstate_t *state;
+  svn_string_t *der;
+  unsigned char *buf, *p;
+  void *creds;
+  int len;
+  svn_error_t *err;
+
+  if (!cert)
+    return svn_error_createf(SVN_ERR_RA_SVN_TLS_CERT_UNTRUSTED, NULL,
+                             _("Server '%s' did not present a certificate"),
+                             hostname);
+
+  if (X509_check_host(cert, hostname, 0, 0, NULL) != 1
+      && X509_check_ip_asc(cert, hostname, 0) != 1)
+    failures |= SVN_AUTH_SSL_CNMISMATCH;
+
+  if (!failures)
+    {
+      X509_free(cert);
+      return SVN_NO_ERROR;
+    }
+
+  len = i2d_X509(cert, NULL);
+  if (len <= 0)
+    {
+      X509_free(cert);
+      return svn_error_trace(tls_error(NULL,
+                               _("Can't encode server certificate")));
+    }
+
+  buf = p = apr_palloc(scratch_pool, len);
+  len = i2d_X509(cert, &p);
+  X509_free(cert);
+  der = svn_string_ncreate((const char *)buf, len, scratch_pool);
+
+  SVN_ERR(get_cert_info(&cert_info, der, scratch_pool));
+
+  svn_auth_set_parameter(auth_baton, SVN_AUTH_PARAM_SSL_SERVER_FAILURES,
+                         &failures);
+  svn_auth_set_parameter(auth_baton, SVN_AUTH_PARAM_SSL_SERVER_CERT_INFO,
+                         &cert_info);
+
+  err = svn_auth_first_credentials(&creds, &state,
+                                   SVN_AUTH_CRED_SSL_SERVER_TRUST,
+                                   realm, auth_baton, scratch_pool);
+  if (!err && creds)
+    {
+      svn_auth_cred_ssl_server_trust_t *server_creds = creds;
+
+      failures &= ~server_creds->accepted_failures;
+      err = svn_auth_save_credentials(state, scratch_pool);
+    }
+
+  svn_auth_set_parameter(auth_baton, SVN_AUTH_PARAM_SSL_SERVER_FAILURES,
+                         NULL);
+  svn_auth_set_parameter(auth_baton, SVN_AUTH_PARAM_SSL_SERVER_CERT_INFO,
+                         NULL);
+  SVN_ERR(err);
+
+  if (failures)
+    return svn_error_createf(SVN_ERR_RA_SVN_TLS_CERT_UNTRUSTED, NULL,
+                             _("Server certificate of '%s' verification "
+                               "failed"), hostname);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_ra_svn__tls_connect(svn_ra_svn_conn_t *conn,
+                        apr_socket_t *sock,
+                        svn_ra_svn__session_baton_t *sess,
+                        apr_port_t port,
+                        svn_config_t *servers,
+                        apr_pool_t *scratch_pool)
+{
+  SSL_CTX *ctx;
+  tls_baton_t *b;
+  svn_error_t *err;
+  const char *realm = apr_psprintf(scratch_pool, "svns://%s:%d",
+                                   sess->hostname, port);
+
+  SVN_ERR(svn_atomic__init_once(&session_cache_status, init_session_cache,
+                                NULL, NULL));
+
+  ERR_clear_error();
+  ctx = SSL_CTX_new(TLS_client_method());
+  if (!ctx)
+    return svn_error_trace(tls_error(NULL, _("Can't initialize TLS")));
+
+  init_ctx(ctx);
+  SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, verify_cb);
+  SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT
+                                      | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+  SSL_CTX_sess_set_new_cb(ctx, new_session_cb);
+
+  /* The connection keeps its own reference to CTX. */
+  err = load_authorities(ctx, servers, sess->auth_baton, scratch_pool);
+  if (!err)
+    err = tls_baton_create(&b, ctx, sock, conn->pool);
+  SSL_CTX_free(ctx);
+  SVN_ERR(err);
+
+  b->session_key = apr_psprintf(conn->pool, "%s:%d", sess->hostname, port);
+  SSL_set_connect_state(b->ssl);
+  SSL_set_tlsext_host_name(b->ssl, sess->hostname);
+  SVN_MUTEX__WITH_LOCK(session_cache_mutex, get_session(b));
+
+  SVN_ERR(tls_handshake(b));
+
+  /* We only ever cache sessions of trusted servers. */
+  if (!SSL_session_reused(b->ssl))
+    SVN_ERR(check_server_cert(b, sess->hostname, realm, sess->auth_baton,
+                              scratch_pool));
+
+  b->trusted = TRUE;
+  if (b->pending_session)
+    {
+      cache_session(b->session_key, b->pending_session);
+      b->pending_session = NULL;
+    }
+
+  tls_enable(conn, b);
+
+  return SVN_NO_ERROR;
+}
+
+#else /* SVN_HAVE_OPENSSL */
+
+/* Return the error for missing TLS support. */
+static svn_error_t *
+tls_unsupported(void)
+{
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("TLS support is not available in this build "
+                            "of Subversion"));
+}
+
+svn_error_t *
+svn_ra_svn__tls_server_create(svn_ra_svn__tls_server_t **server_p,
+                              const char *cert_file,
+                              const char *key_file,
+                              apr_pool_t *result_pool)
+{
+  return svn_error_trace(tls_unsupported());
+}
+
+svn_error_t *
+svn_ra_svn__tls_accept(svn_ra_svn_conn_t *conn,
+                       apr_socket_t *sock,
+                       svn_ra_svn__tls_server_t *server,
+                       apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(tls_unsupported());
+}
+
+svn_error_t *
+svn_ra_svn__tls_connect(svn_ra_svn_conn_t *conn,
+                        apr_socket_t *sock,
+                        svn_ra_svn__session_baton_t *sess,
+                        apr_port_t port,
+                        svn_config_t *servers,
+                        apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(tls_unsupported());
+}
+
+#endif /* SVN_HAVE_OPENSSL */
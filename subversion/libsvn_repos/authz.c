@@ -31,6 +31,7 @@
 #include "svn_pools.h"
 #include "svn_error.h"
 #include "svn_dirent_uri.h"
+#include "svn_io.h"
 #include "svn_path.h"
 #include "svn_repos.h"
 #include "svn_config.h"
@@ -40,6 +41,7 @@
 #include "private/svn_repos_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_trace.h"
 #include "repos.h"
 #include "authz.h"
 #include "config_file.h"
@@ -130,6 +132,10 @@ static svn_object_pool__t *authz_pool = NULL;
 static svn_object_pool__t *filtered_pool = NULL;
 static svn_atomic_t authz_pool_initialized = FALSE;
 
+/* Directory shared with other processes, in which we look for and store
+ * compiled authz models.  NULL if not used. */
+static const char *authz_cache_dir = NULL;
+
 /*
  * Ensure that we will initialize authz again if the pool which
  * our authz caches depend on is cleared.
@@ -180,6 +186,33 @@ svn_repos_authz_initialize(apr_pool_t *pool)
                                                NULL, pool));
 }
 
+void
+svn_repos__authz_set_cache_dir(const char *dir_abspath,
+                               apr_pool_t *pool)
+{
+  authz_cache_dir = dir_abspath ? apr_pstrdup(pool, dir_abspath) : NULL;
+}
+
+/* Return KEY as a string of hex digits, allocated in RESULT_POOL. */
+static const char *
+key_to_hex(const svn_membuf_t *key,
+           apr_pool_t *result_pool)
+{
+  static const char digits[] = "0123456789abcdef";
+  const unsigned char *data = key->data;
+  char *result = apr_palloc(result_pool, 2 * key->size + 1);
+  apr_size_t i;
+
+  for (i = 0; i < key->size; ++i)
+    {
+      result[2 * i] = digits[data[i] >> 4];
+      result[2 * i + 1] = digits[data[i] & 0xf];
+    }
+  result[2 * i] = '\0';
+
+  return result;
+}
+
 /* Return a combination of AUTHZ_KEY and GROUPS_KEY, allocated in RESULT_POOL.
  * GROUPS_KEY may be NULL.  This is the key for the AUTHZ_POOL.
  */
@@ -1036,6 +1069,11 @@ typedef struct lookup_state_t
   /* Rights that apply at PARENT_PATH, if PARENT_PATH is not empty. */
   limited_rights_t parent_rights;
 
+  /* Set by lookup().  If TRUE, RIGHTS apply to the path that has been
+   * looked up.  Otherwise, they apply to PARENT_PATH and their limits
+   * already determine the result for its whole sub-tree. */
+  svn_boolean_t rights_at_path;
+
 } lookup_state_t;
 
 /* Constructor for lookup_state_t. */
@@ -1309,11 +1347,17 @@ lookup(lookup_state_t *state,
 
       /* Shortcut 1: We could nowhere find enough rights in this sub-tree. */
       if ((state->rights.max_rights & required) != required)
-        return FALSE;
+        {
+          state->rights_at_path = FALSE;
+          return FALSE;
+        }
 
       /* Shortcut 2: We will find enough rights everywhere in this sub-tree. */
       if ((state->rights.min_rights & required) == required)
-        return TRUE;
+        {
+          state->rights_at_path = FALSE;
+          return TRUE;
+        }
 
       /* Extract the next segment. */
       path = next_segment(segment, path);
@@ -1406,6 +1450,10 @@ lookup(lookup_state_t *state,
         }
     }
 
+  /* If we ran out of tree, RIGHTS are those of PARENT_PATH, inherited by
+   * everything below it. */
+  state->rights_at_path = (path == NULL);
+
   /* If we check recursively, none of the (potential) sub-paths must have
    * less than the REQUIRED access rights.  "Potential" because we don't
    * verify that the respective paths actually exist in the repository.
@@ -1445,6 +1493,15 @@ struct authz_user_rules_t
   /* Reusable lookup state instance. */
   lookup_state_t *lookup_state;
 
+  /* Results of previous lookups, see find_decision().  Maps keys built by
+   * set_decision_key() to svn_boolean_t *.  Allocated in DECISIONS_POOL,
+   * which gets cleared once there are MAX_CACHED_DECISIONS entries. */
+  apr_hash_t *decisions;
+  apr_pool_t *decisions_pool;
+
+  /* Reusable buffer for the keys of DECISIONS. */
+  svn_stringbuf_t *decision_key;
+
   /* Pool from which all data within this struct got allocated.
    * Can be destroyed or cleaned up with no further side-effects. */
   apr_pool_t *pool;
@@ -1504,6 +1561,10 @@ get_user_rules(svn_authz_t *authz,
   authz->filtered->user = user ? apr_pstrdup(pool, user) : NULL;
   authz->filtered->lookup_state = create_lookup_state(pool);
   authz->filtered->root = NULL;
+  authz->filtered->decisions_pool = svn_pool_create(pool);
+  authz->filtered->decisions
+    = apr_hash_make(authz->filtered->decisions_pool);
+  authz->filtered->decision_key = svn_stringbuf_create_ensure(200, pool);
 
   svn_authz__get_global_rights(&authz->filtered->global_rights,
                                authz->full, user, repos_name);
@@ -1511,6 +1572,116 @@ get_user_rules(svn_authz_t *authz,
   return authz->filtered;
 }
 
+/* Upper limit to the number of entries in authz_user_rules_t.DECISIONS. */
+#define MAX_CACHED_DECISIONS 10000
+
+/* Values in authz_user_rules_t.DECISIONS. */
+static const svn_boolean_t decision_granted = TRUE;
+static const svn_boolean_t decision_denied = FALSE;
+
+/* Set KEY to the key in authz_user_rules_t.DECISIONS for the first LEN
+ * chars of PATH.  KIND is '=' for the result of a check of REQUIRED_ACCESS
+ * on exactly that path and '*' for the result of any check of
+ * REQUIRED_ACCESS on that path or any path below it.
+ */
+static void
+set_decision_key(svn_stringbuf_t *key,
+                 char kind,
+                 svn_repos_authz_access_t required_access,
+                 const char *path,
+                 apr_size_t len)
+{
+  svn_stringbuf_setempty(key);
+  svn_stringbuf_appendbyte(key, kind);
+  svn_stringbuf_appendbyte(key, (char)('0' + required_access));
+  svn_stringbuf_appendbytes(key, path, len);
+}
+
+/* Return the result of a previous check of REQUIRED_ACCESS on PATH in
+ * RULES, or NULL if there was none.  The result may also come from a
+ * check of another path in a sub-tree that turned out to be uniformly
+ * accessible or inaccessible to the user.
+ */
+static const svn_boolean_t *
+find_decision(authz_user_rules_t *rules,
+              const char *path,
+              svn_repos_authz_access_t required_access)
+{
+  svn_stringbuf_t *key = rules->decision_key;
+  apr_size_t len = strlen(path);
+  const svn_boolean_t *granted;
+  apr_size_t i;
+
+  set_decision_key(key, '=', required_access, path, len);
+  granted = apr_hash_get(rules->decisions, key->data, key->len);
+  if (granted)
+    return granted;
+
+  /* Try the uniform sub-trees at PATH and all of its parents, keys being
+   * prefixes of each other.  The repository root is the empty path. */
+  set_decision_key(key, '*', required_access & ~svn_authz_recursive,
+                   path, len);
+  for (i = 2; i <= key->len; ++i)
+    if (i == key->len || key->data[i] == '/')
+      {
+        granted = apr_hash_get(rules->decisions, key->data, i);
+        if (granted)
+          return granted;
+      }
+
+  return NULL;
+}
+
+/* Add the result GRANTED of the lookup() of REQUIRED, i.e. REQUIRED_ACCESS
+ * in internal form, on PATH to the decisions in RULES.  If the lookup
+ * found the rights to be the same in the whole sub-tree, add the result
+ * for that sub-tree instead.
+ */
+static void
+store_decision(authz_user_rules_t *rules,
+               const char *path,
+               svn_repos_authz_access_t required_access,
+               authz_access_t required,
+               svn_boolean_t granted)
+{
+  const lookup_state_t *state = rules->lookup_state;
+  svn_stringbuf_t *key = rules->decision_key;
+  apr_size_t len = strlen(path);
+  svn_boolean_t uniform;
+
+  if (apr_hash_count(rules->decisions) >= MAX_CACHED_DECISIONS)
+    {
+      svn_pool_clear(rules->decisions_pool);
+      rules->decisions = apr_hash_make(rules->decisions_pool);
+    }
+
+  if ((state->rights.min_rights & required) == required)
+    uniform = granted;
+  else if ((state->rights.max_rights & required) != required)
+    uniform = !granted;
+  else
+    uniform = FALSE;
+
+  if (!uniform)
+    set_decision_key(key, '=', required_access, path, len);
+  else if (!state->rights_at_path)
+    set_decision_key(key, '*', required_access & ~svn_authz_recursive,
+                     state->parent_path->data, state->parent_path->len);
+  else
+    {
+      while (len && path[len - 1] == '/')
+        --len;
+
+      set_decision_key(key, '*', required_access & ~svn_authz_recursive,
+                       path, len);
+    }
+
+  apr_hash_set(rules->decisions,
+               apr_pmemdup(rules->decisions_pool, key->data, key->len),
+               key->len,
+               (void *)(granted ? &decision_granted : &decision_denied));
+}
+
 /* In AUTHZ's user rules, construct the actual filtered tree.
  * Use SCRATCH_POOL for temporary allocations.
  */
@@ -1573,6 +1744,62 @@ filter_tree(svn_authz_t *authz,
 
 
 
+/* Like svn_authz__parse() but if there is an AUTHZ_CACHE_DIR, use the
+ * compiled model for AUTHZ_ID from there instead of parsing RULES and
+ * GROUPS.  Add it there if it is missing.  Parser warnings will only be
+ * reported if the model has actually been parsed.
+ */
+static svn_error_t *
+parse_authz(authz_full_t **authz_p,
+            const svn_membuf_t *authz_id,
+            svn_stream_t *rules,
+            svn_stream_t *groups,
+            svn_repos_authz_warning_func_t warning_func,
+            void *warning_baton,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  const char *cache_dir = authz_cache_dir;
+  const char *cache_path = NULL;
+
+  if (cache_dir)
+    {
+      svn_error_t *err;
+
+      cache_path = svn_dirent_join(cache_dir,
+                                   key_to_hex(authz_id, scratch_pool),
+                                   scratch_pool);
+
+      /* A damaged or unreadable cache file only costs us a parser run. */
+      err = svn_authz__read_cache(authz_p, cache_path, result_pool,
+                                  scratch_pool);
+      if (err)
+        {
+          svn_error_clear(err);
+          *authz_p = NULL;
+        }
+
+      if (*authz_p)
+        return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_authz__parse(authz_p, rules, groups, warning_func,
+                           warning_baton, result_pool, scratch_pool));
+
+  /* The cache is optional. */
+  if (cache_path)
+    {
+      svn_error_t *err = svn_io_make_dir_recursively(cache_dir,
+                                                     scratch_pool);
+      if (!err)
+        err = svn_authz__write_cache(*authz_p, cache_path, scratch_pool);
+
+      svn_error_clear(err);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Read authz configuration data from PATH into *AUTHZ_P, allocated in
    RESULT_POOL.  Return the cache key in *AUTHZ_ID.  If GROUPS_PATH is set,
    use the global groups parsed from it.  Use SCRATCH_POOL for temporary
@@ -1632,9 +1859,9 @@ authz_read(authz_full_t **authz_p,
 
           /* Parse the configuration(s) and construct the full authz model
            * from it. */
-          err = svn_authz__parse(authz_p, rules_stream, groups_stream,
-                                 warning_func, warning_baton,
-                                 item_pool, scratch_pool);
+          err = parse_authz(authz_p, *authz_id, rules_stream, groups_stream,
+                            warning_func, warning_baton,
+                            item_pool, scratch_pool);
           if (err != SVN_NO_ERROR)
             {
               /* That pool would otherwise never get destroyed. */
@@ -1659,9 +1886,9 @@ authz_read(authz_full_t **authz_p,
       /* Parse the configuration(s) and construct the full authz model from
        * it. */
       err = svn_error_quick_wrapf(
-          svn_authz__parse(authz_p, rules_stream, groups_stream,
-                           warning_func, warning_baton,
-                           result_pool, scratch_pool),
+          parse_authz(authz_p, *authz_id, rules_stream, groups_stream,
+                      warning_func, warning_baton,
+                      result_pool, scratch_pool),
           "Error while parsing authz file: '%s':", path);
     }
 
@@ -1686,11 +1913,16 @@ svn_repos_authz_read4(svn_authz_t **authz_p,
                       apr_pool_t *scratch_pool)
 {
   svn_authz_t *authz = apr_pcalloc(result_pool, sizeof(*authz));
+  svn_trace__span_t *span;
+  svn_error_t *err;
   authz->pool = result_pool;
 
-  SVN_ERR(authz_read(&authz->full, &authz->authz_id, path, groups_path,
-                     must_exist, repos_hint, warning_func, warning_baton,
-                     result_pool, scratch_pool));
+  span = svn_trace__begin("repos", "authz-read", scratch_pool);
+  err = authz_read(&authz->full, &authz->authz_id, path, groups_path,
+                   must_exist, repos_hint, warning_func, warning_baton,
+                   result_pool, scratch_pool);
+  svn_trace__end(span);
+  SVN_ERR(err);
 
   *authz_p = authz;
   return SVN_NO_ERROR;
@@ -1718,6 +1950,16 @@ svn_repos_authz_parse2(svn_authz_t **authz_p,
   return SVN_NO_ERROR;
 }
 
+const char *
+svn_repos__authz_id(const svn_authz_t *authz,
+                    apr_pool_t *result_pool)
+{
+  if (!authz->authz_id)
+    return NULL;
+
+  return key_to_hex(authz->authz_id, result_pool);
+}
+
 svn_error_t *
 svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
                              const char *path, const char *user,
@@ -1728,6 +1970,8 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
   const authz_access_t required =
     ((required_access & svn_authz_read ? authz_access_read_flag : 0)
      | (required_access & svn_authz_write ? authz_access_write_flag : 0));
+  const char *full_path = path;
+  const svn_boolean_t *decision;
 
   /* Pick or create the suitable pre-filtered path rule tree. */
   authz_user_rules_t *rules = get_user_rules(
@@ -1766,6 +2010,15 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
   if (!rules->root)
     SVN_ERR(filter_tree(authz, pool));
 
+  /* Callers like the update reporter and log check many paths, most of
+   * them repeatedly or within sub-trees of uniform access. */
+  decision = find_decision(rules, full_path, required_access);
+  if (decision)
+    {
+      *access_granted = *decision;
+      return SVN_NO_ERROR;
+    }
+
   /* Re-use previous lookup results, if possible. */
   path = init_lockup_state(authz->filtered->lookup_state,
                            authz->filtered->root, path);
@@ -1777,6 +2030,8 @@ svn_repos_authz_check_access(svn_authz_t *authz, const char *repos_name,
    * PATH does not need to be normalized for lockup(). */
   *access_granted = lookup(rules->lookup_state, path, required,
                            !!(required_access & svn_authz_recursive), pool);
+  store_decision(rules, full_path, required_access, required,
+                 *access_granted);
 
   return SVN_NO_ERROR;
 }
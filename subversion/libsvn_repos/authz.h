@@ -318,6 +318,26 @@ svn_authz__parse(authz_full_t **authz,
                  apr_pool_t *scratch_pool);
 
 
+/* Write the authz model AUTHZ to the file at PATH, replacing it
+ * atomically.  The directory of PATH must exist.  Use SCRATCH_POOL for
+ * temporary allocations.
+ */
+svn_error_t *
+svn_authz__write_cache(const authz_full_t *authz,
+                       const char *path,
+                       apr_pool_t *scratch_pool);
+
+/* Read the authz model that svn_authz__write_cache() wrote to PATH into
+ * *AUTHZ, allocated in RESULT_POOL.  Set *AUTHZ to NULL if there is no
+ * file at PATH.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_authz__read_cache(authz_full_t **authz,
+                      const char *path,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool);
+
+
 /* Reverse a STRING of length LEN in place. */
 void
 svn_authz__reverse_string(char *string, apr_size_t len);
@@ -0,0 +1,539 @@
+/* authz_cache.c : Storing compiled authz models in files
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_pools.h>
+
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+
+#include "private/svn_packed_data.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_subr_private.h"
+
+#include "svn_private_config.h"
+#include "authz.h"
+
+/* The cache file contains one int stream and one byte stream, read and
+ * written strictly in sequence.  The format number is written at both
+ * ends of the int stream, so truncated or otherwise mangled files get
+ * detected with high probability.  Increment it with every change to
+ * authz_full_t and its sub-structures.
+ */
+#define AUTHZ_CACHE_FORMAT 1
+
+/* Serialization context. */
+typedef struct write_context_t
+{
+  svn_packed__int_stream_t *ints;
+  svn_packed__byte_stream_t *strings;
+
+  /* Maps the members hash of group ACEs (by address) to the group number
+   * that has been assigned to it, as apr_size_t *. */
+  apr_hash_t *groups;
+
+  apr_pool_t *pool;
+} write_context_t;
+
+/* Deserialization context. */
+typedef struct read_context_t
+{
+  svn_packed__int_stream_t *ints;
+  svn_packed__byte_stream_t *strings;
+
+  /* Interned strings, like svn_authz__parse() creates them. */
+  apr_hash_t *interned;
+
+  /* Members hashes of all groups read so far, indexed by group number
+   * minus 1. */
+  apr_array_header_t *groups;
+
+  /* Pool of the resulting authz model. */
+  apr_pool_t *pool;
+} read_context_t;
+
+/* Write the string STR, which may be NULL, to CTX. */
+static void
+write_string(write_context_t *ctx,
+             const char *str)
+{
+  svn_packed__add_uint(ctx->ints, str != NULL);
+  if (str)
+    svn_packed__add_bytes(ctx->strings, str, strlen(str));
+}
+
+/* Write RIGHTS to CTX. */
+static void
+write_rights(write_context_t *ctx,
+             const authz_rights_t *rights)
+{
+  svn_packed__add_uint(ctx->ints, rights->min_access);
+  svn_packed__add_uint(ctx->ints, rights->max_access);
+}
+
+/* Write the global rights GR to CTX. */
+static void
+write_global_rights(write_context_t *ctx,
+                    const authz_global_rights_t *gr)
+{
+  apr_array_header_t *repos;
+  int i;
+
+  write_string(ctx, gr->user);
+  write_rights(ctx, &gr->any_repos_rights);
+  write_rights(ctx, &gr->all_repos_rights);
+
+  repos = svn_sort__hash(gr->per_repos_rights,
+                         svn_sort_compare_items_lexically, ctx->pool);
+  svn_packed__add_uint(ctx->ints, repos->nelts);
+  for (i = 0; i < repos->nelts; ++i)
+    {
+      const svn_sort__item_t *item = &APR_ARRAY_IDX(repos, i,
+                                                    svn_sort__item_t);
+
+      write_string(ctx, item->key);
+      write_rights(ctx, item->value);
+    }
+}
+
+/* Write ACE to CTX.  Group members get written with the first ACE
+ * that refers to them. */
+static void
+write_ace(write_context_t *ctx,
+          const authz_ace_t *ace)
+{
+  write_string(ctx, ace->name);
+  svn_packed__add_uint(ctx->ints, ace->inverted);
+  svn_packed__add_uint(ctx->ints, ace->access);
+
+  if (ace->members)
+    {
+      apr_size_t *number = apr_hash_get(ctx->groups, &ace->members,
+                                        sizeof(ace->members));
+      if (number)
+        {
+          svn_packed__add_uint(ctx->ints, *number);
+        }
+      else
+        {
+          apr_hash_index_t *hi;
+
+          number = apr_palloc(ctx->pool, sizeof(*number));
+          *number = apr_hash_count(ctx->groups) + 1;
+          apr_hash_set(ctx->groups,
+                       apr_pmemdup(ctx->pool, &ace->members,
+                                   sizeof(ace->members)),
+                       sizeof(ace->members), number);
+
+          svn_packed__add_uint(ctx->ints, *number);
+          svn_packed__add_uint(ctx->ints, apr_hash_count(ace->members));
+          for (hi = apr_hash_first(ctx->pool, ace->members);
+               hi;
+               hi = apr_hash_next(hi))
+            write_string(ctx, apr_hash_this_key(hi));
+        }
+    }
+  else
+    {
+      svn_packed__add_uint(ctx->ints, 0);
+    }
+}
+
+/* Write ACL to CTX. */
+static void
+write_acl(write_context_t *ctx,
+          const authz_acl_t *acl)
+{
+  int i;
+
+  svn_packed__add_uint(ctx->ints, acl->sequence_number);
+  write_string(ctx, acl->rule.repos);
+  svn_packed__add_uint(ctx->ints, acl->rule.len);
+  for (i = 0; i < acl->rule.len; ++i)
+    {
+      svn_packed__add_uint(ctx->ints, acl->rule.path[i].kind);
+      svn_packed__add_bytes(ctx->strings, acl->rule.path[i].pattern.data,
+                            acl->rule.path[i].pattern.len);
+    }
+
+  svn_packed__add_uint(ctx->ints, acl->has_anon_access);
+  svn_packed__add_uint(ctx->ints, acl->anon_access);
+  svn_packed__add_uint(ctx->ints, acl->has_authn_access);
+  svn_packed__add_uint(ctx->ints, acl->authn_access);
+  svn_packed__add_uint(ctx->ints, acl->has_neg_access);
+  svn_packed__add_uint(ctx->ints, acl->neg_access);
+
+  /* 0 for no array, otherwise the number of elements plus 1. */
+  if (acl->user_access)
+    {
+      svn_packed__add_uint(ctx->ints, acl->user_access->nelts + 1);
+      for (i = 0; i < acl->user_access->nelts; ++i)
+        write_ace(ctx, &APR_ARRAY_IDX(acl->user_access, i, authz_ace_t));
+    }
+  else
+    {
+      svn_packed__add_uint(ctx->ints, 0);
+    }
+}
+
+svn_error_t *
+svn_authz__write_cache(const authz_full_t *authz,
+                       const char *path,
+                       apr_pool_t *scratch_pool)
+{
+  svn_packed__data_root_t *root = svn_packed__data_create_root(scratch_pool);
+  write_context_t ctx;
+  apr_array_header_t *users;
+  svn_stream_t *stream;
+  const char *tmp_path;
+  int i;
+
+  ctx.ints = svn_packed__create_int_stream(root, FALSE, FALSE);
+  ctx.strings = svn_packed__create_bytes_stream(root);
+  ctx.groups = apr_hash_make(scratch_pool);
+  ctx.pool = scratch_pool;
+
+  svn_packed__add_uint(ctx.ints, AUTHZ_CACHE_FORMAT);
+
+  svn_packed__add_uint(ctx.ints, authz->acls->nelts);
+  for (i = 0; i < authz->acls->nelts; ++i)
+    write_acl(&ctx, &APR_ARRAY_IDX(authz->acls, i, authz_acl_t));
+
+  svn_packed__add_uint(ctx.ints, authz->has_anon_rights);
+  write_global_rights(&ctx, &authz->anon_rights);
+  svn_packed__add_uint(ctx.ints, authz->has_authn_rights);
+  write_global_rights(&ctx, &authz->authn_rights);
+  svn_packed__add_uint(ctx.ints, authz->has_neg_rights);
+  write_global_rights(&ctx, &authz->neg_rights);
+
+  users = svn_sort__hash(authz->user_rights,
+                         svn_sort_compare_items_lexically, scratch_pool);
+  svn_packed__add_uint(ctx.ints, users->nelts);
+  for (i = 0; i < users->nelts; ++i)
+    write_global_rights(&ctx, APR_ARRAY_IDX(users, i,
+                                            svn_sort__item_t).value);
+
+  svn_packed__add_uint(ctx.ints, AUTHZ_CACHE_FORMAT);
+
+  /* Other processes may read the file at any time, so only ever move
+   * complete files into place. */
+  SVN_ERR(svn_stream_open_unique(&stream, &tmp_path,
+                                 svn_dirent_dirname(path, scratch_pool),
+                                 svn_io_file_del_on_pool_cleanup,
+                                 scratch_pool, scratch_pool));
+  SVN_ERR(svn_packed__data_write(stream, root, scratch_pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  return svn_error_trace(svn_io_file_rename2(tmp_path, path, FALSE,
+                                             scratch_pool));
+}
+
+/* Return an error for a malformed cache file. */
+static svn_error_t *
+malformed_cache(void)
+{
+  return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                          _("Malformed authz cache file"));
+}
+
+/* Read a count from CTX into *COUNT.  Every counted item takes at least
+ * one integer, so anything above the number of integers left is bogus. */
+static svn_error_t *
+read_count(int *count,
+           read_context_t *ctx)
+{
+  apr_uint64_t value = svn_packed__get_uint(ctx->ints);
+
+  if (value > svn_packed__int_count(ctx->ints))
+    return malformed_cache();
+
+  *count = (int)value;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read an interned, non-NULL string from CTX into *STR. */
+static svn_error_t *
+read_interned(const char **str,
+              read_context_t *ctx)
+{
+  apr_size_t len;
+  const char *data = svn_packed__get_bytes(ctx->strings, &len);
+  const char *interned;
+
+  if (!data)
+    return malformed_cache();
+
+  interned = apr_hash_get(ctx->interned, data, len);
+  if (!interned)
+    {
+      interned = apr_pstrmemdup(ctx->pool, data, len);
+      apr_hash_set(ctx->interned, interned, len, interned);
+    }
+
+  *str = interned;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read a string written by write_string() from CTX into *STR. */
+static svn_error_t *
+read_string(const char **str,
+            read_context_t *ctx)
+{
+  if (svn_packed__get_uint(ctx->ints))
+    return svn_error_trace(read_interned(str, ctx));
+
+  *str = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read rights written by write_rights() from CTX into *RIGHTS. */
+static void
+read_rights(authz_rights_t *rights,
+            read_context_t *ctx)
+{
+  rights->min_access = (authz_access_t)svn_packed__get_uint(ctx->ints);
+  rights->max_access = (authz_access_t)svn_packed__get_uint(ctx->ints);
+}
+
+/* Read global rights written by write_global_rights() from CTX into
+ * *GR. */
+static svn_error_t *
+read_global_rights(authz_global_rights_t *gr,
+                   read_context_t *ctx)
+{
+  int count, i;
+
+  SVN_ERR(read_string(&gr->user, ctx));
+  read_rights(&gr->any_repos_rights, ctx);
+  read_rights(&gr->all_repos_rights, ctx);
+
+  gr->per_repos_rights = apr_hash_make(ctx->pool);
+  SVN_ERR(read_count(&count, ctx));
+  for (i = 0; i < count; ++i)
+    {
+      const char *repos;
+      authz_rights_t *rights = apr_palloc(ctx->pool, sizeof(*rights));
+
+      SVN_ERR(read_string(&repos, ctx));
+      if (!repos)
+        return malformed_cache();
+
+      read_rights(rights, ctx);
+      svn_hash_sets(gr->per_repos_rights, repos, rights);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Read an ACE written by write_ace() from CTX into *ACE. */
+static svn_error_t *
+read_ace(authz_ace_t *ace,
+         read_context_t *ctx)
+{
+  apr_uint64_t number;
+
+  SVN_ERR(read_string(&ace->name, ctx));
+  if (!ace->name)
+    return malformed_cache();
+
+  ace->inverted = (svn_boolean_t)svn_packed__get_uint(ctx->ints);
+  ace->access = (authz_access_t)svn_packed__get_uint(ctx->ints);
+
+  number = svn_packed__get_uint(ctx->ints);
+  if (number == 0)
+    {
+      ace->members = NULL;
+    }
+  else if (number <= (apr_uint64_t)ctx->groups->nelts)
+    {
+      ace->members = APR_ARRAY_IDX(ctx->groups, number - 1, apr_hash_t *);
+    }
+  else if (number == (apr_uint64_t)ctx->groups->nelts + 1)
+    {
+      int count, i;
+
+      /* Just like svn_authz__parse(), map members to the empty string. */
+      ace->members = svn_hash__make(ctx->pool);
+      SVN_ERR(read_count(&count, ctx));
+      for (i = 0; i < count; ++i)
+        {
+          const char *member;
+
+          SVN_ERR(read_string(&member, ctx));
+          if (!member)
+            return malformed_cache();
+
+          svn_hash_sets(ace->members, member, "");
+        }
+
+      APR_ARRAY_PUSH(ctx->groups, apr_hash_t *) = ace->members;
+    }
+  else
+    {
+      return malformed_cache();
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Read an ACL written by write_acl() from CTX into *ACL. */
+static svn_error_t *
+read_acl(authz_acl_t *acl,
+         read_context_t *ctx)
+{
+  int count, i;
+
+  acl->sequence_number = (int)svn_packed__get_uint(ctx->ints);
+  SVN_ERR(read_string(&acl->rule.repos, ctx));
+  if (!acl->rule.repos)
+    return malformed_cache();
+
+  SVN_ERR(read_count(&acl->rule.len, ctx));
+  acl->rule.path = acl->rule.len
+                 ? apr_pcalloc(ctx->pool,
+                               acl->rule.len * sizeof(*acl->rule.path))
+                 : NULL;
+  for (i = 0; i < acl->rule.len; ++i)
+    {
+      authz_rule_segment_t *segment = &acl->rule.path[i];
+      apr_uint64_t kind = svn_packed__get_uint(ctx->ints);
+
+      if (kind > authz_rule_fnmatch)
+        return malformed_cache();
+
+      segment->kind = (int)kind;
+      SVN_ERR(read_interned(&segment->pattern.data, ctx));
+      segment->pattern.len = strlen(segment->pattern.data);
+    }
+
+  acl->has_anon_access = (svn_boolean_t)svn_packed__get_uint(ctx->ints);
+  acl->anon_access = (authz_access_t)svn_packed__get_uint(ctx->ints);
+  acl->has_authn_access = (svn_boolean_t)svn_packed__get_uint(ctx->ints);
+  acl->authn_access = (authz_access_t)svn_packed__get_uint(ctx->ints);
+  acl->has_neg_access = (svn_boolean_t)svn_packed__get_uint(ctx->ints);
+  acl->neg_access = (authz_access_t)svn_packed__get_uint(ctx->ints);
+
+  SVN_ERR(read_count(&count, ctx));
+  if (count)
+    {
+      acl->user_access = apr_array_make(ctx->pool, count - 1,
+                                        sizeof(authz_ace_t));
+      for (i = 1; i < count; ++i)
+        SVN_ERR(read_ace(&APR_ARRAY_PUSH(acl->user_access, authz_ace_t),
+                         ctx));
+    }
+  else
+    {
+      acl->user_access = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the authz model in ROOT into *AUTHZ, allocated in RESULT_POOL. */
+static svn_error_t *
+read_authz(authz_full_t **authz_p,
+           svn_packed__data_root_t *root,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  authz_full_t *authz = apr_pcalloc(result_pool, sizeof(*authz));
+  read_context_t ctx;
+  int count, i;
+
+  ctx.ints = svn_packed__first_int_stream(root);
+  ctx.strings = svn_packed__first_byte_stream(root);
+  ctx.interned = apr_hash_make(scratch_pool);
+  ctx.groups = apr_array_make(scratch_pool, 16, sizeof(apr_hash_t *));
+  ctx.pool = result_pool;
+
+  if (!ctx.ints || !ctx.strings
+      || svn_packed__get_uint(ctx.ints) != AUTHZ_CACHE_FORMAT)
+    return malformed_cache();
+
+  SVN_ERR(read_count(&count, &ctx));
+  authz->acls = apr_array_make(result_pool, count, sizeof(authz_acl_t));
+  for (i = 0; i < count; ++i)
+    SVN_ERR(read_acl(&APR_ARRAY_PUSH(authz->acls, authz_acl_t), &ctx));
+
+  authz->has_anon_rights = (svn_boolean_t)svn_packed__get_uint(ctx.ints);
+  SVN_ERR(read_global_rights(&authz->anon_rights, &ctx));
+  authz->has_authn_rights = (svn_boolean_t)svn_packed__get_uint(ctx.ints);
+  SVN_ERR(read_global_rights(&authz->authn_rights, &ctx));
+  authz->has_neg_rights = (svn_boolean_t)svn_packed__get_uint(ctx.ints);
+  SVN_ERR(read_global_rights(&authz->neg_rights, &ctx));
+
+  authz->user_rights = svn_hash__make(result_pool);
+  SVN_ERR(read_count(&count, &ctx));
+  for (i = 0; i < count; ++i)
+    {
+      authz_global_rights_t *gr = apr_palloc(result_pool, sizeof(*gr));
+
+      SVN_ERR(read_global_rights(gr, &ctx));
+      if (!gr->user)
+        return malformed_cache();
+
+      svn_hash_sets(authz->user_rights, gr->user, gr);
+    }
+
+  if (   svn_packed__get_uint(ctx.ints) != AUTHZ_CACHE_FORMAT
+      || svn_packed__int_count(ctx.ints)
+      || svn_packed__byte_block_count(ctx.strings))
+    return malformed_cache();
+
+  authz->pool = result_pool;
+  *authz_p = authz;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_authz__read_cache(authz_full_t **authz,
+                      const char *path,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  svn_packed__data_root_t *root;
+  svn_stream_t *stream;
+  svn_error_t *err;
+
+  err = svn_stream_open_readonly(&stream, path, scratch_pool, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *authz = NULL;
+
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_packed__data_read(&root, stream, scratch_pool, scratch_pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  return svn_error_trace(read_authz(authz, root, result_pool, scratch_pool));
+}
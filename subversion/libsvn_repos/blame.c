@@ -0,0 +1,420 @@
+/* blame.c : determine the revision responsible for each line of a file
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_delta.h"
+#include "svn_diff.h"
+#include "svn_props.h"
+#include "svn_repos.h"
+
+#include "svn_private_config.h"
+
+#include "repos.h"
+
+/* This is the server-side counterpart of the blame implementation in
+ * libsvn_client.  It follows the same approach, i.e. it keeps a linked
+ * list of chunks of lines that are attributed to the same revision and
+ * updates it with the diff between each pair of subsequent file revisions.
+ * The file contents never leave the server; they are kept in memory.
+ */
+
+/* The metadata associated with a particular revision. */
+typedef struct blame_rev_t
+{
+  svn_revnum_t revision;
+  apr_hash_t *rev_props;
+} blame_rev_t;
+
+/* One chunk of blame. */
+typedef struct blame_t
+{
+  const blame_rev_t *rev;   /* the responsible revision */
+  apr_off_t start;          /* the starting diff-token (line) */
+  struct blame_t *next;     /* the next chunk */
+} blame_t;
+
+/* A chain of blame chunks. */
+typedef struct blame_chain_t
+{
+  blame_t *blame;           /* linked list of blame chunks */
+  blame_t *avail;           /* linked list of free blame chunks */
+  apr_pool_t *pool;         /* Allocate members from this pool. */
+} blame_chain_t;
+
+/* The baton used for svn_repos_get_file_revs2(). */
+typedef struct file_rev_baton_t
+{
+  svn_revnum_t start;
+  const svn_diff_file_options_t *diff_options;
+  blame_chain_t chain;
+
+  /* The contents of the previous file revision. */
+  svn_stringbuf_t *last_contents;
+
+  /* The contents of the revision being processed. */
+  svn_stringbuf_t *contents;
+
+  /* The revision being processed. */
+  blame_rev_t *rev;
+
+  /* The delta application handler for the current revision. */
+  svn_txdelta_window_handler_t apply_handler;
+  void *apply_baton;
+
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+
+  apr_pool_t *mainpool;  /* lives during the whole sequence of calls */
+  apr_pool_t *lastpool;  /* holds LAST_CONTENTS */
+  apr_pool_t *currpool;  /* holds CONTENTS */
+} file_rev_baton_t;
+
+/* Return a blame chunk associated with REV for a change starting
+   at token START, and allocated in CHAIN->pool. */
+static blame_t *
+blame_create(blame_chain_t *chain,
+             const blame_rev_t *rev,
+             apr_off_t start)
+{
+  blame_t *blame;
+  if (chain->avail)
+    {
+      blame = chain->avail;
+      chain->avail = blame->next;
+    }
+  else
+    blame = apr_palloc(chain->pool, sizeof(*blame));
+  blame->rev = rev;
+  blame->start = start;
+  blame->next = NULL;
+  return blame;
+}
+
+/* Destroy a blame chunk. */
+static void
+blame_destroy(blame_chain_t *chain,
+              blame_t *blame)
+{
+  blame->next = chain->avail;
+  chain->avail = blame;
+}
+
+/* Return the blame chunk that contains token OFF, starting the search at
+   BLAME. */
+static blame_t *
+blame_find(blame_t *blame, apr_off_t off)
+{
+  blame_t *prev = NULL;
+  while (blame)
+    {
+      if (blame->start > off) break;
+      prev = blame;
+      blame = blame->next;
+    }
+  return prev;
+}
+
+/* Shift the start-point of BLAME and all subsequence blame-chunks
+   by ADJUST tokens */
+static void
+blame_adjust(blame_t *blame, apr_off_t adjust)
+{
+  while (blame)
+    {
+      blame->start += adjust;
+      blame = blame->next;
+    }
+}
+
+/* Delete the blame associated with the region from token START to
+   START + LENGTH */
+static void
+blame_delete_range(blame_chain_t *chain,
+                   apr_off_t start,
+                   apr_off_t length)
+{
+  blame_t *first = blame_find(chain->blame, start);
+  blame_t *last = blame_find(chain->blame, start + length);
+  blame_t *tail = last->next;
+
+  if (first != last)
+    {
+      blame_t *walk = first->next;
+      while (walk != last)
+        {
+          blame_t *next = walk->next;
+          blame_destroy(chain, walk);
+          walk = next;
+        }
+      first->next = last;
+      last->start = start;
+      if (first->start == start)
+        {
+          *first = *last;
+          blame_destroy(chain, last);
+          last = first;
+        }
+    }
+
+  if (tail && tail->start == last->start + length)
+    {
+      *last = *tail;
+      blame_destroy(chain, tail);
+      tail = last->next;
+    }
+
+  blame_adjust(tail, -length);
+}
+
+/* Insert a chunk of blame associated with REV starting
+   at token START and continuing for LENGTH tokens */
+static void
+blame_insert_range(blame_chain_t *chain,
+                   const blame_rev_t *rev,
+                   apr_off_t start,
+                   apr_off_t length)
+{
+  blame_t *point = blame_find(chain->blame, start);
+  blame_t *insert;
+
+  if (point->start == start)
+    {
+      insert = blame_create(chain, point->rev, point->start + length);
+      point->rev = rev;
+      insert->next = point->next;
+      point->next = insert;
+    }
+  else
+    {
+      blame_t *middle;
+      middle = blame_create(chain, rev, start);
+      insert = blame_create(chain, point->rev, start + length);
+      middle->next = insert;
+      insert->next = point->next;
+      point->next = middle;
+    }
+  blame_adjust(insert->next, length);
+}
+
+/* Callback for diff between subsequent revisions.  BATON is the
+   file_rev_baton_t. */
+static svn_error_t *
+output_diff_modified(void *baton,
+                     apr_off_t original_start,
+                     apr_off_t original_length,
+                     apr_off_t modified_start,
+                     apr_off_t modified_length,
+                     apr_off_t latest_start,
+                     apr_off_t latest_length)
+{
+  file_rev_baton_t *frb = baton;
+
+  if (original_length)
+    blame_delete_range(&frb->chain, modified_start, original_length);
+
+  if (modified_length)
+    blame_insert_range(&frb->chain, frb->rev, modified_start,
+                       modified_length);
+
+  return SVN_NO_ERROR;
+}
+
+static const svn_diff_output_fns_t output_fns = {
+        NULL,
+        output_diff_modified
+};
+
+/* Update the blame in FRB->CHAIN with the differences between
+   FRB->LAST_CONTENTS and FRB->CONTENTS and make the latter the new base
+   for the next revision. */
+static svn_error_t *
+update_blame(file_rev_baton_t *frb)
+{
+  apr_pool_t *tmp_pool;
+
+  if (!frb->last_contents)
+    {
+      frb->chain.blame = blame_create(&frb->chain, frb->rev, 0);
+    }
+  else
+    {
+      svn_diff_t *diff;
+      svn_string_t original, modified;
+
+      original.data = frb->last_contents->data;
+      original.len = frb->last_contents->len;
+      modified.data = frb->contents->data;
+      modified.len = frb->contents->len;
+
+      SVN_ERR(svn_diff_mem_string_diff(&diff, &original, &modified,
+                                       frb->diff_options, frb->currpool));
+      SVN_ERR(svn_diff_output2(diff, frb, &output_fns,
+                               frb->cancel_func, frb->cancel_baton));
+    }
+
+  /* Switch pools.  The old contents will be released with the next
+     revision. */
+  frb->last_contents = frb->contents;
+  frb->contents = NULL;
+
+  tmp_pool = frb->lastpool;
+  frb->lastpool = frb->currpool;
+  frb->currpool = tmp_pool;
+
+  return SVN_NO_ERROR;
+}
+
+/* The delta window handler for the text delta between the previous and
+ * the current file revision.  BATON is the file_rev_baton_t.
+ *
+ * Implements svn_txdelta_window_handler_t.
+ */
+static svn_error_t *
+window_handler(svn_txdelta_window_t *window,
+               void *baton)
+{
+  file_rev_baton_t *frb = baton;
+
+  SVN_ERR(frb->apply_handler(window, frb->apply_baton));
+
+  /* We patiently wait for the NULL window marking the end. */
+  if (window)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(update_blame(frb));
+}
+
+/* Implements svn_file_rev_handler_t. */
+static svn_error_t *
+file_rev_handler(void *baton,
+                 const char *path,
+                 svn_revnum_t revnum,
+                 apr_hash_t *rev_props,
+                 svn_boolean_t merged_revision,
+                 svn_txdelta_window_handler_t *content_delta_handler,
+                 void **content_delta_baton,
+                 apr_array_header_t *prop_diffs,
+                 apr_pool_t *pool)
+{
+  file_rev_baton_t *frb = baton;
+  svn_stream_t *last_stream;
+  svn_stream_t *cur_stream;
+
+  if (frb->cancel_func)
+    SVN_ERR(frb->cancel_func(frb->cancel_baton));
+
+  /* Revisions without content changes don't affect the blame. */
+  if (!content_delta_handler)
+    return SVN_NO_ERROR;
+
+  svn_pool_clear(frb->currpool);
+
+  frb->rev = apr_pcalloc(frb->mainpool, sizeof(*frb->rev));
+  if (revnum >= frb->start)
+    {
+      frb->rev->revision = revnum;
+      frb->rev->rev_props = svn_prop_hash_dup(rev_props, frb->mainpool);
+    }
+  else
+    {
+      /* The file existed before START.  Its lines don't get attributed
+         to any revision. */
+      frb->rev->revision = SVN_INVALID_REVNUM;
+    }
+
+  frb->contents = svn_stringbuf_create_empty(frb->currpool);
+  cur_stream = svn_stream_from_stringbuf(frb->contents, frb->currpool);
+  last_stream = frb->last_contents
+              ? svn_stream_from_stringbuf(frb->last_contents, frb->currpool)
+              : svn_stream_empty(frb->currpool);
+
+  svn_txdelta_apply2(last_stream, cur_stream, NULL, NULL, frb->currpool,
+                     &frb->apply_handler, &frb->apply_baton);
+  *content_delta_handler = window_handler;
+  *content_delta_baton = frb;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos_blame(svn_repos_t *repos,
+                const char *path,
+                svn_revnum_t start,
+                svn_revnum_t end,
+                const apr_array_header_t *diff_options,
+                svn_repos_authz_func_t authz_read_func,
+                void *authz_read_baton,
+                svn_repos_blame_receiver_t receiver,
+                void *receiver_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *scratch_pool)
+{
+  file_rev_baton_t frb = { 0 };
+  svn_diff_file_options_t *options;
+  blame_t *walk;
+  apr_pool_t *iterpool;
+
+  if (start > end)
+    return svn_error_createf(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                             _("Can't calculate a reverse blame from r%ld "
+                               "back to r%ld"), start, end);
+
+  options = svn_diff_file_options_create(scratch_pool);
+  if (diff_options)
+    SVN_ERR(svn_diff_file_options_parse(options, diff_options,
+                                        scratch_pool));
+
+  frb.start = start;
+  frb.diff_options = options;
+  frb.chain.pool = scratch_pool;
+  frb.cancel_func = cancel_func;
+  frb.cancel_baton = cancel_baton;
+  frb.mainpool = scratch_pool;
+  frb.lastpool = svn_pool_create(scratch_pool);
+  frb.currpool = svn_pool_create(scratch_pool);
+
+  /* We need the last revision before START, if available, so that we can
+     tell what was actually changed in START. */
+  SVN_ERR(svn_repos_get_file_revs2(repos, path, start > 0 ? start - 1 : 0,
+                                   end, FALSE,
+                                   authz_read_func, authz_read_baton,
+                                   file_rev_handler, &frb, scratch_pool));
+
+  /* Report the chunks in line order. */
+  iterpool = svn_pool_create(scratch_pool);
+  for (walk = frb.chain.blame; walk; walk = walk->next)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(receiver(receiver_baton, walk->start, walk->rev->revision,
+                       walk->rev->rev_props, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(frb.lastpool);
+  svn_pool_destroy(frb.currpool);
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,301 @@
+/* date_index.c : index of the svn:date of all revisions
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_props.h"
+#include "svn_time.h"
+
+#include "svn_private_config.h"
+
+#include "repos.h"
+
+
+/* The date index file stores the svn:date of revision R as 64 bit
+ * big-endian number of microseconds since the epoch at offset
+ * R * DATE_INDEX_ENTRY_SIZE.  Revisions without a date get the
+ * DATE_INDEX_NO_DATE value.  Trailing incomplete entries, e.g. left
+ * behind by a crash, are ignored and overwritten by the next update.
+ *
+ * All writers hold the SVN_REPOS__DATE_INDEX_LOCKFILE lock.  Readers don't
+ * lock and must not trust the index blindly, see svn_repos_dated_revision().
+ */
+
+/* Size of one entry in the index file. */
+#define DATE_INDEX_ENTRY_SIZE 8
+
+/* Value stored for revisions without svn:date. */
+#define DATE_INDEX_NO_DATE APR_INT64_C(-1)
+
+/* Number of entries that we write at once when catching up. */
+#define DATE_INDEX_BATCH 1024
+
+/* Encode TM into the DATE_INDEX_ENTRY_SIZE bytes at BUFFER. */
+static void
+encode_entry(unsigned char *buffer,
+             apr_time_t tm)
+{
+  apr_uint64_t value = (apr_uint64_t)tm;
+  int i;
+
+  for (i = DATE_INDEX_ENTRY_SIZE - 1; i >= 0; --i)
+    {
+      buffer[i] = (unsigned char)(value & 0xff);
+      value >>= 8;
+    }
+}
+
+/* Return the time encoded in the DATE_INDEX_ENTRY_SIZE bytes at BUFFER. */
+static apr_time_t
+decode_entry(const unsigned char *buffer)
+{
+  apr_uint64_t value = 0;
+  int i;
+
+  for (i = 0; i < DATE_INDEX_ENTRY_SIZE; ++i)
+    value = (value << 8) | buffer[i];
+
+  return (apr_time_t)value;
+}
+
+/* Set *TM to the svn:date of REVISION in FS or to DATE_INDEX_NO_DATE if
+   it has none.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_revision_date(apr_time_t *tm,
+                   svn_fs_t *fs,
+                   svn_revnum_t revision,
+                   apr_pool_t *scratch_pool)
+{
+  svn_string_t *date;
+  svn_error_t *err;
+
+  SVN_ERR(svn_fs_revision_prop2(&date, fs, revision, SVN_PROP_REVISION_DATE,
+                                FALSE, scratch_pool, scratch_pool));
+  if (!date)
+    {
+      *tm = DATE_INDEX_NO_DATE;
+      return SVN_NO_ERROR;
+    }
+
+  /* Let svn_repos_dated_revision() report malformed dates. */
+  err = svn_time_from_cstring(tm, date->data, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      *tm = DATE_INDEX_NO_DATE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Open the index file of REPOS for writing, take the update lock and
+   return the file in *FILE and the number of complete entries in *COUNT.
+   If the index does not exist yet, create it if CREATE is set or set
+   *FILE to NULL otherwise.  The lock is released when POOL gets cleared.
+ */
+static svn_error_t *
+open_for_update(apr_file_t **file,
+                svn_revnum_t *count,
+                svn_repos_t *repos,
+                svn_boolean_t create,
+                apr_pool_t *pool)
+{
+  const char *file_path = svn_dirent_join(repos->path,
+                                          SVN_REPOS__DATE_INDEX, pool);
+  apr_file_t *lockfile;
+  svn_error_t *err;
+  svn_filesize_t size;
+
+  SVN_ERR(svn_io_file_open(&lockfile,
+                           svn_dirent_join(repos->lock_path,
+                                           SVN_REPOS__DATE_INDEX_LOCKFILE,
+                                           pool),
+                           APR_WRITE | APR_CREATE, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_lock_open_file(lockfile, TRUE, FALSE, pool));
+
+  err = svn_io_file_open(file, file_path,
+                         APR_READ | APR_WRITE | (create ? APR_CREATE : 0),
+                         APR_OS_DEFAULT, pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err) && !create)
+    {
+      svn_error_clear(err);
+      *file = NULL;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_io_file_size_get(&size, *file, pool));
+  *count = (svn_revnum_t)(size / DATE_INDEX_ENTRY_SIZE);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__date_index_update(svn_repos_t *repos,
+                             svn_boolean_t create,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *scratch_pool)
+{
+  apr_pool_t *pool = svn_pool_create(scratch_pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  unsigned char buffer[DATE_INDEX_BATCH * DATE_INDEX_ENTRY_SIZE];
+  apr_file_t *file;
+  svn_revnum_t count, youngest;
+  apr_off_t offset;
+
+  SVN_ERR(open_for_update(&file, &count, repos, create, pool));
+  if (!file)
+    {
+      svn_pool_destroy(pool);
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest, repos->fs, pool));
+
+  /* Drop entries for revisions that don't exist (anymore). */
+  if (count > youngest + 1)
+    count = youngest + 1;
+
+  offset = (apr_off_t)count * DATE_INDEX_ENTRY_SIZE;
+  SVN_ERR(svn_io_file_trunc(file, offset, pool));
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+
+  while (count <= youngest)
+    {
+      apr_size_t len = 0;
+
+      svn_pool_clear(iterpool);
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      for (; count <= youngest && len < sizeof(buffer); ++count)
+        {
+          apr_time_t tm;
+
+          SVN_ERR(read_revision_date(&tm, repos->fs, count, iterpool));
+          encode_entry(buffer + len, tm);
+          len += DATE_INDEX_ENTRY_SIZE;
+        }
+
+      SVN_ERR(svn_io_file_write_full(file, buffer, len, NULL, iterpool));
+    }
+
+  SVN_ERR(svn_io_file_close(file, pool));
+  svn_pool_destroy(pool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__date_index_refresh(svn_repos_t *repos,
+                              svn_revnum_t revision,
+                              apr_pool_t *scratch_pool)
+{
+  apr_pool_t *pool = svn_pool_create(scratch_pool);
+  unsigned char buffer[DATE_INDEX_ENTRY_SIZE];
+  apr_file_t *file;
+  svn_revnum_t count;
+  apr_time_t tm;
+  apr_off_t offset;
+
+  SVN_ERR(open_for_update(&file, &count, repos, FALSE, pool));
+
+  /* Revisions not in the index yet will be added by the next update. */
+  if (file && revision < count)
+    {
+      SVN_ERR(read_revision_date(&tm, repos->fs, revision, pool));
+      encode_entry(buffer, tm);
+
+      offset = (apr_off_t)revision * DATE_INDEX_ENTRY_SIZE;
+      SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, pool));
+      SVN_ERR(svn_io_file_write_full(file, buffer, sizeof(buffer), NULL,
+                                     pool));
+      SVN_ERR(svn_io_file_close(file, pool));
+    }
+
+  svn_pool_destroy(pool);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__date_index_open(svn_repos__date_index_t **index,
+                           svn_repos_t *repos,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  svn_repos__date_index_t *result;
+  apr_file_t *file;
+  svn_filesize_t size;
+  svn_error_t *err;
+
+  err = svn_io_file_open(&file,
+                         svn_dirent_join(repos->path, SVN_REPOS__DATE_INDEX,
+                                         scratch_pool),
+                         APR_READ | APR_BUFFERED, APR_OS_DEFAULT,
+                         result_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *index = NULL;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_io_file_size_get(&size, file, scratch_pool));
+
+  result = apr_pcalloc(result_pool, sizeof(*result));
+  result->file = file;
+  result->count = (svn_revnum_t)(size / DATE_INDEX_ENTRY_SIZE);
+
+  *index = result;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__date_index_get(apr_time_t *tm,
+                          svn_boolean_t *found,
+                          svn_repos__date_index_t *index,
+                          svn_revnum_t revision,
+                          apr_pool_t *scratch_pool)
+{
+  unsigned char buffer[DATE_INDEX_ENTRY_SIZE];
+  apr_off_t offset;
+
+  *found = FALSE;
+  if (!index || revision < 0 || revision >= index->count)
+    return SVN_NO_ERROR;
+
+  offset = (apr_off_t)revision * DATE_INDEX_ENTRY_SIZE;
+  SVN_ERR(svn_io_file_seek(index->file, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_io_file_read_full2(index->file, buffer, sizeof(buffer),
+                                 NULL, NULL, scratch_pool));
+
+  *tm = decode_entry(buffer);
+  *found = *tm != DATE_INDEX_NO_DATE;
+
+  return SVN_NO_ERROR;
+}
@@ -855,12 +855,17 @@ delta_dirs(struct context *c,
   SVN_ERR(delta_proplists(c, source_path, target_path,
                           change_dir_prop, dir_baton, pool));
 
-  /* Get the list of entries in each of source and target.  */
-  SVN_ERR(svn_fs_dir_entries(&t_entries, c->target_root,
-                             target_path, pool));
+  /* Get the list of entries in each of source and target.  Entries that
+     are the same on both sides would be no-ops below, so let the FS
+     filter them out for us.  */
   if (source_path)
-    SVN_ERR(svn_fs_dir_entries(&s_entries, c->source_root,
-                               source_path, pool));
+    SVN_ERR(svn_fs_dir_entries_changed(&s_entries, &t_entries,
+                                       c->source_root, source_path,
+                                       c->target_root, target_path,
+                                       pool, pool));
+  else
+    SVN_ERR(svn_fs_dir_entries(&t_entries, c->target_root,
+                               target_path, pool));
 
   /* Make a subpool for local allocations. */
   subpool = svn_pool_create(pool);
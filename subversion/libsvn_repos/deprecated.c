@@ -231,6 +231,24 @@ svn_repos_upgrade(const char *path,
   return svn_repos_upgrade2(path, nonblocking, recovery_started, &rb, pool);
 }
 
+svn_error_t *
+svn_repos_hotcopy3(const char *src_path,
+                   const char *dst_path,
+                   svn_boolean_t clean_logs,
+                   svn_boolean_t incremental,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_repos_hotcopy4(src_path, dst_path, clean_logs,
+                                            incremental, 1,
+                                            notify_func, notify_baton,
+                                            cancel_func, cancel_baton,
+                                            scratch_pool));
+}
+
 svn_error_t *
 svn_repos_hotcopy2(const char *src_path,
                    const char *dst_path,
@@ -240,8 +258,8 @@ svn_repos_hotcopy2(const char *src_path,
                    void *cancel_baton,
                    apr_pool_t *pool)
 {
-  return svn_error_trace(svn_repos_hotcopy3(src_path, dst_path, clean_logs,
-                                            incremental, NULL, NULL,
+  return svn_error_trace(svn_repos_hotcopy4(src_path, dst_path, clean_logs,
+                                            incremental, 1, NULL, NULL,
                                             cancel_func, cancel_baton, pool));
 }
 
@@ -489,10 +507,23 @@ svn_repos_fs_pack(svn_repos_t *repos,
   pnwb.notify_func = notify_func;
   pnwb.notify_baton = notify_baton;
 
-  return svn_repos_fs_pack2(repos, pack_notify_wrapper_func, &pnwb,
+  return svn_repos_fs_pack3(repos, 1, pack_notify_wrapper_func, &pnwb,
                             cancel_func, cancel_baton, pool);
 }
 
+svn_error_t *
+svn_repos_fs_pack2(svn_repos_t *repos,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool)
+{
+  return svn_error_trace(svn_repos_fs_pack3(repos, 1, notify_func,
+                                            notify_baton, cancel_func,
+                                            cancel_baton, pool));
+}
+
 
 svn_error_t *
 svn_repos_fs_get_locks(apr_hash_t **locks,
@@ -799,6 +830,41 @@ repos_notify_handler(void *baton,
   }
 }
 
+svn_error_t *
+svn_repos_dump_fs4(svn_repos_t *repos,
+                   svn_stream_t *stream,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   svn_boolean_t incremental,
+                   svn_boolean_t use_deltas,
+                   svn_boolean_t include_revprops,
+                   svn_boolean_t include_changes,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_repos_dump_filter_func_t filter_func,
+                   void *filter_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool)
+{
+  return svn_error_trace(svn_repos_dump_fs5(repos,
+                                            stream,
+                                            start_rev,
+                                            end_rev,
+                                            incremental,
+                                            use_deltas,
+                                            include_revprops,
+                                            include_changes,
+                                            1,
+                                            notify_func,
+                                            notify_baton,
+                                            filter_func,
+                                            filter_baton,
+                                            cancel_func,
+                                            cancel_baton,
+                                            pool));
+}
+
 svn_error_t *
 svn_repos_dump_fs3(svn_repos_t *repos,
                    svn_stream_t *stream,
@@ -855,6 +921,35 @@ svn_repos_dump_fs2(svn_repos_t *repos,
                                             pool));
 }
 
+svn_error_t *
+svn_repos_verify_fs3(svn_repos_t *repos,
+                     svn_revnum_t start_rev,
+                     svn_revnum_t end_rev,
+                     svn_boolean_t check_normalization,
+                     svn_boolean_t metadata_only,
+                     svn_repos_notify_func_t notify_func,
+                     void *notify_baton,
+                     svn_repos_verify_callback_t verify_callback,
+                     void *verify_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *pool)
+{
+  return svn_error_trace(svn_repos_verify_fs4(repos,
+                                              start_rev,
+                                              end_rev,
+                                              check_normalization,
+                                              metadata_only,
+                                              1,
+                                              notify_func,
+                                              notify_baton,
+                                              verify_callback,
+                                              verify_baton,
+                                              cancel_func,
+                                              cancel_baton,
+                                              pool));
+}
+
 svn_error_t *
 svn_repos_verify_fs2(svn_repos_t *repos,
                      svn_revnum_t start_rev,
@@ -865,11 +960,12 @@ svn_repos_verify_fs2(svn_repos_t *repos,
                      void *cancel_baton,
                      apr_pool_t *pool)
 {
-  return svn_error_trace(svn_repos_verify_fs3(repos,
+  return svn_error_trace(svn_repos_verify_fs4(repos,
                                               start_rev,
                                               end_rev,
                                               FALSE,
                                               FALSE,
+                                              1,
                                               notify_func,
                                               notify_baton,
                                               NULL, NULL,
@@ -901,6 +997,32 @@ svn_repos_verify_fs(svn_repos_t *repos,
 
 /*** From load.c ***/
 
+svn_error_t *
+svn_repos_load_fs6(svn_repos_t *repos,
+                   svn_stream_t *dumpstream,
+                   svn_revnum_t start_rev,
+                   svn_revnum_t end_rev,
+                   enum svn_repos_load_uuid uuid_action,
+                   const char *parent_dir,
+                   svn_boolean_t use_pre_commit_hook,
+                   svn_boolean_t use_post_commit_hook,
+                   svn_boolean_t validate_props,
+                   svn_boolean_t ignore_dates,
+                   svn_boolean_t normalize_props,
+                   svn_repos_notify_func_t notify_func,
+                   void *notify_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *pool)
+{
+  return svn_repos_load_fs7(repos, dumpstream, start_rev, end_rev,
+                            uuid_action, parent_dir,
+                            use_pre_commit_hook, use_post_commit_hook,
+                            validate_props, ignore_dates, normalize_props,
+                            1, notify_func, notify_baton,
+                            cancel_func, cancel_baton, pool);
+}
+
 svn_error_t *
 svn_repos_load_fs5(svn_repos_t *repos,
                    svn_stream_t *dumpstream,
@@ -918,10 +1040,10 @@ svn_repos_load_fs5(svn_repos_t *repos,
                    void *cancel_baton,
                    apr_pool_t *pool)
 {
-  return svn_repos_load_fs6(repos, dumpstream, start_rev, end_rev,
+  return svn_repos_load_fs7(repos, dumpstream, start_rev, end_rev,
                             uuid_action, parent_dir,
                             use_post_commit_hook, use_post_commit_hook,
-                            validate_props, ignore_dates, FALSE,
+                            validate_props, ignore_dates, FALSE, 1,
                             notify_func, notify_baton,
                             cancel_func, cancel_baton, pool);
 }
@@ -45,6 +45,8 @@
 #include "private/svn_utf_private.h"
 #include "private/svn_cache.h"
 #include "private/svn_fspath.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_task.h"
 
 #define ARE_VALID_COPY_ARGS(p,r) ((p) && SVN_IS_VALID_REVNUM(r))
 
@@ -2021,9 +2023,322 @@ dump_filter_authz_func(svn_boolean_t *allowed,
 
 
 
+/* Implements svn_repos_notify_func_t.  Append a copy of NOTIFY to the
+   apr_array_header_t * BATON, allocated in the array's pool.  This allows
+   notifications to be created in a worker thread and to be reported later
+   in revision order. */
+static void
+buffer_notify_func(void *baton,
+                   const svn_repos_notify_t *notify,
+                   apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *notifications = baton;
+  svn_repos_notify_t *copy = svn_repos_notify_create(notify->action,
+                                                     notifications->pool);
+
+  copy->revision = notify->revision;
+  copy->warning = notify->warning;
+  copy->warning_str = apr_pstrdup(notifications->pool, notify->warning_str);
+
+  APR_ARRAY_PUSH(notifications, svn_repos_notify_t *) = copy;
+}
+
+/* Parameters and state shared by all revisions of a dump.  Except for the
+   FOUND_OLD_* flags, which are only being updated by the output function,
+   everything in here is read-only while the dump is running. */
+typedef struct dump_shared_t
+{
+  /* Location and FS configuration of the repository, used to open it in
+     the worker threads. */
+  const char *repos_path;
+  apr_hash_t *fs_config;
+
+  /* Parameters as passed to svn_repos_dump_fs5(). */
+  svn_revnum_t start_rev;
+  svn_boolean_t incremental;
+  svn_boolean_t use_deltas;
+  svn_boolean_t include_revprops;
+  svn_boolean_t include_changes;
+
+  /* Filter to apply or NULL. */
+  svn_repos_authz_func_t authz_func;
+  dump_filter_baton_t authz_baton;
+
+  /* Caller's output stream and notification callback. */
+  svn_stream_t *stream;
+  svn_repos_notify_func_t notify_func;
+  void *notify_baton;
+
+  /* Set once any dumped revision refers to revisions before START_REV. */
+  svn_boolean_t found_old_reference;
+  svn_boolean_t found_old_mergeinfo;
+} dump_shared_t;
+
+/* Write revision REV of REPOS to STREAM as specified in SHARED.  Send
+   warnings to NOTIFY_FUNC with NOTIFY_BATON and set *FOUND_OLD_REFERENCE
+   and *FOUND_OLD_MERGEINFO if REV refers to revisions that are not part
+   of the dump.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+dump_revision(svn_stream_t *stream,
+              svn_repos_t *repos,
+              svn_revnum_t rev,
+              const dump_shared_t *shared,
+              svn_repos_notify_func_t notify_func,
+              void *notify_baton,
+              svn_boolean_t *found_old_reference,
+              svn_boolean_t *found_old_mergeinfo,
+              apr_pool_t *scratch_pool)
+{
+  const svn_delta_editor_t *dump_editor;
+  void *dump_edit_baton = NULL;
+  svn_fs_t *fs = svn_repos_fs(repos);
+  svn_fs_root_t *to_root;
+  svn_boolean_t use_deltas_for_rev;
+  void *authz_baton = (void *)&shared->authz_baton;
+
+  /* Write the revision record. */
+  SVN_ERR(write_revision_record(stream, repos, rev,
+                                shared->include_revprops,
+                                shared->authz_func, authz_baton,
+                                scratch_pool));
+
+  /* When dumping revision 0, we just write out the revision record.
+     The parser might want to use its properties.
+     If we don't want revision changes at all, skip in any case. */
+  if (rev == 0 || !shared->include_changes)
+    return SVN_NO_ERROR;
+
+  /* Fetch the editor which dumps nodes to a file.  Regardless of
+     what we've been told, don't use deltas for the first rev of a
+     non-incremental dump. */
+  use_deltas_for_rev = shared->use_deltas
+                    && (shared->incremental || rev != shared->start_rev);
+  SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, rev,
+                          "", stream, found_old_reference,
+                          found_old_mergeinfo, NULL,
+                          notify_func, notify_baton,
+                          shared->start_rev, use_deltas_for_rev,
+                          FALSE, FALSE, scratch_pool));
+
+  /* Drive the editor in one way or another. */
+  SVN_ERR(svn_fs_revision_root(&to_root, fs, rev, scratch_pool));
+
+  /* If this is the first revision of a non-incremental dump,
+     we're in for a full tree dump.  Otherwise, we want to simply
+     replay the revision.  */
+  if ((rev == shared->start_rev) && (! shared->incremental))
+    {
+      /* Compare against revision 0, so everything appears to be added. */
+      svn_fs_root_t *from_root;
+      SVN_ERR(svn_fs_revision_root(&from_root, fs, 0, scratch_pool));
+      SVN_ERR(svn_repos_dir_delta2(from_root, "", "",
+                                   to_root, "",
+                                   dump_editor, dump_edit_baton,
+                                   shared->authz_func, authz_baton,
+                                   FALSE, /* don't send text-deltas */
+                                   svn_depth_infinity,
+                                   FALSE, /* don't send entry props */
+                                   FALSE, /* don't ignore ancestry */
+                                   scratch_pool));
+    }
+  else
+    {
+      /* The normal case: compare consecutive revs. */
+      SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
+                                dump_editor, dump_edit_baton,
+                                shared->authz_func, authz_baton,
+                                scratch_pool));
+
+      /* While our editor close_edit implementation is a no-op, we still
+         do this for completeness. */
+      SVN_ERR(dump_editor->close_edit(dump_edit_baton, scratch_pool));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Revisions prepared ahead of the output may keep this many bytes of their
+   dump data in memory.  Anything beyond that gets spilled to disk. */
+#define DUMP_BUFFER_SIZE (1024 * 1024)
+
+/* Process baton of a parallel dump task covering revisions START to END
+   (inclusive). */
+typedef struct dump_range_t
+{
+  const dump_shared_t *shared;
+  svn_revnum_t start;
+  svn_revnum_t end;
+} dump_range_t;
+
+/* Result of preparing a single revision for the dump. */
+typedef struct dump_rev_result_t
+{
+  /* The revision that has been prepared. */
+  svn_revnum_t revision;
+
+  /* Its complete dump data. */
+  svn_spillbuf_t *data;
+
+  /* svn_repos_notify_t * sent while preparing REVISION, in order. */
+  apr_array_header_t *notifications;
+
+  /* Whether REVISION refers to revisions that are not part of the dump. */
+  svn_boolean_t found_old_reference;
+  svn_boolean_t found_old_mergeinfo;
+} dump_rev_result_t;
+
+/* Implements svn_task__thread_context_constructor_t.  The thread context
+   is the svn_repos_t to use.  CONTEXT_BATON is the dump_shared_t. */
+static svn_error_t *
+dump_context_constructor(void **thread_context,
+                         void *context_baton,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  const dump_shared_t *shared = context_baton;
+  svn_repos_t *repos;
+
+  /* Like for verification, give each worker its own svn_fs_t. */
+  SVN_ERR(svn_repos_open3(&repos, shared->repos_path,
+                          shared->fs_config
+                            ? apr_hash_copy(result_pool, shared->fs_config)
+                            : NULL,
+                          result_pool, scratch_pool));
+  *thread_context = repos;
+
+  return SVN_NO_ERROR;
+}
+
+/* Add a sub-task to TASK that will prepare revisions START to END
+   (inclusive) using the settings in SHARED. */
+static svn_error_t *
+add_dump_range(svn_task__t *task,
+               const dump_shared_t *shared,
+               svn_revnum_t start,
+               svn_revnum_t end)
+{
+  apr_pool_t *process_pool = svn_task__create_process_pool(task);
+  dump_range_t *range = apr_pcalloc(process_pool, sizeof(*range));
+
+  range->shared = shared;
+  range->start = start;
+  range->end = end;
+
+  return svn_error_trace(svn_task__add_similar(task, process_pool, NULL,
+                                               range));
+}
+
+/* Implements svn_task__process_func_t.  PROCESS_BATON is a dump_range_t
+   and THREAD_CONTEXT the svn_repos_t to use.
+
+   Like verify_range_process(), split ranges of more than one revision in
+   halves.  Single revisions get dumped into a spill buffer and produce a
+   dump_rev_result_t. */
+static svn_error_t *
+dump_range_process(void **result,
+                   svn_task__t *task,
+                   void *thread_context,
+                   void *process_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  const dump_range_t *range = process_baton;
+  const dump_shared_t *shared = range->shared;
+  dump_rev_result_t *rev_result;
+
+  if (range->start < range->end)
+    {
+      svn_revnum_t mid = range->start + (range->end - range->start) / 2;
+
+      SVN_ERR(add_dump_range(task, shared, range->start, mid));
+      SVN_ERR(add_dump_range(task, shared, mid + 1, range->end));
+
+      *result = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  rev_result = apr_pcalloc(result_pool, sizeof(*rev_result));
+  rev_result->revision = range->start;
+  rev_result->data = svn_spillbuf__create(SVN__STREAM_CHUNK_SIZE,
+                                          DUMP_BUFFER_SIZE, result_pool);
+  rev_result->notifications = apr_array_make(result_pool, 0,
+                                             sizeof(svn_repos_notify_t *));
+
+  SVN_ERR(dump_revision(svn_stream__from_spillbuf(rev_result->data,
+                                                  scratch_pool),
+                        thread_context, range->start, shared,
+                        shared->notify_func ? buffer_notify_func : NULL,
+                        rev_result->notifications,
+                        &rev_result->found_old_reference,
+                        &rev_result->found_old_mergeinfo,
+                        scratch_pool));
+
+  *result = rev_result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Copy the data of the
+   dump_rev_result_t RESULT to the stream given in the dump_shared_t
+   OUTPUT_BATON and forward the notifications. */
+static svn_error_t *
+dump_range_output(svn_task__t *task,
+                  void *result,
+                  void *output_baton,
+                  svn_cancel_func_t cancel_func,
+                  void *cancel_baton,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  dump_rev_result_t *rev_result = result;
+  dump_shared_t *shared = output_baton;
+  int i;
+
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  while (TRUE)
+    {
+      const char *data;
+      apr_size_t len;
+
+      SVN_ERR(svn_spillbuf__read(&data, &len, rev_result->data,
+                                 scratch_pool));
+      if (data == NULL)
+        break;
+
+      SVN_ERR(svn_stream_write(shared->stream, data, &len));
+    }
+
+  if (rev_result->found_old_reference)
+    shared->found_old_reference = TRUE;
+  if (rev_result->found_old_mergeinfo)
+    shared->found_old_mergeinfo = TRUE;
+
+  if (shared->notify_func)
+    {
+      svn_repos_notify_t *notify;
+
+      for (i = 0; i < rev_result->notifications->nelts; ++i)
+        shared->notify_func(shared->notify_baton,
+                            APR_ARRAY_IDX(rev_result->notifications, i,
+                                          svn_repos_notify_t *),
+                            scratch_pool);
+
+      notify = svn_repos_notify_create(svn_repos_notify_dump_rev_end,
+                                       scratch_pool);
+      notify->revision = rev_result->revision;
+      shared->notify_func(shared->notify_baton, notify, scratch_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* The main dumper. */
 svn_error_t *
-svn_repos_dump_fs4(svn_repos_t *repos,
+svn_repos_dump_fs5(svn_repos_t *repos,
                    svn_stream_t *stream,
                    svn_revnum_t start_rev,
                    svn_revnum_t end_rev,
@@ -2031,6 +2346,7 @@ svn_repos_dump_fs4(svn_repos_t *repos,
                    svn_boolean_t use_deltas,
                    svn_boolean_t include_revprops,
                    svn_boolean_t include_changes,
+                   int jobs,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_repos_dump_filter_func_t filter_func,
@@ -2039,19 +2355,14 @@ svn_repos_dump_fs4(svn_repos_t *repos,
                    void *cancel_baton,
                    apr_pool_t *pool)
 {
-  const svn_delta_editor_t *dump_editor;
-  void *dump_edit_baton = NULL;
   svn_revnum_t rev;
   svn_fs_t *fs = svn_repos_fs(repos);
   apr_pool_t *iterpool = svn_pool_create(pool);
   svn_revnum_t youngest;
   const char *uuid;
   int version;
-  svn_boolean_t found_old_reference = FALSE;
-  svn_boolean_t found_old_mergeinfo = FALSE;
   svn_repos_notify_t *notify;
-  svn_repos_authz_func_t authz_func;
-  dump_filter_baton_t authz_baton = {0};
+  dump_shared_t *shared;
 
   /* Make sure we catch up on the latest revprop changes.  This is the only
    * time we will refresh the revprop data in this query. */
@@ -2080,18 +2391,26 @@ svn_repos_dump_fs4(svn_repos_t *repos,
                                "(youngest revision is %ld)"),
                              end_rev, youngest);
 
+  shared = apr_pcalloc(pool, sizeof(*shared));
+  shared->repos_path = svn_repos_path(repos, pool);
+  shared->fs_config = svn_fs_config(fs, pool);
+  shared->start_rev = start_rev;
+  shared->incremental = incremental;
+  shared->use_deltas = use_deltas;
+  shared->include_revprops = include_revprops;
+  shared->include_changes = include_changes;
+  shared->stream = stream;
+  shared->notify_func = notify_func;
+  shared->notify_baton = notify_baton;
+
   /* We use read authz callback to implement dump filtering. If there is no
    * read access for some node, it will be excluded from dump as well as
    * references to it (e.g. copy source). */
   if (filter_func)
     {
-      authz_func = dump_filter_authz_func;
-      authz_baton.filter_func = filter_func;
-      authz_baton.filter_baton = filter_baton;
-    }
-  else
-    {
-      authz_func = NULL;
+      shared->authz_func = dump_filter_authz_func;
+      shared->authz_baton.filter_func = filter_func;
+      shared->authz_baton.filter_baton = filter_baton;
     }
 
   /* Write out the UUID. */
@@ -2108,82 +2427,50 @@ svn_repos_dump_fs4(svn_repos_t *repos,
   SVN_ERR(svn_repos__dump_magic_header_record(stream, version, pool));
   SVN_ERR(svn_repos__dump_uuid_header_record(stream, uuid, pool));
 
-  /* Create a notify object that we can reuse in the loop. */
-  if (notify_func)
-    notify = svn_repos_notify_create(svn_repos_notify_dump_rev_end,
-                                     pool);
-
-  /* Main loop:  we're going to dump revision REV.  */
-  for (rev = start_rev; rev <= end_rev; rev++)
+  if (jobs > 1 && start_rev < end_rev)
     {
-      svn_fs_root_t *to_root;
-      svn_boolean_t use_deltas_for_rev;
-
-      svn_pool_clear(iterpool);
-
-      /* Check for cancellation. */
-      if (cancel_func)
-        SVN_ERR(cancel_func(cancel_baton));
-
-      /* Write the revision record. */
-      SVN_ERR(write_revision_record(stream, repos, rev, include_revprops,
-                                    authz_func, &authz_baton, iterpool));
-
-      /* When dumping revision 0, we just write out the revision record.
-         The parser might want to use its properties.
-         If we don't want revision changes at all, skip in any case. */
-      if (rev == 0 || !include_changes)
-        goto loop_end;
-
-      /* Fetch the editor which dumps nodes to a file.  Regardless of
-         what we've been told, don't use deltas for the first rev of a
-         non-incremental dump. */
-      use_deltas_for_rev = use_deltas && (incremental || rev != start_rev);
-      SVN_ERR(get_dump_editor(&dump_editor, &dump_edit_baton, fs, rev,
-                              "", stream, &found_old_reference,
-                              &found_old_mergeinfo, NULL,
-                              notify_func, notify_baton,
-                              start_rev, use_deltas_for_rev, FALSE, FALSE,
-                              iterpool));
-
-      /* Drive the editor in one way or another. */
-      SVN_ERR(svn_fs_revision_root(&to_root, fs, rev, iterpool));
-
-      /* If this is the first revision of a non-incremental dump,
-         we're in for a full tree dump.  Otherwise, we want to simply
-         replay the revision.  */
-      if ((rev == start_rev) && (! incremental))
-        {
-          /* Compare against revision 0, so everything appears to be added. */
-          svn_fs_root_t *from_root;
-          SVN_ERR(svn_fs_revision_root(&from_root, fs, 0, iterpool));
-          SVN_ERR(svn_repos_dir_delta2(from_root, "", "",
-                                       to_root, "",
-                                       dump_editor, dump_edit_baton,
-                                       authz_func, &authz_baton,
-                                       FALSE, /* don't send text-deltas */
-                                       svn_depth_infinity,
-                                       FALSE, /* don't send entry props */
-                                       FALSE, /* don't ignore ancestry */
-                                       iterpool));
-        }
-      else
-        {
-          /* The normal case: compare consecutive revs. */
-          SVN_ERR(svn_repos_replay2(to_root, "", SVN_INVALID_REVNUM, FALSE,
-                                    dump_editor, dump_edit_baton,
-                                    authz_func, &authz_baton, iterpool));
-
-          /* While our editor close_edit implementation is a no-op, we still
-             do this for completeness. */
-          SVN_ERR(dump_editor->close_edit(dump_edit_baton, iterpool));
-        }
-
-    loop_end:
+      dump_range_t *range = apr_pcalloc(pool, sizeof(*range));
+
+      range->shared = shared;
+      range->start = start_rev;
+      range->end = end_rev;
+
+      /* Prepare revisions as isolated tasks in parallel.  Their data gets
+         written in revision order. */
+      SVN_ERR(svn_task__run(jobs,
+                            dump_range_process, range,
+                            dump_range_output, shared,
+                            dump_context_constructor, shared,
+                            cancel_func, cancel_baton,
+                            pool, iterpool));
+    }
+  else
+    {
+      /* Create a notify object that we can reuse in the loop. */
       if (notify_func)
+        notify = svn_repos_notify_create(svn_repos_notify_dump_rev_end,
+                                         pool);
+
+      /* Main loop:  we're going to dump revision REV.  */
+      for (rev = start_rev; rev <= end_rev; rev++)
         {
-          notify->revision = rev;
-          notify_func(notify_baton, notify, iterpool);
+          svn_pool_clear(iterpool);
+
+          /* Check for cancellation. */
+          if (cancel_func)
+            SVN_ERR(cancel_func(cancel_baton));
+
+          SVN_ERR(dump_revision(stream, repos, rev, shared,
+                                notify_func, notify_baton,
+                                &shared->found_old_reference,
+                                &shared->found_old_mergeinfo,
+                                iterpool));
+
+          if (notify_func)
+            {
+              notify->revision = rev;
+              notify_func(notify_baton, notify, iterpool);
+            }
         }
     }
 
@@ -2197,7 +2484,7 @@ svn_repos_dump_fs4(svn_repos_t *repos,
       notify = svn_repos_notify_create(svn_repos_notify_dump_end, iterpool);
       notify_func(notify_baton, notify, iterpool);
 
-      if (found_old_reference)
+      if (shared->found_old_reference)
         {
           notify_warning(iterpool, notify_func, notify_baton,
                          svn_repos_notify_warning_found_old_reference,
@@ -2209,7 +2496,7 @@ svn_repos_dump_fs4(svn_repos_t *repos,
 
       /* Ditto if we issued any warnings about old revisions referenced
          in dumped mergeinfo. */
-      if (found_old_mergeinfo)
+      if (shared->found_old_mergeinfo)
         {
           notify_warning(iterpool, notify_func, notify_baton,
                          svn_repos_notify_warning_found_old_mergeinfo,
@@ -2459,12 +2746,218 @@ report_error(svn_revnum_t revision,
     }
 }
 
+/* Parameters and state shared by all tasks of a parallel verification
+   run.  Everything in here is read-only while tasks are being executed. */
+typedef struct verify_shared_t
+{
+  /* FS to verify.  Used directly in single-threaded mode and as template
+     for the per-thread FS instances otherwise. */
+  svn_fs_t *fs;
+
+  /* Path and configuration of FS, pre-fetched for the worker threads. */
+  const char *fs_path;
+  apr_hash_t *fs_config;
+
+  /* Number of worker threads requested by the caller. */
+  int jobs;
+
+  /* Parameters passed through to verify_one_revision(). */
+  svn_revnum_t start_rev;
+  svn_boolean_t check_normalization;
+
+  /* Caller's callbacks, only being invoked from the output function. */
+  svn_repos_notify_func_t notify_func;
+  void *notify_baton;
+  svn_repos_verify_callback_t verify_callback;
+  void *verify_baton;
+} verify_shared_t;
+
+/* Process baton of a verification task covering revisions START to END
+   (inclusive). */
+typedef struct verify_range_t
+{
+  const verify_shared_t *shared;
+  svn_revnum_t start;
+  svn_revnum_t end;
+} verify_range_t;
+
+/* Result of verifying a single revision in some task. */
+typedef struct verify_rev_result_t
+{
+  /* The revision that got verified. */
+  svn_revnum_t revision;
+
+  /* svn_repos_notify_t * sent while verifying REVISION, in order. */
+  apr_array_header_t *notifications;
+
+  /* Verification failure or SVN_NO_ERROR. */
+  svn_error_t *err;
+} verify_rev_result_t;
+
+/* Implements svn_task__thread_context_constructor_t.  The thread context
+   is the svn_fs_t to use.  CONTEXT_BATON is the verify_shared_t. */
+static svn_error_t *
+verify_context_constructor(void **thread_context,
+                           void *context_baton,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool)
+{
+  const verify_shared_t *shared = context_baton;
+  svn_fs_t *fs;
+
+  /* Single-threaded execution may simply use the caller's FS. */
+  if (shared->jobs <= 1)
+    {
+      *thread_context = shared->fs;
+      return SVN_NO_ERROR;
+    }
+
+  /* svn_fs_t must not be shared between threads.  Give each worker its
+     own instance; the process-wide caches will still be shared. */
+  SVN_ERR(svn_fs_open2(&fs, shared->fs_path,
+                       shared->fs_config
+                         ? apr_hash_copy(result_pool, shared->fs_config)
+                         : NULL,
+                       result_pool, scratch_pool));
+  *thread_context = fs;
+
+  return SVN_NO_ERROR;
+}
+
+/* Add a sub-task to TASK that will verify revisions START to END
+   (inclusive) using the settings in SHARED. */
+static svn_error_t *
+add_verify_range(svn_task__t *task,
+                 const verify_shared_t *shared,
+                 svn_revnum_t start,
+                 svn_revnum_t end)
+{
+  apr_pool_t *process_pool = svn_task__create_process_pool(task);
+  verify_range_t *range = apr_pcalloc(process_pool, sizeof(*range));
+
+  range->shared = shared;
+  range->start = start;
+  range->end = end;
+
+  return svn_error_trace(svn_task__add_similar(task, process_pool, NULL,
+                                               range));
+}
+
+/* Implements svn_task__process_func_t.  PROCESS_BATON is a verify_range_t
+   and THREAD_CONTEXT the svn_fs_t to use.
+
+   Ranges of more than one revision get split in halves and turned into
+   sub-tasks, keeping the number of pending tasks logarithmic in the size
+   of the range.  Single revisions get verified and produce a
+   verify_rev_result_t. */
+static svn_error_t *
+verify_range_process(void **result,
+                     svn_task__t *task,
+                     void *thread_context,
+                     void *process_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  const verify_range_t *range = process_baton;
+  const verify_shared_t *shared = range->shared;
+  svn_fs_t *fs = thread_context;
+  verify_rev_result_t *rev_result;
+  svn_error_t *err;
+
+  if (range->start < range->end)
+    {
+      svn_revnum_t mid = range->start + (range->end - range->start) / 2;
+
+      SVN_ERR(add_verify_range(task, shared, range->start, mid));
+      SVN_ERR(add_verify_range(task, shared, mid + 1, range->end));
+
+      *result = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  rev_result = apr_pcalloc(result_pool, sizeof(*rev_result));
+  rev_result->revision = range->start;
+  rev_result->notifications = apr_array_make(result_pool, 0,
+                                             sizeof(svn_repos_notify_t *));
+
+  err = verify_one_revision(fs, range->start,
+                            shared->notify_func ? buffer_notify_func : NULL,
+                            rev_result->notifications,
+                            shared->start_rev, shared->check_normalization,
+                            cancel_func, cancel_baton, scratch_pool);
+
+  /* Cancellation is not a verification failure and needs to stop the
+     whole task tree. */
+  if (err && err->apr_err == SVN_ERR_CANCELLED)
+    return svn_error_trace(err);
+
+  rev_result->err = err;
+  *result = rev_result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  Forward the notifications and
+   verification results in the verify_rev_result_t RESULT to the callbacks
+   given in the verify_shared_t OUTPUT_BATON. */
+static svn_error_t *
+verify_range_output(svn_task__t *task,
+                    void *result,
+                    void *output_baton,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  verify_rev_result_t *rev_result = result;
+  const verify_shared_t *shared = output_baton;
+  int i;
+
+  if (cancel_func)
+    {
+      svn_error_t *err = cancel_func(cancel_baton);
+      if (err)
+        {
+          svn_error_clear(rev_result->err);
+          return svn_error_trace(err);
+        }
+    }
+
+  if (shared->notify_func)
+    for (i = 0; i < rev_result->notifications->nelts; ++i)
+      shared->notify_func(shared->notify_baton,
+                          APR_ARRAY_IDX(rev_result->notifications, i,
+                                        svn_repos_notify_t *),
+                          scratch_pool);
+
+  if (rev_result->err)
+    {
+      SVN_ERR(report_error(rev_result->revision, rev_result->err,
+                           shared->verify_callback, shared->verify_baton,
+                           scratch_pool));
+    }
+  else if (shared->notify_func)
+    {
+      /* Tell the caller that we're done with this revision. */
+      svn_repos_notify_t *notify
+        = svn_repos_notify_create(svn_repos_notify_verify_rev_end,
+                                  scratch_pool);
+      notify->revision = rev_result->revision;
+      shared->notify_func(shared->notify_baton, notify, scratch_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
-svn_repos_verify_fs3(svn_repos_t *repos,
+svn_repos_verify_fs4(svn_repos_t *repos,
                      svn_revnum_t start_rev,
                      svn_revnum_t end_rev,
                      svn_boolean_t check_normalization,
                      svn_boolean_t metadata_only,
+                     int jobs,
                      svn_repos_notify_func_t notify_func,
                      void *notify_baton,
                      svn_repos_verify_callback_t verify_callback,
@@ -2475,7 +2968,6 @@ svn_repos_verify_fs3(svn_repos_t *repos,
 {
   svn_fs_t *fs = svn_repos_fs(repos);
   svn_revnum_t youngest;
-  svn_revnum_t rev;
   apr_pool_t *iterpool = svn_pool_create(pool);
   svn_repos_notify_t *notify;
   svn_fs_progress_notify_func_t verify_notify = NULL;
@@ -2507,12 +2999,10 @@ svn_repos_verify_fs3(svn_repos_t *repos,
                                "(youngest revision is %ld)"),
                              end_rev, youngest);
 
-  /* Create a notify object that we can reuse within the loop and a
-     forwarding structure for notifications from inside svn_fs_verify(). */
+  /* Create a forwarding structure for notifications from inside
+     svn_fs_verify(). */
   if (notify_func)
     {
-      notify = svn_repos_notify_create(svn_repos_notify_verify_rev_end, pool);
-
       verify_notify = verify_fs_notify_func;
       verify_notify_baton = apr_palloc(pool, sizeof(*verify_notify_baton));
       verify_notify_baton->notify_func = notify_func;
@@ -2538,32 +3028,34 @@ svn_repos_verify_fs3(svn_repos_t *repos,
     }
 
   if (!metadata_only)
-    for (rev = start_rev; rev <= end_rev; rev++)
-      {
-        svn_pool_clear(iterpool);
-
-        /* Wrapper function to catch the possible errors. */
-        err = verify_one_revision(fs, rev, notify_func, notify_baton,
-                                  start_rev, check_normalization,
-                                  cancel_func, cancel_baton,
-                                  iterpool);
-
-        if (err && err->apr_err == SVN_ERR_CANCELLED)
-          {
-            return svn_error_trace(err);
-          }
-        else if (err)
-          {
-            SVN_ERR(report_error(rev, err, verify_callback, verify_baton,
-                                 iterpool));
-          }
-        else if (notify_func)
-          {
-            /* Tell the caller that we're done with this revision. */
-            notify->revision = rev;
-            notify_func(notify_baton, notify, iterpool);
-          }
-      }
+    {
+      verify_shared_t *shared = apr_pcalloc(pool, sizeof(*shared));
+      verify_range_t *range = apr_pcalloc(pool, sizeof(*range));
+
+      shared->fs = fs;
+      shared->fs_path = svn_fs_path(fs, pool);
+      shared->fs_config = svn_fs_config(fs, pool);
+      shared->jobs = jobs;
+      shared->start_rev = start_rev;
+      shared->check_normalization = check_normalization;
+      shared->notify_func = notify_func;
+      shared->notify_baton = notify_baton;
+      shared->verify_callback = verify_callback;
+      shared->verify_baton = verify_baton;
+
+      range->shared = shared;
+      range->start = start_rev;
+      range->end = end_rev;
+
+      /* Verify revisions as isolated tasks, possibly in parallel.
+         Results will be reported in revision order. */
+      SVN_ERR(svn_task__run(MAX(jobs, 1),
+                            verify_range_process, range,
+                            verify_range_output, shared,
+                            verify_context_constructor, shared,
+                            cancel_func, cancel_baton,
+                            pool, iterpool));
+    }
 
   /* We're done. */
   if (notify_func)
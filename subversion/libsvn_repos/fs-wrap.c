@@ -111,6 +111,13 @@ svn_repos_fs_commit_txn(const char **conflict_p,
       return err;
     }
 
+  /* Keep the indexes current.  Failing to do so is not fatal as the
+     next update will catch up. */
+  svn_error_clear(svn_repos__path_index_update(repos, FALSE, NULL, NULL,
+                                               pool));
+  svn_error_clear(svn_repos__date_index_update(repos, FALSE, NULL, NULL,
+                                               pool));
+
   /* Run post-commit hooks. */
   if ((err2 = svn_repos__hooks_post_commit(repos, hooks_env,
                                            *new_rev, txn_name, pool)))
@@ -439,6 +446,10 @@ svn_repos_fs_change_rev_prop4(svn_repos_t *repos,
       SVN_ERR(svn_fs_change_rev_prop2(repos->fs, rev, name,
                                       &old_value, new_value, pool));
 
+      /* A stale date index only slows down svn_repos_dated_revision(). */
+      if (strcmp(name, SVN_PROP_REVISION_DATE) == 0)
+        svn_error_clear(svn_repos__date_index_refresh(repos, rev, pool));
+
       if (use_post_revprop_change_hook)
         SVN_ERR(svn_repos__hooks_post_revprop_change(repos, hooks_env, rev,
                                                      author, name, old_value,
@@ -1033,7 +1044,8 @@ pack_notify_func(void *baton,
 }
 
 svn_error_t *
-svn_repos_fs_pack2(svn_repos_t *repos,
+svn_repos_fs_pack3(svn_repos_t *repos,
+                   int jobs,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_cancel_func_t cancel_func,
@@ -1045,10 +1057,16 @@ svn_repos_fs_pack2(svn_repos_t *repos,
   pnb.notify_func = notify_func;
   pnb.notify_baton = notify_baton;
 
-  return svn_fs_pack(repos->db_path,
-                     notify_func ? pack_notify_func : NULL,
-                     notify_func ? &pnb : NULL,
-                     cancel_func, cancel_baton, pool);
+  SVN_ERR(svn_fs_pack2(repos->db_path, jobs,
+                       notify_func ? pack_notify_func : NULL,
+                       notify_func ? &pnb : NULL,
+                       cancel_func, cancel_baton, pool));
+
+  /* Packed revprops are expensive to read one by one.  Make sure that
+     svn_repos_dated_revision() has its index. */
+  return svn_error_trace(svn_repos__date_index_update(repos, TRUE,
+                                                      cancel_func,
+                                                      cancel_baton, pool));
 }
 
 svn_error_t *
@@ -26,6 +26,7 @@
 
 #include <apr_pools.h>
 #include <apr_file_io.h>
+#include <apr_network_io.h>
 
 #include "svn_config.h"
 #include "svn_hash.h"
@@ -45,75 +46,37 @@
 
 /*** Hook drivers. ***/
 
-/* Helper function for run_hook_cmd().  Wait for a hook to finish
-   executing and return either SVN_NO_ERROR if the hook script completed
-   without error, or an error describing the reason for failure.
-
-   NAME and CMD are the name and path of the hook program, CMD_PROC
-   is a pointer to the structure representing the running process,
-   and READ_ERRHANDLE is an open handle to the hook's stderr.
-
-   Hooks are considered to have failed if we are unable to wait for the
-   process, if we are unable to read from the hook's stderr, if the
-   process has failed to exit cleanly (due to a coredump, for example),
-   or if the process returned a non-zero return code.
-
-   Any error output returned by the hook's stderr will be included in an
-   error message, though the presence of output on stderr is not itself
-   a reason to fail a hook. */
+/* Return the error for the hook NAME that ended with EXITWHY and
+   EXITCODE.  NATIVE_STDERR is the error output of the hook in the
+   native encoding or NULL if it could not be read. */
 static svn_error_t *
-check_hook_result(const char *name, const char *cmd, apr_proc_t *cmd_proc,
-                  apr_file_t *read_errhandle, apr_pool_t *pool)
+hook_failure_error(const char *name,
+                   apr_exit_why_e exitwhy,
+                   int exitcode,
+                   const char *native_stderr,
+                   apr_pool_t *pool)
 {
-  svn_error_t *err, *err2;
-  svn_stringbuf_t *native_stderr, *failure_message;
+  svn_error_t *err;
+  svn_stringbuf_t *failure_message;
   const char *utf8_stderr;
-  int exitcode;
-  apr_exit_why_e exitwhy;
-
-  err2 = svn_stringbuf_from_aprfile(&native_stderr, read_errhandle, pool);
-
-  err = svn_io_wait_for_cmd(cmd_proc, cmd, &exitcode, &exitwhy, pool);
-  if (err)
-    {
-      svn_error_clear(err2);
-      return svn_error_trace(err);
-    }
-
-  if (APR_PROC_CHECK_EXIT(exitwhy) && exitcode == 0)
-    {
-      /* The hook exited cleanly.  However, if we got an error reading
-         the hook's stderr, fail the hook anyway, because this might be
-         symptomatic of a more important problem. */
-      if (err2)
-        {
-          return svn_error_createf
-            (SVN_ERR_REPOS_HOOK_FAILURE, err2,
-             _("'%s' hook succeeded, but error output could not be read"),
-             name);
-        }
-
-      return SVN_NO_ERROR;
-    }
-
-  /* The hook script failed. */
 
   /* If we got the stderr output okay, try to translate it into UTF-8.
      Ensure there is something sensible in the UTF-8 string regardless. */
-  if (!err2)
+  if (native_stderr)
     {
-      err2 = svn_utf_cstring_to_utf8(&utf8_stderr, native_stderr->data, pool);
-      if (err2)
+      err = svn_utf_cstring_to_utf8(&utf8_stderr, native_stderr, pool);
+      if (err)
         utf8_stderr = _("[Error output could not be translated from the "
                         "native locale to UTF-8.]");
     }
   else
     {
+      err = SVN_NO_ERROR;
       utf8_stderr = _("[Error output could not be read.]");
     }
   /*### It would be nice to include the text of any translation or read
         error in the messages above before we clear it here. */
-  svn_error_clear(err2);
+  svn_error_clear(err);
 
   if (!APR_PROC_CHECK_EXIT(exitwhy))
     {
@@ -158,10 +121,74 @@ check_hook_result(const char *name, const char *cmd, apr_proc_t *cmd_proc,
                                _(" with no output."));
     }
 
-  return svn_error_create(SVN_ERR_REPOS_HOOK_FAILURE, err,
+  return svn_error_create(SVN_ERR_REPOS_HOOK_FAILURE, NULL,
                           failure_message->data);
 }
 
+/* Helper function for run_hook_cmd().  Wait for a hook to finish
+   executing and return either SVN_NO_ERROR if the hook script completed
+   without error, or an error describing the reason for failure.
+
+   NAME and CMD are the name and path of the hook program, CMD_PROC
+   is a pointer to the structure representing the running process,
+   and READ_ERRHANDLE is an open handle to the hook's stderr.
+
+   Hooks are considered to have failed if we are unable to wait for the
+   process, if we are unable to read from the hook's stderr, if the
+   process has failed to exit cleanly (due to a coredump, for example),
+   or if the process returned a non-zero return code.
+
+   Any error output returned by the hook's stderr will be included in an
+   error message, though the presence of output on stderr is not itself
+   a reason to fail a hook. */
+static svn_error_t *
+check_hook_result(const char *name, const char *cmd, apr_proc_t *cmd_proc,
+                  apr_file_t *read_errhandle, apr_pool_t *pool)
+{
+  svn_error_t *err, *err2;
+  svn_stringbuf_t *native_stderr;
+  int exitcode;
+  apr_exit_why_e exitwhy;
+
+  err2 = svn_stringbuf_from_aprfile(&native_stderr, read_errhandle, pool);
+
+  err = svn_io_wait_for_cmd(cmd_proc, cmd, &exitcode, &exitwhy, pool);
+  if (err)
+    {
+      svn_error_clear(err2);
+      return svn_error_trace(err);
+    }
+
+  if (APR_PROC_CHECK_EXIT(exitwhy) && exitcode == 0)
+    {
+      /* The hook exited cleanly.  However, if we got an error reading
+         the hook's stderr, fail the hook anyway, because this might be
+         symptomatic of a more important problem. */
+      if (err2)
+        {
+          return svn_error_createf
+            (SVN_ERR_REPOS_HOOK_FAILURE, err2,
+             _("'%s' hook succeeded, but error output could not be read"),
+             name);
+        }
+
+      return SVN_NO_ERROR;
+    }
+
+  /* The hook script failed. */
+  if (err2)
+    {
+      svn_error_clear(err2);
+      native_stderr = NULL;
+    }
+
+  return svn_error_trace(hook_failure_error(name, exitwhy, exitcode,
+                                            native_stderr
+                                              ? native_stderr->data
+                                              : NULL,
+                                            pool));
+}
+
 /* Copy the environment given as key/value pairs of ENV_HASH into
  * an array of C strings allocated in RESULT_POOL.
  * If the hook environment is empty, return NULL.
@@ -193,6 +220,283 @@ env_from_env_hash(apr_hash_t *env_hash,
   return env;
 }
 
+/* Return TRUE if the hook NAME appears in the whitespace or comma
+ * separated list given as option OPTION in the hook runner configuration
+ * RUNNER.  Use SCRATCH_POOL for temporary allocations. */
+static svn_boolean_t
+runner_handles_hook(apr_hash_t *runner,
+                    const char *option,
+                    const char *name,
+                    apr_pool_t *scratch_pool)
+{
+  const char *value = svn_hash_gets(runner, option);
+
+  if (!value)
+    return FALSE;
+
+  return svn_cstring_match_list(name,
+                                svn_cstring_split(value, " \t,", TRUE,
+                                                  scratch_pool));
+}
+
+/* Append DATA of length LEN to BUF as a netstring, i.e. as
+ * "<length>:<data>,". */
+static void
+append_netstring(svn_stringbuf_t *buf,
+                 const char *data,
+                 apr_size_t len)
+{
+  char digits[SVN_INT64_BUFFER_SIZE];
+
+  svn_stringbuf_appendbytes(buf, digits, svn__ui64toa(digits, len));
+  svn_stringbuf_appendbyte(buf, ':');
+  svn_stringbuf_appendbytes(buf, data, len);
+  svn_stringbuf_appendbyte(buf, ',');
+}
+
+/* Parse the netstring at *DATA within the *REMAINING bytes available
+ * there and return its contents in *VALUE, allocated in POOL.  Advance
+ * *DATA and *REMAINING past the netstring. */
+static svn_error_t *
+parse_netstring(const char **value,
+                const char **data,
+                apr_size_t *remaining,
+                apr_pool_t *pool)
+{
+  const char *colon = memchr(*data, ':', *remaining);
+  apr_uint64_t len;
+
+  if (!colon
+      || svn_cstring_strtoui64(&len, apr_pstrmemdup(pool, *data,
+                                                    colon - *data),
+                               0, *remaining, 10)
+      || len + 2 > *remaining - (colon - *data)
+      || colon[len + 1] != ',')
+    return svn_error_create(SVN_ERR_REPOS_HOOK_FAILURE, NULL,
+                            _("Malformed response from the hook runner"));
+
+  *value = apr_pstrmemdup(pool, colon + 1, (apr_size_t)len);
+  *remaining -= (colon - *data) + (apr_size_t)len + 2;
+  *data = colon + len + 2;
+
+  return SVN_NO_ERROR;
+}
+
+/* Open a connection to the hook runner at ADDRESS, given as HOST:PORT.
+ * Unless TIMEOUT is 0, fail operations on the socket that take longer
+ * than TIMEOUT.  Allocate *SOCK in POOL. */
+static svn_error_t *
+connect_to_runner(apr_socket_t **sock,
+                  const char *address,
+                  apr_interval_time_t timeout,
+                  apr_pool_t *pool)
+{
+  char *host, *scope_id;
+  apr_port_t port;
+  apr_sockaddr_t *sa;
+  apr_status_t status;
+
+  status = apr_parse_addr_port(&host, &scope_id, &port, address, pool);
+  if (status || !host || !port)
+    return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                             _("Invalid hook runner address '%s'"),
+                             address);
+
+  status = apr_sockaddr_info_get(&sa, host, APR_UNSPEC, port, 0, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Unknown hostname '%s'"), host);
+
+  status = apr_socket_create(sock, sa->family, SOCK_STREAM, APR_PROTO_TCP,
+                             pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create socket"));
+
+  if (timeout)
+    {
+      status = apr_socket_timeout_set(*sock, timeout);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't set socket timeout"));
+    }
+
+  status = apr_socket_connect(*sock, sa);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't connect to host '%s'"),
+                              host);
+
+  return SVN_NO_ERROR;
+}
+
+/* Send REQUEST to the hook runner through SOCK and read its response
+ * into *RESPONSE, allocated in POOL. */
+static svn_error_t *
+exchange_with_runner(svn_stringbuf_t **response,
+                     apr_socket_t *sock,
+                     const svn_stringbuf_t *request,
+                     apr_pool_t *pool)
+{
+  const char *data = request->data;
+  apr_size_t remaining = request->len;
+  apr_status_t status = APR_SUCCESS;
+  svn_stringbuf_t *buf = svn_stringbuf_create_ensure(1024, pool);
+
+  while (remaining)
+    {
+      apr_size_t len = remaining;
+
+      status = apr_socket_send(sock, data, &len);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't write to connection"));
+
+      data += len;
+      remaining -= len;
+    }
+
+  /* The runner answers once it has seen the whole request and then
+     closes the connection. */
+  apr_socket_shutdown(sock, APR_SHUTDOWN_WRITE);
+  while (status != APR_EOF)
+    {
+      apr_size_t len = buf->blocksize - buf->len - 1;
+
+      if (len < 256)
+        {
+          svn_stringbuf_ensure(buf, 2 * buf->blocksize);
+          len = buf->blocksize - buf->len - 1;
+        }
+
+      status = apr_socket_recv(sock, buf->data + buf->len, &len);
+      if (status && status != APR_EOF)
+        return svn_error_wrap_apr(status, _("Can't read from connection"));
+
+      buf->len += len;
+    }
+
+  buf->data[buf->len] = '\0';
+  *response = buf;
+
+  return SVN_NO_ERROR;
+}
+
+/* Like run_hook_cmd() but let the persistent hook runner configured in
+ * RUNNER execute the hook instead of spawning a new process for it.
+ * HOOK_ENV is the environment for the hook.
+ *
+ * If the runner configuration lists NAME as asynchronous, only wait for
+ * the runner to queue the hook and don't report its outcome.  RESULT
+ * must be NULL then. */
+static svn_error_t *
+run_hook_through_runner(svn_string_t **result,
+                        const char *name,
+                        const char *cmd,
+                        const char **args,
+                        apr_hash_t *hook_env,
+                        apr_file_t *stdin_handle,
+                        apr_hash_t *runner,
+                        apr_pool_t *pool)
+{
+  const char *address = svn_hash_gets(runner, "address");
+  const char *timeout_str = svn_hash_gets(runner, "timeout");
+  apr_interval_time_t timeout = 0;
+  svn_boolean_t queue;
+  svn_stringbuf_t *request = svn_stringbuf_create_ensure(1024, pool);
+  svn_stringbuf_t *response;
+  svn_stringbuf_t *input;
+  apr_socket_t *sock;
+  apr_hash_index_t *hi;
+  const char *data, *exitcode_str, *output, *native_stderr;
+  apr_size_t remaining;
+  apr_pool_t *sock_pool;
+  svn_error_t *err;
+  int exitcode;
+  int i;
+
+  if (!address)
+    return svn_error_createf(SVN_ERR_BAD_CONFIG_VALUE, NULL,
+                             _("No 'address' given for the hook runner"));
+
+  if (timeout_str)
+    {
+      int seconds;
+
+      SVN_ERR(svn_cstring_atoi(&seconds, timeout_str));
+      timeout = apr_time_from_sec(seconds);
+    }
+
+  /* Waiting for the outcome of pre-* hooks is their whole point. */
+  queue = (!result
+           && strncmp(name, "post-", 5) == 0
+           && runner_handles_hook(runner, "async-hooks", name, pool));
+
+  /* Version, mode, hook name and path, arguments, environment and
+     finally the standard input of the hook. */
+  append_netstring(request, "1", 1);
+  if (queue)
+    append_netstring(request, "queue", 5);
+  else
+    append_netstring(request, "run", 3);
+  append_netstring(request, name, strlen(name));
+  append_netstring(request, cmd, strlen(cmd));
+
+  for (i = 0; args[i]; ++i)
+    ;
+  data = apr_itoa(pool, i);
+  append_netstring(request, data, strlen(data));
+  for (i = 0; args[i]; ++i)
+    append_netstring(request, args[i], strlen(args[i]));
+
+  data = apr_itoa(pool, hook_env ? apr_hash_count(hook_env) : 0);
+  append_netstring(request, data, strlen(data));
+  if (hook_env)
+    for (hi = apr_hash_first(pool, hook_env); hi; hi = apr_hash_next(hi))
+      {
+        data = apr_psprintf(pool, "%s=%s",
+                            (const char *)apr_hash_this_key(hi),
+                            (const char *)apr_hash_this_val(hi));
+        append_netstring(request, data, strlen(data));
+      }
+
+  if (stdin_handle)
+    SVN_ERR(svn_stringbuf_from_aprfile(&input, stdin_handle, pool));
+  else
+    input = svn_stringbuf_create_empty(pool);
+  append_netstring(request, input->data, input->len);
+
+  /* The socket is closed when SOCK_POOL gets destroyed. */
+  sock_pool = svn_pool_create(pool);
+  err = connect_to_runner(&sock, address, timeout, sock_pool);
+  if (!err)
+    err = exchange_with_runner(&response, sock, request, pool);
+  svn_pool_destroy(sock_pool);
+
+  /* Exit code, stdout and stderr of the hook. */
+  if (!err)
+    {
+      data = response->data;
+      remaining = response->len;
+      err = parse_netstring(&exitcode_str, &data, &remaining, pool);
+      if (!err)
+        err = parse_netstring(&output, &data, &remaining, pool);
+      if (!err)
+        err = parse_netstring(&native_stderr, &data, &remaining, pool);
+      if (!err)
+        err = svn_cstring_atoi(&exitcode, exitcode_str);
+    }
+
+  if (err)
+    return svn_error_createf(SVN_ERR_REPOS_HOOK_FAILURE, err,
+                             _("Failed to run '%s' hook through the hook "
+                               "runner at '%s'"), name, address);
+
+  if (exitcode)
+    return svn_error_trace(hook_failure_error(name, APR_PROC_EXIT, exitcode,
+                                              native_stderr, pool));
+
+  if (result)
+    *result = svn_string_create(output, pool);
+
+  return SVN_NO_ERROR;
+}
+
 /* NAME, CMD and ARGS are the name, path to and arguments for the hook
    program that is to be run.  The hook's exit status will be checked,
    and if an error occurred the hook's stderr output will be added to
@@ -202,7 +506,10 @@ env_from_env_hash(apr_hash_t *env_hash,
    no stdin to the hook.
 
    If RESULT is non-null, set *RESULT to the stdout of the hook or to
-   a zero-length string if the hook generates no output on stdout. */
+   a zero-length string if the hook generates no output on stdout.
+
+   If HOOKS_ENV configures a hook runner for NAME, let that run the
+   hook instead of starting a new process. */
 static svn_error_t *
 run_hook_cmd(svn_string_t **result,
              const char *name,
@@ -218,6 +525,26 @@ run_hook_cmd(svn_string_t **result,
   apr_proc_t cmd_proc = {0};
   apr_pool_t *cmd_pool;
   apr_hash_t *hook_env = NULL;
+  apr_hash_t *runner = NULL;
+
+  /* Check if a custom environment is defined for this hook, or else
+   * whether a default environment is defined. */
+  if (hooks_env)
+    {
+      hook_env = svn_hash_gets(hooks_env, name);
+      if (hook_env == NULL)
+        hook_env = svn_hash_gets(hooks_env,
+                                 SVN_REPOS__HOOKS_ENV_DEFAULT_SECTION);
+
+      runner = svn_hash_gets(hooks_env, SVN_REPOS__HOOKS_ENV_RUNNER_SECTION);
+    }
+
+  if (runner
+      && (runner_handles_hook(runner, "hooks", name, pool)
+          || runner_handles_hook(runner, "async-hooks", name, pool)))
+    return svn_error_trace(run_hook_through_runner(result, name, cmd, args,
+                                                   hook_env, stdin_handle,
+                                                   runner, pool));
 
   if (result)
     {
@@ -237,16 +564,6 @@ run_hook_cmd(svn_string_t **result,
    * destroy in order to clean up the stderr pipe opened for the process. */
   cmd_pool = svn_pool_create(pool);
 
-  /* Check if a custom environment is defined for this hook, or else
-   * whether a default environment is defined. */
-  if (hooks_env)
-    {
-      hook_env = svn_hash_gets(hooks_env, name);
-      if (hook_env == NULL)
-        hook_env = svn_hash_gets(hooks_env,
-                                 SVN_REPOS__HOOKS_ENV_DEFAULT_SECTION);
-    }
-
   err = svn_io_start_cmd3(&cmd_proc, ".", cmd, args,
                           env_from_env_hash(hook_env, pool, pool),
                           FALSE, FALSE, stdin_handle, result != NULL,
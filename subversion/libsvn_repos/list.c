@@ -27,7 +27,9 @@
 #include "svn_error.h"
 #include "svn_dirent_uri.h"
 #include "svn_time.h"
+#include "svn_hash.h"
 
+#include "private/svn_fspath.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_utf_private.h"
@@ -266,6 +268,108 @@ do_list(svn_fs_root_t *root,
   return SVN_NO_ERROR;
 }
 
+/* Set *READABLE to whether the user may read PATH and all its parents up
+ * to, but excluding, ROOT_PATH in ROOT according to AUTHZ_READ_FUNC and
+ * AUTHZ_READ_BATON.  Cache the results for the parents in DIR_ACCESS,
+ * which maps paths to "r" if readable and "" otherwise and must be
+ * allocated in a pool that lives at least as long as POOL.
+ */
+static svn_error_t *
+is_readable(svn_boolean_t *readable,
+            svn_fs_root_t *root,
+            const char *root_path,
+            const char *path,
+            apr_hash_t *dir_access,
+            svn_repos_authz_func_t authz_read_func,
+            void *authz_read_baton,
+            apr_pool_t *pool)
+{
+  const char *parent = svn_fspath__dirname(path, pool);
+
+  /* Check the parents first, caching the results. */
+  if (strcmp(parent, root_path) != 0)
+    {
+      const char *cached = svn_hash_gets(dir_access, parent);
+      if (!cached)
+        {
+          svn_boolean_t parent_readable;
+          apr_pool_t *hash_pool = apr_hash_pool_get(dir_access);
+
+          SVN_ERR(is_readable(&parent_readable, root, root_path, parent,
+                              dir_access, authz_read_func, authz_read_baton,
+                              pool));
+          cached = parent_readable ? "r" : "";
+          svn_hash_sets(dir_access, apr_pstrdup(hash_pool, parent), cached);
+        }
+
+      if (!*cached)
+        {
+          *readable = FALSE;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  return svn_error_trace(authz_read_func(readable, root, path,
+                                         authz_read_baton, pool));
+}
+
+/* Like do_list() with DEPTH being svn_depth_infinity, but report the
+ * nodes given in CANDIDATES, as returned by svn_repos__path_index_lookup(),
+ * instead of walking the tree below PATH.
+ */
+static svn_error_t *
+list_candidates(svn_fs_root_t *root,
+                const char *path,
+                const apr_array_header_t *candidates,
+                const apr_array_header_t *patterns,
+                svn_boolean_t path_info_only,
+                svn_repos_authz_func_t authz_read_func,
+                void *authz_read_baton,
+                svn_repos_dirent_receiver_t receiver,
+                void *receiver_baton,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                svn_membuf_t *scratch_buffer,
+                apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_hash_t *dir_access = apr_hash_make(scratch_pool);
+  int i;
+
+  for (i = 0; i < candidates->nelts; ++i)
+    {
+      const svn_repos__path_index_entry_t *entry
+        = &APR_ARRAY_IDX(candidates, i, svn_repos__path_index_entry_t);
+
+      svn_pool_clear(iterpool);
+
+      if (!matches_any(svn_fspath__basename(entry->path, iterpool),
+                       patterns, scratch_buffer))
+        continue;
+
+      /* Skip paths that we don't have access to. */
+      if (authz_read_func)
+        {
+          svn_boolean_t has_access;
+          SVN_ERR(is_readable(&has_access, root, path, entry->path,
+                              dir_access, authz_read_func, authz_read_baton,
+                              iterpool));
+          if (!has_access)
+            continue;
+        }
+
+      SVN_ERR(report_dirent(root, entry->path, entry->kind, path_info_only,
+                            receiver, receiver_baton, iterpool));
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_repos_list(svn_fs_root_t *root,
                const char *path,
@@ -329,6 +433,24 @@ svn_repos_list(svn_fs_root_t *root,
     SVN_ERR(report_dirent(root, path, kind, path_info_only,
                           receiver, receiver_baton, scratch_pool));
 
+  /* Searching a whole sub-tree for patterns?  The optional path index
+   * may spare us walking it. */
+  if (depth == svn_depth_infinity && patterns && kind == svn_node_dir)
+    {
+      apr_array_header_t *candidates;
+      SVN_ERR(svn_repos__path_index_lookup(&candidates, root, path, patterns,
+                                           scratch_pool, scratch_pool));
+      if (candidates)
+        return svn_error_trace(list_candidates(root, path, candidates,
+                                               patterns, path_info_only,
+                                               authz_read_func,
+                                               authz_read_baton,
+                                               receiver, receiver_baton,
+                                               cancel_func, cancel_baton,
+                                               &scratch_buffer,
+                                               scratch_pool));
+    }
+
   /* Report directory contents if requested. */
   if (depth > svn_depth_empty)
     SVN_ERR(do_list(root, path, patterns, depth,
@@ -179,9 +179,13 @@ change_rev_prop(svn_repos_t *repos,
     return svn_repos_fs_change_rev_prop4(repos, revision, NULL, name,
                                          NULL, value, FALSE, FALSE,
                                          NULL, NULL, pool);
-  else
-    return svn_fs_change_rev_prop2(svn_repos_fs(repos), revision, name,
-                                   NULL, value, pool);
+
+  SVN_ERR(svn_fs_change_rev_prop2(svn_repos_fs(repos), revision, name,
+                                  NULL, value, pool));
+  if (strcmp(name, SVN_PROP_REVISION_DATE) == 0)
+    svn_error_clear(svn_repos__date_index_refresh(repos, revision, pool));
+
+  return SVN_NO_ERROR;
 }
 
 /* Change property NAME to VALUE for PATH in TXN_ROOT.
@@ -1137,6 +1141,9 @@ close_revision(void *baton)
         return svn_error_trace(err);
     }
 
+  svn_error_clear(svn_repos__date_index_update(pb->repos, FALSE, NULL, NULL,
+                                               rb->pool));
+
   /* Run post-commit hook, if so commanded.  */
   if (pb->use_post_commit_hook)
     {
@@ -1275,7 +1282,7 @@ svn_repos_get_fs_build_parser6(const svn_repos_parse_fns3_t **callbacks,
 
 
 svn_error_t *
-svn_repos_load_fs6(svn_repos_t *repos,
+svn_repos_load_fs7(svn_repos_t *repos,
                    svn_stream_t *dumpstream,
                    svn_revnum_t start_rev,
                    svn_revnum_t end_rev,
@@ -1286,6 +1293,7 @@ svn_repos_load_fs6(svn_repos_t *repos,
                    svn_boolean_t validate_props,
                    svn_boolean_t ignore_dates,
                    svn_boolean_t normalize_props,
+                   int jobs,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_cancel_func_t cancel_func,
@@ -1312,6 +1320,13 @@ svn_repos_load_fs6(svn_repos_t *repos,
                                          notify_baton,
                                          pool));
 
+  /* With more than one thread, parse the stream while we commit. */
+  if (jobs > 1)
+    return svn_repos__parse_dumpstream_pipelined(dumpstream, parser,
+                                                 parse_baton, FALSE,
+                                                 cancel_func, cancel_baton,
+                                                 pool);
+
   return svn_repos_parse_dumpstream3(dumpstream, parser, parse_baton, FALSE,
                                      cancel_func, cancel_baton, pool);
 }
@@ -22,6 +22,7 @@
 
 
 #include <apr.h>
+#include <apr_thread_proc.h>
 
 #include "svn_hash.h"
 #include "svn_pools.h"
@@ -33,6 +34,8 @@
 #include "svn_ctype.h"
 
 #include "private/svn_dep_compat.h"
+#include "private/svn_mutex.h"
+#include "private/svn_thread_cond.h"
 
 /*----------------------------------------------------------------------*/
 
@@ -832,3 +835,853 @@ svn_repos_parse_dumpstream3(svn_stream_t *stream,
   svn_pool_destroy(nodepool);
   return SVN_NO_ERROR;
 }
+
+
+/*----------------------------------------------------------------------*/
+
+/** Pipelined parsing **/
+
+/* The dumpstream parser runs in a separate thread and records all
+   callback invocations in batches of "ops".  The caller's thread
+   replays them in the same order to the actual parser vtable.  That way,
+   reading the stream, parsing headers and properties as well as decoding
+   svndiff data runs concurrently with whatever the consumer does with
+   the data - usually committing it to some repository. */
+
+/* Approximate number of bytes to collect in one batch before handing it
+   over to the consumer. */
+#define PIPELINE_BATCH_SIZE (1024 * 1024)
+
+/* Maximum number of batches that may wait for the consumer.  Together
+   with PIPELINE_BATCH_SIZE, this limits the memory usage. */
+#define PIPELINE_MAX_BATCHES 8
+
+#if APR_HAS_THREADS
+
+/* Kinds of parser callback invocations. */
+typedef enum recorded_op_kind_t
+{
+  op_magic_header_record,
+  op_uuid_record,
+  op_new_revision_record,
+  op_new_node_record,
+  op_set_revision_property,
+  op_set_node_property,
+  op_delete_node_property,
+  op_remove_node_props,
+  op_set_fulltext,
+  op_write_fulltext,
+  op_close_fulltext,
+  op_apply_textdelta,
+  op_apply_window,
+  op_close_node,
+  op_close_revision
+} recorded_op_kind_t;
+
+/* A single recorded callback invocation.  Only the members relevant to
+   the respective KIND will be set. */
+typedef struct recorded_op_t
+{
+  recorded_op_kind_t kind;
+
+  /* Whether the op applies to the current node rather than to the
+     current revision. */
+  svn_boolean_t is_node;
+
+  /* Dumpfile format version for op_magic_header_record. */
+  int version;
+
+  /* UUID or property name. */
+  const char *name;
+
+  /* Record headers for op_new_revision_record and op_new_node_record. */
+  apr_hash_t *headers;
+
+  /* Property value or fulltext data. */
+  const svn_string_t *value;
+
+  /* Delta window.  May be NULL even for op_apply_window. */
+  svn_txdelta_window_t *window;
+
+  /* Next op in the same batch. */
+  struct recorded_op_t *next;
+} recorded_op_t;
+
+/* A sequence of recorded ops handed over from the parser thread to
+   the consumer. */
+typedef struct op_batch_t
+{
+  /* Root pool, using its own allocator, containing all data of this
+     batch.  The consumer destroys it after replaying the batch. */
+  apr_pool_t *pool;
+
+  /* The ops in this batch, in order. */
+  recorded_op_t *first;
+  recorded_op_t *last;
+
+  /* Approximate number of bytes used by the ops. */
+  apr_size_t size;
+
+  /* Next batch in the queue. */
+  struct op_batch_t *next;
+} op_batch_t;
+
+/* State shared between the parser thread and the consumer. */
+typedef struct pipeline_t
+{
+  /* Serializes access to all members below except those explicitly
+     marked otherwise. */
+  svn_mutex__t *mutex;
+
+  /* Signaled when a new batch has been queued or the parser finished. */
+  svn_thread_cond__t *batch_queued;
+
+  /* Signaled when the consumer took a batch or gave up. */
+  svn_thread_cond__t *batch_taken;
+
+  /* Queue of batches not replayed, yet. */
+  op_batch_t *first_queued;
+  op_batch_t *last_queued;
+  int queue_length;
+
+  /* Set once the parser thread has finished.  PARSER_ERR is the
+     parser's result then. */
+  svn_boolean_t finished;
+  svn_error_t *parser_err;
+
+  /* Set by the consumer when it gave up, e.g. due to some error. */
+  svn_boolean_t aborted;
+
+  /* Batch currently being filled.  Parser thread only. */
+  op_batch_t *current;
+
+  /* Parser parameters.  Read-only. */
+  svn_stream_t *stream;
+  svn_boolean_t deltas_are_text;
+} pipeline_t;
+
+/* Revision and node baton used by the recording parser vtable. */
+typedef struct record_baton_t
+{
+  pipeline_t *pipeline;
+  svn_boolean_t is_node;
+  apr_pool_t *pool;
+} record_baton_t;
+
+/* Return a new op of the given KIND for the IS_NODE record and append
+   it to the current batch in PIPELINE.  Parser thread only. */
+static recorded_op_t *
+record_op(pipeline_t *pipeline,
+          recorded_op_kind_t kind,
+          svn_boolean_t is_node)
+{
+  op_batch_t *batch = pipeline->current;
+  recorded_op_t *op;
+
+  if (batch == NULL)
+    {
+      apr_pool_t *pool
+        = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+      batch = apr_pcalloc(pool, sizeof(*batch));
+      batch->pool = pool;
+      pipeline->current = batch;
+    }
+
+  op = apr_pcalloc(batch->pool, sizeof(*op));
+  op->kind = kind;
+  op->is_node = is_node;
+
+  if (batch->last)
+    batch->last->next = op;
+  else
+    batch->first = op;
+
+  batch->last = op;
+  batch->size += sizeof(*op);
+
+  return op;
+}
+
+/* Append BATCH to the queue in PIPELINE, waiting for the queue to have
+   space for it.  If the consumer gave up, destroy BATCH and return
+   SVN_ERR_CANCELLED.
+
+   This function must be called with PIPELINE->MUTEX acquired. */
+static svn_error_t *
+enqueue_batch(pipeline_t *pipeline,
+              op_batch_t *batch)
+{
+  while (pipeline->queue_length >= PIPELINE_MAX_BATCHES
+         && !pipeline->aborted)
+    SVN_ERR(svn_thread_cond__wait(pipeline->batch_taken, pipeline->mutex));
+
+  if (pipeline->aborted)
+    {
+      svn_pool_destroy(batch->pool);
+      return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+    }
+
+  if (pipeline->last_queued)
+    pipeline->last_queued->next = batch;
+  else
+    pipeline->first_queued = batch;
+
+  pipeline->last_queued = batch;
+  ++pipeline->queue_length;
+
+  return svn_thread_cond__signal(pipeline->batch_queued);
+}
+
+/* Hand the current batch in PIPELINE over to the consumer if it became
+   large enough or if FORCE has been set.  Parser thread only. */
+static svn_error_t *
+flush_batch(pipeline_t *pipeline,
+            svn_boolean_t force)
+{
+  op_batch_t *batch = pipeline->current;
+  if (batch == NULL)
+    return SVN_NO_ERROR;
+
+  if (!force && batch->size < PIPELINE_BATCH_SIZE)
+    return SVN_NO_ERROR;
+
+  pipeline->current = NULL;
+  SVN_MUTEX__WITH_LOCK(pipeline->mutex, enqueue_batch(pipeline, batch));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return a recording revision or node baton for PIPELINE, depending on
+   IS_NODE, allocated in POOL. */
+static record_baton_t *
+make_record_baton(pipeline_t *pipeline,
+                  svn_boolean_t is_node,
+                  apr_pool_t *pool)
+{
+  record_baton_t *baton = apr_pcalloc(pool, sizeof(*baton));
+  baton->pipeline = pipeline;
+  baton->is_node = is_node;
+  baton->pool = pool;
+
+  return baton;
+}
+
+/* Return a deep copy of the record HEADERS allocated in POOL. */
+static apr_hash_t *
+copy_headers(apr_hash_t *headers,
+             apr_pool_t *pool)
+{
+  apr_hash_t *result = apr_hash_make(pool);
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(pool, headers); hi; hi = apr_hash_next(hi))
+    svn_hash_sets(result,
+                  apr_pstrdup(pool, apr_hash_this_key(hi)),
+                  apr_pstrdup(pool, apr_hash_this_val(hi)));
+
+  return result;
+}
+
+/* Implements svn_repos_parse_fns3_t.magic_header_record. */
+static svn_error_t *
+record_magic_header_record(int version,
+                           void *parse_baton,
+                           apr_pool_t *pool)
+{
+  pipeline_t *pipeline = parse_baton;
+  recorded_op_t *op = record_op(pipeline, op_magic_header_record, FALSE);
+  op->version = version;
+
+  return flush_batch(pipeline, FALSE);
+}
+
+/* Implements svn_repos_parse_fns3_t.uuid_record. */
+static svn_error_t *
+record_uuid_record(const char *uuid,
+                   void *parse_baton,
+                   apr_pool_t *pool)
+{
+  pipeline_t *pipeline = parse_baton;
+  recorded_op_t *op = record_op(pipeline, op_uuid_record, FALSE);
+  op->name = apr_pstrdup(pipeline->current->pool, uuid);
+
+  return flush_batch(pipeline, FALSE);
+}
+
+/* Implements svn_repos_parse_fns3_t.new_revision_record. */
+static svn_error_t *
+record_new_revision_record(void **revision_baton,
+                           apr_hash_t *headers,
+                           void *parse_baton,
+                           apr_pool_t *pool)
+{
+  pipeline_t *pipeline = parse_baton;
+  recorded_op_t *op = record_op(pipeline, op_new_revision_record, FALSE);
+  op->headers = copy_headers(headers, pipeline->current->pool);
+
+  *revision_baton = make_record_baton(pipeline, FALSE, pool);
+  return flush_batch(pipeline, FALSE);
+}
+
+/* Implements svn_repos_parse_fns3_t.new_node_record. */
+static svn_error_t *
+record_new_node_record(void **node_baton,
+                       apr_hash_t *headers,
+                       void *revision_baton,
+                       apr_pool_t *pool)
+{
+  record_baton_t *rb = revision_baton;
+  pipeline_t *pipeline = rb->pipeline;
+  recorded_op_t *op = record_op(pipeline, op_new_node_record, TRUE);
+  op->headers = copy_headers(headers, pipeline->current->pool);
+
+  *node_baton = make_record_baton(pipeline, TRUE, pool);
+  return flush_batch(pipeline, FALSE);
+}
+
+/* Implements svn_repos_parse_fns3_t.set_revision_property. */
+static svn_error_t *
+record_set_revision_property(void *revision_baton,
+                             const char *name,
+                             const svn_string_t *value)
+{
+  record_baton_t *rb = revision_baton;
+  pipeline_t *pipeline = rb->pipeline;
+  recorded_op_t *op = record_op(pipeline, op_set_revision_property, FALSE);
+  op->name = apr_pstrdup(pipeline->current->pool, name);
+  op->value = svn_string_dup(value, pipeline->current->pool);
+  pipeline->current->size += value->len;
+
+  return flush_batch(pipeline, FALSE);
+}
+
+/* Implements svn_repos_parse_fns3_t.set_node_property. */
+static svn_error_t *
+record_set_node_property(void *node_baton,
+                         const char *name,
+                         const svn_string_t *value)
+{
+  record_baton_t *nb = node_baton;
+  pipeline_t *pipeline = nb->pipeline;
+  recorded_op_t *op = record_op(pipeline, op_set_node_property, TRUE);
+  op->name = apr_pstrdup(pipeline->current->pool, name);
+  op->value = svn_string_dup(value, pipeline->current->pool);
+  pipeline->current->size += value->len;
+
+  return flush_batch(pipeline, FALSE);
+}
+
+/* Implements svn_repos_parse_fns3_t.delete_node_property. */
+static svn_error_t *
+record_delete_node_property(void *node_baton,
+                            const char *name)
+{
+  record_baton_t *nb = node_baton;
+  pipeline_t *pipeline = nb->pipeline;
+  recorded_op_t *op = record_op(pipeline, op_delete_node_property, TRUE);
+  op->name = apr_pstrdup(pipeline->current->pool, name);
+
+  return flush_batch(pipeline, FALSE);
+}
+
+/* Implements svn_repos_parse_fns3_t.remove_node_props. */
+static svn_error_t *
+record_remove_node_props(void *node_baton)
+{
+  record_baton_t *nb = node_baton;
+  record_op(nb->pipeline, op_remove_node_props, TRUE);
+
+  return flush_batch(nb->pipeline, FALSE);
+}
+
+/* Implements svn_write_fn_t for the streams returned by
+   record_set_fulltext. */
+static svn_error_t *
+record_write_fulltext(void *baton,
+                      const char *data,
+                      apr_size_t *len)
+{
+  record_baton_t *rb = baton;
+  pipeline_t *pipeline = rb->pipeline;
+  recorded_op_t *op = record_op(pipeline, op_write_fulltext, rb->is_node);
+  op->value = svn_string_ncreate(data, *len, pipeline->current->pool);
+  pipeline->current->size += *len;
+
+  return flush_batch(pipeline, FALSE);
+}
+
+/* Implements svn_close_fn_t for the streams returned by
+   record_set_fulltext. */
+static svn_error_t *
+record_close_fulltext(void *baton)
+{
+  record_baton_t *rb = baton;
+  record_op(rb->pipeline, op_close_fulltext, rb->is_node);
+
+  return flush_batch(rb->pipeline, FALSE);
+}
+
+/* Implements svn_repos_parse_fns3_t.set_fulltext. */
+static svn_error_t *
+record_set_fulltext(svn_stream_t **stream,
+                    void *record_baton)
+{
+  record_baton_t *rb = record_baton;
+  record_op(rb->pipeline, op_set_fulltext, rb->is_node);
+
+  *stream = svn_stream_create(rb, rb->pool);
+  svn_stream_set_write(*stream, record_write_fulltext);
+  svn_stream_set_close(*stream, record_close_fulltext);
+
+  return flush_batch(rb->pipeline, FALSE);
+}
+
+/* Implements svn_txdelta_window_handler_t for the handlers returned by
+   record_apply_textdelta. */
+static svn_error_t *
+record_apply_window(svn_txdelta_window_t *window,
+                    void *baton)
+{
+  record_baton_t *rb = baton;
+  pipeline_t *pipeline = rb->pipeline;
+  recorded_op_t *op = record_op(pipeline, op_apply_window, rb->is_node);
+
+  if (window)
+    {
+      op->window = svn_txdelta_window_dup(window, pipeline->current->pool);
+      pipeline->current->size += window->num_ops * sizeof(*window->ops);
+      if (window->new_data)
+        pipeline->current->size += window->new_data->len;
+    }
+
+  return flush_batch(pipeline, FALSE);
+}
+
+/* Implements svn_repos_parse_fns3_t.apply_textdelta. */
+static svn_error_t *
+record_apply_textdelta(svn_txdelta_window_handler_t *handler,
+                       void **handler_baton,
+                       void *record_baton)
+{
+  record_baton_t *rb = record_baton;
+  record_op(rb->pipeline, op_apply_textdelta, rb->is_node);
+
+  *handler = record_apply_window;
+  *handler_baton = rb;
+
+  return flush_batch(rb->pipeline, FALSE);
+}
+
+/* Implements svn_repos_parse_fns3_t.close_node. */
+static svn_error_t *
+record_close_node(void *node_baton)
+{
+  record_baton_t *nb = node_baton;
+  record_op(nb->pipeline, op_close_node, TRUE);
+
+  return flush_batch(nb->pipeline, FALSE);
+}
+
+/* Implements svn_repos_parse_fns3_t.close_revision.
+   Completed revisions are handed over to the consumer immediately. */
+static svn_error_t *
+record_close_revision(void *revision_baton)
+{
+  record_baton_t *rb = revision_baton;
+  record_op(rb->pipeline, op_close_revision, FALSE);
+
+  return flush_batch(rb->pipeline, TRUE);
+}
+
+/* The parser vtable used by the parser thread. */
+static const svn_repos_parse_fns3_t record_vtable =
+{
+  record_magic_header_record,
+  record_uuid_record,
+  record_new_revision_record,
+  record_new_node_record,
+  record_set_revision_property,
+  record_set_node_property,
+  record_delete_node_property,
+  record_remove_node_props,
+  record_set_fulltext,
+  record_apply_textdelta,
+  record_close_node,
+  record_close_revision
+};
+
+/* Set *ABORTED to whether the consumer of PIPELINE gave up.
+
+   This function must be called with PIPELINE->MUTEX acquired. */
+static svn_error_t *
+get_aborted(svn_boolean_t *aborted,
+            pipeline_t *pipeline)
+{
+  *aborted = pipeline->aborted;
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cancel_func_t for the parser thread.  BATON is the
+   pipeline_t.  Cancel parsing if the consumer gave up. */
+static svn_error_t *
+check_aborted(void *baton)
+{
+  pipeline_t *pipeline = baton;
+  svn_boolean_t aborted;
+
+  SVN_MUTEX__WITH_LOCK(pipeline->mutex, get_aborted(&aborted, pipeline));
+  if (aborted)
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Mark PIPELINE as finished with the parser result ERR and wake up the
+   consumer.
+
+   This function must be called with PIPELINE->MUTEX acquired. */
+static svn_error_t *
+set_finished(pipeline_t *pipeline,
+             svn_error_t *err)
+{
+  pipeline->parser_err = err;
+  pipeline->finished = TRUE;
+
+  return svn_thread_cond__signal(pipeline->batch_queued);
+}
+
+/* The plain APR thread function running the dumpstream parser.
+ * DATA is the pipeline_t object to fill. */
+static void * APR_THREAD_FUNC
+parser_thread(apr_thread_t *thread, void *data)
+{
+  pipeline_t *pipeline = data;
+
+  /* Use a separate single-threaded pool tree for minimum overhead. */
+  apr_pool_t *pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  apr_status_t result = APR_SUCCESS;
+  svn_error_t *parser_err;
+  svn_error_t *err;
+
+  parser_err = svn_repos_parse_dumpstream3(pipeline->stream, &record_vtable,
+                                           pipeline, pipeline->deltas_are_text,
+                                           check_aborted, pipeline, pool);
+
+  /* Even after a parser error, all ops recorded so far shall be passed
+     on to the consumer - just as the plain parser would have done. */
+  parser_err = svn_error_compose_create(parser_err,
+                                        flush_batch(pipeline, TRUE));
+
+  /* Hand the result over to the consumer.  This will only fail if the
+     synchronization itself fails. */
+  err = svn_mutex__lock(pipeline->mutex);
+  if (err)
+    svn_error_clear(parser_err);
+  else
+    err = svn_mutex__unlock(pipeline->mutex,
+                            set_finished(pipeline, parser_err));
+
+  if (err)
+    {
+      result = err->apr_err;
+      svn_error_clear(err);
+    }
+
+  svn_pool_destroy(pool);
+
+  /* End thread explicitly to prevent APR_INCOMPLETE return codes in
+     apr_thread_join(). */
+  apr_thread_exit(thread, result);
+  return NULL;
+}
+
+/* The consumer's counterparts of the recording batons and streams. */
+typedef struct replay_state_t
+{
+  /* Actual parser vtable and baton to pass the ops on to. */
+  const svn_repos_parse_fns3_t *parse_fns;
+  void *parse_baton;
+
+  /* Batons returned by the actual parser vtable for the current records. */
+  void *rev_baton;
+  void *node_baton;
+
+  /* Text sinks returned by the actual parser vtable.  NULL if the
+     respective data shall be discarded. */
+  svn_stream_t *text_stream;
+  svn_txdelta_window_handler_t window_handler;
+  void *window_baton;
+
+  /* The same pools that the plain parser would have used. */
+  apr_pool_t *pool;
+  apr_pool_t *revpool;
+  apr_pool_t *nodepool;
+} replay_state_t;
+
+/* Pass OP on to the actual parser vtable in STATE. */
+static svn_error_t *
+replay_op(replay_state_t *state,
+          const recorded_op_t *op)
+{
+  const svn_repos_parse_fns3_t *parse_fns = state->parse_fns;
+  void *record_baton = op->is_node ? state->node_baton : state->rev_baton;
+  apr_size_t len;
+
+  switch (op->kind)
+    {
+      case op_magic_header_record:
+        if (parse_fns->magic_header_record != NULL)
+          SVN_ERR(parse_fns->magic_header_record(op->version,
+                                                 state->parse_baton,
+                                                 state->pool));
+        break;
+
+      case op_uuid_record:
+        SVN_ERR(parse_fns->uuid_record(op->name, state->parse_baton,
+                                       state->pool));
+        break;
+
+      case op_new_revision_record:
+        SVN_ERR(parse_fns->new_revision_record(&state->rev_baton,
+                                               copy_headers(op->headers,
+                                                            state->revpool),
+                                               state->parse_baton,
+                                               state->revpool));
+        break;
+
+      case op_new_node_record:
+        SVN_ERR(parse_fns->new_node_record(&state->node_baton,
+                                           copy_headers(op->headers,
+                                                        state->nodepool),
+                                           state->rev_baton,
+                                           state->nodepool));
+        break;
+
+      case op_set_revision_property:
+        SVN_ERR(parse_fns->set_revision_property(record_baton, op->name,
+                                                 op->value));
+        break;
+
+      case op_set_node_property:
+        SVN_ERR(parse_fns->set_node_property(record_baton, op->name,
+                                             op->value));
+        break;
+
+      case op_delete_node_property:
+        SVN_ERR(parse_fns->delete_node_property(record_baton, op->name));
+        break;
+
+      case op_remove_node_props:
+        SVN_ERR(parse_fns->remove_node_props(record_baton));
+        break;
+
+      case op_set_fulltext:
+        SVN_ERR(parse_fns->set_fulltext(&state->text_stream, record_baton));
+        break;
+
+      case op_write_fulltext:
+        if (state->text_stream)
+          {
+            len = op->value->len;
+            SVN_ERR(svn_stream_write(state->text_stream, op->value->data,
+                                     &len));
+            if (len != op->value->len)
+              return svn_error_create(SVN_ERR_STREAM_UNEXPECTED_EOF, NULL,
+                                      _("Unexpected EOF writing contents"));
+          }
+        break;
+
+      case op_close_fulltext:
+        if (state->text_stream)
+          SVN_ERR(svn_stream_close(state->text_stream));
+        state->text_stream = NULL;
+        break;
+
+      case op_apply_textdelta:
+        SVN_ERR(parse_fns->apply_textdelta(&state->window_handler,
+                                           &state->window_baton,
+                                           record_baton));
+        break;
+
+      case op_apply_window:
+        if (state->window_handler)
+          SVN_ERR(state->window_handler(op->window, state->window_baton));
+        if (op->window == NULL)
+          state->window_handler = NULL;
+        break;
+
+      case op_close_node:
+        SVN_ERR(parse_fns->close_node(record_baton));
+        svn_pool_clear(state->nodepool);
+        break;
+
+      case op_close_revision:
+        SVN_ERR(parse_fns->close_revision(record_baton));
+        svn_pool_clear(state->revpool);
+        break;
+
+      default:
+        SVN_ERR_MALFUNCTION();
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *BATCH to the next batch queued in PIPELINE, waiting for the parser
+   thread as necessary.  Set *BATCH to NULL if the parser has finished and
+   all batches have been taken.
+
+   This function must be called with PIPELINE->MUTEX acquired. */
+static svn_error_t *
+dequeue_batch(op_batch_t **batch,
+              pipeline_t *pipeline)
+{
+  while (pipeline->first_queued == NULL && !pipeline->finished)
+    SVN_ERR(svn_thread_cond__wait(pipeline->batch_queued, pipeline->mutex));
+
+  *batch = pipeline->first_queued;
+  if (*batch == NULL)
+    return SVN_NO_ERROR;
+
+  pipeline->first_queued = (*batch)->next;
+  if (pipeline->first_queued == NULL)
+    pipeline->last_queued = NULL;
+  --pipeline->queue_length;
+
+  return svn_thread_cond__signal(pipeline->batch_taken);
+}
+
+/* Tell the parser thread in PIPELINE that we gave up.
+
+   This function must be called with PIPELINE->MUTEX acquired. */
+static svn_error_t *
+set_aborted(pipeline_t *pipeline)
+{
+  pipeline->aborted = TRUE;
+  return svn_thread_cond__broadcast(pipeline->batch_taken);
+}
+
+#endif /* APR_HAS_THREADS */
+
+svn_error_t *
+svn_repos__parse_dumpstream_pipelined(svn_stream_t *stream,
+                                      const svn_repos_parse_fns3_t *parse_fns,
+                                      void *parse_baton,
+                                      svn_boolean_t deltas_are_text,
+                                      svn_cancel_func_t cancel_func,
+                                      void *cancel_baton,
+                                      apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+
+  pipeline_t *pipeline = apr_pcalloc(pool, sizeof(*pipeline));
+  replay_state_t state = { 0 };
+  op_batch_t *batch;
+  apr_thread_t *thread;
+  apr_status_t status;
+  apr_status_t retval;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  /* The thread object can't share the allocator with POOL. */
+  apr_pool_t *thread_pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+
+  pipeline->stream = stream;
+  pipeline->deltas_are_text = deltas_are_text;
+  SVN_ERR(svn_mutex__init(&pipeline->mutex, TRUE, pool));
+  SVN_ERR(svn_thread_cond__create(&pipeline->batch_queued, pool));
+  SVN_ERR(svn_thread_cond__create(&pipeline->batch_taken, pool));
+
+  state.parse_fns = complete_vtable(parse_fns, pool);
+  state.parse_baton = parse_baton;
+  state.pool = pool;
+  state.revpool = svn_pool_create(pool);
+  state.nodepool = svn_pool_create(pool);
+
+  status = apr_thread_create(&thread, NULL, parser_thread, pipeline,
+                             thread_pool);
+  if (status)
+    {
+      svn_pool_destroy(thread_pool);
+      return svn_error_wrap_apr(status, _("Can't create parser thread"));
+    }
+
+  /* Replay all batches in order until the parser finished or we fail. */
+  while (!err)
+    {
+      const recorded_op_t *op;
+
+      if (cancel_func)
+        err = cancel_func(cancel_baton);
+      if (err)
+        break;
+
+      err = svn_mutex__lock(pipeline->mutex);
+      if (err)
+        break;
+
+      err = svn_mutex__unlock(pipeline->mutex,
+                              dequeue_batch(&batch, pipeline));
+      if (err || batch == NULL)
+        break;
+
+      for (op = batch->first; op && !err; op = op->next)
+        err = replay_op(&state, op);
+
+      svn_pool_destroy(batch->pool);
+    }
+
+  /* Make the parser thread terminate early. */
+  if (err)
+    {
+      svn_error_t *sync_err = svn_mutex__lock(pipeline->mutex);
+      if (!sync_err)
+        sync_err = svn_mutex__unlock(pipeline->mutex,
+                                     set_aborted(pipeline));
+
+      err = svn_error_compose_create(err, sync_err);
+    }
+
+  status = apr_thread_join(&retval, thread);
+  if (status)
+    err = svn_error_compose_create(err,
+                                   svn_error_wrap_apr(status,
+                                       _("Can't join parser thread")));
+  else if (retval)
+    err = svn_error_compose_create(err,
+                                   svn_error_wrap_apr(retval,
+                                       _("Parser thread returned error")));
+
+  /* The parser thread has terminated.  Release whatever it left behind. */
+  for (batch = pipeline->first_queued; batch; )
+    {
+      op_batch_t *next = batch->next;
+      svn_pool_destroy(batch->pool);
+      batch = next;
+    }
+
+  /* Without errors on our side, the parser result is the overall result.
+     Otherwise, parser errors are most likely just the reaction to us
+     aborting the pipeline. */
+  if (err)
+    svn_error_clear(pipeline->parser_err);
+  else
+    err = pipeline->parser_err;
+
+  svn_pool_destroy(state.revpool);
+  svn_pool_destroy(state.nodepool);
+  svn_pool_destroy(thread_pool);
+
+  return svn_error_trace(err);
+
+#else
+
+  return svn_error_trace(svn_repos_parse_dumpstream3(stream, parse_fns,
+                                                     parse_baton,
+                                                     deltas_are_text,
+                                                     cancel_func,
+                                                     cancel_baton, pool));
+
+#endif
+}
@@ -22,12 +22,14 @@
 
 
 #include <stdlib.h>
+#include <apr_thread_proc.h>
 #define APR_WANT_STRFUNC
 #include <apr_want.h>
 
 #include "svn_compat.h"
 #include "svn_private_config.h"
 #include "svn_hash.h"
+#include "svn_io.h"
 #include "svn_pools.h"
 #include "svn_error.h"
 #include "svn_path.h"
@@ -38,12 +40,16 @@
 #include "svn_props.h"
 #include "svn_mergeinfo.h"
 #include "repos.h"
+#include "private/svn_dirent_uri_private.h"
 #include "private/svn_fspath.h"
 #include "private/svn_fs_private.h"
 #include "private/svn_mergeinfo_private.h"
+#include "private/svn_mutex.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
+#include "private/svn_thread_cond.h"
 
 
 /* This is a mere convenience struct such that we don't need to pass that
@@ -56,6 +62,9 @@ typedef struct log_callbacks_t
   void *revision_receiver_baton;
   svn_repos_authz_func_t authz_read_func;
   void *authz_read_baton;
+
+  /* The repository that all the FS parameters belong to. */
+  svn_repos_t *repos;
 } log_callbacks_t;
 
 
@@ -231,18 +240,22 @@ svn_repos_check_revision_access(svn_repos_revision_access_level_t *access_level,
  * (and copyfrom_path) is readable:
  *
  *     - If absolutely every changed-path (and copyfrom_path) is
- *     readable, then return the full CHANGED hash, and set
- *     *ACCESS_LEVEL to svn_repos_revision_access_full.
+ *     readable, then report all changes, and set *ACCESS_LEVEL to
+ *     svn_repos_revision_access_full.
  *
  *     - If some paths are readable and some are not, then silently
- *     omit the unreadable paths from the CHANGED hash, and set
+ *     omit the unreadable paths from the report, and set
  *     *ACCESS_LEVEL to svn_repos_revision_access_partial.
  *
  *     - If absolutely every changed-path (and copyfrom_path) is
- *     unreadable, then return an empty CHANGED hash, and set
- *     *ACCESS_LEVEL to svn_repos_revision_access_none.  (This is
- *     to distinguish a revision which truly has no changed paths
- *     from a revision in which all paths are unreadable.)
+ *     unreadable, then report nothing, and set *ACCESS_LEVEL to
+ *     svn_repos_revision_access_none.  (This is to distinguish a
+ *     revision which truly has no changed paths from a revision in
+ *     which all paths are unreadable.)
+ *
+ * Changes are passed on one by one as the FS iterator delivers them and
+ * never get collected, so memory usage does not depend on the number of
+ * changes in the revision.
  */
 static svn_error_t *
 detect_changed(svn_repos_revision_access_level_t *access_level,
@@ -288,6 +301,12 @@ detect_changed(svn_repos_revision_access_level_t *access_level,
           if (! readable)
             {
               found_unreadable = TRUE;
+
+              /* Without a receiver, only the access level matters and
+                 it cannot change anymore. */
+              if (found_readable && !callbacks->path_change_receiver)
+                break;
+
               SVN_ERR(svn_fs_path_change_get(&change, iterator));
               continue;
             }
@@ -295,6 +314,8 @@ detect_changed(svn_repos_revision_access_level_t *access_level,
 
       /* At least one changed-path was readable. */
       found_readable = TRUE;
+      if (found_unreadable && !callbacks->path_change_receiver)
+        break;
 
       /* Pre-1.6 revision files don't store the change path kind, so fetch
          it manually. */
@@ -423,8 +444,475 @@ struct path_info
   svn_fs_history_t *hist;
   apr_pool_t *newpool;
   apr_pool_t *oldpool;
+
+  /* If not NULL, a history thread fetches the history of this path and
+     WALK_INDEX is the index of the path within the walk.  HIST is NULL
+     then. */
+  struct history_walk_t *walk;
+  int walk_index;
 };
 
+
+/* --- FETCHING PATH HISTORIES IN PARALLEL --- */
+
+/* Number of history steps that a history thread may fetch ahead of
+   do_logs() for each path. */
+#define HISTORY_QUEUE_SIZE 64
+
+#if APR_HAS_THREADS
+
+/* Steps of one path's history, fetched by a history thread and waiting
+   to be taken by do_logs(). */
+typedef struct history_queue_t
+{
+  /* Ring buffer of COUNT steps starting at index FIRST. */
+  svn_revnum_t revisions[HISTORY_QUEUE_SIZE];
+  svn_stringbuf_t *paths[HISTORY_QUEUE_SIZE];
+  int first;
+  int count;
+
+  /* Set once the history thread will not queue any more steps. */
+  svn_boolean_t finished;
+
+  /* The error that ended the history, if any.  do_logs() gets it after
+     all queued steps. */
+  svn_error_t *err;
+} history_queue_t;
+
+/* One of the history threads. */
+typedef struct history_thread_t
+{
+  struct history_walk_t *walk;
+
+  /* This thread fetches the histories of all paths whose index modulo the
+     number of threads is INDEX. */
+  int index;
+
+  /* The thread and the pool it got allocated in. */
+  apr_thread_t *thread;
+  apr_pool_t *pool;
+} history_thread_t;
+
+/* State shared between do_logs() and the history threads. */
+typedef struct history_walk_t
+{
+  /* Serializes access to the QUEUES, QUEUE_POOL and SHUTDOWN. */
+  svn_mutex__t *mutex;
+
+  /* Signaled when a step has been queued or a queue has finished. */
+  svn_thread_cond__t *step_queued;
+
+  /* Signaled when a step has been taken or the threads shall terminate. */
+  svn_thread_cond__t *step_taken;
+
+  /* One queue per path and the pool to allocate their paths in. */
+  history_queue_t *queues;
+  apr_pool_t *queue_pool;
+
+  /* Set by do_logs() to make the history threads terminate. */
+  svn_boolean_t shutdown;
+
+  /* The histories to fetch, from HIST_END back to HIST_START.
+     Read-only. */
+  const apr_array_header_t *paths;
+  svn_revnum_t hist_start;
+  svn_revnum_t hist_end;
+  svn_boolean_t strict;
+
+  /* Repository to open in the history threads.  Read-only. */
+  const char *repos_path;
+  apr_hash_t *fs_config;
+
+  /* The history threads. */
+  history_thread_t *threads;
+  int thread_count;
+} history_walk_t;
+
+/* A history thread's view of one path's history.  The pools get swapped
+   after each step, like those of path_info. */
+typedef struct history_walker_t
+{
+  svn_fs_root_t *root;
+  svn_fs_history_t *hist;
+  apr_pool_t *newpool;
+  apr_pool_t *oldpool;
+} history_walker_t;
+
+/* Fetch the next step of the history of path number I in WALK, using the
+   repository FS and the state W of that history.  Set *REVISION and *PATH
+   to its location, or *REVISION to SVN_INVALID_REVNUM if there is no more
+   history at or after WALK->HIST_START.  Allocate W's members in
+   RESULT_POOL and *PATH in W's pools.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+walk_history_step(svn_revnum_t *revision,
+                  const char **path,
+                  history_walker_t *w,
+                  svn_fs_t *fs,
+                  const history_walk_t *walk,
+                  int i,
+                  apr_pool_t *result_pool,
+                  apr_pool_t *scratch_pool)
+{
+  apr_pool_t *temppool;
+
+  if (!w->root)
+    {
+      w->newpool = svn_pool_create(result_pool);
+      w->oldpool = svn_pool_create(result_pool);
+
+      SVN_ERR(svn_fs_revision_root(&w->root, fs, walk->hist_end,
+                                   result_pool));
+      SVN_ERR(svn_fs_node_history2(&w->hist, w->root,
+                                   APR_ARRAY_IDX(walk->paths, i,
+                                                 const char *),
+                                   result_pool, scratch_pool));
+    }
+
+  *revision = SVN_INVALID_REVNUM;
+  if (!w->hist)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_history_prev2(&w->hist, w->hist, ! walk->strict,
+                               w->newpool, scratch_pool));
+  if (!w->hist)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_history_location(path, revision, w->hist, w->newpool));
+  if (*revision < walk->hist_start)
+    {
+      *revision = SVN_INVALID_REVNUM;
+      w->hist = NULL;
+    }
+
+  temppool = w->oldpool;
+  w->oldpool = w->newpool;
+  svn_pool_clear(temppool);
+  w->newpool = temppool;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *I to the index of a path in WALK that history thread THREAD_INDEX
+   shall fetch the next step for, waiting until one of its queues has room.
+   If the thread shall terminate instead, set *I to -1.  Call this only
+   while holding the mutex of WALK. */
+static svn_error_t *
+next_path(int *i,
+          history_walk_t *walk,
+          int thread_index)
+{
+  while (!walk->shutdown)
+    {
+      svn_boolean_t pending = FALSE;
+      int k;
+
+      for (k = thread_index; k < walk->paths->nelts; k += walk->thread_count)
+        {
+          history_queue_t *queue = &walk->queues[k];
+          if (queue->finished)
+            continue;
+
+          pending = TRUE;
+          if (queue->count < HISTORY_QUEUE_SIZE)
+            {
+              *i = k;
+              return SVN_NO_ERROR;
+            }
+        }
+
+      if (!pending)
+        break;
+
+      SVN_ERR(svn_thread_cond__wait(walk->step_taken, walk->mutex));
+    }
+
+  *i = -1;
+
+  return SVN_NO_ERROR;
+}
+
+/* Add the step at REVISION and PATH to the queue of path number I in WALK
+   or, if REVISION is not valid or STEP_ERR is set, finish that queue with
+   STEP_ERR.  Call this only while holding the mutex of WALK. */
+static svn_error_t *
+queue_step(history_walk_t *walk,
+           int i,
+           svn_revnum_t revision,
+           const char *path,
+           svn_error_t *step_err)
+{
+  history_queue_t *queue = &walk->queues[i];
+
+  if (step_err || !SVN_IS_VALID_REVNUM(revision))
+    {
+      queue->finished = TRUE;
+      queue->err = step_err;
+    }
+  else
+    {
+      int slot = (queue->first + queue->count) % HISTORY_QUEUE_SIZE;
+
+      if (queue->paths[slot])
+        svn_stringbuf_set(queue->paths[slot], path);
+      else
+        queue->paths[slot] = svn_stringbuf_create(path, walk->queue_pool);
+
+      queue->revisions[slot] = revision;
+      queue->count++;
+    }
+
+  return svn_error_trace(svn_thread_cond__broadcast(walk->step_queued));
+}
+
+/* The plain APR thread function fetching path histories.  DATA is the
+   history_thread_t describing what to fetch. */
+static void * APR_THREAD_FUNC
+history_thread(apr_thread_t *thread, void *data)
+{
+  history_thread_t *t = data;
+  history_walk_t *walk = t->walk;
+
+  /* Use a separate single-threaded pool tree for minimum overhead. */
+  apr_pool_t *pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  history_walker_t *walkers = apr_pcalloc(pool, walk->paths->nelts
+                                                * sizeof(*walkers));
+  apr_status_t result = APR_SUCCESS;
+  svn_repos_t *repos;
+  svn_error_t *open_err;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  /* FS objects must not be shared between threads, so open our own.
+     If that fails, all our histories fail with that error. */
+  open_err = svn_repos_open3(&repos, walk->repos_path, walk->fs_config,
+                             pool, pool);
+
+  while (!err)
+    {
+      svn_revnum_t revision = SVN_INVALID_REVNUM;
+      const char *path = NULL;
+      svn_error_t *step_err;
+      int i;
+
+      err = svn_mutex__lock(walk->mutex);
+      if (!err)
+        err = svn_mutex__unlock(walk->mutex,
+                                next_path(&i, walk, t->index));
+      if (err || i < 0)
+        break;
+
+      svn_pool_clear(iterpool);
+      if (open_err)
+        step_err = svn_error_dup(open_err);
+      else
+        step_err = walk_history_step(&revision, &path, &walkers[i],
+                                     svn_repos_fs(repos), walk, i,
+                                     pool, iterpool);
+
+      err = svn_mutex__lock(walk->mutex);
+      if (!err)
+        err = svn_mutex__unlock(walk->mutex,
+                                queue_step(walk, i, revision, path,
+                                           step_err));
+    }
+
+  if (err)
+    {
+      result = err->apr_err;
+      svn_error_clear(err);
+    }
+
+  svn_error_clear(open_err);
+  svn_pool_destroy(pool);
+
+  /* End thread explicitly to prevent APR_INCOMPLETE return codes in
+     apr_thread_join(). */
+  apr_thread_exit(thread, result);
+  return NULL;
+}
+
+/* Make the history threads of WALK terminate.  Call this only while
+   holding the mutex of WALK. */
+static svn_error_t *
+set_shutdown(history_walk_t *walk)
+{
+  walk->shutdown = TRUE;
+
+  return svn_error_trace(svn_thread_cond__broadcast(walk->step_taken));
+}
+
+/* Pool cleanup function terminating the history threads of the
+   history_walk_t DATA and releasing the steps they fetched. */
+static apr_status_t
+stop_history_walk(void *data)
+{
+  history_walk_t *walk = data;
+  svn_error_t *err;
+  int i;
+
+  err = svn_mutex__lock(walk->mutex);
+  if (!err)
+    err = svn_mutex__unlock(walk->mutex, set_shutdown(walk));
+  svn_error_clear(err);
+
+  for (i = 0; i < walk->thread_count; ++i)
+    {
+      history_thread_t *t = &walk->threads[i];
+      apr_status_t retval;
+
+      if (!t->thread)
+        continue;
+
+      apr_thread_join(&retval, t->thread);
+      svn_pool_destroy(t->pool);
+    }
+
+  for (i = 0; i < walk->paths->nelts; ++i)
+    svn_error_clear(walk->queues[i].err);
+
+  svn_pool_destroy(walk->queue_pool);
+
+  return APR_SUCCESS;
+}
+
+/* Start up to THREAD_COUNT history threads fetching the histories of
+   PATHS in REPOS from HIST_END back to HIST_START.  STRICT is as for
+   get_history().  Return their state in *WALK, allocated in POOL.  The
+   threads terminate when POOL gets cleared. */
+static svn_error_t *
+start_history_walk(history_walk_t **walk_p,
+                   svn_repos_t *repos,
+                   const apr_array_header_t *paths,
+                   svn_revnum_t hist_start,
+                   svn_revnum_t hist_end,
+                   svn_boolean_t strict,
+                   int thread_count,
+                   apr_pool_t *pool)
+{
+  history_walk_t *walk = apr_pcalloc(pool, sizeof(*walk));
+  int i;
+
+  walk->paths = paths;
+  walk->hist_start = hist_start;
+  walk->hist_end = hist_end;
+  walk->strict = strict;
+  walk->repos_path = svn_repos_path(repos, pool);
+  walk->fs_config = repos->log_fs_config;
+  walk->thread_count = MIN(thread_count, paths->nelts);
+  walk->queues = apr_pcalloc(pool, paths->nelts * sizeof(*walk->queues));
+  walk->threads = apr_pcalloc(pool,
+                              walk->thread_count * sizeof(*walk->threads));
+  walk->queue_pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  SVN_ERR(svn_mutex__init(&walk->mutex, TRUE, pool));
+  SVN_ERR(svn_thread_cond__create(&walk->step_queued, pool));
+  SVN_ERR(svn_thread_cond__create(&walk->step_taken, pool));
+
+  /* Registered after the mutex, so this runs before the mutex gets
+     destroyed. */
+  apr_pool_cleanup_register(pool, walk, stop_history_walk,
+                            apr_pool_cleanup_null);
+
+  for (i = 0; i < walk->thread_count; ++i)
+    {
+      history_thread_t *t = &walk->threads[i];
+      apr_status_t status;
+
+      t->walk = walk;
+      t->index = i;
+
+      /* The thread object can't share the allocator with POOL. */
+      t->pool = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+      status = apr_thread_create(&t->thread, NULL, history_thread, t,
+                                 t->pool);
+      if (status)
+        {
+          svn_pool_destroy(t->pool);
+          t->thread = NULL;
+
+          /* Without that thread, some paths would never get any history. */
+          apr_pool_cleanup_run(pool, walk, stop_history_walk);
+          return svn_error_wrap_apr(status, _("Can't create history thread"));
+        }
+    }
+
+  *walk_p = walk;
+
+  return SVN_NO_ERROR;
+}
+
+/* Move the next step of INFO's history from its queue into INFO or, if
+   there is none, set INFO->DONE and return the error that ended the
+   history in *STEP_ERR.  Call this only while holding the mutex of
+   INFO->WALK. */
+static svn_error_t *
+take_step(svn_error_t **step_err,
+          struct path_info *info)
+{
+  history_walk_t *walk = info->walk;
+  history_queue_t *queue = &walk->queues[info->walk_index];
+
+  while (!queue->count && !queue->finished)
+    SVN_ERR(svn_thread_cond__wait(walk->step_queued, walk->mutex));
+
+  if (!queue->count)
+    {
+      info->done = TRUE;
+      *step_err = queue->err;
+      queue->err = SVN_NO_ERROR;
+
+      return SVN_NO_ERROR;
+    }
+
+  info->history_rev = queue->revisions[queue->first];
+  svn_stringbuf_set(info->path, queue->paths[queue->first]->data);
+  queue->first = (queue->first + 1) % HISTORY_QUEUE_SIZE;
+  queue->count--;
+
+  return svn_error_trace(svn_thread_cond__broadcast(walk->step_taken));
+}
+
+/* Like get_history() but take the next step from the queue of INFO's
+   history thread. */
+static svn_error_t *
+get_queued_history(struct path_info *info,
+                   svn_fs_t *fs,
+                   svn_repos_authz_func_t authz_read_func,
+                   void *authz_read_baton,
+                   apr_pool_t *scratch_pool)
+{
+  svn_error_t *step_err = SVN_NO_ERROR;
+  svn_error_t *err;
+
+  err = svn_mutex__lock(info->walk->mutex);
+  if (!err)
+    err = svn_mutex__unlock(info->walk->mutex, take_step(&step_err, info));
+  SVN_ERR(svn_error_compose_create(step_err, err));
+
+  if (info->done)
+    return SVN_NO_ERROR;
+
+  /* Is the history item readable?  If not, done with path.  Only this
+     thread may call the authz callback. */
+  if (authz_read_func)
+    {
+      svn_fs_root_t *history_root;
+      svn_boolean_t readable;
+
+      SVN_ERR(svn_fs_revision_root(&history_root, fs, info->history_rev,
+                                   scratch_pool));
+      SVN_ERR(authz_read_func(&readable, history_root, info->path->data,
+                              authz_read_baton, scratch_pool));
+      if (! readable)
+        info->done = TRUE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
 /* Advance to the next history for the path.
  *
  * If INFO->HIST is not NULL we do this using that existing history object,
@@ -456,6 +944,13 @@ get_history(struct path_info *info,
   apr_pool_t *subpool;
   const char *path;
 
+#if APR_HAS_THREADS
+  if (info->walk)
+    return svn_error_trace(get_queued_history(info, fs, authz_read_func,
+                                              authz_read_baton,
+                                              scratch_pool));
+#endif
+
   if (info->hist)
     {
       subpool = info->newpool;
@@ -887,6 +1382,8 @@ get_combined_mergeinfo_changes(svn_mergeinfo_t *added_mergeinfo,
   apr_pool_t *iterpool;
   int i;
   svn_error_t *err;
+  svn_relpath__intern_pool_t *interned;
+  const svn_relpath__interned_t **interned_paths;
 
   /* Initialize return value. */
   *added_mergeinfo = svn_hash__make(result_pool);
@@ -1056,6 +1553,16 @@ get_combined_mergeinfo_changes(svn_mergeinfo_t *added_mergeinfo,
                                    result_pool, iterpool));
      }
 
+  /* Intern our paths of interest, so the ancestry checks below don't
+     need to compare strings. */
+  interned = svn_relpath__intern_pool_create(scratch_pool);
+  interned_paths = apr_palloc(scratch_pool,
+                              paths->nelts * sizeof(*interned_paths));
+  for (i = 0; i < paths->nelts; i++)
+    interned_paths[i]
+      = svn_relpath__intern(interned,
+                            APR_ARRAY_IDX(paths, i, const char *) + 1);
+
   /* Merge all the mergeinfos which are, or are children of, one of
      our paths of interest into one giant delta mergeinfo.  */
   for (hi = apr_hash_first(scratch_pool, added_mergeinfo_catalog);
@@ -1065,11 +1572,13 @@ get_combined_mergeinfo_changes(svn_mergeinfo_t *added_mergeinfo,
       apr_ssize_t klen = apr_hash_this_key_len(hi);
       svn_mergeinfo_t added = apr_hash_this_val(hi);
       svn_mergeinfo_t deleted;
+      const svn_relpath__interned_t *interned_changed_path
+        = svn_relpath__intern(interned, changed_path + 1);
 
       for (i = 0; i < paths->nelts; i++)
         {
-          const char *path = APR_ARRAY_IDX(paths, i, const char *);
-          if (! svn_fspath__skip_ancestor(path, changed_path))
+          if (! svn_relpath__interned_is_ancestor(interned_paths[i],
+                                                  interned_changed_path))
             continue;
           svn_pool_clear(iterpool);
           deleted = apr_hash_get(deleted_mergeinfo_catalog, changed_path, klen);
@@ -1313,6 +1822,8 @@ send_log(svn_revnum_t rev,
 
   interesting_merge_baton_t baton;
 
+  SVN_ERR(svn_repos__sched_checkpoint(callbacks->repos));
+
   /* Is REV a merged revision that is already part of
      LOG_TARGET_HISTORY_AS_MERGEINFO?  If so then there is no
      need to send it, since it already was (or will be) sent.
@@ -1383,10 +1894,15 @@ send_log(svn_revnum_t rev,
 
 /* Get the histories for PATHS, and store them in *HISTORIES.
 
+   If REPOS has been configured to use log threads, fetch up to
+   MAX_OPEN_HISTORIES histories in parallel.  REPOS must be the repository
+   of FS.
+
    If IGNORE_MISSING_LOCATIONS is set, don't treat requests for bogus
    repository locations as fatal -- just ignore them.  */
 static svn_error_t *
 get_path_histories(apr_array_header_t **histories,
+                   svn_repos_t *repos,
                    svn_fs_t *fs,
                    const apr_array_header_t *paths,
                    svn_revnum_t hist_start,
@@ -1400,6 +1916,7 @@ get_path_histories(apr_array_header_t **histories,
   svn_fs_root_t *root;
   apr_pool_t *iterpool;
   svn_error_t *err;
+  struct history_walk_t *walk = NULL;
   int i;
 
   /* Create a history object for each path so we can walk through
@@ -1415,6 +1932,16 @@ get_path_histories(apr_array_header_t **histories,
 
   SVN_ERR(svn_fs_revision_root(&root, fs, hist_end, pool));
 
+#if APR_HAS_THREADS
+  /* A single path would not gain enough to pay for the thread. */
+  if (   repos->log_threads > 0
+      && paths->nelts > 1
+      && paths->nelts <= MAX_OPEN_HISTORIES)
+    SVN_ERR(start_history_walk(&walk, repos, paths, hist_start, hist_end,
+                               strict_node_history, repos->log_threads,
+                               pool));
+#endif
+
   iterpool = svn_pool_create(pool);
   for (i = 0; i < paths->nelts; i++)
     {
@@ -1436,8 +1963,16 @@ get_path_histories(apr_array_header_t **histories,
       info->done = FALSE;
       info->history_rev = hist_end;
       info->first_time = TRUE;
+      info->walk = walk;
+      info->walk_index = i;
 
-      if (i < MAX_OPEN_HISTORIES)
+      if (walk)
+        {
+          info->hist = NULL;
+          info->oldpool = NULL;
+          info->newpool = NULL;
+        }
+      else if (i < MAX_OPEN_HISTORIES)
         {
           err = svn_fs_node_history2(&info->hist, root, this_path, pool,
                                      iterpool);
@@ -1815,14 +2350,157 @@ handle_merged_revisions(svn_revnum_t rev,
                                         &empty_log_entry, pool);
 }
 
-/* This is used by do_logs to differentiate between forward and
-   reverse merges. */
-struct added_deleted_mergeinfo
+/* When sending logs in ascending order, do_logs has to buffer the
+   mergeinfo deltas of all revisions in the range before it can send the
+   first one.  To keep memory usage bounded, they get appended to a
+   temporary file instead, and read back one revision at a time.
+
+   This is the bookkeeping of one revision buffered that way. */
+struct buffered_rev
 {
-  svn_mergeinfo_t added_mergeinfo;
-  svn_mergeinfo_t deleted_mergeinfo;
+  svn_revnum_t revision;
+
+  /* Offset of the added and deleted mergeinfo of REVISION within the
+     temporary file, or -1 if none got written. */
+  apr_off_t mergeinfo_offset;
 };
 
+/* Append MERGEINFO to BUF, one line per path.  Each line lists the ranges
+   as START and END revision, followed by '*' for non-inheritable ranges,
+   and finally the path.  Terminate the list with an empty line. */
+static void
+serialize_mergeinfo(svn_stringbuf_t *buf,
+                    svn_mergeinfo_t mergeinfo,
+                    apr_pool_t *scratch_pool)
+{
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(scratch_pool, mergeinfo);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *path = apr_hash_this_key(hi);
+      svn_rangelist_t *rangelist = apr_hash_this_val(hi);
+      int i;
+
+      for (i = 0; i < rangelist->nelts; i++)
+        {
+          svn_merge_range_t *range
+            = APR_ARRAY_IDX(rangelist, i, svn_merge_range_t *);
+
+          svn_stringbuf_appendcstr(buf,
+                                   apr_psprintf(scratch_pool, "%ld %ld%s ",
+                                                range->start, range->end,
+                                                range->inheritable
+                                                  ? "" : "*"));
+        }
+
+      svn_stringbuf_appendcstr(buf, path);
+      svn_stringbuf_appendbyte(buf, '\n');
+    }
+
+  svn_stringbuf_appendbyte(buf, '\n');
+}
+
+/* Read mergeinfo as written by serialize_mergeinfo() from STREAM and
+   return it in *MERGEINFO.  Allocate the result in RESULT_POOL. */
+static svn_error_t *
+read_mergeinfo(svn_mergeinfo_t *mergeinfo,
+               svn_stream_t *stream,
+               apr_pool_t *result_pool)
+{
+  *mergeinfo = svn_hash__make(result_pool);
+
+  while (TRUE)
+    {
+      svn_stringbuf_t *line;
+      svn_boolean_t eof;
+      svn_rangelist_t *rangelist;
+      const char *p;
+
+      SVN_ERR(svn_stream_readline(stream, &line, "\n", &eof, result_pool));
+      if (line->len == 0)
+        break;
+
+      rangelist = apr_array_make(result_pool, 1, sizeof(svn_merge_range_t *));
+      for (p = line->data; *p != '/'; ++p)
+        {
+          svn_merge_range_t *range = apr_palloc(result_pool, sizeof(*range));
+
+          SVN_ERR(svn_revnum_parse(&range->start, p, &p));
+          if (*p != ' ')
+            return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                    _("Corrupt buffered mergeinfo"));
+
+          SVN_ERR(svn_revnum_parse(&range->end, p + 1, &p));
+          range->inheritable = (*p != '*');
+          if (! range->inheritable)
+            ++p;
+
+          if (*p != ' ')
+            return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                    _("Corrupt buffered mergeinfo"));
+
+          APR_ARRAY_PUSH(rangelist, svn_merge_range_t *) = range;
+        }
+
+      svn_hash_sets(*mergeinfo, p, rangelist);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Append ADDED_MERGEINFO and DELETED_MERGEINFO to the temporary file
+   *FILE of size *FILE_SIZE and set *OFFSET to where they start.  If *FILE
+   is NULL, create it in RESULT_POOL first.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+spill_mergeinfo(apr_off_t *offset,
+                apr_file_t **file,
+                apr_off_t *file_size,
+                svn_mergeinfo_t added_mergeinfo,
+                svn_mergeinfo_t deleted_mergeinfo,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *buf = svn_stringbuf_create_empty(scratch_pool);
+
+  if (! *file)
+    SVN_ERR(svn_io_open_unique_file3(file, NULL, NULL,
+                                     svn_io_file_del_on_pool_cleanup,
+                                     result_pool, scratch_pool));
+
+  serialize_mergeinfo(buf, added_mergeinfo, scratch_pool);
+  serialize_mergeinfo(buf, deleted_mergeinfo, scratch_pool);
+  SVN_ERR(svn_io_file_write_full(*file, buf->data, buf->len, NULL,
+                                 scratch_pool));
+
+  *offset = *file_size;
+  *file_size += buf->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the added and deleted mergeinfo written by spill_mergeinfo() at
+   OFFSET in FILE back into *ADDED_MERGEINFO and *DELETED_MERGEINFO.
+   Allocate the result in RESULT_POOL. */
+static svn_error_t *
+unspill_mergeinfo(svn_mergeinfo_t *added_mergeinfo,
+                  svn_mergeinfo_t *deleted_mergeinfo,
+                  apr_file_t *file,
+                  apr_off_t offset,
+                  apr_pool_t *result_pool)
+{
+  svn_stream_t *stream;
+
+  SVN_ERR(svn_io_file_seek(file, APR_SET, &offset, result_pool));
+  stream = svn_stream_from_aprfile2(file, TRUE, result_pool);
+  SVN_ERR(read_mergeinfo(added_mergeinfo, stream, result_pool));
+  SVN_ERR(read_mergeinfo(deleted_mergeinfo, stream, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Reduce the search range PATHS, HIST_START, HIST_END by removing
    parts already covered by PROCESSED.  If reduction is possible
    elements may be removed from PATHS and *START_REDUCED and
@@ -1980,8 +2658,10 @@ do_logs(svn_fs_t *fs,
 {
   apr_pool_t *iterpool, *iterpool2;
   apr_pool_t *subpool = NULL;
+  apr_pool_t *histories_pool;
   apr_array_header_t *revs = NULL;
-  apr_hash_t *rev_mergeinfo = NULL;
+  apr_file_t *mergeinfo_file = NULL;
+  apr_off_t mergeinfo_file_size = 0;
   svn_revnum_t current;
   apr_array_header_t *histories;
   svn_boolean_t any_histories_left = TRUE;
@@ -2005,11 +2685,14 @@ do_logs(svn_fs_t *fs,
   /* We have a list of paths and a revision range.  But we don't care
      about all the revisions in the range -- only the ones in which
      one of our paths was changed.  So let's go figure out which
-     revisions contain real changes to at least one of our paths.  */
-  SVN_ERR(get_path_histories(&histories, fs, paths, hist_start, hist_end,
+     revisions contain real changes to at least one of our paths.
+     Destroying HISTORIES_POOL also stops any history threads. */
+  histories_pool = svn_pool_create(pool);
+  SVN_ERR(get_path_histories(&histories, callbacks->repos, fs, paths,
+                             hist_start, hist_end,
                              strict_node_history, ignore_missing_locations,
                              callbacks->authz_read_func,
-                             callbacks->authz_read_baton, pool));
+                             callbacks->authz_read_baton, histories_pool));
 
   /* Loop through all the revisions in the range and add any
      where a path was changed to the array, or if they wanted
@@ -2036,7 +2719,7 @@ do_logs(svn_fs_t *fs,
                                 strict_node_history,
                                 callbacks->authz_read_func,
                                 callbacks->authz_read_baton,
-                                hist_start, pool, iterpool2));
+                                hist_start, histories_pool, iterpool2));
           if (! info->done)
             any_histories_left = TRUE;
         }
@@ -2117,34 +2800,30 @@ do_logs(svn_fs_t *fs,
              process them later. */
           else
             {
-              if (! revs)
-                revs = apr_array_make(pool, 64, sizeof(svn_revnum_t));
-              APR_ARRAY_PUSH(revs, svn_revnum_t) = current;
+              struct buffered_rev *buffered;
 
-              if (added_mergeinfo || deleted_mergeinfo)
-                {
-                  svn_revnum_t *cur_rev =
-                    apr_pmemdup(pool, &current, sizeof(*cur_rev));
-                  struct added_deleted_mergeinfo *add_and_del_mergeinfo =
-                    apr_palloc(pool, sizeof(*add_and_del_mergeinfo));
-
-                  /* If we have added or deleted mergeinfo, both are non-null */
-                  SVN_ERR_ASSERT(added_mergeinfo && deleted_mergeinfo);
-                  add_and_del_mergeinfo->added_mergeinfo =
-                    svn_mergeinfo_dup(added_mergeinfo, pool);
-                  add_and_del_mergeinfo->deleted_mergeinfo =
-                    svn_mergeinfo_dup(deleted_mergeinfo, pool);
-
-                  if (! rev_mergeinfo)
-                    rev_mergeinfo = svn_hash__make(pool);
-                  apr_hash_set(rev_mergeinfo, cur_rev, sizeof(*cur_rev),
-                               add_and_del_mergeinfo);
-                }
+              if (! revs)
+                revs = apr_array_make(pool, 64, sizeof(struct buffered_rev));
+
+              buffered = apr_array_push(revs);
+              buffered->revision = current;
+              buffered->mergeinfo_offset = -1;
+
+              /* Only revisions with mergeinfo changes need to remember
+                 them, and there may be many such revisions, so don't
+                 keep them in memory. */
+              if (has_children)
+                SVN_ERR(spill_mergeinfo(&buffered->mergeinfo_offset,
+                                        &mergeinfo_file,
+                                        &mergeinfo_file_size,
+                                        added_mergeinfo, deleted_mergeinfo,
+                                        pool, iterpool));
             }
         }
     }
   svn_pool_destroy(iterpool2);
   svn_pool_destroy(iterpool);
+  svn_pool_destroy(histories_pool);
 
   if (subpool)
     {
@@ -2159,26 +2838,24 @@ do_logs(svn_fs_t *fs,
       iterpool = svn_pool_create(pool);
       for (i = 0; i < revs->nelts; ++i)
         {
-          svn_mergeinfo_t added_mergeinfo;
-          svn_mergeinfo_t deleted_mergeinfo;
-          svn_boolean_t has_children = FALSE;
+          svn_mergeinfo_t added_mergeinfo = NULL;
+          svn_mergeinfo_t deleted_mergeinfo = NULL;
+          svn_boolean_t has_children;
+          const struct buffered_rev *buffered
+            = &APR_ARRAY_IDX(revs, revs->nelts - i - 1, struct buffered_rev);
 
           svn_pool_clear(iterpool);
-          current = APR_ARRAY_IDX(revs, revs->nelts - i - 1, svn_revnum_t);
+          current = buffered->revision;
 
-          /* If we've got a hash of revision mergeinfo (which can only
-             happen if INCLUDE_MERGED_REVISIONS was set), we check to
-             see if this revision is one which merged in other
-             revisions we need to handle recursively. */
-          if (rev_mergeinfo)
-            {
-              struct added_deleted_mergeinfo *add_and_del_mergeinfo =
-                apr_hash_get(rev_mergeinfo, &current, sizeof(current));
-              added_mergeinfo = add_and_del_mergeinfo->added_mergeinfo;
-              deleted_mergeinfo = add_and_del_mergeinfo->deleted_mergeinfo;
-              has_children = (apr_hash_count(added_mergeinfo) > 0
-                              || apr_hash_count(deleted_mergeinfo) > 0);
-            }
+          /* If this revision merged in other revisions (which can only
+             happen if INCLUDE_MERGED_REVISIONS was set), fetch the
+             mergeinfo changes we need to handle them recursively. */
+          has_children = (buffered->mergeinfo_offset >= 0);
+          if (has_children)
+            SVN_ERR(unspill_mergeinfo(&added_mergeinfo, &deleted_mergeinfo,
+                                      mergeinfo_file,
+                                      buffered->mergeinfo_offset,
+                                      iterpool));
 
           SVN_ERR(send_log(current, fs,
                            log_target_history_as_mergeinfo, nested_merges,
@@ -2297,6 +2974,15 @@ get_paths_history_as_mergeinfo(svn_mergeinfo_t *paths_history_mergeinfo,
   return SVN_NO_ERROR;
 }
 
+void
+svn_repos__set_log_threads(svn_repos_t *repos,
+                           int threads,
+                           apr_hash_t *fs_config)
+{
+  repos->log_threads = threads;
+  repos->log_fs_config = fs_config;
+}
+
 svn_error_t *
 svn_repos_get_logs5(svn_repos_t *repos,
                     const apr_array_header_t *paths,
@@ -2326,6 +3012,7 @@ svn_repos_get_logs5(svn_repos_t *repos,
   callbacks.revision_receiver_baton = revision_receiver_baton;
   callbacks.authz_read_func = authz_read_func;
   callbacks.authz_read_baton = authz_read_baton;
+  callbacks.repos = repos;
 
   if (revprops)
     {
@@ -0,0 +1,982 @@
+/* path_index.c : an optional index of all paths in the youngest revision
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <apr_pools.h>
+
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_path.h"
+#include "svn_sorts.h"
+
+#include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_string_private.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_utf_private.h"
+#include "svn_private_config.h"
+
+#include "repos.h"
+
+
+/* The path index lists all paths of one revision, sorted by
+ * svn_path_compare_paths(), so that every sub-tree is a contiguous
+ * range of entries.  For each trigram (3 byte sequence) found in the
+ * normalized entry names, it stores the list of entries whose names
+ * contain it.  A glob pattern can only match names that contain all
+ * trigrams of its literal parts, so a search only needs to look at the
+ * entries found in the intersection of these lists.
+ *
+ * The index file has the following text format:
+ *
+ *   PATH-INDEX 1
+ *   <revision>
+ *   <number of paths>
+ *   <'d' or 'f'><path>        (one line per path except "/")
+ *   ...
+ *   <number of trigrams>
+ *   <trigram> <count> <entry index deltas, separated by spaces>
+ *   ...
+ *
+ * Paths can't contain control characters, so neither paths nor trigrams
+ * can contain a newline.  The trigram always takes the first 3 bytes of
+ * its line.
+ */
+
+/* First line of the index file. */
+#define PATH_INDEX_FORMAT "PATH-INDEX 1"
+
+/* An in-memory path index. */
+typedef struct path_index_t
+{
+  /* Revision described by this index. */
+  svn_revnum_t revision;
+
+  /* All paths in REVISION except "/", as svn_repos__path_index_entry_t,
+     sorted by svn_path_compare_paths(). */
+  apr_array_header_t *entries;
+
+  /* Maps trigrams (keys of length 3) to the ascending apr_array_header_t
+     of int indexes into ENTRIES of the entries that contain the trigram.
+     Only the trigrams requested when loading the index are present. */
+  apr_hash_t *postings;
+} path_index_t;
+
+/* Return the path of the index file in the repository at REPOS_PATH,
+   allocated in POOL. */
+static const char *
+index_file_path(const char *repos_path,
+                apr_pool_t *pool)
+{
+  return svn_dirent_join(repos_path, SVN_REPOS__PATH_INDEX, pool);
+}
+
+/* Implements the comparison function for svn_sort__array() and
+   svn_sort__bsearch_lower_bound() on svn_repos__path_index_entry_t. */
+static int
+compare_entries(const void *lhs,
+                const void *rhs)
+{
+  const svn_repos__path_index_entry_t *lhs_entry = lhs;
+  const svn_repos__path_index_entry_t *rhs_entry = rhs;
+
+  return svn_path_compare_paths(lhs_entry->path, rhs_entry->path);
+}
+
+/* Return the index of the first entry in ENTRIES that is PATH or
+   follows it in path order. */
+static int
+lower_bound(const apr_array_header_t *entries,
+            const char *path)
+{
+  svn_repos__path_index_entry_t key;
+
+  key.path = path;
+  key.kind = svn_node_unknown;
+
+  return svn_sort__bsearch_lower_bound(entries, &key, compare_entries);
+}
+
+/* Return the index of the first entry in ENTRIES after START that is
+   neither PATH nor one of its descendants. */
+static int
+subtree_end(const apr_array_header_t *entries,
+            int start,
+            const char *path)
+{
+  int i;
+
+  for (i = start; i < entries->nelts; ++i)
+    {
+      const svn_repos__path_index_entry_t *entry
+        = &APR_ARRAY_IDX(entries, i, svn_repos__path_index_entry_t);
+      if (!svn_fspath__skip_ancestor(path, entry->path))
+        break;
+    }
+
+  return i;
+}
+
+/* Add all trigrams of the first LEN bytes of LITERAL to TRIGRAMS as
+   const char * of length 3, allocated in POOL. */
+static void
+add_trigrams(apr_array_header_t *trigrams,
+             const char *literal,
+             apr_size_t len,
+             apr_pool_t *pool)
+{
+  apr_size_t i;
+
+  for (i = 0; i + 3 <= len; ++i)
+    APR_ARRAY_PUSH(trigrams, const char *)
+      = apr_pstrmemdup(pool, literal + i, 3);
+}
+
+/* Return the trigrams that every name matching the apr_fnmatch()
+   PATTERN must contain, as const char * of length 3 allocated in POOL.
+   The result may be empty. */
+static apr_array_header_t *
+pattern_trigrams(const char *pattern,
+                 apr_pool_t *pool)
+{
+  apr_array_header_t *trigrams = apr_array_make(pool, 8,
+                                                sizeof(const char *));
+  svn_stringbuf_t *literal = svn_stringbuf_create_empty(pool);
+  const char *p = pattern;
+
+  while (*p)
+    {
+      if (*p == '*' || *p == '?' || *p == '[')
+        {
+          add_trigrams(trigrams, literal->data, literal->len, pool);
+          svn_stringbuf_setempty(literal);
+
+          /* Skip a character class.  Should it not be terminated, we
+             skip the rest of the pattern and are left with fewer
+             trigrams, which is safe. */
+          if (*p == '[')
+            {
+              ++p;
+              if (*p == '!' || *p == '^')
+                ++p;
+              if (*p == ']')
+                ++p;
+              while (*p && *p != ']')
+                {
+                  if (*p == '\\' && p[1])
+                    ++p;
+                  ++p;
+                }
+            }
+
+          if (*p)
+            ++p;
+        }
+      else if (*p == '\\' && p[1])
+        {
+          svn_stringbuf_appendbyte(literal, p[1]);
+          p += 2;
+        }
+      else
+        {
+          svn_stringbuf_appendbyte(literal, *p);
+          ++p;
+        }
+    }
+
+  add_trigrams(trigrams, literal->data, literal->len, pool);
+
+  return trigrams;
+}
+
+/* Set *LINE to the next line starting at *POS and ending before END,
+   terminate it and advance *POS to the line after it.  Return an error
+   mentioning FILE_PATH if there is no complete line left. */
+static svn_error_t *
+next_line(char **line,
+          char **pos,
+          char *end,
+          const char *file_path,
+          apr_pool_t *scratch_pool)
+{
+  char *eol = memchr(*pos, '\n', end - *pos);
+  if (!eol)
+    return svn_error_createf(SVN_ERR_MALFORMED_FILE, NULL,
+                             _("Path index file '%s' is truncated"),
+                             svn_dirent_local_style(file_path,
+                                                    scratch_pool));
+
+  *eol = '\0';
+  *line = *pos;
+  *pos = eol + 1;
+
+  return SVN_NO_ERROR;
+}
+
+/* Parse the decimal number at the start of LINE into *VALUE and set
+   *LINE to the first character following it.  Return an error mentioning
+   FILE_PATH if there is no number. */
+static svn_error_t *
+parse_number(apr_size_t *value,
+             const char **line,
+             const char *file_path,
+             apr_pool_t *scratch_pool)
+{
+  const char *end;
+
+  *value = (apr_size_t)svn__strtoul(*line, &end);
+  if (end == *line)
+    return svn_error_createf(SVN_ERR_MALFORMED_FILE, NULL,
+                             _("Malformed number in path index file '%s'"),
+                             svn_dirent_local_style(file_path,
+                                                    scratch_pool));
+
+  *line = end;
+  return SVN_NO_ERROR;
+}
+
+/* Read the index file at FILE_PATH into *INDEX.  Only load the posting
+   lists for the trigrams that are keys in WANTED.  Set *INDEX to NULL
+   if there is no index file.  Allocate the result in RESULT_POOL and use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+read_index(path_index_t **index,
+           const char *file_path,
+           apr_hash_t *wanted,
+           apr_pool_t *result_pool,
+           apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  path_index_t *result;
+  svn_error_t *err;
+  char *pos, *end, *line;
+  const char *p;
+  apr_size_t count, i;
+
+  err = svn_stringbuf_from_file2(&contents, file_path, result_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      *index = NULL;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  pos = contents->data;
+  end = contents->data + contents->len;
+
+  SVN_ERR(next_line(&line, &pos, end, file_path, scratch_pool));
+  if (strcmp(line, PATH_INDEX_FORMAT) != 0)
+    return svn_error_createf(SVN_ERR_REPOS_UNSUPPORTED_VERSION, NULL,
+                             _("Unsupported path index format in '%s'"),
+                             svn_dirent_local_style(file_path,
+                                                    scratch_pool));
+
+  result = apr_pcalloc(result_pool, sizeof(*result));
+  SVN_ERR(next_line(&line, &pos, end, file_path, scratch_pool));
+  err = svn_revnum_parse(&result->revision, line, NULL);
+  if (err)
+    return svn_error_createf(SVN_ERR_MALFORMED_FILE, err,
+                             _("Malformed revision in path index file '%s'"),
+                             svn_dirent_local_style(file_path,
+                                                    scratch_pool));
+
+  SVN_ERR(next_line(&line, &pos, end, file_path, scratch_pool));
+  p = line;
+  SVN_ERR(parse_number(&count, &p, file_path, scratch_pool));
+
+  /* The paths point into CONTENTS. */
+  result->entries = apr_array_make(result_pool, (int)count,
+                                   sizeof(svn_repos__path_index_entry_t));
+  for (i = 0; i < count; ++i)
+    {
+      svn_repos__path_index_entry_t *entry;
+
+      SVN_ERR(next_line(&line, &pos, end, file_path, scratch_pool));
+      if ((line[0] != 'd' && line[0] != 'f') || line[1] != '/')
+        return svn_error_createf(SVN_ERR_MALFORMED_FILE, NULL,
+                                 _("Malformed path entry in path index "
+                                   "file '%s'"),
+                                 svn_dirent_local_style(file_path,
+                                                        scratch_pool));
+
+      entry = apr_array_push(result->entries);
+      entry->kind = line[0] == 'd' ? svn_node_dir : svn_node_file;
+      entry->path = line + 1;
+    }
+
+  SVN_ERR(next_line(&line, &pos, end, file_path, scratch_pool));
+  p = line;
+  SVN_ERR(parse_number(&count, &p, file_path, scratch_pool));
+
+  result->postings = apr_hash_make(result_pool);
+  for (i = 0; i < count; ++i)
+    {
+      apr_array_header_t *posting;
+      apr_size_t entry_count, delta, k;
+      int entry_idx = 0;
+
+      SVN_ERR(next_line(&line, &pos, end, file_path, scratch_pool));
+      if (strlen(line) < 4 || line[3] != ' ')
+        return svn_error_createf(SVN_ERR_MALFORMED_FILE, NULL,
+                                 _("Malformed trigram entry in path index "
+                                   "file '%s'"),
+                                 svn_dirent_local_style(file_path,
+                                                        scratch_pool));
+
+      /* Skip the lists that we don't need without parsing them. */
+      if (!wanted || !apr_hash_get(wanted, line, 3))
+        continue;
+
+      p = line + 4;
+      SVN_ERR(parse_number(&entry_count, &p, file_path, scratch_pool));
+      posting = apr_array_make(result_pool, (int)entry_count, sizeof(int));
+      for (k = 0; k < entry_count; ++k)
+        {
+          if (*p != ' ')
+            return svn_error_createf(SVN_ERR_MALFORMED_FILE, NULL,
+                                     _("Malformed trigram entry in path "
+                                       "index file '%s'"),
+                                     svn_dirent_local_style(file_path,
+                                                            scratch_pool));
+          ++p;
+          SVN_ERR(parse_number(&delta, &p, file_path, scratch_pool));
+          entry_idx += (int)delta;
+          if (entry_idx >= result->entries->nelts)
+            return svn_error_createf(SVN_ERR_MALFORMED_FILE, NULL,
+                                     _("Invalid entry index in path index "
+                                       "file '%s'"),
+                                     svn_dirent_local_style(file_path,
+                                                            scratch_pool));
+
+          APR_ARRAY_PUSH(posting, int) = entry_idx;
+        }
+
+      apr_hash_set(result->postings, line, 3, posting);
+    }
+
+  *index = result;
+  return SVN_NO_ERROR;
+}
+
+/* Return the posting lists for the trigrams in the names of all entries
+   of INDEX, see path_index_t.  Allocate the result in RESULT_POOL and
+   use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+collect_postings(apr_hash_t **postings,
+                 const path_index_t *index,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *result_pool,
+                 apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_hash_t *result = apr_hash_make(result_pool);
+  apr_array_header_t *trigrams;
+  svn_membuf_t buffer;
+  int i;
+
+  /* Entries are visited in ascending order, so the lists end up sorted. */
+  svn_membuf__create(&buffer, 256, scratch_pool);
+  trigrams = apr_array_make(scratch_pool, 16, sizeof(const char *));
+  for (i = 0; i < index->entries->nelts; ++i)
+    {
+      const svn_repos__path_index_entry_t *entry
+        = &APR_ARRAY_IDX(index->entries, i, svn_repos__path_index_entry_t);
+      const char *name = svn_fspath__basename(entry->path, iterpool);
+      const char *normalized;
+      svn_error_t *err;
+      int k;
+
+      if (i % 1000 == 0)
+        {
+          svn_pool_clear(iterpool);
+          if (cancel_func)
+            SVN_ERR(cancel_func(cancel_baton));
+        }
+
+      /* Names that can't be normalized never match any pattern. */
+      err = svn_utf__xfrm(&normalized, name, strlen(name), TRUE, TRUE,
+                          &buffer);
+      if (err)
+        {
+          svn_error_clear(err);
+          continue;
+        }
+
+      apr_array_clear(trigrams);
+      add_trigrams(trigrams, normalized, strlen(normalized), iterpool);
+      for (k = 0; k < trigrams->nelts; ++k)
+        {
+          const char *trigram = APR_ARRAY_IDX(trigrams, k, const char *);
+          apr_array_header_t *posting = apr_hash_get(result, trigram, 3);
+
+          if (!posting)
+            {
+              posting = apr_array_make(result_pool, 4, sizeof(int));
+              apr_hash_set(result, apr_pstrmemdup(result_pool, trigram, 3),
+                           3, posting);
+            }
+
+          /* A name may contain the same trigram more than once. */
+          if (posting->nelts == 0
+              || APR_ARRAY_IDX(posting, posting->nelts - 1, int) != i)
+            APR_ARRAY_PUSH(posting, int) = i;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+
+  *postings = result;
+  return SVN_NO_ERROR;
+}
+
+/* Write INDEX in the index file format to STREAM.  Use SCRATCH_POOL for
+   temporary allocations. */
+static svn_error_t *
+write_index_contents(svn_stream_t *stream,
+                     const path_index_t *index,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_stringbuf_t *line = svn_stringbuf_create_empty(scratch_pool);
+  apr_hash_t *postings;
+  apr_array_header_t *sorted;
+  int i;
+
+  SVN_ERR(collect_postings(&postings, index, cancel_func, cancel_baton,
+                           scratch_pool, iterpool));
+
+  SVN_ERR(svn_stream_printf(stream, iterpool,
+                            PATH_INDEX_FORMAT "\n%ld\n%d\n",
+                            index->revision, index->entries->nelts));
+  for (i = 0; i < index->entries->nelts; ++i)
+    {
+      const svn_repos__path_index_entry_t *entry
+        = &APR_ARRAY_IDX(index->entries, i, svn_repos__path_index_entry_t);
+
+      svn_stringbuf_setempty(line);
+      svn_stringbuf_appendbyte(line,
+                               entry->kind == svn_node_dir ? 'd' : 'f');
+      svn_stringbuf_appendcstr(line, entry->path);
+      svn_stringbuf_appendbyte(line, '\n');
+      SVN_ERR(svn_stream_write(stream, line->data, &line->len));
+    }
+
+  /* Sort the trigrams to get reproducible index files. */
+  sorted = svn_sort__hash(postings, svn_sort_compare_items_lexically,
+                          scratch_pool);
+  SVN_ERR(svn_stream_printf(stream, iterpool, "%d\n", sorted->nelts));
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      const svn_sort__item_t *item
+        = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      const apr_array_header_t *posting = item->value;
+      char number[SVN_INT64_BUFFER_SIZE];
+      int last = 0;
+      int k;
+
+      if (cancel_func && i % 1000 == 0)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      svn_stringbuf_setempty(line);
+      svn_stringbuf_appendbytes(line, item->key, 3);
+      svn_stringbuf_appendbyte(line, ' ');
+      svn_stringbuf_appendbytes(line, number,
+                                svn__ui64toa(number, posting->nelts));
+
+      /* Store the differences between the ascending entry indexes. */
+      for (k = 0; k < posting->nelts; ++k)
+        {
+          int entry_idx = APR_ARRAY_IDX(posting, k, int);
+
+          svn_stringbuf_appendbyte(line, ' ');
+          svn_stringbuf_appendbytes(line, number,
+                                    svn__ui64toa(number, entry_idx - last));
+          last = entry_idx;
+        }
+
+      svn_stringbuf_appendbyte(line, '\n');
+      SVN_ERR(svn_stream_write(stream, line->data, &line->len));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Write INDEX to the index file in the repository at REPOS_PATH,
+   replacing it atomically.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+write_index(const path_index_t *index,
+            const char *repos_path,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *scratch_pool)
+{
+  svn_stream_t *stream;
+  const char *tmp_path;
+  svn_error_t *err;
+
+  SVN_ERR(svn_stream_open_unique(&stream, &tmp_path, repos_path,
+                                 svn_io_file_del_none,
+                                 scratch_pool, scratch_pool));
+  err = write_index_contents(stream, index, cancel_func, cancel_baton,
+                             scratch_pool);
+  err = svn_error_compose_create(err, svn_stream_close(stream));
+  if (!err)
+    err = svn_io_file_rename2(tmp_path,
+                              index_file_path(repos_path, scratch_pool),
+                              FALSE, scratch_pool);
+
+  if (err)
+    return svn_error_compose_create(err,
+                                    svn_io_remove_file2(tmp_path, TRUE,
+                                                        scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Append entries for all nodes below the directory PATH in ROOT to
+   ENTRIES, in no particular order.  Allocate them in RESULT_POOL and use
+   SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+add_subtree(apr_array_header_t *entries,
+            svn_fs_root_t *root,
+            const char *path,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+
+  if (cancel_func)
+    SVN_ERR(cancel_func(cancel_baton));
+
+  SVN_ERR(svn_fs_dir_entries(&dirents, root, path, scratch_pool));
+  for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const svn_fs_dirent_t *dirent = apr_hash_this_val(hi);
+      svn_repos__path_index_entry_t *entry = apr_array_push(entries);
+
+      svn_pool_clear(iterpool);
+
+      entry->path = svn_fspath__join(path, dirent->name, result_pool);
+      entry->kind = dirent->kind;
+
+      if (dirent->kind == svn_node_dir)
+        SVN_ERR(add_subtree(entries, root, entry->path,
+                            cancel_func, cancel_baton,
+                            result_pool, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+/* Return a new index for REVISION in FS, created by walking the whole
+   tree.  Allocate it in RESULT_POOL and use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+build_index(path_index_t **index,
+            svn_fs_t *fs,
+            svn_revnum_t revision,
+            svn_cancel_func_t cancel_func,
+            void *cancel_baton,
+            apr_pool_t *result_pool,
+            apr_pool_t *scratch_pool)
+{
+  path_index_t *result = apr_pcalloc(result_pool, sizeof(*result));
+  svn_fs_root_t *root;
+
+  result->revision = revision;
+  result->entries = apr_array_make(result_pool, 1024,
+                                   sizeof(svn_repos__path_index_entry_t));
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, revision, scratch_pool));
+  SVN_ERR(add_subtree(result->entries, root, "/", cancel_func, cancel_baton,
+                      result_pool, scratch_pool));
+  svn_sort__array(result->entries, compare_entries);
+
+  *index = result;
+  return SVN_NO_ERROR;
+}
+
+/* Update INDEX to the next revision in FS, applying the changes of that
+   revision to INDEX->ENTRIES.  Allocate new paths in RESULT_POOL and the
+   new entries array in ARRAY_POOL.  Use SCRATCH_POOL for temporary
+   allocations. */
+static svn_error_t *
+apply_next_revision(path_index_t *index,
+                    svn_fs_t *fs,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *array_pool,
+                    apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_revnum_t revision = index->revision + 1;
+  svn_fs_root_t *root;
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+  svn_bit_array__t *removed = svn_bit_array__create(0, scratch_pool);
+  apr_array_header_t *added;
+  apr_array_header_t *entries;
+  const apr_array_header_t *old_entries = index->entries;
+  int i, k;
+
+  added = apr_array_make(scratch_pool, 16,
+                         sizeof(svn_repos__path_index_entry_t));
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, revision, scratch_pool));
+  SVN_ERR(svn_fs_paths_changed3(&iterator, root, scratch_pool,
+                                scratch_pool));
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  while (change)
+    {
+      const char *path = change->path.data;
+      svn_fs_path_change_kind_t action = change->change_kind;
+
+      svn_pool_clear(iterpool);
+
+      /* Deleted and replaced sub-trees go away. */
+      if (   action == svn_fs_path_change_delete
+          || action == svn_fs_path_change_replace
+          || action == svn_fs_path_change_movereplace)
+        {
+          int start = lower_bound(old_entries, path);
+          int end = subtree_end(old_entries, start, path);
+
+          for (i = start; i < end; ++i)
+            svn_bit_array__set(removed, i, TRUE);
+        }
+
+      /* Added nodes come in; copied directories with all their
+         contents. */
+      if (   action == svn_fs_path_change_add
+          || action == svn_fs_path_change_replace
+          || action == svn_fs_path_change_move
+          || action == svn_fs_path_change_movereplace)
+        {
+          svn_repos__path_index_entry_t *entry = apr_array_push(added);
+          svn_revnum_t copyfrom_rev = SVN_INVALID_REVNUM;
+
+          entry->path = apr_pstrdup(result_pool, path);
+          entry->kind = change->node_kind;
+          if (entry->kind == svn_node_unknown)
+            SVN_ERR(svn_fs_check_path(&entry->kind, root, path, iterpool));
+
+          if (entry->kind == svn_node_dir && change->copyfrom_known)
+            {
+              copyfrom_rev = change->copyfrom_rev;
+            }
+          else if (entry->kind == svn_node_dir)
+            {
+              const char *copyfrom_path;
+              SVN_ERR(svn_fs_copied_from(&copyfrom_rev, &copyfrom_path,
+                                         root, path, iterpool));
+            }
+
+          if (entry->kind == svn_node_dir
+              && SVN_IS_VALID_REVNUM(copyfrom_rev))
+            SVN_ERR(add_subtree(added, root, path, cancel_func, cancel_baton,
+                                result_pool, iterpool));
+        }
+
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
+
+  /* Nodes added within a copied directory may have been reported twice. */
+  svn_sort__array(added, compare_entries);
+
+  /* Merge the surviving old entries with the new ones. */
+  entries = apr_array_make(array_pool, old_entries->nelts + added->nelts,
+                           sizeof(svn_repos__path_index_entry_t));
+  i = 0;
+  k = 0;
+  while (i < old_entries->nelts || k < added->nelts)
+    {
+      const svn_repos__path_index_entry_t *entry;
+
+      if (i < old_entries->nelts && svn_bit_array__get(removed, i))
+        {
+          ++i;
+          continue;
+        }
+
+      if (   k == added->nelts
+          || (   i < old_entries->nelts
+              && compare_entries(&APR_ARRAY_IDX(old_entries, i,
+                                                svn_repos__path_index_entry_t),
+                                 &APR_ARRAY_IDX(added, k,
+                                                svn_repos__path_index_entry_t))
+                 < 0))
+        {
+          entry = &APR_ARRAY_IDX(old_entries, i++,
+                                 svn_repos__path_index_entry_t);
+        }
+      else
+        {
+          entry = &APR_ARRAY_IDX(added, k++, svn_repos__path_index_entry_t);
+        }
+
+      if (entries->nelts == 0
+          || strcmp(APR_ARRAY_IDX(entries, entries->nelts - 1,
+                                  svn_repos__path_index_entry_t).path,
+                    entry->path) != 0)
+        APR_ARRAY_PUSH(entries, svn_repos__path_index_entry_t) = *entry;
+    }
+
+  index->entries = entries;
+  index->revision = revision;
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__path_index_update(svn_repos_t *repos,
+                             svn_boolean_t create,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *scratch_pool)
+{
+  apr_pool_t *pool = svn_pool_create(scratch_pool);
+  apr_pool_t *array_pool = svn_pool_create(pool);
+  apr_pool_t *next_array_pool = svn_pool_create(pool);
+  const char *file_path = index_file_path(repos->path, pool);
+  path_index_t *index = NULL;
+  svn_node_kind_t kind;
+  svn_revnum_t youngest;
+  apr_file_t *lockfile;
+  svn_error_t *err;
+
+  /* The index is optional. */
+  SVN_ERR(svn_io_check_path(file_path, &kind, pool));
+  if (kind == svn_node_none && !create)
+    {
+      svn_pool_destroy(pool);
+      return SVN_NO_ERROR;
+    }
+
+  /* Serialize updates.  The lock is released when POOL gets cleared. */
+  SVN_ERR(svn_io_file_open(&lockfile,
+                           svn_dirent_join(repos->lock_path,
+                                           SVN_REPOS__PATH_INDEX_LOCKFILE,
+                                           pool),
+                           APR_WRITE | APR_CREATE, APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_lock_open_file(lockfile, TRUE, FALSE, pool));
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest, repos->fs, pool));
+
+  /* A broken or outdated index gets rebuilt from scratch. */
+  err = read_index(&index, file_path, NULL, pool, pool);
+  if (err && (   err->apr_err == SVN_ERR_MALFORMED_FILE
+              || err->apr_err == SVN_ERR_REPOS_UNSUPPORTED_VERSION))
+    {
+      svn_error_clear(err);
+      index = NULL;
+    }
+  else
+    SVN_ERR(err);
+
+  if (index && index->revision == youngest)
+    {
+      svn_pool_destroy(pool);
+      return SVN_NO_ERROR;
+    }
+
+  if (!index || index->revision > youngest)
+    SVN_ERR(build_index(&index, repos->fs, youngest, cancel_func,
+                        cancel_baton, pool, pool));
+
+  /* Catch up with the commits since the last update.  Every iteration
+     creates a new entries array; drop the previous one. */
+  while (index->revision < youngest)
+    {
+      apr_pool_t *tmp_pool;
+
+      svn_pool_clear(next_array_pool);
+      SVN_ERR(apply_next_revision(index, repos->fs, cancel_func,
+                                  cancel_baton, pool, next_array_pool,
+                                  next_array_pool));
+
+      tmp_pool = array_pool;
+      array_pool = next_array_pool;
+      next_array_pool = tmp_pool;
+    }
+
+  SVN_ERR(write_index(index, repos->path, cancel_func, cancel_baton, pool));
+
+  svn_pool_destroy(pool);
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__path_index_lookup(apr_array_header_t **candidates,
+                             svn_fs_root_t *root,
+                             const char *path,
+                             const apr_array_header_t *patterns,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  svn_fs_t *fs = svn_fs_root_fs(root);
+  apr_array_header_t *pattern_trigram_lists;
+  apr_hash_t *wanted = apr_hash_make(scratch_pool);
+  svn_boolean_t match_all = FALSE;
+  svn_bit_array__t *matches;
+  path_index_t *index;
+  svn_error_t *err;
+  const char *repos_path;
+  int start, end;
+  int i, k;
+
+  *candidates = NULL;
+  if (!svn_fs_is_revision_root(root))
+    return SVN_NO_ERROR;
+
+  /* Collect the trigrams that the patterns require. */
+  pattern_trigram_lists = apr_array_make(scratch_pool, patterns->nelts,
+                                         sizeof(apr_array_header_t *));
+  for (i = 0; i < patterns->nelts; ++i)
+    {
+      const char *pattern = APR_ARRAY_IDX(patterns, i, const char *);
+      apr_array_header_t *trigrams = pattern_trigrams(pattern, scratch_pool);
+
+      if (trigrams->nelts == 0)
+        match_all = TRUE;
+
+      for (k = 0; k < trigrams->nelts; ++k)
+        {
+          const char *trigram = APR_ARRAY_IDX(trigrams, k, const char *);
+          apr_hash_set(wanted, trigram, 3, trigram);
+        }
+
+      APR_ARRAY_PUSH(pattern_trigram_lists, apr_array_header_t *) = trigrams;
+    }
+
+  /* svn_repos_t always keeps the filesystem in its "db" sub-directory. */
+  repos_path = svn_dirent_dirname(svn_fs_path(fs, scratch_pool),
+                                  scratch_pool);
+
+  /* The index is merely an optimization.  If we can't use it, let the
+     caller walk the tree. */
+  err = read_index(&index, index_file_path(repos_path, scratch_pool),
+                   match_all ? NULL : wanted, scratch_pool, scratch_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  if (!index || index->revision != svn_fs_revision_root_revision(root))
+    return SVN_NO_ERROR;
+
+  /* All entries below PATH. */
+  start = lower_bound(index->entries, path);
+  if (   start < index->entries->nelts
+      && strcmp(APR_ARRAY_IDX(index->entries, start,
+                              svn_repos__path_index_entry_t).path,
+                path) == 0)
+    ++start;
+  end = subtree_end(index->entries, start, path);
+
+  /* Mark the entries that contain all trigrams of at least one pattern.
+   * Without any trigram in some pattern, every entry is a candidate. */
+  matches = svn_bit_array__create(0, scratch_pool);
+  for (i = 0; i < pattern_trigram_lists->nelts && !match_all; ++i)
+    {
+      apr_array_header_t *trigrams
+        = APR_ARRAY_IDX(pattern_trigram_lists, i, apr_array_header_t *);
+      apr_array_header_t *posting
+        = apr_hash_get(index->postings,
+                       APR_ARRAY_IDX(trigrams, 0, const char *), 3);
+
+      /* Intersect the posting lists of all trigrams. */
+      if (posting)
+        posting = apr_array_copy(scratch_pool, posting);
+
+      for (k = 1; k < trigrams->nelts && posting && posting->nelts; ++k)
+        {
+          const apr_array_header_t *other
+            = apr_hash_get(index->postings,
+                           APR_ARRAY_IDX(trigrams, k, const char *), 3);
+          int from, to, o;
+
+          if (!other)
+            {
+              posting = NULL;
+              break;
+            }
+
+          for (from = 0, to = 0, o = 0;
+               from < posting->nelts && o < other->nelts; )
+            {
+              int lhs = APR_ARRAY_IDX(posting, from, int);
+              int rhs = APR_ARRAY_IDX(other, o, int);
+
+              if (lhs < rhs)
+                ++from;
+              else if (lhs > rhs)
+                ++o;
+              else
+                {
+                  APR_ARRAY_IDX(posting, to++, int) = lhs;
+                  ++from;
+                  ++o;
+                }
+            }
+
+          posting->nelts = to;
+        }
+
+      for (k = 0; posting && k < posting->nelts; ++k)
+        {
+          int entry_idx = APR_ARRAY_IDX(posting, k, int);
+          if (entry_idx >= start && entry_idx < end)
+            svn_bit_array__set(matches, entry_idx, TRUE);
+        }
+    }
+
+  /* Return the candidates in path order. */
+  *candidates = apr_array_make(result_pool, 16,
+                               sizeof(svn_repos__path_index_entry_t));
+  for (i = start; i < end; ++i)
+    if (match_all || svn_bit_array__get(matches, i))
+      {
+        svn_repos__path_index_entry_t *entry = apr_array_push(*candidates);
+
+        *entry = APR_ARRAY_IDX(index->entries, i,
+                               svn_repos__path_index_entry_t);
+        entry->path = apr_pstrdup(result_pool, entry->path);
+      }
+
+  return SVN_NO_ERROR;
+}
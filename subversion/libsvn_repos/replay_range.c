@@ -0,0 +1,596 @@
+/*
+ * replay_range.c :  replaying revision ranges with look-ahead
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+#include "svn_delta.h"
+#include "svn_fs.h"
+#include "svn_props.h"
+#include "svn_repos.h"
+
+#include "private/svn_delta_private.h"
+#include "private/svn_mutex.h"
+#include "private/svn_repos_private.h"
+#include "private/svn_thread_cond.h"
+
+#include "svn_private_config.h"
+
+#if APR_HAS_THREADS
+#include <apr_thread_proc.h>
+#endif
+
+
+/* Replay REVISION of REPOS to the editor returned by REVSTART_FUNC and
+ * call REVFINISH_FUNC afterwards, both with REPLAY_BATON.  The other
+ * parameters are as for svn_repos__replay_range().  Use POOL for all
+ * allocations.
+ */
+static svn_error_t *
+replay_revision(svn_repos_t *repos,
+                svn_revnum_t revision,
+                const char *base_dir,
+                svn_revnum_t low_water_mark,
+                svn_boolean_t send_deltas,
+                svn_repos_authz_func_t authz_read_func,
+                void *authz_read_baton,
+                svn_repos__replay_revstart_func_t revstart_func,
+                svn_repos__replay_revfinish_func_t revfinish_func,
+                void *replay_baton,
+                apr_pool_t *pool)
+{
+  apr_hash_t *rev_props;
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  svn_fs_root_t *root;
+  svn_error_t *err;
+
+  SVN_ERR(svn_repos_fs_revision_proplist(&rev_props, repos, revision,
+                                         authz_read_func, authz_read_baton,
+                                         pool));
+  SVN_ERR(revstart_func(revision, replay_baton, &editor, &edit_baton,
+                        rev_props, pool));
+
+  err = svn_fs_revision_root(&root, svn_repos_fs(repos), revision, pool);
+  if (!err)
+    err = svn_repos_replay2(root, base_dir, low_water_mark, send_deltas,
+                            editor, edit_baton,
+                            authz_read_func, authz_read_baton, pool);
+  if (err)
+    return svn_error_compose_create(err,
+                                    editor->abort_edit(edit_baton, pool));
+
+  return svn_error_trace(revfinish_func(revision, replay_baton, editor,
+                                        edit_baton, rev_props, pool));
+}
+
+#if APR_HAS_THREADS
+
+/* Everything prepared by a worker for a single revision. */
+typedef struct revision_t
+{
+  svn_revnum_t revision;
+
+  /* Revision properties as sent to the replay callbacks.  NULL if they
+     could not be read. */
+  apr_hash_t *rev_props;
+
+  /* The recorded editor drive.  It ends early if ERR is set. */
+  svn_delta__recording_t *recording;
+
+  /* Error preparing this revision. */
+  svn_error_t *err;
+
+  /* The look-ahead that this revision belongs to. */
+  struct look_ahead_t *look_ahead;
+
+  /* Root pool containing all of the above. */
+  apr_pool_t *pool;
+} revision_t;
+
+/* State shared between the workers and the calling thread. */
+typedef struct look_ahead_t
+{
+  /* Protects the members below up to and including ABORTED. */
+  svn_mutex__t *mutex;
+
+  /* Broadcast whenever any of the members below changes. */
+  svn_thread_cond__t *changed;
+
+  /* Next revision to be prepared by a worker. */
+  svn_revnum_t next_revision;
+
+  /* Last revision to prepare. */
+  svn_revnum_t end_revision;
+
+  /* Next revision to be played back by the calling thread. */
+  svn_revnum_t next_to_play;
+
+  /* Ring of prepared revisions, indexed by revision modulo SLOT_COUNT.
+     Workers never get more than SLOT_COUNT revisions ahead of
+     NEXT_TO_PLAY. */
+  revision_t **slots;
+  int slot_count;
+
+  /* Set when the calling thread gave up. */
+  svn_boolean_t aborted;
+
+  /* Serializes the calls to AUTHZ_READ_FUNC. */
+  svn_mutex__t *authz_mutex;
+
+  /* Parameters to svn_repos__replay_range().  Read-only. */
+  const char *repos_path;
+  apr_hash_t *fs_config;
+  const char *base_dir;
+  svn_revnum_t low_water_mark;
+  svn_boolean_t send_deltas;
+  svn_repos_authz_func_t authz_read_func;
+  void *authz_read_baton;
+} look_ahead_t;
+
+/* A worker thread and its own view of the repository. */
+typedef struct worker_t
+{
+  look_ahead_t *look_ahead;
+  apr_thread_t *thread;
+
+  /* Opened by the thread itself in its POOL.  NULL until then. */
+  svn_repos_t *repos;
+  apr_pool_t *pool;
+} worker_t;
+
+/* Set *ABORTED to whether the calling thread of LOOK_AHEAD gave up.
+
+   This function must be called with LOOK_AHEAD->MUTEX acquired. */
+static svn_error_t *
+get_aborted(svn_boolean_t *aborted,
+            look_ahead_t *look_ahead)
+{
+  *aborted = look_ahead->aborted;
+  return SVN_NO_ERROR;
+}
+
+/* Return SVN_ERR_CANCELLED if the calling thread of the look-ahead of
+   BATON, a revision_t, gave up.  Implements svn_cancel_func_t. */
+static svn_error_t *
+check_aborted(void *baton)
+{
+  revision_t *rev = baton;
+  svn_boolean_t aborted;
+
+  SVN_MUTEX__WITH_LOCK(rev->look_ahead->mutex,
+                       get_aborted(&aborted, rev->look_ahead));
+  if (aborted)
+    return svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos_authz_func_t.  Call the authz callback of BATON,
+   a look_ahead_t, while no other worker does. */
+static svn_error_t *
+serialized_authz(svn_boolean_t *allowed,
+                 svn_fs_root_t *root,
+                 const char *path,
+                 void *baton,
+                 apr_pool_t *pool)
+{
+  look_ahead_t *look_ahead = baton;
+
+  SVN_MUTEX__WITH_LOCK(look_ahead->authz_mutex,
+                       look_ahead->authz_read_func(allowed, root, path,
+                                          look_ahead->authz_read_baton,
+                                          pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Prepare REVISION in WORKER's repository and return it in a new root
+   pool.  Errors are returned in the ERR member of the result.  Use
+   SCRATCH_POOL for everything that refers to WORKER's repository. */
+static revision_t *
+prepare_revision(worker_t *worker,
+                 svn_revnum_t revision,
+                 apr_pool_t *scratch_pool)
+{
+  look_ahead_t *look_ahead = worker->look_ahead;
+  svn_repos_authz_func_t authz_read_func
+    = look_ahead->authz_read_func ? serialized_authz : NULL;
+  apr_pool_t *pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  revision_t *rev = apr_pcalloc(pool, sizeof(*rev));
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  apr_hash_t *rev_props;
+  svn_fs_root_t *root;
+  svn_error_t *err;
+
+  rev->revision = revision;
+  rev->look_ahead = look_ahead;
+  rev->pool = pool;
+
+  /* FS objects must not be shared between threads, so use our own. */
+  if (!worker->repos)
+    {
+      err = svn_repos_open3(&worker->repos, look_ahead->repos_path,
+                            look_ahead->fs_config, worker->pool,
+                            scratch_pool);
+      if (err)
+        {
+          worker->repos = NULL;
+          rev->err = err;
+          return rev;
+        }
+    }
+
+  err = svn_repos_fs_revision_proplist(&rev_props, worker->repos, revision,
+                                       authz_read_func, look_ahead,
+                                       scratch_pool);
+  if (err)
+    {
+      rev->err = err;
+      return rev;
+    }
+
+  /* The calling thread releases POOL, so nothing in it may refer to our
+     repository. */
+  rev->rev_props = svn_prop_hash_dup(rev_props, pool);
+
+  err = svn_delta__get_recording_editor(&editor, &edit_baton,
+                                        &rev->recording, check_aborted,
+                                        rev, pool);
+  if (!err)
+    err = svn_fs_revision_root(&root, svn_repos_fs(worker->repos),
+                               revision, scratch_pool);
+  if (!err)
+    err = svn_repos_replay2(root, look_ahead->base_dir,
+                            look_ahead->low_water_mark,
+                            look_ahead->send_deltas, editor, edit_baton,
+                            authz_read_func, look_ahead, scratch_pool);
+
+  rev->err = err;
+  return rev;
+}
+
+/* Set *REVISION to the next revision that a worker of LOOK_AHEAD shall
+   prepare, waiting until it may be prepared without overtaking the
+   calling thread by more than the available slots.  Set *REVISION to
+   SVN_INVALID_REVNUM if the worker shall terminate.
+
+   This function must be called with LOOK_AHEAD->MUTEX acquired. */
+static svn_error_t *
+claim_revision(svn_revnum_t *revision,
+               look_ahead_t *look_ahead)
+{
+  while (!look_ahead->aborted
+         && look_ahead->next_revision <= look_ahead->end_revision
+         && look_ahead->next_revision
+              >= look_ahead->next_to_play + look_ahead->slot_count)
+    SVN_ERR(svn_thread_cond__wait(look_ahead->changed, look_ahead->mutex));
+
+  if (look_ahead->aborted
+      || look_ahead->next_revision > look_ahead->end_revision)
+    *revision = SVN_INVALID_REVNUM;
+  else
+    *revision = look_ahead->next_revision++;
+
+  return SVN_NO_ERROR;
+}
+
+/* Hand REV over to the calling thread of LOOK_AHEAD.
+
+   This function must be called with LOOK_AHEAD->MUTEX acquired. */
+static svn_error_t *
+store_revision(look_ahead_t *look_ahead,
+               revision_t *rev)
+{
+  look_ahead->slots[rev->revision % look_ahead->slot_count] = rev;
+  return svn_thread_cond__broadcast(look_ahead->changed);
+}
+
+/* Set *REV to REVISION as prepared by the workers of LOOK_AHEAD, waiting
+   for it as necessary, and free its slot.
+
+   This function must be called with LOOK_AHEAD->MUTEX acquired. */
+static svn_error_t *
+take_revision(revision_t **rev,
+              look_ahead_t *look_ahead,
+              svn_revnum_t revision)
+{
+  revision_t **slot = &look_ahead->slots[revision % look_ahead->slot_count];
+
+  while (*slot == NULL || (*slot)->revision != revision)
+    SVN_ERR(svn_thread_cond__wait(look_ahead->changed, look_ahead->mutex));
+
+  *rev = *slot;
+  *slot = NULL;
+  look_ahead->next_to_play = revision + 1;
+
+  return svn_thread_cond__broadcast(look_ahead->changed);
+}
+
+/* Tell the workers of LOOK_AHEAD that we gave up.
+
+   This function must be called with LOOK_AHEAD->MUTEX acquired. */
+static svn_error_t *
+set_aborted(look_ahead_t *look_ahead)
+{
+  look_ahead->aborted = TRUE;
+  return svn_thread_cond__broadcast(look_ahead->changed);
+}
+
+/* The plain APR thread function of a look-ahead worker.
+ * DATA is the worker_t. */
+static void * APR_THREAD_FUNC
+worker_thread(apr_thread_t *thread, void *data)
+{
+  worker_t *worker = data;
+  look_ahead_t *look_ahead = worker->look_ahead;
+
+  /* Use a separate single-threaded pool tree for minimum overhead. */
+  apr_pool_t *pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_status_t result = APR_SUCCESS;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  worker->pool = pool;
+  while (!err)
+    {
+      svn_revnum_t revision;
+      revision_t *rev;
+
+      err = svn_mutex__lock(look_ahead->mutex);
+      if (err)
+        break;
+
+      err = svn_mutex__unlock(look_ahead->mutex,
+                              claim_revision(&revision, look_ahead));
+      if (err || !SVN_IS_VALID_REVNUM(revision))
+        break;
+
+      /* Errors are reported by the calling thread when it gets to this
+         revision. */
+      svn_pool_clear(iterpool);
+      rev = prepare_revision(worker, revision, iterpool);
+
+      err = svn_mutex__lock(look_ahead->mutex);
+      if (err)
+        {
+          svn_error_clear(rev->err);
+          svn_pool_destroy(rev->pool);
+          break;
+        }
+
+      err = svn_mutex__unlock(look_ahead->mutex,
+                              store_revision(look_ahead, rev));
+    }
+
+  if (err)
+    {
+      result = err->apr_err;
+      svn_error_clear(err);
+    }
+
+  svn_pool_destroy(pool);
+
+  /* End thread explicitly to prevent APR_INCOMPLETE return codes in
+     apr_thread_join(). */
+  apr_thread_exit(thread, result);
+  return NULL;
+}
+
+/* Pass the prepared REV on to REVSTART_FUNC, the editor it returns and
+   REVFINISH_FUNC with REPLAY_BATON, just like replay_revision() would.
+   Use POOL for all of them. */
+static svn_error_t *
+play_revision(revision_t *rev,
+              svn_repos__replay_revstart_func_t revstart_func,
+              svn_repos__replay_revfinish_func_t revfinish_func,
+              void *replay_baton,
+              apr_pool_t *pool)
+{
+  const svn_delta_editor_t *editor;
+  void *edit_baton;
+  svn_error_t *err;
+
+  /* Failed before anything was sent? */
+  if (!rev->rev_props)
+    {
+      err = rev->err;
+      rev->err = SVN_NO_ERROR;
+      return svn_error_trace(err);
+    }
+
+  SVN_ERR(revstart_func(rev->revision, replay_baton, &editor, &edit_baton,
+                        rev->rev_props, pool));
+
+  /* Even a failed drive gets played back up to the point of failure. */
+  err = svn_delta__play_recording(rev->recording, editor, edit_baton,
+                                  pool);
+  if (!err)
+    {
+      err = rev->err;
+      rev->err = SVN_NO_ERROR;
+    }
+  if (err)
+    return svn_error_compose_create(err,
+                                    editor->abort_edit(edit_baton, pool));
+
+  return svn_error_trace(revfinish_func(rev->revision, replay_baton, editor,
+                                        edit_baton, rev->rev_props, pool));
+}
+
+#endif /* APR_HAS_THREADS */
+
+svn_error_t *
+svn_repos__replay_range(svn_repos_t *repos,
+                        const char *base_dir,
+                        svn_revnum_t start_revision,
+                        svn_revnum_t end_revision,
+                        svn_revnum_t low_water_mark,
+                        svn_boolean_t send_deltas,
+                        int threads,
+                        apr_hash_t *fs_config,
+                        svn_repos_authz_func_t authz_read_func,
+                        void *authz_read_baton,
+                        svn_repos__replay_revstart_func_t revstart_func,
+                        svn_repos__replay_revfinish_func_t revfinish_func,
+                        void *replay_baton,
+                        svn_cancel_func_t cancel_func,
+                        void *cancel_baton,
+                        apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool;
+  svn_revnum_t revision;
+
+#if APR_HAS_THREADS
+  /* A single revision leaves nothing to look ahead at. */
+  if (threads > 0 && start_revision < end_revision)
+    {
+      look_ahead_t *look_ahead = apr_pcalloc(scratch_pool,
+                                             sizeof(*look_ahead));
+      worker_t *workers = apr_pcalloc(scratch_pool,
+                                      threads * sizeof(*workers));
+      svn_error_t *err = SVN_NO_ERROR;
+      svn_error_t *sync_err;
+      int threads_started = 0;
+      int i;
+
+      /* The thread objects can't share the allocator with SCRATCH_POOL. */
+      apr_pool_t *thread_pool
+        = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+
+      SVN_ERR(svn_mutex__init(&look_ahead->mutex, TRUE, scratch_pool));
+      SVN_ERR(svn_mutex__init(&look_ahead->authz_mutex, TRUE,
+                              scratch_pool));
+      SVN_ERR(svn_thread_cond__create(&look_ahead->changed, scratch_pool));
+      look_ahead->next_revision = start_revision;
+      look_ahead->end_revision = end_revision;
+      look_ahead->next_to_play = start_revision;
+      look_ahead->slot_count = threads;
+      look_ahead->slots = apr_pcalloc(scratch_pool,
+                                      threads * sizeof(*look_ahead->slots));
+      look_ahead->repos_path = svn_repos_path(repos, scratch_pool);
+      look_ahead->fs_config = fs_config;
+      look_ahead->base_dir = base_dir;
+      look_ahead->low_water_mark = low_water_mark;
+      look_ahead->send_deltas = send_deltas;
+      look_ahead->authz_read_func = authz_read_func;
+      look_ahead->authz_read_baton = authz_read_baton;
+
+      for (i = 0; i < threads && !err; ++i)
+        {
+          apr_status_t status;
+          worker_t *worker = &workers[i];
+
+          worker->look_ahead = look_ahead;
+          status = apr_thread_create(&worker->thread, NULL, worker_thread,
+                                     worker, thread_pool);
+          if (status)
+            err = svn_error_wrap_apr(status,
+                                     _("Can't create replay thread"));
+          else
+            ++threads_started;
+        }
+
+      /* Play all revisions back strictly in order, while the workers
+         prepare the following ones. */
+      iterpool = svn_pool_create(scratch_pool);
+      for (revision = start_revision; revision <= end_revision && !err;
+           ++revision)
+        {
+          revision_t *rev;
+
+          svn_pool_clear(iterpool);
+
+          if (cancel_func)
+            err = cancel_func(cancel_baton);
+          if (!err)
+            err = svn_mutex__lock(look_ahead->mutex);
+          if (err)
+            break;
+
+          err = svn_mutex__unlock(look_ahead->mutex,
+                                  take_revision(&rev, look_ahead, revision));
+          if (err)
+            break;
+
+          err = play_revision(rev, revstart_func, revfinish_func,
+                              replay_baton, iterpool);
+
+          svn_error_clear(rev->err);
+          svn_pool_destroy(rev->pool);
+        }
+
+      /* Stop the workers.  They finish their current revision first. */
+      sync_err = svn_mutex__lock(look_ahead->mutex);
+      if (!sync_err)
+        sync_err = svn_mutex__unlock(look_ahead->mutex,
+                                     set_aborted(look_ahead));
+      err = svn_error_compose_create(err, sync_err);
+
+      for (i = 0; i < threads_started; ++i)
+        {
+          apr_status_t retval;
+          apr_status_t status = apr_thread_join(&retval, workers[i].thread);
+
+          if (status)
+            err = svn_error_compose_create(err,
+                                           svn_error_wrap_apr(status,
+                                             _("Can't join replay thread")));
+          else if (retval)
+            err = svn_error_compose_create(err,
+                                           svn_error_wrap_apr(retval,
+                                             _("Replay thread returned error")));
+        }
+
+      /* Release whatever the workers prepared in vain. */
+      for (i = 0; i < look_ahead->slot_count; ++i)
+        if (look_ahead->slots[i])
+          {
+            svn_error_clear(look_ahead->slots[i]->err);
+            svn_pool_destroy(look_ahead->slots[i]->pool);
+          }
+
+      svn_pool_destroy(iterpool);
+      svn_pool_destroy(thread_pool);
+
+      return svn_error_trace(err);
+    }
+#endif
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (revision = start_revision; revision <= end_revision; ++revision)
+    {
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(replay_revision(repos, revision, base_dir, low_water_mark,
+                              send_deltas, authz_read_func,
+                              authz_read_baton, revstart_func,
+                              revfinish_func, replay_baton, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
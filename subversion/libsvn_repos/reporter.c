@@ -21,6 +21,8 @@
  * ====================================================================
  */
 
+#include <apr_thread_proc.h>
+
 #include "svn_dirent_uri.h"
 #include "svn_hash.h"
 #include "svn_path.h"
@@ -36,7 +38,11 @@
 
 #include "private/svn_dep_compat.h"
 #include "private/svn_fspath.h"
+#include "private/svn_mutex.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_thread_cond.h"
+#include "private/svn_trace.h"
 #include "private/svn_string_private.h"
 
 #define NUM_CACHED_SOURCE_ROOTS 4
@@ -144,6 +150,16 @@ typedef struct report_baton_t
 
   /* This will not change. So, fetch it once and reuse it. */
   svn_string_t *repos_uuid;
+
+  /* Number of files whose text deltas may be prepared ahead of the
+     editor drive and the FS config to use for that.  See
+     svn_repos__report_set_prefetch(). */
+  int prefetch_files;
+  apr_hash_t *prefetch_fs_config;
+
+  /* The prefetch thread's state during the editor drive, or NULL. */
+  struct prefetcher_t *prefetcher;
+
   apr_pool_t *pool;
 } report_baton_t;
 
@@ -663,6 +679,594 @@ send_zero_copy_delta(const unsigned char *contents,
 }
 
 
+/* --- PREFETCHING TEXT DELTAS --- */
+
+/* Text deltas larger than this will not be kept in memory by the prefetch
+   thread.  The editor drive computes them itself instead. */
+#define PREFETCH_MAX_DELTA_SIZE 0x100000
+
+#if APR_HAS_THREADS
+
+/* States of a prefetch_job_t. */
+typedef enum prefetch_state_t
+{
+  prefetch_queued,
+  prefetch_running,
+  prefetch_done
+} prefetch_state_t;
+
+/* A file whose text delta the prefetch thread prepares ahead of the
+   editor drive. */
+typedef struct prefetch_job_t
+{
+  /* Root pool, using its own allocator, containing the job and its
+     results.  The job belongs to the prefetch thread while it is running
+     and to the editor drive otherwise. */
+  apr_pool_t *pool;
+
+  /* The delta to prepare.  S_PATH is NULL for deltas against the empty
+     file. */
+  svn_revnum_t s_rev;
+  const char *s_path;
+  const char *t_path;
+
+  /* Access serialized by the prefetcher's mutex. */
+  prefetch_state_t state;
+
+  /* Set by the editor drive if it won't use the running job.  The prefetch
+     thread will then destroy the job once it is done. */
+  svn_boolean_t abandoned;
+
+  /* Once the job is done, the complete list of delta windows, including
+     the final NULL window, or NULL if the delta could not be prepared. */
+  apr_array_header_t *windows;
+
+  /* Next job in the queue. */
+  struct prefetch_job_t *next;
+} prefetch_job_t;
+
+/* State shared between the editor drive and the prefetch thread. */
+struct prefetcher_t
+{
+  /* Serializes access to the queue, SHUTDOWN and the jobs' STATE and
+     ABANDONED members. */
+  svn_mutex__t *mutex;
+
+  /* Signaled when a job has been queued or the thread shall terminate. */
+  svn_thread_cond__t *job_queued;
+
+  /* Signaled when a job is done. */
+  svn_thread_cond__t *job_done;
+
+  /* Jobs not started by the prefetch thread, yet. */
+  prefetch_job_t *first_queued;
+  prefetch_job_t *last_queued;
+
+  /* Set by the editor drive to make the prefetch thread terminate. */
+  svn_boolean_t shutdown;
+
+  /* Map of const char * target paths to the prefetch_job_t * that the
+     editor drive has not claimed, yet.  Editor drive only. */
+  apr_hash_t *jobs;
+
+  /* Maximum number of entries in JOBS.  Read-only. */
+  int max_jobs;
+
+  /* Repository to open in the prefetch thread.  Read-only. */
+  const char *repos_path;
+  apr_hash_t *fs_config;
+  svn_revnum_t t_rev;
+
+  /* The prefetch thread and the pool it got allocated in. */
+  apr_thread_t *thread;
+  apr_pool_t *thread_pool;
+};
+
+/* The prefetch thread's view of the repository. */
+typedef struct prefetch_fs_t
+{
+  svn_fs_root_t *t_root;
+
+  /* The source root used last, if any. */
+  svn_fs_root_t *s_root;
+
+  /* Pool to allocate the roots in. */
+  apr_pool_t *pool;
+} prefetch_fs_t;
+
+/* Prepare the text delta described by JOB in the repository FS and add
+   the windows to JOB.  Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+prepare_delta(prefetch_job_t *job,
+              prefetch_fs_t *fs,
+              apr_pool_t *scratch_pool)
+{
+  svn_fs_root_t *s_root = NULL;
+  svn_txdelta_stream_t *dstream;
+  svn_txdelta_window_t *window;
+  apr_array_header_t *windows;
+  apr_size_t size = 0;
+  apr_pool_t *iterpool;
+
+  if (job->s_path)
+    {
+      svn_boolean_t changed;
+
+      if (   !fs->s_root
+          || svn_fs_revision_root_revision(fs->s_root) != job->s_rev)
+        {
+          if (fs->s_root)
+            svn_fs_close_root(fs->s_root);
+
+          fs->s_root = NULL;
+          SVN_ERR(svn_fs_revision_root(&fs->s_root,
+                                       svn_fs_root_fs(fs->t_root),
+                                       job->s_rev, fs->pool));
+        }
+      s_root = fs->s_root;
+
+      /* The editor drive won't ask for unchanged contents. */
+      SVN_ERR(svn_fs_contents_different(&changed, fs->t_root, job->t_path,
+                                        s_root, job->s_path, scratch_pool));
+      if (!changed)
+        return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_fs_get_file_delta_stream(&dstream, s_root, job->s_path,
+                                       fs->t_root, job->t_path,
+                                       scratch_pool));
+
+  windows = apr_array_make(job->pool, 16, sizeof(svn_txdelta_window_t *));
+  iterpool = svn_pool_create(scratch_pool);
+  do
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_txdelta_next_window(&window, dstream, iterpool));
+
+      if (window)
+        {
+          size += window->num_ops * sizeof(*window->ops);
+          if (window->new_data)
+            size += window->new_data->len;
+
+          /* Too large to keep.  Let the editor drive stream it. */
+          if (size > PREFETCH_MAX_DELTA_SIZE)
+            return SVN_NO_ERROR;
+
+          window = svn_txdelta_window_dup(window, job->pool);
+        }
+
+      APR_ARRAY_PUSH(windows, svn_txdelta_window_t *) = window;
+    }
+  while (window);
+
+  svn_pool_destroy(iterpool);
+  job->windows = windows;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *JOB to the next job in P's queue and mark it as running.  If the
+   prefetch thread shall terminate instead, set *JOB to NULL.  Call this
+   only while holding the mutex of P. */
+static svn_error_t *
+next_job(prefetch_job_t **job,
+         struct prefetcher_t *p)
+{
+  while (!p->shutdown && !p->first_queued)
+    SVN_ERR(svn_thread_cond__wait(p->job_queued, p->mutex));
+
+  if (p->shutdown)
+    {
+      *job = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  *job = p->first_queued;
+  p->first_queued = (*job)->next;
+  if (!p->first_queued)
+    p->last_queued = NULL;
+
+  (*job)->state = prefetch_running;
+
+  return SVN_NO_ERROR;
+}
+
+/* Mark JOB in P as done or, if it has been abandoned, destroy it.  Call
+   this only while holding the mutex of P. */
+static svn_error_t *
+finish_job(struct prefetcher_t *p,
+           prefetch_job_t *job)
+{
+  if (job->abandoned)
+    {
+      svn_pool_destroy(job->pool);
+      return SVN_NO_ERROR;
+    }
+
+  job->state = prefetch_done;
+
+  return svn_error_trace(svn_thread_cond__broadcast(p->job_done));
+}
+
+/* The plain APR thread function preparing text deltas.  DATA is the
+   prefetcher_t to take the jobs from. */
+static void * APR_THREAD_FUNC
+prefetch_thread(apr_thread_t *thread, void *data)
+{
+  struct prefetcher_t *p = data;
+
+  /* Use a separate single-threaded pool tree for minimum overhead. */
+  apr_pool_t *pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_status_t result = APR_SUCCESS;
+  prefetch_fs_t fs = { 0 };
+  svn_repos_t *repos;
+  svn_error_t *open_err;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  /* FS objects must not be shared between threads, so open our own.
+     If that fails, all jobs fail and the editor drive does the work. */
+  fs.pool = pool;
+  open_err = svn_repos_open3(&repos, p->repos_path, p->fs_config,
+                             pool, pool);
+  if (!open_err)
+    open_err = svn_fs_revision_root(&fs.t_root, svn_repos_fs(repos),
+                                    p->t_rev, pool);
+
+  while (!err)
+    {
+      prefetch_job_t *job;
+
+      err = svn_mutex__lock(p->mutex);
+      if (!err)
+        err = svn_mutex__unlock(p->mutex, next_job(&job, p));
+      if (err || !job)
+        break;
+
+      /* Failed jobs have no windows, which is all the editor drive needs
+         to know. */
+      svn_pool_clear(iterpool);
+      if (!open_err)
+        svn_error_clear(prepare_delta(job, &fs, iterpool));
+
+      err = svn_mutex__lock(p->mutex);
+      if (!err)
+        err = svn_mutex__unlock(p->mutex, finish_job(p, job));
+    }
+
+  if (err)
+    {
+      result = err->apr_err;
+      svn_error_clear(err);
+    }
+
+  svn_error_clear(open_err);
+  svn_pool_destroy(pool);
+
+  /* End thread explicitly to prevent APR_INCOMPLETE return codes in
+     apr_thread_join(). */
+  apr_thread_exit(thread, result);
+  return NULL;
+}
+
+/* Start the prefetch thread for B, if B has been configured to use one. */
+static svn_error_t *
+start_prefetcher(report_baton_t *b)
+{
+  struct prefetcher_t *p;
+  apr_status_t status;
+
+  if (b->prefetch_files <= 0 || !b->text_deltas)
+    return SVN_NO_ERROR;
+
+  p = apr_pcalloc(b->pool, sizeof(*p));
+  p->jobs = apr_hash_make(b->pool);
+  p->max_jobs = b->prefetch_files;
+  p->repos_path = svn_repos_path(b->repos, b->pool);
+  p->fs_config = b->prefetch_fs_config;
+  p->t_rev = b->t_rev;
+  SVN_ERR(svn_mutex__init(&p->mutex, TRUE, b->pool));
+  SVN_ERR(svn_thread_cond__create(&p->job_queued, b->pool));
+  SVN_ERR(svn_thread_cond__create(&p->job_done, b->pool));
+
+  /* The thread object can't share the allocator with B->POOL. */
+  p->thread_pool = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+
+  status = apr_thread_create(&p->thread, NULL, prefetch_thread, p,
+                             p->thread_pool);
+  if (status)
+    {
+      svn_pool_destroy(p->thread_pool);
+      return svn_error_wrap_apr(status, _("Can't create prefetch thread"));
+    }
+
+  b->prefetcher = p;
+
+  return SVN_NO_ERROR;
+}
+
+/* Make the prefetch thread of P terminate.  Call this only while holding
+   the mutex of P. */
+static svn_error_t *
+set_shutdown(struct prefetcher_t *p)
+{
+  p->shutdown = TRUE;
+
+  return svn_error_trace(svn_thread_cond__broadcast(p->job_queued));
+}
+
+/* Terminate the prefetch thread of B, if any, and release all jobs. */
+static svn_error_t *
+stop_prefetcher(report_baton_t *b)
+{
+  struct prefetcher_t *p = b->prefetcher;
+  apr_hash_index_t *hi;
+  apr_status_t status;
+  apr_status_t retval;
+  svn_error_t *err;
+
+  if (!p)
+    return SVN_NO_ERROR;
+
+  b->prefetcher = NULL;
+
+  err = svn_mutex__lock(p->mutex);
+  if (!err)
+    err = svn_mutex__unlock(p->mutex, set_shutdown(p));
+
+  /* Don't join a thread that we failed to tell to terminate. */
+  if (err)
+    return svn_error_trace(err);
+
+  status = apr_thread_join(&retval, p->thread);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't join prefetch thread"));
+
+  /* The thread is gone.  Abandoned jobs got destroyed by it already. */
+  for (hi = apr_hash_first(b->pool, p->jobs); hi; hi = apr_hash_next(hi))
+    {
+      prefetch_job_t *job = apr_hash_this_val(hi);
+      svn_pool_destroy(job->pool);
+    }
+
+  svn_pool_destroy(p->thread_pool);
+
+  if (retval)
+    return svn_error_wrap_apr(retval, _("Prefetch thread returned error"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Append JOB to the queue of P.  Call this only while holding the mutex
+   of P. */
+static svn_error_t *
+enqueue_job(struct prefetcher_t *p,
+            prefetch_job_t *job)
+{
+  if (p->last_queued)
+    p->last_queued->next = job;
+  else
+    p->first_queued = job;
+
+  p->last_queued = job;
+
+  return svn_error_trace(svn_thread_cond__signal(p->job_queued));
+}
+
+/* Queue a job for the text delta from S_REV/S_PATH to T_PATH in B,
+   unless B has enough unclaimed jobs already.  Set *QUEUED accordingly. */
+static svn_error_t *
+queue_prefetch(svn_boolean_t *queued,
+               report_baton_t *b,
+               svn_revnum_t s_rev,
+               const char *s_path,
+               const char *t_path)
+{
+  struct prefetcher_t *p = b->prefetcher;
+  apr_pool_t *pool;
+  prefetch_job_t *job;
+
+  *queued = FALSE;
+  if (apr_hash_count(p->jobs) >= (unsigned int)p->max_jobs)
+    return SVN_NO_ERROR;
+
+  /* Will be handed over to the prefetch thread. */
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+  job = apr_pcalloc(pool, sizeof(*job));
+  job->pool = pool;
+  job->s_rev = s_rev;
+  job->s_path = s_path ? apr_pstrdup(pool, s_path) : NULL;
+  job->t_path = apr_pstrdup(pool, t_path);
+  job->state = prefetch_queued;
+
+  svn_hash_sets(p->jobs, job->t_path, job);
+  SVN_MUTEX__WITH_LOCK(p->mutex, enqueue_job(p, job));
+
+  *queued = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Take JOB away from P.  If WAIT is set and the prefetch thread has
+   started JOB, wait for it to finish and return it in *RESULT.
+   Otherwise, set *RESULT to NULL, destroying JOB if the prefetch thread
+   does not own it.  Call this only while holding the mutex of P. */
+static svn_error_t *
+take_job(prefetch_job_t **result,
+         struct prefetcher_t *p,
+         prefetch_job_t *job,
+         svn_boolean_t wait)
+{
+  *result = NULL;
+
+  if (job->state == prefetch_queued)
+    {
+      prefetch_job_t **link = &p->first_queued;
+      prefetch_job_t *prev = NULL;
+
+      while (*link != job)
+        {
+          prev = *link;
+          link = &(*link)->next;
+        }
+
+      *link = job->next;
+      if (p->last_queued == job)
+        p->last_queued = prev;
+
+      svn_pool_destroy(job->pool);
+    }
+  else if (!wait)
+    {
+      if (job->state == prefetch_running)
+        job->abandoned = TRUE;
+      else
+        svn_pool_destroy(job->pool);
+    }
+  else
+    {
+      while (job->state != prefetch_done)
+        SVN_ERR(svn_thread_cond__wait(p->job_done, p->mutex));
+
+      *result = job;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove the job for T_PATH, if any, from B.  If it prepares the delta
+   from S_REV/S_PATH and WAIT is set, return it in *JOB once it is done.
+   Otherwise, discard the job and set *JOB to NULL. */
+static svn_error_t *
+claim_prefetch(prefetch_job_t **job,
+               report_baton_t *b,
+               svn_revnum_t s_rev,
+               const char *s_path,
+               const char *t_path,
+               svn_boolean_t wait)
+{
+  struct prefetcher_t *p = b->prefetcher;
+  prefetch_job_t *found = svn_hash_gets(p->jobs, t_path);
+
+  *job = NULL;
+  if (!found)
+    return SVN_NO_ERROR;
+
+  svn_hash_sets(p->jobs, t_path, NULL);
+
+  /* The drive might have taken a different route than predicted. */
+  if (wait)
+    wait = found->s_rev == s_rev
+        && (s_path ? found->s_path && strcmp(s_path, found->s_path) == 0
+                   : found->s_path == NULL);
+
+  SVN_MUTEX__WITH_LOCK(p->mutex, take_job(job, p, found, wait));
+
+  return SVN_NO_ERROR;
+}
+
+/* If B's prefetch thread prepared the text delta from S_REV/S_PATH to
+   T_PATH, send it to DHANDLER / DBATON and set *SENT.  Otherwise, clear
+   *SENT. */
+static svn_error_t *
+send_prefetched_delta(svn_boolean_t *sent,
+                      report_baton_t *b,
+                      svn_revnum_t s_rev,
+                      const char *s_path,
+                      const char *t_path,
+                      svn_txdelta_window_handler_t dhandler,
+                      void *dbaton)
+{
+  prefetch_job_t *job;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  *sent = FALSE;
+  if (!b->prefetcher)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(claim_prefetch(&job, b, s_rev, s_path, t_path, TRUE));
+  if (!job)
+    return SVN_NO_ERROR;
+
+  if (job->windows)
+    {
+      for (i = 0; i < job->windows->nelts && !err; ++i)
+        err = dhandler(APR_ARRAY_IDX(job->windows, i,
+                                     svn_txdelta_window_t *),
+                       dbaton);
+
+      *sent = TRUE;
+    }
+
+  svn_pool_destroy(job->pool);
+
+  return svn_error_trace(err);
+}
+
+/* Discard the job for T_PATH in B, if any. */
+static svn_error_t *
+discard_prefetch(report_baton_t *b,
+                 const char *t_path)
+{
+  prefetch_job_t *job;
+
+  if (!b->prefetcher)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(claim_prefetch(&job, b, SVN_INVALID_REVNUM, NULL,
+                                        t_path, FALSE));
+}
+
+#else
+
+static svn_error_t *
+start_prefetcher(report_baton_t *b)
+{
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+stop_prefetcher(report_baton_t *b)
+{
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+queue_prefetch(svn_boolean_t *queued,
+               report_baton_t *b,
+               svn_revnum_t s_rev,
+               const char *s_path,
+               const char *t_path)
+{
+  *queued = FALSE;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+send_prefetched_delta(svn_boolean_t *sent,
+                      report_baton_t *b,
+                      svn_revnum_t s_rev,
+                      const char *s_path,
+                      const char *t_path,
+                      svn_txdelta_window_handler_t dhandler,
+                      void *dbaton)
+{
+  *sent = FALSE;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+discard_prefetch(report_baton_t *b,
+                 const char *t_path)
+{
+  return SVN_NO_ERROR;
+}
+
+#endif /* APR_HAS_THREADS */
+
 /* Make the appropriate edits on FILE_BATON to change its contents and
    properties from those in S_REV/S_PATH to those in B->t_root/T_PATH,
    possibly using LOCK_TOKEN to determine if the client's lock on the file
@@ -711,6 +1315,14 @@ delta_files(report_baton_t *b, void *file_baton, svn_revnum_t s_rev,
     {
       if (b->text_deltas)
         {
+          svn_boolean_t sent;
+
+          /* The prefetch thread may have done all the work already. */
+          SVN_ERR(send_prefetched_delta(&sent, b, s_rev, s_path, t_path,
+                                        dhandler, dbaton));
+          if (sent)
+            return SVN_NO_ERROR;
+
           /* if we send deltas against empty streams, we may use our
              zero-copy code. */
           if (b->zero_copy_limit > 0 && s_path == NULL)
@@ -925,6 +1537,8 @@ update_entry(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
   svn_checksum_t *checksum;
   const char *hex_digest;
 
+  SVN_ERR(svn_repos__sched_checkpoint(b->repos));
+
   /* For non-switch operations, follow link_path in the target. */
   if (info && info->link_path && !b->is_switch)
     {
@@ -1096,6 +1710,54 @@ update_entry(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
     }
 }
 
+/* Queue prefetch jobs in B for the files in ENTRIES, the ordered target
+   dirents of T_PATH, starting at index *NEXT, until B has enough jobs.
+   Skip entries up to index CURRENT, which the editor drive has reached
+   already.  Predict the source of each file from S_REV, S_PATH,
+   S_ENTRIES, WC_DEPTH and REQUESTED_DEPTH just like delta_dirs() will.
+   Update *NEXT to the first entry not looked at.  Use POOL for temporary
+   allocations. */
+static svn_error_t *
+prefetch_entries(report_baton_t *b, int *next,
+                 const apr_array_header_t *entries, int current,
+                 svn_revnum_t s_rev, const char *s_path,
+                 apr_hash_t *s_entries, const char *t_path,
+                 svn_depth_t wc_depth, svn_depth_t requested_depth,
+                 apr_pool_t *pool)
+{
+  for (; *next < entries->nelts; ++*next)
+    {
+      const svn_fs_dirent_t *t_entry
+         = APR_ARRAY_IDX(entries, *next, svn_fs_dirent_t *);
+      const svn_fs_dirent_t *s_entry = NULL;
+      svn_boolean_t queued;
+
+      if (*next <= current || t_entry->kind != svn_node_file)
+        continue;
+
+      if (!is_depth_upgrade(wc_depth, requested_depth, svn_node_file))
+        {
+          if (requested_depth == svn_depth_unknown
+              && wc_depth < svn_depth_files)
+            continue;
+
+          s_entry = s_entries ? svn_hash_gets(s_entries, t_entry->name)
+                              : NULL;
+        }
+
+      SVN_ERR(queue_prefetch(&queued, b, s_rev,
+                             s_entry && s_entry->kind == svn_node_file
+                               ? svn_fspath__join(s_path, t_entry->name,
+                                                  pool)
+                               : NULL,
+                             svn_fspath__join(t_path, t_entry->name, pool)));
+      if (!queued)
+        break;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* A helper macro for when we have to recurse into subdirectories. */
 #define DEPTH_BELOW_HERE(depth) ((depth) == svn_depth_immediates) ? \
                                  svn_depth_empty : (depth)
@@ -1165,6 +1827,7 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
   apr_hash_index_t *hi;
   apr_pool_t *subpool = svn_pool_create(pool);
   apr_array_header_t *t_ordered_entries = NULL;
+  int prefetch_next = 0;
   int i;
 
   /* Compare the property lists.  If we're starting empty, pass a NULL
@@ -1179,16 +1842,36 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
       || requested_depth == svn_depth_unknown)
     {
       apr_pool_t *iterpool;
+      svn_boolean_t changed_only = FALSE;
 
-      /* Get the list of entries in each of source and target. */
+      /* Get the list of entries in each of source and target.
+
+         Unless we are upgrading the working copy depth, entries that are
+         the same on both sides and have no path info would not produce
+         any edits.  Only fetch the changed entries in that case, so we
+         skip unchanged subtrees without even looking at them. */
       if (s_path && !start_empty)
         {
           svn_fs_root_t *s_root;
 
           SVN_ERR(get_source_root(b, &s_root, s_rev));
-          SVN_ERR(svn_fs_dir_entries(&s_entries, s_root, s_path, subpool));
+          if (requested_depth == svn_depth_unknown
+              || requested_depth <= wc_depth)
+            {
+              SVN_ERR(svn_fs_dir_entries_changed(&s_entries, &t_entries,
+                                                 s_root, s_path,
+                                                 b->t_root, t_path,
+                                                 subpool, subpool));
+              changed_only = TRUE;
+            }
+          else
+            {
+              SVN_ERR(svn_fs_dir_entries(&s_entries, s_root, s_path,
+                                         subpool));
+            }
         }
-      SVN_ERR(svn_fs_dir_entries(&t_entries, b->t_root, t_path, subpool));
+      if (!changed_only)
+        SVN_ERR(svn_fs_dir_entries(&t_entries, b->t_root, t_path, subpool));
 
       /* Iterate over the report information for this directory. */
       iterpool = svn_pool_create(subpool);
@@ -1228,6 +1911,15 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
           s_fullpath = s_path ? svn_fspath__join(s_path, name, iterpool) : NULL;
           s_entry = s_entries ? svn_hash_gets(s_entries, name) : NULL;
 
+          /* A name filtered out on both sides is either the same node on
+             both sides or absent on both sides. */
+          if (changed_only && !t_entry && !s_entry)
+            {
+              SVN_ERR(fake_dirent(&t_entry, b->t_root, t_fullpath,
+                                  iterpool));
+              s_entry = t_entry;
+            }
+
           /* The only special cases where we don't process the entry are
 
              - When requested_depth is files but the reported path is
@@ -1314,6 +2006,12 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
 
           svn_pool_clear(iterpool);
 
+          /* Let the prefetch thread work on the files ahead. */
+          if (b->prefetcher)
+            SVN_ERR(prefetch_entries(b, &prefetch_next, t_ordered_entries,
+                                     i, s_rev, s_path, s_entries, t_path,
+                                     wc_depth, requested_depth, iterpool));
+
           if (is_depth_upgrade(wc_depth, requested_depth, t_entry->kind))
             {
               /* We're making the working copy deeper, pretend the source
@@ -1349,6 +2047,9 @@ delta_dirs(report_baton_t *b, svn_revnum_t s_rev, const char *s_path,
                                DEPTH_BELOW_HERE(wc_depth),
                                DEPTH_BELOW_HERE(requested_depth),
                                iterpool));
+
+          /* Unless used, the prefetched delta for this entry is obsolete. */
+          SVN_ERR(discard_prefetch(b, t_fullpath));
         }
 
       /* iterpool is destroyed by destroying its parent (subpool) below */
@@ -1472,9 +2173,12 @@ finish_report(report_baton_t *b, apr_pool_t *pool)
   for (i = 0; i < NUM_CACHED_SOURCE_ROOTS; i++)
     b->s_roots[i] = NULL;
 
+  SVN_ERR(start_prefetcher(b));
+
   {
     svn_error_t *err = svn_error_trace(drive(b, s_rev, info, pool));
 
+    err = svn_error_compose_create(err, stop_prefetcher(b));
     if (err == SVN_NO_ERROR)
       return svn_error_trace(b->editor->close_edit(b->edit_baton, pool));
 
@@ -1569,9 +2273,16 @@ svn_error_t *
 svn_repos_finish_report(void *baton, apr_pool_t *pool)
 {
   report_baton_t *b = baton;
+  svn_trace__span_t *span;
+  svn_error_t *err;
 
   SVN_ERR(svn_fs_refresh_revision_props(svn_repos_fs(b->repos), pool));
-  return svn_error_trace(finish_report(b, pool));
+
+  span = svn_trace__begin("repos", "finish-report", pool);
+  err = finish_report(b, pool);
+  svn_trace__end(span);
+
+  return svn_error_trace(err);
 }
 
 svn_error_t *
@@ -1635,8 +2346,22 @@ svn_repos_begin_report3(void **report_baton,
                                           1000000 /* maxsize */,
                                           pool);
   b->repos_uuid = svn_string_create(uuid, pool);
+  b->prefetch_files = 0;
+  b->prefetch_fs_config = NULL;
+  b->prefetcher = NULL;
 
   /* Hand reporter back to client. */
   *report_baton = b;
   return SVN_NO_ERROR;
 }
+
+void
+svn_repos__report_set_prefetch(void *report_baton,
+                               int files,
+                               apr_hash_t *fs_config)
+{
+  report_baton_t *b = report_baton;
+
+  b->prefetch_files = files;
+  b->prefetch_fs_config = fs_config;
+}
@@ -979,7 +979,22 @@ create_conf(svn_repos_t *repos, apr_pool_t *pool)
 ""                                                                           NL
 "### This sets the PATH environment variable for the pre-commit hook."       NL
 "[pre-commit]"                                                               NL
-"PATH = /usr/local/bin:/usr/bin:/usr/sbin"                                   NL;
+"PATH = /usr/local/bin:/usr/bin:/usr/sbin"                                   NL
+""                                                                           NL
+"### The [hook-runner] section is special.  Instead of starting a new"       NL
+"### process for each of the hooks listed in its 'hooks' option, the"        NL
+"### hook is handed to a long-lived hook runner process listening on"        NL
+"### 'address'.  This avoids the startup cost of e.g. script interpreters."  NL
+"### The hooks listed in 'async-hooks' are only queued by the runner, so"    NL
+"### commits and other operations don't wait for them to finish.  Only"      NL
+"### post-* hooks can be asynchronous.  If 'timeout' is given, fail hooks"   NL
+"### that the runner did not finish within that many seconds.  See"          NL
+"### tools/hook-scripts/hook-runner.py for an example runner."               NL
+"# [hook-runner]"                                                            NL
+"# address = localhost:3691"                                                 NL
+"# hooks = pre-commit"                                                       NL
+"# async-hooks = post-commit"                                                NL
+"# timeout = 60"                                                             NL;
 
     SVN_ERR_W(svn_io_file_create(svn_dirent_join(repos->conf_path,
                                                  SVN_REPOS__CONF_HOOKS_ENV \
@@ -997,16 +1012,20 @@ svn_repos_hooks_setenv(svn_repos_t *repos,
                        const char *hooks_env_path,
                        apr_pool_t *scratch_pool)
 {
+  const char *path;
+
   if (hooks_env_path == NULL)
-    repos->hooks_env_path = svn_dirent_join(repos->conf_path,
-                                            SVN_REPOS__CONF_HOOKS_ENV,
-                                            repos->pool);
+    path = svn_dirent_join(repos->conf_path, SVN_REPOS__CONF_HOOKS_ENV,
+                           scratch_pool);
   else if (!svn_dirent_is_absolute(hooks_env_path))
-    repos->hooks_env_path = svn_dirent_join(repos->conf_path,
-                                            hooks_env_path,
-                                            repos->pool);
+    path = svn_dirent_join(repos->conf_path, hooks_env_path, scratch_pool);
   else
-    repos->hooks_env_path = apr_pstrdup(repos->pool, hooks_env_path);
+    path = hooks_env_path;
+
+  /* Pooled repository objects get configured again and again by their
+     users.  Don't let REPOS->POOL grow each time. */
+  if (!repos->hooks_env_path || strcmp(repos->hooks_env_path, path))
+    repos->hooks_env_path = apr_pstrdup(repos->pool, path);
 
   return SVN_NO_ERROR;
 }
@@ -1197,6 +1216,10 @@ svn_repos_create(svn_repos_t **repos_p,
                                            result_pool)));
     }
 
+  /* Start the date index with revision 0. */
+  SVN_ERR(svn_repos__date_index_update(repos, TRUE, NULL, NULL,
+                                       scratch_pool));
+
   /* This repository is ready.  Stamp it with a format number. */
   SVN_ERR(svn_io_write_version_file
           (svn_dirent_join(path, SVN_REPOS__FORMAT, scratch_pool),
@@ -1478,6 +1501,10 @@ svn_repos_upgrade2(const char *path,
   SVN_ERR(svn_io_write_version_file(format_path, SVN_REPOS__FORMAT_NUMBER,
                                     subpool));
 
+  /* Repositories created by older releases have no date index yet. */
+  SVN_ERR(svn_fs_open2(&repos->fs, repos->db_path, NULL, subpool, subpool));
+  SVN_ERR(svn_repos__date_index_update(repos, TRUE, NULL, NULL, subpool));
+
   /* Close shop and free the subpool, to release the exclusive lock. */
   svn_pool_destroy(subpool);
 
@@ -1964,10 +1991,11 @@ fs_hotcopy_notify(void *baton,
 
 /* Make a copy of a repository with hot backup of fs. */
 svn_error_t *
-svn_repos_hotcopy3(const char *src_path,
+svn_repos_hotcopy4(const char *src_path,
                    const char *dst_path,
                    svn_boolean_t clean_logs,
                    svn_boolean_t incremental,
+                   int jobs,
                    svn_repos_notify_func_t notify_func,
                    void *notify_baton,
                    svn_cancel_func_t cancel_func,
@@ -2052,8 +2080,8 @@ svn_repos_hotcopy3(const char *src_path,
   fs_notify_baton.notify_func = notify_func;
   fs_notify_baton.notify_baton = notify_baton;
 
-  SVN_ERR(svn_fs_hotcopy3(src_repos->db_path, dst_repos->db_path,
-                          clean_logs, incremental,
+  SVN_ERR(svn_fs_hotcopy4(src_repos->db_path, dst_repos->db_path,
+                          clean_logs, incremental, jobs,
                           fs_notify_func, &fs_notify_baton,
                           cancel_func, cancel_baton, scratch_pool));
 
@@ -65,10 +65,14 @@ extern "C" {
 #define SVN_REPOS__LOCK_DIR    "locks"      /* Lock files live here. */
 #define SVN_REPOS__HOOK_DIR    "hooks"      /* Hook programs. */
 #define SVN_REPOS__CONF_DIR    "conf"       /* Configuration files. */
+#define SVN_REPOS__PATH_INDEX  "path-index" /* Optional path index. */
+#define SVN_REPOS__DATE_INDEX  "date-index" /* svn:date of all revisions. */
 
 /* Things for which we keep lockfiles. */
 #define SVN_REPOS__DB_LOCKFILE "db.lock" /* Our Berkeley lockfile. */
 #define SVN_REPOS__DB_LOGS_LOCKFILE "db-logs.lock" /* BDB logs lockfile. */
+#define SVN_REPOS__PATH_INDEX_LOCKFILE "path-index.lock" /* Index updates. */
+#define SVN_REPOS__DATE_INDEX_LOCKFILE "date-index.lock" /* Index updates. */
 
 /* In the repository hooks directory, look for these files. */
 #define SVN_REPOS__HOOK_START_COMMIT    "start-commit"
@@ -92,6 +96,9 @@ extern "C" {
 #define SVN_REPOS__CONF_HOOKS_ENV "hooks-env"
 /* The name of the default section in the hooks-env config file. */
 #define SVN_REPOS__HOOKS_ENV_DEFAULT_SECTION "default"
+/* The name of the section in the hooks-env config file that configures
+ * the persistent hook runner.  See run_hook_cmd(). */
+#define SVN_REPOS__HOOKS_ENV_RUNNER_SECTION "hook-runner"
 
 /* The configuration file for svnserve, in the repository conf directory. */
 #define SVN_REPOS__CONF_SVNSERVE_CONF "svnserve.conf"
@@ -153,6 +160,15 @@ struct svn_repos_t
      those constants' addresses, therefore). */
   apr_hash_t *repository_capabilities;
 
+  /* Number of threads that log requests may use to fetch path histories
+     and the FS config for them, see svn_repos__set_log_threads(). */
+  int log_threads;
+  apr_hash_t *log_fs_config;
+
+  /* The slot of the operation that svn_repos__scheduler_admit() admitted
+     on this repository, if any.  See svn_repos__sched_checkpoint(). */
+  struct sched_slot_t *sched_slot;
+
   /* Pool from which this structure was allocated.  Also used for
      auxiliary repository-related data that requires a matching
      lifespan.  (As the svn_repos_t structure tends to be relatively
@@ -387,6 +403,116 @@ svn_repos__prev_location(svn_revnum_t *appeared_rev,
                          const char *path,
                          apr_pool_t *pool);
 
+/* Like svn_repos_parse_dumpstream3() but read and parse STREAM in a
+   separate thread, concurrently with the PARSE_FNS callbacks being
+   invoked with PARSE_BATON in the current thread.  The callbacks will
+   see the same sequence of calls as with svn_repos_parse_dumpstream3(),
+   but svndiff data will always be decoded, even if the respective
+   apply_textdelta callback does not provide a window handler.
+
+   Call CANCEL_FUNC with CANCEL_BATON only from the current thread.
+   Memory usage is limited to a few MB in addition to what the callbacks
+   use.  If APR does not support threads, this is equivalent to calling
+   svn_repos_parse_dumpstream3().  Use POOL for all allocations. */
+svn_error_t *
+svn_repos__parse_dumpstream_pipelined(svn_stream_t *stream,
+                                      const svn_repos_parse_fns3_t *parse_fns,
+                                      void *parse_baton,
+                                      svn_boolean_t deltas_are_text,
+                                      svn_cancel_func_t cancel_func,
+                                      void *cancel_baton,
+                                      apr_pool_t *pool);
+
+
+/*** Path index. ***/
+
+/* An entry of the path index. */
+typedef struct svn_repos__path_index_entry_t
+{
+  /* Full path of the node. */
+  const char *path;
+
+  /* Node kind, svn_node_file or svn_node_dir. */
+  svn_node_kind_t kind;
+} svn_repos__path_index_entry_t;
+
+/* Use the path index of the repository containing the revision ROOT to
+   find the nodes below the directory PATH whose names may match any of
+   the PATTERNS, as in svn_repos_list().  Set *CANDIDATES to these nodes,
+   as svn_repos__path_index_entry_t in path order, allocated in
+   RESULT_POOL.  The caller must still match the names against PATTERNS.
+
+   Set *CANDIDATES to NULL if there is no usable index for ROOT, e.g.
+   because it has not been created or is not up to date with ROOT.
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_repos__path_index_lookup(apr_array_header_t **candidates,
+                             svn_fs_root_t *root,
+                             const char *path,
+                             const apr_array_header_t *patterns,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool);
+
+
+/*** Date index. ***/
+
+/* An open date index, see svn_repos__date_index_open(). */
+typedef struct svn_repos__date_index_t
+{
+  /* The index file. */
+  apr_file_t *file;
+
+  /* Number of revisions, starting at 0, that the index covers. */
+  svn_revnum_t count;
+} svn_repos__date_index_t;
+
+/* Add the svn:date of all revisions of REPOS that are not in its date
+   index yet to the index.  If the index does not exist, create it if
+   CREATE is set and do nothing otherwise.  Use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_repos__date_index_update(svn_repos_t *repos,
+                             svn_boolean_t create,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *scratch_pool);
+
+/* Update the entry for REVISION in the date index of REPOS after its
+   svn:date has been changed.  Use SCRATCH_POOL for temporary
+   allocations. */
+svn_error_t *
+svn_repos__date_index_refresh(svn_repos_t *repos,
+                              svn_revnum_t revision,
+                              apr_pool_t *scratch_pool);
+
+/* Open the date index of REPOS for reading and return it in *INDEX,
+   allocated in RESULT_POOL.  Set *INDEX to NULL if there is no index.
+   Use SCRATCH_POOL for temporary allocations. */
+svn_error_t *
+svn_repos__date_index_open(svn_repos__date_index_t **index,
+                           svn_repos_t *repos,
+                           apr_pool_t *result_pool,
+                           apr_pool_t *scratch_pool);
+
+/* Set *TM to the svn:date of REVISION according to INDEX and set *FOUND.
+   If INDEX is NULL, does not cover REVISION or the revision has no valid
+   date, set *FOUND to FALSE and leave *TM alone.  Use SCRATCH_POOL for
+   temporary allocations. */
+svn_error_t *
+svn_repos__date_index_get(apr_time_t *tm,
+                          svn_boolean_t *found,
+                          svn_repos__date_index_t *index,
+                          svn_revnum_t revision,
+                          apr_pool_t *scratch_pool);
+
+/* Call this regularly during long-running operations on REPOS.  If the
+   operation is a bulk request admitted by svn_repos__scheduler_admit()
+   that has held its slot for a while and interactive requests are waiting
+   for the same kind of operation, give the slot to them and wait to be
+   admitted again. */
+svn_error_t *
+svn_repos__sched_checkpoint(svn_repos_t *repos);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
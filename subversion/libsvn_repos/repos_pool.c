@@ -0,0 +1,410 @@
+/*
+ * repos_pool.c :  pool of opened repository objects
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
+
+#include "private/svn_mutex.h"
+#include "private/svn_repos_private.h"
+#include "private/svn_sorts_private.h"
+
+#include "svn_private_config.h"
+
+#include "repos.h"
+
+
+/* Maximum number of idle instances kept per key.  More than that will
+ * only be needed in bursts and it is cheaper to open them again than to
+ * keep them around indefinitely. */
+#define MAX_IDLE_PER_KEY 16
+
+/* Files whose status decides whether an idle repository instance may
+ * still be used.  They cover everything svn_repos_open3 and the FS
+ * backends read once and then keep in memory.  Paths are relative to
+ * the repository root. */
+static const char * const stamp_files[] =
+  {
+    SVN_REPOS__FORMAT,
+    SVN_REPOS__DB_DIR "/format",
+    SVN_REPOS__DB_DIR "/uuid",
+    SVN_REPOS__DB_DIR "/fsfs.conf",
+    NULL
+  };
+
+/* An opened repository, either idle in the pool or lent to a user.
+ */
+typedef struct repos_entry_t
+{
+  /* The pool that this entry belongs to. */
+  svn_repos__repos_pool_t *repos_pool;
+
+  /* Key under which this entry gets filed in REPOS_POOL. */
+  const char *key;
+
+  /* The repository object. */
+  svn_repos_t *repos;
+
+  /* Status of the STAMP_FILES when REPOS got opened. */
+  const char *stamp;
+
+  /* Next idle entry with the same key. */
+  struct repos_entry_t *next;
+
+  /* Root pool owning this instance and REPOS.  Each entry has its own
+   * allocator, so entries may be used from different threads. */
+  apr_pool_t *pool;
+} repos_entry_t;
+
+struct svn_repos__repos_pool_t
+{
+  /* Serializes access to IDLE. */
+  svn_mutex__t *mutex;
+
+  /* Maps keys to chains of idle repos_entry_t. */
+  apr_hash_t *idle;
+
+  /* Pool owning this structure. */
+  apr_pool_t *pool;
+};
+
+
+/* Return a key allocated in POOL that identifies repositories opened for
+ * PATH with FS_CONFIG and HOOKS_ENV.
+ */
+static const char *
+make_key(const char *path,
+         apr_hash_t *fs_config,
+         const char *hooks_env,
+         apr_pool_t *pool)
+{
+  svn_stringbuf_t *key = svn_stringbuf_create(path, pool);
+
+  svn_stringbuf_appendbyte(key, '\n');
+  if (hooks_env)
+    svn_stringbuf_appendcstr(key, hooks_env);
+
+  if (fs_config)
+    {
+      apr_array_header_t *sorted
+        = svn_sort__hash(fs_config, svn_sort_compare_items_lexically, pool);
+      int i;
+
+      for (i = 0; i < sorted->nelts; ++i)
+        {
+          svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i,
+                                                  svn_sort__item_t);
+          svn_stringbuf_appendbyte(key, '\n');
+          svn_stringbuf_appendcstr(key, item->key);
+          svn_stringbuf_appendbyte(key, '=');
+          svn_stringbuf_appendcstr(key, item->value);
+        }
+    }
+
+  return key->data;
+}
+
+/* Set *STAMP to a string allocated in POOL that describes the current
+ * state of the STAMP_FILES in the repository at PATH.
+ */
+static void
+get_stamp(const char **stamp,
+          const char *path,
+          apr_pool_t *pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  for (i = 0; stamp_files[i]; ++i)
+    {
+      apr_finfo_t finfo;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+      err = svn_io_stat(&finfo, svn_dirent_join(path, stamp_files[i],
+                                                iterpool),
+                        APR_FINFO_SIZE | APR_FINFO_MTIME | APR_FINFO_INODE,
+                        iterpool);
+
+      /* Missing files simply have no stamp.  Unreadable ones will make
+       * svn_repos_open3 fail, so we don't need to report them here. */
+      if (err)
+        {
+          svn_error_clear(err);
+          svn_stringbuf_appendcstr(result, "- ");
+        }
+      else
+        {
+          svn_stringbuf_appendcstr(result,
+                                   apr_psprintf(iterpool,
+                                                "%" APR_OFF_T_FMT
+                                                ":%" APR_TIME_T_FMT
+                                                ":%" APR_UINT64_T_FMT " ",
+                                                finfo.size, finfo.mtime,
+                                                (apr_uint64_t)finfo.inode));
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  *stamp = result->data;
+}
+
+/* Implements svn_fs_warning_callback_t.  Idle repositories have nobody
+ * to report warnings to. */
+static void
+ignore_warning(void *baton,
+               svn_error_t *err)
+{
+}
+
+/* Take the first idle entry for KEY from REPOS_POOL and return it in
+ * *ENTRY.  Set *ENTRY to NULL if there is none.
+ *
+ * Requires external serialization on REPOS_POOL.
+ */
+static svn_error_t *
+take_idle(repos_entry_t **entry,
+          svn_repos__repos_pool_t *repos_pool,
+          const char *key)
+{
+  *entry = svn_hash_gets(repos_pool->idle, key);
+  if (*entry)
+    {
+      /* Keys in the hash must live as long as the entries they map to. */
+      repos_entry_t *next = (*entry)->next;
+      svn_hash_sets(repos_pool->idle, (*entry)->key, NULL);
+      if (next)
+        svn_hash_sets(repos_pool->idle, next->key, next);
+
+      (*entry)->next = NULL;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Add ENTRY to the idle chain for its key in its pool, unless there are
+ * already enough idle instances for that key.  In that case, set *DISCARD
+ * to TRUE and leave ENTRY alone.
+ *
+ * Requires external serialization on ENTRY->REPOS_POOL.
+ */
+static svn_error_t *
+put_idle(svn_boolean_t *discard,
+         repos_entry_t *entry)
+{
+  svn_repos__repos_pool_t *repos_pool = entry->repos_pool;
+  repos_entry_t *first = svn_hash_gets(repos_pool->idle, entry->key);
+  repos_entry_t *iter;
+  int count = 0;
+
+  for (iter = first; iter; iter = iter->next)
+    ++count;
+
+  *discard = count >= MAX_IDLE_PER_KEY;
+  if (!*discard)
+    {
+      /* See take_idle() for why we remove and re-add the key. */
+      if (first)
+        svn_hash_sets(repos_pool->idle, first->key, NULL);
+
+      entry->next = first;
+      svn_hash_sets(repos_pool->idle, entry->key, entry);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Pool cleanup function returning the repos_entry_t BATON to its pool
+ * once the user's pool gets cleaned up.
+ */
+static apr_status_t
+return_entry(void *baton)
+{
+  repos_entry_t *entry = baton;
+  svn_repos_t *repos = entry->repos;
+  svn_boolean_t discard = TRUE;
+  svn_error_t *err;
+
+  /* Forget everything that belonged to the last user. */
+  err = svn_fs_set_access(repos->fs, NULL);
+  svn_fs_set_warning_func(repos->fs, ignore_warning, NULL);
+  repos->client_capabilities = NULL;
+  repos->log_threads = 0;
+  repos->log_fs_config = NULL;
+  repos->sched_slot = NULL;
+
+  if (!err)
+    err = svn_mutex__lock(entry->repos_pool->mutex);
+  if (!err)
+    err = svn_mutex__unlock(entry->repos_pool->mutex,
+                            put_idle(&discard, entry));
+
+  svn_error_clear(err);
+  if (discard)
+    svn_pool_destroy(entry->pool);
+
+  return APR_SUCCESS;
+}
+
+/* Pool cleanup function destroying all idle entries in the
+ * svn_repos__repos_pool_t given by BATON.
+ */
+static apr_status_t
+repos_pool_cleanup(void *baton)
+{
+  svn_repos__repos_pool_t *repos_pool = baton;
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(repos_pool->pool, repos_pool->idle);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      repos_entry_t *entry = apr_hash_this_val(hi);
+      while (entry)
+        {
+          repos_entry_t *next = entry->next;
+          svn_pool_destroy(entry->pool);
+          entry = next;
+        }
+    }
+
+  repos_pool->idle = NULL;
+  return APR_SUCCESS;
+}
+
+/* Open a new instance of the repository at PATH for KEY in REPOS_POOL,
+ * using FS_CONFIG and HOOKS_ENV, and return it in *ENTRY.  STAMP is the
+ * current state of the repository.  Use SCRATCH_POOL for temporaries.
+ */
+static svn_error_t *
+open_entry(repos_entry_t **entry,
+           svn_repos__repos_pool_t *repos_pool,
+           const char *key,
+           const char *path,
+           apr_hash_t *fs_config,
+           const char *hooks_env,
+           const char *stamp,
+           apr_pool_t *scratch_pool)
+{
+  apr_pool_t *pool
+    = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  repos_entry_t *result = apr_pcalloc(pool, sizeof(*result));
+  svn_error_t *err;
+
+  /* The FS keeps a reference to its config. */
+  if (fs_config)
+    {
+      apr_hash_index_t *hi;
+      apr_hash_t *config = apr_hash_make(pool);
+
+      for (hi = apr_hash_first(scratch_pool, fs_config);
+           hi;
+           hi = apr_hash_next(hi))
+        svn_hash_sets(config, apr_pstrdup(pool, apr_hash_this_key(hi)),
+                      apr_pstrdup(pool, apr_hash_this_val(hi)));
+
+      fs_config = config;
+    }
+
+  err = svn_repos_open3(&result->repos, path, fs_config, pool,
+                        scratch_pool);
+  if (!err)
+    err = svn_repos_hooks_setenv(result->repos, hooks_env, scratch_pool);
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  result->repos_pool = repos_pool;
+  result->key = apr_pstrdup(pool, key);
+  result->stamp = apr_pstrdup(pool, stamp);
+  result->pool = pool;
+
+  *entry = result;
+  return SVN_NO_ERROR;
+}
+
+
+/* API implementation */
+
+svn_error_t *
+svn_repos__repos_pool_create(svn_repos__repos_pool_t **repos_pool,
+                             svn_boolean_t thread_safe,
+                             apr_pool_t *pool)
+{
+  svn_repos__repos_pool_t *result = apr_pcalloc(pool, sizeof(*result));
+
+  SVN_ERR(svn_mutex__init(&result->mutex, thread_safe, pool));
+  result->idle = apr_hash_make(pool);
+  result->pool = pool;
+
+  apr_pool_cleanup_register(pool, result, repos_pool_cleanup,
+                            apr_pool_cleanup_null);
+
+  *repos_pool = result;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_repos__repos_pool_get(svn_repos_t **repos_p,
+                          svn_repos__repos_pool_t *repos_pool,
+                          const char *path,
+                          apr_hash_t *fs_config,
+                          const char *hooks_env,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  const char *key = make_key(path, fs_config, hooks_env, scratch_pool);
+  const char *stamp;
+  repos_entry_t *entry;
+
+  get_stamp(&stamp, path, scratch_pool);
+
+  /* Skip over idle instances that don't match the repository on disk
+   * anymore, e.g. after a hotcopy or svnadmin setuuid.  There usually
+   * are none or all of them are stale. */
+  while (TRUE)
+    {
+      SVN_MUTEX__WITH_LOCK(repos_pool->mutex,
+                           take_idle(&entry, repos_pool, key));
+      if (!entry || !strcmp(entry->stamp, stamp))
+        break;
+
+      svn_pool_destroy(entry->pool);
+    }
+
+  if (!entry)
+    SVN_ERR(open_entry(&entry, repos_pool, key, path, fs_config, hooks_env,
+                       stamp, scratch_pool));
+
+  apr_pool_cleanup_register(result_pool, entry, return_entry,
+                            apr_pool_cleanup_null);
+
+  *repos_p = entry->repos;
+  return SVN_NO_ERROR;
+}
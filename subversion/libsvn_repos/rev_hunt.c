@@ -39,6 +39,7 @@
 #include "repos.h"
 #include "private/svn_fspath.h"
 #include "private/svn_fs_private.h"
+#include "private/svn_fs_fs_private.h"
 #include "private/svn_sorts_private.h"
 
 
@@ -56,14 +57,21 @@
 
 /* helper for svn_repos_dated_revision().
 
-   Set *TM to the apr_time_t datestamp on revision REV in FS. */
+   Set *TM to the apr_time_t datestamp on revision REV in FS.  Take it
+   from INDEX if that is not NULL and knows REV. */
 static svn_error_t *
 get_time(apr_time_t *tm,
          svn_fs_t *fs,
+         svn_repos__date_index_t *index,
          svn_revnum_t rev,
          apr_pool_t *pool)
 {
   svn_string_t *date_str;
+  svn_boolean_t found;
+
+  SVN_ERR(svn_repos__date_index_get(tm, &found, index, rev, pool));
+  if (found)
+    return SVN_NO_ERROR;
 
   SVN_ERR(svn_fs_revision_prop2(&date_str, fs, rev, SVN_PROP_REVISION_DATE,
                                 FALSE, pool, pool));
@@ -75,27 +83,30 @@ get_time(apr_time_t *tm,
   return svn_time_from_cstring(tm, date_str->data, pool);
 }
 
+/* helper for svn_repos_dated_revision().
 
-svn_error_t *
-svn_repos_dated_revision(svn_revnum_t *revision,
-                         svn_repos_t *repos,
-                         apr_time_t tm,
-                         apr_pool_t *pool)
+   Set *REVISION to the youngest revision in FS up to REV_LATEST that
+   is not younger than TM, using binary search.  Get the revision dates
+   through get_time() with INDEX. */
+static svn_error_t *
+find_dated_revision(svn_revnum_t *revision,
+                    svn_fs_t *fs,
+                    svn_repos__date_index_t *index,
+                    svn_revnum_t rev_latest,
+                    apr_time_t tm,
+                    apr_pool_t *pool)
 {
-  svn_revnum_t rev_mid, rev_top, rev_bot, rev_latest;
+  svn_revnum_t rev_mid, rev_top, rev_bot;
   apr_time_t this_time;
-  svn_fs_t *fs = repos->fs;
 
   /* Initialize top and bottom values of binary search. */
-  SVN_ERR(svn_fs_youngest_rev(&rev_latest, fs, pool));
-  SVN_ERR(svn_fs_refresh_revision_props(fs, pool));
   rev_bot = 0;
   rev_top = rev_latest;
 
   while (rev_bot <= rev_top)
     {
       rev_mid = (rev_top + rev_bot) / 2;
-      SVN_ERR(get_time(&this_time, fs, rev_mid, pool));
+      SVN_ERR(get_time(&this_time, fs, index, rev_mid, pool));
 
       if (this_time > tm)/* we've overshot */
         {
@@ -108,7 +119,7 @@ svn_repos_dated_revision(svn_revnum_t *revision,
             }
 
           /* see if time falls between rev_mid and rev_mid-1: */
-          SVN_ERR(get_time(&previous_time, fs, rev_mid - 1, pool));
+          SVN_ERR(get_time(&previous_time, fs, index, rev_mid - 1, pool));
           if (previous_time <= tm)
             {
               *revision = rev_mid - 1;
@@ -129,7 +140,7 @@ svn_repos_dated_revision(svn_revnum_t *revision,
             }
 
           /* see if time falls between rev_mid and rev_mid+1: */
-          SVN_ERR(get_time(&next_time, fs, rev_mid + 1, pool));
+          SVN_ERR(get_time(&next_time, fs, index, rev_mid + 1, pool));
           if (next_time > tm)
             {
               *revision = rev_mid;
@@ -149,6 +160,81 @@ svn_repos_dated_revision(svn_revnum_t *revision,
   return SVN_NO_ERROR;
 }
 
+/* helper for svn_repos_dated_revision().
+
+   Look up the revision for TM in REPOS like find_dated_revision() but
+   using the date index of REPOS.  The index may be stale, e.g. if some
+   svn:date got changed without updating it.  Therefore, check the result
+   against the actual dates of *REVISION and its successor and set
+   *VALID accordingly.  Set *VALID to FALSE if there is no index. */
+static svn_error_t *
+find_dated_revision_indexed(svn_revnum_t *revision,
+                            svn_boolean_t *valid,
+                            svn_repos_t *repos,
+                            svn_revnum_t rev_latest,
+                            apr_time_t tm,
+                            apr_pool_t *pool)
+{
+  svn_repos__date_index_t *index;
+  apr_time_t this_time;
+
+  *valid = FALSE;
+  SVN_ERR(svn_repos__date_index_open(&index, repos, pool, pool));
+  if (!index)
+    return SVN_NO_ERROR;
+
+  *revision = SVN_INVALID_REVNUM;
+  SVN_ERR(find_dated_revision(revision, repos->fs, index, rev_latest, tm,
+                              pool));
+  SVN_ERR(svn_io_file_close(index->file, pool));
+  if (! SVN_IS_VALID_REVNUM(*revision))
+    return SVN_NO_ERROR;
+
+  if (*revision > 0)
+    {
+      SVN_ERR(get_time(&this_time, repos->fs, NULL, *revision, pool));
+      if (this_time > tm)
+        return SVN_NO_ERROR;
+    }
+
+  if (*revision < rev_latest)
+    {
+      SVN_ERR(get_time(&this_time, repos->fs, NULL, *revision + 1, pool));
+      if (this_time <= tm)
+        return SVN_NO_ERROR;
+    }
+
+  *valid = TRUE;
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_repos_dated_revision(svn_revnum_t *revision,
+                         svn_repos_t *repos,
+                         apr_time_t tm,
+                         apr_pool_t *pool)
+{
+  svn_revnum_t rev_latest;
+  svn_fs_t *fs = repos->fs;
+  svn_boolean_t valid;
+  svn_error_t *err;
+
+  SVN_ERR(svn_fs_youngest_rev(&rev_latest, fs, pool));
+  SVN_ERR(svn_fs_refresh_revision_props(fs, pool));
+
+  /* The date index usually spares us reading ~2 log2(REV_LATEST) revprops.
+     Should it fail us, fall back to the plain search. */
+  err = find_dated_revision_indexed(revision, &valid, repos, rev_latest, tm,
+                                    pool);
+  if (!err && valid)
+    return SVN_NO_ERROR;
+
+  svn_error_clear(err);
+  return svn_error_trace(find_dated_revision(revision, fs, NULL, rev_latest,
+                                             tm, pool));
+}
+
 
 svn_error_t *
 svn_repos_get_committed_info(svn_revnum_t *committed_rev,
@@ -304,6 +390,50 @@ svn_repos_history2(svn_fs_t *fs,
 }
 
 
+/* Set *LOWER to TRUE, if the node at PATH in START_ROOT has been deleted
+   at or before REV in FS, i.e. if we have to look at lower revisions to
+   find the deletion.  See the matrix in svn_repos_deleted_rev().
+   Use POOL for temporaries. */
+static svn_error_t *
+is_deleted_at(svn_boolean_t *lower,
+              svn_fs_t *fs,
+              svn_fs_root_t *start_root,
+              const char *path,
+              svn_revnum_t rev,
+              apr_pool_t *pool)
+{
+  svn_fs_root_t *root, *copy_root;
+  const char *copy_path;
+  svn_node_kind_t kind;
+  svn_fs_node_relation_t node_relation;
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_check_path(&kind, root, path, pool));
+  if (kind == svn_node_none)
+    {
+      /* Case D. */
+      *lower = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_fs_node_relation(&node_relation, start_root, path,
+                               root, path, pool));
+  if (node_relation == svn_fs_node_unrelated)
+    {
+      /* Case C. */
+      *lower = TRUE;
+      return SVN_NO_ERROR;
+    }
+
+  /* Cases A and B vs. E and F. */
+  SVN_ERR(svn_fs_closest_copy(&copy_root, &copy_path, root, path, pool));
+  *lower = copy_root
+        && (svn_fs_revision_root_revision(copy_root)
+              > svn_fs_revision_root_revision(start_root));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_repos_deleted_rev(svn_fs_t *fs,
                       const char *path,
@@ -432,8 +562,65 @@ svn_repos_deleted_rev(svn_fs_t *fs,
      node          |     look LOWER                                     |
                    |                                                    |
      --------------------------------------------------------------------
+
+     The node at PATH may only change in revisions that touched PATH or
+     one of its parents.  If the backend can tell us which revisions those
+     are, we only need to search the latter.
   */
 
+  {
+    svn_fs_fs__ioctl_changed_revs_input_t input = { 0 };
+    svn_fs_fs__ioctl_changed_revs_output_t *output;
+    svn_error_t *err;
+
+    input.path = path;
+    input.start_rev = start + 1;
+    input.end_rev = end;
+    input.include_descendants = FALSE;
+
+    err = svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_CHANGED_REVS, &input,
+                       (void **)&output, NULL, NULL, pool, pool);
+    if (err && err->apr_err == SVN_ERR_FS_UNRECOGNIZED_IOCTL_CODE)
+      {
+        /* Not FSFS.  Use the generic search below. */
+        svn_error_clear(err);
+      }
+    else
+      {
+        apr_array_header_t *revisions;
+        int low, high;
+
+        SVN_ERR(err);
+        revisions = output->revisions;
+
+        /* Find the first candidate at which the start node is gone. */
+        iterpool = svn_pool_create(pool);
+        low = 0;
+        high = revisions->nelts;
+        while (low < high)
+          {
+            int mid = low + (high - low) / 2;
+            svn_boolean_t lower;
+
+            svn_pool_clear(iterpool);
+            SVN_ERR(is_deleted_at(&lower, fs, start_root, path,
+                                  APR_ARRAY_IDX(revisions, mid, svn_revnum_t),
+                                  iterpool));
+            if (lower)
+              high = mid;
+            else
+              low = mid + 1;
+          }
+
+        svn_pool_destroy(iterpool);
+        if (low < revisions->nelts)
+          {
+            *deleted = APR_ARRAY_IDX(revisions, low, svn_revnum_t);
+            return SVN_NO_ERROR;
+          }
+      }
+  }
+
   mid_rev = (start + end) / 2;
   iterpool = svn_pool_create(pool);
 
@@ -757,31 +944,25 @@ svn_repos_trace_node_locations(svn_fs_t *fs,
 
   /* There are no copies relevant to path@revision.  So any remaining
      revisions either predate the creation of path@revision or have
-     the node existing at the same path.  We will look up path@lrev
-     for each remaining location-revision and make sure it is related
-     to path@revision. */
-  SVN_ERR(svn_fs_revision_root(&root, fs, revision, lastpool));
-  while (revision_ptr < revision_ptr_end)
+     the node existing at the same path.  Without a copy, the node can
+     neither have left PATH nor come back to it, i.e. it existed there
+     in every revision since its revision of origin.  So, a single
+     origin lookup replaces checking each location-revision in turn. */
+  if (revision_ptr < revision_ptr_end)
     {
-      svn_node_kind_t kind;
-      svn_fs_node_relation_t node_relation;
-      svn_fs_root_t *cur_rev_root;
+      svn_revnum_t origin_rev;
 
-      svn_pool_clear(currpool);
-      SVN_ERR(svn_fs_revision_root(&cur_rev_root, fs, *revision_ptr,
-                                   currpool));
-      SVN_ERR(svn_fs_check_path(&kind, cur_rev_root, path, currpool));
-      if (kind == svn_node_none)
-        break;
-      SVN_ERR(svn_fs_node_relation(&node_relation, root, path,
-                                   cur_rev_root, path, currpool));
-      if (node_relation == svn_fs_node_unrelated)
-        break;
+      SVN_ERR(svn_fs_revision_root(&root, fs, revision, lastpool));
+      SVN_ERR(svn_fs_node_origin_rev(&origin_rev, root, path, lastpool));
 
-      /* The node exists at the same path; record that and advance. */
-      apr_hash_set(*locations, revision_ptr, sizeof(*revision_ptr),
-                   apr_pstrdup(pool, path));
-      revision_ptr++;
+      path = apr_pstrdup(pool, path);
+      while ((revision_ptr < revision_ptr_end)
+             && (*revision_ptr >= origin_rev))
+        {
+          apr_hash_set(*locations, revision_ptr, sizeof(*revision_ptr),
+                       path);
+          revision_ptr++;
+        }
     }
 
   /* Ignore any remaining location-revisions; they predate the
@@ -1372,6 +1553,7 @@ send_path_revision(struct path_revision *path_rev,
   svn_boolean_t props_changed;
 
   svn_pool_clear(sb->iterpool);
+  SVN_ERR(svn_repos__sched_checkpoint(repos));
 
   /* Get the revision properties. */
   SVN_ERR(svn_fs_revision_proplist2(&rev_props, repos->fs,
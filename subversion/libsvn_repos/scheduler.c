@@ -0,0 +1,288 @@
+/*
+ * scheduler.c :  admission control for expensive server operations
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#include "svn_hash.h"
+#include "svn_pools.h"
+
+#include "private/svn_mutex.h"
+#include "private/svn_repos_private.h"
+#include "private/svn_thread_cond.h"
+
+#include "svn_private_config.h"
+
+#include "repos.h"
+
+
+/* Minimum time that a bulk operation keeps its slot before it gives it
+ * to waiting interactive operations. */
+#define SCHED_QUANTUM (APR_USEC_PER_SEC / 10)
+
+/* Admission state of one kind of operation.
+ */
+typedef struct op_state_t
+{
+  /* Maximum number of concurrent operations; 0 for no limit. */
+  int limit;
+
+  /* Number of operations admitted, and how many of them are bulk ones. */
+  int active;
+  int active_bulk;
+
+  /* Number of interactive operations waiting to be admitted. */
+  int waiting_interactive;
+} op_state_t;
+
+struct svn_repos__scheduler_t
+{
+  /* Serializes access to OPS. */
+  svn_mutex__t *mutex;
+
+  /* Signalled whenever a slot gets released. */
+  svn_thread_cond__t *released;
+
+  /* Per svn_repos__sched_op_t. */
+  op_state_t ops[SVN_REPOS__SCHED_OP_COUNT];
+
+  /* Names of the users with bulk priority, mapped to themselves. */
+  apr_hash_t *bulk_users;
+};
+
+/* An operation admitted by svn_repos__scheduler_admit().
+ */
+typedef struct sched_slot_t
+{
+  svn_repos__scheduler_t *scheduler;
+  svn_repos__sched_op_t op;
+  svn_repos__sched_class_t sched_class;
+
+  /* The repository that the operation runs on. */
+  svn_repos_t *repos;
+
+  /* The slot that was set on REPOS before this one. */
+  struct sched_slot_t *previous;
+
+  /* Time when the operation was admitted last. */
+  apr_time_t admitted;
+
+  /* Whether the operation currently holds a slot. */
+  svn_boolean_t held;
+} sched_slot_t;
+
+svn_error_t *
+svn_repos__scheduler_create(svn_repos__scheduler_t **scheduler,
+                            const int *limits,
+                            const apr_array_header_t *bulk_users,
+                            apr_pool_t *pool)
+{
+  svn_repos__scheduler_t *result = apr_pcalloc(pool, sizeof(*result));
+  int i;
+
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, pool));
+  SVN_ERR(svn_thread_cond__create(&result->released, pool));
+
+  for (i = 0; i < SVN_REPOS__SCHED_OP_COUNT; ++i)
+    result->ops[i].limit = MAX(limits[i], 0);
+
+  result->bulk_users = apr_hash_make(pool);
+  for (i = 0; bulk_users && i < bulk_users->nelts; ++i)
+    {
+      const char *user = apr_pstrdup(pool, APR_ARRAY_IDX(bulk_users, i,
+                                                         const char *));
+      svn_hash_sets(result->bulk_users, user, user);
+    }
+
+  *scheduler = result;
+  return SVN_NO_ERROR;
+}
+
+svn_repos__sched_class_t
+svn_repos__scheduler_classify(svn_repos__scheduler_t *scheduler,
+                              const char *user)
+{
+  if (user && svn_hash_gets(scheduler->bulk_users, user))
+    return svn_repos__sched_bulk;
+
+  return svn_repos__sched_interactive;
+}
+
+/* Return TRUE if an operation of priority SCHED_CLASS may start in STATE.
+ */
+static svn_boolean_t
+may_start(const op_state_t *state,
+          svn_repos__sched_class_t sched_class)
+{
+  if (state->limit == 0)
+    return TRUE;
+
+  if (state->active >= state->limit)
+    return FALSE;
+
+  if (sched_class == svn_repos__sched_interactive)
+    return TRUE;
+
+  /* Bulk operations queue behind interactive ones and leave the last slot
+     to them. */
+  return state->waiting_interactive == 0
+      && (state->limit == 1 || state->active_bulk < state->limit - 1);
+}
+
+/* Wait until SLOT may start and take it.  The scheduler's mutex must be
+ * held by the caller.
+ */
+static svn_error_t *
+acquire(sched_slot_t *slot)
+{
+  svn_repos__scheduler_t *scheduler = slot->scheduler;
+  op_state_t *state = &scheduler->ops[slot->op];
+  svn_boolean_t interactive
+    = slot->sched_class == svn_repos__sched_interactive;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  if (interactive)
+    ++state->waiting_interactive;
+
+  while (!err && !may_start(state, slot->sched_class))
+    err = svn_thread_cond__wait(scheduler->released, scheduler->mutex);
+
+  if (interactive)
+    --state->waiting_interactive;
+  SVN_ERR(err);
+
+  ++state->active;
+  if (!interactive)
+    ++state->active_bulk;
+
+  slot->held = TRUE;
+  slot->admitted = apr_time_now();
+
+  return SVN_NO_ERROR;
+}
+
+/* Give up the slot held by SLOT.  The scheduler's mutex must be held by
+ * the caller.
+ */
+static svn_error_t *
+release(sched_slot_t *slot)
+{
+  op_state_t *state = &slot->scheduler->ops[slot->op];
+
+  if (!slot->held)
+    return SVN_NO_ERROR;
+
+  --state->active;
+  if (slot->sched_class == svn_repos__sched_bulk)
+    --state->active_bulk;
+  slot->held = FALSE;
+
+  return svn_error_trace(svn_thread_cond__broadcast(
+                           slot->scheduler->released));
+}
+
+/* Pool cleanup function releasing the sched_slot_t BATON.
+ */
+static apr_status_t
+release_slot(void *baton)
+{
+  sched_slot_t *slot = baton;
+  svn_error_t *err;
+
+  slot->repos->sched_slot = slot->previous;
+
+  err = svn_mutex__lock(slot->scheduler->mutex);
+  if (!err)
+    err = svn_mutex__unlock(slot->scheduler->mutex, release(slot));
+
+  svn_error_clear(err);
+  return APR_SUCCESS;
+}
+
+svn_error_t *
+svn_repos__scheduler_admit(svn_repos__scheduler_t *scheduler,
+                           svn_repos_t *repos,
+                           svn_repos__sched_op_t op,
+                           svn_repos__sched_class_t sched_class,
+                           apr_pool_t *result_pool)
+{
+  sched_slot_t *slot;
+
+  /* Unlimited operations don't need any bookkeeping.  Neither do single-
+     threaded servers which can't run operations concurrently anyway. */
+#if APR_HAS_THREADS
+  if (scheduler->ops[op].limit == 0)
+    return SVN_NO_ERROR;
+#else
+  return SVN_NO_ERROR;
+#endif
+
+  slot = apr_pcalloc(result_pool, sizeof(*slot));
+  slot->scheduler = scheduler;
+  slot->op = op;
+  slot->sched_class = sched_class;
+  slot->repos = repos;
+
+  SVN_MUTEX__WITH_LOCK(scheduler->mutex, acquire(slot));
+
+  slot->previous = repos->sched_slot;
+  repos->sched_slot = slot;
+  apr_pool_cleanup_register(result_pool, slot, release_slot,
+                            apr_pool_cleanup_null);
+
+  return SVN_NO_ERROR;
+}
+
+/* Let SLOT give its slot to waiting interactive operations, if any, and
+ * take it again afterwards.  The scheduler's mutex must be held by the
+ * caller.
+ */
+static svn_error_t *
+yield(sched_slot_t *slot)
+{
+  if (!slot->held)
+    return SVN_NO_ERROR;
+
+  if (slot->scheduler->ops[slot->op].waiting_interactive == 0)
+    {
+      slot->admitted = apr_time_now();
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(release(slot));
+  return svn_error_trace(acquire(slot));
+}
+
+svn_error_t *
+svn_repos__sched_checkpoint(svn_repos_t *repos)
+{
+  sched_slot_t *slot = repos->sched_slot;
+
+  if (   !slot
+      || slot->sched_class != svn_repos__sched_bulk
+      || apr_time_now() - slot->admitted < SCHED_QUANTUM)
+    return SVN_NO_ERROR;
+
+  SVN_MUTEX__WITH_LOCK(slot->scheduler->mutex, yield(slot));
+
+  return SVN_NO_ERROR;
+}
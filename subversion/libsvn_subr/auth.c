@@ -27,6 +27,8 @@
 #include <apr_strings.h>
 
 #include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_sorts.h"
 #include "svn_types.h"
 #include "svn_string.h"
 #include "svn_error.h"
@@ -37,6 +39,7 @@
 #include "svn_version.h"
 #include "private/svn_auth_private.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_mutex.h"
 
 #include "auth.h"
 
@@ -98,21 +101,46 @@ typedef struct provider_set_t
 } provider_set_t;
 
 
+/* An entry in the run-time credentials cache. */
+typedef struct cached_creds_t
+{
+  /* The credentials themselves. */
+  void *creds;
+
+  /* Index of the provider that produced CREDS in its provider_set_t. */
+  int provider_idx;
+
+  /* When CREDS were obtained from the provider. */
+  apr_time_t fetched;
+
+  /* Whether CREDS have already been saved successfully. */
+  svn_boolean_t saved;
+} cached_creds_t;
+
 /* The main auth baton. */
 struct svn_auth_baton_t
 {
   /* a collection of tables.  maps cred_kind -> provider_set */
   apr_hash_t *tables;
 
-  /* the pool I'm allocated in. */
+  /* the pool holding the credentials.  It has its own, thread-safe
+     allocator, so the baton may be used by multiple threads. */
   apr_pool_t *pool;
 
   /* run-time parameters needed by providers. */
   apr_hash_t *parameters;
   apr_hash_t *slave_parameters;
 
-  /* run-time credentials cache. */
+  /* run-time credentials cache.  maps cache key -> cached_creds_t */
   apr_hash_t *creds_cache;
+
+  /* Cached credentials older than this get fetched again.  0 means that
+     they never expire. */
+  apr_interval_time_t creds_cache_ttl;
+
+  /* serializes all access to CREDS_CACHE and POOL, i.e. the calls to the
+     providers.  Shared with the session batons.  May be NULL. */
+  svn_mutex__t *mutex;
 };
 
 /* Abstracted iteration baton */
@@ -121,6 +149,7 @@ struct svn_auth_iterstate_t
   provider_set_t *table;        /* the table being searched */
   int provider_idx;             /* the current provider (row) */
   svn_boolean_t got_first;      /* did we get the provider's first creds? */
+  cached_creds_t *cached;       /* the cache entry served, if any */
   void *provider_iter_baton;    /* the provider's own iteration context */
   const char *realmstring;      /* The original realmstring passed in */
   const char *cache_key;        /* key to use in auth_baton's creds_cache */
@@ -130,6 +159,14 @@ struct svn_auth_iterstate_t
 
 
 
+/* Pool cleanup function destroying the pool given as DATA. */
+static apr_status_t
+destroy_creds_pool(void *data)
+{
+  svn_pool_destroy(data);
+  return APR_SUCCESS;
+}
+
 void
 svn_auth_open(svn_auth_baton_t **auth_baton,
               const apr_array_header_t *providers,
@@ -137,6 +174,7 @@ svn_auth_open(svn_auth_baton_t **auth_baton,
 {
   svn_auth_baton_t *ab;
   svn_auth_provider_object_t *provider;
+  svn_error_t *err;
   int i;
 
   /* Build the auth_baton. */
@@ -144,8 +182,21 @@ svn_auth_open(svn_auth_baton_t **auth_baton,
   ab->tables = apr_hash_make(pool);
   ab->parameters = apr_hash_make(pool);
   /* ab->slave_parameters = NULL; */
-  ab->creds_cache = apr_hash_make(pool);
-  ab->pool = pool;
+
+  /* Credentials may be requested by RA sessions running in other threads
+     than the one owning POOL, so they get a separate allocator. */
+  ab->pool = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+  apr_pool_cleanup_register(pool, ab->pool, destroy_creds_pool,
+                            apr_pool_cleanup_null);
+  ab->creds_cache = apr_hash_make(ab->pool);
+
+  /* Without a mutex, the baton still works for a single thread. */
+  err = svn_mutex__init(&ab->mutex, TRUE, pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      ab->mutex = NULL;
+    }
 
   /* Register each provider in order.  Providers of different
      credentials will be automatically sorted into different tables by
@@ -223,13 +274,52 @@ make_cache_key(const char *cred_kind,
   return apr_pstrcat(pool, cred_kind, ":", realmstring, SVN_VA_NULL);
 }
 
-svn_error_t *
-svn_auth_first_credentials(void **credentials,
-                           svn_auth_iterstate_t **state,
-                           const char *cred_kind,
-                           const char *realmstring,
-                           svn_auth_baton_t *auth_baton,
-                           apr_pool_t *pool)
+/* Return the unexpired entry of AUTH_BATON's credentials cache for
+   CACHE_KEY, or NULL if there is none.  Expired entries get removed. */
+static cached_creds_t *
+get_cached_creds(svn_auth_baton_t *auth_baton,
+                 const char *cache_key)
+{
+  cached_creds_t *entry = svn_hash_gets(auth_baton->creds_cache, cache_key);
+
+  if (   entry
+      && auth_baton->creds_cache_ttl
+      && apr_time_now() - entry->fetched >= auth_baton->creds_cache_ttl)
+    {
+      svn_hash_sets(auth_baton->creds_cache, cache_key, NULL);
+      entry = NULL;
+    }
+
+  return entry;
+}
+
+/* Cache CREDS, produced by the provider at PROVIDER_IDX, in AUTH_BATON
+   under CACHE_KEY. */
+static void
+set_cached_creds(svn_auth_baton_t *auth_baton,
+                 const char *cache_key,
+                 void *creds,
+                 int provider_idx)
+{
+  cached_creds_t *entry = apr_pcalloc(auth_baton->pool, sizeof(*entry));
+
+  entry->creds = creds;
+  entry->provider_idx = provider_idx;
+  entry->fetched = apr_time_now();
+
+  svn_hash_sets(auth_baton->creds_cache,
+                apr_pstrdup(auth_baton->pool, cache_key), entry);
+}
+
+/* The guts of svn_auth_first_credentials(), to be called while holding
+   AUTH_BATON->MUTEX. */
+static svn_error_t *
+first_credentials(void **credentials,
+                  svn_auth_iterstate_t **state,
+                  const char *cred_kind,
+                  const char *realmstring,
+                  svn_auth_baton_t *auth_baton,
+                  apr_pool_t *pool)
 {
   int i = 0;
   provider_set_t *table;
@@ -239,12 +329,9 @@ svn_auth_first_credentials(void **credentials,
   svn_boolean_t got_first = FALSE;
   svn_auth_iterstate_t *iterstate;
   const char *cache_key;
+  cached_creds_t *cached;
   apr_hash_t *parameters;
 
-  if (! auth_baton)
-    return svn_error_create(SVN_ERR_AUTHN_NO_PROVIDER, NULL,
-                            _("No authentication providers registered"));
-
   /* Get the appropriate table of providers for CRED_KIND. */
   table = svn_hash_gets(auth_baton->tables, cred_kind);
   if (! table)
@@ -272,11 +359,15 @@ svn_auth_first_credentials(void **credentials,
   else
     parameters = auth_baton->parameters;
 
-  /* First, see if we have cached creds in the auth_baton. */
+  /* First, see if we have cached creds in the auth_baton.  Should they
+     be rejected, continue with the provider that produced them; the
+     ones before it had nothing to offer. */
   cache_key = make_cache_key(cred_kind, realmstring, pool);
-  creds = svn_hash_gets(auth_baton->creds_cache, cache_key);
-  if (creds)
+  cached = get_cached_creds(auth_baton, cache_key);
+  if (cached)
     {
+       creds = cached->creds;
+       i = cached->provider_idx;
        got_first = FALSE;
     }
   else
@@ -312,6 +403,7 @@ svn_auth_first_credentials(void **credentials,
       iterstate->table = table;
       iterstate->provider_idx = i;
       iterstate->got_first = got_first;
+      iterstate->cached = cached;
       iterstate->provider_iter_baton = iter_baton;
       iterstate->realmstring = apr_pstrdup(pool, realmstring);
       iterstate->cache_key = cache_key;
@@ -320,9 +412,8 @@ svn_auth_first_credentials(void **credentials,
       *state = iterstate;
 
       /* Put the creds in the cache */
-      svn_hash_sets(auth_baton->creds_cache,
-                    apr_pstrdup(auth_baton->pool, cache_key),
-                    creds);
+      if (! cached)
+        set_cached_creds(auth_baton, cache_key, creds, i);
     }
 
   *credentials = creds;
@@ -330,17 +421,50 @@ svn_auth_first_credentials(void **credentials,
   return SVN_NO_ERROR;
 }
 
-
 svn_error_t *
-svn_auth_next_credentials(void **credentials,
-                          svn_auth_iterstate_t *state,
-                          apr_pool_t *pool)
+svn_auth_first_credentials(void **credentials,
+                           svn_auth_iterstate_t **state,
+                           const char *cred_kind,
+                           const char *realmstring,
+                           svn_auth_baton_t *auth_baton,
+                           apr_pool_t *pool)
+{
+  if (! auth_baton)
+    return svn_error_create(SVN_ERR_AUTHN_NO_PROVIDER, NULL,
+                            _("No authentication providers registered"));
+
+  SVN_MUTEX__WITH_LOCK(auth_baton->mutex,
+                       first_credentials(credentials, state, cred_kind,
+                                         realmstring, auth_baton, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* The guts of svn_auth_next_credentials(), to be called while holding
+   STATE->AUTH_BATON->MUTEX. */
+static svn_error_t *
+next_credentials(void **credentials,
+                 svn_auth_iterstate_t *state,
+                 apr_pool_t *pool)
 {
   svn_auth_baton_t *auth_baton = state->auth_baton;
   svn_auth_provider_object_t *provider;
   provider_set_t *table = state->table;
   void *creds = NULL;
 
+  /* Being asked for more means that the cached creds got rejected.
+     Don't serve them to other sessions again - unless some other session
+     has replaced them already. */
+  if (state->cached)
+    {
+      if (svn_hash_gets(auth_baton->creds_cache, state->cache_key)
+          == state->cached)
+        svn_hash_sets(auth_baton->creds_cache, state->cache_key, NULL);
+
+      state->cached = NULL;
+    }
+
   /* Continue traversing the table from where we left off. */
   for (/* no init */;
        state->provider_idx < table->providers->nelts;
@@ -370,9 +494,8 @@ svn_auth_next_credentials(void **credentials,
       if (creds != NULL)
         {
           /* Put the creds in the cache */
-          svn_hash_sets(auth_baton->creds_cache,
-                        apr_pstrdup(auth_baton->pool, state->cache_key),
-                        creds);
+          set_cached_creds(auth_baton, state->cache_key, creds,
+                           state->provider_idx);
           break;
         }
 
@@ -384,24 +507,42 @@ svn_auth_next_credentials(void **credentials,
   return SVN_NO_ERROR;
 }
 
-
 svn_error_t *
-svn_auth_save_credentials(svn_auth_iterstate_t *state,
+svn_auth_next_credentials(void **credentials,
+                          svn_auth_iterstate_t *state,
                           apr_pool_t *pool)
+{
+  SVN_MUTEX__WITH_LOCK(state->auth_baton->mutex,
+                       next_credentials(credentials, state, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* The guts of svn_auth_save_credentials(), to be called while holding
+   STATE->AUTH_BATON->MUTEX. */
+static svn_error_t *
+save_credentials(svn_auth_iterstate_t *state,
+                 apr_pool_t *pool)
 {
   int i;
   svn_auth_provider_object_t *provider;
   svn_boolean_t save_succeeded = FALSE;
   const char *no_auth_cache;
+  cached_creds_t *cached;
   void *creds;
 
   if (! state || state->table->providers->nelts <= state->provider_idx)
     return SVN_NO_ERROR;
 
-  creds = svn_hash_gets(state->auth_baton->creds_cache, state->cache_key);
-  if (! creds)
+  /* Creds that have been saved before don't need to go through the
+     providers, i.e. to disk or to some password store, again. */
+  cached = svn_hash_gets(state->auth_baton->creds_cache, state->cache_key);
+  if (! cached || cached->saved)
     return SVN_NO_ERROR;
 
+  creds = cached->creds;
+
   /* Do not save the creds if SVN_AUTH_PARAM_NO_AUTH_CACHE is set */
   no_auth_cache = svn_hash_gets(state->parameters,
                                 SVN_AUTH_PARAM_NO_AUTH_CACHE);
@@ -420,7 +561,10 @@ svn_auth_save_credentials(svn_auth_iterstate_t *state,
                                                state->realmstring,
                                                pool));
   if (save_succeeded)
-    return SVN_NO_ERROR;
+    {
+      cached->saved = TRUE;
+      return SVN_NO_ERROR;
+    }
 
   /* Otherwise, loop from the top of the list, asking every provider
      to attempt a save.  ### todo: someday optimize so we don't
@@ -437,7 +581,10 @@ svn_auth_save_credentials(svn_auth_iterstate_t *state,
                                                    pool));
 
       if (save_succeeded)
-        break;
+        {
+          cached->saved = TRUE;
+          break;
+        }
     }
 
   /* ### notice that at the moment, if no provider can save, there's
@@ -446,15 +593,28 @@ svn_auth_save_credentials(svn_auth_iterstate_t *state,
   return SVN_NO_ERROR;
 }
 
-
 svn_error_t *
-svn_auth_forget_credentials(svn_auth_baton_t *auth_baton,
-                            const char *cred_kind,
-                            const char *realmstring,
-                            apr_pool_t *scratch_pool)
+svn_auth_save_credentials(svn_auth_iterstate_t *state,
+                          apr_pool_t *pool)
 {
-  SVN_ERR_ASSERT((cred_kind && realmstring) || (!cred_kind && !realmstring));
+  if (! state)
+    return SVN_NO_ERROR;
 
+  SVN_MUTEX__WITH_LOCK(state->auth_baton->mutex,
+                       save_credentials(state, pool));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* The guts of svn_auth_forget_credentials(), to be called while holding
+   AUTH_BATON->MUTEX. */
+static svn_error_t *
+forget_credentials(svn_auth_baton_t *auth_baton,
+                   const char *cred_kind,
+                   const char *realmstring,
+                   apr_pool_t *scratch_pool)
+{
   /* If we have a CRED_KIND and REALMSTRING, we clear out just the
      cached item (if any).  Otherwise, empty the whole hash. */
   if (cred_kind)
@@ -471,6 +631,28 @@ svn_auth_forget_credentials(svn_auth_baton_t *auth_baton,
   return SVN_NO_ERROR;
 }
 
+void
+svn_auth__set_credentials_cache_ttl(svn_auth_baton_t *auth_baton,
+                                    apr_interval_time_t ttl)
+{
+  auth_baton->creds_cache_ttl = MAX(ttl, 0);
+}
+
+svn_error_t *
+svn_auth_forget_credentials(svn_auth_baton_t *auth_baton,
+                            const char *cred_kind,
+                            const char *realmstring,
+                            apr_pool_t *scratch_pool)
+{
+  SVN_ERR_ASSERT((cred_kind && realmstring) || (!cred_kind && !realmstring));
+
+  SVN_MUTEX__WITH_LOCK(auth_baton->mutex,
+                       forget_credentials(auth_baton, cred_kind, realmstring,
+                                          scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 
 svn_auth_ssl_server_cert_info_t *
 svn_auth_ssl_server_cert_info_dup
@@ -876,7 +1058,7 @@ svn_auth__make_session_auth(svn_auth_baton_t **session_auth_baton,
   if (server_group)
     svn_auth_set_parameter(ab,
                            SVN_AUTH_PARAM_SERVER_GROUP,
-                           apr_pstrdup(ab->pool, server_group));
+                           apr_pstrdup(result_pool, server_group));
 
   *session_auth_baton = ab;
 
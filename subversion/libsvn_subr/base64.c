@@ -36,6 +36,14 @@
 #include "private/svn_string_private.h"
 #include "private/svn_subr_private.h"
 
+/* Use SSSE3 to encode and decode whole lines 16 chars at a time.  Unlike
+ * SSE2, SSSE3 is not part of the x86-64 base ISA, so this is only enabled
+ * when compiling for targets that have it. */
+#if defined(__SSSE3__) && defined(__GNUC__)
+#include <tmmintrin.h>
+#define SVN_BASE64__USE_SSSE3 1
+#endif
+
 /* When asked to format the base64-encoded output as multiple lines,
    we put this many chars in each line (plus one new line char) unless
    we run out of data.
@@ -85,6 +93,44 @@ encode_group(const unsigned char *in, char *out)
   out[3] = base64tab[part2 & 0x3f];
 }
 
+#ifdef SVN_BASE64__USE_SSSE3
+/* Base64-encode the first 12 of the 16 bytes at IN into 16 chars at OUT.
+ * This is the vectorized equivalent of 4x encode_group().
+ */
+static APR_INLINE void
+encode_block_ssse3(const unsigned char *in, char *out)
+{
+  const __m128i shift_lut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '+' - 62,
+                                          '/' - 63, 'A', 0, 0);
+  __m128i data = _mm_loadu_si128((const __m128i *)in);
+  __m128i lo, hi, indexes, shift;
+
+  /* Spread each group of 3 bytes across 4 bytes ... */
+  data = _mm_shuffle_epi8(data, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4,
+                                              7, 6, 8, 7, 10, 9, 11, 10));
+
+  /* ... and move the four 6 bit values into separate bytes. */
+  hi = _mm_mulhi_epu16(_mm_and_si128(data, _mm_set1_epi32(0x0fc0fc00)),
+                       _mm_set1_epi32(0x04000040));
+  lo = _mm_mullo_epi16(_mm_and_si128(data, _mm_set1_epi32(0x003f03f0)),
+                       _mm_set1_epi32(0x01000010));
+  indexes = _mm_or_si128(hi, lo);
+
+  /* Map the values to the base64 chars by adding a per-range offset. */
+  shift = _mm_subs_epu8(indexes, _mm_set1_epi8(51));
+  shift = _mm_or_si128(shift,
+                       _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26),
+                                                    indexes),
+                                     _mm_set1_epi8(13)));
+  shift = _mm_shuffle_epi8(shift_lut, shift);
+
+  _mm_storeu_si128((__m128i *)out, _mm_add_epi8(indexes, shift));
+}
+#endif
+
 /* Base64-encode a line, i.e. BYTES_PER_LINE bytes from DATA into
    BASE64_LINELEN chars and append it to STR.  It does not assume that
    a new line char will be appended, though.
@@ -101,6 +147,14 @@ encode_line(svn_stringbuf_t *str, const char *data)
   char *out = str->data + str->len;
   char *end = out + BASE64_LINELEN;
 
+#ifdef SVN_BASE64__USE_SSSE3
+  /* Each block reads 16 but consumes only 12 bytes, so stop early enough
+     to stay within the line. */
+  for ( ; in + 16 <= (const unsigned char *)data + BYTES_PER_LINE;
+       in += 12, out += 16)
+    encode_block_ssse3(in, out);
+#endif
+
   /* We assume that BYTES_PER_LINE is a multiple of 3 and BASE64_LINELEN
      a multiple of 4. */
   for ( ; out != end; in += 3, out += 4)
@@ -361,6 +415,56 @@ decode_group_directly(const unsigned char *in, char *out)
   return (part0 | part1 | part2 | part3) != (unsigned char)(-1);
 }
 
+#ifdef SVN_BASE64__USE_SSSE3
+/* Base64-decode the 16 chars at IN into 12 bytes at OUT, which must have
+ * room for 16 bytes.  Return FALSE and leave OUT untouched if any of the
+ * chars is not a base64 char, e.g. '=' or new line.  Otherwise, this is
+ * the vectorized equivalent of 4x decode_group_directly().
+ */
+static APR_INLINE svn_boolean_t
+decode_block_ssse3(const unsigned char *in, char *out)
+{
+  /* Classify the chars by their low and high nibbles.  Only valid base64
+     chars have no bit in common in both lookup results. */
+  const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                       0x11, 0x11, 0x11, 0x11, 0x13, 0x1a,
+                                       0x1b, 0x1b, 0x1b, 0x1a);
+  const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08,
+                                       0x04, 0x08, 0x10, 0x10, 0x10, 0x10,
+                                       0x10, 0x10, 0x10, 0x10);
+
+  /* Offsets that map the chars to their values, indexed by high nibble
+     with '/' getting its own entry. */
+  const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                         0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i mask_2f = _mm_set1_epi8(0x2f);
+
+  __m128i data = _mm_loadu_si128((const __m128i *)in);
+  __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(data, 4), mask_2f);
+  __m128i lo_nibbles = _mm_and_si128(data, mask_2f);
+  __m128i invalid = _mm_and_si128(_mm_shuffle_epi8(lut_lo, lo_nibbles),
+                                  _mm_shuffle_epi8(lut_hi, hi_nibbles));
+  __m128i roll;
+
+  if (_mm_movemask_epi8(_mm_cmpgt_epi8(invalid, _mm_setzero_si128())))
+    return FALSE;
+
+  roll = _mm_shuffle_epi8(lut_roll,
+                          _mm_add_epi8(_mm_cmpeq_epi8(data, mask_2f),
+                                       hi_nibbles));
+  data = _mm_add_epi8(data, roll);
+
+  /* Pack 4x6 bits into 3x8 and move the 12 result bytes to the front. */
+  data = _mm_maddubs_epi16(data, _mm_set1_epi32(0x01400140));
+  data = _mm_madd_epi16(data, _mm_set1_epi32(0x00011000));
+  data = _mm_shuffle_epi8(data, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                              14, 13, 12, -1, -1, -1, -1));
+  _mm_storeu_si128((__m128i *)out, data);
+
+  return TRUE;
+}
+#endif
+
 /* Base64-encode up to BASE64_LINELEN chars from *DATA and append it to
    STR.  After the function returns, *DATA will point to the first char
    that has not been translated, yet.  Returns TRUE if all BASE64_LINELEN
@@ -379,6 +483,15 @@ decode_line(svn_stringbuf_t *str, const char **data)
   char *out = str->data + str->len;
   char *end = out + BYTES_PER_LINE;
 
+#ifdef SVN_BASE64__USE_SSSE3
+  /* Each block writes 16 but produces only 12 bytes, so stop early enough
+     to stay within the line.  Let the code below handle blocks with
+     special chars. */
+  for (; out + 16 <= end; p += 16, out += 12)
+    if (!decode_block_ssse3(p, out))
+      break;
+#endif
+
   /* We assume that BYTES_PER_LINE is a multiple of 3 and BASE64_LINELEN
      a multiple of 4.  Stop translation as soon as we encounter a special
      char.  Leave the entire group untouched in that case. */
@@ -24,17 +24,27 @@
 #include <assert.h>
 #include <apr_md5.h>
 #include <apr_thread_rwlock.h>
+#include <apr_proc_mutex.h>
+#include <apr_shm.h>
+#include <apr_strings.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
 
 #include "svn_pools.h"
 #include "svn_checksum.h"
 #include "svn_private_config.h"
 #include "svn_hash.h"
+#include "svn_io.h"
 #include "svn_string.h"
 #include "svn_sorts.h"  /* get the MIN macro */
 
 #include "private/svn_atomic.h"
 #include "private/svn_dep_compat.h"
 #include "private/svn_mutex.h"
+#include "private/svn_probes.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_string_private.h"
 
@@ -197,6 +207,52 @@
  */
 #define MAX_ITEM_SIZE ((apr_uint32_t)(0 - ITEM_ALIGNMENT))
 
+/* Items stored through caches with compression enabled end with one of
+ * these marker bytes, telling whether the data before it is the plain
+ * serialized item or its LZ4-compressed form.  The marker goes to the end
+ * to keep the start of the item data aligned.
+ */
+#define ITEM_PLAIN 0
+#define ITEM_LZ4 1
+
+/* LZ4 can't handle blocks larger than this (LZ4_MAX_INPUT_SIZE).
+ */
+#define MAX_COMPRESSIBLE_SIZE 0x7E000000
+
+/* Hit counters of individual entries saturate at this value.  That is
+ * plenty of resolution for our LFU-style replacement strategy.  Once an
+ * entry has become that hot, further hits on it no longer modify the cache
+ * line that holds the entry, i.e. concurrent readers stop competing for it.
+ */
+#define MAX_HIT_COUNT 0x10000
+
+/* Number of independent read statistics counters per segment.  Readers
+ * only hold a shared lock, so these counters get updated concurrently
+ * from many threads.  Spreading them over multiple cache lines keeps the
+ * segment header from bouncing between CPU cores.  Must be a power of 2.
+ */
+#define READ_STATS_STRIPES 16
+
+/* Assumed size of a CPU cache line.  Must be a power of 2.
+ */
+#define CACHE_LINE_SIZE 64
+
+/* Maximum number of distinct key prefixes for which we collect separate
+ * access statistics.  Prefixes beyond that share the statistics of the
+ * "other" prefix.
+ */
+#define MAX_PREFIX_STATS 1024
+
+/* Index of the statistics shared by all short-lived and otherwise
+ * unaccounted prefixes.
+ */
+#define OTHER_PREFIX_STATS 0
+
+/* Cache front-ends collect their access statistics locally and add them
+ * to the shared prefix statistics after this many accesses.
+ */
+#define PREFIX_STATS_FLUSH_INTERVAL 64
+
 /* We use this structure to identify cache entries. There cannot be two
  * entries with the same entry key. However unlikely, though, two different
  * full keys (see full_key_t) may have the same entry key.  That is a
@@ -220,6 +276,11 @@ typedef struct entry_key_t
    * prefix pool (see prefix_pool_t).  NO_INDEX if the key prefix is not
    * shared, otherwise KEY_LEN==0 is implied. */
   apr_uint32_t prefix_idx;
+
+  /* Index of the prefix statistics (see prefix_stats_pool_t) to attribute
+   * the entry to.  This is not part of the key's identity and will be
+   * ignored when comparing keys. */
+  apr_uint32_t stats_idx;
 } entry_key_t;
 
 /* A full key, i.e. the combination of the cache's key prefix with some
@@ -391,6 +452,148 @@ prefix_pool_get(apr_uint32_t *prefix_idx,
   return SVN_NO_ERROR;
 }
 
+/* Access statistics for all cache front-end instances that use the same
+ * key prefix.  Purely statistical information that may be used for
+ * profiling only.  The number and size of cached entries per prefix is
+ * not stored here but determined when the statistics get reported.
+ */
+typedef struct prefix_stats_t
+{
+  /* The key prefix.  NULL for the OTHER_PREFIX_STATS entry. */
+  const char *prefix;
+
+  /* Number of getter calls. */
+  apr_uint64_t gets;
+
+  /* Number of getter calls that found an entry. */
+  apr_uint64_t hits;
+
+  /* Number of setter calls. */
+  apr_uint64_t sets;
+
+  /* Number of entries dropped to make room for new data.
+   * Updated without synchronization, so it may be slightly off. */
+  apr_uint64_t evictions;
+} prefix_stats_t;
+
+/* A limited capacity, thread-safe pool of prefix_stats_t.  All segments
+ * of the same membuffer cache share the same instance.
+ */
+typedef struct prefix_stats_pool_t
+{
+  /* Map C string to a pointer into STATS with the same prefix. */
+  apr_hash_t *map;
+
+  /* Array of MAX_PREFIX_STATS entries.  The first one is being used for
+   * OTHER_PREFIX_STATS. */
+  prefix_stats_t *stats;
+
+  /* Number of used entries in STATS.  Never exceeds MAX_PREFIX_STATS. */
+  apr_uint32_t stats_used;
+
+  /* The serialization object.  Protects everything but the EVICTIONS
+   * counters. */
+  svn_mutex__t *mutex;
+} prefix_stats_pool_t;
+
+/* Set *STATS_POOL to a new, empty instance.  If MUTEX_REQUIRED is set and
+ * multi-threading is supported, serialize all access to it.  Allocate the
+ * object from *RESULT_POOL. */
+static svn_error_t *
+prefix_stats_pool_create(prefix_stats_pool_t **stats_pool,
+                         svn_boolean_t mutex_required,
+                         apr_pool_t *result_pool)
+{
+  prefix_stats_pool_t *result = apr_pcalloc(result_pool, sizeof(*result));
+  result->map = svn_hash__make(result_pool);
+  result->stats = apr_pcalloc(result_pool,
+                              MAX_PREFIX_STATS * sizeof(*result->stats));
+  result->stats_used = OTHER_PREFIX_STATS + 1;
+
+  SVN_ERR(svn_mutex__init(&result->mutex, mutex_required, result_pool));
+
+  *stats_pool = result;
+  return SVN_NO_ERROR;
+}
+
+/* Set *STATS_IDX to the index of the statistics for PREFIX in STATS_POOL.
+ * If none exists, auto-insert it.  If we can't due to capacity exhaustion,
+ * set *STATS_IDX to OTHER_PREFIX_STATS.
+ * To be called by prefix_stats_pool_get() only. */
+static svn_error_t *
+prefix_stats_pool_get_internal(apr_uint32_t *stats_idx,
+                               prefix_stats_pool_t *stats_pool,
+                               const char *prefix)
+{
+  prefix_stats_t *stats = svn_hash_gets(stats_pool->map, prefix);
+  if (stats != NULL)
+    {
+      *stats_idx = (apr_uint32_t)(stats - stats_pool->stats);
+      return SVN_NO_ERROR;
+    }
+
+  if (stats_pool->stats_used == MAX_PREFIX_STATS)
+    {
+      *stats_idx = OTHER_PREFIX_STATS;
+      return SVN_NO_ERROR;
+    }
+
+  stats = &stats_pool->stats[stats_pool->stats_used];
+  stats->prefix = apr_pstrdup(apr_hash_pool_get(stats_pool->map), prefix);
+  svn_hash_sets(stats_pool->map, stats->prefix, stats);
+
+  *stats_idx = stats_pool->stats_used;
+  ++stats_pool->stats_used;
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread-safe wrapper around prefix_stats_pool_get_internal. */
+static svn_error_t *
+prefix_stats_pool_get(apr_uint32_t *stats_idx,
+                      prefix_stats_pool_t *stats_pool,
+                      const char *prefix)
+{
+  SVN_MUTEX__WITH_LOCK(stats_pool->mutex,
+                       prefix_stats_pool_get_internal(stats_idx, stats_pool,
+                                                      prefix));
+
+  return SVN_NO_ERROR;
+}
+
+/* Add GETS, HITS and SETS to the statistics with index STATS_IDX in
+ * STATS_POOL.
+ * To be called by prefix_stats_pool_add() only. */
+static svn_error_t *
+prefix_stats_pool_add_internal(prefix_stats_pool_t *stats_pool,
+                               apr_uint32_t stats_idx,
+                               apr_uint32_t gets,
+                               apr_uint32_t hits,
+                               apr_uint32_t sets)
+{
+  prefix_stats_t *stats = &stats_pool->stats[stats_idx];
+  stats->gets += gets;
+  stats->hits += hits;
+  stats->sets += sets;
+
+  return SVN_NO_ERROR;
+}
+
+/* Thread-safe wrapper around prefix_stats_pool_add_internal. */
+static svn_error_t *
+prefix_stats_pool_add(prefix_stats_pool_t *stats_pool,
+                      apr_uint32_t stats_idx,
+                      apr_uint32_t gets,
+                      apr_uint32_t hits,
+                      apr_uint32_t sets)
+{
+  SVN_MUTEX__WITH_LOCK(stats_pool->mutex,
+                       prefix_stats_pool_add_internal(stats_pool, stats_idx,
+                                                      gets, hits, sets));
+
+  return SVN_NO_ERROR;
+}
+
 /* Debugging / corruption detection support.
  * If you define this macro, the getter functions will performed expensive
  * checks on the item data, requested keys and entry types. If there is
@@ -692,6 +895,26 @@ typedef struct cache_level_t
 
 } cache_level_t;
 
+/* One stripe of the read access statistics of a cache segment.
+ * Purely statistical information that may be used for profiling only.
+ * Updates are not synchronized and values may be nonsensicle on some
+ * platforms.
+ */
+typedef struct read_stats_t
+{
+  /* Number of calls to membuffer_cache_get and friends.
+   */
+  apr_uint64_t reads;
+
+  /* Number of hits among those calls.
+   */
+  apr_uint64_t hits;
+
+  /* Make every stripe occupy a cache line of its own.
+   */
+  char padding[CACHE_LINE_SIZE - 2 * sizeof(apr_uint64_t)];
+} read_stats_t;
+
 /* The cache header structure.
  */
 struct svn_membuffer_t
@@ -707,6 +930,9 @@ struct svn_membuffer_t
    * use the one stored in this pool. */
   prefix_pool_t *prefix_pool;
 
+  /* Access statistics per key prefix, shared among all segments. */
+  prefix_stats_pool_t *prefix_stats;
+
   /* The dictionary, GROUP_SIZE * (group_count + spare_group_count)
    * entries long.  Never NULL.
    */
@@ -725,6 +951,51 @@ struct svn_membuffer_t
    */
   apr_uint32_t spare_group_count;
 
+  /* Pointer to the data buffer, data_size bytes long. Never NULL.
+   */
+  unsigned char *data;
+
+  /* Largest entry size that we would accept.  For total cache sizes
+   * less than 4TB (sic!), this is determined by the total cache size.
+   */
+  apr_uint64_t max_entry_size;
+
+  /* Read access statistics, READ_STATS_STRIPES entries, each one aligned
+   * to CACHE_LINE_SIZE.  Use get_read_stats() to select the entry to
+   * update.  Never NULL.
+   */
+  read_stats_t *read_stats;
+
+#if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
+  /* A lock for intra-process synchronization to the cache, or NULL if
+   * the cache's creator doesn't feel the cache needs to be
+   * thread-safe.
+   */
+  svn_mutex__t *lock;
+#elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
+  /* Same for read-write lock. */
+  apr_thread_rwlock_t *lock;
+#endif
+
+  /* If set, write access will wait until they get exclusive access.
+   * Otherwise, they will become no-ops if the segment is currently
+   * locked.  Only used when LOCK is an r/w lock or if PROC_LOCK is set.
+   */
+  svn_boolean_t allow_blocking_writes;
+
+  /* If not NULL, this segment lives in memory shared with other processes
+   * and this lock serializes all access to it, including reads.  LOCK
+   * will not be used in that case.  Process-shared pthread mutexes also
+   * serialize the threads within each process.
+   */
+  apr_proc_mutex_t *proc_lock;
+
+  /* Everything above is set up once and then only read, in the case of
+   * segment 0 by every cache access.  Keep it off the cache lines of the
+   * fields below, which get modified by every write to this segment.
+   */
+  char read_only_padding[CACHE_LINE_SIZE];
+
   /* First recycleable spare group.
    */
   apr_uint32_t first_spare_group;
@@ -735,19 +1006,10 @@ struct svn_membuffer_t
    */
   apr_uint32_t max_spare_used;
 
-  /* Pointer to the data buffer, data_size bytes long. Never NULL.
-   */
-  unsigned char *data;
-
   /* Total number of data buffer bytes in use.
    */
   apr_uint64_t data_used;
 
-  /* Largest entry size that we would accept.  For total cache sizes
-   * less than 4TB (sic!), this is determined by the total cache size.
-   */
-  apr_uint64_t max_entry_size;
-
   /* The cache levels, organized as sub-buffers.  Since entries in the
    * DIRECTORY use offsets in DATA for addressing, a cache lookup does
    * not need to know the cache level of a specific item.  Cache levels
@@ -767,7 +1029,6 @@ struct svn_membuffer_t
    */
   cache_level_t l2;
 
-
   /* Number of used dictionary entries, i.e. number of cached items.
    * Purely statistical information that may be used for profiling only.
    * Updates are not synchronized and values may be nonsensicle on some
@@ -775,13 +1036,6 @@ struct svn_membuffer_t
    */
   apr_uint32_t used_entries;
 
-  /* Total number of calls to membuffer_cache_get.
-   * Purely statistical information that may be used for profiling only.
-   * Updates are not synchronized and values may be nonsensicle on some
-   * platforms.
-   */
-  apr_uint64_t total_reads;
-
   /* Total number of calls to membuffer_cache_set.
    * Purely statistical information that may be used for profiling only.
    * Updates are not synchronized and values may be nonsensicle on some
@@ -789,45 +1043,66 @@ struct svn_membuffer_t
    */
   apr_uint64_t total_writes;
 
-  /* Total number of hits since the cache's creation.
-   * Purely statistical information that may be used for profiling only.
-   * Updates are not synchronized and values may be nonsensicle on some
-   * platforms.
-   */
-  apr_uint64_t total_hits;
-
-#if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
-  /* A lock for intra-process synchronization to the cache, or NULL if
-   * the cache's creator doesn't feel the cache needs to be
-   * thread-safe.
-   */
-  svn_mutex__t *lock;
-#elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
-  /* Same for read-write lock. */
-  apr_thread_rwlock_t *lock;
-
-  /* If set, write access will wait until they get exclusive access.
-   * Otherwise, they will become no-ops if the segment is currently
-   * read-locked.  Only used when LOCK is an r/w lock.
-   */
-  svn_boolean_t allow_blocking_writes;
-#endif
-
   /* A write lock counter, must be either 0 or 1.
    * This one is only used in debug assertions to verify that you used
    * the correct multi-threading settings. */
   svn_atomic_t write_lock_count;
+
+  /* Keep the fields above off the cache line of the next segment's
+   * header.  Otherwise, writes to one segment would keep invalidating
+   * the header of its neighbor in the caches of all other CPU cores.
+   */
+  char segment_padding[CACHE_LINE_SIZE];
 };
 
 /* Align integer VALUE to the next ITEM_ALIGNMENT boundary.
  */
 #define ALIGN_VALUE(value) (((value) + ITEM_ALIGNMENT-1) & -ITEM_ALIGNMENT)
 
+/* Align integer VALUE to the next CACHE_LINE_SIZE boundary.
+ */
+#define ALIGN_TO_CACHE_LINE(value) \
+  (((value) + CACHE_LINE_SIZE-1) & ~(apr_size_t)(CACHE_LINE_SIZE-1))
+
+/* Acquire the inter-process lock of the shared CACHE segment.  If BLOCKING
+ * is not set and the lock is currently held by someone else, set *SUCCESS
+ * to FALSE and return without acquiring it.
+ */
+static svn_error_t *
+proc_lock_cache(svn_membuffer_t *cache,
+                svn_boolean_t blocking,
+                svn_boolean_t *success)
+{
+  apr_status_t status;
+
+  if (blocking)
+    {
+      status = apr_proc_mutex_lock(cache->proc_lock);
+    }
+  else
+    {
+      status = apr_proc_mutex_trylock(cache->proc_lock);
+      if (APR_STATUS_IS_EBUSY(status))
+        {
+          *success = FALSE;
+          status = APR_SUCCESS;
+        }
+    }
+
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't lock shared cache mutex"));
+
+  return SVN_NO_ERROR;
+}
+
 /* If locking is supported for CACHE, acquire a read lock for it.
  */
 static svn_error_t *
 read_lock_cache(svn_membuffer_t *cache)
 {
+  if (cache->proc_lock)
+    return svn_error_trace(proc_lock_cache(cache, TRUE, NULL));
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -851,6 +1126,11 @@ read_lock_cache(svn_membuffer_t *cache)
 static svn_error_t *
 write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
 {
+  if (cache->proc_lock)
+    return svn_error_trace(proc_lock_cache(cache,
+                                           cache->allow_blocking_writes,
+                                           success));
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -888,6 +1168,9 @@ write_lock_cache(svn_membuffer_t *cache, svn_boolean_t *success)
 static svn_error_t *
 force_write_lock_cache(svn_membuffer_t *cache)
 {
+  if (cache->proc_lock)
+    return svn_error_trace(proc_lock_cache(cache, TRUE, NULL));
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__lock(cache->lock);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -908,6 +1191,19 @@ force_write_lock_cache(svn_membuffer_t *cache)
 static svn_error_t *
 unlock_cache(svn_membuffer_t *cache, svn_error_t *err)
 {
+  if (cache->proc_lock)
+    {
+      apr_status_t status = apr_proc_mutex_unlock(cache->proc_lock);
+      if (err)
+        return err;
+
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't unlock shared cache mutex"));
+
+      return SVN_NO_ERROR;
+    }
+
 #if (APR_HAS_THREADS && USE_SIMPLE_MUTEX)
   return svn_mutex__unlock(cache->lock, err);
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
@@ -1289,6 +1585,19 @@ drop_entry(svn_membuffer_t *cache, entry_t *entry)
     free_spare_group(cache, last_group);
 }
 
+/* Remove the used ENTRY from the CACHE to make room for new data and
+ * count that as an eviction.
+ */
+static void
+evict_entry(svn_membuffer_t *cache, entry_t *entry)
+{
+  /* The statistics are shared between segments.  Since this is for
+   * profiling only, we don't synchronize the update. */
+  cache->prefix_stats->stats[entry->key.stats_idx].evictions++;
+  SVN_PROBE3(cache__evict, entry->size, entry->hit_count, entry->priority);
+  drop_entry(cache, entry);
+}
+
 /* Insert ENTRY into the chain of used dictionary entries. The entry's
  * offset and size members must already have been initialized. Also,
  * the offset must match the beginning of the insertion window.
@@ -1453,7 +1762,7 @@ find_entry(svn_membuffer_t *cache,
               }
 
             /* need to empty that entry */
-            drop_entry(cache, entry);
+            evict_entry(cache, entry);
             if (group->header.used == GROUP_SIZE)
               group = last_group_in_chain(cache, group);
             else if (group->header.chain_length == 0)
@@ -1538,7 +1847,7 @@ find_entry(svn_membuffer_t *cache,
             if (entry != &to_shrink->entries[i])
               let_entry_age(cache, &to_shrink->entries[i]);
 
-          drop_entry(cache, entry);
+          evict_entry(cache, entry);
         }
 
       /* initialize entry for the new key
@@ -1755,7 +2064,7 @@ ensure_data_insertable_l2(svn_membuffer_t *cache,
               if (entry->priority > SVN_CACHE__MEMBUFFER_LOW_PRIORITY)
                 drop_hits += entry->hit_count * (apr_uint64_t)entry->priority;
 
-              drop_entry(cache, entry);
+              evict_entry(cache, entry);
             }
         }
     }
@@ -1823,7 +2132,7 @@ ensure_data_insertable_l1(svn_membuffer_t *cache, apr_size_t size)
               if (keep)
                 promote_entry(cache, entry);
               else
-                drop_entry(cache, entry);
+                evict_entry(cache, entry);
             }
         }
     }
@@ -1832,17 +2141,152 @@ ensure_data_insertable_l1(svn_membuffer_t *cache, apr_size_t size)
    * right answer. */
 }
 
-svn_error_t *
-svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
-                                  apr_size_t total_size,
-                                  apr_size_t directory_size,
-                                  apr_size_t segment_count,
-                                  svn_boolean_t thread_safe,
-                                  svn_boolean_t allow_blocking_writes,
-                                  apr_pool_t *pool)
+/* Maximum number of NUMA nodes that we spread cache memory across.
+ */
+#define MAX_NUMA_NODES 1024
+
+/* Linux' MPOL_INTERLEAVE memory policy, see mbind(2).
+ */
+#define NUMA_POLICY_INTERLEAVE 3
+
+/* A bit mask of NUMA nodes in the format expected by mbind(2).
+ */
+typedef struct numa_nodes_t
+{
+  unsigned long mask[MAX_NUMA_NODES / (8 * sizeof(unsigned long))];
+
+  /* One above the highest node number set in MASK. */
+  unsigned long max_node;
+
+  /* Number of nodes set in MASK. */
+  int count;
+} numa_nodes_t;
+
+/* Set *NODES to the NUMA nodes currently online, as reported by the
+ * kernel in a list of ranges like "0-3,6".  If that information is not
+ * available, report a single node.  Use POOL for temporaries.
+ */
+static void
+get_numa_nodes(numa_nodes_t *nodes,
+               apr_pool_t *pool)
+{
+  svn_stringbuf_t *online = NULL;
+  const char *p;
+
+  memset(nodes, 0, sizeof(*nodes));
+  nodes->count = 1;
+
+#ifdef __linux__
+  svn_error_clear(svn_stringbuf_from_file2(&online,
+                                           "/sys/devices/system/node/online",
+                                           pool));
+#endif
+  if (online == NULL)
+    return;
+
+  nodes->count = 0;
+  for (p = online->data; *p; )
+    {
+      char *end;
+      unsigned long first = strtoul(p, &end, 10);
+      unsigned long last = first;
+      unsigned long node;
+
+      if (end == p)
+        break;
+      if (*end == '-')
+        {
+          p = end + 1;
+          last = strtoul(p, &end, 10);
+          if (end == p)
+            break;
+        }
+
+      for (node = first; node <= last && node < MAX_NUMA_NODES; ++node)
+        {
+          nodes->mask[node / (8 * sizeof(unsigned long))]
+            |= 1ul << (node % (8 * sizeof(unsigned long)));
+          nodes->max_node = node + 1;
+          ++nodes->count;
+        }
+
+      p = *end == ',' ? end + 1 : end;
+      if (*p == '\n')
+        break;
+    }
+}
+
+/* Ask the OS to spread the pages of the SIZE bytes at START round-robin
+ * across all of the NUMA NODES.  Otherwise, each page would be placed
+ * on the node of the thread that happens to touch it first - usually the
+ * one that warms up the cache - and threads on all other nodes would need
+ * remote memory accesses for every cache hit.  This is merely a hint
+ * without effect on memory that has already been touched and on machines
+ * with a single node.
+ */
+static void
+interleave_memory(void *start,
+                  apr_size_t size,
+                  const numa_nodes_t *nodes)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+  long page_size = sysconf(_SC_PAGESIZE);
+  apr_uintptr_t first;
+  apr_uintptr_t last;
+
+  if (start == NULL || nodes->count < 2 || page_size <= 0)
+    return;
+
+  /* mbind() only works on whole pages. */
+  first = ((apr_uintptr_t)start + page_size - 1)
+        & ~(apr_uintptr_t)(page_size - 1);
+  last = ((apr_uintptr_t)start + size) & ~(apr_uintptr_t)(page_size - 1);
+  if (last <= first)
+    return;
+
+  /* Failure is not a problem; the memory will just stay where it is. */
+  (void)syscall(SYS_mbind, (void *)first, (unsigned long)(last - first),
+                NUMA_POLICY_INTERLEAVE, nodes->mask, nodes->max_node + 1,
+                0);
+#endif
+}
+
+/* Return SIZE bytes of uninitialized memory for a cache segment.  If
+ * *SHARED is not NULL, take them from the shared memory region it points
+ * into and advance *SHARED to the next cache line behind them.  Otherwise,
+ * allocate them in POOL.
+ */
+static void *
+segment_alloc(char **shared,
+              apr_size_t size,
+              apr_pool_t *pool)
+{
+  void *result = *shared;
+  if (result == NULL)
+    return apr_palloc(pool, size);
+
+  *shared += ALIGN_TO_CACHE_LINE(size);
+  return result;
+}
+
+/* Implement svn_cache__membuffer_cache_create() and its _SHARED variant.
+ * If SHARED is set, place all segment data in a shared memory region
+ * that will be inherited by child processes and use inter-process locks.
+ */
+static svn_error_t *
+membuffer_cache_create(svn_membuffer_t **cache,
+                       apr_size_t total_size,
+                       apr_size_t directory_size,
+                       apr_size_t segment_count,
+                       svn_boolean_t thread_safe,
+                       svn_boolean_t allow_blocking_writes,
+                       svn_boolean_t shared,
+                       apr_pool_t *pool)
 {
   svn_membuffer_t *c;
+  char *region = NULL;
   prefix_pool_t *prefix_pool;
+  prefix_stats_pool_t *prefix_stats;
 
   apr_uint32_t seg;
   apr_uint32_t group_count;
@@ -1851,13 +2295,28 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   apr_uint32_t group_init_size;
   apr_uint64_t data_size;
   apr_uint64_t max_entry_size;
+  void *stats_buffer;
+  apr_size_t stats_size = (READ_STATS_STRIPES + 1) * sizeof(read_stats_t);
+  numa_nodes_t numa_nodes;
+
+#if !APR_HAS_PROC_PTHREAD_SERIALIZE
+  if (shared)
+    return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                            _("Shared memory caches are not supported "
+                              "on this platform"));
+#endif
 
   /* Allocate 1% of the cache capacity to the prefix string pool.
+   *
+   * Prefix indexes are only valid within the current process, so shared
+   * caches can't use them and must always store the full keys instead.
    */
-  SVN_ERR(prefix_pool_create(&prefix_pool, total_size / 100, thread_safe,
-                             pool));
+  SVN_ERR(prefix_pool_create(&prefix_pool, shared ? 0 : total_size / 100,
+                             thread_safe, pool));
   total_size -= total_size / 100;
 
+  SVN_ERR(prefix_stats_pool_create(&prefix_stats, thread_safe, pool));
+
   /* Limit the total size (only relevant if we can address > 4GB)
    */
 #if APR_SIZEOF_VOIDP > 4
@@ -1910,9 +2369,6 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
          && segment_count < MAX_SEGMENT_COUNT)
     segment_count *= 2;
 
-  /* allocate cache as an array of segments / cache objects */
-  c = apr_palloc(pool, segment_count * sizeof(*c));
-
   /* Split total cache size into segments of equal size
    */
   total_size /= segment_count;
@@ -1963,12 +2419,49 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   assert(spare_group_count > 0 && main_group_count > 0);
 
   group_init_size = 1 + group_count / (8 * GROUP_INIT_GRANULARITY);
+
+  /* Get one region large enough to hold everything that any process may
+   * modify, including the segment objects themselves.  Its contents will
+   * be visible at the same addresses in all processes forked from here.
+   */
+  if (shared)
+    {
+      apr_shm_t *shm;
+      apr_status_t status;
+      apr_size_t region_size
+        = CACHE_LINE_SIZE
+        + ALIGN_TO_CACHE_LINE(segment_count * sizeof(*c))
+        + segment_count
+          * (  ALIGN_TO_CACHE_LINE(group_count * sizeof(entry_group_t))
+             + ALIGN_TO_CACHE_LINE(group_init_size)
+             + ALIGN_TO_CACHE_LINE((apr_size_t)ALIGN_VALUE(data_size))
+             + ALIGN_TO_CACHE_LINE(stats_size));
+
+      status = apr_shm_create(&shm, region_size, NULL, pool);
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't create shared memory for cache"));
+
+      region = (char *)ALIGN_TO_CACHE_LINE(
+                          (apr_uintptr_t)apr_shm_baseaddr_get(shm));
+    }
+
+  /* allocate cache as an array of segments / cache objects */
+  c = segment_alloc(&region, segment_count * sizeof(*c), pool);
+
+  /* The key -> segment mapping is the same for all threads and processes,
+   * so there is no node-local placement of items.  Spread the large,
+   * untouched directories and data buffers evenly across all nodes
+   * instead, such that no node's memory bus becomes the bottleneck. */
+  get_numa_nodes(&numa_nodes, pool);
+
   for (seg = 0; seg < segment_count; ++seg)
     {
       /* allocate buffers and initialize cache members
        */
       c[seg].segment_count = (apr_uint32_t)segment_count;
       c[seg].prefix_pool = prefix_pool;
+      c[seg].prefix_stats = prefix_stats;
 
       c[seg].group_count = main_group_count;
       c[seg].spare_group_count = spare_group_count;
@@ -1978,12 +2471,18 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       /* Allocate but don't clear / zero the directory because it would add
          significantly to the server start-up time if the caches are large.
          Group initialization will take care of that in stead. */
-      c[seg].directory = apr_palloc(pool,
-                                    group_count * sizeof(entry_group_t));
+      c[seg].directory = segment_alloc(&region,
+                                       group_count * sizeof(entry_group_t),
+                                       pool);
+      interleave_memory(c[seg].directory,
+                        group_count * sizeof(entry_group_t), &numa_nodes);
 
       /* Allocate and initialize directory entries as "not initialized",
          hence "unused" */
-      c[seg].group_initialized = apr_pcalloc(pool, group_init_size);
+      c[seg].group_initialized = segment_alloc(&region, group_init_size,
+                                               pool);
+      if (c[seg].group_initialized)
+        memset(c[seg].group_initialized, 0, group_init_size);
 
       /* Allocate 1/4th of the data buffer to L1
        */
@@ -2004,19 +2503,30 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
       c[seg].l2.current_data = c[seg].l2.start_offset;
 
       /* This cast is safe because DATA_SIZE <= MAX_SEGMENT_SIZE. */
-      c[seg].data = apr_palloc(pool, (apr_size_t)ALIGN_VALUE(data_size));
+      c[seg].data = segment_alloc(&region,
+                                  (apr_size_t)ALIGN_VALUE(data_size), pool);
+      interleave_memory(c[seg].data, (apr_size_t)ALIGN_VALUE(data_size),
+                        &numa_nodes);
       c[seg].data_used = 0;
       c[seg].max_entry_size = max_entry_size;
 
       c[seg].used_entries = 0;
-      c[seg].total_reads = 0;
       c[seg].total_writes = 0;
-      c[seg].total_hits = 0;
+
+      /* Over-allocate such that we can align the stripes to cache lines.
+       */
+      stats_buffer = segment_alloc(&region, stats_size, pool);
+      if (stats_buffer)
+        memset(stats_buffer, 0, stats_size);
+      c[seg].read_stats
+        = (read_stats_t *)(((apr_uintptr_t)stats_buffer + CACHE_LINE_SIZE - 1)
+                           & ~(apr_uintptr_t)(CACHE_LINE_SIZE - 1));
 
       /* were allocations successful?
        * If not, initialize a minimal cache structure.
        */
-      if (c[seg].data == NULL || c[seg].directory == NULL)
+      if (   c[seg].data == NULL || c[seg].directory == NULL
+          || c[seg].group_initialized == NULL || stats_buffer == NULL)
         {
           /* We are OOM. There is no need to proceed with "half a cache".
            */
@@ -2028,11 +2538,11 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
        * the cache's creator doesn't feel the cache needs to be
        * thread-safe.
        */
-      SVN_ERR(svn_mutex__init(&c[seg].lock, thread_safe, pool));
+      SVN_ERR(svn_mutex__init(&c[seg].lock, thread_safe && !shared, pool));
 #elif (APR_HAS_THREADS && !USE_SIMPLE_MUTEX)
       /* Same for read-write lock. */
       c[seg].lock = NULL;
-      if (thread_safe)
+      if (thread_safe && !shared)
         {
           apr_status_t status =
               apr_thread_rwlock_create(&(c[seg].lock), pool);
@@ -2040,9 +2550,26 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
             return svn_error_wrap_apr(status, _("Can't create cache mutex"));
         }
 
+#endif
+
       /* Select the behavior of write operations.
        */
       c[seg].allow_blocking_writes = allow_blocking_writes;
+
+      /* Locks that work across forked processes.  The pthread variant
+       * needs no re-initialization in the child processes.
+       */
+      c[seg].proc_lock = NULL;
+#if APR_HAS_PROC_PTHREAD_SERIALIZE
+      if (shared)
+        {
+          apr_status_t status =
+              apr_proc_mutex_create(&(c[seg].proc_lock), NULL,
+                                    APR_LOCK_PROC_PTHREAD, pool);
+          if (status)
+            return svn_error_wrap_apr(status,
+                                      _("Can't create shared cache mutex"));
+        }
 #endif
       /* No writers at the moment. */
       c[seg].write_lock_count = 0;
@@ -2054,6 +2581,39 @@ svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_cache__membuffer_cache_create(svn_membuffer_t **cache,
+                                  apr_size_t total_size,
+                                  apr_size_t directory_size,
+                                  apr_size_t segment_count,
+                                  svn_boolean_t thread_safe,
+                                  svn_boolean_t allow_blocking_writes,
+                                  apr_pool_t *pool)
+{
+  return svn_error_trace(membuffer_cache_create(cache, total_size,
+                                                directory_size,
+                                                segment_count,
+                                                thread_safe,
+                                                allow_blocking_writes,
+                                                FALSE, pool));
+}
+
+svn_error_t *
+svn_cache__membuffer_cache_create_shared(svn_membuffer_t **cache,
+                                         apr_size_t total_size,
+                                         apr_size_t directory_size,
+                                         apr_size_t segment_count,
+                                         svn_boolean_t allow_blocking_writes,
+                                         apr_pool_t *pool)
+{
+  return svn_error_trace(membuffer_cache_create(cache, total_size,
+                                                directory_size,
+                                                segment_count,
+                                                TRUE,
+                                                allow_blocking_writes,
+                                                TRUE, pool));
+}
+
 svn_error_t *
 svn_cache__membuffer_clear(svn_membuffer_t *cache)
 {
@@ -2343,6 +2903,7 @@ membuffer_cache_set(svn_membuffer_t *cache,
 
   /* The actual cache data access needs to sync'ed
    */
+  SVN_PROBE1(cache__set__start, size);
   WITH_WRITE_LOCK(cache,
                   membuffer_cache_set_internal(cache,
                                                key,
@@ -2352,22 +2913,39 @@ membuffer_cache_set(svn_membuffer_t *cache,
                                                priority,
                                                DEBUG_CACHE_MEMBUFFER_TAG
                                                scratch_pool));
+  SVN_PROBE1(cache__set__done, size);
   return SVN_NO_ERROR;
 }
 
+/* Return the read statistics stripe of CACHE to be used by the current
+ * thread.  The mapping does not need to be perfect, it just has to spread
+ * concurrent threads.  Since different threads run on different stacks,
+ * the address of a local variable is a good enough and cheap indicator.
+ */
+static APR_INLINE read_stats_t *
+get_read_stats(svn_membuffer_t *cache)
+{
+  char marker;
+  apr_uint32_t hash = (apr_uint32_t)((apr_uintptr_t)&marker >> 12)
+                    * 0x9e3779b1;
+
+  return &cache->read_stats[(hash >> 16) & (READ_STATS_STRIPES - 1)];
+}
+
 /* Count a hit in ENTRY within CACHE.
+ *
+ * This only requires a read lock on CACHE.
  */
 static void
 increment_hit_counters(svn_membuffer_t *cache, entry_t *entry)
 {
-  /* To minimize the memory footprint of the cache index, we limit local
-   * hit counters to 32 bits.  These may overflow but we don't really
-   * care because at worst, ENTRY will be dropped from cache once every
-   * few billion hits. */
-  svn_atomic_inc(&entry->hit_count);
+  /* Concurrent readers may push the counter slightly beyond MAX_HIT_COUNT
+   * but there is no risk of overflows.  Hot entries will only be read. */
+  if (entry->hit_count < MAX_HIT_COUNT)
+    svn_atomic_inc(&entry->hit_count);
 
   /* That one is for stats only. */
-  cache->total_hits++;
+  get_read_stats(cache)->hits++;
 }
 
 /* Look for the cache entry in group GROUP_INDEX of CACHE, identified
@@ -2394,7 +2972,7 @@ membuffer_cache_get_internal(svn_membuffer_t *cache,
   /* The actual cache data access needs to sync'ed
    */
   entry = find_entry(cache, group_index, to_find, FALSE);
-  cache->total_reads++;
+  get_read_stats(cache)->reads++;
   if (entry == NULL)
     {
       /* no such entry found.
@@ -2453,6 +3031,7 @@ membuffer_cache_get(svn_membuffer_t *cache,
   /* find the entry group that will hold the key.
    */
   group_index = get_group_index(&cache, &key->entry_key);
+  SVN_PROBE0(cache__get__start);
   WITH_READ_LOCK(cache,
                  membuffer_cache_get_internal(cache,
                                               group_index,
@@ -2461,6 +3040,7 @@ membuffer_cache_get(svn_membuffer_t *cache,
                                               &size,
                                               DEBUG_CACHE_MEMBUFFER_TAG
                                               result_pool));
+  SVN_PROBE2(cache__get__done, size, buffer != NULL);
 
   /* re-construct the original data object from its serialized form.
    */
@@ -2515,7 +3095,7 @@ membuffer_cache_has_key(svn_membuffer_t *cache,
   /* find the entry group that will hold the key.
    */
   apr_uint32_t group_index = get_group_index(&cache, &key->entry_key);
-  cache->total_reads++;
+  get_read_stats(cache)->reads++;
 
   WITH_READ_LOCK(cache,
                  membuffer_cache_has_key_internal(cache,
@@ -2549,7 +3129,7 @@ membuffer_cache_get_partial_internal(svn_membuffer_t *cache,
                                      apr_pool_t *result_pool)
 {
   entry_t *entry = find_entry(cache, group_index, to_find, FALSE);
-  cache->total_reads++;
+  get_read_stats(cache)->reads++;
   if (entry == NULL)
     {
       *item = NULL;
@@ -2632,7 +3212,7 @@ membuffer_cache_set_partial_internal(svn_membuffer_t *cache,
   /* cache item lookup
    */
   entry_t *entry = find_entry(cache, group_index, to_find, FALSE);
-  cache->total_reads++;
+  get_read_stats(cache)->reads++;
 
   /* this function is a no-op if the item is not in cache
    */
@@ -2799,6 +3379,11 @@ typedef struct svn_membuffer_cache_t
   /* priority class for all items written through this interface */
   apr_uint32_t priority;
 
+  /* Serialized items of at least this size get stored LZ4-compressed.
+   * If 0, compression is disabled and items are stored as they are.
+   */
+  apr_size_t compression_threshold;
+
   /* Temporary buffer containing the hash key for the current access
    */
   full_key_t combined_key;
@@ -2806,8 +3391,66 @@ typedef struct svn_membuffer_cache_t
   /* if enabled, this will serialize the access to this instance.
    */
   svn_mutex__t *mutex;
+
+  /* Access statistics not yet added to the shared statistics for PREFIX.
+   */
+  apr_uint32_t pending_gets;
+  apr_uint32_t pending_hits;
+  apr_uint32_t pending_sets;
 } svn_membuffer_cache_t;
 
+/* Add the access statistics collected locally in CACHE to the statistics
+ * shared by all caches with the same prefix.
+ */
+static svn_error_t *
+flush_prefix_stats(svn_membuffer_cache_t *cache)
+{
+  if (cache->pending_gets || cache->pending_sets)
+    {
+      SVN_ERR(prefix_stats_pool_add(cache->membuffer->prefix_stats,
+                                    cache->prefix.stats_idx,
+                                    cache->pending_gets,
+                                    cache->pending_hits,
+                                    cache->pending_sets));
+
+      cache->pending_gets = 0;
+      cache->pending_hits = 0;
+      cache->pending_sets = 0;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Count GETS, HITS and SETS as accesses to CACHE.  To keep the overhead
+ * low, we only update the shared statistics every now and then.
+ */
+static svn_error_t *
+count_access(svn_membuffer_cache_t *cache,
+             apr_uint32_t gets,
+             apr_uint32_t hits,
+             apr_uint32_t sets)
+{
+  cache->pending_gets += gets;
+  cache->pending_hits += hits;
+  cache->pending_sets += sets;
+
+  if (cache->pending_gets + cache->pending_sets
+      >= PREFIX_STATS_FLUSH_INTERVAL)
+    SVN_ERR(flush_prefix_stats(cache));
+
+  return SVN_NO_ERROR;
+}
+
+/* APR pool cleanup handler that makes sure the svn_membuffer_cache_t in
+ * BATON does not lose any recorded accesses.
+ */
+static apr_status_t
+flush_prefix_stats_cleanup(void *baton)
+{
+  svn_error_clear(flush_prefix_stats(baton));
+  return APR_SUCCESS;
+}
+
 /* Return the prefix key used by CACHE. */
 static const char *
 get_prefix_key(const svn_membuffer_cache_t *cache)
@@ -2917,6 +3560,177 @@ combine_key(svn_membuffer_cache_t *cache,
     = data[1] ^ cache->prefix.fingerprint[1];
 }
 
+/* Encode the serialized item in BUFFER of SIZE bytes for storage in
+ * CACHE, i.e. compress it if it is at least as large as CACHE's compression
+ * threshold, and append the ITEM_* marker.  Return the result in *ENCODED,
+ * allocated in RESULT_POOL.
+ */
+static svn_error_t *
+encode_item(svn_stringbuf_t **encoded,
+            svn_membuffer_cache_t *cache,
+            const void *buffer,
+            apr_size_t size,
+            apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(result_pool);
+
+  if (size >= cache->compression_threshold && size <= MAX_COMPRESSIBLE_SIZE)
+    {
+      SVN_ERR(svn__compress_lz4(buffer, size, result));
+      if (result->len < size)
+        {
+          svn_stringbuf_appendbyte(result, ITEM_LZ4);
+          *encoded = result;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  /* Not worth compressing. */
+  svn_stringbuf_setempty(result);
+  svn_stringbuf_ensure(result, size + 1);
+  svn_stringbuf_appendbytes(result, buffer, size);
+  svn_stringbuf_appendbyte(result, ITEM_PLAIN);
+  *encoded = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Reconstruct the serialized item from the DATA_LEN bytes in DATA that
+ * encode_item() produced and return it in *DECODED, allocated in
+ * RESULT_POOL.
+ */
+static svn_error_t *
+decode_item(svn_stringbuf_t **decoded,
+            const void *data,
+            apr_size_t data_len,
+            apr_pool_t *result_pool)
+{
+  const char *bytes = data;
+
+  if (data_len == 0)
+    return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                            _("Missing compression marker in cache item"));
+
+  if (bytes[data_len - 1] == ITEM_LZ4)
+    {
+      *decoded = svn_stringbuf_create_empty(result_pool);
+      SVN_ERR(svn__decompress_lz4(data, data_len - 1, *decoded,
+                                  MAX_COMPRESSIBLE_SIZE));
+    }
+  else
+    {
+      *decoded = svn_stringbuf_ncreate(data, data_len - 1, result_pool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_cache__serialize_func_t for the svn_stringbuf_t ITEM
+ * returned by encode_item().  Unlike serialize_svn_stringbuf(), this does
+ * not include the terminating NUL.
+ */
+static svn_error_t *
+serialize_encoded_item(void **buffer,
+                       apr_size_t *buffer_size,
+                       void *item,
+                       apr_pool_t *result_pool)
+{
+  svn_stringbuf_t *encoded = item;
+
+  *buffer = encoded->data;
+  *buffer_size = encoded->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_cache__partial_getter_func_t returning the decoded
+ * serialized item as an svn_stringbuf_t.  BATON is unused.
+ */
+static svn_error_t *
+get_decoded_item(void **out,
+                 const void *data,
+                 apr_size_t data_len,
+                 void *baton,
+                 apr_pool_t *result_pool)
+{
+  return svn_error_trace(decode_item((svn_stringbuf_t **)out, data,
+                                     data_len, result_pool));
+}
+
+/* Baton type used by get_partial_encoded() and set_partial_encoded() to
+ * forward calls to the user-provided partial getter / setter function.
+ */
+typedef struct partial_baton_t
+{
+  /* The cache instance accessed. */
+  svn_membuffer_cache_t *cache;
+
+  /* User-provided callbacks; only one of them is set. */
+  svn_cache__partial_getter_func_t getter;
+  svn_cache__partial_setter_func_t setter;
+
+  /* Baton to pass to GETTER or SETTER. */
+  void *baton;
+} partial_baton_t;
+
+/* Implement svn_cache__partial_getter_func_t for items stored through
+ * encode_item().  Plain items are passed to the user's getter in place;
+ * compressed ones get decompressed first.  BATON is a partial_baton_t.
+ */
+static svn_error_t *
+get_partial_encoded(void **out,
+                    const void *data,
+                    apr_size_t data_len,
+                    void *baton,
+                    apr_pool_t *result_pool)
+{
+  partial_baton_t *partial_baton = baton;
+  svn_stringbuf_t *decoded;
+
+  if (data_len && ((const char *)data)[data_len - 1] == ITEM_PLAIN)
+    return svn_error_trace(partial_baton->getter(out, data, data_len - 1,
+                                                 partial_baton->baton,
+                                                 result_pool));
+
+  SVN_ERR(decode_item(&decoded, data, data_len, result_pool));
+  return svn_error_trace(partial_baton->getter(out, decoded->data,
+                                               decoded->len,
+                                               partial_baton->baton,
+                                               result_pool));
+}
+
+/* Implement svn_cache__partial_setter_func_t for items stored through
+ * encode_item().  The user's setter operates on a decoded copy which then
+ * gets encoded again into a new buffer, i.e. the cache will re-insert the
+ * modified item.  BATON is a partial_baton_t.
+ */
+static svn_error_t *
+set_partial_encoded(void **data,
+                    apr_size_t *data_len,
+                    void *baton,
+                    apr_pool_t *result_pool)
+{
+  partial_baton_t *partial_baton = baton;
+  svn_stringbuf_t *decoded;
+  svn_stringbuf_t *encoded;
+  void *item_data;
+  apr_size_t item_size;
+
+  SVN_ERR(decode_item(&decoded, *data, *data_len, result_pool));
+  item_data = decoded->data;
+  item_size = decoded->len;
+
+  SVN_ERR(partial_baton->setter(&item_data, &item_size,
+                                partial_baton->baton, result_pool));
+  SVN_ERR(encode_item(&encoded, partial_baton->cache, item_data, item_size,
+                      result_pool));
+
+  *data = encoded->data;
+  *data_len = encoded->len;
+
+  return SVN_NO_ERROR;
+}
+
 /* Implement svn_cache__vtable_t.get (not thread-safe)
  */
 static svn_error_t *
@@ -2945,17 +3759,37 @@ svn_membuffer_cache_get(void **value_p,
   combine_key(cache, key, cache->key_len);
 
   /* Look the item up. */
-  SVN_ERR(membuffer_cache_get(cache->membuffer,
-                              &cache->combined_key,
-                              value_p,
-                              cache->deserializer,
-                              DEBUG_CACHE_MEMBUFFER_TAG
-                              result_pool));
+  if (cache->compression_threshold)
+    {
+      svn_stringbuf_t *decoded;
+      SVN_ERR(membuffer_cache_get_partial(cache->membuffer,
+                                          &cache->combined_key,
+                                          (void **)&decoded,
+                                          found,
+                                          get_decoded_item,
+                                          NULL,
+                                          DEBUG_CACHE_MEMBUFFER_TAG
+                                          result_pool));
+      if (*found)
+        SVN_ERR(cache->deserializer(value_p, decoded->data, decoded->len,
+                                    result_pool));
+      else
+        *value_p = NULL;
+    }
+  else
+    {
+      SVN_ERR(membuffer_cache_get(cache->membuffer,
+                                  &cache->combined_key,
+                                  value_p,
+                                  cache->deserializer,
+                                  DEBUG_CACHE_MEMBUFFER_TAG
+                                  result_pool));
+    }
 
   /* return result */
   *found = *value_p != NULL;
 
-  return SVN_NO_ERROR;
+  return svn_error_trace(count_access(cache, 1, *found ? 1 : 0, 0));
 }
 
 /* Implement svn_cache__vtable_t.has_key (not thread-safe)
@@ -3011,6 +3845,27 @@ svn_membuffer_cache_set(void *cache_void,
    */
   combine_key(cache, key, cache->key_len);
 
+  SVN_ERR(count_access(cache, 0, 0, 1));
+
+  /* Store a compressed or marked copy of the serialized item instead. */
+  if (cache->compression_threshold && value)
+    {
+      void *buffer;
+      apr_size_t size;
+      svn_stringbuf_t *encoded;
+
+      SVN_ERR(cache->serializer(&buffer, &size, value, scratch_pool));
+      SVN_ERR(encode_item(&encoded, cache, buffer, size, scratch_pool));
+
+      return membuffer_cache_set(cache->membuffer,
+                                 &cache->combined_key,
+                                 encoded,
+                                 serialize_encoded_item,
+                                 cache->priority,
+                                 DEBUG_CACHE_MEMBUFFER_TAG
+                                 scratch_pool);
+    }
+
   /* (probably) add the item to the cache. But there is no real guarantee
    * that the item will actually be cached afterwards.
    */
@@ -3060,6 +3915,18 @@ svn_membuffer_cache_get_partial(void **value_p,
     }
 
   combine_key(cache, key, cache->key_len);
+  if (cache->compression_threshold)
+    {
+      partial_baton_t *partial_baton = apr_pcalloc(result_pool,
+                                                   sizeof(*partial_baton));
+      partial_baton->cache = cache;
+      partial_baton->getter = func;
+      partial_baton->baton = baton;
+
+      func = get_partial_encoded;
+      baton = partial_baton;
+    }
+
   SVN_ERR(membuffer_cache_get_partial(cache->membuffer,
                                       &cache->combined_key,
                                       value_p,
@@ -3069,7 +3936,7 @@ svn_membuffer_cache_get_partial(void **value_p,
                                       DEBUG_CACHE_MEMBUFFER_TAG
                                       result_pool));
 
-  return SVN_NO_ERROR;
+  return svn_error_trace(count_access(cache, 1, *found ? 1 : 0, 0));
 }
 
 /* Implement svn_cache__vtable_t.set_partial (not thread-safe)
@@ -3088,6 +3955,19 @@ svn_membuffer_cache_set_partial(void *cache_void,
   if (key != NULL)
     {
       combine_key(cache, key, cache->key_len);
+      SVN_ERR(count_access(cache, 0, 0, 1));
+      if (cache->compression_threshold)
+        {
+          partial_baton_t *partial_baton
+            = apr_pcalloc(scratch_pool, sizeof(*partial_baton));
+          partial_baton->cache = cache;
+          partial_baton->setter = func;
+          partial_baton->baton = baton;
+
+          func = set_partial_encoded;
+          baton = partial_baton;
+        }
+
       SVN_ERR(membuffer_cache_set_partial(cache->membuffer,
                                           &cache->combined_key,
                                           func,
@@ -3186,7 +4066,8 @@ static svn_cache__vtable_t membuffer_cache_vtable = {
   svn_membuffer_cache_is_cachable,
   svn_membuffer_cache_get_partial,
   svn_membuffer_cache_set_partial,
-  svn_membuffer_cache_get_info
+  svn_membuffer_cache_get_info,
+  NULL                                    /* no batched reads */
 };
 
 /* Implement svn_cache__vtable_t.get and serialize all cache access.
@@ -3299,7 +4180,8 @@ static svn_cache__vtable_t membuffer_cache_synced_vtable = {
   svn_membuffer_cache_is_cachable,        /* no sync required */
   svn_membuffer_cache_get_partial_synced,
   svn_membuffer_cache_set_partial_synced,
-  svn_membuffer_cache_get_info            /* no sync required */
+  svn_membuffer_cache_get_info,           /* no sync required */
+  NULL                                    /* no batched reads */
 };
 
 /* standard serialization function for svn_stringbuf_t items.
@@ -3342,17 +4224,18 @@ deserialize_svn_stringbuf(void **item,
 /* Construct a svn_cache__t object on top of a shared memcache.
  */
 svn_error_t *
-svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
-                                  svn_membuffer_t *membuffer,
-                                  svn_cache__serialize_func_t serializer,
-                                  svn_cache__deserialize_func_t deserializer,
-                                  apr_ssize_t klen,
-                                  const char *prefix,
-                                  apr_uint32_t priority,
-                                  svn_boolean_t thread_safe,
-                                  svn_boolean_t short_lived,
-                                  apr_pool_t *result_pool,
-                                  apr_pool_t *scratch_pool)
+svn_cache__create_membuffer_cache2(svn_cache__t **cache_p,
+                                   svn_membuffer_t *membuffer,
+                                   svn_cache__serialize_func_t serializer,
+                                   svn_cache__deserialize_func_t deserializer,
+                                   apr_ssize_t klen,
+                                   const char *prefix,
+                                   apr_uint32_t priority,
+                                   apr_size_t compression_threshold,
+                                   svn_boolean_t thread_safe,
+                                   svn_boolean_t short_lived,
+                                   apr_pool_t *result_pool,
+                                   apr_pool_t *scratch_pool)
 {
   svn_checksum_t *checksum;
   apr_size_t prefix_len, prefix_orig_len;
@@ -3372,8 +4255,15 @@ svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
                       ? deserializer
                       : deserialize_svn_stringbuf;
   cache->priority = priority;
+  cache->compression_threshold = compression_threshold;
   cache->key_len = klen;
 
+  /* Items stored with and without compression markers must not be mixed
+   * up, e.g. when the configuration changes while another process keeps
+   * using a shared membuffer.  So, use separate key spaces for them. */
+  if (compression_threshold)
+    prefix = apr_pstrcat(scratch_pool, prefix, ":LZ4", SVN_VA_NULL);
+
   SVN_ERR(svn_mutex__init(&cache->mutex, thread_safe, result_pool));
 
   /* Copy the prefix into the prefix full key. Align it to ITEM_ALIGMENT.
@@ -3407,6 +4297,16 @@ svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
   else
     cache->prefix.prefix_idx = NO_INDEX;
 
+  /* Short-lived prefixes would only clutter the statistics.  In shared
+   * caches, the entries of other processes would refer to our statistics
+   * indexes, so attribute everything to the "other" prefix there. */
+  if (short_lived || membuffer->proc_lock)
+    cache->prefix.stats_idx = OTHER_PREFIX_STATS;
+  else
+    SVN_ERR(prefix_stats_pool_get(&cache->prefix.stats_idx,
+                                  membuffer->prefix_stats,
+                                  prefix));
+
   /* If key combining is not guaranteed to produce unique results, we have
    * to handle full keys.  Otherwise, leave it NULL. */
   if (cache->prefix.prefix_idx == NO_INDEX)
@@ -3428,9 +4328,14 @@ svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
        * it.  Keep the fingerprint 0 as well b/c it will always be set anew
        * by combine_key(). */
       cache->combined_key.entry_key.prefix_idx = cache->prefix.prefix_idx;
+      cache->combined_key.entry_key.stats_idx = cache->prefix.stats_idx;
       cache->combined_key.entry_key.key_len = 0;
     }
 
+  /* Don't lose the last accesses to this cache instance. */
+  apr_pool_cleanup_register(result_pool, cache, flush_prefix_stats_cleanup,
+                            apr_pool_cleanup_null);
+
   /* initialize the generic cache wrapper
    */
   wrapper->vtable = thread_safe ? &membuffer_cache_synced_vtable
@@ -3444,13 +4349,43 @@ svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_cache__create_membuffer_cache(svn_cache__t **cache_p,
+                                  svn_membuffer_t *membuffer,
+                                  svn_cache__serialize_func_t serializer,
+                                  svn_cache__deserialize_func_t deserializer,
+                                  apr_ssize_t klen,
+                                  const char *prefix,
+                                  apr_uint32_t priority,
+                                  svn_boolean_t thread_safe,
+                                  svn_boolean_t short_lived,
+                                  apr_pool_t *result_pool,
+                                  apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_cache__create_membuffer_cache2(cache_p,
+                                                            membuffer,
+                                                            serializer,
+                                                            deserializer,
+                                                            klen, prefix,
+                                                            priority, 0,
+                                                            thread_safe,
+                                                            short_lived,
+                                                            result_pool,
+                                                            scratch_pool));
+}
+
 static svn_error_t *
 svn_membuffer_get_global_segment_info(svn_membuffer_t *segment,
                                       svn_cache__info_t *info)
 {
-  info->gets += segment->total_reads;
+  int i;
+  for (i = 0; i < READ_STATS_STRIPES; ++i)
+    {
+      info->gets += segment->read_stats[i].reads;
+      info->hits += segment->read_stats[i].hits;
+    }
+
   info->sets += segment->total_writes;
-  info->hits += segment->total_hits;
 
   WITH_READ_LOCK(segment,
                   svn_membuffer_get_segment_info(segment, info, TRUE));
@@ -3476,5 +4411,124 @@ svn_cache__membuffer_get_global_info(apr_pool_t *pool)
     svn_error_clear(svn_membuffer_get_global_segment_info(membuffer + i,
                                                           info));
 
+  for (i = 0; i < membuffer->prefix_stats->stats_used; ++i)
+    info->evictions += membuffer->prefix_stats->stats[i].evictions;
+
   return info;
 }
+
+/* Add the number and size of the entries in SEGMENT to the elements of
+ * the INFOS array, indexed by the entries' prefix statistics index.
+ */
+static svn_error_t *
+svn_membuffer_get_segment_prefix_info(svn_membuffer_t *segment,
+                                      svn_cache__info_t *infos)
+{
+  cache_level_t *levels[2];
+  int i;
+
+  levels[0] = &segment->l1;
+  levels[1] = &segment->l2;
+
+  for (i = 0; i < 2; ++i)
+    {
+      apr_uint32_t idx = levels[i]->first;
+      while (idx != NO_INDEX)
+        {
+          entry_t *entry = get_entry(segment, idx);
+          svn_cache__info_t *info = &infos[entry->key.stats_idx];
+
+          info->used_entries++;
+          info->used_size += entry->size;
+
+          idx = entry->next;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Copy the access statistics from STATS_POOL to the respective elements
+ * of the INFOS array and set *COUNT to the number of valid elements.
+ * Allocate the IDs in RESULT_POOL.
+ *
+ * This function must be called with STATS_POOL->MUTEX acquired.
+ */
+static svn_error_t *
+get_prefix_access_info(svn_cache__info_t *infos,
+                       apr_uint32_t *count,
+                       prefix_stats_pool_t *stats_pool,
+                       apr_pool_t *result_pool)
+{
+  apr_uint32_t i;
+  for (i = 0; i < stats_pool->stats_used; ++i)
+    {
+      const prefix_stats_t *stats = &stats_pool->stats[i];
+
+      infos[i].id = stats->prefix
+                  ? apr_pstrdup(result_pool, stats->prefix)
+                  : "(other)";
+      infos[i].gets = stats->gets;
+      infos[i].hits = stats->hits;
+      infos[i].sets = stats->sets;
+      infos[i].evictions = stats->evictions;
+    }
+
+  *count = stats_pool->stats_used;
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_cache__membuffer_get_prefix_info with error reporting.
+ */
+static svn_error_t *
+get_prefix_info(apr_array_header_t *result,
+                svn_membuffer_t *membuffer,
+                apr_pool_t *result_pool)
+{
+  prefix_stats_pool_t *stats_pool = membuffer->prefix_stats;
+  svn_cache__info_t *infos = apr_pcalloc(result_pool,
+                                         MAX_PREFIX_STATS * sizeof(*infos));
+  svn_cache__info_t total = { 0 };
+  apr_uint32_t count;
+  apr_uint32_t i;
+
+  SVN_MUTEX__WITH_LOCK(stats_pool->mutex,
+                       get_prefix_access_info(infos, &count, stats_pool,
+                                              result_pool));
+
+  for (i = 0; i < membuffer->segment_count; ++i)
+    {
+      svn_membuffer_t *segment = membuffer + i;
+      WITH_READ_LOCK(segment,
+                     svn_membuffer_get_segment_info(segment, &total, FALSE));
+      WITH_READ_LOCK(segment,
+                     svn_membuffer_get_segment_prefix_info(segment, infos));
+    }
+
+  for (i = 0; i < count; ++i)
+    {
+      svn_cache__info_t *info = &infos[i];
+      if (info->gets || info->sets || info->used_entries)
+        {
+          info->data_size = total.data_size;
+          info->total_size = total.total_size;
+          info->total_entries = total.total_entries;
+
+          APR_ARRAY_PUSH(result, svn_cache__info_t *) = info;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+apr_array_header_t *
+svn_cache__membuffer_get_prefix_info(svn_membuffer_t *membuffer,
+                                     apr_pool_t *pool)
+{
+  apr_array_header_t *result = apr_array_make(pool, 16,
+                                              sizeof(svn_cache__info_t *));
+  if (membuffer)
+    svn_error_clear(get_prefix_info(result, membuffer, pool));
+
+  return result;
+}
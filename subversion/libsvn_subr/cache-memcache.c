@@ -23,6 +23,7 @@
 
 #include <apr_md5.h>
 
+#include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_base64.h"
 #include "svn_path.h"
@@ -36,19 +37,33 @@
 #ifdef SVN_HAVE_MEMCACHE
 
 #include <apr_memcache.h>
+#if APR_HAS_THREADS
+#include <apr_thread_pool.h>
+#endif
 
 /* A note on thread safety:
 
    The apr_memcache_t object does its own mutex handling, and nothing
    else in memcache_t is ever modified, so this implementation should
-   be fully thread-safe.
+   be fully thread-safe.  The same goes for the write-behind thread
+   pool in svn_memcache_t which is only set up before the first cache
+   gets created.
 */
 
+/* Maximum number of asynchronous writes waiting to be sent to the
+   memcached servers.  Further writes will be dropped until the backlog
+   has been reduced.  Dropping a write merely costs a future cache miss. */
+#define MAX_PENDING_WRITES 256
+
 /* The (internal) cache object. */
 typedef struct memcache_t {
   /* The memcached server set we're using. */
   apr_memcache_t *memcache;
 
+  /* The wrapper that MEMCACHE came from.  Tells us whether to write
+   * asynchronously. */
+  svn_memcache_t *owner;
+
   /* A prefix used to differentiate our data from any other data in
    * the memcached (URI-encoded). */
   const char *prefix;
@@ -66,6 +81,15 @@ typedef struct memcache_t {
 /* The wrapper around apr_memcache_t. */
 struct svn_memcache_t {
   apr_memcache_t *c;
+
+  /* The pool that C has been allocated in. */
+  apr_pool_t *pool;
+
+#if APR_HAS_THREADS
+  /* Single-threaded pool sending cache writes to the servers in the
+   * background.  NULL, if writes are synchronous. */
+  apr_thread_pool_t *writer;
+#endif
 };
 
 
@@ -127,6 +151,34 @@ build_key(const char **mc_key,
   return SVN_NO_ERROR;
 }
 
+/* Set *VALUE_P to the value of CACHE stored in the DATA_LEN bytes of DATA
+ * as read from memcached.  DATA must have been allocated in RESULT_POOL,
+ * which will also be used to allocate the result.
+ */
+static svn_error_t *
+deserialize_value(void **value_p,
+                  memcache_t *cache,
+                  char *data,
+                  apr_size_t data_len,
+                  apr_pool_t *result_pool)
+{
+  if (cache->deserialize_func)
+    {
+      SVN_ERR((cache->deserialize_func)(value_p, data, data_len,
+                                        result_pool));
+    }
+  else
+    {
+      svn_stringbuf_t *value = svn_stringbuf_create_empty(result_pool);
+      value->data = data;
+      value->blocksize = data_len;
+      value->len = data_len - 1; /* account for trailing NUL */
+      *value_p = value;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 /* Core functionality of our getter functions: fetch DATA from the memcached
  * given by CACHE_VOID and identified by KEY. Indicate success in FOUND and
  * use a tempoary sub-pool of POOL for allocations.
@@ -195,22 +247,66 @@ memcache_get(void **value_p,
 
   /* If we found it, de-serialize it. */
   if (*found)
+    SVN_ERR(deserialize_value(value_p, cache, data, data_len, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implement vtable.get_many using a single memcached multi-get request
+ * per server instead of one round-trip per key.
+ */
+static svn_error_t *
+memcache_get_many(apr_array_header_t *values,
+                  void *cache_void,
+                  const apr_array_header_t *keys,
+                  apr_pool_t *result_pool)
+{
+  memcache_t *cache = cache_void;
+  apr_pool_t *subpool = svn_pool_create(result_pool);
+  const char **mc_keys = apr_pcalloc(subpool,
+                                     keys->nelts * sizeof(*mc_keys));
+  apr_hash_t *mc_values = NULL;
+  apr_status_t apr_err;
+  int i;
+
+  for (i = 0; i < keys->nelts; ++i)
     {
-      if (cache->deserialize_func)
-        {
-          SVN_ERR((cache->deserialize_func)(value_p, data, data_len,
-                                            result_pool));
-        }
-      else
-        {
-          svn_stringbuf_t *value = svn_stringbuf_create_empty(result_pool);
-          value->data = data;
-          value->blocksize = data_len;
-          value->len = data_len - 1; /* account for trailing NUL */
-          *value_p = value;
-        }
+      const void *key = APR_ARRAY_IDX(keys, i, const void *);
+      if (key == NULL)
+        continue;
+
+      /* Duplicate keys simply map to the same hash entry. */
+      SVN_ERR(build_key(&mc_keys[i], cache, key, subpool));
+      apr_memcache_add_multget_key(subpool, mc_keys[i], &mc_values);
     }
 
+  /* Nothing to look up? */
+  if (mc_values == NULL)
+    {
+      svn_pool_destroy(subpool);
+      return SVN_NO_ERROR;
+    }
+
+  apr_err = apr_memcache_multgetp(cache->memcache, subpool, result_pool,
+                                  mc_values);
+  if (apr_err != APR_SUCCESS)
+    return svn_error_wrap_apr(apr_err,
+                              _("Unknown memcached error while reading"));
+
+  for (i = 0; i < keys->nelts; ++i)
+    {
+      apr_memcache_value_t *mc_value;
+      if (mc_keys[i] == NULL)
+        continue;
+
+      mc_value = svn_hash_gets(mc_values, mc_keys[i]);
+      if (mc_value && mc_value->status == APR_SUCCESS && mc_value->data)
+        SVN_ERR(deserialize_value(&APR_ARRAY_IDX(values, i, void *), cache,
+                                  mc_value->data, mc_value->len,
+                                  result_pool));
+    }
+
+  svn_pool_destroy(subpool);
   return SVN_NO_ERROR;
 }
 
@@ -234,9 +330,79 @@ memcache_has_key(svn_boolean_t *found,
   return SVN_NO_ERROR;
 }
 
+#if APR_HAS_THREADS
+
+/* A cache write waiting to be sent to memcached by the writer thread.
+ * This is allocated with malloc() because it is being freed by a
+ * different thread than the one that created it.
+ */
+typedef struct async_write_t
+{
+  /* Server set to write to. */
+  apr_memcache_t *memcache;
+
+  /* Length of the data, which follows the NUL-terminated key in BUFFER. */
+  apr_size_t len;
+
+  /* Key and data. */
+  char buffer[1];
+} async_write_t;
+
+/* Implements apr_thread_start_t.  Send the async_write_t given by DATA
+ * to memcached and release it.  Errors are ignored because nobody is
+ * waiting for the result.
+ */
+static void * APR_THREAD_FUNC
+async_write_task(apr_thread_t *thread,
+                 void *data)
+{
+  async_write_t *write = data;
+  apr_size_t key_len = strlen(write->buffer);
+
+  apr_memcache_set(write->memcache, write->buffer,
+                   write->buffer + key_len + 1, write->len, 0, 0);
+  free(write);
+
+  return NULL;
+}
+
+/* Hand the LEN bytes of DATA to be stored under MC_KEY in CACHE over to
+ * the writer thread of CACHE->OWNER.  Drop the write, if the writer is
+ * falling behind or the data cannot be queued.
+ */
+static void
+queue_async_write(memcache_t *cache,
+                  const char *mc_key,
+                  const char *data,
+                  apr_size_t len)
+{
+  apr_thread_pool_t *writer = cache->owner->writer;
+  apr_size_t key_len = strlen(mc_key);
+  async_write_t *write;
+
+  if (apr_thread_pool_tasks_count(writer) >= MAX_PENDING_WRITES)
+    return;
+
+  write = malloc(sizeof(*write) + key_len + 1 + len);
+  if (write == NULL)
+    return;
+
+  write->memcache = cache->memcache;
+  write->len = len;
+  memcpy(write->buffer, mc_key, key_len + 1);
+  memcpy(write->buffer + key_len + 1, data, len);
+
+  if (apr_thread_pool_push(writer, async_write_task, write,
+                           APR_THREAD_TASK_PRIORITY_NORMAL, NULL))
+    free(write);
+}
+
+#endif /* APR_HAS_THREADS */
+
 /* Core functionality of our setter functions: store LENGTH bytes of DATA
  * to be identified by KEY in the memcached given by CACHE_VOID. Use POOL
- * for temporary allocations.
+ * for temporary allocations.  If asynchronous writes have been enabled
+ * for the memcached, the data will be copied and sent in the background.
  */
 static svn_error_t *
 memcache_internal_set(void *cache_void,
@@ -250,6 +416,15 @@ memcache_internal_set(void *cache_void,
   apr_status_t apr_err;
 
   SVN_ERR(build_key(&mc_key, cache, key, scratch_pool));
+
+#if APR_HAS_THREADS
+  if (cache->owner->writer)
+    {
+      queue_async_write(cache, mc_key, data, len);
+      return SVN_NO_ERROR;
+    }
+#endif
+
   apr_err = apr_memcache_set(cache->memcache, mc_key, (char *)data, len, 0, 0);
 
   /* ### Maybe write failures should be ignored (but logged)? */
@@ -398,7 +573,8 @@ static svn_cache__vtable_t memcache_vtable = {
   memcache_is_cachable,
   memcache_get_partial,
   memcache_set_partial,
-  memcache_get_info
+  memcache_get_info,
+  memcache_get_many
 };
 
 svn_error_t *
@@ -418,6 +594,7 @@ svn_cache__create_memcache(svn_cache__t **cache_p,
   cache->klen = klen;
   cache->prefix = svn_path_uri_encode(prefix, pool);
   cache->memcache = memcache->c;
+  cache->owner = memcache;
 
   wrapper->vtable = &memcache_vtable;
   wrapper->cache_internal = cache;
@@ -508,6 +685,26 @@ add_memcache_server(const char *name,
   return TRUE;
 }
 
+svn_error_t *
+svn_cache__memcache_enable_async_writes(svn_memcache_t *memcache)
+{
+#if APR_HAS_THREADS
+  apr_status_t apr_err;
+
+  if (memcache->writer)
+    return SVN_NO_ERROR;
+
+  /* A single thread is enough to keep up with the servers and keeps the
+     writes in order. */
+  apr_err = apr_thread_pool_create(&memcache->writer, 1, 1, memcache->pool);
+  if (apr_err != APR_SUCCESS)
+    return svn_error_wrap_apr(apr_err,
+                              _("Can't create memcached writer thread"));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
 #else /* ! SVN_HAVE_MEMCACHE */
 
 /* Stubs for no apr memcache library. */
@@ -528,6 +725,12 @@ svn_cache__create_memcache(svn_cache__t **cache_p,
   return svn_error_create(SVN_ERR_NO_APR_MEMCACHE, NULL, NULL);
 }
 
+svn_error_t *
+svn_cache__memcache_enable_async_writes(svn_memcache_t *memcache)
+{
+  return svn_error_create(SVN_ERR_NO_APR_MEMCACHE, NULL, NULL);
+}
+
 #endif /* SVN_HAVE_MEMCACHE */
 
 /* Implements svn_config_enumerator2_t.  Just used for the
@@ -573,6 +776,7 @@ svn_cache__make_memcache_from_config(svn_memcache_t **memcache_p,
       return svn_error_wrap_apr(apr_err,
                                 _("Unknown error creating apr_memcache_t"));
 
+    memcache->pool = result_pool;
     b.memcache = memcache->c;
     b.memcache_pool = result_pool;
     b.err = SVN_NO_ERROR;
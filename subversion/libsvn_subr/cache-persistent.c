@@ -0,0 +1,703 @@
+/*
+ * cache-persistent.c: file-backed second-level cache
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_mmap.h>
+
+#include "svn_hash.h"
+#include "svn_pools.h"
+#include "svn_io.h"
+#include "svn_dirent_uri.h"
+#include "svn_private_config.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+#include "private/svn_subr_private.h"
+
+#include "cache.h"
+
+/* A note on the file format and on thread safety:
+
+   The store is a single, append-only "segment" file.  It starts with
+   HEADER and is followed by any number of records.  Each record consists
+   of RECORD_HEADER_SIZE bytes containing the key length, the value length
+   and the FNV-1a checksum over key and value - each as a 4 byte big-endian
+   number - followed by the key and the value.  Values are stored exactly
+   as produced by the cache's serializer, i.e. usually in the format of
+   temp_serializer.c.
+
+   When a store gets opened, we map the file into memory and build an
+   index over all valid records.  A torn record at the end of the file,
+   e.g. left behind by a crashed process, gets truncated.  The mapping and
+   the index never change afterwards and may be read without any locking.
+
+   New entries get appended at the end of the file under an exclusive
+   file lock, so multiple processes may share the same file.  They will
+   become visible to readers only after the next restart; until then,
+   they are expected to be in the first-level cache anyway.
+ */
+
+/* File format marker. */
+#define HEADER "SVN-L2C1"
+#define HEADER_SIZE (sizeof(HEADER) - 1)
+
+/* Length of the fixed-size part of each record. */
+#define RECORD_HEADER_SIZE 12
+
+/* Location of a value within the mapped segment file. */
+typedef struct entry_t
+{
+  const char *data;
+  apr_size_t size;
+} entry_t;
+
+struct svn_cache__persistent_t
+{
+  /* Segment file name. */
+  const char *path;
+
+  /* The mapped file contents and their size at the time of opening. */
+  const char *data;
+  apr_size_t size;
+
+#if APR_HAS_MMAP
+  apr_mmap_t *mmap;
+#endif
+
+  /* Maps full keys to entry_t *.  Read-only after opening the store. */
+  apr_hash_t *index;
+
+  /* The members below are protected by MUTEX. */
+  svn_mutex__t *mutex;
+
+  /* The segment file, opened for writing.  NULL if the store is
+     read-only or if we stopped writing to it. */
+  apr_file_t *file;
+
+  /* Current size of the segment file as far as we know. */
+  apr_uint64_t file_size;
+
+  /* Don't grow the file beyond this. */
+  apr_uint64_t max_size;
+
+  /* Full keys of all entries that we appended.  Prevents us from writing
+     the same entry twice after it got evicted from the first level. */
+  apr_hash_t *appended;
+
+  /* Root pool with its own allocator, containing all of the above. */
+  apr_pool_t *pool;
+};
+
+/* Process-wide registry of open stores, mapping paths to
+   svn_cache__persistent_t *.  All access must be serialized by
+   STORES_MUTEX. */
+static apr_hash_t *stores = NULL;
+static svn_mutex__t *stores_mutex = NULL;
+static apr_pool_t *stores_pool = NULL;
+static volatile svn_atomic_t stores_initialized = 0;
+
+/* Implements svn_atomic__err_init_func_t. */
+static svn_error_t *
+init_stores(void *baton,
+            apr_pool_t *pool)
+{
+  stores_pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  stores = apr_hash_make(stores_pool);
+
+  return svn_error_trace(svn_mutex__init(&stores_mutex, TRUE, stores_pool));
+}
+
+/* Encode VALUE as 4 bytes big-endian at P. */
+static void
+encode_uint32(char *p,
+              apr_uint32_t value)
+{
+  p[0] = (char)(value >> 24);
+  p[1] = (char)(value >> 16);
+  p[2] = (char)(value >> 8);
+  p[3] = (char)value;
+}
+
+/* Return the 4 byte big-endian number at P. */
+static apr_uint32_t
+decode_uint32(const char *p)
+{
+  const unsigned char *u = (const unsigned char *)p;
+  return ((apr_uint32_t)u[0] << 24) | ((apr_uint32_t)u[1] << 16)
+       | ((apr_uint32_t)u[2] << 8) | (apr_uint32_t)u[3];
+}
+
+/* Return the checksum over KEY of length KEY_LEN followed by VALUE of
+   length VALUE_LEN. */
+static apr_uint32_t
+record_checksum(const char *key,
+                apr_size_t key_len,
+                const char *value,
+                apr_size_t value_len)
+{
+  /* Mix the checksum of the value into that of the key such that
+     moving the boundary between the two changes the result. */
+  return svn__fnv1a_32(key, key_len) * 31
+       + svn__fnv1a_32(value, value_len);
+}
+
+/* Add all valid records in the mapped segment of STORE to its index.
+   Return the offset behind the last valid record in *VALID_END. */
+static void
+build_index(apr_size_t *valid_end,
+            svn_cache__persistent_t *store)
+{
+  apr_size_t offset = HEADER_SIZE;
+
+  while (store->size - offset >= RECORD_HEADER_SIZE)
+    {
+      const char *record = store->data + offset;
+      apr_uint32_t key_len = decode_uint32(record);
+      apr_uint32_t value_len = decode_uint32(record + 4);
+      apr_uint32_t checksum = decode_uint32(record + 8);
+      const char *key = record + RECORD_HEADER_SIZE;
+      entry_t *entry;
+
+      if (   key_len == 0
+          || key_len > store->size - offset - RECORD_HEADER_SIZE
+          || value_len > store->size - offset - RECORD_HEADER_SIZE - key_len)
+        break;
+
+      if (checksum != record_checksum(key, key_len, key + key_len,
+                                      value_len))
+        break;
+
+      entry = apr_palloc(store->pool, sizeof(*entry));
+      entry->data = key + key_len;
+      entry->size = value_len;
+      apr_hash_set(store->index, key, key_len, entry);
+
+      offset += RECORD_HEADER_SIZE + key_len + value_len;
+    }
+
+  *valid_end = offset;
+}
+
+/* Open the segment file at PATH and return the new store in *STORE_P.
+   If the file cannot be mapped, set *STORE_P to NULL. */
+static svn_error_t *
+open_store(svn_cache__persistent_t **store_p,
+           const char *path,
+           apr_uint64_t max_size,
+           apr_pool_t *scratch_pool)
+{
+#if APR_HAS_MMAP
+  apr_pool_t *pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  svn_cache__persistent_t *store = apr_pcalloc(pool, sizeof(*store));
+  apr_file_t *file;
+  svn_filesize_t file_size;
+  apr_size_t valid_end = HEADER_SIZE;
+  svn_error_t *err;
+  apr_status_t status;
+
+  store->path = apr_pstrdup(pool, path);
+  store->index = apr_hash_make(pool);
+  store->appended = apr_hash_make(pool);
+  store->max_size = max_size;
+  store->pool = pool;
+  SVN_ERR(svn_mutex__init(&store->mutex, TRUE, pool));
+
+  /* Fall back to read-only access if we can't write to the file. */
+  err = svn_io_file_open(&file, path,
+                         APR_READ | APR_WRITE | APR_CREATE | APR_BINARY,
+                         APR_OS_DEFAULT, pool);
+  if (err && APR_STATUS_IS_EACCES(err->apr_err))
+    {
+      svn_error_clear(err);
+      err = svn_io_file_open(&file, path, APR_READ | APR_BINARY,
+                             APR_OS_DEFAULT, pool);
+      if (!err)
+        store->max_size = 0;
+    }
+
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  /* Nobody may append while we check and repair the file. */
+  err = svn_io_lock_open_file(file, store->max_size > 0, FALSE, pool);
+  if (!err)
+    err = svn_io_file_size_get(&file_size, file, pool);
+
+  if (!err && file_size == 0 && store->max_size > 0)
+    {
+      err = svn_io_file_write_full(file, HEADER, HEADER_SIZE, NULL, pool);
+      if (!err)
+        err = svn_io_file_flush(file, pool);
+
+      file_size = HEADER_SIZE;
+    }
+
+  if (!err && (file_size < HEADER_SIZE || file_size > APR_SIZE_MAX))
+    err = svn_error_createf(SVN_ERR_BAD_VERSION_FILE_FORMAT, NULL,
+                            _("Invalid cache file size in '%s'"),
+                            svn_dirent_local_style(path, pool));
+
+  if (!err)
+    {
+      status = apr_mmap_create(&store->mmap, file, 0, (apr_size_t)file_size,
+                               APR_MMAP_READ, pool);
+      if (status)
+        err = svn_error_wrap_apr(status, _("Can't map cache file '%s'"),
+                                 svn_dirent_local_style(path, pool));
+    }
+
+  if (!err)
+    {
+      store->data = store->mmap->mm;
+      store->size = (apr_size_t)file_size;
+
+      if (memcmp(store->data, HEADER, HEADER_SIZE))
+        err = svn_error_createf(SVN_ERR_BAD_VERSION_FILE_FORMAT, NULL,
+                                _("Unknown cache file format in '%s'"),
+                                svn_dirent_local_style(path, pool));
+    }
+
+  if (!err)
+    {
+      build_index(&valid_end, store);
+
+      /* Drop torn records at the end of the file.  Nobody else can have
+         mapped them because they would already have truncated them. */
+      if (valid_end < store->size && store->max_size > 0)
+        err = svn_io_file_trunc(file, valid_end, pool);
+    }
+
+  if (!err)
+    err = svn_io_unlock_open_file(file, pool);
+
+  if (err)
+    {
+      svn_pool_destroy(pool);
+      return svn_error_trace(err);
+    }
+
+  store->file_size = valid_end;
+  if (store->max_size > 0)
+    store->file = file;
+
+  *store_p = store;
+#else
+  *store_p = NULL;
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_cache__get_persistent_store(svn_cache__persistent_t **store_p,
+                                const char *path,
+                                apr_uint64_t max_size,
+                                apr_pool_t *scratch_pool)
+{
+  svn_cache__persistent_t *store;
+  svn_error_t *err;
+
+  SVN_ERR(svn_atomic__init_once(&stores_initialized, init_stores, NULL,
+                                scratch_pool));
+
+  SVN_ERR(svn_mutex__lock(stores_mutex));
+
+  store = svn_hash_gets(stores, path);
+  if (store)
+    err = SVN_NO_ERROR;
+  else
+    err = open_store(&store, path, max_size, scratch_pool);
+
+  if (!err && store && !svn_hash_gets(stores, path))
+    svn_hash_sets(stores, apr_pstrdup(stores_pool, path), store);
+
+  SVN_ERR(svn_mutex__unlock(stores_mutex, err));
+
+  *store_p = store;
+  return SVN_NO_ERROR;
+}
+
+/* Look up the entry for the full KEY of length KEY_LEN in STORE.
+   Return NULL if there is none. */
+static const entry_t *
+lookup(svn_cache__persistent_t *store,
+       const char *key,
+       apr_size_t key_len)
+{
+  return apr_hash_get(store->index, key, key_len);
+}
+
+/* Append a record for the full KEY of length KEY_LEN and the serialized
+   VALUE of length VALUE_LEN to STORE.
+
+   This function must be called with STORE->MUTEX acquired. */
+static svn_error_t *
+append(svn_cache__persistent_t *store,
+       const char *key,
+       apr_size_t key_len,
+       const char *value,
+       apr_size_t value_len,
+       apr_pool_t *scratch_pool)
+{
+  apr_size_t record_len = RECORD_HEADER_SIZE + key_len + value_len;
+  apr_pool_t *lock_pool;
+  apr_off_t offset = 0;
+  char *record;
+  svn_error_t *err;
+
+  if (   store->file == NULL
+      || key_len > APR_UINT32_MAX
+      || value_len > APR_UINT32_MAX
+      || store->file_size + record_len > store->max_size
+      || apr_hash_get(store->appended, key, key_len))
+    return SVN_NO_ERROR;
+
+  record = apr_palloc(scratch_pool, record_len);
+  encode_uint32(record, (apr_uint32_t)key_len);
+  encode_uint32(record + 4, (apr_uint32_t)value_len);
+  encode_uint32(record + 8, record_checksum(key, key_len, value, value_len));
+  memcpy(record + RECORD_HEADER_SIZE, key, key_len);
+  memcpy(record + RECORD_HEADER_SIZE + key_len, value, value_len);
+
+  /* The file lock functions allocate from the file's pool tree. */
+  lock_pool = svn_pool_create(store->pool);
+
+  err = svn_io_lock_open_file(store->file, TRUE, FALSE, lock_pool);
+  if (!err)
+    {
+      err = svn_io_file_seek(store->file, APR_END, &offset, lock_pool);
+      if (!err && offset + record_len > store->max_size)
+        store->file_size = offset;
+      else if (!err)
+        {
+          err = svn_io_file_write_full(store->file, record, record_len,
+                                       NULL, lock_pool);
+          if (!err)
+            err = svn_io_file_flush(store->file, lock_pool);
+
+          /* Don't leave a torn record behind for others to append to. */
+          if (err)
+            svn_error_clear(svn_io_file_trunc(store->file, offset,
+                                              lock_pool));
+          else
+            store->file_size = offset + record_len;
+        }
+
+      err = svn_error_compose_create(err,
+                                     svn_io_unlock_open_file(store->file,
+                                                             lock_pool));
+    }
+
+  if (err)
+    {
+      /* Caching is optional.  Stop writing to this store but keep
+         serving what we have. */
+      svn_error_clear(err);
+      store->file = NULL;
+    }
+  else
+    {
+      char *key_copy = apr_pmemdup(store->pool, key, key_len);
+      apr_hash_set(store->appended, key_copy, key_len, key_copy);
+    }
+
+  svn_pool_destroy(lock_pool);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* The svn_cache__t implementation wrapping a first-level cache. */
+typedef struct persistent_cache_t
+{
+  /* First cache level.  Gets queried first and receives all writes. */
+  svn_cache__t *l1;
+
+  /* Second cache level. */
+  svn_cache__persistent_t *store;
+
+  /* Prepended to all keys within STORE. */
+  const char *prefix;
+  apr_size_t prefix_len;
+
+  /* The size of the key: either a fixed number of bytes or
+   * APR_HASH_KEY_STRING. */
+  apr_ssize_t klen;
+
+  /* Used to marshal values in and out of STORE. */
+  svn_cache__serialize_func_t serialize_func;
+  svn_cache__deserialize_func_t deserialize_func;
+} persistent_cache_t;
+
+/* Return the full key for KEY in CACHE in *FULL_KEY and its length in
+   *FULL_KEY_LEN.  Allocate it in RESULT_POOL. */
+static void
+build_key(const char **full_key,
+          apr_size_t *full_key_len,
+          persistent_cache_t *cache,
+          const void *key,
+          apr_pool_t *result_pool)
+{
+  apr_size_t key_len = cache->klen == APR_HASH_KEY_STRING
+                     ? strlen(key)
+                     : (apr_size_t)cache->klen;
+  char *result = apr_palloc(result_pool, cache->prefix_len + key_len);
+
+  memcpy(result, cache->prefix, cache->prefix_len);
+  memcpy(result + cache->prefix_len, key, key_len);
+
+  *full_key = result;
+  *full_key_len = cache->prefix_len + key_len;
+}
+
+/* Return a copy of the serialized value in ENTRY, allocated in
+   RESULT_POOL.  Deserializers modify their input, so we can't use the
+   read-only mapping directly. */
+static void *
+copy_entry(const entry_t *entry,
+           apr_pool_t *result_pool)
+{
+  return apr_pmemdup(result_pool, entry->data, entry->size);
+}
+
+static svn_error_t *
+persistent_cache_get(void **value_p,
+                     svn_boolean_t *found,
+                     void *cache_void,
+                     const void *key,
+                     apr_pool_t *result_pool)
+{
+  persistent_cache_t *cache = cache_void;
+  const entry_t *entry;
+  const char *full_key;
+  apr_size_t full_key_len;
+  apr_pool_t *scratch_pool;
+
+  SVN_ERR(svn_cache__get(value_p, found, cache->l1, key, result_pool));
+  if (*found)
+    return SVN_NO_ERROR;
+
+  scratch_pool = svn_pool_create(result_pool);
+  build_key(&full_key, &full_key_len, cache, key, scratch_pool);
+  entry = lookup(cache->store, full_key, full_key_len);
+
+  if (entry)
+    {
+      SVN_ERR(cache->deserialize_func(value_p, copy_entry(entry, result_pool),
+                                      entry->size, result_pool));
+      *found = TRUE;
+
+      /* Promote the entry to the first level. */
+      SVN_ERR(svn_cache__set(cache->l1, key, *value_p, scratch_pool));
+    }
+
+  svn_pool_destroy(scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+persistent_cache_has_key(svn_boolean_t *found,
+                         void *cache_void,
+                         const void *key,
+                         apr_pool_t *scratch_pool)
+{
+  persistent_cache_t *cache = cache_void;
+  const char *full_key;
+  apr_size_t full_key_len;
+
+  SVN_ERR(svn_cache__has_key(found, cache->l1, key, scratch_pool));
+  if (*found)
+    return SVN_NO_ERROR;
+
+  build_key(&full_key, &full_key_len, cache, key, scratch_pool);
+  *found = lookup(cache->store, full_key, full_key_len) != NULL;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+persistent_cache_set(void *cache_void,
+                     const void *key,
+                     void *value,
+                     apr_pool_t *scratch_pool)
+{
+  persistent_cache_t *cache = cache_void;
+  const char *full_key;
+  apr_size_t full_key_len;
+  void *data;
+  apr_size_t data_len;
+
+  SVN_ERR(svn_cache__set(cache->l1, key, value, scratch_pool));
+  if (cache->store->max_size == 0)
+    return SVN_NO_ERROR;
+
+  /* Entries that were present when we opened the store need not be
+     written again. */
+  build_key(&full_key, &full_key_len, cache, key, scratch_pool);
+  if (lookup(cache->store, full_key, full_key_len))
+    return SVN_NO_ERROR;
+
+  SVN_ERR(cache->serialize_func(&data, &data_len, value, scratch_pool));
+  SVN_MUTEX__WITH_LOCK(cache->store->mutex,
+                       append(cache->store, full_key, full_key_len,
+                              data, data_len, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+persistent_cache_iter(svn_boolean_t *completed,
+                      void *cache_void,
+                      svn_iter_apr_hash_cb_t user_cb,
+                      void *user_baton,
+                      apr_pool_t *scratch_pool)
+{
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Can't iterate a persistent cache"));
+}
+
+static svn_boolean_t
+persistent_cache_is_cachable(void *cache_void,
+                             apr_size_t size)
+{
+  persistent_cache_t *cache = cache_void;
+  return svn_cache__is_cachable(cache->l1, size);
+}
+
+static svn_error_t *
+persistent_cache_get_partial(void **value_p,
+                             svn_boolean_t *found,
+                             void *cache_void,
+                             const void *key,
+                             svn_cache__partial_getter_func_t func,
+                             void *baton,
+                             apr_pool_t *result_pool)
+{
+  persistent_cache_t *cache = cache_void;
+  const entry_t *entry;
+  const char *full_key;
+  apr_size_t full_key_len;
+  apr_pool_t *scratch_pool;
+
+  SVN_ERR(svn_cache__get_partial(value_p, found, cache->l1, key, func, baton,
+                                 result_pool));
+  if (*found)
+    return SVN_NO_ERROR;
+
+  scratch_pool = svn_pool_create(result_pool);
+  build_key(&full_key, &full_key_len, cache, key, scratch_pool);
+  entry = lookup(cache->store, full_key, full_key_len);
+
+  /* The stored data has the same format as in the first level, so the
+     partial getter can operate on it directly. */
+  if (entry)
+    {
+      SVN_ERR(func(value_p, copy_entry(entry, scratch_pool), entry->size,
+                   baton, result_pool));
+      *found = TRUE;
+    }
+
+  svn_pool_destroy(scratch_pool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+persistent_cache_set_partial(void *cache_void,
+                             const void *key,
+                             svn_cache__partial_setter_func_t func,
+                             void *baton,
+                             apr_pool_t *scratch_pool)
+{
+  persistent_cache_t *cache = cache_void;
+
+  /* The persistent entries can't be modified.  Only use this for caches
+     where this merely updates derived information. */
+  return svn_error_trace(svn_cache__set_partial(cache->l1, key, func, baton,
+                                                scratch_pool));
+}
+
+static svn_error_t *
+persistent_cache_get_info(void *cache_void,
+                          svn_cache__info_t *info,
+                          svn_boolean_t reset,
+                          apr_pool_t *result_pool)
+{
+  persistent_cache_t *cache = cache_void;
+
+  SVN_ERR(svn_cache__get_info(cache->l1, info, reset, result_pool));
+  info->id = apr_pstrcat(result_pool, info->id, " + ", cache->store->path,
+                         SVN_VA_NULL);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_cache__vtable_t persistent_cache_vtable = {
+  persistent_cache_get,
+  persistent_cache_has_key,
+  persistent_cache_set,
+  persistent_cache_iter,
+  persistent_cache_is_cachable,
+  persistent_cache_get_partial,
+  persistent_cache_set_partial,
+  persistent_cache_get_info,
+  NULL                                    /* no batched reads */
+};
+
+svn_error_t *
+svn_cache__create_persistent(svn_cache__t **cache_p,
+                             svn_cache__t *l1_cache,
+                             svn_cache__persistent_t *store,
+                             svn_cache__serialize_func_t serialize_func,
+                             svn_cache__deserialize_func_t deserialize_func,
+                             apr_ssize_t klen,
+                             const char *prefix,
+                             apr_pool_t *result_pool)
+{
+  svn_cache__t *wrapper = apr_pcalloc(result_pool, sizeof(*wrapper));
+  persistent_cache_t *cache = apr_pcalloc(result_pool, sizeof(*cache));
+
+  SVN_ERR_ASSERT(l1_cache && store && serialize_func && deserialize_func);
+
+  cache->l1 = l1_cache;
+  cache->store = store;
+  cache->prefix = apr_pstrdup(result_pool, prefix);
+  cache->prefix_len = strlen(prefix);
+  cache->klen = klen;
+  cache->serialize_func = serialize_func;
+  cache->deserialize_func = deserialize_func;
+
+  wrapper->vtable = &persistent_cache_vtable;
+  wrapper->cache_internal = cache;
+  wrapper->error_handler = 0;
+  wrapper->error_baton = 0;
+  wrapper->pretend_empty = !!getenv("SVN_X_DOES_NOT_MARK_THE_SPOT");
+
+  *cache_p = wrapper;
+  return SVN_NO_ERROR;
+}
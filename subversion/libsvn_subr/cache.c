@@ -95,6 +95,54 @@ svn_cache__get(void **value_p,
   return err;
 }
 
+svn_error_t *
+svn_cache__get_many(apr_array_header_t **values,
+                    svn_cache__t *cache,
+                    const apr_array_header_t *keys,
+                    apr_pool_t *result_pool)
+{
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  /* Start with "nothing found", so that quelched errors leave us with
+     a consistent result. */
+  *values = apr_array_make(result_pool, keys->nelts, sizeof(void *));
+  for (i = 0; i < keys->nelts; ++i)
+    APR_ARRAY_PUSH(*values, void *) = NULL;
+
+#ifdef SVN_DEBUG
+  if (cache->pretend_empty)
+    return SVN_NO_ERROR;
+#endif
+
+  cache->reads += keys->nelts;
+  if (cache->vtable->get_many)
+    {
+      err = (cache->vtable->get_many)(*values, cache->cache_internal, keys,
+                                      result_pool);
+    }
+  else
+    {
+      for (i = 0; i < keys->nelts && !err; ++i)
+        {
+          svn_boolean_t found;
+          void *value;
+
+          err = (cache->vtable->get)(&value, &found, cache->cache_internal,
+                                     APR_ARRAY_IDX(keys, i, const void *),
+                                     result_pool);
+          if (!err && found)
+            APR_ARRAY_IDX(*values, i, void *) = value;
+        }
+    }
+
+  for (i = 0; i < keys->nelts; ++i)
+    if (APR_ARRAY_IDX(*values, i, void *))
+      cache->hits++;
+
+  return handle_error(cache, err, result_pool);
+}
+
 svn_error_t *
 svn_cache__has_key(svn_boolean_t *found,
                    svn_cache__t *cache,
@@ -240,6 +288,15 @@ svn_cache__get_info(svn_cache__t *cache,
   return SVN_NO_ERROR;
 }
 
+void
+svn_cache__add_access_counts(apr_uint64_t *gets,
+                             apr_uint64_t *hits,
+                             const svn_cache__t *cache)
+{
+  *gets += cache->reads;
+  *hits += cache->hits;
+}
+
 svn_string_t *
 svn_cache__format_info(const svn_cache__info_t *info,
                        svn_boolean_t access_only,
@@ -296,6 +353,7 @@ svn_cache__format_info(const svn_cache__info_t *info,
                             "sets    : %" APR_UINT64_T_FMT
                             " (%5.2f%% of misses)\n"
                             "failures: %" APR_UINT64_T_FMT "\n"
+                            "evicted : %" APR_UINT64_T_FMT "\n"
                             "used    : %" APR_UINT64_T_FMT " MB (%5.2f%%)"
                             " of %" APR_UINT64_T_FMT " MB data cache"
                             " / %" APR_UINT64_T_FMT " MB total cache memory\n"
@@ -308,6 +366,7 @@ svn_cache__format_info(const svn_cache__info_t *info,
                             info->hits, hit_rate,
                             info->sets, write_rate,
                             info->failures,
+                            info->evictions,
 
                             info->used_size / _1MB, data_usage_rate,
                             info->data_size / _1MB,
@@ -82,6 +82,14 @@ typedef struct svn_cache__vtable_t {
                            svn_cache__info_t *info,
                            svn_boolean_t reset,
                            apr_pool_t *result_pool);
+
+  /* See svn_cache__get_many().  VALUES has been pre-filled with one
+     NULL element per key.  May be NULL, in which case the keys will be
+     looked up one by one using GET. */
+  svn_error_t *(*get_many)(apr_array_header_t *values,
+                           void *cache_implementation,
+                           const apr_array_header_t *keys,
+                           apr_pool_t *result_pool);
 } svn_cache__vtable_t;
 
 struct svn_cache__t {
@@ -665,6 +665,85 @@ svn_checksum_final(svn_checksum_t **checksum,
   return SVN_NO_ERROR;
 }
 
+
+/* Number of bytes that svn_checksum__multi_update() feeds into each of
+ * its contexts before moving on to the next one.  The data should still
+ * be in the L1 cache when the last context gets to process it. */
+#define MULTI_CTX_SLICE_SIZE 0x2000
+
+struct svn_checksum__multi_ctx_t
+{
+  /* The contexts for the individual checksum kinds. */
+  svn_checksum_ctx_t **contexts;
+
+  /* Number of elements in CONTEXTS. */
+  int count;
+};
+
+svn_checksum__multi_ctx_t *
+svn_checksum__multi_ctx_create(const svn_checksum_kind_t *kinds,
+                               int count,
+                               apr_pool_t *pool)
+{
+  svn_checksum__multi_ctx_t *ctx = apr_palloc(pool, sizeof(*ctx));
+  int i;
+
+  ctx->contexts = apr_palloc(pool, count * sizeof(*ctx->contexts));
+  ctx->count = count;
+  for (i = 0; i < count; ++i)
+    ctx->contexts[i] = svn_checksum_ctx_create(kinds[i], pool);
+
+  return ctx;
+}
+
+svn_error_t *
+svn_checksum__multi_ctx_reset(svn_checksum__multi_ctx_t *ctx)
+{
+  int i;
+
+  for (i = 0; i < ctx->count; ++i)
+    SVN_ERR(svn_checksum_ctx_reset(ctx->contexts[i]));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_checksum__multi_update(svn_checksum__multi_ctx_t *ctx,
+                           const void *data,
+                           apr_size_t len)
+{
+  const char *p = data;
+
+  /* Process large buffers in cache-friendly slices instead of making
+     every context run over all of the data. */
+  while (len > 0)
+    {
+      apr_size_t slice = MIN(len, MULTI_CTX_SLICE_SIZE);
+      int i;
+
+      for (i = 0; i < ctx->count; ++i)
+        SVN_ERR(svn_checksum_update(ctx->contexts[i], p, slice));
+
+      p += slice;
+      len -= slice;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_checksum__multi_final(svn_checksum_t **checksums,
+                          const svn_checksum__multi_ctx_t *ctx,
+                          apr_pool_t *pool)
+{
+  int i;
+
+  for (i = 0; i < ctx->count; ++i)
+    SVN_ERR(svn_checksum_final(&checksums[i], ctx->contexts[i], pool));
+
+  return SVN_NO_ERROR;
+}
+
 apr_size_t
 svn_checksum_size(const svn_checksum_t *checksum)
 {
@@ -69,6 +69,7 @@
 #include "svn_props.h"
 #include "svn_subst.h"
 
+#include "private/svn_auth_private.h"
 #include "private/svn_cmdline_private.h"
 #include "private/svn_utf_private.h"
 #include "private/svn_sorts_private.h"
@@ -606,6 +607,7 @@ svn_cmdline_create_auth_baton2(svn_auth_baton_t **ab,
 {
   svn_boolean_t store_password_val = TRUE;
   svn_boolean_t store_auth_creds_val = TRUE;
+  apr_int64_t creds_cache_ttl;
   svn_auth_provider_object_t *provider;
   svn_cmdline_prompt_baton2_t *pb = NULL;
 
@@ -766,6 +768,14 @@ svn_cmdline_create_auth_baton2(svn_auth_baton_t **ab,
   if (no_auth_cache || ! store_auth_creds_val)
     svn_auth_set_parameter(*ab, SVN_AUTH_PARAM_NO_AUTH_CACHE, "");
 
+  /* Long-running processes may want to notice changes to the stored
+     credentials. */
+  SVN_ERR(svn_config_get_int64(cfg, &creds_cache_ttl,
+                               SVN_CONFIG_SECTION_AUTH,
+                               SVN_CONFIG_OPTION_CREDENTIALS_CACHE_TTL, 0));
+  svn_auth__set_credentials_cache_ttl(*ab,
+                                      apr_time_from_sec(creds_cache_ttl));
+
 #ifdef SVN_HAVE_GNOME_KEYRING
   svn_auth_set_parameter(*ab, SVN_AUTH_PARAM_GNOME_KEYRING_UNLOCK_PROMPT_FUNC,
                          &svn_cmdline__auth_gnome_keyring_unlock_prompt);
@@ -33,11 +33,14 @@
 #include <apr_lib.h>
 #include "svn_hash.h"
 #include "svn_error.h"
+#include "svn_io.h"
 #include "svn_string.h"
 #include "svn_pools.h"
 #include "config_impl.h"
 
+#include "private/svn_atomic.h"
 #include "private/svn_dep_compat.h"
+#include "private/svn_mutex.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_config_private.h"
 
@@ -125,6 +128,147 @@ svn_config_create2(svn_config_t **cfgp,
   return SVN_NO_ERROR;
 }
 
+/* Parsed config files, so that reading the same unchanged file again
+   becomes a simple copy.  This helps servers that re-read fsfs.conf,
+   svnserve.conf etc. whenever they open a repository. */
+typedef struct parsed_config_t
+{
+  /* Pool that CFG is allocated in. */
+  apr_pool_t *pool;
+
+  /* The parsed contents.  Never expanded nor handed out directly. */
+  svn_config_t *cfg;
+
+  /* File timestamp and size at the time it got parsed. */
+  apr_time_t mtime;
+  apr_off_t size;
+} parsed_config_t;
+
+/* A mutex to protect our global pool and cache. */
+static svn_mutex__t *parsed_configs_mutex = NULL;
+
+/* Global pool for the parsed config cache. */
+static apr_pool_t *parsed_configs_pool;
+
+/* Maps config file paths to parsed_config_t. */
+static apr_hash_t *parsed_configs;
+
+static volatile svn_atomic_t parsed_configs_init_status = 0;
+
+/* Implements svn_atomic__err_init_func_t. */
+static svn_error_t *
+init_parsed_configs(void *baton,
+                    apr_pool_t *pool)
+{
+  parsed_configs_pool = svn_pool_create(NULL);
+  SVN_ERR(svn_mutex__init(&parsed_configs_mutex, TRUE,
+                          parsed_configs_pool));
+  parsed_configs = apr_hash_make(parsed_configs_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *CFGP to a copy of the parsed contents of FILE, allocated in
+   RESULT_POOL, if we have them for the version described by FINFO and
+   the same case sensitivity settings.  Set it to NULL otherwise.
+   Call this only while holding PARSED_CONFIGS_MUTEX. */
+static svn_error_t *
+get_parsed_config(svn_config_t **cfgp,
+                  const char *file,
+                  const apr_finfo_t *finfo,
+                  svn_boolean_t section_names_case_sensitive,
+                  svn_boolean_t option_names_case_sensitive,
+                  apr_pool_t *result_pool)
+{
+  parsed_config_t *entry = svn_hash_gets(parsed_configs, file);
+
+  *cfgp = NULL;
+  if (   entry
+      && entry->mtime == finfo->mtime
+      && entry->size == finfo->size
+      && entry->cfg->section_names_case_sensitive
+           == section_names_case_sensitive
+      && entry->cfg->option_names_case_sensitive
+           == option_names_case_sensitive)
+    SVN_ERR(svn_config_dup(cfgp, entry->cfg, result_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Store a copy of CFG as the parsed contents of FILE in the version
+   described by FINFO, replacing any older entry.  Call this only while
+   holding PARSED_CONFIGS_MUTEX. */
+static svn_error_t *
+set_parsed_config(const char *file,
+                  const apr_finfo_t *finfo,
+                  svn_config_t *cfg)
+{
+  parsed_config_t *entry = svn_hash_gets(parsed_configs, file);
+  apr_pool_t *pool;
+
+  if (entry)
+    {
+      svn_hash_sets(parsed_configs, file, NULL);
+      svn_pool_destroy(entry->pool);
+    }
+
+  pool = svn_pool_create(parsed_configs_pool);
+  entry = apr_palloc(pool, sizeof(*entry));
+  entry->pool = pool;
+  entry->mtime = finfo->mtime;
+  entry->size = finfo->size;
+  SVN_ERR(svn_config_dup(&entry->cfg, cfg, pool));
+  svn_hash_sets(parsed_configs, apr_pstrdup(pool, file), entry);
+
+  return SVN_NO_ERROR;
+}
+
+/* Like svn_config__parse_file but for the freshly created, empty CFG
+   only.  Re-use the result of earlier calls for the same FILE if it has
+   not changed since, as indicated by its timestamp and size. */
+static svn_error_t *
+parse_file_cached(svn_config_t **cfgp,
+                  svn_config_t *cfg,
+                  const char *file,
+                  svn_boolean_t must_exist,
+                  apr_pool_t *result_pool)
+{
+  apr_finfo_t finfo;
+  svn_config_t *parsed;
+  svn_error_t *err;
+
+  /* Missing files and such are handled by the parser. */
+  err = svn_io_stat(&finfo, file, APR_FINFO_MTIME | APR_FINFO_SIZE,
+                    result_pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      SVN_ERR(svn_config__parse_file(cfg, file, must_exist, result_pool));
+      *cfgp = cfg;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_atomic__init_once(&parsed_configs_init_status,
+                                init_parsed_configs, NULL, result_pool));
+  SVN_MUTEX__WITH_LOCK(parsed_configs_mutex,
+                       get_parsed_config(&parsed, file, &finfo,
+                                         cfg->section_names_case_sensitive,
+                                         cfg->option_names_case_sensitive,
+                                         result_pool));
+  if (parsed)
+    {
+      *cfgp = parsed;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_config__parse_file(cfg, file, must_exist, result_pool));
+  SVN_MUTEX__WITH_LOCK(parsed_configs_mutex,
+                       set_parsed_config(file, &finfo, cfg));
+
+  *cfgp = cfg;
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_config_read3(svn_config_t **cfgp, const char *file,
                  svn_boolean_t must_exist,
@@ -151,7 +295,7 @@ svn_config_read3(svn_config_t **cfgp, const char *file,
                                      must_exist, result_pool);
   else
 #endif /* WIN32 */
-    err = svn_config__parse_file(cfg, file, must_exist, result_pool);
+    err = parse_file_cached(&cfg, cfg, file, must_exist, result_pool);
 
   if (err != SVN_NO_ERROR)
     return err;
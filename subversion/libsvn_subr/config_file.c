@@ -1159,6 +1159,7 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "###   ssl-authority-files        List of files, each of a trusted CA"
                                                                              NL
         "###   ssl-trust-default-ca       Trust the system 'default' CAs"    NL
+        "###                              (both also apply to svns://)."     NL
         "###   ssl-client-cert-file       PKCS#12 format client certificate file"
                                                                              NL
         "###   ssl-client-cert-password   Client Key password, if needed."   NL
@@ -1396,6 +1397,13 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### 'servers' configuration file). Defaults to 'no'."               NL
         "# ssl-client-cert-file-prompt = no"                                 NL
         "###"                                                                NL
+        "### Credentials are kept in memory once obtained, so that further"  NL
+        "### connections within the same process don't have to read them"    NL
+        "### again.  Set credentials-cache-ttl to the number of seconds"     NL
+        "### after which they shall be read again.  Defaults to 0, i.e."     NL
+        "### they are kept until the process ends."                          NL
+        "# credentials-cache-ttl = 0"                                        NL
+        "###"                                                                NL
         "### The rest of the [auth] section in this file has been deprecated."
                                                                              NL
         "### Both 'store-passwords' and 'store-auth-creds' can now be"       NL
@@ -1512,6 +1520,23 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### to show meaningful differences for binary file formats.  [New"  NL
         "### in 1.9]"                                                        NL
         "# diff-ignore-content-type = no"                                    NL
+        "### Set enable-delta-source-tracking to 'yes' to make 'svn commit'" NL
+        "### look for matching data in the whole vicinity of the pristine"   NL
+        "### text when sending a file's changes to the server.  This can"    NL
+        "### reduce the amount of data sent for large files with inserted"   NL
+        "### or removed content considerably but needs about 10 MB of"       NL
+        "### additional memory.  [New in 1.15]"                              NL
+        "# enable-delta-source-tracking = no"                                NL
+        "### Set ra-cache-size to keep file contents and directory"          NL
+        "### listings of remote repositories on disk, so that commands like" NL
+        "### 'svn cat' and 'svn ls' do not fetch the same revision of a"     NL
+        "### path twice."                                                    NL
+        "### The value is the size of the cache in MB.  The least recently"  NL
+        "### used data is removed when the cache gets full.  0 disables the" NL
+        "### cache.  ra-cache-dir defaults to the 'ra-cache' directory in"   NL
+        "### the user's configuration area.  [New in 1.15]"                  NL
+        "# ra-cache-size = 0"                                                NL
+        "# ra-cache-dir ="                                                   NL
         ""                                                                   NL
         "### Section for configuring automatic properties."                  NL
         "[auto-props]"                                                       NL
@@ -1557,6 +1582,48 @@ svn_config_ensure(const char *config_dir, apr_pool_t *pool)
         "### and upgraded working copies will by default be compatible with" NL
         "### the specified Subversion version."                              NL
         "# compatible-version = 1.8"                                         NL
+        "### Set to true to let SQLite use a write-ahead log instead of a"   NL
+        "### rollback journal for working copies.  This makes checkouts and" NL
+        "### updates faster, especially where creating and truncating files" NL
+        "### is expensive, e.g. on network shares or with virus scanners."   NL
+        "### Unless exclusive locking is enabled as well, only enable this"  NL
+        "### for working copies on local disks, and do so for all clients"   NL
+        "### that access them."                                              NL
+        "# write-ahead-logging = false"                                      NL
+        "### Set how many megabytes of the working copy database SQLite"     NL
+        "### keeps in memory and how many megabytes of it are accessed"      NL
+        "### through a memory map instead of file reads.  Very large"        NL
+        "### working copies run faster when all of their database fits."    NL
+        "### By default, the SQLite defaults of a few megabytes are used."   NL
+        "# sqlite-cache-size = 0"                                            NL
+        "# sqlite-mmap-size = 0"                                             NL
+        "### Set to the path of a program that reports which files in a"     NL
+        "### working copy have changed since its previous invocation, e.g."  NL
+        "### based on a filesystem watcher.  'svn status' will then only"    NL
+        "### scan the directories of a working copy that have changed."      NL
+        "### See subversion/libsvn_wc/fsmonitor.h for the protocol."         NL
+        "# fsmonitor-hook ="                                                 NL
+        "### For working copies that do not store all pristine contents,"    NL
+        "### set the size in megabytes of the pristine contents to keep"     NL
+        "### after the files that needed them got committed or reverted."    NL
+        "### The least recently used contents are removed first.  The"       NL
+        "### default is 0, i.e. such contents are removed right away."       NL
+        "# textbase-cache-size = 0"                                          NL
+        "### Set to a directory that several working copies on the same"     NL
+        "### machine share for their pristine contents, e.g. the checkouts"  NL
+        "### of a build agent.  Identical contents are then stored only"     NL
+        "### once and hard linked into the working copies.  The directory"   NL
+        "### must be on the same filesystem as the working copies.  It is"   NL
+        "### cleaned up whenever 'svn cleanup' runs on one of them."         NL
+        "# shared-pristine-store ="                                          NL
+        "### Set the number of externals that checkouts and updates bring"   NL
+        "### up to date concurrently, each with its own connection to the"   NL
+        "### repository.  Set to 1 to process them one after another."       NL
+        "# externals-parallelism = 4"                                        NL
+        "### Set reclaim-pristines to 'yes' to remove pristine copies that"  NL
+        "### are no longer needed after every commit and update, instead"    NL
+        "### of waiting for 'svn cleanup --vacuum-pristines'."               NL
+        "# reclaim-pristines = no"                                           NL
         ;
 
       err = svn_io_file_open(&f, path,
@@ -317,6 +317,24 @@ canonicalize(const char **canonical_path,
         return SVN_NO_ERROR;
     }
 
+  /* Most callers pass canonical paths.  Detecting them is much cheaper
+     than rebuilding them segment by segment.  Dirents with DOS-specific
+     syntax and URIs need the full treatment, though. */
+  if (type == type_relpath
+#ifndef SVN_USE_DOS_PATHS
+      || type == type_dirent
+#endif
+     )
+    {
+      if (relpath_is_canonical(*path == '/' && type == type_dirent
+                                 ? path + 1
+                                 : path))
+        {
+          *canonical_path = apr_pstrdup(pool, path);
+          return SVN_NO_ERROR;
+        }
+    }
+
   dst = canon = apr_pcalloc(pool, strlen(path) + 1);
 
   /* If this is supposed to be an URI, it should start with
@@ -413,6 +431,13 @@ canonicalize(const char **canonical_path,
                 {
                   src += 5;
                 }
+              else if (src[1] == '3' && src[2] == '6'
+                       && src[3] == '9' && src[4] == '1'
+                       && (src[5]== '/'|| !src[5])
+                       && !strncmp(canon, "svns:", 5))
+                {
+                  src += 5;
+                }
               else if (src[1] == '/' || !src[1])
                 {
                   src += 1;
@@ -1855,9 +1880,8 @@ svn_dirent_is_canonical(const char *dirent, apr_pool_t *scratch_pool)
 static svn_boolean_t
 relpath_is_canonical(const char *relpath)
 {
-  const char *dot_pos, *ptr = relpath;
-  apr_size_t i, len;
-  unsigned pattern = 0;
+  const char *slash, *end, *ptr = relpath;
+  apr_size_t len;
 
   /* RELPATH is canonical if it has:
    *  - no '.' segments
@@ -1881,24 +1905,18 @@ relpath_is_canonical(const char *relpath)
   if (ptr[len-1] == '/' || (ptr[len-1] == '.' && ptr[len-2] == '/'))
     return FALSE;
 
-  /* '.' are rare. So, search for them globally. There will often be no
-   * more than one hit.  Also note that we already checked for invalid
-   * starts and endings, i.e. we only need to check for "/./"
+  /* Now check what follows each inner '/'.  We already checked for
+   * invalid starts and endings, i.e. we only need to check for "//" and
+   * "/./".  Let memchr() skip the segment contents; it is vectorized in
+   * most C libraries, which makes this fast for long paths.
    */
-  for (dot_pos = memchr(ptr, '.', len);
-       dot_pos;
-       dot_pos = strchr(dot_pos+1, '.'))
-    if (dot_pos > ptr && dot_pos[-1] == '/' && dot_pos[1] == '/')
+  end = ptr + len;
+  for (slash = memchr(ptr, '/', len);
+       slash;
+       slash = memchr(slash + 1, '/', end - slash - 1))
+    if (slash[1] == '/' || (slash[1] == '.' && slash[2] == '/'))
       return FALSE;
 
-  /* Now validate the rest of the path. */
-  for (i = 0; i < len - 1; ++i)
-    {
-      pattern = ((pattern & 0xff) << 8) + (unsigned char)ptr[i];
-      if (pattern == 0x101 * (unsigned char)('/'))
-        return FALSE;
-    }
-
   return TRUE;
 }
 
@@ -2008,6 +2026,8 @@ svn_uri_is_canonical(const char *uri, apr_pool_t *scratch_pool)
         return FALSE;
       else if (port == 3690 && strncmp(uri, "svn:", 4) == 0)
         return FALSE;
+      else if (port == 3691 && strncmp(uri, "svns:", 5) == 0)
+        return FALSE;
 
       while (*ptr && *ptr != '/')
         ++ptr; /* Allow "http://host:stuff" */
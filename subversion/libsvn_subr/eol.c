@@ -30,10 +30,32 @@
 #include "private/svn_eol_private.h"
 #include "private/svn_dep_compat.h"
 
+/* Use SSE2 to scan for EOLs 16 bytes at a time.  SSE2 is part of the
+ * x86-64 base ISA, so there is no need for a runtime check. */
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define SVN_EOL__USE_SSE2 1
+#endif
+
 char *
 svn_eol__find_eol_start(char *buf, apr_size_t len)
 {
-#if SVN_UNALIGNED_ACCESS_IS_OK
+#ifdef SVN_EOL__USE_SSE2
+
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+
+  for (; len >= sizeof(__m128i); buf += sizeof(__m128i),
+                                 len -= sizeof(__m128i))
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *)buf);
+      int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, cr),
+                                                _mm_cmpeq_epi8(chunk, lf)));
+      if (mask)
+        return buf + __builtin_ctz(mask);
+    }
+
+#elif SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Scan the input one machine word at a time. */
   for (; len > sizeof(apr_uintptr_t)
@@ -250,6 +250,290 @@ hash_read(apr_hash_t *hash, svn_stream_t *stream, const char *terminator,
   return SVN_NO_ERROR;
 }
 
+/* Parse the length in the "<X> <length>" header LINE of LINELEN bytes,
+ * which must be NUL-terminated, into *LEN.  Use ERRMSG for parser errors.
+ */
+static svn_error_t *
+parse_length(apr_size_t *len,
+             const char *line,
+             apr_size_t linelen,
+             const char *errmsg)
+{
+  svn_error_t *err;
+  apr_uint64_t ui64;
+
+  if (linelen < 3 || line[1] != ' ')
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                            _("Serialized hash malformed"));
+
+  err = svn_cstring_strtoui64(&ui64, line + 2, 0, APR_SIZE_MAX, 10);
+  if (err)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, err, errmsg);
+
+  *len = (apr_size_t)ui64;
+  return SVN_NO_ERROR;
+}
+
+/* Return the LEN bytes at **P and advance *P behind them and the new line
+ * following them, which gets replaced by NUL.  END is the end of the data.
+ * Use ERRMSG if the data is too short or not followed by a new line.
+ */
+static svn_error_t *
+parse_data(char **data,
+           char **p,
+           char *end,
+           apr_size_t len,
+           const char *errmsg)
+{
+  if ((apr_size_t)(end - *p) <= len || (*p)[len] != '\n')
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL, errmsg);
+
+  *data = *p;
+  (*p)[len] = '\0';
+  *p += len + 1;
+
+  return SVN_NO_ERROR;
+}
+
+/* The in-memory equivalent of svn_hash__read_entry() for the data between
+ * *P and END.  Point the members of *ENTRY into that data, advance *P
+ * behind the entry and NUL-terminate the lines, keys and values in place.
+ */
+static svn_error_t *
+parse_entry(svn_hash__entry_t *entry,
+            char **p,
+            char *end,
+            const char *terminator,
+            svn_boolean_t incremental)
+{
+  char *line = *p;
+  char *eol = memchr(line, '\n', end - line);
+  apr_size_t linelen = eol ? (apr_size_t)(eol - line)
+                           : (apr_size_t)(end - line);
+
+  /* Check for the end of the hash. */
+  if ((!terminator && !eol && linelen == 0)
+      || (terminator && strlen(terminator) == linelen
+          && memcmp(line, terminator, linelen) == 0))
+    {
+      entry->key = NULL;
+      entry->keylen = 0;
+      entry->val = NULL;
+      entry->vallen = 0;
+
+      *p = eol ? eol + 1 : end;
+      return SVN_NO_ERROR;
+    }
+
+  /* Check for unexpected end of data */
+  if (!eol)
+    return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                            _("Serialized hash missing terminator"));
+
+  *eol = '\0';
+  *p = eol + 1;
+
+  if (line[0] == 'K')
+    {
+      SVN_ERR(parse_length(&entry->keylen, line, linelen,
+                           _("Serialized hash malformed key length")));
+      SVN_ERR(parse_data(&entry->key, p, end, entry->keylen,
+                         _("Serialized hash malformed key data")));
+
+      /* Read a val length line */
+      line = *p;
+      eol = memchr(line, '\n', end - line);
+      if (!eol || line[0] != 'V')
+        return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                                _("Serialized hash malformed"));
+
+      *eol = '\0';
+      *p = eol + 1;
+
+      SVN_ERR(parse_length(&entry->vallen, line, (apr_size_t)(eol - line),
+                           _("Serialized hash malformed value length")));
+      SVN_ERR(parse_data(&entry->val, p, end, entry->vallen,
+                         _("Serialized hash malformed value data")));
+    }
+  else if (incremental && line[0] == 'D')
+    {
+      SVN_ERR(parse_length(&entry->keylen, line, linelen,
+                           _("Serialized hash malformed key length")));
+      SVN_ERR(parse_data(&entry->key, p, end, entry->keylen,
+                         _("Serialized hash malformed key data")));
+
+      /* Remove this hash entry. */
+      entry->vallen = 0;
+      entry->val = NULL;
+    }
+  else
+    {
+      return svn_error_create(SVN_ERR_MALFORMED_FILE, NULL,
+                              _("Serialized hash malformed"));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_hash__parse_entries(apr_array_header_t **entries,
+                        char *data,
+                        apr_size_t len,
+                        const char *terminator,
+                        svn_boolean_t incremental,
+                        apr_pool_t *result_pool)
+{
+  apr_array_header_t *result;
+  char *end = data + len;
+
+  /* Typical entries, e.g. properties or directory entries, are a few
+     dozen bytes long. */
+  result = apr_array_make(result_pool, (int)(len / 32) + 1,
+                          sizeof(svn_hash__entry_t));
+
+  while (1)
+    {
+      svn_hash__entry_t entry;
+
+      SVN_ERR(parse_entry(&entry, &data, end, terminator, incremental));
+      if (entry.key == NULL)
+        break;
+
+      APR_ARRAY_PUSH(result, svn_hash__entry_t) = entry;
+    }
+
+  *entries = result;
+  return SVN_NO_ERROR;
+}
+
+/* Return an array of svn_string_t views on the values in ENTRIES, which
+ * must all have a value.  Allocate it in RESULT_POOL.
+ */
+static svn_string_t *
+make_value_views(const apr_array_header_t *entries,
+                 apr_pool_t *result_pool)
+{
+  svn_string_t *values = apr_palloc(result_pool,
+                                    entries->nelts * sizeof(*values));
+  int i;
+
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      const svn_hash__entry_t *entry
+        = &APR_ARRAY_IDX(entries, i, svn_hash__entry_t);
+
+      values[i].data = entry->val;
+      values[i].len = entry->vallen;
+    }
+
+  return values;
+}
+
+svn_error_t *
+svn_hash__parse(apr_hash_t *hash,
+                char *data,
+                apr_size_t len,
+                const char *terminator,
+                apr_pool_t *pool)
+{
+  apr_array_header_t *entries;
+  svn_string_t *values;
+  int i;
+
+  SVN_ERR(svn_hash__parse_entries(&entries, data, len, terminator, FALSE,
+                                  pool));
+  values = make_value_views(entries, pool);
+
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      const svn_hash__entry_t *entry
+        = &APR_ARRAY_IDX(entries, i, svn_hash__entry_t);
+
+      apr_hash_set(hash, entry->key, entry->keylen, &values[i]);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Compare the svn_sort__item_t A and B like
+ * svn_sort_compare_items_lexically() but order items with equal keys by
+ * the position of their svn_string_t values in the parsed data.
+ */
+static int
+compare_parsed_items(const void *a,
+                     const void *b)
+{
+  const svn_sort__item_t *lhs = a;
+  const svn_sort__item_t *rhs = b;
+  const svn_string_t *lhs_value = lhs->value;
+  const svn_string_t *rhs_value = rhs->value;
+  int diff = svn_sort_compare_items_lexically(lhs, rhs);
+
+  if (diff)
+    return diff;
+
+  return lhs_value->data < rhs_value->data ? -1
+       : lhs_value->data > rhs_value->data ? 1 : 0;
+}
+
+svn_error_t *
+svn_hash__parse_sorted(apr_array_header_t **items,
+                       char *data,
+                       apr_size_t len,
+                       const char *terminator,
+                       apr_pool_t *result_pool)
+{
+  apr_array_header_t *entries;
+  apr_array_header_t *result;
+  svn_string_t *values;
+  svn_boolean_t is_sorted = TRUE;
+  int i, k;
+
+  SVN_ERR(svn_hash__parse_entries(&entries, data, len, terminator, FALSE,
+                                  result_pool));
+  values = make_value_views(entries, result_pool);
+
+  result = apr_array_make(result_pool, entries->nelts,
+                          sizeof(svn_sort__item_t));
+  for (i = 0; i < entries->nelts; ++i)
+    {
+      const svn_hash__entry_t *entry
+        = &APR_ARRAY_IDX(entries, i, svn_hash__entry_t);
+      svn_sort__item_t *item = apr_array_push(result);
+
+      item->key = entry->key;
+      item->klen = entry->keylen;
+      item->value = &values[i];
+
+      if (i && is_sorted)
+        is_sorted = svn_sort_compare_items_lexically(item - 1, item) < 0;
+    }
+
+  /* svn_hash_write2() writes the keys in order, so we rarely need this. */
+  if (!is_sorted)
+    {
+      svn_sort__array(result, compare_parsed_items);
+
+      /* Keep only the last value of every key. */
+      for (i = 0, k = 0; i < result->nelts; ++i)
+        {
+          svn_sort__item_t *item = &APR_ARRAY_IDX(result, i,
+                                                  svn_sort__item_t);
+
+          if (i + 1 < result->nelts
+              && svn_sort_compare_items_lexically(item, item + 1) == 0)
+            continue;
+
+          APR_ARRAY_IDX(result, k++, svn_sort__item_t) = *item;
+        }
+
+      result->nelts = k;
+    }
+
+  *items = result;
+  return SVN_NO_ERROR;
+}
+
 
 /* Implements svn_hash_write2 and svn_hash_write_incremental. */
 static svn_error_t *
@@ -51,6 +51,24 @@
 #include <fcntl.h>
 #endif
 
+#ifdef HAVE_LINUX_FS_H
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
+#if defined(FICLONE) || defined(HAVE_COPY_FILE_RANGE)
+#include <errno.h>
+#define SVN_IO__COPY_IN_KERNEL 1
+#endif
+
+#if defined(HAVE_FSTATAT) && defined(HAVE_DIRFD) \
+    && defined(HAVE_STRUCT_STAT_ST_MTIM) && !defined(WIN32)
+#include <errno.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#define SVN_IO__GET_DIRENTS_AT 1
+#endif
+
 #include "svn_hash.h"
 #include "svn_types.h"
 #include "svn_dirent_uri.h"
@@ -66,6 +84,7 @@
 
 #include "private/svn_atomic.h"
 #include "private/svn_io_private.h"
+#include "private/svn_profile.h"
 #include "private/svn_utf_private.h"
 #include "private/svn_dep_compat.h"
 
@@ -880,6 +899,64 @@ svn_io_temp_dir(const char **dir,
 
 /*** Creating, copying and appending files. ***/
 
+#ifdef SVN_IO__COPY_IN_KERNEL
+/* Try to make the kernel copy the contents of FROM_FILE to the empty
+ * TO_FILE, ideally by sharing the data blocks between both files on
+ * copy-on-write file systems, and set *COPIED to TRUE if that worked.
+ * If the file system does not support any of this, set *COPIED to FALSE
+ * and leave both files untouched, so the caller can copy the contents
+ * itself.
+ */
+static apr_status_t
+copy_contents_in_kernel(svn_boolean_t *copied,
+                        apr_file_t *from_file,
+                        apr_file_t *to_file)
+{
+  apr_os_file_t from_fd, to_fd;
+
+  *copied = FALSE;
+  apr_os_file_get(&from_fd, from_file);
+  apr_os_file_get(&to_fd, to_file);
+
+#ifdef FICLONE
+  /* Btrfs, XFS and others can share the data blocks. */
+  if (ioctl(to_fd, FICLONE, from_fd) == 0)
+    {
+      *copied = TRUE;
+      return APR_SUCCESS;
+    }
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+  /* Still avoid the round-trip through user space. */
+  while (1)
+    {
+      ssize_t bytes_this_time = copy_file_range(from_fd, NULL, to_fd, NULL,
+                                                0x40000000, 0);
+      if (bytes_this_time == 0)
+        break;
+
+      if (bytes_this_time < 0)
+        {
+          if (errno == EINTR)
+            continue;
+
+          /* Not supported for these files?  Nothing has been copied yet,
+             so the caller may simply fall back to read and write. */
+          if (!*copied)
+            return APR_SUCCESS;
+
+          return apr_get_os_error();
+        }
+
+      *copied = TRUE;
+    }
+#endif
+
+  return APR_SUCCESS;
+}
+#endif
+
 /* Transfer the contents of FROM_FILE to TO_FILE, using POOL for temporary
  * allocations.
  *
@@ -894,6 +971,14 @@ copy_contents(apr_file_t *from_file,
               apr_file_t *to_file,
               apr_pool_t *pool)
 {
+#ifdef SVN_IO__COPY_IN_KERNEL
+  svn_boolean_t copied;
+  apr_status_t status = copy_contents_in_kernel(&copied, from_file, to_file);
+
+  if (status || copied)
+    return status;
+#endif
+
   /* Copy bytes till the cows come home. */
   while (1)
     {
@@ -2753,6 +2838,27 @@ svn_io_file_lock2(const char *lock_file,
   return svn_io_lock_open_file(lockfile_handle, exclusive, nonblocking, pool);
 }
 
+svn_error_t *
+svn_io__file_link(const char *from_path,
+                  const char *to_path,
+                  apr_pool_t *scratch_pool)
+{
+  apr_status_t status;
+  const char *from_path_apr, *to_path_apr;
+
+  SVN_ERR(cstring_from_utf8(&from_path_apr, from_path, scratch_pool));
+  SVN_ERR(cstring_from_utf8(&to_path_apr, to_path, scratch_pool));
+
+  status = apr_file_link(from_path_apr, to_path_apr);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't link '%s' to '%s'"),
+                              svn_dirent_local_style(to_path, scratch_pool),
+                              svn_dirent_local_style(from_path,
+                                                     scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_io__file_lock_autocreate(const char *lock_file,
                              apr_pool_t *pool)
@@ -2791,6 +2897,7 @@ svn_error_t *svn_io_file_flush_to_disk(apr_file_t *file,
 {
   const char *fname;
   apr_status_t apr_err;
+  apr_time_t start;
 
   /* We need this only in case of an error but this is cheap to get -
    * so we do it here for clarity. */
@@ -2798,9 +2905,11 @@ svn_error_t *svn_io_file_flush_to_disk(apr_file_t *file,
   if (apr_err)
     return svn_error_wrap_apr(apr_err, _("Can't get file name"));
 
+  start = svn_profile__start();
   do {
     apr_err = apr_file_datasync(file);
   } while(APR_STATUS_IS_EINTR(apr_err));
+  svn_profile__record("io", "fsync", start, 0);
 
   /* If the file is in a memory filesystem, fsync() may return
      EINVAL.  Presumably the user knows the risks, and we can just
@@ -3129,6 +3238,134 @@ svn_io_dirent2_dup(const svn_io_dirent2_t *item,
                      sizeof(*item));
 }
 
+#ifdef SVN_IO__GET_DIRENTS_AT
+/* Fill in the fields of DIRENT from the lstat() result INFO the same way
+ * as apr_stat() and map_apr_finfo_to_node_kind() would. */
+static void
+map_stat_to_dirent(svn_io_dirent2_t *dirent,
+                   const struct stat *info)
+{
+  dirent->special = FALSE;
+  if (S_ISREG(info->st_mode))
+    dirent->kind = svn_node_file;
+  else if (S_ISDIR(info->st_mode))
+    dirent->kind = svn_node_dir;
+  else if (S_ISLNK(info->st_mode))
+    {
+      dirent->special = TRUE;
+      dirent->kind = svn_node_file;
+    }
+  else
+    dirent->kind = svn_node_unknown;
+
+  dirent->filesize = info->st_size;
+  dirent->mtime = apr_time_from_sec(info->st_mtime)
+                + info->st_mtim.tv_nsec / APR_TIME_C(1000);
+}
+
+/* Implement svn_io_get_dirents3() with readdir() and fstatat().
+ *
+ * Unlike apr_dir_read(), stat the entries relative to the descriptor of
+ * the open directory.  That spares the kernel from walking the full path
+ * of PATH again for every entry.  Like apr_dir_read(), use the entry type
+ * reported by readdir() if ONLY_CHECK_TYPE is set.
+ */
+static svn_error_t *
+get_dirents_at(apr_hash_t *dirents,
+               const char *path,
+               svn_boolean_t only_check_type,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
+{
+  const char *path_apr;
+  svn_error_t *err = SVN_NO_ERROR;
+  DIR *dir;
+
+  SVN_ERR(cstring_from_utf8(&path_apr, path[0] ? path : ".", scratch_pool));
+
+  dir = opendir(path_apr);
+  if (!dir)
+    return svn_error_wrap_apr(apr_get_os_error(),
+                              _("Can't open directory '%s'"),
+                              svn_dirent_local_style(path[0] ? path : ".",
+                                                     scratch_pool));
+
+  while (!err)
+    {
+      struct dirent *entry;
+      struct stat info;
+      svn_io_dirent2_t *dirent;
+      const char *name;
+
+      errno = 0;
+      entry = readdir(dir);
+      if (!entry)
+        {
+          if (errno)
+            err = svn_error_wrap_apr(apr_get_os_error(),
+                                     _("Can't read directory '%s'"),
+                                     svn_dirent_local_style(path,
+                                                            scratch_pool));
+          break;
+        }
+
+      if ((entry->d_name[0] == '.')
+          && ((entry->d_name[1] == '\0')
+              || ((entry->d_name[1] == '.')
+                  && (entry->d_name[2] == '\0'))))
+        continue;
+
+      dirent = svn_io_dirent2_create(result_pool);
+
+#ifdef DT_UNKNOWN
+      if (only_check_type && entry->d_type != DT_UNKNOWN)
+        {
+          if (entry->d_type == DT_REG)
+            dirent->kind = svn_node_file;
+          else if (entry->d_type == DT_DIR)
+            dirent->kind = svn_node_dir;
+          else if (entry->d_type == DT_LNK)
+            {
+              dirent->special = TRUE;
+              dirent->kind = svn_node_file;
+            }
+          else
+            dirent->kind = svn_node_unknown;
+        }
+      else
+#endif
+      if (fstatat(dirfd(dir), entry->d_name, &info, AT_SYMLINK_NOFOLLOW))
+        {
+          err = svn_error_wrap_apr(apr_get_os_error(),
+                                   _("Can't read directory '%s'"),
+                                   svn_dirent_local_style(path,
+                                                          scratch_pool));
+          break;
+        }
+      else
+        {
+          map_stat_to_dirent(dirent, &info);
+          if (only_check_type)
+            {
+              dirent->filesize = SVN_INVALID_FILESIZE;
+              dirent->mtime = 0;
+            }
+        }
+
+      err = entry_name_to_utf8(&name, entry->d_name, path, result_pool);
+      if (!err)
+        svn_hash_sets(dirents, name, dirent);
+    }
+
+  if (closedir(dir) && !err)
+    err = svn_error_wrap_apr(apr_get_os_error(),
+                             _("Error closing directory '%s'"),
+                             svn_dirent_local_style(path, scratch_pool));
+
+  return svn_error_trace(err);
+}
+#endif
+
 svn_error_t *
 svn_io_get_dirents3(apr_hash_t **dirents,
                     const char *path,
@@ -3136,6 +3373,12 @@ svn_io_get_dirents3(apr_hash_t **dirents,
                     apr_pool_t *result_pool,
                     apr_pool_t *scratch_pool)
 {
+#ifdef SVN_IO__GET_DIRENTS_AT
+  *dirents = apr_hash_make(result_pool);
+
+  return svn_error_trace(get_dirents_at(*dirents, path, only_check_type,
+                                        result_pool, scratch_pool));
+#else
   apr_status_t status;
   apr_dir_t *this_dir;
   apr_finfo_t this_entry;
@@ -3190,6 +3433,7 @@ svn_io_get_dirents3(apr_hash_t **dirents,
                               svn_dirent_local_style(path, scratch_pool));
 
   return SVN_NO_ERROR;
+#endif
 }
 
 svn_error_t *
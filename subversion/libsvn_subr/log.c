@@ -114,6 +114,29 @@ svn_log__get_dir(const char *path, svn_revnum_t rev,
                       want_props ? " props" : "");
 }
 
+const char *
+svn_log__get_dirs(const apr_array_header_t *paths, svn_revnum_t rev,
+                  apr_pool_t *pool)
+{
+  int i;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_stringbuf_t *space_separated_paths = svn_stringbuf_create_empty(pool);
+
+  for (i = 0; i < paths->nelts; i++)
+    {
+      const char *path = APR_ARRAY_IDX(paths, i, const char *);
+      svn_pool_clear(iterpool);
+      if (i != 0)
+        svn_stringbuf_appendcstr(space_separated_paths, " ");
+      svn_stringbuf_appendcstr(space_separated_paths,
+                               svn_path_uri_encode(path, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return apr_psprintf(pool, "get-dirs (%s) r%ld",
+                      space_separated_paths->data, rev);
+}
+
 const char *
 svn_log__get_mergeinfo(const apr_array_header_t *paths,
                        svn_mergeinfo_inheritance_t inherit,
@@ -306,6 +329,14 @@ svn_log__get_file_revs(const char *path, svn_revnum_t start, svn_revnum_t end,
                       log_include_merged_revisions(include_merged_revisions));
 }
 
+const char *
+svn_log__blame(const char *path, svn_revnum_t start, svn_revnum_t end,
+               apr_pool_t *pool)
+{
+  return apr_psprintf(pool, "blame %s r%ld:%ld",
+                      svn_path_uri_encode(path, pool), start, end);
+}
+
 const char *
 svn_log__lock(apr_hash_t *targets,
               svn_boolean_t steal, apr_pool_t *pool)
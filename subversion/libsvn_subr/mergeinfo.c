@@ -22,6 +22,7 @@
  */
 #include <assert.h>
 #include <ctype.h>
+#include <string.h>
 
 #include "svn_path.h"
 #include "svn_types.h"
@@ -1468,6 +1469,269 @@ svn_rangelist_remove(svn_rangelist_t **output,
                                        consider_inheritance, pool);
 }
 
+/* Make room for at least NALLOC ranges in PACKED, keeping its ranges. */
+static void
+packed_reserve(svn_rangelist__packed_t *packed,
+               int nalloc)
+{
+  svn_revnum_t *starts;
+  svn_revnum_t *ends;
+  svn_boolean_t *inheritable;
+
+  if (nalloc <= packed->nalloc)
+    return;
+
+  nalloc = MAX(nalloc, 2 * packed->nalloc);
+  starts = apr_palloc(packed->pool, nalloc * sizeof(*starts));
+  ends = apr_palloc(packed->pool, nalloc * sizeof(*ends));
+  inheritable = apr_palloc(packed->pool, nalloc * sizeof(*inheritable));
+
+  if (packed->nelts)
+    {
+      memcpy(starts, packed->starts, packed->nelts * sizeof(*starts));
+      memcpy(ends, packed->ends, packed->nelts * sizeof(*ends));
+      memcpy(inheritable, packed->inheritable,
+             packed->nelts * sizeof(*inheritable));
+    }
+
+  packed->starts = starts;
+  packed->ends = ends;
+  packed->inheritable = inheritable;
+  packed->nalloc = nalloc;
+}
+
+svn_rangelist__packed_t *
+svn_rangelist__packed_create(int nalloc,
+                             apr_pool_t *result_pool)
+{
+  svn_rangelist__packed_t *packed = apr_pcalloc(result_pool, sizeof(*packed));
+
+  packed->pool = result_pool;
+  packed_reserve(packed, nalloc);
+
+  return packed;
+}
+
+svn_error_t *
+svn_rangelist__packed_set(svn_rangelist__packed_t *packed,
+                          const svn_rangelist_t *rangelist)
+{
+  svn_revnum_t last_end = 0;
+  int i;
+
+  packed->nelts = 0;
+  packed_reserve(packed, rangelist->nelts);
+
+  for (i = 0; i < rangelist->nelts; i++)
+    {
+      const svn_merge_range_t *range = APR_ARRAY_IDX(rangelist, i,
+                                                     svn_merge_range_t *);
+
+      SVN_ERR_ASSERT(IS_VALID_FORWARD_RANGE(range));
+      SVN_ERR_ASSERT(range->start >= last_end);
+
+      packed->starts[i] = range->start;
+      packed->ends[i] = range->end;
+      packed->inheritable[i] = range->inheritable;
+      last_end = range->end;
+    }
+
+  packed->nelts = rangelist->nelts;
+
+  return SVN_NO_ERROR;
+}
+
+svn_rangelist_t *
+svn_rangelist__unpack(const svn_rangelist__packed_t *packed,
+                      apr_pool_t *result_pool)
+{
+  svn_rangelist_t *rangelist = apr_array_make(result_pool, packed->nelts,
+                                              sizeof(svn_merge_range_t *));
+  svn_merge_range_t *ranges = apr_palloc(result_pool,
+                                         packed->nelts * sizeof(*ranges));
+  int i;
+
+  for (i = 0; i < packed->nelts; i++)
+    {
+      ranges[i].start = packed->starts[i];
+      ranges[i].end = packed->ends[i];
+      ranges[i].inheritable = packed->inheritable[i];
+      APR_ARRAY_PUSH(rangelist, svn_merge_range_t *) = &ranges[i];
+    }
+
+  return rangelist;
+}
+
+/* The operations on packed rangelists. */
+typedef enum packed_op_t
+{
+  packed_op_merge,
+  packed_op_intersect,
+  packed_op_remove
+} packed_op_t;
+
+/* Return the kind of the interval of the output of OP for an interval in
+ * which the first input has KIND1 and the second KIND2. */
+static enum rangelist_interval_kind_t
+packed_op_kind(packed_op_t op,
+               enum rangelist_interval_kind_t kind1,
+               enum rangelist_interval_kind_t kind2,
+               svn_boolean_t consider_inheritance)
+{
+  switch (op)
+    {
+      case packed_op_merge:
+        return MAX(kind1, kind2);
+
+      case packed_op_intersect:
+        /* The intersection of two ranges is non-inheritable only if both
+           ranges are non-inheritable. */
+        if (consider_inheritance)
+          return (kind1 == kind2) ? kind1 : MI_NONE;
+        else
+          return (kind1 != MI_NONE && kind2 != MI_NONE)
+                   ? MAX(kind1, kind2) : MI_NONE;
+
+      default:
+        /* Only remove what the eraser KIND1 covers with the same
+           inheritability, if we have to consider it. */
+        if (consider_inheritance)
+          return (kind1 != kind2) ? kind2 : MI_NONE;
+        else
+          return (kind1 == MI_NONE) ? kind2 : MI_NONE;
+    }
+}
+
+/* Append the interval (START, END] of KIND to OUTPUT, combining it with
+ * the last range of OUTPUT as combine_with_lastrange() would. */
+static void
+packed_append(svn_rangelist__packed_t *output,
+              svn_revnum_t start,
+              svn_revnum_t end,
+              enum rangelist_interval_kind_t kind,
+              svn_boolean_t combine_any_kind)
+{
+  svn_boolean_t inheritable = (kind == MI_INHERITABLE);
+  int last = output->nelts - 1;
+
+  if (kind == MI_NONE)
+    return;
+
+  if (last >= 0 && output->ends[last] == start
+      && (combine_any_kind || output->inheritable[last] == inheritable))
+    {
+      output->ends[last] = end;
+      output->inheritable[last] = output->inheritable[last] || inheritable;
+      return;
+    }
+
+  packed_reserve(output, output->nelts + 1);
+  output->starts[output->nelts] = start;
+  output->ends[output->nelts] = end;
+  output->inheritable[output->nelts] = inheritable;
+  output->nelts++;
+}
+
+/* Set OUTPUT to the result of OP on RL1 and RL2 by walking the intervals
+ * of both inputs side by side, the way rangelist_merge() does. */
+static svn_error_t *
+packed_combine(svn_rangelist__packed_t *output,
+               const svn_rangelist__packed_t *rl1,
+               const svn_rangelist__packed_t *rl2,
+               packed_op_t op,
+               svn_boolean_t consider_inheritance)
+{
+  svn_revnum_t r_last = 0;
+  int i1 = 0;
+  int i2 = 0;
+
+  SVN_ERR_ASSERT(output != rl1 && output != rl2);
+
+  /* Most outputs have no more ranges than both inputs together. */
+  output->nelts = 0;
+  packed_reserve(output, rl1->nelts + rl2->nelts);
+
+  while (i1 < rl1->nelts || i2 < rl2->nelts)
+    {
+      enum rangelist_interval_kind_t kind1 = MI_NONE;
+      enum rangelist_interval_kind_t kind2 = MI_NONE;
+      svn_revnum_t r_next = SVN_INVALID_REVNUM;
+
+      /* The kind of each input at R_LAST and where that changes. */
+      if (i1 < rl1->nelts)
+        {
+          if (rl1->starts[i1] <= r_last)
+            {
+              kind1 = rl1->inheritable[i1] ? MI_INHERITABLE
+                                           : MI_NON_INHERITABLE;
+              r_next = rl1->ends[i1];
+            }
+          else
+            r_next = rl1->starts[i1];
+        }
+      if (i2 < rl2->nelts)
+        {
+          svn_revnum_t r_next2;
+
+          if (rl2->starts[i2] <= r_last)
+            {
+              kind2 = rl2->inheritable[i2] ? MI_INHERITABLE
+                                           : MI_NON_INHERITABLE;
+              r_next2 = rl2->ends[i2];
+            }
+          else
+            r_next2 = rl2->starts[i2];
+
+          if (!SVN_IS_VALID_REVNUM(r_next) || r_next2 < r_next)
+            r_next = r_next2;
+        }
+
+      if (r_next > r_last)
+        packed_append(output, r_last, r_next,
+                      packed_op_kind(op, kind1, kind2, consider_inheritance),
+                      !consider_inheritance && op != packed_op_merge);
+
+      r_last = r_next;
+      if (i1 < rl1->nelts && rl1->ends[i1] <= r_last)
+        i1++;
+      if (i2 < rl2->nelts && rl2->ends[i2] <= r_last)
+        i2++;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_rangelist__packed_merge(svn_rangelist__packed_t *output,
+                            const svn_rangelist__packed_t *rangelist1,
+                            const svn_rangelist__packed_t *rangelist2)
+{
+  return svn_error_trace(packed_combine(output, rangelist1, rangelist2,
+                                        packed_op_merge, TRUE));
+}
+
+svn_error_t *
+svn_rangelist__packed_intersect(svn_rangelist__packed_t *output,
+                                const svn_rangelist__packed_t *rangelist1,
+                                const svn_rangelist__packed_t *rangelist2,
+                                svn_boolean_t consider_inheritance)
+{
+  return svn_error_trace(packed_combine(output, rangelist1, rangelist2,
+                                        packed_op_intersect,
+                                        consider_inheritance));
+}
+
+svn_error_t *
+svn_rangelist__packed_remove(svn_rangelist__packed_t *output,
+                             const svn_rangelist__packed_t *eraser,
+                             const svn_rangelist__packed_t *whiteboard,
+                             svn_boolean_t consider_inheritance)
+{
+  return svn_error_trace(packed_combine(output, eraser, whiteboard,
+                                        packed_op_remove,
+                                        consider_inheritance));
+}
+
 svn_error_t *
 svn_rangelist_diff(svn_rangelist_t **deleted, svn_rangelist_t **added,
                    const svn_rangelist_t *from, const svn_rangelist_t *to,
@@ -37,14 +37,48 @@
 
 
 
+/* Number of independently locked shards in thread-safe object pools.
+ * Requests by different threads for different keys will rarely contend
+ * for the same mutex. */
+#define SHARD_COUNT 32
+
+/* The part of a svn_object_pool__t holding the objects whose keys hash
+ * to the same shard.  All access to it must be serialized using MUTEX.
+ */
+typedef struct object_pool_shard_t
+{
+  /* serialization object for all non-atomic data in this struct */
+  svn_mutex__t *mutex;
+
+  /* object_ref_t.KEY -> object_ref_t* mapping.
+   *
+   * In shared object mode, there is at most one such entry per key and it
+   * may or may not be in use.  In exclusive mode, only unused references
+   * will be put here and they form chains if there are multiple unused
+   * instances for the key. */
+  apr_hash_t *objects;
+
+  /* same as objects->count but allows for non-sync'ed access */
+  volatile svn_atomic_t object_count;
+
+  /* Number of entries in OBJECTS with a reference count 0.
+     Due to races, this may be *temporarily* off by one or more.
+     Hence we must not strictly depend on it. */
+  volatile svn_atomic_t unused_count;
+
+  /* private pool for OBJECTS.  Shards don't share pools because
+   * allocating from a pool is not thread-safe. */
+  apr_pool_t *pool;
+} object_pool_shard_t;
+
 /* A reference counting wrapper around the user-provided object.
  */
 typedef struct object_ref_t
 {
   /* reference to the parent container */
-  svn_object_pool__t *object_pool;
+  object_pool_shard_t *shard;
 
-  /* identifies the bucket in OBJECT_POOL->OBJECTS in which this entry
+  /* identifies the bucket in SHARD->OBJECTS in which this entry
    * belongs. */
   svn_membuf_t key;
 
@@ -60,28 +94,15 @@ typedef struct object_ref_t
 } object_ref_t;
 
 
-/* Core data structure.  All access to it must be serialized using MUTEX.
+/* Core data structure.  It is immutable after creation, all state lives
+ * in the shards.
  */
 struct svn_object_pool__t
 {
-  /* serialization object for all non-atomic data in this struct */
-  svn_mutex__t *mutex;
-
-  /* object_ref_t.KEY -> object_ref_t* mapping.
-   *
-   * In shared object mode, there is at most one such entry per key and it
-   * may or may not be in use.  In exclusive mode, only unused references
-   * will be put here and they form chains if there are multiple unused
-   * instances for the key. */
-  apr_hash_t *objects;
-
-  /* same as objects->count but allows for non-sync'ed access */
-  volatile svn_atomic_t object_count;
-
-  /* Number of entries in OBJECTS with a reference count 0.
-     Due to races, this may be *temporarily* off by one or more.
-     Hence we must not strictly depend on it. */
-  volatile svn_atomic_t unused_count;
+  /* SHARD_COUNT shards for thread-safe pools, a single one otherwise.
+   * Keys get assigned to shards by their hash value. */
+  object_pool_shard_t *shards;
+  unsigned int shard_count;
 
   /* the root pool owning this structure */
   apr_pool_t *pool;
@@ -94,26 +115,43 @@ static apr_status_t
 object_pool_cleanup(void *baton)
 {
   svn_object_pool__t *object_pool = baton;
+  unsigned int i;
 
   /* all entries must have been released up by now */
-  SVN_ERR_ASSERT_NO_RETURN(   object_pool->object_count
-                           == object_pool->unused_count);
+  for (i = 0; i < object_pool->shard_count; ++i)
+    SVN_ERR_ASSERT_NO_RETURN(   object_pool->shards[i].object_count
+                             == object_pool->shards[i].unused_count);
 
   return APR_SUCCESS;
 }
 
-/* Remove entries from OBJECTS in OBJECT_POOL that have a ref-count of 0.
+/* Return the shard of OBJECT_POOL responsible for KEY.
+ */
+static object_pool_shard_t *
+get_shard(svn_object_pool__t *object_pool,
+          const svn_membuf_t *key)
+{
+  apr_ssize_t klen = (apr_ssize_t)key->size;
+
+  if (object_pool->shard_count == 1)
+    return object_pool->shards;
+
+  return &object_pool->shards[apr_hashfunc_default(key->data, &klen)
+                              % object_pool->shard_count];
+}
+
+/* Remove entries from OBJECTS in SHARD that have a ref-count of 0.
  *
- * Requires external serialization on OBJECT_POOL.
+ * Requires external serialization on SHARD.
  */
 static void
-remove_unused_objects(svn_object_pool__t *object_pool)
+remove_unused_objects(object_pool_shard_t *shard)
 {
-  apr_pool_t *subpool = svn_pool_create(object_pool->pool);
+  apr_pool_t *subpool = svn_pool_create(shard->pool);
 
   /* process all hash buckets */
   apr_hash_index_t *hi;
-  for (hi = apr_hash_first(subpool, object_pool->objects);
+  for (hi = apr_hash_first(subpool, shard->objects);
        hi != NULL;
        hi = apr_hash_next(hi))
     {
@@ -123,10 +161,10 @@ remove_unused_objects(svn_object_pool__t *object_pool)
          to the hash is serialized */
       if (svn_atomic_read(&object_ref->ref_count) == 0)
         {
-          apr_hash_set(object_pool->objects, object_ref->key.data,
+          apr_hash_set(shard->objects, object_ref->key.data,
                        object_ref->key.size, NULL);
-          svn_atomic_dec(&object_pool->object_count);
-          svn_atomic_dec(&object_pool->unused_count);
+          svn_atomic_dec(&shard->object_count);
+          svn_atomic_dec(&shard->unused_count);
 
           svn_pool_destroy(object_ref->pool);
         }
@@ -141,7 +179,7 @@ static apr_status_t
 object_ref_cleanup(void *baton)
 {
   object_ref_t *object = baton;
-  svn_object_pool__t *object_pool = object->object_pool;
+  object_pool_shard_t *shard = object->shard;
 
   /* If we released the last reference to object, there is one more
      unused entry.
@@ -153,7 +191,7 @@ object_ref_cleanup(void *baton)
      all threads left the racy sections.
    */
   if (svn_atomic_dec(&object->ref_count) == 0)
-    svn_atomic_inc(&object_pool->unused_count);
+    svn_atomic_inc(&shard->unused_count);
 
   return APR_SUCCESS;
 }
@@ -161,7 +199,7 @@ object_ref_cleanup(void *baton)
 /* Handle reference counting for the OBJECT_REF that the caller is about
  * to return.  The reference will be released when POOL gets cleaned up.
  *
- * Requires external serialization on OBJECT_REF->OBJECT_POOL.
+ * Requires external serialization on OBJECT_REF->SHARD.
  */
 static void
 add_object_ref(object_ref_t *object_ref,
@@ -170,27 +208,27 @@ add_object_ref(object_ref_t *object_ref,
   /* Update ref counter.
      Note that this is racy with object_ref_cleanup; see comment there. */
   if (svn_atomic_inc(&object_ref->ref_count) == 0)
-    svn_atomic_dec(&object_ref->object_pool->unused_count);
+    svn_atomic_dec(&object_ref->shard->unused_count);
 
   /* Make sure the reference gets released automatically.
-     Since POOL might be a parent pool of OBJECT_REF->OBJECT_POOL,
+     Since POOL might be a parent pool of OBJECT_REF->SHARD,
      to the reference counting update before destroying any of the
      pool hierarchy. */
   apr_pool_pre_cleanup_register(pool, object_ref, object_ref_cleanup);
 }
 
-/* Actual implementation of svn_object_pool__lookup.
+/* Actual implementation of svn_object_pool__lookup for KEY in SHARD.
  *
- * Requires external serialization on OBJECT_POOL.
+ * Requires external serialization on SHARD.
  */
 static svn_error_t *
 lookup(void **object,
-       svn_object_pool__t *object_pool,
+       object_pool_shard_t *shard,
        svn_membuf_t *key,
        apr_pool_t *result_pool)
 {
   object_ref_t *object_ref
-    = apr_hash_get(object_pool->objects, key->data, key->size);
+    = apr_hash_get(shard->objects, key->data, key->size);
 
   if (object_ref)
     {
@@ -205,20 +243,20 @@ lookup(void **object,
   return SVN_NO_ERROR;
 }
 
-/* Actual implementation of svn_object_pool__insert.
+/* Actual implementation of svn_object_pool__insert for KEY in SHARD.
  *
- * Requires external serialization on OBJECT_POOL.
+ * Requires external serialization on SHARD.
  */
 static svn_error_t *
 insert(void **object,
-       svn_object_pool__t *object_pool,
+       object_pool_shard_t *shard,
        const svn_membuf_t *key,
        void *item,
        apr_pool_t *item_pool,
        apr_pool_t *result_pool)
 {
   object_ref_t *object_ref
-    = apr_hash_get(object_pool->objects, key->data, key->size);
+    = apr_hash_get(shard->objects, key->data, key->size);
   if (object_ref)
     {
       /* Destroy the new one and return a reference to the existing one
@@ -230,7 +268,7 @@ insert(void **object,
     {
       /* add new index entry */
       object_ref = apr_pcalloc(item_pool, sizeof(*object_ref));
-      object_ref->object_pool = object_pool;
+      object_ref->shard = shard;
       object_ref->object = item;
       object_ref->pool = item_pool;
 
@@ -238,14 +276,14 @@ insert(void **object,
       object_ref->key.size = key->size;
       memcpy(object_ref->key.data, key->data, key->size);
 
-      apr_hash_set(object_pool->objects, object_ref->key.data,
+      apr_hash_set(shard->objects, object_ref->key.data,
                    object_ref->key.size, object_ref);
-      svn_atomic_inc(&object_pool->object_count);
+      svn_atomic_inc(&shard->object_count);
 
       /* the new entry is *not* in use yet.
        * add_object_ref will update counters again.
        */
-      svn_atomic_inc(&object_ref->object_pool->unused_count);
+      svn_atomic_inc(&shard->unused_count);
     }
 
   /* return a reference to the object we just added */
@@ -253,9 +291,9 @@ insert(void **object,
   add_object_ref(object_ref, result_pool);
 
   /* limit memory usage */
-  if (svn_atomic_read(&object_pool->unused_count) * 2
-      > apr_hash_count(object_pool->objects) + 2)
-    remove_unused_objects(object_pool);
+  if (svn_atomic_read(&shard->unused_count) * 2
+      > apr_hash_count(shard->objects) + 2)
+    remove_unused_objects(shard);
 
   return SVN_NO_ERROR;
 }
@@ -269,15 +307,25 @@ svn_object_pool__create(svn_object_pool__t **object_pool,
                         apr_pool_t *pool)
 {
   svn_object_pool__t *result;
+  unsigned int i;
 
   /* construct the object pool in our private ROOT_POOL to survive POOL
    * cleanup and to prevent threading issues with the allocator
    */
   result = apr_pcalloc(pool, sizeof(*result));
-  SVN_ERR(svn_mutex__init(&result->mutex, thread_safe, pool));
-
   result->pool = pool;
-  result->objects = svn_hash__make(result->pool);
+  result->shard_count = thread_safe ? SHARD_COUNT : 1;
+  result->shards = apr_pcalloc(pool,
+                               result->shard_count * sizeof(*result->shards));
+
+  for (i = 0; i < result->shard_count; ++i)
+    {
+      object_pool_shard_t *shard = &result->shards[i];
+
+      SVN_ERR(svn_mutex__init(&shard->mutex, thread_safe, pool));
+      shard->pool = svn_pool_create(pool);
+      shard->objects = svn_hash__make(shard->pool);
+    }
 
   /* make sure we clean up nicely.
    * We need two cleanup functions of which exactly one will be run
@@ -305,9 +353,11 @@ svn_object_pool__lookup(void **object,
                         svn_membuf_t *key,
                         apr_pool_t *result_pool)
 {
+  object_pool_shard_t *shard = get_shard(object_pool, key);
+
   *object = NULL;
-  SVN_MUTEX__WITH_LOCK(object_pool->mutex,
-                       lookup(object, object_pool, key, result_pool));
+  SVN_MUTEX__WITH_LOCK(shard->mutex,
+                       lookup(object, shard, key, result_pool));
   return SVN_NO_ERROR;
 }
 
@@ -319,9 +369,11 @@ svn_object_pool__insert(void **object,
                         apr_pool_t *item_pool,
                         apr_pool_t *result_pool)
 {
+  object_pool_shard_t *shard = get_shard(object_pool, key);
+
   *object = NULL;
-  SVN_MUTEX__WITH_LOCK(object_pool->mutex,
-                       insert(object, object_pool, key, item,
+  SVN_MUTEX__WITH_LOCK(shard->mutex,
+                       insert(object, shard, key, item,
                               item_pool, result_pool));
   return SVN_NO_ERROR;
 }
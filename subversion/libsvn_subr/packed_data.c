@@ -31,6 +31,18 @@
 
 #include "svn_private_config.h"
 
+/* Use SSE2 to find runs of single-byte values 16 bytes at a time.  SSE2
+ * is part of the x86-64 base ISA, so there is no need for a runtime check.
+ */
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define SVN_PACKED__USE_SSE2 1
+#endif
+
+/* Number of bytes that read_packed_uint_block() may access beyond the
+ * start of the last value it decodes. */
+#define PACKED_READ_PADDING 16
+
 
 
 /* Private int stream data referenced by svn_packed__int_stream_t.
@@ -721,6 +733,50 @@ read_packed_uint_body(unsigned char *p, apr_uint64_t *result)
   return ++p;
 }
 
+/* Read COUNT 7b/8b encoded values from P and store them in reverse order,
+ * i.e. the first value goes to VALUES[COUNT-1].  Returns the first position
+ * after the parsed data.
+ *
+ * At least 10 * COUNT + PACKED_READ_PADDING bytes must be readable from P.
+ * Overflows are handled as in read_packed_uint_body.
+ */
+static unsigned char *
+read_packed_uint_block(unsigned char *p,
+                       apr_uint64_t *values,
+                       apr_size_t count)
+{
+#ifdef SVN_PACKED__USE_SSE2
+
+  while (count > 0)
+    {
+      /* Small numbers are by far the most frequent ones, in particular
+       * for deltified streams.  Bit N in MASK is set iff byte N is a
+       * continuation byte, i.e. the length of the leading run of values
+       * < 0x80 is the number of trailing 0 bits. */
+      __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+      unsigned int mask = (unsigned int)_mm_movemask_epi8(chunk);
+      apr_size_t run = (apr_size_t)__builtin_ctz(mask | 0x10000);
+
+      if (run > count)
+        run = count;
+
+      for (count -= run; run > 0; --run)
+        values[count + run - 1] = *p++;
+
+      if (count > 0 && *p >= 0x80)
+        p = read_packed_uint_body(p, &values[--count]);
+    }
+
+#else
+
+  for (; count > 0; --count)
+    p = read_packed_uint_body(p, &values[count-1]);
+
+#endif
+
+  return p;
+}
+
 /* Read one 7b/8b encoded value from STREAM and return it in *RESULT.
  *
  * Overflows will be detected in the sense that it will end parsing the
@@ -801,9 +857,10 @@ svn_packed__data_fill_buffer(svn_packed__int_stream_t *stream)
   else
     {
       /* use this local buffer only if the packed data is shorter than this.
-         The goal is that read_packed_uint_body doesn't need check for
+         The goal is that read_packed_uint_block doesn't need check for
          overflows. */
-      unsigned char local_buffer[10 * SVN__PACKED_DATA_BUFFER_SIZE];
+      unsigned char local_buffer[10 * SVN__PACKED_DATA_BUFFER_SIZE
+                                 + PACKED_READ_PADDING];
       unsigned char *p;
       unsigned char *start;
       apr_size_t packed_read;
@@ -814,7 +871,7 @@ svn_packed__data_fill_buffer(svn_packed__int_stream_t *stream)
           memcpy(local_buffer,
                  private_data->packed->data,
                  private_data->packed->len);
-          memset(local_buffer + private_data->packed->len, 0, MIN(trail, end));
+          memset(local_buffer + private_data->packed->len, 0, trail);
 
           p = local_buffer;
         }
@@ -823,8 +880,7 @@ svn_packed__data_fill_buffer(svn_packed__int_stream_t *stream)
 
       /* unpack numbers */
       start = p;
-      for (i = end; i > 0; --i)
-        p = read_packed_uint_body(p, &stream->buffer[i-1]);
+      p = read_packed_uint_block(p, stream->buffer, end);
 
       /* adjust remaining packed data buffer */
       packed_read = p - start;
@@ -0,0 +1,131 @@
+/* path_intern.c --- interned relpaths with O(1) equality
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include <string.h>
+#include <apr_hash.h>
+
+#include "svn_string.h"
+#include "private/svn_dirent_uri_private.h"
+
+/* Every interned path is stored exactly once in a hash keyed by its
+ * full relpath.  Its parent gets interned first, so all ancestors of an
+ * interned path are interned as well and reachable through the PARENT
+ * links.
+ */
+struct svn_relpath__intern_pool_t
+{
+  /* Maps const char * relpaths to svn_relpath__interned_t *. */
+  apr_hash_t *paths;
+
+  /* The interned empty path, i.e. the root of all others. */
+  svn_relpath__interned_t *root;
+
+  /* Buffer for constructing the keys in svn_relpath__intern_join(). */
+  svn_stringbuf_t *buffer;
+
+  /* Allocate everything in here. */
+  apr_pool_t *pool;
+};
+
+svn_relpath__intern_pool_t *
+svn_relpath__intern_pool_create(apr_pool_t *result_pool)
+{
+  svn_relpath__intern_pool_t *ipool
+    = apr_pcalloc(result_pool, sizeof(*ipool));
+
+  ipool->paths = apr_hash_make(result_pool);
+  ipool->buffer = svn_stringbuf_create_empty(result_pool);
+  ipool->pool = result_pool;
+
+  ipool->root = apr_pcalloc(result_pool, sizeof(*ipool->root));
+  ipool->root->data = "";
+  apr_hash_set(ipool->paths, "", 0, ipool->root);
+
+  return ipool;
+}
+
+/* Return the interned version of the LEN bytes long relpath DATA from
+ * IPOOL, interning it and all its ancestors if necessary.  DATA does not
+ * need to be NUL-terminated.
+ */
+static const svn_relpath__interned_t *
+intern(svn_relpath__intern_pool_t *ipool,
+       const char *data,
+       apr_size_t len)
+{
+  svn_relpath__interned_t *result = apr_hash_get(ipool->paths, data, len);
+  apr_size_t parent_len;
+
+  if (result)
+    return result;
+
+  /* Intern the parent first. */
+  for (parent_len = len; parent_len > 0; --parent_len)
+    if (data[parent_len - 1] == '/')
+      break;
+
+  result = apr_palloc(ipool->pool, sizeof(*result));
+  result->parent = intern(ipool, data, parent_len ? parent_len - 1 : 0);
+  result->data = apr_pstrmemdup(ipool->pool, data, len);
+  result->len = len;
+  result->depth = result->parent->depth + 1;
+
+  apr_hash_set(ipool->paths, result->data, len, result);
+
+  return result;
+}
+
+const svn_relpath__interned_t *
+svn_relpath__intern(svn_relpath__intern_pool_t *ipool,
+                    const char *relpath)
+{
+  return intern(ipool, relpath, strlen(relpath));
+}
+
+const svn_relpath__interned_t *
+svn_relpath__intern_join(svn_relpath__intern_pool_t *ipool,
+                         const svn_relpath__interned_t *parent,
+                         const char *component)
+{
+  svn_stringbuf_t *buffer = ipool->buffer;
+
+  if (parent->len == 0)
+    return svn_relpath__intern(ipool, component);
+
+  svn_stringbuf_setempty(buffer);
+  svn_stringbuf_appendbytes(buffer, parent->data, parent->len);
+  svn_stringbuf_appendbyte(buffer, '/');
+  svn_stringbuf_appendcstr(buffer, component);
+
+  return intern(ipool, buffer->data, buffer->len);
+}
+
+svn_boolean_t
+svn_relpath__interned_is_ancestor(const svn_relpath__interned_t *ancestor,
+                                  const svn_relpath__interned_t *path)
+{
+  while (path->depth > ancestor->depth)
+    path = path->parent;
+
+  return path == ancestor;
+}
@@ -32,9 +32,20 @@
 #include <apr_pools.h>
 
 #include "svn_pools.h"
+#include "svn_error.h"
+#include "private/svn_atomic.h"
+#include "private/svn_subr_private.h"
 
 #include "pools.h"
 
+#include "svn_private_config.h"
+
+#if !defined(WIN32) && defined(HAVE_UNISTD_H)
+#include <unistd.h>         /* For sysconf() */
+#include <sys/resource.h>   /* For getrusage() */
+#define SVN_HAVE_RUSAGE 1
+#endif
+
 #if APR_POOL_DEBUG
 /* file_line for the non-debug case. */
 static const char SVN_FILE_LINE_UNDEFINED[] = "svn:<undefined>";
@@ -160,3 +171,90 @@ svn_pool__create_unmanaged(svn_boolean_t thread_safe)
                                svn_pool_create_allocator(thread_safe));
   return pool;
 }
+
+
+/*** Process memory accounting ***/
+
+/* Sample the process size only on every Nth budget check. */
+#define BUDGET_CHECK_INTERVAL 64
+
+/* Memory budget in bytes.  0 means "unlimited". */
+static apr_uint64_t memory_budget = 0;
+
+/* Number of budget checks so far. */
+static volatile svn_atomic_t budget_checks = 0;
+
+void
+svn_pool__memory_usage(apr_uint64_t *current,
+                       apr_uint64_t *peak)
+{
+  apr_uint64_t rss = 0;
+  apr_uint64_t max_rss = 0;
+
+#ifdef SVN_HAVE_RUSAGE
+  struct rusage usage;
+
+#ifdef __linux__
+  {
+    /* The second field is the number of resident pages. */
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (statm)
+      {
+        unsigned long size, resident;
+        if (fscanf(statm, "%lu %lu", &size, &resident) == 2)
+          rss = (apr_uint64_t)resident * sysconf(_SC_PAGESIZE);
+        fclose(statm);
+      }
+  }
+#endif
+
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+      max_rss = (apr_uint64_t)usage.ru_maxrss;
+#ifndef __APPLE__
+      /* Everybody but Darwin reports kilobytes. */
+      max_rss *= 1024;
+#endif
+    }
+#endif
+
+  /* Where we can't get the current size, the peak is an upper bound. */
+  if (rss == 0)
+    rss = max_rss;
+  if (max_rss < rss)
+    max_rss = rss;
+
+  if (current)
+    *current = rss;
+  if (peak)
+    *peak = max_rss;
+}
+
+void
+svn_pool__set_memory_budget(apr_uint64_t budget)
+{
+  memory_budget = budget;
+}
+
+svn_error_t *
+svn_pool__check_memory_budget(void)
+{
+  apr_uint64_t budget = memory_budget;
+  apr_uint64_t current;
+
+  if (budget == 0)
+    return SVN_NO_ERROR;
+
+  if (svn_atomic_inc(&budget_checks) % BUDGET_CHECK_INTERVAL)
+    return SVN_NO_ERROR;
+
+  svn_pool__memory_usage(&current, NULL);
+  if (current <= budget)
+    return SVN_NO_ERROR;
+
+  return svn_error_createf(SVN_ERR_MEMORY_BUDGET_EXCEEDED, NULL,
+                           _("Process size of %" APR_UINT64_T_FMT " kB "
+                             "exceeds the memory budget of %"
+                             APR_UINT64_T_FMT " kB"),
+                           current / 1024, budget / 1024);
+}
@@ -0,0 +1,257 @@
+/* profile.c : process-wide counters and timers for diagnostics
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_hash.h>
+#include <apr_strings.h>
+
+#include "svn_pools.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_mutex.h"
+#include "private/svn_profile.h"
+#include "private/svn_sorts_private.h"
+
+#include "svn_private_config.h"
+
+/* Totals of one LABEL in one CATEGORY. */
+typedef struct profile_entry_t
+{
+  const char *category;
+  const char *label;
+
+  /* Number of events. */
+  apr_uint64_t count;
+
+  /* Sum of the amounts of data the events processed. */
+  apr_uint64_t amount;
+
+  /* Sum of the durations of the events that were timed. */
+  apr_interval_time_t time;
+} profile_entry_t;
+
+/* Non-zero once svn_profile__enable() has been called. */
+static volatile svn_atomic_t profile_enabled = 0;
+
+/* Initialization state of the globals below. */
+static volatile svn_atomic_t profile_status = 0;
+
+/* Serializes all access to PROFILE_ENTRIES. */
+static svn_mutex__t *profile_mutex = NULL;
+
+/* Global pool holding PROFILE_ENTRIES. */
+static apr_pool_t *profile_pool = NULL;
+
+/* Map of const char *category to apr_hash_t * maps of const char *label
+   to profile_entry_t *. */
+static apr_hash_t *profile_entries = NULL;
+
+/* svn_atomic__err_init_func_t implementation that initializes the
+ * globals.  Both arguments are unused and should be NULL. */
+static svn_error_t *
+init_profile(void *null_baton,
+             apr_pool_t *null_pool)
+{
+  /* The profile lives for the rest of the process, so it needs a
+   * global pool. */
+  profile_pool = svn_pool_create(NULL);
+  SVN_ERR(svn_mutex__init(&profile_mutex, TRUE, profile_pool));
+  profile_entries = apr_hash_make(profile_pool);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_profile__enable(void)
+{
+  SVN_ERR(svn_atomic__init_once(&profile_status, init_profile, NULL, NULL));
+  svn_atomic_set(&profile_enabled, 1);
+
+  return SVN_NO_ERROR;
+}
+
+svn_boolean_t
+svn_profile__enabled(void)
+{
+  return svn_atomic_read(&profile_enabled) != 0;
+}
+
+apr_time_t
+svn_profile__start(void)
+{
+  return svn_profile__enabled() ? apr_time_now() : 0;
+}
+
+/* Add an event of LABEL in CATEGORY that took DURATION and processed
+ * AMOUNT units of data to PROFILE_ENTRIES.  Call this only while holding
+ * PROFILE_MUTEX. */
+static svn_error_t *
+add_event(const char *category,
+          const char *label,
+          apr_interval_time_t duration,
+          apr_uint64_t amount)
+{
+  apr_hash_t *labels = apr_hash_get(profile_entries, category,
+                                    APR_HASH_KEY_STRING);
+  profile_entry_t *entry;
+
+  if (!labels)
+    {
+      category = apr_pstrdup(profile_pool, category);
+      labels = apr_hash_make(profile_pool);
+      apr_hash_set(profile_entries, category, APR_HASH_KEY_STRING, labels);
+    }
+
+  entry = apr_hash_get(labels, label, APR_HASH_KEY_STRING);
+  if (!entry)
+    {
+      entry = apr_pcalloc(profile_pool, sizeof(*entry));
+      entry->category = apr_pstrdup(profile_pool, category);
+      entry->label = apr_pstrdup(profile_pool, label);
+      apr_hash_set(labels, entry->label, APR_HASH_KEY_STRING, entry);
+    }
+
+  entry->count++;
+  entry->amount += amount;
+  entry->time += duration;
+
+  return SVN_NO_ERROR;
+}
+
+void
+svn_profile__record(const char *category,
+                    const char *label,
+                    apr_time_t start,
+                    apr_uint64_t amount)
+{
+  apr_interval_time_t duration = 0;
+  svn_error_t *err;
+
+  if (!svn_profile__enabled())
+    return;
+
+  if (start)
+    duration = apr_time_now() - start;
+
+  /* Losing an event is preferable to failing the operation. */
+  err = svn_mutex__lock(profile_mutex);
+  if (!err)
+    err = svn_mutex__unlock(profile_mutex,
+                            add_event(category, label, duration, amount));
+  svn_error_clear(err);
+}
+
+/* Order profile_entry_t ** by category, then by decreasing time, then
+ * by decreasing count and finally by label. */
+static int
+compare_entries(const void *a, const void *b)
+{
+  const profile_entry_t *lhs = *(const profile_entry_t * const *)a;
+  const profile_entry_t *rhs = *(const profile_entry_t * const *)b;
+  int diff = strcmp(lhs->category, rhs->category);
+
+  if (diff)
+    return diff;
+  if (lhs->time != rhs->time)
+    return lhs->time > rhs->time ? -1 : 1;
+  if (lhs->count != rhs->count)
+    return lhs->count > rhs->count ? -1 : 1;
+
+  return strcmp(lhs->label, rhs->label);
+}
+
+/* Copy all entries of PROFILE_ENTRIES to *ENTRIES, allocated in
+ * RESULT_POOL.  Call this only while holding PROFILE_MUTEX. */
+static svn_error_t *
+collect_entries(apr_array_header_t **entries,
+                apr_pool_t *result_pool)
+{
+  apr_hash_index_t *hi;
+
+  *entries = apr_array_make(result_pool, 64, sizeof(profile_entry_t *));
+
+  for (hi = apr_hash_first(result_pool, profile_entries);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      apr_hash_t *labels = apr_hash_this_val(hi);
+      apr_hash_index_t *hi2;
+
+      for (hi2 = apr_hash_first(result_pool, labels);
+           hi2;
+           hi2 = apr_hash_next(hi2))
+        {
+          profile_entry_t *entry = apr_pmemdup(result_pool,
+                                               apr_hash_this_val(hi2),
+                                               sizeof(*entry));
+
+          APR_ARRAY_PUSH(*entries, profile_entry_t *) = entry;
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_profile__print(svn_stream_t *stream,
+                   apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *entries;
+  const char *last_category = NULL;
+  int i;
+
+  if (!svn_profile__enabled())
+    return SVN_NO_ERROR;
+
+  SVN_MUTEX__WITH_LOCK(profile_mutex,
+                       collect_entries(&entries, scratch_pool));
+  svn_sort__array(entries, compare_entries);
+
+  SVN_ERR(svn_stream_printf(stream, scratch_pool,
+                            "%-44s %10s %14s %12s\n",
+                            _("Profile"), _("Count"), _("Amount"),
+                            _("Time (ms)")));
+
+  for (i = 0; i < entries->nelts; i++)
+    {
+      const profile_entry_t *entry = APR_ARRAY_IDX(entries, i,
+                                                   profile_entry_t *);
+
+      if (!last_category || strcmp(last_category, entry->category))
+        {
+          SVN_ERR(svn_stream_printf(stream, scratch_pool, "%s:\n",
+                                    entry->category));
+          last_category = entry->category;
+        }
+
+      SVN_ERR(svn_stream_printf(stream, scratch_pool,
+                                "  %-42s %10" APR_UINT64_T_FMT
+                                " %14" APR_UINT64_T_FMT
+                                " %12" APR_INT64_T_FMT ".%03d\n",
+                                entry->label, entry->count, entry->amount,
+                                (apr_int64_t)(entry->time / 1000),
+                                (int)(entry->time % 1000)));
+    }
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,111 @@
+/*
+ * slab.c :  allocator for fixed-size objects with explicit free
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+#include "svn_sorts.h"
+#include "private/svn_subr_private.h"
+
+/* We allocate objects from the pool in slabs of about this size (in
+ * bytes).  Large enough to make pool allocations rare but small enough
+ * to not waste much memory on nearly empty slabs.
+ */
+#define SLAB_SIZE 0x2000
+
+/* Freed objects get linked into a list through their first bytes.
+ */
+typedef struct free_object_t
+{
+  struct free_object_t *next;
+} free_object_t;
+
+struct svn_slab__t
+{
+  /* Size of each object, aligned and large enough to hold a
+   * free_object_t. */
+  apr_size_t object_size;
+
+  /* Number of objects to allocate at once. */
+  apr_size_t objects_per_slab;
+
+  /* Next unused object in the current slab. */
+  char *next;
+
+  /* Number of unused objects remaining in the current slab. */
+  apr_size_t remaining;
+
+  /* Objects released by svn_slab__free(), ready for reuse. */
+  free_object_t *free_list;
+
+  /* Allocate the slabs from this pool. */
+  apr_pool_t *pool;
+};
+
+svn_slab__t *
+svn_slab__create(apr_size_t object_size,
+                 apr_pool_t *pool)
+{
+  svn_slab__t *slab = apr_pcalloc(pool, sizeof(*slab));
+
+  slab->object_size
+    = APR_ALIGN_DEFAULT(MAX(object_size, sizeof(free_object_t)));
+  slab->objects_per_slab = MAX(SLAB_SIZE / slab->object_size, 1);
+  slab->pool = pool;
+
+  return slab;
+}
+
+void *
+svn_slab__alloc(svn_slab__t *slab)
+{
+  void *result;
+
+  if (slab->free_list)
+    {
+      result = slab->free_list;
+      slab->free_list = slab->free_list->next;
+      return result;
+    }
+
+  if (slab->remaining == 0)
+    {
+      slab->next = apr_palloc(slab->pool,
+                              slab->objects_per_slab * slab->object_size);
+      slab->remaining = slab->objects_per_slab;
+    }
+
+  result = slab->next;
+  slab->next += slab->object_size;
+  slab->remaining--;
+
+  return result;
+}
+
+void
+svn_slab__free(svn_slab__t *slab,
+               void *object)
+{
+  free_object_t *freed = object;
+
+  freed->next = slab->free_list;
+  slab->free_list = freed;
+}
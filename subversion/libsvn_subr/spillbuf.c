@@ -26,6 +26,7 @@
 #include "svn_io.h"
 #include "svn_pools.h"
 
+#include "private/svn_io_private.h"
 #include "private/svn_subr_private.h"
 
 
@@ -74,6 +75,12 @@ struct svn_spillbuf_t {
   /* How much content remains in SPILL.  */
   svn_filesize_t spill_size;
 
+  /* Content that follows SPILL but has not been written to it yet.
+     Small writes get collected here, so we only write whole blocks to
+     the file.  If the reader consumes all of SPILL before this block is
+     full, it gets the block from memory.  Counted in MEMORY_SIZE.  */
+  struct memblock_t *pending;
+
   /* When false, do not delete the spill file when it is closed. */
   svn_boolean_t delete_on_close;
 
@@ -230,6 +237,81 @@ return_buffer(svn_spillbuf_t *buf,
 }
 
 
+/* Append the LEN bytes at DATA to the spill file of BUF.  */
+static svn_error_t *
+write_to_spill(svn_spillbuf_t *buf,
+               const char *data,
+               apr_size_t len,
+               apr_pool_t *scratch_pool)
+{
+  apr_off_t output_unused = 0;  /* ### stupid API  */
+
+  /* Seek to the end of the spill file. We don't know if a read has
+     occurred since our last write, and moved the file position.  */
+  SVN_ERR(svn_io_file_seek(buf->spill,
+                           APR_END, &output_unused,
+                           scratch_pool));
+
+  SVN_ERR(svn_io_file_write_full(buf->spill, data, len,
+                                 NULL, scratch_pool));
+  buf->spill_size += len;
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Write the content of BUF->PENDING to the spill file.  */
+static svn_error_t *
+flush_pending(svn_spillbuf_t *buf,
+              apr_pool_t *scratch_pool)
+{
+  if (buf->pending == NULL || buf->pending->size == 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(write_to_spill(buf, buf->pending->data, buf->pending->size,
+                         scratch_pool));
+  buf->memory_size -= buf->pending->size;
+  buf->pending->size = 0;
+
+  return SVN_NO_ERROR;
+}
+
+
+/* Close the spill file of BUF after all of its content has been read.
+   Content still pending becomes the last in-memory block.  */
+static svn_error_t *
+close_spill(svn_spillbuf_t *buf,
+            apr_pool_t *scratch_pool)
+{
+  struct memblock_t *mem = buf->pending;
+
+  SVN_ERR(svn_io_file_close(buf->spill, scratch_pool));
+  buf->spill = NULL;
+  buf->spill_start = 0;
+  buf->pending = NULL;
+
+  if (mem == NULL)
+    return SVN_NO_ERROR;
+
+  if (mem->size == 0)
+    {
+      return_buffer(buf, mem);
+    }
+  else if (buf->tail == NULL)
+    {
+      buf->head = mem;
+      buf->tail = mem;
+    }
+  else
+    {
+      buf->tail->next = mem;
+      buf->tail = mem;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_spillbuf__write(svn_spillbuf_t *buf,
                     const char *data,
@@ -275,20 +357,31 @@ svn_spillbuf__write(svn_spillbuf_t *buf,
 
   /* Once a spill file has been constructed, then we need to put all
      arriving data into the file. We will no longer attempt to hold it
-     in memory.  */
+     in memory, except for collecting small writes into whole blocks.
+     Those who want the whole contents in the file get it right away.  */
   if (buf->spill != NULL)
     {
-      apr_off_t output_unused = 0;  /* ### stupid API  */
+      if (buf->spill_all_contents)
+        return svn_error_trace(write_to_spill(buf, data, len,
+                                              scratch_pool));
 
-      /* Seek to the end of the spill file. We don't know if a read has
-         occurred since our last write, and moved the file position.  */
-      SVN_ERR(svn_io_file_seek(buf->spill,
-                               APR_END, &output_unused,
-                               scratch_pool));
+      if (buf->pending && buf->pending->size + len > buf->blocksize)
+        SVN_ERR(flush_pending(buf, scratch_pool));
+
+      if (len >= buf->blocksize)
+        return svn_error_trace(write_to_spill(buf, data, len,
+                                              scratch_pool));
 
-      SVN_ERR(svn_io_file_write_full(buf->spill, data, len,
-                                     NULL, scratch_pool));
-      buf->spill_size += len;
+      if (buf->pending == NULL)
+        {
+          buf->pending = get_buffer(buf);
+          buf->pending->size = 0;
+          buf->pending->next = NULL;
+        }
+
+      memcpy(&buf->pending->data[buf->pending->size], data, len);
+      buf->pending->size += len;
+      buf->memory_size += len;
 
       return SVN_NO_ERROR;
     }
@@ -355,6 +448,10 @@ read_data(struct memblock_t **mem,
 {
   svn_error_t *err;
 
+  /* Nothing left in the spill file but maybe some pending content?  */
+  if (buf->head == NULL && buf->spill != NULL && buf->spill_size == 0)
+    SVN_ERR(close_spill(buf, scratch_pool));
+
   /* If we have some in-memory blocks, then return one.  */
   if (buf->head != NULL)
     {
@@ -406,9 +503,7 @@ read_data(struct memblock_t **mem,
   if ((buf->spill_size -= (*mem)->size) == 0)
     {
       /* Close and reset our spill file information.  */
-      SVN_ERR(svn_io_file_close(buf->spill, scratch_pool));
-      buf->spill = NULL;
-      buf->spill_start = 0;
+      SVN_ERR(close_spill(buf, scratch_pool));
     }
 
   /* *mem has been initialized. Done.  */
@@ -671,6 +766,49 @@ read_handler_spillbuf(void *baton, char *buffer, apr_size_t *len)
 }
 
 
+static svn_error_t *
+read_buffer_handler_spillbuf(void *baton, const char **data,
+                             apr_size_t *len)
+{
+  struct spillbuf_baton *sb = baton;
+  svn_spillbuf_reader_t *reader = sb->reader;
+
+  /* Hand out saved content first, then the spillbuf's own blocks. */
+  if (reader->save_len > 0)
+    {
+      if (*len > reader->save_len)
+        *len = reader->save_len;
+
+      *data = reader->save_ptr + reader->save_pos;
+      reader->save_pos += *len;
+      reader->save_len -= *len;
+      return SVN_NO_ERROR;
+    }
+
+  if (reader->sb_len == 0)
+    {
+      SVN_ERR(svn_spillbuf__read(&reader->sb_ptr, &reader->sb_len,
+                                 reader->buf, sb->scratch_pool));
+      svn_pool_clear(sb->scratch_pool);
+
+      if (reader->sb_ptr == NULL)
+        {
+          reader->sb_len = 0;
+          *len = 0;
+          return SVN_NO_ERROR;
+        }
+    }
+
+  if (*len > reader->sb_len)
+    *len = reader->sb_len;
+
+  *data = reader->sb_ptr;
+  reader->sb_ptr += *len;
+  reader->sb_len -= *len;
+  return SVN_NO_ERROR;
+}
+
+
 static svn_error_t *
 write_handler_spillbuf(void *baton, const char *data, apr_size_t *len)
 {
@@ -700,6 +838,7 @@ svn_stream__from_spillbuf(svn_spillbuf_t *buf,
   svn_stream_set_read2(stream, NULL /* only full read support */,
                        read_handler_spillbuf);
   svn_stream_set_write(stream, write_handler_spillbuf);
+  svn_stream__set_read_buffer(stream, read_buffer_handler_spillbuf);
 
   return stream;
 }
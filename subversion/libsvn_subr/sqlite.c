@@ -37,6 +37,8 @@
 #include "private/svn_atomic.h"
 #include "private/svn_skel.h"
 #include "private/svn_token.h"
+#include "private/svn_profile.h"
+#include "private/svn_probes.h"
 #ifdef WIN32
 #include "private/svn_io_private.h"
 #include "private/svn_utf_private.h"
@@ -138,6 +140,7 @@ struct svn_sqlite__db_t
 {
   sqlite3 *db3;
   const char * const *statement_strings;
+  const char * const (*statement_info)[2];
   int nbr_statements;
   svn_sqlite__stmt_t **prepared_stmts;
   apr_pool_t *state_pool;
@@ -155,6 +158,9 @@ struct svn_sqlite__stmt_t
   sqlite3_stmt *s3stmt;
   svn_sqlite__db_t *db;
   svn_boolean_t needs_reset;
+
+  /* Name under which this statement is profiled, or NULL if unknown. */
+  const char *name;
 };
 
 struct svn_sqlite__context_t
@@ -250,6 +256,7 @@ prepare_statement(svn_sqlite__stmt_t **stmt, svn_sqlite__db_t *db,
   *stmt = apr_palloc(result_pool, sizeof(**stmt));
   (*stmt)->db = db;
   (*stmt)->needs_reset = FALSE;
+  (*stmt)->name = NULL;
 
   SQLITE_ERR(sqlite3_prepare_v2(db->db3, text, -1, &(*stmt)->s3stmt, NULL), db);
 
@@ -257,6 +264,14 @@ prepare_statement(svn_sqlite__stmt_t **stmt, svn_sqlite__db_t *db,
 }
 
 
+void
+svn_sqlite__set_statement_info(svn_sqlite__db_t *db,
+                               const char * const statement_info[][2])
+{
+  db->statement_info = statement_info;
+}
+
+
 svn_error_t *
 svn_sqlite__exec_statements(svn_sqlite__db_t *db, int stmt_idx)
 {
@@ -273,9 +288,13 @@ svn_sqlite__get_statement(svn_sqlite__stmt_t **stmt, svn_sqlite__db_t *db,
   SVN_ERR_ASSERT(stmt_idx < db->nbr_statements);
 
   if (db->prepared_stmts[stmt_idx] == NULL)
-    SVN_ERR(prepare_statement(&db->prepared_stmts[stmt_idx], db,
-                              db->statement_strings[stmt_idx],
-                              db->state_pool));
+    {
+      SVN_ERR(prepare_statement(&db->prepared_stmts[stmt_idx], db,
+                                db->statement_strings[stmt_idx],
+                                db->state_pool));
+      if (db->statement_info)
+        db->prepared_stmts[stmt_idx]->name = db->statement_info[stmt_idx][0];
+    }
 
   *stmt = db->prepared_stmts[stmt_idx];
 
@@ -344,7 +363,17 @@ svn_sqlite__step_row(svn_sqlite__stmt_t *stmt)
 svn_error_t *
 svn_sqlite__step(svn_boolean_t *got_row, svn_sqlite__stmt_t *stmt)
 {
-  int sqlite_result = sqlite3_step(stmt->s3stmt);
+  apr_time_t start = svn_profile__start();
+  int sqlite_result;
+
+  SVN_PROBE1(sqlite__step__start, stmt->name);
+  sqlite_result = sqlite3_step(stmt->s3stmt);
+  SVN_PROBE2(sqlite__step__done, stmt->name, sqlite_result == SQLITE_ROW);
+
+  /* The amount is the number of rows returned. */
+  if (start)
+    svn_profile__record("sqlite", stmt->name ? stmt->name : "(unnamed)",
+                        start, sqlite_result == SQLITE_ROW ? 1 : 0);
 
   if (sqlite_result != SQLITE_DONE && sqlite_result != SQLITE_ROW)
     {
@@ -386,6 +415,12 @@ svn_sqlite__update(int *affected_rows, svn_sqlite__stmt_t *stmt)
   return svn_error_trace(svn_sqlite__reset(stmt));
 }
 
+int
+svn_sqlite__total_changes(svn_sqlite__db_t *db)
+{
+  return sqlite3_total_changes(db->db3);
+}
+
 
 static svn_error_t *
 vbindf(svn_sqlite__stmt_t *stmt, const char *fmt, va_list ap)
@@ -1221,6 +1256,28 @@ svn_sqlite__open(svn_sqlite__db_t **db, const char *path,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_sqlite__set_memory_limits(svn_sqlite__db_t *db,
+                              apr_int64_t cache_size,
+                              apr_int64_t mmap_size,
+                              apr_pool_t *scratch_pool)
+{
+  /* Negative cache sizes are in KiB instead of pages. */
+  if (cache_size > 0)
+    SVN_ERR(exec_sql(db, apr_psprintf(scratch_pool,
+                                      "PRAGMA cache_size = -%" APR_INT64_T_FMT
+                                      ";",
+                                      (cache_size + 1023) / 1024)));
+
+  if (mmap_size > 0)
+    SVN_ERR(exec_sql(db, apr_psprintf(scratch_pool,
+                                      "PRAGMA mmap_size = %" APR_INT64_T_FMT
+                                      ";",
+                                      mmap_size)));
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_sqlite__close(svn_sqlite__db_t *db)
 {
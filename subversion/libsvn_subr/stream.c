@@ -62,6 +62,7 @@ struct svn_stream_t {
   svn_stream_seek_fn_t seek_fn;
   svn_stream_data_available_fn_t data_available_fn;
   svn_stream_readline_fn_t readline_fn;
+  svn_stream__read_buffer_fn_t read_buffer_fn;
   apr_file_t *file; /* Maybe NULL */
 };
 
@@ -145,6 +146,13 @@ svn_stream_set_readline(svn_stream_t *stream,
   stream->readline_fn = readline_fn;
 }
 
+void
+svn_stream__set_read_buffer(svn_stream_t *stream,
+                            svn_stream__read_buffer_fn_t read_buffer_fn)
+{
+  stream->read_buffer_fn = read_buffer_fn;
+}
+
 /* Standard implementation for svn_stream_read_full() based on
    multiple svn_stream_read2() calls (in separate function to make
    it more likely for svn_stream_read_full to be inlined) */
@@ -194,6 +202,21 @@ svn_stream_read_full(svn_stream_t *stream, char *buffer, apr_size_t *len)
   return svn_error_trace(stream->read_full_fn(stream->baton, buffer, len));
 }
 
+svn_error_t *
+svn_stream__read_buffer(svn_stream_t *stream,
+                        const char **data,
+                        apr_size_t *len,
+                        char *buffer)
+{
+  if (stream->read_buffer_fn == NULL)
+    {
+      *data = buffer;
+      return svn_error_trace(svn_stream_read_full(stream, buffer, len));
+    }
+
+  return svn_error_trace(stream->read_buffer_fn(stream->baton, data, len));
+}
+
 svn_error_t *
 svn_stream_skip(svn_stream_t *stream, apr_size_t len)
 {
@@ -402,16 +425,21 @@ svn_error_t *svn_stream_copy3(svn_stream_t *from, svn_stream_t *to,
                               void *cancel_baton,
                               apr_pool_t *scratch_pool)
 {
-  char *buf = apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
+  /* Streams that hand out their internal buffers don't need ours. */
+  char *buf = from->read_buffer_fn
+            ? NULL
+            : apr_palloc(scratch_pool, SVN__STREAM_CHUNK_SIZE);
   svn_error_t *err;
   svn_error_t *err2;
 
   /* Read and write chunks until we get a short read, indicating the
      end of the stream.  (We can't get a short write without an
-     associated error.) */
+     associated error.)  Buffer-passing streams may return short reads
+     at any time and signal EOF with an empty one. */
   while (1)
     {
       apr_size_t len = SVN__STREAM_CHUNK_SIZE;
+      const char *data;
 
       if (cancel_func)
         {
@@ -420,14 +448,15 @@ svn_error_t *svn_stream_copy3(svn_stream_t *from, svn_stream_t *to,
              break;
         }
 
-      err = svn_stream_read_full(from, buf, &len);
+      err = svn_stream__read_buffer(from, &data, &len, buf);
       if (err)
          break;
 
       if (len > 0)
-        err = svn_stream_write(to, buf, &len);
+        err = svn_stream_write(to, data, &len);
 
-      if (err || (len != SVN__STREAM_CHUNK_SIZE))
+      if (err || len == 0
+          || (len != SVN__STREAM_CHUNK_SIZE && !from->read_buffer_fn))
           break;
     }
 
@@ -613,6 +642,13 @@ read_full_handler_disown(void *baton, char *buffer, apr_size_t *len)
   return svn_error_trace(svn_stream_read_full(baton, buffer, len));
 }
 
+static svn_error_t *
+read_buffer_handler_disown(void *baton, const char **data, apr_size_t *len)
+{
+  svn_stream_t *stream = baton;
+  return svn_error_trace(stream->read_buffer_fn(stream->baton, data, len));
+}
+
 static svn_error_t *
 skip_handler_disown(void *baton, apr_size_t len)
 {
@@ -666,6 +702,8 @@ svn_stream_disown(svn_stream_t *stream, apr_pool_t *pool)
   svn_stream_set_seek(s, seek_handler_disown);
   svn_stream_set_data_available(s, data_available_disown);
   svn_stream_set_readline(s, readline_handler_disown);
+  if (stream->read_buffer_fn)
+    svn_stream__set_read_buffer(s, read_buffer_handler_disown);
 
   return s;
 }
@@ -1405,6 +1443,23 @@ read_full_handler_checksum(void *baton, char *buffer, apr_size_t *len)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+read_buffer_handler_checksum(void *baton, const char **data, apr_size_t *len)
+{
+  struct checksum_stream_baton *btn = baton;
+  svn_stream_t *proxy = btn->proxy;
+
+  SVN_ERR(proxy->read_buffer_fn(proxy->baton, data, len));
+
+  if (btn->read_checksum)
+    SVN_ERR(svn_checksum_update(btn->read_ctx, *data, *len));
+
+  if (*len == 0)
+    btn->read_more = FALSE;
+
+  return SVN_NO_ERROR;
+}
+
 
 static svn_error_t *
 write_handler_checksum(void *baton, const char *buffer, apr_size_t *len)
@@ -1518,6 +1573,104 @@ svn_stream_checksummed2(svn_stream_t *stream,
   svn_stream_set_close(s, close_handler_checksum);
   if (svn_stream_supports_reset(stream))
     svn_stream_set_seek(s, seek_handler_checksum);
+  if (stream->read_buffer_fn)
+    svn_stream__set_read_buffer(s, read_buffer_handler_checksum);
+  return s;
+}
+
+/* Baton for the stream returned by svn_stream__checksummed_md5_sha1(). */
+typedef struct md5_sha1_stream_baton_t
+{
+  /* Calculates the checksums requested by the caller. */
+  svn_checksum__multi_ctx_t *ctx;
+
+  /* Output values, in the order of the checksum kinds in CTX. */
+  svn_checksum_t **outputs[2];
+  int count;
+
+  /* The stream that we wrap. */
+  svn_stream_t *proxy;
+
+  /* Pool to allocate the output values from. */
+  apr_pool_t *pool;
+} md5_sha1_stream_baton_t;
+
+/* Implements svn_write_fn_t for md5_sha1_stream_baton_t BATON. */
+static svn_error_t *
+write_handler_md5_sha1(void *baton, const char *buffer, apr_size_t *len)
+{
+  md5_sha1_stream_baton_t *btn = baton;
+
+  SVN_ERR(svn_checksum__multi_update(btn->ctx, buffer, *len));
+
+  return svn_error_trace(svn_stream_write(btn->proxy, buffer, len));
+}
+
+/* Implements svn_close_fn_t for md5_sha1_stream_baton_t BATON. */
+static svn_error_t *
+close_handler_md5_sha1(void *baton)
+{
+  md5_sha1_stream_baton_t *btn = baton;
+  svn_checksum_t *checksums[2];
+  int i;
+
+  SVN_ERR(svn_checksum__multi_final(checksums, btn->ctx, btn->pool));
+  for (i = 0; i < btn->count; ++i)
+    *btn->outputs[i] = checksums[i];
+
+  return svn_error_trace(svn_stream_close(btn->proxy));
+}
+
+/* Implements svn_stream_seek_fn_t for md5_sha1_stream_baton_t BATON.
+ * Only reset is supported. */
+static svn_error_t *
+seek_handler_md5_sha1(void *baton, const svn_stream_mark_t *mark)
+{
+  md5_sha1_stream_baton_t *btn = baton;
+
+  if (mark)
+    return svn_error_create(SVN_ERR_STREAM_SEEK_NOT_SUPPORTED, NULL, NULL);
+
+  SVN_ERR(svn_checksum__multi_ctx_reset(btn->ctx));
+  return svn_error_trace(svn_stream_reset(btn->proxy));
+}
+
+svn_stream_t *
+svn_stream__checksummed_md5_sha1(svn_stream_t *stream,
+                                 svn_checksum_t **md5_checksum,
+                                 svn_checksum_t **sha1_checksum,
+                                 apr_pool_t *pool)
+{
+  svn_checksum_kind_t kinds[2];
+  md5_sha1_stream_baton_t *baton;
+  svn_stream_t *s;
+
+  if (md5_checksum == NULL && sha1_checksum == NULL)
+    return stream;
+
+  baton = apr_palloc(pool, sizeof(*baton));
+  baton->count = 0;
+  if (md5_checksum)
+    {
+      kinds[baton->count] = svn_checksum_md5;
+      baton->outputs[baton->count++] = md5_checksum;
+    }
+  if (sha1_checksum)
+    {
+      kinds[baton->count] = svn_checksum_sha1;
+      baton->outputs[baton->count++] = sha1_checksum;
+    }
+
+  baton->ctx = svn_checksum__multi_ctx_create(kinds, baton->count, pool);
+  baton->proxy = stream;
+  baton->pool = pool;
+
+  s = svn_stream_create(baton, pool);
+  svn_stream_set_write(s, write_handler_md5_sha1);
+  svn_stream_set_close(s, close_handler_md5_sha1);
+  if (svn_stream_supports_reset(stream))
+    svn_stream_set_seek(s, seek_handler_md5_sha1);
+
   return s;
 }
 
@@ -1633,6 +1786,19 @@ read_handler_stringbuf(void *baton, char *buffer, apr_size_t *len)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+read_buffer_handler_stringbuf(void *baton, const char **data,
+                              apr_size_t *len)
+{
+  struct stringbuf_stream_baton *btn = baton;
+  apr_size_t left_to_read = btn->str->len - btn->amt_read;
+
+  *len = (*len > left_to_read) ? left_to_read : *len;
+  *data = btn->str->data + btn->amt_read;
+  btn->amt_read += *len;
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 skip_handler_stringbuf(void *baton, apr_size_t len)
 {
@@ -1746,6 +1912,7 @@ svn_stream_from_stringbuf(svn_stringbuf_t *str,
   svn_stream_set_seek(stream, seek_handler_stringbuf);
   svn_stream_set_data_available(stream, data_available_handler_stringbuf);
   svn_stream_set_readline(stream, readline_handler_stringbuf);
+  svn_stream__set_read_buffer(stream, read_buffer_handler_stringbuf);
   return stream;
 }
 
@@ -1772,6 +1939,18 @@ read_handler_string(void *baton, char *buffer, apr_size_t *len)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+read_buffer_handler_string(void *baton, const char **data, apr_size_t *len)
+{
+  struct string_stream_baton *btn = baton;
+  apr_size_t left_to_read = btn->str->len - btn->amt_read;
+
+  *len = (*len > left_to_read) ? left_to_read : *len;
+  *data = btn->str->data + btn->amt_read;
+  btn->amt_read += *len;
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 mark_handler_string(void *baton, svn_stream_mark_t **mark, apr_pool_t *pool)
 {
@@ -1875,6 +2054,7 @@ svn_stream_from_string(const svn_string_t *str,
   svn_stream_set_skip(stream, skip_handler_string);
   svn_stream_set_data_available(stream, data_available_handler_string);
   svn_stream_set_readline(stream, readline_handler_string);
+  svn_stream__set_read_buffer(stream, read_buffer_handler_string);
   return stream;
 }
 
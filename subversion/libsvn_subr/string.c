@@ -37,6 +37,13 @@
 
 #include "svn_private_config.h"
 
+/* Use SSE2 to compare strings 16 bytes at a time.  SSE2 is part of the
+ * x86-64 base ISA, so there is no need for a runtime check. */
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define SVN_STRING__USE_SSE2 1
+#endif
+
 
 
 /* Allocate the space for a memory buffer from POOL.
@@ -939,6 +946,129 @@ svn_boolean_t svn_cstring_match_glob_list(const char *str,
   return FALSE;
 }
 
+struct svn_cstring__glob_list_t
+{
+  /* Set if any pattern matches every string, e.g. "*". */
+  svn_boolean_t match_all;
+
+  /* The patterns without wildcards. */
+  apr_hash_t *literals;
+
+  /* The literal SUFFIXes of "*SUFFIX" patterns and the PREFIXes of
+     "PREFIX*" patterns, with the distinct apr_size_t lengths of each. */
+  apr_hash_t *suffixes;
+  apr_array_header_t *suffix_lengths;
+  apr_hash_t *prefixes;
+  apr_array_header_t *prefix_lengths;
+
+  /* The const char * patterns that need apr_fnmatch(). */
+  apr_array_header_t *others;
+};
+
+/* Return TRUE if the LEN bytes at S contain characters that are special
+   to apr_fnmatch(). */
+static svn_boolean_t
+has_glob_chars(const char *s, apr_size_t len)
+{
+  apr_size_t i;
+
+  for (i = 0; i < len; i++)
+    if (s[i] == '*' || s[i] == '?' || s[i] == '[' || s[i] == '\\')
+      return TRUE;
+
+  return FALSE;
+}
+
+/* Add the LEN bytes at KEY to HASH and LEN to the distinct LENGTHS. */
+static void
+add_affix(apr_hash_t *hash,
+          apr_array_header_t *lengths,
+          const char *key,
+          apr_size_t len)
+{
+  int i;
+
+  apr_hash_set(hash, apr_pstrmemdup(lengths->pool, key, len), len, "");
+
+  for (i = 0; i < lengths->nelts; i++)
+    if (APR_ARRAY_IDX(lengths, i, apr_size_t) == len)
+      return;
+
+  APR_ARRAY_PUSH(lengths, apr_size_t) = len;
+}
+
+svn_cstring__glob_list_t *
+svn_cstring__glob_list_create(const apr_array_header_t *patterns,
+                              apr_pool_t *result_pool)
+{
+  svn_cstring__glob_list_t *list = apr_pcalloc(result_pool, sizeof(*list));
+  int i;
+
+  list->literals = apr_hash_make(result_pool);
+  list->suffixes = apr_hash_make(result_pool);
+  list->suffix_lengths = apr_array_make(result_pool, 4, sizeof(apr_size_t));
+  list->prefixes = apr_hash_make(result_pool);
+  list->prefix_lengths = apr_array_make(result_pool, 4, sizeof(apr_size_t));
+  list->others = apr_array_make(result_pool, 0, sizeof(const char *));
+
+  for (i = 0; i < patterns->nelts; i++)
+    {
+      const char *pattern = APR_ARRAY_IDX(patterns, i, const char *);
+      apr_size_t len = strlen(pattern);
+
+      if (!has_glob_chars(pattern, len))
+        apr_hash_set(list->literals, apr_pstrmemdup(result_pool, pattern, len),
+                     len, "");
+      else if (strspn(pattern, "*") == len)
+        list->match_all = TRUE;
+      else if (pattern[0] == '*' && !has_glob_chars(pattern + 1, len - 1))
+        add_affix(list->suffixes, list->suffix_lengths, pattern + 1, len - 1);
+      else if (pattern[len - 1] == '*' && !has_glob_chars(pattern, len - 1))
+        add_affix(list->prefixes, list->prefix_lengths, pattern, len - 1);
+      else
+        APR_ARRAY_PUSH(list->others, const char *)
+          = apr_pstrmemdup(result_pool, pattern, len);
+    }
+
+  return list;
+}
+
+svn_boolean_t
+svn_cstring__glob_list_match(const svn_cstring__glob_list_t *list,
+                             const char *str)
+{
+  apr_size_t len = strlen(str);
+  int i;
+
+  if (list->match_all)
+    return TRUE;
+
+  if (apr_hash_get(list->literals, str, len))
+    return TRUE;
+
+  for (i = 0; i < list->suffix_lengths->nelts; i++)
+    {
+      apr_size_t suffix_len = APR_ARRAY_IDX(list->suffix_lengths, i,
+                                            apr_size_t);
+
+      if (suffix_len <= len
+          && apr_hash_get(list->suffixes, str + len - suffix_len, suffix_len))
+        return TRUE;
+    }
+
+  for (i = 0; i < list->prefix_lengths->nelts; i++)
+    {
+      apr_size_t prefix_len = APR_ARRAY_IDX(list->prefix_lengths, i,
+                                            apr_size_t);
+
+      if (prefix_len <= len
+          && apr_hash_get(list->prefixes, str, prefix_len))
+        return TRUE;
+    }
+
+  return svn_cstring_match_glob_list(str, list->others);
+}
+
 svn_boolean_t
 svn_cstring_match_list(const char *str, const apr_array_header_t *list)
 {
@@ -1508,6 +1638,23 @@ svn_cstring__match_length(const char *a,
 {
   apr_size_t pos = 0;
 
+#ifdef SVN_STRING__USE_SSE2
+
+  /* Compare 16 bytes at a time.  The comparison mask tells us directly
+   * where the first mismatch is. */
+  for (; max_len - pos >= sizeof(__m128i); pos += sizeof(__m128i))
+    {
+      __m128i va = _mm_loadu_si128((const __m128i *)(a + pos));
+      __m128i vb = _mm_loadu_si128((const __m128i *)(b + pos));
+      unsigned int mismatch
+        = _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) ^ 0xffff;
+
+      if (mismatch)
+        return pos + __builtin_ctz(mismatch);
+    }
+
+#endif
+
 #if SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Chunky processing is so much faster ...
@@ -1536,6 +1683,25 @@ svn_cstring__reverse_match_length(const char *a,
 {
   apr_size_t pos = 0;
 
+#ifdef SVN_STRING__USE_SSE2
+
+  /* Compare 16 bytes at a time.  The highest bit in the comparison mask
+   * marks the mismatch closest to the end of the strings. */
+  for (pos = sizeof(__m128i); pos <= max_len; pos += sizeof(__m128i))
+    {
+      __m128i va = _mm_loadu_si128((const __m128i *)(a - pos));
+      __m128i vb = _mm_loadu_si128((const __m128i *)(b - pos));
+      unsigned int mismatch
+        = _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) ^ 0xffff;
+
+      if (mismatch)
+        return pos - 32 + __builtin_clz(mismatch);
+    }
+
+  pos -= sizeof(__m128i);
+
+#endif
+
 #if SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Chunky processing is so much faster ...
@@ -1544,7 +1710,7 @@ svn_cstring__reverse_match_length(const char *a,
    * because A and B will probably have different alignment. So, skipping
    * the first few chars until alignment is reached is not an option.
    */
-  for (pos = sizeof(apr_size_t); pos <= max_len; pos += sizeof(apr_size_t))
+  for (pos += sizeof(apr_size_t); pos <= max_len; pos += sizeof(apr_size_t))
     if (*(const apr_size_t*)(a - pos) != *(const apr_size_t*)(b - pos))
       break;
 
@@ -52,6 +52,14 @@
 #include "private/svn_string_private.h"
 #include "private/svn_eol_private.h"
 
+/* Use SSE2 to scan for interesting characters 32 bytes at a time.  SSE2
+ * is part of the x86-64 base ISA, so there is no need for a runtime
+ * check. */
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define SVN_SUBST__USE_SSE2 1
+#endif
+
 /**
  * The textual elements of a detranslated special file.  One of these
  * strings must appear as the first element of any special file as it
@@ -950,6 +958,63 @@ create_translation_baton(const char *eol_str,
   return b;
 }
 
+/* Return the position of the first character in the range START to END
+ * that is interesting to B or END if there is none.
+ */
+static const char *
+find_interesting(const struct translation_baton *b,
+                 const char *start,
+                 const char *end)
+{
+  const char *interesting = b->interesting;
+
+#ifdef SVN_SUBST__USE_SSE2
+
+  /* Repeat one of the other characters for those that B doesn't care
+     about. */
+  const __m128i cr = _mm_set1_epi8(b->eol_str ? '\r' : '$');
+  const __m128i lf = _mm_set1_epi8(b->eol_str ? '\n' : '$');
+  const __m128i dollar = _mm_set1_epi8(b->keywords ? '$' : '\n');
+
+  if (!b->eol_str && !b->keywords)
+    return end;
+
+  for (; end - start >= 2 * (apr_ssize_t)sizeof(__m128i);
+       start += 2 * sizeof(__m128i))
+    {
+      __m128i lo = _mm_loadu_si128((const __m128i *)start);
+      __m128i hi = _mm_loadu_si128((const __m128i *)start + 1);
+      unsigned int mask_lo
+        = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(lo, cr),
+                                                      _mm_cmpeq_epi8(lo, lf)),
+                                         _mm_cmpeq_epi8(lo, dollar)));
+      unsigned int mask_hi
+        = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(hi, cr),
+                                                      _mm_cmpeq_epi8(hi, lf)),
+                                         _mm_cmpeq_epi8(hi, dollar)));
+      if (mask_lo | mask_hi)
+        return start + __builtin_ctz(mask_lo | (mask_hi << 16));
+    }
+
+#else
+
+  /* Check 4 bytes at once to allow for efficient pipelining
+     and to reduce loop condition overhead. */
+  for (; end - start >= 4; start += 4)
+    if (interesting[(unsigned char)start[0]]
+        || interesting[(unsigned char)start[1]]
+        || interesting[(unsigned char)start[2]]
+        || interesting[(unsigned char)start[3]])
+      break;
+
+#endif
+
+  while (start < end && !interesting[(unsigned char)*start])
+    ++start;
+
+  return start;
+}
+
 /* Return TRUE if the EOL starting at BUF matches the eol_str member of B.
  * Be aware of special cases like "\n\r\n" and "\n\n\r". For sequences like
  * "\n$" (an EOL followed by a keyword), the result will be FALSE since it is
@@ -1126,24 +1191,7 @@ translate_chunk(svn_stream_t *dst,
 
               if (b->keywords)
                 {
-                  /* Check 4 bytes at once to allow for efficient pipelining
-                    and to reduce loop condition overhead. */
-                  while ((end - p) >= (len + 4))
-                    {
-                      if (interesting[(unsigned char)p[len]]
-                          || interesting[(unsigned char)p[len+1]]
-                          || interesting[(unsigned char)p[len+2]]
-                          || interesting[(unsigned char)p[len+3]])
-                        break;
-
-                      len += 4;
-                    }
-
-                  /* Found an interesting char or EOF in the next 4 bytes.
-                     Find its exact position. */
-                  while ((p + len) < end
-                         && !interesting[(unsigned char)p[len]])
-                    ++len;
+                  len = find_interesting(b, p + len, end) - p;
                 }
               else
                 {
@@ -1161,8 +1209,8 @@ translate_chunk(svn_stream_t *dst,
                  (end - p) > (len + 2) &&     /* not too close to EOF */
                  eol_unchanged(b, p + len));  /* EOL format already ok */
 
-          while ((p + len) < end && !interesting[(unsigned char)p[len]])
-            len++;
+          if ((p + len) < end && !interesting[(unsigned char)p[len]])
+            len = find_interesting(b, p + len, end) - p;
 
           if (len)
             {
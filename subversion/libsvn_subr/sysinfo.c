@@ -191,6 +191,15 @@ svn_sysinfo__linked_libs(apr_pool_t *pool)
                                       (lz4_version / 100) % 100,
                                       lz4_version % 100);
 
+  if (svn_zstd__is_available())
+    {
+      lib = &APR_ARRAY_PUSH(array, svn_version_ext_linked_lib_t);
+      lib->name = "Zstandard";
+      lib->compiled_version = apr_pstrdup(pool,
+                                          svn_zstd__compiled_version());
+      lib->runtime_version = apr_pstrdup(pool, svn_zstd__runtime_version());
+    }
+
   return array;
 }
 
@@ -0,0 +1,454 @@
+/* trace.c : spans for following operations across processes
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <apr_file_io.h>
+#include <apr_strings.h>
+#include <apr_time.h>
+#include <apr_uuid.h>
+
+#if APR_HAS_THREADS
+#include <apr_thread_proc.h>
+#endif
+
+#include "svn_pools.h"
+#include "svn_io.h"
+
+#include "private/svn_atomic.h"
+#include "private/svn_trace.h"
+
+#include "svn_private_config.h"
+
+#ifdef WIN32
+#include <process.h>  /* For _getpid() */
+#elif defined(HAVE_UNISTD_H)
+#include <unistd.h>   /* For getpid() */
+#endif
+
+/* Maximum length of a single record in the trace file.  Longer labels
+ * get truncated. */
+#define MAX_RECORD_LEN 512
+
+/* Tracing state of a single thread. */
+typedef struct thread_state_t
+{
+  /* The innermost span that has not ended yet.  May be NULL. */
+  svn_trace__span_t *active;
+
+  /* Set by svn_trace__continue().  If TRUE, new root spans become
+   * children of REMOTE_PARENT_ID in trace REMOTE_TRACE_ID. */
+  svn_boolean_t has_remote;
+  apr_uint64_t remote_trace_id[2];
+  apr_uint64_t remote_parent_id;
+} thread_state_t;
+
+struct svn_trace__span_t
+{
+  /* IDs of this span, its trace and its parent.  PARENT_ID is 0 for
+   * root spans. */
+  apr_uint64_t trace_id[2];
+  apr_uint64_t span_id;
+  apr_uint64_t parent_id;
+
+  /* What this span covers. */
+  const char *category;
+  const char *label;
+
+  /* When this span began. */
+  apr_time_t start;
+
+  /* The span that was active when this one began.  May be NULL. */
+  svn_trace__span_t *previous;
+
+  /* The thread that began this span. */
+  thread_state_t *state;
+
+  /* The pool that ends this span when it gets cleaned up. */
+  apr_pool_t *pool;
+};
+
+/* Non-zero once svn_trace__enable() has been called. */
+static volatile svn_atomic_t trace_enabled = 0;
+
+/* Initialization state of the globals below. */
+static volatile svn_atomic_t trace_status = 0;
+
+/* Global pool holding TRACE_FILE and STATE_KEY. */
+static apr_pool_t *trace_pool = NULL;
+
+/* The file that we append our records to. */
+static apr_file_t *trace_file = NULL;
+
+/* Random bits that make our IDs differ from those of other processes. */
+static apr_uint64_t id_salt[2] = { 0, 0 };
+
+/* Number of IDs handed out so far. */
+static volatile svn_atomic_t id_counter = 0;
+
+#if APR_HAS_THREADS
+/* Per-thread thread_state_t, allocated on first use. */
+static apr_threadkey_t *state_key = NULL;
+#else
+/* The thread_state_t of our only thread. */
+static thread_state_t single_state = { 0 };
+#endif
+
+/* Return the ID of the current process.  Other processes may have been
+ * forked from this one after initialization, so we can't cache it. */
+static apr_uint64_t
+current_pid(void)
+{
+#ifdef WIN32
+  return (apr_uint64_t)_getpid();
+#elif defined(HAVE_UNISTD_H)
+  return (apr_uint64_t)getpid();
+#else
+  return 0;
+#endif
+}
+
+/* Free the thread_state_t DATA.  Destructor for STATE_KEY. */
+static void
+free_state(void *data)
+{
+  free(data);
+}
+
+/* svn_atomic__err_init_func_t implementation that initializes the
+ * globals and opens the trace file at BATON.  Use POOL for temporaries.
+ */
+static svn_error_t *
+init_trace(void *baton,
+           apr_pool_t *pool)
+{
+  const char *path = baton;
+  apr_uuid_t uuid;
+
+  /* The trace lives for the rest of the process, so it needs a
+   * global pool. */
+  trace_pool = svn_pool_create(NULL);
+  SVN_ERR(svn_io_file_open(&trace_file, path,
+                           APR_WRITE | APR_CREATE | APR_APPEND,
+                           APR_OS_DEFAULT, trace_pool));
+
+#if APR_HAS_THREADS
+  {
+    apr_status_t status = apr_threadkey_private_create(&state_key,
+                                                       free_state,
+                                                       trace_pool);
+    if (status)
+      return svn_error_wrap_apr(status, _("Can't create trace state key"));
+  }
+#endif
+
+  /* Version 4 UUIDs are as random as it gets without extra
+   * dependencies. */
+  apr_uuid_get(&uuid);
+  memcpy(id_salt, uuid.data, sizeof(id_salt));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_trace__enable(const char *path,
+                  apr_pool_t *scratch_pool)
+{
+  SVN_ERR(svn_atomic__init_once(&trace_status, init_trace, (void *)path,
+                                scratch_pool));
+  svn_atomic_set(&trace_enabled, 1);
+
+  return SVN_NO_ERROR;
+}
+
+svn_boolean_t
+svn_trace__enabled(void)
+{
+  return svn_atomic_read(&trace_enabled) != 0;
+}
+
+/* Return the tracing state of the current thread or NULL, if it can't
+ * be allocated.  Tracing must be enabled. */
+static thread_state_t *
+get_state(void)
+{
+#if APR_HAS_THREADS
+  void *state = NULL;
+
+  apr_threadkey_private_get(&state, state_key);
+  if (!state)
+    {
+      state = calloc(1, sizeof(thread_state_t));
+      if (state && apr_threadkey_private_set(state, state_key))
+        {
+          free(state);
+          state = NULL;
+        }
+    }
+
+  return state;
+#else
+  return &single_state;
+#endif
+}
+
+/* Return a new, non-zero ID that is unique within this process and very
+ * likely unique across all processes.  SALT selects the half of ID_SALT
+ * to use. */
+static apr_uint64_t
+new_id(int salt)
+{
+  apr_uint64_t counter = (apr_uint64_t)svn_atomic_inc(&id_counter) + 1;
+  apr_uint64_t id = id_salt[salt]
+                  ^ (current_pid() << 32)
+                  ^ (counter * APR_UINT64_C(0x9e3779b97f4a7c15));
+
+  return id ? id : 1;
+}
+
+/* Write the 16 lower-case hex digits of VALUE to DEST. */
+static void
+write_hex(char *dest,
+          apr_uint64_t value)
+{
+  static const char digits[] = "0123456789abcdef";
+  int i;
+
+  for (i = 15; i >= 0; --i, value >>= 4)
+    dest[i] = digits[value & 0xf];
+}
+
+/* Parse the 16 hex digits at SOURCE into *VALUE.  Return FALSE if SOURCE
+ * does not start with 16 lower-case hex digits. */
+static svn_boolean_t
+parse_hex(apr_uint64_t *value,
+          const char *source)
+{
+  int i;
+
+  *value = 0;
+  for (i = 0; i < 16; ++i)
+    {
+      char c = source[i];
+      if (c >= '0' && c <= '9')
+        *value = (*value << 4) + (c - '0');
+      else if (c >= 'a' && c <= 'f')
+        *value = (*value << 4) + (c - 'a' + 10);
+      else
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Copy SOURCE to DEST of size DEST_SIZE, replacing everything that would
+ * need escaping in JSON.  Truncate if necessary. */
+static void
+copy_name(char *dest,
+          apr_size_t dest_size,
+          const char *source)
+{
+  apr_size_t i;
+
+  for (i = 0; source[i] && i + 1 < dest_size; ++i)
+    {
+      char c = source[i];
+      dest[i] = (c < ' ' || c > '~' || c == '"' || c == '\\') ? '?' : c;
+    }
+
+  dest[i] = '\0';
+}
+
+/* Append the record for SPAN, which ended at END, to the trace file. */
+static void
+write_record(const svn_trace__span_t *span,
+             apr_time_t end)
+{
+  char trace_id[33];
+  char span_id[17];
+  char parent_id[17] = "";
+  char category[64];
+  char label[256];
+  char record[MAX_RECORD_LEN];
+  int len;
+
+  write_hex(trace_id, span->trace_id[0]);
+  write_hex(trace_id + 16, span->trace_id[1]);
+  trace_id[32] = '\0';
+  write_hex(span_id, span->span_id);
+  span_id[16] = '\0';
+  if (span->parent_id)
+    {
+      write_hex(parent_id, span->parent_id);
+      parent_id[16] = '\0';
+    }
+
+  copy_name(category, sizeof(category), span->category);
+  copy_name(label, sizeof(label), span->label);
+
+  len = apr_snprintf(record, sizeof(record),
+                     "{\"trace_id\":\"%s\",\"span_id\":\"%s\","
+                     "\"parent_id\":\"%s\",\"pid\":%" APR_UINT64_T_FMT ","
+                     "\"component\":\"%s\",\"name\":\"%s\","
+                     "\"start_us\":%" APR_INT64_T_FMT ","
+                     "\"duration_us\":%" APR_INT64_T_FMT "}\n",
+                     trace_id, span_id, parent_id, current_pid(),
+                     category, label, (apr_int64_t)span->start,
+                     (apr_int64_t)(end - span->start));
+
+  /* Losing a record is preferable to failing the operation. */
+  if (len > 0)
+    apr_file_write_full(trace_file, record, len, NULL);
+}
+
+/* Record the span BATON and make its predecessor the active span again.
+ * Implements the cleanup function for svn_trace__span_t.pool. */
+static apr_status_t
+end_span(void *baton)
+{
+  svn_trace__span_t *span = baton;
+
+  write_record(span, apr_time_now());
+
+  /* Spans ended out of order must not re-activate ended spans. */
+  if (span->state->active == span)
+    span->state->active = span->previous;
+
+  return APR_SUCCESS;
+}
+
+svn_trace__span_t *
+svn_trace__begin(const char *category,
+                 const char *label,
+                 apr_pool_t *pool)
+{
+  thread_state_t *state;
+  svn_trace__span_t *span;
+
+  if (!svn_trace__enabled())
+    return NULL;
+
+  state = get_state();
+  if (!state)
+    return NULL;
+
+  span = apr_pcalloc(pool, sizeof(*span));
+  span->category = category;
+  span->label = label;
+  span->state = state;
+  span->pool = pool;
+  span->previous = state->active;
+  span->span_id = new_id(1);
+
+  if (state->active)
+    {
+      span->trace_id[0] = state->active->trace_id[0];
+      span->trace_id[1] = state->active->trace_id[1];
+      span->parent_id = state->active->span_id;
+    }
+  else if (state->has_remote)
+    {
+      span->trace_id[0] = state->remote_trace_id[0];
+      span->trace_id[1] = state->remote_trace_id[1];
+      span->parent_id = state->remote_parent_id;
+    }
+  else
+    {
+      span->trace_id[0] = new_id(0);
+      span->trace_id[1] = new_id(1);
+    }
+
+  state->active = span;
+  apr_pool_cleanup_register(pool, span, end_span, apr_pool_cleanup_null);
+  span->start = apr_time_now();
+
+  return span;
+}
+
+void
+svn_trace__end(svn_trace__span_t *span)
+{
+  if (span)
+    apr_pool_cleanup_run(span->pool, span, end_span);
+}
+
+const char *
+svn_trace__traceparent(apr_pool_t *result_pool)
+{
+  thread_state_t *state;
+  char *result;
+
+  if (!svn_trace__enabled())
+    return NULL;
+
+  state = get_state();
+  if (!state || !state->active)
+    return NULL;
+
+  /* "00-" TRACE_ID "-" SPAN_ID "-01", i.e. version 0 and sampled. */
+  result = apr_palloc(result_pool, SVN_TRACE__TRACEPARENT_SIZE);
+  memcpy(result, "00-", 3);
+  write_hex(result + 3, state->active->trace_id[0]);
+  write_hex(result + 19, state->active->trace_id[1]);
+  result[35] = '-';
+  write_hex(result + 36, state->active->span_id);
+  memcpy(result + 52, "-01", 4);
+
+  return result;
+}
+
+void
+svn_trace__continue(const char *traceparent)
+{
+  thread_state_t *state;
+  apr_uint64_t trace_id[2];
+  apr_uint64_t parent_id;
+
+  if (!svn_trace__enabled())
+    return;
+
+  state = get_state();
+  if (!state)
+    return;
+
+  /* Future versions may append fields, so don't insist on the length.
+   * Version 0xff is invalid and so are all-zero IDs. */
+  state->has_remote = FALSE;
+  if (   !traceparent
+      || strlen(traceparent) < SVN_TRACE__TRACEPARENT_SIZE - 1
+      || strncmp(traceparent, "ff", 2) == 0
+      || traceparent[2] != '-'
+      || traceparent[35] != '-'
+      || traceparent[52] != '-'
+      || !parse_hex(&trace_id[0], traceparent + 3)
+      || !parse_hex(&trace_id[1], traceparent + 19)
+      || !parse_hex(&parent_id, traceparent + 36)
+      || (trace_id[0] == 0 && trace_id[1] == 0)
+      || parent_id == 0)
+    return;
+
+  state->has_remote = TRUE;
+  state->remote_trace_id[0] = trace_id[0];
+  state->remote_trace_id[1] = trace_id[1];
+  state->remote_parent_id = parent_id;
+}
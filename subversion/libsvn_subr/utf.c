@@ -31,6 +31,7 @@
 #include <apr_lib.h>
 #include <apr_xlate.h>
 #include <apr_atomic.h>
+#include <apr_portable.h>
 
 #include "svn_hash.h"
 #include "svn_string.h"
@@ -59,6 +60,10 @@ static const char *SVN_APR_UTF8_CHARSET = "UTF-8";
 static svn_mutex__t *xlate_handle_mutex = NULL;
 static svn_boolean_t assume_native_charset_is_utf8 = FALSE;
 
+/* Whether svn_utf_initialize2() found the native encoding to be UTF-8.
+   Conversions between native and UTF-8 then reduce to validation. */
+static svn_boolean_t native_charset_is_utf8 = FALSE;
+
 #if defined(WIN32)
 typedef svn_subr__win32_xlate_t xlate_handle_t;
 #else
@@ -101,10 +106,20 @@ static apr_hash_t *xlate_handle_hash = NULL;
 static void * volatile xlat_ntou_static_handle = NULL;
 static void * volatile xlat_uton_static_handle = NULL;
 
+/* Likewise for all other conversions, e.g. those of
+ * svn_utf_cstring_to_utf8_ex2().  Each slot holds one unused handle node
+ * or NULL.  As the nodes live as long as XLATE_HANDLE_HASH, their
+ * conversion pages may be checked before taking them out of a slot.
+ */
+#define XLATE_SLOT_COUNT 4
+static void * volatile xlat_other_handles[XLATE_SLOT_COUNT] = { NULL };
+
 /* Clean up the xlate handle cache. */
 static apr_status_t
 xlate_cleanup(void *arg)
 {
+  int i;
+
   /* We set the cache variables to NULL so that translation works in other
      cleanup functions, even if it isn't cached then. */
   xlate_handle_hash = NULL;
@@ -112,6 +127,8 @@ xlate_cleanup(void *arg)
   /* ensure no stale objects get accessed */
   xlat_ntou_static_handle = NULL;
   xlat_uton_static_handle = NULL;
+  for (i = 0; i < XLATE_SLOT_COUNT; ++i)
+    xlat_other_handles[i] = NULL;
 
   return APR_SUCCESS;
 }
@@ -126,6 +143,22 @@ xlate_handle_node_cleanup(void *arg)
   return APR_SUCCESS;
 }
 
+/* Return TRUE if the encoding of the current locale is UTF-8.
+   Use POOL for temporary allocations. */
+static svn_boolean_t
+locale_charset_is_utf8(apr_pool_t *pool)
+{
+#ifdef WIN32
+  /* The win32 converters handle CP_ACP; don't second-guess them. */
+  return FALSE;
+#else
+  const char *charset = apr_os_locale_encoding(pool);
+
+  return charset && (svn_cstring_casecmp(charset, "UTF-8") == 0
+                     || svn_cstring_casecmp(charset, "UTF8") == 0);
+#endif
+}
+
 void
 svn_utf_initialize2(svn_boolean_t assume_native_utf8,
                     apr_pool_t *pool)
@@ -154,6 +187,11 @@ svn_utf_initialize2(svn_boolean_t assume_native_utf8,
 
     if (!assume_native_charset_is_utf8)
       assume_native_charset_is_utf8 = assume_native_utf8;
+
+    /* The locale has been set up by now; see svn_cmdline_init(). */
+    if (!native_charset_is_utf8)
+      native_charset_is_utf8 = assume_native_charset_is_utf8
+                               || locale_charset_is_utf8(pool);
 }
 
 /* Return a unique string key based on TOPAGE and FROMPAGE.  TOPAGE and
@@ -199,6 +237,35 @@ atomic_swap(void * volatile * mem, void *new_value)
 #endif
 }
 
+/* Atomically replace the content in *MEM with NEW_VALUE if it is
+ * CMP_VALUE and return the previous content of *MEM.
+ */
+static APR_INLINE void*
+atomic_cas(void * volatile * mem, void *new_value, void *cmp_value)
+{
+#if APR_HAS_THREADS
+   return svn_atomic_casptr(mem, new_value, cmp_value);
+#else
+   /* no threads - no sync. necessary */
+   void *old_value = (void*)*mem;
+   if (old_value == cmp_value)
+     *mem = new_value;
+   return old_value;
+#endif
+}
+
+/* Return TRUE if the code pages A and B, as passed to apr_xlate_open(),
+ * are the same. */
+static svn_boolean_t
+same_page(const char *a, const char *b)
+{
+  if (a == SVN_APR_LOCALE_CHARSET || b == SVN_APR_LOCALE_CHARSET
+      || a == SVN_APR_DEFAULT_CHARSET || b == SVN_APR_DEFAULT_CHARSET)
+    return a == b;
+
+  return strcmp(a, b) == 0;
+}
+
 /* Set *RET to a newly created handle node for converting from FROMPAGE
    to TOPAGE, If apr_xlate_open() returns APR_EINVAL or APR_ENOTIMPL, set
    (*RET)->handle to NULL.  If fail for any other reason, return the error.
@@ -355,6 +422,25 @@ get_xlate_handle_node(xlate_handle_node_t **ret,
             old_node = atomic_swap(&xlat_ntou_static_handle, NULL);
           else if (userdata_key == SVN_UTF_UTON_XLATE_HANDLE)
             old_node = atomic_swap(&xlat_uton_static_handle, NULL);
+          else
+            {
+              int i;
+
+              for (i = 0; i < XLATE_SLOT_COUNT; ++i)
+                {
+                  xlate_handle_node_t *node = xlat_other_handles[i];
+
+                  if (node && node->valid
+                      && same_page(node->topage, topage)
+                      && same_page(node->frompage, frompage)
+                      && atomic_cas(&xlat_other_handles[i], NULL, node)
+                           == node)
+                    {
+                      old_node = node;
+                      break;
+                    }
+                }
+            }
 
           if (old_node && old_node->valid)
             {
@@ -433,6 +519,14 @@ put_xlate_handle_node(xlate_handle_node_t *node,
         node = atomic_swap(&xlat_ntou_static_handle, node);
       else if (userdata_key == SVN_UTF_UTON_XLATE_HANDLE)
         node = atomic_swap(&xlat_uton_static_handle, node);
+      else
+        {
+          int i;
+
+          for (i = 0; i < XLATE_SLOT_COUNT; ++i)
+            if (atomic_cas(&xlat_other_handles[i], node, NULL) == NULL)
+              return SVN_NO_ERROR;
+        }
       if (node == NULL)
         return SVN_NO_ERROR;
 
@@ -684,6 +778,13 @@ svn_utf_stringbuf_to_utf8(svn_stringbuf_t **dest,
   xlate_handle_node_t *node;
   svn_error_t *err;
 
+  /* Native UTF-8 only needs validation. */
+  if (native_charset_is_utf8 && svn_utf__is_valid(src->data, src->len))
+    {
+      *dest = svn_stringbuf_dup(src, pool);
+      return SVN_NO_ERROR;
+    }
+
   SVN_ERR(get_ntou_xlate_handle_node(&node, pool));
 
   if (node->handle)
@@ -716,6 +817,13 @@ svn_utf_string_to_utf8(const svn_string_t **dest,
   xlate_handle_node_t *node;
   svn_error_t *err;
 
+  /* Native UTF-8 only needs validation. */
+  if (native_charset_is_utf8 && svn_utf__is_valid(src->data, src->len))
+    {
+      *dest = svn_string_dup(src, pool);
+      return SVN_NO_ERROR;
+    }
+
   SVN_ERR(get_ntou_xlate_handle_node(&node, pool));
 
   if (node->handle)
@@ -776,6 +884,13 @@ svn_utf_cstring_to_utf8(const char **dest,
   xlate_handle_node_t *node;
   svn_error_t *err;
 
+  /* Native UTF-8 only needs validation. */
+  if (native_charset_is_utf8 && svn_utf__cstring_is_valid(src))
+    {
+      *dest = apr_pstrdup(pool, src);
+      return SVN_NO_ERROR;
+    }
+
   SVN_ERR(get_ntou_xlate_handle_node(&node, pool));
   err = convert_cstring(dest, src, node, pool);
   SVN_ERR(svn_error_compose_create(err,
@@ -803,9 +918,7 @@ svn_utf_cstring_to_utf8_ex2(const char **dest,
   err = convert_cstring(dest, src, node, pool);
   SVN_ERR(svn_error_compose_create(err,
                                    put_xlate_handle_node
-                                      (node,
-                                       SVN_UTF_NTOU_XLATE_HANDLE,
-                                       pool)));
+                                      (node, convset_key, pool)));
 
   return check_cstring_utf8(*dest, pool);
 }
@@ -830,6 +943,14 @@ svn_utf_stringbuf_from_utf8(svn_stringbuf_t **dest,
   xlate_handle_node_t *node;
   svn_error_t *err;
 
+  /* Native UTF-8 only needs validation. */
+  if (native_charset_is_utf8)
+    {
+      SVN_ERR(check_utf8(src->data, src->len, pool));
+      *dest = svn_stringbuf_dup(src, pool);
+      return SVN_NO_ERROR;
+    }
+
   SVN_ERR(get_uton_xlate_handle_node(&node, pool));
 
   if (node->handle)
@@ -861,6 +982,14 @@ svn_utf_string_from_utf8(const svn_string_t **dest,
   xlate_handle_node_t *node;
   svn_error_t *err;
 
+  /* Native UTF-8 only needs validation. */
+  if (native_charset_is_utf8)
+    {
+      SVN_ERR(check_utf8(src->data, src->len, pool));
+      *dest = svn_string_dup(src, pool);
+      return SVN_NO_ERROR;
+    }
+
   SVN_ERR(get_uton_xlate_handle_node(&node, pool));
 
   if (node->handle)
@@ -902,6 +1031,13 @@ svn_utf_cstring_from_utf8(const char **dest,
 
   SVN_ERR(check_cstring_utf8(src, pool));
 
+  /* Native UTF-8 only needs validation. */
+  if (native_charset_is_utf8)
+    {
+      *dest = apr_pstrdup(pool, src);
+      return SVN_NO_ERROR;
+    }
+
   SVN_ERR(get_uton_xlate_handle_node(&node, pool));
   err = convert_cstring(dest, src, node, pool);
   err = svn_error_compose_create(
@@ -996,6 +1132,14 @@ svn_utf_cstring_from_utf8_string(const char **dest,
   xlate_handle_node_t *node;
   svn_error_t *err;
 
+  /* Native UTF-8 only needs validation. */
+  if (native_charset_is_utf8)
+    {
+      SVN_ERR(check_utf8(src->data, src->len, pool));
+      *dest = apr_pstrmemdup(pool, src->data, src->len);
+      return SVN_NO_ERROR;
+    }
+
   SVN_ERR(get_uton_xlate_handle_node(&node, pool));
 
   if (node->handle)
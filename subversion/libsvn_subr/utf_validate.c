@@ -58,6 +58,13 @@
 
 #include "private/svn_utf_private.h"
 #include "private/svn_eol_private.h"
+
+/* Use SSE2 to skip over ASCII text 16 bytes at a time.  SSE2 is part of
+ * the x86-64 base ISA, so there is no need for a runtime check. */
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define SVN_UTF__USE_SSE2 1
+#endif
 #include "private/svn_dep_compat.h"
 
 /* Lookup table to categorise each octet in the string. */
@@ -258,7 +265,18 @@ static const char machine [9][14] = {
 static const char *
 first_non_fsm_start_char(const char *data, apr_size_t max_len)
 {
-#if SVN_UNALIGNED_ACCESS_IS_OK
+#ifdef SVN_UTF__USE_SSE2
+
+  /* The sign bits of all bytes are set for non-ASCII chars only. */
+  for (; max_len >= sizeof(__m128i)
+       ; data += sizeof(__m128i), max_len -= sizeof(__m128i))
+    {
+      int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)data));
+      if (mask)
+        return data + __builtin_ctz(mask);
+    }
+
+#elif SVN_UNALIGNED_ACCESS_IS_OK
 
   /* Scan the input one machine word at a time. */
   for (; max_len > sizeof(apr_uintptr_t)
@@ -290,7 +308,12 @@ svn_utf__last_valid(const char *data, apr_size_t len)
       int category = octet_category[octet];
       state = machine[state][category];
       if (state == FSM_START)
-        start = data;
+        {
+          /* Skip runs of ASCII following a multi-byte char quickly. */
+          if (data < end && (unsigned char)*data < 0x80)
+            data = first_non_fsm_start_char(data, end - data);
+          start = data;
+        }
     }
   return start;
 }
@@ -320,6 +343,8 @@ svn_utf__is_valid(const char *data, apr_size_t len)
       unsigned char octet = *data++;
       int category = octet_category[octet];
       state = machine[state][category];
+      if (state == FSM_START && data < end && (unsigned char)*data < 0x80)
+        data = first_non_fsm_start_char(data, end - data);
     }
   return state == FSM_START;
 }
@@ -309,6 +309,11 @@ svn_wc_restore2(svn_wc_context_t *wc_ctx,
    DEPTH_COMPATIBILITY_TRICK means the same thing here as it does
    in svn_wc_crawl_revisions6().
 
+   If BASE_DIRS is not NULL, it is the result of
+   svn_wc__db_base_get_descendants_info() for the root of the report,
+   and the BASE children of DIR_ABSPATH are looked up in it instead of
+   being read from the database.
+
    If RESTORE_FILES is set, then unexpectedly missing working files
    will be restored from text-base and NOTIFY_FUNC/NOTIFY_BATON
    will be called to report the restoration.  USE_COMMIT_TIMES is
@@ -321,6 +326,7 @@ report_revisions_and_depths(svn_wc__db_t *db,
                             const char *dir_repos_relpath,
                             const char *dir_repos_root,
                             svn_depth_t dir_depth,
+                            apr_hash_t *base_dirs,
                             const svn_ra_reporter3_t *reporter,
                             void *report_baton,
                             svn_boolean_t restore_files,
@@ -345,8 +351,17 @@ report_revisions_and_depths(svn_wc__db_t *db,
   /* Get both the SVN Entries and the actual on-disk entries.   Also
      notice that we're picking up hidden entries too (read_children never
      hides children). */
-  SVN_ERR(svn_wc__db_base_get_children_info(&base_children, db, dir_abspath,
-                                            scratch_pool, iterpool));
+  if (base_dirs)
+    {
+      base_children = svn_hash_gets(base_dirs, report_relpath);
+
+      if (!base_children)
+        base_children = apr_hash_make(scratch_pool);
+    }
+  else
+    SVN_ERR(svn_wc__db_base_get_children_info(&base_children, db,
+                                              dir_abspath,
+                                              scratch_pool, iterpool));
 
   if (restore_files)
     {
@@ -650,6 +665,7 @@ report_revisions_and_depths(svn_wc__db_t *db,
                                                   repos_relpath,
                                                   dir_repos_root,
                                                   ths->depth,
+                                                  base_dirs,
                                                   reporter, report_baton,
                                                   restore_files, depth,
                                                   honor_depth_exclude,
@@ -780,6 +796,21 @@ svn_wc_crawl_revisions6(svn_wc_context_t *wc_ctx,
     {
       if (depth != svn_depth_empty)
         {
+          apr_hash_t *base_dirs = NULL;
+
+          /* A recursive crawl visits every BASE directory, so obtain
+             them all with one ordered scan instead of a query per
+             directory. */
+          if (SVN_DEPTH_IS_RECURSIVE(depth))
+            {
+              err = svn_wc__db_base_get_descendants_info(&base_dirs, db,
+                                                         local_abspath,
+                                                         scratch_pool,
+                                                         scratch_pool);
+              if (err)
+                goto abort_report;
+            }
+
           /* Recursively crawl ROOT_DIRECTORY and report differing
              revisions. */
           err = report_revisions_and_depths(wc_ctx->db,
@@ -789,6 +820,7 @@ svn_wc_crawl_revisions6(svn_wc_context_t *wc_ctx,
                                             repos_relpath,
                                             repos_root_url,
                                             report_depth,
+                                            base_dirs,
                                             reporter, report_baton,
                                             restore_files, depth,
                                             honor_depth_exclude,
@@ -1033,6 +1065,7 @@ read_and_checksum_pristine_text(svn_stream_t **stream,
 typedef struct open_txdelta_stream_baton_t
 {
   svn_boolean_t need_reset;
+  svn_boolean_t track_source;
   svn_stream_t *base_stream;
   svn_stream_t *local_stream;
 } open_txdelta_stream_baton_t;
@@ -1054,8 +1087,8 @@ open_txdelta_stream(svn_txdelta_stream_t **txdelta_stream_p,
       SVN_ERR(svn_stream_reset(b->local_stream));
     }
 
-  svn_txdelta2(txdelta_stream_p, b->base_stream, b->local_stream,
-               FALSE, result_pool);
+  svn_txdelta3(txdelta_stream_p, b->base_stream, b->local_stream,
+               FALSE, b->track_source, result_pool);
   b->need_reset = TRUE;
   return SVN_NO_ERROR;
 }
@@ -1067,6 +1100,7 @@ svn_wc__internal_transmit_text_deltas(svn_stream_t *tempstream,
                                       svn_wc__db_t *db,
                                       const char *local_abspath,
                                       svn_boolean_t fulltext,
+                                      svn_boolean_t track_source,
                                       const svn_delta_editor_t *editor,
                                       void *file_baton,
                                       apr_pool_t *result_pool,
@@ -1173,6 +1207,7 @@ svn_wc__internal_transmit_text_deltas(svn_stream_t *tempstream,
                                                         scratch_pool);
 
     baton.need_reset = FALSE;
+    baton.track_source = track_source;
     baton.base_stream = svn_stream_disown(base_stream, scratch_pool);
     baton.local_stream = svn_stream_disown(local_stream, scratch_pool);
     err = editor->apply_textdelta_stream(editor, file_baton, base_digest_hex,
@@ -1254,6 +1289,7 @@ svn_wc_transmit_text_deltas4(const svn_checksum_t **new_text_base_md5_checksum,
                              svn_wc_context_t *wc_ctx,
                              const char *local_abspath,
                              svn_boolean_t fulltext,
+                             svn_boolean_t track_source,
                              const svn_delta_editor_t *editor,
                              void *file_baton,
                              apr_pool_t *result_pool,
@@ -1263,7 +1299,7 @@ svn_wc_transmit_text_deltas4(const svn_checksum_t **new_text_base_md5_checksum,
                                                new_text_base_md5_checksum,
                                                new_text_base_sha1_checksum,
                                                wc_ctx->db, local_abspath,
-                                               fulltext, editor,
+                                               fulltext, track_source, editor,
                                                file_baton, result_pool,
                                                scratch_pool);
 }
@@ -227,6 +227,11 @@ svn_wc_process_committed_queue2(svn_wc_committed_queue_t *queue,
       SVN_ERR(svn_wc__wq_run(wc_ctx->db, wcroot_abspath,
                              cancel_func, cancel_baton,
                              iterpool));
+
+      SVN_ERR(svn_wc__reclaim_pristines_if_enabled(wc_ctx->db,
+                                                   wcroot_abspath,
+                                                   cancel_func, cancel_baton,
+                                                   iterpool));
     }
 
   svn_pool_destroy(iterpool);
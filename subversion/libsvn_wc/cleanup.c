@@ -26,6 +26,7 @@
 #include <string.h>
 
 #include "svn_wc.h"
+#include "svn_config.h"
 #include "svn_error.h"
 #include "svn_pools.h"
 #include "svn_io.h"
@@ -152,6 +153,34 @@ cleanup_internal(svn_wc__db_t *db,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__reclaim_pristines_if_enabled(svn_wc__db_t *db,
+                                     const char *wri_abspath,
+                                     svn_cancel_func_t cancel_func,
+                                     void *cancel_baton,
+                                     apr_pool_t *scratch_pool)
+{
+  svn_boolean_t reclaim;
+  svn_error_t *err;
+
+  err = svn_config_get_bool(svn_wc__db_get_config(db), &reclaim,
+                            SVN_CONFIG_SECTION_WORKING_COPY,
+                            SVN_CONFIG_OPTION_RECLAIM_PRISTINES, FALSE);
+  if (err)
+    {
+      svn_error_clear(err);
+      reclaim = FALSE;
+    }
+
+  if (!reclaim)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(svn_wc__db_pristine_reclaim(db, wri_abspath,
+                                                     cancel_func,
+                                                     cancel_baton,
+                                                     scratch_pool));
+}
+
 svn_error_t *
 svn_wc_cleanup4(svn_wc_context_t *wc_ctx,
                 const char *local_abspath,
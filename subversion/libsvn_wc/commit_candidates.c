@@ -0,0 +1,378 @@
+/*
+ * commit_candidates.c: finding the nodes a commit has to look at
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* A commit of a large working copy with only a few changes spends most
+ * of its time in the status walk that finds these changes: it reads
+ * every directory from wc.db and from disk.  svn_wc__find_commit_candidates()
+ * instead reads all nodes of the tree with a single query and stat()s the
+ * working files in batches on a few threads, leaving only the nodes that
+ * may actually be committable to the status walk.
+ *
+ * svn_wc__node_has_stat_changes() uses the same scan to tell quickly
+ * whether a tree has been modified at all. */
+
+#include <string.h>
+#include <apr_thread_proc.h>
+
+#include "svn_pools.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
+#include "svn_sorts.h"
+
+#include "wc.h"
+#include "wc_db.h"
+#include "fsmonitor.h"
+
+#include "svn_private_config.h"
+#include "private/svn_sorts_private.h"
+#include "private/svn_wc_private.h"
+
+/* Number of working files and directories to stat() at once. */
+#define STAT_BATCH_SIZE 4096
+
+/* Number of threads, including the caller, stat()ing a batch. */
+#define STAT_THREAD_COUNT 4
+
+/* A versioned file or directory to compare with its recorded state. */
+typedef struct stat_job_t
+{
+  const char *local_abspath;
+  svn_node_kind_t kind;
+  svn_filesize_t recorded_size;
+  apr_time_t recorded_time;
+
+  /* Set if the node on disk doesn't match the recorded state. */
+  svn_boolean_t changed;
+} stat_job_t;
+
+/* Baton for collect_candidate(). */
+typedef struct find_candidates_baton_t
+{
+  /* The root of the scan, if it shall not be reported, or NULL. */
+  const char *root_abspath;
+
+  /* The filesystem monitor of the working copy, or NULL. */
+  svn_wc__fsmonitor_t *monitor;
+
+  /* Whether to stop the scan at the first candidate. */
+  svn_boolean_t stop_at_first;
+
+  /* The candidates found so far, allocated in RESULT_POOL. */
+  apr_array_header_t *candidates;
+  apr_pool_t *result_pool;
+
+  /* The stat_job_t * not checked, yet, allocated in BATCH_POOL. */
+  apr_array_header_t *jobs;
+  apr_pool_t *batch_pool;
+} find_candidates_baton_t;
+
+/* Compare JOB with the node on disk and set JOB->CHANGED accordingly,
+ * using the heuristic of svn_wc__internal_file_modified_p() for files.
+ * Use SCRATCH_POOL for temporary allocations. */
+static void
+check_stat_job(stat_job_t *job,
+               apr_pool_t *scratch_pool)
+{
+  const svn_io_dirent2_t *dirent;
+  svn_error_t *err = svn_io_stat_dirent2(&dirent, job->local_abspath,
+                                         FALSE, TRUE,
+                                         scratch_pool, scratch_pool);
+
+  if (err)
+    {
+      /* Let the status walk report the problem. */
+      svn_error_clear(err);
+      job->changed = TRUE;
+    }
+  else if (dirent->kind != job->kind || dirent->special)
+    job->changed = TRUE;
+  else if (job->kind == svn_node_file)
+    job->changed = (   (   job->recorded_size != SVN_INVALID_FILESIZE
+                        && dirent->filesize != job->recorded_size)
+                    || dirent->mtime != job->recorded_time);
+}
+
+/* Check every STEP-th job in JOBS, starting with the one at FIRST.
+ * Use SCRATCH_POOL for temporary allocations. */
+static void
+check_stat_jobs(apr_array_header_t *jobs,
+                int first,
+                int step,
+                apr_pool_t *scratch_pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  for (i = first; i < jobs->nelts; i += step)
+    {
+      svn_pool_clear(iterpool);
+      check_stat_job(APR_ARRAY_IDX(jobs, i, stat_job_t *), iterpool);
+    }
+
+  svn_pool_destroy(iterpool);
+}
+
+#if APR_HAS_THREADS
+
+/* A share of a batch of stat_job_t checked by one thread. */
+typedef struct stat_worker_t
+{
+  apr_array_header_t *jobs;
+  int first;
+  int step;
+
+  /* Pool with its own allocator for the temporaries of this worker. */
+  apr_pool_t *pool;
+} stat_worker_t;
+
+/* The plain APR thread function checking the jobs of the stat_worker_t
+ * given as DATA. */
+static void * APR_THREAD_FUNC
+stat_thread(apr_thread_t *thread, void *data)
+{
+  stat_worker_t *worker = data;
+
+  check_stat_jobs(worker->jobs, worker->first, worker->step, worker->pool);
+
+  /* End thread explicitly to prevent APR_INCOMPLETE return codes in
+     apr_thread_join(). */
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Check all jobs in B->JOBS, add the changed nodes to B->CANDIDATES and
+ * start a new batch.  Use SCRATCH_POOL for temporary allocations. */
+static void
+flush_stat_jobs(find_candidates_baton_t *b,
+                apr_pool_t *scratch_pool)
+{
+  int i;
+
+#if APR_HAS_THREADS
+  if (b->jobs->nelts >= STAT_THREAD_COUNT)
+    {
+      /* The thread objects can't share the allocator with the caller. */
+      apr_pool_t *thread_pool
+        = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+      apr_thread_t *threads[STAT_THREAD_COUNT];
+      stat_worker_t workers[STAT_THREAD_COUNT];
+
+      for (i = 1; i < STAT_THREAD_COUNT; i++)
+        {
+          workers[i].jobs = b->jobs;
+          workers[i].first = i;
+          workers[i].step = STAT_THREAD_COUNT;
+          workers[i].pool
+            = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+          /* If we can't get another thread, check its share ourselves. */
+          if (apr_thread_create(&threads[i], NULL, stat_thread, &workers[i],
+                                thread_pool))
+            {
+              threads[i] = NULL;
+              check_stat_jobs(b->jobs, i, STAT_THREAD_COUNT, scratch_pool);
+            }
+        }
+
+      check_stat_jobs(b->jobs, 0, STAT_THREAD_COUNT, scratch_pool);
+
+      for (i = 1; i < STAT_THREAD_COUNT; i++)
+        {
+          if (threads[i])
+            {
+              apr_status_t retval;
+              apr_thread_join(&retval, threads[i]);
+            }
+          svn_pool_destroy(workers[i].pool);
+        }
+
+      svn_pool_destroy(thread_pool);
+    }
+  else
+#endif
+    check_stat_jobs(b->jobs, 0, 1, scratch_pool);
+
+  for (i = 0; i < b->jobs->nelts; i++)
+    {
+      const stat_job_t *job = APR_ARRAY_IDX(b->jobs, i, stat_job_t *);
+
+      if (job->changed)
+        APR_ARRAY_PUSH(b->candidates, const char *)
+          = apr_pstrdup(b->result_pool, job->local_abspath);
+    }
+
+  svn_pool_clear(b->batch_pool);
+  b->jobs = apr_array_make(b->batch_pool, STAT_BATCH_SIZE,
+                           sizeof(stat_job_t *));
+}
+
+/* Implements svn_wc__db_commit_info_cb_t.  Add nodes with local changes
+ * in the database to BATON->CANDIDATES directly and queue the versioned
+ * files and directories for being checked on disk, unless the filesystem
+ * monitor knows that their parent directory is unchanged.
+ *
+ * Return SVN_ERR_CEASE_INVOCATION once a candidate has been found if
+ * BATON->STOP_AT_FIRST is set. */
+static svn_error_t *
+collect_candidate(void *baton,
+                  const char *local_abspath,
+                  svn_wc__db_status_t status,
+                  svn_node_kind_t kind,
+                  svn_boolean_t have_work,
+                  svn_boolean_t props_mod,
+                  svn_boolean_t file_external,
+                  svn_filesize_t recorded_size,
+                  apr_time_t recorded_time,
+                  apr_pool_t *scratch_pool)
+{
+  find_candidates_baton_t *b = baton;
+  stat_job_t *job;
+
+  /* File externals are never candidates, the root is up to the caller. */
+  if (file_external
+      || (b->root_abspath && strcmp(local_abspath, b->root_abspath) == 0))
+    return SVN_NO_ERROR;
+
+  /* Nodes that are not there, have nothing to commit. */
+  if (   status == svn_wc__db_status_not_present
+      || status == svn_wc__db_status_excluded
+      || status == svn_wc__db_status_server_excluded)
+    return SVN_NO_ERROR;
+
+  if (   have_work || props_mod
+      || status != svn_wc__db_status_normal
+      || (kind != svn_node_file && kind != svn_node_dir))
+    {
+      APR_ARRAY_PUSH(b->candidates, const char *)
+        = apr_pstrdup(b->result_pool, local_abspath);
+    }
+  else if (!svn_wc__fsmonitor_dir_unchanged(
+                    b->monitor, svn_dirent_dirname(local_abspath,
+                                                   scratch_pool)))
+    {
+      job = apr_pcalloc(b->batch_pool, sizeof(*job));
+      job->local_abspath = apr_pstrdup(b->batch_pool, local_abspath);
+      job->kind = kind;
+      job->recorded_size = recorded_size;
+      job->recorded_time = recorded_time;
+      APR_ARRAY_PUSH(b->jobs, stat_job_t *) = job;
+
+      if (b->jobs->nelts >= STAT_BATCH_SIZE)
+        flush_stat_jobs(b, scratch_pool);
+    }
+
+  if (b->stop_at_first && b->candidates->nelts > 0)
+    return svn_error_create(SVN_ERR_CEASE_INVOCATION, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__find_commit_candidates(apr_array_header_t **candidates,
+                               svn_wc_context_t *wc_ctx,
+                               const char *local_abspath,
+                               svn_cancel_func_t cancel_func,
+                               void *cancel_baton,
+                               apr_pool_t *result_pool,
+                               apr_pool_t *scratch_pool)
+{
+  find_candidates_baton_t b;
+  svn_boolean_t conflicted;
+
+  b.root_abspath = local_abspath;
+  b.monitor = NULL;
+  b.stop_at_first = FALSE;
+  b.result_pool = result_pool;
+  b.candidates = apr_array_make(result_pool, 16, sizeof(const char *));
+  b.batch_pool = svn_pool_create(scratch_pool);
+  b.jobs = apr_array_make(b.batch_pool, STAT_BATCH_SIZE,
+                          sizeof(stat_job_t *));
+
+  APR_ARRAY_PUSH(b.candidates, const char *)
+    = apr_pstrdup(result_pool, local_abspath);
+
+  SVN_ERR(svn_wc__db_read_commit_info_recursive(&conflicted, wc_ctx->db,
+                                                local_abspath,
+                                                collect_candidate, &b,
+                                                cancel_func, cancel_baton,
+                                                scratch_pool));
+  if (conflicted)
+    {
+      *candidates = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  flush_stat_jobs(&b, scratch_pool);
+  svn_pool_destroy(b.batch_pool);
+
+  /* Parents before their children, as in a status walk. */
+  svn_sort__array(b.candidates, svn_sort_compare_paths);
+  *candidates = b.candidates;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__node_has_stat_changes(svn_boolean_t *modified,
+                              svn_wc__db_t *db,
+                              const char *local_abspath,
+                              svn_cancel_func_t cancel_func,
+                              void *cancel_baton,
+                              apr_pool_t *scratch_pool)
+{
+  find_candidates_baton_t b;
+  const char *wcroot_abspath;
+  svn_error_t *err;
+
+  SVN_ERR(svn_wc__db_get_wcroot(&wcroot_abspath, db, local_abspath,
+                                scratch_pool, scratch_pool));
+
+  b.root_abspath = NULL;
+  b.stop_at_first = TRUE;
+  b.result_pool = scratch_pool;
+  b.candidates = apr_array_make(scratch_pool, 1, sizeof(const char *));
+  b.batch_pool = svn_pool_create(scratch_pool);
+  b.jobs = apr_array_make(b.batch_pool, STAT_BATCH_SIZE,
+                          sizeof(stat_job_t *));
+  SVN_ERR(svn_wc__fsmonitor_open(&b.monitor, db, wcroot_abspath,
+                                 scratch_pool, scratch_pool));
+
+  err = svn_wc__db_read_commit_info_recursive(NULL, db, local_abspath,
+                                              collect_candidate, &b,
+                                              cancel_func, cancel_baton,
+                                              scratch_pool);
+  if (err && err->apr_err == SVN_ERR_CEASE_INVOCATION)
+    svn_error_clear(err);
+  else
+    SVN_ERR(err);
+
+  if (b.candidates->nelts == 0)
+    flush_stat_jobs(&b, scratch_pool);
+  svn_pool_destroy(b.batch_pool);
+
+  *modified = (b.candidates->nelts > 0);
+
+  return svn_error_trace(svn_wc__fsmonitor_close(b.monitor, scratch_pool));
+}
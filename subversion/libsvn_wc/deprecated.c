@@ -534,6 +534,7 @@ svn_wc_transmit_text_deltas3(const svn_checksum_t **new_text_base_md5_checksum,
                                        wc_ctx,
                                        local_abspath,
                                        fulltext,
+                                       FALSE,
                                        editor,
                                        file_baton,
                                        result_pool,
@@ -584,7 +585,7 @@ svn_wc_transmit_text_deltas2(const char **tempfile,
                                                : NULL),
                                               NULL, wc_ctx->db,
                                               local_abspath, fulltext,
-                                              editor, file_baton,
+                                              FALSE, editor, file_baton,
                                               pool, pool);
   if (tempfile)
     {
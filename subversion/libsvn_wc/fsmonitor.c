@@ -0,0 +1,388 @@
+/*
+ * fsmonitor.c: skip unchanged directories based on a filesystem monitor
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <string.h>
+
+#include <apr_strings.h>
+
+#include "svn_config.h"
+#include "svn_dirent_uri.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+
+#include "adm_files.h"
+#include "fsmonitor.h"
+
+/* Name of the journal file in the administrative area of the wcroot. */
+#define JOURNAL_FILE "fsmonitor"
+
+/* Format number of the journal file. */
+#define JOURNAL_FORMAT "1"
+
+/* Version of the hook protocol that we speak. */
+#define HOOK_VERSION "1"
+
+struct svn_wc__fsmonitor_t
+{
+  /* The working copy root. */
+  const char *wcroot_abspath;
+
+  /* The token that the hook returned for the current state. */
+  const char *token;
+
+  /* Size and timestamp of wc.db as of svn_wc__fsmonitor_open(). */
+  const char *db_stamp;
+
+  /* Set of relpaths of directories that are known to match wc.db,
+     mapped to "".  Allocated in POOL. */
+  apr_hash_t *clean_dirs;
+
+  apr_pool_t *pool;
+};
+
+/* Set *STAMP to a string that changes whenever the wc.db of the working
+   copy WCROOT_ABSPATH gets modified.  Allocate it in RESULT_POOL. */
+static svn_error_t *
+get_db_stamp(const char **stamp,
+             const char *wcroot_abspath,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  apr_finfo_t finfo;
+
+  SVN_ERR(svn_io_stat(&finfo, svn_wc__adm_child(wcroot_abspath, "wc.db",
+                                                 scratch_pool),
+                      APR_FINFO_MTIME | APR_FINFO_SIZE, scratch_pool));
+
+  *stamp = apr_psprintf(result_pool, "%" APR_TIME_T_FMT " %" APR_OFF_T_FMT,
+                        finfo.mtime, finfo.size);
+  return SVN_NO_ERROR;
+}
+
+/* Return the next line of the NUL-terminated buffer at *DATA, terminated
+   by a newline, and advance *DATA behind it.  Return NULL if there is no
+   complete line left. */
+static const char *
+next_line(char **data)
+{
+  char *line = *data;
+  char *eol = strchr(line, '\n');
+
+  if (!eol)
+    return NULL;
+
+  *eol = '\0';
+  *data = eol + 1;
+  return line;
+}
+
+/* Read the journal of the working copy MONITOR->WCROOT_ABSPATH.  Set
+   *TOKEN to the token stored in it and fill MONITOR->CLEAN_DIRS from it.
+   If there is no valid journal or if it was written for a different
+   state of wc.db, set *TOKEN to "" and leave MONITOR->CLEAN_DIRS empty.
+   Allocate *TOKEN in RESULT_POOL. */
+static svn_error_t *
+read_journal(const char **token,
+             svn_wc__fsmonitor_t *monitor,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents;
+  const char *format, *stamp, *relpath;
+  char *data;
+  svn_error_t *err;
+
+  *token = "";
+
+  err = svn_stringbuf_from_file2(&contents,
+                                 svn_wc__adm_child(monitor->wcroot_abspath,
+                                                   JOURNAL_FILE,
+                                                   scratch_pool),
+                                 scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  data = contents->data;
+  format = next_line(&data);
+  if (!format || strcmp(format, JOURNAL_FORMAT) != 0)
+    return SVN_NO_ERROR;
+
+  *token = next_line(&data);
+  stamp = next_line(&data);
+  if (!stamp || strcmp(stamp, monitor->db_stamp) != 0)
+    {
+      /* wc.db has changed, so our idea of "clean" may be outdated.
+         The token is still valid, though. */
+      *token = *token ? apr_pstrdup(result_pool, *token) : "";
+      return SVN_NO_ERROR;
+    }
+
+  while ((relpath = next_line(&data)))
+    svn_hash_sets(monitor->clean_dirs, apr_pstrdup(monitor->pool, relpath),
+                  "");
+
+  *token = apr_pstrdup(result_pool, *token);
+  return SVN_NO_ERROR;
+}
+
+/* Run HOOK for the working copy MONITOR->WCROOT_ABSPATH, passing TOKEN
+   to it.  Set MONITOR->TOKEN to the token that the hook returned and
+   set *CHANGED to the set of relpaths that it reported as changed.
+   Set *CHANGED to NULL if the hook could not tell what changed.  Set
+   MONITOR->TOKEN to NULL if the hook failed.  Allocate *CHANGED in
+   RESULT_POOL.
+
+   Use DB to locate the temporary area of the working copy. */
+static svn_error_t *
+run_hook(apr_hash_t **changed,
+         svn_wc__fsmonitor_t *monitor,
+         const char *hook,
+         const char *token,
+         svn_wc__db_t *db,
+         apr_pool_t *result_pool,
+         apr_pool_t *scratch_pool)
+{
+  const char *args[4];
+  const char *tmpdir_abspath;
+  apr_file_t *outfile;
+  svn_stringbuf_t *output;
+  apr_off_t offset = 0;
+  apr_exit_why_e exitwhy;
+  int exitcode;
+  const char *p, *end;
+  svn_error_t *err;
+
+  monitor->token = NULL;
+  *changed = NULL;
+
+  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&tmpdir_abspath, db,
+                                         monitor->wcroot_abspath,
+                                         scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_open_unique_file3(&outfile, NULL, tmpdir_abspath,
+                                   svn_io_file_del_on_pool_cleanup,
+                                   scratch_pool, scratch_pool));
+
+  args[0] = hook;
+  args[1] = HOOK_VERSION;
+  args[2] = token;
+  args[3] = NULL;
+
+  err = svn_io_run_cmd(monitor->wcroot_abspath, hook, args,
+                       &exitcode, &exitwhy, TRUE /* inherit */,
+                       NULL, outfile, NULL, scratch_pool);
+  if (err)
+    {
+      /* The monitor is just an optimization.  Without it, we simply
+         scan the whole working copy. */
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+
+  if (!APR_PROC_CHECK_EXIT(exitwhy) || exitcode != 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_io_file_seek(outfile, APR_SET, &offset, scratch_pool));
+  SVN_ERR(svn_stringbuf_from_aprfile(&output, outfile, scratch_pool));
+
+  /* The token comes first and must be usable as a line in our journal. */
+  p = output->data;
+  end = output->data + output->len;
+  if (memchr(p, '\0', output->len) == NULL || strchr(p, '\n'))
+    return SVN_NO_ERROR;
+
+  monitor->token = apr_pstrdup(monitor->pool, p);
+  p += strlen(p) + 1;
+
+  *changed = apr_hash_make(result_pool);
+  while (p < end)
+    {
+      const char *path = p;
+
+      p += strlen(p) + 1;
+      if (strcmp(path, "/") == 0)
+        {
+          *changed = NULL;
+          break;
+        }
+
+      if (*path)
+        svn_hash_sets(*changed,
+                      svn_relpath_canonicalize(path, result_pool), "");
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove all directories from MONITOR->CLEAN_DIRS that may be affected
+   by a change to any of the relpaths in the set CHANGED, i.e. the parents
+   of the changed paths and everything at or below them. */
+static void
+drop_changed_dirs(svn_wc__fsmonitor_t *monitor,
+                  apr_hash_t *changed,
+                  apr_pool_t *scratch_pool)
+{
+  apr_hash_t *changed_parents = apr_hash_make(scratch_pool);
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(scratch_pool, changed); hi; hi = apr_hash_next(hi))
+    svn_hash_sets(changed_parents,
+                  svn_relpath_dirname(apr_hash_this_key(hi), scratch_pool),
+                  "");
+
+  for (hi = apr_hash_first(scratch_pool, monitor->clean_dirs);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *relpath = apr_hash_this_key(hi);
+      const char *ancestor = relpath;
+      svn_boolean_t affected = svn_hash_gets(changed_parents, relpath) != NULL;
+
+      while (!affected)
+        {
+          affected = svn_hash_gets(changed, ancestor) != NULL;
+          if (!*ancestor)
+            break;
+
+          ancestor = svn_relpath_dirname(ancestor, scratch_pool);
+        }
+
+      /* Removing the current entry does not disturb the iteration. */
+      if (affected)
+        svn_hash_sets(monitor->clean_dirs, relpath, NULL);
+    }
+}
+
+svn_error_t *
+svn_wc__fsmonitor_open(svn_wc__fsmonitor_t **monitor_p,
+                       svn_wc__db_t *db,
+                       const char *wcroot_abspath,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  svn_wc__fsmonitor_t *monitor;
+  const char *hook;
+  const char *token;
+  apr_hash_t *changed;
+
+  *monitor_p = NULL;
+
+  svn_config_get(svn_wc__db_get_config(db), &hook,
+                 SVN_CONFIG_SECTION_WORKING_COPY,
+                 SVN_CONFIG_OPTION_FSMONITOR_HOOK, NULL);
+  if (!hook || !*hook)
+    return SVN_NO_ERROR;
+
+  monitor = apr_pcalloc(result_pool, sizeof(*monitor));
+  monitor->pool = result_pool;
+  monitor->wcroot_abspath = apr_pstrdup(result_pool, wcroot_abspath);
+  monitor->clean_dirs = apr_hash_make(result_pool);
+
+  /* Take the stamp first, so that concurrent modifications to wc.db
+     will invalidate the journal that we are going to write. */
+  SVN_ERR(get_db_stamp(&monitor->db_stamp, wcroot_abspath,
+                       result_pool, scratch_pool));
+  SVN_ERR(read_journal(&token, monitor, scratch_pool, scratch_pool));
+  SVN_ERR(run_hook(&changed, monitor, hook, token, db,
+                   scratch_pool, scratch_pool));
+
+  if (!monitor->token)
+    return SVN_NO_ERROR;
+
+  if (changed)
+    drop_changed_dirs(monitor, changed, scratch_pool);
+  else
+    apr_hash_clear(monitor->clean_dirs);
+
+  *monitor_p = monitor;
+  return SVN_NO_ERROR;
+}
+
+svn_boolean_t
+svn_wc__fsmonitor_dir_unchanged(svn_wc__fsmonitor_t *monitor,
+                                const char *local_abspath)
+{
+  const char *relpath;
+
+  if (!monitor)
+    return FALSE;
+
+  relpath = svn_dirent_skip_ancestor(monitor->wcroot_abspath, local_abspath);
+  return relpath && svn_hash_gets(monitor->clean_dirs, relpath);
+}
+
+void
+svn_wc__fsmonitor_set_dir_clean(svn_wc__fsmonitor_t *monitor,
+                                const char *local_abspath,
+                                svn_boolean_t clean)
+{
+  const char *relpath;
+
+  if (!monitor)
+    return;
+
+  relpath = svn_dirent_skip_ancestor(monitor->wcroot_abspath, local_abspath);
+  if (!relpath)
+    return;
+
+  if (!clean)
+    svn_hash_sets(monitor->clean_dirs, relpath, NULL);
+  else if (!svn_hash_gets(monitor->clean_dirs, relpath))
+    svn_hash_sets(monitor->clean_dirs, apr_pstrdup(monitor->pool, relpath),
+                  "");
+}
+
+svn_error_t *
+svn_wc__fsmonitor_close(svn_wc__fsmonitor_t *monitor,
+                        apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *journal;
+  apr_hash_index_t *hi;
+
+  if (!monitor)
+    return SVN_NO_ERROR;
+
+  journal = svn_stringbuf_createf(scratch_pool, "%s\n%s\n%s\n",
+                                  JOURNAL_FORMAT, monitor->token,
+                                  monitor->db_stamp);
+
+  for (hi = apr_hash_first(scratch_pool, monitor->clean_dirs);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      svn_stringbuf_appendcstr(journal, apr_hash_this_key(hi));
+      svn_stringbuf_appendbyte(journal, '\n');
+    }
+
+  return svn_error_trace(
+           svn_io_write_atomic2(svn_wc__adm_child(monitor->wcroot_abspath,
+                                                  JOURNAL_FILE,
+                                                  scratch_pool),
+                                journal->data, journal->len,
+                                NULL, FALSE /* flush_to_disk */,
+                                scratch_pool));
+}
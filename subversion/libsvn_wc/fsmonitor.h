@@ -0,0 +1,108 @@
+/*
+ * fsmonitor.h: skip unchanged directories based on a filesystem monitor
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_WC_FSMONITOR_H
+#define SVN_LIBSVN_WC_FSMONITOR_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+
+#include "wc_db.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* A journal of the directories of one working copy that did not differ
+ * from what wc.db recorded about them, combined with the changes that a
+ * filesystem monitor (inotify, FSEvents, ReadDirectoryChangesW, ...)
+ * observed since that journal was written.
+ *
+ * The monitor itself is an external program, configured as the
+ * SVN_CONFIG_OPTION_FSMONITOR_HOOK option in the
+ * SVN_CONFIG_SECTION_WORKING_COPY section.  It gets invoked in the working
+ * copy root as
+ *
+ *   HOOK 1 TOKEN
+ *
+ * where TOKEN is whatever the hook returned on its previous invocation
+ * for this working copy, or "" if there was none.  The hook must write
+ * a new token to stdout, followed by the paths that changed since TOKEN
+ * relative to the working copy root, each one terminated by a NUL byte.
+ * The path "/" tells us that the hook cannot tell what changed since
+ * TOKEN.  A non-zero exit code is treated the same way.
+ *
+ * The journal is stored in the administrative area of the working copy
+ * root and becomes invalid as soon as wc.db gets modified.
+ */
+typedef struct svn_wc__fsmonitor_t svn_wc__fsmonitor_t;
+
+/* Query the filesystem monitor of the working copy WCROOT_ABSPATH in DB
+ * and set *MONITOR_P to the resulting state, allocated in RESULT_POOL.
+ * Set *MONITOR_P to NULL if no monitor has been configured or if the
+ * monitor failed.
+ */
+svn_error_t *
+svn_wc__fsmonitor_open(svn_wc__fsmonitor_t **monitor_p,
+                       svn_wc__db_t *db,
+                       const char *wcroot_abspath,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool);
+
+/* Return TRUE if the directory LOCAL_ABSPATH and its direct children
+ * are known to still match what wc.db records about them, i.e. if the
+ * working copy scan may skip reading that directory from disk.
+ *
+ * MONITOR may be NULL, in which case this returns FALSE.
+ */
+svn_boolean_t
+svn_wc__fsmonitor_dir_unchanged(svn_wc__fsmonitor_t *monitor,
+                                const char *local_abspath);
+
+/* Record whether the directory LOCAL_ABSPATH, as just read from disk,
+ * matched what wc.db records about it and its direct children.
+ *
+ * MONITOR may be NULL, in which case this is a no-op.
+ */
+void
+svn_wc__fsmonitor_set_dir_clean(svn_wc__fsmonitor_t *monitor,
+                                const char *local_abspath,
+                                svn_boolean_t clean);
+
+/* Write the journal of MONITOR to disk, such that the next
+ * svn_wc__fsmonitor_open() only needs to account for changes made after
+ * the latter had been called.  Use SCRATCH_POOL for temporary
+ * allocations.
+ *
+ * MONITOR may be NULL, in which case this is a no-op.
+ */
+svn_error_t *
+svn_wc__fsmonitor_close(svn_wc__fsmonitor_t *monitor,
+                        apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_WC_FSMONITOR_H */
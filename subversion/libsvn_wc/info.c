@@ -469,6 +469,13 @@ svn_wc__get_info(svn_wc_context_t *wc_ctx,
   fe_baton.tree_conflicts = apr_hash_make(scratch_pool);
   fe_baton.pool = scratch_pool;
 
+  /* A recursive walk reads the information of every node separately, so
+     load all of it in one go.  This is just an optimization: if it fails,
+     the walk below reports whatever is wrong. */
+  if (depth == svn_depth_infinity)
+    svn_error_clear(svn_wc__db_cache_nodes(wc_ctx->db, local_abspath,
+                                           iterpool));
+
   err = svn_wc__internal_walk_children(wc_ctx->db, local_abspath,
                                        fetch_excluded,
                                        changelist_filter,
@@ -477,6 +484,10 @@ svn_wc__get_info(svn_wc_context_t *wc_ctx,
                                        cancel_func, cancel_baton,
                                        iterpool);
 
+  if (depth == svn_depth_infinity)
+    svn_error_clear(svn_wc__db_uncache_nodes(wc_ctx->db, local_abspath,
+                                             iterpool));
+
   /* If the target root node is not present, svn_wc__internal_walk_children()
      returns a PATH_NOT_FOUND error and doesn't call the callback.  If there
      is a tree conflict on this node, that is not an error. */
@@ -1605,6 +1605,19 @@ svn_wc__call_with_write_lock(svn_wc__with_write_lock_func_t func,
   return svn_error_compose_create(err1, err2);
 }
 
+svn_error_t *
+svn_wc__call_in_txn(svn_wc__with_write_lock_func_t func,
+                    void *baton,
+                    svn_wc_context_t *wc_ctx,
+                    const char *local_abspath,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(svn_wc__db_with_txn(wc_ctx->db, local_abspath,
+                                             func, baton,
+                                             result_pool, scratch_pool));
+}
+
 
 svn_error_t *
 svn_wc__acquire_write_lock_for_resolve(const char **lock_root_abspath,
@@ -53,6 +53,8 @@ typedef struct merge_target_t
   const char *diff3_cmd;                    /* The diff3 command and options */
   const apr_array_header_t *merge_options;
 
+  const svn_wc__text_merge_t *precomputed;  /* Text merge computed ahead,
+                                               or NULL */
 } merge_target_t;
 
 
@@ -847,37 +849,54 @@ merge_text_file(svn_skel_t **work_items,
      ultimately winds up in a conflict resolution editor.  */
   SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&temp_dir, mt->db, mt->wri_abspath,
                                          pool, pool));
-  SVN_ERR(svn_io_open_uniquely_named(&result_f, &result_target,
-                                     temp_dir, base_name, ".tmp",
-                                     svn_io_file_del_none, pool, pool));
-
-  /* Run the external or internal merge, as requested. */
-  if (mt->diff3_cmd)
-      SVN_ERR(do_text_merge_external(&contains_conflicts,
-                                     result_f,
-                                     mt->diff3_cmd,
-                                     mt->merge_options,
-                                     detranslated_target_abspath,
-                                     left_abspath,
-                                     right_abspath,
-                                     target_label,
-                                     left_label,
-                                     right_label,
-                                     pool));
-  else /* Use internal merge. */
-    SVN_ERR(do_text_merge(&contains_conflicts,
-                          result_f,
-                          mt->merge_options,
-                          detranslated_target_abspath,
-                          left_abspath,
-                          right_abspath,
-                          target_label,
-                          left_label,
-                          right_label,
-                          cancel_func, cancel_baton,
-                          pool));
-
-  SVN_ERR(svn_io_file_close(result_f, pool));
+
+  /* Use the result of svn_wc__merge_text_ahead() if it merged exactly the
+     files we would merge here into this working copy's temp area. */
+  if (mt->precomputed && !mt->diff3_cmd
+      && strcmp(mt->precomputed->left_abspath, left_abspath) == 0
+      && strcmp(mt->precomputed->right_abspath, right_abspath) == 0
+      && strcmp(mt->precomputed->target_abspath,
+                detranslated_target_abspath) == 0
+      && strcmp(svn_dirent_dirname(mt->precomputed->result_abspath, pool),
+                temp_dir) == 0)
+    {
+      result_target = mt->precomputed->result_abspath;
+      contains_conflicts = mt->precomputed->contains_conflicts;
+    }
+  else
+    {
+      SVN_ERR(svn_io_open_uniquely_named(&result_f, &result_target,
+                                         temp_dir, base_name, ".tmp",
+                                         svn_io_file_del_none, pool, pool));
+
+      /* Run the external or internal merge, as requested. */
+      if (mt->diff3_cmd)
+          SVN_ERR(do_text_merge_external(&contains_conflicts,
+                                         result_f,
+                                         mt->diff3_cmd,
+                                         mt->merge_options,
+                                         detranslated_target_abspath,
+                                         left_abspath,
+                                         right_abspath,
+                                         target_label,
+                                         left_label,
+                                         right_label,
+                                         pool));
+      else /* Use internal merge. */
+        SVN_ERR(do_text_merge(&contains_conflicts,
+                              result_f,
+                              mt->merge_options,
+                              detranslated_target_abspath,
+                              left_abspath,
+                              right_abspath,
+                              target_label,
+                              left_label,
+                              right_label,
+                              cancel_func, cancel_baton,
+                              pool));
+
+      SVN_ERR(svn_io_file_close(result_f, pool));
+    }
 
   /* Determine the MERGE_OUTCOME, and record any conflict. */
   if (contains_conflicts)
@@ -1074,27 +1093,31 @@ merge_binary_file(svn_skel_t **work_items,
   return SVN_NO_ERROR;
 }
 
-svn_error_t *
-svn_wc__internal_merge(svn_skel_t **work_items,
-                       svn_skel_t **conflict_skel,
-                       enum svn_wc_merge_outcome_t *merge_outcome,
-                       svn_wc__db_t *db,
-                       const char *left_abspath,
-                       const char *right_abspath,
-                       const char *target_abspath,
-                       const char *wri_abspath,
-                       const char *left_label,
-                       const char *right_label,
-                       const char *target_label,
-                       apr_hash_t *old_actual_props,
-                       svn_boolean_t dry_run,
-                       const char *diff3_cmd,
-                       const apr_array_header_t *merge_options,
-                       const apr_array_header_t *prop_diff,
-                       svn_cancel_func_t cancel_func,
-                       void *cancel_baton,
-                       apr_pool_t *result_pool,
-                       apr_pool_t *scratch_pool)
+/* The implementation of svn_wc__internal_merge(), which uses the
+   text merge PRECOMPUTED by svn_wc__merge_text_ahead() when it applies.
+   PRECOMPUTED may be NULL. */
+static svn_error_t *
+internal_merge(svn_skel_t **work_items,
+               svn_skel_t **conflict_skel,
+               enum svn_wc_merge_outcome_t *merge_outcome,
+               svn_wc__db_t *db,
+               const char *left_abspath,
+               const char *right_abspath,
+               const char *target_abspath,
+               const char *wri_abspath,
+               const char *left_label,
+               const char *right_label,
+               const char *target_label,
+               apr_hash_t *old_actual_props,
+               svn_boolean_t dry_run,
+               const char *diff3_cmd,
+               const apr_array_header_t *merge_options,
+               const apr_array_header_t *prop_diff,
+               const svn_wc__text_merge_t *precomputed,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *result_pool,
+               apr_pool_t *scratch_pool)
 {
   const char *detranslated_target_abspath;
   svn_boolean_t is_binary = FALSE;
@@ -1116,6 +1139,7 @@ svn_wc__internal_merge(svn_skel_t **work_items,
   mt.prop_diff = prop_diff;
   mt.diff3_cmd = diff3_cmd;
   mt.merge_options = merge_options;
+  mt.precomputed = precomputed;
 
   /* Decide if the merge target is a text or binary file. */
   if ((mimeprop = get_prop(prop_diff, SVN_PROP_MIME_TYPE))
@@ -1200,29 +1224,114 @@ svn_wc__internal_merge(svn_skel_t **work_items,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__internal_merge(svn_skel_t **work_items,
+                       svn_skel_t **conflict_skel,
+                       enum svn_wc_merge_outcome_t *merge_outcome,
+                       svn_wc__db_t *db,
+                       const char *left_abspath,
+                       const char *right_abspath,
+                       const char *target_abspath,
+                       const char *wri_abspath,
+                       const char *left_label,
+                       const char *right_label,
+                       const char *target_label,
+                       apr_hash_t *old_actual_props,
+                       svn_boolean_t dry_run,
+                       const char *diff3_cmd,
+                       const apr_array_header_t *merge_options,
+                       const apr_array_header_t *prop_diff,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(internal_merge(work_items, conflict_skel,
+                                        merge_outcome, db,
+                                        left_abspath, right_abspath,
+                                        target_abspath, wri_abspath,
+                                        left_label, right_label,
+                                        target_label, old_actual_props,
+                                        dry_run, diff3_cmd, merge_options,
+                                        prop_diff, NULL,
+                                        cancel_func, cancel_baton,
+                                        result_pool, scratch_pool));
+}
 
 svn_error_t *
-svn_wc_merge6(enum svn_wc_merge_outcome_t *merge_content_outcome,
-              enum svn_wc_notify_state_t *merge_props_outcome,
-              svn_wc_context_t *wc_ctx,
-              const char *left_abspath,
-              const char *right_abspath,
-              const char *target_abspath,
-              const char *left_label,
-              const char *right_label,
-              const char *target_label,
-              const svn_wc_conflict_version_t *left_version,
-              const svn_wc_conflict_version_t *right_version,
-              svn_boolean_t dry_run,
-              const char *diff3_cmd,
-              const apr_array_header_t *merge_options,
-              apr_hash_t *original_props,
-              const apr_array_header_t *prop_diff,
-              svn_wc_conflict_resolver_func2_t conflict_func,
-              void *conflict_baton,
-              svn_cancel_func_t cancel_func,
-              void *cancel_baton,
-              apr_pool_t *scratch_pool)
+svn_wc__merge_text_ahead(svn_wc__text_merge_t **result,
+                         const char *left_abspath,
+                         const char *right_abspath,
+                         const char *target_abspath,
+                         const char *left_label,
+                         const char *right_label,
+                         const char *target_label,
+                         const apr_array_header_t *merge_options,
+                         const char *tmpdir_abspath,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
+                         apr_pool_t *result_pool,
+                         apr_pool_t *scratch_pool)
+{
+  svn_wc__text_merge_t *merge = apr_pcalloc(result_pool, sizeof(*merge));
+  apr_file_t *result_f;
+  svn_error_t *err;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(left_abspath));
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(right_abspath));
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(target_abspath));
+
+  merge->left_abspath = apr_pstrdup(result_pool, left_abspath);
+  merge->right_abspath = apr_pstrdup(result_pool, right_abspath);
+  merge->target_abspath = apr_pstrdup(result_pool, target_abspath);
+
+  /* Name the result like merge_text_file() does. */
+  SVN_ERR(svn_io_open_uniquely_named(&result_f, &merge->result_abspath,
+                                     tmpdir_abspath,
+                                     svn_dirent_basename(target_abspath,
+                                                         scratch_pool),
+                                     ".tmp", svn_io_file_del_none,
+                                     result_pool, scratch_pool));
+
+  err = do_text_merge(&merge->contains_conflicts, result_f, merge_options,
+                      target_abspath, left_abspath, right_abspath,
+                      target_label, left_label, right_label,
+                      cancel_func, cancel_baton, scratch_pool);
+  err = svn_error_compose_create(err, svn_io_file_close(result_f,
+                                                        scratch_pool));
+  if (err)
+    return svn_error_compose_create(
+             err,
+             svn_io_remove_file2(merge->result_abspath, TRUE, scratch_pool));
+
+  *result = merge;
+  return SVN_NO_ERROR;
+}
+
+/* The implementation of svn_wc_merge6() and svn_wc__merge_precomputed(). */
+static svn_error_t *
+merge_file(enum svn_wc_merge_outcome_t *merge_content_outcome,
+           enum svn_wc_notify_state_t *merge_props_outcome,
+           svn_wc_context_t *wc_ctx,
+           const char *left_abspath,
+           const char *right_abspath,
+           const char *target_abspath,
+           const char *left_label,
+           const char *right_label,
+           const char *target_label,
+           const svn_wc_conflict_version_t *left_version,
+           const svn_wc_conflict_version_t *right_version,
+           svn_boolean_t dry_run,
+           const char *diff3_cmd,
+           const apr_array_header_t *merge_options,
+           apr_hash_t *original_props,
+           const apr_array_header_t *prop_diff,
+           const svn_wc__text_merge_t *precomputed,
+           svn_wc_conflict_resolver_func2_t conflict_func,
+           void *conflict_baton,
+           svn_cancel_func_t cancel_func,
+           void *cancel_baton,
+           apr_pool_t *scratch_pool)
 {
   const char *dir_abspath = svn_dirent_dirname(target_abspath, scratch_pool);
   svn_skel_t *work_items;
@@ -1342,22 +1451,23 @@ svn_wc_merge6(enum svn_wc_merge_outcome_t *merge_content_outcome,
     }
 
   /* Merge the text. */
-  SVN_ERR(svn_wc__internal_merge(&work_items,
-                                 &conflict_skel,
-                                 merge_content_outcome,
-                                 wc_ctx->db,
-                                 left_abspath,
-                                 right_abspath,
-                                 target_abspath,
-                                 target_abspath,
-                                 left_label, right_label, target_label,
-                                 old_actual_props,
-                                 dry_run,
-                                 diff3_cmd,
-                                 merge_options,
-                                 prop_diff,
-                                 cancel_func, cancel_baton,
-                                 scratch_pool, scratch_pool));
+  SVN_ERR(internal_merge(&work_items,
+                         &conflict_skel,
+                         merge_content_outcome,
+                         wc_ctx->db,
+                         left_abspath,
+                         right_abspath,
+                         target_abspath,
+                         target_abspath,
+                         left_label, right_label, target_label,
+                         old_actual_props,
+                         dry_run,
+                         diff3_cmd,
+                         merge_options,
+                         prop_diff,
+                         precomputed,
+                         cancel_func, cancel_baton,
+                         scratch_pool, scratch_pool));
 
   /* If this isn't a dry run, then update the DB, run the work, and
    * call the conflict resolver callback.  */
@@ -1426,3 +1536,76 @@ svn_wc_merge6(enum svn_wc_merge_outcome_t *merge_content_outcome,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_wc_merge6(enum svn_wc_merge_outcome_t *merge_content_outcome,
+              enum svn_wc_notify_state_t *merge_props_outcome,
+              svn_wc_context_t *wc_ctx,
+              const char *left_abspath,
+              const char *right_abspath,
+              const char *target_abspath,
+              const char *left_label,
+              const char *right_label,
+              const char *target_label,
+              const svn_wc_conflict_version_t *left_version,
+              const svn_wc_conflict_version_t *right_version,
+              svn_boolean_t dry_run,
+              const char *diff3_cmd,
+              const apr_array_header_t *merge_options,
+              apr_hash_t *original_props,
+              const apr_array_header_t *prop_diff,
+              svn_wc_conflict_resolver_func2_t conflict_func,
+              void *conflict_baton,
+              svn_cancel_func_t cancel_func,
+              void *cancel_baton,
+              apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(merge_file(merge_content_outcome,
+                                    merge_props_outcome, wc_ctx,
+                                    left_abspath, right_abspath,
+                                    target_abspath,
+                                    left_label, right_label, target_label,
+                                    left_version, right_version,
+                                    dry_run, diff3_cmd, merge_options,
+                                    original_props, prop_diff, NULL,
+                                    conflict_func, conflict_baton,
+                                    cancel_func, cancel_baton,
+                                    scratch_pool));
+}
+
+svn_error_t *
+svn_wc__merge_precomputed(enum svn_wc_merge_outcome_t *merge_content_outcome,
+                          enum svn_wc_notify_state_t *merge_props_outcome,
+                          svn_wc_context_t *wc_ctx,
+                          const char *left_abspath,
+                          const char *right_abspath,
+                          const char *target_abspath,
+                          const char *left_label,
+                          const char *right_label,
+                          const char *target_label,
+                          const svn_wc_conflict_version_t *left_version,
+                          const svn_wc_conflict_version_t *right_version,
+                          svn_boolean_t dry_run,
+                          const char *diff3_cmd,
+                          const apr_array_header_t *merge_options,
+                          apr_hash_t *original_props,
+                          const apr_array_header_t *prop_diff,
+                          const svn_wc__text_merge_t *precomputed,
+                          svn_wc_conflict_resolver_func2_t conflict_func,
+                          void *conflict_baton,
+                          svn_cancel_func_t cancel_func,
+                          void *cancel_baton,
+                          apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(merge_file(merge_content_outcome,
+                                    merge_props_outcome, wc_ctx,
+                                    left_abspath, right_abspath,
+                                    target_abspath,
+                                    left_label, right_label, target_label,
+                                    left_version, right_version,
+                                    dry_run, diff3_cmd, merge_options,
+                                    original_props, prop_diff, precomputed,
+                                    conflict_func, conflict_baton,
+                                    cancel_func, cancel_baton,
+                                    scratch_pool));
+}
@@ -96,6 +96,38 @@ svn_wc__node_get_children_of_working_node(const apr_array_header_t **children,
   return SVN_NO_ERROR;
 }
 
+svn_error_t *
+svn_wc__get_existing_children(apr_hash_t **children,
+                              svn_wc_context_t *wc_ctx,
+                              const char *dir_abspath,
+                              apr_pool_t *result_pool,
+                              apr_pool_t *scratch_pool)
+{
+  apr_hash_t *nodes;
+  apr_hash_t *conflicts;
+  apr_hash_index_t *hi;
+
+  SVN_ERR(svn_wc__db_read_children_info(&nodes, &conflicts, wc_ctx->db,
+                                        dir_abspath, FALSE,
+                                        scratch_pool, scratch_pool));
+
+  *children = apr_hash_make(result_pool);
+  for (hi = apr_hash_first(scratch_pool, nodes); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      const struct svn_wc__db_info_t *info = apr_hash_this_val(hi);
+
+      if (info->conflicted
+          || info->status == svn_wc__db_status_deleted
+          || info->status == svn_wc__db_status_not_present)
+        continue;
+
+      svn_hash_sets(*children, apr_pstrdup(result_pool, name), "");
+    }
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_wc__node_get_not_present_children(const apr_array_header_t **children,
                                       svn_wc_context_t *wc_ctx,
@@ -45,6 +45,7 @@
 #include "wc_db.h"
 
 #include "svn_private_config.h"
+#include "private/svn_sorts_private.h"
 #include "private/svn_wc_private.h"
 
 
@@ -78,9 +79,49 @@
 */
 
 
+/* Set *TRANSLATION to a checksum that identifies detranslating a working
+ * file to PRISTINE_EOL_STR with KEYWORDS contracted, allocated in
+ * RESULT_POOL.  Either of them may be NULL.  Use SCRATCH_POOL for temporary
+ * allocations.
+ */
+static svn_error_t *
+get_translation_key(svn_checksum_t **translation,
+                    const char *pristine_eol_str,
+                    apr_hash_t *keywords,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *buf = svn_stringbuf_create(pristine_eol_str
+                                                ? pristine_eol_str : "",
+                                              scratch_pool);
+
+  /* Contracting keywords only depends on their names, not on their
+     current values. */
+  if (keywords)
+    {
+      apr_array_header_t *names
+        = svn_sort__hash(keywords, svn_sort_compare_items_lexically,
+                         scratch_pool);
+      int i;
+
+      for (i = 0; i < names->nelts; i++)
+        {
+          const svn_sort__item_t *item = &APR_ARRAY_IDX(names, i,
+                                                        svn_sort__item_t);
+
+          svn_stringbuf_appendbyte(buf, '\0');
+          svn_stringbuf_appendbytes(buf, item->key, item->klen);
+        }
+    }
+
+  return svn_error_trace(svn_checksum(translation, svn_checksum_md5,
+                                      buf->data, buf->len, result_pool));
+}
+
 /* Set *MODIFIED_P to TRUE if (after translation) VERSIONED_FILE_ABSPATH
- * (of VERSIONED_FILE_SIZE bytes) differs from pristine file with checksum
- * PRISTINE_CHECKSUM, else to FALSE if not.
+ * (of VERSIONED_FILE_SIZE bytes, last modified at VERSIONED_FILE_MTIME)
+ * differs from pristine file with checksum PRISTINE_CHECKSUM, else to
+ * FALSE if not.
  *
  * If EXACT_COMPARISON is FALSE, translate VERSIONED_FILE_ABSPATH's EOL
  * style and keywords to repository-normal form according to its properties,
@@ -94,13 +135,23 @@
  * PROPS_MOD should be TRUE if the file's properties have been changed,
  * otherwise FALSE.
  *
+ * If FINGERPRINT is not NULL, set *FINGERPRINT to the svn_checksum_fnv1a_32x4
+ * checksum of VERSIONED_FILE_ABSPATH as stored on disk if it was read as
+ * part of the comparison, or to NULL otherwise.
+ *
+ * If EXACT_COMPARISON is FALSE and VERSIONED_FILE_ABSPATH needs to be
+ * detranslated, use and record the checksum of the detranslated contents
+ * in DB, such that unchanged files will not have to be read again.
+ *
  * DB is a wc_db; use SCRATCH_POOL for temporary allocation.
  */
 static svn_error_t *
 compare_and_verify(svn_boolean_t *modified_p,
+                   svn_checksum_t **fingerprint,
                    svn_wc__db_t *db,
                    const char *versioned_file_abspath,
                    svn_filesize_t versioned_file_size,
+                   apr_time_t versioned_file_mtime,
                    const svn_checksum_t *pristine_checksum,
                    svn_boolean_t has_props,
                    svn_boolean_t props_mod,
@@ -112,12 +163,17 @@ compare_and_verify(svn_boolean_t *modified_p,
   apr_hash_t *keywords;
   svn_boolean_t special = FALSE;
   svn_boolean_t need_translation;
+  const char *pristine_eol_str = NULL;
+  svn_checksum_t *translation = NULL;
   svn_stream_t *v_stream; /* versioned_file */
   svn_checksum_t *v_checksum;
   svn_error_t *err;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(versioned_file_abspath));
 
+  if (fingerprint)
+    *fingerprint = NULL;
+
   if (props_mod)
     has_props = TRUE; /* Maybe it didn't have properties; but it has now */
 
@@ -136,6 +192,11 @@ compare_and_verify(svn_boolean_t *modified_p,
       need_translation = svn_subst_translation_required(eol_style, eol_str,
                                                         keywords, special,
                                                         TRUE);
+
+      if (eol_style == svn_subst_eol_style_native)
+        pristine_eol_str = SVN_SUBST_NATIVE_EOL_STR;
+      else
+        pristine_eol_str = eol_str;
     }
   else
     need_translation = FALSE;
@@ -156,6 +217,32 @@ compare_and_verify(svn_boolean_t *modified_p,
         }
     }
 
+  /* Translated files can't be compared by size.  But if we detranslated
+     the file before and it has not been touched since, we already know
+     the result. */
+  if (need_translation && !special && !exact_comparison)
+    {
+      const svn_checksum_t *recorded_checksum;
+
+      SVN_ERR(get_translation_key(&translation, pristine_eol_str, keywords,
+                                  scratch_pool, scratch_pool));
+      SVN_ERR(svn_wc__db_read_detranslated_checksum(&recorded_checksum, db,
+                                                    versioned_file_abspath,
+                                                    versioned_file_size,
+                                                    versioned_file_mtime,
+                                                    translation,
+                                                    scratch_pool,
+                                                    scratch_pool));
+
+      if (recorded_checksum
+          && recorded_checksum->kind == pristine_checksum->kind)
+        {
+          *modified_p = !svn_checksum_match(recorded_checksum,
+                                            pristine_checksum);
+          return SVN_NO_ERROR;
+        }
+    }
+
   /* ### Other checks possible? */
 
   /* Reading files is necessary. */
@@ -178,15 +265,13 @@ compare_and_verify(svn_boolean_t *modified_p,
         SVN_ERR(err);
       v_stream = svn_stream_from_aprfile2(file, FALSE, scratch_pool);
 
+      if (fingerprint && !exact_comparison)
+        v_stream = svn_stream_checksummed2(v_stream, fingerprint, NULL,
+                                           svn_checksum_fnv1a_32x4, TRUE,
+                                           scratch_pool);
+
       if (need_translation)
         {
-          const char *pristine_eol_str;
-
-          if (eol_style == svn_subst_eol_style_native)
-            pristine_eol_str = SVN_SUBST_NATIVE_EOL_STR;
-          else
-            pristine_eol_str = eol_str;
-
           if (exact_comparison)
             {
               svn_checksum_t *working_checksum;
@@ -261,9 +346,44 @@ compare_and_verify(svn_boolean_t *modified_p,
 
   *modified_p = (! svn_checksum_match(v_checksum, pristine_checksum));
 
+  /* This is merely a cache.  Read-only working copies simply don't get
+     one, so ignore errors. */
+  if (translation)
+    svn_error_clear(svn_wc__db_global_record_detranslated_checksum(
+                      db, versioned_file_abspath, versioned_file_size,
+                      versioned_file_mtime, translation, v_checksum,
+                      scratch_pool));
+
   return SVN_NO_ERROR;
 }
 
+/* Set *FINGERPRINT to the svn_checksum_fnv1a_32x4 checksum of the
+ * contents of LOCAL_ABSPATH as stored on disk, allocated in RESULT_POOL.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+static svn_error_t *
+calculate_fingerprint(svn_checksum_t **fingerprint,
+                      const char *local_abspath,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  svn_stream_t *stream;
+  svn_error_t *err;
+
+  err = svn_stream_open_readonly(&stream, local_abspath,
+                                 scratch_pool, scratch_pool);
+  if (!err)
+    err = svn_stream_contents_checksum(fingerprint, stream,
+                                       svn_checksum_fnv1a_32x4,
+                                       result_pool, scratch_pool);
+
+  /* Convert EACCESS on working copy path to WC specific error code. */
+  if (err && APR_STATUS_IS_EACCES(err->apr_err))
+    return svn_error_create(SVN_ERR_WC_PATH_ACCESS_DENIED, err, NULL);
+
+  return svn_error_trace(err);
+}
+
 svn_error_t *
 svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
                                  svn_wc__db_t *db,
@@ -279,6 +399,7 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
   svn_boolean_t has_props;
   svn_boolean_t props_mod;
   const svn_io_dirent2_t *dirent;
+  svn_checksum_t *fingerprint = NULL;
 
   /* Read the relevant info */
   SVN_ERR(svn_wc__db_read_info(&status, &kind, NULL, NULL, NULL, NULL, NULL,
@@ -358,13 +479,50 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
     }
 
  compare_them:
+  /* The timestamp changed, but the contents may not have, e.g. after a
+     touch or when a build tool rewrote the file.  If we recorded a
+     fingerprint of the unmodified working file, comparing against that
+     is much cheaper than detranslating and checksumming the file.  The
+     fingerprint is only valid for the node as it was when it got
+     recorded, so local property changes rule it out. */
+  if (! exact_comparison
+      && status == svn_wc__db_status_normal
+      && ! props_mod
+      && ! dirent->special)
+    {
+      const svn_checksum_t *recorded_fingerprint;
+
+      SVN_ERR(svn_wc__db_read_fingerprint(&recorded_fingerprint, db,
+                                          local_abspath, dirent->filesize,
+                                          scratch_pool, scratch_pool));
+
+      if (recorded_fingerprint)
+        {
+          SVN_ERR(calculate_fingerprint(&fingerprint, local_abspath,
+                                        scratch_pool, scratch_pool));
+
+          if (svn_checksum_match(fingerprint, recorded_fingerprint))
+            {
+              *modified_p = FALSE;
+              fingerprint = NULL; /* Nothing new to record */
+              goto repair_fileinfo;
+            }
+
+          fingerprint = NULL;
+        }
+    }
+
   /* Check all bytes, and verify checksum if requested. */
-  SVN_ERR(compare_and_verify(modified_p, db,
-                             local_abspath, dirent->filesize,
-                             checksum, has_props, props_mod,
+  SVN_ERR(compare_and_verify(modified_p,
+                             (status == svn_wc__db_status_normal
+                              && ! props_mod)
+                                ? &fingerprint : NULL,
+                             db, local_abspath, dirent->filesize,
+                             dirent->mtime, checksum, has_props, props_mod,
                              exact_comparison,
                              scratch_pool));
 
+ repair_fileinfo:
   if (!*modified_p)
     {
       svn_boolean_t own_lock;
@@ -373,10 +531,17 @@ svn_wc__internal_file_modified_p(svn_boolean_t *modified_p,
       SVN_ERR(svn_wc__db_wclock_owns_lock(&own_lock, db, local_abspath, FALSE,
                                           scratch_pool));
       if (own_lock)
-        SVN_ERR(svn_wc__db_global_record_fileinfo(db, local_abspath,
-                                                  dirent->filesize,
-                                                  dirent->mtime,
-                                                  scratch_pool));
+        {
+          SVN_ERR(svn_wc__db_global_record_fileinfo(db, local_abspath,
+                                                    dirent->filesize,
+                                                    dirent->mtime,
+                                                    scratch_pool));
+          if (fingerprint && ! dirent->special)
+            SVN_ERR(svn_wc__db_global_record_fingerprint(db, local_abspath,
+                                                         dirent->filesize,
+                                                         fingerprint,
+                                                         scratch_pool));
+        }
     }
 
   return SVN_NO_ERROR;
@@ -276,6 +276,83 @@ revert_wc_data(svn_boolean_t *run_wq,
                void *cancel_baton,
                apr_pool_t *scratch_pool);
 
+/* Baton for revert_restore_files(). */
+typedef struct revert_children_baton_t
+{
+  svn_boolean_t *run_wq;
+  svn_wc__db_t *db;
+
+  /* The directory being reverted and its children, as returned by
+     svn_wc__db_read_children_info(). */
+  const char *dir_abspath;
+  apr_hash_t *children;
+
+  svn_boolean_t metadata_only;
+  svn_boolean_t use_commit_times;
+  svn_boolean_t added_keep_local;
+  svn_cancel_func_t cancel_func;
+  void *cancel_baton;
+  svn_wc_notify_func2_t notify_func;
+  void *notify_baton;
+} revert_children_baton_t;
+
+/* Forward definition */
+static svn_error_t *
+revert_restore(svn_boolean_t *run_wq,
+               svn_wc__db_t *db,
+               const char *local_abspath,
+               svn_depth_t depth,
+               svn_boolean_t metadata_only,
+               svn_boolean_t use_commit_times,
+               svn_boolean_t revert_root,
+               svn_boolean_t added_keep_local,
+               const struct svn_wc__db_info_t *info,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               svn_wc_notify_func2_t notify_func,
+               void *notify_baton,
+               apr_pool_t *scratch_pool);
+
+/* Implements svn_wc__with_write_lock_func_t.  Call revert_restore() for
+   the children in BATON, a revert_children_baton_t, that are not
+   directories. */
+static svn_error_t *
+revert_restore_files(void *baton,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  revert_children_baton_t *b = baton;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(scratch_pool, b->children);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      const char *child_name = apr_hash_this_key(hi);
+      const struct svn_wc__db_info_t *child_info = apr_hash_this_val(hi);
+
+      if (child_info->kind == svn_node_dir)
+        continue;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(revert_restore(b->run_wq, b->db,
+                             svn_dirent_join(b->dir_abspath, child_name,
+                                             iterpool),
+                             svn_depth_infinity, b->metadata_only,
+                             b->use_commit_times, FALSE /* revert root */,
+                             b->added_keep_local, child_info,
+                             b->cancel_func, b->cancel_baton,
+                             b->notify_func, b->notify_baton,
+                             iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* Make the working tree under LOCAL_ABSPATH to depth DEPTH match the
    versioned tree.  This function is called after svn_wc__db_op_revert
    has done the database revert and created the revert list.  Notifies
@@ -430,6 +507,7 @@ revert_restore(svn_boolean_t *run_wq,
       apr_pool_t *iterpool = svn_pool_create(scratch_pool);
       apr_hash_t *children, *conflicts;
       apr_hash_index_t *hi;
+      revert_children_baton_t rcb;
 
       SVN_ERR(revert_restore_handle_copied_dirs(NULL, db, local_abspath, FALSE,
                                                 cancel_func, cancel_baton,
@@ -439,13 +517,35 @@ revert_restore(svn_boolean_t *run_wq,
                                             db, local_abspath, FALSE,
                                             scratch_pool, iterpool));
 
+      /* Restore the children that are not directories in a single
+         transaction, then descend into the directories. */
+      rcb.run_wq = run_wq;
+      rcb.db = db;
+      rcb.dir_abspath = local_abspath;
+      rcb.children = children;
+      rcb.metadata_only = metadata_only;
+      rcb.use_commit_times = use_commit_times;
+      rcb.added_keep_local = added_keep_local;
+      rcb.cancel_func = cancel_func;
+      rcb.cancel_baton = cancel_baton;
+      rcb.notify_func = notify_func;
+      rcb.notify_baton = notify_baton;
+
+      SVN_ERR(svn_wc__db_with_txn(db, local_abspath,
+                                  revert_restore_files, &rcb,
+                                  scratch_pool, iterpool));
+
       for (hi = apr_hash_first(scratch_pool, children);
            hi;
            hi = apr_hash_next(hi))
         {
           const char *child_name = apr_hash_this_key(hi);
+          const struct svn_wc__db_info_t *child_info = apr_hash_this_val(hi);
           const char *child_abspath;
 
+          if (child_info->kind != svn_node_dir)
+            continue;
+
           svn_pool_clear(iterpool);
 
           child_abspath = svn_dirent_join(local_abspath, child_name, iterpool);
@@ -454,7 +554,7 @@ revert_restore(svn_boolean_t *run_wq,
                                  db, child_abspath, depth, metadata_only,
                                  use_commit_times, FALSE /* revert root */,
                                  added_keep_local,
-                                 apr_hash_this_val(hi),
+                                 child_info,
                                  cancel_func, cancel_baton,
                                  notify_func, notify_baton,
                                  iterpool));
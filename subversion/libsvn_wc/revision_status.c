@@ -31,16 +31,20 @@
 
 #include "svn_private_config.h"
 
-svn_error_t *
-svn_wc_revision_status2(svn_wc_revision_status_t **result_p,
-                        svn_wc_context_t *wc_ctx,
-                        const char *local_abspath,
-                        const char *trail_url,
-                        svn_boolean_t committed,
-                        svn_cancel_func_t cancel_func,
-                        void *cancel_baton,
-                        apr_pool_t *result_pool,
-                        apr_pool_t *scratch_pool)
+/* Implement svn_wc_revision_status2() and svn_wc__revision_status_fast().
+   If FAST is set, use svn_wc__node_has_stat_changes() to detect
+   modifications. */
+static svn_error_t *
+revision_status(svn_wc_revision_status_t **result_p,
+                svn_wc_context_t *wc_ctx,
+                const char *local_abspath,
+                const char *trail_url,
+                svn_boolean_t committed,
+                svn_boolean_t fast,
+                svn_cancel_func_t cancel_func,
+                void *cancel_baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
 {
   svn_wc_revision_status_t *result = apr_pcalloc(result_pool, sizeof(*result));
 
@@ -63,7 +67,15 @@ svn_wc_revision_status2(svn_wc_revision_status_t **result_p,
                                      committed,
                                      scratch_pool));
 
-  if (!result->modified)
+  if (result->modified)
+    return SVN_NO_ERROR;
+
+  if (fast)
+    SVN_ERR(svn_wc__node_has_stat_changes(&result->modified,
+                                          wc_ctx->db, local_abspath,
+                                          cancel_func, cancel_baton,
+                                          scratch_pool));
+  else
     SVN_ERR(svn_wc__node_has_local_mods(&result->modified, NULL,
                                         wc_ctx->db, local_abspath, TRUE,
                                         cancel_func, cancel_baton,
@@ -71,3 +83,37 @@ svn_wc_revision_status2(svn_wc_revision_status_t **result_p,
 
   return SVN_NO_ERROR;
 }
+
+svn_error_t *
+svn_wc_revision_status2(svn_wc_revision_status_t **result_p,
+                        svn_wc_context_t *wc_ctx,
+                        const char *local_abspath,
+                        const char *trail_url,
+                        svn_boolean_t committed,
+                        svn_cancel_func_t cancel_func,
+                        void *cancel_baton,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(revision_status(result_p, wc_ctx, local_abspath,
+                                         trail_url, committed, FALSE,
+                                         cancel_func, cancel_baton,
+                                         result_pool, scratch_pool));
+}
+
+svn_error_t *
+svn_wc__revision_status_fast(svn_wc_revision_status_t **result_p,
+                             svn_wc_context_t *wc_ctx,
+                             const char *local_abspath,
+                             const char *trail_url,
+                             svn_boolean_t committed,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(revision_status(result_p, wc_ctx, local_abspath,
+                                         trail_url, committed, TRUE,
+                                         cancel_func, cancel_baton,
+                                         result_pool, scratch_pool));
+}
@@ -29,6 +29,7 @@
 #include <apr_pools.h>
 #include <apr_file_io.h>
 #include <apr_hash.h>
+#include <apr_thread_proc.h>
 
 #include "svn_pools.h"
 #include "svn_types.h"
@@ -46,11 +47,15 @@
 
 #include "wc.h"
 #include "props.h"
+#include "fsmonitor.h"
 
 #include "private/svn_sorts_private.h"
+#include "private/svn_string_private.h"
 #include "private/svn_wc_private.h"
 #include "private/svn_fspath.h"
 #include "private/svn_editor.h"
+#include "private/svn_mutex.h"
+#include "private/svn_thread_cond.h"
 
 
 /* The file internal variant of svn_wc_status3_t, with slightly more
@@ -100,6 +105,12 @@ struct walk_status_baton
 
   /* Repository locks, if set. */
   apr_hash_t *repos_locks;
+
+  /* Threads reading directories ahead of the walk, or NULL. */
+  struct dirent_prefetcher_t *prefetcher;
+
+  /* Directories known to be unchanged on disk, or NULL. */
+  svn_wc__fsmonitor_t *fsmonitor;
 };
 
 /*** Editor batons ***/
@@ -970,12 +981,12 @@ is_external_path(apr_hash_t *externals,
    requested.  PATH_KIND is the node kind of NAME as determined by the
    caller.  PATH_SPECIAL is the special status of the path, also determined
    by the caller.
-   PATTERNS points to a list of filename patterns which are marked as ignored.
+   IGNORES holds the filename patterns which are marked as ignored.
    None of these parameter may be NULL.
 
    If NO_IGNORE is TRUE, the item will be added regardless of
    whether it is ignored; otherwise we will only add the item if it
-   does not match any of the patterns in PATTERN or INHERITED_IGNORES.
+   does not match any of the patterns in IGNORES.
 
    Allocate everything in POOL.
 */
@@ -984,7 +995,7 @@ send_unversioned_item(const struct walk_status_baton *wb,
                       const char *local_abspath,
                       const svn_io_dirent2_t *dirent,
                       svn_boolean_t tree_conflicted,
-                      const apr_array_header_t *patterns,
+                      const svn_cstring__glob_list_t *ignores,
                       svn_boolean_t no_ignore,
                       svn_wc_status_func4_t status_func,
                       void *status_baton,
@@ -995,7 +1006,7 @@ send_unversioned_item(const struct walk_status_baton *wb,
   svn_wc__internal_status_t *status;
   const char *base_name = svn_dirent_basename(local_abspath, NULL);
 
-  is_ignored = svn_wc_match_ignore_list(base_name, patterns, scratch_pool);
+  is_ignored = svn_cstring__glob_list_match(ignores, base_name);
   SVN_ERR(assemble_unversioned(&status,
                                wb->db, local_abspath,
                                dirent, tree_conflicted,
@@ -1023,6 +1034,584 @@ send_unversioned_item(const struct walk_status_baton *wb,
   return SVN_NO_ERROR;
 }
 
+/*** Reading directories ahead of the status walk. ***/
+
+/* The walk itself has to stay on one thread: it reads wc.db and must call
+ * STATUS_FUNC in depth-first order.  But most of the time on large working
+ * copies goes into reading the directories and stat()ing their children.
+ * So, whenever the walk enters a directory, it queues the subdirectories
+ * that it will descend into for a few worker threads.  By the time the walk
+ * gets there, their dirents have usually been read already.
+ *
+ * Queued directories form a stack such that the workers read them roughly
+ * in the order the walk will need them.  The walk reads directories that
+ * no worker picked up, yet, by itself. */
+
+#if APR_HAS_THREADS
+
+/* Number of threads reading directories ahead of the walk. */
+#define PREFETCH_THREAD_COUNT 4
+
+/* Maximum number of directories read ahead of the walk. */
+#define PREFETCH_MAX_DIRS 256
+
+/* A directory to read ahead of the walk. */
+typedef struct prefetch_job_t
+{
+  /* Pool with its own allocator that this job and its results live in. */
+  apr_pool_t *pool;
+
+  /* The directory to read. */
+  const char *local_abspath;
+
+  /* Neighbours in the stack of jobs not picked up by any worker, yet. */
+  struct prefetch_job_t *above;
+  struct prefetch_job_t *below;
+
+  /* Set once a worker picked up resp. finished this job. */
+  svn_boolean_t running;
+  svn_boolean_t done;
+
+  /* The result of svn_io_get_dirents3().  Only valid when DONE is set. */
+  apr_hash_t *dirents;
+  svn_error_t *err;
+} prefetch_job_t;
+
+/* The worker threads and the directories in flight. */
+typedef struct dirent_prefetcher_t
+{
+  /* Pool that this struct has been allocated in. */
+  apr_pool_t *pool;
+
+  /* Passed through to svn_io_get_dirents3(). */
+  svn_boolean_t only_check_type;
+
+  /* Worker threads, started on demand. */
+  apr_thread_t **threads;
+  int thread_count;
+  int threads_started;
+  apr_pool_t *thread_pool;
+
+  /* Serializes access to all members below. */
+  svn_mutex__t *mutex;
+
+  /* Signaled when a job has been queued or the workers shall exit. */
+  svn_thread_cond__t *job_queued;
+
+  /* Signaled when a worker finished a job. */
+  svn_thread_cond__t *job_done;
+
+  /* All jobs not claimed by the walk, yet, keyed by their path. */
+  apr_hash_t *jobs;
+
+  /* Top of the stack of jobs not picked up by any worker, yet. */
+  prefetch_job_t *top;
+
+  /* Set when the workers shall terminate. */
+  svn_boolean_t shutdown;
+} dirent_prefetcher_t;
+
+/* Remove JOB from the stack of queued jobs in PREFETCHER.
+
+   This function must be called with PREFETCHER->MUTEX acquired. */
+static void
+unlink_prefetch_job(dirent_prefetcher_t *prefetcher,
+                    prefetch_job_t *job)
+{
+  if (job->above)
+    job->above->below = job->below;
+  else
+    prefetcher->top = job->below;
+
+  if (job->below)
+    job->below->above = job->above;
+
+  job->above = NULL;
+  job->below = NULL;
+}
+
+/* Take the topmost job from the stack in PREFETCHER and return it in *JOB.
+   Block while the stack is empty.  Set *JOB to NULL after PREFETCHER has
+   been shut down.
+
+   This function must be called with PREFETCHER->MUTEX acquired. */
+static svn_error_t *
+take_prefetch_job(prefetch_job_t **job,
+                  dirent_prefetcher_t *prefetcher)
+{
+  while (prefetcher->top == NULL && !prefetcher->shutdown)
+    SVN_ERR(svn_thread_cond__wait(prefetcher->job_queued,
+                                  prefetcher->mutex));
+
+  *job = prefetcher->shutdown ? NULL : prefetcher->top;
+  if (*job)
+    {
+      unlink_prefetch_job(prefetcher, *job);
+      (*job)->running = TRUE;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Mark JOB in PREFETCHER as processed and wake up the walk.
+
+   This function must be called with PREFETCHER->MUTEX acquired. */
+static svn_error_t *
+finish_prefetch_job(dirent_prefetcher_t *prefetcher,
+                    prefetch_job_t *job)
+{
+  job->done = TRUE;
+  return svn_thread_cond__broadcast(prefetcher->job_done);
+}
+
+/* Worker loop: read queued directories in PREFETCHER until it gets shut
+   down. */
+static svn_error_t *
+run_prefetch_worker(dirent_prefetcher_t *prefetcher)
+{
+  while (TRUE)
+    {
+      prefetch_job_t *job;
+
+      SVN_MUTEX__WITH_LOCK(prefetcher->mutex,
+                           take_prefetch_job(&job, prefetcher));
+      if (job == NULL)
+        break;
+
+      job->err = svn_io_get_dirents3(&job->dirents, job->local_abspath,
+                                     prefetcher->only_check_type,
+                                     job->pool, job->pool);
+      SVN_MUTEX__WITH_LOCK(prefetcher->mutex,
+                           finish_prefetch_job(prefetcher, job));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* The plain APR thread function running a worker.
+ * DATA is the dirent_prefetcher_t object to serve. */
+static void * APR_THREAD_FUNC
+prefetch_thread(apr_thread_t *thread, void *data)
+{
+  svn_error_t *err = run_prefetch_worker(data);
+  apr_status_t result = APR_SUCCESS;
+
+  if (err)
+    {
+      result = err->apr_err;
+      svn_error_clear(err);
+    }
+
+  /* End thread explicitly to prevent APR_INCOMPLETE return codes in
+     apr_thread_join(). */
+  apr_thread_exit(thread, result);
+  return NULL;
+}
+
+/* Start all worker threads of PREFETCHER that are not running, yet.
+
+   This function must be called with PREFETCHER->MUTEX acquired. */
+static svn_error_t *
+ensure_prefetch_threads(dirent_prefetcher_t *prefetcher)
+{
+  /* The thread objects can't share the allocator with the walk. */
+  if (prefetcher->thread_pool == NULL)
+    prefetcher->thread_pool
+      = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+
+  while (prefetcher->threads_started < prefetcher->thread_count)
+    {
+      apr_status_t status
+        = apr_thread_create(&prefetcher->threads[prefetcher->threads_started],
+                            NULL, prefetch_thread, prefetcher,
+                            prefetcher->thread_pool);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't create status thread"));
+
+      ++prefetcher->threads_started;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Queue LOCAL_ABSPATH to be read by the workers in PREFETCHER, unless it
+   has been queued before or too many directories are in flight already.
+
+   This function must be called with PREFETCHER->MUTEX acquired. */
+static svn_error_t *
+queue_prefetch_job(dirent_prefetcher_t *prefetcher,
+                   const char *local_abspath)
+{
+  apr_pool_t *job_pool;
+  prefetch_job_t *job;
+
+  if (   apr_hash_count(prefetcher->jobs) >= PREFETCH_MAX_DIRS
+      || svn_hash_gets(prefetcher->jobs, local_abspath))
+    return SVN_NO_ERROR;
+
+  /* Workers allocate the results in the job's pool. */
+  job_pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+  job = apr_pcalloc(job_pool, sizeof(*job));
+  job->pool = job_pool;
+  job->local_abspath = apr_pstrdup(job_pool, local_abspath);
+
+  svn_hash_sets(prefetcher->jobs, job->local_abspath, job);
+  job->below = prefetcher->top;
+  if (job->below)
+    job->below->above = job;
+  prefetcher->top = job;
+
+  SVN_ERR(ensure_prefetch_threads(prefetcher));
+  return svn_thread_cond__signal(prefetcher->job_queued);
+}
+
+/* Remove the job for LOCAL_ABSPATH from PREFETCHER and return it in *JOB,
+   waiting for a worker to finish it if necessary.  If there is no such
+   job or no worker has picked it up, yet, set *JOB to NULL.
+
+   This function must be called with PREFETCHER->MUTEX acquired. */
+static svn_error_t *
+claim_prefetch_job(prefetch_job_t **job,
+                   dirent_prefetcher_t *prefetcher,
+                   const char *local_abspath)
+{
+  *job = svn_hash_gets(prefetcher->jobs, local_abspath);
+  if (*job == NULL)
+    return SVN_NO_ERROR;
+
+  svn_hash_sets(prefetcher->jobs, local_abspath, NULL);
+  if (!(*job)->running)
+    {
+      /* Reading it ourselves is faster than waiting for a worker. */
+      unlink_prefetch_job(prefetcher, *job);
+      svn_pool_destroy((*job)->pool);
+      *job = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  while (!(*job)->done)
+    SVN_ERR(svn_thread_cond__wait(prefetcher->job_done, prefetcher->mutex));
+
+  return SVN_NO_ERROR;
+}
+
+/* Tell the threads of PREFETCHER to terminate.
+
+   This function must be called with PREFETCHER->MUTEX acquired. */
+static svn_error_t *
+request_prefetch_shutdown(dirent_prefetcher_t *prefetcher)
+{
+  prefetcher->shutdown = TRUE;
+  return svn_thread_cond__broadcast(prefetcher->job_queued);
+}
+
+/* Pool cleanup function terminating the threads of the dirent_prefetcher_t
+   given as BATON and releasing all jobs that have not been claimed. */
+static apr_status_t
+cleanup_prefetcher(void *baton)
+{
+  dirent_prefetcher_t *prefetcher = baton;
+  svn_error_t *err = svn_mutex__lock(prefetcher->mutex);
+  apr_hash_index_t *hi;
+  int i;
+
+  if (!err)
+    err = svn_mutex__unlock(prefetcher->mutex,
+                            request_prefetch_shutdown(prefetcher));
+  svn_error_clear(err);
+
+  for (i = 0; i < prefetcher->threads_started; ++i)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, prefetcher->threads[i]);
+    }
+  prefetcher->threads_started = 0;
+
+  for (hi = apr_hash_first(prefetcher->pool, prefetcher->jobs);
+       hi;
+       hi = apr_hash_next(hi))
+    {
+      prefetch_job_t *job = apr_hash_this_val(hi);
+
+      svn_error_clear(job->err);
+      svn_pool_destroy(job->pool);
+    }
+  apr_hash_clear(prefetcher->jobs);
+  prefetcher->top = NULL;
+
+  if (prefetcher->thread_pool)
+    {
+      svn_pool_destroy(prefetcher->thread_pool);
+      prefetcher->thread_pool = NULL;
+    }
+
+  return APR_SUCCESS;
+}
+
+/* Pool cleanup function destroying the pool given as BATON. */
+static apr_status_t
+destroy_job_pool(void *baton)
+{
+  svn_pool_destroy(baton);
+  return APR_SUCCESS;
+}
+
+#endif /* APR_HAS_THREADS */
+
+/* Set WB->PREFETCHER to a new prefetcher living in POOL, if threads are
+   available. */
+static svn_error_t *
+start_prefetcher(struct walk_status_baton *wb,
+                 apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  dirent_prefetcher_t *prefetcher = apr_pcalloc(pool, sizeof(*prefetcher));
+
+  prefetcher->pool = pool;
+  prefetcher->only_check_type = wb->ignore_text_mods;
+  prefetcher->thread_count = PREFETCH_THREAD_COUNT;
+  prefetcher->threads = apr_pcalloc(pool, prefetcher->thread_count
+                                            * sizeof(*prefetcher->threads));
+  prefetcher->jobs = apr_hash_make(pool);
+
+  SVN_ERR(svn_mutex__init(&prefetcher->mutex, TRUE, pool));
+  SVN_ERR(svn_thread_cond__create(&prefetcher->job_queued, pool));
+  SVN_ERR(svn_thread_cond__create(&prefetcher->job_done, pool));
+
+  apr_pool_cleanup_register(pool, prefetcher, cleanup_prefetcher,
+                            apr_pool_cleanup_null);
+
+  wb->prefetcher = prefetcher;
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Terminate the workers of WB->PREFETCHER, if any, and reset it. */
+static void
+finish_prefetcher(struct walk_status_baton *wb)
+{
+#if APR_HAS_THREADS
+  if (wb->prefetcher)
+    apr_pool_cleanup_run(wb->prefetcher->pool, wb->prefetcher,
+                         cleanup_prefetcher);
+#endif
+
+  wb->prefetcher = NULL;
+}
+
+/* Queue those of the SORTED_CHILDREN of LOCAL_ABSPATH for reading ahead
+   that the walk will descend into.  NODES and DIRENTS are the wc.db and
+   on-disk information on the children, as in get_dir_status(). */
+static svn_error_t *
+prefetch_subdirs(const struct walk_status_baton *wb,
+                 const char *local_abspath,
+                 const apr_array_header_t *sorted_children,
+                 apr_hash_t *nodes,
+                 apr_hash_t *dirents,
+                 apr_pool_t *scratch_pool)
+{
+#if APR_HAS_THREADS
+  dirent_prefetcher_t *prefetcher = wb->prefetcher;
+  svn_error_t *err;
+  int i;
+
+  if (!prefetcher)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_mutex__lock(prefetcher->mutex));
+
+  /* Push in reverse order, so the first subdir ends up on top. */
+  err = SVN_NO_ERROR;
+  for (i = sorted_children->nelts - 1; i >= 0 && !err; i--)
+    {
+      const svn_sort__item_t *item = &APR_ARRAY_IDX(sorted_children, i,
+                                                    svn_sort__item_t);
+      const struct svn_wc__db_info_t *info
+        = apr_hash_get(nodes, item->key, item->klen);
+      const svn_io_dirent2_t *dirent
+        = apr_hash_get(dirents, item->key, item->klen);
+
+      const char *child_abspath;
+
+      if (   info && info->has_descendants
+          && info->status != svn_wc__db_status_not_present
+          && info->status != svn_wc__db_status_excluded
+          && info->status != svn_wc__db_status_server_excluded
+          && dirent && dirent->kind == svn_node_dir)
+        {
+          child_abspath = svn_dirent_join(local_abspath, item->key,
+                                          scratch_pool);
+
+          /* Nothing to read ahead if the walk will not read it either. */
+          if (!svn_wc__fsmonitor_dir_unchanged(wb->fsmonitor, child_abspath))
+            err = queue_prefetch_job(prefetcher, child_abspath);
+        }
+    }
+
+  SVN_ERR(svn_mutex__unlock(prefetcher->mutex, err));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the directory LOCAL_ABSPATH like svn_io_get_dirents3() does,
+   using the result of WB->PREFETCHER if available.  Allocate *DIRENTS
+   in RESULT_POOL. */
+static svn_error_t *
+read_dirents(apr_hash_t **dirents,
+             const struct walk_status_baton *wb,
+             const char *local_abspath,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+#if APR_HAS_THREADS
+  if (wb->prefetcher)
+    {
+      prefetch_job_t *job;
+
+      SVN_MUTEX__WITH_LOCK(wb->prefetcher->mutex,
+                           claim_prefetch_job(&job, wb->prefetcher,
+                                              local_abspath));
+      if (job)
+        {
+          /* Hand the job's pool over to RESULT_POOL. */
+          apr_pool_cleanup_register(result_pool, job->pool,
+                                    destroy_job_pool,
+                                    apr_pool_cleanup_null);
+          *dirents = job->dirents;
+          return svn_error_trace(job->err);
+        }
+    }
+#endif
+
+  return svn_error_trace(svn_io_get_dirents3(dirents, local_abspath,
+                                             wb->ignore_text_mods,
+                                             result_pool, scratch_pool));
+}
+
+/* Return the dirents that the children NODES of a directory would have
+   on disk if they exactly matched their wc.db records, i.e. what
+   svn_io_get_dirents3() would return for a directory that
+   svn_wc__fsmonitor_dir_unchanged() considers unchanged.  Allocate the
+   result in RESULT_POOL. */
+static apr_hash_t *
+dirents_from_nodes(apr_hash_t *nodes,
+                   apr_pool_t *result_pool)
+{
+  apr_hash_t *dirents = apr_hash_make(result_pool);
+  apr_hash_index_t *hi;
+
+  for (hi = apr_hash_first(result_pool, nodes); hi; hi = apr_hash_next(hi))
+    {
+      const struct svn_wc__db_info_t *info = apr_hash_this_val(hi);
+      svn_io_dirent2_t *dirent;
+
+      if (info->status != svn_wc__db_status_normal)
+        continue;
+
+      dirent = svn_io_dirent2_create(result_pool);
+      if (info->kind == svn_node_dir)
+        {
+          dirent->kind = svn_node_dir;
+        }
+      else
+        {
+          dirent->kind = svn_node_file;
+#ifdef HAVE_SYMLINK
+          dirent->special = info->special;
+#endif
+          dirent->filesize = info->recorded_size;
+          dirent->mtime = info->recorded_time;
+        }
+
+      svn_hash_sets(dirents, apr_hash_this_key(hi), dirent);
+    }
+
+  return dirents;
+}
+
+/* Return TRUE if the DIRENTS read from disk for a directory exactly match
+   the wc.db NODES of its children and none of them is in conflict, as
+   listed in CONFLICTS.  This is the condition under which a later status
+   walk may use dirents_from_nodes() instead of reading the directory.
+   The DIRENTS must have been read including their size and timestamp. */
+static svn_boolean_t
+dir_matches_nodes(apr_hash_t *nodes,
+                  apr_hash_t *conflicts,
+                  apr_hash_t *dirents,
+                  apr_pool_t *scratch_pool)
+{
+  apr_hash_index_t *hi;
+
+  if (apr_hash_count(conflicts) > 0)
+    return FALSE;
+
+  /* Any unversioned item must be reported. */
+  for (hi = apr_hash_first(scratch_pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+
+      if (!svn_hash_gets(nodes, name)
+          && !svn_wc_is_adm_dir(name, scratch_pool))
+        return FALSE;
+    }
+
+  for (hi = apr_hash_first(scratch_pool, nodes); hi; hi = apr_hash_next(hi))
+    {
+      const struct svn_wc__db_info_t *info = apr_hash_this_val(hi);
+      const svn_io_dirent2_t *dirent
+        = svn_hash_gets(dirents, apr_hash_this_key(hi));
+
+      if (info->conflicted)
+        return FALSE;
+
+      switch (info->status)
+        {
+          case svn_wc__db_status_normal:
+            if (!dirent)
+              return FALSE;
+
+            if (info->kind == svn_node_dir)
+              {
+                if (dirent->kind != svn_node_dir || dirent->special)
+                  return FALSE;
+              }
+            else if (info->kind == svn_node_file
+                     || info->kind == svn_node_symlink)
+              {
+                if (dirent->kind != svn_node_file
+#ifdef HAVE_SYMLINK
+                    || dirent->special != info->special
+#else
+                    || dirent->special
+#endif
+                    || !info->has_checksum
+                    || info->recorded_size == SVN_INVALID_FILESIZE
+                    || info->recorded_time == 0
+                    || info->recorded_size != dirent->filesize
+                    || info->recorded_time != dirent->mtime)
+                  return FALSE;
+              }
+            else
+              return FALSE;
+            break;
+
+          case svn_wc__db_status_not_present:
+          case svn_wc__db_status_excluded:
+          case svn_wc__db_status_server_excluded:
+            if (dirent)
+              return FALSE;
+            break;
+
+          default:
+            return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
 static svn_error_t *
 get_dir_status(const struct walk_status_baton *wb,
                const char *local_abspath,
@@ -1063,8 +1652,8 @@ get_dir_status(const struct walk_status_baton *wb,
  * URL treated with svn_uri_dirname(). ### TODO verify this (externals)
  *
  * If *COLLECTED_IGNORE_PATTERNS is NULL and ignore patterns are needed in this
- * call, then *COLLECTED_IGNORE_PATTERNS will be set to an apr_array_header_t*
- * containing all ignore patterns, as returned by collect_ignore_patterns() on
+ * call, then *COLLECTED_IGNORE_PATTERNS will be set to a glob list of all
+ * ignore patterns, as returned by collect_ignore_patterns() on
  * PARENT_ABSPATH and IGNORE_PATTERNS. If *COLLECTED_IGNORE_PATTERNS is passed
  * non-NULL, it is assumed it already holds those results.
  * This speeds up repeated calls with the same PARENT_ABSPATH.
@@ -1083,7 +1672,7 @@ one_child_status(const struct walk_status_baton *wb,
                  const char *dir_repos_relpath,
                  const char *dir_repos_uuid,
                  svn_boolean_t unversioned_tree_conflicted,
-                 apr_array_header_t **collected_ignore_patterns,
+                 svn_cstring__glob_list_t **collected_ignore_patterns,
                  const apr_array_header_t *ignore_patterns,
                  svn_depth_t depth,
                  svn_boolean_t get_all,
@@ -1172,9 +1761,15 @@ one_child_status(const struct walk_status_baton *wb,
    * as '?  C', where ignored ones show as 'I  C'. */
 
   if (ignore_patterns && ! *collected_ignore_patterns)
-    SVN_ERR(collect_ignore_patterns(collected_ignore_patterns,
-                                    wb->db, parent_abspath, ignore_patterns,
-                                    result_pool, scratch_pool));
+    {
+      apr_array_header_t *patterns;
+
+      SVN_ERR(collect_ignore_patterns(&patterns,
+                                      wb->db, parent_abspath, ignore_patterns,
+                                      scratch_pool, scratch_pool));
+      *collected_ignore_patterns = svn_cstring__glob_list_create(patterns,
+                                                                 result_pool);
+    }
 
   SVN_ERR(send_unversioned_item(wb,
                                 local_abspath,
@@ -1232,8 +1827,9 @@ get_dir_status(const struct walk_status_baton *wb,
   const char *dir_repos_uuid;
   apr_hash_t *dirents, *nodes, *conflicts, *all_children;
   apr_array_header_t *sorted_children;
-  apr_array_header_t *collected_ignore_patterns = NULL;
+  svn_cstring__glob_list_t *collected_ignore_patterns = NULL;
   apr_pool_t *iterpool;
+  svn_boolean_t unchanged;
   svn_error_t *err;
   int i;
 
@@ -1245,11 +1841,18 @@ get_dir_status(const struct walk_status_baton *wb,
 
   iterpool = svn_pool_create(scratch_pool);
 
-  if (wb->check_working_copy)
+  /* Only trust the monitor if the directory itself is still there. */
+  unchanged = (wb->check_working_copy
+               && dirent && dirent->kind == svn_node_dir
+               && svn_wc__fsmonitor_dir_unchanged(wb->fsmonitor,
+                                                  local_abspath));
+
+  if (unchanged)
+    dirents = NULL; /* Constructed from NODES below. */
+  else if (wb->check_working_copy)
     {
-      err = svn_io_get_dirents3(&dirents, local_abspath,
-                                wb->ignore_text_mods /* only_check_type*/,
-                                scratch_pool, iterpool);
+      err = read_dirents(&dirents, wb, local_abspath,
+                         scratch_pool, iterpool);
       if (err
           && (APR_STATUS_IS_ENOENT(err->apr_err)
               || SVN__APR_STATUS_IS_ENOTDIR(err->apr_err)))
@@ -1283,6 +1886,13 @@ get_dir_status(const struct walk_status_baton *wb,
                                         !wb->check_working_copy,
                                         scratch_pool, iterpool));
 
+  if (unchanged)
+    dirents = dirents_from_nodes(nodes, scratch_pool);
+  else if (wb->check_working_copy && !wb->ignore_text_mods)
+    svn_wc__fsmonitor_set_dir_clean(wb->fsmonitor, local_abspath,
+                                    dir_matches_nodes(nodes, conflicts,
+                                                      dirents, iterpool));
+
   all_children = apr_hash_overlay(scratch_pool, nodes, dirents);
   if (apr_hash_count(conflicts) > 0)
     all_children = apr_hash_overlay(scratch_pool, conflicts, all_children);
@@ -1340,6 +1950,10 @@ get_dir_status(const struct walk_status_baton *wb,
   sorted_children = svn_sort__hash(all_children,
                                    svn_sort_compare_items_lexically,
                                    scratch_pool);
+  if (depth == svn_depth_infinity)
+    SVN_ERR(prefetch_subdirs(wb, local_abspath, sorted_children, nodes,
+                             dirents, iterpool));
+
   for (i = 0; i < sorted_children->nelts; i++)
     {
       const void *key;
@@ -1417,7 +2031,7 @@ get_child_status(const struct walk_status_baton *wb,
   const char *dir_repos_relpath;
   const char *dir_repos_uuid;
   const struct svn_wc__db_info_t *dir_info;
-  apr_array_header_t *collected_ignore_patterns = NULL;
+  svn_cstring__glob_list_t *collected_ignore_patterns = NULL;
   const char *parent_abspath = svn_dirent_dirname(local_abspath,
                                                   scratch_pool);
 
@@ -2513,6 +3127,8 @@ svn_wc__get_status_editor(const svn_delta_editor_t **editor,
   eb->wb.check_working_copy = check_working_copy;
   eb->wb.repos_locks      = NULL;
   eb->wb.repos_root       = NULL;
+  eb->wb.prefetcher       = NULL;
+  eb->wb.fsmonitor        = NULL;
 
   SVN_ERR(svn_wc__db_externals_defined_below(&eb->wb.externals,
                                              wc_ctx->db, eb->target_abspath,
@@ -2644,6 +3260,8 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
   wb.check_working_copy = TRUE;
   wb.repos_root = NULL;
   wb.repos_locks = NULL;
+  wb.prefetcher = NULL;
+  wb.fsmonitor = NULL;
 
   /* Use the caller-provided ignore patterns if provided; the build-time
      configured defaults otherwise. */
@@ -2690,19 +3308,36 @@ svn_wc__internal_walk_status(svn_wc__db_t *db,
       && info->status != svn_wc__db_status_excluded
       && info->status != svn_wc__db_status_server_excluded)
     {
-      SVN_ERR(get_dir_status(&wb,
-                             local_abspath,
-                             FALSE /* skip_root */,
-                             NULL, NULL, NULL,
-                             info,
-                             dirent,
-                             ignore_patterns,
-                             depth,
-                             get_all,
-                             no_ignore,
-                             status_func, status_baton,
-                             cancel_func, cancel_baton,
-                             scratch_pool));
+      const char *wcroot_abspath;
+
+      /* Let a filesystem monitor tell us which directories to skip. */
+      SVN_ERR(svn_wc__db_get_wcroot(&wcroot_abspath, db, local_abspath,
+                                    scratch_pool, scratch_pool));
+      SVN_ERR(svn_wc__fsmonitor_open(&wb.fsmonitor, db, wcroot_abspath,
+                                     scratch_pool, scratch_pool));
+
+      /* Read the directories of deep walks ahead on other threads. */
+      if (depth == svn_depth_infinity || depth == svn_depth_unknown)
+        SVN_ERR(start_prefetcher(&wb, scratch_pool));
+
+      err = get_dir_status(&wb,
+                           local_abspath,
+                           FALSE /* skip_root */,
+                           NULL, NULL, NULL,
+                           info,
+                           dirent,
+                           ignore_patterns,
+                           depth,
+                           get_all,
+                           no_ignore,
+                           status_func, status_baton,
+                           cancel_func, cancel_baton,
+                           scratch_pool);
+
+      finish_prefetcher(&wb);
+      SVN_ERR(err);
+
+      SVN_ERR(svn_wc__fsmonitor_close(wb.fsmonitor, scratch_pool));
     }
   else
     {
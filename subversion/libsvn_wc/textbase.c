@@ -23,6 +23,7 @@
 
 #include "svn_dirent_uri.h"
 #include "svn_path.h"
+#include "svn_pools.h"
 
 #include "textbase.h"
 #include "wc.h"
@@ -463,11 +464,15 @@ svn_wc__textbase_prepare_install(svn_stream_t **stream_p,
   return SVN_NO_ERROR;
 }
 
-/* A baton for use with textbase_walk_cb() and textbase_sync_cb(). */
+/* The number of text-bases that svn_wc__textbase_sync() asks its fetch
+   callback for at once. */
+#define TEXTBASE_FETCH_BATCH_SIZE 32
+
+/* A baton for use with textbase_walk_cb() and textbase_fetch_cb(). */
 typedef struct textbase_sync_baton_t
 {
   svn_wc__db_t *db;
-  svn_wc_textbase_fetch_cb_t fetch_callback;
+  svn_wc__textbase_fetch_batch_cb_t fetch_callback;
   void *fetch_baton;
   svn_wc_notify_func2_t notify_func;
   void *notify_baton;
@@ -517,13 +522,10 @@ textbase_walk_cb(svn_boolean_t *referenced_p,
   return SVN_NO_ERROR;
 }
 
-/* Implements svn_wc__db_textbase_fetch_cb_t. */
+/* Implements svn_wc__textbase_fetch_batch_cb_t. */
 static svn_error_t *
 textbase_fetch_cb(void *baton,
-                  const char *repos_root_url,
-                  const char *repos_relpath,
-                  svn_revnum_t revision,
-                  svn_stream_t *contents,
+                  const apr_array_header_t *fetches,
                   svn_cancel_func_t cancel_func,
                   void *cancel_baton,
                   apr_pool_t *scratch_pool)
@@ -532,38 +534,51 @@ textbase_fetch_cb(void *baton,
 
   if (b->notify_func)
     {
-      svn_wc_notify_t *notify
-        = svn_wc_create_notify(".", svn_wc_notify_hydrating_file,
-                               scratch_pool);
-      notify->revision = revision;
-      notify->url = svn_path_url_add_component2(repos_root_url,
-                                                repos_relpath,
-                                                scratch_pool);
-      b->notify_func(b->notify_baton, notify, scratch_pool);
+      apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+      int i;
+
+      for (i = 0; i < fetches->nelts; i++)
+        {
+          const svn_wc__textbase_fetch_t *fetch
+            = APR_ARRAY_IDX(fetches, i, const svn_wc__textbase_fetch_t *);
+          svn_wc_notify_t *notify;
+
+          svn_pool_clear(iterpool);
+
+          notify = svn_wc_create_notify(".", svn_wc_notify_hydrating_file,
+                                        iterpool);
+          notify->revision = fetch->revision;
+          notify->url = svn_path_url_add_component2(fetch->repos_root_url,
+                                                    fetch->repos_relpath,
+                                                    iterpool);
+          b->notify_func(b->notify_baton, notify, iterpool);
+        }
+      svn_pool_destroy(iterpool);
     }
 
-  SVN_ERR(b->fetch_callback(b->fetch_baton, repos_root_url,
-                            repos_relpath, revision, contents,
+  SVN_ERR(b->fetch_callback(b->fetch_baton, fetches,
                             cancel_func, cancel_baton, scratch_pool));
 
   return SVN_NO_ERROR;
 }
 
 svn_error_t *
-svn_wc_textbase_sync(svn_wc_context_t *wc_ctx,
-                     const char *local_abspath,
-                     svn_boolean_t allow_hydrate,
-                     svn_boolean_t allow_dehydrate,
-                     svn_wc_textbase_fetch_cb_t fetch_callback,
-                     void *fetch_baton,
-                     svn_cancel_func_t cancel_func,
-                     void *cancel_baton,
-                     svn_wc_notify_func2_t notify_func,
-                     void *notify_baton,
-                     apr_pool_t *scratch_pool)
+svn_wc__textbase_sync(svn_wc_context_t *wc_ctx,
+                      const char *local_abspath,
+                      svn_boolean_t allow_hydrate,
+                      svn_boolean_t allow_dehydrate,
+                      svn_wc__textbase_fetch_batch_cb_t fetch_callback,
+                      void *fetch_baton,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      svn_wc_notify_func2_t notify_func,
+                      void *notify_baton,
+                      apr_pool_t *scratch_pool)
 {
   svn_boolean_t store_pristine;
   textbase_sync_baton_t baton = {0};
+  apr_int64_t cache_size_mb;
+  svn_error_t *err;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
 
@@ -572,6 +587,16 @@ svn_wc_textbase_sync(svn_wc_context_t *wc_ctx,
   if (store_pristine)
     return SVN_NO_ERROR;
 
+  err = svn_config_get_int64(svn_wc__db_get_config(wc_ctx->db),
+                             &cache_size_mb,
+                             SVN_CONFIG_SECTION_WORKING_COPY,
+                             SVN_CONFIG_OPTION_TEXTBASE_CACHE_SIZE, 0);
+  if (err || cache_size_mb < 0 || cache_size_mb > APR_INT32_MAX)
+    {
+      svn_error_clear(err);
+      cache_size_mb = 0;
+    }
+
   baton.db = wc_ctx->db;
   baton.fetch_callback = fetch_callback;
   baton.fetch_baton = fetch_baton;
@@ -593,6 +618,8 @@ svn_wc_textbase_sync(svn_wc_context_t *wc_ctx,
 
   SVN_ERR(svn_wc__db_textbase_sync(wc_ctx->db, local_abspath,
                                    allow_hydrate, allow_dehydrate,
+                                   TEXTBASE_FETCH_BATCH_SIZE,
+                                   (apr_uint64_t)cache_size_mb * 1024 * 1024,
                                    textbase_fetch_cb, &baton,
                                    cancel_func, cancel_baton,
                                    scratch_pool));
@@ -607,3 +634,72 @@ svn_wc_textbase_sync(svn_wc_context_t *wc_ctx,
 
   return SVN_NO_ERROR;
 }
+
+/* A baton for use with textbase_fetch_one_by_one_cb(). */
+typedef struct textbase_fetch_one_baton_t
+{
+  svn_wc_textbase_fetch_cb_t fetch_callback;
+  void *fetch_baton;
+} textbase_fetch_one_baton_t;
+
+/* Implements svn_wc__textbase_fetch_batch_cb_t on top of a
+ * svn_wc_textbase_fetch_cb_t. */
+static svn_error_t *
+textbase_fetch_one_by_one_cb(void *baton,
+                             const apr_array_header_t *fetches,
+                             svn_cancel_func_t cancel_func,
+                             void *cancel_baton,
+                             apr_pool_t *scratch_pool)
+{
+  textbase_fetch_one_baton_t *b = baton;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  for (i = 0; i < fetches->nelts; i++)
+    {
+      const svn_wc__textbase_fetch_t *fetch
+        = APR_ARRAY_IDX(fetches, i, const svn_wc__textbase_fetch_t *);
+
+      svn_pool_clear(iterpool);
+
+      /* Once a fetch failed, only close the streams that are left. */
+      if (err)
+        err = svn_error_compose_create(err, svn_stream_close(fetch->contents));
+      else
+        err = b->fetch_callback(b->fetch_baton, fetch->repos_root_url,
+                                fetch->repos_relpath, fetch->revision,
+                                fetch->contents, cancel_func, cancel_baton,
+                                iterpool);
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(err);
+}
+
+svn_error_t *
+svn_wc_textbase_sync(svn_wc_context_t *wc_ctx,
+                     const char *local_abspath,
+                     svn_boolean_t allow_hydrate,
+                     svn_boolean_t allow_dehydrate,
+                     svn_wc_textbase_fetch_cb_t fetch_callback,
+                     void *fetch_baton,
+                     svn_cancel_func_t cancel_func,
+                     void *cancel_baton,
+                     svn_wc_notify_func2_t notify_func,
+                     void *notify_baton,
+                     apr_pool_t *scratch_pool)
+{
+  textbase_fetch_one_baton_t baton;
+
+  baton.fetch_callback = fetch_callback;
+  baton.fetch_baton = fetch_baton;
+
+  return svn_error_trace(svn_wc__textbase_sync(wc_ctx, local_abspath,
+                                               allow_hydrate, allow_dehydrate,
+                                               textbase_fetch_one_by_one_cb,
+                                               &baton,
+                                               cancel_func, cancel_baton,
+                                               notify_func, notify_baton,
+                                               scratch_pool));
+}
@@ -49,6 +49,7 @@
 #include "translate.h"
 #include "workqueue.h"
 #include "textbase.h"
+#include "write_behind.h"
 
 #include "private/svn_subr_private.h"
 #include "private/svn_wc_private.h"
@@ -262,6 +263,10 @@ struct edit_baton
   /* After closing the root directory a copy of its edited value */
   svn_boolean_t edited;
 
+  /* Worker thread writing the new pristines and working files.  NULL if
+     threading is not available. */
+  svn_wc__write_behind_t *write_behind;
+
   apr_pool_t *pool;
 };
 
@@ -789,6 +794,10 @@ struct file_baton
 
   /* Writer with the provisioned content of the working file.  May be NULL. */
   svn_wc__working_file_writer_t *file_writer;
+
+  /* Pool for everything that EDIT_BATON->WRITE_BEHIND may access while
+     installing the new text.  NULL before apply_textdelta(). */
+  apr_pool_t *install_pool;
 };
 
 
@@ -1031,8 +1040,12 @@ window_handler(svn_txdelta_window_t *window, void *baton)
 
   if (err)
     {
-      /* We failed to apply the delta; clean up the temporary file if it
-         already created by lazy_open_target(). */
+      /* We failed to apply the delta.  Make sure the worker is no longer
+         writing the target streams ... */
+      svn_error_clear(svn_wc__write_behind_wait(fb->edit_baton->write_behind));
+
+      /* ... and clean up the temporary file if it already created by
+         lazy_open_target(). */
       if (hb->install_data)
         {
           svn_error_clear(svn_wc__db_pristine_install_abort(hb->install_data,
@@ -3803,7 +3816,7 @@ lazy_open_target(svn_stream_t **stream_p,
     }
   else
     {
-      SVN_ERR(open_working_file_writer(&file_writer, fb, fb->pool,
+      SVN_ERR(open_working_file_writer(&file_writer, fb, fb->install_pool,
                                        scratch_pool));
     }
 
@@ -3825,7 +3838,9 @@ lazy_open_target(svn_stream_t **stream_p,
                  result_pool);
     }
 
-  *stream_p = stream;
+  /* Let the worker do the checksumming, translation and writing. */
+  *stream_p = svn_wc__write_behind_stream(fb->edit_baton->write_behind,
+                                          stream, result_pool);
   return SVN_NO_ERROR;
 }
 
@@ -3838,9 +3853,9 @@ apply_textdelta(void *file_baton,
                 void **handler_baton)
 {
   struct file_baton *fb = file_baton;
-  apr_pool_t *handler_pool = svn_pool_create(fb->pool);
-  struct handler_baton *hb = apr_pcalloc(handler_pool, sizeof(*hb));
   struct edit_baton *eb = fb->edit_baton;
+  apr_pool_t *handler_pool;
+  struct handler_baton *hb;
   const svn_checksum_t *recorded_base_checksum;
   svn_checksum_t *expected_base_checksum;
   svn_stream_t *source;
@@ -3853,6 +3868,12 @@ apply_textdelta(void *file_baton,
       return SVN_NO_ERROR;
     }
 
+  /* The target streams will be written by EB->WRITE_BEHIND, hence they
+     must not share an allocator with the rest of the edit. */
+  fb->install_pool = svn_wc__write_behind_pool(eb->write_behind, fb->pool);
+  handler_pool = svn_pool_create(fb->install_pool);
+  hb = apr_pcalloc(handler_pool, sizeof(*hb));
+
   SVN_ERR(mark_file_edited(fb, pool));
 
   /* Parse checksum or sets expected_base_checksum to NULL */
@@ -5086,6 +5107,11 @@ close_edit(void *edit_baton,
                          eb->cancel_func, eb->cancel_baton,
                          eb->pool));
 
+  SVN_ERR(svn_wc__reclaim_pristines_if_enabled(eb->db, eb->wcroot_abspath,
+                                               eb->cancel_func,
+                                               eb->cancel_baton,
+                                               eb->pool));
+
   /* The edit is over, free its pool.
      ### No, this is wrong.  Who says this editor/baton won't be used
      again?  But the change is not merely to remove this call.  We
@@ -5210,6 +5236,8 @@ make_editor(svn_revnum_t *target_revision,
   eb->dir_dirents              = apr_hash_make(edit_pool);
   eb->ext_patterns             = preserved_exts;
 
+  SVN_ERR(svn_wc__write_behind_create(&eb->write_behind, edit_pool));
+
   apr_pool_cleanup_register(edit_pool, eb, cleanup_edit_baton,
                             apr_pool_cleanup_null);
 
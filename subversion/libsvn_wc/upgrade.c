@@ -44,6 +44,7 @@
 #include "private/svn_wc_private.h"
 #include "private/svn_sqlite.h"
 #include "private/svn_token.h"
+#include "private/svn_task.h"
 
 /* WC-1.0 administrative area extensions */
 #define SVN_WC__BASE_EXT      ".svn-base" /* for text and prop bases */
@@ -74,6 +75,10 @@
 #define ADM_LOG "log"
 #define ADM_LOCK "lock"
 
+/* Maximum number of text-bases that get copied into the pristine store
+   concurrently. */
+#define UPGRADE_TEXT_BASE_THREAD_COUNT 4
+
 /* New pristine location */
 #define PRISTINE_STORAGE_RELPATH "pristine"
 #define PRISTINE_STORAGE_EXT ".svn-base"
@@ -1000,10 +1005,219 @@ remove_suffix(const char *str, const char *suffix, apr_pool_t *result_pool)
   return NULL;
 }
 
+/* A text-base file to copy into the pristine store. */
+typedef struct text_base_job_t
+{
+  const char *basename;
+  const char *text_base_path;
+  const char *new_wcroot_abspath;
+} text_base_job_t;
+
+/* The copy of a text_base_job_t in a temporary file, not yet moved into
+   the pristine store. */
+typedef struct text_base_copy_t
+{
+  const char *basename;
+  const char *temp_path;
+  svn_checksum_t *md5_checksum;
+  svn_checksum_t *sha1_checksum;
+  svn_filesize_t size;
+} text_base_copy_t;
+
+/* All text-bases of a single directory to migrate. */
+typedef struct text_base_batch_t
+{
+  /* Array of text_base_job_t. */
+  apr_array_header_t *jobs;
+
+  svn_sqlite__db_t *sdb;
+  const char *new_wcroot_abspath;
+
+  /* Maps versioned file names to svn_wc__text_base_info_t. */
+  apr_hash_t *text_bases_info;
+} text_base_batch_t;
+
+/* Implements svn_task__process_func_t.  PROCESS_BATON is the
+   text_base_job_t to copy.  Runs in a worker thread. */
+static svn_error_t *
+copy_text_base_process(void **result,
+                       svn_task__t *task,
+                       void *thread_context,
+                       void *process_baton,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  const text_base_job_t *job = process_baton;
+  text_base_copy_t *copy = apr_pcalloc(result_pool, sizeof(*copy));
+  apr_finfo_t finfo;
+  svn_stream_t *read_stream;
+  svn_stream_t *result_stream;
+
+  /* Create a copy and calculate a checksum in one step */
+  SVN_ERR(svn_stream_open_unique(&result_stream, &copy->temp_path,
+                                 job->new_wcroot_abspath,
+                                 svn_io_file_del_none,
+                                 result_pool, scratch_pool));
+
+  SVN_ERR(svn_stream_open_readonly(&read_stream, job->text_base_path,
+                                   scratch_pool, scratch_pool));
+
+  read_stream = svn_stream_checksummed2(read_stream, &copy->md5_checksum,
+                                        NULL, svn_checksum_md5,
+                                        TRUE, result_pool);
+
+  read_stream = svn_stream_checksummed2(read_stream, &copy->sha1_checksum,
+                                        NULL, svn_checksum_sha1,
+                                        TRUE, result_pool);
+
+  /* This calculates the hash, creates a copy and closes the stream */
+  SVN_ERR(svn_stream_copy3(read_stream, result_stream,
+                           cancel_func, cancel_baton, scratch_pool));
+
+  SVN_ERR(svn_io_stat(&finfo, job->text_base_path, APR_FINFO_SIZE,
+                      scratch_pool));
+
+  copy->basename = apr_pstrdup(result_pool, job->basename);
+  copy->size = finfo.size;
+  *result = copy;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  OUTPUT_BATON is the
+   text_base_batch_t.  Runs in the thread that performs the upgrade,
+   in directory order, and does all the database work. */
+static svn_error_t *
+copy_text_base_output(svn_task__t *task,
+                      void *result,
+                      void *output_baton,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  text_base_batch_t *batch = output_baton;
+  const text_base_copy_t *copy = result;
+  const char *pristine_path;
+  svn_sqlite__stmt_t *stmt;
+
+  /* Insert a row into the pristine table. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, batch->sdb,
+                                    STMT_INSERT_OR_IGNORE_PRISTINE_F31));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, copy->sha1_checksum,
+                                    scratch_pool));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 2, copy->md5_checksum,
+                                    scratch_pool));
+  SVN_ERR(svn_sqlite__bind_int64(stmt, 3, copy->size));
+  SVN_ERR(svn_sqlite__insert(NULL, stmt));
+
+  SVN_ERR(svn_wc__db_pristine_get_future_path(&pristine_path,
+                                              batch->new_wcroot_abspath,
+                                              copy->sha1_checksum,
+                                              scratch_pool, scratch_pool));
+
+  /* Ensure any sharding directories exist. */
+  SVN_ERR(svn_wc__ensure_directory(svn_dirent_dirname(pristine_path,
+                                                      scratch_pool),
+                                   scratch_pool));
+
+  /* Now move the file into the pristine store, overwriting
+     existing files with the same checksum. */
+  SVN_ERR(svn_io_file_move(copy->temp_path, pristine_path, scratch_pool));
+
+  /* Add the checksums for this text-base to the batch's TEXT_BASES_INFO. */
+  {
+    const char *versioned_file_name;
+    svn_boolean_t is_revert_base;
+    svn_wc__text_base_info_t *info;
+    svn_wc__text_base_file_info_t *file_info;
+
+    /* Determine the versioned file name and whether this is a normal base
+     * or a revert base. */
+    versioned_file_name = remove_suffix(copy->basename,
+                                        SVN_WC__REVERT_EXT, result_pool);
+    if (versioned_file_name)
+      {
+        is_revert_base = TRUE;
+      }
+    else
+      {
+        versioned_file_name = remove_suffix(copy->basename,
+                                            SVN_WC__BASE_EXT, result_pool);
+        is_revert_base = FALSE;
+      }
+
+    if (! versioned_file_name)
+      {
+         /* Some file that doesn't end with .svn-base or .svn-revert.
+            No idea why that would be in our administrative area, but
+            we shouldn't segfault on this case.
+
+            Note that we already copied this file in the pristine store,
+            but the next cleanup will take care of that.
+          */
+        return SVN_NO_ERROR;
+      }
+
+    /* Create a new info struct for this versioned file, or fill in the
+     * existing one if this is the second text-base we've found for it. */
+    info = svn_hash_gets(batch->text_bases_info, versioned_file_name);
+    if (info == NULL)
+      info = apr_pcalloc(result_pool, sizeof (*info));
+    file_info = (is_revert_base ? &info->revert_base : &info->normal_base);
+
+    file_info->sha1_checksum = svn_checksum_dup(copy->sha1_checksum,
+                                                result_pool);
+    file_info->md5_checksum = svn_checksum_dup(copy->md5_checksum,
+                                               result_pool);
+    svn_hash_sets(batch->text_bases_info, versioned_file_name, info);
+  }
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  PROCESS_BATON is the
+   text_base_batch_t; add a sub-task for each of its jobs. */
+static svn_error_t *
+copy_text_bases_process(void **result,
+                        svn_task__t *task,
+                        void *thread_context,
+                        void *process_baton,
+                        svn_cancel_func_t cancel_func,
+                        void *cancel_baton,
+                        apr_pool_t *result_pool,
+                        apr_pool_t *scratch_pool)
+{
+  text_base_batch_t *batch = process_baton;
+  int i;
+
+  for (i = 0; i < batch->jobs->nelts; i++)
+    {
+      apr_pool_t *process_pool = svn_task__create_process_pool(task);
+      text_base_job_t *job
+        = apr_pmemdup(process_pool,
+                      &APR_ARRAY_IDX(batch->jobs, i, text_base_job_t),
+                      sizeof(*job));
+
+      SVN_ERR(svn_task__add(task, process_pool, NULL,
+                            copy_text_base_process, job,
+                            copy_text_base_output, batch));
+    }
+
+  *result = NULL;
+  return SVN_NO_ERROR;
+}
+
 /* Copy all the text-base files from the administrative area of WC directory
    DIR_ABSPATH into the pristine store of SDB which is located in directory
    NEW_WCROOT_ABSPATH.
 
+   Reading, checksumming and copying the text-bases happens in up to
+   UPGRADE_TEXT_BASE_THREAD_COUNT worker threads while all database
+   updates are made by the calling thread.
+
    Set *TEXT_BASES_INFO to a new hash, allocated in RESULT_POOL, that maps
    (const char *) name of the versioned file to (svn_wc__text_base_info_t *)
    information about the pristine text. */
@@ -1016,8 +1230,8 @@ migrate_text_bases(apr_hash_t **text_bases_info,
                    apr_pool_t *scratch_pool)
 {
   apr_hash_t *dirents;
-  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
   apr_hash_index_t *hi;
+  text_base_batch_t *batch;
   const char *text_base_dir = svn_wc__adm_child(dir_abspath,
                                                 TEXT_BASE_SUBDIR,
                                                 scratch_pool);
@@ -1027,122 +1241,35 @@ migrate_text_bases(apr_hash_t **text_bases_info,
   /* Iterate over the text-base files */
   SVN_ERR(svn_io_get_dirents3(&dirents, text_base_dir, TRUE,
                               scratch_pool, scratch_pool));
+
+  batch = apr_pcalloc(scratch_pool, sizeof(*batch));
+  batch->jobs = apr_array_make(scratch_pool, apr_hash_count(dirents),
+                               sizeof(text_base_job_t));
+  batch->sdb = sdb;
+  batch->new_wcroot_abspath = new_wcroot_abspath;
+  batch->text_bases_info = *text_bases_info;
+
   for (hi = apr_hash_first(scratch_pool, dirents); hi;
        hi = apr_hash_next(hi))
     {
-      const char *text_base_basename = apr_hash_this_key(hi);
-      svn_checksum_t *md5_checksum;
-      svn_checksum_t *sha1_checksum;
-
-      svn_pool_clear(iterpool);
-
-      /* Calculate its checksums and copy it to the pristine store */
-      {
-        const char *pristine_path;
-        const char *text_base_path;
-        const char *temp_path;
-        svn_sqlite__stmt_t *stmt;
-        apr_finfo_t finfo;
-        svn_stream_t *read_stream;
-        svn_stream_t *result_stream;
-
-        text_base_path = svn_dirent_join(text_base_dir, text_base_basename,
-                                         iterpool);
-
-        /* Create a copy and calculate a checksum in one step */
-        SVN_ERR(svn_stream_open_unique(&result_stream, &temp_path,
-                                       new_wcroot_abspath,
-                                       svn_io_file_del_none,
-                                       iterpool, iterpool));
-
-        SVN_ERR(svn_stream_open_readonly(&read_stream, text_base_path,
-                                           iterpool, iterpool));
-
-        read_stream = svn_stream_checksummed2(read_stream, &md5_checksum,
-                                              NULL, svn_checksum_md5,
-                                              TRUE, iterpool);
-
-        read_stream = svn_stream_checksummed2(read_stream, &sha1_checksum,
-                                              NULL, svn_checksum_sha1,
-                                              TRUE, iterpool);
-
-        /* This calculates the hash, creates a copy and closes the stream */
-        SVN_ERR(svn_stream_copy3(read_stream, result_stream,
-                                 NULL, NULL, iterpool));
-
-        SVN_ERR(svn_io_stat(&finfo, text_base_path, APR_FINFO_SIZE, iterpool));
-
-        /* Insert a row into the pristine table. */
-        SVN_ERR(svn_sqlite__get_statement(&stmt, sdb,
-                                          STMT_INSERT_OR_IGNORE_PRISTINE_F31));
-        SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, iterpool));
-        SVN_ERR(svn_sqlite__bind_checksum(stmt, 2, md5_checksum, iterpool));
-        SVN_ERR(svn_sqlite__bind_int64(stmt, 3, finfo.size));
-        SVN_ERR(svn_sqlite__insert(NULL, stmt));
-
-        SVN_ERR(svn_wc__db_pristine_get_future_path(&pristine_path,
-                                                    new_wcroot_abspath,
-                                                    sha1_checksum,
-                                                    iterpool, iterpool));
-
-        /* Ensure any sharding directories exist. */
-        SVN_ERR(svn_wc__ensure_directory(svn_dirent_dirname(pristine_path,
-                                                            iterpool),
-                                         iterpool));
-
-        /* Now move the file into the pristine store, overwriting
-           existing files with the same checksum. */
-        SVN_ERR(svn_io_file_move(temp_path, pristine_path, iterpool));
-      }
+      text_base_job_t *job = apr_array_push(batch->jobs);
 
-      /* Add the checksums for this text-base to *TEXT_BASES_INFO. */
-      {
-        const char *versioned_file_name;
-        svn_boolean_t is_revert_base;
-        svn_wc__text_base_info_t *info;
-        svn_wc__text_base_file_info_t *file_info;
-
-        /* Determine the versioned file name and whether this is a normal base
-         * or a revert base. */
-        versioned_file_name = remove_suffix(text_base_basename,
-                                            SVN_WC__REVERT_EXT, result_pool);
-        if (versioned_file_name)
-          {
-            is_revert_base = TRUE;
-          }
-        else
-          {
-            versioned_file_name = remove_suffix(text_base_basename,
-                                                SVN_WC__BASE_EXT, result_pool);
-            is_revert_base = FALSE;
-          }
-
-        if (! versioned_file_name)
-          {
-             /* Some file that doesn't end with .svn-base or .svn-revert.
-                No idea why that would be in our administrative area, but
-                we shouldn't segfault on this case.
-
-                Note that we already copied this file in the pristine store,
-                but the next cleanup will take care of that.
-              */
-            continue;
-          }
-
-        /* Create a new info struct for this versioned file, or fill in the
-         * existing one if this is the second text-base we've found for it. */
-        info = svn_hash_gets(*text_bases_info, versioned_file_name);
-        if (info == NULL)
-          info = apr_pcalloc(result_pool, sizeof (*info));
-        file_info = (is_revert_base ? &info->revert_base : &info->normal_base);
-
-        file_info->sha1_checksum = svn_checksum_dup(sha1_checksum, result_pool);
-        file_info->md5_checksum = svn_checksum_dup(md5_checksum, result_pool);
-        svn_hash_sets(*text_bases_info, versioned_file_name, info);
-      }
+      job->basename = apr_hash_this_key(hi);
+      job->text_base_path = svn_dirent_join(text_base_dir, job->basename,
+                                            scratch_pool);
+      job->new_wcroot_abspath = new_wcroot_abspath;
     }
 
-  svn_pool_destroy(iterpool);
+  if (batch->jobs->nelts == 0)
+    return SVN_NO_ERROR;
+
+  /* A single file is not worth the thread synchronization. */
+  SVN_ERR(svn_task__run(batch->jobs->nelts < 2
+                          ? 1 : UPGRADE_TEXT_BASE_THREAD_COUNT,
+                        copy_text_bases_process, batch,
+                        NULL, NULL, NULL, NULL,
+                        NULL, NULL,
+                        result_pool, scratch_pool));
 
   return SVN_NO_ERROR;
 }
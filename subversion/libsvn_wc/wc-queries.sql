@@ -50,6 +50,22 @@ LEFT OUTER JOIN lock ON nodes.repos_id = lock.repos_id
 WHERE wc_id = ?1 AND local_relpath = ?2
 ORDER BY op_depth DESC
 
+-- STMT_SELECT_NODE_INFO_WITH_LOCK_RECURSIVE
+SELECT op_depth, nodes.repos_id, nodes.repos_path, presence, kind, revision,
+  checksum, translated_size, changed_revision, changed_date, changed_author,
+  depth, symlink_target, last_mod_time, properties, moved_here,
+  inherited_props,
+  lock_token, lock_owner, lock_comment, lock_date,
+  /* All the columns until now must match those returned by
+     STMT_SELECT_NODE_INFO_WITH_LOCK */
+  local_relpath
+FROM nodes
+LEFT OUTER JOIN lock ON nodes.repos_id = lock.repos_id
+  AND nodes.repos_path = lock.repos_relpath AND nodes.op_depth=0
+WHERE wc_id = ?1
+  AND (local_relpath = ?2 OR IS_STRICT_DESCENDANT_OF(local_relpath, ?2))
+ORDER BY local_relpath DESC, op_depth DESC
+
 -- STMT_SELECT_BASE_NODE
 SELECT repos_id, repos_path, presence, kind, revision, checksum,
   translated_size, changed_revision, changed_date, changed_author, depth,
@@ -85,6 +101,16 @@ LEFT OUTER JOIN lock ON nodes.repos_id = lock.repos_id
   AND nodes.repos_path = lock.repos_relpath
 WHERE wc_id = ?1 AND parent_relpath = ?2 AND op_depth = 0
 
+-- STMT_SELECT_BASE_DESCENDANTS_INFO_LOCK
+SELECT local_relpath, nodes.repos_id, nodes.repos_path, presence, kind,
+  revision, depth, file_external,
+  lock_token, lock_owner, lock_comment, lock_date, parent_relpath
+FROM nodes
+LEFT OUTER JOIN lock ON nodes.repos_id = lock.repos_id
+  AND nodes.repos_path = lock.repos_relpath
+WHERE wc_id = ?1 AND IS_STRICT_DESCENDANT_OF(local_relpath, ?2)
+  AND op_depth = 0
+
 
 -- STMT_SELECT_WORKING_NODE
 SELECT op_depth, presence, kind, checksum, translated_size,
@@ -133,6 +159,13 @@ SELECT changelist, properties, conflict_data
 FROM actual_node
 WHERE wc_id = ?1 AND local_relpath = ?2
 
+-- STMT_SELECT_ACTUAL_NODE_RECURSIVE
+SELECT changelist, properties, conflict_data, local_relpath
+FROM actual_node
+WHERE wc_id = ?1
+  AND (local_relpath = ?2 OR IS_STRICT_DESCENDANT_OF(local_relpath, ?2))
+ORDER BY local_relpath DESC
+
 -- STMT_SELECT_NODE_CHILDREN_INFO
 /* Getting rows in an advantageous order using
      ORDER BY local_relpath, op_depth DESC
@@ -270,23 +303,19 @@ WHERE wc_id = ?1
   AND (local_relpath = ?2 OR IS_STRICT_DESCENDANT_OF(local_relpath, ?2))
   AND op_depth = ?3
 
-/* Full layer replacement check code for handling moves
-The op_root must exist (or there is no layer to replace) and an op-root
-   always has presence 'normal' */
--- STMT_SELECT_LAYER_FOR_REPLACE
-SELECT s.local_relpath, s.kind,
-  RELPATH_SKIP_JOIN(?2, ?4, s.local_relpath) drp, 'normal'
-FROM nodes s
-WHERE s.wc_id = ?1 AND s.local_relpath = ?2 AND s.op_depth = ?3
-UNION ALL
+/* The descendants of a layer replacement that do not exist (with presence
+   normal) in the destination layer yet, and may need their parent delete
+   extended. */
+-- STMT_SELECT_LAYER_FOR_REPLACE_ADDED
 SELECT s.local_relpath, s.kind,
-  RELPATH_SKIP_JOIN(?2, ?4, s.local_relpath) drp, d.presence
+  RELPATH_SKIP_JOIN(?2, ?4, s.local_relpath) drp
 FROM nodes s
 LEFT OUTER JOIN nodes d ON d.wc_id= ?1 AND d.op_depth = ?5
      AND d.local_relpath = drp
 WHERE s.wc_id = ?1
   AND IS_STRICT_DESCENDANT_OF(s.local_relpath, ?2)
   AND s.op_depth = ?3
+  AND (d.presence IS NULL OR d.presence != MAP_NORMAL)
 ORDER BY s.local_relpath
 
 -- STMT_SELECT_DESCENDANTS_OP_DEPTH_RV
@@ -316,6 +345,62 @@ FROM nodes s
 LEFT JOIN nodes d ON d.wc_id=?1 AND d.local_relpath=?4 AND d.op_depth=?5
 WHERE s.wc_id = ?1 AND s.local_relpath = ?2 AND s.op_depth = ?3
 
+/* Like STMT_COPY_NODE_MOVE, but for all descendants of ?2 at once */
+-- STMT_COPY_DESCENDANTS_MOVE
+INSERT OR REPLACE INTO nodes (
+    wc_id, local_relpath, op_depth, parent_relpath, repos_id, repos_path,
+    revision, presence, depth, kind, changed_revision, changed_date,
+    changed_author, checksum, properties, translated_size, last_mod_time,
+    symlink_target, moved_here, moved_to )
+SELECT
+    s.wc_id, RELPATH_SKIP_JOIN(?2, ?4, s.local_relpath), ?5,
+    RELPATH_SKIP_JOIN(?2, ?4, s.parent_relpath),
+    s.repos_id,
+    s.repos_path, s.revision, s.presence, s.depth, s.kind, s.changed_revision,
+    s.changed_date, s.changed_author, s.checksum, s.properties,
+    CASE WHEN d.checksum=s.checksum THEN d.translated_size END,
+    CASE WHEN d.checksum=s.checksum THEN d.last_mod_time END,
+    s.symlink_target, 1, d.moved_to
+FROM nodes s
+LEFT JOIN nodes d ON d.wc_id=?1 AND d.op_depth=?5
+     AND d.local_relpath=RELPATH_SKIP_JOIN(?2, ?4, s.local_relpath)
+WHERE s.wc_id = ?1
+  AND IS_STRICT_DESCENDANT_OF(s.local_relpath, ?2)
+  AND s.op_depth = ?3
+
+/* The descendants of the move destination ?4 that may differ from their
+   move source below ?2, by their destination relpath.  Nodes that exist
+   on only one side, nodes that are incomplete and nodes of which the
+   kind, checksum or properties differ are reported. */
+-- STMT_SELECT_MOVED_LAYER_DIFFERENCES
+SELECT RELPATH_SKIP_JOIN(?2, ?4, s.local_relpath)
+FROM nodes s
+LEFT OUTER JOIN nodes d ON d.wc_id = ?1 AND d.op_depth = ?5
+     AND d.local_relpath = RELPATH_SKIP_JOIN(?2, ?4, s.local_relpath)
+     AND d.presence IN (MAP_NORMAL, MAP_INCOMPLETE)
+WHERE s.wc_id = ?1
+  AND IS_STRICT_DESCENDANT_OF(s.local_relpath, ?2)
+  AND s.op_depth = ?3
+  AND s.presence IN (MAP_NORMAL, MAP_INCOMPLETE)
+  AND (d.local_relpath IS NULL
+       OR s.presence != MAP_NORMAL OR d.presence != MAP_NORMAL
+       OR d.kind != s.kind
+       OR d.checksum IS NOT s.checksum
+       OR d.properties IS NOT s.properties)
+UNION ALL
+SELECT d.local_relpath
+FROM nodes d
+WHERE d.wc_id = ?1
+  AND IS_STRICT_DESCENDANT_OF(d.local_relpath, ?4)
+  AND d.op_depth = ?5
+  AND d.presence IN (MAP_NORMAL, MAP_INCOMPLETE)
+  AND NOT EXISTS(SELECT * FROM nodes s
+                 WHERE s.wc_id = ?1
+                   AND s.local_relpath
+                         = RELPATH_SKIP_JOIN(?4, ?2, d.local_relpath)
+                   AND s.op_depth = ?3
+                   AND s.presence IN (MAP_NORMAL, MAP_INCOMPLETE))
+
 -- STMT_SELECT_NO_LONGER_MOVED_RV
 SELECT d.local_relpath, RELPATH_SKIP_JOIN(?2, ?4, d.local_relpath) srp,
        b.presence, b.op_depth
@@ -880,6 +965,9 @@ INSERT INTO work_queue (work) VALUES (?1)
 -- STMT_SELECT_WORK_ITEM
 SELECT id, work FROM work_queue ORDER BY id LIMIT 1
 
+-- STMT_SELECT_WORK_ITEMS
+SELECT id, work FROM work_queue ORDER BY id LIMIT ?1
+
 -- STMT_DELETE_WORK_ITEM
 DELETE FROM work_queue WHERE id = ?1
 
@@ -1297,6 +1385,11 @@ PRAGMA locking_mode = exclusive;
    exclusive-locking is mostly used on remote file systems. */
 PRAGMA journal_mode = DELETE
 
+-- STMT_PRAGMA_JOURNAL_MODE_WAL
+/* With exclusive locking, the WAL index lives in heap memory, so this
+   works on network file systems as well. */
+PRAGMA journal_mode = WAL
+
 -- STMT_FIND_REPOS_PATH_IN_WC
 SELECT local_relpath FROM nodes_current
   WHERE wc_id = ?1 AND repos_path = ?2
@@ -1593,6 +1686,29 @@ WHERE wc_id = ?1
   AND properties IS NOT NULL
 LIMIT 1
 
+-- STMT_SUBTREE_HAS_CONFLICTS
+SELECT 1 FROM actual_node
+WHERE wc_id = ?1
+  AND (local_relpath = ?2
+       OR IS_STRICT_DESCENDANT_OF(local_relpath, ?2))
+  AND conflict_data IS NOT NULL
+LIMIT 1
+
+-- STMT_SELECT_COMMIT_INFO_RECURSIVE
+SELECT nodes.local_relpath, nodes.op_depth, nodes.presence, nodes.kind,
+       nodes.translated_size, nodes.last_mod_time,
+       nodes.file_external IS NOT NULL,
+       (SELECT properties IS NOT NULL FROM actual_node a
+        WHERE a.wc_id = ?1
+          AND a.local_relpath = nodes.local_relpath)
+FROM nodes
+WHERE nodes.wc_id = ?1
+  AND (nodes.local_relpath = ?2
+       OR IS_STRICT_DESCENDANT_OF(nodes.local_relpath, ?2))
+  AND nodes.op_depth = (SELECT MAX(op_depth) FROM nodes w
+                        WHERE w.wc_id = ?1
+                          AND w.local_relpath = nodes.local_relpath)
+
 -- STMT_HAS_SWITCHED
 SELECT 1
 FROM nodes
@@ -1855,6 +1971,112 @@ UNION ALL
 SELECT pristine.checksum, pristine.hydrated, 0, NULL, NULL, NULL
 FROM pristine WHERE refcount = 0
 
+-- STMT_SELECT_UNREFERENCED_TEXTBASES
+SELECT checksum, size FROM pristine
+WHERE hydrated != 0 AND refcount > 0
+  AND checksum NOT IN (SELECT nodes.checksum
+                       FROM textbase_refs refs
+                       JOIN nodes ON nodes.wc_id = refs.wc_id
+                                 AND nodes.local_relpath = refs.local_relpath
+                                 AND nodes.op_depth = refs.op_depth
+                       WHERE refs.wc_id = ?1 AND nodes.checksum IS NOT NULL)
+
+/* The FILE_FINGERPRINTS table is not part of the format 32 schema.  It is
+   created on demand by clients that know about it and ignored by all
+   others, which is safe as every row is validated against NODES before
+   it gets used.
+
+   A row records that the working file at LOCAL_RELPATH, as it is stored
+   on disk, of TRANSLATED_SIZE bytes and with the (cheap to calculate)
+   checksum FINGERPRINT, was known to be unmodified while the top-most
+   node at LOCAL_RELPATH had the pristine CHECKSUM and CHANGED_REVISION. */
+-- STMT_CREATE_FILE_FINGERPRINTS
+CREATE TABLE IF NOT EXISTS file_fingerprints (
+  wc_id  INTEGER NOT NULL REFERENCES WCROOT (id),
+  local_relpath  TEXT NOT NULL,
+  checksum  TEXT NOT NULL,
+  changed_revision  INTEGER,
+  translated_size  INTEGER NOT NULL,
+  fingerprint  TEXT NOT NULL,
+  PRIMARY KEY (wc_id, local_relpath)
+  );
+
+-- STMT_HAVE_FILE_FINGERPRINTS_TABLE
+SELECT 1 FROM sqlite_master WHERE name='file_fingerprints' AND type='table'
+LIMIT 1
+
+-- STMT_RECORD_FILE_FINGERPRINT
+INSERT OR REPLACE INTO file_fingerprints (wc_id, local_relpath, checksum,
+                                          changed_revision, translated_size,
+                                          fingerprint)
+SELECT wc_id, local_relpath, checksum, changed_revision, ?3, ?4
+FROM nodes
+WHERE wc_id = ?1 AND local_relpath = ?2
+  AND op_depth = (SELECT MAX(op_depth) FROM nodes
+                  WHERE wc_id = ?1 AND local_relpath = ?2)
+  AND checksum IS NOT NULL
+
+-- STMT_SELECT_FILE_FINGERPRINT
+SELECT f.fingerprint
+FROM file_fingerprints f
+JOIN nodes n ON n.wc_id = f.wc_id
+            AND n.local_relpath = f.local_relpath
+            AND n.checksum = f.checksum
+            AND n.changed_revision IS f.changed_revision
+WHERE f.wc_id = ?1 AND f.local_relpath = ?2 AND f.translated_size = ?3
+  AND n.op_depth = (SELECT MAX(op_depth) FROM nodes
+                    WHERE wc_id = ?1 AND local_relpath = ?2)
+
+-- STMT_DELETE_STALE_FILE_FINGERPRINTS
+DELETE FROM file_fingerprints
+WHERE NOT EXISTS (SELECT 1 FROM nodes n
+                  WHERE n.wc_id = file_fingerprints.wc_id
+                    AND n.local_relpath = file_fingerprints.local_relpath
+                    AND n.checksum = file_fingerprints.checksum)
+
+/* The DETRANSLATED_CHECKSUMS table is not part of the format 32 schema
+   either and gets created on demand, just like FILE_FINGERPRINTS.  Its
+   rows don't depend on NODES at all.
+
+   A row records that the working file at LOCAL_RELPATH, of
+   TRANSLATED_SIZE bytes and last modified at LAST_MOD_TIME, has the
+   CHECKSUM after detranslating it with the settings identified by the
+   checksum TRANSLATION.  This allows telling whether files with keywords
+   or eol-style have been modified without reading them again, whether
+   they match their pristine or not. */
+-- STMT_CREATE_DETRANSLATED_CHECKSUMS
+CREATE TABLE IF NOT EXISTS detranslated_checksums (
+  wc_id  INTEGER NOT NULL REFERENCES WCROOT (id),
+  local_relpath  TEXT NOT NULL,
+  translated_size  INTEGER NOT NULL,
+  last_mod_time  INTEGER NOT NULL,
+  translation  TEXT NOT NULL,
+  checksum  TEXT NOT NULL,
+  PRIMARY KEY (wc_id, local_relpath)
+  );
+
+-- STMT_HAVE_DETRANSLATED_CHECKSUMS_TABLE
+SELECT 1 FROM sqlite_master
+WHERE name='detranslated_checksums' AND type='table'
+LIMIT 1
+
+-- STMT_RECORD_DETRANSLATED_CHECKSUM
+INSERT OR REPLACE INTO detranslated_checksums (wc_id, local_relpath,
+                                               translated_size, last_mod_time,
+                                               translation, checksum)
+VALUES (?1, ?2, ?3, ?4, ?5, ?6)
+
+-- STMT_SELECT_DETRANSLATED_CHECKSUM
+SELECT checksum FROM detranslated_checksums
+WHERE wc_id = ?1 AND local_relpath = ?2 AND translated_size = ?3
+  AND last_mod_time = ?4 AND translation = ?5
+
+-- STMT_DELETE_STALE_DETRANSLATED_CHECKSUMS
+DELETE FROM detranslated_checksums
+WHERE NOT EXISTS (SELECT 1 FROM nodes n
+                  WHERE n.wc_id = detranslated_checksums.wc_id
+                    AND n.local_relpath = detranslated_checksums.local_relpath)
+
 -- STMT_SELECT_SETTINGS
 SELECT store_pristine FROM settings WHERE wc_id = ?1
 
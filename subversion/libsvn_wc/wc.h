@@ -508,6 +508,7 @@ svn_wc__internal_transmit_text_deltas(svn_stream_t *tempstream,
                                       svn_wc__db_t *db,
                                       const char *local_abspath,
                                       svn_boolean_t fulltext,
+                                      svn_boolean_t track_source,
                                       const svn_delta_editor_t *editor,
                                       void *file_baton,
                                       apr_pool_t *result_pool,
@@ -651,6 +652,18 @@ svn_wc__wipe_postupgrade(const char *dir_abspath,
                          void *cancel_baton,
                          apr_pool_t *scratch_pool);
 
+/* If SVN_CONFIG_OPTION_RECLAIM_PRISTINES is enabled in the configuration
+ * of DB, remove the unreferenced pristine texts of the working copy of
+ * WRI_ABSPATH.  Call this after operations that may have released some,
+ * like commits and updates.
+ */
+svn_error_t *
+svn_wc__reclaim_pristines_if_enabled(svn_wc__db_t *db,
+                                     const char *wri_abspath,
+                                     svn_cancel_func_t cancel_func,
+                                     void *cancel_baton,
+                                     apr_pool_t *scratch_pool);
+
 /* Ensure LOCAL_ABSPATH is still locked in DB.  Returns the error
  * SVN_ERR_WC_NOT_LOCKED if this is not the case.
  */
@@ -769,6 +782,24 @@ svn_wc__node_has_local_mods(svn_boolean_t *modified,
                             void *cancel_baton,
                             apr_pool_t *scratch_pool);
 
+/* Set *MODIFIED to TRUE if any node in the tree rooted at LOCAL_ABSPATH
+ * in DB has local changes recorded in DB or no longer matches the kind,
+ * size or timestamp recorded for it, and to FALSE otherwise.
+ *
+ * Unlike svn_wc__node_has_local_mods(), this neither compares file
+ * contents nor looks for unversioned nodes, so a file that was touched
+ * without changing it counts as modified.  The children of directories
+ * that the filesystem monitor of the working copy knows to be unchanged
+ * are not checked on disk.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_wc__node_has_stat_changes(svn_boolean_t *modified,
+                              svn_wc__db_t *db,
+                              const char *local_abspath,
+                              svn_cancel_func_t cancel_func,
+                              void *cancel_baton,
+                              apr_pool_t *scratch_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -1446,12 +1446,13 @@ create_db(svn_sqlite__db_t **sdb,
           svn_depth_t root_node_depth,
           svn_boolean_t store_pristine,
           svn_boolean_t exclusive,
+          svn_boolean_t wal,
           apr_int32_t timeout,
           apr_pool_t *result_pool,
           apr_pool_t *scratch_pool)
 {
   SVN_ERR(svn_wc__db_util_open_db(sdb, dir_abspath, sdb_fname,
-                                  svn_sqlite__mode_rwcreate, exclusive,
+                                  svn_sqlite__mode_rwcreate, exclusive, wal,
                                   timeout,
                                   NULL /* my_statements */,
                                   result_pool, scratch_pool));
@@ -1507,8 +1508,10 @@ svn_wc__db_init(svn_wc__db_t *db,
   SVN_ERR(create_db(&sdb, &repos_id, &wc_id, target_format, local_abspath,
                     repos_root_url, repos_uuid, SDB_FILE,
                     repos_relpath, initial_rev, depth, store_pristine,
-                    sqlite_exclusive, sqlite_timeout,
+                    sqlite_exclusive, db->wal, sqlite_timeout,
                     db->state_pool, scratch_pool));
+  SVN_ERR(svn_sqlite__set_memory_limits(sdb, db->cache_size, db->mmap_size,
+                                        scratch_pool));
 
   /* Create the WCROOT for this directory.  */
   SVN_ERR(svn_wc__db_pdh_create_wcroot(&wcroot,
@@ -1516,6 +1519,7 @@ svn_wc__db_init(svn_wc__db_t *db,
                         sdb, wc_id, FORMAT_FROM_SDB,
                         FALSE /* auto-upgrade */,
                         store_pristine,
+                        db->shared_pristine_abspath,
                         db->state_pool, scratch_pool));
 
   /* Any previously cached children may now have a new WCROOT, most likely that
@@ -1660,6 +1664,36 @@ svn_wc__db_get_wcroot(const char **wcroot_abspath,
 }
 
 
+svn_config_t *
+svn_wc__db_get_config(svn_wc__db_t *db)
+{
+  return db->config;
+}
+
+
+svn_error_t *
+svn_wc__db_with_txn(svn_wc__db_t *db,
+                    const char *wri_abspath,
+                    svn_wc__with_write_lock_func_t func,
+                    void *baton,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  SVN_WC__DB_WITH_TXN(func(baton, result_pool, scratch_pool), wcroot);
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_wc__db_base_add_directory(svn_wc__db_t *db,
                               const char *local_abspath,
@@ -1822,6 +1856,43 @@ db_record_fileinfo(svn_wc__db_wcroot_t *wcroot,
 }
 
 
+/* Make sure that the FILE_FINGERPRINTS table exists in WCROOT. */
+static svn_error_t *
+ensure_fingerprints_table(svn_wc__db_wcroot_t *wcroot)
+{
+  if (wcroot->have_fingerprints != svn_tristate_true)
+    {
+      SVN_ERR(svn_sqlite__exec_statements(wcroot->sdb,
+                                          STMT_CREATE_FILE_FINGERPRINTS));
+      wcroot->have_fingerprints = svn_tristate_true;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Record FINGERPRINT and TRANSLATED_SIZE as the fingerprint of the
+   unmodified working file of the top layer in NODES. */
+static svn_error_t *
+db_record_fingerprint(svn_wc__db_wcroot_t *wcroot,
+                      const char *local_relpath,
+                      apr_int64_t translated_size,
+                      const svn_checksum_t *fingerprint,
+                      apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  SVN_ERR(ensure_fingerprints_table(wcroot));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_RECORD_FILE_FINGERPRINT));
+  SVN_ERR(svn_sqlite__bindf(stmt, "isi", wcroot->wc_id, local_relpath,
+                            translated_size));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 4, fingerprint, scratch_pool));
+
+  return svn_error_trace(svn_sqlite__step_done(stmt));
+}
+
+
 /* Install the working file provided by FILE_WRITER, optionally
    recording its fileinfo. */
 static svn_error_t *
@@ -1838,10 +1909,17 @@ install_working_file(svn_wc__db_wcroot_t *wcroot,
       apr_time_t mtime;
       apr_off_t size;
 
+      const svn_checksum_t *fingerprint;
+
       SVN_ERR(svn_wc__working_file_writer_finalize(&mtime, &size, file_writer,
                                                    scratch_pool));
       SVN_ERR(db_record_fileinfo(wcroot, local_relpath, size, mtime,
                                  scratch_pool));
+
+      fingerprint = svn_wc__working_file_writer_get_fingerprint(file_writer);
+      if (fingerprint)
+        SVN_ERR(db_record_fingerprint(wcroot, local_relpath, size,
+                                      fingerprint, scratch_pool));
     }
   else
     {
@@ -2782,6 +2860,53 @@ svn_wc__db_base_get_info(svn_wc__db_status_t *status,
   return SVN_NO_ERROR;
 }
 
+/* Read the struct svn_wc__db_base_info_t of the current row of STMT,
+   which must be one of STMT_SELECT_BASE_CHILDREN_INFO and friends, into
+   *INFO.  *LAST_REPOS_ID and *LAST_REPOS_ROOT_URL cache the repository
+   of the previous row.  Allocate *INFO in RESULT_POOL. */
+static svn_error_t *
+base_info_from_row(struct svn_wc__db_base_info_t **info_p,
+                   svn_sqlite__stmt_t *stmt,
+                   svn_wc__db_wcroot_t *wcroot,
+                   svn_boolean_t obtain_locks,
+                   apr_int64_t *last_repos_id,
+                   const char **last_repos_root_url,
+                   apr_pool_t *result_pool)
+{
+  struct svn_wc__db_base_info_t *info;
+  apr_int64_t repos_id;
+
+  info = apr_pcalloc(result_pool, sizeof(*info));
+
+  repos_id = svn_sqlite__column_int64(stmt, 1);
+  info->repos_relpath = svn_sqlite__column_text(stmt, 2, result_pool);
+  info->status = svn_sqlite__column_token(stmt, 3, presence_map);
+  info->kind = svn_sqlite__column_token(stmt, 4, kind_map);
+  info->revnum = svn_sqlite__column_revnum(stmt, 5);
+
+  info->depth = svn_sqlite__column_token_null(stmt, 6, depth_map,
+                                              svn_depth_unknown);
+
+  info->update_root = svn_sqlite__column_boolean(stmt, 7);
+
+  if (obtain_locks)
+    info->lock = lock_from_columns(stmt, 8, 9, 10, 11, result_pool);
+
+  if (repos_id != *last_repos_id)
+    {
+      SVN_ERR(svn_wc__db_fetch_repos_info(last_repos_root_url, NULL,
+                                          wcroot, repos_id,
+                                          result_pool));
+
+      *last_repos_id = repos_id;
+    }
+
+  info->repos_root_url = *last_repos_root_url;
+
+  *info_p = info;
+  return SVN_NO_ERROR;
+}
+
 /* The implementation of svn_wc__db_base_get_children_info */
 static svn_error_t *
 base_get_children_info(apr_hash_t **nodes,
@@ -2809,45 +2934,84 @@ base_get_children_info(apr_hash_t **nodes,
   while (have_row)
     {
       struct svn_wc__db_base_info_t *info;
-      apr_int64_t repos_id;
       const char *child_relpath = svn_sqlite__column_text(stmt, 0, NULL);
       const char *name = svn_relpath_basename(child_relpath, result_pool);
+      svn_error_t *err;
 
-      info = apr_pcalloc(result_pool, sizeof(*info));
+      err = base_info_from_row(&info, stmt, wcroot, obtain_locks,
+                               &last_repos_id, &last_repos_root_url,
+                               result_pool);
+      if (err)
+        return svn_error_trace(
+                 svn_error_compose_create(err, svn_sqlite__reset(stmt)));
 
-      repos_id = svn_sqlite__column_int64(stmt, 1);
-      info->repos_relpath = svn_sqlite__column_text(stmt, 2, result_pool);
-      info->status = svn_sqlite__column_token(stmt, 3, presence_map);
-      info->kind = svn_sqlite__column_token(stmt, 4, kind_map);
-      info->revnum = svn_sqlite__column_revnum(stmt, 5);
+      svn_hash_sets(*nodes, name, info);
 
-      info->depth = svn_sqlite__column_token_null(stmt, 6, depth_map,
-                                                  svn_depth_unknown);
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
 
-      info->update_root = svn_sqlite__column_boolean(stmt, 7);
+  SVN_ERR(svn_sqlite__reset(stmt));
 
-      if (obtain_locks)
-        info->lock = lock_from_columns(stmt, 8, 9, 10, 11, result_pool);
+  return SVN_NO_ERROR;
+}
 
-      if (repos_id != last_repos_id)
-        {
-          svn_error_t *err;
+/* The implementation of svn_wc__db_base_get_descendants_info */
+static svn_error_t *
+base_get_descendants_info(apr_hash_t **dirs,
+                          svn_wc__db_wcroot_t *wcroot,
+                          const char *local_relpath,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  apr_int64_t last_repos_id = INVALID_REPOS_ID;
+  const char *last_repos_root_url = NULL;
+  const char *last_parent_relpath = NULL;
+  apr_hash_t *children = NULL;
 
-          err = svn_wc__db_fetch_repos_info(&last_repos_root_url, NULL,
-                                            wcroot, repos_id,
-                                            result_pool);
+  *dirs = apr_hash_make(result_pool);
 
-          if (err)
-            return svn_error_trace(
-                     svn_error_compose_create(err,
-                                              svn_sqlite__reset(stmt)));
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_BASE_DESCENDANTS_INFO_LOCK));
+  SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, local_relpath));
+
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+
+  while (have_row)
+    {
+      struct svn_wc__db_base_info_t *info;
+      const char *child_relpath = svn_sqlite__column_text(stmt, 0, NULL);
+      const char *parent_relpath = svn_sqlite__column_text(stmt, 12, NULL);
+      svn_error_t *err;
+
+      /* Siblings are usually returned next to each other, so avoid
+         most of the hash lookups. */
+      if (!last_parent_relpath || strcmp(parent_relpath, last_parent_relpath))
+        {
+          const char *dir_relpath = svn_relpath_skip_ancestor(local_relpath,
+                                                              parent_relpath);
 
-          last_repos_id = repos_id;
+          children = svn_hash_gets(*dirs, dir_relpath);
+          if (!children)
+            {
+              children = apr_hash_make(result_pool);
+              svn_hash_sets(*dirs, apr_pstrdup(result_pool, dir_relpath),
+                            children);
+            }
+          last_parent_relpath = apr_pstrdup(scratch_pool, parent_relpath);
         }
 
-      info->repos_root_url = last_repos_root_url;
+      err = base_info_from_row(&info, stmt, wcroot, TRUE,
+                               &last_repos_id, &last_repos_root_url,
+                               result_pool);
+      if (err)
+        return svn_error_trace(
+                 svn_error_compose_create(err, svn_sqlite__reset(stmt)));
 
-      svn_hash_sets(*nodes, name, info);
+      svn_hash_sets(children, svn_relpath_basename(child_relpath,
+                                                   result_pool),
+                    info);
 
       SVN_ERR(svn_sqlite__step(&have_row, stmt));
     }
@@ -2882,6 +3046,29 @@ svn_wc__db_base_get_children_info(apr_hash_t **nodes,
 }
 
 
+svn_error_t *
+svn_wc__db_base_get_descendants_info(apr_hash_t **dirs,
+                                     svn_wc__db_t *db,
+                                     const char *dir_abspath,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(dir_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              dir_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  return svn_error_trace(base_get_descendants_info(dirs, wcroot,
+                                                   local_relpath,
+                                                   result_pool,
+                                                   scratch_pool));
+}
+
+
 svn_error_t *
 svn_wc__db_base_get_props(apr_hash_t **props,
                           svn_wc__db_t *db,
@@ -5068,64 +5255,35 @@ svn_wc__db_op_copy_layer_internal(svn_wc__db_wcroot_t *wcroot,
                              path_for_error_message(wcroot, dst_op_relpath,
                                                     scratch_pool));
 
-  SVN_ERR(svn_sqlite__get_statement(&stmt2, wcroot->sdb,
-                                    STMT_COPY_NODE_MOVE));
+  /* Descendants that are new in the destination layer may have to extend
+     an existing shadowing.  That only depends on the layers above
+     DST_OP_DEPTH, so do this before the destination layer changes.
 
-  /* Replace entire subtree at one op-depth. */
+     The node can't be deleted where it is added, so extension of
+     an existing shadowing is only interesting 2 levels deep. */
   SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
-                                    STMT_SELECT_LAYER_FOR_REPLACE));
+                                    STMT_SELECT_LAYER_FOR_REPLACE_ADDED));
   SVN_ERR(svn_sqlite__bindf(stmt, "isdsd", wcroot->wc_id,
                             src_op_relpath, src_op_depth,
                             dst_op_relpath, dst_op_depth));
   SVN_ERR(svn_sqlite__step(&have_row, stmt));
   while (have_row)
     {
-      const char *src_relpath;
       const char *dst_relpath;
 
       svn_pool_clear(iterpool);
 
-      src_relpath = svn_sqlite__column_text(stmt, 0, iterpool);
       dst_relpath = svn_sqlite__column_text(stmt, 2, iterpool);
 
-      err = svn_sqlite__bindf(stmt2, "isdsds", wcroot->wc_id,
-                              src_relpath, src_op_depth,
-                              dst_relpath, dst_op_depth,
-                              svn_relpath_dirname(dst_relpath, iterpool));
-      if (!err)
-        err = svn_sqlite__step_done(stmt2);
-
-      /* stmt2 is reset (never modified or by step_done) */
-
-      if (err)
-        break;
-
-      /* The node can't be deleted where it is added, so extension of
-         an existing shadowing is only interesting 2 levels deep. */
       if (relpath_depth(dst_relpath) > (dst_op_depth+1))
         {
-          svn_boolean_t exists = !svn_sqlite__column_is_null(stmt, 3);
-
-          if (exists)
-            {
-              svn_wc__db_status_t presence;
-
-              presence = svn_sqlite__column_token(stmt, 3, presence_map);
+          svn_node_kind_t kind = svn_sqlite__column_token(stmt, 1, kind_map);
 
-              if (presence != svn_wc__db_status_normal)
-                exists = FALSE;
-            }
+          err = db_extend_parent_delete(wcroot, dst_relpath,
+                                        kind, dst_op_depth, iterpool);
 
-          if (!exists)
-            {
-              svn_node_kind_t kind = svn_sqlite__column_token(stmt, 1, kind_map);
-
-              err = db_extend_parent_delete(wcroot, dst_relpath,
-                                            kind, dst_op_depth, iterpool);
-
-              if (err)
-                break;
-            }
+          if (err)
+            break;
         }
 
       SVN_ERR(svn_sqlite__step(&have_row, stmt));
@@ -5133,6 +5291,25 @@ svn_wc__db_op_copy_layer_internal(svn_wc__db_wcroot_t *wcroot,
 
   SVN_ERR(svn_error_compose_create(err, svn_sqlite__reset(stmt)));
 
+  /* Replace entire subtree at one op-depth: first the op-root, which
+     gets a parent outside the layer, and then all its descendants in
+     a single statement. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_COPY_NODE_MOVE));
+  SVN_ERR(svn_sqlite__bindf(stmt, "isdsds", wcroot->wc_id,
+                            src_op_relpath, src_op_depth,
+                            dst_op_relpath, dst_op_depth,
+                            svn_relpath_dirname(dst_op_relpath,
+                                                scratch_pool)));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_COPY_DESCENDANTS_MOVE));
+  SVN_ERR(svn_sqlite__bindf(stmt, "isdsd", wcroot->wc_id,
+                            src_op_relpath, src_op_depth,
+                            dst_op_relpath, dst_op_depth));
+  SVN_ERR(svn_sqlite__step_done(stmt));
+
   /* And now remove the records that are no longer needed */
   SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
                                     STMT_SELECT_NO_LONGER_MOVED_RV));
@@ -6193,6 +6370,199 @@ svn_wc__db_global_record_fileinfo(svn_wc__db_t *db,
 }
 
 
+svn_error_t *
+svn_wc__db_global_record_fingerprint(svn_wc__db_t *db,
+                                     const char *local_abspath,
+                                     svn_filesize_t translated_size,
+                                     const svn_checksum_t *fingerprint,
+                                     apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              local_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  SVN_WC__DB_WITH_TXN(
+    db_record_fingerprint(wcroot, local_relpath, translated_size,
+                          fingerprint, scratch_pool),
+    wcroot);
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_wc__db_read_fingerprint(const svn_checksum_t **fingerprint,
+                            svn_wc__db_t *db,
+                            const char *local_abspath,
+                            svn_filesize_t translated_size,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              local_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  /* Working copies that never recorded a fingerprint don't have the
+     table, and we shouldn't write to the db just to find that out. */
+  if (wcroot->have_fingerprints == svn_tristate_unknown)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                        STMT_HAVE_FILE_FINGERPRINTS_TABLE));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      SVN_ERR(svn_sqlite__reset(stmt));
+
+      wcroot->have_fingerprints = have_row ? svn_tristate_true
+                                           : svn_tristate_false;
+    }
+
+  if (wcroot->have_fingerprints != svn_tristate_true)
+    {
+      *fingerprint = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_FILE_FINGERPRINT));
+  SVN_ERR(svn_sqlite__bindf(stmt, "isi", wcroot->wc_id, local_relpath,
+                            translated_size));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+
+  if (have_row)
+    SVN_ERR(svn_sqlite__column_checksum(fingerprint, stmt, 0, result_pool));
+  else
+    *fingerprint = NULL;
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+
+/* Record CHECKSUM as the detranslated checksum of the working file at
+   LOCAL_RELPATH.  See svn_wc__db_global_record_detranslated_checksum(). */
+static svn_error_t *
+db_record_detranslated_checksum(svn_wc__db_wcroot_t *wcroot,
+                                const char *local_relpath,
+                                apr_int64_t translated_size,
+                                apr_time_t last_mod_time,
+                                const svn_checksum_t *translation,
+                                const svn_checksum_t *checksum,
+                                apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+
+  if (wcroot->have_detranslated_checksums != svn_tristate_true)
+    {
+      SVN_ERR(svn_sqlite__exec_statements(wcroot->sdb,
+                                          STMT_CREATE_DETRANSLATED_CHECKSUMS));
+      wcroot->have_detranslated_checksums = svn_tristate_true;
+    }
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_RECORD_DETRANSLATED_CHECKSUM));
+  SVN_ERR(svn_sqlite__bindf(stmt, "isii", wcroot->wc_id, local_relpath,
+                            translated_size, last_mod_time));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 5, translation, scratch_pool));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 6, checksum, scratch_pool));
+
+  return svn_error_trace(svn_sqlite__step_done(stmt));
+}
+
+
+svn_error_t *
+svn_wc__db_global_record_detranslated_checksum(
+  svn_wc__db_t *db,
+  const char *local_abspath,
+  svn_filesize_t translated_size,
+  apr_time_t last_mod_time,
+  const svn_checksum_t *translation,
+  const svn_checksum_t *checksum,
+  apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              local_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  SVN_WC__DB_WITH_TXN(
+    db_record_detranslated_checksum(wcroot, local_relpath, translated_size,
+                                    last_mod_time, translation, checksum,
+                                    scratch_pool),
+    wcroot);
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_error_t *
+svn_wc__db_read_detranslated_checksum(const svn_checksum_t **checksum,
+                                      svn_wc__db_t *db,
+                                      const char *local_abspath,
+                                      svn_filesize_t translated_size,
+                                      apr_time_t last_mod_time,
+                                      const svn_checksum_t *translation,
+                                      apr_pool_t *result_pool,
+                                      apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              local_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  /* Don't create the table just to find out that it is empty. */
+  if (wcroot->have_detranslated_checksums == svn_tristate_unknown)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_HAVE_DETRANSLATED_CHECKSUMS_TABLE));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      SVN_ERR(svn_sqlite__reset(stmt));
+
+      wcroot->have_detranslated_checksums = have_row ? svn_tristate_true
+                                                     : svn_tristate_false;
+    }
+
+  if (wcroot->have_detranslated_checksums != svn_tristate_true)
+    {
+      *checksum = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_DETRANSLATED_CHECKSUM));
+  SVN_ERR(svn_sqlite__bindf(stmt, "isii", wcroot->wc_id, local_relpath,
+                            translated_size, last_mod_time));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 5, translation, scratch_pool));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+
+  if (have_row)
+    SVN_ERR(svn_sqlite__column_checksum(checksum, stmt, 0, result_pool));
+  else
+    *checksum = NULL;
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
+
 /* Set the ACTUAL_NODE properties column for (WC_ID, LOCAL_RELPATH) to
  * PROPS.
  *
@@ -8899,10 +9269,236 @@ column_token_err(svn_error_t **err,
   return value;
 }
 
-/* Like svn_wc__db_read_info(), but taking WCROOT+LOCAL_RELPATH instead of
-   DB+LOCAL_ABSPATH, and outputting repos ids instead of URL+UUID. */
+/* The read_info() outputs for one node, as stored in a node cache. */
+typedef struct cached_node_t
+{
+  const char *local_relpath;
+
+  svn_wc__db_status_t status;
+  svn_node_kind_t kind;
+  svn_revnum_t revision;
+  const char *repos_relpath;
+  apr_int64_t repos_id;
+  svn_revnum_t changed_rev;
+  apr_time_t changed_date;
+  const char *changed_author;
+  svn_depth_t depth;
+  const svn_checksum_t *checksum;
+  const char *target;
+  const char *original_repos_relpath;
+  apr_int64_t original_repos_id;
+  svn_revnum_t original_revision;
+  svn_wc__db_lock_t *lock;
+  svn_filesize_t recorded_size;
+  apr_time_t recorded_time;
+  const char *changelist;
+  svn_boolean_t conflicted;
+  svn_boolean_t op_root;
+  svn_boolean_t had_props;
+  svn_boolean_t props_mod;
+  svn_boolean_t have_base;
+  svn_boolean_t have_more_work;
+  svn_boolean_t have_work;
+
+  /* TRUE if this node only exists in ACTUAL_NODE. */
+  svn_boolean_t actual_only;
+} cached_node_t;
+
+/* The information on all nodes of a subtree of a wcroot, see
+   svn_wc__db_cache_nodes(). */
+struct svn_wc__db_node_cache_t
+{
+  /* The root of the cached subtree. */
+  const char *local_relpath;
+
+  /* cached_node_t for every node of the subtree (not pointers!),
+     sorted by local_relpath. */
+  apr_array_header_t *nodes;
+
+  /* svn_sqlite__total_changes() of the wcroot's database at the time the
+     cache was loaded. */
+  int total_changes;
+
+  /* The pool holding all of the above. */
+  apr_pool_t *pool;
+};
+
+/* Discard the node cache of WCROOT, if any. */
+static void
+drop_node_cache(svn_wc__db_wcroot_t *wcroot)
+{
+  if (wcroot->node_cache)
+    {
+      svn_pool_destroy(wcroot->node_cache->pool);
+      wcroot->node_cache = NULL;
+    }
+}
+
+/* Implements the compare function for svn_sort__bsearch_lower_bound(),
+   comparing a cached_node_t to a local_relpath. */
+static int
+compare_cached_node(const void *node, const void *local_relpath)
+{
+  return strcmp(((const cached_node_t *)node)->local_relpath,
+                local_relpath);
+}
+
+/* Return TRUE if WCROOT has an up-to-date node cache covering
+   LOCAL_RELPATH.  If so, set *NODE to the cached information on
+   LOCAL_RELPATH, or to NULL if that node does not exist. */
+static svn_boolean_t
+find_cached_node(const cached_node_t **node,
+                 svn_wc__db_wcroot_t *wcroot,
+                 const char *local_relpath)
+{
+  struct svn_wc__db_node_cache_t *cache = wcroot->node_cache;
+  int idx;
+
+  if (!cache)
+    return FALSE;
+
+  if (svn_sqlite__total_changes(wcroot->sdb) != cache->total_changes)
+    {
+      drop_node_cache(wcroot);
+      return FALSE;
+    }
+
+  if (!svn_relpath_skip_ancestor(cache->local_relpath, local_relpath))
+    return FALSE;
+
+  idx = svn_sort__bsearch_lower_bound(cache->nodes, local_relpath,
+                                      compare_cached_node);
+  if (idx < cache->nodes->nelts
+      && strcmp(APR_ARRAY_IDX(cache->nodes, idx, cached_node_t).local_relpath,
+                local_relpath) == 0)
+    *node = &APR_ARRAY_IDX(cache->nodes, idx, cached_node_t);
+  else
+    *node = NULL;
+
+  return TRUE;
+}
+
+/* Like read_info(), but obtaining the information from NODE, as found by
+   find_cached_node(), instead of from the database. */
 static svn_error_t *
-read_info(svn_wc__db_status_t *status,
+read_info_from_cache(svn_wc__db_status_t *status,
+                     svn_node_kind_t *kind,
+                     svn_revnum_t *revision,
+                     const char **repos_relpath,
+                     apr_int64_t *repos_id,
+                     svn_revnum_t *changed_rev,
+                     apr_time_t *changed_date,
+                     const char **changed_author,
+                     svn_depth_t *depth,
+                     const svn_checksum_t **checksum,
+                     const char **target,
+                     const char **original_repos_relpath,
+                     apr_int64_t *original_repos_id,
+                     svn_revnum_t *original_revision,
+                     svn_wc__db_lock_t **lock,
+                     svn_filesize_t *recorded_size,
+                     apr_time_t *recorded_time,
+                     const char **changelist,
+                     svn_boolean_t *conflicted,
+                     svn_boolean_t *op_root,
+                     svn_boolean_t *had_props,
+                     svn_boolean_t *props_mod,
+                     svn_boolean_t *have_base,
+                     svn_boolean_t *have_more_work,
+                     svn_boolean_t *have_work,
+                     const cached_node_t *node,
+                     svn_wc__db_wcroot_t *wcroot,
+                     const char *local_relpath,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
+{
+  if (!node)
+    return svn_error_createf(SVN_ERR_WC_PATH_NOT_FOUND, NULL,
+                             _("The node '%s' was not found."),
+                             path_for_error_message(wcroot, local_relpath,
+                                                    scratch_pool));
+
+  /* See read_info_from_rows() */
+  if (node->actual_only)
+    SVN_ERR_ASSERT(conflicted);
+
+  if (status)
+    *status = node->status;
+  if (kind)
+    *kind = node->kind;
+  if (revision)
+    *revision = node->revision;
+  if (repos_relpath)
+    *repos_relpath = apr_pstrdup(result_pool, node->repos_relpath);
+  if (repos_id)
+    *repos_id = node->repos_id;
+  if (changed_rev)
+    *changed_rev = node->changed_rev;
+  if (changed_date)
+    *changed_date = node->changed_date;
+  if (changed_author)
+    *changed_author = apr_pstrdup(result_pool, node->changed_author);
+  if (depth)
+    *depth = node->depth;
+  if (checksum)
+    *checksum = svn_checksum_dup(node->checksum, result_pool);
+  if (target)
+    *target = apr_pstrdup(result_pool, node->target);
+  if (original_repos_relpath)
+    *original_repos_relpath = apr_pstrdup(result_pool,
+                                          node->original_repos_relpath);
+  if (original_repos_id)
+    *original_repos_id = node->original_repos_id;
+  if (original_revision)
+    *original_revision = node->original_revision;
+  if (lock)
+    {
+      if (node->lock)
+        {
+          *lock = apr_pmemdup(result_pool, node->lock, sizeof(**lock));
+          (*lock)->token = apr_pstrdup(result_pool, node->lock->token);
+          (*lock)->owner = apr_pstrdup(result_pool, node->lock->owner);
+          (*lock)->comment = apr_pstrdup(result_pool, node->lock->comment);
+        }
+      else
+        *lock = NULL;
+    }
+  if (recorded_size)
+    *recorded_size = node->recorded_size;
+  if (recorded_time)
+    *recorded_time = node->recorded_time;
+  if (changelist)
+    *changelist = apr_pstrdup(result_pool, node->changelist);
+  if (conflicted)
+    *conflicted = node->conflicted;
+  if (op_root)
+    *op_root = node->op_root;
+  if (had_props)
+    *had_props = node->had_props;
+  if (props_mod)
+    *props_mod = node->props_mod;
+  if (have_base)
+    *have_base = node->have_base;
+  if (have_more_work)
+    *have_more_work = node->have_more_work;
+  if (have_work)
+    *have_work = node->have_work;
+
+  return SVN_NO_ERROR;
+}
+
+/* Decode the read_info() outputs for LOCAL_RELPATH from the current rows
+   of STMT_INFO (a STMT_SELECT_NODE_INFO or STMT_SELECT_NODE_INFO_WITH_LOCK
+   like statement, if *HAVE_INFO) and STMT_ACT (a STMT_SELECT_ACTUAL_NODE
+   like statement, if HAVE_ACT).
+
+   Calculating HAVE_BASE and HAVE_MORE_WORK steps through further rows of
+   STMT_INFO; *HAVE_INFO is updated to tell whether STMT_INFO still has a
+   current row afterwards.  If RELPATH_COLUMN is not negative, STMT_INFO
+   returns the rows of multiple nodes and the local_relpath of each row in
+   that column, and stepping stops at the first row of another node. */
+static svn_error_t *
+read_info_from_rows(svn_wc__db_status_t *status,
           svn_node_kind_t *kind,
           svn_revnum_t *revision,
           const char **repos_relpath,
@@ -8927,39 +9523,19 @@ read_info(svn_wc__db_status_t *status,
           svn_boolean_t *have_base,
           svn_boolean_t *have_more_work,
           svn_boolean_t *have_work,
+          svn_boolean_t *have_info,
+          svn_sqlite__stmt_t *stmt_info,
+          int relpath_column,
+          svn_boolean_t have_act,
+          svn_sqlite__stmt_t *stmt_act,
           svn_wc__db_wcroot_t *wcroot,
           const char *local_relpath,
           apr_pool_t *result_pool,
           apr_pool_t *scratch_pool)
 {
-  svn_sqlite__stmt_t *stmt_info;
-  svn_sqlite__stmt_t *stmt_act;
-  svn_boolean_t have_info;
-  svn_boolean_t have_act;
   svn_error_t *err = NULL;
 
-  /* Obtain the most likely to exist record first, to make sure we don't
-     have to obtain the SQLite read-lock multiple times */
-  SVN_ERR(svn_sqlite__get_statement(&stmt_info, wcroot->sdb,
-                                    lock ? STMT_SELECT_NODE_INFO_WITH_LOCK
-                                         : STMT_SELECT_NODE_INFO));
-  SVN_ERR(svn_sqlite__bindf(stmt_info, "is", wcroot->wc_id, local_relpath));
-  SVN_ERR(svn_sqlite__step(&have_info, stmt_info));
-
-  if (changelist || conflicted || props_mod)
-    {
-      SVN_ERR(svn_sqlite__get_statement(&stmt_act, wcroot->sdb,
-                                        STMT_SELECT_ACTUAL_NODE));
-      SVN_ERR(svn_sqlite__bindf(stmt_act, "is", wcroot->wc_id, local_relpath));
-      SVN_ERR(svn_sqlite__step(&have_act, stmt_act));
-    }
-  else
-    {
-      have_act = FALSE;
-      stmt_act = NULL;
-    }
-
-  if (have_info)
+  if (*have_info)
     {
       int op_depth;
       svn_node_kind_t node_kind;
@@ -9118,9 +9694,15 @@ read_info(svn_wc__db_status_t *status,
 
           while (!err && op_depth != 0)
             {
-              err = svn_sqlite__step(&have_info, stmt_info);
+              err = svn_sqlite__step(have_info, stmt_info);
+
+              if (err || !*have_info)
+                break;
 
-              if (err || !have_info)
+              if (relpath_column >= 0
+                  && strcmp(svn_sqlite__column_text(stmt_info, relpath_column,
+                                                    NULL),
+                            local_relpath) != 0)
                 break;
 
               op_depth = svn_sqlite__column_int(stmt_info, 0);
@@ -9207,12 +9789,99 @@ read_info(svn_wc__db_status_t *status,
     }
   else
     {
-      err = svn_error_createf(SVN_ERR_WC_PATH_NOT_FOUND, NULL,
-                              _("The node '%s' was not found."),
-                              path_for_error_message(wcroot, local_relpath,
-                                                     scratch_pool));
+      err = svn_error_createf(SVN_ERR_WC_PATH_NOT_FOUND, NULL,
+                              _("The node '%s' was not found."),
+                              path_for_error_message(wcroot, local_relpath,
+                                                     scratch_pool));
+    }
+
+  return err;
+}
+
+/* Like svn_wc__db_read_info(), but taking WCROOT+LOCAL_RELPATH instead of
+   DB+LOCAL_ABSPATH, and outputting repos ids instead of URL+UUID. */
+static svn_error_t *
+read_info(svn_wc__db_status_t *status,
+          svn_node_kind_t *kind,
+          svn_revnum_t *revision,
+          const char **repos_relpath,
+          apr_int64_t *repos_id,
+          svn_revnum_t *changed_rev,
+          apr_time_t *changed_date,
+          const char **changed_author,
+          svn_depth_t *depth,
+          const svn_checksum_t **checksum,
+          const char **target,
+          const char **original_repos_relpath,
+          apr_int64_t *original_repos_id,
+          svn_revnum_t *original_revision,
+          svn_wc__db_lock_t **lock,
+          svn_filesize_t *recorded_size,
+          apr_time_t *recorded_time,
+          const char **changelist,
+          svn_boolean_t *conflicted,
+          svn_boolean_t *op_root,
+          svn_boolean_t *had_props,
+          svn_boolean_t *props_mod,
+          svn_boolean_t *have_base,
+          svn_boolean_t *have_more_work,
+          svn_boolean_t *have_work,
+          svn_wc__db_wcroot_t *wcroot,
+          const char *local_relpath,
+          apr_pool_t *result_pool,
+          apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt_info;
+  svn_sqlite__stmt_t *stmt_act;
+  svn_boolean_t have_info;
+  svn_boolean_t have_act;
+  const cached_node_t *node;
+  svn_error_t *err;
+
+  if (find_cached_node(&node, wcroot, local_relpath))
+    return svn_error_trace(
+             read_info_from_cache(status, kind, revision, repos_relpath,
+                                  repos_id, changed_rev, changed_date,
+                                  changed_author, depth, checksum, target,
+                                  original_repos_relpath, original_repos_id,
+                                  original_revision, lock, recorded_size,
+                                  recorded_time, changelist, conflicted,
+                                  op_root, had_props, props_mod,
+                                  have_base, have_more_work, have_work,
+                                  node, wcroot, local_relpath,
+                                  result_pool, scratch_pool));
+
+  /* Obtain the most likely to exist record first, to make sure we don't
+     have to obtain the SQLite read-lock multiple times */
+  SVN_ERR(svn_sqlite__get_statement(&stmt_info, wcroot->sdb,
+                                    lock ? STMT_SELECT_NODE_INFO_WITH_LOCK
+                                         : STMT_SELECT_NODE_INFO));
+  SVN_ERR(svn_sqlite__bindf(stmt_info, "is", wcroot->wc_id, local_relpath));
+  SVN_ERR(svn_sqlite__step(&have_info, stmt_info));
+
+  if (changelist || conflicted || props_mod)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt_act, wcroot->sdb,
+                                        STMT_SELECT_ACTUAL_NODE));
+      SVN_ERR(svn_sqlite__bindf(stmt_act, "is", wcroot->wc_id, local_relpath));
+      SVN_ERR(svn_sqlite__step(&have_act, stmt_act));
+    }
+  else
+    {
+      have_act = FALSE;
+      stmt_act = NULL;
     }
 
+  err = read_info_from_rows(status, kind, revision, repos_relpath, repos_id,
+                            changed_rev, changed_date, changed_author,
+                            depth, checksum, target, original_repos_relpath,
+                            original_repos_id, original_revision, lock,
+                            recorded_size, recorded_time, changelist,
+                            conflicted, op_root, had_props, props_mod,
+                            have_base, have_more_work, have_work,
+                            &have_info, stmt_info, -1, have_act, stmt_act,
+                            wcroot, local_relpath, result_pool, scratch_pool);
+
   if (stmt_act != NULL)
     err = svn_error_compose_create(err, svn_sqlite__reset(stmt_act));
 
@@ -9269,6 +9938,188 @@ svn_wc__db_read_info_internal(svn_wc__db_status_t *status,
 }
 
 
+/* Set *CACHE_P to a new node cache holding the information on
+   LOCAL_RELPATH and all its descendants in WCROOT, allocated in a new
+   subpool of RESULT_POOL.  Set *CACHE_P to NULL if the information in
+   the database is not valid; reporting that is left to the uncached code
+   path, which only does so if the broken node is actually accessed.
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+load_node_cache(struct svn_wc__db_node_cache_t **cache_p,
+                svn_wc__db_wcroot_t *wcroot,
+                const char *local_relpath,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  struct svn_wc__db_node_cache_t *cache;
+  apr_pool_t *cache_pool;
+  svn_sqlite__stmt_t *stmt_info;
+  svn_sqlite__stmt_t *stmt_act;
+  svn_boolean_t have_info;
+  svn_boolean_t have_act;
+  apr_pool_t *iterpool;
+  svn_error_t *err = NULL;
+  int i, j;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt_info, wcroot->sdb,
+                                    STMT_SELECT_NODE_INFO_WITH_LOCK_RECURSIVE));
+  SVN_ERR(svn_sqlite__bindf(stmt_info, "is", wcroot->wc_id, local_relpath));
+  SVN_ERR(svn_sqlite__step(&have_info, stmt_info));
+
+  err = svn_sqlite__get_statement(&stmt_act, wcroot->sdb,
+                                  STMT_SELECT_ACTUAL_NODE_RECURSIVE);
+  if (!err)
+    err = svn_sqlite__bindf(stmt_act, "is", wcroot->wc_id, local_relpath);
+  if (!err)
+    err = svn_sqlite__step(&have_act, stmt_act);
+  if (err)
+    return svn_error_compose_create(err, svn_sqlite__reset(stmt_info));
+
+  cache_pool = svn_pool_create(result_pool);
+  cache = apr_pcalloc(cache_pool, sizeof(*cache));
+  cache->local_relpath = apr_pstrdup(cache_pool, local_relpath);
+  cache->nodes = apr_array_make(cache_pool, 64, sizeof(cached_node_t));
+  cache->total_changes = svn_sqlite__total_changes(wcroot->sdb);
+  cache->pool = cache_pool;
+
+  iterpool = svn_pool_create(scratch_pool);
+
+  /* Both statements return their rows in descending local_relpath order,
+     so merge them node by node. */
+  while (!err && (have_info || have_act))
+    {
+      cached_node_t *node = apr_array_push(cache->nodes);
+      svn_boolean_t node_has_info;
+      svn_boolean_t node_has_act;
+      svn_boolean_t no_info = FALSE;
+
+      svn_pool_clear(iterpool);
+
+      if (have_info && have_act)
+        {
+          int cmp = strcmp(svn_sqlite__column_text(stmt_info, 21, NULL),
+                           svn_sqlite__column_text(stmt_act, 3, NULL));
+
+          node_has_info = (cmp >= 0);
+          node_has_act = (cmp <= 0);
+        }
+      else
+        {
+          node_has_info = have_info;
+          node_has_act = have_act;
+        }
+
+      node->local_relpath = node_has_info
+                 ? svn_sqlite__column_text(stmt_info, 21, cache->pool)
+                 : svn_sqlite__column_text(stmt_act, 3, cache->pool);
+      node->actual_only = !node_has_info;
+
+      err = read_info_from_rows(&node->status, &node->kind, &node->revision,
+                                &node->repos_relpath, &node->repos_id,
+                                &node->changed_rev, &node->changed_date,
+                                &node->changed_author, &node->depth,
+                                &node->checksum, &node->target,
+                                &node->original_repos_relpath,
+                                &node->original_repos_id,
+                                &node->original_revision, &node->lock,
+                                &node->recorded_size, &node->recorded_time,
+                                &node->changelist, &node->conflicted,
+                                &node->op_root, &node->had_props,
+                                &node->props_mod, &node->have_base,
+                                &node->have_more_work, &node->have_work,
+                                node_has_info ? &have_info : &no_info,
+                                stmt_info, 21, node_has_act, stmt_act,
+                                wcroot, node->local_relpath,
+                                cache->pool, iterpool);
+
+      /* Skip the remaining NODES rows of this node */
+      while (!err && node_has_info && have_info
+             && strcmp(svn_sqlite__column_text(stmt_info, 21, NULL),
+                       node->local_relpath) == 0)
+        err = svn_sqlite__step(&have_info, stmt_info);
+
+      if (!err && node_has_act)
+        err = svn_sqlite__step(&have_act, stmt_act);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  err = svn_error_compose_create(err, svn_sqlite__reset(stmt_act));
+  err = svn_error_compose_create(err, svn_sqlite__reset(stmt_info));
+
+  if (err)
+    {
+      svn_pool_destroy(cache_pool);
+
+      if (err->apr_err != SVN_ERR_WC_CORRUPT)
+        return svn_error_trace(err);
+
+      svn_error_clear(err);
+      *cache_p = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  /* Turn the descending order into the ascending order used for lookups */
+  for (i = 0, j = cache->nodes->nelts - 1; i < j; i++, j--)
+    {
+      cached_node_t tmp = APR_ARRAY_IDX(cache->nodes, i, cached_node_t);
+
+      APR_ARRAY_IDX(cache->nodes, i, cached_node_t)
+        = APR_ARRAY_IDX(cache->nodes, j, cached_node_t);
+      APR_ARRAY_IDX(cache->nodes, j, cached_node_t) = tmp;
+    }
+
+  *cache_p = cache;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_cache_nodes(svn_wc__db_t *db,
+                       const char *local_abspath,
+                       apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  struct svn_wc__db_node_cache_t *cache;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              local_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  drop_node_cache(wcroot);
+
+  SVN_WC__DB_WITH_TXN(
+    load_node_cache(&cache, wcroot, local_relpath, db->state_pool,
+                    scratch_pool),
+    wcroot);
+
+  wcroot->node_cache = cache;
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_uncache_nodes(svn_wc__db_t *db,
+                         const char *local_abspath,
+                         apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              local_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  drop_node_cache(wcroot);
+
+  return SVN_NO_ERROR;
+}
+
+
 svn_error_t *
 svn_wc__db_read_info(svn_wc__db_status_t *status,
                      svn_node_kind_t *kind,
@@ -13471,6 +14322,7 @@ svn_wc__db_upgrade_begin(svn_sqlite__db_t **sdb,
                     NULL, SVN_INVALID_REVNUM, svn_depth_unknown,
                     store_pristine,
                     TRUE /* exclusive */,
+                    FALSE /* wal */,
                     0 /* timeout */,
                     wc_db->state_pool, scratch_pool));
 
@@ -13480,6 +14332,7 @@ svn_wc__db_upgrade_begin(svn_sqlite__db_t **sdb,
                                        *sdb, *wc_id, FORMAT_FROM_SDB,
                                        FALSE /* auto-upgrade */,
                                        store_pristine,
+                                       wc_db->shared_pristine_abspath,
                                        wc_db->state_pool, scratch_pool));
 
   /* The WCROOT is complete. Stash it into DB.  */
@@ -13697,39 +14550,102 @@ wq_record(svn_wc__db_wcroot_t *wcroot,
       SVN_ERR(db_record_fileinfo(wcroot, local_relpath,
                                  info->size, info->mtime,
                                  iterpool));
+      if (info->fingerprint)
+        SVN_ERR(db_record_fingerprint(wcroot, local_relpath, info->size,
+                                      info->fingerprint, iterpool));
     }
 
   svn_pool_destroy(iterpool);
   return SVN_NO_ERROR;
 }
 
+/* The body of svn_wc__db_wq_record_and_fetch_batch().
+ */
+static svn_error_t *
+wq_record_and_fetch_batch(apr_array_header_t *ids,
+                          apr_array_header_t *work_items,
+                          svn_wc__db_wcroot_t *wcroot,
+                          const apr_array_header_t *completed_ids,
+                          apr_hash_t *record_map,
+                          int max_items,
+                          apr_pool_t *result_pool,
+                          apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  int i;
+
+  if (completed_ids && completed_ids->nelts)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                        STMT_DELETE_WORK_ITEM));
+      for (i = 0; i < completed_ids->nelts; i++)
+        {
+          SVN_ERR(svn_sqlite__bind_int64(stmt, 1,
+                                         APR_ARRAY_IDX(completed_ids, i,
+                                                       apr_uint64_t)));
+          SVN_ERR(svn_sqlite__step_done(stmt));
+        }
+    }
+
+  if (record_map)
+    SVN_ERR(wq_record(wcroot, record_map, scratch_pool));
+
+  if (max_items == 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_WORK_ITEMS));
+  SVN_ERR(svn_sqlite__bind_int(stmt, 1, max_items));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+
+  while (have_row)
+    {
+      apr_size_t len;
+      const void *val;
+
+      APR_ARRAY_PUSH(ids, apr_uint64_t) = svn_sqlite__column_int64(stmt, 0);
+
+      val = svn_sqlite__column_blob(stmt, 1, &len, result_pool);
+      APR_ARRAY_PUSH(work_items, svn_skel_t *)
+        = svn_skel__parse(val, len, result_pool);
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
 svn_error_t *
-svn_wc__db_wq_record_and_fetch_next(apr_uint64_t *id,
-                                    svn_skel_t **work_item,
-                                    svn_wc__db_t *db,
-                                    const char *wri_abspath,
-                                    apr_uint64_t completed_id,
-                                    apr_hash_t *record_map,
-                                    apr_pool_t *result_pool,
-                                    apr_pool_t *scratch_pool)
+svn_wc__db_wq_record_and_fetch_batch(apr_array_header_t **ids,
+                                     apr_array_header_t **work_items,
+                                     svn_wc__db_t *db,
+                                     const char *wri_abspath,
+                                     const apr_array_header_t *completed_ids,
+                                     apr_hash_t *record_map,
+                                     int max_items,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool)
 {
   svn_wc__db_wcroot_t *wcroot;
   const char *local_relpath;
 
-  SVN_ERR_ASSERT(id != NULL);
-  SVN_ERR_ASSERT(work_item != NULL);
+  SVN_ERR_ASSERT(ids != NULL);
+  SVN_ERR_ASSERT(work_items != NULL);
+  SVN_ERR_ASSERT(max_items >= 0);
   SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
 
   SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
                               wri_abspath, scratch_pool, scratch_pool));
   VERIFY_USABLE_WCROOT(wcroot);
 
+  *ids = apr_array_make(result_pool, max_items, sizeof(apr_uint64_t));
+  *work_items = apr_array_make(result_pool, max_items, sizeof(svn_skel_t *));
+
   SVN_WC__DB_WITH_TXN(
-    svn_error_compose_create(
-            wq_fetch_next(id, work_item,
-                          wcroot, local_relpath, completed_id,
-                          result_pool, scratch_pool),
-            wq_record(wcroot, record_map, scratch_pool)),
+    wq_record_and_fetch_batch(*ids, *work_items, wcroot,
+                              completed_ids, record_map, max_items,
+                              result_pool, scratch_pool),
     wcroot);
 
   return SVN_NO_ERROR;
@@ -15817,6 +16733,88 @@ svn_wc__db_has_db_mods(svn_boolean_t *is_modified,
                                      scratch_pool));
 }
 
+svn_error_t *
+svn_wc__db_read_commit_info_recursive(svn_boolean_t *conflicted,
+                                      svn_wc__db_t *db,
+                                      const char *local_abspath,
+                                      svn_wc__db_commit_info_cb_t callback,
+                                      void *callback_baton,
+                                      svn_cancel_func_t cancel_func,
+                                      void *cancel_baton,
+                                      apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  apr_pool_t *iterpool;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath,
+                                                db, local_abspath,
+                                                scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  if (conflicted)
+    {
+      SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                        STMT_SUBTREE_HAS_CONFLICTS));
+      SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, local_relpath));
+      SVN_ERR(svn_sqlite__step(conflicted, stmt));
+      SVN_ERR(svn_sqlite__reset(stmt));
+
+      if (*conflicted)
+        return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_COMMIT_INFO_RECURSIVE));
+  SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, local_relpath));
+
+  iterpool = svn_pool_create(scratch_pool);
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      const char *node_relpath;
+      svn_filesize_t recorded_size;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        {
+          err = cancel_func(cancel_baton);
+          if (err)
+            return svn_error_compose_create(err, svn_sqlite__reset(stmt));
+        }
+
+      node_relpath = svn_sqlite__column_text(stmt, 0, NULL);
+      if (svn_sqlite__column_is_null(stmt, 4))
+        recorded_size = SVN_INVALID_FILESIZE;
+      else
+        recorded_size = svn_sqlite__column_int64(stmt, 4);
+
+      err = callback(callback_baton,
+                     svn_dirent_join(wcroot->abspath, node_relpath, iterpool),
+                     svn_sqlite__column_token(stmt, 2, presence_map),
+                     svn_sqlite__column_token(stmt, 3, kind_map),
+                     svn_sqlite__column_int(stmt, 1) > 0,
+                     svn_sqlite__column_boolean(stmt, 7),
+                     svn_sqlite__column_boolean(stmt, 6),
+                     recorded_size,
+                     svn_sqlite__column_int64(stmt, 5),
+                     iterpool);
+      if (err)
+        return svn_error_compose_create(err, svn_sqlite__reset(stmt));
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
 
 /* The body of svn_wc__db_revision_status().
  */
@@ -16155,6 +17153,7 @@ svn_wc__db_bump_format(int *result_format,
   err = svn_wc__db_util_open_db(&sdb, wcroot_abspath, SDB_FILE,
                                 svn_sqlite__mode_readwrite,
                                 TRUE, /* exclusive */
+                                FALSE, /* wal */
                                 0, /* default timeout */
                                 NULL, /* my statements */
                                 scratch_pool, scratch_pool);
@@ -16211,6 +17210,36 @@ svn_wc__db_vacuum(svn_wc__db_t *db,
   SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath,
                                                 db, local_abspath,
                                                 scratch_pool, scratch_pool));
+  if (wcroot->have_fingerprints != svn_tristate_false)
+    {
+      svn_sqlite__stmt_t *stmt;
+      svn_boolean_t have_row;
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                        STMT_HAVE_FILE_FINGERPRINTS_TABLE));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      SVN_ERR(svn_sqlite__reset(stmt));
+
+      if (have_row)
+        SVN_ERR(svn_sqlite__exec_statements(
+                          wcroot->sdb, STMT_DELETE_STALE_FILE_FINGERPRINTS));
+    }
+
+  if (wcroot->have_detranslated_checksums != svn_tristate_false)
+    {
+      svn_sqlite__stmt_t *stmt;
+      svn_boolean_t have_row;
+
+      SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_HAVE_DETRANSLATED_CHECKSUMS_TABLE));
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+      SVN_ERR(svn_sqlite__reset(stmt));
+
+      if (have_row)
+        SVN_ERR(svn_sqlite__exec_statements(
+                     wcroot->sdb, STMT_DELETE_STALE_DETRANSLATED_CHECKSUMS));
+    }
+
   SVN_ERR(svn_sqlite__exec_statements(wcroot->sdb, STMT_VACUUM));
 
   return SVN_NO_ERROR;
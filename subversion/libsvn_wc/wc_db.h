@@ -209,6 +209,10 @@ typedef struct svn_wc__db_fileinfo_t {
 
   /* The size of this file. */
   svn_filesize_t size;
+
+  /* The svn_checksum_fnv1a_32x4 checksum of the file as stored on disk,
+     or NULL if not known.  See svn_wc__db_global_record_fingerprint(). */
+  const svn_checksum_t *fingerprint;
 } svn_wc__db_fileinfo_t;
 
 
@@ -386,6 +390,26 @@ svn_wc__db_get_wcroot(const char **wcroot_abspath,
                       apr_pool_t *result_pool,
                       apr_pool_t *scratch_pool);
 
+/* Return the configuration that DB has been opened with.  This may be
+   NULL. */
+svn_config_t *
+svn_wc__db_get_config(svn_wc__db_t *db);
+
+/* Call FUNC with BATON, RESULT_POOL and SCRATCH_POOL within a single
+   transaction on the database of the working copy of WRI_ABSPATH in DB.
+
+   The changes that FUNC makes to that working copy through DB get
+   committed together, or rolled back together if FUNC returns an error.
+   This makes batches of many small changes much cheaper than giving each
+   of them a transaction of its own. */
+svn_error_t *
+svn_wc__db_with_txn(svn_wc__db_t *db,
+                    const char *wri_abspath,
+                    svn_wc__with_write_lock_func_t func,
+                    void *baton,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool);
+
 
 /* @} */
 
@@ -845,6 +869,21 @@ svn_wc__db_base_get_children_info(apr_hash_t **nodes,
                                   apr_pool_t *result_pool,
                                   apr_pool_t *scratch_pool);
 
+/* Like svn_wc__db_base_get_children_info(), but for all BASE descendants
+   of DIR_ABSPATH, using a single scan of the NODES table.
+
+   Return in *DIRS a hash mapping the path, relative to DIR_ABSPATH, of
+   every directory at or below DIR_ABSPATH that has BASE children to a
+   hash like the one that svn_wc__db_base_get_children_info() returns for
+   that directory.  DIR_ABSPATH itself is mapped as "".
+ */
+svn_error_t *
+svn_wc__db_base_get_descendants_info(apr_hash_t **dirs,
+                                     svn_wc__db_t *db,
+                                     const char *dir_abspath,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool);
+
 
 /* Set *PROPS to the properties of the node LOCAL_ABSPATH in the BASE tree.
 
@@ -1058,6 +1097,20 @@ svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
                             apr_pool_t *scratch_pool);
 
 
+/* Like svn_wc__db_pristine_cleanup(), but in time proportional to the
+ * number of unreferenced pristines and without scanning the shared
+ * pristine store.  This does not need a write lock on the WC of
+ * WRI_ABSPATH in DB, so it can run after every commit or update.
+ *
+ * Do nothing if the work queue is not empty. */
+svn_error_t *
+svn_wc__db_pristine_reclaim(svn_wc__db_t *db,
+                            const char *wri_abspath,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *scratch_pool);
+
+
 /* Set *PRESENT to true if the pristine store for WRI_ABSPATH in DB contains
    a pristine text with SHA-1 checksum SHA1_CHECKSUM, and to false otherwise.
    If the pristine is present, set *HYDRATED to true if its contents are
@@ -1994,6 +2047,33 @@ svn_wc__db_read_info(svn_wc__db_status_t *status,  /* ### derived */
                      apr_pool_t *result_pool,
                      apr_pool_t *scratch_pool);
 
+/* Load the NODES and ACTUAL_NODE information of LOCAL_ABSPATH and all its
+   descendants in DB into memory, such that svn_wc__db_read_info() (and
+   everything else built on the same internal function) can answer
+   requests for nodes in that subtree without querying the database.
+
+   This is meant for operations that read the information of many nodes of
+   a subtree one by one and do not modify the working copy, like 'svn info
+   -R'.  The cache gets discarded as soon as the working copy database is
+   modified through DB, but changes made through other connections to the
+   same working copy are not noticed; call svn_wc__db_uncache_nodes() once
+   the operation is done.
+
+   Replaces any cache loaded earlier for the working copy that contains
+   LOCAL_ABSPATH.  Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_wc__db_cache_nodes(svn_wc__db_t *db,
+                       const char *local_abspath,
+                       apr_pool_t *scratch_pool);
+
+/* Discard the cache loaded by svn_wc__db_cache_nodes() for the working
+   copy that contains LOCAL_ABSPATH, if any. */
+svn_error_t *
+svn_wc__db_uncache_nodes(svn_wc__db_t *db,
+                         const char *local_abspath,
+                         apr_pool_t *scratch_pool);
+
 /* Structure used as linked list in svn_wc__db_info_t to describe all nodes
    in this location that were moved to another location */
 struct svn_wc__db_moved_to_info_t
@@ -2666,6 +2746,70 @@ svn_wc__db_global_record_fileinfo(svn_wc__db_t *db,
                                   apr_time_t recorded_time,
                                   apr_pool_t *scratch_pool);
 
+/* Record that the working file of the versioned file LOCAL_ABSPATH, of
+   TRANSLATED_SIZE bytes and with the checksum FINGERPRINT over its
+   contents as stored on disk, matches the pristine of the node.
+
+   FINGERPRINT should be a cheap checksum such as svn_checksum_fnv1a_32x4.
+   The record stays valid for as long as the pristine checksum and the
+   changed revision of the node remain the same.
+*/
+svn_error_t *
+svn_wc__db_global_record_fingerprint(svn_wc__db_t *db,
+                                     const char *local_abspath,
+                                     svn_filesize_t translated_size,
+                                     const svn_checksum_t *fingerprint,
+                                     apr_pool_t *scratch_pool);
+
+/* Set *FINGERPRINT to the checksum recorded for the working file of
+   LOCAL_ABSPATH by svn_wc__db_global_record_fingerprint(), if that was
+   recorded for a working file of TRANSLATED_SIZE bytes and is still
+   valid.  Otherwise, set *FINGERPRINT to NULL.
+
+   Allocate *FINGERPRINT in RESULT_POOL.
+*/
+svn_error_t *
+svn_wc__db_read_fingerprint(const svn_checksum_t **fingerprint,
+                            svn_wc__db_t *db,
+                            const char *local_abspath,
+                            svn_filesize_t translated_size,
+                            apr_pool_t *result_pool,
+                            apr_pool_t *scratch_pool);
+
+/* Record that the working file LOCAL_ABSPATH, of TRANSLATED_SIZE bytes
+   and last modified at LAST_MOD_TIME, has the contents CHECKSUM after
+   detranslating it with the settings identified by TRANSLATION.
+
+   TRANSLATION may be any checksum that changes whenever the eol-style
+   or keywords used for detranslating the file change.
+*/
+svn_error_t *
+svn_wc__db_global_record_detranslated_checksum(
+  svn_wc__db_t *db,
+  const char *local_abspath,
+  svn_filesize_t translated_size,
+  apr_time_t last_mod_time,
+  const svn_checksum_t *translation,
+  const svn_checksum_t *checksum,
+  apr_pool_t *scratch_pool);
+
+/* Set *CHECKSUM to the checksum recorded for the working file of
+   LOCAL_ABSPATH by svn_wc__db_global_record_detranslated_checksum(), if
+   that was recorded for the same TRANSLATED_SIZE, LAST_MOD_TIME and
+   TRANSLATION.  Otherwise, set *CHECKSUM to NULL.
+
+   Allocate *CHECKSUM in RESULT_POOL.
+*/
+svn_error_t *
+svn_wc__db_read_detranslated_checksum(const svn_checksum_t **checksum,
+                                      svn_wc__db_t *db,
+                                      const char *local_abspath,
+                                      svn_filesize_t translated_size,
+                                      apr_time_t last_mod_time,
+                                      const svn_checksum_t *translation,
+                                      apr_pool_t *result_pool,
+                                      apr_pool_t *scratch_pool);
+
 
 /* ### post-commit handling.
    ### maybe multiple phases?
@@ -3035,17 +3179,29 @@ svn_wc__db_wq_fetch_next(apr_uint64_t *id,
                          apr_pool_t *result_pool,
                          apr_pool_t *scratch_pool);
 
-/* Special variant of svn_wc__db_wq_fetch_next(), which in the same transaction
-   also records timestamps and sizes for one or more nodes */
+/* Special variant of svn_wc__db_wq_fetch_next(), which handles any number
+   of work items in a single transaction.
+
+   Mark the work items listed in COMPLETED_IDS (an array of apr_uint64_t)
+   as completed, record the timestamps and sizes in RECORD_MAP (which may
+   be NULL) and then fetch up to MAX_ITEMS of the next work items that
+   need to be completed.  Return their identifiers in *IDS (an array of
+   apr_uint64_t) and their data in *WORK_ITEMS (an array of svn_skel_t *),
+   in the order they were queued.  Both arrays are empty if there are no
+   more work items or if MAX_ITEMS is 0.
+
+   RESULT_POOL will be used to allocate the arrays and work items, and
+   SCRATCH_POOL will be used for all temporary allocations.  */
 svn_error_t *
-svn_wc__db_wq_record_and_fetch_next(apr_uint64_t *id,
-                                    svn_skel_t **work_item,
-                                    svn_wc__db_t *db,
-                                    const char *wri_abspath,
-                                    apr_uint64_t completed_id,
-                                    apr_hash_t *record_map,
-                                    apr_pool_t *result_pool,
-                                    apr_pool_t *scratch_pool);
+svn_wc__db_wq_record_and_fetch_batch(apr_array_header_t **ids,
+                                     apr_array_header_t **work_items,
+                                     svn_wc__db_t *db,
+                                     const char *wri_abspath,
+                                     const apr_array_header_t *completed_ids,
+                                     apr_hash_t *record_map,
+                                     int max_items,
+                                     apr_pool_t *result_pool,
+                                     apr_pool_t *scratch_pool);
 
 
 /* @} */
@@ -3138,30 +3294,27 @@ svn_wc__db_textbase_walk(svn_wc__db_t *db,
                          void *cancel_baton,
                          apr_pool_t *scratch_pool);
 
-/* The callback invoked by svn_wc__db_textbase_sync(). */
-typedef svn_error_t * (*svn_wc__db_textbase_fetch_cb_t)(
-  void *baton,
-  const char *repos_root_url,
-  const char *repos_relpath,
-  svn_revnum_t revision,
-  svn_stream_t *contents,
-  svn_cancel_func_t cancel_func,
-  void *cancel_baton,
-  apr_pool_t *scratch_pool);
-
 /* Synchronize the state of the text-bases in DB.
 
    If ALLOW_HYDRATE is true, fetch the referenced but missing text-base
-   contents using the provided FETCH_CALLBACK and FETCH_BATON.
+   contents using the provided FETCH_CALLBACK and FETCH_BATON, passing
+   up to BATCH_SIZE text-bases to each invocation of the callback.
    If ALLOW_DEHYDRATE is true, remove the on disk text-base contents
    that is no longer referenced.
+
+   If CACHE_SIZE is non-zero, keep unreferenced text-bases of the whole
+   working copy up to a total of CACHE_SIZE bytes instead of removing
+   them, preferring the most recently used ones.  Referenced text-bases
+   count as used whenever they get synchronized.
  */
 svn_error_t *
 svn_wc__db_textbase_sync(svn_wc__db_t *db,
                          const char *local_abspath,
                          svn_boolean_t allow_hydrate,
                          svn_boolean_t allow_dehydrate,
-                         svn_wc__db_textbase_fetch_cb_t fetch_callback,
+                         int batch_size,
+                         apr_uint64_t cache_size,
+                         svn_wc__textbase_fetch_batch_cb_t fetch_callback,
                          void *fetch_baton,
                          svn_cancel_func_t cancel_func,
                          void *cancel_baton,
@@ -3453,6 +3606,44 @@ svn_wc__db_has_db_mods(svn_boolean_t *is_modified,
                        const char *local_abspath,
                        apr_pool_t *scratch_pool);
 
+/* The callback invoked by svn_wc__db_read_commit_info_recursive() for
+ * every node.  STATUS and KIND describe the topmost layer of the node,
+ * HAVE_WORK tells whether that layer is a WORKING layer.  PROPS_MOD is
+ * TRUE if the node has local property changes and FILE_EXTERNAL is TRUE
+ * for file externals.  RECORDED_SIZE (or SVN_INVALID_FILESIZE) and
+ * RECORDED_TIME are the values recorded for the working file. */
+typedef svn_error_t * (*svn_wc__db_commit_info_cb_t)(
+  void *baton,
+  const char *local_abspath,
+  svn_wc__db_status_t status,
+  svn_node_kind_t kind,
+  svn_boolean_t have_work,
+  svn_boolean_t props_mod,
+  svn_boolean_t file_external,
+  svn_filesize_t recorded_size,
+  apr_time_t recorded_time,
+  apr_pool_t *scratch_pool);
+
+/* Invoke CALLBACK with CALLBACK_BATON for every node in the tree rooted
+ * at LOCAL_ABSPATH in DB, in no particular order, reading all of them
+ * with a single query.  CALLBACK must not access DB.
+ *
+ * If CONFLICTED is not NULL and any node in the tree is conflicted, set
+ * *CONFLICTED to TRUE and don't invoke CALLBACK at all.  Otherwise set
+ * *CONFLICTED to FALSE.
+ *
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+svn_wc__db_read_commit_info_recursive(svn_boolean_t *conflicted,
+                                      svn_wc__db_t *db,
+                                      const char *local_abspath,
+                                      svn_wc__db_commit_info_cb_t callback,
+                                      void *callback_baton,
+                                      svn_cancel_func_t cancel_func,
+                                      void *cancel_baton,
+                                      apr_pool_t *scratch_pool);
+
 
 /* Verify the consistency of metadata concerning the WC that contains
  * WRI_ABSPATH, in DB.  Return an error if any problem is found. */
@@ -30,6 +30,7 @@
 #include "svn_dirent_uri.h"
 
 #include "private/svn_io_private.h"
+#include "private/svn_profile.h"
 
 #include "wc.h"
 #include "wc_db.h"
@@ -42,6 +43,42 @@
 
 
 
+/* Returns in PRISTINE_ABSPATH a new string allocated from RESULT_POOL,
+   holding the local absolute path to the file location that is dedicated
+   to hold CHECKSUM's pristine file within the pristine store directory
+   BASE_DIR_ABSPATH. The returned path does not necessarily currently exist.
+
+   Any other allocations are made in SCRATCH_POOL. */
+static svn_error_t *
+get_store_fname(const char **pristine_abspath,
+                const char *base_dir_abspath,
+                const svn_checksum_t *sha1_checksum,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  const char *hexdigest = svn_checksum_to_cstring(sha1_checksum, scratch_pool);
+  char subdir[3];
+
+  /* We should have a valid checksum and (thus) a valid digest. */
+  SVN_ERR_ASSERT(hexdigest != NULL);
+
+  /* Get the first two characters of the digest, for the subdir. */
+  subdir[0] = hexdigest[0];
+  subdir[1] = hexdigest[1];
+  subdir[2] = '\0';
+
+  hexdigest = apr_pstrcat(scratch_pool, hexdigest, PRISTINE_STORAGE_EXT,
+                          SVN_VA_NULL);
+
+  /* The file is located at DIR/.svn/pristine/XX/XXYYZZ...svn-base */
+  *pristine_abspath = svn_dirent_join_many(result_pool,
+                                           base_dir_abspath,
+                                           subdir,
+                                           hexdigest,
+                                           SVN_VA_NULL);
+  return SVN_NO_ERROR;
+}
+
 /* Returns in PRISTINE_ABSPATH a new string allocated from RESULT_POOL,
    holding the local absolute path to the file location that is dedicated
    to hold CHECKSUM's pristine file, relating to the pristine store
@@ -57,8 +94,6 @@ get_pristine_fname(const char **pristine_abspath,
                    apr_pool_t *scratch_pool)
 {
   const char *base_dir_abspath;
-  const char *hexdigest = svn_checksum_to_cstring(sha1_checksum, scratch_pool);
-  char subdir[3];
 
   /* ### code is in transition. make sure we have the proper data.  */
   SVN_ERR_ASSERT(pristine_abspath != NULL);
@@ -72,23 +107,201 @@ get_pristine_fname(const char **pristine_abspath,
                                           PRISTINE_STORAGE_RELPATH,
                                           SVN_VA_NULL);
 
-  /* We should have a valid checksum and (thus) a valid digest. */
-  SVN_ERR_ASSERT(hexdigest != NULL);
+  return svn_error_trace(get_store_fname(pristine_abspath, base_dir_abspath,
+                                         sha1_checksum,
+                                         result_pool, scratch_pool));
+}
 
-  /* Get the first two characters of the digest, for the subdir. */
-  subdir[0] = hexdigest[0];
-  subdir[1] = hexdigest[1];
-  subdir[2] = '\0';
 
-  hexdigest = apr_pstrcat(scratch_pool, hexdigest, PRISTINE_STORAGE_EXT,
-                          SVN_VA_NULL);
+/* The shared pristine store.
+ *
+ * Working copies that are configured with the same
+ * SVN_CONFIG_OPTION_SHARED_PRISTINE_STORE directory share their hydrated
+ * pristine files.  The shared store uses the same layout as the pristine
+ * store in .svn/pristine and every file in it is a hard link to the
+ * pristine file of at least one working copy.  Its link count thereby is
+ * its reference count: a working copy that removes or dehydrates its
+ * pristine file simply drops its link, and the shared store forgets
+ * about files that nobody links to anymore in shared_store_prune().
+ *
+ * Pristine files are never modified in place, so sharing the inode is
+ * safe.  The shared store is only ever an optimization: whenever linking
+ * fails, e.g. because the store lives on a different filesystem, the
+ * working copy keeps a private copy as before.
+ */
+
+/* If the shared pristine store of WCROOT contains the pristine text
+ * SHA1_CHECKSUM with EXPECTED_SIZE bytes, replace PRISTINE_ABSPATH with
+ * a hard link to it and set *LINKED to TRUE.  Otherwise set *LINKED to
+ * FALSE and leave PRISTINE_ABSPATH alone.
+ */
+static svn_error_t *
+link_from_shared_store(svn_boolean_t *linked,
+                       svn_wc__db_wcroot_t *wcroot,
+                       const svn_checksum_t *sha1_checksum,
+                       svn_filesize_t expected_size,
+                       const char *pristine_abspath,
+                       apr_pool_t *scratch_pool)
+{
+  const char *shared_abspath;
+  const svn_io_dirent2_t *dirent;
+  svn_error_t *err;
+
+  *linked = FALSE;
+
+  if (!wcroot->shared_pristine_abspath)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_store_fname(&shared_abspath, wcroot->shared_pristine_abspath,
+                          sha1_checksum, scratch_pool, scratch_pool));
+  SVN_ERR(svn_io_stat_dirent2(&dirent, shared_abspath, FALSE, TRUE,
+                              scratch_pool, scratch_pool));
+  if (dirent->kind != svn_node_file || dirent->filesize != expected_size)
+    return SVN_NO_ERROR;
+
+  err = svn_io_make_dir_recursively(svn_dirent_dirname(pristine_abspath,
+                                                       scratch_pool),
+                                    scratch_pool);
+  if (!err)
+    err = svn_io_remove_file2(pristine_abspath, TRUE, scratch_pool);
+  if (!err)
+    err = svn_io__file_link(shared_abspath, pristine_abspath, scratch_pool);
+
+  if (err)
+    svn_error_clear(err);
+  else
+    *linked = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Offer the pristine file PRISTINE_ABSPATH of SHA1_CHECKSUM to the shared
+ * pristine store of WCROOT, if it has one.
+ */
+static svn_error_t *
+share_pristine(svn_wc__db_wcroot_t *wcroot,
+               const svn_checksum_t *sha1_checksum,
+               const char *pristine_abspath,
+               apr_pool_t *scratch_pool)
+{
+  const char *shared_abspath;
+  svn_error_t *err;
+
+  if (!wcroot->shared_pristine_abspath)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_store_fname(&shared_abspath, wcroot->shared_pristine_abspath,
+                          sha1_checksum, scratch_pool, scratch_pool));
+
+  err = svn_io_make_dir_recursively(svn_dirent_dirname(shared_abspath,
+                                                       scratch_pool),
+                                    scratch_pool);
+  if (!err)
+    err = svn_io__file_link(pristine_abspath, shared_abspath, scratch_pool);
+
+  /* If another working copy was faster, or if we can't link at all, just
+     keep our private copy. */
+  svn_error_clear(err);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove the files from the shared pristine store at STORE_ABSPATH that
+ * no working copy links to anymore.
+ */
+static svn_error_t *
+shared_store_prune(const char *store_abspath,
+                   apr_pool_t *scratch_pool)
+{
+  apr_hash_t *subdirs;
+  apr_hash_index_t *hi;
+  apr_pool_t *iterpool;
+  apr_pool_t *fileiterpool;
+  svn_error_t *err;
+
+  err = svn_io_get_dirents3(&subdirs, store_abspath, TRUE,
+                            scratch_pool, scratch_pool);
+  if (err && (APR_STATUS_IS_ENOENT(err->apr_err)
+              || SVN__APR_STATUS_IS_ENOTDIR(err->apr_err)))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  iterpool = svn_pool_create(scratch_pool);
+  fileiterpool = svn_pool_create(scratch_pool);
+  for (hi = apr_hash_first(scratch_pool, subdirs); hi; hi = apr_hash_next(hi))
+    {
+      const svn_io_dirent2_t *subdir = apr_hash_this_val(hi);
+      const char *subdir_abspath;
+      apr_hash_t *files;
+      apr_hash_index_t *hi2;
+
+      if (subdir->kind != svn_node_dir)
+        continue;
+
+      svn_pool_clear(iterpool);
+
+      subdir_abspath = svn_dirent_join(store_abspath, apr_hash_this_key(hi),
+                                       iterpool);
+      SVN_ERR(svn_io_get_dirents3(&files, subdir_abspath, TRUE,
+                                  iterpool, iterpool));
+
+      for (hi2 = apr_hash_first(iterpool, files); hi2; hi2 = apr_hash_next(hi2))
+        {
+          const svn_io_dirent2_t *file = apr_hash_this_val(hi2);
+          const char *file_abspath;
+          apr_finfo_t finfo;
+
+          if (file->kind != svn_node_file)
+            continue;
+
+          svn_pool_clear(fileiterpool);
+
+          file_abspath = svn_dirent_join(subdir_abspath,
+                                         apr_hash_this_key(hi2),
+                                         fileiterpool);
+
+          /* Files that belong to other users may not be removable by us;
+             that is for them to clean up. */
+          err = svn_io_stat(&finfo, file_abspath, APR_FINFO_NLINK,
+                            fileiterpool);
+          if (!err && finfo.nlink == 1)
+            err = svn_io_remove_file2(file_abspath, TRUE, fileiterpool);
+          svn_error_clear(err);
+        }
+    }
+  svn_pool_destroy(fileiterpool);
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Remove the pristine text SHA1_CHECKSUM from the shared pristine store
+ * of WCROOT, if it has one and no working copy links to it anymore.
+ * This is shared_store_prune() for a single file.
+ */
+static svn_error_t *
+shared_store_release(svn_wc__db_wcroot_t *wcroot,
+                     const svn_checksum_t *sha1_checksum,
+                     apr_pool_t *scratch_pool)
+{
+  const char *shared_abspath;
+  apr_finfo_t finfo;
+  svn_error_t *err;
+
+  if (!wcroot->shared_pristine_abspath)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_store_fname(&shared_abspath, wcroot->shared_pristine_abspath,
+                          sha1_checksum, scratch_pool, scratch_pool));
+
+  err = svn_io_stat(&finfo, shared_abspath, APR_FINFO_NLINK, scratch_pool);
+  if (!err && finfo.nlink == 1)
+    err = svn_io_remove_file2(shared_abspath, TRUE, scratch_pool);
+  svn_error_clear(err);
 
-  /* The file is located at DIR/.svn/pristine/XX/XXYYZZ...svn-base */
-  *pristine_abspath = svn_dirent_join_many(result_pool,
-                                           base_dir_abspath,
-                                           subdir,
-                                           hexdigest,
-                                           SVN_VA_NULL);
   return SVN_NO_ERROR;
 }
 
@@ -362,15 +575,31 @@ pristine_install_txn(svn_wc__db_wcroot_t *wcroot,
 
   if (install_stream)
     {
-      /* Move the file to its target location.  (If it is already there, it is
-       * an orphan file and it doesn't matter if we overwrite it.) */
+      svn_boolean_t linked;
+
+      /* Another working copy may have stored the same text already. */
+      SVN_ERR(link_from_shared_store(&linked, wcroot, sha1_checksum,
+                                     install_data->size, pristine_abspath,
+                                     scratch_pool));
+      if (linked)
+        {
+          SVN_ERR(svn_stream__install_delete(install_stream, scratch_pool));
+        }
+      else
+        {
+          /* Move the file to its target location.  (If it is already there,
+           * it is an orphan file and it doesn't matter if we overwrite it.) */
+
+          svn_stream__install_set_read_only(install_stream, TRUE);
 
-      svn_stream__install_set_read_only(install_stream, TRUE);
+          SVN_ERR(svn_stream__install_finalize(NULL, NULL, install_stream,
+                                               scratch_pool));
+          SVN_ERR(svn_stream__install_stream(install_stream, pristine_abspath,
+                                             TRUE, scratch_pool));
 
-      SVN_ERR(svn_stream__install_finalize(NULL, NULL, install_stream,
-                                           scratch_pool));
-      SVN_ERR(svn_stream__install_stream(install_stream, pristine_abspath,
-                                         TRUE, scratch_pool));
+          SVN_ERR(share_pristine(wcroot, sha1_checksum, pristine_abspath,
+                                 scratch_pool));
+        }
     }
   else
     {
@@ -455,12 +684,8 @@ svn_wc__db_pristine_prepare_install_internal(svn_stream_t **stream_p,
   svn_stream_set_seek(stream, install_stream_seek_fn);
   svn_stream_set_close(stream, install_stream_close_fn);
 
-  if (md5_checksum_p)
-    stream = svn_stream_checksummed2(stream, NULL, md5_checksum_p,
-                                     svn_checksum_md5, FALSE, result_pool);
-  if (sha1_checksum_p)
-    stream = svn_stream_checksummed2(stream, NULL, sha1_checksum_p,
-                                     svn_checksum_sha1, FALSE, result_pool);
+  stream = svn_stream__checksummed_md5_sha1(stream, md5_checksum_p,
+                                            sha1_checksum_p, result_pool);
 
   *stream_p = stream;
   *install_data_p = install_data;
@@ -476,6 +701,7 @@ svn_wc__db_pristine_install(svn_wc__db_install_data_t *install_data,
 {
   svn_wc__db_wcroot_t *wcroot = install_data->wcroot;
   const char *pristine_abspath;
+  apr_time_t start = svn_profile__start();
 
   SVN_ERR_ASSERT(sha1_checksum != NULL);
   SVN_ERR_ASSERT(sha1_checksum->kind == svn_checksum_sha1);
@@ -495,6 +721,9 @@ svn_wc__db_pristine_install(svn_wc__db_install_data_t *install_data,
                          scratch_pool),
     wcroot->sdb);
 
+  svn_profile__record("pristine", "install", start,
+                      (apr_uint64_t)install_data->size);
+
   return SVN_NO_ERROR;
 }
 
@@ -749,6 +978,76 @@ pristine_cleanup_wcroot(svn_wc__db_wcroot_t *wcroot,
       svn_error_compose_create(err, svn_sqlite__reset(stmt)));
 }
 
+svn_error_t *
+svn_wc__db_pristine_reclaim(svn_wc__db_t *db,
+                            const char *wri_abspath,
+                            svn_cancel_func_t cancel_func,
+                            void *cancel_baton,
+                            apr_pool_t *scratch_pool)
+{
+  svn_wc__db_wcroot_t *wcroot;
+  const char *local_relpath;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+  apr_array_header_t *checksums;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR_ASSERT(svn_dirent_is_absolute(wri_abspath));
+
+  SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
+                              wri_abspath, scratch_pool, scratch_pool));
+  VERIFY_USABLE_WCROOT(wcroot);
+
+  /* Queued work items may refer to texts that have no other references
+     yet; leave everything to the next run. */
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb, STMT_LOOK_FOR_WORK));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  SVN_ERR(svn_sqlite__reset(stmt));
+  if (have_row)
+    return SVN_NO_ERROR;
+
+  /* The I_PRISTINE_UNREFERENCED index makes this as cheap as the number
+     of unreferenced texts.  Collect them first, such that we don't keep
+     a read transaction open while removing them. */
+  checksums = apr_array_make(scratch_pool, 16, sizeof(svn_checksum_t *));
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_UNREFERENCED_PRISTINES));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      const svn_checksum_t *sha1_checksum;
+
+      SVN_ERR(svn_sqlite__column_checksum(&sha1_checksum, stmt, 0,
+                                          scratch_pool));
+      APR_ARRAY_PUSH(checksums, const svn_checksum_t *) = sha1_checksum;
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < checksums->nelts; i++)
+    {
+      const svn_checksum_t *sha1_checksum
+        = APR_ARRAY_IDX(checksums, i, const svn_checksum_t *);
+
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      /* This re-checks the reference count in its own transaction, so
+         texts that got referenced again in the meantime stay. */
+      SVN_ERR(pristine_remove_if_unreferenced(wcroot, sha1_checksum,
+                                              iterpool));
+      SVN_ERR(shared_store_release(wcroot, sha1_checksum, iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
                             const char *wri_abspath,
@@ -765,6 +1064,10 @@ svn_wc__db_pristine_cleanup(svn_wc__db_t *db,
 
   SVN_ERR(pristine_cleanup_wcroot(wcroot, scratch_pool));
 
+  if (wcroot->shared_pristine_abspath)
+    SVN_ERR(shared_store_prune(wcroot->shared_pristine_abspath,
+                               scratch_pool));
+
   return SVN_NO_ERROR;
 }
 
@@ -852,3 +1155,65 @@ svn_wc__db_pristine_dehydrate_internal(svn_wc__db_wcroot_t *wcroot,
 
   return SVN_NO_ERROR;
 }
+
+/* Hydrate the pristine text SHA1_CHECKSUM in WCROOT from the shared
+ * pristine store, if possible.
+ *
+ * This function expects to be executed inside a SQLite txn that has already
+ * acquired a 'RESERVED' lock.
+ */
+static svn_error_t *
+pristine_hydrate_shared_txn(svn_boolean_t *hydrated_p,
+                            svn_wc__db_wcroot_t *wcroot,
+                            const svn_checksum_t *sha1_checksum,
+                            apr_pool_t *scratch_pool)
+{
+  svn_boolean_t have_row;
+  svn_filesize_t size;
+  const char *pristine_abspath;
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t linked;
+
+  SVN_ERR(stmt_select_pristine(&have_row, NULL, &size, hydrated_p,
+                               wcroot, sha1_checksum,
+                               scratch_pool, scratch_pool));
+  if (!have_row || *hydrated_p)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(get_pristine_fname(&pristine_abspath, wcroot->abspath,
+                             sha1_checksum,
+                             scratch_pool, scratch_pool));
+  SVN_ERR(link_from_shared_store(&linked, wcroot, sha1_checksum, size,
+                                 pristine_abspath, scratch_pool));
+  if (!linked)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_UPDATE_PRISTINE_HYDRATED));
+  SVN_ERR(svn_sqlite__bind_checksum(stmt, 1, sha1_checksum, scratch_pool));
+  SVN_ERR(svn_sqlite__bind_int(stmt, 2, TRUE));
+  SVN_ERR(svn_sqlite__update(NULL, stmt));
+
+  *hydrated_p = TRUE;
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__db_pristine_hydrate_shared_internal(svn_boolean_t *hydrated_p,
+                                            svn_wc__db_wcroot_t *wcroot,
+                                            const svn_checksum_t *sha1_checksum,
+                                            apr_pool_t *scratch_pool)
+{
+  SVN_ERR_ASSERT(sha1_checksum->kind == svn_checksum_sha1);
+
+  *hydrated_p = FALSE;
+  if (!wcroot->shared_pristine_abspath)
+    return SVN_NO_ERROR;
+
+  SVN_SQLITE__WITH_IMMEDIATE_TXN(
+    pristine_hydrate_shared_txn(hydrated_p, wcroot, sha1_checksum,
+                                scratch_pool),
+    wcroot->sdb);
+
+  return SVN_NO_ERROR;
+}
@@ -49,9 +49,19 @@ struct svn_wc__db_t {
   /* Should we open Sqlite databases EXCLUSIVE */
   svn_boolean_t exclusive;
 
+  /* Should Sqlite use a write-ahead log instead of a rollback journal? */
+  svn_boolean_t wal;
+
   /* Busy timeout in ms., 0 for the libsvn_subr default. */
   apr_int32_t timeout;
 
+  /* Sqlite page cache and memory map sizes in bytes, 0 for the defaults. */
+  apr_int64_t cache_size;
+  apr_int64_t mmap_size;
+
+  /* The pristine store shared with other working copies, or NULL. */
+  const char *shared_pristine_abspath;
+
   /* Map a given working copy directory to its relevant data.
      const char *local_abspath -> svn_wc__db_wcroot_t *wcroot  */
   apr_hash_t *dir_data;
@@ -111,6 +121,21 @@ typedef struct svn_wc__db_wcroot_t {
      to fetch the contents on demand. */
   svn_boolean_t store_pristine;
 
+  /* The directory of the pristine store that this wcroot shares with
+     other working copies, or NULL.  See wc_db_pristine.c. */
+  const char *shared_pristine_abspath;
+
+  /* The NODES and ACTUAL_NODE rows of a subtree of this wcroot, as loaded
+     by svn_wc__db_cache_nodes(), or NULL. */
+  struct svn_wc__db_node_cache_t *node_cache;
+
+  /* Whether the FILE_FINGERPRINTS table exists in SDB, or
+     svn_tristate_unknown if we didn't look yet. */
+  svn_tristate_t have_fingerprints;
+
+  /* Likewise for the DETRANSLATED_CHECKSUMS table. */
+  svn_tristate_t have_detranslated_checksums;
+
 } svn_wc__db_wcroot_t;
 
 
@@ -131,6 +156,7 @@ svn_wc__db_pdh_create_wcroot(svn_wc__db_wcroot_t **wcroot,
                              int format,
                              svn_boolean_t verify_format,
                              svn_boolean_t store_pristine,
+                             const char *shared_pristine_abspath,
                              apr_pool_t *result_pool,
                              apr_pool_t *scratch_pool);
 
@@ -217,6 +243,7 @@ svn_wc__db_util_open_db(svn_sqlite__db_t **sdb,
                         const char *sdb_fname,
                         svn_sqlite__mode_t smode,
                         svn_boolean_t exclusive,
+                        svn_boolean_t wal,
                         apr_int32_t timeout,
                         const char *const *my_statements,
                         apr_pool_t *result_pool,
@@ -578,6 +605,16 @@ svn_wc__db_pristine_prepare_install_internal(svn_stream_t **stream_p,
                                              apr_pool_t *result_pool,
                                              apr_pool_t *scratch_pool);
 
+/* Hydrate the pristine text SHA1_CHECKSUM in WCROOT by linking it from
+   the shared pristine store of WCROOT.  Set *HYDRATED_P to whether the
+   text is hydrated afterwards.  If WCROOT has no shared pristine store or
+   the store does not contain the text, leave the pristine as it is. */
+svn_error_t *
+svn_wc__db_pristine_hydrate_shared_internal(svn_boolean_t *hydrated_p,
+                                            svn_wc__db_wcroot_t *wcroot,
+                                            const svn_checksum_t *sha1_checksum,
+                                            apr_pool_t *scratch_pool);
+
 /* Like svn_wc__db_pristine_dehydrate() but taking WCROOT instead
    of DB+WRI_ABSPATH. */
 svn_error_t *
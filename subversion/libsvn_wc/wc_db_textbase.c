@@ -26,6 +26,8 @@
 #include "svn_pools.h"
 #include "svn_dirent_uri.h"
 
+#include "private/svn_sorts_private.h"
+
 #include "wc.h"
 #include "wc_db.h"
 #include "wc-queries.h"
@@ -159,55 +161,222 @@ svn_wc__db_textbase_walk(svn_wc__db_t *db,
   return SVN_NO_ERROR;
 }
 
-static svn_error_t *
-textbase_hydrate(svn_wc__db_wcroot_t *wcroot,
-                 svn_wc__db_textbase_fetch_cb_t fetch_callback,
-                 void *fetch_baton,
-                 svn_cancel_func_t cancel_func,
-                 void *cancel_baton,
-                 const svn_checksum_t *checksum,
-                 const char *repos_root_url,
-                 const char *repos_relpath,
-                 svn_revnum_t revision,
-                 apr_pool_t *scratch_pool)
+/* A text-base that svn_wc__db_textbase_sync() has to fetch. */
+typedef struct textbase_hydration_t
 {
-  svn_stream_t *install_stream;
+  const svn_checksum_t *checksum;
+  const char *repos_relpath;
+  svn_revnum_t revision;
+
   svn_wc__db_install_data_t *install_data;
-  svn_checksum_t *install_sha1_checksum;
-  svn_checksum_t *install_md5_checksum;
+  svn_checksum_t *sha1_checksum;
+  svn_checksum_t *md5_checksum;
+} textbase_hydration_t;
+
+/* Fetch the text-bases HYDRATIONS[START .. START+COUNT-1] of the repository
+ * at REPOS_ROOT_URL with a single invocation of FETCH_CALLBACK and install
+ * them into the pristine store of WCROOT.
+ */
+static svn_error_t *
+textbase_hydrate_batch(svn_wc__db_wcroot_t *wcroot,
+                       svn_wc__textbase_fetch_batch_cb_t fetch_callback,
+                       void *fetch_baton,
+                       svn_cancel_func_t cancel_func,
+                       void *cancel_baton,
+                       const char *repos_root_url,
+                       apr_array_header_t *hydrations,
+                       int start,
+                       int count,
+                       apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *fetches;
+  svn_error_t *err = SVN_NO_ERROR;
+  int prepared;
+  int i;
+
+  fetches = apr_array_make(scratch_pool, count,
+                           sizeof(svn_wc__textbase_fetch_t *));
+
+  for (prepared = 0; prepared < count; prepared++)
+    {
+      textbase_hydration_t *h
+        = APR_ARRAY_IDX(hydrations, start + prepared, textbase_hydration_t *);
+      svn_wc__textbase_fetch_t *fetch = apr_pcalloc(scratch_pool,
+                                                    sizeof(*fetch));
+
+      fetch->repos_root_url = repos_root_url;
+      fetch->repos_relpath = h->repos_relpath;
+      fetch->revision = h->revision;
+
+      err = svn_wc__db_pristine_prepare_install_internal(
+              &fetch->contents, &h->install_data,
+              &h->sha1_checksum, &h->md5_checksum,
+              wcroot, TRUE, scratch_pool, scratch_pool);
+      if (err)
+        break;
+
+      APR_ARRAY_PUSH(fetches, svn_wc__textbase_fetch_t *) = fetch;
+    }
+
+  if (!err)
+    err = fetch_callback(fetch_baton, fetches, cancel_func, cancel_baton,
+                         scratch_pool);
+
+  for (i = 0; i < prepared; i++)
+    {
+      textbase_hydration_t *h
+        = APR_ARRAY_IDX(hydrations, start + i, textbase_hydration_t *);
+
+      if (!err && !svn_checksum_match(h->checksum, h->sha1_checksum))
+        err = svn_checksum_mismatch_err(
+                h->checksum, h->sha1_checksum, scratch_pool,
+                _("Checksum mismatch while fetching text base"));
+
+      if (!err)
+        err = svn_wc__db_pristine_install(h->install_data, h->sha1_checksum,
+                                          h->md5_checksum, scratch_pool);
+
+      /* Make sure that no temporary files are left behind. */
+      if (err)
+        err = svn_error_compose_create(
+                err, svn_wc__db_pristine_install_abort(h->install_data,
+                                                       scratch_pool));
+    }
+
+  return svn_error_trace(err);
+}
+
+/* Mark the on disk contents of the text-base CHECKSUM in WCROOT as
+ * recently used. */
+static svn_error_t *
+textbase_touch(svn_wc__db_wcroot_t *wcroot,
+               const svn_checksum_t *checksum,
+               apr_pool_t *scratch_pool)
+{
+  const char *pristine_abspath;
   svn_error_t *err;
 
-  SVN_ERR(svn_wc__db_pristine_prepare_install_internal(
-            &install_stream, &install_data,
-            &install_sha1_checksum, &install_md5_checksum,
-            wcroot, TRUE, scratch_pool, scratch_pool));
-
-  err = fetch_callback(fetch_baton, repos_root_url,
-                       repos_relpath, revision,
-                       install_stream,
-                       cancel_func, cancel_baton,
-                       scratch_pool);
-  if (err)
-    return svn_error_compose_create(err,
-             svn_wc__db_pristine_install_abort(install_data, scratch_pool));
-
-  if (!svn_checksum_match(checksum, install_sha1_checksum))
+  SVN_ERR(svn_wc__db_pristine_get_future_path(&pristine_abspath,
+                                              wcroot->abspath, checksum,
+                                              scratch_pool, scratch_pool));
+
+  err = svn_io_set_file_affected_time(apr_time_now(), pristine_abspath,
+                                      scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      /* Not our problem here. */
+      svn_error_clear(err);
+      err = SVN_NO_ERROR;
+    }
+
+  return svn_error_trace(err);
+}
+
+/* An unreferenced text-base whose contents are on disk. */
+typedef struct cached_textbase_t
+{
+  const svn_checksum_t *checksum;
+  svn_filesize_t size;
+  apr_time_t last_used;
+} cached_textbase_t;
+
+/* Sort cached_textbase_t * by descending last_used. */
+static int
+compare_cached_textbases(const void *a, const void *b)
+{
+  const cached_textbase_t *tb_a = *(const cached_textbase_t *const *)a;
+  const cached_textbase_t *tb_b = *(const cached_textbase_t *const *)b;
+
+  if (tb_a->last_used > tb_b->last_used)
+    return -1;
+  else if (tb_a->last_used < tb_b->last_used)
+    return 1;
+  else
+    return 0;
+}
+
+/* Dehydrate the unreferenced text-bases in WCROOT that do not fit into
+ * CACHE_SIZE bytes, starting with the least recently used ones.
+ */
+static svn_error_t *
+textbase_evict(svn_wc__db_wcroot_t *wcroot,
+               apr_uint64_t cache_size,
+               svn_cancel_func_t cancel_func,
+               void *cancel_baton,
+               apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  apr_array_header_t *cached;
+  apr_uint64_t total_size;
+  apr_pool_t *iterpool;
+  svn_boolean_t have_row;
+  int i;
+
+  cached = apr_array_make(scratch_pool, 0, sizeof(cached_textbase_t *));
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_UNREFERENCED_TEXTBASES));
+  SVN_ERR(svn_sqlite__bind_int64(stmt, 1, wcroot->wc_id));
+
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      cached_textbase_t *tb = apr_pcalloc(scratch_pool, sizeof(*tb));
+      svn_error_t *err;
+
+      err = svn_sqlite__column_checksum(&tb->checksum, stmt, 0, scratch_pool);
+      if (err)
+        return svn_error_compose_create(err, svn_sqlite__reset(stmt));
+
+      tb->size = svn_sqlite__column_int64(stmt, 1);
+      APR_ARRAY_PUSH(cached, cached_textbase_t *) = tb;
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+  SVN_ERR(svn_sqlite__reset(stmt));
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < cached->nelts; i++)
     {
-      err = svn_checksum_mismatch_err(
-              checksum, install_sha1_checksum, scratch_pool,
-              _("Checksum mismatch while fetching text base"));
+      cached_textbase_t *tb = APR_ARRAY_IDX(cached, i, cached_textbase_t *);
+      const char *pristine_abspath;
+      const svn_io_dirent2_t *dirent;
+
+      svn_pool_clear(iterpool);
 
-      return svn_error_compose_create(err,
-               svn_wc__db_pristine_install_abort(install_data, scratch_pool));
+      SVN_ERR(svn_wc__db_pristine_get_future_path(&pristine_abspath,
+                                                  wcroot->abspath,
+                                                  tb->checksum,
+                                                  iterpool, iterpool));
+      SVN_ERR(svn_io_stat_dirent2(&dirent, pristine_abspath, FALSE, TRUE,
+                                  iterpool, iterpool));
+
+      /* Contents that vanished from disk are the least useful of all. */
+      tb->last_used = (dirent->kind == svn_node_file) ? dirent->mtime : 0;
     }
 
-  err = svn_wc__db_pristine_install(install_data,
-                                    install_sha1_checksum,
-                                    install_md5_checksum,
-                                    scratch_pool);
-  if (err)
-    return svn_error_compose_create(err,
-             svn_wc__db_pristine_install_abort(install_data, scratch_pool));
+  svn_sort__array(cached, compare_cached_textbases);
+
+  total_size = 0;
+  for (i = 0; i < cached->nelts; i++)
+    {
+      cached_textbase_t *tb = APR_ARRAY_IDX(cached, i, cached_textbase_t *);
+
+      svn_pool_clear(iterpool);
+
+      if (tb->last_used != 0 && total_size + tb->size <= cache_size)
+        {
+          total_size += tb->size;
+          continue;
+        }
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(svn_wc__db_pristine_dehydrate_internal(wcroot, tb->checksum,
+                                                     iterpool));
+    }
+  svn_pool_destroy(iterpool);
 
   return SVN_NO_ERROR;
 }
@@ -217,7 +386,9 @@ svn_wc__db_textbase_sync(svn_wc__db_t *db,
                          const char *local_abspath,
                          svn_boolean_t allow_hydrate,
                          svn_boolean_t allow_dehydrate,
-                         svn_wc__db_textbase_fetch_cb_t fetch_callback,
+                         int batch_size,
+                         apr_uint64_t cache_size,
+                         svn_wc__textbase_fetch_batch_cb_t fetch_callback,
                          void *fetch_baton,
                          svn_cancel_func_t cancel_func,
                          void *cancel_baton,
@@ -228,8 +399,11 @@ svn_wc__db_textbase_sync(svn_wc__db_t *db,
   svn_sqlite__stmt_t *stmt;
   apr_pool_t *iterpool;
   const char *repos_root_url;
+  apr_array_header_t *hydrations;
+  int i;
 
   SVN_ERR_ASSERT(svn_dirent_is_absolute(local_abspath));
+  SVN_ERR_ASSERT(batch_size > 0);
 
   SVN_ERR(svn_wc__db_wcroot_parse_local_abspath(&wcroot, &local_relpath, db,
                                                 local_abspath, scratch_pool,
@@ -239,6 +413,10 @@ svn_wc__db_textbase_sync(svn_wc__db_t *db,
   SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb, STMT_TEXTBASE_SYNC));
   SVN_ERR(svn_sqlite__bindf(stmt, "is", wcroot->wc_id, local_relpath));
 
+  /* Only collect the text-bases to fetch while the statement is running,
+     so that they can be requested in batches afterwards. */
+  hydrations = apr_array_make(scratch_pool, 0,
+                              sizeof(textbase_hydration_t *));
   repos_root_url = NULL;
   iterpool = svn_pool_create(scratch_pool);
   while (1)
@@ -247,7 +425,7 @@ svn_wc__db_textbase_sync(svn_wc__db_t *db,
       const svn_checksum_t *checksum;
       svn_boolean_t hydrated;
       svn_boolean_t referenced;
-      svn_error_t *err;
+      svn_error_t *err = SVN_NO_ERROR;
 
       svn_pool_clear(iterpool);
 
@@ -262,10 +440,6 @@ svn_wc__db_textbase_sync(svn_wc__db_t *db,
       if (!have_row)
         break;
 
-      err = svn_sqlite__column_checksum(&checksum, stmt, 0, iterpool);
-      if (err)
-        return svn_error_compose_create(err, svn_sqlite__reset(stmt));
-
       hydrated = svn_sqlite__column_boolean(stmt, 1);
       referenced = svn_sqlite__column_boolean(stmt, 2);
 
@@ -273,10 +447,16 @@ svn_wc__db_textbase_sync(svn_wc__db_t *db,
         {
           if (allow_hydrate)
             {
+              textbase_hydration_t *h;
               const char *repos_relpath;
               svn_revnum_t revision;
 
-              repos_relpath = svn_sqlite__column_text(stmt, 3, NULL);
+              err = svn_sqlite__column_checksum(&checksum, stmt, 0,
+                                                scratch_pool);
+              if (err)
+                return svn_error_compose_create(err, svn_sqlite__reset(stmt));
+
+              repos_relpath = svn_sqlite__column_text(stmt, 3, scratch_pool);
               if (!repos_relpath)
                 {
                   return svn_error_createf(
@@ -303,14 +483,6 @@ svn_wc__db_textbase_sync(svn_wc__db_t *db,
                     return svn_error_compose_create(err, svn_sqlite__reset(stmt));
                 }
 
-              if (!repos_relpath)
-                {
-                  return svn_error_createf(
-                           SVN_ERR_WC_CORRUPT, svn_sqlite__reset(stmt),
-                           _("Unexpected entry for '%s'"),
-                           svn_checksum_to_cstring_display(checksum, iterpool));
-                }
-
               revision = svn_sqlite__column_revnum(stmt, 5);
               if (!SVN_IS_VALID_REVNUM(revision))
                 {
@@ -320,31 +492,85 @@ svn_wc__db_textbase_sync(svn_wc__db_t *db,
                            svn_checksum_to_cstring_display(checksum, iterpool));
                 }
 
-              err = textbase_hydrate(wcroot, fetch_callback, fetch_baton,
-                                     cancel_func, cancel_baton, checksum,
-                                     repos_root_url, repos_relpath, revision,
-                                     iterpool);
-              if (err)
-                return svn_error_compose_create(err, svn_sqlite__reset(stmt));
+              h = apr_pcalloc(scratch_pool, sizeof(*h));
+              h->checksum = checksum;
+              h->repos_relpath = repos_relpath;
+              h->revision = revision;
+              APR_ARRAY_PUSH(hydrations, textbase_hydration_t *) = h;
+            }
+        }
+      else if (hydrated && referenced)
+        {
+          if (cache_size > 0)
+            {
+              err = svn_sqlite__column_checksum(&checksum, stmt, 0, iterpool);
+              if (!err)
+                err = textbase_touch(wcroot, checksum, iterpool);
             }
         }
       else if (hydrated && !referenced)
         {
-          if (allow_dehydrate)
+          /* With a cache, textbase_evict() takes care of the text-bases
+             that are still in use by some node. */
+          if (allow_dehydrate
+              && (cache_size == 0 || svn_sqlite__column_is_null(stmt, 3)))
             {
-              err = svn_wc__db_pristine_dehydrate_internal(wcroot, checksum,
-                                                           iterpool);
-              if (err)
-                return svn_error_compose_create(err, svn_sqlite__reset(stmt));
+              err = svn_sqlite__column_checksum(&checksum, stmt, 0, iterpool);
+              if (!err)
+                err = svn_wc__db_pristine_dehydrate_internal(wcroot, checksum,
+                                                             iterpool);
             }
         }
 
       if (err)
         return svn_error_compose_create(err, svn_sqlite__reset(stmt));
     }
-  svn_pool_destroy(iterpool);
 
   SVN_ERR(svn_sqlite__reset(stmt));
 
+  /* Whatever another working copy shares with us needs no fetching. */
+  if (wcroot->shared_pristine_abspath)
+    {
+      apr_array_header_t *remaining;
+
+      remaining = apr_array_make(scratch_pool, hydrations->nelts,
+                                 sizeof(textbase_hydration_t *));
+      for (i = 0; i < hydrations->nelts; i++)
+        {
+          textbase_hydration_t *h
+            = APR_ARRAY_IDX(hydrations, i, textbase_hydration_t *);
+          svn_boolean_t hydrated;
+
+          svn_pool_clear(iterpool);
+
+          SVN_ERR(svn_wc__db_pristine_hydrate_shared_internal(&hydrated,
+                                                              wcroot,
+                                                              h->checksum,
+                                                              iterpool));
+          if (!hydrated)
+            APR_ARRAY_PUSH(remaining, textbase_hydration_t *) = h;
+        }
+      hydrations = remaining;
+    }
+
+  for (i = 0; i < hydrations->nelts; i += batch_size)
+    {
+      svn_pool_clear(iterpool);
+
+      if (cancel_func)
+        SVN_ERR(cancel_func(cancel_baton));
+
+      SVN_ERR(textbase_hydrate_batch(wcroot, fetch_callback, fetch_baton,
+                                     cancel_func, cancel_baton,
+                                     repos_root_url, hydrations, i,
+                                     MIN(batch_size, hydrations->nelts - i),
+                                     iterpool));
+    }
+  svn_pool_destroy(iterpool);
+
+  if (allow_dehydrate && cache_size > 0)
+    SVN_ERR(textbase_evict(wcroot, cache_size, cancel_func, cancel_baton,
+                           scratch_pool));
+
   return SVN_NO_ERROR;
 }
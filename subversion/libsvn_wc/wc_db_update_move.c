@@ -256,6 +256,10 @@ typedef struct update_move_baton_t {
 
   svn_cancel_func_t cancel_func;
   void *cancel_baton;
+
+  /* The move destination relpaths that may need an edit, together with
+     all their ancestors, or NULL to visit every node. */
+  apr_hash_t *changed;
 } update_move_baton_t;
 
 /* Per node flags for tree conflict collection */
@@ -2048,6 +2052,53 @@ props_match(svn_boolean_t *match,
   return SVN_NO_ERROR;
 }
 
+/* Set *CHANGED to the descendants of DST_RELPATH at DST_OP_DEPTH that
+ * may differ from their move source below SRC_RELPATH at SRC_OP_DEPTH,
+ * and to all their ancestors up to DST_RELPATH, as a set of relpaths
+ * allocated in RESULT_POOL.
+ *
+ * This lets the per-node walk skip the (often very large) parts of the
+ * moved tree that are unaffected by the update.
+ */
+static svn_error_t *
+find_moved_layer_differences(apr_hash_t **changed,
+                             svn_wc__db_wcroot_t *wcroot,
+                             const char *src_relpath,
+                             int src_op_depth,
+                             const char *dst_relpath,
+                             int dst_op_depth,
+                             apr_pool_t *result_pool,
+                             apr_pool_t *scratch_pool)
+{
+  svn_sqlite__stmt_t *stmt;
+  svn_boolean_t have_row;
+
+  *changed = apr_hash_make(result_pool);
+
+  SVN_ERR(svn_sqlite__get_statement(&stmt, wcroot->sdb,
+                                    STMT_SELECT_MOVED_LAYER_DIFFERENCES));
+  SVN_ERR(svn_sqlite__bindf(stmt, "isdsd", wcroot->wc_id,
+                            src_relpath, src_op_depth,
+                            dst_relpath, dst_op_depth));
+  SVN_ERR(svn_sqlite__step(&have_row, stmt));
+  while (have_row)
+    {
+      const char *relpath = svn_sqlite__column_text(stmt, 0, result_pool);
+
+      /* Stop at the first ancestor that is already known. */
+      while (strcmp(relpath, dst_relpath) != 0
+             && !svn_hash_gets(*changed, relpath))
+        {
+          svn_hash_sets(*changed, relpath, "");
+          relpath = svn_relpath_dirname(relpath, result_pool);
+        }
+
+      SVN_ERR(svn_sqlite__step(&have_row, stmt));
+    }
+
+  return svn_error_trace(svn_sqlite__reset(stmt));
+}
+
 /* ### Drive TC_EDITOR so as to ...
  */
 static svn_error_t *
@@ -2169,13 +2220,17 @@ update_moved_away_node(node_move_baton_t *nmb,
           cnmb.dst_relpath = svn_relpath_join(dst_relpath, child_name,
                                               iterpool);
 
-          if (!cnmb.shadowed)
-            SVN_ERR(check_node_shadowed(&cnmb.shadowed, wcroot,
-                                        cnmb.dst_relpath, b->dst_op_depth,
-                                        iterpool));
+          /* Subtrees that are identical on both sides need no edits. */
+          if (!b->changed || svn_hash_gets(b->changed, cnmb.dst_relpath))
+            {
+              if (!cnmb.shadowed)
+                SVN_ERR(check_node_shadowed(&cnmb.shadowed, wcroot,
+                                            cnmb.dst_relpath, b->dst_op_depth,
+                                            iterpool));
 
-          SVN_ERR(update_moved_away_node(&cnmb, wcroot, cnmb.src_relpath,
-                                         cnmb.dst_relpath, iterpool));
+              SVN_ERR(update_moved_away_node(&cnmb, wcroot, cnmb.src_relpath,
+                                             cnmb.dst_relpath, iterpool));
+            }
 
           if (!dst_only)
             ++i;
@@ -2347,6 +2402,11 @@ update_moved_away_conflict_victim(svn_revnum_t *old_rev,
   SVN_ERR(svn_sqlite__exec_statements(wcroot->sdb,
                                       STMT_CREATE_UPDATE_MOVE_LIST));
 
+  SVN_ERR(find_moved_layer_differences(&umb.changed, wcroot,
+                                       src_relpath, umb.src_op_depth,
+                                       dst_relpath, umb.dst_op_depth,
+                                       scratch_pool, scratch_pool));
+
   /* Drive the editor... */
 
   nmb.umb = &umb;
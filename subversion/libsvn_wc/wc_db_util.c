@@ -48,6 +48,7 @@
 #include "svn_private_config.h"
 
 WC_QUERIES_SQL_DECLARE_STATEMENTS(statements);
+WC_QUERIES_SQL_DECLARE_STATEMENT_INFO(statement_info);
 
 
 
@@ -115,6 +116,7 @@ svn_wc__db_util_open_db(svn_sqlite__db_t **sdb,
                         const char *sdb_fname,
                         svn_sqlite__mode_t smode,
                         svn_boolean_t exclusive,
+                        svn_boolean_t wal,
                         apr_int32_t timeout,
                         const char *const *my_statements,
                         apr_pool_t *result_pool,
@@ -142,9 +144,18 @@ svn_wc__db_util_open_db(svn_sqlite__db_t **sdb,
                            my_statements ? my_statements : statements,
                            0, NULL, timeout, result_pool, scratch_pool));
 
+  /* Callers passing their own statements use their own numbering. */
+  if (!my_statements)
+    svn_sqlite__set_statement_info(*sdb, statement_info);
+
   if (exclusive)
     SVN_ERR(svn_sqlite__exec_statements(*sdb, STMT_PRAGMA_LOCKING_MODE));
 
+  /* Must come after the locking mode, as switching to exclusive locking
+     after the WAL has been opened does not avoid the shared memory. */
+  if (wal)
+    SVN_ERR(svn_sqlite__exec_statements(*sdb, STMT_PRAGMA_JOURNAL_MODE_WAL));
+
   SVN_ERR(svn_sqlite__create_scalar_function(*sdb, "relpath_depth", 1,
                                              TRUE /* deterministic */,
                                              relpath_depth_sqlite, NULL));
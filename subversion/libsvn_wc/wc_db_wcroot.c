@@ -240,7 +240,10 @@ svn_wc__db_open(svn_wc__db_t **db,
     {
       svn_error_t *err;
       svn_boolean_t sqlite_exclusive = FALSE;
+      svn_boolean_t sqlite_wal = FALSE;
       apr_int64_t timeout;
+      apr_int64_t size;
+      const char *shared_pristine;
 
       err = svn_config_get_bool(config, &sqlite_exclusive,
                                 SVN_CONFIG_SECTION_WORKING_COPY,
@@ -253,6 +256,17 @@ svn_wc__db_open(svn_wc__db_t **db,
       else
         (*db)->exclusive = sqlite_exclusive;
 
+      err = svn_config_get_bool(config, &sqlite_wal,
+                                SVN_CONFIG_SECTION_WORKING_COPY,
+                                SVN_CONFIG_OPTION_SQLITE_WAL,
+                                FALSE);
+      if (err)
+        {
+          svn_error_clear(err);
+        }
+      else
+        (*db)->wal = sqlite_wal;
+
       err = svn_config_get_int64(config, &timeout,
                                  SVN_CONFIG_SECTION_WORKING_COPY,
                                  SVN_CONFIG_OPTION_SQLITE_BUSY_TIMEOUT,
@@ -261,6 +275,40 @@ svn_wc__db_open(svn_wc__db_t **db,
         svn_error_clear(err);
       else
         (*db)->timeout = (apr_int32_t)timeout;
+
+      err = svn_config_get_int64(config, &size,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_SQLITE_CACHE_SIZE,
+                                 0);
+      if (err || size < 0 || size > APR_INT32_MAX)
+        svn_error_clear(err);
+      else
+        (*db)->cache_size = size * 0x100000;
+
+      err = svn_config_get_int64(config, &size,
+                                 SVN_CONFIG_SECTION_WORKING_COPY,
+                                 SVN_CONFIG_OPTION_SQLITE_MMAP_SIZE,
+                                 0);
+      if (err || size < 0 || size > APR_INT32_MAX)
+        svn_error_clear(err);
+      else
+        (*db)->mmap_size = size * 0x100000;
+
+      svn_config_get(config, &shared_pristine,
+                     SVN_CONFIG_SECTION_WORKING_COPY,
+                     SVN_CONFIG_OPTION_SHARED_PRISTINE_STORE, NULL);
+      if (shared_pristine && *shared_pristine)
+        {
+          err = svn_dirent_get_absolute(
+                  &(*db)->shared_pristine_abspath,
+                  svn_dirent_internal_style(shared_pristine, scratch_pool),
+                  result_pool);
+          if (err)
+            {
+              svn_error_clear(err);
+              (*db)->shared_pristine_abspath = NULL;
+            }
+        }
     }
 
   return SVN_NO_ERROR;
@@ -302,6 +350,7 @@ svn_wc__db_pdh_create_wcroot(svn_wc__db_wcroot_t **wcroot,
                              int format,
                              svn_boolean_t verify_format,
                              svn_boolean_t store_pristine,
+                             const char *shared_pristine_abspath,
                              apr_pool_t *result_pool,
                              apr_pool_t *scratch_pool)
 {
@@ -390,6 +439,10 @@ svn_wc__db_pdh_create_wcroot(svn_wc__db_wcroot_t **wcroot,
                                           sizeof(svn_wc__db_wclock_t));
   (*wcroot)->access_cache = apr_hash_make(result_pool);
   (*wcroot)->store_pristine = store_pristine;
+  (*wcroot)->shared_pristine_abspath = shared_pristine_abspath;
+  (*wcroot)->node_cache = NULL;
+  (*wcroot)->have_fingerprints = svn_tristate_unknown;
+  (*wcroot)->have_detranslated_checksums = svn_tristate_unknown;
 
   /* SDB will be NULL for pre-NG working copies. We only need to run a
      cleanup when the SDB is present.  */
@@ -683,10 +736,14 @@ svn_wc__db_wcroot_parse_local_abspath(svn_wc__db_wcroot_t **wcroot,
              as the filesystem allows. */
           err = svn_wc__db_util_open_db(&sdb, local_abspath, SDB_FILE,
                                         svn_sqlite__mode_readwrite,
-                                        db->exclusive, db->timeout, NULL,
+                                        db->exclusive, db->wal,
+                                        db->timeout, NULL,
                                         db->state_pool, scratch_pool);
           if (err == NULL)
             {
+              SVN_ERR(svn_sqlite__set_memory_limits(sdb, db->cache_size,
+                                                    db->mmap_size,
+                                                    scratch_pool));
 #ifdef SVN_DEBUG
               /* Install self-verification trigger statements. */
               err = svn_sqlite__exec_statements(sdb,
@@ -819,6 +876,7 @@ try_symlink_as_dir:
                             sdb, wc_id, format,
                             db->verify_format,
                             store_pristine,
+                            db->shared_pristine_abspath,
                             db->state_pool, scratch_pool);
       if (err && (err->apr_err == SVN_ERR_WC_UNSUPPORTED_FORMAT ||
                   err->apr_err == SVN_ERR_WC_UPGRADE_REQUIRED) &&
@@ -895,6 +953,7 @@ try_symlink_as_dir:
                             NULL, UNKNOWN_WC_ID, wc_format,
                             db->verify_format,
                             TRUE,
+                            NULL,
                             db->state_pool, scratch_pool));
     }
 
@@ -37,6 +37,7 @@ struct svn_wc__working_file_writer_t
   svn_boolean_t is_special;
   svn_stream_t *install_stream;
   svn_stream_t *write_stream;
+  svn_checksum_t *fingerprint;
 };
 
 static apr_status_t
@@ -83,7 +84,17 @@ svn_wc__working_file_writer_open(svn_wc__working_file_writer_t **writer_p,
   if (final_mtime >= 0)
     svn_stream__install_set_affected_time(install_stream, final_mtime);
 
-  write_stream = install_stream;
+  writer = apr_pcalloc(result_pool, sizeof(*writer));
+
+  /* Fingerprint the contents as they end up on disk, to allow cheaply
+     verifying later on that the working file is still unmodified. */
+  if (is_special)
+    write_stream = install_stream;
+  else
+    write_stream = svn_stream_checksummed2(install_stream, NULL,
+                                           &writer->fingerprint,
+                                           svn_checksum_fnv1a_32x4, FALSE,
+                                           result_pool);
 
   if (svn_subst_translation_required(eol_style, eol, keywords,
                                      FALSE /* special */,
@@ -97,7 +108,6 @@ svn_wc__working_file_writer_open(svn_wc__working_file_writer_t **writer_p,
                                                  result_pool);
     }
 
-  writer = apr_pcalloc(result_pool, sizeof(*writer));
   writer->pool = result_pool;
   writer->tmp_abspath = apr_pstrdup(result_pool, tmp_abspath);
   writer->is_special = is_special;
@@ -117,6 +127,13 @@ svn_wc__working_file_writer_get_stream(svn_wc__working_file_writer_t *writer)
   return writer->write_stream;
 }
 
+const svn_checksum_t *
+svn_wc__working_file_writer_get_fingerprint(
+  svn_wc__working_file_writer_t *writer)
+{
+  return writer->fingerprint;
+}
+
 svn_error_t *
 svn_wc__working_file_writer_finalize(apr_time_t *mtime_p,
                                      apr_off_t *size_p,
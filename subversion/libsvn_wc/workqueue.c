@@ -41,7 +41,10 @@
 
 #include "private/svn_io_private.h"
 #include "private/svn_wc_private.h"
+#include "private/svn_profile.h"
+#include "private/svn_probes.h"
 #include "private/svn_skel.h"
+#include "private/svn_task.h"
 
 
 /* Workqueue operation names.  */
@@ -90,7 +93,8 @@ static void
 wq_record_fileinfo(work_item_baton_t *wqb,
                    const char *local_abspath,
                    apr_time_t mtime,
-                   svn_filesize_t size)
+                   svn_filesize_t size,
+                   const svn_checksum_t *fingerprint)
 {
   svn_wc__db_fileinfo_t *info;
 
@@ -102,6 +106,7 @@ wq_record_fileinfo(work_item_baton_t *wqb,
   info = apr_pcalloc(wqb->result_pool, sizeof(*info));
   info->mtime = mtime;
   info->size = size;
+  info->fingerprint = svn_checksum_dup(fingerprint, wqb->result_pool);
 
   svn_hash_sets(wqb->record_map, apr_pstrdup(wqb->result_pool, local_abspath),
                 info);
@@ -468,60 +473,65 @@ svn_wc__wq_build_postupgrade(svn_skel_t **work_item,
 
 /* OP_FILE_INSTALL */
 
-/* Process the OP_FILE_INSTALL work item WORK_ITEM.
- * See svn_wc__wq_build_file_install() which generates this work item.
- * Implements (struct work_item_dispatch).func. */
+/* Everything needed to install a working file, as collected from wc.db
+   by prepare_file_install(). */
+typedef struct file_install_t
+{
+  const char *local_abspath;
+  const char *source_abspath;
+  const char *temp_dir_abspath;
+  apr_time_t final_mtime;
+  svn_subst_eol_style_t eol_style;
+  const char *eol;
+  apr_hash_t *keywords;
+  svn_boolean_t is_special;
+  svn_boolean_t is_executable;
+  svn_boolean_t is_readonly;
+  svn_boolean_t record_fileinfo;
+} file_install_t;
+
+/* Read what it takes to run the OP_FILE_INSTALL work item WORK_ITEM from
+ * DB and return it in *INSTALL_P, allocated in RESULT_POOL.
+ * Use SCRATCH_POOL for temporary allocations. */
 static svn_error_t *
-run_file_install(work_item_baton_t *wqb,
-                 svn_wc__db_t *db,
-                 const svn_skel_t *work_item,
-                 const char *wri_abspath,
-                 svn_cancel_func_t cancel_func,
-                 void *cancel_baton,
-                 apr_pool_t *scratch_pool)
+prepare_file_install(file_install_t **install_p,
+                     svn_wc__db_t *db,
+                     const svn_skel_t *work_item,
+                     const char *wri_abspath,
+                     apr_pool_t *result_pool,
+                     apr_pool_t *scratch_pool)
 {
   const svn_skel_t *arg1 = work_item->children->next;
   const svn_skel_t *arg4 = arg1->next->next->next;
+  file_install_t *install = apr_pcalloc(result_pool, sizeof(*install));
   const char *local_relpath;
   const char *local_abspath;
   svn_boolean_t use_commit_times;
-  svn_boolean_t record_fileinfo;
-  svn_stream_t *src_stream;
-  const char *temp_dir_abspath;
   apr_int64_t val;
   const char *wcroot_abspath;
   const char *source_abspath;
   const svn_checksum_t *checksum;
   apr_hash_t *props;
-  svn_boolean_t is_special;
-  svn_boolean_t is_executable;
   svn_boolean_t needs_lock;
   const char *eol_propval;
-  svn_subst_eol_style_t eol_style;
-  const char *eol;
   const char *keywords_propval;
-  apr_hash_t *keywords;
   apr_time_t changed_date;
   svn_revnum_t changed_rev;
   const char *changed_author;
-  apr_time_t final_mtime;
   svn_wc__db_status_t status;
   svn_wc__db_lock_t *lock;
   const char *repos_relpath;
   const char *repos_root_url;
-  svn_wc__working_file_writer_t *file_writer;
-  apr_time_t record_mtime;
-  apr_off_t record_size;
-  svn_boolean_t is_readonly;
 
   local_relpath = apr_pstrmemdup(scratch_pool, arg1->data, arg1->len);
   SVN_ERR(svn_wc__db_from_relpath(&local_abspath, db, wri_abspath,
-                                  local_relpath, scratch_pool, scratch_pool));
+                                  local_relpath, result_pool, scratch_pool));
+  install->local_abspath = local_abspath;
 
   SVN_ERR(svn_skel__parse_int(&val, arg1->next, scratch_pool));
   use_commit_times = (val != 0);
   SVN_ERR(svn_skel__parse_int(&val, arg1->next->next, scratch_pool));
-  record_fileinfo = (val != 0);
+  install->record_fileinfo = (val != 0);
 
   SVN_ERR(svn_wc__db_read_node_install_info(&wcroot_abspath,
                                             &checksum, &props,
@@ -535,7 +545,7 @@ run_file_install(work_item_baton_t *wqb,
       local_relpath = apr_pstrmemdup(scratch_pool, arg4->data, arg4->len);
       SVN_ERR(svn_wc__db_from_relpath(&source_abspath, db, wri_abspath,
                                       local_relpath,
-                                      scratch_pool, scratch_pool));
+                                      result_pool, scratch_pool));
     }
   else if (! checksum)
     {
@@ -558,20 +568,23 @@ run_file_install(work_item_baton_t *wqb,
       SVN_ERR(svn_wc__db_pristine_get_future_path(&source_abspath,
                                                   wcroot_abspath,
                                                   checksum,
-                                                  scratch_pool, scratch_pool));
+                                                  result_pool, scratch_pool));
     }
+  install->source_abspath = source_abspath;
 
   /* Where is the Right Place to put a temp file in this working copy?  */
-  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&temp_dir_abspath,
+  SVN_ERR(svn_wc__db_temp_wcroot_tempdir(&install->temp_dir_abspath,
                                          db, wcroot_abspath,
-                                         scratch_pool, scratch_pool));
+                                         result_pool, scratch_pool));
 
-  is_special = svn_prop_get_value(props, SVN_PROP_SPECIAL) != NULL;
-  is_executable = svn_prop_get_value(props, SVN_PROP_EXECUTABLE) != NULL;
+  install->is_special = svn_prop_get_value(props, SVN_PROP_SPECIAL) != NULL;
+  install->is_executable
+    = svn_prop_get_value(props, SVN_PROP_EXECUTABLE) != NULL;
   needs_lock = svn_prop_get_value(props, SVN_PROP_NEEDS_LOCK) != NULL;
 
   eol_propval = svn_prop_get_value(props, SVN_PROP_EOL_STYLE);
-  svn_subst_eol_style_from_value(&eol_style, &eol, eol_propval);
+  svn_subst_eol_style_from_value(&install->eol_style, &install->eol,
+                                 eol_propval);
 
   keywords_propval = svn_prop_get_value(props, SVN_PROP_KEYWORDS);
 
@@ -599,41 +612,66 @@ run_file_install(work_item_baton_t *wqb,
       url = svn_path_url_add_component2(repos_root_url, repos_relpath,
                                         scratch_pool);
 
-      SVN_ERR(svn_subst_build_keywords3(&keywords, keywords_propval,
+      SVN_ERR(svn_subst_build_keywords3(&install->keywords, keywords_propval,
                                         apr_psprintf(scratch_pool, "%ld",
                                                      changed_rev),
                                         url, repos_root_url, changed_date,
-                                        changed_author, scratch_pool));
+                                        changed_author, result_pool));
     }
   else
     {
-      keywords = NULL;
+      install->keywords = NULL;
     }
 
   if (use_commit_times && changed_date)
-    final_mtime = changed_date;
+    install->final_mtime = changed_date;
   else
-    final_mtime = -1;
+    install->final_mtime = -1;
 
   if (needs_lock && !lock && status != svn_wc__db_status_added)
-    is_readonly = TRUE;
+    install->is_readonly = TRUE;
   else
-    is_readonly = FALSE;
+    install->is_readonly = FALSE;
+
+  *install_p = install;
+  return SVN_NO_ERROR;
+}
+
+/* Translate the source of INSTALL into its working file.  If INSTALL
+ * wants the file info to be recorded, return the size and timestamp of
+ * the new working file in *RECORD_SIZE and *RECORD_MTIME and its
+ * fingerprint, if any, in *RECORD_FINGERPRINT, allocated in RESULT_POOL.
+ * Otherwise, set them to -1 and NULL.
+ *
+ * This does not access wc.db and may be called in any thread.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+install_file(apr_time_t *record_mtime,
+             apr_off_t *record_size,
+             const svn_checksum_t **record_fingerprint,
+             const file_install_t *install,
+             svn_cancel_func_t cancel_func,
+             void *cancel_baton,
+             apr_pool_t *result_pool,
+             apr_pool_t *scratch_pool)
+{
+  svn_stream_t *src_stream;
+  svn_wc__working_file_writer_t *file_writer;
 
   SVN_ERR(svn_wc__working_file_writer_open(&file_writer,
-                                           temp_dir_abspath,
-                                           final_mtime,
-                                           eol_style,
-                                           eol,
+                                           install->temp_dir_abspath,
+                                           install->final_mtime,
+                                           install->eol_style,
+                                           install->eol,
                                            TRUE /* repair_eol */,
-                                           keywords,
-                                           is_special,
-                                           is_executable,
-                                           is_readonly,
+                                           install->keywords,
+                                           install->is_special,
+                                           install->is_executable,
+                                           install->is_readonly,
                                            scratch_pool,
                                            scratch_pool));
 
-  SVN_ERR(svn_stream_open_readonly(&src_stream, source_abspath,
+  SVN_ERR(svn_stream_open_readonly(&src_stream, install->source_abspath,
                                    scratch_pool, scratch_pool));
 
   SVN_ERR(svn_stream_copy3(src_stream,
@@ -641,25 +679,57 @@ run_file_install(work_item_baton_t *wqb,
                            cancel_func, cancel_baton,
                            scratch_pool));
 
-  if (record_fileinfo)
+  if (install->record_fileinfo)
     {
-      SVN_ERR(svn_wc__working_file_writer_finalize(&record_mtime, &record_size,
+      SVN_ERR(svn_wc__working_file_writer_finalize(record_mtime, record_size,
                                                    file_writer, scratch_pool));
+      *record_fingerprint = svn_checksum_dup(
+                    svn_wc__working_file_writer_get_fingerprint(file_writer),
+                    result_pool);
     }
   else
     {
       SVN_ERR(svn_wc__working_file_writer_finalize(NULL, NULL, file_writer,
                                                    scratch_pool));
-      record_mtime = -1;
-      record_size = -1;
+      *record_mtime = -1;
+      *record_size = -1;
+      *record_fingerprint = NULL;
     }
 
-  SVN_ERR(svn_wc__working_file_writer_install(file_writer, local_abspath,
+  SVN_ERR(svn_wc__working_file_writer_install(file_writer,
+                                              install->local_abspath,
                                               scratch_pool));
 
-  if (record_fileinfo)
+  return SVN_NO_ERROR;
+}
+
+/* Process the OP_FILE_INSTALL work item WORK_ITEM.
+ * See svn_wc__wq_build_file_install() which generates this work item.
+ * Implements (struct work_item_dispatch).func. */
+static svn_error_t *
+run_file_install(work_item_baton_t *wqb,
+                 svn_wc__db_t *db,
+                 const svn_skel_t *work_item,
+                 const char *wri_abspath,
+                 svn_cancel_func_t cancel_func,
+                 void *cancel_baton,
+                 apr_pool_t *scratch_pool)
+{
+  file_install_t *install;
+  apr_time_t record_mtime;
+  apr_off_t record_size;
+  const svn_checksum_t *record_fingerprint;
+
+  SVN_ERR(prepare_file_install(&install, db, work_item, wri_abspath,
+                               scratch_pool, scratch_pool));
+  SVN_ERR(install_file(&record_mtime, &record_size, &record_fingerprint,
+                       install, cancel_func, cancel_baton,
+                       scratch_pool, scratch_pool));
+
+  if (install->record_fileinfo)
     {
-      wq_record_fileinfo(wqb, local_abspath, record_mtime, record_size);
+      wq_record_fileinfo(wqb, install->local_abspath, record_mtime,
+                         record_size, record_fingerprint);
     }
 
   return SVN_NO_ERROR;
@@ -1255,7 +1325,8 @@ run_record_fileinfo(work_item_baton_t *wqb,
 
   if (dirent->kind == svn_node_file)
     {
-      wq_record_fileinfo(wqb, local_abspath, dirent->mtime, dirent->filesize);
+      wq_record_fileinfo(wqb, local_abspath, dirent->mtime, dirent->filesize,
+                         NULL);
     }
 
   return SVN_NO_ERROR;
@@ -1466,13 +1537,17 @@ dispatch_work_item(work_item_baton_t *wqb,
     {
       if (svn_skel__matches_atom(work_item->children, scan->name))
         {
+          apr_time_t start = svn_profile__start();
 
 #ifdef SVN_DEBUG_WORK_QUEUE
           SVN_DBG(("dispatch: operation='%s'\n", scan->name));
 #endif
+          SVN_PROBE1(wc__workqueue__item__start, scan->name);
           SVN_ERR((*scan->func)(wqb, db, work_item, wri_abspath,
                                 cancel_func, cancel_baton,
                                 scratch_pool));
+          SVN_PROBE1(wc__workqueue__item__done, scan->name);
+          svn_profile__record("workqueue", scan->name, start, 0);
 
 #ifdef SVN_RUN_WORK_QUEUE_TWICE
 #ifdef SVN_DEBUG_WORK_QUEUE
@@ -1506,6 +1581,321 @@ dispatch_work_item(work_item_baton_t *wqb,
 }
 
 
+/* Maximum number of work items that svn_wc__wq_run() fetches, and marks
+   as completed, per wc.db transaction. */
+#define WQ_BATCH_SIZE 64
+
+/* Return TRUE if running WORK_ITEM may remove the input of earlier work
+   items, such that those must not be run again after it. */
+static svn_boolean_t
+is_destructive_work_item(const svn_skel_t *work_item)
+{
+  return (svn_skel__matches_atom(work_item->children, OP_FILE_REMOVE)
+          || svn_skel__matches_atom(work_item->children, OP_FILE_MOVE)
+          || svn_skel__matches_atom(work_item->children, OP_DIRECTORY_REMOVE));
+}
+
+/* Mark the work items listed in COMPLETED as completed and record the
+   file info collected in WIB, then reset both.  If IDS and WORK_ITEMS
+   are not NULL, fetch up to WQ_BATCH_SIZE of the next work items into
+   them, allocated in RESULT_POOL.  All of this happens in a single
+   wc.db transaction. */
+static svn_error_t *
+complete_work_items(apr_array_header_t **ids,
+                    apr_array_header_t **work_items,
+                    work_item_baton_t *wib,
+                    apr_array_header_t *completed,
+                    svn_wc__db_t *db,
+                    const char *wri_abspath,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *unused_ids, *unused_work_items;
+
+  SVN_ERR(svn_wc__db_wq_record_and_fetch_batch(
+            ids ? ids : &unused_ids,
+            work_items ? work_items : &unused_work_items,
+            db, wri_abspath, completed,
+            wib->used ? wib->record_map : NULL,
+            ids ? WQ_BATCH_SIZE : 0,
+            result_pool, scratch_pool));
+
+  apr_array_clear(completed);
+  svn_pool_clear(wib->result_pool);
+  wib->record_map = NULL;
+  wib->used = FALSE;
+
+  return SVN_NO_ERROR;
+}
+
+/* Wrap ERR, returned by running WORK_ITEM with ID from the work queue of
+   WRI_ABSPATH, such that the user can tell which item failed. */
+static svn_error_t *
+wrap_work_item_error(svn_error_t *err,
+                     const char *wri_abspath,
+                     apr_uint64_t id,
+                     const svn_skel_t *work_item,
+                     apr_pool_t *scratch_pool)
+{
+  const char *skel = svn_skel__unparse(work_item, scratch_pool)->data;
+
+  return svn_error_createf(SVN_ERR_WC_BAD_ADM_LOG, err,
+                           _("Failed to run the WC DB work queue "
+                             "associated with '%s', work item %d %s"),
+                           svn_dirent_local_style(wri_abspath,
+                                                  scratch_pool),
+                           (int)id, skel);
+}
+
+/* Maximum number of threads that install working files in parallel. */
+#define WQ_INSTALL_THREAD_COUNT 4
+
+/* A run of OP_FILE_INSTALL work items to execute in parallel. */
+typedef struct install_batch_t
+{
+  /* Collects the file info recorded by the installs. */
+  work_item_baton_t *wib;
+
+  /* The ids of the finished installs get appended to this,
+     in queue order. */
+  apr_array_header_t *completed;
+
+  /* The work queue we are processing. */
+  const char *wri_abspath;
+
+  /* The install_job_t (not pointers!) to execute, in queue order. */
+  apr_array_header_t *jobs;
+} install_batch_t;
+
+/* A single OP_FILE_INSTALL work item within an install_batch_t. */
+typedef struct install_job_t
+{
+  apr_uint64_t id;
+  const svn_skel_t *work_item;
+  const file_install_t *install;
+  const char *wri_abspath;
+} install_job_t;
+
+/* The result of an install_job_t. */
+typedef struct install_result_t
+{
+  apr_uint64_t id;
+  const file_install_t *install;
+  apr_time_t record_mtime;
+  apr_off_t record_size;
+  const svn_checksum_t *record_fingerprint;
+} install_result_t;
+
+/* Implements svn_task__process_func_t.  PROCESS_BATON is the
+   install_job_t to execute.  Runs in a worker thread. */
+static svn_error_t *
+install_job_process(void **result,
+                    svn_task__t *task,
+                    void *thread_context,
+                    void *process_baton,
+                    svn_cancel_func_t cancel_func,
+                    void *cancel_baton,
+                    apr_pool_t *result_pool,
+                    apr_pool_t *scratch_pool)
+{
+  const install_job_t *job = process_baton;
+  install_result_t *install_result = apr_pcalloc(result_pool,
+                                                 sizeof(*install_result));
+  svn_error_t *err;
+
+  err = install_file(&install_result->record_mtime,
+                     &install_result->record_size,
+                     &install_result->record_fingerprint,
+                     job->install, cancel_func, cancel_baton,
+                     result_pool, scratch_pool);
+  if (err)
+    return svn_error_trace(wrap_work_item_error(err, job->wri_abspath,
+                                                job->id, job->work_item,
+                                                scratch_pool));
+
+  install_result->id = job->id;
+  install_result->install = job->install;
+  *result = install_result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__output_func_t.  OUTPUT_BATON is the
+   install_batch_t.  Runs in the thread that runs the work queue, in
+   queue order, such that no item gets marked as completed before all
+   items queued before it. */
+static svn_error_t *
+install_job_output(svn_task__t *task,
+                   void *result,
+                   void *output_baton,
+                   svn_cancel_func_t cancel_func,
+                   void *cancel_baton,
+                   apr_pool_t *result_pool,
+                   apr_pool_t *scratch_pool)
+{
+  install_batch_t *batch = output_baton;
+  const install_result_t *install_result = result;
+
+  if (install_result->install->record_fileinfo)
+    wq_record_fileinfo(batch->wib, install_result->install->local_abspath,
+                       install_result->record_mtime,
+                       install_result->record_size,
+                       install_result->record_fingerprint);
+
+  APR_ARRAY_PUSH(batch->completed, apr_uint64_t) = install_result->id;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_task__process_func_t.  PROCESS_BATON is the
+   install_batch_t; add a sub-task for each of its jobs. */
+static svn_error_t *
+install_batch_process(void **result,
+                      svn_task__t *task,
+                      void *thread_context,
+                      void *process_baton,
+                      svn_cancel_func_t cancel_func,
+                      void *cancel_baton,
+                      apr_pool_t *result_pool,
+                      apr_pool_t *scratch_pool)
+{
+  install_batch_t *batch = process_baton;
+  int i;
+
+  for (i = 0; i < batch->jobs->nelts; i++)
+    {
+      apr_pool_t *process_pool = svn_task__create_process_pool(task);
+      install_job_t *job
+        = apr_pmemdup(process_pool,
+                      &APR_ARRAY_IDX(batch->jobs, i, install_job_t),
+                      sizeof(*job));
+
+      SVN_ERR(svn_task__add(task, process_pool, NULL,
+                            install_job_process, job,
+                            install_job_output, batch));
+    }
+
+  *result = NULL;
+  return SVN_NO_ERROR;
+}
+
+/* Return TRUE if WORK_ITEM is an OP_FILE_INSTALL that only reads from the
+   pristine store, such that it is independent of all other such items
+   with a different target.  If so, set *LOCAL_RELPATH to its target,
+   allocated in RESULT_POOL. */
+static svn_boolean_t
+is_independent_install(const char **local_relpath,
+                       const svn_skel_t *work_item,
+                       apr_pool_t *result_pool)
+{
+  const svn_skel_t *arg1;
+
+  if (!svn_skel__matches_atom(work_item->children, OP_FILE_INSTALL))
+    return FALSE;
+
+  /* An explicit source path might be written by an earlier item. */
+  arg1 = work_item->children->next;
+  if (arg1->next->next->next != NULL)
+    return FALSE;
+
+  *local_relpath = apr_pstrmemdup(result_pool, arg1->data, arg1->len);
+  return TRUE;
+}
+
+/* If the items starting at index START of WORK_ITEMS (with their ids in
+   IDS) begin with a run of OP_FILE_INSTALL items for distinct targets,
+   install those files in parallel and append the ids of the installed
+   items to COMPLETED, recording their file info in WIB.  Set *COUNT to
+   the number of items processed this way, which may be 0.
+
+   The installs get processed in worker threads, but their database work
+   stays in this thread.  Should one of them fail, all items before it
+   will have been appended to COMPLETED.
+
+   Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+run_independent_installs(int *count,
+                         work_item_baton_t *wib,
+                         apr_array_header_t *completed,
+                         svn_wc__db_t *db,
+                         const char *wri_abspath,
+                         const apr_array_header_t *ids,
+                         const apr_array_header_t *work_items,
+                         int start,
+                         svn_cancel_func_t cancel_func,
+                         void *cancel_baton,
+                         apr_pool_t *scratch_pool)
+{
+  apr_hash_t *targets = apr_hash_make(scratch_pool);
+  install_batch_t *batch;
+  int end;
+  int i;
+
+  *count = 0;
+
+  /* Writing the same target twice would depend on the order. */
+  for (end = start; end < work_items->nelts; end++)
+    {
+      const char *local_relpath;
+
+      if (!is_independent_install(&local_relpath,
+                                  APR_ARRAY_IDX(work_items, end,
+                                                const svn_skel_t *),
+                                  scratch_pool)
+          || svn_hash_gets(targets, local_relpath))
+        break;
+
+      svn_hash_sets(targets, local_relpath, local_relpath);
+    }
+
+  /* Not worth the thread synchronization */
+  if (end - start < 2)
+    return SVN_NO_ERROR;
+
+  batch = apr_pcalloc(scratch_pool, sizeof(*batch));
+  batch->wib = wib;
+  batch->completed = completed;
+  batch->wri_abspath = wri_abspath;
+  batch->jobs = apr_array_make(scratch_pool, end - start,
+                               sizeof(install_job_t));
+
+  /* The workers must not access DB, so read everything they need now. */
+  for (i = start; i < end; i++)
+    {
+      install_job_t *job = apr_array_push(batch->jobs);
+      file_install_t *install;
+      svn_error_t *err;
+
+      job->id = APR_ARRAY_IDX(ids, i, apr_uint64_t);
+      job->work_item = APR_ARRAY_IDX(work_items, i, const svn_skel_t *);
+      job->wri_abspath = wri_abspath;
+
+      err = prepare_file_install(&install, db, job->work_item, wri_abspath,
+                                 scratch_pool, scratch_pool);
+      if (err)
+        {
+          /* Leave reporting the error to dispatch_work_item(). */
+          svn_error_clear(err);
+          apr_array_pop(batch->jobs);
+          break;
+        }
+
+      job->install = install;
+    }
+
+  if (batch->jobs->nelts == 0)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_task__run(WQ_INSTALL_THREAD_COUNT,
+                        install_batch_process, batch,
+                        NULL, NULL, NULL, NULL,
+                        cancel_func, cancel_baton,
+                        scratch_pool, scratch_pool));
+
+  *count = batch->jobs->nelts;
+  return SVN_NO_ERROR;
+}
+
 svn_error_t *
 svn_wc__wq_run(svn_wc__db_t *db,
                const char *wri_abspath,
@@ -1514,7 +1904,12 @@ svn_wc__wq_run(svn_wc__db_t *db,
                apr_pool_t *scratch_pool)
 {
   apr_pool_t *iterpool = svn_pool_create(scratch_pool);
-  apr_uint64_t last_id = 0;
+  apr_pool_t *batch_pool = svn_pool_create(scratch_pool);
+  apr_array_header_t *ids = NULL;
+  apr_array_header_t *work_items = NULL;
+  apr_array_header_t *completed = apr_array_make(scratch_pool, WQ_BATCH_SIZE,
+                                                 sizeof(apr_uint64_t));
+  int i = 0;
   work_item_baton_t wib = { 0 };
   wib.result_pool = svn_pool_create(scratch_pool);
 
@@ -1540,60 +1935,96 @@ svn_wc__wq_run(svn_wc__db_t *db,
 
       svn_pool_clear(iterpool);
 
-      if (! wib.used)
+      if (work_items == NULL || i == work_items->nelts)
         {
-          /* Make sure to do this *early* in the loop iteration. There may
-             be a LAST_ID that needs to be marked as completed, *before* we
-             start worrying about anything else.  */
-          SVN_ERR(svn_wc__db_wq_fetch_next(&id, &work_item, db, wri_abspath,
-                                           last_id, iterpool, iterpool));
+          /* Mark the items of the previous batch as completed and fetch
+             the next batch, all in a single transaction.  Compared to a
+             transaction per item, this saves a lot of journal I/O. */
+          svn_pool_clear(batch_pool);
+          SVN_ERR(complete_work_items(&ids, &work_items, &wib, completed,
+                                      db, wri_abspath,
+                                      batch_pool, iterpool));
+          i = 0;
         }
-      else
+      else if (completed->nelts > 0
+               && is_destructive_work_item(APR_ARRAY_IDX(work_items, i,
+                                                         svn_skel_t *)))
         {
-          /* Make sure to do this *early* in the loop iteration. There may
-             be a LAST_ID that needs to be marked as completed, *before* we
-             start worrying about anything else.  */
-          SVN_ERR(svn_wc__db_wq_record_and_fetch_next(&id, &work_item,
-                                                      db, wri_abspath,
-                                                      last_id, wib.record_map,
-                                                      iterpool,
-                                                      wib.result_pool));
-
-          svn_pool_clear(wib.result_pool);
-          wib.record_map = NULL;
-          wib.used = FALSE;
+          /* Should we get interrupted, everything after the last completed
+             item will be run again.  Make sure that this does not include
+             items whose input the next one might remove. */
+          SVN_ERR(complete_work_items(NULL, NULL, &wib, completed,
+                                      db, wri_abspath,
+                                      batch_pool, iterpool));
         }
 
       /* Stop work queue processing, if requested. A future 'svn cleanup'
          should be able to continue the processing. Note that we may
          have WORK_ITEM, but we'll just skip its processing for now.  */
       if (cancel_func)
-        SVN_ERR(cancel_func(cancel_baton));
+        {
+          err = cancel_func(cancel_baton);
+          if (err)
+            return svn_error_compose_create(
+                     err,
+                     complete_work_items(NULL, NULL, &wib, completed,
+                                         db, wri_abspath,
+                                         batch_pool, iterpool));
+        }
 
       /* If we have a WORK_ITEM, then process the sucker. Otherwise,
          we're done.  */
-      if (work_item == NULL)
+      if (i == work_items->nelts)
         break;
 
+      /* After a checkout or update, most of the queue consists of file
+         installs that don't depend on each other.  Run those in parallel. */
+      {
+        int count;
+
+        err = run_independent_installs(&count, &wib, completed,
+                                       db, wri_abspath, ids, work_items, i,
+                                       cancel_func, cancel_baton, iterpool);
+        if (err)
+          /* Don't run the items before the failed one again. */
+          return svn_error_compose_create(
+                   err,
+                   complete_work_items(NULL, NULL, &wib, completed,
+                                       db, wri_abspath,
+                                       batch_pool, iterpool));
+
+        if (count > 0)
+          {
+            i += count;
+            continue;
+          }
+      }
+
+      id = APR_ARRAY_IDX(ids, i, apr_uint64_t);
+      work_item = APR_ARRAY_IDX(work_items, i, svn_skel_t *);
+      i++;
+
       err = dispatch_work_item(&wib, db, wri_abspath, work_item,
                                cancel_func, cancel_baton, iterpool);
       if (err)
         {
-          const char *skel = svn_skel__unparse(work_item, scratch_pool)->data;
-
-          return svn_error_createf(SVN_ERR_WC_BAD_ADM_LOG, err,
-                                   _("Failed to run the WC DB work queue "
-                                     "associated with '%s', work item %d %s"),
-                                   svn_dirent_local_style(wri_abspath,
-                                                          scratch_pool),
-                                   (int)id, skel);
+          err = wrap_work_item_error(err, wri_abspath, id, work_item,
+                                     scratch_pool);
+
+          /* Don't run the items before this one again. */
+          return svn_error_compose_create(
+                   err,
+                   complete_work_items(NULL, NULL, &wib, completed,
+                                       db, wri_abspath,
+                                       batch_pool, iterpool));
         }
 
       /* The work item finished without error. Mark it completed
-         in the next loop.  */
-      last_id = id;
+         with the next batch.  */
+      APR_ARRAY_PUSH(completed, apr_uint64_t) = id;
     }
 
+  svn_pool_destroy(batch_pool);
   svn_pool_destroy(iterpool);
   return SVN_NO_ERROR;
 }
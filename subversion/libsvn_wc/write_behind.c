@@ -0,0 +1,550 @@
+/*
+ * write_behind.c: let a worker thread write streams on our behalf
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <apr_thread_proc.h>
+
+#include "svn_pools.h"
+#include "svn_private_config.h"
+
+#include "private/svn_mutex.h"
+#include "private/svn_thread_cond.h"
+
+#include "write_behind.h"
+
+/* Number of bytes at the start of each stream that get written directly.
+   Most files are small and handing them over to the worker would cost
+   more than it saves. */
+#define SYNC_WRITE_LIMIT (64 * 1024)
+
+/* Maximum number of bytes waiting for the worker.  Writers will block
+   while the queue is full. */
+#define MAX_QUEUED_BYTES (4 * 1024 * 1024)
+
+#if APR_HAS_THREADS
+
+/* A chunk of data waiting to be written to some stream. */
+typedef struct chunk_t
+{
+  /* The write-behind stream that this data has been written to. */
+  struct write_behind_baton_t *stream;
+
+  /* Next chunk in the queue. */
+  struct chunk_t *next;
+
+  /* Set by the worker if the chunk shall be dropped instead of being
+     written. */
+  svn_boolean_t skip;
+
+  /* The data.  This is allocated with malloc() because it is being
+     freed by a different thread than the one that created it. */
+  apr_size_t len;
+  char data[1];
+} chunk_t;
+
+struct svn_wc__write_behind_t
+{
+  /* Serializes access to all members below. */
+  svn_mutex__t *mutex;
+
+  /* Signaled when a chunk has been queued or the worker shall exit. */
+  svn_thread_cond__t *chunk_queued;
+
+  /* Signaled when the worker finished processing a chunk. */
+  svn_thread_cond__t *chunk_done;
+
+  /* Chunks not processed, yet. */
+  chunk_t *first;
+  chunk_t *last;
+  apr_size_t queued_bytes;
+
+  /* The worker thread or NULL if it has not been started, yet. */
+  apr_thread_t *thread;
+  apr_pool_t *thread_pool;
+
+  /* Set when the worker shall terminate. */
+  svn_boolean_t shutdown;
+};
+
+/* Baton of the streams returned by svn_wc__write_behind_stream(). */
+typedef struct write_behind_baton_t
+{
+  svn_wc__write_behind_t *wb;
+  svn_stream_t *target;
+
+  /* Bytes written to this stream so far.  Writer thread only. */
+  apr_size_t written;
+
+  /* Once set, all further writes go through the queue to keep the data
+     in order.  Writer thread only. */
+  svn_boolean_t queued;
+
+  /* The members below are protected by WB->MUTEX. */
+
+  /* Number of chunks that have been queued but not been processed. */
+  int pending;
+
+  /* Set when TARGET failed or the caller gave up on this stream.
+     All chunks pending for this stream will be skipped. */
+  svn_boolean_t failed;
+
+  /* The error reported by TARGET, if it has not been returned to the
+     caller, yet. */
+  svn_error_t *err;
+} write_behind_baton_t;
+
+/* Take the next chunk from the queue in WB and return it in *CHUNK.
+   Block while the queue is empty.  Set *CHUNK to NULL after WB has been
+   shut down.
+
+   This function must be called with WB->MUTEX acquired. */
+static svn_error_t *
+take_chunk(chunk_t **chunk,
+           svn_wc__write_behind_t *wb)
+{
+  while (wb->first == NULL && !wb->shutdown)
+    SVN_ERR(svn_thread_cond__wait(wb->chunk_queued, wb->mutex));
+
+  *chunk = wb->first;
+  if (*chunk)
+    {
+      wb->first = (*chunk)->next;
+      if (wb->first == NULL)
+        wb->last = NULL;
+
+      (*chunk)->skip = (*chunk)->stream->failed;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Record that the worker of WB finished processing CHUNK with the result
+   ERR.  Release CHUNK and wake up any writer waiting for it.
+
+   This function must be called with WB->MUTEX acquired. */
+static svn_error_t *
+finish_chunk(svn_wc__write_behind_t *wb,
+             chunk_t *chunk,
+             svn_error_t *err)
+{
+  write_behind_baton_t *stream = chunk->stream;
+
+  if (err)
+    {
+      if (stream->failed)
+        svn_error_clear(err);
+      else
+        stream->err = err;
+
+      stream->failed = TRUE;
+    }
+
+  --stream->pending;
+  wb->queued_bytes -= chunk->len;
+  free(chunk);
+
+  return svn_thread_cond__broadcast(wb->chunk_done);
+}
+
+/* Worker loop: write all chunks queued in WB until WB gets shut down. */
+static svn_error_t *
+run_worker(svn_wc__write_behind_t *wb)
+{
+  while (TRUE)
+    {
+      chunk_t *chunk;
+      svn_error_t *err = SVN_NO_ERROR;
+
+      SVN_MUTEX__WITH_LOCK(wb->mutex, take_chunk(&chunk, wb));
+      if (chunk == NULL)
+        break;
+
+      if (!chunk->skip)
+        {
+          apr_size_t len = chunk->len;
+          err = svn_stream_write(chunk->stream->target, chunk->data, &len);
+        }
+
+      SVN_MUTEX__WITH_LOCK(wb->mutex, finish_chunk(wb, chunk, err));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* The plain APR thread function running the worker.
+ * DATA is the svn_wc__write_behind_t object to serve. */
+static void * APR_THREAD_FUNC
+worker_thread(apr_thread_t *thread, void *data)
+{
+  svn_error_t *err = run_worker(data);
+  apr_status_t result = APR_SUCCESS;
+
+  if (err)
+    {
+      result = err->apr_err;
+      svn_error_clear(err);
+    }
+
+  /* End thread explicitly to prevent APR_INCOMPLETE return codes in
+     apr_thread_join(). */
+  apr_thread_exit(thread, result);
+  return NULL;
+}
+
+/* Start the worker thread of WB, unless it is already running.
+
+   This function must be called with WB->MUTEX acquired. */
+static svn_error_t *
+ensure_worker(svn_wc__write_behind_t *wb)
+{
+  apr_status_t status;
+
+  if (wb->thread)
+    return SVN_NO_ERROR;
+
+  /* The thread object can't share the allocator with the writer. */
+  if (wb->thread_pool == NULL)
+    wb->thread_pool
+      = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+
+  status = apr_thread_create(&wb->thread, NULL, worker_thread, wb,
+                             wb->thread_pool);
+  if (status)
+    {
+      wb->thread = NULL;
+      return svn_error_wrap_apr(status, _("Can't create write-behind thread"));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Hand CHUNK over to the worker of WB, blocking while the queue is full.
+   If CHUNK's stream already failed, release CHUNK and return the error
+   instead.
+
+   This function must be called with WB->MUTEX acquired. */
+static svn_error_t *
+queue_chunk(svn_wc__write_behind_t *wb,
+            chunk_t *chunk)
+{
+  write_behind_baton_t *stream = chunk->stream;
+  svn_error_t *err;
+
+  while (wb->queued_bytes >= MAX_QUEUED_BYTES && !stream->failed)
+    SVN_ERR(svn_thread_cond__wait(wb->chunk_done, wb->mutex));
+
+  if (stream->failed)
+    {
+      err = stream->err;
+      stream->err = NULL;
+      free(chunk);
+
+      return err ? err : svn_error_create(SVN_ERR_CANCELLED, NULL, NULL);
+    }
+
+  err = ensure_worker(wb);
+  if (err)
+    {
+      free(chunk);
+      return svn_error_trace(err);
+    }
+
+  if (wb->last)
+    wb->last->next = chunk;
+  else
+    wb->first = chunk;
+
+  wb->last = chunk;
+  wb->queued_bytes += chunk->len;
+  ++stream->pending;
+
+  return svn_thread_cond__signal(wb->chunk_queued);
+}
+
+/* Block until all chunks of STREAM have been processed.  Return the
+   error reported by the target, if any.
+
+   This function must be called with STREAM->WB->MUTEX acquired. */
+static svn_error_t *
+wait_for_stream(write_behind_baton_t *stream)
+{
+  svn_error_t *err;
+
+  while (stream->pending)
+    SVN_ERR(svn_thread_cond__wait(stream->wb->chunk_done, stream->wb->mutex));
+
+  err = stream->err;
+  stream->err = NULL;
+
+  return err;
+}
+
+/* Block until the worker of WB has processed all queued chunks.
+
+   This function must be called with WB->MUTEX acquired. */
+static svn_error_t *
+wait_for_idle(svn_wc__write_behind_t *wb)
+{
+  while (wb->queued_bytes)
+    SVN_ERR(svn_thread_cond__wait(wb->chunk_done, wb->mutex));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_write_fn_t. */
+static svn_error_t *
+write_behind_write(void *baton,
+                   const char *data,
+                   apr_size_t *len)
+{
+  write_behind_baton_t *stream = baton;
+  chunk_t *chunk;
+
+  if (*len == 0)
+    return SVN_NO_ERROR;
+
+  /* Write short streams directly. */
+  if (!stream->queued && stream->written + *len <= SYNC_WRITE_LIMIT)
+    {
+      stream->written += *len;
+      return svn_error_trace(svn_stream_write(stream->target, data, len));
+    }
+
+  chunk = malloc(offsetof(chunk_t, data) + *len);
+  if (chunk == NULL)
+    return svn_error_wrap_apr(APR_ENOMEM, NULL);
+
+  chunk->stream = stream;
+  chunk->next = NULL;
+  chunk->skip = FALSE;
+  chunk->len = *len;
+  memcpy(chunk->data, data, *len);
+
+  stream->queued = TRUE;
+  stream->written += *len;
+
+  SVN_MUTEX__WITH_LOCK(stream->wb->mutex, queue_chunk(stream->wb, chunk));
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t. */
+static svn_error_t *
+write_behind_close(void *baton)
+{
+  write_behind_baton_t *stream = baton;
+
+  if (stream->queued)
+    SVN_MUTEX__WITH_LOCK(stream->wb->mutex, wait_for_stream(stream));
+
+  return svn_error_trace(svn_stream_close(stream->target));
+}
+
+/* Mark STREAM as failed and wait for the worker to drop its pending data.
+
+   This function must be called with STREAM->WB->MUTEX acquired. */
+static svn_error_t *
+abandon_stream(write_behind_baton_t *stream)
+{
+  stream->failed = TRUE;
+  svn_error_clear(wait_for_stream(stream));
+
+  return SVN_NO_ERROR;
+}
+
+/* Pool cleanup function making sure that the worker won't access the
+   write_behind_baton_t given as BATON anymore. */
+static apr_status_t
+cleanup_stream(void *baton)
+{
+  write_behind_baton_t *stream = baton;
+  svn_error_t *err = svn_mutex__lock(stream->wb->mutex);
+
+  if (!err)
+    err = svn_mutex__unlock(stream->wb->mutex, abandon_stream(stream));
+
+  svn_error_clear(err);
+  return APR_SUCCESS;
+}
+
+/* Tell the worker of WB to terminate.
+
+   This function must be called with WB->MUTEX acquired. */
+static svn_error_t *
+request_shutdown(svn_wc__write_behind_t *wb)
+{
+  wb->shutdown = TRUE;
+  return svn_thread_cond__broadcast(wb->chunk_queued);
+}
+
+/* Pool cleanup function terminating the worker of the
+   svn_wc__write_behind_t given as BATON. */
+static apr_status_t
+cleanup_write_behind(void *baton)
+{
+  svn_wc__write_behind_t *wb = baton;
+  svn_error_t *err = svn_mutex__lock(wb->mutex);
+
+  if (!err)
+    err = svn_mutex__unlock(wb->mutex, request_shutdown(wb));
+
+  if (wb->thread)
+    {
+      apr_status_t retval;
+      apr_thread_join(&retval, wb->thread);
+      wb->thread = NULL;
+    }
+
+  if (wb->thread_pool)
+    {
+      svn_pool_destroy(wb->thread_pool);
+      wb->thread_pool = NULL;
+    }
+
+  svn_error_clear(err);
+  return APR_SUCCESS;
+}
+
+/* A pool created by svn_wc__write_behind_pool() and its parent. */
+typedef struct attached_pool_t
+{
+  apr_pool_t *parent;
+  apr_pool_t *pool;
+} attached_pool_t;
+
+/* Pool cleanup function registered with the parent pool of the
+   attached_pool_t given as BATON. */
+static apr_status_t destroy_attached_pool(void *baton);
+
+/* Pool cleanup function registered with the attached_pool_t given as
+   BATON, such that its parent won't try to destroy it again. */
+static apr_status_t
+detach_pool(void *baton)
+{
+  attached_pool_t *attached = baton;
+  apr_pool_cleanup_kill(attached->parent, attached, destroy_attached_pool);
+
+  return APR_SUCCESS;
+}
+
+static apr_status_t
+destroy_attached_pool(void *baton)
+{
+  attached_pool_t *attached = baton;
+  apr_pool_cleanup_kill(attached->pool, attached, detach_pool);
+  svn_pool_destroy(attached->pool);
+
+  return APR_SUCCESS;
+}
+
+#endif /* APR_HAS_THREADS */
+
+svn_error_t *
+svn_wc__write_behind_create(svn_wc__write_behind_t **wb_p,
+                            apr_pool_t *result_pool)
+{
+#if APR_HAS_THREADS
+  svn_wc__write_behind_t *wb = apr_pcalloc(result_pool, sizeof(*wb));
+
+  SVN_ERR(svn_mutex__init(&wb->mutex, TRUE, result_pool));
+  SVN_ERR(svn_thread_cond__create(&wb->chunk_queued, result_pool));
+  SVN_ERR(svn_thread_cond__create(&wb->chunk_done, result_pool));
+
+  apr_pool_cleanup_register(result_pool, wb, cleanup_write_behind,
+                            apr_pool_cleanup_null);
+
+  *wb_p = wb;
+#else
+  *wb_p = NULL;
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+svn_wc__write_behind_wait(svn_wc__write_behind_t *wb)
+{
+#if APR_HAS_THREADS
+  if (wb)
+    SVN_MUTEX__WITH_LOCK(wb->mutex, wait_for_idle(wb));
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+apr_pool_t *
+svn_wc__write_behind_pool(svn_wc__write_behind_t *wb,
+                          apr_pool_t *parent)
+{
+#if APR_HAS_THREADS
+  if (wb)
+    {
+      apr_pool_t *pool
+        = apr_allocator_owner_get(svn_pool_create_allocator(TRUE));
+      attached_pool_t *attached = apr_palloc(pool, sizeof(*attached));
+
+      attached->parent = parent;
+      attached->pool = pool;
+
+      apr_pool_cleanup_register(parent, attached, destroy_attached_pool,
+                                apr_pool_cleanup_null);
+      apr_pool_cleanup_register(pool, attached, detach_pool,
+                                apr_pool_cleanup_null);
+
+      return pool;
+    }
+#endif
+
+  return svn_pool_create(parent);
+}
+
+svn_stream_t *
+svn_wc__write_behind_stream(svn_wc__write_behind_t *wb,
+                            svn_stream_t *target,
+                            apr_pool_t *result_pool)
+{
+#if APR_HAS_THREADS
+  if (wb)
+    {
+      write_behind_baton_t *baton = apr_pcalloc(result_pool, sizeof(*baton));
+      svn_stream_t *stream;
+
+      baton->wb = wb;
+      baton->target = target;
+
+      stream = svn_stream_create(baton, result_pool);
+      svn_stream_set_write(stream, write_behind_write);
+      svn_stream_set_close(stream, write_behind_close);
+
+      apr_pool_cleanup_register(result_pool, baton, cleanup_stream,
+                                apr_pool_cleanup_null);
+
+      return stream;
+    }
+#endif
+
+  return target;
+}
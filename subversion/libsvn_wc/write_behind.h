@@ -0,0 +1,99 @@
+/*
+ * write_behind.h: let a worker thread write streams on our behalf
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef SVN_LIBSVN_WC_WRITE_BEHIND_H
+#define SVN_LIBSVN_WC_WRITE_BEHIND_H
+
+#include <apr_pools.h>
+
+#include "svn_types.h"
+#include "svn_io.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* A single worker thread that performs the writes to any number of
+ * streams in the background, one chunk at a time and strictly in the
+ * order the chunks were written.
+ *
+ * The update editor uses this to move the pristine checksumming, the
+ * EOL / keyword translation and the disk writes of incoming file contents
+ * off the thread that drives the editor.
+ *
+ * Everything the worker touches while writing, i.e. the target streams
+ * and all pools they may allocate from, must live in pools created by
+ * svn_wc__write_behind_pool().  The caller must not use the target
+ * streams otherwise until the write-behind stream has been closed.
+ */
+typedef struct svn_wc__write_behind_t svn_wc__write_behind_t;
+
+/* Create a new write-behind context in *WB_P, allocated in RESULT_POOL.
+ * The worker thread will be started on demand and gets terminated when
+ * RESULT_POOL is being cleaned up.
+ *
+ * If APR does not support threads, all writes will be passed through to
+ * the target streams directly.
+ */
+svn_error_t *
+svn_wc__write_behind_create(svn_wc__write_behind_t **wb_p,
+                            apr_pool_t *result_pool);
+
+/* Block until the worker of WB has processed all data written so far.
+ * Use this before cleaning up target streams that still have data pending.
+ *
+ * WB may be NULL, in which case this is a no-op.
+ */
+svn_error_t *
+svn_wc__write_behind_wait(svn_wc__write_behind_t *wb);
+
+/* Return a new pool that may be shared with the worker of WB.  It will
+ * be destroyed together with PARENT, if it has not been destroyed before.
+ *
+ * WB may be NULL, in which case this is equivalent to svn_pool_create().
+ */
+apr_pool_t *
+svn_wc__write_behind_pool(svn_wc__write_behind_t *wb,
+                          apr_pool_t *parent);
+
+/* Return a write-only stream, allocated in RESULT_POOL, that forwards all
+ * data to TARGET.  Except for the first few KB, the writes will happen
+ * in the worker thread of WB.  Errors reported by TARGET will be returned
+ * from the next write to, or the closing of, the returned stream.
+ *
+ * Closing the returned stream waits for all pending writes to finish
+ * and then closes TARGET in the calling thread.  If RESULT_POOL gets
+ * cleaned up before that, any pending data will be discarded.
+ *
+ * WB may be NULL, in which case TARGET is returned as is.
+ */
+svn_stream_t *
+svn_wc__write_behind_stream(svn_wc__write_behind_t *wb,
+                            svn_stream_t *target,
+                            apr_pool_t *result_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* SVN_LIBSVN_WC_WRITE_BEHIND_H */
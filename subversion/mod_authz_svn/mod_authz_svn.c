@@ -47,6 +47,7 @@
 #include "svn_pools.h"
 #include "svn_dirent_uri.h"
 #include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
 
 /* The apache headers define these and they conflict with our definitions. */
 #ifdef PACKAGE_BUGREPORT
@@ -210,6 +211,23 @@ AuthzSVNGroupsFile_cmd(cmd_parms *cmd, void *config, const char *arg1)
   return NULL;
 }
 
+static const char *
+AuthzSVNCacheDir_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  const char *cache_dir = ap_server_root_relative(cmd->pool, arg1);
+
+  if (!cache_dir)
+    return apr_pstrcat(cmd->pool, "Invalid directory path ", arg1,
+                       SVN_VA_NULL);
+
+  /* The setting is process-wide and the child processes inherit it. */
+  svn_repos__authz_set_cache_dir(svn_dirent_internal_style(cache_dir,
+                                                           cmd->pool),
+                                 cmd->pool);
+
+  return NULL;
+}
+
 /* Implements the #cmds member of Apache's #module vtable. */
 static const command_rec authz_svn_cmds[] =
 {
@@ -241,6 +259,13 @@ static const command_rec authz_svn_cmds[] =
                 "repositories.  Path may be an repository relative URL (^/) "
                 "or absolute file:// URL to a text file in a Subversion "
                 "repository."),
+  AP_INIT_TAKE1("AuthzSVNCacheDir",
+                AuthzSVNCacheDir_cmd,
+                NULL,
+                RSRC_CONF,
+                "Directory in which the compiled rules of authz files are "
+                "kept, so that other processes can load them instead of "
+                "parsing the same authz files again."),
   AP_INIT_FLAG("AuthzSVNAnonymous", ap_set_flag_slot,
                (void *)APR_OFFSETOF(authz_svn_config_rec, anonymous),
                OR_AUTHCFG,
@@ -831,23 +856,21 @@ req_check_access(request_rec *r,
 }
 
 /*
- * Implementation of subreq_bypass with scratch_pool parameter.
+ * Set *ACCESS_CONF and *USERNAME_TO_AUTHORIZE for the subrequest bypass
+ * checks of R.  Return OK on success and HTTP_FORBIDDEN, after logging
+ * the denial of REPOS_PATH, if the configuration does not allow them.
  */
 static int
-subreq_bypass2(request_rec *r,
-               const char *repos_path,
-               const char *repos_name,
-               apr_pool_t *scratch_pool)
+get_bypass_access_conf(svn_authz_t **access_conf,
+                       const char **username_to_authorize,
+                       request_rec *r,
+                       const char *repos_path,
+                       apr_pool_t *scratch_pool)
 {
-  svn_error_t *svn_err = NULL;
-  svn_authz_t *access_conf = NULL;
-  authz_svn_config_rec *conf = NULL;
-  svn_boolean_t authz_access_granted = FALSE;
-  const char *username_to_authorize;
+  authz_svn_config_rec *conf = ap_get_module_config(r->per_dir_config,
+                                                    &authz_svn_module);
 
-  conf = ap_get_module_config(r->per_dir_config,
-                              &authz_svn_module);
-  username_to_authorize = get_username_to_authorize(r, conf, scratch_pool);
+  *username_to_authorize = get_username_to_authorize(r, conf, scratch_pool);
 
   /* If configured properly, this should never be true, but just in case. */
   if (!conf->anonymous
@@ -858,10 +881,33 @@ subreq_bypass2(request_rec *r,
     }
 
   /* Retrieve authorization file */
-  access_conf = get_access_conf(r, conf, scratch_pool);
-  if (access_conf == NULL)
+  *access_conf = get_access_conf(r, conf, scratch_pool);
+  if (*access_conf == NULL)
     return HTTP_FORBIDDEN;
 
+  return OK;
+}
+
+/*
+ * Implementation of subreq_bypass with scratch_pool parameter.
+ */
+static int
+subreq_bypass2(request_rec *r,
+               const char *repos_path,
+               const char *repos_name,
+               apr_pool_t *scratch_pool)
+{
+  svn_error_t *svn_err = NULL;
+  svn_authz_t *access_conf = NULL;
+  svn_boolean_t authz_access_granted = FALSE;
+  const char *username_to_authorize;
+  int status;
+
+  status = get_bypass_access_conf(&access_conf, &username_to_authorize, r,
+                                  repos_path, scratch_pool);
+  if (status != OK)
+    return status;
+
   /* Perform authz access control.
    * See similarly labeled comment in req_check_access.
    */
@@ -912,6 +958,93 @@ subreq_bypass(request_rec *r,
   return status;
 }
 
+/*
+ * Implementation of subreq_bypass_bulk with scratch_pool parameter.
+ */
+static int
+subreq_bypass_bulk2(request_rec *r,
+                    const apr_array_header_t *repos_paths,
+                    const char *repos_name,
+                    int *allowed,
+                    apr_pool_t *scratch_pool)
+{
+  svn_authz_t *access_conf = NULL;
+  const char *username_to_authorize;
+  apr_pool_t *iterpool;
+  int status;
+  int i;
+
+  if (repos_paths->nelts == 0)
+    return OK;
+
+  /* The configuration is the same for all paths. */
+  status = get_bypass_access_conf(&access_conf, &username_to_authorize, r,
+                                  APR_ARRAY_IDX(repos_paths, 0,
+                                                const char *),
+                                  scratch_pool);
+  if (status != OK)
+    return status;
+
+  iterpool = svn_pool_create(scratch_pool);
+  for (i = 0; i < repos_paths->nelts; ++i)
+    {
+      const char *repos_path = APR_ARRAY_IDX(repos_paths, i, const char *);
+      svn_boolean_t authz_access_granted = TRUE;
+      svn_error_t *svn_err;
+
+      svn_pool_clear(iterpool);
+
+      /* See subreq_bypass2(). */
+      if (repos_path)
+        {
+          svn_err = svn_repos_authz_check_access(access_conf, repos_name,
+                                                 repos_path,
+                                                 username_to_authorize,
+                                                 svn_authz_none|svn_authz_read,
+                                                 &authz_access_granted,
+                                                 iterpool);
+          if (svn_err)
+            {
+              log_svn_error(APLOG_MARK, r,
+                            "Failed to perform access control:",
+                            svn_err, iterpool);
+              svn_pool_destroy(iterpool);
+              return HTTP_FORBIDDEN;
+            }
+        }
+
+      log_access_verdict(APLOG_MARK, r, authz_access_granted, TRUE,
+                         repos_path, NULL);
+      allowed[i] = authz_access_granted;
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return OK;
+}
+
+/*
+ * This function is used as a provider to allow mod_dav_svn to authorize
+ * many paths at once, e.g. the entries of a directory, without creating
+ * an apache request for each of them.
+ */
+static int
+subreq_bypass_bulk(request_rec *r,
+                   const apr_array_header_t *repos_paths,
+                   const char *repos_name,
+                   int *allowed)
+{
+  int status;
+  apr_pool_t *scratch_pool;
+
+  scratch_pool = svn_pool_create(r->pool);
+  status = subreq_bypass_bulk2(r, repos_paths, repos_name, allowed,
+                               scratch_pool);
+  svn_pool_destroy(scratch_pool);
+
+  return status;
+}
+
 /*
  * Hooks
  */
@@ -1142,6 +1275,11 @@ register_hooks(apr_pool_t *p)
                        AUTHZ_SVN__SUBREQ_BYPASS_PROV_NAME,
                        AUTHZ_SVN__SUBREQ_BYPASS_PROV_VER,
                        (void*)subreq_bypass);
+  ap_register_provider(p,
+                       AUTHZ_SVN__SUBREQ_BYPASS_PROV_GRP,
+                       AUTHZ_SVN__SUBREQ_BYPASS_BULK_PROV_NAME,
+                       AUTHZ_SVN__SUBREQ_BYPASS_BULK_PROV_VER,
+                       (void*)subreq_bypass_bulk);
 }
 
 module AP_MODULE_DECLARE_DATA authz_svn_module =
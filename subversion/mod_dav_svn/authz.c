@@ -98,6 +98,70 @@ dav_svn__allow_read(request_rec *r,
 }
 
 
+void
+dav_svn__allow_read_bulk(request_rec *r,
+                         const dav_svn_repos *repos,
+                         const apr_array_header_t *paths,
+                         svn_revnum_t rev,
+                         svn_boolean_t *allowed,
+                         apr_pool_t *pool)
+{
+  authz_svn__subreq_bypass_bulk_func_t allow_read_bypass_bulk;
+  apr_pool_t *iterpool;
+  int i;
+
+  /* Easy out:  if the admin has explicitly set 'SVNPathAuthz Off',
+     then this whole callback does nothing. */
+  if (! dav_svn__get_pathauthz_flag(r))
+    {
+      for (i = 0; i < paths->nelts; ++i)
+        allowed[i] = TRUE;
+
+      return;
+    }
+
+  allow_read_bypass_bulk = dav_svn__get_pathauthz_bypass_bulk(r);
+  if (allow_read_bypass_bulk != NULL)
+    {
+      apr_array_header_t *abs_paths = apr_array_make(pool, paths->nelts,
+                                                     sizeof(const char *));
+      int *verdicts = apr_pcalloc(pool, paths->nelts * sizeof(*verdicts));
+      int status;
+
+      /* Fix up the paths the same way dav_svn__allow_read() does. */
+      for (i = 0; i < paths->nelts; ++i)
+        {
+          const char *path = APR_ARRAY_IDX(paths, i, const char *);
+
+          if (path && path[0] != '/')
+            path = apr_pstrcat(pool, "/", path, SVN_VA_NULL);
+
+          APR_ARRAY_PUSH(abs_paths, const char *) = path;
+        }
+
+      /* Like the single-path version, deny everything if the check
+         itself failed. */
+      status = allow_read_bypass_bulk(r, abs_paths, repos->repo_basename,
+                                      verdicts);
+      for (i = 0; i < paths->nelts; ++i)
+        allowed[i] = status == OK && verdicts[i] != 0;
+
+      return;
+    }
+
+  /* One check per path. */
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < paths->nelts; ++i)
+    {
+      svn_pool_clear(iterpool);
+      allowed[i] = dav_svn__allow_read(r, repos,
+                                       APR_ARRAY_IDX(paths, i, const char *),
+                                       rev, iterpool);
+    }
+  svn_pool_destroy(iterpool);
+}
+
+
 svn_boolean_t
 dav_svn__allow_list_repos(request_rec *r,
                           const char *repos_name,
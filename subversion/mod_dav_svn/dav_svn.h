@@ -37,6 +37,7 @@
 #include "svn_path.h"
 #include "svn_xml.h"
 #include "private/svn_dav_protocol.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_skel.h"
 #include "mod_authz_svn.h"
 
@@ -52,6 +53,9 @@ extern "C" {
 /* a pool-key for the shared dav_svn_root used by autoversioning  */
 #define DAV_SVN__AUTOVERSIONING_ACTIVITY "svn-autoversioning-activity"
 
+/* a pool-key for the dav_svn_repos whose I/O stats shall be logged */
+#define DAV_SVN__IO_STATS_REPOS "svn-io-stats-repos"
+
 /* Option values for SVNAllowBulkUpdates.  Note that
    it's important that CONF_BULKUPD_DEFAULT is 0 to make
    merge_dir_config in mod_dav_svn do the right thing. */
@@ -130,6 +134,12 @@ typedef struct dav_svn_repos {
   /* a cached copy of REPOS->fs above. */
   svn_fs_t *fs;
 
+  /* I/O statistics of FS at the start of this request.  May be NULL. */
+  svn_fs_io_stats_t *io_stats_base;
+
+  /* Resident size of the server process at the start of this request. */
+  apr_uint64_t rss_base;
+
   /* the user operating against this repository */
   const char *username;
 
@@ -306,6 +316,19 @@ struct dav_resource_private {
 
   /* resource is accessed by 'public' uri (not under "!svn") */
   svn_boolean_t is_public_uri;
+
+  /* The single byte range of the file to deliver, as determined by
+     set_headers().  RANGE_LENGTH is 0 if the whole file is requested. */
+  svn_filesize_t range_start;
+  svn_filesize_t range_length;
+
+  /* Set by set_headers() if the client already has the current contents
+     of this resource, i.e. if deliver() must not send a body. */
+  svn_boolean_t not_modified;
+
+  /* The file contents as a raw deflate stream, if set_headers() decided
+     to send them with "Content-Encoding: deflate".  NULL otherwise. */
+  svn_string_t *deflated;
 };
 
 
@@ -347,11 +370,22 @@ dav_svn__get_nodeprop_cache_flag(request_rec *r);
  * request? */
 svn_boolean_t dav_svn__get_block_read_flag(request_rec *r);
 
+/* may file contents stored compressed in the repository referred to by
+ * this request be sent as they are, with "Content-Encoding: deflate"? */
+svn_boolean_t dav_svn__get_send_precompressed_flag(request_rec *r);
+
 /* for the repository referred to by this request, are subrequests bypassed?
  * A function pointer if yes, NULL if not.
  */
 authz_svn__subreq_bypass_func_t dav_svn__get_pathauthz_bypass(request_rec *r);
 
+/* for the repository referred to by this request, are subrequests bypassed
+ * and can many paths be checked at once?  A function pointer if yes, NULL
+ * if not.
+ */
+authz_svn__subreq_bypass_bulk_func_t
+dav_svn__get_pathauthz_bypass_bulk(request_rec *r);
+
 /* for the repository referred to by this request, is a GET of
    SVNParentPath allowed? */
 svn_boolean_t dav_svn__get_list_parentpath_flag(request_rec *r);
@@ -416,6 +450,11 @@ const char *dav_svn__get_master_uri(request_rec *r);
    Comes from the <SVNMasterVersion> directive. */
 svn_version_t *dav_svn__get_master_version(request_rec *r);
 
+/* Return how long to wait for this slave to catch up with a revision
+   requested by a read request before proxying the request to the master
+   instead.  Comes from the <SVNMasterSyncWait> directive. */
+apr_interval_time_t dav_svn__get_master_sync_wait(request_rec *r);
+
 /* Return the disk path to the activities db.
    Comes from the <SVNActivitiesDB> directive. */
 const char *dav_svn__get_activities_db(request_rec *r);
@@ -431,6 +470,17 @@ int dav_svn__get_compression_level(request_rec *r);
 /* Return the hook script environment parsed from the configuration. */
 const char *dav_svn__get_hooks_env(request_rec *r);
 
+/* Return the process-wide pool of opened repositories. */
+svn_repos__repos_pool_t *dav_svn__get_repos_pool(void);
+
+/* Wait until the process-wide scheduler, if any is configured, admits the
+   expensive operation OP on REPOS for the user of request R.  The
+   operation keeps its slot until POOL gets cleaned up. */
+svn_error_t *dav_svn__admit_request(request_rec *r,
+                                    svn_repos_t *repos,
+                                    svn_repos__sched_op_t op,
+                                    apr_pool_t *pool);
+
 /** For HTTP protocol v2, these are the new URIs and URI stubs
     returned to the client in our OPTIONS response.  They all depend
     on the 'special uri', which is configurable in httpd.conf.  **/
@@ -705,6 +755,7 @@ static const dav_report_elem dav_svn__reports_list[] = {
   { SVN_XML_NAMESPACE, SVN_DAV__MERGEINFO_REPORT },
   { SVN_XML_NAMESPACE, SVN_DAV__INHERITED_PROPS_REPORT },
   { SVN_XML_NAMESPACE, "list-report" },
+  { SVN_XML_NAMESPACE, "blame-report" },
   { NULL, NULL },
 };
 
@@ -762,6 +813,11 @@ dav_svn__list_report(const dav_resource *resource,
                      const apr_xml_doc *doc,
                      dav_svn__output *output);
 
+dav_error *
+dav_svn__blame_report(const dav_resource *resource,
+                      const apr_xml_doc *doc,
+                      dav_svn__output *output);
+
 /*** posts/ ***/
 
 /* The various POST handlers, defined in posts/, and used by repos.c.  */
@@ -802,6 +858,21 @@ dav_svn__allow_read(request_rec *r,
                     svn_revnum_t rev,
                     apr_pool_t *pool);
 
+/* Set the elements of ALLOWED, which must have at least as many elements
+   as PATHS, to whether the current user may read the respective path in
+   PATHS, an array of const char *, in REPOS at REV, just like
+   dav_svn__allow_read() would.  If this Subversion location bypasses
+   Apache's authz modules and mod_authz_svn supports it, check all paths
+   in one call.  Use POOL for any temporary allocation.
+*/
+void
+dav_svn__allow_read_bulk(request_rec *r,
+                         const dav_svn_repos *repos,
+                         const apr_array_header_t *paths,
+                         svn_revnum_t rev,
+                         svn_boolean_t *allowed,
+                         apr_pool_t *pool);
+
 /* Return TRUE iff the current user (as determined by Apache's
    authentication system) has permission to read RESOURCE in REV
    (where an invalid REV means "HEAD").  This will invoke any authz
@@ -1040,11 +1111,29 @@ dav_svn__make_base64_output_stream(apr_bucket_brigade *bb,
                                    dav_svn__output *output,
                                    apr_pool_t *pool);
 
+/* Return a writable generic stream that will send its output to OUTPUT
+   using BB as binary frames: a NUL byte, the length of the data as a
+   4 byte big-endian number and the data itself.  As XML never contains
+   NUL bytes, such frames can be embedded between the tokens of an XML
+   response for clients that asked for them.  Allocate the stream in
+   POOL. */
+svn_stream_t *
+dav_svn__make_binary_output_stream(apr_bucket_brigade *bb,
+                                   dav_svn__output *output,
+                                   apr_pool_t *pool);
+
 /* In INFO->r->subprocess_env set "SVN-ACTION" to LINE, "SVN-REPOS" to
  * INFO->repos->fs_path, and "SVN-REPOS-NAME" to INFO->repos->repo_basename. */
 void
 dav_svn__operational_log(struct dav_resource_private *info, const char *line);
 
+/* Implements the log_transaction hook.  If the request R has been logged
+ * with dav_svn__operational_log(), set "SVN-IO" in R->subprocess_env to
+ * a summary of the filesystem I/O caused by that request and "SVN-MEM"
+ * to the current, peak and request-time growth of the process size. */
+int
+dav_svn__log_io_stats(request_rec *r);
+
 /* Flush BB if it's okay and useful to do so, but treat PREFERRED_ERR
  * as a more important error to return (if it is non-NULL).
  *
@@ -28,6 +28,9 @@
 #include <httpd.h>
 #include <http_core.h>
 
+#include "svn_dirent_uri.h"
+#include "svn_fs.h"
+#include "svn_repos.h"
 #include "private/svn_fspath.h"
 
 #include "dav_svn.h"
@@ -76,6 +79,93 @@ static int proxy_request_fixup(request_rec *r,
 }
 
 
+/* If URI_SEGMENT (relative to the location root) addresses a resource at
+   an explicit revision through SPECIAL_URI, set *REV to that revision and
+   *REPOS_NAME to the part of URI_SEGMENT before the special URI, i.e. the
+   repository name when using SVNParentPath.  Otherwise, set *REV to
+   SVN_INVALID_REVNUM.  Allocate *REPOS_NAME in POOL. */
+static void
+requested_revision(svn_revnum_t *rev,
+                   const char **repos_name,
+                   const char *uri_segment,
+                   const char *special_uri,
+                   apr_pool_t *pool)
+{
+    /* Special URI types that start with a revision number. */
+    static const char * const types[] =
+      { "rvr/", "rev/", "bc/", "bln/", "ver/", NULL };
+    const char *special, *start, *end;
+    int i;
+
+    *rev = SVN_INVALID_REVNUM;
+    *repos_name = "";
+    special = ap_strstr_c(uri_segment, apr_pstrcat(pool, "/", special_uri,
+                                                   "/", SVN_VA_NULL));
+    if (!special)
+        return;
+
+    start = special + strlen(special_uri) + 2;
+    for (i = 0; types[i]; ++i) {
+        if (strncmp(start, types[i], strlen(types[i])) == 0) {
+            svn_error_t *err;
+
+            start += strlen(types[i]);
+            err = svn_revnum_parse(rev, start, &end);
+            if (err || (*end != '\0' && *end != '/')) {
+                svn_error_clear(err);
+                *rev = SVN_INVALID_REVNUM;
+                return;
+            }
+
+            *repos_name = svn_relpath_canonicalize(
+                              apr_pstrmemdup(pool, uri_segment,
+                                             special - uri_segment),
+                              pool);
+            return;
+        }
+    }
+}
+
+/* Return TRUE if the repository addressed by R, with REPOS_NAME as
+   returned by requested_revision(), does not have revision REV yet,
+   even after waiting for the configured SVNMasterSyncWait time. */
+static svn_boolean_t
+lagging_behind(request_rec *r,
+               const char *repos_name,
+               svn_revnum_t rev)
+{
+    const char *fs_path = dav_svn__get_fs_path(r);
+    apr_time_t deadline = apr_time_now() + dav_svn__get_master_sync_wait(r);
+    svn_repos_t *repos;
+    svn_revnum_t youngest;
+    svn_error_t *err;
+
+    if (!fs_path) {
+        const char *parent_path = dav_svn__get_fs_parent_path(r);
+
+        if (!parent_path || !*repos_name)
+            return FALSE;
+        fs_path = svn_dirent_join(parent_path, repos_name, r->pool);
+    }
+
+    err = svn_repos_open3(&repos, fs_path, NULL, r->pool, r->pool);
+    while (!err) {
+        err = svn_fs_youngest_rev(&youngest, svn_repos_fs(repos), r->pool);
+        if (err || youngest >= rev)
+            break;
+
+        /* svnsync may still be busy replicating REV. */
+        if (apr_time_now() >= deadline)
+            return TRUE;
+        apr_sleep(apr_time_from_msec(50));
+    }
+
+    /* Let the regular request processing deal with any problems. */
+    svn_error_clear(err);
+    return FALSE;
+}
+
+
 int dav_svn__proxy_request_fixup(request_rec *r)
 {
     const char *root_dir, *master_uri, *special_uri;
@@ -112,6 +202,23 @@ int dav_svn__proxy_request_fixup(request_rec *r)
                     rv = proxy_request_fixup(r, master_uri, seg);
                     if (rv) return rv;
                 }
+                else {
+                    svn_revnum_t rev;
+                    const char *repos_name;
+
+                    /* Requests for revisions that haven't been synced to
+                       this slave yet can only be answered by the master.
+                       This gives clients read-your-writes consistency
+                       for the revisions they just committed. */
+                    seg += strlen(root_dir);
+                    requested_revision(&rev, &repos_name, seg, special_uri,
+                                       r->pool);
+                    if (SVN_IS_VALID_REVNUM(rev)
+                        && lagging_behind(r, repos_name, rev)) {
+                        int rv = proxy_request_fixup(r, master_uri, seg);
+                        if (rv) return rv;
+                    }
+                }
             }
             return OK;
         }
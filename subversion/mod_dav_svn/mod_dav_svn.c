@@ -30,6 +30,7 @@
 #include <httpd.h>
 #include <http_config.h>
 #include <http_request.h>
+#include <http_protocol.h>
 #include <http_log.h>
 #include <ap_provider.h>
 #include <mod_dav.h>
@@ -42,8 +43,11 @@
 #include "svn_dso.h"
 #include "mod_dav_svn.h"
 
+#include "private/svn_cache.h"
 #include "private/svn_fspath.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_trace.h"
 
 #include "dav_svn.h"
 #include "mod_authz_svn.h"
@@ -101,12 +105,14 @@ typedef struct dir_conf_t {
   const char *root_dir;              /* our top-level directory */
   const char *master_uri;            /* URI to the master SVN repos */
   svn_version_t *master_version;     /* version of master server */
+  int master_sync_wait;              /* msecs to wait for a lagging slave */
   const char *activities_db;         /* path to activities database(s) */
   enum conf_flag txdelta_cache;      /* whether to enable txdelta caching */
   enum conf_flag fulltext_cache;     /* whether to enable fulltext caching */
   enum conf_flag revprop_cache;      /* whether to enable revprop caching */
   enum conf_flag nodeprop_cache;     /* whether to enable nodeprop caching */
   enum conf_flag block_read;         /* whether to enable block read mode */
+  enum conf_flag send_precompressed; /* whether to send stored zlib data */
   const char *hooks_env;             /* path to hook script env config file */
 } dir_conf_t;
 
@@ -120,6 +126,94 @@ extern module AP_MODULE_DECLARE_DATA dav_svn_module;
 /* The authz_svn provider for bypassing path authz. */
 static authz_svn__subreq_bypass_func_t pathauthz_bypass_func = NULL;
 
+/* The authz_svn provider for bypassing path authz for many paths at once.
+   May be NULL even if PATHAUTHZ_BYPASS_FUNC is not. */
+static authz_svn__subreq_bypass_bulk_func_t pathauthz_bypass_bulk_func = NULL;
+
+/* Whether all child processes shall use the same in-memory cache. */
+static svn_boolean_t share_memory_cache = FALSE;
+
+/* The file to append trace spans to.  NULL if tracing is disabled. */
+static const char *trace_file = NULL;
+
+/* Key of the trace span of a request in the userdata of its pool. */
+#define TRACE_SPAN_KEY "mod_dav_svn-trace-span"
+
+/* Opened repositories, shared by all connections of this process. */
+static svn_repos__repos_pool_t *repos_pool = NULL;
+
+/* Reset REPOS_POOL when the configuration pool that it lives in gets
+ * cleared, e.g. during a graceful restart.  Implements apr cleanup. */
+static apr_status_t
+deinit_repos_pool(void *data)
+{
+  repos_pool = NULL;
+  return APR_SUCCESS;
+}
+
+/* Concurrency limits per svn_repos__sched_op_t; 0 for no limit. */
+static int sched_limits[SVN_REPOS__SCHED_OP_COUNT] = { 0 };
+
+/* Users (const char *) whose requests wait for everybody else's when
+ * one of SCHED_LIMITS is reached.  Allocated in the configuration pool;
+ * may be NULL. */
+static apr_array_header_t *bulk_users = NULL;
+
+/* Admission control for expensive requests, shared by all threads of this
+ * process.  NULL if no SCHED_LIMITS are configured. */
+static svn_repos__scheduler_t *scheduler = NULL;
+
+/* Reset the scheduler configuration when the configuration pool gets
+ * cleared, e.g. during a graceful restart.  Implements apr cleanup. */
+static apr_status_t
+deinit_scheduler(void *data)
+{
+  int i;
+  for (i = 0; i < SVN_REPOS__SCHED_OP_COUNT; ++i)
+    sched_limits[i] = 0;
+
+  bulk_users = NULL;
+  scheduler = NULL;
+  return APR_SUCCESS;
+}
+
+/* Begin a trace span for request R if it is for one of our repositories
+ * and continue the client's trace, if it sent one.  Implements the
+ * fixups hook. */
+static int
+trace_request_begin(request_rec *r)
+{
+  svn_trace__span_t *span;
+
+  if (!svn_trace__enabled() || r->main
+      || (!dav_svn__get_fs_path(r) && !dav_svn__get_fs_parent_path(r)))
+    return DECLINED;
+
+  svn_trace__continue(apr_table_get(r->headers_in, "traceparent"));
+  span = svn_trace__begin("mod_dav_svn", r->method, r->pool);
+  apr_pool_userdata_setn(span, TRACE_SPAN_KEY, NULL, r->pool);
+
+  return DECLINED;
+}
+
+/* End the trace span of request R, if there is one.  Implements the
+ * log_transaction hook.  Without it, the span would only end when the
+ * request pool gets destroyed, possibly after the next request began. */
+static int
+trace_request_end(request_rec *r)
+{
+  void *span = NULL;
+
+  apr_pool_userdata_get(&span, TRACE_SPAN_KEY, r->pool);
+  if (span)
+    {
+      svn_trace__end(span);
+      apr_pool_userdata_setn(NULL, TRACE_SPAN_KEY, NULL, r->pool);
+    }
+
+  return DECLINED;
+}
+
 static int
 init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
 {
@@ -137,6 +231,38 @@ init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
       return HTTP_INTERNAL_SERVER_ERROR;
     }
 
+  /* Like the authz pools, the repository pool is created in the
+     non-threaded context of the server's initialization. */
+  serr = svn_repos__repos_pool_create(&repos_pool, APR_HAS_THREADS,
+                                      svn_pool_create(p));
+  if (serr)
+    {
+      ap_log_perror(APLOG_MARK, APLOG_ERR, serr->apr_err, p,
+                    "mod_dav_svn: error creating the repository pool: '%s'",
+                    serr->message ? serr->message : "(no more info)");
+      return HTTP_INTERNAL_SERVER_ERROR;
+    }
+  apr_pool_cleanup_register(p, NULL, deinit_repos_pool,
+                            apr_pool_cleanup_null);
+
+  /* Threads of the same child process share the scheduler. */
+  if (   sched_limits[svn_repos__sched_op_log_changed_paths]
+      || sched_limits[svn_repos__sched_op_file_revs]
+      || sched_limits[svn_repos__sched_op_report])
+    {
+      serr = svn_repos__scheduler_create(&scheduler, sched_limits,
+                                         bulk_users, p);
+      if (serr)
+        {
+          ap_log_perror(APLOG_MARK, APLOG_ERR, serr->apr_err, p,
+                        "mod_dav_svn: error creating the scheduler: '%s'",
+                        serr->message ? serr->message : "(no more info)");
+          return HTTP_INTERNAL_SERVER_ERROR;
+        }
+    }
+  apr_pool_cleanup_register(p, NULL, deinit_scheduler,
+                            apr_pool_cleanup_null);
+
   serr = svn_repos_authz_initialize(p);
   if (serr)
     {
@@ -150,6 +276,34 @@ init(apr_pool_t *p, apr_pool_t *plog, apr_pool_t *ptemp, server_rec *s)
   conf = ap_get_module_config(s->module_config, &dav_svn_module);
   svn_utf_initialize2(conf->use_utf8, p);
 
+  /* The child processes will be forked from this one.  Caching is optional,
+     so don't fail the server start if we can't share the cache. */
+  if (share_memory_cache)
+    {
+      serr = svn_cache__share_global_membuffer_cache();
+      if (serr)
+        {
+          ap_log_perror(APLOG_MARK, APLOG_WARNING, serr->apr_err, p,
+                        "mod_dav_svn: can't share the in-memory cache: '%s'",
+                        serr->message ? serr->message : "(no more info)");
+          svn_error_clear(serr);
+        }
+    }
+
+  /* Tracing is optional as well.  All child processes append to the
+     same file. */
+  if (trace_file)
+    {
+      serr = svn_trace__enable(trace_file, ptemp);
+      if (serr)
+        {
+          ap_log_perror(APLOG_MARK, APLOG_WARNING, serr->apr_err, p,
+                        "mod_dav_svn: can't open the trace file: '%s'",
+                        serr->message ? serr->message : "(no more info)");
+          svn_error_clear(serr);
+        }
+    }
+
   return OK;
 }
 
@@ -272,6 +426,7 @@ merge_dir_config(apr_pool_t *p, void *base, void *overrides)
   newconf->fs_path = INHERIT_VALUE(parent, child, fs_path);
   newconf->master_uri = INHERIT_VALUE(parent, child, master_uri);
   newconf->master_version = INHERIT_VALUE(parent, child, master_version);
+  newconf->master_sync_wait = INHERIT_VALUE(parent, child, master_sync_wait);
   newconf->activities_db = INHERIT_VALUE(parent, child, activities_db);
   newconf->repo_name = INHERIT_VALUE(parent, child, repo_name);
   newconf->xslt_uri = INHERIT_VALUE(parent, child, xslt_uri);
@@ -286,6 +441,8 @@ merge_dir_config(apr_pool_t *p, void *base, void *overrides)
   newconf->revprop_cache = INHERIT_VALUE(parent, child, revprop_cache);
   newconf->nodeprop_cache = INHERIT_VALUE(parent, child, nodeprop_cache);
   newconf->block_read = INHERIT_VALUE(parent, child, block_read);
+  newconf->send_precompressed = INHERIT_VALUE(parent, child,
+                                              send_precompressed);
   newconf->root_dir = INHERIT_VALUE(parent, child, root_dir);
   newconf->hooks_env = INHERIT_VALUE(parent, child, hooks_env);
 
@@ -364,6 +521,26 @@ SVNMasterVersion_cmd(cmd_parms *cmd, void *config, const char *arg1)
 }
 
 
+static const char *
+SVNMasterSyncWait_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  dir_conf_t *conf = config;
+  int value = 0;
+  svn_error_t *err = svn_cstring_atoi(&value, arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the master sync wait time.";
+    }
+
+  if (value < 0)
+    return "The master sync wait time must not be negative.";
+
+  conf->master_sync_wait = value;
+  return NULL;
+}
+
+
 static const char *
 SVNActivitiesDB_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -459,6 +636,13 @@ SVNPathAuthz_cmd(cmd_parms *cmd, void *config, const char *arg1)
                                AUTHZ_SVN__SUBREQ_BYPASS_PROV_NAME,
                                AUTHZ_SVN__SUBREQ_BYPASS_PROV_VER);
         }
+      if (pathauthz_bypass_bulk_func == NULL)
+        {
+          pathauthz_bypass_bulk_func =
+            ap_lookup_provider(AUTHZ_SVN__SUBREQ_BYPASS_PROV_GRP,
+                               AUTHZ_SVN__SUBREQ_BYPASS_BULK_PROV_NAME,
+                               AUTHZ_SVN__SUBREQ_BYPASS_BULK_PROV_VER);
+        }
     }
   else if (apr_strnatcasecmp("on", arg1) == 0)
     {
@@ -611,6 +795,19 @@ SVNBlockRead_cmd(cmd_parms *cmd, void *config, int arg)
   return NULL;
 }
 
+static const char *
+SVNSendPrecompressed_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  dir_conf_t *conf = config;
+
+  if (arg)
+    conf->send_precompressed = CONF_FLAG_ON;
+  else
+    conf->send_precompressed = CONF_FLAG_OFF;
+
+  return NULL;
+}
+
 static const char *
 SVNInMemoryCacheSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -631,6 +828,91 @@ SVNInMemoryCacheSize_cmd(cmd_parms *cmd, void *config, const char *arg1)
   return NULL;
 }
 
+static const char *
+SVNInMemoryCacheShared_cmd(cmd_parms *cmd, void *config, int arg)
+{
+  share_memory_cache = arg;
+
+  return NULL;
+}
+
+static const char *
+SVNMemoryBudget_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  apr_uint64_t value = 0;
+  svn_error_t *err = svn_cstring_atoui64(&value, arg1);
+  if (err)
+    {
+      svn_error_clear(err);
+      return "Invalid decimal number for the SVN memory budget.";
+    }
+
+  svn_pool__set_memory_budget(value * 0x100000);
+
+  return NULL;
+}
+
+/* Set the limit of OP to the number ARG.  Return an error message naming
+ * the directive of CMD if ARG is not a valid limit. */
+static const char *
+set_sched_limit(cmd_parms *cmd,
+                svn_repos__sched_op_t op,
+                const char *arg)
+{
+  int value = 0;
+  svn_error_t *err = svn_cstring_atoi(&value, arg);
+  if (err || value < 0)
+    {
+      svn_error_clear(err);
+      return apr_pstrcat(cmd->pool, "Invalid value for ", cmd->cmd->name,
+                         ": ", arg, SVN_VA_NULL);
+    }
+
+  sched_limits[op] = value;
+
+  return NULL;
+}
+
+static const char *
+SVNMaxLogVerbose_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  return set_sched_limit(cmd, svn_repos__sched_op_log_changed_paths, arg1);
+}
+
+static const char *
+SVNMaxFileRevs_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  return set_sched_limit(cmd, svn_repos__sched_op_file_revs, arg1);
+}
+
+static const char *
+SVNMaxDeepReports_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  return set_sched_limit(cmd, svn_repos__sched_op_report, arg1);
+}
+
+static const char *
+SVNBulkUsers_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  if (!bulk_users)
+    bulk_users = apr_array_make(cmd->pool, 4, sizeof(const char *));
+
+  APR_ARRAY_PUSH(bulk_users, const char *) = apr_pstrdup(cmd->pool, arg1);
+
+  return NULL;
+}
+
+static const char *
+SVNTraceFile_cmd(cmd_parms *cmd, void *config, const char *arg1)
+{
+  trace_file = ap_server_root_relative(cmd->pool, arg1);
+  if (!trace_file)
+    return apr_pstrcat(cmd->pool, "Invalid SVNTraceFile path ", arg1,
+                       SVN_VA_NULL);
+
+  return NULL;
+}
+
 static const char *
 SVNCompressionLevel_cmd(cmd_parms *cmd, void *config, const char *arg1)
 {
@@ -807,6 +1089,16 @@ dav_svn__get_master_version(request_rec *r)
 }
 
 
+apr_interval_time_t
+dav_svn__get_master_sync_wait(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+  return apr_time_from_msec(conf->master_sync_wait);
+}
+
+
 const char *
 dav_svn__get_xslt_uri(request_rec *r)
 {
@@ -956,6 +1248,20 @@ dav_svn__get_pathauthz_bypass(request_rec *r)
   return NULL;
 }
 
+/* Function pointer if we should use the bulk bypass directly to
+ * mod_authz_svn.  NULL otherwise. */
+authz_svn__subreq_bypass_bulk_func_t
+dav_svn__get_pathauthz_bypass_bulk(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  if (conf->path_authz_method == CONF_PATHAUTHZ_BYPASS)
+    return pathauthz_bypass_bulk_func;
+  return NULL;
+}
+
 
 svn_boolean_t
 dav_svn__get_list_parentpath_flag(request_rec *r)
@@ -1034,6 +1340,17 @@ dav_svn__get_block_read_flag(request_rec *r)
   return get_conf_flag(conf->block_read, FALSE);
 }
 
+svn_boolean_t
+dav_svn__get_send_precompressed_flag(request_rec *r)
+{
+  dir_conf_t *conf;
+
+  conf = ap_get_module_config(r->per_dir_config, &dav_svn_module);
+
+  /* sending stored compressed data is disabled by default. */
+  return get_conf_flag(conf->send_precompressed, FALSE);
+}
+
 int
 dav_svn__get_compression_level(request_rec *r)
 {
@@ -1061,6 +1378,27 @@ dav_svn__get_hooks_env(request_rec *r)
   return conf->hooks_env;
 }
 
+svn_repos__repos_pool_t *
+dav_svn__get_repos_pool(void)
+{
+  return repos_pool;
+}
+
+svn_error_t *
+dav_svn__admit_request(request_rec *r,
+                       svn_repos_t *repos,
+                       svn_repos__sched_op_t op,
+                       apr_pool_t *pool)
+{
+  if (!scheduler)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(svn_repos__scheduler_admit(
+                           scheduler, repos, op,
+                           svn_repos__scheduler_classify(scheduler, r->user),
+                           pool));
+}
+
 static void
 merge_xml_filter_insert(request_rec *r)
 {
@@ -1334,6 +1672,13 @@ static const command_rec cmds[] =
                 "specifies the Subversion release version of a master "
                 "Subversion server "),
 
+  /* per directory/location */
+  AP_INIT_TAKE1("SVNMasterSyncWait", SVNMasterSyncWait_cmd, NULL,
+                ACCESS_CONF,
+                "specifies how many milliseconds to wait for this slave "
+                "to catch up with a revision it doesn't have yet before "
+                "proxying the request to the master (default is 0)"),
+
   /* per directory/location */
   AP_INIT_TAKE1("SVNActivitiesDB", SVNActivitiesDB_cmd, NULL, ACCESS_CONF,
                 "specifies the location in the filesystem in which the "
@@ -1389,6 +1734,14 @@ static const command_rec cmds[] =
                "caches (see SVNInMemoryCacheSize) have been configured."
                "(default is Off)."),
 
+  /* per directory/location */
+  AP_INIT_FLAG("SVNSendPrecompressed", SVNSendPrecompressed_cmd, NULL,
+               ACCESS_CONF|RSRC_CONF,
+               "sends file contents that FSFS stores zlib-compressed "
+               "as-is with 'Content-Encoding: deflate' to clients that "
+               "accept it, instead of decompressing them "
+               "(default is Off)."),
+
   /* per server */
   AP_INIT_TAKE1("SVNInMemoryCacheSize", SVNInMemoryCacheSize_cmd, NULL,
                 RSRC_CONF,
@@ -1396,6 +1749,49 @@ static const command_rec cmds[] =
                 "in-memory object cache (default value is 16384; 0 switches "
                 "to dynamically sized caches)."),
   /* per server */
+  AP_INIT_FLAG("SVNInMemoryCacheShared", SVNInMemoryCacheShared_cmd, NULL,
+               RSRC_CONF,
+               "enables one in-memory object cache (see SVNInMemoryCacheSize) "
+               "shared by all child processes instead of one cache per "
+               "process (default is Off)."),
+  /* per server */
+  AP_INIT_TAKE1("SVNMemoryBudget", SVNMemoryBudget_cmd, NULL,
+                RSRC_CONF,
+                "specifies the maximum size in MB of a server process.  "
+                "Responses being sent while the process is larger than that "
+                "fail with an error instead of making the host swap "
+                "(default is 0 for no limit)."),
+  /* per server */
+  AP_INIT_TAKE1("SVNMaxLogVerbose", SVNMaxLogVerbose_cmd, NULL,
+                RSRC_CONF,
+                "specifies the maximum number of log requests with changed "
+                "paths that a server process runs concurrently; others "
+                "wait (default is 0 for no limit)."),
+  /* per server */
+  AP_INIT_TAKE1("SVNMaxFileRevs", SVNMaxFileRevs_cmd, NULL,
+                RSRC_CONF,
+                "specifies the maximum number of blame requests that a "
+                "server process runs concurrently; others wait "
+                "(default is 0 for no limit)."),
+  /* per server */
+  AP_INIT_TAKE1("SVNMaxDeepReports", SVNMaxDeepReports_cmd, NULL,
+                RSRC_CONF,
+                "specifies the maximum number of checkouts, updates and "
+                "other tree-wide reports that a server process runs "
+                "concurrently; others wait (default is 0 for no limit)."),
+  /* per server */
+  AP_INIT_ITERATE("SVNBulkUsers", SVNBulkUsers_cmd, NULL,
+                  RSRC_CONF,
+                  "specifies users, e.g. mirrors or crawlers, whose "
+                  "requests wait for those of all other users when one of "
+                  "the SVNMax... limits is reached."),
+  /* per server */
+  AP_INIT_TAKE1("SVNTraceFile", SVNTraceFile_cmd, NULL,
+                RSRC_CONF,
+                "specifies a file to append a trace span for every request "
+                "to, continuing the traces of clients that send a "
+                "traceparent header (default is no tracing)."),
+  /* per server */
   AP_INIT_TAKE1("SVNCompressionLevel", SVNCompressionLevel_cmd, NULL,
                 RSRC_CONF,
                 "specifies the compression level used before sending file "
@@ -1468,12 +1864,18 @@ register_hooks(apr_pool_t *pconf)
   ap_register_input_filter("IncomingRewrite", dav_svn__location_in_filter,
                            NULL, AP_FTYPE_CONTENT_SET);
   ap_hook_fixups(dav_svn__proxy_request_fixup, NULL, NULL, APR_HOOK_MIDDLE);
+  ap_hook_fixups(trace_request_begin, NULL, NULL, APR_HOOK_LAST);
   /* translate_name hook is LAST so that it doesn't interfere with modules
    * like mod_alias that are MIDDLE. */
   ap_hook_translate_name(dav_svn__translate_name, NULL, NULL, APR_HOOK_LAST);
   /* map_to_storage hook is LAST to avoid interfering with mod_http's
    * handling of OPTIONS and TRACE. */
   ap_hook_map_to_storage(dav_svn__map_to_storage, NULL, NULL, APR_HOOK_LAST);
+  /* Provide "SVN-IO" before mod_log_config writes the log entries. */
+  ap_hook_log_transaction(dav_svn__log_io_stats, NULL, NULL,
+                          APR_HOOK_REALLY_FIRST);
+  ap_hook_log_transaction(trace_request_end, NULL, NULL,
+                          APR_HOOK_REALLY_FIRST);
 }
 
 
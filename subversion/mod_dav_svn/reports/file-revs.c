@@ -313,6 +313,14 @@ dav_svn__file_revs_report(const dav_resource *resource,
   /* file_rev_handler will send header first time it is called. */
 
   /* Get the revisions and send them. */
+  serr = dav_svn__admit_request(resource->info->r,
+                                resource->info->repos->repos,
+                                svn_repos__sched_op_file_revs,
+                                resource->pool);
+  if (serr)
+    return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR, NULL,
+                                resource->pool);
+
   serr = svn_repos_get_file_revs2(resource->info->repos->repos,
                                   abs_path, start, end, include_merged_revisions,
                                   dav_svn__authz_read_func(&arb), &arb,
@@ -67,6 +67,16 @@ typedef struct list_receiver_baton_t
 
   /* Send the field selected by these flags. */
   apr_uint32_t dirent_fields;
+
+  /* Root that we list.  Needed to read inlined file contents. */
+  svn_fs_root_t *root;
+
+  /* Send the contents of files up to this size with their items.
+     Negative if the client did not ask for inlined contents. */
+  svn_filesize_t inline_contents_max;
+
+  /* Don't send an item for this path.  May be NULL. */
+  const char *skip_path;
 } list_receiver_baton_t;
 
 
@@ -91,6 +101,44 @@ maybe_send_header(list_receiver_baton_t *lrb)
 }
 
 
+/* If B asks for inlined file contents and PATH of KIND in B->root is
+   a file of at most B->inline_contents_max bytes, set *TAG_CONTENTS to
+   an <S:contents> element with the base64-encoded file contents.
+   Otherwise, set it to "".  Allocate the result in POOL. */
+static svn_error_t *
+get_inline_contents(const char **tag_contents,
+                    list_receiver_baton_t *b,
+                    const char *path,
+                    svn_node_kind_t kind,
+                    apr_pool_t *pool)
+{
+  svn_filesize_t size;
+  svn_stream_t *stream;
+  svn_stringbuf_t *contents;
+  const svn_string_t *encoded;
+
+  *tag_contents = "";
+  if (b->inline_contents_max < 0 || kind != svn_node_file)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_file_length(&size, b->root, path, pool));
+  if (size > b->inline_contents_max)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_fs_file_contents(&stream, b->root, path, pool));
+  SVN_ERR(svn_stringbuf_from_stream(&contents, stream, (apr_size_t)size,
+                                    pool));
+  encoded = svn_base64_encode_string2(svn_string_create_from_buf(contents,
+                                                                 pool),
+                                      FALSE, pool);
+  *tag_contents = apr_pstrcat(pool,
+                              "<S:contents encoding=\"base64\">",
+                              encoded->data,
+                              "</S:contents>", SVN_VA_NULL);
+
+  return SVN_NO_ERROR;
+}
+
 /* Implements svn_repos_dirent_receiver_t, sending DIRENT and PATH to the
  * client.  BATON must be a list_receiver_baton_t. */
 static svn_error_t *
@@ -108,6 +156,10 @@ list_receiver(const char *path,
   const char *attr_created_rev = "";
   const char *attr_date = "";
   const char *tag_author = "";
+  const char *tag_contents;
+
+  if (b->skip_path && strcmp(path, b->skip_path) == 0)
+    return SVN_NO_ERROR;
 
   if (b->dirent_fields & SVN_DIRENT_SIZE)
     attr_size = apr_psprintf(pool, " size=\"%" SVN_FILESIZE_T_FMT "\"",
@@ -140,6 +192,9 @@ list_receiver(const char *path,
                                 apr_xml_quote_string(pool, author, 1));
     }
 
+  /* KIND is always known, even with PATH_INFO_ONLY set. */
+  SVN_ERR(get_inline_contents(&tag_contents, b, path, dirent->kind, pool));
+
   SVN_ERR(maybe_send_header(b));
 
   /* If we need to close the element, then send the attributes
@@ -150,14 +205,15 @@ list_receiver(const char *path,
                                  "%s"
                                  "%s"
                                  "%s"
-                                 "%s>%s%s</S:item>" DEBUG_CR,
+                                 "%s>%s%s%s</S:item>" DEBUG_CR,
                                  kind,
                                  attr_size,
                                  attr_has_props,
                                  attr_created_rev,
                                  attr_date,
                                  apr_xml_quote_string(pool, path, 0),
-                                 tag_author));
+                                 tag_author,
+                                 tag_contents));
 
   /* In general APR will flush the brigade every 8000 bytes through the filter
      stack, but log items may not be generated that fast, especially in
@@ -189,6 +245,67 @@ list_receiver(const char *path,
   return SVN_NO_ERROR;
 }
 
+/* Send the entries of the directories FULL_PATHS in LRB->root, each in a
+ * <S:dir> element with the respective path from REL_PATHS, using AUTHZ_FUNC
+ * and AUTHZ_BATON to filter them.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+send_dirs(list_receiver_baton_t *lrb,
+          const apr_array_header_t *rel_paths,
+          const apr_array_header_t *full_paths,
+          svn_repos_authz_func_t authz_func,
+          void *authz_baton,
+          apr_pool_t *scratch_pool)
+{
+  svn_boolean_t path_info_only = (lrb->dirent_fields & ~SVN_DIRENT_KIND) == 0;
+  apr_pool_t *iterpool = svn_pool_create(scratch_pool);
+  int i;
+
+  /* Check all paths before starting the response, so that we can still
+     report a proper error for them. */
+  for (i = 0; i < full_paths->nelts; i++)
+    {
+      const char *full_path = APR_ARRAY_IDX(full_paths, i, const char *);
+      svn_node_kind_t kind;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_check_path(&kind, lrb->root, full_path, iterpool));
+      if (kind == svn_node_none)
+        return svn_error_createf(SVN_ERR_FS_NOT_FOUND, NULL,
+                                 "Path '%s' not found", full_path);
+      if (kind != svn_node_dir)
+        return svn_error_createf(SVN_ERR_FS_NOT_DIRECTORY, NULL,
+                                 "Path '%s' not a directory", full_path);
+    }
+
+  SVN_ERR(maybe_send_header(lrb));
+
+  for (i = 0; i < full_paths->nelts; i++)
+    {
+      const char *full_path = APR_ARRAY_IDX(full_paths, i, const char *);
+      const char *rel_path = APR_ARRAY_IDX(rel_paths, i, const char *);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(dav_svn__brigade_printf(lrb->bb, lrb->output,
+                                      "<S:dir path=\"%s\">" DEBUG_CR,
+                                      apr_xml_quote_string(iterpool,
+                                                           rel_path, 1)));
+
+      /* svn_repos_list() reports the directory itself as well. */
+      lrb->skip_path = full_path;
+      SVN_ERR(svn_repos_list(lrb->root, full_path, NULL,
+                             svn_depth_immediates, path_info_only,
+                             authz_func, authz_baton,
+                             list_receiver, lrb, NULL, NULL, iterpool));
+      lrb->skip_path = NULL;
+
+      SVN_ERR(dav_svn__brigade_puts(lrb->bb, lrb->output,
+                                    "</S:dir>" DEBUG_CR));
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 dav_error *
 dav_svn__list_report(const dav_resource *resource,
                      const apr_xml_doc *doc,
@@ -209,11 +326,16 @@ dav_svn__list_report(const dav_resource *resource,
   /* These get determined from the request document. */
   svn_revnum_t rev = SVN_INVALID_REVNUM;     /* defaults to HEAD */
   apr_array_header_t *patterns = NULL;
+  apr_array_header_t *dir_rel_paths
+    = apr_array_make(resource->pool, 0, sizeof(const char *));
+  apr_array_header_t *dir_full_paths
+    = apr_array_make(resource->pool, 0, sizeof(const char *));
 
   /* Sanity check. */
   if (!resource->info->repos_path)
     return dav_svn__new_error(resource->pool, HTTP_BAD_REQUEST, 0, 0,
                               "The request does not specify a repository path");
+  lrb.inline_contents_max = -1;
   ns = dav_svn__find_ns(doc->namespaces, SVN_XML_NAMESPACE);
   if (ns == -1)
     {
@@ -243,6 +365,18 @@ dav_svn__list_report(const dav_resource *resource,
           full_path = svn_fspath__join(resource->info->repos_path, rel_path,
                                        resource->pool);
         }
+      else if (strcmp(child->name, "dir-path") == 0)
+        {
+          const char *rel_path = dav_xml_get_cdata(child, resource->pool, 0);
+          if ((derr = dav_svn__test_canonical(rel_path, resource->pool)))
+            return derr;
+
+          APR_ARRAY_PUSH(dir_rel_paths, const char *) = rel_path;
+          rel_path = svn_relpath_canonicalize(rel_path, resource->pool);
+          APR_ARRAY_PUSH(dir_full_paths, const char *)
+            = svn_fspath__join(resource->info->repos_path, rel_path,
+                               resource->pool);
+        }
       else if (strcmp(child->name, "revision") == 0)
         rev = SVN_STR_TO_REV(dav_xml_get_cdata(child, resource->pool, 1));
       else if (strcmp(child->name, "depth") == 0)
@@ -277,10 +411,23 @@ dav_svn__list_report(const dav_resource *resource,
           else if (strcmp(name, "DAV:allprop") == 0)
             lrb.dirent_fields |= SVN_DIRENT_ALL;
         }
+      else if (strcmp(child->name, "inline-contents-max") == 0)
+        {
+          const char *max = dav_xml_get_cdata(child, resource->pool, 1);
+          serr = svn_cstring_atoi64(&lrb.inline_contents_max, max);
+          if (serr || lrb.inline_contents_max < 0)
+            {
+              svn_error_clear(serr);
+              return dav_svn__new_error_svn(resource->pool, HTTP_BAD_REQUEST,
+                                            0, 0,
+                                            "Invalid inline-contents-max "
+                                            "value");
+            }
+        }
       /* else unknown element; skip it */
     }
 
-  if (! full_path)
+  if (! full_path && ! dir_full_paths->nelts)
     {
       return dav_svn__new_error_svn(resource->pool, HTTP_BAD_REQUEST, 0, 0,
                                     "Request was missing the path argument");
@@ -302,11 +449,20 @@ dav_svn__list_report(const dav_resource *resource,
   serr = svn_fs_revision_root(&root, repos->fs, rev, resource->pool);
   if (!serr)
     {
+      lrb.root = root;
+
       /* Fetch the directory entries if requested and send them immediately. */
       path_info_only = (lrb.dirent_fields & ~SVN_DIRENT_KIND) == 0;
-      serr = svn_repos_list(root, full_path, patterns, depth, path_info_only,
-                            dav_svn__authz_read_func(&arb), &arb,
-                            list_receiver, &lrb, NULL, NULL, resource->pool);
+      if (dir_full_paths->nelts)
+        serr = send_dirs(&lrb, dir_rel_paths, dir_full_paths,
+                         dav_svn__authz_read_func(&arb), &arb,
+                         resource->pool);
+      else
+        serr = svn_repos_list(root, full_path, patterns, depth,
+                              path_info_only,
+                              dav_svn__authz_read_func(&arb), &arb,
+                              list_receiver, &lrb, NULL, NULL,
+                              resource->pool);
     }
 
   if (serr)
@@ -335,9 +491,15 @@ dav_svn__list_report(const dav_resource *resource,
 
  cleanup:
 
-  dav_svn__operational_log(resource->info,
-                           svn_log__list(full_path, rev, patterns, depth,
-                                         lrb.dirent_fields, resource->pool));
+  if (dir_full_paths->nelts)
+    dav_svn__operational_log(resource->info,
+                             svn_log__get_dirs(dir_full_paths, rev,
+                                               resource->pool));
+  else
+    dav_svn__operational_log(resource->info,
+                             svn_log__list(full_path, rev, patterns, depth,
+                                           lrb.dirent_fields,
+                                           resource->pool));
 
   return dav_svn__final_flush_or_error(resource->info->r, lrb.bb, output,
                                        derr, resource->pool);
@@ -505,6 +505,19 @@ dav_svn__log_report(const dav_resource *resource,
      flag in our log_receiver_baton structure). */
 
   /* Send zero or more log items. */
+  if (discover_changed_paths)
+    {
+      serr = dav_svn__admit_request(resource->info->r, repos->repos,
+                                    svn_repos__sched_op_log_changed_paths,
+                                    resource->pool);
+      if (serr)
+        {
+          derr = dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                      NULL, resource->pool);
+          goto cleanup;
+        }
+    }
+
   serr = svn_repos_get_logs5(repos->repos,
                              paths,
                              start,
@@ -49,6 +49,7 @@ typedef struct edit_baton_t {
   svn_boolean_t sending_textdelta;
   int compression_level;
   int svndiff_version;
+  svn_boolean_t binary_txdelta;
 } edit_baton_t;
 
 
@@ -313,20 +314,29 @@ apply_textdelta(void *file_baton,
                 void **handler_baton)
 {
   edit_baton_t *eb = file_baton;
+  svn_stream_t *stream;
 
   SVN_ERR(dav_svn__brigade_puts(eb->bb, eb->output, "<S:apply-textdelta"));
 
   if (base_checksum)
-    SVN_ERR(dav_svn__brigade_printf(eb->bb, eb->output, " checksum=\"%s\">",
+    SVN_ERR(dav_svn__brigade_printf(eb->bb, eb->output, " checksum=\"%s\"",
                                     base_checksum));
+
+  if (eb->binary_txdelta)
+    {
+      SVN_ERR(dav_svn__brigade_puts(eb->bb, eb->output,
+                                    " encoding=\"binary\">"));
+      stream = dav_svn__make_binary_output_stream(eb->bb, eb->output, pool);
+    }
   else
-    SVN_ERR(dav_svn__brigade_puts(eb->bb, eb->output, ">"));
+    {
+      SVN_ERR(dav_svn__brigade_puts(eb->bb, eb->output, ">"));
+      stream = dav_svn__make_base64_output_stream(eb->bb, eb->output, pool);
+    }
 
   svn_txdelta_to_svndiff3(handler,
                           handler_baton,
-                          dav_svn__make_base64_output_stream(eb->bb,
-                                                             eb->output,
-                                                             pool),
+                          stream,
                           eb->svndiff_version,
                           eb->compression_level,
                           pool);
@@ -371,6 +381,7 @@ make_editor(const svn_delta_editor_t **editor,
             dav_svn__output *output,
             int compression_level,
             int svndiff_version,
+            svn_boolean_t binary_txdelta,
             apr_pool_t *pool)
 {
   edit_baton_t *eb = apr_pcalloc(pool, sizeof(*eb));
@@ -382,6 +393,7 @@ make_editor(const svn_delta_editor_t **editor,
   eb->sending_textdelta = FALSE;
   eb->compression_level = compression_level;
   eb->svndiff_version = svndiff_version;
+  eb->binary_txdelta = binary_txdelta;
 
   e->set_target_revision = set_target_revision;
   e->open_root = open_root;
@@ -423,6 +435,7 @@ dav_svn__replay_report(const dav_resource *resource,
   svn_revnum_t rev;
   const svn_delta_editor_t *editor;
   svn_boolean_t send_deltas = TRUE;
+  svn_boolean_t binary_txdelta = FALSE;
   dav_svn__authz_read_baton arb;
   const char *base_dir;
   apr_bucket_brigade *bb;
@@ -508,6 +521,11 @@ dav_svn__replay_report(const dav_resource *resource,
                 }
               send_deltas = parsed_val != 0;
             }
+          else if (strcmp(child->name, "binary-txdelta") == 0)
+            {
+              cdata = dav_xml_get_cdata(child, resource->pool, 1);
+              binary_txdelta = (strcmp(cdata, "no") != 0);
+            }
           else if (strcmp(child->name, "include-path") == 0)
             {
               cdata = dav_xml_get_cdata(child, resource->pool, 1);
@@ -548,6 +566,7 @@ dav_svn__replay_report(const dav_resource *resource,
   make_editor(&editor, &edit_baton, bb, output,
               dav_svn__get_compression_level(resource->info->r),
               resource->info->svndiff_version,
+              binary_txdelta,
               resource->pool);
 
   if ((err = svn_repos_replay2(root, base_dir, low_water_mark,
@@ -86,9 +86,18 @@ typedef struct update_ctx_t {
      inline.  (This is implied when "send_all" is set.)  */
   svn_boolean_t include_props;
 
+  /* When not in "send_all" mode, the size up to which the contents of
+     changed files are transmitted inline, or 0 to always tell the client
+     to fetch them. */
+  svn_filesize_t inline_max_size;
+
   /* SVNDIFF version to send to client.  */
   int svndiff_version;
 
+  /* True iff client accepts svndiff data in binary frames instead of
+     base64-encoded cdata. */
+  svn_boolean_t binary_txdelta;
+
   /* Compression level of SVNDIFF deltas. */
   int compression_level;
 
@@ -486,9 +495,10 @@ maybe_start_update_report(update_ctx_t *uc)
                   uc->bb, uc->output,
                   DAV_XML_HEADER DEBUG_CR "<S:update-report xmlns:S=\""
                   SVN_XML_NAMESPACE "\" xmlns:V=\"" SVN_DAV_PROP_NS_DAV "\" "
-                  "xmlns:D=\"DAV:\" %s %s>" DEBUG_CR,
+                  "xmlns:D=\"DAV:\" %s %s %s>" DEBUG_CR,
                   uc->send_all ? "send-all=\"true\"" : "",
-                  uc->include_props ? "inline-props=\"true\"" : ""));
+                  uc->include_props ? "inline-props=\"true\"" : "",
+                  uc->inline_max_size ? "inline-contents=\"true\"" : ""));
 
       uc->started_update = TRUE;
     }
@@ -766,6 +776,18 @@ struct window_handler_baton
 };
 
 
+/* Return the stream that svndiff data for the client of UC should be
+   written to, allocated in POOL. */
+static svn_stream_t *
+make_txdelta_output_stream(update_ctx_t *uc,
+                           apr_pool_t *pool)
+{
+  if (uc->binary_txdelta)
+    return dav_svn__make_binary_output_stream(uc->bb, uc->output, pool);
+  else
+    return dav_svn__make_base64_output_stream(uc->bb, uc->output, pool);
+}
+
 /* This implements 'svn_txdelta_window_handler_t'. */
 static svn_error_t *
 window_handler(svn_txdelta_window_t *window, void *baton)
@@ -777,12 +799,16 @@ window_handler(svn_txdelta_window_t *window, void *baton)
       wb->seen_first_window = TRUE;
 
       if (!wb->base_checksum)
-        SVN_ERR(dav_svn__brigade_puts(wb->uc->bb, wb->uc->output,
-                                      "<S:txdelta>"));
+        SVN_ERR(dav_svn__brigade_printf(wb->uc->bb, wb->uc->output,
+                                        "<S:txdelta%s>",
+                                        wb->uc->binary_txdelta
+                                          ? " encoding=\"binary\"" : ""));
       else
         SVN_ERR(dav_svn__brigade_printf(wb->uc->bb, wb->uc->output,
-                                        "<S:txdelta base-checksum=\"%s\">",
-                                        wb->base_checksum));
+                                        "<S:txdelta base-checksum=\"%s\"%s>",
+                                        wb->base_checksum,
+                                        wb->uc->binary_txdelta
+                                          ? " encoding=\"binary\"" : ""));
     }
 
   SVN_ERR(wb->handler(window, wb->handler_baton));
@@ -805,7 +831,6 @@ upd_apply_textdelta(void *file_baton,
 {
   item_baton_t *file = file_baton;
   struct window_handler_baton *wb;
-  svn_stream_t *base64_stream;
 
   /* Store the base checksum and the fact the file's text changed. */
   file->base_checksum = apr_pstrdup(file->pool, base_checksum);
@@ -824,12 +849,9 @@ upd_apply_textdelta(void *file_baton,
   wb->seen_first_window = FALSE;
   wb->uc = file->uc;
   wb->base_checksum = file->base_checksum;
-  base64_stream = dav_svn__make_base64_output_stream(wb->uc->bb,
-                                                     wb->uc->output,
-                                                     file->pool);
-
   svn_txdelta_to_svndiff3(&(wb->handler), &(wb->handler_baton),
-                          base64_stream, file->uc->svndiff_version,
+                          make_txdelta_output_stream(wb->uc, file->pool),
+                          file->uc->svndiff_version,
                           file->uc->compression_level, file->pool);
 
   *handler = window_handler;
@@ -839,15 +861,63 @@ upd_apply_textdelta(void *file_baton,
 }
 
 
+/* If FILE is not larger than the inline size limit of its update context,
+   send its full text as a txdelta against the empty stream and set
+   *INLINED to TRUE.  Otherwise, set *INLINED to FALSE.  Use POOL for
+   temporary allocations. */
+static svn_error_t *
+send_inline_contents(svn_boolean_t *inlined,
+                     item_baton_t *file,
+                     apr_pool_t *pool)
+{
+  const char *real_path = get_real_fs_path(file, pool);
+  struct window_handler_baton *wb;
+  svn_stream_t *contents;
+  svn_filesize_t length;
+
+  SVN_ERR(svn_fs_file_length(&length, file->uc->rev_root, real_path, pool));
+  if (length > file->uc->inline_max_size)
+    {
+      *inlined = FALSE;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_fs_file_contents(&contents, file->uc->rev_root, real_path,
+                               pool));
+
+  wb = apr_palloc(pool, sizeof(*wb));
+  wb->seen_first_window = FALSE;
+  wb->uc = file->uc;
+  wb->base_checksum = NULL;
+  svn_txdelta_to_svndiff3(&(wb->handler), &(wb->handler_baton),
+                          make_txdelta_output_stream(wb->uc, pool),
+                          file->uc->svndiff_version,
+                          file->uc->compression_level, pool);
+
+  SVN_ERR(svn_txdelta_send_stream(contents, window_handler, wb, NULL, pool));
+
+  *inlined = TRUE;
+  return SVN_NO_ERROR;
+}
+
+
 static svn_error_t *
 upd_close_file(void *file_baton, const char *text_checksum, apr_pool_t *pool)
 {
   item_baton_t *file = file_baton;
+  svn_boolean_t inlined = FALSE;
+
+  /* If the client asked for small files to be sent inline even though
+     we are not in "send all" mode, try that first. */
+  if ((! file->uc->send_all) && (! file->uc->resource_walk)
+      && file->uc->inline_max_size && file->text_changed)
+    SVN_ERR(send_inline_contents(&inlined, file, pool));
 
   /* If we are not in "send all" mode, and this file is not a new
      addition or didn't otherwise have changed text, tell the client
      to fetch it. */
-  if ((! file->uc->send_all) && (! file->added) && file->text_changed)
+  if ((! file->uc->send_all) && (! file->added) && file->text_changed
+      && (! inlined))
     {
       svn_checksum_t *sha1_checksum;
       const char *real_path = get_real_fs_path(file, pool);
@@ -1164,6 +1234,27 @@ dav_svn__update_report(const dav_resource *resource,
           if (strcmp(cdata, "no") != 0)
             uc.include_props = TRUE;
         }
+      if (child->ns == ns && strcmp(child->name, "binary-txdelta") == 0)
+        {
+          cdata = dav_xml_get_cdata(child, resource->pool, 1);
+          if (! *cdata)
+            return malformed_element_error(child->name, resource->pool);
+          if (strcmp(cdata, "no") != 0)
+            uc.binary_txdelta = TRUE;
+        }
+      if (child->ns == ns && strcmp(child->name, "inline-max-size") == 0)
+        {
+          apr_int64_t size;
+
+          cdata = dav_xml_get_cdata(child, resource->pool, 1);
+          serr = svn_cstring_atoi64(&size, cdata);
+          if (serr || size < 0)
+            {
+              svn_error_clear(serr);
+              return malformed_element_error(child->name, resource->pool);
+            }
+          uc.inline_max_size = size;
+        }
     }
 
   /* If a target revision wasn't requested, or the requested target
@@ -1246,7 +1337,16 @@ dav_svn__update_report(const dav_resource *resource,
      sending only a "skelta" of the difference, which will not need to
      contain actual text deltas. */
   if (! uc.send_all)
-    text_deltas = FALSE;
+    {
+      /* Inline contents are a compromise between the two modes, which
+         follows the bulk update configuration. */
+      if (! text_deltas || repos->bulk_updates == CONF_BULKUPD_OFF)
+        uc.inline_max_size = 0;
+
+      text_deltas = FALSE;
+    }
+  else
+    uc.inline_max_size = 0;
 
   /* When we call svn_repos_finish_report, it will ultimately run
      dir_delta() between REPOS_PATH/TARGET and TARGET_PATH.  In the
@@ -1268,6 +1368,17 @@ dav_svn__update_report(const dav_resource *resource,
   editor->close_file = upd_close_file;
   editor->absent_file = upd_absent_file;
   editor->close_edit = upd_close_edit;
+
+  if (requested_depth == svn_depth_infinity)
+    {
+      serr = dav_svn__admit_request(resource->info->r, repos->repos,
+                                    svn_repos__sched_op_report,
+                                    resource->pool);
+      if (serr)
+        return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR, NULL,
+                                    resource->pool);
+    }
+
   if ((serr = svn_repos_begin_report3(&rbaton, revnum,
                                       repos->repos,
                                       src_path, target,
@@ -54,9 +54,11 @@
 #include "svn_ra.h"  /* for SVN_RA_CAPABILITY_* */
 #include "svn_dirent_uri.h"
 #include "private/svn_log.h"
+#include "private/svn_fs_fs_private.h"
 #include "private/svn_fspath.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_subr_private.h"
 
 #include "dav_svn.h"
 
@@ -1771,7 +1773,10 @@ static int sort_encoding_pref(const void *accept_rec1, const void *accept_rec2)
 
 static int get_svndiff_version(const struct accept_rec *rec)
 {
-  if (strcmp(rec->name, "svndiff2") == 0)
+  /* We can't produce svndiff3 without Zstandard support. */
+  if (strcmp(rec->name, "svndiff3") == 0 && svn_zstd__is_available())
+    return 3;
+  else if (strcmp(rec->name, "svndiff2") == 0)
     return 2;
   else if (strcmp(rec->name, "svndiff1") == 0)
     return 1;
@@ -2464,10 +2469,14 @@ get_resource(request_rec *r,
       else
         serr = NULL;
 
-      /* open the FS */
+      /* open the FS or borrow an instance that an earlier connection
+         has opened; it is ours until the connection closes */
       if (!serr)
-        serr = svn_repos_open3(&(repos->repos), fs_path, fs_config,
-                               r->connection->pool, r->pool);
+        serr = svn_repos__repos_pool_get(&(repos->repos),
+                                         dav_svn__get_repos_pool(),
+                                         fs_path, fs_config,
+                                         dav_svn__get_hooks_env(r),
+                                         r->connection->pool, r->pool);
       if (serr != NULL)
         {
           /* The error returned by svn_repos_open2 might contain the
@@ -2503,19 +2512,21 @@ get_resource(request_rec *r,
                                          "in repos object",
                                          HTTP_INTERNAL_SERVER_ERROR, r);
         }
-
-      /* Configure hook script environment variables. */
-      serr = svn_repos_hooks_setenv(repos->repos, dav_svn__get_hooks_env(r),
-                                    r->pool);
-      if (serr)
-        return dav_svn__sanitize_error(serr,
-                                       "Error settings hooks environment",
-                                       HTTP_INTERNAL_SERVER_ERROR, r);
     }
 
   /* cache the filesystem object */
   repos->fs = svn_repos_fs(repos->repos);
 
+  /* The FS object may be shared with earlier requests on this connection.
+     Remember where we start so we can report our own I/O only. */
+  serr = svn_fs_get_io_stats(&repos->io_stats_base, repos->fs, r->pool);
+  if (serr)
+    {
+      svn_error_clear(serr);
+      repos->io_stats_base = NULL;
+    }
+  svn_pool__memory_usage(&repos->rss_base, NULL);
+
   /* capture warnings during cleanup of the FS */
   svn_fs_set_warning_func(repos->fs, log_warning_req, r);
 
@@ -3207,17 +3218,215 @@ is_cacheable(request_rec *r, const dav_resource *resource)
       return FALSE;
 }
 
+/* Return TRUE if the client sending request R accepts responses with
+ * "Content-Encoding: deflate". */
+static svn_boolean_t
+accepts_deflate(request_rec *r)
+{
+  apr_array_header_t *encoding_prefs;
+  int i;
+
+  encoding_prefs = do_header_line(r->pool,
+                                  apr_table_get(r->headers_in,
+                                                "Accept-Encoding"));
+  if (!encoding_prefs)
+    return FALSE;
+
+  for (i = 0; i < encoding_prefs->nelts; i++)
+    {
+      const struct accept_rec *rec = &APR_ARRAY_IDX(encoding_prefs, i,
+                                                    struct accept_rec);
+      if (strcmp(rec->name, "deflate") == 0 && rec->quality > 0.0f)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* Helper for set_headers().  If configured and accepted by the client,
+ * fetch the contents of the file RESOURCE requested by R in the
+ * compressed form in which the repository stores them.  If that is
+ * possible, set RESOURCE->INFO->DEFLATED and the Content-Encoding header,
+ * such that neither we nor mod_deflate need to compress them again. */
+static void
+get_precompressed_contents(request_rec *r, const dav_resource *resource)
+{
+  svn_fs_fs__ioctl_deflated_contents_input_t input = { 0 };
+  svn_fs_fs__ioctl_deflated_contents_output_t *output;
+  svn_error_t *serr;
+
+  /* Byte ranges and keyword expansion work on the plain text and deltas
+     are compressed differently. */
+  if (   r->method_number != M_GET
+      || resource->collection
+      || resource->info->delta_base
+      || resource->info->keyword_subst
+      || apr_table_get(r->headers_in, "Range")
+      || !dav_svn__get_send_precompressed_flag(r)
+      || !accepts_deflate(r))
+    return;
+
+  input.root = resource->info->root.root;
+  input.path = resource->info->repos_path;
+  serr = svn_fs_ioctl(resource->info->repos->fs,
+                      SVN_FS_FS__IOCTL_DEFLATED_CONTENTS, &input,
+                      (void **)&output, NULL, NULL, resource->pool,
+                      resource->pool);
+
+  /* Other backends don't support this. */
+  if (serr)
+    {
+      svn_error_clear(serr);
+      return;
+    }
+
+  if (output->deflated)
+    {
+      resource->info->deflated = output->deflated;
+      apr_table_setn(r->headers_out, "Content-Encoding", "deflate");
+      apr_table_mergen(r->headers_out, "Vary", "Accept-Encoding");
+    }
+}
+
+/* Helper for set_headers().  Return a strong ETag for the GET response
+ * to the cacheable file RESOURCE, allocated in POOL, or NULL if the
+ * file's SHA1 checksum is not known.
+ *
+ * Unlike dav_svn__getetag(), the result depends on the file contents
+ * rather than on the path, such that e.g. the same file in many tags
+ * shares a single entry in caches that key on the ETag.  It still
+ * differs between fulltexts, keyword-expanded texts and svndiffs against
+ * different bases in different formats. */
+static const char *
+get_content_etag(const dav_resource *resource, apr_pool_t *pool)
+{
+  svn_checksum_t *checksum;
+  svn_error_t *serr;
+  const char *etag;
+
+  serr = svn_fs_file_checksum(&checksum, svn_checksum_sha1,
+                              resource->info->root.root,
+                              resource->info->repos_path, FALSE, pool);
+  if (serr || !checksum)
+    {
+      svn_error_clear(serr);
+      return NULL;
+    }
+
+  etag = svn_checksum_to_cstring(checksum, pool);
+  if (resource->info->delta_base)
+    {
+      svn_checksum_t *base_checksum;
+
+      serr = svn_checksum(&base_checksum, svn_checksum_md5,
+                          resource->info->delta_base,
+                          strlen(resource->info->delta_base), pool);
+      if (serr)
+        {
+          svn_error_clear(serr);
+          return NULL;
+        }
+
+      etag = apr_psprintf(pool, "%s-%s-%d", etag,
+                          svn_checksum_to_cstring(base_checksum, pool),
+                          resource->info->svndiff_version);
+    }
+  else if (resource->info->keyword_subst)
+    {
+      etag = apr_pstrcat(pool, etag, "-kw", SVN_VA_NULL);
+    }
+  else if (resource->info->deflated)
+    {
+      etag = apr_pstrcat(pool, etag, "-deflate", SVN_VA_NULL);
+    }
+
+  return apr_psprintf(pool, "\"%s\"", etag);
+}
+
+/* If R is a GET request for a single, satisfiable byte range of a file
+   of LENGTH bytes, set *START and *RANGE_LENGTH to that range and return
+   TRUE.  Otherwise, return FALSE and leave the Range header to httpd's
+   byterange filter, which also handles multiple ranges, If-Range and
+   unsatisfiable ranges. */
+static svn_boolean_t
+get_single_byte_range(svn_filesize_t *start,
+                      svn_filesize_t *range_length,
+                      request_rec *r,
+                      svn_filesize_t length)
+{
+  const char *range = apr_table_get(r->headers_in, "Range");
+  const char *dash;
+  apr_int64_t first, last;
+  svn_error_t *err;
+
+  if (r->method_number != M_GET
+      || !range
+      || apr_table_get(r->headers_in, "If-Range")
+      || strncmp(range, "bytes=", 6) != 0
+      || strchr(range, ','))
+    return FALSE;
+
+  range += 6;
+  dash = strchr(range, '-');
+  if (!dash)
+    return FALSE;
+
+  if (dash == range)
+    {
+      /* "-N" selects the last N bytes. */
+      err = svn_cstring_atoi64(&last, dash + 1);
+      if (err || last <= 0)
+        {
+          svn_error_clear(err);
+          return FALSE;
+        }
+
+      first = last < length ? length - last : 0;
+      last = length - 1;
+    }
+  else
+    {
+      err = svn_cstring_atoi64(&first,
+                               apr_pstrndup(r->pool, range, dash - range));
+      if (!err && dash[1] == '\0')
+        last = length - 1;
+      else if (!err)
+        err = svn_cstring_atoi64(&last, dash + 1);
+
+      if (err || first < 0 || last < first)
+        {
+          svn_error_clear(err);
+          return FALSE;
+        }
+
+      if (last >= length)
+        last = length - 1;
+    }
+
+  if (first >= length)
+    return FALSE;
+
+  *start = first;
+  *range_length = last - first + 1;
+  return TRUE;
+}
+
 static dav_error *
 set_headers(request_rec *r, const dav_resource *resource)
 {
   svn_error_t *serr;
   svn_filesize_t length;
   const char *mimetype = NULL;
-
-  /* As version resources don't change, encourage caching. */
-  if (is_cacheable(r, resource))
-    /* Cache resource for one week (specified in seconds). */
-    apr_table_setn(r->headers_out, "Cache-Control", "max-age=604800");
+  const char *etag = NULL;
+  svn_boolean_t cacheable = is_cacheable(r, resource);
+
+  /* As version resources don't change, let clients and proxies keep them
+     for a year without revalidation.  Shared caches such as CDNs may only
+     store them if no authentication was involved in serving them. */
+  if (cacheable)
+    apr_table_setn(r->headers_out, "Cache-Control",
+                   r->user ? "private, max-age=31536000, immutable"
+                           : "public, max-age=31536000, immutable");
   else
     apr_table_setn(r->headers_out, "Cache-Control", "max-age=0");
 
@@ -3263,9 +3472,25 @@ set_headers(request_rec *r, const dav_resource *resource)
       svn_error_clear(serr);
     }
 
+  /* Send the stored compressed file contents if we can. */
+  if (cacheable)
+    get_precompressed_contents(r, resource);
+
   /* generate our etag and place it into the output */
-  apr_table_setn(r->headers_out, "ETag",
-                 dav_svn__getetag(resource, resource->pool));
+  if (cacheable)
+    etag = get_content_etag(resource, resource->pool);
+  if (etag == NULL)
+    etag = dav_svn__getetag(resource, resource->pool);
+  apr_table_setn(r->headers_out, "ETag", etag);
+
+  /* Immutable resources can be validated from the headers alone.  So,
+     answer conditional requests before we look at the contents. */
+  if (cacheable && ap_meets_conditions(r) == HTTP_NOT_MODIFIED)
+    {
+      resource->info->not_modified = TRUE;
+      r->status = HTTP_NOT_MODIFIED;
+      return NULL;
+    }
 
   /* we accept byte-ranges */
   apr_table_setn(r->headers_out, "Accept-Ranges", "bytes");
@@ -3296,9 +3521,10 @@ set_headers(request_rec *r, const dav_resource *resource)
           mimetype = SVN_SVNDIFF_MIME_TYPE;
 
           /* Note the base that this svndiff is based on, and tell any
-             intermediate caching proxies that this header is
-             significant.  */
-          apr_table_setn(r->headers_out, "Vary", SVN_DAV_DELTA_BASE_HEADER);
+             intermediate caching proxies that this header as well as
+             the negotiated svndiff format are significant.  */
+          apr_table_setn(r->headers_out, "Vary",
+                         SVN_DAV_DELTA_BASE_HEADER ", Accept-Encoding");
           apr_table_setn(r->headers_out, SVN_DAV_DELTA_BASE_HEADER,
                          resource->info->delta_base);
         }
@@ -3369,6 +3595,29 @@ set_headers(request_rec *r, const dav_resource *resource)
                                           resource->pool);
             }
           ap_set_content_length(r, (apr_off_t) length);
+
+          if (resource->info->deflated)
+            {
+              ap_set_content_length(r, resource->info->deflated->len);
+            }
+          /* Serve a single byte range ourselves, such that deliver() does
+             not need to read the file from its start. */
+          else if (get_single_byte_range(&resource->info->range_start,
+                                    &resource->info->range_length,
+                                    r, length))
+            {
+              r->status = HTTP_PARTIAL_CONTENT;
+              apr_table_setn(r->headers_out, "Content-Range",
+                             apr_psprintf(r->pool, "bytes %" SVN_FILESIZE_T_FMT
+                                          "-%" SVN_FILESIZE_T_FMT
+                                          "/%" SVN_FILESIZE_T_FMT,
+                                          resource->info->range_start,
+                                          resource->info->range_start
+                                            + resource->info->range_length - 1,
+                                          length));
+              ap_set_content_length(r,
+                                    (apr_off_t) resource->info->range_length);
+            }
         }
     }
 
@@ -3680,6 +3929,22 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
 
   output = dav_svn__output_create(resource->info->r, resource->pool);
 
+  /* set_headers() found the client's copy to be up to date. */
+  if (resource->info->not_modified)
+    {
+      bb = apr_brigade_create(resource->pool,
+                              dav_svn__output_get_bucket_alloc(output));
+      bkt = apr_bucket_eos_create(dav_svn__output_get_bucket_alloc(output));
+      APR_BRIGADE_INSERT_TAIL(bb, bkt);
+      serr = dav_svn__output_pass_brigade(output, bb);
+      if (serr != NULL)
+        return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                    "Could not write EOS to filter.",
+                                    resource->pool);
+
+      return NULL;
+    }
+
   if (resource->collection)
     {
       const int gen_html = !resource->info->repos->xslt_uri;
@@ -3687,6 +3952,7 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
       apr_pool_t *iterpool;
       apr_array_header_t *sorted;
       svn_revnum_t dir_rev = SVN_INVALID_REVNUM;
+      svn_boolean_t *allowed = NULL;
       int i;
 
       /* <svn version="1.3.0 (dev-build)"
@@ -3783,6 +4049,26 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
       sorted = svn_sort__hash(entries, svn_sort_compare_items_as_paths,
                               resource->pool);
 
+      /* authorize all entries of a versioned directory in one go */
+      if (SVN_IS_VALID_REVNUM(dir_rev))
+        {
+          apr_array_header_t *paths
+            = apr_array_make(resource->pool, sorted->nelts,
+                             sizeof(const char *));
+
+          for (i = 0; i < sorted->nelts; ++i)
+            APR_ARRAY_PUSH(paths, const char *)
+              = svn_fspath__join(resource->info->repos_path,
+                                 APR_ARRAY_IDX(sorted, i,
+                                               svn_sort__item_t).key,
+                                 resource->pool);
+
+          allowed = apr_palloc(resource->pool,
+                               sorted->nelts * sizeof(*allowed));
+          dav_svn__allow_read_bulk(resource->info->r, resource->info->repos,
+                                   paths, dir_rev, allowed, resource->pool);
+        }
+
       iterpool = svn_pool_create(resource->pool);
 
       for (i = 0; i < sorted->nelts; ++i)
@@ -3790,8 +4076,6 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
           const svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i,
                                                         const svn_sort__item_t);
           const svn_fs_dirent_t *entry = item->value;
-          const char *name = item->key;
-          const char *repos_relpath = NULL;
 
           svn_pool_clear(iterpool);
 
@@ -3800,13 +4084,7 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
              looking at a parent-path listing. */
           if (SVN_IS_VALID_REVNUM(dir_rev))
             {
-              repos_relpath = svn_fspath__join(resource->info->repos_path,
-                                               name, iterpool);
-              if (! dav_svn__allow_read(resource->info->r,
-                                        resource->info->repos,
-                                        repos_relpath,
-                                        dir_rev,
-                                        iterpool))
+              if (! allowed[i])
                 continue;
             }
           else
@@ -3940,15 +4218,50 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
         }
     }
 
+  /* set_headers() decided to send the stored compressed contents. */
+  if (resource->info->deflated)
+    {
+      bb = apr_brigade_create(resource->pool,
+                              dav_svn__output_get_bucket_alloc(output));
+      serr = dav_svn__brigade_write(bb, output,
+                                    resource->info->deflated->data,
+                                    resource->info->deflated->len);
+      if (serr == NULL)
+        {
+          bkt = apr_bucket_eos_create(
+                  dav_svn__output_get_bucket_alloc(output));
+          APR_BRIGADE_INSERT_TAIL(bb, bkt);
+          serr = dav_svn__output_pass_brigade(output, bb);
+        }
+
+      apr_brigade_destroy(bb);
+      if (serr != NULL)
+        return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
+                                    "could not write the file contents",
+                                    resource->pool);
+
+      return NULL;
+    }
+
   /* resource->info->delta_base is NULL, or we had an invalid base URL */
     {
       svn_stream_t *stream;
       char *block;
-
-      serr = svn_fs_file_contents(&stream,
-                                  resource->info->root.root,
-                                  resource->info->repos_path,
-                                  resource->pool);
+      svn_filesize_t remaining = resource->info->range_length;
+
+      /* set_headers() only selects a range if there is no keyword
+         substitution, so we can start right at the range's offset. */
+      if (remaining > 0)
+        serr = svn_fs_file_contents_at(&stream,
+                                       resource->info->root.root,
+                                       resource->info->repos_path,
+                                       resource->info->range_start,
+                                       resource->pool);
+      else
+        serr = svn_fs_file_contents(&stream,
+                                    resource->info->root.root,
+                                    resource->info->repos_path,
+                                    resource->pool);
       if (serr != NULL)
         {
           return dav_svn__convert_err(serr, HTTP_INTERNAL_SERVER_ERROR,
@@ -4037,6 +4350,15 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
       while (1) {
         apr_size_t bufsize = SVN__STREAM_CHUNK_SIZE;
 
+        /* ... but not beyond the requested range */
+        if (resource->info->range_length > 0)
+          {
+            if (remaining < (svn_filesize_t)bufsize)
+              bufsize = (apr_size_t)remaining;
+            if (bufsize == 0)
+              break;
+          }
+
         /* read from the FS ... */
         serr = svn_stream_read_full(stream, block, &bufsize);
         if (serr != NULL)
@@ -4048,6 +4370,7 @@ deliver(const dav_resource *resource, ap_filter_t *unused)
           }
         if (bufsize == 0)
           break;
+        remaining -= bufsize;
 
         /* write to the filter ... */
         bkt = apr_bucket_transient_create(
@@ -4494,6 +4817,8 @@ do_walk(walker_ctx_t *ctx,
   apr_size_t repos_len;
   apr_hash_t *children;
   apr_pool_t *iterpool;
+  svn_boolean_t *allowed = NULL;
+  int i;
 
   /* The current resource is a collection (possibly here thru recursion)
      and this is the invocation for the collection. Alternatively, this is
@@ -4568,9 +4893,32 @@ do_walk(walker_ctx_t *ctx,
                                 "could not fetch collection members",
                                 params->pool);
 
+  /* authorize access to all children at once, if applicable.  The
+     iteration order of CHILDREN does not change as long as we don't
+     modify it, so ALLOWED lines up with the loop below. */
+  if (params->walk_type & DAV_WALKTYPE_AUTH)
+    {
+      apr_array_header_t *paths
+        = apr_array_make(scratch_pool, apr_hash_count(children),
+                         sizeof(const char *));
+
+      for (hi = apr_hash_first(scratch_pool, children);
+           hi;
+           hi = apr_hash_next(hi))
+        APR_ARRAY_PUSH(paths, const char *)
+          = apr_pstrcat(scratch_pool, ctx->repos_path->data,
+                        apr_hash_this_key(hi), SVN_VA_NULL);
+
+      allowed = apr_palloc(scratch_pool, paths->nelts * sizeof(*allowed));
+      dav_svn__allow_read_bulk(ctx->info.r, ctx->info.repos, paths,
+                               ctx->info.root.rev, allowed, scratch_pool);
+    }
+
   /* iterate over the children in this collection */
   iterpool = svn_pool_create(scratch_pool);
-  for (hi = apr_hash_first(scratch_pool, children); hi; hi = apr_hash_next(hi))
+  for (hi = apr_hash_first(scratch_pool, children), i = 0;
+       hi;
+       hi = apr_hash_next(hi), ++i)
     {
       const void *key;
       apr_ssize_t klen;
@@ -4583,20 +4931,9 @@ do_walk(walker_ctx_t *ctx,
       apr_hash_this(hi, &key, &klen, &val);
       dirent = val;
 
-      /* authorize access to this resource, if applicable */
-      if (params->walk_type & DAV_WALKTYPE_AUTH)
-        {
-          const char *repos_relpath =
-            apr_pstrcat(iterpool,
-                        apr_pstrmemdup(iterpool,
-                                       ctx->repos_path->data,
-                                       ctx->repos_path->len),
-                        key, SVN_VA_NULL);
-          if (! dav_svn__allow_read(ctx->info.r, ctx->info.repos,
-                                    repos_relpath, ctx->info.root.rev,
-                                    iterpool))
-            continue;
-        }
+      /* skip the children we may not access */
+      if (allowed && ! allowed[i])
+        continue;
 
       /* append this child to our buffers */
       svn_stringbuf_appendbytes(ctx->info.uri_path, key, klen);
@@ -72,6 +72,7 @@ int dav_svn__status(request_rec *r)
   svn_cache__info_t *info;
   svn_string_t *text_stats;
   apr_array_header_t *lines;
+  apr_array_header_t *prefix_infos;
   int i;
 
   if (r->method_number != M_GET || strcmp(r->handler, "svn-status"))
@@ -113,7 +114,31 @@ int dav_svn__status(request_rec *r)
       ap_rvputs(r, "<dt>", line, "</dt>\n", SVN_VA_NULL);
     }
 
-  ap_rvputs(r, "</dl></body></html>\n", SVN_VA_NULL);
+  /* Break the totals down by cache, i.e. by key prefix. */
+  ap_rvputs(r, "</dl>\n<h2>Statistics per Cache</h2>\n", SVN_VA_NULL);
+
+  prefix_infos = svn_cache__membuffer_get_prefix_info(
+                   svn_cache__get_global_membuffer_cache(), r->pool);
+  for (i = 0; i < prefix_infos->nelts; ++i)
+    {
+      const svn_cache__info_t *prefix_info
+        = APR_ARRAY_IDX(prefix_infos, i, const svn_cache__info_t *);
+      int k;
+
+      text_stats = svn_cache__format_info(prefix_info, FALSE, r->pool);
+      lines = svn_cstring_split(text_stats->data, "\n", FALSE, r->pool);
+
+      ap_rvputs(r, "<dl>\n", SVN_VA_NULL);
+      for (k = 0; k < lines->nelts; ++k)
+        {
+          const char *line = APR_ARRAY_IDX(lines, k, const char *);
+          ap_rvputs(r, k ? "<dd>" : "<dt>", ap_escape_html(r->pool, line),
+                    k ? "</dd>\n" : "</dt>\n", SVN_VA_NULL);
+        }
+      ap_rvputs(r, "</dl>\n", SVN_VA_NULL);
+    }
+
+  ap_rvputs(r, "</body></html>\n", SVN_VA_NULL);
 
   return 0;
 }
@@ -38,10 +38,12 @@
 #include "svn_dav.h"
 #include "svn_base64.h"
 #include "svn_ctype.h"
+#include "svn_sorts.h"
 
 #include "dav_svn.h"
 #include "private/svn_fspath.h"
 #include "private/svn_string_private.h"
+#include "private/svn_subr_private.h"
 
 dav_error *
 dav_svn__new_error(apr_pool_t *pool,
@@ -506,7 +508,7 @@ dav_svn__output_pass_brigade(dav_svn__output *output,
      appear to return useful errors when the connection is dropped. */
   if (output->r->connection->aborted)
     return svn_error_create(SVN_ERR_APMOD_CONNECTION_ABORTED, NULL, NULL);
-  return SVN_NO_ERROR;
+  return svn_error_trace(svn_pool__check_memory_budget());
 }
 
 
@@ -528,7 +530,7 @@ dav_svn__brigade_write(apr_bucket_brigade *bb,
      appear to return useful errors when the connection is dropped. */
   if (output->r->connection->aborted)
     return svn_error_create(SVN_ERR_APMOD_CONNECTION_ABORTED, 0, NULL);
-  return SVN_NO_ERROR;
+  return svn_error_trace(svn_pool__check_memory_budget());
 }
 
 
@@ -546,7 +548,7 @@ dav_svn__brigade_puts(apr_bucket_brigade *bb,
      appear to return useful errors when the connection is dropped. */
   if (output->r->connection->aborted)
     return svn_error_create(SVN_ERR_APMOD_CONNECTION_ABORTED, 0, NULL);
-  return SVN_NO_ERROR;
+  return svn_error_trace(svn_pool__check_memory_budget());
 }
 
 
@@ -569,7 +571,7 @@ dav_svn__brigade_printf(apr_bucket_brigade *bb,
      appear to return useful errors when the connection is dropped. */
   if (output->r->connection->aborted)
     return svn_error_create(SVN_ERR_APMOD_CONNECTION_ABORTED, 0, NULL);
-  return SVN_NO_ERROR;
+  return svn_error_trace(svn_pool__check_memory_budget());
 }
 
 
@@ -591,7 +593,7 @@ dav_svn__brigade_putstrs(apr_bucket_brigade *bb,
      appear to return useful errors when the connection is dropped. */
   if (output->r->connection->aborted)
     return svn_error_create(SVN_ERR_APMOD_CONNECTION_ABORTED, NULL, NULL);
-  return SVN_NO_ERROR;
+  return svn_error_trace(svn_pool__check_memory_budget());
 }
 
 
@@ -673,7 +675,7 @@ brigade_write_fn(void *baton, const char *data, apr_size_t *len)
   if (apr_err != APR_SUCCESS)
     return svn_error_wrap_apr(apr_err, "Error writing base64 data");
 
-  return SVN_NO_ERROR;
+  return svn_error_trace(svn_pool__check_memory_budget());
 }
 
 
@@ -692,6 +694,51 @@ dav_svn__make_base64_output_stream(apr_bucket_brigade *bb,
   return svn_base64_encode2(stream, FALSE, pool);
 }
 
+
+/* This implements 'svn_write_fn_t'. */
+static svn_error_t *
+binary_frame_write_fn(void *baton, const char *data, apr_size_t *len)
+{
+  apr_size_t remaining = *len;
+
+  while (remaining > 0)
+    {
+      apr_size_t chunk = MIN(remaining, 0x7FFFFFFF);
+      apr_size_t header_len = 5;
+      char header[5];
+
+      header[0] = '\0';
+      header[1] = (char)((chunk >> 24) & 0xFF);
+      header[2] = (char)((chunk >> 16) & 0xFF);
+      header[3] = (char)((chunk >> 8) & 0xFF);
+      header[4] = (char)(chunk & 0xFF);
+
+      SVN_ERR(brigade_write_fn(baton, header, &header_len));
+      SVN_ERR(brigade_write_fn(baton, data, &chunk));
+
+      data += chunk;
+      remaining -= chunk;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+
+svn_stream_t *
+dav_svn__make_binary_output_stream(apr_bucket_brigade *bb,
+                                   dav_svn__output *output,
+                                   apr_pool_t *pool)
+{
+  struct brigade_write_baton *wb = apr_palloc(pool, sizeof(*wb));
+  svn_stream_t *stream = svn_stream_create(wb, pool);
+
+  wb->bb = bb;
+  wb->output = output;
+  svn_stream_set_write(stream, binary_frame_write_fn);
+
+  return stream;
+}
+
 void
 dav_svn__operational_log(struct dav_resource_private *info, const char *line)
 {
@@ -700,6 +747,67 @@ dav_svn__operational_log(struct dav_resource_private *info, const char *line)
                 svn_path_uri_encode(info->repos->fs_path, info->r->pool));
   apr_table_set(info->r->subprocess_env, "SVN-REPOS-NAME",
                 svn_path_uri_encode(info->repos->repo_basename, info->r->pool));
+
+  /* The I/O summary can only be given once the request has been handled. */
+  apr_pool_userdata_setn(info->repos, DAV_SVN__IO_STATS_REPOS, NULL,
+                         info->r->pool);
+}
+
+int
+dav_svn__log_io_stats(request_rec *r)
+{
+  void *data = NULL;
+  dav_svn_repos *repos;
+  svn_fs_io_stats_t *stats;
+  const svn_fs_io_stats_t *base;
+  apr_uint64_t rss, peak_rss;
+  svn_error_t *err;
+
+  apr_pool_userdata_get(&data, DAV_SVN__IO_STATS_REPOS, r->pool);
+  repos = data;
+  if (repos == NULL || repos->fs == NULL || repos->io_stats_base == NULL)
+    return DECLINED;
+
+  err = svn_fs_get_io_stats(&stats, repos->fs, r->pool);
+  if (err)
+    {
+      svn_error_clear(err);
+      return DECLINED;
+    }
+
+  base = repos->io_stats_base;
+  apr_table_set(r->subprocess_env, "SVN-IO",
+                apr_psprintf(r->pool,
+                             "files=%" APR_UINT64_T_FMT
+                             " index=%" APR_UINT64_T_FMT
+                             " items=%" APR_UINT64_T_FMT
+                             " bytes=%" APR_UINT64_T_FMT
+                             " decompressed=%" APR_UINT64_T_FMT
+                             " cache-gets=%" APR_UINT64_T_FMT
+                             " cache-hits=%" APR_UINT64_T_FMT,
+                             stats->files_opened - base->files_opened,
+                             stats->index_lookups - base->index_lookups,
+                             stats->items_read - base->items_read,
+                             stats->bytes_read - base->bytes_read,
+                             stats->bytes_decompressed
+                               - base->bytes_decompressed,
+                             stats->cache_gets - base->cache_gets,
+                             stats->cache_hits - base->cache_hits));
+
+  /* Other requests may be served concurrently by the same process, so
+     the growth is only an indication of what this one needed. */
+  svn_pool__memory_usage(&rss, &peak_rss);
+  apr_table_set(r->subprocess_env, "SVN-MEM",
+                apr_psprintf(r->pool,
+                             "rss=%" APR_UINT64_T_FMT
+                             " peak=%" APR_UINT64_T_FMT
+                             " growth=%" APR_UINT64_T_FMT,
+                             rss / 1024, peak_rss / 1024,
+                             rss > repos->rss_base
+                               ? (rss - repos->rss_base) / 1024
+                               : 0));
+
+  return DECLINED;
 }
 
 
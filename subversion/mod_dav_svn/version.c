@@ -44,6 +44,7 @@
 #include "private/svn_dav_protocol.h"
 #include "private/svn_log.h"
 #include "private/svn_fspath.h"
+#include "private/svn_probes.h"
 
 #include "dav_svn.h"
 
@@ -153,6 +154,10 @@ get_vsn_options(apr_pool_t *p, apr_text_header *phdr)
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_INLINE_PROPS);
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_REVERSE_FILE_REVS);
   apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_LIST);
+  apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_LIST_INLINE_CONTENTS);
+  apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_LIST_DIRS);
+  apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_BLAME);
+  apr_text_append(p, phdr, SVN_DAV_NS_DAV_SVN_MULTIPLEXED_FETCHES);
   /* Mergeinfo is a special case: here we merely say that the server
    * knows how to handle mergeinfo -- whether the repository does too
    * is a separate matter.
@@ -370,6 +375,13 @@ get_option(const dav_resource *resource,
                      apr_pstrdup(r->pool, capabilities[i].capability_name));
     }
 
+  /* Svndiff3 support depends on whether we have been built with
+     Zstandard, so it can't be part of the static table above. */
+  if (svn_zstd__is_available()
+      && (!master_version
+          || svn_version__at_least(master_version, 1, 15, 0)))
+    apr_table_addn(r->headers_out, "DAV", SVN_DAV_NS_DAV_SVN_SVNDIFF3);
+
   return NULL;
 }
 
@@ -1116,11 +1128,10 @@ report_label_header_allowed(const apr_xml_doc *doc)
 }
 
 
+/* Run the report requested in DOC against RESOURCE. */
 static dav_error *
-deliver_report(request_rec *r,
-               const dav_resource *resource,
-               const apr_xml_doc *doc,
-               ap_filter_t *unused)
+dispatch_report(const dav_resource *resource,
+                const apr_xml_doc *doc)
 {
   int ns = dav_svn__find_ns(doc->namespaces, SVN_XML_NAMESPACE);
 
@@ -1180,6 +1191,10 @@ deliver_report(request_rec *r,
         {
           return dav_svn__list_report(resource, doc, output);
         }
+      else if (strcmp(doc->root->name, "blame-report") == 0)
+        {
+          return dav_svn__blame_report(resource, doc, output);
+        }
       /* NOTE: if you add a report, don't forget to add it to the
        *       dav_svn__reports_list[] array.
        */
@@ -1192,6 +1207,23 @@ deliver_report(request_rec *r,
 }
 
 
+static dav_error *
+deliver_report(request_rec *r,
+               const dav_resource *resource,
+               const apr_xml_doc *doc,
+               ap_filter_t *unused)
+{
+  dav_error *derr;
+
+  SVN_PROBE1(dav__report__start, doc->root->name);
+  derr = dispatch_report(resource, doc);
+  SVN_PROBE3(dav__report__done, doc->root->name, r->bytes_sent,
+             derr != NULL);
+
+  return derr;
+}
+
+
 static int
 can_be_activity(const dav_resource *resource)
 {
@@ -377,7 +377,9 @@ typedef enum svn_cl__longopt_t {
   opt_drop,
   opt_viewspec,
   opt_compatible_version,
-  opt_store_pristine
+  opt_store_pristine,
+  opt_profile,
+  opt_trace_file
 } svn_cl__longopt_t;
 
 /* Options for giving a log message.  (Some of these also have other uses.)
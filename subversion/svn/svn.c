@@ -56,6 +56,8 @@
 #include "shelf-cmd.h"
 
 #include "private/svn_opt_private.h"
+#include "private/svn_profile.h"
+#include "private/svn_trace.h"
 #include "private/svn_cmdline_private.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_utf_private.h"
@@ -140,7 +142,9 @@ const apr_getopt_option_t svn_cl__options[] =
                        "                             "
                        "  -U ARG, --context ARG: Show ARG lines of context\n"
                        "                             "
-                       "  -p, --show-c-function: Show C function name")},
+                       "  -p, --show-c-function: Show C function name\n"
+                       "                             "
+                       "  --histogram: Use the histogram diff algorithm")},
   {"targets",       opt_targets, 1,
                     N_("pass contents of file ARG as additional args")},
   {"depth",         opt_depth, 1,
@@ -382,6 +386,13 @@ const apr_getopt_option_t svn_cl__options[] =
                        "                             "
                        "commands such as diff or revert. Default: 'yes'.")},
 
+  {"profile", opt_profile, 0,
+                       N_("print where the time went to stderr on exit")},
+  {"trace-file", opt_trace_file, 1,
+                       N_("append spans of this operation to ARG, and\n"
+                       "                             "
+                       "ask the server to continue the trace")},
+
   /* Long-opt Aliases
    *
    * These have NULL descriptions, but an option code that matches some
@@ -416,7 +427,7 @@ const int svn_cl__global_options[] =
   opt_no_auth_cache, opt_non_interactive,
   opt_force_interactive, opt_trust_server_cert,
   opt_trust_server_cert_failures,
-  opt_config_dir, opt_config_options, 0
+  opt_config_dir, opt_config_options, opt_profile, opt_trace_file, 0
 };
 
 static const svn_opt_subcommand_desc3_t
@@ -2838,6 +2849,15 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
                                      "Supported values: %s"),
                                    utf8_opt_arg, "--store-pristine", "yes, no");
         break;
+      case opt_profile:
+        SVN_ERR(svn_profile__enable());
+        break;
+      case opt_trace_file:
+        SVN_ERR(svn_utf_cstring_to_utf8(&utf8_opt_arg, opt_arg, pool));
+        SVN_ERR(svn_trace__enable(svn_dirent_internal_style(utf8_opt_arg,
+                                                            pool),
+                                  pool));
+        break;
       default:
         /* Hmmm. Perhaps this would be a good place to squirrel away
            opts that commands like svn diff might need. Hmmm indeed. */
@@ -3507,6 +3527,17 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Write the profile gathered by --profile to stderr.  Use POOL for
+ * temporary allocations. */
+static svn_error_t *
+print_profile(apr_pool_t *pool)
+{
+  svn_stream_t *err_stream;
+
+  SVN_ERR(svn_stream_for_stderr(&err_stream, pool));
+  return svn_error_trace(svn_profile__print(err_stream, pool));
+}
+
 int
 main(int argc, const char *argv[])
 {
@@ -3529,6 +3560,9 @@ main(int argc, const char *argv[])
      but this makes sure that output is not silently lost if it fails. */
   err = svn_error_compose_create(err, svn_cmdline_fflush(stdout));
 
+  if (svn_profile__enabled())
+    err = svn_error_compose_create(err, print_profile(pool));
+
   if (err)
     {
       exit_code = EXIT_FAILURE;
@@ -51,6 +51,7 @@
 #include "private/svn_cmdline_private.h"
 #include "private/svn_fspath.h"
 #include "private/svn_fs_fs_private.h"
+#include "private/svn_repos_private.h"
 
 #include "svn_private_config.h"
 
@@ -97,6 +98,7 @@ check_lib_versions(void)
 /** Subcommands. **/
 
 static svn_opt_subcommand_t
+  subcommand_build_path_index,
   subcommand_build_repcache,
   subcommand_crashtest,
   subcommand_create,
@@ -159,7 +161,11 @@ enum svnadmin__cmdline_options_t
     svnadmin__normalize_props,
     svnadmin__exclude,
     svnadmin__include,
-    svnadmin__glob
+    svnadmin__glob,
+    svnadmin__jobs,
+    svnadmin__checkpoint,
+    svnadmin__resume,
+    svnadmin__split_every
   };
 
 /* Option codes and descriptions.
@@ -298,6 +304,19 @@ static const apr_getopt_option_t options_table[] =
         "                             Character '/' is not treated specially, so\n"
         "                             pattern /*/foo matches paths /a/foo and /a/b/foo.") },
 
+    {"jobs",          svnadmin__jobs, 1,
+     N_("use up to ARG worker threads (default: 1)")},
+
+    {"checkpoint",    svnadmin__checkpoint, 0,
+     N_("record verified revisions in the repository and\n"
+        "                             skip those that did not change since")},
+
+    {"resume",        svnadmin__resume, 0,
+     N_("continue an interrupted 'verify --checkpoint'")},
+
+    {"split-every",   svnadmin__split_every, 1,
+     N_("start a new output file after every ARG revisions")},
+
     {NULL}
   };
 
@@ -307,6 +326,17 @@ static const apr_getopt_option_t options_table[] =
  */
 static const svn_opt_subcommand_desc3_t cmd_table[] =
 {
+  {"build-path-index", subcommand_build_path_index, {0}, {N_(
+    "usage: svnadmin build-path-index REPOS_PATH\n"
+    "\n"), N_(
+    "Create or update the path index of the repository at REPOS_PATH.\n"
+    "Once created, every commit updates the index.  It lets searches for\n"
+    "name patterns in the youngest revision, like 'svn list --search',\n"
+    "run without walking the whole tree.  Delete the 'path-index' file\n"
+    "in REPOS_PATH to drop the index.\n"
+   )},
+   {0} },
+
   {"build-repcache", subcommand_build_repcache, {0}, {N_(
     "usage: svnadmin build-repcache REPOS_PATH [-r LOWER[:UPPER]]\n"
     "\n"), N_(
@@ -314,8 +344,13 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "at REPOS_PATH. Process data in revisions LOWER through UPPER.\n"
     "If no revision arguments are given, process all revisions. If only\n"
     "LOWER revision argument is given, process only that single revision.\n"
+    "\n"
+    "With --incremental, skip the revisions up to the youngest one that\n"
+    "already has entries in the representation cache.\n"
+    "\n"
+    "With --jobs, read up to ARG shards concurrently.\n"
    )},
-   {'r', 'q', 'M'} },
+   {'r', 'q', 'M', svnadmin__incremental, svnadmin__jobs} },
 
   {"crashtest", subcommand_crashtest, {0}, {N_(
     "usage: svnadmin crashtest REPOS_PATH\n"
@@ -382,9 +417,18 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "Using --exclude or --include gives results equivalent to authz-based\n"
     "path exclusions. In particular, when the source of a copy is\n"
     "excluded, the copy is transformed into an add (unlike in 'svndumpfilter').\n"
+    "\n"), N_(
+    "With --jobs, up to ARG revisions get prepared in parallel.  The output\n"
+    "is the same as without that option.\n"
+    "\n"), N_(
+    "With --split-every N, the dump gets written to a series of complete\n"
+    "dumpfiles of N revisions each, named after the -F option's ARG and the\n"
+    "first revision they contain, e.g. 'ARG.0000000100'.  Loading them in\n"
+    "the order of their names is equivalent to loading the whole dump.\n"
    )},
   {'r', svnadmin__incremental, svnadmin__deltas, 'q', 'M', 'F',
-   svnadmin__exclude, svnadmin__include, svnadmin__glob },
+   svnadmin__exclude, svnadmin__include, svnadmin__glob, svnadmin__jobs,
+   svnadmin__split_every },
   {{'F', N_("write to file ARG instead of stdout")}} },
 
   {"dump-revprops", subcommand_dump_revprops, {0}, {N_(
@@ -429,8 +473,10 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "Make a hot copy of a repository.\n"
     "If --incremental is passed, data which already exists at the destination\n"
     "is not copied again.  Incremental mode is implemented for FSFS repositories.\n"
+    "If --jobs is passed, FSFS and FSX repositories will copy multiple shards\n"
+    "concurrently.\n"
    )},
-   {svnadmin__clean_logs, svnadmin__incremental, 'q'} },
+   {svnadmin__clean_logs, svnadmin__incremental, 'q', svnadmin__jobs} },
 
   {"info", subcommand_info, {0}, {N_(
     "usage: svnadmin info REPOS_PATH\n"
@@ -471,7 +517,7 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     svnadmin__use_pre_commit_hook, svnadmin__use_post_commit_hook,
     svnadmin__parent_dir, svnadmin__normalize_props,
     svnadmin__bypass_prop_validation, 'M',
-    svnadmin__no_flush_to_disk, 'F'},
+    svnadmin__no_flush_to_disk, 'F', svnadmin__jobs},
    {{'F', N_("read from file ARG instead of stdin")}} },
 
   {"load-revprops", subcommand_load_revprops, {0}, {N_(
@@ -521,7 +567,7 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "Possibly compact the repository into a more efficient storage model.\n"
     "This may not apply to all repositories, in which case, exit.\n"
    )},
-   {'q', 'M'} },
+   {'q', 'M', svnadmin__jobs} },
 
   {"recover", subcommand_recover, {0}, {N_(
     "usage: svnadmin recover REPOS_PATH\n"
@@ -632,9 +678,16 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
     "usage: svnadmin verify REPOS_PATH\n"
     "\n"), N_(
     "Verify the data stored in the repository.\n"
+   ), N_(
+    "With --checkpoint, record the verified revisions together with a\n"
+    "fingerprint of the files they are stored in.  Later runs with\n"
+    "--checkpoint will skip revisions whose files did not change since.\n"
+    "If such a run gets interrupted, --resume continues it for the\n"
+    "revision range that it was started with.\n"
    )},
    {'t', 'r', 'q', svnadmin__keep_going, 'M',
-    svnadmin__check_normalization, svnadmin__metadata_only} },
+    svnadmin__check_normalization, svnadmin__metadata_only,
+    svnadmin__jobs, svnadmin__checkpoint, svnadmin__resume} },
 
   { NULL, NULL, {0}, {NULL}, {0} }
 };
@@ -677,6 +730,10 @@ struct svnadmin_opt_state
   apr_array_header_t *exclude;                      /* --exclude */
   apr_array_header_t *include;                      /* --include */
   svn_boolean_t glob;                               /* --pattern */
+  int jobs;                                         /* --jobs */
+  svn_boolean_t checkpoint;                         /* --checkpoint */
+  svn_boolean_t resume;                             /* --resume */
+  svn_revnum_t split_every;                         /* --split-every */
 
   const char *config_dir;    /* Overriding Configuration Directory */
 };
@@ -1019,7 +1076,7 @@ struct repos_verify_callback_baton
 };
 
 /* Implementation of svn_repos_verify_callback_t to handle errors coming
-   from svn_repos_verify_fs3(). */
+   from svn_repos_verify_fs4(). */
 static svn_error_t *
 repos_verify_callback(void *baton,
                       svn_revnum_t revision,
@@ -1425,6 +1482,119 @@ dump_filter_func(svn_boolean_t *include,
   return SVN_NO_ERROR;
 }
 
+/* Baton for the stream and notification handler that distribute a dump
+   over several files. */
+typedef struct split_baton_t
+{
+  /* Common prefix of the file names. */
+  const char *path;
+
+  /* Revisions per file. */
+  svn_revnum_t split_every;
+
+  /* Headers to write at the start of every file but the first. */
+  int version;
+  const char *uuid;
+
+  /* File currently being written to and the number of revisions completed
+     in it.  FILE_STREAM is NULL until the first data of the next file
+     arrives. */
+  svn_stream_t *file_stream;
+  svn_revnum_t revisions;
+
+  /* First revision of the next file and whether it is the first file. */
+  svn_revnum_t next_rev;
+  svn_boolean_t first_file;
+
+  /* Progress feedback or NULL. */
+  svn_stream_t *feedback_stream;
+
+  /* Pool for the current file, cleared whenever that gets closed. */
+  apr_pool_t *file_pool;
+} split_baton_t;
+
+/* Implements svn_write_fn_t.  Write to the current file of the
+   split_baton_t BATON, opening it first if necessary. */
+static svn_error_t *
+split_write(void *baton,
+            const char *data,
+            apr_size_t *len)
+{
+  split_baton_t *b = baton;
+
+  if (! b->file_stream)
+    {
+      const char *path = apr_psprintf(b->file_pool, "%s.%010ld", b->path,
+                                      b->next_rev);
+      apr_file_t *file;
+
+      /* Overwrite existing files, same as for the plain -F option. */
+      SVN_ERR(svn_io_file_open(&file, path,
+                               APR_WRITE | APR_CREATE | APR_TRUNCATE
+                               | APR_BUFFERED, APR_OS_DEFAULT,
+                               b->file_pool));
+      b->file_stream = svn_stream_from_aprfile2(file, FALSE, b->file_pool);
+
+      /* svn_repos_dump_fs5() writes the headers of the first file.
+         Every other file needs its own copy to be loadable. */
+      if (! b->first_file)
+        {
+          SVN_ERR(svn_repos__dump_magic_header_record(b->file_stream,
+                                                      b->version,
+                                                      b->file_pool));
+          SVN_ERR(svn_repos__dump_uuid_header_record(b->file_stream,
+                                                     b->uuid,
+                                                     b->file_pool));
+        }
+
+      b->first_file = FALSE;
+    }
+
+  return svn_error_trace(svn_stream_write(b->file_stream, data, len));
+}
+
+/* Close the current file of B, if any. */
+static svn_error_t *
+split_close_file(split_baton_t *b)
+{
+  if (b->file_stream)
+    SVN_ERR(svn_stream_close(b->file_stream));
+
+  b->file_stream = NULL;
+  b->revisions = 0;
+  svn_pool_clear(b->file_pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_close_fn_t for the split_baton_t BATON. */
+static svn_error_t *
+split_close(void *baton)
+{
+  return svn_error_trace(split_close_file(baton));
+}
+
+/* Implements svn_repos_notify_func_t for the split_baton_t BATON.  Close
+   the current file once it contains the requested number of revisions
+   and pass the notification on to repos_notify_handler(). */
+static void
+split_notify_handler(void *baton,
+                     const svn_repos_notify_t *notify,
+                     apr_pool_t *scratch_pool)
+{
+  split_baton_t *b = baton;
+
+  if (notify->action == svn_repos_notify_dump_rev_end
+      && ++b->revisions == b->split_every)
+    {
+      b->next_rev = notify->revision + 1;
+      svn_error_clear(split_close_file(b));
+    }
+
+  if (b->feedback_stream)
+    repos_notify_handler(b->feedback_stream, notify, scratch_pool);
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_dump(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -1435,15 +1605,53 @@ subcommand_dump(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   svn_revnum_t lower, upper;
   svn_stream_t *feedback_stream = NULL;
   struct dump_filter_baton_t filter_baton = {0};
+  svn_repos_notify_func_t notify_func = NULL;
+  void *notify_baton = NULL;
+  split_baton_t *split_baton = NULL;
 
   /* Expect no more arguments. */
   SVN_ERR(parse_args(NULL, os, 0, 0, pool));
 
+  if (opt_state->split_every && !opt_state->file)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("'--split-every' requires '--file'"));
+
   SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
   SVN_ERR(get_dump_range(&lower, &upper, repos, opt_state, pool));
 
-  /* Open the file or STDOUT, depending on whether -F was specified. */
-  if (opt_state->file)
+  /* Progress feedback goes to STDERR, unless they asked to suppress it. */
+  if (! opt_state->quiet)
+    {
+      feedback_stream = recode_stream_create(stderr, pool);
+      notify_func = repos_notify_handler;
+      notify_baton = feedback_stream;
+    }
+
+  /* Open the file or STDOUT, depending on whether -F was specified.
+     Split dumps open their files on demand. */
+  if (opt_state->split_every)
+    {
+      split_baton = apr_pcalloc(pool, sizeof(*split_baton));
+      split_baton->path = opt_state->file;
+      split_baton->split_every = opt_state->split_every;
+      split_baton->version = SVN_REPOS_DUMPFILE_FORMAT_VERSION;
+      if (! opt_state->use_deltas)
+        split_baton->version--;
+      SVN_ERR(svn_fs_get_uuid(svn_repos_fs(repos), &split_baton->uuid,
+                              pool));
+      split_baton->next_rev = lower;
+      split_baton->first_file = TRUE;
+      split_baton->feedback_stream = feedback_stream;
+      split_baton->file_pool = svn_pool_create(pool);
+
+      out_stream = svn_stream_create(split_baton, pool);
+      svn_stream_set_write(out_stream, split_write);
+      svn_stream_set_close(out_stream, split_close);
+
+      notify_func = split_notify_handler;
+      notify_baton = split_baton;
+    }
+  else if (opt_state->file)
     {
       apr_file_t *file;
 
@@ -1456,10 +1664,6 @@ subcommand_dump(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   else
     SVN_ERR(svn_stream_for_stdout(&out_stream, pool));
 
-  /* Progress feedback goes to STDERR, unless they asked to suppress it. */
-  if (! opt_state->quiet)
-    feedback_stream = recode_stream_create(stderr, pool);
-
   /* Initialize the filter baton. */
   filter_baton.glob = opt_state->glob;
 
@@ -1480,15 +1684,17 @@ subcommand_dump(apr_getopt_t *os, void *baton, apr_pool_t *pool)
                                  "cannot be used simultaneously"));
     }
 
-  SVN_ERR(svn_repos_dump_fs4(repos, out_stream, lower, upper,
+  SVN_ERR(svn_repos_dump_fs5(repos, out_stream, lower, upper,
                              opt_state->incremental, opt_state->use_deltas,
-                             TRUE, TRUE,
-                             !opt_state->quiet ? repos_notify_handler : NULL,
-                             feedback_stream,
+                             TRUE, TRUE, opt_state->jobs,
+                             notify_func, notify_baton,
                              filter_baton.prefixes ? dump_filter_func : NULL,
                              &filter_baton,
                              check_cancel, NULL, pool));
 
+  if (split_baton)
+    SVN_ERR(svn_stream_close(out_stream));
+
   return SVN_NO_ERROR;
 }
 
@@ -1526,8 +1732,8 @@ subcommand_dump_revprops(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   if (! opt_state->quiet)
     feedback_stream = recode_stream_create(stderr, pool);
 
-  SVN_ERR(svn_repos_dump_fs4(repos, out_stream, lower, upper,
-                             FALSE, FALSE, TRUE, FALSE,
+  SVN_ERR(svn_repos_dump_fs5(repos, out_stream, lower, upper,
+                             FALSE, FALSE, TRUE, FALSE, 1,
                              !opt_state->quiet ? repos_notify_handler : NULL,
                              feedback_stream, NULL, NULL,
                              check_cancel, NULL, pool));
@@ -1736,13 +1942,14 @@ subcommand_load(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   if (! opt_state->quiet)
     feedback_stream = recode_stream_create(stdout, pool);
 
-  err = svn_repos_load_fs6(repos, in_stream, lower, upper,
+  err = svn_repos_load_fs7(repos, in_stream, lower, upper,
                            opt_state->uuid_action, opt_state->parent_dir,
                            opt_state->use_pre_commit_hook,
                            opt_state->use_post_commit_hook,
                            !opt_state->bypass_prop_validation,
                            opt_state->ignore_dates,
                            opt_state->normalize_props,
+                           opt_state->jobs,
                            opt_state->quiet ? NULL : repos_notify_handler,
                            feedback_stream, check_cancel, NULL, pool);
 
@@ -2210,11 +2417,372 @@ subcommand_pack(apr_getopt_t *os, void *baton, apr_pool_t *pool)
     feedback_stream = recode_stream_create(stdout, pool);
 
   return svn_error_trace(
-    svn_repos_fs_pack2(repos, !opt_state->quiet ? repos_notify_handler : NULL,
+    svn_repos_fs_pack3(repos, opt_state->jobs,
+                       !opt_state->quiet ? repos_notify_handler : NULL,
                        feedback_stream, check_cancel, NULL, pool));
 }
 
 
+/* Name of the file within the repository's db directory that records
+ * the progress of 'svnadmin verify --checkpoint'. */
+#define VERIFY_CHECKPOINT_FILE "verify-checkpoint"
+
+/* First line of that file. */
+#define VERIFY_CHECKPOINT_FORMAT "SVN-VERIFY-CHECKPOINT 1"
+
+/* A range of revisions stored in the same rev / pack file.  The file
+ * has the given FINGERPRINT. */
+typedef struct verify_unit_t
+{
+  svn_revnum_t start;
+  svn_revnum_t end;
+  const char *fingerprint;
+} verify_unit_t;
+
+/* In-memory representation of the verification checkpoint file. */
+typedef struct verify_checkpoint_t
+{
+  /* Location of the checkpoint file. */
+  const char *path;
+
+  /* The revision range of a verification that has been started but not
+   * completed, yet.  SVN_INVALID_REVNUM if there is none. */
+  svn_revnum_t run_start;
+  svn_revnum_t run_end;
+
+  /* All units that have been verified successfully.
+   * Maps svn_revnum_t start revisions to verify_unit_t *. */
+  apr_hash_t *units;
+
+  /* Pool used for the contents of this structure. */
+  apr_pool_t *pool;
+} verify_checkpoint_t;
+
+/* Parse STR as a revision number into *REV.  Report errors as errors
+ * in checkpoint file PATH.  Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+parse_checkpoint_revnum(svn_revnum_t *rev,
+                        const char *str,
+                        const char *path,
+                        apr_pool_t *scratch_pool)
+{
+  const char *end;
+  svn_error_t *err = svn_revnum_parse(rev, str, &end);
+
+  if (err || *end != '\0')
+    return svn_error_createf(SVN_ERR_BAD_VERSION_FILE_FORMAT, err,
+                             _("Invalid revision number '%s' in '%s'"),
+                             str, svn_dirent_local_style(path, scratch_pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the verification checkpoint file of REPOS into *CHECKPOINT.
+ * A missing file is equivalent to an empty one.  Allocate the result
+ * in RESULT_POOL and use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+read_verify_checkpoint(verify_checkpoint_t **checkpoint,
+                       svn_repos_t *repos,
+                       apr_pool_t *result_pool,
+                       apr_pool_t *scratch_pool)
+{
+  verify_checkpoint_t *cp = apr_pcalloc(result_pool, sizeof(*cp));
+  svn_stringbuf_t *contents;
+  apr_array_header_t *lines;
+  svn_error_t *err;
+  int i;
+
+  cp->path = svn_dirent_join(svn_repos_db_env(repos, scratch_pool),
+                             VERIFY_CHECKPOINT_FILE, result_pool);
+  cp->run_start = SVN_INVALID_REVNUM;
+  cp->run_end = SVN_INVALID_REVNUM;
+  cp->units = apr_hash_make(result_pool);
+  cp->pool = result_pool;
+  *checkpoint = cp;
+
+  err = svn_stringbuf_from_file2(&contents, cp->path, scratch_pool);
+  if (err && APR_STATUS_IS_ENOENT(err->apr_err))
+    {
+      svn_error_clear(err);
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  lines = svn_cstring_split(contents->data, "\n", TRUE, scratch_pool);
+  if (   lines->nelts == 0
+      || strcmp(APR_ARRAY_IDX(lines, 0, const char *),
+                VERIFY_CHECKPOINT_FORMAT))
+    return svn_error_createf(SVN_ERR_BAD_VERSION_FILE_FORMAT, NULL,
+                             _("Unsupported verification checkpoint file "
+                               "'%s'; remove it to start over"),
+                             svn_dirent_local_style(cp->path, scratch_pool));
+
+  for (i = 1; i < lines->nelts; ++i)
+    {
+      const char *line = APR_ARRAY_IDX(lines, i, const char *);
+      apr_array_header_t *fields = svn_cstring_split(line, " ", TRUE,
+                                                     scratch_pool);
+      const char *kind = fields->nelts ? APR_ARRAY_IDX(fields, 0,
+                                                       const char *)
+                                       : "";
+
+      if (strcmp(kind, "run") == 0 && fields->nelts == 3)
+        {
+          SVN_ERR(parse_checkpoint_revnum(&cp->run_start,
+                                          APR_ARRAY_IDX(fields, 1,
+                                                        const char *),
+                                          cp->path, scratch_pool));
+          SVN_ERR(parse_checkpoint_revnum(&cp->run_end,
+                                          APR_ARRAY_IDX(fields, 2,
+                                                        const char *),
+                                          cp->path, scratch_pool));
+        }
+      else if (strcmp(kind, "unit") == 0 && fields->nelts == 4)
+        {
+          verify_unit_t *unit = apr_palloc(result_pool, sizeof(*unit));
+          SVN_ERR(parse_checkpoint_revnum(&unit->start,
+                                          APR_ARRAY_IDX(fields, 1,
+                                                        const char *),
+                                          cp->path, scratch_pool));
+          SVN_ERR(parse_checkpoint_revnum(&unit->end,
+                                          APR_ARRAY_IDX(fields, 2,
+                                                        const char *),
+                                          cp->path, scratch_pool));
+          unit->fingerprint = apr_pstrdup(result_pool,
+                                          APR_ARRAY_IDX(fields, 3,
+                                                        const char *));
+          apr_hash_set(cp->units, &unit->start, sizeof(unit->start), unit);
+        }
+      else
+        {
+          return svn_error_createf(SVN_ERR_BAD_VERSION_FILE_FORMAT, NULL,
+                                   _("Invalid line '%s' in '%s'"), line,
+                                   svn_dirent_local_style(cp->path,
+                                                          scratch_pool));
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Sort function for svn_sort__array, ordering verify_unit_t * by
+ * start revision. */
+static int
+compare_verify_units(const void *lhs,
+                     const void *rhs)
+{
+  const verify_unit_t *lhs_unit = *(const verify_unit_t * const *)lhs;
+  const verify_unit_t *rhs_unit = *(const verify_unit_t * const *)rhs;
+
+  if (lhs_unit->start == rhs_unit->start)
+    return 0;
+
+  return lhs_unit->start < rhs_unit->start ? -1 : 1;
+}
+
+/* Atomically replace the checkpoint file with the contents of CHECKPOINT.
+ * Use SCRATCH_POOL for temporaries. */
+static svn_error_t *
+write_verify_checkpoint(verify_checkpoint_t *checkpoint,
+                        apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *contents
+    = svn_stringbuf_create(VERIFY_CHECKPOINT_FORMAT "\n", scratch_pool);
+  apr_array_header_t *units
+    = apr_array_make(scratch_pool, apr_hash_count(checkpoint->units),
+                     sizeof(verify_unit_t *));
+  apr_hash_index_t *hi;
+  int i;
+
+  if (SVN_IS_VALID_REVNUM(checkpoint->run_start))
+    svn_stringbuf_appendcstr(contents,
+                             apr_psprintf(scratch_pool, "run %ld %ld\n",
+                                          checkpoint->run_start,
+                                          checkpoint->run_end));
+
+  for (hi = apr_hash_first(scratch_pool, checkpoint->units);
+       hi;
+       hi = apr_hash_next(hi))
+    APR_ARRAY_PUSH(units, verify_unit_t *) = apr_hash_this_val(hi);
+  svn_sort__array(units, compare_verify_units);
+
+  for (i = 0; i < units->nelts; ++i)
+    {
+      const verify_unit_t *unit = APR_ARRAY_IDX(units, i, verify_unit_t *);
+      svn_stringbuf_appendcstr(contents,
+                               apr_psprintf(scratch_pool, "unit %ld %ld %s\n",
+                                            unit->start, unit->end,
+                                            unit->fingerprint));
+    }
+
+  return svn_error_trace(svn_io_write_atomic2(checkpoint->path,
+                                              contents->data, contents->len,
+                                              NULL, TRUE, scratch_pool));
+}
+
+/* Set *UNIT to the range of revisions in FS that is stored in the same
+ * file as REVISION, including a fingerprint of that file.  Allocate the
+ * fingerprint in RESULT_POOL and use SCRATCH_POOL for temporaries.
+ *
+ * Backends other than FSFS never modify revisions in place, so there
+ * every revision forms a unit of its own and has a constant fingerprint.
+ */
+static svn_error_t *
+get_verify_unit(verify_unit_t *unit,
+                svn_fs_t *fs,
+                svn_revnum_t revision,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  svn_error_t *err;
+  svn_fs_fs__ioctl_verify_fingerprint_input_t input = {0};
+  svn_fs_fs__ioctl_verify_fingerprint_output_t *output;
+
+  input.revision = revision;
+  err = svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_VERIFY_FINGERPRINT,
+                     &input, (void **)&output,
+                     check_cancel, NULL, result_pool, scratch_pool);
+  if (err && err->apr_err == SVN_ERR_FS_UNRECOGNIZED_IOCTL_CODE)
+    {
+      svn_error_clear(err);
+      unit->start = revision;
+      unit->end = revision;
+      unit->fingerprint = "-";
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  unit->start = output->start_rev;
+  unit->end = output->end_rev;
+  unit->fingerprint = output->fingerprint;
+
+  return SVN_NO_ERROR;
+}
+
+/* Verify revisions LOWER through UPPER in REPOS like svn_repos_verify_fs4
+ * but skip all units recorded in the checkpoint file whose fingerprint
+ * did not change.  Record each fully verified unit in that file.
+ *
+ * If OPT_STATE->RESUME is set, ignore LOWER and UPPER and use the range
+ * of the interrupted run recorded in the checkpoint file instead.
+ *
+ * FEEDBACK_STREAM and VERIFY_BATON are as in subcommand_verify.
+ * Use POOL for allocations.
+ */
+static svn_error_t *
+verify_with_checkpoint(svn_repos_t *repos,
+                       svn_revnum_t lower,
+                       svn_revnum_t upper,
+                       struct svnadmin_opt_state *opt_state,
+                       svn_stream_t *feedback_stream,
+                       struct repos_verify_callback_baton *verify_baton,
+                       apr_pool_t *pool)
+{
+  svn_fs_t *fs = svn_repos_fs(repos);
+  verify_checkpoint_t *checkpoint;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_revnum_t rev;
+
+  SVN_ERR(read_verify_checkpoint(&checkpoint, repos, pool, pool));
+
+  if (opt_state->resume)
+    {
+      if (!SVN_IS_VALID_REVNUM(checkpoint->run_start))
+        return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                _("There is no interrupted verification "
+                                  "to resume"));
+
+      lower = checkpoint->run_start;
+      upper = checkpoint->run_end;
+    }
+  else
+    {
+      if (lower > upper)
+        return svn_error_createf(SVN_ERR_REPOS_BAD_ARGS, NULL,
+                                 _("Start revision %ld"
+                                   " is greater than end revision %ld"),
+                                 lower, upper);
+
+      checkpoint->run_start = lower;
+      checkpoint->run_end = upper;
+      SVN_ERR(write_verify_checkpoint(checkpoint, pool));
+    }
+
+  rev = lower;
+  while (rev <= upper)
+    {
+      verify_unit_t unit;
+      const verify_unit_t *recorded;
+      svn_revnum_t first, last;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(get_verify_unit(&unit, fs, rev, iterpool, iterpool));
+      first = MAX(unit.start, lower);
+      last = MIN(unit.end, upper);
+
+      recorded = apr_hash_get(checkpoint->units, &unit.start,
+                              sizeof(unit.start));
+      if (   recorded
+          && recorded->end == unit.end
+          && strcmp(recorded->fingerprint, unit.fingerprint) == 0)
+        {
+          if (feedback_stream)
+            SVN_ERR(svn_stream_printf(feedback_stream, iterpool,
+                                      _("* Skipped revisions %ld through %ld "
+                                        "(verified before).\n"),
+                                      first, last));
+        }
+      else
+        {
+          int error_count = verify_baton->error_summary->nelts;
+
+          SVN_ERR(svn_repos_verify_fs4(repos, first, last,
+                                       opt_state->check_normalization,
+                                       FALSE,
+                                       opt_state->jobs,
+                                       !opt_state->quiet
+                                         ? repos_notify_handler : NULL,
+                                       feedback_stream,
+                                       repos_verify_callback, verify_baton,
+                                       check_cancel, NULL, pool));
+
+          /* Only record complete units that verified without errors. */
+          if (   error_count == verify_baton->error_summary->nelts
+              && first == unit.start
+              && last == unit.end)
+            {
+              verify_unit_t *done = apr_palloc(checkpoint->pool,
+                                               sizeof(*done));
+              svn_revnum_t i;
+
+              /* Units that this one replaces, e.g. after packing. */
+              for (i = unit.start + 1; i <= unit.end; ++i)
+                apr_hash_set(checkpoint->units, &i, sizeof(i), NULL);
+
+              done->start = unit.start;
+              done->end = unit.end;
+              done->fingerprint = apr_pstrdup(checkpoint->pool,
+                                              unit.fingerprint);
+              apr_hash_set(checkpoint->units, &done->start,
+                           sizeof(done->start), done);
+              SVN_ERR(write_verify_checkpoint(checkpoint, iterpool));
+            }
+        }
+
+      rev = unit.end + 1;
+    }
+
+  /* This run is complete. */
+  checkpoint->run_start = SVN_INVALID_REVNUM;
+  checkpoint->run_end = SVN_INVALID_REVNUM;
+  SVN_ERR(write_verify_checkpoint(checkpoint, iterpool));
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_verify(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -2238,6 +2806,24 @@ subcommand_verify(apr_getopt_t *os, void *baton, apr_pool_t *pool)
                                  "are mutually exclusive"));
     }
 
+  if ((opt_state->checkpoint || opt_state->resume)
+      && (opt_state->txn_id || opt_state->metadata_only))
+    {
+      return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                               _("--checkpoint and --resume cannot be used "
+                                 "together with --transaction (-t) or "
+                                 "--metadata-only"));
+    }
+
+  if (opt_state->resume
+      && (opt_state->start_revision.kind != svn_opt_revision_unspecified
+          || opt_state->end_revision.kind != svn_opt_revision_unspecified))
+    {
+      return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                               _("--revision (-r) and --resume "
+                                 "are mutually exclusive"));
+    }
+
   SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
   fs = svn_repos_fs(repos);
   SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
@@ -2276,14 +2862,30 @@ subcommand_verify(apr_getopt_t *os, void *baton, apr_pool_t *pool)
     apr_array_make(pool, 0, sizeof(struct verification_error *));
   verify_baton.result_pool = pool;
 
-  SVN_ERR(svn_repos_verify_fs3(repos, lower, upper,
-                               opt_state->check_normalization,
-                               opt_state->metadata_only,
-                               !opt_state->quiet
-                                 ? repos_notify_handler : NULL,
-                               feedback_stream,
-                               repos_verify_callback, &verify_baton,
-                               check_cancel, NULL, pool));
+  if (opt_state->checkpoint || opt_state->resume)
+    {
+      /* Checkpoints need explicit revision ranges. */
+      if (lower == SVN_INVALID_REVNUM)
+        {
+          lower = 0;
+          upper = youngest;
+        }
+
+      SVN_ERR(verify_with_checkpoint(repos, lower, upper, opt_state,
+                                     feedback_stream, &verify_baton, pool));
+    }
+  else
+    {
+      SVN_ERR(svn_repos_verify_fs4(repos, lower, upper,
+                                   opt_state->check_normalization,
+                                   opt_state->metadata_only,
+                                   opt_state->jobs,
+                                   !opt_state->quiet
+                                     ? repos_notify_handler : NULL,
+                                   feedback_stream,
+                                   repos_verify_callback, &verify_baton,
+                                   check_cancel, NULL, pool));
+    }
 
   /* Show the --keep-going error summary. */
   if (opt_state->keep_going && verify_baton.error_summary->nelts > 0)
@@ -2376,8 +2978,9 @@ subcommand_hotcopy(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   if (! opt_state->quiet)
     feedback_stream = recode_stream_create(stdout, pool);
 
-  return svn_repos_hotcopy3(opt_state->repository_path, new_repos_path,
+  return svn_repos_hotcopy4(opt_state->repository_path, new_repos_path,
                             opt_state->clean_logs, opt_state->incremental,
+                            opt_state->jobs,
                             !opt_state->quiet ? repos_notify_handler : NULL,
                             feedback_stream, check_cancel, NULL, pool);
 }
@@ -2965,6 +3568,8 @@ build_rep_cache(svn_fs_t *fs,
 
   input.start_rev = start_rev;
   input.end_rev = end_rev;
+  input.jobs = opt_state->jobs;
+  input.incremental = opt_state->incremental;
 
   if (opt_state->quiet)
     {
@@ -3001,6 +3606,23 @@ build_rep_cache(svn_fs_t *fs,
     }
 }
 
+/* This implements `svn_opt_subcommand_t'. */
+static svn_error_t *
+subcommand_build_path_index(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  struct svnadmin_opt_state *opt_state = baton;
+  svn_repos_t *repos;
+
+  /* Expect no more arguments. */
+  SVN_ERR(parse_args(NULL, os, 0, 0, pool));
+
+  SVN_ERR(open_repos(&repos, opt_state->repository_path, opt_state, pool));
+  SVN_ERR(svn_repos__path_index_update(repos, TRUE, check_cancel, NULL,
+                                       pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_build_repcache(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -3085,6 +3707,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   opt_state.start_revision.kind = svn_opt_revision_unspecified;
   opt_state.end_revision.kind = svn_opt_revision_unspecified;
   opt_state.memory_cache_size = svn_cache_config_get()->cache_size;
+  opt_state.jobs = 1;
 
   /* Parse options. */
   SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
@@ -3229,6 +3852,12 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnadmin__metadata_only:
         opt_state.metadata_only = TRUE;
         break;
+      case svnadmin__checkpoint:
+        opt_state.checkpoint = TRUE;
+        break;
+      case svnadmin__resume:
+        opt_state.resume = TRUE;
+        break;
       case svnadmin__fs_type:
         SVN_ERR(svn_utf_cstring_to_utf8(&opt_state.fs_type, opt_arg, pool));
         break;
@@ -3299,6 +3928,35 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       case svnadmin__glob:
         opt_state.glob = TRUE;
         break;
+      case svnadmin__jobs:
+        {
+          err = svn_cstring_atoi(&opt_state.jobs, opt_arg);
+          if (err)
+            {
+              return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                                      _("Non-numeric jobs argument given"));
+            }
+          if (opt_state.jobs <= 0)
+            {
+              return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                      _("Argument to --jobs must be positive"));
+            }
+        }
+        break;
+      case svnadmin__split_every:
+        {
+          apr_int64_t split_every;
+
+          err = svn_cstring_strtoi64(&split_every, opt_arg, 1,
+                                     APR_INT32_MAX, 10);
+          if (err)
+            {
+              return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                                      _("Invalid --split-every argument"));
+            }
+          opt_state.split_every = (svn_revnum_t)split_every;
+        }
+        break;
       default:
         {
           SVN_ERR(subcommand_help(NULL, NULL, pool));
@@ -3426,7 +4084,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     svn_cache_config_t settings = *svn_cache_config_get();
 
     settings.cache_size = opt_state.memory_cache_size;
-    settings.single_threaded = TRUE;
+    settings.single_threaded = opt_state.jobs <= 1;
 
     svn_cache_config_set(&settings);
   }
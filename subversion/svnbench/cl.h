@@ -96,6 +96,10 @@ typedef struct svn_cl__opt_state_t
   svn_boolean_t trust_server_cert_not_yet_valid;
   svn_boolean_t trust_server_cert_other_failure;
   apr_array_header_t* search_patterns; /* pattern arguments for --search */
+  int clients;                   /* concurrent sessions for 'load' */
+  int operations;                /* total operations for 'load' */
+  const char *mix;               /* operation mix profile for 'load' */
+  svn_boolean_t apply_deltas;    /* reconstruct received file contents */
 } svn_cl__opt_state_t;
 
 
@@ -109,11 +113,14 @@ typedef struct svn_cl__cmd_baton_t
 /* Declare all the command procedures */
 svn_opt_subcommand_t
   svn_cl__help,
+  svn_cl__load,
   svn_cl__null_blame,
+  svn_cl__null_checkout,
   svn_cl__null_export,
   svn_cl__null_list,
   svn_cl__null_log,
-  svn_cl__null_info;
+  svn_cl__null_info,
+  svn_cl__null_update;
 
 
 /* See definition in main.c for documentation. */
@@ -0,0 +1,608 @@
+/*
+ * load-cmd.c -- Put load on a repository server with concurrent sessions.
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include <stdlib.h>
+
+#include <apr_thread_proc.h>
+
+#include "svn_cmdline.h"
+#include "svn_client.h"
+#include "svn_config.h"
+#include "svn_delta.h"
+#include "svn_error.h"
+#include "svn_hash.h"
+#include "svn_path.h"
+#include "svn_pools.h"
+#include "svn_ra.h"
+#include "svn_string.h"
+#include "svn_time.h"
+
+#include "cl.h"
+
+#include "svn_private_config.h"
+#include "private/svn_atomic.h"
+#include "private/svn_string_private.h"
+
+
+/*** Code. ***/
+
+/* The operations that we can simulate. */
+typedef enum load_op_t
+{
+  load_op_update,
+  load_op_checkout,
+  load_op_log,
+  load_op_list,
+  load_op_cat,
+  load_op_info,
+
+  /* Number of operation kinds. */
+  load_op_count
+} load_op_t;
+
+/* Names of the operations in the --mix profile and in the report. */
+static const char * const op_names[load_op_count] =
+  { "update", "checkout", "log", "list", "cat", "info" };
+
+/* Operation mix used if none has been given. */
+#define DEFAULT_MIX "update=4,log=2,list=2,cat=4,info=2"
+
+/* Operations to run if no number has been given. */
+#define DEFAULT_OPERATIONS 100
+
+/* Sessions to run if no number has been given. */
+#define DEFAULT_CLIENTS 4
+
+/* Number of log entries to fetch if no --limit has been given. */
+#define DEFAULT_LOG_LIMIT 100
+
+/* Settings and progress shared by all simulated clients. */
+typedef struct load_baton_t
+{
+  /* Repository URL and revision to run the operations against. */
+  const char *url;
+  svn_revnum_t revision;
+
+  /* Files directly below URL, to pick from for 'cat'. */
+  apr_array_header_t *files;
+
+  /* Relative weights of the operations and their sum. */
+  int weights[load_op_count];
+  int total_weight;
+
+  /* Number of log entries per 'log' operation. */
+  int log_limit;
+
+  /* Number of operations to run in total and of those started so far. */
+  int operations;
+  volatile svn_atomic_t started;
+
+  /* Used to create per-client contexts. */
+  svn_cl__opt_state_t *opt_state;
+  svn_client_ctx_t *ctx;
+} load_baton_t;
+
+/* State and results of a single simulated client. */
+typedef struct client_baton_t
+{
+  load_baton_t *load;
+
+  /* Seed of our pseudo-random operation selection. */
+  apr_uint32_t seed;
+
+  /* Latencies of all successful operations, in microseconds, as arrays
+     of apr_interval_time_t per operation kind. */
+  apr_array_header_t *latencies[load_op_count];
+
+  /* Number of failed operations per operation kind. */
+  int errors[load_op_count];
+
+  /* Error that made the client stop early, e.g. cancellation. */
+  svn_error_t *err;
+
+  /* Everything above gets allocated in this root pool. */
+  apr_pool_t *pool;
+} client_baton_t;
+
+/* Parse the operation mix PROFILE of the form "OP[=WEIGHT],..." into LB.
+ * Use SCRATCH_POOL for temporary allocations. */
+static svn_error_t *
+parse_mix(load_baton_t *lb,
+          const char *profile,
+          apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *items = svn_cstring_split(profile, ",", TRUE,
+                                                scratch_pool);
+  int i;
+
+  for (i = 0; i < items->nelts; ++i)
+    {
+      char *item = apr_pstrdup(scratch_pool,
+                               APR_ARRAY_IDX(items, i, const char *));
+      char *value = strchr(item, '=');
+      int weight = 1;
+      int k;
+
+      if (value)
+        {
+          *value = '\0';
+          SVN_ERR(svn_cstring_atoi(&weight, value + 1));
+          if (weight < 0)
+            return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                     _("Negative weight for '%s'"), item);
+        }
+
+      for (k = 0; k < load_op_count; ++k)
+        if (strcmp(item, op_names[k]) == 0)
+          break;
+
+      if (k == load_op_count)
+        return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                 _("Unknown operation '%s' in --mix"), item);
+
+      lb->weights[k] += weight;
+      lb->total_weight += weight;
+    }
+
+  if (lb->total_weight <= 0)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("The --mix profile selects no operations"));
+
+  return SVN_NO_ERROR;
+}
+
+/* Return the next operation for CB to run. */
+static load_op_t
+next_op(client_baton_t *cb)
+{
+  int value;
+  int k;
+
+  cb->seed = cb->seed * 1103515245 + 12345;
+  value = (int)((cb->seed >> 8) % (apr_uint32_t)cb->load->total_weight);
+
+  for (k = 0; value >= cb->load->weights[k]; ++k)
+    value -= cb->load->weights[k];
+
+  return k;
+}
+
+/* Implements svn_log_entry_receiver_t.  Discards all log entries. */
+static svn_error_t *
+null_log_receiver(void *baton,
+                  svn_log_entry_t *log_entry,
+                  apr_pool_t *pool)
+{
+  return SVN_NO_ERROR;
+}
+
+/* Run a report for an update of "" to LB->REVISION over SESSION and send
+ * the response to a null editor.  If START_EMPTY is set, report an empty
+ * working copy, i.e. do a checkout.  Otherwise, report it as being one
+ * revision behind.  Use POOL for allocations. */
+static svn_error_t *
+run_update(svn_ra_session_t *session,
+           load_baton_t *lb,
+           svn_boolean_t start_empty,
+           apr_pool_t *pool)
+{
+  const svn_ra_reporter3_t *reporter;
+  void *report_baton;
+  svn_revnum_t base_rev = lb->revision > 0 && !start_empty
+                        ? lb->revision - 1
+                        : lb->revision;
+
+  SVN_ERR(svn_ra_do_update3(session, &reporter, &report_baton,
+                            lb->revision, "", svn_depth_infinity,
+                            FALSE, FALSE,
+                            svn_delta_default_editor(pool), NULL,
+                            pool, pool));
+  SVN_ERR(reporter->set_path(report_baton, "", base_rev,
+                             svn_depth_infinity, start_empty, NULL, pool));
+
+  return svn_error_trace(reporter->finish_report(report_baton, pool));
+}
+
+/* Run operation OP for client CB over SESSION.  Use POOL for
+ * allocations. */
+static svn_error_t *
+run_op(svn_ra_session_t *session,
+       client_baton_t *cb,
+       load_op_t op,
+       apr_pool_t *pool)
+{
+  load_baton_t *lb = cb->load;
+  apr_hash_t *dirents;
+  svn_dirent_t *dirent;
+  const char *file;
+
+  switch (op)
+    {
+      case load_op_update:
+        return svn_error_trace(run_update(session, lb, FALSE, pool));
+
+      case load_op_checkout:
+        return svn_error_trace(run_update(session, lb, TRUE, pool));
+
+      case load_op_log:
+        return svn_error_trace(svn_ra_get_log2(session, NULL, lb->revision,
+                                               0, lb->log_limit, TRUE,
+                                               FALSE, FALSE, NULL,
+                                               null_log_receiver, NULL,
+                                               pool));
+
+      case load_op_list:
+        return svn_error_trace(svn_ra_get_dir2(session, &dirents, NULL,
+                                               NULL, "", lb->revision,
+                                               SVN_DIRENT_ALL, pool));
+
+      case load_op_cat:
+        cb->seed = cb->seed * 1103515245 + 12345;
+        file = APR_ARRAY_IDX(lb->files,
+                             (cb->seed >> 8) % lb->files->nelts,
+                             const char *);
+        return svn_error_trace(svn_ra_get_file(session, file, lb->revision,
+                                               svn_stream_empty(pool),
+                                               NULL, NULL, pool));
+
+      case load_op_info:
+        return svn_error_trace(svn_ra_stat(session, "", lb->revision,
+                                           &dirent, pool));
+
+      default:
+        SVN_ERR_MALFUNCTION();
+    }
+}
+
+/* Open a new RA session to CB's URL in *SESSION.  Use a client context
+ * of our own because auth batons must not be shared between threads.
+ * Allocate everything in POOL. */
+static svn_error_t *
+open_session(svn_ra_session_t **session,
+             client_baton_t *cb,
+             apr_pool_t *pool)
+{
+  load_baton_t *lb = cb->load;
+  svn_cl__opt_state_t *opt_state = lb->opt_state;
+  svn_client_ctx_t *ctx;
+
+  SVN_ERR(svn_client_create_context2(&ctx, lb->ctx->config, pool));
+  ctx->cancel_func = lb->ctx->cancel_func;
+  ctx->cancel_baton = lb->ctx->cancel_baton;
+
+  SVN_ERR(svn_cmdline_create_auth_baton2(
+            &ctx->auth_baton,
+            opt_state->non_interactive,
+            opt_state->auth_username,
+            opt_state->auth_password,
+            opt_state->config_dir,
+            opt_state->no_auth_cache,
+            opt_state->trust_server_cert_unknown_ca,
+            opt_state->trust_server_cert_cn_mismatch,
+            opt_state->trust_server_cert_expired,
+            opt_state->trust_server_cert_not_yet_valid,
+            opt_state->trust_server_cert_other_failure,
+            svn_hash_gets(ctx->config, SVN_CONFIG_CATEGORY_CONFIG),
+            ctx->cancel_func,
+            ctx->cancel_baton,
+            pool));
+
+  return svn_error_trace(svn_client_open_ra_session2(session, lb->url,
+                                                     NULL, ctx,
+                                                     pool, pool));
+}
+
+/* Run operations for client CB until the shared budget is used up.
+ * Record latencies and errors in CB.  Failed operations don't stop the
+ * client but make it reconnect.  Cancellation and failures to connect do.
+ */
+static svn_error_t *
+run_client(client_baton_t *cb)
+{
+  load_baton_t *lb = cb->load;
+  apr_pool_t *session_pool = svn_pool_create(cb->pool);
+  apr_pool_t *iterpool = svn_pool_create(cb->pool);
+  svn_ra_session_t *session = NULL;
+
+  while (svn_atomic_inc(&lb->started) < (svn_atomic_t)lb->operations)
+    {
+      load_op_t op = next_op(cb);
+      apr_time_t start;
+      svn_error_t *err;
+
+      svn_pool_clear(iterpool);
+      if (lb->ctx->cancel_func)
+        SVN_ERR(lb->ctx->cancel_func(lb->ctx->cancel_baton));
+
+      if (!session)
+        {
+          svn_pool_clear(session_pool);
+          SVN_ERR(open_session(&session, cb, session_pool));
+        }
+
+      start = apr_time_now();
+      err = run_op(session, cb, op, iterpool);
+      if (err && err->apr_err == SVN_ERR_CANCELLED)
+        return svn_error_trace(err);
+
+      if (err)
+        {
+          svn_error_clear(err);
+          cb->errors[op]++;
+          session = NULL;
+        }
+      else
+        {
+          APR_ARRAY_PUSH(cb->latencies[op], apr_interval_time_t)
+            = apr_time_now() - start;
+        }
+    }
+
+  svn_pool_destroy(iterpool);
+  svn_pool_destroy(session_pool);
+
+  return SVN_NO_ERROR;
+}
+
+#if APR_HAS_THREADS
+/* Thread entry point for run_client() with client_baton_t DATA. */
+static void * APR_THREAD_FUNC
+client_thread(apr_thread_t *thread,
+              void *data)
+{
+  client_baton_t *cb = data;
+  cb->err = run_client(cb);
+
+  return NULL;
+}
+#endif
+
+/* qsort() comparison function for apr_interval_time_t. */
+static int
+compare_latencies(const void *lhs,
+                  const void *rhs)
+{
+  apr_interval_time_t a = *(const apr_interval_time_t *)lhs;
+  apr_interval_time_t b = *(const apr_interval_time_t *)rhs;
+
+  return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+/* Return the PCT-th percentile of the sorted LATENCIES in milliseconds. */
+static double
+percentile(const apr_array_header_t *latencies,
+           int pct)
+{
+  int idx = (int)((apr_int64_t)(latencies->nelts - 1) * pct / 100);
+  return APR_ARRAY_IDX(latencies, idx, apr_interval_time_t) / 1000.0;
+}
+
+/* Print the combined results of the NUM_CLIENTS CLIENTS after running
+ * for TIME_TAKEN.  Use POOL for allocations. */
+static svn_error_t *
+print_report(client_baton_t *clients,
+             int num_clients,
+             apr_interval_time_t time_taken,
+             apr_pool_t *pool)
+{
+  int total = 0;
+  int total_errors = 0;
+  int i, k;
+
+  SVN_ERR(svn_cmdline_printf(pool,
+                             _("%-10s %8s %8s %10s %10s %10s %10s\n"),
+                             _("operation"), _("count"), _("errors"),
+                             _("p50 ms"), _("p90 ms"), _("p99 ms"),
+                             _("max ms")));
+
+  for (k = 0; k < load_op_count; ++k)
+    {
+      apr_array_header_t *latencies
+        = apr_array_make(pool, 0, sizeof(apr_interval_time_t));
+      int errors = 0;
+
+      for (i = 0; i < num_clients; ++i)
+        {
+          apr_array_cat(latencies, clients[i].latencies[k]);
+          errors += clients[i].errors[k];
+        }
+
+      if (latencies->nelts + errors == 0)
+        continue;
+
+      total += latencies->nelts + errors;
+      total_errors += errors;
+
+      if (latencies->nelts == 0)
+        {
+          SVN_ERR(svn_cmdline_printf(pool, "%-10s %8d %8d\n", op_names[k],
+                                     errors, errors));
+          continue;
+        }
+
+      qsort(latencies->elts, latencies->nelts, latencies->elt_size,
+            compare_latencies);
+      SVN_ERR(svn_cmdline_printf(pool,
+                                 "%-10s %8d %8d %10.1f %10.1f %10.1f %10.1f\n",
+                                 op_names[k], latencies->nelts + errors,
+                                 errors, percentile(latencies, 50),
+                                 percentile(latencies, 90),
+                                 percentile(latencies, 99),
+                                 percentile(latencies, 100)));
+    }
+
+  SVN_ERR(svn_cmdline_printf(pool, _("%15d operations\n"), total));
+  SVN_ERR(svn_cmdline_printf(pool, _("%15.2f%% errors\n"),
+                             total ? 100.0 * total_errors / total : 0.0));
+  if (time_taken > 0)
+    SVN_ERR(svn_cmdline_printf(pool, _("%15.1f operations per second\n"),
+                               total * 1.0e6 / time_taken));
+
+  return SVN_NO_ERROR;
+}
+
+/* Fill LB->REVISION and LB->FILES using CTX.  Use POOL for all
+ * allocations. */
+static svn_error_t *
+prepare(load_baton_t *lb,
+        svn_client_ctx_t *ctx,
+        apr_pool_t *pool)
+{
+  svn_ra_session_t *session;
+  apr_hash_t *dirents;
+  apr_hash_index_t *hi;
+
+  SVN_ERR(svn_client_open_ra_session2(&session, lb->url, NULL, ctx,
+                                      pool, pool));
+
+  if (!SVN_IS_VALID_REVNUM(lb->revision))
+    SVN_ERR(svn_ra_get_latest_revnum(session, &lb->revision, pool));
+
+  lb->files = apr_array_make(pool, 0, sizeof(const char *));
+  SVN_ERR(svn_ra_get_dir2(session, &dirents, NULL, NULL, "", lb->revision,
+                          SVN_DIRENT_KIND, pool));
+  for (hi = apr_hash_first(pool, dirents); hi; hi = apr_hash_next(hi))
+    {
+      const svn_dirent_t *dirent = apr_hash_this_val(hi);
+      if (dirent->kind == svn_node_file)
+        APR_ARRAY_PUSH(lb->files, const char *) = apr_hash_this_key(hi);
+    }
+
+  if (lb->weights[load_op_cat] > 0 && lb->files->nelts == 0)
+    return svn_error_createf(SVN_ERR_ILLEGAL_TARGET, NULL,
+                             _("No files in '%s' to use for 'cat'"),
+                             lb->url);
+
+  return SVN_NO_ERROR;
+}
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__load(apr_getopt_t *os,
+             void *baton,
+             apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  svn_client_ctx_t *ctx = ((svn_cl__cmd_baton_t *) baton)->ctx;
+  apr_array_header_t *targets;
+  load_baton_t *lb = apr_pcalloc(pool, sizeof(*lb));
+  client_baton_t *clients;
+  int num_clients = opt_state->clients ? opt_state->clients
+                                       : DEFAULT_CLIENTS;
+  apr_time_t start_time;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i, k;
+
+  SVN_ERR(svn_cl__args_to_target_array_print_reserved(&targets, os,
+                                                      opt_state->targets,
+                                                      ctx, FALSE, pool));
+  if (targets->nelts != 1)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, NULL, NULL);
+
+  lb->url = APR_ARRAY_IDX(targets, 0, const char *);
+  if (!svn_path_is_url(lb->url))
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("'%s' is not a URL"), lb->url);
+
+  if (opt_state->start_revision.kind == svn_opt_revision_number)
+    lb->revision = opt_state->start_revision.value.number;
+  else if (opt_state->start_revision.kind == svn_opt_revision_unspecified
+           || opt_state->start_revision.kind == svn_opt_revision_head)
+    lb->revision = SVN_INVALID_REVNUM;
+  else
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("Only revision numbers and HEAD are "
+                              "supported"));
+
+  SVN_ERR(parse_mix(lb, opt_state->mix ? opt_state->mix : DEFAULT_MIX,
+                    pool));
+  lb->log_limit = opt_state->limit ? opt_state->limit : DEFAULT_LOG_LIMIT;
+  lb->operations = opt_state->operations ? opt_state->operations
+                                         : DEFAULT_OPERATIONS;
+  lb->opt_state = opt_state;
+  lb->ctx = ctx;
+
+  /* This also gives the user a chance to enter credentials once. */
+  SVN_ERR(prepare(lb, ctx, pool));
+
+#if !APR_HAS_THREADS
+  num_clients = 1;
+#endif
+
+  /* Each client gets a root pool of its own, so they don't need to
+     synchronize on allocations. */
+  clients = apr_pcalloc(pool, num_clients * sizeof(*clients));
+  for (i = 0; i < num_clients; ++i)
+    {
+      clients[i].load = lb;
+      clients[i].seed = (apr_uint32_t)i;
+      clients[i].pool = svn_pool_create(NULL);
+      for (k = 0; k < load_op_count; ++k)
+        clients[i].latencies[k]
+          = apr_array_make(clients[i].pool, 0, sizeof(apr_interval_time_t));
+    }
+
+  start_time = apr_time_now();
+
+#if APR_HAS_THREADS
+  if (num_clients > 1)
+    {
+      apr_thread_t **threads = apr_pcalloc(pool,
+                                           num_clients * sizeof(*threads));
+      for (i = 0; i < num_clients; ++i)
+        {
+          apr_status_t status = apr_thread_create(&threads[i], NULL,
+                                                  client_thread, &clients[i],
+                                                  pool);
+          if (status)
+            {
+              err = svn_error_wrap_apr(status, _("Can't create thread"));
+
+              /* Let the running clients finish quickly. */
+              lb->operations = 0;
+              break;
+            }
+        }
+
+      for (k = 0; k < i; ++k)
+        {
+          apr_status_t retval;
+          apr_thread_join(&retval, threads[k]);
+        }
+    }
+  else
+#endif
+    clients[0].err = run_client(&clients[0]);
+
+  for (i = 0; i < num_clients; ++i)
+    err = svn_error_compose_create(err, clients[i].err);
+
+  if (!err)
+    err = print_report(clients, num_clients, apr_time_now() - start_time,
+                       pool);
+
+  for (i = 0; i < num_clients; ++i)
+    svn_pool_destroy(clients[i].pool);
+
+  return svn_error_trace(err);
+}
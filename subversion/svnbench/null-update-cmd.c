@@ -0,0 +1,473 @@
+/*
+ * null-update-cmd.c -- Receive updates and checkouts without a working copy
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* ==================================================================== */
+
+
+
+/*** Includes. ***/
+
+#include "svn_client.h"
+#include "svn_error.h"
+#include "svn_delta.h"
+#include "svn_path.h"
+#include "svn_cmdline.h"
+#include "svn_time.h"
+#include "cl.h"
+
+#include "svn_private_config.h"
+#include "private/svn_string_private.h"
+#include "private/svn_client_private.h"
+
+/*** The null update editor code. ***/
+
+/* Counters and timestamps collected while receiving an update. */
+typedef struct edit_baton_t
+{
+  apr_int64_t file_count;
+  apr_int64_t dir_count;
+  apr_int64_t delete_count;
+  apr_int64_t byte_count;
+  apr_int64_t delta_byte_count;
+  apr_int64_t prop_count;
+  apr_int64_t prop_byte_count;
+
+  /* Reconstruct the file contents from the deltas, discarding the
+     result.  Only possible for deltas against the empty file. */
+  svn_boolean_t apply_deltas;
+
+  /* Time of the first editor call or 0 if there was none yet. */
+  apr_time_t first_response;
+} edit_baton_t;
+
+/* Record the time of the first response in EB. */
+static void
+got_response(edit_baton_t *eb)
+{
+  if (eb->first_response == 0)
+    eb->first_response = apr_time_now();
+}
+
+static svn_error_t *
+set_target_revision(void *edit_baton,
+                    svn_revnum_t target_revision,
+                    apr_pool_t *pool)
+{
+  got_response(edit_baton);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+open_root(void *edit_baton,
+          svn_revnum_t base_revision,
+          apr_pool_t *pool,
+          void **root_baton)
+{
+  got_response(edit_baton);
+  *root_baton = edit_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+delete_entry(const char *path,
+             svn_revnum_t revision,
+             void *parent_baton,
+             apr_pool_t *pool)
+{
+  edit_baton_t *eb = parent_baton;
+  eb->delete_count++;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+add_directory(const char *path,
+              void *parent_baton,
+              const char *copyfrom_path,
+              svn_revnum_t copyfrom_revision,
+              apr_pool_t *pool,
+              void **baton)
+{
+  edit_baton_t *eb = parent_baton;
+  eb->dir_count++;
+
+  *baton = parent_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+open_directory(const char *path,
+               void *parent_baton,
+               svn_revnum_t base_revision,
+               apr_pool_t *pool,
+               void **baton)
+{
+  edit_baton_t *eb = parent_baton;
+  eb->dir_count++;
+
+  *baton = parent_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+add_file(const char *path,
+         void *parent_baton,
+         const char *copyfrom_path,
+         svn_revnum_t copyfrom_revision,
+         apr_pool_t *pool,
+         void **baton)
+{
+  edit_baton_t *eb = parent_baton;
+  eb->file_count++;
+
+  *baton = parent_baton;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+open_file(const char *path,
+          void *parent_baton,
+          svn_revnum_t base_revision,
+          apr_pool_t *pool,
+          void **baton)
+{
+  edit_baton_t *eb = parent_baton;
+  eb->file_count++;
+
+  *baton = parent_baton;
+  return SVN_NO_ERROR;
+}
+
+/* Implement svn_write_fn_t, simply counting the incoming data. */
+static svn_error_t *
+file_write_handler(void *baton, const char *data, apr_size_t *len)
+{
+  edit_baton_t *eb = baton;
+  eb->byte_count += *len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for window_handler(). */
+typedef struct window_baton_t
+{
+  edit_baton_t *eb;
+
+  /* Applies the windows if the contents shall be reconstructed. */
+  svn_txdelta_window_handler_t apply_handler;
+  void *apply_baton;
+} window_baton_t;
+
+static svn_error_t *
+window_handler(svn_txdelta_window_t *window, void *baton)
+{
+  window_baton_t *wb = baton;
+
+  if (window != NULL)
+    {
+      if (window->new_data)
+        wb->eb->delta_byte_count += window->new_data->len;
+      if (!wb->apply_handler)
+        wb->eb->byte_count += window->tview_len;
+    }
+
+  if (wb->apply_handler)
+    SVN_ERR(wb->apply_handler(window, wb->apply_baton));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+apply_textdelta(void *file_baton,
+                const char *base_checksum,
+                apr_pool_t *pool,
+                svn_txdelta_window_handler_t *handler,
+                void **handler_baton)
+{
+  edit_baton_t *eb = file_baton;
+  window_baton_t *wb = apr_pcalloc(pool, sizeof(*wb));
+
+  wb->eb = eb;
+  if (eb->apply_deltas)
+    {
+      svn_stream_t *sink = svn_stream_create(eb, pool);
+      svn_stream_set_write(sink, file_write_handler);
+
+      svn_txdelta_apply(svn_stream_empty(pool), sink, NULL, NULL, pool,
+                        &wb->apply_handler, &wb->apply_baton);
+    }
+
+  *handler_baton = wb;
+  *handler = window_handler;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+change_file_prop(void *file_baton,
+                 const char *name,
+                 const svn_string_t *value,
+                 apr_pool_t *pool)
+{
+  edit_baton_t *eb = file_baton;
+  eb->prop_count++;
+  if (value)
+    eb->prop_byte_count += value->len;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+change_dir_prop(void *dir_baton,
+                const char *name,
+                const svn_string_t *value,
+                apr_pool_t *pool)
+{
+  edit_baton_t *eb = dir_baton;
+  eb->prop_count++;
+  if (value)
+    eb->prop_byte_count += value->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Report a working copy of URL at BASE_REVISION, or an empty one if that
+ * is SVN_INVALID_REVNUM, and receive the update to REVISION with DEPTH
+ * into the counters in EB.  Print how long each phase took unless QUIET
+ * is set.  Use CTX for the connection and POOL for all allocations. */
+static svn_error_t *
+bench_null_update(const char *url,
+                  svn_opt_revision_t *peg_revision,
+                  svn_revnum_t base_revision,
+                  svn_opt_revision_t *revision,
+                  svn_depth_t depth,
+                  edit_baton_t *eb,
+                  svn_client_ctx_t *ctx,
+                  svn_boolean_t quiet,
+                  apr_pool_t *pool)
+{
+  svn_client__pathrev_t *loc;
+  svn_ra_session_t *ra_session;
+  svn_node_kind_t kind;
+  const svn_delta_editor_t *update_editor;
+  void *edit_baton;
+  const svn_ra_reporter3_t *reporter;
+  void *report_baton;
+  svn_delta_editor_t *editor;
+  svn_boolean_t start_empty = !SVN_IS_VALID_REVNUM(base_revision);
+  apr_time_t start, session_opened, report_sent, finished;
+
+  if (peg_revision->kind == svn_opt_revision_unspecified)
+    peg_revision->kind = svn_opt_revision_head;
+  if (revision->kind == svn_opt_revision_unspecified)
+    revision = peg_revision;
+
+  start = apr_time_now();
+  SVN_ERR(svn_client__ra_session_from_path2(&ra_session, &loc, url, NULL,
+                                            peg_revision, revision,
+                                            ctx, pool));
+  session_opened = apr_time_now();
+
+  SVN_ERR(svn_ra_check_path(ra_session, "", loc->rev, &kind, pool));
+  if (kind == svn_node_none)
+    return svn_error_createf(SVN_ERR_RA_ILLEGAL_URL, NULL,
+                             _("URL '%s' doesn't exist"), url);
+  if (kind != svn_node_dir)
+    return svn_error_createf(SVN_ERR_RA_ILLEGAL_URL, NULL,
+                             _("URL '%s' is not a directory"), url);
+
+  editor = svn_delta_default_editor(pool);
+  editor->set_target_revision = set_target_revision;
+  editor->open_root = open_root;
+  editor->delete_entry = delete_entry;
+  editor->add_directory = add_directory;
+  editor->open_directory = open_directory;
+  editor->add_file = add_file;
+  editor->open_file = open_file;
+  editor->apply_textdelta = apply_textdelta;
+  editor->change_file_prop = change_file_prop;
+  editor->change_dir_prop = change_dir_prop;
+
+  SVN_ERR(svn_delta_get_cancellation_editor(ctx->cancel_func,
+                                            ctx->cancel_baton,
+                                            editor, eb,
+                                            &update_editor, &edit_baton,
+                                            pool));
+
+  SVN_ERR(svn_ra_do_update3(ra_session, &reporter, &report_baton,
+                            loc->rev,
+                            "", /* no sub-target */
+                            depth,
+                            FALSE, /* don't want copyfrom-args */
+                            FALSE, /* don't want ignore_ancestry */
+                            update_editor, edit_baton,
+                            pool, pool));
+
+  SVN_ERR(reporter->set_path(report_baton, "",
+                             start_empty ? loc->rev : base_revision,
+                             depth, start_empty, NULL, pool));
+  report_sent = apr_time_now();
+
+  SVN_ERR(reporter->finish_report(report_baton, pool));
+  finished = apr_time_now();
+
+  if (!quiet)
+    SVN_ERR(svn_cmdline_printf(pool,
+                               _("%15.6f seconds to open the session\n"
+                                 "%15.6f seconds to send the report\n"
+                                 "%15.6f seconds to the first response\n"
+                                 "%15.6f seconds to receive the response\n"),
+                               (session_opened - start) / 1.0e6,
+                               (report_sent - session_opened) / 1.0e6,
+                               eb->first_response
+                                 ? (eb->first_response - report_sent) / 1.0e6
+                                 : 0.0,
+                               (finished - report_sent) / 1.0e6));
+
+  return SVN_NO_ERROR;
+}
+
+/* Print the counters in EB unless QUIET is set.  Use POOL for temporary
+ * allocations. */
+static svn_error_t *
+print_counters(const edit_baton_t *eb,
+               svn_boolean_t quiet,
+               apr_pool_t *pool)
+{
+  if (quiet)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(svn_cmdline_printf(pool,
+                               _("%15s directories\n"
+                                 "%15s files\n"
+                                 "%15s deletions\n"
+                                 "%15s bytes in files\n"
+                                 "%15s bytes in deltas\n"
+                                 "%15s properties\n"
+                                 "%15s bytes in properties\n"),
+                               svn__ui64toa_sep(eb->dir_count, ',', pool),
+                               svn__ui64toa_sep(eb->file_count, ',', pool),
+                               svn__ui64toa_sep(eb->delete_count, ',', pool),
+                               svn__ui64toa_sep(eb->byte_count, ',', pool),
+                               svn__ui64toa_sep(eb->delta_byte_count, ',',
+                                                pool),
+                               svn__ui64toa_sep(eb->prop_count, ',', pool),
+                               svn__ui64toa_sep(eb->prop_byte_count, ',',
+                                                pool)));
+}
+
+/* Set *URL and *PEG_REVISION to the single URL[@PEG] argument in OS.
+ * Use CTX and POOL as usual. */
+static svn_error_t *
+get_url_target(const char **url,
+               svn_opt_revision_t *peg_revision,
+               apr_getopt_t *os,
+               svn_cl__opt_state_t *opt_state,
+               svn_client_ctx_t *ctx,
+               apr_pool_t *pool)
+{
+  apr_array_header_t *targets;
+
+  SVN_ERR(svn_cl__args_to_target_array_print_reserved(&targets, os,
+                                                      opt_state->targets,
+                                                      ctx, FALSE, pool));
+  if (targets->nelts < 1)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, 0, NULL);
+  if (targets->nelts > 1)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, 0, NULL);
+
+  SVN_ERR(svn_opt_parse_path(peg_revision, url,
+                             APR_ARRAY_IDX(targets, 0, const char *), pool));
+  if (!svn_path_is_url(*url))
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("'%s' is not a URL"), *url);
+
+  return SVN_NO_ERROR;
+}
+
+
+/*** Code. ***/
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__null_checkout(apr_getopt_t *os,
+                      void *baton,
+                      apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  svn_client_ctx_t *ctx = ((svn_cl__cmd_baton_t *) baton)->ctx;
+  svn_opt_revision_t peg_revision;
+  const char *url;
+  edit_baton_t eb = { 0 };
+  svn_error_t *err;
+
+  SVN_ERR(get_url_target(&url, &peg_revision, os, opt_state, ctx, pool));
+
+  if (opt_state->depth == svn_depth_unknown)
+    opt_state->depth = svn_depth_infinity;
+
+  eb.apply_deltas = opt_state->apply_deltas;
+  err = bench_null_update(url, &peg_revision, SVN_INVALID_REVNUM,
+                          &opt_state->start_revision, opt_state->depth,
+                          &eb, ctx, opt_state->quiet, pool);
+  SVN_ERR(print_counters(&eb, opt_state->quiet, pool));
+
+  return svn_error_trace(err);
+}
+
+/* This implements the `svn_opt_subcommand_t' interface. */
+svn_error_t *
+svn_cl__null_update(apr_getopt_t *os,
+                    void *baton,
+                    apr_pool_t *pool)
+{
+  svn_cl__opt_state_t *opt_state = ((svn_cl__cmd_baton_t *) baton)->opt_state;
+  svn_client_ctx_t *ctx = ((svn_cl__cmd_baton_t *) baton)->ctx;
+  svn_opt_revision_t peg_revision;
+  const char *url;
+  edit_baton_t eb = { 0 };
+  svn_error_t *err;
+
+  SVN_ERR(get_url_target(&url, &peg_revision, os, opt_state, ctx, pool));
+
+  if (opt_state->start_revision.kind != svn_opt_revision_number)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("null-update requires a revision number "
+                              "to update from"));
+
+  if (opt_state->apply_deltas)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("--apply-deltas is not supported by "
+                              "null-update"));
+
+  if (opt_state->depth == svn_depth_unknown)
+    opt_state->depth = svn_depth_infinity;
+
+  err = bench_null_update(url, &peg_revision,
+                          opt_state->start_revision.value.number,
+                          &opt_state->end_revision, opt_state->depth,
+                          &eb, ctx, opt_state->quiet, pool);
+  SVN_ERR(print_counters(&eb, opt_state->quiet, pool));
+
+  return svn_error_trace(err);
+}
@@ -39,6 +39,7 @@
 #include "cl.h"
 
 #include "private/svn_opt_private.h"
+#include "private/svn_profile.h"
 #include "private/svn_cmdline_private.h"
 #include "private/svn_string_private.h"
 #include "private/svn_utf_private.h"
@@ -70,7 +71,12 @@ typedef enum svn_cl__longopt_t {
   opt_trust_server_cert,
   opt_trust_server_cert_failures,
   opt_changelist,
-  opt_search
+  opt_search,
+  opt_profile,
+  opt_clients,
+  opt_operations,
+  opt_mix,
+  opt_apply_deltas
 } svn_cl__longopt_t;
 
 
@@ -171,6 +177,20 @@ const apr_getopt_option_t svn_cl__options[] =
                        "history")},
   {"search", opt_search, 1,
                        N_("use ARG as search pattern (glob syntax)")},
+  {"profile", opt_profile, 0,
+                       N_("print where the time went to stderr on exit")},
+  {"clients", opt_clients, 1,
+                       N_("number ARG of concurrent sessions")},
+  {"operations", opt_operations, 1,
+                       N_("total number ARG of operations to run")},
+  {"mix", opt_mix, 1,
+                       N_("operation mix ARG as comma-separated list of\n"
+                          "                             "
+                          "OP[=WEIGHT] with OP being 'update', 'checkout',\n"
+                          "                             "
+                          "'log', 'list', 'cat' or 'info'")},
+  {"apply-deltas", opt_apply_deltas, 0,
+                       N_("reconstruct the received file contents")},
 
   /* Long-opt Aliases
    *
@@ -203,7 +223,7 @@ const int svn_cl__global_options[] =
 { opt_auth_username, opt_auth_password, opt_auth_password_from_stdin,
   opt_no_auth_cache, opt_non_interactive,
   opt_trust_server_cert, opt_trust_server_cert_failures,
-  opt_config_dir, opt_config_options, 0
+  opt_config_dir, opt_config_options, opt_profile, 0
 };
 
 const svn_opt_subcommand_desc3_t svn_cl__cmd_table[] =
@@ -215,6 +235,31 @@ const svn_opt_subcommand_desc3_t svn_cl__cmd_table[] =
     {0} },
   /* This command is also invoked if we see option "--help", "-h" or "-?". */
 
+  { "load", svn_cl__load, {0}, {N_(
+     "Put load on a repository server and report its response times.\n"
+     "usage: load [-r REV] URL\n"
+     "\n"), N_(
+     "  Run --operations (default: 100) operations against URL at revision\n"
+     "  REV (default: HEAD), spread over --clients (default: 4) concurrent\n"
+     "  sessions.  Each session picks its next operation at random with\n"
+     "  the weights given in --mix\n"
+     "  (default: 'update=4,log=2,list=2,cat=4,info=2').\n"
+     "\n"), N_(
+     "  The operations are:\n"
+     "    update    update a working copy of URL from REV-1 to REV\n"
+     "    checkout  update an empty working copy of URL to REV\n"
+     "    log       fetch up to --limit (default: 100) log entries for URL\n"
+     "    list      list the directory URL\n"
+     "    cat       fetch a file directly below URL\n"
+     "    info      fetch information about URL\n"
+     "\n"), N_(
+     "  All data received is discarded.  Failed operations are counted and\n"
+     "  reported but don't stop the run.  The report shows the latency\n"
+     "  percentiles of successful operations, the error rate and the\n"
+     "  throughput.\n"
+    )},
+    {'r', 'l', opt_clients, opt_operations, opt_mix} },
+
   { "null-blame", svn_cl__null_blame, {0}, {N_(
      "Fetch all versions of a file in a batch.\n"
      "usage: null-blame [-rM:N] TARGET[@REV]...\n"
@@ -236,6 +281,23 @@ const svn_opt_subcommand_desc3_t svn_cl__cmd_table[] =
     )},
     {'r', 'g'} },
 
+  { "null-checkout", svn_cl__null_checkout, {0}, {N_(
+     "Receive a checkout of a directory without storing it.\n"
+     "usage: null-checkout [-r REV] URL[@PEGREV]\n"
+     "\n"), N_(
+     "  Requests the tree at URL in revision REV (default: PEGREV or HEAD)\n"
+     "  the way a checkout does and discards the response.  Reports how long\n"
+     "  opening the session, sending the report, the first response and\n"
+     "  receiving the whole response took, together with the amount of\n"
+     "  data received.\n"
+     "\n"), N_(
+     "  With --apply-deltas, also reconstruct the file contents in memory.\n"
+     "\n"), N_(
+     "  Use e.g. '--config-option servers:global:http-bulk-updates=yes' to\n"
+     "  compare bulk and skelta mode with ra_serf.\n"
+    )},
+    {'r', 'q', opt_depth, opt_apply_deltas} },
+
   { "null-export", svn_cl__null_export, {0}, {N_(
      "Create an unversioned copy of a tree.\n"
      "usage: null-export [-r REV] URL[@PEGREV]\n"
@@ -316,6 +378,21 @@ const svn_opt_subcommand_desc3_t svn_cl__cmd_table[] =
     {'r', 'R', opt_depth, opt_targets, opt_changelist}
   },
 
+  { "null-update", svn_cl__null_update, {0}, {N_(
+     "Receive an update of a directory without storing it.\n"
+     "usage: null-update -r N[:M] URL[@PEGREV]\n"
+     "\n"), N_(
+     "  Reports a working copy of URL at revision N, requests the update to\n"
+     "  revision M (default: PEGREV or HEAD) and discards the response.\n"
+     "  Reports how long opening the session, sending the report, the first\n"
+     "  response and receiving the whole response took, together with the\n"
+     "  amount of data received.\n"
+     "\n"), N_(
+     "  Use e.g. '--config-option servers:global:http-bulk-updates=yes' to\n"
+     "  compare bulk and skelta mode with ra_serf.\n"
+    )},
+    {'r', 'q', opt_depth} },
+
   { NULL, NULL, {0}, {NULL}, {0} }
 };
 
@@ -704,6 +781,34 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
                                  apr_pstrdup(pool, utf8_opt_arg),
                                  pool);
         break;
+      case opt_profile:
+        SVN_ERR(svn_profile__enable());
+        break;
+      case opt_clients:
+        err = svn_cstring_atoi(&opt_state.clients, opt_arg);
+        if (err)
+          return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                                  _("Non-numeric clients argument given"));
+        if (opt_state.clients <= 0)
+          return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                  _("Argument to --clients must be positive"));
+        break;
+      case opt_operations:
+        err = svn_cstring_atoi(&opt_state.operations, opt_arg);
+        if (err)
+          return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                                  _("Non-numeric operations argument given"));
+        if (opt_state.operations <= 0)
+          return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                  _("Argument to --operations must be "
+                                    "positive"));
+        break;
+      case opt_mix:
+        SVN_ERR(svn_utf_cstring_to_utf8(&opt_state.mix, opt_arg, pool));
+        break;
+      case opt_apply_deltas:
+        opt_state.apply_deltas = TRUE;
+        break;
       default:
         /* Hmmm. Perhaps this would be a good place to squirrel away
            opts that commands like svn diff might need. Hmmm indeed. */
@@ -887,7 +992,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   /* Only a few commands can accept a revision range; the rest can take at
      most one revision number. */
   if (subcommand->cmd_func != svn_cl__null_blame
-      && subcommand->cmd_func != svn_cl__null_log)
+      && subcommand->cmd_func != svn_cl__null_log
+      && subcommand->cmd_func != svn_cl__null_update)
     {
       if (opt_state.end_revision.kind != svn_opt_revision_unspecified)
         {
@@ -1038,6 +1144,17 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Write the profile gathered by --profile to stderr.  Use POOL for
+ * temporary allocations. */
+static svn_error_t *
+print_profile(apr_pool_t *pool)
+{
+  svn_stream_t *err_stream;
+
+  SVN_ERR(svn_stream_for_stderr(&err_stream, pool));
+  return svn_error_trace(svn_profile__print(err_stream, pool));
+}
+
 int
 main(int argc, const char *argv[])
 {
@@ -1060,6 +1177,9 @@ main(int argc, const char *argv[])
      but this makes sure that output is not silently lost if it fails. */
   err = svn_error_compose_create(err, svn_cmdline_fflush(stdout));
 
+  if (svn_profile__enabled())
+    err = svn_error_compose_create(err, print_profile(pool));
+
   if (err)
     {
       exit_code = EXIT_FAILURE;
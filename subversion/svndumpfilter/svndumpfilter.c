@@ -106,47 +106,95 @@ write_propdel_to_stringbuf(svn_stringbuf_t **strbuf,
 }
 
 
-/* Compare the node-path PATH with the (const char *) prefixes in PFXLIST.
- * Return TRUE if any prefix is a prefix of PATH (matching whole path
- * components); FALSE otherwise.
- * PATH starts with a '/', as do the (const char *) paths in PREFIXES. */
-/* This function is a duplicate of svnadmin.c:ary_prefix_match(). */
-static svn_boolean_t
-ary_prefix_match(const apr_array_header_t *pfxlist, const char *path)
+/* The path prefixes to filter by, compiled into a trie of path
+   components.  Matching a node path costs one hash lookup per component
+   of the path, no matter how many prefixes have been given. */
+typedef struct prefix_node_t
+{
+  /* Maps the next path component (not NUL-terminated) to the
+     prefix_node_t for it. */
+  apr_hash_t *children;
+
+  /* Does a prefix end at this node? */
+  svn_boolean_t is_prefix;
+} prefix_node_t;
+
+/* Return the length of the path component starting at PATH. */
+static APR_INLINE apr_ssize_t
+component_len(const char *path)
+{
+  const char *end = strchr(path, '/');
+  return end ? end - path : (apr_ssize_t)strlen(path);
+}
+
+/* Return a new, empty trie node allocated in POOL. */
+static prefix_node_t *
+make_prefix_node(apr_pool_t *pool)
+{
+  prefix_node_t *node = apr_pcalloc(pool, sizeof(*node));
+  node->children = apr_hash_make(pool);
+  return node;
+}
+
+/* Return the trie for the (const char *) prefixes in PFXLIST, allocated
+   in POOL.  The trie refers to the strings in PFXLIST, which must live
+   at least as long.  The prefixes start with a '/'. */
+static prefix_node_t *
+build_prefix_trie(const apr_array_header_t *pfxlist,
+                  apr_pool_t *pool)
 {
+  prefix_node_t *root = make_prefix_node(pool);
   int i;
-  size_t path_len = strlen(path);
 
   for (i = 0; i < pfxlist->nelts; i++)
     {
       const char *pfx = APR_ARRAY_IDX(pfxlist, i, const char *);
-      size_t pfx_len = strlen(pfx);
+      prefix_node_t *node = root;
 
-      if (path_len < pfx_len)
-        continue;
-      if (strncmp(path, pfx, pfx_len) == 0
-          && (pfx_len == 1 || path[pfx_len] == '\0' || path[pfx_len] == '/'))
-        return TRUE;
+      /* A single character prefix, i.e. "/", matches every path. */
+      if (pfx[0] != '\0' && pfx[1] != '\0')
+        for (pfx++; ; pfx += component_len(pfx) + 1)
+          {
+            apr_ssize_t len = component_len(pfx);
+            prefix_node_t *child = apr_hash_get(node->children, pfx, len);
+
+            if (child == NULL)
+              {
+                child = make_prefix_node(pool);
+                apr_hash_set(node->children, pfx, len, child);
+              }
+
+            node = child;
+            if (pfx[len] == '\0')
+              break;
+          }
+
+      node->is_prefix = TRUE;
     }
 
-  return FALSE;
+  return root;
 }
 
-
-/* Check whether we need to skip this PATH based on its presence in
-   the PREFIXES list, and the DO_EXCLUDE option.
-   PATH starts with a '/', as do the (const char *) paths in PREFIXES. */
-static APR_INLINE svn_boolean_t
-skip_path(const char *path, const apr_array_header_t *prefixes,
-          svn_boolean_t do_exclude, svn_boolean_t glob)
+/* Return TRUE if any prefix in the trie ROOT is a prefix of PATH
+ * (matching whole path components); FALSE otherwise.
+ * PATH starts with a '/'. */
+static svn_boolean_t
+trie_prefix_match(const prefix_node_t *root, const char *path)
 {
-  const svn_boolean_t matches =
-    (glob
-     ? svn_cstring_match_glob_list(path, prefixes)
-     : ary_prefix_match(prefixes, path));
+  const prefix_node_t *node = root;
 
-  /* NXOR */
-  return (matches ? do_exclude : !do_exclude);
+  for (path++; !node->is_prefix; path += component_len(path) + 1)
+    {
+      apr_ssize_t len = component_len(path);
+
+      node = apr_hash_get(node->children, path, len);
+      if (node == NULL)
+        return FALSE;
+      if (path[len] == '\0')
+        return node->is_prefix;
+    }
+
+  return TRUE;
 }
 
 
@@ -172,6 +220,7 @@ struct revmap_t
 {
   svn_revnum_t rev; /* Last non-dropped revision to which this maps. */
   svn_boolean_t was_dropped; /* Was this revision dropped? */
+  svn_boolean_t known; /* Has this revision been seen at all? */
 };
 
 struct parse_baton_t
@@ -188,20 +237,104 @@ struct parse_baton_t
   svn_boolean_t allow_deltas;
   apr_array_header_t *prefixes;
 
+  /* PREFIXES compiled into a trie, unless GLOB is set. */
+  prefix_node_t *prefix_trie;
+
   /* Input and output streams. */
   svn_stream_t *in_stream;
   svn_stream_t *out_stream;
 
   /* State for the filtering process. */
   apr_int32_t rev_drop_count;
+
+  /* The paths of the dropped nodes, for the final report.  Only
+     collected if that report will be shown. */
   apr_hash_t *dropped_nodes;
-  apr_hash_t *renumber_history;  /* svn_revnum_t -> struct revmap_t */
+
+  /* The struct revmap_t for the original revisions RENUMBER_BASE and
+     upward, one per revision.  Much more compact than a hash. */
+  apr_array_header_t *renumber_history;
+  svn_revnum_t renumber_base;
+
   svn_revnum_t last_live_revision;
   /* The oldest original revision, greater than r0, in the input
      stream which was not filtered. */
   svn_revnum_t oldest_original_rev;
 };
 
+/* Check whether we need to skip this PATH based on its presence in
+   the prefixes of PB, and its DO_EXCLUDE option.
+   PATH starts with a '/', as do the prefixes. */
+static APR_INLINE svn_boolean_t
+skip_path(const char *path, const struct parse_baton_t *pb)
+{
+  const svn_boolean_t matches =
+    (pb->glob
+     ? svn_cstring_match_glob_list(path, pb->prefixes)
+     : trie_prefix_match(pb->prefix_trie, path));
+
+  /* NXOR */
+  return (matches ? pb->do_exclude : !pb->do_exclude);
+}
+
+/* Return the struct revmap_t for original revision REV in PB, or NULL if
+   REV has not been seen. */
+static struct revmap_t *
+get_revmap(const struct parse_baton_t *pb, svn_revnum_t rev)
+{
+  struct revmap_t *entry;
+
+  if (rev < pb->renumber_base
+      || rev - pb->renumber_base >= pb->renumber_history->nelts)
+    return NULL;
+
+  entry = &APR_ARRAY_IDX(pb->renumber_history, rev - pb->renumber_base,
+                         struct revmap_t);
+  return entry->known ? entry : NULL;
+}
+
+/* Record in PB that original revision REV maps to NEW_REV and whether
+   it WAS_DROPPED. */
+static void
+set_revmap(struct parse_baton_t *pb,
+           svn_revnum_t rev,
+           svn_revnum_t new_rev,
+           svn_boolean_t was_dropped)
+{
+  apr_array_header_t *history = pb->renumber_history;
+  struct revmap_t *entry;
+
+  /* Dump streams come in ascending revision order, so this is rare. */
+  if (rev < pb->renumber_base && history->nelts)
+    {
+      apr_array_header_t *old = history;
+      int gap = (int)(pb->renumber_base - rev);
+
+      history = apr_array_make(apr_array_pool_get(old), old->nelts + gap,
+                               sizeof(struct revmap_t));
+      history->nelts = gap;
+      memset(history->elts, 0, gap * sizeof(struct revmap_t));
+      apr_array_cat(history, old);
+      pb->renumber_history = history;
+      pb->renumber_base = rev;
+    }
+  else if (history->nelts == 0)
+    {
+      pb->renumber_base = rev;
+    }
+
+  while (rev - pb->renumber_base >= history->nelts)
+    {
+      entry = apr_array_push(history);
+      entry->known = FALSE;
+    }
+
+  entry = &APR_ARRAY_IDX(history, rev - pb->renumber_base, struct revmap_t);
+  entry->rev = new_rev;
+  entry->was_dropped = was_dropped;
+  entry->known = TRUE;
+}
+
 struct revision_baton_t
 {
   /* Reference to the global parse baton. */
@@ -394,16 +527,7 @@ output_revision(struct revision_baton_t *rb)
 
       if (rb->pb->do_renumber_revs)
         {
-          svn_revnum_t *rr_key;
-          struct revmap_t *rr_val;
-          apr_pool_t *rr_pool = apr_hash_pool_get(rb->pb->renumber_history);
-          rr_key = apr_palloc(rr_pool, sizeof(*rr_key));
-          rr_val = apr_palloc(rr_pool, sizeof(*rr_val));
-          *rr_key = rb->rev_orig;
-          rr_val->rev = rb->rev_actual;
-          rr_val->was_dropped = FALSE;
-          apr_hash_set(rb->pb->renumber_history, rr_key,
-                       sizeof(*rr_key), rr_val);
+          set_revmap(rb->pb, rb->rev_orig, rb->rev_actual, FALSE);
           rb->pb->last_live_revision = rb->rev_actual;
         }
 
@@ -417,18 +541,7 @@ output_revision(struct revision_baton_t *rb)
       /* We're dropping this revision. */
       rb->pb->rev_drop_count++;
       if (rb->pb->do_renumber_revs)
-        {
-          svn_revnum_t *rr_key;
-          struct revmap_t *rr_val;
-          apr_pool_t *rr_pool = apr_hash_pool_get(rb->pb->renumber_history);
-          rr_key = apr_palloc(rr_pool, sizeof(*rr_key));
-          rr_val = apr_palloc(rr_pool, sizeof(*rr_val));
-          *rr_key = rb->rev_orig;
-          rr_val->rev = rb->pb->last_live_revision;
-          rr_val->was_dropped = TRUE;
-          apr_hash_set(rb->pb->renumber_history, rr_key,
-                       sizeof(*rr_key), rr_val);
-        }
+        set_revmap(rb->pb, rb->rev_orig, rb->pb->last_live_revision, TRUE);
 
       if (! rb->pb->quiet)
         SVN_ERR(svn_cmdline_fprintf(stderr, subpool,
@@ -479,17 +592,17 @@ new_node_record(void **node_baton,
   if (copyfrom_path && copyfrom_path[0] != '/')
     copyfrom_path = apr_pstrcat(pool, "/", copyfrom_path, SVN_VA_NULL);
 
-  nb->do_skip = skip_path(node_path, pb->prefixes,
-                          pb->do_exclude, pb->glob);
+  nb->do_skip = skip_path(node_path, pb);
 
   /* If we're skipping the node, take note of path, discarding the
      rest.  */
   if (nb->do_skip)
     {
-      svn_hash_sets(pb->dropped_nodes,
-                    apr_pstrdup(apr_hash_pool_get(pb->dropped_nodes),
-                                node_path),
-                    (void *)1);
+      if (pb->dropped_nodes && !svn_hash_gets(pb->dropped_nodes, node_path))
+        svn_hash_sets(pb->dropped_nodes,
+                      apr_pstrdup(apr_hash_pool_get(pb->dropped_nodes),
+                                  node_path),
+                      (void *)1);
       nb->rb->had_dropped_nodes = TRUE;
     }
   else
@@ -501,7 +614,7 @@ new_node_record(void **node_baton,
 
       /* Test if this node was copied from dropped source. */
       if (copyfrom_path &&
-          skip_path(copyfrom_path, pb->prefixes, pb->do_exclude, pb->glob))
+          skip_path(copyfrom_path, pb))
         {
           /* This node was copied from a dropped source.
              We have a problem, since we did not want to drop this node too.
@@ -605,9 +718,7 @@ new_node_record(void **node_baton,
               struct revmap_t *cf_renum_val;
 
               cf_orig_rev = SVN_STR_TO_REV(val);
-              cf_renum_val = apr_hash_get(pb->renumber_history,
-                                          &cf_orig_rev,
-                                          sizeof(cf_orig_rev));
+              cf_renum_val = get_revmap(pb, cf_orig_rev);
               if (! (cf_renum_val && SVN_IS_VALID_REVNUM(cf_renum_val->rev)))
                 return svn_error_createf
                   (SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
@@ -674,7 +785,7 @@ adjust_mergeinfo(svn_string_t **final_val, const svn_string_t *initial_val,
       struct parse_baton_t *pb = rb->pb;
 
       /* Determine whether the merge_source is a part of the prefix. */
-      if (skip_path(merge_source, pb->prefixes, pb->do_exclude, pb->glob))
+      if (skip_path(merge_source, pb))
         {
           if (pb->skip_missing_merge_sources)
             continue;
@@ -697,15 +808,13 @@ adjust_mergeinfo(svn_string_t **final_val, const svn_string_t *initial_val,
               svn_merge_range_t *range = APR_ARRAY_IDX(rangelist, i,
                                                        svn_merge_range_t *);
 
-              revmap_start = apr_hash_get(pb->renumber_history,
-                                          &range->start, sizeof(range->start));
+              revmap_start = get_revmap(pb, range->start);
               if (! (revmap_start && SVN_IS_VALID_REVNUM(revmap_start->rev)))
                 return svn_error_createf
                   (SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
                    _("No valid revision range 'start' in filtered stream"));
 
-              revmap_end = apr_hash_get(pb->renumber_history,
-                                        &range->end, sizeof(range->end));
+              revmap_end = get_revmap(pb, range->end);
               if (! (revmap_end && SVN_IS_VALID_REVNUM(revmap_end->rev)))
                 return svn_error_createf
                   (SVN_ERR_NODE_UNEXPECTED_KIND, NULL,
@@ -1058,10 +1167,14 @@ parse_baton_initialize(struct parse_baton_t **pb,
   baton->quiet = opt_state->quiet;
   baton->glob = opt_state->glob;
   baton->prefixes = opt_state->prefixes;
+  baton->prefix_trie = opt_state->glob
+                     ? NULL
+                     : build_prefix_trie(opt_state->prefixes, pool);
   baton->skip_missing_merge_sources = opt_state->skip_missing_merge_sources;
   baton->rev_drop_count = 0; /* used to shift revnums while filtering */
-  baton->dropped_nodes = apr_hash_make(pool);
-  baton->renumber_history = apr_hash_make(pool);
+  baton->dropped_nodes = opt_state->quiet ? NULL : apr_hash_make(pool);
+  baton->renumber_history = apr_array_make(pool, 0, sizeof(struct revmap_t));
+  baton->renumber_base = 0;
   baton->last_live_revision = SVN_INVALID_REVNUM;
   baton->oldest_original_rev = SVN_INVALID_REVNUM;
   baton->allow_deltas = FALSE;
@@ -1196,28 +1309,17 @@ do_filter(apr_getopt_t *os,
       SVN_ERR(svn_cmdline_fputs(_("Revisions renumbered as follows:\n"),
                                 stderr, subpool));
 
-      /* Get the keys of the hash, sort them, then print the hash keys
-         and values, sorted by keys. */
-      num_keys = apr_hash_count(pb->renumber_history);
-      keys = apr_array_make(pool, num_keys + 1, sizeof(svn_revnum_t));
-      for (hi = apr_hash_first(pool, pb->renumber_history);
-           hi;
-           hi = apr_hash_next(hi))
+      /* The history is already sorted by original revision. */
+      for (i = 0; i < pb->renumber_history->nelts; i++)
         {
-          const svn_revnum_t *revnum = apr_hash_this_key(hi);
+          svn_revnum_t this_key = pb->renumber_base + i;
+          struct revmap_t *this_val
+            = &APR_ARRAY_IDX(pb->renumber_history, i, struct revmap_t);
 
-          APR_ARRAY_PUSH(keys, svn_revnum_t) = *revnum;
-        }
-      svn_sort__array(keys, svn_sort_compare_revisions);
-      for (i = 0; i < keys->nelts; i++)
-        {
-          svn_revnum_t this_key;
-          struct revmap_t *this_val;
+          if (! this_val->known)
+            continue;
 
           svn_pool_clear(subpool);
-          this_key = APR_ARRAY_IDX(keys, i, svn_revnum_t);
-          this_val = apr_hash_get(pb->renumber_history, &this_key,
-                                  sizeof(this_key));
           if (this_val->was_dropped)
             SVN_ERR(svn_cmdline_fprintf(stderr, subpool,
                                         _("   %ld => (dropped)\n"),
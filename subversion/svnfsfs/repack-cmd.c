@@ -0,0 +1,75 @@
+/* repack-cmd.c -- reorder the items within existing pack files
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_pools.h"
+#include "private/svn_fs_fs_private.h"
+
+#include "svn_private_config.h"
+
+#include "svnfsfs.h"
+
+/* Print the first REVISION of the shard that is about to be rewritten.
+ * This implements svn_fs_progress_notify_func_t. */
+static void
+print_progress(svn_revnum_t revision,
+               void *baton,
+               apr_pool_t *pool)
+{
+  printf(_("Repacking shard starting at r%ld ...\n"), revision);
+  fflush(stdout);
+}
+
+/* This implements `svn_opt_subcommand_t'. */
+svn_error_t *
+subcommand__repack(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  svnfsfs__opt_state *opt_state = baton;
+  svn_fs_t *fs;
+  svn_fs_fs__ioctl_repack_input_t input = { 0 };
+
+  if (opt_state->layout == NULL)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, NULL,
+                            _("The --layout option is required"));
+
+  if (strcmp(opt_state->layout, "head-locality"))
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("Unknown layout '%s'"), opt_state->layout);
+
+  if (opt_state->start_revision.kind == svn_opt_revision_number)
+    input.revision = opt_state->start_revision.value.number;
+  else if (   opt_state->start_revision.kind == svn_opt_revision_unspecified
+           || opt_state->start_revision.kind == svn_opt_revision_head)
+    input.revision = SVN_INVALID_REVNUM;
+  else
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("Revision must be a number or HEAD"));
+
+  SVN_ERR(open_fs(&fs, opt_state->repository_path, pool));
+
+  if (!opt_state->quiet)
+    input.notify_func = print_progress;
+
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_REPACK, &input, NULL,
+                       check_cancel, NULL, pool, pool));
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,102 @@
+/* replay-trace-cmd.c -- replay a recorded FSFS access trace
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_dirent_uri.h"
+#include "svn_pools.h"
+#include "svn_utf.h"
+#include "private/svn_fs_fs_private.h"
+
+#include "svn_private_config.h"
+
+#include "svnfsfs.h"
+
+/* Return HITS as a percentage of TOTAL. */
+static int
+percentage(apr_uint64_t hits,
+           apr_uint64_t total)
+{
+  return total ? (int)(hits * 100 / total) : 0;
+}
+
+/* Print the summary of the replayed trace in OUTPUT and the I/O
+ * statistics STATS of the replay that took ELAPSED microseconds. */
+static void
+print_results(const svn_fs_fs__ioctl_replay_trace_output_t *output,
+              const svn_fs_io_stats_t *stats,
+              apr_interval_time_t elapsed)
+{
+  printf(_("Recorded:\n"));
+  printf(_("%12" APR_UINT64_T_FMT " node revisions (%d%% cache hits)\n"),
+         output->noderevs, percentage(output->noderev_hits,
+                                      output->noderevs));
+  printf(_("%12" APR_UINT64_T_FMT " changed paths lists (%d%% cache hits)\n"),
+         output->changes, percentage(output->changes_hits,
+                                     output->changes));
+  printf(_("%12" APR_UINT64_T_FMT " representations (%d%% cache hits)\n"),
+         output->contents, percentage(output->contents_hits,
+                                      output->contents));
+  printf(_("%12" APR_UINT64_T_FMT " reads of %" APR_UINT64_T_FMT
+           " bytes\n"),
+         output->reads, output->bytes_read);
+  if (output->skipped)
+    printf(_("%12" APR_UINT64_T_FMT " records skipped\n"), output->skipped);
+
+  printf(_("\nReplayed in %.3f seconds:\n"), (double)elapsed / 1000000.0);
+  printf(_("%12" APR_UINT64_T_FMT " cache lookups (%d%% hits)\n"),
+         stats->cache_gets, percentage(stats->cache_hits,
+                                       stats->cache_gets));
+  printf(_("%12" APR_UINT64_T_FMT " files opened\n"), stats->files_opened);
+  printf(_("%12" APR_UINT64_T_FMT " index lookups\n"), stats->index_lookups);
+  printf(_("%12" APR_UINT64_T_FMT " items read\n"), stats->items_read);
+  printf(_("%12" APR_UINT64_T_FMT " bytes read\n"), stats->bytes_read);
+}
+
+/* This implements `svn_opt_subcommand_t'. */
+svn_error_t *
+subcommand__replay_trace(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  svnfsfs__opt_state *opt_state = baton;
+  svn_fs_t *fs;
+  svn_fs_fs__ioctl_replay_trace_input_t input = { 0 };
+  svn_fs_fs__ioctl_replay_trace_output_t *output;
+  svn_fs_io_stats_t *stats;
+  const char *trace_path;
+  apr_time_t start;
+
+  if (os->ind >= os->argc)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, NULL,
+                            _("Trace file argument required"));
+
+  SVN_ERR(svn_utf_cstring_to_utf8(&trace_path, os->argv[os->ind++], pool));
+  input.path = svn_dirent_internal_style(trace_path, pool);
+
+  SVN_ERR(open_fs(&fs, opt_state->repository_path, pool));
+
+  start = apr_time_now();
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_REPLAY_TRACE, &input,
+                       (void **)&output, check_cancel, NULL, pool, pool));
+  SVN_ERR(svn_fs_get_io_stats(&stats, fs, pool));
+
+  print_results(output, stats, apr_time_now() - start);
+
+  return SVN_NO_ERROR;
+}
@@ -0,0 +1,106 @@
+/* reshard-cmd.c -- write a copy of an FSFS repository with a new shard size
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#include "svn_dirent_uri.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+#include "private/svn_fs_fs_private.h"
+
+#include "svn_private_config.h"
+
+#include "svnfsfs.h"
+
+/* Name of the resharded copy within the repository folder. */
+#define RESHARD_DIR "db.reshard"
+
+/* Print the revision range that has just been copied.
+ * This implements svn_fs_hotcopy_notify_t. */
+static void
+print_copied(void *baton,
+             svn_revnum_t start_revision,
+             svn_revnum_t end_revision,
+             apr_pool_t *scratch_pool)
+{
+  if (start_revision == end_revision)
+    printf(_("* Copied revision %ld.\n"), start_revision);
+  else
+    printf(_("* Copied revisions from %ld to %ld.\n"),
+           start_revision, end_revision);
+
+  fflush(stdout);
+}
+
+/* Print the progress of packing the copy.
+ * This implements svn_fs_pack_notify_t. */
+static svn_error_t *
+print_packed(void *baton,
+             apr_int64_t shard,
+             svn_fs_pack_notify_action_t action,
+             apr_pool_t *pool)
+{
+  if (action == svn_fs_pack_notify_start)
+    printf(_("Packing revisions in shard %" APR_INT64_T_FMT "...\n"), shard);
+
+  fflush(stdout);
+  return SVN_NO_ERROR;
+}
+
+/* This implements `svn_opt_subcommand_t'. */
+svn_error_t *
+subcommand__reshard(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  svnfsfs__opt_state *opt_state = baton;
+  svn_fs_t *fs;
+  svn_fs_fs__ioctl_reshard_input_t input = { 0 };
+  svn_error_t *err;
+
+  if (os->ind >= os->argc)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, NULL,
+                            _("Shard size argument required"));
+
+  err = svn_cstring_atoi(&input.max_files_per_dir, os->argv[os->ind++]);
+  if (err)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                            _("Non-numeric shard size given"));
+  if (input.max_files_per_dir <= 0)
+    return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                            _("Shard size must be positive"));
+
+  input.path = svn_dirent_join(opt_state->repository_path, RESHARD_DIR,
+                               pool);
+  input.jobs = opt_state->jobs;
+  if (!opt_state->quiet)
+    {
+      input.notify_func = print_copied;
+      input.pack_notify_func = print_packed;
+    }
+
+  SVN_ERR(open_fs(&fs, opt_state->repository_path, pool));
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_RESHARD, &input, NULL,
+                       check_cancel, NULL, pool, pool));
+
+  if (!opt_state->quiet)
+    printf(_("\nThe resharded copy in '%s' is up to date.\n"),
+           svn_dirent_local_style(input.path, pool));
+
+  return SVN_NO_ERROR;
+}
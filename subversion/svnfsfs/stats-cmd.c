@@ -397,6 +397,11 @@ print_stats(svn_fs_fs__stats_t *stats,
                          pool),
          svn__ui64toa_sep(stats->total_rep_stats.expanded_size, ',', pool));
 
+  if (stats->scanned_revision_count < stats->revision_count)
+    printf(_("\nAll figures but the largest changes have been extrapolated\n"
+             "from a sample of %s revisions.\n"),
+           svn__ui64toa_sep(stats->scanned_revision_count, ',', pool));
+
   printf("\nNoderev statistics:\n");
   printf(_("%20s bytes in %12s nodes total\n"
            "%20s bytes in %12s directory noderevs\n"
@@ -508,6 +513,8 @@ subcommand__stats(apr_getopt_t *os, void *baton, apr_pool_t *pool)
   SVN_ERR(open_fs(&fs, opt_state->repository_path, pool));
 
   input.progress_func = print_progress;
+  input.jobs = opt_state->jobs;
+  input.sample = opt_state->sample;
   SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_GET_STATS, &input, (void **)&output,
                        check_cancel, NULL, pool, pool));
   print_stats(output->stats, pool);
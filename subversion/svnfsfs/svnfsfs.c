@@ -76,7 +76,10 @@ check_lib_versions(void)
 
 enum svnfsfs__cmdline_options_t
   {
-    svnfsfs__version = SVN_OPT_FIRST_LONGOPT_ID
+    svnfsfs__version = SVN_OPT_FIRST_LONGOPT_ID,
+    svnfsfs__jobs,
+    svnfsfs__sample,
+    svnfsfs__layout
   };
 
 /* Option codes and descriptions.
@@ -104,6 +107,17 @@ static const apr_getopt_option_t options_table[] =
      N_("size of the extra in-memory cache in MB used to\n"
         "                             minimize redundant operations. Default: 16.")},
 
+    {"jobs",          svnfsfs__jobs, 1,
+     N_("use up to ARG worker threads (default: 1)")},
+
+    {"sample",        svnfsfs__sample, 1,
+     N_("scan only every ARG-th shard and extrapolate\n"
+        "                             the results (default: 1)")},
+
+    {"layout",        svnfsfs__layout, 1,
+     N_("item order to produce; ARG can be:\n"
+        "                                head-locality")},
+
     {NULL}
   };
 
@@ -162,12 +176,57 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
    )},
    {'M'} },
 
+  {"repack", subcommand__repack, {0}, {N_(
+    "usage: svnfsfs repack REPOS_PATH --layout=head-locality [-r REV]\n"
+    "\n"), N_(
+    "Rewrite the existing pack files such that the node revisions and\n"
+    "representations needed to read the tree of revision REV (default: HEAD)\n"
+    "are stored contiguously, in tree order, at the start of each pack file.\n"
+    "This speeds up checkouts and exports of that revision on cold caches.\n"
+    "Items never move between pack files.  The repository remains fully\n"
+    "usable while the command runs, so it may be run in the background.\n"
+   )},
+   {svnfsfs__layout, 'r', 'q', 'M'} },
+
+  {"replay-trace", subcommand__replay_trace, {0}, {N_(
+    "usage: svnfsfs replay-trace REPOS_PATH TRACE_FILE\n"
+    "\n"), N_(
+    "Request all node revisions, changed paths lists and file contents recorded\n"
+    "in TRACE_FILE from the repository, in the recorded order, and show the\n"
+    "resulting cache efficiency and I/O.  Traces are written by repositories\n"
+    "that have the 'access-trace' option set in the [debug] section of their\n"
+    "fsfs.conf.  Replay them against a copy of the repository to compare the\n"
+    "effect of different --memory-cache-size values or fsfs.conf settings such\n"
+    "as the block size.\n"
+   )},
+   {'M'} },
+
+  {"reshard", subcommand__reshard, {0}, {N_(
+    "usage: svnfsfs reshard REPOS_PATH SHARD_SIZE\n"
+    "\n"), N_(
+    "Write a copy of the repository's filesystem that uses SHARD_SIZE revisions\n"
+    "per shard to REPOS_PATH/db.reshard.  Revisions are cut out of existing pack\n"
+    "files, their indexes are rebuilt and the copy gets packed again if the\n"
+    "repository is packed.  The repository remains fully usable while this\n"
+    "runs.  Running the command again only copies the revisions that have\n"
+    "been committed since.\n"
+    "\n"), N_(
+    "To switch to the new layout, make the repository inaccessible, run this\n"
+    "command once more and replace REPOS_PATH/db with REPOS_PATH/db.reshard.\n"
+    "\n"
+    "If --jobs is given, process multiple shards concurrently.\n"
+   )},
+   {svnfsfs__jobs, 'q', 'M'} },
+
   {"stats", subcommand__stats, {0}, {N_(
     "usage: svnfsfs stats REPOS_PATH\n"
     "\n"), N_(
     "Write object size statistics to console.\n"
+    "\n"
+    "If --jobs is given, scan multiple shards concurrently.  With --sample N,\n"
+    "scan only every N-th shard and extrapolate the sizes and counts from it.\n"
    )},
-   {'M'} },
+   {'M', svnfsfs__jobs, svnfsfs__sample} },
 
   { NULL, NULL, {0}, {NULL}, {0} }
 };
@@ -259,6 +318,8 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   opt_state.start_revision.kind = svn_opt_revision_unspecified;
   opt_state.end_revision.kind = svn_opt_revision_unspecified;
   opt_state.memory_cache_size = svn_cache_config_get()->cache_size;
+  opt_state.jobs = 1;
+  opt_state.sample = 1;
 
   /* Parse options. */
   SVN_ERR(svn_cmdline__getopt_init(&os, argc, argv, pool));
@@ -320,6 +381,31 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           opt_state.memory_cache_size = 0x100000 * sz_val;
         }
         break;
+      case svnfsfs__jobs:
+        {
+          svn_error_t *err = svn_cstring_atoi(&opt_state.jobs, opt_arg);
+          if (err)
+            return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                                    _("Non-numeric jobs argument given"));
+          if (opt_state.jobs <= 0)
+            return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                    _("Argument to --jobs must be positive"));
+        }
+        break;
+      case svnfsfs__sample:
+        {
+          svn_error_t *err = svn_cstring_atoi(&opt_state.sample, opt_arg);
+          if (err)
+            return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, err,
+                                    _("Non-numeric sample argument given"));
+          if (opt_state.sample <= 0)
+            return svn_error_create(SVN_ERR_INCORRECT_PARAMS, NULL,
+                                    _("Argument to --sample must be positive"));
+        }
+        break;
+      case svnfsfs__layout:
+        SVN_ERR(svn_utf_cstring_to_utf8(&opt_state.layout, opt_arg, pool));
+        break;
       case svnfsfs__version:
         opt_state.version = TRUE;
         break;
@@ -449,7 +535,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     svn_cache_config_t settings = *svn_cache_config_get();
 
     settings.cache_size = opt_state.memory_cache_size;
-    settings.single_threaded = TRUE;
+    settings.single_threaded = opt_state.jobs <= 1;
 
     svn_cache_config_set(&settings);
   }
@@ -45,6 +45,9 @@ typedef struct svnfsfs__opt_state
   svn_boolean_t version;                            /* --version */
   svn_boolean_t quiet;                              /* --quiet */
   apr_uint64_t memory_cache_size;                   /* --memory-cache-size M */
+  int jobs;                                         /* --jobs */
+  int sample;                                       /* --sample */
+  const char *layout;                               /* --layout */
 } svnfsfs__opt_state;
 
 /* Declare all the command procedures */
@@ -52,6 +55,9 @@ svn_opt_subcommand_t
   subcommand__help,
   subcommand__dump_index,
   subcommand__load_index,
+  subcommand__repack,
+  subcommand__replay_trace,
+  subcommand__reshard,
   subcommand__stats;
 
 
@@ -59,6 +59,7 @@
 #include "private/svn_fspath.h"
 #include "private/svn_io_private.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_utf_private.h"
 
 #include "svn_private_config.h"
 
@@ -79,6 +80,7 @@ static svn_opt_subcommand_t
   subcommand_help,
   subcommand_history,
   subcommand_info,
+  subcommand_json,
   subcommand_lock,
   subcommand_log,
   subcommand_pget,
@@ -103,7 +105,8 @@ enum
     svnlook__properties_only,
     svnlook__diff_cmd,
     svnlook__show_inherited_props,
-    svnlook__no_newline
+    svnlook__no_newline,
+    svnlook__with_diff
   };
 
 /*
@@ -181,6 +184,9 @@ static const apr_getopt_option_t options_table[] =
   {"xml",               svnlook__xml_opt, 0,
    N_("output in XML")},
 
+  {"with-diff",         svnlook__with_diff, 0,
+   N_("include the differences of each revision")},
+
   {"extensions",        'x', 1,
    N_("Specify differencing options for external diff or\n"
       "                             "
@@ -289,6 +295,23 @@ static const svn_opt_subcommand_desc3_t cmd_table[] =
    )},
    {'r', 't'} },
 
+  {"json", subcommand_json, {0}, {N_(
+      "usage: svnlook json REPOS_PATH\n"
+      "\n"), N_(
+      "Print one line of JSON for each revision in the range given with\n"
+      "-r LOWER[:UPPER] (the youngest revision by default) or for the\n"
+      "transaction given with -t.  Each line holds the revision number or\n"
+      "transaction name, author, datestamp, log message and the changed\n"
+      "paths with their action, node kind, modifications, copy source and\n"
+      "file size.\n"
+      "With -v, also show the revision properties and the properties of\n"
+      "the changed paths.  With --with-diff, also show the differences as\n"
+      "printed by 'svnlook diff'.\n"
+   )},
+   {'r', 't', 'v', svnlook__with_diff, svnlook__no_diff_deleted,
+    svnlook__no_diff_added, svnlook__diff_copy_from, 'x',
+    svnlook__ignore_properties, svnlook__properties_only, 'M'} },
+
   {"lock", subcommand_lock, {0}, {N_(
       "usage: svnlook lock REPOS_PATH PATH_IN_REPOS\n"
       "\n"), N_(
@@ -360,6 +383,7 @@ struct svnlook_opt_state
   const char *arg1;        /* Usually an fs path, a propname, or NULL. */
   const char *arg2;        /* Usually an fs path or NULL. */
   svn_revnum_t rev;
+  svn_revnum_t end_rev;    /* Upper end of a -r LOWER:UPPER range. */
   const char *txn;
   svn_boolean_t version;          /* --version */
   svn_boolean_t show_ids;         /* --show-ids */
@@ -381,6 +405,7 @@ struct svnlook_opt_state
   const char *diff_cmd;           /* --diff-cmd */
   svn_boolean_t show_inherited_props; /*  --show-inherited-props */
   svn_boolean_t no_newline;       /* --no-newline */
+  svn_boolean_t with_diff;        /* --with-diff */
   apr_uint64_t memory_cache_size; /* --memory-cache-size */
 };
 
@@ -2062,6 +2087,324 @@ do_tree(svnlook_ctxt_t *c,
 }
 
 
+/* Append the JSON string literal for the LEN bytes at DATA to BUF.
+   Data that is not valid UTF-8 gets escaped by svn_utf__fuzzy_escape()
+   first, using SCRATCH_POOL. */
+static void
+json_append_string(svn_stringbuf_t *buf,
+                   const char *data,
+                   apr_size_t len,
+                   apr_pool_t *scratch_pool)
+{
+  static const char hex[] = "0123456789abcdef";
+  apr_size_t i;
+
+  if (! svn_utf__is_valid(data, len))
+    {
+      data = svn_utf__fuzzy_escape(data, len, scratch_pool);
+      len = strlen(data);
+    }
+
+  svn_stringbuf_appendbyte(buf, '"');
+  for (i = 0; i < len; i++)
+    {
+      unsigned char ch = (unsigned char)data[i];
+
+      switch (ch)
+        {
+          case '"':
+            svn_stringbuf_appendbytes(buf, "\\\"", 2);
+            break;
+          case '\\':
+            svn_stringbuf_appendbytes(buf, "\\\\", 2);
+            break;
+          case '\n':
+            svn_stringbuf_appendbytes(buf, "\\n", 2);
+            break;
+          case '\r':
+            svn_stringbuf_appendbytes(buf, "\\r", 2);
+            break;
+          case '\t':
+            svn_stringbuf_appendbytes(buf, "\\t", 2);
+            break;
+          default:
+            if (ch < 0x20)
+              {
+                svn_stringbuf_appendbytes(buf, "\\u00", 4);
+                svn_stringbuf_appendbyte(buf, hex[ch >> 4]);
+                svn_stringbuf_appendbyte(buf, hex[ch & 0xf]);
+              }
+            else
+              svn_stringbuf_appendbyte(buf, (char)ch);
+        }
+    }
+  svn_stringbuf_appendbyte(buf, '"');
+}
+
+/* Append ",\"NAME\":" to BUF. */
+static void
+json_append_key(svn_stringbuf_t *buf,
+                const char *name)
+{
+  svn_stringbuf_appendcstr(buf, ",\"");
+  svn_stringbuf_appendcstr(buf, name);
+  svn_stringbuf_appendcstr(buf, "\":");
+}
+
+/* Append the JSON object for the property hash PROPS to BUF, sorted by
+   property name.  Use SCRATCH_POOL for temporaries. */
+static void
+json_append_props(svn_stringbuf_t *buf,
+                  apr_hash_t *props,
+                  apr_pool_t *scratch_pool)
+{
+  apr_array_header_t *sorted
+    = svn_sort__hash(props, svn_sort_compare_items_lexically, scratch_pool);
+  int i;
+
+  svn_stringbuf_appendbyte(buf, '{');
+  for (i = 0; i < sorted->nelts; i++)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      const svn_string_t *value = item->value;
+
+      if (i)
+        svn_stringbuf_appendbyte(buf, ',');
+      json_append_string(buf, item->key, item->klen, scratch_pool);
+      svn_stringbuf_appendbyte(buf, ':');
+      json_append_string(buf, value->data, value->len, scratch_pool);
+    }
+  svn_stringbuf_appendbyte(buf, '}');
+}
+
+/* Sort the svn_fs_path_change3_t * in an array by path, in tree order.
+   This implements the qsort() comparison function interface. */
+static int
+compare_change_paths(const void *a,
+                     const void *b)
+{
+  const svn_fs_path_change3_t *change_a
+    = *(const svn_fs_path_change3_t *const *)a;
+  const svn_fs_path_change3_t *change_b
+    = *(const svn_fs_path_change3_t *const *)b;
+
+  return svn_path_compare_paths(change_a->path.data, change_b->path.data);
+}
+
+/* Append the JSON array of the paths changed in ROOT to BUF.  If
+   WITH_PROPS is set, include the properties of all paths that were not
+   deleted.  Use POOL for all allocations. */
+static svn_error_t *
+json_append_changes(svn_stringbuf_t *buf,
+                    svn_fs_root_t *root,
+                    svn_boolean_t with_props,
+                    apr_pool_t *pool)
+{
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+  apr_array_header_t *changes
+    = apr_array_make(pool, 16, sizeof(svn_fs_path_change3_t *));
+  int i;
+
+  SVN_ERR(svn_fs_paths_changed3(&iterator, root, pool, pool));
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  while (change)
+    {
+      APR_ARRAY_PUSH(changes, svn_fs_path_change3_t *)
+        = svn_fs_path_change3_dup(change, pool);
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
+  svn_sort__array(changes, compare_change_paths);
+
+  svn_stringbuf_appendbyte(buf, '[');
+  for (i = 0; i < changes->nelts; i++)
+    {
+      const char *path;
+      const char *action;
+      svn_node_kind_t kind;
+      svn_revnum_t copyfrom_rev = SVN_INVALID_REVNUM;
+      const char *copyfrom_path = NULL;
+
+      SVN_ERR(check_cancel(NULL));
+
+      change = APR_ARRAY_IDX(changes, i, svn_fs_path_change3_t *);
+      path = change->path.data;
+      kind = change->node_kind;
+
+      switch (change->change_kind)
+        {
+          case svn_fs_path_change_add:
+            action = "A";
+            break;
+          case svn_fs_path_change_delete:
+            action = "D";
+            break;
+          case svn_fs_path_change_replace:
+            action = "R";
+            break;
+          default:
+            action = "M";
+        }
+
+      if (kind == svn_node_unknown
+          && change->change_kind != svn_fs_path_change_delete)
+        SVN_ERR(svn_fs_check_path(&kind, root, path, pool));
+
+      if (change->copyfrom_known)
+        {
+          copyfrom_rev = change->copyfrom_rev;
+          copyfrom_path = change->copyfrom_path;
+        }
+      else if (change->change_kind == svn_fs_path_change_add
+               || change->change_kind == svn_fs_path_change_replace)
+        SVN_ERR(svn_fs_copied_from(&copyfrom_rev, &copyfrom_path,
+                                   root, path, pool));
+
+      if (i)
+        svn_stringbuf_appendbyte(buf, ',');
+      svn_stringbuf_appendcstr(buf, "{\"path\":");
+      json_append_string(buf, path, change->path.len, pool);
+      json_append_key(buf, "action");
+      json_append_string(buf, action, 1, pool);
+      json_append_key(buf, "kind");
+      json_append_string(buf, svn_node_kind_to_word(kind),
+                         strlen(svn_node_kind_to_word(kind)), pool);
+      json_append_key(buf, "text_mod");
+      svn_stringbuf_appendcstr(buf, change->text_mod ? "true" : "false");
+      json_append_key(buf, "props_mod");
+      svn_stringbuf_appendcstr(buf, change->prop_mod ? "true" : "false");
+
+      if (copyfrom_path && SVN_IS_VALID_REVNUM(copyfrom_rev))
+        {
+          json_append_key(buf, "copyfrom_path");
+          json_append_string(buf, copyfrom_path, strlen(copyfrom_path),
+                             pool);
+          json_append_key(buf, "copyfrom_rev");
+          svn_stringbuf_appendcstr(buf, apr_psprintf(pool, "%ld",
+                                                     copyfrom_rev));
+        }
+
+      if (change->change_kind != svn_fs_path_change_delete)
+        {
+          if (kind == svn_node_file)
+            {
+              svn_filesize_t size;
+
+              SVN_ERR(svn_fs_file_length(&size, root, path, pool));
+              json_append_key(buf, "size");
+              svn_stringbuf_appendcstr(buf,
+                                       apr_psprintf(pool,
+                                                    "%" SVN_FILESIZE_T_FMT,
+                                                    size));
+            }
+
+          if (with_props)
+            {
+              apr_hash_t *props;
+
+              SVN_ERR(svn_fs_node_proplist(&props, root, path, pool));
+              json_append_key(buf, "props");
+              json_append_props(buf, props, pool);
+            }
+        }
+
+      svn_stringbuf_appendbyte(buf, '}');
+    }
+  svn_stringbuf_appendbyte(buf, ']');
+
+  return SVN_NO_ERROR;
+}
+
+/* Write one line of JSON describing the revision or transaction in C to
+   OUT.  If WITH_PROPS is set, include the revision properties and the
+   properties of the changed paths.  If WITH_DIFF is set, include the
+   output of 'svnlook diff'.  Use POOL for all allocations. */
+static svn_error_t *
+print_json_entry(svn_stream_t *out,
+                 svnlook_ctxt_t *c,
+                 svn_boolean_t with_props,
+                 svn_boolean_t with_diff,
+                 apr_pool_t *pool)
+{
+  static const char *const summary_props[]
+    = { SVN_PROP_REVISION_AUTHOR, SVN_PROP_REVISION_DATE,
+        SVN_PROP_REVISION_LOG };
+  static const char *const summary_keys[] = { "author", "date", "log" };
+  svn_stringbuf_t *buf = svn_stringbuf_create_ensure(256, pool);
+  apr_hash_t *revprops;
+  svn_fs_root_t *root;
+  apr_size_t len;
+  apr_size_t i;
+
+  if (c->is_revision)
+    {
+      svn_stringbuf_appendcstr(buf, apr_psprintf(pool, "{\"revision\":%ld",
+                                                 c->rev_id));
+      SVN_ERR(svn_fs_revision_proplist2(&revprops, c->fs, c->rev_id, TRUE,
+                                        pool, pool));
+    }
+  else
+    {
+      svn_stringbuf_appendcstr(buf, "{\"transaction\":");
+      json_append_string(buf, c->txn_name, strlen(c->txn_name), pool);
+      SVN_ERR(svn_fs_txn_proplist(&revprops, c->txn, pool));
+    }
+
+  for (i = 0; i < sizeof(summary_keys) / sizeof(summary_keys[0]); i++)
+    {
+      const svn_string_t *value = svn_hash_gets(revprops, summary_props[i]);
+
+      json_append_key(buf, summary_keys[i]);
+      if (value)
+        json_append_string(buf, value->data, value->len, pool);
+      else
+        svn_stringbuf_appendcstr(buf, "null");
+    }
+
+  if (with_props)
+    {
+      json_append_key(buf, "revprops");
+      json_append_props(buf, revprops, pool);
+    }
+
+  SVN_ERR(get_root(&root, c, pool));
+  json_append_key(buf, "changes");
+  SVN_ERR(json_append_changes(buf, root, with_props, pool));
+
+  if (with_diff)
+    {
+      svn_stringbuf_t *diff = svn_stringbuf_create_empty(pool);
+      svn_revnum_t base_rev_id;
+
+      SVN_ERR(get_base_rev(&base_rev_id, c, pool));
+      if (base_rev_id != SVN_INVALID_REVNUM)
+        {
+          svn_repos_node_t *tree;
+
+          SVN_ERR(generate_delta_tree(&tree, c->repos, root, base_rev_id,
+                                      pool));
+          if (tree)
+            {
+              svn_fs_root_t *base_root;
+
+              SVN_ERR(svn_fs_revision_root(&base_root, c->fs, base_rev_id,
+                                           pool));
+              SVN_ERR(print_diff_tree(svn_stream_from_stringbuf(diff, pool),
+                                      "UTF-8", root, base_root, tree,
+                                      "", "", c, pool));
+            }
+        }
+
+      json_append_key(buf, "diff");
+      json_append_string(buf, diff->data, diff->len, pool);
+    }
+
+  svn_stringbuf_appendcstr(buf, "}\n");
+  len = buf->len;
+  return svn_error_trace(svn_stream_write(out, buf->data, &len));
+}
+
+
 /* Custom filesystem warning function. */
 static void
 warning_func(void *baton,
@@ -2285,6 +2628,53 @@ subcommand_history(apr_getopt_t *os, void *baton, apr_pool_t *pool)
 }
 
 
+/* This implements `svn_opt_subcommand_t'. */
+static svn_error_t *
+subcommand_json(apr_getopt_t *os, void *baton, apr_pool_t *pool)
+{
+  struct svnlook_opt_state *opt_state = baton;
+  svnlook_ctxt_t *c;
+  svn_stream_t *out;
+  svn_revnum_t start, end, youngest, rev;
+  apr_pool_t *iterpool;
+
+  SVN_ERR(check_number_of_args(opt_state, 0));
+
+  /* One context, and with it one FS object and its caches, serves all
+     revisions of the range. */
+  SVN_ERR(get_ctxt_baton(&c, opt_state, pool));
+  SVN_ERR(svn_stream_for_stdout(&out, pool));
+
+  if (! c->is_revision)
+    return svn_error_trace(print_json_entry(out, c, opt_state->verbose,
+                                            opt_state->with_diff, pool));
+
+  start = c->rev_id;
+  end = SVN_IS_VALID_REVNUM(opt_state->end_rev) ? opt_state->end_rev : start;
+
+  SVN_ERR(svn_fs_youngest_rev(&youngest, c->fs, pool));
+  if (start > youngest || end > youngest)
+    return svn_error_createf(SVN_ERR_FS_NO_SUCH_REVISION, NULL,
+                             _("No such revision %ld"),
+                             start > youngest ? start : end);
+
+  iterpool = svn_pool_create(pool);
+  for (rev = start; ; rev += (start <= end) ? 1 : -1)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(check_cancel(NULL));
+
+      c->rev_id = rev;
+      SVN_ERR(print_json_entry(out, c, opt_state->verbose,
+                               opt_state->with_diff, iterpool));
+      if (rev == end)
+        break;
+    }
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 /* This implements `svn_opt_subcommand_t'. */
 static svn_error_t *
 subcommand_lock(apr_getopt_t *os, void *baton, apr_pool_t *pool)
@@ -2496,6 +2886,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   /* Initialize opt_state. */
   memset(&opt_state, 0, sizeof(opt_state));
   opt_state.rev = SVN_INVALID_REVNUM;
+  opt_state.end_rev = SVN_INVALID_REVNUM;
   opt_state.memory_cache_size = svn_cache_config_get()->cache_size;
 
   /* Parse options. */
@@ -2526,6 +2917,16 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           {
             char *digits_end = NULL;
             opt_state.rev = strtol(opt_arg, &digits_end, 10);
+            if (digits_end && *digits_end == ':')
+              {
+                const char *upper = digits_end + 1;
+
+                opt_state.end_rev = strtol(upper, &digits_end, 10);
+                if (digits_end == upper)
+                  opt_state.end_rev = SVN_INVALID_REVNUM;
+                if (! SVN_IS_VALID_REVNUM(opt_state.end_rev))
+                  digits_end = NULL;
+              }
             if ((! SVN_IS_VALID_REVNUM(opt_state.rev))
                 || (! digits_end)
                 || *digits_end)
@@ -2641,6 +3042,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           opt_state.no_newline = TRUE;
           break;
 
+        case svnlook__with_diff:
+          opt_state.with_diff = TRUE;
+          break;
+
         default:
           SVN_ERR(subcommand_help(NULL, NULL, pool));
           *exit_code = EXIT_FAILURE;
@@ -2817,6 +3222,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
         }
     }
 
+  /* Only 'svnlook json' iterates over revision ranges. */
+  if (SVN_IS_VALID_REVNUM(opt_state.end_rev)
+      && subcommand->cmd_func != subcommand_json)
+    return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                             _("Subcommand '%s' doesn't accept revision "
+                               "ranges"), subcommand->name);
+
   check_cancel = svn_cmdline__setup_cancellation_handler();
 
   /* Configure FSFS caches for maximum efficiency with svnadmin.
@@ -138,6 +138,21 @@ struct action {
   const svn_string_t *prop_value;
 };
 
+/* Implements svn_stream_lazyopen_func_t for the source file of a put,
+   whose path is BATON.  Opening the file only when the commit sends it
+   keeps the number of open files bounded for large action lists. */
+static svn_error_t *
+open_put_source(svn_stream_t **stream,
+                void *baton,
+                apr_pool_t *result_pool,
+                apr_pool_t *scratch_pool)
+{
+  const char *src_path = baton;
+
+  return svn_error_trace(svn_stream_open_readonly(stream, src_path,
+                                                  result_pool, scratch_pool));
+}
+
 static svn_error_t *
 execute(const apr_array_header_t *actions,
         const char *anchor,
@@ -168,31 +183,32 @@ execute(const apr_array_header_t *actions,
       switch (action->action)
         {
         case ACTION_MV:
-          path1 = subtract_anchor(anchor, action->path[0], pool);
-          path2 = subtract_anchor(anchor, action->path[1], pool);
+          path1 = subtract_anchor(anchor, action->path[0], iterpool);
+          path2 = subtract_anchor(anchor, action->path[1], iterpool);
           SVN_ERR(svn_client__mtcc_add_move(path1, path2, mtcc, iterpool));
           break;
         case ACTION_CP:
-          path1 = subtract_anchor(anchor, action->path[0], pool);
-          path2 = subtract_anchor(anchor, action->path[1], pool);
+          path1 = subtract_anchor(anchor, action->path[0], iterpool);
+          path2 = subtract_anchor(anchor, action->path[1], iterpool);
           SVN_ERR(svn_client__mtcc_add_copy(path1, action->rev, path2,
                                             mtcc, iterpool));
           break;
         case ACTION_RM:
-          path1 = subtract_anchor(anchor, action->path[0], pool);
+          path1 = subtract_anchor(anchor, action->path[0], iterpool);
           SVN_ERR(svn_client__mtcc_add_delete(path1, mtcc, iterpool));
           break;
         case ACTION_MKDIR:
-          path1 = subtract_anchor(anchor, action->path[0], pool);
+          path1 = subtract_anchor(anchor, action->path[0], iterpool);
           SVN_ERR(svn_client__mtcc_add_mkdir(path1, mtcc, iterpool));
           break;
         case ACTION_PUT:
-          path1 = subtract_anchor(anchor, action->path[0], pool);
-          SVN_ERR(svn_client__mtcc_check_path(&kind, path1, TRUE, mtcc, pool));
+          path1 = subtract_anchor(anchor, action->path[0], iterpool);
+          SVN_ERR(svn_client__mtcc_check_path(&kind, path1, TRUE, mtcc,
+                                              iterpool));
 
           if (kind == svn_node_dir)
             {
-              SVN_ERR(svn_client__mtcc_add_delete(path1, mtcc, pool));
+              SVN_ERR(svn_client__mtcc_add_delete(path1, mtcc, iterpool));
               kind = svn_node_none;
             }
 
@@ -200,8 +216,9 @@ execute(const apr_array_header_t *actions,
             svn_stream_t *src;
 
             if (strcmp(action->path[1], "-") != 0)
-              SVN_ERR(svn_stream_open_readonly(&src, action->path[1],
-                                               pool, iterpool));
+              src = svn_stream_lazyopen_create(open_put_source,
+                                               (void *)action->path[1],
+                                               FALSE, pool);
             else
               SVN_ERR(svn_stream_for_stdin2(&src, TRUE, pool));
 
@@ -217,7 +234,7 @@ execute(const apr_array_header_t *actions,
           break;
         case ACTION_PROPSET:
         case ACTION_PROPDEL:
-          path1 = subtract_anchor(anchor, action->path[0], pool);
+          path1 = subtract_anchor(anchor, action->path[0], iterpool);
           SVN_ERR(svn_client__mtcc_add_propset(path1, action->prop_name,
                                                action->prop_value, FALSE,
                                                mtcc, iterpool));
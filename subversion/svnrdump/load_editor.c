@@ -127,6 +127,16 @@ struct parse_baton
      SVN_INVALID_REVNUM if none have been loaded. */
   svn_revnum_t oldest_dumpstream_rev;
 
+  /* The youngest revision in the target repository, or
+     SVN_INVALID_REVNUM if it has not been asked for yet.  We hold the
+     load lock, so it only changes through our own commits and asking
+     for it once saves a round trip per revision. */
+  svn_revnum_t head_rev;
+
+  /* Info about the commit of the current revision, or NULL if it has
+     not been committed (yet).  Allocated in the revision's pool. */
+  svn_commit_info_t *commit_info;
+
   /* An hash containing specific revision properties to skip while
      loading. */
   apr_hash_t *skip_revprops;
@@ -333,8 +343,10 @@ new_revision_record(void **revision_baton,
   if (rev_str)
     rb->rev = SVN_STR_TO_REV(rev_str);
 
-  SVN_ERR(svn_ra_get_latest_revnum(pb->session, &rb->head_rev_before_commit,
-                                   pool));
+  if (! SVN_IS_VALID_REVNUM(pb->head_rev))
+    SVN_ERR(svn_ra_get_latest_revnum(pb->session, &pb->head_rev, pool));
+  rb->head_rev_before_commit = pb->head_rev;
+  pb->commit_info = NULL;
 
   /* FIXME: This is a lame fallback loading multiple segments of dump in
      several separate operations. It is highly susceptible to race conditions.
@@ -745,8 +757,8 @@ set_fulltext(svn_stream_t **stream,
 
   SVN_ERR(commit_editor->apply_textdelta(nb->file_baton, nb->base_checksum,
                                          pool, &handler, &handler_baton));
-  *stream = svn_txdelta_target_push(handler, handler_baton,
-                                    svn_stream_empty(pool), pool);
+  *stream = svn_txdelta_target_push2(handler, handler_baton,
+                                     svn_stream_empty(pool), FALSE, pool);
   return SVN_NO_ERROR;
 }
 
@@ -806,6 +818,18 @@ close_node(void *baton)
   return SVN_NO_ERROR;
 }
 
+/* Return TRUE if the revprop value VALUE set by the commit equals
+   EXPECTED, both of which may be NULL. */
+static svn_boolean_t
+same_value(const char *value,
+           const svn_string_t *expected)
+{
+  if (!value || !expected)
+    return !value && !expected;
+
+  return strcmp(value, expected->data) == 0;
+}
+
 static svn_error_t *
 close_revision(void *baton)
 {
@@ -858,15 +882,21 @@ close_revision(void *baton)
       committed_rev = 0;
     }
 
+  /* Values that the commit already set correctly don't need another
+     round trip. */
   if (SVN_IS_VALID_REVNUM(committed_rev))
     {
-      if (!svn_hash_gets(rb->pb->skip_revprops, SVN_PROP_REVISION_DATE))
+      const svn_commit_info_t *commit_info = rb->pb->commit_info;
+
+      if (!svn_hash_gets(rb->pb->skip_revprops, SVN_PROP_REVISION_DATE)
+          && !(commit_info && same_value(commit_info->date, rb->datestamp)))
         {
           SVN_ERR(svn_ra_change_rev_prop2(rb->pb->session, committed_rev,
                                           SVN_PROP_REVISION_DATE,
                                           NULL, rb->datestamp, rb->pool));
         }
-      if (!svn_hash_gets(rb->pb->skip_revprops, SVN_PROP_REVISION_AUTHOR))
+      if (!svn_hash_gets(rb->pb->skip_revprops, SVN_PROP_REVISION_AUTHOR)
+          && !(commit_info && same_value(commit_info->author, rb->author)))
         {
           SVN_ERR(svn_ra_change_rev_prop2(rb->pb->session, committed_rev,
                                           SVN_PROP_REVISION_AUTHOR,
@@ -874,6 +904,7 @@ close_revision(void *baton)
         }
     }
 
+  rb->pb->commit_info = NULL;
   svn_pool_destroy(rb->pool);
 
   return SVN_NO_ERROR;
@@ -888,6 +919,9 @@ struct commit_baton_t
 {
   svn_revnum_t rev;
   struct parse_baton *pb;
+
+  /* Pool of the revision being committed. */
+  apr_pool_t *pool;
 };
 
 /*
@@ -911,6 +945,11 @@ commit_callback(const svn_commit_info_t *commit_info,
   /* Add the mapping of the dumpstream revision to the committed revision. */
   set_revision_mapping(pb->rev_map, cb->rev, commit_info->revision);
 
+  /* Remember what the commit did, so close_revision() can skip revprop
+     changes, and that it moved HEAD. */
+  pb->commit_info = svn_commit_info_dup(commit_info, cb->pool);
+  pb->head_rev = commit_info->revision;
+
   /* If the incoming dump stream has non-contiguous revisions (e.g. from
      using svndumpfilter --drop-empty-revs without --renumber-revs) then
      we must account for the missing gaps in PB->REV_MAP.  Otherwise we
@@ -1075,6 +1114,7 @@ revstart(svn_revnum_t revision,
 
   cb->rev = revision;
   cb->pb = pb;
+  cb->pool = result_pool;
   SVN_ERR(svn_ra__register_editor_shim_callbacks(pb->session,
                                                  get_shim_callbacks(cb, result_pool)));
   SVN_ERR(svn_ra_get_commit_editor3(pb->session,
@@ -1139,6 +1179,7 @@ get_dumpstream_loader(svn_repos_parse_fns3_t **parser_p,
   parse_baton->rev_map = apr_hash_make(pool);
   parse_baton->last_rev_mapped = SVN_INVALID_REVNUM;
   parse_baton->oldest_dumpstream_rev = SVN_INVALID_REVNUM;
+  parse_baton->head_rev = SVN_INVALID_REVNUM;
   parse_baton->skip_revprops = skip_revprops;
   parse_baton->callbacks = &callbacks;
   parse_baton->cb_baton = parse_baton;
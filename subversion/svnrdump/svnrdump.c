@@ -67,6 +67,7 @@ enum svn_svnrdump__longopt_t
     opt_incremental,
     opt_trust_server_cert,
     opt_trust_server_cert_failures,
+    opt_prefetch,
     opt_version
   };
 
@@ -89,8 +90,12 @@ static const svn_opt_subcommand_desc3_t svnrdump__cmd_table[] =
        "Dump revisions LOWER to UPPER of repository at remote URL to stdout\n"
        "in a 'dumpfile' portable format.  If only LOWER is given, dump that\n"
        "one revision.\n"
+       "\n"), N_(
+       "With --prefetch N, up to N revisions are fetched in parallel over\n"
+       "separate sessions.  The output is still written in revision order.\n"
     )},
-    { 'r', 'q', opt_incremental, 'F', SVN_SVNRDUMP__BASE_OPTIONS },
+    { 'r', 'q', opt_incremental, opt_prefetch, 'F',
+      SVN_SVNRDUMP__BASE_OPTIONS },
     {{'F', N_("write to file ARG instead of stdout")}} },
   { "load", load_cmd, { 0 }, {N_(
        "usage: svnrdump load URL\n"
@@ -116,6 +121,10 @@ static const apr_getopt_option_t svnrdump__options[] =
                       N_("no progress (only errors) to stderr")},
     {"incremental",   opt_incremental, 0,
                       N_("dump incrementally")},
+    {"prefetch",      opt_prefetch, 1,
+                      N_("fetch up to ARG revisions in parallel\n"
+                         "                             "
+                         "(default: 1)")},
     {"skip-revprop",  opt_skip_revprop, 1,
                       N_("skip revision property ARG (e.g., \"svn:author\")")},
     {"config-dir",    opt_config_dir, 1,
@@ -195,6 +204,7 @@ typedef struct opt_baton_t {
   svn_opt_revision_t end_revision;
   svn_boolean_t quiet;
   svn_boolean_t incremental;
+  int prefetch;
   apr_hash_t *skip_revprops;
 } opt_baton_t;
 
@@ -470,10 +480,14 @@ dump_initial_full_revision(svn_ra_session_t *session,
  * which generate Subversion repository dumpstreams describing the
  * changes made in those revisions.  If QUIET is set, don't generate
  * progress messages.
+ *
+ * If PREFETCH_SESSIONS is not NULL, it contains additional sessions to
+ * the same URL that are used to fetch as many revisions in parallel.
  */
 static svn_error_t *
 replay_revisions(svn_ra_session_t *session,
                  svn_ra_session_t *extra_ra_session,
+                 apr_array_header_t *prefetch_sessions,
                  svn_revnum_t start_revision,
                  svn_revnum_t end_revision,
                  svn_boolean_t quiet,
@@ -537,9 +551,16 @@ replay_revisions(svn_ra_session_t *session,
   if (start_revision <= end_revision)
     {
 #ifndef USE_EV2_IMPL
-      SVN_ERR(svn_ra_replay_range(session, start_revision, end_revision,
-                                  0, TRUE, replay_revstart, replay_revend,
-                                  replay_baton, pool));
+      if (prefetch_sessions && start_revision < end_revision)
+        SVN_ERR(svn_ra__replay_range_prefetched(prefetch_sessions,
+                                                start_revision, end_revision,
+                                                0, TRUE, replay_revstart,
+                                                replay_revend, replay_baton,
+                                                check_cancel, NULL, pool));
+      else
+        SVN_ERR(svn_ra_replay_range(session, start_revision, end_revision,
+                                    0, TRUE, replay_revstart, replay_revend,
+                                    replay_baton, pool));
 #else
       SVN_ERR(svn_ra__replay_range_ev2(session, start_revision, end_revision,
                                        0, TRUE, replay_revstart_v2,
@@ -636,7 +657,10 @@ dump_cmd(apr_getopt_t *os,
 {
   opt_baton_t *opt_baton = baton;
   svn_ra_session_t *extra_ra_session;
+  apr_array_header_t *prefetch_sessions = NULL;
+  apr_array_header_t *session_pools = NULL;
   const char *repos_root;
+  svn_error_t *err = SVN_NO_ERROR;
 
   SVN_ERR(svn_client_open_ra_session2(&extra_ra_session,
                                       opt_baton->url, NULL,
@@ -644,11 +668,48 @@ dump_cmd(apr_getopt_t *os,
   SVN_ERR(svn_ra_get_repos_root2(extra_ra_session, &repos_root, pool));
   SVN_ERR(svn_ra_reparent(extra_ra_session, repos_root, pool));
 
-  return replay_revisions(opt_baton->session, extra_ra_session,
-                          opt_baton->start_revision.value.number,
-                          opt_baton->end_revision.value.number,
-                          opt_baton->quiet, opt_baton->incremental,
-                          opt_baton->dumpfile, pool);
+  /* Each prefetch session is used by its own thread and therefore
+     needs its own root pool. */
+  if (opt_baton->prefetch > 1)
+    {
+      int i;
+
+      prefetch_sessions = apr_array_make(pool, opt_baton->prefetch,
+                                         sizeof(svn_ra_session_t *));
+      session_pools = apr_array_make(pool, opt_baton->prefetch,
+                                     sizeof(apr_pool_t *));
+      for (i = 0; i < opt_baton->prefetch && !err; ++i)
+        {
+          apr_pool_t *session_pool
+            = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+          svn_ra_session_t *session;
+
+          APR_ARRAY_PUSH(session_pools, apr_pool_t *) = session_pool;
+          err = svn_client_open_ra_session2(&session, opt_baton->url, NULL,
+                                            opt_baton->ctx, session_pool,
+                                            session_pool);
+          if (!err)
+            APR_ARRAY_PUSH(prefetch_sessions, svn_ra_session_t *) = session;
+        }
+    }
+
+  if (!err)
+    err = replay_revisions(opt_baton->session, extra_ra_session,
+                           prefetch_sessions,
+                           opt_baton->start_revision.value.number,
+                           opt_baton->end_revision.value.number,
+                           opt_baton->quiet, opt_baton->incremental,
+                           opt_baton->dumpfile, pool);
+
+  if (session_pools)
+    {
+      int i;
+
+      for (i = 0; i < session_pools->nelts; ++i)
+        svn_pool_destroy(APR_ARRAY_IDX(session_pools, i, apr_pool_t *));
+    }
+
+  return svn_error_trace(err);
 }
 
 /* Handle the "load" subcommand.  Implements `svn_opt_subcommand_t'.  */
@@ -900,6 +961,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
         case opt_incremental:
           opt_baton->incremental = TRUE;
           break;
+        case opt_prefetch:
+          SVN_ERR(svn_cstring_atoi(&opt_baton->prefetch, opt_arg));
+          if (opt_baton->prefetch < 1)
+            return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                    _("The number of revisions to prefetch "
+                                      "must be at least 1"));
+          break;
         case opt_skip_revprop:
           SVN_ERR(svn_utf_cstring_to_utf8(&opt_arg, opt_arg, pool));
           svn_hash_sets(opt_baton->skip_revprops, opt_arg, opt_arg);
@@ -0,0 +1,359 @@
+/*
+ * metrics.c : Implementation of the svnserve performance metrics
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+
+
+#define APR_WANT_STRFUNC
+#include <apr_want.h>
+
+#include "svn_error.h"
+#include "svn_hash.h"
+#include "svn_io.h"
+#include "svn_pools.h"
+#include "svn_string.h"
+
+#include "private/svn_mutex.h"
+#include "private/svn_sorts_private.h"
+
+#include "svn_private_config.h"
+#include "metrics.h"
+
+/* Upper bounds of the latency histogram buckets in microseconds and as
+ * they appear in the "le" label.  The final "+Inf" bucket is implicit. */
+static const apr_interval_time_t bucket_bounds[] =
+  {
+    1000, 5000, 10000, 50000, 100000, 500000,
+    1000000, 5000000, 10000000, 60000000
+  };
+static const char * const bucket_labels[] =
+  {
+    "0.001", "0.005", "0.01", "0.05", "0.1", "0.5",
+    "1", "5", "10", "60"
+  };
+
+#define BUCKET_COUNT (sizeof(bucket_bounds) / sizeof(bucket_bounds[0]))
+
+/* Totals of one ra_svn command. */
+typedef struct command_metrics_t
+{
+  /* Number of commands per latency bucket, not cumulative.  The extra
+     entry counts the commands that took longer than the last bound. */
+  apr_uint64_t buckets[BUCKET_COUNT + 1];
+
+  /* Number of commands and the sum of their durations. */
+  apr_uint64_t count;
+  apr_interval_time_t duration;
+
+  /* Number of commands that returned an error. */
+  apr_uint64_t failures;
+
+  /* Bytes received and sent for the commands. */
+  apr_uint64_t bytes_in;
+  apr_uint64_t bytes_out;
+} command_metrics_t;
+
+struct metrics_t
+{
+  /* file to write the metrics to */
+  const char *filename;
+
+  /* map of const char * command name to command_metrics_t * */
+  apr_hash_t *commands;
+
+  /* connections accepted so far and those not closed yet */
+  apr_uint64_t connections_total;
+  apr_uint64_t connections_active;
+
+  /* mutex used to serialize access to this structure */
+  svn_mutex__t *mutex;
+
+  /* private pool used for the command entries */
+  apr_pool_t *pool;
+};
+
+svn_error_t *
+metrics__create(metrics_t **metrics,
+                const char *filename,
+                apr_pool_t *pool)
+{
+  metrics_t *result = apr_pcalloc(pool, sizeof(*result));
+
+  result->filename = apr_pstrdup(pool, filename);
+  result->pool = svn_pool_create(pool);
+  result->commands = apr_hash_make(result->pool);
+  SVN_ERR(svn_mutex__init(&result->mutex, TRUE, pool));
+
+  *metrics = result;
+
+  return SVN_NO_ERROR;
+}
+
+/* Add DELTA to the active connections in METRICS and, if DELTA is
+ * positive, to the total connections as well.  Call this only while
+ * holding the mutex of METRICS. */
+static svn_error_t *
+count_connection(metrics_t *metrics,
+                 int delta)
+{
+  if (delta > 0)
+    metrics->connections_total += delta;
+  metrics->connections_active += delta;
+
+  return SVN_NO_ERROR;
+}
+
+void
+metrics__connection_opened(metrics_t *metrics)
+{
+  svn_error_t *err;
+
+  if (!metrics)
+    return;
+
+  err = svn_mutex__lock(metrics->mutex);
+  if (!err)
+    err = svn_mutex__unlock(metrics->mutex, count_connection(metrics, 1));
+  svn_error_clear(err);
+}
+
+void
+metrics__connection_closed(metrics_t *metrics)
+{
+  svn_error_t *err;
+
+  if (!metrics)
+    return;
+
+  err = svn_mutex__lock(metrics->mutex);
+  if (!err)
+    err = svn_mutex__unlock(metrics->mutex, count_connection(metrics, -1));
+  svn_error_clear(err);
+}
+
+/* Add one command of CMDNAME with DURATION, BYTES_IN, BYTES_OUT and
+ * FAILED to METRICS.  Call this only while holding the mutex of
+ * METRICS. */
+static svn_error_t *
+add_command(metrics_t *metrics,
+            const char *cmdname,
+            apr_interval_time_t duration,
+            apr_uint64_t bytes_in,
+            apr_uint64_t bytes_out,
+            svn_boolean_t failed)
+{
+  command_metrics_t *entry = svn_hash_gets(metrics->commands, cmdname);
+  apr_size_t i;
+
+  if (!entry)
+    {
+      entry = apr_pcalloc(metrics->pool, sizeof(*entry));
+      svn_hash_sets(metrics->commands,
+                    apr_pstrdup(metrics->pool, cmdname), entry);
+    }
+
+  for (i = 0; i < BUCKET_COUNT; ++i)
+    if (duration <= bucket_bounds[i])
+      break;
+
+  entry->buckets[i]++;
+  entry->count++;
+  entry->duration += duration;
+  entry->bytes_in += bytes_in;
+  entry->bytes_out += bytes_out;
+  if (failed)
+    entry->failures++;
+
+  return SVN_NO_ERROR;
+}
+
+void
+metrics__record_command(void *baton,
+                        const char *cmdname,
+                        apr_interval_time_t duration,
+                        apr_uint64_t bytes_in,
+                        apr_uint64_t bytes_out,
+                        svn_boolean_t failed)
+{
+  metrics_t *metrics = baton;
+  svn_error_t *err;
+
+  /* Losing a sample is preferable to failing the command. */
+  err = svn_mutex__lock(metrics->mutex);
+  if (!err)
+    err = svn_mutex__unlock(metrics->mutex,
+                            add_command(metrics, cmdname, duration,
+                                        bytes_in, bytes_out, failed));
+  svn_error_clear(err);
+}
+
+/* Append the metric header for NAME of TYPE with description HELP to
+ * BUF. */
+static void
+append_header(svn_stringbuf_t *buf,
+              const char *name,
+              const char *type,
+              const char *help)
+{
+  svn_stringbuf_appendcstr(buf, "# HELP ");
+  svn_stringbuf_appendcstr(buf, name);
+  svn_stringbuf_appendbyte(buf, ' ');
+  svn_stringbuf_appendcstr(buf, help);
+  svn_stringbuf_appendcstr(buf, "\n# TYPE ");
+  svn_stringbuf_appendcstr(buf, name);
+  svn_stringbuf_appendbyte(buf, ' ');
+  svn_stringbuf_appendcstr(buf, type);
+  svn_stringbuf_appendbyte(buf, '\n');
+}
+
+/* Offsets of the per-command counters in command_metrics_t. */
+#define COUNTER_OFFSET(member) APR_OFFSETOF(command_metrics_t, member)
+
+/* Append the per-command counter at OFFSET of all COMMANDS to BUF,
+ * as metric NAME with description HELP.  Allocate in POOL. */
+static void
+append_command_counter(svn_stringbuf_t *buf,
+                       apr_array_header_t *commands,
+                       const char *name,
+                       apr_size_t offset,
+                       const char *help,
+                       apr_pool_t *pool)
+{
+  int i;
+
+  append_header(buf, name, "counter", help);
+  for (i = 0; i < commands->nelts; ++i)
+    {
+      const svn_sort__item_t *item = &APR_ARRAY_IDX(commands, i,
+                                                    svn_sort__item_t);
+      const char *entry = item->value;
+
+      svn_stringbuf_appendcstr(buf,
+        apr_psprintf(pool, "%s{command=\"%s\"} %" APR_UINT64_T_FMT "\n",
+                     name, (const char *)item->key,
+                     *(const apr_uint64_t *)(entry + offset)));
+    }
+}
+
+/* Append all figures in METRICS to BUF.  Call this only while holding
+ * the mutex of METRICS.  Allocate in POOL. */
+static svn_error_t *
+format_metrics(svn_stringbuf_t *buf,
+               metrics_t *metrics,
+               apr_pool_t *pool)
+{
+  apr_array_header_t *commands;
+  int i;
+
+  commands = svn_sort__hash(metrics->commands,
+                            svn_sort_compare_items_lexically, pool);
+
+  append_header(buf, "svnserve_command_duration_seconds", "histogram",
+                "Time spent handling ra_svn commands.");
+  for (i = 0; i < commands->nelts; ++i)
+    {
+      const svn_sort__item_t *item = &APR_ARRAY_IDX(commands, i,
+                                                    svn_sort__item_t);
+      const char *cmdname = item->key;
+      const command_metrics_t *entry = item->value;
+      apr_uint64_t cumulative = 0;
+      apr_size_t k;
+
+      for (k = 0; k < BUCKET_COUNT; ++k)
+        {
+          cumulative += entry->buckets[k];
+          svn_stringbuf_appendcstr(buf,
+            apr_psprintf(pool, "svnserve_command_duration_seconds_bucket"
+                               "{command=\"%s\",le=\"%s\"} %"
+                               APR_UINT64_T_FMT "\n",
+                         cmdname, bucket_labels[k], cumulative));
+        }
+
+      svn_stringbuf_appendcstr(buf,
+        apr_psprintf(pool, "svnserve_command_duration_seconds_bucket"
+                           "{command=\"%s\",le=\"+Inf\"} %"
+                           APR_UINT64_T_FMT "\n"
+                           "svnserve_command_duration_seconds_sum"
+                           "{command=\"%s\"} %" APR_INT64_T_FMT ".%06d\n"
+                           "svnserve_command_duration_seconds_count"
+                           "{command=\"%s\"} %" APR_UINT64_T_FMT "\n",
+                     cmdname, entry->count,
+                     cmdname, (apr_int64_t)apr_time_sec(entry->duration),
+                     (int)apr_time_usec(entry->duration),
+                     cmdname, entry->count));
+    }
+
+  append_command_counter(buf, commands, "svnserve_command_failures_total",
+                         COUNTER_OFFSET(failures),
+                         "Number of ra_svn commands that failed.", pool);
+  append_command_counter(buf, commands,
+                         "svnserve_command_received_bytes_total",
+                         COUNTER_OFFSET(bytes_in),
+                         "Bytes received for ra_svn commands.", pool);
+  append_command_counter(buf, commands, "svnserve_command_sent_bytes_total",
+                         COUNTER_OFFSET(bytes_out),
+                         "Bytes sent for ra_svn commands.", pool);
+
+  append_header(buf, "svnserve_connections_total", "counter",
+                "Number of accepted connections.");
+  svn_stringbuf_appendcstr(buf,
+    apr_psprintf(pool, "svnserve_connections_total %" APR_UINT64_T_FMT "\n",
+                 metrics->connections_total));
+  append_header(buf, "svnserve_connections_active", "gauge",
+                "Number of open connections.");
+  svn_stringbuf_appendcstr(buf,
+    apr_psprintf(pool, "svnserve_connections_active %" APR_UINT64_T_FMT "\n",
+                 metrics->connections_active));
+
+  return SVN_NO_ERROR;
+}
+
+svn_error_t *
+metrics__write(metrics_t *metrics,
+               apr_size_t threads_busy,
+               apr_size_t threads_max,
+               apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *buf = svn_stringbuf_create_ensure(4096, scratch_pool);
+
+  SVN_MUTEX__WITH_LOCK(metrics->mutex,
+                       format_metrics(buf, metrics, scratch_pool));
+
+  if (threads_max)
+    {
+      append_header(buf, "svnserve_threads_busy", "gauge",
+                    "Number of worker threads serving a connection.");
+      svn_stringbuf_appendcstr(buf,
+        apr_psprintf(scratch_pool, "svnserve_threads_busy %" APR_SIZE_T_FMT
+                                   "\n", threads_busy));
+      append_header(buf, "svnserve_threads_max", "gauge",
+                    "Maximum number of worker threads.");
+      svn_stringbuf_appendcstr(buf,
+        apr_psprintf(scratch_pool, "svnserve_threads_max %" APR_SIZE_T_FMT
+                                   "\n", threads_max));
+    }
+
+  /* Scrapers must never see a partially written file. */
+  return svn_error_trace(svn_io_write_atomic2(metrics->filename,
+                                              buf->data, buf->len,
+                                              NULL, FALSE, scratch_pool));
+}
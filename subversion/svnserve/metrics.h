@@ -0,0 +1,83 @@
+/*
+ * metrics.h : Declarations for the svnserve performance metrics
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "server.h"
+
+
+
+/* Opaque collection of svnserve performance metrics: latency histograms
+ * and I/O volume per ra_svn command as well as connection counts.
+ * Updates will be serialized among threads within the same process.
+ */
+typedef struct metrics_t metrics_t;
+
+/* In POOL, create an empty metrics collection that will be written to
+ * FILENAME and return it in *METRICS.
+ */
+svn_error_t *
+metrics__create(metrics_t **metrics,
+                const char *filename,
+                apr_pool_t *pool);
+
+/* Count a newly accepted connection in METRICS. */
+void
+metrics__connection_opened(metrics_t *metrics);
+
+/* Count the end of a connection in METRICS. */
+void
+metrics__connection_closed(metrics_t *metrics);
+
+/* Implements svn_ra_svn__command_hook_t for a metrics_t BATON, i.e. add
+ * the figures of one command to the metrics collection.
+ */
+void
+metrics__record_command(void *baton,
+                        const char *cmdname,
+                        apr_interval_time_t duration,
+                        apr_uint64_t bytes_in,
+                        apr_uint64_t bytes_out,
+                        svn_boolean_t failed);
+
+/* Atomically replace the file of METRICS with the current figures in the
+ * Prometheus text exposition format.  If THREADS_MAX is not 0, also write
+ * the number of busy worker threads THREADS_BUSY and the limit THREADS_MAX.
+ * Use SCRATCH_POOL for temporary allocations.
+ */
+svn_error_t *
+metrics__write(metrics_t *metrics,
+               apr_size_t threads_busy,
+               apr_size_t threads_max,
+               apr_pool_t *scratch_pool);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* METRICS_H */
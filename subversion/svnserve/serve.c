@@ -32,6 +32,8 @@
 #include <apr_general.h>
 #include <apr_lib.h>
 #include <apr_strings.h>
+#include <apr_portable.h>
+#include <apr_user.h>
 
 #include "svn_compat.h"
 #include "svn_private_config.h"  /* For SVN_PATH_LOCAL_SEPARATOR */
@@ -49,12 +51,17 @@
 #include "svn_config.h"
 #include "svn_props.h"
 #include "svn_mergeinfo.h"
+#include "svn_sorts.h"
 #include "svn_user.h"
 
 #include "private/svn_log.h"
 #include "private/svn_mergeinfo_private.h"
 #include "private/svn_ra_svn_private.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_fspath.h"
+#include "private/svn_fs_fs_private.h"
+#include "private/svn_subr_private.h"
+#include "private/svn_trace.h"
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>   /* For getpid() */
@@ -62,6 +69,11 @@
 
 #include "server.h"
 #include "logger.h"
+#include "metrics.h"
+
+#ifndef WIN32
+#include <sys/socket.h>   /* For getsockopt() / getpeereid() */
+#endif
 
 typedef struct commit_callback_baton_t {
   apr_pool_t *pool;
@@ -180,6 +192,44 @@ static svn_error_t *log_command(server_baton_t *b,
   return logger__write(b->logger, line, nbytes);
 }
 
+/* Log the filesystem I/O statistics of the session B, if any, followed
+ * by the current and peak size of the server process. */
+static void
+log_io_stats(server_baton_t *b,
+             svn_ra_svn_conn_t *conn,
+             apr_pool_t *pool)
+{
+  svn_fs_io_stats_t *stats;
+  apr_uint64_t rss, peak_rss;
+  svn_error_t *err;
+
+  if (!b || !b->logger || !b->repository || !b->repository->fs)
+    return;
+
+  svn_pool__memory_usage(&rss, &peak_rss);
+  err = svn_fs_get_io_stats(&stats, b->repository->fs, pool);
+  if (!err)
+    err = log_command(b, conn, pool,
+                      "io files=%" APR_UINT64_T_FMT
+                      " index=%" APR_UINT64_T_FMT
+                      " items=%" APR_UINT64_T_FMT
+                      " bytes=%" APR_UINT64_T_FMT
+                      " decompressed=%" APR_UINT64_T_FMT
+                      " cache-gets=%" APR_UINT64_T_FMT
+                      " cache-hits=%" APR_UINT64_T_FMT,
+                      stats->files_opened, stats->index_lookups,
+                      stats->items_read, stats->bytes_read,
+                      stats->bytes_decompressed,
+                      stats->cache_gets, stats->cache_hits);
+  if (!err)
+    err = log_command(b, conn, pool,
+                      "mem rss=%" APR_UINT64_T_FMT
+                      " peak=%" APR_UINT64_T_FMT,
+                      rss / 1024, peak_rss / 1024);
+
+  svn_error_clear(err);
+}
+
 /* Log an authz failure */
 static svn_error_t *
 log_authz_denied(const char *path,
@@ -433,6 +483,25 @@ static void convert_case(char *text, svn_boolean_t to_uppercase)
     }
 }
 
+/* If we have a username in B, and we've not yet used it + any username
+   case normalization that might be requested to determine "the username
+   we used for authz purposes", do so now. */
+static void set_authz_user(server_baton_t *b)
+{
+  client_info_t *client_info = b->client_info;
+
+  if (client_info->user && (! client_info->authz_user))
+    {
+      char *authz_user = apr_pstrdup(b->pool, client_info->user);
+      if (b->repository->username_case == CASE_FORCE_UPPER)
+        convert_case(authz_user, TRUE);
+      else if (b->repository->username_case == CASE_FORCE_LOWER)
+        convert_case(authz_user, FALSE);
+
+      client_info->authz_user = authz_user;
+    }
+}
+
 /* Set *ALLOWED to TRUE if PATH is accessible in the REQUIRED mode to
    the user described in BATON according to the authz rules in BATON.
    Use POOL for temporary allocations only.  If no authz rules are
@@ -465,19 +534,7 @@ static svn_error_t *authz_check_access(svn_boolean_t *allowed,
   if (path && *path != '/')
     path = svn_fspath__canonicalize(path, pool);
 
-  /* If we have a username, and we've not yet used it + any username
-     case normalization that might be requested to determine "the
-     username we used for authz purposes", do so now. */
-  if (client_info->user && (! client_info->authz_user))
-    {
-      char *authz_user = apr_pstrdup(b->pool, client_info->user);
-      if (repository->username_case == CASE_FORCE_UPPER)
-        convert_case(authz_user, TRUE);
-      else if (repository->username_case == CASE_FORCE_LOWER)
-        convert_case(authz_user, FALSE);
-
-      client_info->authz_user = authz_user;
-    }
+  set_authz_user(b);
 
   SVN_ERR(svn_repos_authz_check_access(repository->authzdb,
                                        repository->authz_repos_name,
@@ -970,6 +1027,25 @@ static const svn_ra_svn__cmd_entry_t report_commands[] = {
   { NULL }
 };
 
+/* Wait until the scheduler of B, if any, admits the expensive operation OP
+ * of the current user.  The operation's slot is being held until POOL
+ * gets cleaned up.
+ */
+static svn_error_t *
+admit_request(server_baton_t *b,
+              svn_repos__sched_op_t op,
+              apr_pool_t *pool)
+{
+  if (!b->scheduler)
+    return SVN_NO_ERROR;
+
+  return svn_error_trace(svn_repos__scheduler_admit(
+                           b->scheduler, b->repository->repos, op,
+                           svn_repos__scheduler_classify(b->scheduler,
+                                                         b->client_info->user),
+                           pool));
+}
+
 /* Accept a report from the client, drive the network editor with the
  * result, and then write an empty command response.  If there is a
  * non-protocol failure, accept_report will abort the edit and return
@@ -1002,6 +1078,11 @@ static svn_error_t *accept_report(svn_boolean_t *only_empty_entry,
   ab.server = b;
   ab.conn = conn;
 
+  /* Unknown depth means "as deep as the working copy", i.e. usually
+     infinite. */
+  if (depth == svn_depth_infinity || depth == svn_depth_unknown)
+    SVN_ERR(admit_request(b, svn_repos__sched_op_report, pool));
+
   /* Make an svn_repos report baton.  Tell it to drive the network editor
    * when the report is complete. */
   svn_ra_svn_get_editor(&editor, &edit_baton, conn, pool, NULL, NULL);
@@ -1014,6 +1095,8 @@ static svn_error_t *accept_report(svn_boolean_t *only_empty_entry,
                                       authz_check_access_cb_func(b),
                                       &ab, svn_ra_svn_zero_copy_limit(conn),
                                       pool));
+  svn_repos__report_set_prefetch(report_baton, b->update_prefetch,
+                                 b->fs_config);
 
   rb.sb = b;
   rb.repos_url = svn_path_uri_decode(b->repository->repos_url, pool);
@@ -1582,6 +1665,77 @@ commit(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+/* Files smaller than this get sent through the usual contents stream,
+ * which may be served from the FS caches. */
+#define FILE_LOCATION_MIN_SIZE 0x10000
+
+/* Upper limit for the size of a single string of a file's contents,
+ * so the client never needs to hold large parts of it in memory. */
+#define FILE_LOCATION_CHUNK_SIZE 0x100000
+
+/* If the contents of the file PATH under ROOT are large and stored
+ * verbatim in a rev or pack file, set *LOCATION to their position in
+ * that file.  Otherwise, set *LOCATION to NULL.  Use POOL for all
+ * allocations. */
+static svn_error_t *
+get_contents_location(svn_fs_fs__ioctl_contents_location_output_t **location,
+                      svn_fs_root_t *root,
+                      const char *path,
+                      apr_pool_t *pool)
+{
+  svn_fs_fs__ioctl_contents_location_input_t input = { 0 };
+  svn_filesize_t size;
+  svn_error_t *err;
+
+  *location = NULL;
+
+  SVN_ERR(svn_fs_file_length(&size, root, path, pool));
+  if (size < FILE_LOCATION_MIN_SIZE)
+    return SVN_NO_ERROR;
+
+  input.root = root;
+  input.path = path;
+  err = svn_fs_ioctl(svn_fs_root_fs(root), SVN_FS_FS__IOCTL_CONTENTS_LOCATION,
+                     &input, (void **)location, NULL, NULL, pool, pool);
+  if (err && err->apr_err == SVN_ERR_FS_UNRECOGNIZED_IOCTL_CODE)
+    {
+      /* Not FSFS.  Use the contents stream. */
+      svn_error_clear(err);
+      *location = NULL;
+      return SVN_NO_ERROR;
+    }
+  SVN_ERR(err);
+
+  if (*location && !(*location)->file)
+    *location = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Send the file contents at LOCATION over CONN as a sequence of strings,
+ * letting the OS copy them directly from the repository where possible.
+ * Use POOL for temporary allocations. */
+static svn_error_t *
+send_contents_location(svn_ra_svn_conn_t *conn,
+                       svn_fs_fs__ioctl_contents_location_output_t *location,
+                       apr_pool_t *pool)
+{
+  apr_off_t offset = location->offset;
+  svn_filesize_t remaining = location->length;
+
+  while (remaining > 0)
+    {
+      apr_size_t len = (apr_size_t)MIN(remaining, FILE_LOCATION_CHUNK_SIZE);
+
+      SVN_ERR(svn_ra_svn__write_file_string(conn, pool, location->file,
+                                            offset, len));
+      offset += len;
+      remaining -= len;
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 get_file(svn_ra_svn_conn_t *conn,
          apr_pool_t *pool,
@@ -1593,6 +1747,7 @@ get_file(svn_ra_svn_conn_t *conn,
   svn_revnum_t rev;
   svn_fs_root_t *root;
   svn_stream_t *contents;
+  svn_fs_fs__ioctl_contents_location_output_t *location = NULL;
   apr_hash_t *props = NULL;
   apr_array_header_t *inherited_props;
   svn_string_t write_str;
@@ -1647,7 +1802,11 @@ get_file(svn_ra_svn_conn_t *conn,
                           &ab, root, full_path,
                           pool));
   if (want_contents)
-    SVN_CMD_ERR(svn_fs_file_contents(&contents, root, full_path, pool));
+    {
+      SVN_CMD_ERR(get_contents_location(&location, root, full_path, pool));
+      if (!location)
+        SVN_CMD_ERR(svn_fs_file_contents(&contents, root, full_path, pool));
+    }
 
   /* Send successful command response with revision and props. */
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w((?c)r(!", "success",
@@ -1677,7 +1836,13 @@ get_file(svn_ra_svn_conn_t *conn,
   SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "!))"));
 
   /* Now send the file's contents. */
-  if (want_contents)
+  if (want_contents && location)
+    {
+      SVN_ERR(send_contents_location(conn, location, pool));
+      SVN_ERR(svn_ra_svn__write_cstring(conn, pool, ""));
+      SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
+    }
+  else if (want_contents)
     {
       err = SVN_NO_ERROR;
       while (1)
@@ -1769,6 +1934,98 @@ parse_dirent_fields(apr_uint32_t *dirent_fields_p,
   return SVN_NO_ERROR;
 }
 
+/* Send the directory ENTRIES of FULL_PATH in ROOT as dirent tuples over
+ * CONN, leaving out those that the user of B may not read.  Only fill in
+ * the fields selected by DIRENT_FIELDS.  Use POOL for temporaries.
+ */
+static svn_error_t *
+write_dir_entries(svn_ra_svn_conn_t *conn,
+                  server_baton_t *b,
+                  svn_fs_root_t *root,
+                  const char *full_path,
+                  apr_hash_t *entries,
+                  apr_uint32_t dirent_fields,
+                  apr_pool_t *pool)
+{
+  /* Use epoch for a placeholder for a missing date.  */
+  const char *missing_date = svn_time_to_cstring(0, pool);
+  apr_pool_t *subpool = svn_pool_create(pool);
+  apr_hash_index_t *hi;
+
+  /* Transform the hash table's FS entries into dirents.  This probably
+   * belongs in libsvn_repos. */
+  for (hi = apr_hash_first(pool, entries); hi; hi = apr_hash_next(hi))
+    {
+      const char *name = apr_hash_this_key(hi);
+      svn_fs_dirent_t *fsent = apr_hash_this_val(hi);
+      const char *file_path;
+
+      /* The fields in the entry tuple.  */
+      svn_node_kind_t entry_kind = svn_node_none;
+      svn_filesize_t entry_size = 0;
+      svn_boolean_t has_props = FALSE;
+      /* If 'created rev' was not requested, send 0.  We can't use
+       * SVN_INVALID_REVNUM as the tuple field is not optional.
+       * See the email thread on dev@, 2012-03-28, subject
+       * "buildbot failure in ASF Buildbot on svn-slik-w2k3-x64-ra",
+       * <http://svn.haxx.se/dev/archive-2012-03/0655.shtml>. */
+      svn_revnum_t created_rev = 0;
+      const char *cdate = NULL;
+      const char *last_author = NULL;
+
+      svn_pool_clear(subpool);
+
+      file_path = svn_fspath__join(full_path, name, subpool);
+      if (! lookup_access(subpool, b, svn_authz_read, file_path, FALSE))
+        continue;
+
+      if (dirent_fields & SVN_DIRENT_KIND)
+          entry_kind = fsent->kind;
+
+      if (dirent_fields & SVN_DIRENT_SIZE)
+          if (fsent->kind != svn_node_dir)
+            SVN_CMD_ERR(svn_fs_file_length(&entry_size, root, file_path,
+                                           subpool));
+
+      if (dirent_fields & SVN_DIRENT_HAS_PROPS)
+        {
+          /* has_props */
+          SVN_CMD_ERR(svn_fs_node_has_props(&has_props, root, file_path,
+                                           subpool));
+        }
+
+      if ((dirent_fields & SVN_DIRENT_LAST_AUTHOR)
+          || (dirent_fields & SVN_DIRENT_TIME)
+          || (dirent_fields & SVN_DIRENT_CREATED_REV))
+        {
+          /* created_rev, last_author, time */
+          SVN_CMD_ERR(svn_repos_get_committed_info(&created_rev,
+                                                   &cdate,
+                                                   &last_author,
+                                                   root,
+                                                   file_path,
+                                                   subpool));
+        }
+
+      /* The client does not properly handle a missing CDATE. For
+         interoperability purposes, we must fill in some junk.
+
+         See libsvn_ra_svn/client.c:ra_svn_get_dir()  */
+      if (cdate == NULL)
+        cdate = missing_date;
+
+      /* Send the entry. */
+      SVN_ERR(svn_ra_svn__write_tuple(conn, subpool, "cwnbr(?c)(?c)", name,
+                                      svn_node_kind_to_word(entry_kind),
+                                      (apr_uint64_t) entry_size,
+                                      has_props, created_rev,
+                                      cdate, last_author));
+    }
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 get_dir(svn_ra_svn_conn_t *conn,
         apr_pool_t *pool,
@@ -1780,9 +2037,7 @@ get_dir(svn_ra_svn_conn_t *conn,
   svn_revnum_t rev;
   apr_hash_t *entries, *props = NULL;
   apr_array_header_t *inherited_props;
-  apr_hash_index_t *hi;
   svn_fs_root_t *root;
-  apr_pool_t *subpool;
   svn_boolean_t want_props, want_contents;
   apr_uint64_t wants_inherited_props;
   apr_uint32_t dirent_fields;
@@ -1843,82 +2098,8 @@ get_dir(svn_ra_svn_conn_t *conn,
 
   /* Fetch the directory entries if requested and send them immediately. */
   if (want_contents)
-    {
-      /* Use epoch for a placeholder for a missing date.  */
-      const char *missing_date = svn_time_to_cstring(0, pool);
-
-      /* Transform the hash table's FS entries into dirents.  This probably
-       * belongs in libsvn_repos. */
-      subpool = svn_pool_create(pool);
-      for (hi = apr_hash_first(pool, entries); hi; hi = apr_hash_next(hi))
-        {
-          const char *name = apr_hash_this_key(hi);
-          svn_fs_dirent_t *fsent = apr_hash_this_val(hi);
-          const char *file_path;
-
-          /* The fields in the entry tuple.  */
-          svn_node_kind_t entry_kind = svn_node_none;
-          svn_filesize_t entry_size = 0;
-          svn_boolean_t has_props = FALSE;
-          /* If 'created rev' was not requested, send 0.  We can't use
-           * SVN_INVALID_REVNUM as the tuple field is not optional.
-           * See the email thread on dev@, 2012-03-28, subject
-           * "buildbot failure in ASF Buildbot on svn-slik-w2k3-x64-ra",
-           * <http://svn.haxx.se/dev/archive-2012-03/0655.shtml>. */
-          svn_revnum_t created_rev = 0;
-          const char *cdate = NULL;
-          const char *last_author = NULL;
-
-          svn_pool_clear(subpool);
-
-          file_path = svn_fspath__join(full_path, name, subpool);
-          if (! lookup_access(subpool, b, svn_authz_read, file_path, FALSE))
-            continue;
-
-          if (dirent_fields & SVN_DIRENT_KIND)
-              entry_kind = fsent->kind;
-
-          if (dirent_fields & SVN_DIRENT_SIZE)
-              if (fsent->kind != svn_node_dir)
-                SVN_CMD_ERR(svn_fs_file_length(&entry_size, root, file_path,
-                                               subpool));
-
-          if (dirent_fields & SVN_DIRENT_HAS_PROPS)
-            {
-              /* has_props */
-              SVN_CMD_ERR(svn_fs_node_has_props(&has_props, root, file_path,
-                                               subpool));
-            }
-
-          if ((dirent_fields & SVN_DIRENT_LAST_AUTHOR)
-              || (dirent_fields & SVN_DIRENT_TIME)
-              || (dirent_fields & SVN_DIRENT_CREATED_REV))
-            {
-              /* created_rev, last_author, time */
-              SVN_CMD_ERR(svn_repos_get_committed_info(&created_rev,
-                                                       &cdate,
-                                                       &last_author,
-                                                       root,
-                                                       file_path,
-                                                       subpool));
-            }
-
-          /* The client does not properly handle a missing CDATE. For
-             interoperability purposes, we must fill in some junk.
-
-             See libsvn_ra_svn/client.c:ra_svn_get_dir()  */
-          if (cdate == NULL)
-            cdate = missing_date;
-
-          /* Send the entry. */
-          SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "cwnbr(?c)(?c)", name,
-                                          svn_node_kind_to_word(entry_kind),
-                                          (apr_uint64_t) entry_size,
-                                          has_props, created_rev,
-                                          cdate, last_author));
-        }
-      svn_pool_destroy(subpool);
-    }
+    SVN_ERR(write_dir_entries(conn, b, root, full_path, entries,
+                              dirent_fields, pool));
 
   if (wants_inherited_props)
     {
@@ -1944,6 +2125,88 @@ get_dir(svn_ra_svn_conn_t *conn,
   return svn_ra_svn__write_tuple(conn, pool, "!))");
 }
 
+static svn_error_t *
+get_dirs(svn_ra_svn_conn_t *conn,
+         apr_pool_t *pool,
+         svn_ra_svn__list_t *params,
+         void *baton)
+{
+  server_baton_t *b = baton;
+  svn_revnum_t rev;
+  svn_ra_svn__list_t *paths_list, *dirent_fields_list;
+  apr_array_header_t *full_paths;
+  apr_hash_t **entries;
+  apr_uint32_t dirent_fields;
+  svn_fs_root_t *root;
+  apr_pool_t *iterpool;
+  int i;
+
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "l(?r)l", &paths_list, &rev,
+                                  &dirent_fields_list));
+  SVN_ERR(parse_dirent_fields(&dirent_fields, dirent_fields_list));
+
+  full_paths = apr_array_make(pool, paths_list->nelts, sizeof(const char *));
+  for (i = 0; i < paths_list->nelts; i++)
+    {
+      svn_ra_svn__item_t *item = &SVN_RA_SVN__LIST_ITEM(paths_list, i);
+      const char *canonical_path;
+
+      if (item->kind != SVN_RA_SVN_STRING)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                _("Path is not a string"));
+
+      SVN_ERR(svn_relpath_canonicalize_safe(&canonical_path, NULL,
+                                            item->u.string.data,
+                                            pool, pool));
+      APR_ARRAY_PUSH(full_paths, const char *)
+        = svn_fspath__join(b->repository->fs_path->data, canonical_path,
+                           pool);
+    }
+
+  /* Check authorizations */
+  for (i = 0; i < full_paths->nelts; i++)
+    SVN_ERR(must_have_access(conn, pool, b, svn_authz_read,
+                             APR_ARRAY_IDX(full_paths, i, const char *),
+                             FALSE));
+
+  if (!SVN_IS_VALID_REVNUM(rev))
+    SVN_CMD_ERR(svn_fs_youngest_rev(&rev, b->repository->fs, pool));
+
+  SVN_ERR(log_command(b, conn, pool, "%s",
+                      svn_log__get_dirs(full_paths, rev, pool)));
+
+  /* Fetch the root of the appropriate revision. */
+  SVN_CMD_ERR(svn_fs_revision_root(&root, b->repository->fs, rev, pool));
+
+  /* Fetch all directories' entries before starting the response, to allow
+     proper error handling in cases like when one of them doesn't exist. */
+  entries = apr_palloc(pool, full_paths->nelts * sizeof(*entries));
+  for (i = 0; i < full_paths->nelts; i++)
+    SVN_CMD_ERR(svn_fs_dir_entries(&entries[i], root,
+                                   APR_ARRAY_IDX(full_paths, i, const char *),
+                                   pool));
+
+  /* Send the entries of one directory after the other. */
+  SVN_ERR(svn_ra_svn__write_tuple(conn, pool, "w((!", "success"));
+
+  iterpool = svn_pool_create(pool);
+  for (i = 0; i < full_paths->nelts; i++)
+    {
+      svn_ra_svn__item_t *item = &SVN_RA_SVN__LIST_ITEM(paths_list, i);
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "!(c(!",
+                                      item->u.string.data));
+      SVN_ERR(write_dir_entries(conn, b, root,
+                                APR_ARRAY_IDX(full_paths, i, const char *),
+                                entries[i], dirent_fields, iterpool));
+      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "!))!"));
+    }
+  svn_pool_destroy(iterpool);
+
+  return svn_ra_svn__write_tuple(conn, pool, "!))");
+}
+
 static svn_error_t *
 update(svn_ra_svn_conn_t *conn,
        apr_pool_t *pool,
@@ -2299,6 +2562,146 @@ get_mergeinfo(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+/* Largest response that we add to the response cache. */
+#define MAX_CACHED_RESPONSE 0x100000
+
+/* Append S to the cache KEY such that the result is unambiguous. */
+static void
+append_key_string(svn_stringbuf_t *key,
+                  const char *s)
+{
+  svn_stringbuf_appendcstr(key, apr_psprintf(key->pool, "%" APR_SIZE_T_FMT
+                                                        ":%s ",
+                                             strlen(s), s));
+}
+
+/* Set *KEY to the key of the response to CMDNAME with the normalized
+ * arguments ARGS in the response cache of B.  Besides ARGS, the key
+ * covers the repository as well as the authz rules and user that the
+ * response depends on.  If WITH_REVPROPS is set, it also covers the
+ * current state of the revprops.
+ *
+ * Set *KEY to NULL if the response must not be cached.  Allocate the
+ * result in POOL. */
+static svn_error_t *
+response_cache_key(const char **key,
+                   server_baton_t *b,
+                   const char *cmdname,
+                   const char *args,
+                   svn_boolean_t with_revprops,
+                   apr_pool_t *pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create(cmdname, pool);
+  const char *authz_user = b->client_info->authz_user;
+
+  *key = NULL;
+  if (!b->response_cache)
+    return SVN_NO_ERROR;
+
+  svn_stringbuf_appendbyte(result, ' ');
+  append_key_string(result, b->repository->uuid);
+  append_key_string(result, b->repository->repos_root);
+
+  /* Without an ID, we could not tell whether the rules changed. */
+  if (b->repository->authzdb)
+    {
+      const char *authz_id = svn_repos__authz_id(b->repository->authzdb,
+                                                 pool);
+      if (!authz_id)
+        return SVN_NO_ERROR;
+
+      append_key_string(result, authz_id);
+    }
+  else
+    {
+      svn_stringbuf_appendcstr(result, "- ");
+    }
+
+  if (authz_user)
+    append_key_string(result, authz_user);
+  else
+    svn_stringbuf_appendcstr(result, "- ");
+
+  /* Revprops may change at any time.  Only FSFS tells us when they do. */
+  if (with_revprops)
+    {
+      svn_fs_fs__ioctl_revprop_generation_output_t *output;
+      svn_error_t *err;
+
+      err = svn_fs_ioctl(b->repository->fs,
+                         SVN_FS_FS__IOCTL_REVPROP_GENERATION,
+                         NULL, (void **)&output, NULL, NULL, pool, pool);
+      if (err)
+        {
+          /* Not FSFS, most likely.  Failing to cache is not fatal. */
+          svn_error_clear(err);
+          return SVN_NO_ERROR;
+        }
+
+      svn_stringbuf_appendcstr(result,
+                               apr_psprintf(pool, "%" APR_INT64_T_FMT
+                                                  ".%" APR_INT64_T_FMT " ",
+                                            output->epoch,
+                                            output->generation));
+    }
+
+  svn_stringbuf_appendcstr(result, args);
+  *key = result->data;
+
+  return SVN_NO_ERROR;
+}
+
+/* If the response cache of B contains the response for KEY, send it over
+ * CONN and set *FOUND.  Otherwise, clear *FOUND and, if KEY is not NULL,
+ * start recording the response for store_cached_response().  Use POOL
+ * for allocations. */
+static svn_error_t *
+send_cached_response(svn_boolean_t *found,
+                     server_baton_t *b,
+                     svn_ra_svn_conn_t *conn,
+                     const char *key,
+                     apr_pool_t *pool)
+{
+  svn_stringbuf_t *response;
+
+  *found = FALSE;
+  if (!key)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_cache__get((void **)&response, found, b->response_cache, key,
+                         pool));
+  if (*found)
+    return svn_error_trace(svn_ra_svn__write_raw(conn, pool, response->data,
+                                                 response->len));
+
+  return svn_error_trace(svn_ra_svn__start_capture(conn, MAX_CACHED_RESPONSE,
+                                                   pool, pool));
+}
+
+/* Stop recording the response on CONN that send_cached_response() started
+ * for KEY and, if STORE is set, add it to the response cache of B.  Do
+ * nothing if KEY is NULL.  Use POOL for temporary allocations. */
+static svn_error_t *
+store_cached_response(server_baton_t *b,
+                      svn_ra_svn_conn_t *conn,
+                      const char *key,
+                      svn_boolean_t store,
+                      apr_pool_t *pool)
+{
+  svn_stringbuf_t *response;
+
+  if (!key)
+    return SVN_NO_ERROR;
+
+  SVN_ERR(svn_ra_svn__end_capture(&response, conn, pool));
+
+  /* Failing to cache is not fatal. */
+  if (store && response)
+    svn_error_clear(svn_cache__set(b->response_cache, key, response, pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* Send a changed paths list entry to the client.
    This implements svn_repos_path_change_receiver_t. */
 static svn_error_t *
@@ -2443,6 +2846,8 @@ log_cmd(svn_ra_svn_conn_t *conn,
   apr_uint64_t limit, include_merged_revs_param;
   log_baton_t lb;
   authz_baton_t ab;
+  const char *cache_key = NULL;
+  svn_boolean_t found;
 
   ab.server = b;
   ab.conn = conn;
@@ -2511,11 +2916,68 @@ log_cmd(svn_ra_svn_conn_t *conn,
                                    strict_node, include_merged_revisions,
                                    revprops, pool)));
 
+  /* Resolve HEAD now, so later commits don't change the meaning of the
+     cached response.  If that fails, so will the log query below. */
+  if (b->response_cache)
+    {
+      svn_revnum_t youngest;
+
+      err = svn_fs_youngest_rev(&youngest, b->repository->fs, pool);
+      if (err)
+        {
+          svn_error_clear(err);
+        }
+      else
+        {
+          svn_stringbuf_t *args;
+
+          if (!SVN_IS_VALID_REVNUM(start_rev))
+            start_rev = youngest;
+          if (!SVN_IS_VALID_REVNUM(end_rev))
+            end_rev = youngest;
+
+          args = svn_stringbuf_createf(pool, "%ld %ld %" APR_UINT64_T_FMT
+                                             " %d %d %d %d ",
+                                       start_rev, end_rev, limit,
+                                       send_changed_paths, strict_node,
+                                       include_merged_revisions,
+                                       full_paths->nelts);
+          for (i = 0; i < full_paths->nelts; i++)
+            append_key_string(args, APR_ARRAY_IDX(full_paths, i,
+                                                  const char *));
+
+          if (revprops)
+            {
+              svn_stringbuf_appendcstr(args,
+                                       apr_psprintf(pool, "%d ",
+                                                    revprops->nelts));
+              for (i = 0; i < revprops->nelts; i++)
+                append_key_string(args, APR_ARRAY_IDX(revprops, i,
+                                                      const char *));
+            }
+          else
+            {
+              svn_stringbuf_appendcstr(args, "all");
+            }
+
+          SVN_ERR(response_cache_key(&cache_key, b, "log", args->data, TRUE,
+                                     pool));
+        }
+    }
+
+  SVN_ERR(send_cached_response(&found, b, conn, cache_key, pool));
+  if (found)
+    return SVN_NO_ERROR;
+
   /* Get logs.  (Can't report errors back to the client at this point.) */
   lb.fs_path = b->repository->fs_path->data;
   lb.conn = conn;
   lb.stack_depth = 0;
   lb.started = FALSE;
+  svn_repos__set_log_threads(b->repository->repos, b->log_threads,
+                             b->fs_config);
+  if (send_changed_paths)
+    SVN_ERR(admit_request(b, svn_repos__sched_op_log_changed_paths, pool));
   err = svn_repos_get_logs5(b->repository->repos, full_paths, start_rev,
                             end_rev, (int) limit,
                             strict_node, include_merged_revisions,
@@ -2525,13 +2987,18 @@ log_cmd(svn_ra_svn_conn_t *conn,
                             revision_receiver, &lb, pool);
 
   write_err = svn_ra_svn__write_word(conn, pool, "done");
+  if (!write_err && !err)
+    write_err = svn_ra_svn__write_cmd_response(conn, pool, "");
+  write_err = svn_error_compose_create(
+                  write_err,
+                  store_cached_response(b, conn, cache_key,
+                                        !err && !write_err, pool));
   if (write_err)
     {
       svn_error_clear(err);
       return write_err;
     }
   SVN_CMD_ERR(err);
-  SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
   return SVN_NO_ERROR;
 }
 
@@ -2739,6 +3206,8 @@ get_location_segments(svn_ra_svn_conn_t *conn,
   const char *relative_path, *canonical_path;
   const char *abs_path;
   authz_baton_t ab;
+  const char *cache_key;
+  svn_boolean_t found;
 
   ab.server = b;
   ab.conn = conn;
@@ -2805,7 +3274,16 @@ get_location_segments(svn_ra_svn_conn_t *conn,
     }
 
   /* All the parameters are fine - let's perform the query against the
-   * repository. */
+   * repository.  The history of fixed revisions never changes, so the
+   * response may be cached. */
+  SVN_ERR(response_cache_key(&cache_key, b, "get-location-segments",
+                             apr_psprintf(pool, "%ld %ld %ld %s",
+                                          peg_revision, start_rev, end_rev,
+                                          abs_path),
+                             FALSE, pool));
+  SVN_ERR(send_cached_response(&found, b, conn, cache_key, pool));
+  if (found)
+    return SVN_NO_ERROR;
 
   /* We store both err and write_err here, so the client will get
    * the "done" even if there was an error in fetching the results. */
@@ -2816,14 +3294,18 @@ get_location_segments(svn_ra_svn_conn_t *conn,
                                          authz_check_access_cb_func(b), &ab,
                                          pool);
   write_err = svn_ra_svn__write_word(conn, pool, "done");
+  if (!write_err && !err)
+    write_err = svn_ra_svn__write_cmd_response(conn, pool, "");
+  write_err = svn_error_compose_create(
+                  write_err,
+                  store_cached_response(b, conn, cache_key,
+                                        !err && !write_err, pool));
   if (write_err)
     {
       return svn_error_compose_create(write_err, err);
     }
   SVN_CMD_ERR(err);
 
-  SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
-
   return SVN_NO_ERROR;
 }
 
@@ -2932,6 +3414,7 @@ get_file_revs(svn_ra_svn_conn_t *conn,
   frb.conn = conn;
   frb.pool = NULL;
 
+  SVN_ERR(admit_request(b, svn_repos__sched_op_file_revs, pool));
   err = svn_repos_get_file_revs2(b->repository->repos, full_path, start_rev,
                                  end_rev, include_merged_revisions,
                                  authz_check_access_cb_func(b), &ab,
@@ -3515,16 +3998,57 @@ replay(svn_ra_svn_conn_t *conn,
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_repos__replay_revstart_func_t for replay_range().
+   REPLAY_BATON is the authz_baton_t of the request. */
+static svn_error_t *
+replay_revstart(svn_revnum_t revision,
+                void *replay_baton,
+                const svn_delta_editor_t **editor,
+                void **edit_baton,
+                apr_hash_t *rev_props,
+                apr_pool_t *pool)
+{
+  authz_baton_t *ab = replay_baton;
+  server_baton_t *b = ab->server;
+
+  SVN_ERR(svn_ra_svn__write_tuple(ab->conn, pool, "w(!", "revprops"));
+  SVN_ERR(svn_ra_svn__write_proplist(ab->conn, pool, rev_props));
+  SVN_ERR(svn_ra_svn__write_tuple(ab->conn, pool, "!)"));
+
+  SVN_ERR(log_command(b, ab->conn, pool,
+                      svn_log__replay(b->repository->fs_path->data, revision,
+                                      pool)));
+
+  svn_ra_svn_get_editor(editor, edit_baton, ab->conn, pool, NULL, NULL);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_repos__replay_revfinish_func_t for replay_range().
+   REPLAY_BATON is the authz_baton_t of the request. */
+static svn_error_t *
+replay_revfinish(svn_revnum_t revision,
+                 void *replay_baton,
+                 const svn_delta_editor_t *editor,
+                 void *edit_baton,
+                 apr_hash_t *rev_props,
+                 apr_pool_t *pool)
+{
+  authz_baton_t *ab = replay_baton;
+
+  return svn_error_trace(svn_ra_svn__write_cmd_finish_replay(ab->conn,
+                                                             pool));
+}
+
 static svn_error_t *
 replay_range(svn_ra_svn_conn_t *conn,
              apr_pool_t *pool,
              svn_ra_svn__list_t *params,
              void *baton)
 {
-  svn_revnum_t start_rev, end_rev, rev, low_water_mark;
+  svn_revnum_t start_rev, end_rev, low_water_mark;
   svn_boolean_t send_deltas;
   server_baton_t *b = baton;
-  apr_pool_t *iterpool;
   authz_baton_t ab;
 
   ab.server = b;
@@ -3536,27 +4060,18 @@ replay_range(svn_ra_svn_conn_t *conn,
 
   SVN_ERR(trivial_auth_request(conn, pool, b));
 
-  iterpool = svn_pool_create(pool);
-  for (rev = start_rev; rev <= end_rev; rev++)
-    {
-      apr_hash_t *props;
-
-      svn_pool_clear(iterpool);
-
-      SVN_CMD_ERR(svn_repos_fs_revision_proplist(&props,
-                                                 b->repository->repos, rev,
-                                                 authz_check_access_cb_func(b),
-                                                 &ab,
-                                                 iterpool));
-      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "w(!", "revprops"));
-      SVN_ERR(svn_ra_svn__write_proplist(conn, iterpool, props));
-      SVN_ERR(svn_ra_svn__write_tuple(conn, iterpool, "!)"));
-
-      SVN_ERR(replay_one_revision(conn, b, rev, low_water_mark,
-                                  send_deltas, iterpool));
+  /* The look-ahead threads check authz while we keep sending, so settle
+     the name to check against up-front. */
+  set_authz_user(b);
 
-    }
-  svn_pool_destroy(iterpool);
+  SVN_CMD_ERR(svn_repos__replay_range(b->repository->repos,
+                                      b->repository->fs_path->data,
+                                      start_rev, end_rev, low_water_mark,
+                                      send_deltas, b->replay_threads,
+                                      b->fs_config,
+                                      authz_check_access_cb_func(b), &ab,
+                                      replay_revstart, replay_revfinish, &ab,
+                                      NULL, NULL, pool));
 
   SVN_ERR(svn_ra_svn__write_cmd_response(conn, pool, ""));
 
@@ -3780,6 +4295,83 @@ list(svn_ra_svn_conn_t *conn,
   return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, ""));
 }
 
+/* Implements svn_repos_blame_receiver_t, sending one blame chunk to the
+ * client.  BATON is the svn_ra_svn_conn_t. */
+static svn_error_t *
+blame_receiver(void *baton,
+               apr_int64_t start_line,
+               svn_revnum_t revision,
+               apr_hash_t *rev_props,
+               apr_pool_t *scratch_pool)
+{
+  svn_ra_svn_conn_t *conn = baton;
+
+  SVN_ERR(svn_ra_svn__write_tuple(conn, scratch_pool, "n(?r)(!",
+                                  (apr_uint64_t) start_line, revision));
+  SVN_ERR(svn_ra_svn__write_proplist(conn, scratch_pool, rev_props));
+  return svn_error_trace(svn_ra_svn__write_tuple(conn, scratch_pool, "!)"));
+}
+
+static svn_error_t *
+blame(svn_ra_svn_conn_t *conn,
+      apr_pool_t *pool,
+      svn_ra_svn__list_t *params,
+      void *baton)
+{
+  server_baton_t *b = baton;
+  const char *path, *full_path, *canonical_path;
+  svn_revnum_t start_rev, end_rev;
+  svn_ra_svn__list_t *options_list;
+  apr_array_header_t *diff_options;
+  int i;
+  svn_error_t *err, *write_err;
+
+  authz_baton_t ab;
+  ab.server = b;
+  ab.conn = conn;
+
+  /* Read the command parameters. */
+  SVN_ERR(svn_ra_svn__parse_tuple(params, "crrl", &path, &start_rev,
+                                  &end_rev, &options_list));
+  SVN_ERR(svn_relpath_canonicalize_safe(&canonical_path, NULL, path,
+                                        pool, pool));
+  full_path = svn_fspath__join(b->repository->fs_path->data,
+                               canonical_path, pool);
+
+  diff_options = apr_array_make(pool, options_list->nelts,
+                                sizeof(const char *));
+  for (i = 0; i < options_list->nelts; ++i)
+    {
+      svn_ra_svn__item_t *elt = &SVN_RA_SVN__LIST_ITEM(options_list, i);
+
+      if (elt->kind != SVN_RA_SVN_STRING)
+        return svn_error_create(SVN_ERR_RA_SVN_MALFORMED_DATA, NULL,
+                                "Diff option not a string");
+
+      APR_ARRAY_PUSH(diff_options, const char *) = elt->u.string.data;
+    }
+
+  SVN_ERR(trivial_auth_request(conn, pool, b));
+  SVN_ERR(log_command(b, conn, pool, "%s",
+                      svn_log__blame(full_path, start_rev, end_rev, pool)));
+
+  /* The chunks are sent as soon as the blame is complete. */
+  err = svn_repos_blame(b->repository->repos, full_path, start_rev, end_rev,
+                        diff_options, authz_check_access_cb_func(b), &ab,
+                        blame_receiver, conn, NULL, NULL, pool);
+
+  /* Finish response. */
+  write_err = svn_ra_svn__write_word(conn, pool, "done");
+  if (write_err)
+    {
+      svn_error_clear(err);
+      return write_err;
+    }
+  SVN_CMD_ERR(err);
+
+  return svn_error_trace(svn_ra_svn__write_cmd_response(conn, pool, ""));
+}
+
 static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "reparent",        reparent },
   { "get-latest-rev",  get_latest_rev },
@@ -3799,6 +4391,7 @@ static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "log",             log_cmd },
   { "check-path",      check_path },
   { "stat",            stat_cmd },
+  { "get-dirs",        get_dirs },
   { "get-locations",   get_locations },
   { "get-location-segments",   get_location_segments },
   { "get-file-revs",   get_file_revs },
@@ -3813,6 +4406,7 @@ static const svn_ra_svn__cmd_entry_t main_commands[] = {
   { "get-deleted-rev", get_deleted_rev },
   { "get-iprops",      get_inherited_props },
   { "list",            list },
+  { "blame",           blame },
   { NULL }
 };
 
@@ -3873,7 +4467,8 @@ repos_path_valid(const char *path)
  * and fs_path fields of REPOSITORY.  VHOST and READ_ONLY flags are the
  * same as in the server baton.
  *
- * CONFIG_POOL shall be used to load config objects.
+ * CONFIG_POOL shall be used to load config objects.  The repository
+ * will be borrowed from REPOS_POOL until RESULT_POOL gets cleaned up.
  *
  * Use SCRATCH_POOL for temporary allocations.
  *
@@ -3886,6 +4481,7 @@ find_repos(const char *url,
            svn_config_t *cfg,
            repository_t *repository,
            svn_repos__config_pool_t *config_pool,
+           svn_repos__repos_pool_t *repos_pool,
            apr_hash_t *fs_config,
            svn_repos_authz_warning_func_t authz_warning_func,
            void *authz_warning_baton,
@@ -3931,8 +4527,9 @@ find_repos(const char *url,
                              "No repository found in '%s'", url);
 
   /* Open the repository and fill in b with the resulting information. */
-  SVN_ERR(svn_repos_open3(&repository->repos, repository->repos_root,
-                          fs_config, result_pool, scratch_pool));
+  SVN_ERR(svn_repos__repos_pool_get(&repository->repos, repos_pool,
+                                    repository->repos_root, fs_config,
+                                    NULL, result_pool, scratch_pool));
   SVN_ERR(svn_repos_remember_client_capabilities(repository->repos,
                                                  repository->capabilities));
   repository->fs = svn_repos_fs(repository->repos);
@@ -4230,7 +4827,18 @@ construct_server_baton(server_baton_t **baton,
 
   b->read_only = params->read_only;
   b->pool = conn_pool;
+
+  if (params->adaptive_compression)
+    svn_ra_svn__set_adaptive_compression(conn, TRUE);
+  if (params->max_buffer_size)
+    svn_ra_svn__set_max_buffer_size(conn, params->max_buffer_size);
   b->vhost = params->vhost;
+  b->response_cache = params->response_cache;
+  b->update_prefetch = params->update_prefetch;
+  b->log_threads = params->log_threads;
+  b->replay_threads = params->replay_threads;
+  b->scheduler = params->scheduler;
+  b->fs_config = params->fs_config;
 
   b->logger = params->logger;
   b->client_info = get_client_info(conn, params, conn_pool);
@@ -4239,7 +4847,7 @@ construct_server_baton(server_baton_t **baton,
    * send an empty mechlist. */
   if (params->compression_level > 0)
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwwwwwww?ww)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_SVNDIFF1,
@@ -4253,11 +4861,20 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_BLAME,
+                                           SVN_RA_SVN_CAP_PIPELINING,
+                                           SVN_RA_SVN_CAP_GET_DIRS,
+                                           svn_zstd__is_available()
+                                             ? SVN_RA_SVN_CAP_SVNDIFF3_ACCEPTED
+                                             : NULL,
+                                           svn_trace__enabled()
+                                             ? SVN_RA_SVN_CAP_TRACE_CONTEXT
+                                             : NULL
                                            ));
   else
     SVN_ERR(svn_ra_svn__write_cmd_response(conn, scratch_pool,
-                                           "nn()(wwwwwwwwwww)",
+                                           "nn()(wwwwwwwwwwwwww?w)",
                                            (apr_uint64_t) 2, (apr_uint64_t) 2,
                                            SVN_RA_SVN_CAP_EDIT_PIPELINE,
                                            SVN_RA_SVN_CAP_ABSENT_ENTRIES,
@@ -4269,7 +4886,13 @@ construct_server_baton(server_baton_t **baton,
                                            SVN_RA_SVN_CAP_INHERITED_PROPS,
                                            SVN_RA_SVN_CAP_EPHEMERAL_TXNPROPS,
                                            SVN_RA_SVN_CAP_GET_FILE_REVS_REVERSE,
-                                           SVN_RA_SVN_CAP_LIST
+                                           SVN_RA_SVN_CAP_LIST,
+                                           SVN_RA_SVN_CAP_BLAME,
+                                           SVN_RA_SVN_CAP_PIPELINING,
+                                           SVN_RA_SVN_CAP_GET_DIRS,
+                                           svn_trace__enabled()
+                                             ? SVN_RA_SVN_CAP_TRACE_CONTEXT
+                                             : NULL
                                            ));
 
   /* Read client response, which we assume to be in version 2 format:
@@ -4336,7 +4959,7 @@ construct_server_baton(server_baton_t **baton,
   err = handle_config_error(find_repos(client_url, params->root, b->vhost,
                                        b->read_only, params->cfg,
                                        b->repository, params->config_pool,
-                                       params->fs_config,
+                                       params->repos_pool, params->fs_config,
                                        handle_authz_warning, b,
                                        conn_pool, scratch_pool),
                             b);
@@ -4432,6 +5055,101 @@ construct_server_baton(server_baton_t **baton,
   return SVN_NO_ERROR;
 }
 
+/* Set *UID to the user id of the process at the other end of the Unix
+   domain socket SOCK. */
+static svn_error_t *
+get_peer_uid(apr_uid_t *uid,
+             apr_socket_t *sock)
+{
+#if defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) \
+    || defined(__OpenBSD__) || defined(__DragonFly__)
+  apr_os_sock_t fd;
+  gid_t gid;
+  apr_status_t status = apr_os_sock_get(&fd, sock);
+
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't get the socket descriptor"));
+  if (getpeereid(fd, uid, &gid))
+    return svn_error_wrap_apr(apr_get_netos_error(),
+                              _("Can't get the peer credentials"));
+
+  return SVN_NO_ERROR;
+#elif defined(SO_PEERCRED)
+  apr_os_sock_t fd;
+  struct ucred cred;
+  socklen_t len = sizeof(cred);
+  apr_status_t status = apr_os_sock_get(&fd, sock);
+
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't get the socket descriptor"));
+  if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len))
+    return svn_error_wrap_apr(apr_get_netos_error(),
+                              _("Can't get the peer credentials"));
+
+  *uid = cred.uid;
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Can't get the peer credentials on this "
+                            "platform"));
+#endif
+}
+
+/* Read the name of the tunnel user that svnserve --tunnel-connect sends
+   ahead of the actual session on CONNECTION and make CONNECTION use
+   tunnel mode parameters for that user.
+
+   A tunnel connector running as some other user than us may only claim
+   its own name, so a shared daemon can't be used to impersonate others.
+   Use POOL for temporary allocations. */
+static svn_error_t *
+accept_tunnel_connection(connection_t *connection,
+                         apr_pool_t *pool)
+{
+#if APR_HAS_USER
+  serve_params_t *params;
+  const char *user;
+  apr_uid_t peer_uid, uid;
+  apr_gid_t gid;
+  apr_status_t status;
+
+  SVN_ERR(svn_ra_svn__read_tuple(connection->conn, pool, "c", &user));
+
+  SVN_ERR(get_peer_uid(&peer_uid, connection->usock));
+  status = apr_uid_current(&uid, &gid, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't get the current user"));
+  if (apr_uid_compare(peer_uid, uid) != APR_SUCCESS)
+    {
+      char *peer_name;
+
+      status = apr_uid_name_get(&peer_name, peer_uid, pool);
+      if (status)
+        return svn_error_wrap_apr(status,
+                                  _("Can't get the name of the peer user"));
+      if (strcmp(peer_name, user) != 0)
+        return svn_error_createf(SVN_ERR_RA_NOT_AUTHORIZED, NULL,
+                                 _("Tunnel user '%s' does not match the "
+                                   "connecting user '%s'"),
+                                 user, peer_name);
+    }
+
+  /* The parameters are shared by all connections. */
+  params = apr_pmemdup(connection->pool, connection->params,
+                       sizeof(*params));
+  params->tunnel = TRUE;
+  params->tunnel_user = apr_pstrdup(connection->pool, user);
+  connection->params = params;
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Tunnel connections are not supported on "
+                            "this platform"));
+#endif
+}
+
 svn_error_t *
 serve_interruptable(svn_boolean_t *terminate_p,
                     connection_t *connection,
@@ -4477,9 +5195,22 @@ serve_interruptable(svn_boolean_t *terminate_p,
                                   connection->params->max_response_size,
                                   connection->pool);
 
+      if (connection->params->metrics)
+        svn_ra_svn__set_command_hook(connection->conn,
+                                     metrics__record_command,
+                                     connection->params->metrics);
+
+      /* Encrypt everything from the greeting on. */
+      if (connection->params->tls)
+        err = svn_ra_svn__tls_accept(connection->conn, connection->usock,
+                                     connection->params->tls, pool);
+      else if (connection->params->tunnel_broker)
+        err = accept_tunnel_connection(connection, pool);
+
       /* Construct server baton and open the repository for the first time. */
-      err = construct_server_baton(&connection->baton, connection->conn,
-                                   connection->params, pool);
+      if (!err)
+        err = construct_server_baton(&connection->baton, connection->conn,
+                                     connection->params, pool);
     }
 
   /* If we can't access the repo for some reason, end this connection. */
@@ -4523,6 +5254,8 @@ serve_interruptable(svn_boolean_t *terminate_p,
 
   /* error or normal end of session. Close the connection */
   svn_pool_destroy(iterpool);
+  if (terminate || err)
+    log_io_stats(connection->baton, connection->conn, pool);
   if (terminate_p)
     *terminate_p = terminate;
 
@@ -4534,7 +5267,11 @@ svn_error_t *serve(svn_ra_svn_conn_t *conn,
                    apr_pool_t *pool)
 {
   server_baton_t *baton = NULL;
+  svn_error_t *err;
 
   SVN_ERR(construct_server_baton(&baton, conn, params, pool));
-  return svn_ra_svn__handle_commands2(conn, pool, main_commands, baton, FALSE);
+  err = svn_ra_svn__handle_commands2(conn, pool, main_commands, baton, FALSE);
+  log_io_stats(baton, conn, pool);
+
+  return svn_error_trace(err);
 }
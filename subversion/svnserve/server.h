@@ -37,7 +37,9 @@ extern "C" {
 #include "svn_ra_svn.h"
 
 #include "private/svn_atomic.h"
+#include "private/svn_cache.h"
 #include "private/svn_mutex.h"
+#include "private/svn_ra_svn_private.h"
 #include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
 
@@ -90,6 +92,13 @@ typedef struct server_baton_t {
                               May be NULL even if log_file is not. */
   svn_boolean_t read_only; /* Disallow write access (global flag) */
   svn_boolean_t vhost;     /* Use virtual-host-based path to repo. */
+  svn_cache__t *response_cache; /* Cached responses; may be NULL. */
+  int update_prefetch;     /* Files to prefetch during updates */
+  int log_threads;         /* Threads per log request */
+  int replay_threads;      /* Threads per replay-range request */
+  svn_repos__scheduler_t *scheduler; /* Limits expensive requests;
+                                        may be NULL. */
+  apr_hash_t *fs_config;   /* FS configuration of all repositories */
   apr_pool_t *pool;
 } server_baton_t;
 
@@ -127,6 +136,9 @@ typedef struct serve_params_t {
   /* all configurations should be opened through this factory */
   svn_repos__config_pool_t *config_pool;
 
+  /* repositories are borrowed from this pool for each connection */
+  svn_repos__repos_pool_t *repos_pool;
+
   /* The FS configuration to be applied to all repositories.
      It mainly contains things like cache settings. */
   apr_hash_t *fs_config;
@@ -143,10 +155,35 @@ typedef struct serve_params_t {
      Defaults to SVN_DELTA_COMPRESSION_LEVEL_DEFAULT. */
   int compression_level;
 
+  /* If set, pick the compression of each delta according to the link
+     speed of the connection, using COMPRESSION_LEVEL for slow links. */
+  svn_boolean_t adaptive_compression;
+
   /* Item size up to which we use the zero-copy code path to transmit
      them over the network.  0 disables that code path. */
   apr_size_t zero_copy_limit;
 
+  /* If not 0, the size up to which the I/O buffers of a connection may
+     grow during sustained transfers. */
+  apr_size_t max_buffer_size;
+
+  /* Number of files whose text deltas an update may prepare on a separate
+     thread, ahead of sending them.  0 disables that. */
+  int update_prefetch;
+
+  /* Number of threads that a log request may use to find the histories
+     of multiple paths.  0 disables that. */
+  int log_threads;
+
+  /* Number of threads that a replay-range request may use to prepare
+     the following revisions while sending the current one.  0 disables
+     that. */
+  int replay_threads;
+
+  /* If not NULL, limits the number of expensive requests that may run
+     concurrently, shared by all connections. */
+  svn_repos__scheduler_t *scheduler;
+
   /* Amount of data to send between checks for cancellation requests
      coming in from the client. */
   apr_size_t error_check_interval;
@@ -159,6 +196,20 @@ typedef struct serve_params_t {
 
   /* Use virtual-host-based path to repo. */
   svn_boolean_t vhost;
+
+  /* If not NULL, encrypt all connections with TLS. */
+  svn_ra_svn__tls_server_t *tls;
+
+  /* Whether connections are tunnels forwarded by svnserve --tunnel-connect.
+     These start with the name of the tunnel user. */
+  svn_boolean_t tunnel_broker;
+
+  /* If not NULL, collect performance figures of all connections. */
+  struct metrics_t *metrics;
+
+  /* If not NULL, responses to log and get-location-segments commands,
+     shared by all connections. */
+  svn_cache__t *response_cache;
 } serve_params_t;
 
 /* This structure contains all data that describes a client / server
@@ -31,6 +31,7 @@
 #include <apr_signal.h>
 #include <apr_thread_proc.h>
 #include <apr_portable.h>
+#include <apr_poll.h>
 
 #include <locale.h>
 
@@ -49,14 +50,19 @@
 #include "svn_version.h"
 #include "svn_io.h"
 #include "svn_hash.h"
+#include "svn_user.h"
 
 #include "svn_private_config.h"
 
 #include "private/svn_dep_compat.h"
 #include "private/svn_cmdline_private.h"
 #include "private/svn_atomic.h"
+#include "private/svn_cache.h"
 #include "private/svn_mutex.h"
+#include "private/svn_ra_svn_private.h"
+#include "private/svn_repos_private.h"
 #include "private/svn_subr_private.h"
+#include "private/svn_trace.h"
 
 #if APR_HAS_THREADS
 #    include <apr_thread_pool.h>
@@ -70,6 +76,7 @@
 
 #include "server.h"
 #include "logger.h"
+#include "metrics.h"
 
 /* The strategy for handling incoming connections.  Some of these may be
    unavailable due to platform limitations. */
@@ -145,6 +152,15 @@ enum run_mode {
  */
 #define THREADPOOL_THREAD_IDLE_LIMIT 1000000
 
+/* Number of idle connections that the poll set of --event-loop is sized
+ * for.  With epoll and kqueue, this is merely a hint.
+ */
+#define EVENT_LOOP_SIZE 16384
+
+/* Number of microseconds between two updates of the --metrics-file.
+ */
+#define METRICS_INTERVAL apr_time_from_sec(10)
+
 /* Number of client to server connections that may concurrently in the
  * TCP 3-way handshake state, i.e. are in the process of being created.
  *
@@ -222,6 +238,24 @@ void winservice_notify_stop(void)
 #define SVNSERVE_OPT_MAX_REQUEST     274
 #define SVNSERVE_OPT_MAX_RESPONSE    275
 #define SVNSERVE_OPT_CACHE_NODEPROPS 276
+#define SVNSERVE_OPT_SHARED_CACHE    277
+#define SVNSERVE_OPT_EVENT_LOOP      278
+#define SVNSERVE_OPT_TLS_CERT        279
+#define SVNSERVE_OPT_TLS_KEY         280
+#define SVNSERVE_OPT_TUNNEL_LISTEN   281
+#define SVNSERVE_OPT_TUNNEL_CONNECT  282
+#define SVNSERVE_OPT_METRICS_FILE    283
+#define SVNSERVE_OPT_CACHE_RESPONSES 284
+#define SVNSERVE_OPT_UPDATE_PREFETCH 285
+#define SVNSERVE_OPT_AUTHZ_CACHE_DIR 286
+#define SVNSERVE_OPT_LOG_THREADS     287
+#define SVNSERVE_OPT_TRACE_FILE      288
+#define SVNSERVE_OPT_MEMORY_BUDGET   289
+#define SVNSERVE_OPT_MAX_LOG_VERBOSE 290
+#define SVNSERVE_OPT_MAX_FILE_REVS   291
+#define SVNSERVE_OPT_MAX_DEEP_REPORTS 292
+#define SVNSERVE_OPT_BULK_USER       293
+#define SVNSERVE_OPT_REPLAY_THREADS  294
 
 /* Text macro because we can't use #ifdef sections inside a N_("...")
    macro expansion. */
@@ -251,11 +285,15 @@ static const apr_getopt_option_t svnserve__options[] =
      N_("read configuration from file ARG")},
     {"listen-port",       SVNSERVE_OPT_LISTEN_PORT, 1,
 #ifdef WIN32
-     N_("listen port. The default port is 3690.\n"
+     N_("listen port. The default port is 3690, or 3691\n"
+        "                             "
+        "with --tls-cert.\n"
         "                             "
         "[mode: daemon, service, listen-once]")},
 #else
-     N_("listen port. The default port is 3690.\n"
+     N_("listen port. The default port is 3690, or 3691\n"
+        "                             "
+        "with --tls-cert.\n"
         "                             "
         "[mode: daemon, listen-once]")},
 #endif
@@ -286,7 +324,9 @@ static const apr_getopt_option_t svnserve__options[] =
         "                             "
         "[0 .. no compression, 5 .. default, \n"
         "                             "
-        " 9 .. maximum compression]")},
+        " 9 .. maximum compression, \n"
+        "                             "
+        " adaptive .. choose by link speed]")},
     {"memory-cache-size", 'M', 1,
      N_("size of the extra in-memory cache in MB used to\n"
         "                             "
@@ -297,6 +337,12 @@ static const apr_getopt_option_t svnserve__options[] =
         "0 switches to dynamically sized caches.\n"
         "                             "
         "[used for FSFS and FSX repositories only]")},
+    {"memory-cache-shared", SVNSERVE_OPT_SHARED_CACHE, 0,
+     N_("share the in-memory cache between all connection\n"
+        "                             "
+        "processes instead of using one cache per process.\n"
+        "                             "
+        "[mode: daemon, not used with --threads]")},
     {"cache-txdeltas", SVNSERVE_OPT_CACHE_TXDELTAS, 1,
      N_("enable or disable caching of deltas between older\n"
         "                             "
@@ -325,6 +371,16 @@ static const apr_getopt_option_t svnserve__options[] =
         "Default is yes.\n"
         "                             "
         "[used for FSFS repositories only]")},
+    {"cache-responses", SVNSERVE_OPT_CACHE_RESPONSES, 1,
+     N_("enable or disable caching of responses to log and\n"
+        "                             "
+        "get-location-segments requests in the in-memory\n"
+        "                             "
+        "cache.  Changes to svn:log and other revision\n"
+        "                             "
+        "properties are detected for FSFS repositories only.\n"
+        "                             "
+        "Default is no.")},
     {"client-speed", SVNSERVE_OPT_CLIENT_SPEED, 1,
      N_("Optimize network handling based on the assumption\n"
         "                             "
@@ -362,6 +418,66 @@ static const apr_getopt_option_t svnserve__options[] =
         "                             "
         "Default is " APR_STRINGIFY(THREADPOOL_MAX_SIZE) "."
         ONLY_AVAILABLE_WITH_THEADS)},
+    {"event-loop",       SVNSERVE_OPT_EVENT_LOOP, 0,
+     N_("Let idle connections wait in a poll set instead\n"
+        "                             "
+        "of occupying a server thread each.  Use this\n"
+        "                             "
+        "when serving many mostly idle connections."
+        ONLY_AVAILABLE_WITH_THEADS)},
+    {"update-prefetch",  SVNSERVE_OPT_UPDATE_PREFETCH, 1,
+     N_("Number of files whose text deltas an update may\n"
+        "                             "
+        "prepare on a separate thread ahead of sending\n"
+        "                             "
+        "them.  Default is 0 (disabled)."
+        ONLY_AVAILABLE_WITH_THEADS)},
+    {"log-threads",      SVNSERVE_OPT_LOG_THREADS, 1,
+     N_("Number of threads that a log request for\n"
+        "                             "
+        "multiple paths may use to find their history.\n"
+        "                             "
+        "Default is 0 (disabled)."
+        ONLY_AVAILABLE_WITH_THEADS)},
+    {"replay-threads",   SVNSERVE_OPT_REPLAY_THREADS, 1,
+     N_("Number of threads that a replay of a revision\n"
+        "                             "
+        "range may use to prepare the following revisions\n"
+        "                             "
+        "while sending the current one.  Default is 0\n"
+        "                             "
+        "(disabled)."
+        ONLY_AVAILABLE_WITH_THEADS)},
+    {"max-log-verbose",  SVNSERVE_OPT_MAX_LOG_VERBOSE, 1,
+     N_("Maximum number of log requests with changed\n"
+        "                             "
+        "paths that may run concurrently.  Others wait.\n"
+        "                             "
+        "Default is 0 (unlimited)."
+        ONLY_AVAILABLE_WITH_THEADS)},
+    {"max-file-revs",    SVNSERVE_OPT_MAX_FILE_REVS, 1,
+     N_("Maximum number of blame requests that may run\n"
+        "                             "
+        "concurrently.  Others wait.\n"
+        "                             "
+        "Default is 0 (unlimited)."
+        ONLY_AVAILABLE_WITH_THEADS)},
+    {"max-deep-reports", SVNSERVE_OPT_MAX_DEEP_REPORTS, 1,
+     N_("Maximum number of checkouts, updates and other\n"
+        "                             "
+        "tree-wide reports that may run concurrently.\n"
+        "                             "
+        "Others wait.  Default is 0 (unlimited)."
+        ONLY_AVAILABLE_WITH_THEADS)},
+    {"bulk-user",        SVNSERVE_OPT_BULK_USER, 1,
+     N_("Let requests of this user, e.g. a mirror or a\n"
+        "                             "
+        "crawler, wait for those of other users when\n"
+        "                             "
+        "one of the limits above is reached.  May be\n"
+        "                             "
+        "given multiple times."
+        ONLY_AVAILABLE_WITH_THEADS)},
 #endif
     {"max-request-size", SVNSERVE_OPT_MAX_REQUEST, 1,
      N_("Maximum acceptable size of a client request in MB.\n"
@@ -386,6 +502,16 @@ static const apr_getopt_option_t svnserve__options[] =
         "checking out at the wrong path level.\n"
         "                             "
         "Default is 0 (disabled).")},
+    {"memory-budget",    SVNSERVE_OPT_MEMORY_BUDGET, 1,
+     N_("Maximum size of the server process in MB.\n"
+        "                             "
+        "Requests that are being processed while the\n"
+        "                             "
+        "process is larger than that fail with an error\n"
+        "                             "
+        "instead of pushing the host into swap.\n"
+        "                             "
+        "Default is 0 (disabled).")},
     {"foreground",        SVNSERVE_OPT_FOREGROUND, 0,
      N_("run in foreground (useful for debugging)\n"
         "                             "
@@ -396,6 +522,24 @@ static const apr_getopt_option_t svnserve__options[] =
         "process (useful for debugging)")},
     {"log-file",         SVNSERVE_OPT_LOG_FILE, 1,
      N_("svnserve log file")},
+    {"metrics-file",     SVNSERVE_OPT_METRICS_FILE, 1,
+     N_("periodically write per-command latency and I/O\n"
+        "                             "
+        "figures as well as connection and thread counts\n"
+        "                             "
+        "to file ARG in the Prometheus text format\n"
+        "                             "
+        "[mode: daemon]")},
+    {"trace-file",       SVNSERVE_OPT_TRACE_FILE, 1,
+     N_("append a trace span per command to file ARG and\n"
+        "                             "
+        "continue the traces of clients that send them")},
+    {"authz-cache-dir",  SVNSERVE_OPT_AUTHZ_CACHE_DIR, 1,
+     N_("keep the compiled authz rules in directory ARG,\n"
+        "                             "
+        "so other svnserve processes do not need to parse\n"
+        "                             "
+        "the same authz files again")},
     {"pid-file",         SVNSERVE_OPT_PID_FILE, 1,
 #ifdef WIN32
      N_("write server process ID to file ARG\n"
@@ -406,10 +550,36 @@ static const apr_getopt_option_t svnserve__options[] =
         "                             "
         "[mode: daemon, listen-once]")},
 #endif
+    {"tls-cert",         SVNSERVE_OPT_TLS_CERT, 1,
+     N_("encrypt connections with TLS, presenting the PEM\n"
+        "                             "
+        "encoded certificate chain in file ARG.  Clients\n"
+        "                             "
+        "connect with svns:// URLs.  Requires --tls-key.")},
+    {"tls-key",          SVNSERVE_OPT_TLS_KEY, 1,
+     N_("read the unencrypted PEM private key for\n"
+        "                             "
+        "--tls-cert from file ARG")},
     {"tunnel-user",      SVNSERVE_OPT_TUNNEL_USER, 1,
      N_("tunnel username (default is current uid's name)\n"
         "                             "
         "[mode: tunnel]")},
+    {"tunnel-listen",    SVNSERVE_OPT_TUNNEL_LISTEN, 1,
+     N_("accept tunnel connections forwarded by\n"
+        "                             "
+        "--tunnel-connect on the Unix socket ARG instead\n"
+        "                             "
+        "of listening on a TCP port\n"
+        "                             "
+        "[mode: daemon, listen-once]")},
+    {"tunnel-connect",   SVNSERVE_OPT_TUNNEL_CONNECT, 1,
+     N_("forward the tunnel connection to the daemon\n"
+        "                             "
+        "started with --tunnel-listen=ARG, or serve it\n"
+        "                             "
+        "ourselves if there is no such daemon\n"
+        "                             "
+        "[mode: tunnel]")},
     {"help",             'h', 0, N_("display this help")},
     {"virtual-host",     SVNSERVE_OPT_VIRTUAL_HOST, 0,
      N_("virtual host mode (look for repo in directory\n"
@@ -556,6 +726,8 @@ accept_connection(connection_t **connection,
 
       status = apr_socket_accept(&(*connection)->usock, sock,
                                  connection_pool);
+      if (status == APR_SUCCESS)
+        metrics__connection_opened(params->metrics);
 #if APR_HAVE_SIGACTION
       if (sigtermint_seen)
           break;
@@ -596,7 +768,10 @@ close_connection(connection_t *connection)
 {
   /* this will automatically close USOCK */
   if (svn_atomic_dec(&connection->ref_count) == 0)
-    svn_pool_destroy(connection->pool);
+    {
+      metrics__connection_closed(connection->params->metrics);
+      svn_pool_destroy(connection->pool);
+    }
 }
 
 /* Wrapper around serve() that takes a socket instead of a connection.
@@ -669,6 +844,192 @@ static void * APR_THREAD_FUNC serve_thread(apr_thread_t *tid, void *data)
   return NULL;
 }
 
+/* With --event-loop, the poll set that idle connections wait in for their
+   next command, together with the listening socket.  NULL otherwise. */
+static apr_pollset_t *idle_connections = NULL;
+
+/* Load determination callback for serve_interruptable in event loop mode:
+   Never block in the socket read() function but return to the caller
+   once there is no command waiting. */
+static svn_boolean_t
+always_busy(connection_t *connection)
+{
+  return TRUE;
+}
+
+/* Make CONNECTION wait in IDLE_CONNECTIONS for its next command. */
+static svn_error_t *
+park_connection(connection_t *connection)
+{
+  apr_pollfd_t pfd = { 0 };
+  apr_status_t status;
+
+  pfd.p = connection->pool;
+  pfd.desc_type = APR_POLL_SOCKET;
+  pfd.desc.s = connection->usock;
+  pfd.reqevents = APR_POLLIN;
+  pfd.client_data = connection;
+
+  status = apr_pollset_add(idle_connections, &pfd);
+
+  return status
+       ? svn_error_wrap_apr(status, _("Can't add connection to poll set"))
+       : SVN_NO_ERROR;
+}
+
+/* Serve the connection given by DATA in event loop mode: serve all
+   commands already waiting for it and then park it in IDLE_CONNECTIONS
+   until the next one arrives. */
+static void * APR_THREAD_FUNC serve_event_thread(apr_thread_t *tid,
+                                                 void *data)
+{
+  svn_boolean_t done = FALSE;
+  svn_boolean_t has_command = TRUE;
+  connection_t *connection = data;
+  svn_error_t *err = SVN_NO_ERROR;
+
+  apr_pool_t *pool = svn_root_pools__acquire_pool(connection_pools);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* A new connection blocks here for its handshake, an idle one got
+     woken up because data arrived.  Either way, this won't wait long. */
+  while (!err && !done && has_command)
+    {
+      svn_pool_clear(iterpool);
+      err = serve_interruptable(&done, connection, always_busy, iterpool);
+
+      /* Pipelined commands may already sit in our receive buffer, which
+         the poll set would not notice. */
+      if (!err && !done)
+        err = svn_ra_svn__has_command(&has_command, &done, connection->conn,
+                                      iterpool);
+    }
+
+  if (!err && !done)
+    err = park_connection(connection);
+
+  if (err)
+    {
+      logger__log_error(connection->params->logger, err, NULL,
+                        get_client_info(connection->conn, connection->params,
+                                        iterpool));
+      svn_error_clear(err);
+      done = TRUE;
+    }
+  svn_pool_destroy(iterpool);
+  svn_root_pools__release_pool(pool, connection_pools);
+
+  if (done)
+    close_connection(connection);
+
+  return NULL;
+}
+
+/* Accept connections on SOCK and serve them in THREADS, using PARAMS.
+ * Instead of waiting for the next command in a thread of their own, idle
+ * connections wait in IDLE_CONNECTIONS and only get handed to a thread
+ * once their next command arrives.  Return when SIGTERM has been seen or
+ * on error.  Use POOL for allocations.
+ */
+static svn_error_t *
+run_event_loop(apr_socket_t *sock,
+               serve_params_t *params,
+               apr_pool_t *pool)
+{
+  apr_pollfd_t listener = { 0 };
+  apr_status_t status;
+
+  listener.p = pool;
+  listener.desc_type = APR_POLL_SOCKET;
+  listener.desc.s = sock;
+  listener.reqevents = APR_POLLIN;
+  listener.client_data = NULL;
+
+  status = apr_pollset_add(idle_connections, &listener);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't add socket to poll set"));
+
+  while (1)
+    {
+      apr_int32_t count;
+      const apr_pollfd_t *ready;
+      int i;
+
+      status = apr_pollset_poll(idle_connections, -1, &count, &ready);
+#if APR_HAVE_SIGACTION
+      if (sigtermint_seen)
+        break;
+#endif
+      if (APR_STATUS_IS_EINTR(status))
+        continue;
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't poll connections"));
+
+      for (i = 0; i < count; i++)
+        {
+          connection_t *connection = ready[i].client_data;
+
+          if (connection)
+            {
+              /* The worker will park it again, if necessary. */
+              status = apr_pollset_remove(idle_connections, &ready[i]);
+              if (status)
+                return svn_error_wrap_apr(status,
+                                          _("Can't remove connection "
+                                            "from poll set"));
+            }
+          else
+            {
+              SVN_ERR(accept_connection(&connection, sock, params,
+                                        connection_mode_thread, pool));
+#if APR_HAVE_SIGACTION
+              if (sigtermint_seen)
+                return SVN_NO_ERROR;
+#endif
+            }
+
+          status = apr_thread_pool_push(threads, serve_event_thread,
+                                        connection, 0, NULL);
+          if (status)
+            return svn_error_wrap_apr(status, _("Can't push task"));
+        }
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Write the metrics of the serve_params_t given by DATA to their file
+   every METRICS_INTERVAL for the rest of the lifetime of this process. */
+static void * APR_THREAD_FUNC metrics_thread(apr_thread_t *tid, void *data)
+{
+  serve_params_t *params = data;
+  apr_pool_t *pool = svn_pool_create(NULL);
+
+  while (1)
+    {
+      svn_error_t *err;
+
+      apr_sleep(METRICS_INTERVAL);
+      svn_pool_clear(pool);
+
+      if (threads)
+        err = metrics__write(params->metrics,
+                             apr_thread_pool_busy_count(threads),
+                             apr_thread_pool_thread_max_get(threads),
+                             pool);
+      else
+        err = metrics__write(params->metrics, 0, 0, pool);
+
+      if (err)
+        {
+          logger__log_error(params->logger, err, NULL, NULL);
+          svn_error_clear(err);
+        }
+    }
+
+  return NULL;
+}
+
 #endif
 
 /* Write the PID of the current process as a decimal number, followed by a
@@ -691,6 +1052,299 @@ static svn_error_t *write_pid_file(const char *filename, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Set *SOCK_P to a new socket, allocated in POOL, that listens on PORT
+   of HOST.  If HOST is NULL, listen on all addresses, preferring IPv6 ones
+   if PREFER_V6 is set. */
+static svn_error_t *
+listen_on_tcp_socket(apr_socket_t **sock_p,
+                     const char *host,
+                     apr_port_t port,
+                     svn_boolean_t prefer_v6,
+                     apr_pool_t *pool)
+{
+  apr_socket_t *sock;
+  apr_sockaddr_t *sa;
+  apr_status_t status;
+  int family = APR_INET;
+  apr_int32_t sockaddr_info_flags = 0;
+
+  /* Make sure we have IPV6 support first before giving apr_sockaddr_info_get
+     APR_UNSPEC, because it may give us back an IPV6 address even if we can't
+     create IPV6 sockets. */
+
+#if APR_HAVE_IPV6
+#ifdef MAX_SECS_TO_LINGER
+  /* ### old APR interface */
+  status = apr_socket_create(&sock, APR_INET6, SOCK_STREAM, pool);
+#else
+  status = apr_socket_create(&sock, APR_INET6, SOCK_STREAM, APR_PROTO_TCP,
+                             pool);
+#endif
+  if (status == 0)
+    {
+      apr_socket_close(sock);
+      family = APR_UNSPEC;
+
+      if (prefer_v6)
+        {
+          if (host == NULL)
+            host = "::";
+          sockaddr_info_flags = APR_IPV6_ADDR_OK;
+        }
+      else
+        {
+          if (host == NULL)
+            host = "0.0.0.0";
+          sockaddr_info_flags = APR_IPV4_ADDR_OK;
+        }
+    }
+#endif
+
+  status = apr_sockaddr_info_get(&sa, host, family, port,
+                                 sockaddr_info_flags, pool);
+  if (status)
+    {
+      return svn_error_wrap_apr(status, _("Can't get address info"));
+    }
+
+
+#ifdef MAX_SECS_TO_LINGER
+  /* ### old APR interface */
+  status = apr_socket_create(&sock, sa->family, SOCK_STREAM, pool);
+#else
+  status = apr_socket_create(&sock, sa->family, SOCK_STREAM, APR_PROTO_TCP,
+                             pool);
+#endif
+  if (status)
+    {
+      return svn_error_wrap_apr(status, _("Can't create server socket"));
+    }
+
+  /* Prevents "socket in use" errors when server is killed and quickly
+   * restarted. */
+  status = apr_socket_opt_set(sock, APR_SO_REUSEADDR, 1);
+  if (status)
+    {
+      return svn_error_wrap_apr(status, _("Can't set options on server socket"));
+    }
+
+  status = apr_socket_bind(sock, sa);
+  if (status)
+    {
+      return svn_error_wrap_apr(status, _("Can't bind server socket"));
+    }
+
+  status = apr_socket_listen(sock, ACCEPT_BACKLOG);
+  if (status)
+    {
+      return svn_error_wrap_apr(status, _("Can't listen on server socket"));
+    }
+
+  *sock_p = sock;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *SOCK_P to a new socket, allocated in POOL, that listens on the Unix
+   domain socket PATH for connections from svnserve --tunnel-connect. */
+static svn_error_t *
+listen_on_unix_socket(apr_socket_t **sock_p,
+                      const char *path,
+                      apr_pool_t *pool)
+{
+#ifdef APR_UNIX
+  apr_socket_t *sock;
+  apr_sockaddr_t *sa;
+  apr_status_t status;
+  const char *native_path;
+
+  SVN_ERR(svn_utf_cstring_from_utf8(&native_path,
+                                    svn_dirent_local_style(path, pool),
+                                    pool));
+
+  /* Remove the socket of an earlier instance. */
+  SVN_ERR(svn_io_remove_file2(path, TRUE, pool));
+
+  status = apr_sockaddr_info_get(&sa, native_path, APR_UNIX, 0, 0, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't get address info"));
+
+  status = apr_socket_create(&sock, APR_UNIX, SOCK_STREAM, 0, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create server socket"));
+
+  status = apr_socket_bind(sock, sa);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't bind server socket"));
+
+  status = apr_socket_listen(sock, ACCEPT_BACKLOG);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't listen on server socket"));
+
+  *sock_p = sock;
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+                          _("Unix domain sockets are not supported on "
+                            "this platform"));
+#endif
+}
+
+#ifdef APR_UNIX
+/* Send all LEN bytes of DATA to SOCK. */
+static svn_error_t *
+send_all(apr_socket_t *sock,
+         const char *data,
+         apr_size_t len)
+{
+  while (len > 0)
+    {
+      apr_size_t written = len;
+      apr_status_t status = apr_socket_send(sock, data, &written);
+
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't write to connection"));
+
+      data += written;
+      len -= written;
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Copy everything from our stdin to SOCK and everything from SOCK to our
+   stdout, until the daemon closes the connection.  Use POOL for
+   allocations. */
+static svn_error_t *
+relay_tunnel(apr_socket_t *sock,
+             apr_pool_t *pool)
+{
+  apr_file_t *in, *out;
+  apr_pollfd_t pfds[2] = { { 0 } };
+  svn_boolean_t in_open = TRUE;
+  char *buffer = apr_palloc(pool, SVN__STREAM_CHUNK_SIZE);
+  apr_status_t status;
+
+  status = apr_file_open_stdin(&in, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't open stdin"));
+  status = apr_file_open_stdout(&out, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't open stdout"));
+
+  pfds[0].p = pool;
+  pfds[0].desc_type = APR_POLL_SOCKET;
+  pfds[0].desc.s = sock;
+  pfds[0].reqevents = APR_POLLIN;
+  pfds[1].p = pool;
+  pfds[1].desc_type = APR_POLL_FILE;
+  pfds[1].desc.f = in;
+  pfds[1].reqevents = APR_POLLIN;
+
+  while (TRUE)
+    {
+      apr_int32_t count;
+      apr_size_t len;
+
+      status = apr_poll(pfds, in_open ? 2 : 1, &count, -1);
+      if (APR_STATUS_IS_EINTR(status))
+        continue;
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't poll the tunnel"));
+
+      if (pfds[0].rtnevents)
+        {
+          len = SVN__STREAM_CHUNK_SIZE;
+          status = apr_socket_recv(sock, buffer, &len);
+          if (len)
+            SVN_ERR(svn_io_file_write_full(out, buffer, len, NULL, pool));
+
+          /* The daemon is done with this connection. */
+          if (APR_STATUS_IS_EOF(status))
+            return SVN_NO_ERROR;
+          if (status)
+            return svn_error_wrap_apr(status,
+                                      _("Can't read from connection"));
+        }
+
+      if (in_open && pfds[1].rtnevents)
+        {
+          len = SVN__STREAM_CHUNK_SIZE;
+          status = apr_file_read(in, buffer, &len);
+          if (len)
+            SVN_ERR(send_all(sock, buffer, len));
+
+          /* Let the daemon see the EOF, but keep forwarding its output. */
+          if (APR_STATUS_IS_EOF(status))
+            {
+              in_open = FALSE;
+              apr_socket_shutdown(sock, APR_SHUTDOWN_WRITE);
+            }
+          else if (status)
+            {
+              return svn_error_wrap_apr(status, _("Can't read stdin"));
+            }
+        }
+    }
+}
+
+#endif
+
+/* Forward the tunnel connection on our stdin / stdout to the svnserve
+   daemon listening on the Unix domain socket PATH, telling it that the
+   connection belongs to TUNNEL_USER.  If no daemon accepts the connection,
+   set *CONNECTED to FALSE and return, so we can serve it ourselves.
+   Use POOL for allocations. */
+static svn_error_t *
+tunnel_connect(svn_boolean_t *connected,
+               const char *path,
+               const char *tunnel_user,
+               apr_pool_t *pool)
+{
+#ifdef APR_UNIX
+  apr_socket_t *sock;
+  apr_sockaddr_t *sa;
+  apr_status_t status;
+  const char *native_path;
+  const char *preamble;
+
+  *connected = FALSE;
+
+  SVN_ERR(svn_utf_cstring_from_utf8(&native_path,
+                                    svn_dirent_local_style(path, pool),
+                                    pool));
+
+  status = apr_sockaddr_info_get(&sa, native_path, APR_UNIX, 0, 0, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't get address info"));
+
+  status = apr_socket_create(&sock, APR_UNIX, SOCK_STREAM, 0, pool);
+  if (status)
+    return svn_error_wrap_apr(status, _("Can't create socket"));
+
+  status = apr_socket_connect(sock, sa);
+  if (status)
+    {
+      apr_socket_close(sock);
+      return SVN_NO_ERROR;
+    }
+
+  *connected = TRUE;
+
+  /* The daemon expects the user name as an ra_svn tuple. */
+  preamble = apr_psprintf(pool, "( %" APR_SIZE_T_FMT ":%s ) ",
+                          strlen(tunnel_user), tunnel_user);
+  SVN_ERR(send_all(sock, preamble, strlen(preamble)));
+
+  return svn_error_trace(relay_tunnel(sock, pool));
+#else
+  *connected = FALSE;
+
+  return SVN_NO_ERROR;
+#endif
+}
+
 /* Version compatibility check */
 static svn_error_t *
 check_lib_versions(void)
@@ -721,7 +1375,6 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   enum run_mode run_mode = run_mode_unspecified;
   svn_boolean_t foreground = FALSE;
   apr_socket_t *sock;
-  apr_sockaddr_t *sa;
   svn_error_t *err;
   apr_getopt_t *os;
   int opt;
@@ -738,13 +1391,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   svn_boolean_t cache_txdeltas = TRUE;
   svn_boolean_t cache_revprops = FALSE;
   svn_boolean_t use_block_read = FALSE;
+  svn_boolean_t share_memory_cache = FALSE;
+  svn_boolean_t cache_responses = FALSE;
+  svn_boolean_t use_event_loop = FALSE;
   apr_uint16_t port = SVN_RA_SVN_PORT;
+  svn_boolean_t port_given = FALSE;
   const char *host = NULL;
-  int family = APR_INET;
-  apr_int32_t sockaddr_info_flags = 0;
-#if APR_HAVE_IPV6
   svn_boolean_t prefer_v6 = FALSE;
-#endif
   svn_boolean_t quiet = FALSE;
   svn_boolean_t is_version = FALSE;
   int mode_opt_count = 0;
@@ -752,9 +1405,17 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   const char *config_filename = NULL;
   const char *pid_filename = NULL;
   const char *log_filename = NULL;
+  const char *metrics_filename = NULL;
+  const char *tls_cert_filename = NULL;
+  const char *tls_key_filename = NULL;
+  const char *tunnel_listen_filename = NULL;
+  const char *tunnel_connect_filename = NULL;
   svn_node_kind_t kind;
   apr_size_t min_thread_count = THREADPOOL_MIN_SIZE;
   apr_size_t max_thread_count = THREADPOOL_MAX_SIZE;
+  int sched_limits[SVN_REPOS__SCHED_OP_COUNT] = { 0 };
+  apr_array_header_t *bulk_users = apr_array_make(pool, 0,
+                                                  sizeof(const char *));
 #ifdef SVN_HAVE_SASL
   SVN_ERR(cyrus_init(pool));
 #endif
@@ -777,16 +1438,23 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   params.base = NULL;
   params.cfg = NULL;
   params.compression_level = SVN_DELTA_COMPRESSION_LEVEL_DEFAULT;
+  params.adaptive_compression = FALSE;
   params.logger = NULL;
   params.config_pool = NULL;
+  params.repos_pool = NULL;
   params.fs_config = NULL;
   params.vhost = FALSE;
   params.username_case = CASE_ASIS;
   params.memory_cache_size = (apr_uint64_t)-1;
   params.zero_copy_limit = 0;
+  params.max_buffer_size = 0;
+  params.update_prefetch = 0;
+  params.log_threads = 0;
+  params.replay_threads = 0;
   params.error_check_interval = 4096;
   params.max_request_size = MAX_REQUEST_SIZE * 0x100000;
   params.max_response_size = 0;
+  params.tls = NULL;
 
   while (1)
     {
@@ -854,6 +1522,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
               return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, err,
                                        _("Invalid port '%s'"), arg);
             port = (apr_uint16_t)val;
+            port_given = TRUE;
           }
           break;
 
@@ -906,6 +1575,13 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           break;
 
         case 'c':
+          if (strcmp(arg, "adaptive") == 0)
+            {
+              params.adaptive_compression = TRUE;
+              break;
+            }
+
+          params.adaptive_compression = FALSE;
           params.compression_level = atoi(arg);
           if (params.compression_level < SVN_DELTA_COMPRESSION_LEVEL_NONE)
             params.compression_level = SVN_DELTA_COMPRESSION_LEVEL_NONE;
@@ -938,10 +1614,18 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           cache_nodeprops = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
 
+        case SVNSERVE_OPT_CACHE_RESPONSES:
+          cache_responses = svn_tristate__from_word(arg) == svn_tristate_true;
+          break;
+
         case SVNSERVE_OPT_BLOCK_READ:
           use_block_read = svn_tristate__from_word(arg) == svn_tristate_true;
           break;
 
+        case SVNSERVE_OPT_SHARED_CACHE:
+          share_memory_cache = TRUE;
+          break;
+
         case SVNSERVE_OPT_CLIENT_SPEED:
           {
             apr_size_t bandwidth = (apr_size_t)apr_strtoi64(arg, NULL, 0);
@@ -955,6 +1639,9 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
 
                 /* check for aborted connections at the same rate */
                 params.error_check_interval = bandwidth * 120;
+
+                /* and let each system call carry that much */
+                params.max_buffer_size = bandwidth * 120;
               }
           }
           break;
@@ -967,6 +1654,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           params.max_response_size = 0x100000 * apr_strtoi64(arg, NULL, 0);
           break;
 
+        case SVNSERVE_OPT_MEMORY_BUDGET:
+          svn_pool__set_memory_budget(0x100000 * apr_strtoi64(arg, NULL, 0));
+          break;
+
         case SVNSERVE_OPT_MIN_THREADS:
           min_thread_count = (apr_size_t)apr_strtoi64(arg, NULL, 0);
           break;
@@ -975,6 +1666,43 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           max_thread_count = (apr_size_t)apr_strtoi64(arg, NULL, 0);
           break;
 
+        case SVNSERVE_OPT_UPDATE_PREFETCH:
+          params.update_prefetch = (int)apr_strtoi64(arg, NULL, 0);
+          break;
+
+        case SVNSERVE_OPT_LOG_THREADS:
+          params.log_threads = (int)apr_strtoi64(arg, NULL, 0);
+          break;
+
+        case SVNSERVE_OPT_REPLAY_THREADS:
+          params.replay_threads = (int)apr_strtoi64(arg, NULL, 0);
+          break;
+
+        case SVNSERVE_OPT_MAX_LOG_VERBOSE:
+          sched_limits[svn_repos__sched_op_log_changed_paths]
+            = (int)apr_strtoi64(arg, NULL, 0);
+          break;
+
+        case SVNSERVE_OPT_MAX_FILE_REVS:
+          sched_limits[svn_repos__sched_op_file_revs]
+            = (int)apr_strtoi64(arg, NULL, 0);
+          break;
+
+        case SVNSERVE_OPT_MAX_DEEP_REPORTS:
+          sched_limits[svn_repos__sched_op_report]
+            = (int)apr_strtoi64(arg, NULL, 0);
+          break;
+
+        case SVNSERVE_OPT_BULK_USER:
+          SVN_ERR(svn_utf_cstring_to_utf8(&APR_ARRAY_PUSH(bulk_users,
+                                                          const char *),
+                                          arg, pool));
+          break;
+
+        case SVNSERVE_OPT_EVENT_LOOP:
+          use_event_loop = TRUE;
+          break;
+
 #ifdef WIN32
         case SVNSERVE_OPT_SERVICE:
           if (run_mode != run_mode_service)
@@ -1008,6 +1736,76 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
           SVN_ERR(svn_dirent_get_absolute(&log_filename, log_filename, pool));
           break;
 
+        case SVNSERVE_OPT_TRACE_FILE:
+          {
+            const char *trace_filename;
+
+            SVN_ERR(svn_utf_cstring_to_utf8(&trace_filename, arg, pool));
+            trace_filename = svn_dirent_internal_style(trace_filename, pool);
+            SVN_ERR(svn_dirent_get_absolute(&trace_filename, trace_filename,
+                                            pool));
+            SVN_ERR(svn_trace__enable(trace_filename, pool));
+          }
+          break;
+
+        case SVNSERVE_OPT_AUTHZ_CACHE_DIR:
+          {
+            const char *cache_dir;
+
+            SVN_ERR(svn_utf_cstring_to_utf8(&cache_dir, arg, pool));
+            cache_dir = svn_dirent_internal_style(cache_dir, pool);
+            SVN_ERR(svn_dirent_get_absolute(&cache_dir, cache_dir, pool));
+            svn_repos__authz_set_cache_dir(cache_dir, pool);
+          }
+          break;
+
+        case SVNSERVE_OPT_METRICS_FILE:
+          SVN_ERR(svn_utf_cstring_to_utf8(&metrics_filename, arg, pool));
+          metrics_filename = svn_dirent_internal_style(metrics_filename,
+                                                       pool);
+          SVN_ERR(svn_dirent_get_absolute(&metrics_filename,
+                                          metrics_filename, pool));
+          break;
+
+        case SVNSERVE_OPT_TLS_CERT:
+          SVN_ERR(svn_utf_cstring_to_utf8(&tls_cert_filename, arg, pool));
+          tls_cert_filename = svn_dirent_internal_style(tls_cert_filename,
+                                                        pool);
+          SVN_ERR(svn_dirent_get_absolute(&tls_cert_filename,
+                                          tls_cert_filename, pool));
+          break;
+
+        case SVNSERVE_OPT_TLS_KEY:
+          SVN_ERR(svn_utf_cstring_to_utf8(&tls_key_filename, arg, pool));
+          tls_key_filename = svn_dirent_internal_style(tls_key_filename,
+                                                       pool);
+          SVN_ERR(svn_dirent_get_absolute(&tls_key_filename,
+                                          tls_key_filename, pool));
+          break;
+
+        case SVNSERVE_OPT_TUNNEL_LISTEN:
+          SVN_ERR(svn_utf_cstring_to_utf8(&tunnel_listen_filename, arg,
+                                          pool));
+          tunnel_listen_filename
+            = svn_dirent_internal_style(tunnel_listen_filename, pool);
+          SVN_ERR(svn_dirent_get_absolute(&tunnel_listen_filename,
+                                          tunnel_listen_filename, pool));
+          break;
+
+        case SVNSERVE_OPT_TUNNEL_CONNECT:
+          SVN_ERR(svn_utf_cstring_to_utf8(&tunnel_connect_filename, arg,
+                                          pool));
+          tunnel_connect_filename
+            = svn_dirent_internal_style(tunnel_connect_filename, pool);
+          SVN_ERR(svn_dirent_get_absolute(&tunnel_connect_filename,
+                                          tunnel_connect_filename, pool));
+          if (run_mode != run_mode_tunnel)
+            {
+              run_mode = run_mode_tunnel;
+              mode_opt_count++;
+            }
+          break;
+
         }
     }
 
@@ -1066,6 +1864,9 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   SVN_ERR(svn_repos__config_pool_create(&params.config_pool,
                                         is_multi_threaded,
                                         pool));
+  SVN_ERR(svn_repos__repos_pool_create(&params.repos_pool,
+                                       is_multi_threaded,
+                                       svn_pool_create(pool)));
 
   /* If a configuration file is specified, load it and any referenced
    * password and authorization files. */
@@ -1092,6 +1893,55 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
                _("Option --tunnel-user is only valid in tunnel mode"));
     }
 
+  if (tls_cert_filename || tls_key_filename)
+    {
+      if (!tls_cert_filename || !tls_key_filename)
+        return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                 _("Options --tls-cert and --tls-key must be used together"));
+
+      /* Tunnels and inetd connections don't give us a socket. */
+      if (run_mode == run_mode_inetd || run_mode == run_mode_tunnel)
+        return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                 _("TLS is not available in inetd or tunnel mode"));
+
+      /* Created before we fork, so all connection handlers share the
+         session ticket keys. */
+      SVN_ERR(svn_ra_svn__tls_server_create(&params.tls, tls_cert_filename,
+                                            tls_key_filename, pool));
+      if (!port_given)
+        port = SVN_RA_SVN_TLS_PORT;
+    }
+
+  if (tunnel_listen_filename)
+    {
+      if (run_mode != run_mode_daemon && run_mode != run_mode_listen_once)
+        return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                 _("Option --tunnel-listen is only valid in daemon and "
+                   "listen-once mode"));
+
+      /* The tunnel has already been encrypted by ssh. */
+      if (params.tls)
+        return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                 _("Options --tunnel-listen and --tls-cert are mutually "
+                   "exclusive"));
+
+      params.tunnel_broker = TRUE;
+    }
+
+  if (metrics_filename)
+    {
+      if (run_mode != run_mode_daemon && run_mode != run_mode_service)
+        return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                 _("Option --metrics-file is only valid in daemon mode"));
+
+#if APR_HAS_THREADS
+      SVN_ERR(metrics__create(&params.metrics, metrics_filename, pool));
+#else
+      return svn_error_create(SVN_ERR_UNSUPPORTED_FEATURE, NULL,
+               _("Option --metrics-file requires thread support"));
+#endif
+    }
+
   if (run_mode == run_mode_inetd || run_mode == run_mode_tunnel)
     {
       apr_pool_t *connection_pool;
@@ -1112,6 +1962,29 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
        * the pool cleanup handlers that call sasl_dispose() (connection_pool)
        * and sasl_done() (pool) are run in the right order. See issue #3664. */
       connection_pool = svn_pool_create(pool);
+
+      /* Hand the connection to a warm daemon if there is one. */
+      if (tunnel_connect_filename)
+        {
+          svn_boolean_t connected;
+          const char *tunnel_user = params.tunnel_user;
+
+          if (!tunnel_user)
+            tunnel_user = svn_user_get_name(connection_pool);
+          if (!tunnel_user)
+            return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                     _("Can't determine the tunnel user; use "
+                       "--tunnel-user"));
+
+          err = tunnel_connect(&connected, tunnel_connect_filename,
+                               tunnel_user, connection_pool);
+          if (err || connected)
+            {
+              svn_pool_destroy(connection_pool);
+              return err;
+            }
+        }
+
       conn = svn_ra_svn_create_conn5(NULL, stdin_stream, stdout_stream,
                                      params.compression_level,
                                      params.zero_copy_limit,
@@ -1177,77 +2050,10 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     }
 #endif /* WIN32 */
 
-  /* Make sure we have IPV6 support first before giving apr_sockaddr_info_get
-     APR_UNSPEC, because it may give us back an IPV6 address even if we can't
-     create IPV6 sockets. */
-
-#if APR_HAVE_IPV6
-#ifdef MAX_SECS_TO_LINGER
-  /* ### old APR interface */
-  status = apr_socket_create(&sock, APR_INET6, SOCK_STREAM, pool);
-#else
-  status = apr_socket_create(&sock, APR_INET6, SOCK_STREAM, APR_PROTO_TCP,
-                             pool);
-#endif
-  if (status == 0)
-    {
-      apr_socket_close(sock);
-      family = APR_UNSPEC;
-
-      if (prefer_v6)
-        {
-          if (host == NULL)
-            host = "::";
-          sockaddr_info_flags = APR_IPV6_ADDR_OK;
-        }
-      else
-        {
-          if (host == NULL)
-            host = "0.0.0.0";
-          sockaddr_info_flags = APR_IPV4_ADDR_OK;
-        }
-    }
-#endif
-
-  status = apr_sockaddr_info_get(&sa, host, family, port,
-                                 sockaddr_info_flags, pool);
-  if (status)
-    {
-      return svn_error_wrap_apr(status, _("Can't get address info"));
-    }
-
-
-#ifdef MAX_SECS_TO_LINGER
-  /* ### old APR interface */
-  status = apr_socket_create(&sock, sa->family, SOCK_STREAM, pool);
-#else
-  status = apr_socket_create(&sock, sa->family, SOCK_STREAM, APR_PROTO_TCP,
-                             pool);
-#endif
-  if (status)
-    {
-      return svn_error_wrap_apr(status, _("Can't create server socket"));
-    }
-
-  /* Prevents "socket in use" errors when server is killed and quickly
-   * restarted. */
-  status = apr_socket_opt_set(sock, APR_SO_REUSEADDR, 1);
-  if (status)
-    {
-      return svn_error_wrap_apr(status, _("Can't set options on server socket"));
-    }
-
-  status = apr_socket_bind(sock, sa);
-  if (status)
-    {
-      return svn_error_wrap_apr(status, _("Can't bind server socket"));
-    }
-
-  status = apr_socket_listen(sock, ACCEPT_BACKLOG);
-  if (status)
-    {
-      return svn_error_wrap_apr(status, _("Can't listen on server socket"));
-    }
+  if (tunnel_listen_filename)
+    SVN_ERR(listen_on_unix_socket(&sock, tunnel_listen_filename, pool));
+  else
+    SVN_ERR(listen_on_tcp_socket(&sock, host, port, prefer_v6, pool));
 
 #if APR_HAS_FORK
   if (run_mode != run_mode_listen_once && !foreground)
@@ -1308,8 +2114,49 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
       }
 
     svn_cache_config_set(&settings);
+
+    /* All connection processes will be forked from this one.  Let them
+     * use the same cache instead of warming up one cache each. */
+    if (share_memory_cache && run_mode == run_mode_daemon
+        && handling_mode == connection_mode_fork)
+      SVN_ERR(svn_cache__share_global_membuffer_cache());
+
+    /* The keys cover everything a response depends on, so all
+     * connections may share the cached responses. */
+    if (cache_responses && svn_cache__get_global_membuffer_cache())
+      SVN_ERR(svn_cache__create_membuffer_cache(
+                  &params.response_cache,
+                  svn_cache__get_global_membuffer_cache(),
+                  NULL, NULL, APR_HASH_KEY_STRING, "svnserve:responses",
+                  SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                  !settings.single_threaded, FALSE, pool, pool));
   }
 
+  /* The prefetching, log and replay threads share the FS caches with the
+     connection threads, so they need the thread-safe variant of them. */
+  if (handling_mode != connection_mode_thread || params.update_prefetch < 0)
+    params.update_prefetch = 0;
+  if (handling_mode != connection_mode_thread || params.log_threads < 0)
+    params.log_threads = 0;
+  if (handling_mode != connection_mode_thread || params.replay_threads < 0)
+    params.replay_threads = 0;
+
+  /* Only connection threads compete for the same scheduler.  Forked
+     sub-processes would each get their own copy of it. */
+  params.scheduler = NULL;
+  if (handling_mode == connection_mode_thread)
+    {
+      int i;
+      for (i = 0; i < SVN_REPOS__SCHED_OP_COUNT; ++i)
+        if (sched_limits[i] > 0)
+          {
+            SVN_ERR(svn_repos__scheduler_create(&params.scheduler,
+                                                sched_limits, bulk_users,
+                                                pool));
+            break;
+          }
+    }
+
 #if APR_HAS_THREADS
   SVN_ERR(svn_root_pools__create(&connection_pools));
 
@@ -1336,11 +2183,31 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
 
       /* don't queue requests unless we reached the worker thread limit */
       apr_thread_pool_threshold_set(threads, 0);
+
+      /* Idle connections get added to and woken up from the poll set by
+         the worker threads while the main thread is waiting in it. */
+      if (use_event_loop && run_mode != run_mode_listen_once)
+        {
+          status = apr_pollset_create(&idle_connections, EVENT_LOOP_SIZE,
+                                      pool, APR_POLLSET_THREADSAFE);
+          if (status)
+            return svn_error_wrap_apr(status, _("Can't create poll set"));
+        }
     }
   else
     {
       threads = NULL;
     }
+
+  /* Started only now, as threads don't survive daemonizing. */
+  if (params.metrics)
+    {
+      apr_thread_t *tid;
+
+      status = apr_thread_create(&tid, NULL, metrics_thread, &params, pool);
+      if (status)
+        return svn_error_wrap_apr(status, _("Can't create metrics thread"));
+    }
 #endif
 
 #if APR_HAVE_SIGACTION
@@ -1348,6 +2215,11 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   apr_signal(SIGINT, sigtermint_handler);
 #endif
 
+#if APR_HAS_THREADS
+  if (idle_connections)
+    return svn_error_trace(run_event_loop(sock, &params, pool));
+#endif
+
   while (1)
     {
       connection_t *connection = NULL;
@@ -47,6 +47,7 @@
 
 static svn_opt_subcommand_t initialize_cmd,
                             synchronize_cmd,
+                            replicate_cmd,
                             copy_revprops_cmd,
                             info_cmd,
                             help_cmd;
@@ -71,7 +72,9 @@ enum svnsync__opt {
   svnsync_opt_trust_server_cert_failures_dst,
   svnsync_opt_allow_non_empty,
   svnsync_opt_skip_unchanged,
-  svnsync_opt_steal_lock
+  svnsync_opt_steal_lock,
+  svnsync_opt_poll_interval,
+  svnsync_opt_prefetch
 };
 
 #define SVNSYNC_OPTS_DEFAULT svnsync_opt_non_interactive, \
@@ -129,9 +132,31 @@ static const svn_opt_subcommand_desc3_t svnsync_cmd_table[] =
          "source URL.  Specifying SOURCE_URL is recommended in particular\n"
          "if untrusted users/administrators may have write access to the\n"
          "DEST_URL repository.\n"
+         "\n"), N_(
+         "With --prefetch N, the next N revisions are fetched from the\n"
+         "source in parallel while the current one is being committed.\n"
+         "Commits are still applied strictly in order.\n"
       )},
       { SVNSYNC_OPTS_DEFAULT, svnsync_opt_source_prop_encoding, 'q',
-        svnsync_opt_disable_locking, svnsync_opt_steal_lock, 'M' } },
+        svnsync_opt_disable_locking, svnsync_opt_steal_lock,
+        svnsync_opt_prefetch, 'M' } },
+    { "replicate", replicate_cmd, { 0 }, {N_(
+         "usage: svnsync replicate DEST_URL...\n"
+         "\n"), N_(
+         "Keep the destination repositories synchronized with the sources\n"
+         "with which they were initialized until interrupted.\n"
+         "\n"), N_(
+         "The sessions to all repositories and the locks on the\n"
+         "destination repositories are kept for as long as the command\n"
+         "runs.  The sources are checked for new revisions every\n"
+         "--poll-interval seconds.  All pending revisions are transferred\n"
+         "in a single replay, so mirrors that fall behind catch up in\n"
+         "batches.  This replaces running 'svnsync synchronize' from the\n"
+         "source's post-commit hook.\n"
+      )},
+      { SVNSYNC_OPTS_DEFAULT, svnsync_opt_source_prop_encoding, 'q',
+        svnsync_opt_disable_locking, svnsync_opt_steal_lock,
+        svnsync_opt_poll_interval, svnsync_opt_prefetch, 'M' } },
     { "copy-revprops", copy_revprops_cmd, { 0 }, {N_(
          "usage:\n"
          "\n"), N_(
@@ -279,6 +304,14 @@ static const apr_getopt_option_t svnsync_options[] =
                           "and is not being concurrently accessed by another\n"
                           "                             "
                           "svnsync instance.")},
+    {"poll-interval",  svnsync_opt_poll_interval, 1,
+                       N_("check for new revisions every ARG seconds\n"
+                          "                             "
+                          "(default: 1)")},
+    {"prefetch",       svnsync_opt_prefetch, 1,
+                       N_("fetch up to ARG revisions from the source in\n"
+                          "                             "
+                          "parallel while committing (default: 1)")},
     {"memory-cache-size", 'M', 1,
                        N_("size of the extra in-memory cache in MB used to\n"
                           "                             "
@@ -313,6 +346,8 @@ typedef struct opt_baton_t {
   const char *source_prop_encoding;
   svn_boolean_t disable_locking;
   svn_boolean_t steal_lock;
+  int poll_interval;
+  int prefetch;
   svn_boolean_t quiet;
   svn_boolean_t allow_non_empty;
   svn_boolean_t skip_unchanged;
@@ -426,6 +461,14 @@ typedef struct subcommand_baton_t {
   /* synchronize only */
   svn_revnum_t committed_rev;
 
+  /* Number of revisions to fetch in parallel; 0 or 1 to fetch them
+     one after another. */
+  int prefetch;
+
+  /* Session to the source repository to reuse or NULL to open a new one
+     (replicate keeps it open across synchronizations). */
+  svn_ra_session_t *from_session;
+
   /* copy-revprops only */
   svn_revnum_t start_rev;
   svn_revnum_t end_rev;
@@ -772,6 +815,7 @@ make_subcommand_baton(opt_baton_t *opt_baton,
   b->from_url = from_url;
   b->start_rev = start_rev;
   b->end_rev = end_rev;
+  b->prefetch = opt_baton->prefetch;
   return b;
 }
 
@@ -1424,6 +1468,63 @@ replay_rev_finished(svn_revnum_t revision,
   return SVN_NO_ERROR;
 }
 
+/* Copy START_REVISION through END_REVISION from FROM_SESSION using
+ * replay baton RB, fetching up to RB->SB->PREFETCH revisions in parallel.
+ * Each worker gets its own session to the source repository, opened in
+ * a separate root pool.  Use POOL for temporary allocations.
+ */
+static svn_error_t *
+replay_range_prefetched(svn_ra_session_t *from_session,
+                        svn_revnum_t start_revision,
+                        svn_revnum_t end_revision,
+                        replay_baton_t *rb,
+                        apr_pool_t *pool)
+{
+  subcommand_baton_t *baton = rb->sb;
+  apr_array_header_t *sessions;
+  apr_array_header_t *session_pools;
+  const char *from_url;
+  const char *from_uuid;
+  svn_error_t *err = SVN_NO_ERROR;
+  int count = baton->prefetch;
+  int i;
+
+  /* Don't open more sessions than there are revisions to fetch. */
+  if (count > end_revision - start_revision + 1)
+    count = (int)(end_revision - start_revision + 1);
+
+  SVN_ERR(svn_ra_get_session_url(from_session, &from_url, pool));
+  SVN_ERR(svn_ra_get_uuid2(from_session, &from_uuid, pool));
+
+  sessions = apr_array_make(pool, count, sizeof(svn_ra_session_t *));
+  session_pools = apr_array_make(pool, count, sizeof(apr_pool_t *));
+  for (i = 0; i < count && !err; ++i)
+    {
+      apr_pool_t *session_pool
+        = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+      svn_ra_session_t *session;
+
+      APR_ARRAY_PUSH(session_pools, apr_pool_t *) = session_pool;
+      err = svn_ra_open5(&session, NULL, NULL, from_url, from_uuid,
+                         &baton->source_callbacks, baton, baton->config,
+                         session_pool);
+      if (!err)
+        APR_ARRAY_PUSH(sessions, svn_ra_session_t *) = session;
+    }
+
+  if (!err)
+    err = svn_ra__replay_range_prefetched(sessions, start_revision,
+                                          end_revision, 0, TRUE,
+                                          replay_rev_started,
+                                          replay_rev_finished, rb,
+                                          check_cancel, NULL, pool);
+
+  for (i = 0; i < session_pools->nelts; ++i)
+    svn_pool_destroy(APR_ARRAY_IDX(session_pools, i, apr_pool_t *));
+
+  return svn_error_trace(err);
+}
+
 /* Synchronize the repository associated with RA session TO_SESSION,
  * using information found in BATON.
  *
@@ -1443,10 +1544,23 @@ do_synchronize(svn_ra_session_t *to_session,
   replay_baton_t *rb;
   int normalized_rev_props_count = 0;
 
-  SVN_ERR(open_source_session(&from_session, &last_merged_rev,
-                              baton->from_url, to_session,
-                              &(baton->source_callbacks), baton->config,
-                              baton, pool));
+  if (baton->from_session)
+    {
+      from_session = baton->from_session;
+      SVN_ERR(svn_ra_rev_prop(to_session, 0, SVNSYNC_PROP_LAST_MERGED_REV,
+                              &last_merged_rev, pool));
+      if (! last_merged_rev)
+        return svn_error_create
+          (APR_EINVAL, NULL,
+           _("Destination repository has not been initialized"));
+    }
+  else
+    {
+      SVN_ERR(open_source_session(&from_session, &last_merged_rev,
+                                  baton->from_url, to_session,
+                                  &(baton->source_callbacks), baton->config,
+                                  baton, pool));
+    }
 
   /* Check to see if we have revprops that still need to be copied for
      a prior revision we didn't finish copying.  But first, check for
@@ -1556,9 +1670,13 @@ do_synchronize(svn_ra_session_t *to_session,
 
   SVN_ERR(check_cancel(NULL));
 
-  SVN_ERR(svn_ra_replay_range(from_session, start_revision, end_revision,
-                              0, TRUE, replay_rev_started,
-                              replay_rev_finished, rb, pool));
+  if (baton->prefetch > 1 && end_revision > start_revision)
+    SVN_ERR(replay_range_prefetched(from_session, start_revision,
+                                    end_revision, rb, pool));
+  else
+    SVN_ERR(svn_ra_replay_range(from_session, start_revision, end_revision,
+                                0, TRUE, replay_rev_started,
+                                replay_rev_finished, rb, pool));
 
   SVN_ERR(log_properties_normalized(rb->normalized_rev_props_count
                                       + normalized_rev_props_count,
@@ -1618,6 +1736,173 @@ synchronize_cmd(apr_getopt_t *os, void *b, apr_pool_t *pool)
 }
 
 
+
+/*** `svnsync replicate' ***/
+
+/* State of one destination repository kept by `svnsync replicate'. */
+typedef struct mirror_t
+{
+  /* The synchronization parameters.  Its FROM_SESSION is NULL until
+     the session to the source repository has been opened. */
+  subcommand_baton_t *baton;
+
+  /* Session to the destination repository or NULL if it has to be
+     (re-)opened. */
+  svn_ra_session_t *to_session;
+
+  /* Our lock on the destination repository or NULL if we don't hold
+     one. */
+  const svn_string_t *lock_string;
+
+  /* The latest source revision that we know to be synchronized. */
+  svn_revnum_t synced_rev;
+
+  /* Pool for the sessions. */
+  apr_pool_t *pool;
+} mirror_t;
+
+/* Bring MIRROR up to date with its source repository, (re-)opening the
+ * RA sessions and taking the lock on the destination repository as
+ * needed.  If LOCKING is set, lock the destination repository, stealing
+ * the lock if STEAL_LOCK is set.  Use SCRATCH_POOL for temporary
+ * allocations. */
+static svn_error_t *
+replicate_mirror(mirror_t *mirror,
+                 svn_boolean_t locking,
+                 svn_boolean_t steal_lock,
+                 apr_pool_t *scratch_pool)
+{
+  subcommand_baton_t *baton = mirror->baton;
+  svn_revnum_t from_latest;
+
+  if (!mirror->to_session)
+    {
+      svn_string_t *last_merged_rev;
+
+      svn_pool_clear(mirror->pool);
+      baton->from_session = NULL;
+      SVN_ERR(open_target_session(&mirror->to_session, baton,
+                                  mirror->pool));
+      if (locking && !mirror->lock_string)
+        SVN_ERR(get_lock(&mirror->lock_string, mirror->to_session,
+                         steal_lock, mirror->pool));
+
+      SVN_ERR(open_source_session(&baton->from_session, &last_merged_rev,
+                                  baton->from_url, mirror->to_session,
+                                  &baton->source_callbacks, baton->config,
+                                  baton, mirror->pool));
+    }
+
+  /* The common case: there is nothing to do. */
+  SVN_ERR(svn_ra_get_latest_revnum(baton->from_session, &from_latest,
+                                   scratch_pool));
+  if (from_latest <= mirror->synced_rev)
+    return SVN_NO_ERROR;
+
+  /* Copy all pending revisions in one go. */
+  SVN_ERR(do_synchronize(mirror->to_session, baton, scratch_pool));
+  mirror->synced_rev = from_latest;
+
+  return SVN_NO_ERROR;
+}
+
+/* SUBCOMMAND: replicate */
+static svn_error_t *
+replicate_cmd(apr_getopt_t *os, void *b, apr_pool_t *pool)
+{
+  opt_baton_t *opt_baton = b;
+  apr_array_header_t *targets;
+  apr_array_header_t *mirrors;
+  apr_pool_t *iterpool;
+  apr_interval_time_t interval;
+  svn_error_t *err = SVN_NO_ERROR;
+  int i;
+
+  SVN_ERR(svn_opt__args_to_target_array(&targets, os,
+                                        apr_array_make(pool, 0,
+                                                       sizeof(const char *)),
+                                        pool));
+  if (targets->nelts < 1)
+    return svn_error_create(SVN_ERR_CL_INSUFFICIENT_ARGS, 0, NULL);
+
+  mirrors = apr_array_make(pool, targets->nelts, sizeof(mirror_t *));
+  for (i = 0; i < targets->nelts; ++i)
+    {
+      const char *to_url = APR_ARRAY_IDX(targets, i, const char *);
+      mirror_t *mirror;
+
+      if (! svn_path_is_url(to_url))
+        return svn_error_createf(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                 _("Path '%s' is not a URL"), to_url);
+
+      mirror = apr_pcalloc(pool, sizeof(*mirror));
+      mirror->baton = make_subcommand_baton(opt_baton, to_url, NULL, 0, 0,
+                                            pool);
+      mirror->synced_rev = SVN_INVALID_REVNUM;
+      mirror->pool = svn_pool_create(pool);
+      APR_ARRAY_PUSH(mirrors, mirror_t *) = mirror;
+    }
+
+  interval = apr_time_from_sec(opt_baton->poll_interval
+                               ? opt_baton->poll_interval
+                               : 1);
+
+  /* Keep the sessions and the locks for as long as we run.  Problems
+     with one mirror must not stop the replication to the others, so
+     just report them and try again in the next round. */
+  iterpool = svn_pool_create(pool);
+  while (!err)
+    {
+      apr_time_t next_round = apr_time_now() + interval;
+
+      for (i = 0; i < mirrors->nelts && !err; ++i)
+        {
+          mirror_t *mirror = APR_ARRAY_IDX(mirrors, i, mirror_t *);
+
+          svn_pool_clear(iterpool);
+          err = replicate_mirror(mirror, !opt_baton->disable_locking,
+                                 opt_baton->steal_lock, iterpool);
+          if (err && err->apr_err != SVN_ERR_CANCELLED)
+            {
+              svn_handle_warning2(stderr, err, "svnsync: ");
+              svn_error_clear(err);
+              err = SVN_NO_ERROR;
+              mirror->to_session = NULL;
+            }
+        }
+
+      while (!err && apr_time_now() < next_round)
+        {
+          err = check_cancel(NULL);
+          if (!err)
+            apr_sleep(apr_time_from_msec(100));
+        }
+    }
+  svn_pool_destroy(iterpool);
+
+  /* Release all locks that we still hold. */
+  for (i = 0; i < mirrors->nelts; ++i)
+    {
+      mirror_t *mirror = APR_ARRAY_IDX(mirrors, i, mirror_t *);
+      svn_ra_session_t *session = mirror->to_session;
+
+      if (!mirror->lock_string)
+        continue;
+
+      if (!session)
+        err = svn_error_compose_create(err,
+                open_target_session(&session, mirror->baton, pool));
+      if (session)
+        err = svn_error_compose_create(err,
+                svn_ra__release_operational_lock(session, SVNSYNC_PROP_LOCK,
+                                                 mirror->lock_string,
+                                                 pool));
+    }
+
+  return svn_error_trace(err);
+}
+
+
 
 /*** `svnsync copy-revprops' ***/
 
@@ -2118,6 +2403,22 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
             opt_baton.steal_lock = TRUE;
             break;
 
+          case svnsync_opt_poll_interval:
+            opt_err = svn_cstring_atoi(&opt_baton.poll_interval, opt_arg);
+            if (!opt_err && opt_baton.poll_interval < 1)
+              return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                      _("The poll interval must be at "
+                                        "least 1 second"));
+            break;
+
+          case svnsync_opt_prefetch:
+            opt_err = svn_cstring_atoi(&opt_baton.prefetch, opt_arg);
+            if (!opt_err && opt_baton.prefetch < 1)
+              return svn_error_create(SVN_ERR_CL_ARG_PARSING_ERROR, NULL,
+                                      _("The number of revisions to "
+                                        "prefetch must be at least 1"));
+            break;
+
           case svnsync_opt_version:
             opt_baton.version = TRUE;
             break;
@@ -29,6 +29,7 @@
 
 #include "private/svn_opt_private.h"
 #include "private/svn_cmdline_private.h"
+#include "private/svn_wc_private.h"
 
 #include "svn_private_config.h"
 
@@ -129,7 +130,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   const char *wc_path, *trail_url;
   const char *local_abspath;
   svn_wc_revision_status_t *res;
-  svn_boolean_t no_newline = FALSE, committed = FALSE;
+  svn_boolean_t no_newline = FALSE, committed = FALSE, fast = FALSE;
   svn_error_t *err;
   apr_getopt_t *os;
   svn_wc_context_t *wc_ctx;
@@ -139,6 +140,7 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
     {
       {"no-newline", 'n', 0, N_("do not output the trailing newline")},
       {"committed",  'c', 0, N_("last changed rather than current revisions")},
+      {"fast",       'f', 0, N_("detect modifications by size and time only")},
       {"help", 'h', 0, N_("display this help")},
       {"version", SVNVERSION_OPT_VERSION, 0,
        N_("show program version information")},
@@ -183,6 +185,9 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
         case 'c':
           committed = TRUE;
           break;
+        case 'f':
+          fast = TRUE;
+          break;
         case 'q':
           quiet = TRUE;
           break;
@@ -224,8 +229,12 @@ sub_main(int *exit_code, int argc, const char *argv[], apr_pool_t *pool)
   else
     trail_url = NULL;
 
-  err = svn_wc_revision_status2(&res, wc_ctx, local_abspath, trail_url,
-                                committed, NULL, NULL, pool, pool);
+  if (fast)
+    err = svn_wc__revision_status_fast(&res, wc_ctx, local_abspath, trail_url,
+                                       committed, NULL, NULL, pool, pool);
+  else
+    err = svn_wc_revision_status2(&res, wc_ctx, local_abspath, trail_url,
+                                  committed, NULL, NULL, pool, pool);
 
   if (err && (err->apr_err == SVN_ERR_WC_PATH_NOT_FOUND
               || err->apr_err == SVN_ERR_WC_NOT_WORKING_COPY))
@@ -0,0 +1,807 @@
+/*
+ * micro-bench.c :  micro-benchmarks for delta, diff, cache and packed
+ *                  stream code
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/*  Usage:
+
+       micro-bench [--seed N] [--size BYTES] [--time MSEC]
+                   [--filter SUBSTRING] [--save FILE] [--baseline FILE]
+
+    Every benchmark works on data generated from a fixed seed, i.e. two
+    runs with the same --seed and --size process identical input.  Each
+    benchmark is run until it took at least --time milliseconds and the
+    average time per operation as well as the throughput are reported.
+
+    --save writes the results to FILE.  --baseline reads such a file and
+    shows the relative change of every benchmark against it, so the
+    effect of a code change can be measured by saving the results of an
+    unmodified build first. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <apr_getopt.h>
+
+#include "svn_cmdline.h"
+#include "svn_pools.h"
+#include "svn_error.h"
+#include "svn_io.h"
+#include "svn_delta.h"
+#include "svn_diff.h"
+#include "svn_string.h"
+#include "svn_hash.h"
+#include "svn_dirent_uri.h"
+#include "svn_opt.h"
+
+#include "private/svn_cache.h"
+#include "private/svn_string_private.h"
+#include "private/svn_packed_data.h"
+
+
+/* Default size of the generated texts. */
+#define DEFAULT_SIZE (1024 * 1024)
+
+/* Default minimum run time per benchmark in milliseconds. */
+#define DEFAULT_TIME 500
+
+/* Number of entries used by the cache benchmarks. */
+#define CACHE_ENTRIES 4096
+
+/* Size of the values used by the cache benchmarks. */
+#define CACHE_VALUE_SIZE 256
+
+/* Number of integers in the packed stream benchmarks. */
+#define PACKED_INTS (64 * 1024)
+
+/* Deterministic pseudo-random number generator.  We don't use rand()
+   to get the same sequence on all platforms. */
+static apr_uint32_t
+next_random(apr_uint32_t *seed)
+{
+  *seed = *seed * 1103515245 + 12345;
+  return (*seed >> 16) & 0x7fff;
+}
+
+/* Return a text of about SIZE bytes consisting of lines of random words,
+   allocated in POOL.  Use SEED for the random numbers. */
+static svn_stringbuf_t *
+make_text(apr_size_t size,
+          apr_uint32_t *seed,
+          apr_pool_t *pool)
+{
+  svn_stringbuf_t *text = svn_stringbuf_create_ensure(size + 100, pool);
+
+  while (text->len < size)
+    {
+      int words = 3 + next_random(seed) % 10;
+      int i;
+
+      for (i = 0; i < words; ++i)
+        {
+          int len = 1 + next_random(seed) % 12;
+          int k;
+
+          for (k = 0; k < len; ++k)
+            svn_stringbuf_appendbyte(text,
+                                     (char)('a' + next_random(seed) % 26));
+          svn_stringbuf_appendbyte(text, i + 1 < words ? ' ' : '\n');
+        }
+    }
+
+  return text;
+}
+
+/* Return a copy of TEXT, allocated in POOL, with about one in RATE lines
+   deleted, replaced or preceded by a new line.  Use SEED for the random
+   numbers. */
+static svn_stringbuf_t *
+mutate_text(const svn_stringbuf_t *text,
+            int rate,
+            apr_uint32_t *seed,
+            apr_pool_t *pool)
+{
+  svn_stringbuf_t *result = svn_stringbuf_create_ensure(text->len, pool);
+  const char *p = text->data;
+  const char *end = text->data + text->len;
+
+  while (p < end)
+    {
+      const char *eol = memchr(p, '\n', end - p);
+      apr_size_t len = eol ? eol - p + 1 : end - p;
+
+      if (next_random(seed) % rate == 0)
+        {
+          switch (next_random(seed) % 3)
+            {
+              case 0:
+                /* Delete the line. */
+                break;
+
+              case 1:
+                /* Replace the line. */
+                svn_stringbuf_appendstr(result,
+                                        make_text(len, seed, pool));
+                break;
+
+              default:
+                /* Insert a line. */
+                svn_stringbuf_appendstr(result,
+                                        make_text(40, seed, pool));
+                svn_stringbuf_appendbytes(result, p, len);
+                break;
+            }
+        }
+      else
+        {
+          svn_stringbuf_appendbytes(result, p, len);
+        }
+
+      p += len;
+    }
+
+  return result;
+}
+
+
+/* Benchmark data shared by all benchmarks. */
+typedef struct bench_data_t
+{
+  /* Delta source and target. */
+  svn_string_t *source;
+  svn_string_t *target;
+
+  /* Third text for diff3. */
+  svn_string_t *latest;
+
+  /* Delta windows transforming SOURCE into TARGET. */
+  apr_array_header_t *windows;
+
+  /* WINDOWS in svndiff format. */
+  svn_stringbuf_t *svndiff0;
+  svn_stringbuf_t *svndiff1;
+
+  /* Cache with CACHE_ENTRIES entries, see KEYS. */
+  svn_cache__t *cache;
+  const char *keys[CACHE_ENTRIES];
+  svn_string_t *value;
+
+  /* Integers for the packed stream benchmarks and their serialization. */
+  apr_uint64_t ints[PACKED_INTS];
+  svn_stringbuf_t *packed;
+
+  /* Running counter, e.g. to select the next cache key. */
+  int counter;
+} bench_data_t;
+
+/* A benchmark: NAME and the function FUNC that performs one operation
+   on DATA, allocating temporaries in SCRATCH_POOL. */
+typedef struct bench_t
+{
+  const char *name;
+  svn_error_t *(*func)(bench_data_t *data, apr_pool_t *scratch_pool);
+
+  /* Return the number of bytes processed per call of FUNC. */
+  apr_size_t (*bytes)(bench_data_t *data);
+} bench_t;
+
+/* Implements svn_txdelta_window_handler_t, discarding all windows. */
+static svn_error_t *
+null_window_handler(svn_txdelta_window_t *window,
+                    void *baton)
+{
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_txdelta_window_handler_t, appending a copy of WINDOW to
+   the array BATON. */
+static svn_error_t *
+collect_window_handler(svn_txdelta_window_t *window,
+                       void *baton)
+{
+  apr_array_header_t *windows = baton;
+
+  if (window)
+    APR_ARRAY_PUSH(windows, svn_txdelta_window_t *)
+      = svn_txdelta_window_dup(window, windows->pool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Send all windows in DATA to HANDLER with BATON, followed by the final
+   NULL window. */
+static svn_error_t *
+send_windows(bench_data_t *data,
+             svn_txdelta_window_handler_t handler,
+             void *baton)
+{
+  int i;
+
+  for (i = 0; i < data->windows->nelts; ++i)
+    SVN_ERR(handler(APR_ARRAY_IDX(data->windows, i, svn_txdelta_window_t *),
+                    baton));
+
+  return svn_error_trace(handler(NULL, baton));
+}
+
+/* Set *SVNDIFF to the windows in DATA in svndiff VERSION format,
+   allocated in POOL. */
+static svn_error_t *
+encode_windows(svn_stringbuf_t **svndiff,
+               bench_data_t *data,
+               int version,
+               apr_pool_t *pool)
+{
+  svn_txdelta_window_handler_t handler;
+  void *baton;
+
+  *svndiff = svn_stringbuf_create_empty(pool);
+  svn_txdelta_to_svndiff3(&handler, &baton,
+                          svn_stream_from_stringbuf(*svndiff, pool),
+                          version, SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                          pool);
+
+  return svn_error_trace(send_windows(data, handler, baton));
+}
+
+/* Return the size of the delta target in DATA. */
+static apr_size_t
+target_size(bench_data_t *data)
+{
+  return data->target->len;
+}
+
+/* Return the combined size of the diff inputs in DATA. */
+static apr_size_t
+diff_size(bench_data_t *data)
+{
+  return data->source->len + data->target->len;
+}
+
+/* Return the combined size of the diff3 inputs in DATA. */
+static apr_size_t
+diff3_size(bench_data_t *data)
+{
+  return data->source->len + data->target->len + data->latest->len;
+}
+
+/* Return the size of a cache value. */
+static apr_size_t
+cache_value_size(bench_data_t *data)
+{
+  return data->value->len;
+}
+
+/* Return the size of the unpacked integers in DATA. */
+static apr_size_t
+packed_size(bench_data_t *data)
+{
+  return sizeof(data->ints);
+}
+
+/* Deltify the target against the source in DATA. */
+static svn_error_t *
+bench_deltify(bench_data_t *data,
+              apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(
+           svn_txdelta_run(svn_stream_from_string(data->source, scratch_pool),
+                           svn_stream_from_string(data->target, scratch_pool),
+                           null_window_handler, NULL,
+                           svn_checksum_md5, NULL, NULL, NULL,
+                           scratch_pool, scratch_pool));
+}
+
+/* Apply the delta windows in DATA to the source. */
+static svn_error_t *
+bench_apply(bench_data_t *data,
+            apr_pool_t *scratch_pool)
+{
+  svn_txdelta_window_handler_t handler;
+  void *baton;
+
+  svn_txdelta_apply(svn_stream_from_string(data->source, scratch_pool),
+                    svn_stream_empty(scratch_pool), NULL, NULL,
+                    scratch_pool, &handler, &baton);
+
+  return svn_error_trace(send_windows(data, handler, baton));
+}
+
+/* Encode the delta windows in DATA as svndiff version 0. */
+static svn_error_t *
+bench_svndiff0_encode(bench_data_t *data,
+                      apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *svndiff;
+  return svn_error_trace(encode_windows(&svndiff, data, 0, scratch_pool));
+}
+
+/* Encode the delta windows in DATA as svndiff version 1. */
+static svn_error_t *
+bench_svndiff1_encode(bench_data_t *data,
+                      apr_pool_t *scratch_pool)
+{
+  svn_stringbuf_t *svndiff;
+  return svn_error_trace(encode_windows(&svndiff, data, 1, scratch_pool));
+}
+
+/* Parse SVNDIFF into delta windows. */
+static svn_error_t *
+decode_svndiff(svn_stringbuf_t *svndiff,
+               apr_pool_t *scratch_pool)
+{
+  svn_stream_t *stream = svn_txdelta_parse_svndiff(null_window_handler,
+                                                   NULL, TRUE,
+                                                   scratch_pool);
+  apr_size_t len = svndiff->len;
+
+  SVN_ERR(svn_stream_write(stream, svndiff->data, &len));
+  return svn_error_trace(svn_stream_close(stream));
+}
+
+/* Decode the svndiff version 0 data in DATA. */
+static svn_error_t *
+bench_svndiff0_decode(bench_data_t *data,
+                      apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(decode_svndiff(data->svndiff0, scratch_pool));
+}
+
+/* Decode the svndiff version 1 data in DATA. */
+static svn_error_t *
+bench_svndiff1_decode(bench_data_t *data,
+                      apr_pool_t *scratch_pool)
+{
+  return svn_error_trace(decode_svndiff(data->svndiff1, scratch_pool));
+}
+
+/* Diff the source and target texts in DATA. */
+static svn_error_t *
+bench_diff(bench_data_t *data,
+           apr_pool_t *scratch_pool)
+{
+  svn_diff_t *diff;
+
+  return svn_error_trace(
+           svn_diff_mem_string_diff(&diff, data->source, data->target,
+                                    svn_diff_file_options_create(
+                                      scratch_pool),
+                                    scratch_pool));
+}
+
+/* Merge the changes between source and target texts in DATA into the
+   latest text. */
+static svn_error_t *
+bench_diff3(bench_data_t *data,
+            apr_pool_t *scratch_pool)
+{
+  svn_diff_t *diff;
+
+  return svn_error_trace(
+           svn_diff_mem_string_diff3(&diff, data->source, data->target,
+                                     data->latest,
+                                     svn_diff_file_options_create(
+                                       scratch_pool),
+                                     scratch_pool));
+}
+
+/* Store the next value in the cache of DATA. */
+static svn_error_t *
+bench_cache_set(bench_data_t *data,
+                apr_pool_t *scratch_pool)
+{
+  const char *key = data->keys[data->counter++ % CACHE_ENTRIES];
+  return svn_error_trace(svn_cache__set(data->cache, key, data->value,
+                                        scratch_pool));
+}
+
+/* Read the next value from the cache of DATA. */
+static svn_error_t *
+bench_cache_get(bench_data_t *data,
+                apr_pool_t *scratch_pool)
+{
+  const char *key = data->keys[data->counter++ % CACHE_ENTRIES];
+  void *value;
+  svn_boolean_t found;
+
+  return svn_error_trace(svn_cache__get(&value, &found, data->cache, key,
+                                        scratch_pool));
+}
+
+/* Serialize the integers in DATA into a packed stream. */
+static svn_error_t *
+bench_packed_encode(bench_data_t *data,
+                    apr_pool_t *scratch_pool)
+{
+  svn_packed__data_root_t *root = svn_packed__data_create_root(scratch_pool);
+  svn_packed__int_stream_t *stream
+    = svn_packed__create_int_stream(root, TRUE, FALSE);
+  svn_stringbuf_t *packed = svn_stringbuf_create_empty(scratch_pool);
+  int i;
+
+  for (i = 0; i < PACKED_INTS; ++i)
+    svn_packed__add_uint(stream, data->ints[i]);
+
+  return svn_error_trace(
+           svn_packed__data_write(svn_stream_from_stringbuf(packed,
+                                                            scratch_pool),
+                                  root, scratch_pool));
+}
+
+/* Read the integers back from the packed stream in DATA. */
+static svn_error_t *
+bench_packed_decode(bench_data_t *data,
+                    apr_pool_t *scratch_pool)
+{
+  svn_packed__data_root_t *root;
+  svn_packed__int_stream_t *stream;
+  apr_uint64_t sum = 0;
+
+  SVN_ERR(svn_packed__data_read(&root,
+                                svn_stream_from_stringbuf(data->packed,
+                                                          scratch_pool),
+                                scratch_pool, scratch_pool));
+
+  stream = svn_packed__first_int_stream(root);
+  while (svn_packed__int_count(stream))
+    sum += svn_packed__get_uint(stream);
+
+  if (sum == 0)
+    return svn_error_create(SVN_ERR_CORRUPT_PACKED_DATA, NULL,
+                            "Unexpected packed stream contents");
+
+  return SVN_NO_ERROR;
+}
+
+/* All benchmarks in the order in which they are run. */
+static const bench_t benchmarks[] =
+{
+  { "deltify",          bench_deltify,          target_size },
+  { "apply",            bench_apply,            target_size },
+  { "svndiff0-encode",  bench_svndiff0_encode,  target_size },
+  { "svndiff0-decode",  bench_svndiff0_decode,  target_size },
+  { "svndiff1-encode",  bench_svndiff1_encode,  target_size },
+  { "svndiff1-decode",  bench_svndiff1_decode,  target_size },
+  { "diff",             bench_diff,             diff_size },
+  { "diff3",            bench_diff3,            diff3_size },
+  { "cache-set",        bench_cache_set,        cache_value_size },
+  { "cache-get",        bench_cache_get,        cache_value_size },
+  { "packed-encode",    bench_packed_encode,    packed_size },
+  { "packed-decode",    bench_packed_decode,    packed_size },
+  { NULL }
+};
+
+
+/* Implements svn_cache__serialize_func_t for svn_string_t. */
+static svn_error_t *
+serialize_string(void **data,
+                 apr_size_t *data_len,
+                 void *in,
+                 apr_pool_t *pool)
+{
+  svn_string_t *value = in;
+
+  *data = (void *)value->data;
+  *data_len = value->len;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__deserialize_func_t for svn_string_t. */
+static svn_error_t *
+deserialize_string(void **out,
+                   void *data,
+                   apr_size_t data_len,
+                   apr_pool_t *pool)
+{
+  *out = svn_string_ncreate(data, data_len, pool);
+  return SVN_NO_ERROR;
+}
+
+/* Set *DATA_P to the benchmark input generated from SEED with texts of
+   about SIZE bytes, allocated in POOL. */
+static svn_error_t *
+create_data(bench_data_t **data_p,
+            apr_uint32_t seed,
+            apr_size_t size,
+            apr_pool_t *pool)
+{
+  bench_data_t *data = apr_pcalloc(pool, sizeof(*data));
+  svn_stringbuf_t *source = make_text(size, &seed, pool);
+  svn_membuffer_t *membuffer;
+  svn_packed__data_root_t *root;
+  svn_packed__int_stream_t *stream;
+  apr_uint64_t value = 0;
+  int i;
+
+  data->source = svn_stringbuf__morph_into_string(source);
+  data->target = svn_stringbuf__morph_into_string(
+                   mutate_text(source, 50, &seed, pool));
+  data->latest = svn_stringbuf__morph_into_string(
+                   mutate_text(source, 50, &seed, pool));
+
+  data->windows = apr_array_make(pool, 16, sizeof(svn_txdelta_window_t *));
+  SVN_ERR(svn_txdelta_run(svn_stream_from_string(data->source, pool),
+                          svn_stream_from_string(data->target, pool),
+                          collect_window_handler, data->windows,
+                          svn_checksum_md5, NULL, NULL, NULL, pool, pool));
+  SVN_ERR(encode_windows(&data->svndiff0, data, 0, pool));
+  SVN_ERR(encode_windows(&data->svndiff1, data, 1, pool));
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 64 * 1024 * 1024,
+                                            0, 0, FALSE, TRUE, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&data->cache, membuffer,
+                                            serialize_string,
+                                            deserialize_string,
+                                            APR_HASH_KEY_STRING, "bench",
+                                      SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+  data->value = svn_stringbuf__morph_into_string(
+                  make_text(CACHE_VALUE_SIZE, &seed, pool));
+  data->value->len = CACHE_VALUE_SIZE;
+  for (i = 0; i < CACHE_ENTRIES; ++i)
+    {
+      data->keys[i] = apr_psprintf(pool, "/trunk/path/%08x/%d",
+                                   next_random(&seed), i);
+      SVN_ERR(svn_cache__set(data->cache, data->keys[i], data->value, pool));
+    }
+
+  /* Mostly small deltas with an occasional large value, as typical for
+     revision numbers and offsets. */
+  for (i = 0; i < PACKED_INTS; ++i)
+    {
+      value += next_random(&seed) % 64;
+      if (next_random(&seed) % 100 == 0)
+        value += (apr_uint64_t)next_random(&seed) << 20;
+      data->ints[i] = value;
+    }
+
+  root = svn_packed__data_create_root(pool);
+  stream = svn_packed__create_int_stream(root, TRUE, FALSE);
+  for (i = 0; i < PACKED_INTS; ++i)
+    svn_packed__add_uint(stream, data->ints[i]);
+
+  data->packed = svn_stringbuf_create_empty(pool);
+  SVN_ERR(svn_packed__data_write(svn_stream_from_stringbuf(data->packed,
+                                                           pool),
+                                 root, pool));
+
+  *data_p = data;
+  return SVN_NO_ERROR;
+}
+
+/* Run BENCH on DATA for at least MIN_TIME microseconds and return the
+   average time per operation in nanoseconds in *NS_PER_OP.  Use POOL for
+   temporary allocations. */
+static svn_error_t *
+run_bench(double *ns_per_op,
+          const bench_t *bench,
+          bench_data_t *data,
+          apr_interval_time_t min_time,
+          apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  apr_int64_t iterations = 1;
+  apr_interval_time_t elapsed;
+
+  /* Warm up caches and lazy initializations. */
+  SVN_ERR(bench->func(data, iterpool));
+
+  while (TRUE)
+    {
+      apr_time_t start = apr_time_now();
+      apr_int64_t i;
+
+      for (i = 0; i < iterations; ++i)
+        {
+          svn_pool_clear(iterpool);
+          SVN_ERR(bench->func(data, iterpool));
+        }
+
+      elapsed = apr_time_now() - start;
+      if (elapsed >= min_time)
+        break;
+
+      /* Aim for the MIN_TIME with some safety margin. */
+      if (elapsed < min_time / 16)
+        iterations *= 16;
+      else
+        iterations = iterations * min_time * 5 / (elapsed * 4) + 1;
+    }
+
+  *ns_per_op = (double)elapsed * 1000.0 / (double)iterations;
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Read the results previously written with --save from PATH and return
+   them as a mapping of benchmark names to double * in *BASELINE,
+   allocated in POOL. */
+static svn_error_t *
+read_baseline(apr_hash_t **baseline,
+              const char *path,
+              apr_pool_t *pool)
+{
+  svn_stringbuf_t *contents;
+  apr_array_header_t *lines;
+  int i;
+
+  SVN_ERR(svn_stringbuf_from_file2(&contents, path, pool));
+  lines = svn_cstring_split(contents->data, "\n", TRUE, pool);
+
+  *baseline = apr_hash_make(pool);
+  for (i = 0; i < lines->nelts; ++i)
+    {
+      const char *line = APR_ARRAY_IDX(lines, i, const char *);
+      apr_array_header_t *fields = svn_cstring_split(line, " \t", TRUE,
+                                                     pool);
+      double *value;
+
+      if (fields->nelts != 2)
+        return svn_error_createf(SVN_ERR_MALFORMED_FILE, NULL,
+                                 "Malformed line %d in '%s'",
+                                 i + 1, svn_dirent_local_style(path, pool));
+
+      value = apr_palloc(pool, sizeof(*value));
+      *value = atof(APR_ARRAY_IDX(fields, 1, const char *));
+      svn_hash_sets(*baseline, APR_ARRAY_IDX(fields, 0, const char *),
+                    value);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+/* Run all benchmarks whose name contains FILTER on input generated from
+   SEED with texts of about SIZE bytes, for at least MIN_TIME each.  If
+   BASELINE_PATH is not NULL, compare the results with that file.  If
+   SAVE_PATH is not NULL, write the results to that file.  Use POOL for
+   all allocations. */
+static svn_error_t *
+run_all(apr_uint32_t seed,
+        apr_size_t size,
+        apr_interval_time_t min_time,
+        const char *filter,
+        const char *baseline_path,
+        const char *save_path,
+        apr_pool_t *pool)
+{
+  bench_data_t *data;
+  apr_hash_t *baseline = NULL;
+  svn_stringbuf_t *results = svn_stringbuf_create_empty(pool);
+  const bench_t *bench;
+
+  if (baseline_path)
+    SVN_ERR(read_baseline(&baseline, baseline_path, pool));
+
+  SVN_ERR(create_data(&data, seed, size, pool));
+
+  printf("%-18s %14s %10s %10s\n", "benchmark", "ns/op", "MB/s",
+         baseline ? "change" : "");
+
+  for (bench = benchmarks; bench->name; ++bench)
+    {
+      double ns_per_op;
+      apr_size_t bytes = bench->bytes(data);
+      double *old_value;
+
+      if (filter && !strstr(bench->name, filter))
+        continue;
+
+      SVN_ERR(run_bench(&ns_per_op, bench, data, min_time, pool));
+
+      printf("%-18s %14.1f %10.1f", bench->name, ns_per_op,
+             (double)bytes * 1000.0 / ns_per_op);
+
+      old_value = baseline ? svn_hash_gets(baseline, bench->name) : NULL;
+      if (old_value && *old_value > 0)
+        printf(" %+9.1f%%", (ns_per_op - *old_value) * 100.0 / *old_value);
+
+      printf("\n");
+      fflush(stdout);
+
+      svn_stringbuf_appendcstr(results,
+                               apr_psprintf(pool, "%s %.1f\n",
+                                            bench->name, ns_per_op));
+    }
+
+  if (save_path)
+    SVN_ERR(svn_io_write_atomic2(save_path, results->data, results->len,
+                                 NULL, FALSE, pool));
+
+  return SVN_NO_ERROR;
+}
+
+int main(int argc, const char *argv[])
+{
+  enum { opt_seed = SVN_OPT_FIRST_LONGOPT_ID, opt_size, opt_time,
+         opt_filter, opt_save, opt_baseline };
+  static const apr_getopt_option_t options[] =
+  {
+    { "seed",     opt_seed,     1, "seed of the data generators" },
+    { "size",     opt_size,     1, "size of the generated texts" },
+    { "time",     opt_time,     1, "minimum run time per benchmark [ms]" },
+    { "filter",   opt_filter,   1, "run only matching benchmarks" },
+    { "save",     opt_save,     1, "write results to file" },
+    { "baseline", opt_baseline, 1, "compare results to file" },
+    { NULL }
+  };
+  apr_pool_t *pool;
+  apr_getopt_t *os;
+  apr_status_t status;
+  int opt_id;
+  const char *opt_arg;
+  apr_uint32_t seed = 1;
+  apr_size_t size = DEFAULT_SIZE;
+  apr_interval_time_t min_time = DEFAULT_TIME * 1000;
+  const char *filter = NULL;
+  const char *save_path = NULL;
+  const char *baseline_path = NULL;
+  svn_error_t *err;
+
+  if (svn_cmdline_init("micro-bench", stderr) != EXIT_SUCCESS)
+    return EXIT_FAILURE;
+  pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+  apr_getopt_init(&os, pool, argc, argv);
+  while ((status = apr_getopt_long(os, options, &opt_id, &opt_arg))
+         != APR_EOF)
+    {
+      if (status != APR_SUCCESS)
+        return EXIT_FAILURE;
+
+      switch (opt_id)
+        {
+          case opt_seed:
+            seed = (apr_uint32_t)strtoul(opt_arg, NULL, 10);
+            break;
+          case opt_size:
+            size = (apr_size_t)strtoul(opt_arg, NULL, 10);
+            break;
+          case opt_time:
+            min_time = (apr_interval_time_t)strtoul(opt_arg, NULL, 10) * 1000;
+            break;
+          case opt_filter:
+            filter = opt_arg;
+            break;
+          case opt_save:
+            save_path = opt_arg;
+            break;
+          case opt_baseline:
+            baseline_path = opt_arg;
+            break;
+        }
+    }
+
+  err = run_all(seed, size, min_time, filter, baseline_path, save_path,
+                pool);
+  if (err)
+    {
+      svn_handle_error2(err, stderr, FALSE, "micro-bench: ");
+      svn_error_clear(err);
+      return EXIT_FAILURE;
+    }
+
+  svn_pool_destroy(pool);
+  return EXIT_SUCCESS;
+}
@@ -198,6 +198,12 @@ def cache_control_header(sbox):
                                            r.getheader('Cache-Control'))
   r.read()
 
+  # Immutable responses may only be stored by shared caches if they
+  # were served without authentication.
+  immutable_cache_control = svntest.verify.RegexOutput(
+                              '^(public|private), max-age=31536000, '
+                              'immutable$')
+
   # GET /repos/iota?p=1
   # Response for a pegged file is immutable; expect to see Cache-Control
   # with non-zero max-age.
@@ -206,7 +212,7 @@ def cache_control_header(sbox):
   if r.status != httplib.OK:
     raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
   svntest.verify.compare_and_display_lines(None, 'Cache-Control',
-                                           'max-age=604800',
+                                           immutable_cache_control,
                                            r.getheader('Cache-Control'))
   r.read()
 
@@ -218,7 +224,7 @@ def cache_control_header(sbox):
   if r.status != httplib.OK:
     raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
   svntest.verify.compare_and_display_lines(None, 'Cache-Control',
-                                           'max-age=604800',
+                                           immutable_cache_control,
                                            r.getheader('Cache-Control'))
   r.read()
 
@@ -230,11 +236,60 @@ def cache_control_header(sbox):
   if r.status != httplib.OK:
     raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
   svntest.verify.compare_and_display_lines(None, 'Cache-Control',
-                                           'max-age=604800',
+                                           immutable_cache_control,
                                            r.getheader('Cache-Control'))
   r.read()
 
 
+@SkipUnless(svntest.main.is_ra_type_dav)
+def conditional_get_immutable(sbox):
+  "conditional GET of immutable resources"
+
+  sbox.build(create_wc=False, read_only=True)
+
+  headers = {
+    'Authorization': 'Basic ' + base64.b64encode(b'jconstant:rayjandom').decode(),
+  }
+
+  h = svntest.main.create_http_connection(sbox.repo_url)
+
+  # The same file contents get the same strong ETag, no matter whether
+  # they are addressed by revision or by peg revision.
+  h.request('GET', sbox.repo_url + '/!svn/rvr/1/iota', None, headers)
+  r = h.getresponse()
+  if r.status != httplib.OK:
+    raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
+  etag = r.getheader('ETag')
+  r.read()
+  if not etag or etag.startswith('W/'):
+    raise svntest.Failure('Unexpected ETag: %s' % etag)
+
+  h.request('GET', sbox.repo_url + '/iota?p=1', None, headers)
+  r = h.getresponse()
+  if r.status != httplib.OK:
+    raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
+  svntest.verify.compare_and_display_lines(None, 'ETag', etag,
+                                           r.getheader('ETag'))
+  r.read()
+
+  # Revalidating with that ETag must not send the contents again.
+  headers['If-None-Match'] = etag
+  h.request('GET', sbox.repo_url + '/!svn/rvr/1/iota', None, headers)
+  r = h.getresponse()
+  if r.status != httplib.NOT_MODIFIED:
+    raise svntest.Failure('Unexpected status: %d %s' % (r.status, r.reason))
+  if r.read():
+    raise svntest.Failure('Unexpected body in 304 response')
+
+  # A different ETag gets the full response.
+  headers['If-None-Match'] = '"0123"'
+  h.request('GET', sbox.repo_url + '/!svn/rvr/1/iota', None, headers)
+  r = h.getresponse()
+  if r.status != httplib.OK:
+    raise svntest.Failure('Request failed: %d %s' % (r.status, r.reason))
+  r.read()
+
+
 @SkipUnless(svntest.main.is_ra_type_dav)
 def simple_propfind(sbox):
   "verify simple PROPFIND responses"
@@ -700,6 +755,7 @@ test_list = [ None,
               propfind_allprop,
               propfind_propname,
               last_modified_header,
+              conditional_get_immutable,
              ]
 serial_only = True
 
@@ -4061,6 +4061,192 @@ def build_repcache(sbox):
   if new_rep_cache != rep_cache:
     raise svntest.Failure
 
+@SkipUnless(svntest.main.is_fs_type_fsfs)
+@SkipUnless(svntest.main.fs_has_rep_sharing)
+@SkipUnless(svntest.main.python_sqlite_can_read_without_rowid)
+def build_repcache_incremental(sbox):
+  "svnadmin build-repcache --incremental --jobs"
+
+  sbox.build()
+  for i in range(2, 7):
+    sbox.simple_append('iota', "Line %d.\n" % i)
+    sbox.simple_commit(message='r%d' % i)
+
+  # Remember and remove the existing rep-cache.
+  rep_cache = read_rep_cache(sbox.repo_dir)
+  rep_cache_path = os.path.join(sbox.repo_dir, 'db', 'rep-cache.db')
+  os.remove(rep_cache_path)
+
+  # Rebuild the first revisions only ...
+  expected_output = ["* Processed revision %d.\n" % i for i in range(1, 4)]
+  svntest.actions.run_and_verify_svnadmin(expected_output, [],
+                                          "build-repcache", "-r1:3",
+                                          sbox.repo_dir)
+
+  # ... and continue from there, in parallel.
+  expected_output = ["* Processed revision %d.\n" % i for i in range(4, 7)]
+  svntest.actions.run_and_verify_svnadmin(expected_output, [],
+                                          "build-repcache", "--incremental",
+                                          "--jobs", "3", sbox.repo_dir)
+
+  new_rep_cache = read_rep_cache(sbox.repo_dir)
+  if new_rep_cache != rep_cache:
+    raise svntest.Failure
+
+  # Nothing left to do.
+  svntest.actions.run_and_verify_svnadmin([], [],
+                                          "build-repcache", "--incremental",
+                                          sbox.repo_dir)
+
+
+def verify_parallel(sbox):
+  "svnadmin verify --jobs"
+
+  sbox.build()
+  for i in range(2, 9):
+    sbox.simple_append('iota', "Line %d.\n" % i)
+    sbox.simple_commit(message='r%d' % i)
+
+  exit_code, output, errput = svntest.main.run_svnadmin("verify",
+                                                        "--jobs", "4",
+                                                        sbox.repo_dir)
+  if errput:
+    raise SVNUnexpectedStderr(errput)
+
+  # Results must be reported in revision order, regardless of the order
+  # in which the worker threads finished their work.
+  expected_output = ["* Verified revision %d.\n" % i for i in range(0, 9)]
+  svntest.verify.compare_and_display_lines(
+    "Unexpected output of 'svnadmin verify --jobs'.",
+    'STDOUT', expected_output,
+    [line for line in output if line.startswith("* Verified revision")])
+
+  # Invalid arguments must be rejected.
+  svntest.actions.run_and_verify_svnadmin(None, ".*--jobs must be positive",
+                                          "verify", "--jobs", "0",
+                                          sbox.repo_dir)
+
+def load_parallel(sbox):
+  "svnadmin load --jobs"
+
+  sbox.build()
+  for i in range(2, 9):
+    sbox.simple_append('iota', "Line %d.\n" % i)
+    sbox.simple_propset('prop', 'value %d' % i, 'A/mu')
+    if i % 3 == 0:
+      sbox.simple_copy('A/B', 'A/B%d' % i)
+    sbox.simple_commit(message='r%d' % i)
+
+  # Use a deltified dump to exercise the svndiff parsing as well.
+  _, dump, _ = svntest.actions.run_and_verify_svnadmin(None, [],
+                                                       'dump', '-q',
+                                                       '--deltas',
+                                                       sbox.repo_dir)
+  sbox2 = sbox.clone_dependent()
+  sbox2.build(create_wc=False, empty=True)
+  load_and_verify_dumpstream(sbox2, None, [], None, False, dump,
+                             '--jobs', '4')
+
+  # The result must be the same as for a single-threaded load.
+  expected_dump = svntest.actions.run_and_verify_dump(sbox.repo_dir)
+  actual_dump = svntest.actions.run_and_verify_dump(sbox2.repo_dir)
+  svntest.verify.compare_dump_files(None, None, expected_dump, actual_dump)
+
+
+@SkipUnless(svntest.main.is_fs_type_fsfs)
+def verify_checkpoint(sbox):
+  "svnadmin verify --checkpoint and --resume"
+
+  sbox.build()
+  sbox.simple_append('iota', "Line.\n")
+  sbox.simple_commit(message='r2')
+
+  def verified_revisions():
+    exit_code, output, errput = svntest.main.run_svnadmin("verify",
+                                                          "--checkpoint",
+                                                          sbox.repo_dir)
+    if errput:
+      raise SVNUnexpectedStderr(errput)
+    return [line for line in output if line.startswith("* Verified revision")]
+
+  # The first run verifies everything, the second one nothing.
+  svntest.verify.compare_and_display_lines(
+    "Unexpected output of first 'svnadmin verify --checkpoint'.",
+    'STDOUT', ["* Verified revision %d.\n" % i for i in range(0, 3)],
+    verified_revisions())
+  svntest.verify.compare_and_display_lines(
+    "Unexpected output of second 'svnadmin verify --checkpoint'.",
+    'STDOUT', [], verified_revisions())
+
+  # Only new revisions need verification.
+  sbox.simple_append('iota', "Another line.\n")
+  sbox.simple_commit(message='r3')
+  svntest.verify.compare_and_display_lines(
+    "Unexpected output of third 'svnadmin verify --checkpoint'.",
+    'STDOUT', ["* Verified revision 3.\n"], verified_revisions())
+
+  # There is nothing to resume ...
+  svntest.actions.run_and_verify_svnadmin(None, ".*no interrupted verification",
+                                          "verify", "--resume",
+                                          sbox.repo_dir)
+
+  # ... unless a run got interrupted.
+  checkpoint_path = os.path.join(sbox.repo_dir, 'db', 'verify-checkpoint')
+  lines = open(checkpoint_path).readlines()
+  lines.insert(1, "run 0 3\n")
+  open(checkpoint_path, 'w').writelines(lines)
+
+  svntest.actions.run_and_verify_svnadmin(None, [],
+                                          "verify", "-q", "--resume",
+                                          sbox.repo_dir)
+  if "run 0 3\n" in open(checkpoint_path).readlines():
+    raise svntest.Failure("Completed run still recorded in checkpoint")
+
+
+@SkipUnless(svntest.main.fs_has_pack)
+def hotcopy_parallel(sbox):
+  "svnadmin hotcopy --jobs"
+
+  # Use small shards to get many of them, packed and unpacked.
+  sbox.build(create_wc=False)
+  patch_format(sbox.repo_dir, shard_size=2)
+  for i in range(2, 10):
+    svntest.actions.run_and_verify_svnmucc(None, [],
+                                           '-U', sbox.repo_url,
+                                           '-m', 'r%d' % i,
+                                           'mkdir', 'dir-%d' % i)
+  svntest.actions.run_and_verify_svnadmin(None, [], "pack", "-q",
+                                          sbox.repo_dir)
+  for i in range(10, 13):
+    svntest.actions.run_and_verify_svnmucc(None, [],
+                                           '-U', sbox.repo_url,
+                                           '-m', 'r%d' % i,
+                                           'mkdir', 'dir-%d' % i)
+
+  if svntest.main.is_fs_type_fsfs():
+    check_hotcopy = check_hotcopy_fsfs
+  else:
+    check_hotcopy = check_hotcopy_fsx
+
+  backup_dir, backup_url = sbox.add_repo_path('backup')
+  svntest.actions.run_and_verify_svnadmin(None, [], "hotcopy", "--jobs", "4",
+                                          sbox.repo_dir, backup_dir)
+  check_hotcopy(sbox.repo_dir, backup_dir)
+
+  # Let the incremental hotcopy pick up new packs and revisions.
+  if svntest.main.is_fs_type_fsfs():
+    for i in range(13, 16):
+      svntest.actions.run_and_verify_svnmucc(None, [],
+                                             '-U', sbox.repo_url,
+                                             '-m', 'r%d' % i,
+                                             'mkdir', 'dir-%d' % i)
+    svntest.actions.run_and_verify_svnadmin(None, [], "pack", "-q",
+                                            sbox.repo_dir)
+    svntest.actions.run_and_verify_svnadmin(None, [], "hotcopy",
+                                            "--incremental", "--jobs", "4",
+                                            sbox.repo_dir, backup_dir)
+    check_hotcopy(sbox.repo_dir, backup_dir)
+
 
 ########################################################################
 # Run the tests
@@ -4142,6 +4328,11 @@ test_list = [ None,
               dump_include_copied_directory,
               load_normalize_node_props,
               build_repcache,
+              build_repcache_incremental,
+              verify_parallel,
+              load_parallel,
+              verify_checkpoint,
+              hotcopy_parallel,
              ]
 
 if __name__ == '__main__':
@@ -25,7 +25,7 @@
 ######################################################################
 
 # General modules
-import re, os, logging
+import re, os, logging, json
 
 logger = logging.getLogger()
 
@@ -718,6 +718,52 @@ def property_delete(sbox):
   svntest.actions.run_and_verify_svnlook(["_U  A/mu\n"], [],
                                          'changed', repo_dir)
 
+def json_range(sbox):
+  "svnlook json over a revision range"
+
+  sbox.build()
+  repo_dir = sbox.repo_dir
+
+  sbox.simple_append('A/mu', 'appended\n')
+  sbox.simple_propset('foo', 'bar', 'iota')
+  sbox.simple_copy('A/B', 'A/B2')
+  sbox.simple_commit(message='second')
+
+  output = run_svnlook('json', '-r', '1:2', '-v', '--with-diff', repo_dir)
+  if len(output) != 2:
+    raise svntest.Failure("Expected one line per revision, got %d"
+                          % len(output))
+  entries = [json.loads(line) for line in output]
+  expect('revisions', [1, 2], [e['revision'] for e in entries])
+  expect('log', 'second', entries[1]['log'])
+  expect('author', svntest.main.wc_author, entries[1]['author'])
+
+  changes = dict((c['path'], c) for c in entries[1]['changes'])
+  expect('paths', ['/A/B2', '/A/mu', '/iota'], sorted(changes.keys()))
+  expect('mu action', 'M', changes['/A/mu']['action'])
+  expect('mu text_mod', True, changes['/A/mu']['text_mod'])
+  expect('mu size', len(open(sbox.ospath('A/mu'), 'rb').read()),
+         changes['/A/mu']['size'])
+  expect('iota props', {'foo': 'bar'}, changes['/iota']['props'])
+  expect('copy source', ['/A/B', 1],
+         [changes['/A/B2']['copyfrom_path'],
+          changes['/A/B2']['copyfrom_rev']])
+  expect('kind', 'dir', changes['/A/B2']['kind'])
+  if 'appended' not in entries[1]['diff']:
+    raise svntest.Failure("Diff of r2 not included")
+
+  # A descending range and a single revision, without the extras.
+  output = run_svnlook('json', '-r', '2:1', repo_dir)
+  expect('descending', [2, 1], [json.loads(l)['revision'] for l in output])
+  entry = json.loads(run_svnlook('json', repo_dir)[0])
+  expect('youngest', 2, entry['revision'])
+  if 'diff' in entry or 'revprops' in entry:
+    raise svntest.Failure("Unexpected output without -v and --with-diff")
+
+  # Other subcommands don't take revision ranges.
+  svntest.actions.run_and_verify_svnlook(None, ".*revision ranges.*",
+                                         'changed', '-r', '1:2', repo_dir)
+
 
 ########################################################################
 # Run the tests
@@ -738,6 +784,7 @@ test_list = [ None,
               test_filesize,
               test_txn_flag,
               property_delete,
+              json_range,
              ]
 
 if __name__ == '__main__':
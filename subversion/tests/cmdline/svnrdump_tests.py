@@ -1021,6 +1021,11 @@ def load_invalid_svn_date_revprop_in_r1(sbox):
                                [], expected_err, 1,
                                sbox.repo_url)
 
+def prefetch_dump(sbox):
+  "dump: fetch revisions in parallel"
+  run_dump_test(sbox, "move-and-modify.dump",
+                extra_options=['--prefetch', '3'])
+
 ########################################################################
 # Run the tests
 
@@ -1084,6 +1089,7 @@ test_list = [ None,
               load_non_deltas_with_props,
               load_invalid_svn_date_revprop_in_r0,
               load_invalid_svn_date_revprop_in_r1,
+              prefetch_dump,
              ]
 
 if __name__ == '__main__':
@@ -51,7 +51,7 @@ Item = svntest.wc.StateItem
 
 
 def run_sync(url, source_url=None,
-             source_prop_encoding=None,
+             source_prop_encoding=None, prefetch=None,
              expected_output=AnyOutput, expected_error=[]):
   "Synchronize the mirror repository with the master"
   if source_url is not None:
@@ -61,6 +61,9 @@ def run_sync(url, source_url=None,
   if source_prop_encoding:
     args.append("--source-prop-encoding")
     args.append(source_prop_encoding)
+  if prefetch:
+    args.append("--prefetch")
+    args.append(str(prefetch))
 
   # Normal expected output is of the form:
   #            ['Transmitting file data .......\n',  # optional
@@ -105,7 +108,8 @@ def run_info(url, expected_output=AnyOutput, expected_error=[]):
 
 def setup_and_sync(sbox, dump_file_contents, subdir=None,
                    bypass_prop_validation=False, source_prop_encoding=None,
-                   is_src_ra_local=None, is_dest_ra_local=None):
+                   is_src_ra_local=None, is_dest_ra_local=None,
+                   prefetch=None):
   """Create a repository for SBOX, load it with DUMP_FILE_CONTENTS, then create a mirror repository and sync it with SBOX. If is_src_ra_local or is_dest_ra_local is True, then run_init, run_sync, and run_copy_revprops will use the file:// scheme for the source and destination URLs.  Return the mirror sandbox."""
 
   # Create the empty master repository.
@@ -142,7 +146,7 @@ def setup_and_sync(sbox, dump_file_contents, subdir=None,
   run_init(dest_repo_url, repo_url, source_prop_encoding)
 
   run_sync(dest_repo_url, repo_url,
-           source_prop_encoding=source_prop_encoding)
+           source_prop_encoding=source_prop_encoding, prefetch=prefetch)
   run_copy_revprops(dest_repo_url, repo_url,
                     source_prop_encoding=source_prop_encoding)
 
@@ -171,7 +175,7 @@ def verify_mirror(dest_sbox, exp_dump_file_contents):
 
 def run_test(sbox, dump_file_name, subdir=None, exp_dump_file_name=None,
              bypass_prop_validation=False, source_prop_encoding=None,
-             is_src_ra_local=None, is_dest_ra_local=None):
+             is_src_ra_local=None, is_dest_ra_local=None, prefetch=None):
 
   """Load a dump file, sync repositories, and compare contents with the original
 or another dump file."""
@@ -187,7 +191,7 @@ or another dump file."""
 
   dest_sbox = setup_and_sync(sbox, master_dumpfile_contents, subdir,
                              bypass_prop_validation, source_prop_encoding,
-                             is_src_ra_local, is_dest_ra_local)
+                             is_src_ra_local, is_dest_ra_local, prefetch)
 
   # Compare the dump produced by the mirror repository with either the original
   # dump file (used to create the master repository) or another specified dump
@@ -587,6 +591,10 @@ def up_to_date_sync(sbox):
   svntest.actions.run_and_verify_svnsync([], [],
                                          "synchronize", dest_sbox.repo_url)
 
+def prefetch_sync(sbox):
+  "sync with parallel prefetch"
+  run_test(sbox, "svnsync-move-and-modify.dump", prefetch=3)
+
 
 ########################################################################
 # Run the tests
@@ -625,6 +633,7 @@ test_list = [ None,
               fd_leak_sync_from_serf_to_local, # calls setrlimit
               mergeinfo_contains_r0,
               up_to_date_sync,
+              prefetch_sync,
              ]
 
 if __name__ == '__main__':
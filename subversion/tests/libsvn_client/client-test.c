@@ -36,6 +36,7 @@
 #include "svn_repos.h"
 #include "svn_subst.h"
 #include "private/svn_sorts_private.h"
+#include "private/svn_string_private.h"
 #include "private/svn_wc_private.h"
 #include "svn_props.h"
 #include "svn_hash.h"
@@ -1446,6 +1447,129 @@ test_copy_pin_externals_select_subtree(const svn_test_opts_t *opts, apr_pool_t *
   return SVN_NO_ERROR;
 }
 
+/* Implements svn_client_blame_receiver4_t, appending "REV AUTHOR LINE"
+   for every line to the svn_stringbuf_t BATON. */
+static svn_error_t *
+blame_to_string(void *baton,
+                apr_int64_t line_no,
+                svn_revnum_t revision,
+                apr_hash_t *rev_props,
+                svn_revnum_t merged_revision,
+                apr_hash_t *merged_rev_props,
+                const char *merged_path,
+                const svn_string_t *line,
+                svn_boolean_t local_change,
+                apr_pool_t *pool)
+{
+  svn_stringbuf_t *result = baton;
+  const char *author = svn_prop_get_value(rev_props,
+                                          SVN_PROP_REVISION_AUTHOR);
+
+  svn_stringbuf_appendcstr(result,
+                           apr_psprintf(pool, "%ld %s %s\n", revision,
+                                        author ? author : "-", line->data));
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_blame_incremental(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  const char *repos_url;
+  const char *iota_url;
+  svn_client_ctx_t *ctx;
+  svn_client__mtcc_t *mtcc;
+  svn_opt_revision_t head_rev = { svn_opt_revision_head, { 0 } };
+  svn_opt_revision_t start_rev = { svn_opt_revision_number, { 0 } };
+  svn_opt_revision_t end_rev = { svn_opt_revision_number, { 0 } };
+  svn_diff_file_options_t *diff_options = svn_diff_file_options_create(pool);
+  svn_stringbuf_t *expected = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *actual = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *state;
+  svn_stringbuf_t *state2;
+  svn_revnum_t start_revnum;
+  svn_revnum_t end_revnum;
+  svn_error_t *err;
+
+  SVN_ERR(create_greek_repos(&repos_url, "test-blame-incremental", opts,
+                             pool));
+  iota_url = svn_path_url_add_component2(repos_url, "iota", pool);
+
+  SVN_ERR(svn_client_create_context(&ctx, pool));
+
+  /* r2 and r3 rewrite iota. */
+  SVN_ERR(svn_client__mtcc_create(&mtcc, repos_url, -1, ctx, pool, pool));
+  SVN_ERR(svn_client__mtcc_add_update_file(
+            "iota",
+            svn_stream_from_string(svn_string_create("one\ntwo\n", pool),
+                                   pool),
+            NULL, NULL, NULL, mtcc, pool));
+  SVN_ERR(svn_client__mtcc_commit(NULL, NULL, NULL, mtcc, pool));
+
+  SVN_ERR(svn_client__mtcc_create(&mtcc, repos_url, -1, ctx, pool, pool));
+  SVN_ERR(svn_client__mtcc_add_update_file(
+            "iota",
+            svn_stream_from_string(svn_string_create("one\nTWO\nthree\n",
+                                                     pool),
+                                   pool),
+            NULL, NULL, NULL, mtcc, pool));
+  SVN_ERR(svn_client__mtcc_commit(NULL, NULL, NULL, mtcc, pool));
+
+  /* The blame of r2:3 as a whole ... */
+  start_rev.value.number = 2;
+  end_rev.value.number = 3;
+  SVN_ERR(svn_client_blame6(NULL, NULL, iota_url, &head_rev,
+                            &start_rev, &end_rev, diff_options,
+                            FALSE, FALSE, blame_to_string, expected,
+                            ctx, pool));
+  SVN_TEST_STRING_ASSERT(expected->data,
+                         "2 - one\n3 - TWO\n3 - three\n");
+
+  /* ... must be the same as the blame of r2 continued to r3. */
+  end_rev.value.number = 2;
+  SVN_ERR(svn_client_blame_incremental(&state, NULL, NULL, iota_url,
+                                       &head_rev, &start_rev, &end_rev,
+                                       NULL, diff_options, FALSE,
+                                       blame_to_string, actual,
+                                       ctx, pool, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, "2 - one\n2 - two\n");
+
+  svn_stringbuf_setempty(actual);
+  end_rev.value.number = 3;
+  SVN_ERR(svn_client_blame_incremental(&state2, &start_revnum, &end_revnum,
+                                       iota_url, &head_rev, NULL, &end_rev,
+                                       svn_stringbuf__morph_into_string(state),
+                                       diff_options, FALSE,
+                                       blame_to_string, actual,
+                                       ctx, pool, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, expected->data);
+  SVN_TEST_ASSERT(start_revnum == 2);
+  SVN_TEST_ASSERT(end_revnum == 3);
+
+  /* Continuing without new revisions reports the state as is. */
+  svn_stringbuf_setempty(actual);
+  SVN_ERR(svn_client_blame_incremental(NULL, NULL, NULL,
+                                       iota_url, &head_rev, NULL, &end_rev,
+                                       svn_stringbuf__morph_into_string(state2),
+                                       diff_options, FALSE,
+                                       blame_to_string, actual,
+                                       ctx, pool, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, expected->data);
+
+  /* A state can't be used for another file. */
+  err = svn_client_blame_incremental(NULL, NULL, NULL,
+                                     svn_path_url_add_component2(
+                                       repos_url, "A/mu", pool),
+                                     &head_rev, NULL, &end_rev,
+                                     svn_stringbuf__morph_into_string(state2),
+                                     diff_options, FALSE,
+                                     blame_to_string, actual,
+                                     ctx, pool, pool);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_CLIENT_UNRELATED_RESOURCES);
+
+  return SVN_NO_ERROR;
+}
+
 /* ========================================================================== */
 
 
@@ -1474,6 +1598,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test svn_client_copy7 with externals_to_pin"),
     SVN_TEST_OPTS_PASS(test_copy_pin_externals_select_subtree,
                        "pin externals on selected subtrees only"),
+    SVN_TEST_OPTS_PASS(test_blame_incremental,
+                       "test svn_client_blame_incremental"),
     SVN_TEST_NULL
   };
 
@@ -811,6 +811,88 @@ test_move_and_delete_ancestor(const svn_test_opts_t *opts,
 
 }
 
+static svn_error_t *
+test_many_files(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_client__mtcc_t *mtcc;
+  svn_client_ctx_t *ctx;
+  const char *repos_url;
+  svn_node_kind_t kind;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(svn_test__create_repos2(NULL, &repos_url, NULL, "mtcc-many-files",
+                                  opts, pool, pool));
+
+  SVN_ERR(make_greek_tree(repos_url, pool));
+
+  SVN_ERR(svn_client_create_context2(&ctx, NULL, pool));
+  SVN_ERR(svn_test__init_auth_baton(&ctx->auth_baton, pool));
+
+  SVN_ERR(svn_client__mtcc_create(&mtcc, repos_url, 1, ctx, pool, pool));
+
+  /* Enough files in an existing and in a new directory to have their
+     children indexed and the existing directory listed. */
+  SVN_ERR(svn_client__mtcc_add_mkdir("many", mtcc, pool));
+  for (i = 0; i < 40; i++)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_client__mtcc_add_add_file(
+                        apr_psprintf(iterpool, "A/f-%d", i),
+                        cstr_stream("A file\n", pool), NULL, mtcc, iterpool));
+      SVN_ERR(svn_client__mtcc_add_add_file(
+                        apr_psprintf(iterpool, "many/f-%d", i),
+                        cstr_stream("A file\n", pool), NULL, mtcc, iterpool));
+    }
+
+  /* Existing nodes are still found once the directory got listed */
+  SVN_TEST_ASSERT_ERROR(
+        svn_client__mtcc_add_add_file("A/mu", cstr_stream("", pool), NULL,
+                                      mtcc, pool),
+        SVN_ERR_FS_ALREADY_EXISTS);
+  SVN_TEST_ASSERT_ERROR(
+        svn_client__mtcc_add_add_file("many/f-7", cstr_stream("", pool),
+                                      NULL, mtcc, pool),
+        SVN_ERR_FS_ALREADY_EXISTS);
+  SVN_ERR(svn_client__mtcc_check_path(&kind, "A/B", FALSE, mtcc, pool));
+  SVN_TEST_ASSERT(kind == svn_node_dir);
+  SVN_ERR(svn_client__mtcc_check_path(&kind, "A/f-7", FALSE, mtcc, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+  SVN_ERR(svn_client__mtcc_check_path(&kind, "A/nothing", FALSE, mtcc,
+                                      pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* Replace a node in an indexed directory */
+  SVN_ERR(svn_client__mtcc_add_delete("A/mu", mtcc, pool));
+  SVN_ERR(svn_client__mtcc_check_path(&kind, "A/mu", FALSE, mtcc, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(svn_client__mtcc_add_mkdir("A/mu", mtcc, pool));
+  SVN_ERR(svn_client__mtcc_check_path(&kind, "A/mu", FALSE, mtcc, pool));
+  SVN_TEST_ASSERT(kind == svn_node_dir);
+
+  SVN_ERR(verify_mtcc_commit(mtcc, 2, pool));
+
+  SVN_ERR(svn_client__mtcc_create(&mtcc, repos_url, 2, ctx, pool, pool));
+  for (i = 0; i < 40; i += 13)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_client__mtcc_check_path(&kind,
+                                          apr_psprintf(iterpool, "many/f-%d",
+                                                       i),
+                                          TRUE, mtcc, iterpool));
+      SVN_TEST_ASSERT(kind == svn_node_file);
+    }
+  SVN_ERR(svn_client__mtcc_check_path(&kind, "A/mu", TRUE, mtcc, pool));
+  SVN_TEST_ASSERT(kind == svn_node_dir);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* ========================================================================== */
 
@@ -842,6 +924,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test iprops url format"),
     SVN_TEST_OPTS_PASS(test_move_and_delete_ancestor,
                        "test move and delete ancestor (issue 4666)"),
+    SVN_TEST_OPTS_PASS(test_many_files,
+                       "test adding many files"),
     SVN_TEST_NULL
   };
 
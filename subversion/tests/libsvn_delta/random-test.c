@@ -37,6 +37,7 @@
 #include "svn_pools.h"
 #include "svn_error.h"
 
+#include "private/svn_subr_private.h"
 #include "../../libsvn_delta/delta.h"
 #include "delta-window-test.h"
 
@@ -330,14 +331,15 @@ do_random_test(apr_pool_t *pool,
 
       /* Make stage 2: encode the text delta in svndiff format using
                        varying svndiff versions and compression levels. */
-      svn_txdelta_to_svndiff3(&handler, &handler_baton, stream, i % 3,
+      svn_txdelta_to_svndiff3(&handler, &handler_baton, stream,
+                              i % (svn_zstd__is_available() ? 4 : 3),
                               i % 10, delta_pool);
 
       /* Make stage 1: create the text delta.  */
-      svn_txdelta2(&txdelta_stream,
+      svn_txdelta3(&txdelta_stream,
                    svn_stream_from_aprfile(source, delta_pool),
                    svn_stream_from_aprfile(target, delta_pool),
-                   FALSE,
+                   FALSE, FALSE,
                    delta_pool);
 
       SVN_ERR(svn_txdelta_send_txstream(txdelta_stream,
@@ -426,21 +428,22 @@ do_random_combine_test(apr_pool_t *pool,
 
       /* Make stage 2: encode the text delta in svndiff format using
                        varying svndiff versions and compression levels. */
-      svn_txdelta_to_svndiff3(&handler, &handler_baton, stream, i % 3,
+      svn_txdelta_to_svndiff3(&handler, &handler_baton, stream,
+                              i % (svn_zstd__is_available() ? 4 : 3),
                               i % 10, delta_pool);
 
       /* Make stage 1: create the text deltas.  */
 
-      svn_txdelta2(&txdelta_stream_A,
+      svn_txdelta3(&txdelta_stream_A,
                    svn_stream_from_aprfile(source, delta_pool),
                    svn_stream_from_aprfile(middle, delta_pool),
-                   FALSE,
+                   FALSE, FALSE,
                    delta_pool);
 
-      svn_txdelta2(&txdelta_stream_B,
+      svn_txdelta3(&txdelta_stream_B,
                    svn_stream_from_aprfile(middle_copy, delta_pool),
                    svn_stream_from_aprfile(target, delta_pool),
-                   FALSE,
+                   FALSE, FALSE,
                    delta_pool);
 
       {
@@ -565,10 +568,10 @@ do_random_txdelta_to_svndiff_stream_test(apr_pool_t *pool,
 
       /* Create a txdelta stream that turns the source into target;
          turn it into a generic readable svn_stream_t. */
-      svn_txdelta2(&txstream,
+      svn_txdelta3(&txstream,
                    svn_stream_from_aprfile2(source, TRUE, iterpool),
                    svn_stream_from_aprfile2(target, TRUE, iterpool),
-                   FALSE, iterpool);
+                   FALSE, FALSE, iterpool);
       delta_stream = svn_txdelta_to_svndiff_stream(txstream, i % 3, i % 10,
                                                    iterpool);
 
@@ -22,6 +22,8 @@
  */
 
 #include "svn_delta.h"
+#include "svn_pools.h"
+#include "private/svn_delta_private.h"
 #include "../svn_test.h"
 
 static svn_error_t *
@@ -66,6 +68,96 @@ test_txdelta_to_svndiff_stream_small_reads(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Return a txdelta stream from SOURCE to TARGET, allocated in POOL. */
+static svn_txdelta_stream_t *
+create_txstream(const svn_string_t *source,
+                const svn_string_t *target,
+                apr_pool_t *pool)
+{
+  svn_txdelta_stream_t *txstream;
+  svn_txdelta2(&txstream, svn_stream_from_string(source, pool),
+               svn_stream_from_string(target, pool), FALSE, pool);
+
+  return txstream;
+}
+
+static svn_error_t *
+test_parallel_svndiff_encoding(apr_pool_t *pool)
+{
+  const apr_size_t size = 1024 * 1024;
+  char *source_data = apr_palloc(pool, size);
+  char *target_data = apr_palloc(pool, size);
+  svn_string_t source, target;
+  apr_uint32_t seed = 0;
+  apr_size_t i;
+  int version;
+
+  /* Compressible text, modified in every window. */
+  for (i = 0; i < size; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      source_data[i] = (char)('a' + (seed >> 16) % 16);
+    }
+  memcpy(target_data, source_data, size);
+  for (i = 0; i < size; i += 997)
+    target_data[i] = 'X';
+
+  source.data = source_data;
+  source.len = size;
+  target.data = target_data;
+  target.len = size;
+
+  for (version = 0; version <= 2; ++version)
+    {
+      apr_pool_t *iterpool = svn_pool_create(pool);
+      svn_stringbuf_t *expected = svn_stringbuf_create_empty(iterpool);
+      svn_stringbuf_t *actual = svn_stringbuf_create_empty(iterpool);
+      svn_txdelta_window_handler_t handler;
+      void *baton;
+      svn_stream_t *stream;
+      char buf[1000];
+      apr_size_t len;
+
+      svn_txdelta_to_svndiff3(&handler, &baton,
+                              svn_stream_from_stringbuf(expected, iterpool),
+                              version, SVN_DELTA_COMPRESSION_LEVEL_DEFAULT,
+                              iterpool);
+      SVN_ERR(svn_txdelta_send_txstream(create_txstream(&source, &target,
+                                                        iterpool),
+                                        handler, baton, iterpool));
+
+      /* Push the windows through the parallel encoder. */
+      SVN_ERR(svn_txdelta__to_svndiff_parallel(
+                  &handler, &baton,
+                  svn_stream_from_stringbuf(actual, iterpool),
+                  version, SVN_DELTA_COMPRESSION_LEVEL_DEFAULT, 4,
+                  iterpool));
+      SVN_ERR(svn_txdelta_send_txstream(create_txstream(&source, &target,
+                                                        iterpool),
+                                        handler, baton, iterpool));
+      SVN_TEST_ASSERT(svn_stringbuf_compare(expected, actual));
+
+      /* Pull the data in small chunks. */
+      svn_stringbuf_setempty(actual);
+      SVN_ERR(svn_txdelta__to_svndiff_stream_parallel(
+                  &stream, create_txstream(&source, &target, iterpool),
+                  version, SVN_DELTA_COMPRESSION_LEVEL_DEFAULT, 4,
+                  iterpool));
+      do
+        {
+          len = sizeof(buf);
+          SVN_ERR(svn_stream_read_full(stream, buf, &len));
+          svn_stringbuf_appendbytes(actual, buf, len);
+        }
+      while (len == sizeof(buf));
+      SVN_TEST_ASSERT(svn_stringbuf_compare(expected, actual));
+
+      svn_pool_destroy(iterpool);
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = -1;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -73,6 +165,8 @@ static struct svn_test_descriptor_t test_funcs[] =
   SVN_TEST_NULL,
   SVN_TEST_PASS2(test_txdelta_to_svndiff_stream_small_reads,
                  "test svn_txdelta_to_svndiff_stream() small reads"),
+  SVN_TEST_PASS2(test_parallel_svndiff_encoding,
+                 "test svndiff encoding in worker threads"),
   SVN_TEST_NULL
 };
 
@@ -70,7 +70,7 @@ stream_window_test(apr_pool_t *pool)
   target_str.len = 109000;
   target_stream = svn_stream_from_string(&target_str, pool);
 
-  svn_txdelta2(&txstream, source_stream, target_stream, TRUE, pool);
+  svn_txdelta3(&txstream, source_stream, target_stream, TRUE, FALSE, pool);
 
   while (1)
     {
@@ -97,6 +97,181 @@ stream_window_test(apr_pool_t *pool)
 }
 
 
+/* Fill LEN bytes at DATA with pseudo-random data based on *SEED. */
+static void
+fill_random(char *data, apr_size_t len, apr_uint32_t *seed)
+{
+  apr_size_t i;
+  for (i = 0; i < len; ++i)
+    {
+      *seed = *seed * 1103515245 + 12345;
+      data[i] = (char)(*seed >> 16);
+    }
+}
+
+/* Baton for count_window_handler(). */
+typedef struct count_baton_t
+{
+  /* Window handler to forward all windows to. */
+  svn_txdelta_window_handler_t handler;
+  void *baton;
+
+  /* Total amount of new data in all windows so far. */
+  apr_size_t new_len;
+} count_baton_t;
+
+/* Implements svn_txdelta_window_handler_t.  Sum up the new data in
+ * WINDOW and pass it on to the handler in BATON. */
+static svn_error_t *
+count_window_handler(svn_txdelta_window_t *window,
+                     void *baton)
+{
+  count_baton_t *b = baton;
+  if (window)
+    b->new_len += window->new_data->len;
+
+  return svn_error_trace(b->handler(window, b->baton));
+}
+
+/* Deltify TARGET against SOURCE with the given TRACK_SOURCE setting,
+ * either pulling windows from a delta stream or pushing the TARGET data,
+ * depending on USE_PUSH.  Verify that applying the windows reproduces
+ * TARGET and return the total amount of new data in the windows in
+ * *NEW_LEN. */
+static svn_error_t *
+deltify_and_apply(apr_size_t *new_len,
+                  const svn_string_t *source,
+                  const svn_string_t *target,
+                  svn_boolean_t track_source,
+                  svn_boolean_t use_push,
+                  apr_pool_t *pool)
+{
+  count_baton_t count_baton = { 0 };
+  svn_stringbuf_t *result = svn_stringbuf_create_empty(pool);
+
+  svn_txdelta_apply2(svn_stream_from_string(source, pool),
+                     svn_stream_from_stringbuf(result, pool),
+                     NULL, NULL, pool,
+                     &count_baton.handler, &count_baton.baton);
+
+  if (use_push)
+    {
+      apr_size_t len = target->len;
+      svn_stream_t *stream
+        = svn_txdelta_target_push2(count_window_handler, &count_baton,
+                                   svn_stream_from_string(source, pool),
+                                   track_source, pool);
+
+      SVN_ERR(svn_stream_write(stream, target->data, &len));
+      SVN_ERR(svn_stream_close(stream));
+    }
+  else
+    {
+      svn_txdelta_stream_t *txstream;
+
+      svn_txdelta3(&txstream, svn_stream_from_string(source, pool),
+                   svn_stream_from_string(target, pool), FALSE,
+                   track_source, pool);
+      SVN_ERR(svn_txdelta_send_txstream(txstream, count_window_handler,
+                                        &count_baton, pool));
+    }
+
+  SVN_TEST_ASSERT(result->len == target->len);
+  SVN_TEST_ASSERT(memcmp(result->data, target->data, target->len) == 0);
+
+  *new_len = count_baton.new_len;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+source_tracking_test(apr_pool_t *pool)
+{
+  const apr_size_t source_size = 2 * 1024 * 1024;
+  const apr_size_t insert_pos = 200 * 1024;
+  const apr_size_t insert_size = 1024 * 1024;
+  char *source_data = apr_palloc(pool, source_size);
+  char *target_data = apr_palloc(pool, source_size + insert_size);
+  svn_string_t source, target;
+  apr_size_t plain_len, tracked_len, pushed_len;
+  apr_uint32_t seed = 0;
+
+  /* The target is the source with a large block of random data inserted,
+     i.e. most of it has moved far beyond the window size. */
+  fill_random(source_data, source_size, &seed);
+  memcpy(target_data, source_data, insert_pos);
+  fill_random(target_data + insert_pos, insert_size, &seed);
+  memcpy(target_data + insert_pos + insert_size, source_data + insert_pos,
+         source_size - insert_pos);
+
+  source.data = source_data;
+  source.len = source_size;
+  target.data = target_data;
+  target.len = source_size + insert_size;
+
+  SVN_ERR(deltify_and_apply(&plain_len, &source, &target, FALSE, FALSE,
+                            pool));
+  SVN_ERR(deltify_and_apply(&tracked_len, &source, &target, TRUE, FALSE,
+                            pool));
+  SVN_ERR(deltify_and_apply(&pushed_len, &source, &target, TRUE, TRUE,
+                            pool));
+
+  /* Without source tracking, hardly anything behind the insertion can be
+     found.  With it, little more than the inserted data should remain. */
+  SVN_TEST_ASSERT(plain_len > source_size);
+  SVN_TEST_ASSERT(tracked_len < insert_size + insert_size / 10);
+  SVN_TEST_ASSERT(pushed_len == tracked_len);
+
+  return SVN_NO_ERROR;
+}
+
+/* Apply target copies with all short pattern periods and lengths both
+ * shorter and much longer than the period and compare the result with a
+ * byte-by-byte reference implementation. */
+static svn_error_t *
+patterning_copy_test(apr_pool_t *pool)
+{
+  enum { PREFIX = 32, TARGET_LEN = 4096 };
+  static const char new_data[PREFIX + 1] = "0123456789abcdefghijklmnopqrstuv";
+  svn_string_t new_str;
+  svn_txdelta_op_t ops[2];
+  svn_txdelta_window_t window = { 0 };
+  char *expected = apr_palloc(pool, TARGET_LEN);
+  char *actual = apr_palloc(pool, TARGET_LEN);
+  apr_size_t period, len, i;
+
+  new_str.data = new_data;
+  new_str.len = PREFIX;
+
+  ops[0].action_code = svn_txdelta_new;
+  ops[0].offset = 0;
+  ops[0].length = PREFIX;
+  ops[1].action_code = svn_txdelta_target;
+
+  window.ops = ops;
+  window.num_ops = 2;
+  window.new_data = &new_str;
+
+  for (period = 1; period <= PREFIX; ++period)
+    for (len = 1; len <= TARGET_LEN - PREFIX; len = len * 3 + 1)
+      {
+        apr_size_t tlen = PREFIX + len;
+
+        ops[1].offset = PREFIX - period;
+        ops[1].length = len;
+        window.tview_len = tlen;
+
+        memcpy(expected, new_data, PREFIX);
+        for (i = PREFIX; i < tlen; ++i)
+          expected[i] = expected[i - period];
+
+        svn_txdelta_apply_instructions(&window, NULL, actual, &tlen);
+        SVN_TEST_ASSERT(tlen == PREFIX + len);
+        SVN_TEST_ASSERT(memcmp(expected, actual, tlen) == 0);
+      }
+
+  return SVN_NO_ERROR;
+}
+
 
 /* The test table.  */
 
@@ -107,6 +282,10 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_NULL,
     SVN_TEST_PASS2(stream_window_test,
                    "txdelta stream and windows test"),
+    SVN_TEST_PASS2(source_tracking_test,
+                   "txdelta with source tracking"),
+    SVN_TEST_PASS2(patterning_copy_test,
+                   "apply short-period target copies"),
     SVN_TEST_NULL
   };
 
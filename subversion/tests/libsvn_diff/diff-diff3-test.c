@@ -3065,6 +3065,155 @@ three_way_double_add(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Like random_trivial_merge() but use the histogram diff algorithm,
+   selected through svn_diff_file_options_parse(). */
+static svn_error_t *
+random_histogram_merge(apr_pool_t *pool)
+{
+  int i;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  svn_diff_file_options_t *options = svn_diff_file_options_create(pool);
+  apr_array_header_t *args = apr_array_make(pool, 1, sizeof(const char *));
+
+  const char *base_filename1 = "histogram1";
+  const char *base_filename2 = "histogram2";
+
+  const char *filename1 = svn_test_data_path(base_filename1, pool);
+  const char *filename2 = svn_test_data_path(base_filename2, pool);
+
+  APR_ARRAY_PUSH(args, const char *) = "--histogram";
+  SVN_ERR(svn_diff_file_options_parse(options, args, pool));
+  SVN_TEST_ASSERT(options->histogram);
+
+  seed_val();
+
+  for (i = 0; i < 5; ++i)
+    {
+      int min_lines = 1000;
+      int max_lines = 1100;
+      int var_lines = 50;
+      int block_lines = 10;
+      svn_stringbuf_t *contents1, *contents2;
+
+      SVN_ERR(make_random_file(filename1,
+                               min_lines, max_lines, var_lines, block_lines,
+                               i % 3, subpool));
+      SVN_ERR(make_random_file(filename2,
+                               min_lines, max_lines, var_lines, block_lines,
+                               i % 2, subpool));
+
+      SVN_ERR(svn_stringbuf_from_file2(&contents1, filename1, subpool));
+      SVN_ERR(svn_stringbuf_from_file2(&contents2, filename2, subpool));
+
+      SVN_ERR(three_way_merge(base_filename1, base_filename2, base_filename1,
+                              contents1->data, contents2->data,
+                              contents1->data, contents2->data, options,
+                              svn_diff_conflict_display_modified_latest,
+                              subpool));
+      SVN_ERR(three_way_merge(base_filename2, base_filename1, base_filename2,
+                              contents2->data, contents1->data,
+                              contents2->data, contents1->data, options,
+                              svn_diff_conflict_display_modified_latest,
+                              subpool));
+      svn_pool_clear(subpool);
+    }
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
+/* Diff and merge files with many distinct, long lines, ignoring
+   whitespace changes. */
+static svn_error_t *
+test_many_tokens_ignore_space(apr_pool_t *pool)
+{
+  svn_stringbuf_t *original = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *spaced = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *modified = svn_stringbuf_create_empty(pool);
+  svn_diff_file_options_t *options = svn_diff_file_options_create(pool);
+  svn_diff_t *diff;
+  int i;
+
+  for (i = 0; i < 5000; i++)
+    {
+      svn_stringbuf_appendcstr(original,
+        apr_psprintf(pool, "  line %d with some longer content %d;\n",
+                     i, i * 7));
+      svn_stringbuf_appendcstr(spaced,
+        apr_psprintf(pool, "\tline %d  with some longer \t content %d;\n",
+                     i, i * 7));
+      svn_stringbuf_appendcstr(modified,
+        apr_psprintf(pool, "  line %d with some longer content %d;\n",
+                     i, i % 13 ? i * 7 : i));
+    }
+
+  options->ignore_space = svn_diff_file_ignore_space_change;
+  SVN_ERR(svn_diff_mem_string_diff(&diff,
+                                   svn_string_create_from_buf(original, pool),
+                                   svn_string_create_from_buf(spaced, pool),
+                                   options, pool));
+  SVN_TEST_ASSERT(! svn_diff_contains_diffs(diff));
+
+  options->ignore_space = svn_diff_file_ignore_space_none;
+  SVN_ERR(svn_diff_mem_string_diff(&diff,
+                                   svn_string_create_from_buf(original, pool),
+                                   svn_string_create_from_buf(spaced, pool),
+                                   options, pool));
+  SVN_TEST_ASSERT(svn_diff_contains_diffs(diff));
+
+  SVN_ERR(three_way_merge("manytokens1", "manytokens2", "manytokens1",
+                          original->data, modified->data,
+                          original->data, modified->data, NULL,
+                          svn_diff_conflict_display_modified_latest,
+                          pool));
+
+  return SVN_NO_ERROR;
+}
+
+/* Merge files that span several chunks, with and without normalization.
+   Without normalization, the files will usually be memory-mapped. */
+static svn_error_t *
+test_multi_chunk_merge(apr_pool_t *pool)
+{
+  svn_stringbuf_t *original = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *modified = svn_stringbuf_create_empty(pool);
+  svn_diff_file_options_t *options = svn_diff_file_options_create(pool);
+  int i;
+
+  /* About 600kB, i.e. several chunks in diff_file.c. */
+  for (i = 0; i < 20000; i++)
+    {
+      const char *line = apr_psprintf(pool, "line %d of a multi-chunk file\n",
+                                      i % 1000);
+
+      svn_stringbuf_appendcstr(original, line);
+      if (i % 997 == 0)
+        svn_stringbuf_appendcstr(modified, "changed line\n");
+      else if (i % 1499 != 0)
+        svn_stringbuf_appendcstr(modified, line);
+    }
+
+  SVN_ERR(three_way_merge("multichunk1", "multichunk2", "multichunk1",
+                          original->data, modified->data,
+                          original->data, modified->data, NULL,
+                          svn_diff_conflict_display_modified_latest,
+                          pool));
+  SVN_ERR(three_way_merge("multichunk2", "multichunk1", "multichunk2",
+                          modified->data, original->data,
+                          modified->data, original->data, NULL,
+                          svn_diff_conflict_display_modified_latest,
+                          pool));
+
+  options->ignore_eol_style = TRUE;
+  SVN_ERR(three_way_merge("multichunk1", "multichunk2", "multichunk1",
+                          original->data, modified->data,
+                          original->data, modified->data, options,
+                          svn_diff_conflict_display_modified_latest,
+                          pool));
+
+  return SVN_NO_ERROR;
+}
+
 /* ========================================================================== */
 
 
@@ -3109,6 +3258,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "2-way issue #3362 test v2"),
     SVN_TEST_XFAIL2(three_way_double_add,
                    "3-way merge, double add"),
+    SVN_TEST_PASS2(random_histogram_merge,
+                   "random trivial merge with histogram diff"),
+    SVN_TEST_PASS2(test_many_tokens_ignore_space,
+                   "many distinct tokens, ignoring whitespace"),
+    SVN_TEST_PASS2(test_multi_chunk_merge,
+                   "merge files spanning multiple chunks"),
     SVN_TEST_NULL
   };
 
@@ -7226,8 +7226,8 @@ test_cache_clear_during_stream(const svn_test_opts_t *opts,
    * Just to be sure, make it not too uniform to keep self-txdelta at bay. */
   SVN_ERR(svn_fs_apply_textdelta(&consumer_func, &consumer_baton,
                                  txn_root, "/foo", NULL, NULL, subpool));
-  stream = svn_txdelta_target_push(consumer_func, consumer_baton,
-                                   svn_stream_empty(subpool), subpool);
+  stream = svn_txdelta_target_push2(consumer_func, consumer_baton,
+                                    svn_stream_empty(subpool), FALSE, subpool);
   for (i = 0; i < 10000; ++ i)
     {
       svn_string_t *text;
@@ -7476,6 +7476,115 @@ test_unrecognized_ioctl(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_io_stats(const svn_test_opts_t *opts,
+              apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *rev_root;
+  svn_revnum_t new_rev;
+  svn_stringbuf_t *contents;
+  svn_fs_io_stats_t *before, *after;
+  const char *repo_name = "test-repo-io-stats";
+
+  SVN_ERR(svn_test__create_fs(&fs, repo_name, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(test_commit_txn(&new_rev, txn, NULL, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(new_rev));
+
+  /* Use a fresh FS object. */
+  SVN_ERR(svn_fs_open2(&fs, repo_name, NULL, pool, pool));
+  SVN_ERR(svn_fs_get_io_stats(&before, fs, pool));
+
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, new_rev, pool));
+  SVN_ERR(svn_test__get_file_contents(rev_root, "A/D/G/rho", &contents,
+                                      pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "This is the file 'rho'.\n");
+  SVN_ERR(svn_fs_get_io_stats(&after, fs, pool));
+
+  /* Counters never go backwards. */
+  SVN_TEST_ASSERT(after->files_opened >= before->files_opened);
+  SVN_TEST_ASSERT(after->index_lookups >= before->index_lookups);
+  SVN_TEST_ASSERT(after->items_read >= before->items_read);
+  SVN_TEST_ASSERT(after->bytes_read >= before->bytes_read);
+  SVN_TEST_ASSERT(after->cache_gets >= before->cache_gets);
+  SVN_TEST_ASSERT(after->cache_hits <= after->cache_gets);
+  SVN_TEST_ASSERT(after->items_read || !after->bytes_read);
+
+  if (strcmp(opts->fs_type, SVN_FS_TYPE_BDB) == 0)
+    {
+      /* BDB does not collect any statistics. */
+      SVN_TEST_ASSERT(after->files_opened == 0);
+      SVN_TEST_ASSERT(after->cache_gets == 0);
+    }
+  else
+    {
+      /* The data came either from disk or from some cache. */
+      SVN_TEST_ASSERT(  after->files_opened + after->cache_gets
+                      > before->files_opened + before->cache_gets);
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_dir_entries_changed(const svn_test_opts_t *opts,
+                         apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root, *root1, *root2;
+  svn_revnum_t rev1, rev2;
+  apr_hash_t *s_entries, *t_entries;
+
+  SVN_ERR(svn_test__create_fs(&fs, "test-repo-dir-entries-changed", opts,
+                              pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(test_commit_txn(&rev1, txn, NULL, pool));
+
+  /* Modify A/mu, delete A/C and add A/new. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev1, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/mu", "changed\n", pool));
+  SVN_ERR(svn_fs_delete(txn_root, "A/C", pool));
+  SVN_ERR(svn_fs_make_dir(txn_root, "A/new", pool));
+  SVN_ERR(test_commit_txn(&rev2, txn, NULL, pool));
+
+  SVN_ERR(svn_fs_revision_root(&root1, fs, rev1, pool));
+  SVN_ERR(svn_fs_revision_root(&root2, fs, rev2, pool));
+
+  /* Only the changed entries remain.  A/B and A/D are unchanged. */
+  SVN_ERR(svn_fs_dir_entries_changed(&s_entries, &t_entries,
+                                     root1, "A", root2, "A", pool, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(s_entries), 2);
+  SVN_TEST_ASSERT(svn_hash_gets(s_entries, "mu"));
+  SVN_TEST_ASSERT(svn_hash_gets(s_entries, "C"));
+  SVN_TEST_INT_ASSERT(apr_hash_count(t_entries), 2);
+  SVN_TEST_ASSERT(svn_hash_gets(t_entries, "mu"));
+  SVN_TEST_ASSERT(svn_hash_gets(t_entries, "new"));
+
+  /* Identical directories have no changed entries. */
+  SVN_ERR(svn_fs_dir_entries_changed(&s_entries, &t_entries,
+                                     root1, "A/D", root2, "A/D",
+                                     pool, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(s_entries), 0);
+  SVN_TEST_INT_ASSERT(apr_hash_count(t_entries), 0);
+
+  /* Unrelated directories differ in all their entries. */
+  SVN_ERR(svn_fs_dir_entries_changed(&s_entries, &t_entries,
+                                     root1, "A/B", root2, "A/D",
+                                     pool, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(s_entries), 3);
+  SVN_TEST_INT_ASSERT(apr_hash_count(t_entries), 3);
+
+  return SVN_NO_ERROR;
+}
+
 /* ------------------------------------------------------------------------ */
 
 /* The test table.  */
@@ -7624,6 +7733,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "svn_fs_closest_copy after replacing file with dir"),
     SVN_TEST_OPTS_PASS(test_unrecognized_ioctl,
                        "test svn_fs_ioctl with unrecognized code"),
+    SVN_TEST_OPTS_PASS(test_io_stats,
+                       "test svn_fs_get_io_stats"),
+    SVN_TEST_OPTS_PASS(test_dir_entries_changed,
+                       "test svn_fs_dir_entries_changed"),
     SVN_TEST_NULL
   };
 
@@ -1214,6 +1214,65 @@ parent_and_child_lock(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Test lock verification for commits that change many more paths than
+   there are locks in the repository. */
+static svn_error_t *
+lock_check_many_changes(const svn_test_opts_t *opts,
+                        apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  const char *conflict;
+  svn_revnum_t newrev;
+  svn_fs_access_t *access;
+  svn_lock_t *mylock;
+  static const char * const files[] =
+    {
+      "/iota", "/A/mu", "/A/B/lambda", "/A/B/E/alpha", "/A/B/E/beta",
+      "/A/D/gamma", "/A/D/G/pi", "/A/D/G/rho", "/A/D/G/tau",
+      "/A/D/H/chi", "/A/D/H/psi", "/A/D/H/omega"
+    };
+  int i;
+
+  SVN_ERR(create_greek_fs(&fs, &newrev, "test-repo-lock-many-changes",
+                          opts, pool));
+
+  SVN_ERR(svn_fs_create_access(&access, "bubba", pool));
+  SVN_ERR(svn_fs_set_access(fs, access));
+  SVN_ERR(svn_fs_lock(&mylock, fs, "/A/D/G/rho", NULL, "", 0, 0,
+                      SVN_INVALID_REVNUM, FALSE, pool));
+
+  /* Modify all files, including the locked one. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, newrev, SVN_FS_TXN_CHECK_LOCKS, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  for (i = 0; i < (int)(sizeof(files) / sizeof(files[0])); ++i)
+    SVN_ERR(svn_test__set_file_contents(txn_root, files[i], "changed\n",
+                                        pool));
+
+  SVN_TEST_ASSERT_ERROR(svn_fs_commit_txn(&conflict, &newrev, txn, pool),
+                        SVN_ERR_FS_BAD_LOCK_TOKEN);
+  SVN_ERR(svn_fs_abort_txn(txn, pool));
+
+  /* Add files and delete the directory containing the locked file. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, newrev, SVN_FS_TXN_CHECK_LOCKS, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  for (i = 0; i < 20; ++i)
+    SVN_ERR(svn_fs_make_file(txn_root, apr_psprintf(pool, "/A/new%d", i),
+                             pool));
+  SVN_ERR(svn_fs_delete(txn_root, "/A/D", pool));
+
+  SVN_TEST_ASSERT_ERROR(svn_fs_commit_txn(&conflict, &newrev, txn, pool),
+                        SVN_ERR_FS_BAD_LOCK_TOKEN);
+
+  /* With the token, the commit succeeds. */
+  SVN_ERR(svn_fs_access_add_lock_token(access, mylock->token));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &newrev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(newrev));
+
+  return SVN_NO_ERROR;
+}
+
 /* ------------------------------------------------------------------------ */
 
 /* The test table.  */
@@ -1253,6 +1312,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "lock/unlock when 'write-lock' couldn't be obtained"),
     SVN_TEST_OPTS_PASS(parent_and_child_lock,
                        "lock parent and it's child"),
+    SVN_TEST_OPTS_PASS(lock_check_many_changes,
+                       "verify locks of commits with many changes"),
     SVN_TEST_NULL
   };
 
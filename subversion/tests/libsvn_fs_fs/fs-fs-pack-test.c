@@ -23,20 +23,35 @@
 #include <stdlib.h>
 #include <string.h>
 #include <apr_pools.h>
+#include <apr_thread_proc.h>
 
 #include "../svn_test.h"
 #include "../../libsvn_fs/fs-loader.h"
+#include "../../libsvn_fs_fs/cached_data.h"
 #include "../../libsvn_fs_fs/fs.h"
 #include "../../libsvn_fs_fs/fs_fs.h"
+#include "../../libsvn_fs_fs/id.h"
+#include "../../libsvn_fs_fs/index.h"
+#include "../../libsvn_fs_fs/lock_index.h"
 #include "../../libsvn_fs_fs/low_level.h"
+#include "../../libsvn_fs_fs/mergeinfo_index.h"
 #include "../../libsvn_fs_fs/pack.h"
+#include "../../libsvn_fs_fs/path_index.h"
+#include "../../libsvn_fs_fs/rev_file.h"
+#include "../../libsvn_fs_fs/revprops.h"
 #include "../../libsvn_fs_fs/util.h"
 
 #include "svn_hash.h"
+#include "svn_mergeinfo.h"
 #include "svn_pools.h"
 #include "svn_props.h"
+#include "svn_sorts.h"
 #include "svn_fs.h"
+#include "private/svn_fs_fs_private.h"
+#include "private/svn_mutex.h"
+#include "private/svn_sorts_private.h"
 #include "private/svn_string_private.h"
+#include "private/svn_thread_cond.h"
 
 #include "../svn_test_fs.h"
 
@@ -417,6 +432,67 @@ read_packed_fs(const svn_test_opts_t *opts,
 #undef SHARD_SIZE
 #undef MAX_REV
 
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-read-mapped-packed-fs"
+#define SHARD_SIZE 5
+#define MAX_REV 11
+static svn_error_t *
+read_mapped_packed_fs(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_fs__revision_file_t *rev_file;
+  svn_stream_t *rstream;
+  svn_stringbuf_t *rstring;
+  svn_revnum_t i;
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  /* Same as setting the option in fsfs.conf. */
+  ffd = fs->fsap_data;
+  ffd->mmap_pack_files = TRUE;
+
+  /* Only pack files get mapped. */
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, 1, pool, pool));
+#if APR_HAS_MMAP
+  SVN_TEST_ASSERT(rev_file->mapped_data != NULL);
+#endif
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+  SVN_TEST_ASSERT(rev_file->mapped_data == NULL);
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, MAX_REV, pool,
+                                           pool));
+  SVN_TEST_ASSERT(rev_file->mapped_data == NULL);
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  /* Read the contents through the mapping. */
+  for (i = 1; i < (MAX_REV + 1); i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stringbuf_t *sb;
+
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, pool));
+      SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", pool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, pool));
+
+      if (i == 1)
+        sb = svn_stringbuf_create("This is the file 'iota'.\n", pool);
+      else
+        sb = svn_stringbuf_create(get_rev_contents(i, pool), pool);
+
+      if (! svn_stringbuf_compare(rstring, sb))
+        return svn_error_createf(SVN_ERR_FS_GENERAL, NULL,
+                                 "Bad data in revision %ld.", i);
+    }
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
 /* ------------------------------------------------------------------------ */
 #define REPO_NAME "test-repo-commit-packed-fs"
 #define SHARD_SIZE 5
@@ -1796,7 +1872,7 @@ pack_with_limited_memory(const svn_test_opts_t *opts,
 
       /* Pack it with a narrow memory budget. */
       SVN_ERR(svn_fs_open2(&fs, dir, NULL, iterpool, iterpool));
-      SVN_ERR(svn_fs_fs__pack(fs, max_mem, NULL, NULL, NULL, NULL,
+      SVN_ERR(svn_fs_fs__pack(fs, max_mem, 1, NULL, NULL, NULL, NULL,
                               iterpool));
 
       /* To be sure: Verify that we didn't break the repo. */
@@ -1888,6 +1964,2058 @@ large_delta_against_plain(const svn_test_opts_t *opts,
 
 #undef REPO_NAME
 
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-pack_in_parallel"
+#define SHARD_SIZE 4
+#define MAX_REV 43
+
+static svn_error_t *
+pack_in_parallel(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  struct pack_notify_baton pnb;
+  svn_fs_t *fs;
+  svn_revnum_t min_unpacked;
+  svn_revnum_t i;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* Create the repo and pack it using multiple jobs.  Notifications must
+     still arrive in shard order. */
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                       pool));
+
+  pnb.expected_shard = 0;
+  pnb.expected_action = svn_fs_pack_notify_start;
+  SVN_ERR(svn_fs_pack2(REPO_NAME, 4, pack_notify, &pnb, NULL, NULL, pool));
+  SVN_TEST_ASSERT(pnb.expected_shard == (MAX_REV + 1) / SHARD_SIZE);
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_fs__min_unpacked_rev(&min_unpacked, fs, pool));
+  SVN_TEST_ASSERT(min_unpacked == MAX_REV + 1);
+
+  /* The contents must be the same as after a sequential pack. */
+  for (i = 2; i <= MAX_REV; i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stream_t *rstream;
+      svn_stringbuf_t *rstring;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, iterpool));
+      SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", iterpool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, iterpool));
+      SVN_TEST_STRING_ASSERT(rstring->data, get_rev_contents(i, iterpool));
+    }
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef MAX_REV
+#undef SHARD_SIZE
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-indexed_directory"
+#define DIR_SIZE 2000
+
+static svn_error_t *
+indexed_directory(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  const char *conflict;
+  const svn_fs_id_t *id;
+  node_revision_t *noderev;
+  svn_stream_t *stream;
+  svn_stringbuf_t *contents;
+  apr_hash_t *fs_config = apr_hash_make(pool);
+  apr_hash_t *entries;
+  svn_node_kind_t kind;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_DIR_INDEX_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "directory index not supported by format");
+
+  /* Same as setting the option in fsfs.conf. */
+  ffd->dir_index_min_entries = DIR_SIZE;
+
+  /* Commit a large directory with every other name in use. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_dir(root, "big", pool));
+  for (i = 0; i < DIR_SIZE; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_make_file(root,
+                               apr_psprintf(iterpool, "big/f%05d", i * 2),
+                               iterpool));
+    }
+  SVN_ERR(svn_fs_delete(root, "big/f00100", pool));
+  SVN_ERR(svn_fs_make_dir(root, "big/f00100", pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+
+  /* The directory must have been written with an index. */
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_node_id(&id, root, "big", pool));
+  SVN_ERR(svn_fs_fs__get_node_revision(&noderev, fs, id, pool, pool));
+  SVN_ERR(svn_fs_fs__get_contents(&stream, fs, noderev->data_rep, FALSE,
+                                  pool));
+  SVN_ERR(svn_test__stream_to_string(&contents, stream, pool));
+  SVN_TEST_ASSERT(strstr(contents->data,
+                         "\n" SVN_FS_FS__DIR_INDEX_MARKER " 2000 ") != NULL);
+
+  /* Look up entries with a cold cache, i.e. through the index. */
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  for (i = 0; i <= DIR_SIZE * 2; ++i)
+    {
+      svn_node_kind_t expected = (i % 2 || i == DIR_SIZE * 2)
+                               ? svn_node_none
+                               : (i == 100) ? svn_node_dir : svn_node_file;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_check_path(&kind, root,
+                                apr_psprintf(iterpool, "big/f%05d", i),
+                                iterpool));
+      SVN_TEST_ASSERT(kind == expected);
+    }
+
+  /* Names before the first and after the last entry. */
+  SVN_ERR(svn_fs_check_path(&kind, root, "big/a", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+  SVN_ERR(svn_fs_check_path(&kind, root, "big/z", pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* Reading the whole directory ignores the index. */
+  SVN_ERR(svn_fs_dir_entries(&entries, root, "big", pool));
+  SVN_TEST_ASSERT(apr_hash_count(entries) == DIR_SIZE);
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, rev, NULL, NULL, NULL, NULL,
+                        pool));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef DIR_SIZE
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-group-commit"
+#define COMMIT_COUNT 5
+
+static svn_error_t *
+group_commit(const svn_test_opts_t *opts,
+             apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  const char *conflict;
+  svn_revnum_t rev;
+  svn_revnum_t youngest;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  ffd = fs->fsap_data;
+
+  /* Same as setting the option in fsfs.conf. */
+  ffd->group_commit = TRUE;
+  ffd->flush_to_disk = TRUE;
+
+  /* Every commit must wait for its 'current' update to become durable. */
+  for (i = 1; i <= COMMIT_COUNT; i++)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, i - 1, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      SVN_ERR(svn_fs_make_dir(root, apr_psprintf(iterpool, "d%d", i),
+                              iterpool));
+      SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, iterpool));
+      SVN_TEST_ASSERT(rev == i);
+
+      SVN_TEST_ASSERT(ffd->shared->current_written == i);
+      SVN_TEST_ASSERT(ffd->shared->current_durable == i);
+      SVN_TEST_ASSERT(!ffd->shared->current_flushing);
+    }
+
+  /* The results must be visible to other FS instances. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+  SVN_TEST_ASSERT(youngest == COMMIT_COUNT);
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, youngest, NULL, NULL, NULL, NULL,
+                        pool));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef COMMIT_COUNT
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-rep-cache-front"
+#define FILE_COUNT 200
+
+/* Set *REVISION to the revision that contains the data representation
+   of PATH in ROOT. */
+static svn_error_t *
+get_data_rep_revision(svn_revnum_t *revision,
+                      svn_fs_root_t *root,
+                      const char *path,
+                      apr_pool_t *pool)
+{
+  const svn_fs_id_t *id;
+  node_revision_t *noderev;
+
+  SVN_ERR(svn_fs_node_id(&id, root, path, pool));
+  SVN_ERR(svn_fs_fs__get_node_revision(&noderev, svn_fs_root_fs(root), id,
+                                       pool, pool));
+  *revision = noderev->data_rep->revision;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+rep_cache_front(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_fs_t *fs, *fs2;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  const char *conflict;
+  svn_revnum_t rev, rep_rev, youngest;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_REP_SHARING_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "rep-sharing not supported by format");
+  ffd->rep_sharing_allowed = TRUE;
+
+  /* r1: enough distinct files to make the rep-cache build its filter. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  for (i = 0; i < FILE_COUNT; ++i)
+    {
+      const char *path;
+
+      svn_pool_clear(iterpool);
+      path = apr_psprintf(iterpool, "f%d", i);
+      SVN_ERR(svn_fs_make_file(root, path, iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, path,
+                                          apr_psprintf(iterpool,
+                                                       "contents %d\n", i),
+                                          iterpool));
+    }
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 1);
+
+  /* r2: the same contents again must be shared, new ones must not. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 1, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  for (i = 0; i < FILE_COUNT; ++i)
+    {
+      const char *path;
+
+      svn_pool_clear(iterpool);
+      path = apr_psprintf(iterpool, "g%d", i);
+      SVN_ERR(svn_fs_make_file(root, path, iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, path,
+                                          apr_psprintf(iterpool,
+                                                       "contents %d\n", i),
+                                          iterpool));
+    }
+  SVN_ERR(svn_fs_make_file(root, "new", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "new", "new contents\n", pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 2);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  for (i = 0; i < FILE_COUNT; ++i)
+    {
+      svn_pool_clear(iterpool);
+      SVN_ERR(get_data_rep_revision(&rep_rev, root,
+                                    apr_psprintf(iterpool, "g%d", i),
+                                    iterpool));
+      SVN_TEST_ASSERT(rep_rev == 1);
+    }
+  SVN_ERR(get_data_rep_revision(&rep_rev, root, "new", pool));
+  SVN_TEST_ASSERT(rep_rev == 2);
+
+  /* r3: committed through another FS instance. */
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, NULL, pool, pool));
+  ((fs_fs_data_t *)fs2->fsap_data)->rep_sharing_allowed = TRUE;
+  SVN_ERR(svn_fs_begin_txn(&txn, fs2, 2, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "other", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "other", "other contents\n",
+                                      pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 3);
+
+  /* Once the first instance knows about r3, it must find its reps. */
+  SVN_ERR(svn_fs_youngest_rev(&youngest, fs, pool));
+  SVN_TEST_ASSERT(youngest == 3);
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 3, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "same", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "same", "other contents\n",
+                                      pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 4);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(get_data_rep_revision(&rep_rev, root, "same", pool));
+  SVN_TEST_ASSERT(rep_rev == 3);
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef FILE_COUNT
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-path-index"
+#define SHARD_SIZE 4
+
+/* Verify that svn_fs_fs__path_index_find for PATH in FS, START to END
+   and INCLUDE_DESCENDANTS returns the revisions given as a space-separated
+   list in EXPECTED. */
+static svn_error_t *
+verify_changed_revs(svn_fs_t *fs,
+                    const char *path,
+                    svn_revnum_t start,
+                    svn_revnum_t end,
+                    svn_boolean_t include_descendants,
+                    const char *expected,
+                    apr_pool_t *pool)
+{
+  apr_array_header_t *revisions;
+  svn_stringbuf_t *actual = svn_stringbuf_create_empty(pool);
+  int i;
+
+  SVN_ERR(svn_fs_fs__path_index_find(&revisions, fs, path, start, end,
+                                     include_descendants, NULL, NULL,
+                                     pool, pool));
+  for (i = 0; i < revisions->nelts; ++i)
+    svn_stringbuf_appendcstr(actual,
+                             apr_psprintf(pool, i ? " %ld" : "%ld",
+                                          APR_ARRAY_IDX(revisions, i,
+                                                        svn_revnum_t)));
+
+  SVN_TEST_STRING_ASSERT(actual->data, expected);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+path_index(const svn_test_opts_t *opts,
+           apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  const char *conflict;
+  svn_revnum_t rev;
+
+  /* r1 .. r5, then modify, delete and modify below /A. */
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, 5, SHARD_SIZE,
+                                       pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 5, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(root, "A/B/lambda", "r6\n", pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 6);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 6, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_delete(root, "A/D", pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 7);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 7, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(root, "A/B/E/alpha", "r8\n", pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 8);
+
+  /* Non-packed shards only. */
+  SVN_ERR(verify_changed_revs(fs, "/iota", 0, 8, FALSE, "1 2 3 4 5", pool));
+  SVN_ERR(verify_changed_revs(fs, "A/B", 0, 8, TRUE, "1 6 8", pool));
+
+  /* Pack the first two shards.  r8 remains in a non-packed shard. */
+  SVN_ERR(svn_fs_pack(REPO_NAME, NULL, NULL, NULL, NULL, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_TEST_ASSERT(svn_fs_fs__is_packed_rev(fs, 7));
+  SVN_TEST_ASSERT(!svn_fs_fs__is_packed_rev(fs, 8));
+
+  SVN_ERR(verify_changed_revs(fs, "/iota", 0, 8, FALSE, "1 2 3 4 5", pool));
+  SVN_ERR(verify_changed_revs(fs, "/iota", 3, 4, FALSE, "3 4", pool));
+  SVN_ERR(verify_changed_revs(fs, "/A/B/lambda", 0, 8, FALSE, "1 6", pool));
+  SVN_ERR(verify_changed_revs(fs, "/A/D/G/rho", 0, 8, FALSE, "1 7", pool));
+  SVN_ERR(verify_changed_revs(fs, "/A/B", 0, 8, TRUE, "1 6 8", pool));
+  SVN_ERR(verify_changed_revs(fs, "/A/B/E/alpha", 6, 8, FALSE, "8", pool));
+  SVN_ERR(verify_changed_revs(fs, "/", 0, 8, TRUE, "1 2 3 4 5 6 7 8",
+                              pool));
+  SVN_ERR(verify_changed_revs(fs, "/A/C", 2, 100, TRUE, "", pool));
+
+  /* Without the index, the changes lists must produce the same result. */
+  SVN_ERR(svn_io_remove_file2(svn_dirent_join(svn_fs_fs__path_rev_shard(fs,
+                                                                       8,
+                                                                       pool),
+                                              PATH_CHANGED_PATHS, pool),
+                              FALSE, pool));
+  SVN_ERR(svn_io_remove_file2(svn_fs_fs__path_rev_packed(fs, 4,
+                                                         PATH_CHANGED_PATHS,
+                                                         pool),
+                              FALSE, pool));
+  SVN_ERR(verify_changed_revs(fs, "/A/B", 0, 8, TRUE, "1 6 8", pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-revprop-generations"
+#define SHARD_SIZE 4
+#define MAX_REV 9
+
+/* Verify that the svn:log of REV in PROPLISTS, which starts at START,
+   is EXPECTED.  NULL means "no svn:log". */
+static svn_error_t *
+verify_log(apr_array_header_t *proplists,
+           svn_revnum_t start,
+           svn_revnum_t rev,
+           const char *expected)
+{
+  apr_hash_t *proplist = APR_ARRAY_IDX(proplists, rev - start, apr_hash_t *);
+  svn_string_t *log = svn_hash_gets(proplist, SVN_PROP_REVISION_LOG);
+
+  SVN_TEST_STRING_ASSERT(log ? log->data : NULL, expected);
+  SVN_TEST_ASSERT(svn_hash_gets(proplist, SVN_PROP_REVISION_DATE));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+revprop_generations(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs, *fs2;
+  apr_array_header_t *proplists;
+  svn_stringbuf_t *generations;
+  const svn_string_t *new_log = svn_string_create("changed", pool);
+  const char *path;
+
+  /* r1 .. r7 are in packed shards, r8 and r9 are not. */
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_open2(&fs2, REPO_NAME, NULL, pool, pool));
+  path = svn_fs_fs__path_revprop_generations(fs, pool);
+
+  /* Bulk read across pack and shard boundaries. */
+  SVN_ERR(svn_fs_fs__get_revision_proplists(&proplists, fs, 0, MAX_REV,
+                                            pool, pool));
+  SVN_TEST_ASSERT(proplists->nelts == MAX_REV + 1);
+  SVN_ERR(verify_log(proplists, 0, 1, R1_LOG_MSG));
+  SVN_ERR(verify_log(proplists, 0, 5, NULL));
+  SVN_ERR(verify_log(proplists, 0, 9, NULL));
+
+  /* Only setting r0's date at creation time changed any revprops. */
+  SVN_ERR(svn_stringbuf_from_file2(&generations, path, pool));
+  SVN_TEST_STRING_ASSERT(generations->data, "0\n0 1\n");
+
+  /* Modify a packed and a non-packed revprop through the other instance. */
+  SVN_ERR(svn_fs_change_rev_prop2(fs2, 5, SVN_PROP_REVISION_LOG, NULL,
+                                  new_log, pool));
+  SVN_ERR(svn_fs_change_rev_prop2(fs2, 9, SVN_PROP_REVISION_LOG, NULL,
+                                  new_log, pool));
+  SVN_ERR(svn_stringbuf_from_file2(&generations, path, pool));
+  SVN_TEST_STRING_ASSERT(generations->data, "0\n0 1\n1 1\n2 1\n");
+
+  /* The first instance must see the changes after a refresh. */
+  SVN_ERR(svn_fs_refresh_revision_props(fs, pool));
+  SVN_ERR(svn_fs_fs__get_revision_proplists(&proplists, fs, 1, MAX_REV,
+                                            pool, pool));
+  SVN_ERR(verify_log(proplists, 1, 1, R1_LOG_MSG));
+  SVN_ERR(verify_log(proplists, 1, 4, NULL));
+  SVN_ERR(verify_log(proplists, 1, 5, "changed"));
+  SVN_ERR(verify_log(proplists, 1, 9, "changed"));
+
+  /* A new epoch resets all generations. */
+  SVN_ERR(svn_fs_fs__invalidate_revprop_generations(fs2, pool));
+  SVN_ERR(svn_stringbuf_from_file2(&generations, path, pool));
+  SVN_TEST_ASSERT(strchr(generations->data, ' ') == NULL);
+  SVN_TEST_ASSERT(strcmp(generations->data, "0\n") != 0);
+
+  SVN_ERR(svn_fs_refresh_revision_props(fs, pool));
+  SVN_ERR(svn_fs_fs__get_revision_proplists(&proplists, fs, 5, 5,
+                                            pool, pool));
+  SVN_ERR(verify_log(proplists, 5, 5, "changed"));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+
+#define REPO_NAME "test-repo-packed-changes"
+#define CHANGE_COUNT 250
+
+/* Add a change for PATH, of kind CHANGE_KIND and with node ID_STR (may be
+   NULL) to CHANGES.  If COPYFROM_PATH is not NULL, set COPYFROM_REV as
+   well.  Allocate everything in POOL. */
+static svn_error_t *
+add_change(apr_hash_t *changes,
+           const char *path,
+           const char *id_str,
+           svn_fs_path_change_kind_t change_kind,
+           svn_tristate_t mergeinfo_mod,
+           svn_revnum_t copyfrom_rev,
+           const char *copyfrom_path,
+           apr_pool_t *pool)
+{
+  const svn_fs_id_t *id = NULL;
+  svn_fs_path_change2_t *change;
+
+  if (id_str)
+    SVN_ERR(svn_fs_fs__id_parse(&id, apr_pstrdup(pool, id_str), pool));
+
+  change = svn_fs_path_change2_create(id, change_kind, pool);
+  change->node_kind = svn_node_file;
+  change->text_mod = change_kind == svn_fs_path_change_modify;
+  change->mergeinfo_mod = mergeinfo_mod;
+  change->copyfrom_rev = copyfrom_rev;
+  change->copyfrom_path = copyfrom_path;
+  svn_hash_sets(changes, path, change);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+packed_changes(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_fs_root_t *rev_root;
+  svn_revnum_t rev;
+  const char *conflict;
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+  apr_hash_t *changes = apr_hash_make(pool);
+  apr_array_header_t *read_changes;
+  svn_stringbuf_t *buffer = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream;
+  svn_boolean_t eol;
+  change_t *entry;
+  int count;
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  /* Round-trip all kinds of entries, including txn IDs and resets. */
+  SVN_ERR(add_change(changes, "/a", "0.0.r1/2", svn_fs_path_change_modify,
+                     svn_tristate_unknown, SVN_INVALID_REVNUM, NULL, pool));
+  SVN_ERR(add_change(changes, "/b", "_1.0.t5-7", svn_fs_path_change_add,
+                     svn_tristate_true, 3, "/a", pool));
+  SVN_ERR(add_change(changes, "/c", NULL, svn_fs_path_change_reset,
+                     svn_tristate_false, SVN_INVALID_REVNUM, NULL, pool));
+
+  SVN_ERR(svn_fs_fs__write_packed_changes(svn_stream_from_stringbuf(buffer,
+                                                                    pool),
+                                          changes, pool));
+  SVN_ERR(svn_fs_fs__read_changes(&read_changes, &eol,
+                                  svn_stream_from_stringbuf(buffer, pool),
+                                  1, pool, pool));
+  SVN_TEST_ASSERT(eol);
+  SVN_TEST_ASSERT(read_changes->nelts == 3);
+
+  entry = APR_ARRAY_IDX(read_changes, 0, change_t *);
+  SVN_TEST_STRING_ASSERT(entry->path.data, "/a");
+  SVN_TEST_STRING_ASSERT(svn_fs_fs__id_unparse(entry->info.node_rev_id,
+                                               pool)->data, "0.0.r1/2");
+  SVN_TEST_ASSERT(entry->info.change_kind == svn_fs_path_change_modify);
+  SVN_TEST_ASSERT(entry->info.node_kind == svn_node_file);
+  SVN_TEST_ASSERT(entry->info.text_mod && !entry->info.prop_mod);
+  SVN_TEST_ASSERT(entry->info.mergeinfo_mod == svn_tristate_unknown);
+  SVN_TEST_ASSERT(!SVN_IS_VALID_REVNUM(entry->info.copyfrom_rev));
+
+  entry = APR_ARRAY_IDX(read_changes, 1, change_t *);
+  SVN_TEST_STRING_ASSERT(entry->path.data, "/b");
+  SVN_TEST_STRING_ASSERT(svn_fs_fs__id_unparse(entry->info.node_rev_id,
+                                               pool)->data, "_1.0.t5-7");
+  SVN_TEST_ASSERT(entry->info.change_kind == svn_fs_path_change_add);
+  SVN_TEST_ASSERT(entry->info.mergeinfo_mod == svn_tristate_true);
+  SVN_TEST_ASSERT(entry->info.copyfrom_rev == 3);
+  SVN_TEST_STRING_ASSERT(entry->info.copyfrom_path, "/a");
+
+  entry = APR_ARRAY_IDX(read_changes, 2, change_t *);
+  SVN_TEST_STRING_ASSERT(entry->path.data, "/c");
+  SVN_TEST_ASSERT(entry->info.node_rev_id == NULL);
+  SVN_TEST_ASSERT(entry->info.change_kind == svn_fs_path_change_reset);
+  SVN_TEST_ASSERT(entry->info.mergeinfo_mod == svn_tristate_false);
+
+  /* Large lists get split into chunks that can be read individually. */
+  changes = apr_hash_make(pool);
+  for (i = 0; i < CHANGE_COUNT; ++i)
+    SVN_ERR(add_change(changes, apr_psprintf(pool, "/f%03d", i), "0.0.r1/2",
+                       svn_fs_path_change_add, svn_tristate_unknown,
+                       SVN_INVALID_REVNUM, NULL, pool));
+
+  svn_stringbuf_setempty(buffer);
+  stream = svn_stream_from_stringbuf(buffer, pool);
+  SVN_ERR(svn_fs_fs__write_packed_changes(stream, changes, pool));
+  for (i = 0; i < CHANGE_COUNT; i += SVN_FS_FS__CHANGES_BLOCK_SIZE)
+    {
+      SVN_ERR(svn_fs_fs__read_changes(&read_changes, &eol, stream,
+                                      SVN_FS_FS__CHANGES_BLOCK_SIZE,
+                                      pool, pool));
+      SVN_TEST_ASSERT(read_changes->nelts
+                      == MIN(SVN_FS_FS__CHANGES_BLOCK_SIZE,
+                             CHANGE_COUNT - i));
+      SVN_TEST_ASSERT(eol == (read_changes->nelts
+                              < SVN_FS_FS__CHANGES_BLOCK_SIZE));
+
+      entry = APR_ARRAY_IDX(read_changes, 0, change_t *);
+      SVN_TEST_STRING_ASSERT(entry->path.data,
+                             apr_psprintf(pool, "/f%03d", i));
+    }
+
+  /* Now, commit a list larger than a changes cache block. */
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, 1, 4, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  ffd = fs->fsap_data;
+  if (ffd->format < SVN_FS_FS__MIN_PACKED_CHANGES_FORMAT)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "packed changes not supported by format");
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 1, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_delete(root, "iota", pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, 1, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A", root, "A2", pool));
+  for (i = 0; i < CHANGE_COUNT; ++i)
+    SVN_ERR(svn_fs_make_file(root, apr_psprintf(pool, "f%03d", i), pool));
+  SVN_ERR(svn_fs_commit_txn(&conflict, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 2);
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_revision_root(&root, fs, 2, pool));
+  SVN_ERR(svn_fs_paths_changed3(&iterator, root, pool, pool));
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  for (count = 0; change; ++count)
+    {
+      if (strcmp(change->path.data, "/iota") == 0)
+        {
+          SVN_TEST_ASSERT(change->change_kind == svn_fs_path_change_delete);
+        }
+      else if (strcmp(change->path.data, "/A2") == 0)
+        {
+          SVN_TEST_ASSERT(change->change_kind == svn_fs_path_change_add);
+          SVN_TEST_ASSERT(change->node_kind == svn_node_dir);
+          SVN_TEST_ASSERT(change->copyfrom_rev == 1);
+          SVN_TEST_STRING_ASSERT(change->copyfrom_path, "/A");
+        }
+      else
+        {
+          SVN_TEST_ASSERT(change->change_kind == svn_fs_path_change_add);
+          SVN_TEST_ASSERT(change->node_kind == svn_node_file);
+          SVN_TEST_ASSERT(!SVN_IS_VALID_REVNUM(change->copyfrom_rev));
+        }
+
+      SVN_ERR(svn_fs_path_change_get(&change, iterator));
+    }
+
+  SVN_TEST_ASSERT(count == CHANGE_COUNT + 2);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef CHANGE_COUNT
+
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-parallel-stats"
+#define SHARD_SIZE 4
+#define MAX_REV 13
+
+/* Return TRUE if the histograms LHS and RHS are identical. */
+static svn_boolean_t
+same_histogram(const svn_fs_fs__histogram_t *lhs,
+               const svn_fs_fs__histogram_t *rhs)
+{
+  return memcmp(lhs, rhs, sizeof(*lhs)) == 0;
+}
+
+static svn_error_t *
+parallel_stats(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_fs__stats_t *expected;
+  svn_fs_fs__stats_t *actual;
+  apr_size_t i;
+
+  /* Three packed shards followed by two non-packed revisions. */
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  SVN_ERR(svn_fs_fs__get_stats(&expected, fs, NULL, NULL, 1, 1, NULL, NULL,
+                               pool, pool));
+  SVN_TEST_ASSERT(expected->revision_count == MAX_REV + 1);
+  SVN_TEST_ASSERT(expected->scanned_revision_count == MAX_REV + 1);
+
+  /* Concurrent scans must produce the same results. */
+  SVN_ERR(svn_fs_fs__get_stats(&actual, fs, NULL, NULL, 3, 1, NULL, NULL,
+                               pool, pool));
+  SVN_TEST_ASSERT(actual->revision_count == expected->revision_count);
+  SVN_TEST_ASSERT(actual->scanned_revision_count
+                  == expected->scanned_revision_count);
+  SVN_TEST_ASSERT(actual->total_size == expected->total_size);
+  SVN_TEST_ASSERT(actual->change_count == expected->change_count);
+  SVN_TEST_ASSERT(actual->change_len == expected->change_len);
+
+  SVN_TEST_ASSERT(!memcmp(&actual->total_rep_stats,
+                          &expected->total_rep_stats,
+                          sizeof(actual->total_rep_stats)));
+  SVN_TEST_ASSERT(!memcmp(&actual->file_rep_stats,
+                          &expected->file_rep_stats,
+                          sizeof(actual->file_rep_stats)));
+  SVN_TEST_ASSERT(!memcmp(&actual->dir_rep_stats,
+                          &expected->dir_rep_stats,
+                          sizeof(actual->dir_rep_stats)));
+  SVN_TEST_ASSERT(!memcmp(&actual->total_node_stats,
+                          &expected->total_node_stats,
+                          sizeof(actual->total_node_stats)));
+
+  SVN_TEST_ASSERT(same_histogram(&actual->rep_size_histogram,
+                                 &expected->rep_size_histogram));
+  SVN_TEST_ASSERT(same_histogram(&actual->node_size_histogram,
+                                 &expected->node_size_histogram));
+  SVN_TEST_ASSERT(same_histogram(&actual->added_rep_size_histogram,
+                                 &expected->added_rep_size_histogram));
+  SVN_TEST_ASSERT(same_histogram(&actual->file_histogram,
+                                 &expected->file_histogram));
+  SVN_TEST_ASSERT(same_histogram(&actual->dir_rep_histogram,
+                                 &expected->dir_rep_histogram));
+  SVN_TEST_ASSERT(apr_hash_count(actual->by_extension)
+                  == apr_hash_count(expected->by_extension));
+
+  /* Entries of equal size may be listed in a different order. */
+  for (i = 0; i < expected->largest_changes->count; ++i)
+    SVN_TEST_ASSERT(actual->largest_changes->changes[i]->size
+                    == expected->largest_changes->changes[i]->size);
+
+  /* Sampling every other shard scans r0..3 and r8..11 only but still
+   * reports figures for the whole repository. */
+  SVN_ERR(svn_fs_fs__get_stats(&actual, fs, NULL, NULL, 2, 2, NULL, NULL,
+                               pool, pool));
+  SVN_TEST_ASSERT(actual->revision_count == MAX_REV + 1);
+  SVN_TEST_ASSERT(actual->scanned_revision_count == 2 * SHARD_SIZE);
+  SVN_TEST_ASSERT(actual->total_size > 0);
+  SVN_TEST_ASSERT(actual->change_count > 0);
+  SVN_TEST_ASSERT(actual->total_rep_stats.total.count > 0);
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-composed_delta_windows"
+#define FILE_SIZE 300000
+#define MAX_REV 5
+
+/* Read the contents of FILE_PATH in REVISION of FS and compare them with
+ * EXPECTED.  Also read a few bytes from the middle of the last window. */
+static svn_error_t *
+verify_delta_chain_contents(svn_fs_t *fs,
+                            svn_revnum_t revision,
+                            const char *file_path,
+                            const svn_stringbuf_t *expected,
+                            apr_pool_t *pool)
+{
+  svn_fs_root_t *root;
+  svn_stream_t *stream;
+  svn_stringbuf_t *actual;
+  char buffer[1000];
+  apr_size_t len = sizeof(buffer);
+  const apr_size_t offset = FILE_SIZE - 2 * sizeof(buffer);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, revision, pool));
+
+  SVN_ERR(svn_fs_file_contents(&stream, root, file_path, pool));
+  SVN_ERR(svn_stream_skip(stream, offset));
+  SVN_ERR(svn_stream_read_full(stream, buffer, &len));
+  SVN_ERR(svn_stream_close(stream));
+  SVN_TEST_ASSERT(len == sizeof(buffer));
+  SVN_TEST_ASSERT(!memcmp(buffer, expected->data + offset, len));
+
+  SVN_ERR(svn_fs_file_contents(&stream, root, file_path, pool));
+  SVN_ERR(svn_stringbuf_from_stream(&actual, stream, FILE_SIZE, pool));
+  SVN_TEST_STRING_ASSERT(actual->data, expected->data);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+composed_delta_windows(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *contents;
+  apr_hash_t *fs_config;
+  apr_uint32_t seed = 0;
+  apr_size_t i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* Pseudo-random text that spans several svndiff windows. */
+  contents = svn_stringbuf_create_ensure(FILE_SIZE, pool);
+  for (i = 0; i < FILE_SIZE; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      svn_stringbuf_appendbyte(contents, (char)('a' + (seed >> 16) % 26));
+    }
+
+  /* Build a delta chain with changes in every window. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  for (rev = 0; rev < MAX_REV; )
+    {
+      apr_pool_t *iterpool = svn_pool_create(pool);
+
+      for (i = rev * 7; i < FILE_SIZE; i += 20000)
+        contents->data[i] = (char)('0' + rev);
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      if (rev == 0)
+        SVN_ERR(svn_fs_make_file(root, "foo", iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, "foo", contents->data,
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+
+      svn_pool_destroy(iterpool);
+    }
+
+  /* Read the head contents without the fulltext cache, such that the
+   * windows have to be combined.  The second instance will find the
+   * composed windows in the shared cache. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_FULLTEXTS, "0");
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_DELTAS, "1");
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  SVN_ERR(verify_delta_chain_contents(fs, MAX_REV, "foo", contents, pool));
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  SVN_ERR(verify_delta_chain_contents(fs, MAX_REV, "foo", contents, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef FILE_SIZE
+#undef MAX_REV
+
+#define REPO_NAME "test-repo-random_access_reads"
+#define FILE_SIZE 350000
+#define MAX_REV 6
+
+/* Read up to 1000 bytes at OFFSET from FILE_PATH in REVISION of FS and
+ * compare them with EXPECTED.  Then skip into the next window on the same
+ * stream and compare again. */
+static svn_error_t *
+verify_random_access(svn_fs_t *fs,
+                     svn_revnum_t revision,
+                     const char *file_path,
+                     const svn_stringbuf_t *expected,
+                     svn_filesize_t offset,
+                     apr_pool_t *pool)
+{
+  svn_fs_root_t *root;
+  svn_stream_t *stream;
+  char buffer[1000];
+  apr_size_t len;
+  int i;
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, revision, pool));
+  SVN_ERR(svn_fs_file_contents_at(&stream, root, file_path, offset, pool));
+
+  for (i = 0; i < 2; ++i)
+    {
+      apr_size_t expected_len = offset >= (svn_filesize_t)expected->len
+                              ? 0
+                              : MIN(sizeof(buffer),
+                                    expected->len - (apr_size_t)offset);
+
+      len = sizeof(buffer);
+      SVN_ERR(svn_stream_read_full(stream, buffer, &len));
+      SVN_TEST_ASSERT(len == expected_len);
+      SVN_TEST_ASSERT(!len || !memcmp(buffer, expected->data + offset, len));
+
+      SVN_ERR(svn_stream_skip(stream, 120000));
+      offset += len + 120000;
+    }
+
+  return svn_error_trace(svn_stream_close(stream));
+}
+
+static svn_error_t *
+random_access_reads(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *contents;
+  apr_hash_t *fs_config;
+  apr_uint32_t seed = 0;
+  apr_size_t i;
+  /* Include offsets next to the 100kB svndiff window boundaries. */
+  const svn_filesize_t offsets[] = { 0, 1, 50000, 102399, 102400,
+                                     204807, FILE_SIZE - 10, FILE_SIZE,
+                                     FILE_SIZE + 10 };
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* Pseudo-random text that spans several svndiff windows. */
+  contents = svn_stringbuf_create_ensure(FILE_SIZE, pool);
+  for (i = 0; i < FILE_SIZE; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      svn_stringbuf_appendbyte(contents, (char)('a' + (seed >> 16) % 26));
+    }
+
+  /* Build a delta chain with changes in every window. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  for (rev = 0; rev < MAX_REV; )
+    {
+      apr_pool_t *iterpool = svn_pool_create(pool);
+
+      for (i = rev * 11; i < FILE_SIZE; i += 30000)
+        contents->data[i] = (char)('0' + rev);
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, iterpool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, iterpool));
+      if (rev == 0)
+        SVN_ERR(svn_fs_make_file(root, "foo", iterpool));
+      SVN_ERR(svn_test__set_file_contents(root, "foo", contents->data,
+                                          iterpool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, iterpool));
+
+      svn_pool_destroy(iterpool);
+    }
+
+  /* Without the fulltext cache, every read has to seek in the window
+   * stream.  With it, the full read will populate that cache first. */
+  fs_config = apr_hash_make(pool);
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_NS,
+                svn_uuid_generate(pool));
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_FULLTEXTS, "0");
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  for (i = 0; i < sizeof(offsets) / sizeof(offsets[0]); ++i)
+    SVN_ERR(verify_random_access(fs, MAX_REV, "foo", contents, offsets[i],
+                                 pool));
+
+  svn_hash_sets(fs_config, SVN_FS_CONFIG_FSFS_CACHE_FULLTEXTS, "1");
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, fs_config, pool, pool));
+  SVN_ERR(verify_delta_chain_contents(fs, MAX_REV, "foo", contents, pool));
+  for (i = 0; i < sizeof(offsets) / sizeof(offsets[0]); ++i)
+    SVN_ERR(verify_random_access(fs, MAX_REV, "foo", contents, offsets[i],
+                                 pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef FILE_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-mergeinfo-index"
+
+/* Implements svn_fs_mergeinfo_receiver_t.  Add MERGEINFO of PATH to the
+   apr_hash_t * BATON, mapping PATH to the mergeinfo string. */
+static svn_error_t *
+collect_mergeinfo(const char *path,
+                  svn_mergeinfo_t mergeinfo,
+                  void *baton,
+                  apr_pool_t *scratch_pool)
+{
+  apr_hash_t *catalog = baton;
+  apr_pool_t *pool = apr_hash_pool_get(catalog);
+  svn_string_t *mergeinfo_string;
+
+  SVN_ERR(svn_mergeinfo_to_string(&mergeinfo_string, mergeinfo, pool));
+  svn_hash_sets(catalog, apr_pstrdup(pool, path), mergeinfo_string->data);
+
+  return SVN_NO_ERROR;
+}
+
+/* Verify that the mergeinfo of "/" and its descendants in REV of FS is
+   EXPECTED, given as "PATH MERGEINFO" lines sorted by path. */
+static svn_error_t *
+verify_mergeinfo(svn_fs_t *fs,
+                 svn_revnum_t rev,
+                 const char *expected,
+                 apr_pool_t *pool)
+{
+  svn_fs_root_t *root;
+  apr_array_header_t *paths = apr_array_make(pool, 1, sizeof(const char *));
+  apr_hash_t *catalog = apr_hash_make(pool);
+  apr_array_header_t *sorted;
+  svn_stringbuf_t *actual = svn_stringbuf_create_empty(pool);
+  int i;
+
+  APR_ARRAY_PUSH(paths, const char *) = "/";
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_fs_get_mergeinfo3(root, paths, svn_mergeinfo_explicit, TRUE,
+                                FALSE, collect_mergeinfo, catalog, pool));
+
+  sorted = svn_sort__hash(catalog, svn_sort_compare_items_as_paths, pool);
+  for (i = 0; i < sorted->nelts; ++i)
+    {
+      svn_sort__item_t *item = &APR_ARRAY_IDX(sorted, i, svn_sort__item_t);
+      svn_stringbuf_appendcstr(actual,
+                               apr_psprintf(pool, "%s %s\n",
+                                            (const char *)item->key,
+                                            (const char *)item->value));
+    }
+
+  SVN_TEST_STRING_ASSERT(actual->data, expected);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+mergeinfo_index(const svn_test_opts_t *opts,
+                apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root, *rev_root;
+  svn_revnum_t rev;
+  apr_hash_t *catalog;
+  svn_boolean_t missing;
+  const char *index_path;
+  svn_node_kind_t kind;
+
+  /* The index only exists for FSFS with mergeinfo support. */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+  if (opts->server_minor_version && (opts->server_minor_version < 5))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* A new repository gets the index with r1. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  index_path = svn_dirent_join(REPO_NAME, MERGEINFO_INDEX_DB_NAME, pool);
+  SVN_ERR(svn_io_check_path(index_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  /* r2: add mergeinfo. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 1, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "A/B", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/branch:1", pool),
+                                  pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "A/D/G", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/branch:2", pool),
+                                  pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 2);
+
+  /* r3: copy it along with its parent. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 2, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_revision_root(&rev_root, fs, 2, pool));
+  SVN_ERR(svn_fs_copy(rev_root, "A", root, "A2", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 3);
+
+  /* r4: change some mergeinfo and delete some. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 3, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "A/B", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/branch:1-3", pool),
+                                  pool));
+  SVN_ERR(svn_fs_delete(root, "A/D", pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "A2/D/G", SVN_PROP_MERGEINFO, NULL,
+                                  pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 4);
+
+  /* All revisions are covered by the index. */
+  SVN_ERR(svn_fs_fs__mergeinfo_index_find(&catalog, &missing, fs, 4, "/A",
+                                          pool, pool));
+  SVN_TEST_ASSERT(catalog && !missing);
+  SVN_TEST_ASSERT(apr_hash_count(catalog) == 1);
+
+  SVN_ERR(verify_mergeinfo(fs, 1, "", pool));
+  SVN_ERR(verify_mergeinfo(fs, 2,
+                           "/A/B /branch:1\n"
+                           "/A/D/G /branch:2\n", pool));
+  SVN_ERR(verify_mergeinfo(fs, 3,
+                           "/A/B /branch:1\n"
+                           "/A/D/G /branch:2\n"
+                           "/A2/B /branch:1\n"
+                           "/A2/D/G /branch:2\n", pool));
+  SVN_ERR(verify_mergeinfo(fs, 4,
+                           "/A/B /branch:1-3\n"
+                           "/A2/B /branch:1\n", pool));
+
+  /* Without the index, commits don't create it ... */
+  SVN_ERR(svn_io_remove_file2(index_path, FALSE, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 4, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "A2", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/branch:4", pool),
+                                  pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 5);
+
+  SVN_ERR(svn_io_check_path(index_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* ... but crawling the youngest revision does. */
+  SVN_ERR(verify_mergeinfo(fs, 5,
+                           "/A/B /branch:1-3\n"
+                           "/A2 /branch:4\n"
+                           "/A2/B /branch:1\n", pool));
+  SVN_ERR(svn_io_check_path(index_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  /* From then on, commits extend it. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 5, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_change_node_prop(root, "A2/B", SVN_PROP_MERGEINFO,
+                                  svn_string_create("/branch:1,5", pool),
+                                  pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 6);
+
+  SVN_ERR(svn_fs_fs__mergeinfo_index_find(&catalog, &missing, fs, 4, "/",
+                                          pool, pool));
+  SVN_TEST_ASSERT(!catalog && !missing);
+  SVN_ERR(svn_fs_fs__mergeinfo_index_find(&catalog, &missing, fs, 6, "/",
+                                          pool, pool));
+  SVN_TEST_ASSERT(catalog);
+  SVN_TEST_STRING_ASSERT(((svn_string_t *)svn_hash_gets(catalog,
+                                                        "/A2/B"))->data,
+                         "/branch:1,5");
+
+  SVN_ERR(verify_mergeinfo(fs, 4,
+                           "/A/B /branch:1-3\n"
+                           "/A2/B /branch:1\n", pool));
+  SVN_ERR(verify_mergeinfo(fs, 6,
+                           "/A/B /branch:1-3\n"
+                           "/A2 /branch:4\n"
+                           "/A2/B /branch:1,5\n", pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-lock-index"
+
+/* Implements svn_fs_get_locks_callback_t.  Add the path of LOCK to the
+   apr_array_header_t * BATON. */
+static svn_error_t *
+collect_lock_paths(void *baton,
+                   svn_lock_t *lock,
+                   apr_pool_t *pool)
+{
+  apr_array_header_t *paths = baton;
+
+  APR_ARRAY_PUSH(paths, const char *) = apr_pstrdup(paths->pool, lock->path);
+  return SVN_NO_ERROR;
+}
+
+/* Verify that the locks at and below PATH in FS up to DEPTH are on the
+   paths in EXPECTED, given as sorted lines. */
+static svn_error_t *
+verify_locks(svn_fs_t *fs,
+             const char *path,
+             svn_depth_t depth,
+             const char *expected,
+             apr_pool_t *pool)
+{
+  apr_array_header_t *paths = apr_array_make(pool, 4, sizeof(const char *));
+  svn_stringbuf_t *actual = svn_stringbuf_create_empty(pool);
+  int i;
+
+  SVN_ERR(svn_fs_get_locks2(fs, path, depth, collect_lock_paths, paths,
+                            pool));
+
+  svn_sort__array(paths, svn_sort_compare_paths);
+  for (i = 0; i < paths->nelts; ++i)
+    svn_stringbuf_appendcstr(actual,
+                             apr_psprintf(pool, "%s\n",
+                                          APR_ARRAY_IDX(paths, i,
+                                                        const char *)));
+
+  SVN_TEST_STRING_ASSERT(actual->data, expected);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+lock_index(const svn_test_opts_t *opts,
+           apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_fs_access_t *access;
+  svn_revnum_t rev;
+  svn_lock_t *lock;
+  apr_array_header_t *locks;
+  const char *index_path;
+  svn_node_kind_t kind;
+
+  /* The index only exists for FSFS. */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_ERR(svn_fs_create_access(&access, "artist", pool));
+  SVN_ERR(svn_fs_set_access(fs, access));
+
+  /* Without locks, there is no index. */
+  index_path = svn_dirent_join(REPO_NAME, LOCK_INDEX_DB_NAME, pool);
+  SVN_ERR(verify_locks(fs, "/", svn_depth_infinity, "", pool));
+  SVN_ERR(svn_io_check_path(index_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* The first lock creates it. */
+  SVN_ERR(svn_fs_lock(&lock, fs, "/iota", NULL, "", FALSE, 0, rev, FALSE,
+                      pool));
+  SVN_ERR(svn_fs_lock(&lock, fs, "/A/mu", NULL, "", FALSE, 0, rev, FALSE,
+                      pool));
+  SVN_ERR(svn_fs_lock(&lock, fs, "/A/D/G/pi", NULL, "", FALSE, 0, rev,
+                      FALSE, pool));
+  SVN_ERR(svn_fs_lock(&lock, fs, "/A/D/G/rho", NULL, "", FALSE, 0, rev,
+                      FALSE, pool));
+  SVN_ERR(svn_io_check_path(index_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_file);
+
+  SVN_ERR(svn_fs_fs__lock_index_find(&locks, fs, "/A/D", TRUE, pool, pool));
+  SVN_TEST_ASSERT(locks && locks->nelts == 2);
+  SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(locks, 1, svn_lock_t *)->token,
+                         lock->token);
+  SVN_ERR(svn_fs_fs__lock_index_find(&locks, fs, "/A/D", FALSE, pool, pool));
+  SVN_TEST_ASSERT(locks && locks->nelts == 0);
+
+  SVN_ERR(verify_locks(fs, "/", svn_depth_infinity,
+                       "/A/D/G/pi\n"
+                       "/A/D/G/rho\n"
+                       "/A/mu\n"
+                       "/iota\n", pool));
+  SVN_ERR(verify_locks(fs, "/A", svn_depth_immediates, "/A/mu\n", pool));
+  SVN_ERR(verify_locks(fs, "/A/D/G/pi", svn_depth_empty, "/A/D/G/pi\n",
+                       pool));
+
+  /* Unlocking updates the index. */
+  SVN_ERR(svn_fs_unlock(fs, "/A/D/G/rho", lock->token, FALSE, pool));
+  SVN_ERR(verify_locks(fs, "/A/D", svn_depth_infinity, "/A/D/G/pi\n",
+                       pool));
+
+  /* Commits find the locks below deleted paths in the index. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_delete(root, "A/D", pool));
+  SVN_TEST_ASSERT_ERROR(svn_fs_commit_txn(NULL, &rev, txn, pool),
+                        SVN_ERR_FS_BAD_LOCK_TOKEN);
+  SVN_ERR(svn_fs_abort_txn(txn, pool));
+
+  /* Without the index, readers fall back to the digest files ... */
+  SVN_ERR(svn_io_remove_file2(index_path, FALSE, pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_set_access(fs, access));
+  SVN_ERR(verify_locks(fs, "/", svn_depth_infinity,
+                       "/A/D/G/pi\n"
+                       "/A/mu\n"
+                       "/iota\n", pool));
+  SVN_ERR(svn_io_check_path(index_path, &kind, pool));
+  SVN_TEST_ASSERT(kind == svn_node_none);
+
+  /* ... and writers rebuild it. */
+  SVN_ERR(svn_fs_lock(&lock, fs, "/A/D/G/rho", NULL, "", FALSE, 0, rev,
+                      FALSE, pool));
+  SVN_ERR(svn_fs_fs__lock_index_find(&locks, fs, "/", TRUE, pool, pool));
+  SVN_TEST_ASSERT(locks && locks->nelts == 4);
+  SVN_ERR(verify_locks(fs, "/A/D", svn_depth_infinity,
+                       "/A/D/G/pi\n"
+                       "/A/D/G/rho\n", pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-delta_passthrough"
+#define FILE_SIZE 250000
+
+/* Check that "foo" in REVISION of FS has the EXPECTED contents. */
+static svn_error_t *
+verify_foo_contents(svn_fs_t *fs,
+                    svn_revnum_t revision,
+                    const svn_stringbuf_t *expected,
+                    apr_pool_t *pool)
+{
+  svn_fs_root_t *root;
+  svn_stringbuf_t *actual;
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, revision, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "foo", &actual, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(expected, actual));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+delta_passthrough(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *old_contents, *contents;
+  svn_txdelta_stream_t *delta;
+  svn_txdelta_window_handler_t handler;
+  void *handler_baton;
+  svn_txdelta_window_t window = { 0 };
+  svn_txdelta_op_t op = { 0 };
+  apr_uint32_t seed = 0;
+  apr_size_t i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* Pseudo-random text that spans several svndiff windows. */
+  contents = svn_stringbuf_create_ensure(FILE_SIZE, pool);
+  for (i = 0; i < FILE_SIZE; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      svn_stringbuf_appendbyte(contents, (char)('a' + (seed >> 16) % 26));
+    }
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "foo", pool));
+  SVN_ERR(svn_test__set_file_contents(root, "foo", contents->data, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  /* r2: A regular delta against the previous contents, as found in dump
+   * files with deltas. */
+  old_contents = svn_stringbuf_dup(contents, pool);
+  for (i = 0; i < FILE_SIZE; i += 30000)
+    contents->data[i] = '!';
+  svn_stringbuf_appendcstr(contents, "tail");
+
+  svn_txdelta2(&delta,
+               svn_stream_from_stringbuf(old_contents, pool),
+               svn_stream_from_stringbuf(contents, pool),
+               FALSE, pool);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_apply_textdelta(&handler, &handler_baton, root, "foo",
+                                 NULL, NULL, pool));
+  SVN_ERR(svn_txdelta_send_txstream(delta, handler, handler_baton, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  SVN_ERR(verify_foo_contents(fs, rev, contents, pool));
+
+  /* r3: A short window followed by another one.  Such a delta cannot be
+   * stored as-is and must be converted on the fly. */
+  old_contents = contents;
+  contents = svn_stringbuf_ncreate(old_contents->data, 1000, pool);
+  svn_stringbuf_appendcstr(contents, "hello");
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_apply_textdelta(&handler, &handler_baton, root, "foo",
+                                 NULL, NULL, pool));
+
+  op.action_code = svn_txdelta_source;
+  op.offset = 0;
+  op.length = 1000;
+  window.sview_offset = 0;
+  window.sview_len = 1000;
+  window.tview_len = 1000;
+  window.num_ops = 1;
+  window.src_ops = 1;
+  window.ops = &op;
+  window.new_data = svn_string_create_empty(pool);
+  SVN_ERR(handler(&window, handler_baton));
+
+  op.action_code = svn_txdelta_new;
+  op.offset = 0;
+  op.length = 5;
+  window.sview_offset = 1000;
+  window.sview_len = 0;
+  window.tview_len = 5;
+  window.src_ops = 0;
+  window.new_data = svn_string_create("hello", pool);
+  SVN_ERR(handler(&window, handler_baton));
+  SVN_ERR(handler(NULL, handler_baton));
+
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  SVN_ERR(verify_foo_contents(fs, rev, contents, pool));
+  SVN_ERR(verify_foo_contents(fs, rev - 1, old_contents, pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef FILE_SIZE
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-concurrent-text-writes"
+
+#if APR_HAS_THREADS
+
+/* Baton for write_bar_thread(). */
+typedef struct write_bar_baton_t
+{
+  /* The transaction to write "bar" in. */
+  const char *repo_path;
+  const char *txn_name;
+
+  /* Set once the thread has written all contents.  Protected by MUTEX. */
+  svn_boolean_t written;
+  svn_mutex__t *mutex;
+  svn_thread_cond__t *cond;
+
+  /* The result of the thread. */
+  svn_error_t *err;
+} write_bar_baton_t;
+
+/* Write the contents of "bar" in the transaction given by BATON through
+   its own FS object, signal BATON->COND before closing the stream and
+   return the result in BATON->ERR. */
+static svn_error_t *
+write_bar(write_bar_baton_t *baton,
+          apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_stream_t *stream;
+
+  SVN_ERR(svn_fs_open2(&fs, baton->repo_path, NULL, pool, pool));
+  SVN_ERR(svn_fs_open_txn(&txn, fs, baton->txn_name, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_apply_text(&stream, root, "bar", NULL, pool));
+  SVN_ERR(svn_stream_puts(stream, "This is bar.\n"));
+
+  SVN_ERR(svn_mutex__lock(baton->mutex));
+  baton->written = TRUE;
+  SVN_ERR(svn_mutex__unlock(baton->mutex,
+                            svn_thread_cond__broadcast(baton->cond)));
+
+  /* This has to wait for the other writer to finish. */
+  return svn_error_trace(svn_stream_close(stream));
+}
+
+/* The plain APR thread function running write_bar() for DATA. */
+static void * APR_THREAD_FUNC
+write_bar_thread(apr_thread_t *thread, void *data)
+{
+  write_bar_baton_t *baton = data;
+  apr_pool_t *pool = apr_allocator_owner_get(svn_pool_create_allocator(FALSE));
+
+  baton->err = write_bar(baton, pool);
+
+  /* Wake up the main thread even if we failed. */
+  svn_error_clear(svn_mutex__lock(baton->mutex));
+  baton->written = TRUE;
+  svn_error_clear(svn_mutex__unlock(baton->mutex,
+                                    svn_thread_cond__broadcast(baton->cond)));
+
+  svn_pool_destroy(pool);
+  apr_thread_exit(thread, APR_SUCCESS);
+  return NULL;
+}
+
+#endif
+
+static svn_error_t *
+concurrent_text_writes(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+#if APR_HAS_THREADS
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_stream_t *stream;
+  svn_stringbuf_t *contents;
+  write_bar_baton_t baton = { 0 };
+  apr_thread_t *thread;
+  apr_status_t status;
+  svn_error_t *err;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, "foo", pool));
+  SVN_ERR(svn_fs_make_file(root, "bar", pool));
+
+  /* Keep the proto-rev file busy with "foo" ... */
+  SVN_ERR(svn_fs_apply_text(&stream, root, "foo", NULL, pool));
+  SVN_ERR(svn_stream_puts(stream, "This is foo.\n"));
+
+  /* ... while another thread writes "bar". */
+  baton.repo_path = REPO_NAME;
+  SVN_ERR(svn_fs_txn_name(&baton.txn_name, txn, pool));
+  SVN_ERR(svn_mutex__init(&baton.mutex, TRUE, pool));
+  SVN_ERR(svn_thread_cond__create(&baton.cond, pool));
+
+  status = apr_thread_create(&thread, NULL, write_bar_thread, &baton, pool);
+  if (status)
+    return svn_error_wrap_apr(status, "Can't create thread");
+
+  err = svn_mutex__lock(baton.mutex);
+  while (!err && !baton.written)
+    err = svn_thread_cond__wait(baton.cond, baton.mutex);
+  if (!err)
+    err = svn_mutex__unlock(baton.mutex, SVN_NO_ERROR);
+
+  err = svn_error_compose_create(err, svn_stream_close(stream));
+  apr_thread_join(&status, thread);
+  SVN_ERR(svn_error_compose_create(err, baton.err));
+
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "foo", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "This is foo.\n");
+  SVN_ERR(svn_test__get_file_contents(root, "bar", &contents, pool));
+  SVN_TEST_STRING_ASSERT(contents->data, "This is bar.\n");
+
+  return SVN_NO_ERROR;
+#else
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "Test requires threads");
+#endif
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-composed_delta_stream"
+#define FILE_SIZE 250000
+#define MAX_REV 4
+
+static svn_error_t *
+composed_delta_stream(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root, *source_root, *target_root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *contents[MAX_REV + 1];
+  apr_uint32_t seed = 0;
+  apr_size_t i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* Pseudo-random text that spans several svndiff windows. */
+  contents[0] = svn_stringbuf_create_ensure(FILE_SIZE, pool);
+  for (i = 0; i < FILE_SIZE; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      svn_stringbuf_appendbyte(contents[0], (char)('a' + (seed >> 16) % 26));
+    }
+
+  /* Build a linear delta chain with changes in every window.  The last
+   * revision grows beyond the end of its delta base. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  for (rev = 0; rev < MAX_REV; )
+    {
+      svn_stringbuf_t *text = svn_stringbuf_dup(contents[rev], pool);
+
+      for (i = rev * 7; i < text->len; i += 20000)
+        text->data[i] = (char)('0' + rev);
+      if (rev + 1 == MAX_REV)
+        svn_stringbuf_appendbytes(text, contents[0]->data, 120000);
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+      if (rev == 0)
+        SVN_ERR(svn_fs_make_file(root, "foo", pool));
+      SVN_ERR(svn_test__set_file_contents(root, "foo", text->data, pool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+      contents[rev] = text;
+    }
+
+  /* Deltas from any older revision to HEAD must reproduce HEAD, whether
+   * they are read as stored, composed from the chain or computed. */
+  SVN_ERR(svn_fs_revision_root(&target_root, fs, MAX_REV, pool));
+  for (rev = 1; rev < MAX_REV; ++rev)
+    {
+      svn_txdelta_stream_t *delta;
+      svn_txdelta_window_handler_t handler;
+      void *handler_baton;
+      svn_stringbuf_t *actual = svn_stringbuf_create_empty(pool);
+
+      SVN_ERR(svn_fs_revision_root(&source_root, fs, rev, pool));
+      SVN_ERR(svn_fs_get_file_delta_stream(&delta, source_root, "foo",
+                                           target_root, "foo", pool));
+      svn_txdelta_apply(svn_stream_from_stringbuf(contents[rev], pool),
+                        svn_stream_from_stringbuf(actual, pool),
+                        NULL, NULL, pool, &handler, &handler_baton);
+      SVN_ERR(svn_txdelta_send_txstream(delta, handler, handler_baton,
+                                        pool));
+      SVN_TEST_ASSERT(svn_stringbuf_compare(actual, contents[MAX_REV]));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef FILE_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-group-store"
+#define GROUP_NAME "test-repo-group-store-group"
+#define FILE_SIZE 100000
+
+/* Commit CONTENTS as file PATH into a new revision of FS. */
+static svn_error_t *
+commit_file(svn_fs_t *fs,
+            const char *path,
+            const char *contents,
+            apr_pool_t *pool)
+{
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+
+  SVN_ERR(svn_fs_youngest_rev(&rev, fs, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+  SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+  SVN_ERR(svn_fs_make_file(root, path, pool));
+  SVN_ERR(svn_test__set_file_contents(root, path, contents, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+group_store(const svn_test_opts_t *opts,
+            apr_pool_t *pool)
+{
+  svn_fs_t *group;
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_root_t *root;
+  svn_stringbuf_t *text;
+  svn_stringbuf_t *actual;
+  apr_finfo_t group_info, member_info;
+  apr_uint32_t seed = 0;
+  apr_size_t i;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  text = svn_stringbuf_create_ensure(FILE_SIZE, pool);
+  for (i = 0; i < FILE_SIZE; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      svn_stringbuf_appendbyte(text, (char)('a' + (seed >> 16) % 26));
+    }
+
+  /* The group store holds the "vendor drop". */
+  SVN_ERR(svn_test__create_fs(&group, GROUP_NAME, opts, pool));
+  ffd = group->fsap_data;
+  if (!ffd->rep_sharing_allowed)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  SVN_ERR(commit_file(group, "vendor", text->data, pool));
+
+  /* A member repository that commits the same content only stores a
+   * reference to it.  Same as setting the option in fsfs.conf. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  ffd = fs->fsap_data;
+  ffd->group_store_path = svn_fs_path(group, pool);
+
+  SVN_ERR(commit_file(fs, "copy", text->data, pool));
+
+  SVN_ERR(svn_io_stat(&group_info,
+                      svn_fs_fs__path_rev_absolute(group, 1, pool),
+                      APR_FINFO_SIZE, pool));
+  SVN_ERR(svn_io_stat(&member_info,
+                      svn_fs_fs__path_rev_absolute(fs, 1, pool),
+                      APR_FINFO_SIZE, pool));
+  SVN_TEST_ASSERT(member_info.size * 4 < group_info.size);
+
+  /* Read it back through a fresh FS instance without cached data. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  ffd = fs->fsap_data;
+  ffd->group_store_path = svn_fs_path(group, pool);
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, 1, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "copy", &actual, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(actual, text));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef GROUP_NAME
+#undef FILE_SIZE
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-similar-delta-bases"
+#define FILE_SIZE 100000
+#define MAX_REV 6
+
+static svn_error_t *
+similar_delta_bases(const svn_test_opts_t *opts,
+                    apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *variants[2];
+  svn_stringbuf_t *contents[MAX_REV + 1];
+  apr_finfo_t finfo;
+  apr_uint32_t seed = 0;
+  apr_size_t i;
+  int k;
+
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* Two unrelated variants of the file. */
+  for (k = 0; k < 2; ++k)
+    {
+      variants[k] = svn_stringbuf_create_ensure(FILE_SIZE, pool);
+      for (i = 0; i < FILE_SIZE; ++i)
+        {
+          seed = seed * 1103515245 + 12345;
+          svn_stringbuf_appendbyte(variants[k],
+                                   (char)('a' + (seed >> 16) % 26));
+        }
+    }
+
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+
+  /* Same as setting the option in fsfs.conf. */
+  ffd = fs->fsap_data;
+  ffd->similar_delta_bases = TRUE;
+
+  /* Alternate between slightly modified versions of both variants. */
+  for (rev = 0; rev < MAX_REV; )
+    {
+      svn_stringbuf_t *text = svn_stringbuf_dup(variants[rev % 2], pool);
+      text->data[rev * 1000] = '0';
+
+      SVN_ERR(svn_fs_begin_txn(&txn, fs, rev, pool));
+      SVN_ERR(svn_fs_txn_root(&root, txn, pool));
+      if (rev == 0)
+        SVN_ERR(svn_fs_make_file(root, "foo", pool));
+      SVN_ERR(svn_test__set_file_contents(root, "foo", text->data, pool));
+      SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+
+      contents[rev] = text;
+    }
+
+  /* Only the first two revisions had to store a whole variant. */
+  for (rev = 3; rev <= MAX_REV; ++rev)
+    {
+      SVN_ERR(svn_io_stat(&finfo,
+                          svn_fs_fs__path_rev_absolute(fs, rev, pool),
+                          APR_FINFO_SIZE, pool));
+      SVN_TEST_ASSERT(finfo.size < FILE_SIZE / 10);
+    }
+
+  /* All contents must be read back correctly. */
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  for (rev = 1; rev <= MAX_REV; ++rev)
+    {
+      svn_stringbuf_t *actual;
+
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+      SVN_ERR(svn_test__get_file_contents(root, "foo", &actual, pool));
+      SVN_TEST_ASSERT(svn_stringbuf_compare(actual, contents[rev]));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef FILE_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-repack-head-locality"
+#define SHARD_SIZE 4
+#define MAX_REV 11
+
+/* Read "iota" in all revisions of FS and compare it to what
+   create_packed_filesystem committed.  Use POOL for allocations. */
+static svn_error_t *
+check_iota_contents(svn_fs_t *fs,
+                    apr_pool_t *pool)
+{
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_revnum_t rev;
+
+  for (rev = 2; rev <= MAX_REV; ++rev)
+    {
+      svn_fs_root_t *root;
+      svn_stringbuf_t *actual;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_root(&root, fs, rev, iterpool));
+      SVN_ERR(svn_test__get_file_contents(root, "iota", &actual, iterpool));
+      SVN_TEST_STRING_ASSERT(actual->data, get_rev_contents(rev, iterpool));
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+repack_head_locality(const svn_test_opts_t *opts,
+                     apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_t *reader;
+  fs_fs_data_t *ffd;
+  svn_fs_id_t *root_id;
+  svn_fs_fs__revision_file_t *rev_file;
+  apr_array_header_t *entries;
+  svn_fs_fs__p2l_entry_t *first;
+  const svn_fs_fs__id_part_t *root_item;
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  if (!svn_fs_fs__use_log_addressing(fs))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL, NULL);
+
+  /* Fill the caches of a concurrent reader with the old layout. */
+  SVN_ERR(svn_fs_open2(&reader, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(check_iota_contents(reader, pool));
+
+  SVN_ERR(svn_fs_fs__repack(fs, SVN_INVALID_REVNUM, NULL, NULL, NULL, NULL,
+                            pool));
+
+  /* The reader must not use index data cached for the old pack files. */
+  SVN_ERR(check_iota_contents(reader, pool));
+
+  /* The HEAD root noderev now comes first in its pack file. */
+  ffd = fs->fsap_data;
+  SVN_ERR(svn_fs_fs__rev_get_root(&root_id, fs, MAX_REV, pool, pool));
+  root_item = svn_fs_fs__id_rev_item(root_id);
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, MAX_REV, pool,
+                                           pool));
+  SVN_ERR(svn_fs_fs__p2l_index_lookup(&entries, fs, rev_file, MAX_REV, 0,
+                                      ffd->p2l_page_size, pool, pool));
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  first = &APR_ARRAY_IDX(entries, 0, svn_fs_fs__p2l_entry_t);
+  SVN_TEST_ASSERT(first->offset == 0);
+  SVN_TEST_ASSERT(first->item.revision == root_item->revision);
+  SVN_TEST_ASSERT(first->item.number == root_item->number);
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-reshard"
+#define SHARD_SIZE 4
+#define NEW_SHARD_SIZE 3
+#define MAX_REV 11
+
+static svn_error_t *
+reshard(const svn_test_opts_t *opts,
+        apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_t *resharded;
+  fs_fs_data_t *ffd;
+  svn_fs_fs__ioctl_reshard_input_t input = { 0 };
+  const char *dst_path = REPO_NAME ".reshard";
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_revnum_t rev;
+
+  SVN_ERR(create_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                   pool));
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+
+  SVN_ERR(svn_io_remove_dir2(dst_path, TRUE, NULL, NULL, pool));
+  svn_test_add_dir_cleanup(dst_path);
+
+  input.path = dst_path;
+  input.max_files_per_dir = NEW_SHARD_SIZE;
+  input.jobs = 2;
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_RESHARD, &input, NULL,
+                       NULL, NULL, pool, pool));
+
+  /* Catching up with an unchanged source is a no-op. */
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_RESHARD, &input, NULL,
+                       NULL, NULL, pool, pool));
+
+  /* The copy uses the new layout and has been packed. */
+  SVN_ERR(svn_fs_open2(&resharded, dst_path, NULL, pool, pool));
+  ffd = resharded->fsap_data;
+  SVN_TEST_ASSERT(ffd->max_files_per_dir == NEW_SHARD_SIZE);
+  SVN_ERR(svn_fs_fs__read_min_unpacked_rev(&rev, resharded, pool));
+  SVN_TEST_ASSERT(rev == MAX_REV + 1);
+
+  /* Contents and revprops survived. */
+  SVN_ERR(check_iota_contents(resharded, pool));
+  for (rev = 0; rev <= MAX_REV; ++rev)
+    {
+      apr_hash_t *expected;
+      apr_hash_t *actual;
+
+      svn_pool_clear(iterpool);
+      SVN_ERR(svn_fs_revision_proplist2(&expected, fs, rev, FALSE,
+                                        iterpool, iterpool));
+      SVN_ERR(svn_fs_revision_proplist2(&actual, resharded, rev, FALSE,
+                                        iterpool, iterpool));
+      SVN_TEST_ASSERT(apr_hash_count(actual) == apr_hash_count(expected));
+      SVN_TEST_STRING_ASSERT(svn_prop_get_value(actual,
+                                                SVN_PROP_REVISION_DATE),
+                             svn_prop_get_value(expected,
+                                                SVN_PROP_REVISION_DATE));
+    }
+  svn_pool_destroy(iterpool);
+
+  SVN_ERR(svn_fs_verify(dst_path, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef NEW_SHARD_SIZE
+#undef MAX_REV
+
+/* ------------------------------------------------------------------------ */
 
 
 /* The test table.  */
@@ -1903,6 +4031,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pack FSFS where revs % shard = 0"),
     SVN_TEST_OPTS_PASS(read_packed_fs,
                        "read from a packed FSFS filesystem"),
+    SVN_TEST_OPTS_PASS(read_mapped_packed_fs,
+                       "read from a memory-mapped packed FSFS filesystem"),
     SVN_TEST_OPTS_PASS(commit_packed_fs,
                        "commit to a packed FSFS filesystem"),
     SVN_TEST_OPTS_PASS(get_set_revprop_packed_fs,
@@ -1943,6 +4073,44 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pack with limited memory for metadata"),
     SVN_TEST_OPTS_PASS(large_delta_against_plain,
                        "large deltas against PLAIN, issue #4658"),
+    SVN_TEST_OPTS_PASS(pack_in_parallel,
+                       "pack multiple shards concurrently"),
+    SVN_TEST_OPTS_PASS(indexed_directory,
+                       "look up entries in indexed directories"),
+    SVN_TEST_OPTS_PASS(group_commit,
+                       "share the flush of 'current' between commits"),
+    SVN_TEST_OPTS_PASS(rep_cache_front,
+                       "in-memory front-end of the rep-cache"),
+    SVN_TEST_OPTS_PASS(path_index,
+                       "look up revisions in the changed-paths index"),
+    SVN_TEST_OPTS_PASS(revprop_generations,
+                       "per-shard revprop cache invalidation"),
+    SVN_TEST_OPTS_PASS(packed_changes,
+                       "packed changed paths lists"),
+    SVN_TEST_OPTS_PASS(parallel_stats,
+                       "parallel and sampled stats scans"),
+    SVN_TEST_OPTS_PASS(composed_delta_windows,
+                       "read composed delta chain windows"),
+    SVN_TEST_OPTS_PASS(random_access_reads,
+                       "read representations at arbitrary offsets"),
+    SVN_TEST_OPTS_PASS(mergeinfo_index,
+                       "mergeinfo index for descendant queries"),
+    SVN_TEST_OPTS_PASS(lock_index,
+                       "lock index for subtree lock queries"),
+    SVN_TEST_OPTS_PASS(delta_passthrough,
+                       "store incoming deltas without re-deltification"),
+    SVN_TEST_OPTS_PASS(concurrent_text_writes,
+                       "write file contents concurrently in one txn"),
+    SVN_TEST_OPTS_PASS(composed_delta_stream,
+                       "compose stored deltas into a delta stream"),
+    SVN_TEST_OPTS_PASS(group_store,
+                       "share representations through a group store"),
+    SVN_TEST_OPTS_PASS(similar_delta_bases,
+                       "deltify against the most similar recent version"),
+    SVN_TEST_OPTS_PASS(repack_head_locality,
+                       "repack FSFS for HEAD tree locality"),
+    SVN_TEST_OPTS_PASS(reshard,
+                       "reshard FSFS into a copy"),
     SVN_TEST_NULL
   };
 
@@ -25,17 +25,22 @@
 
 #include "../svn_test.h"
 
+#include "svn_dirent_uri.h"
 #include "svn_hash.h"
 #include "svn_pools.h"
 #include "svn_props.h"
 #include "svn_fs.h"
 
+#include "private/svn_adler32.h"
 #include "private/svn_string_private.h"
 #include "private/svn_fs_fs_private.h"
 #include "private/svn_subr_private.h"
 
+#include "../../libsvn_fs_fs/access_trace.h"
 #include "../../libsvn_fs_fs/index.h"
 #include "../../libsvn_fs_fs/rep-cache.h"
+#include "../../libsvn_fs_fs/rev_file.h"
+#include "../../libsvn_fs_fs/util.h"
 #include "../../libsvn_fs/fs-loader.h"
 
 #include "../svn_test_fs.h"
@@ -424,8 +429,8 @@ load_index(const svn_test_opts_t *opts, apr_pool_t *pool)
   SVN_ERR(svn_fs_ioctl(svn_repos_fs(repos), SVN_FS_FS__IOCTL_LOAD_INDEX,
                        &load_input, NULL, NULL, NULL, pool, pool));
 
-  SVN_TEST_ASSERT_ERROR(svn_repos_verify_fs3(repos, rev, rev, FALSE, FALSE,
-                                             NULL, NULL, NULL, NULL, NULL,
+  SVN_TEST_ASSERT_ERROR(svn_repos_verify_fs4(repos, rev, rev, FALSE, FALSE,
+                                             1, NULL, NULL, NULL, NULL, NULL,
                                              NULL, pool),
                         SVN_ERR_FS_INDEX_CORRUPTION);
 
@@ -434,7 +439,7 @@ load_index(const svn_test_opts_t *opts, apr_pool_t *pool)
   load_input.entries = entries;
   SVN_ERR(svn_fs_ioctl(svn_repos_fs(repos), SVN_FS_FS__IOCTL_LOAD_INDEX,
                        &load_input, NULL, NULL, NULL, pool, pool));
-  SVN_ERR(svn_repos_verify_fs3(repos, rev, rev, FALSE, FALSE, NULL, NULL,
+  SVN_ERR(svn_repos_verify_fs4(repos, rev, rev, FALSE, FALSE, 1, NULL, NULL,
                                NULL, NULL, NULL, NULL, pool));
 
   return SVN_NO_ERROR;
@@ -499,6 +504,375 @@ build_rep_cache(const svn_test_opts_t *opts, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* ------------------------------------------------------------------------ */
+
+#define REPO_NAME "test-repo-batch-item-offsets"
+
+/* Compare the results of svn_fs_fs__item_offsets for ITEM_INDEXES of REV
+ * with those of individual svn_fs_fs__item_offset calls. */
+static svn_error_t *
+verify_item_offsets(svn_fs_t *fs,
+                    svn_fs_fs__revision_file_t *rev_file,
+                    svn_revnum_t rev,
+                    const apr_array_header_t *item_indexes,
+                    apr_pool_t *pool)
+{
+  apr_array_header_t *offsets;
+  int i;
+
+  SVN_ERR(svn_fs_fs__item_offsets(&offsets, fs, rev_file, rev, item_indexes,
+                                  pool, pool));
+  SVN_TEST_INT_ASSERT(offsets->nelts, item_indexes->nelts);
+
+  for (i = 0; i < item_indexes->nelts; ++i)
+    {
+      apr_off_t offset;
+      SVN_ERR(svn_fs_fs__item_offset(&offset, fs, rev_file, rev, NULL,
+                                     APR_ARRAY_IDX(item_indexes, i,
+                                                   apr_uint64_t),
+                                     pool));
+      SVN_TEST_ASSERT(offset == APR_ARRAY_IDX(offsets, i, apr_off_t));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+batch_item_offsets(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_revnum_t rev;
+  svn_fs_fs__revision_file_t *rev_file;
+  apr_array_header_t *max_ids;
+  apr_array_header_t *item_indexes;
+  apr_uint64_t max_id;
+  apr_uint64_t i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 9))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.9 SVN doesn't have FSFS indexes");
+
+  SVN_ERR(create_greek_repo(&repos, &rev, opts, REPO_NAME, pool, pool));
+  fs = svn_repos_fs(repos);
+  if (!svn_fs_fs__use_log_addressing(fs))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test log addressing only");
+
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rev, pool, pool));
+  SVN_ERR(svn_fs_fs__l2p_get_max_ids(&max_ids, fs, rev, 1, pool, pool));
+  max_id = APR_ARRAY_IDX(max_ids, 0, apr_uint64_t);
+
+  /* All items in ascending order. */
+  item_indexes = apr_array_make(pool, (int)max_id, sizeof(apr_uint64_t));
+  for (i = 0; i < max_id; ++i)
+    APR_ARRAY_PUSH(item_indexes, apr_uint64_t) = i;
+  SVN_ERR(verify_item_offsets(fs, rev_file, rev, item_indexes, pool));
+
+  /* Unsorted input must still produce correct results. */
+  apr_array_clear(item_indexes);
+  for (i = max_id; i > 0; --i)
+    APR_ARRAY_PUSH(item_indexes, apr_uint64_t) = i - 1;
+  SVN_ERR(verify_item_offsets(fs, rev_file, rev, item_indexes, pool));
+
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  return SVN_NO_ERROR;
+}
+
+#undef REPO_NAME
+
+/* ------------------------------------------------------------------------ */
+
+static svn_error_t *
+contents_location(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_fs_fs__ioctl_contents_location_input_t input = {0};
+  svn_fs_fs__ioctl_contents_location_output_t *output;
+  const char *contents = "This is a verbatim file.\n";
+  apr_size_t len = strlen(contents);
+  svn_stringbuf_t *str;
+  char *buffer;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs2(&fs, "test-repo-contents-location", opts,
+                               NULL, pool));
+  ffd = fs->fsap_data;
+
+  /* Store one file as usual and one verbatim.  Their contents must differ
+   * or the second would share the representation of the first. */
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "deltified", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "deltified",
+                                      "This is a deltified file.\n", pool));
+  ffd->deltify_files = FALSE;
+  SVN_ERR(svn_fs_make_file(txn_root, "verbatim", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "verbatim", contents, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+
+  /* Deltified contents have no location. */
+  input.root = root;
+  input.path = "deltified";
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_CONTENTS_LOCATION, &input,
+                       (void **)&output, NULL, NULL, pool, pool));
+  SVN_TEST_ASSERT(output->file == NULL);
+
+  /* Verbatim contents can be read directly from the rev file. */
+  input.path = "verbatim";
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_CONTENTS_LOCATION, &input,
+                       (void **)&output, NULL, NULL, pool, pool));
+  SVN_TEST_ASSERT(output->file != NULL);
+  SVN_TEST_ASSERT(output->length == len);
+
+  buffer = apr_palloc(pool, len);
+  SVN_ERR(svn_io_file_seek(output->file, APR_SET, &output->offset, pool));
+  SVN_ERR(svn_io_file_read_full2(output->file, buffer, len, NULL, NULL,
+                                 pool));
+  SVN_TEST_ASSERT(memcmp(buffer, contents, len) == 0);
+
+  /* Reading them through the FS API still works. */
+  SVN_ERR(svn_test__get_file_contents(root, "verbatim", &str, pool));
+  SVN_TEST_STRING_ASSERT(str->data, contents);
+
+  return SVN_NO_ERROR;
+}
+
+
+/* ------------------------------------------------------------------------ */
+
+static svn_error_t *
+deflated_contents(const svn_test_opts_t *opts,
+                  apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_fs_fs__ioctl_deflated_contents_input_t input = {0};
+  svn_fs_fs__ioctl_deflated_contents_output_t *output;
+  svn_stringbuf_t *contents;
+  svn_stringbuf_t *zlib_data;
+  svn_stringbuf_t *actual;
+  unsigned char header[SVN__MAX_ENCODED_UINT_LEN];
+  apr_uint32_t adler;
+  unsigned char trailer[4];
+  int i;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  if (opts->server_minor_version && (opts->server_minor_version < 4))
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "pre-1.4 SVN doesn't support svndiff1");
+
+  SVN_ERR(svn_test__create_fs2(&fs, "test-repo-deflated-contents", opts,
+                               NULL, pool));
+  ffd = fs->fsap_data;
+  ffd->delta_compression_type = compression_type_zlib;
+  ffd->delta_compression_level = 5;
+
+  /* A compressible text and one that zlib can't shrink. */
+  contents = svn_stringbuf_create_empty(pool);
+  for (i = 0; i < 1000; ++i)
+    svn_stringbuf_appendcstr(contents, "This is a compressible line.\n");
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "compressed", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "compressed",
+                                      contents->data, pool));
+  SVN_ERR(svn_fs_make_file(txn_root, "short", pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "short", "short\n", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+
+  /* Short texts are not compressed at all. */
+  input.root = root;
+  input.path = "short";
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_DEFLATED_CONTENTS, &input,
+                       (void **)&output, NULL, NULL, pool, pool));
+  SVN_TEST_ASSERT(output->deflated == NULL);
+
+  input.path = "compressed";
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_DEFLATED_CONTENTS, &input,
+                       (void **)&output, NULL, NULL, pool, pool));
+  SVN_TEST_ASSERT(output->deflated != NULL);
+  SVN_TEST_ASSERT(output->deflated->len < contents->len);
+
+  /* Wrap the raw deflate stream into the zlib format again and expand
+   * it.  That must give us the original contents. */
+  zlib_data = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_appendbytes(zlib_data, (const char *)header,
+                            svn__encode_uint(header, contents->len)
+                              - header);
+  svn_stringbuf_appendbytes(zlib_data, "\x78\x9c", 2);
+  svn_stringbuf_appendbytes(zlib_data, output->deflated->data,
+                            output->deflated->len);
+
+  adler = svn__adler32(1, contents->data, contents->len);
+  trailer[0] = (unsigned char)(adler >> 24);
+  trailer[1] = (unsigned char)(adler >> 16);
+  trailer[2] = (unsigned char)(adler >> 8);
+  trailer[3] = (unsigned char)adler;
+  svn_stringbuf_appendbytes(zlib_data, (const char *)trailer, 4);
+
+  actual = svn_stringbuf_create_empty(pool);
+  SVN_ERR(svn__decompress_zlib(zlib_data->data, zlib_data->len, actual,
+                               contents->len));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(actual, contents));
+
+  return SVN_NO_ERROR;
+}
+
+
+/* ------------------------------------------------------------------------ */
+
+static svn_error_t *
+replay_trace(const svn_test_opts_t *opts,
+             apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_fs_root_t *root;
+  svn_revnum_t rev;
+  svn_stringbuf_t *str;
+  svn_fs_path_change_iterator_t *iterator;
+  svn_fs_path_change3_t *change;
+  svn_fs_fs__ioctl_replay_trace_input_t input = {0};
+  svn_fs_fs__ioctl_replay_trace_output_t *output;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs2(&fs, "test-repo-replay-trace", opts,
+                               NULL, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+
+  /* Record some reads. */
+  input.path = svn_dirent_join(fs->path, "access-trace", pool);
+  ffd = fs->fsap_data;
+  SVN_ERR(svn_fs_fs__access_trace_open(&ffd->access_trace, input.path,
+                                       pool, pool));
+
+  SVN_ERR(svn_fs_revision_root(&root, fs, rev, pool));
+  SVN_ERR(svn_test__get_file_contents(root, "A/D/G/rho", &str, pool));
+  SVN_TEST_STRING_ASSERT(str->data, "This is the file 'rho'.\n");
+  SVN_ERR(svn_fs_paths_changed3(&iterator, root, pool, pool));
+  SVN_ERR(svn_fs_path_change_get(&change, iterator));
+  SVN_TEST_ASSERT(change != NULL);
+
+  /* Replaying them requests the same items again. */
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_REPLAY_TRACE, &input,
+                       (void **)&output, NULL, NULL, pool, pool));
+  SVN_TEST_ASSERT(output->noderevs > 0);
+  SVN_TEST_ASSERT(output->changes == 1);
+  SVN_TEST_ASSERT(output->contents > 0);
+  SVN_TEST_ASSERT(output->skipped == 0);
+
+  /* The replay itself has not been recorded. */
+  SVN_ERR(svn_fs_ioctl(fs, SVN_FS_FS__IOCTL_REPLAY_TRACE, &input,
+                       (void **)&output, NULL, NULL, pool, pool));
+  SVN_TEST_ASSERT(output->changes == 1);
+
+  return SVN_NO_ERROR;
+}
+
+/* ------------------------------------------------------------------------ */
+
+static svn_error_t *
+rev_file_reuse(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  fs_fs_data_t *ffd;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t rev;
+  svn_fs_fs__revision_file_t *rev_file;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  apr_uint64_t files_opened;
+
+  /* Bail (with success) on known-untestable scenarios */
+  if (strcmp(opts->fs_type, "fsfs") != 0)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "this will test FSFS repositories only");
+
+  SVN_ERR(svn_test__create_fs2(&fs, "test-repo-rev-file-reuse", opts,
+                               NULL, pool));
+  ffd = fs->fsap_data;
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(rev));
+
+  /* The first open actually opens the file. */
+  svn_fs_fs__rev_file_cache_clear(fs);
+  files_opened = ffd->io_stats.files_opened;
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rev, pool, pool));
+  SVN_ERR(svn_fs_fs__auto_read_footer(rev_file));
+  SVN_TEST_ASSERT(ffd->io_stats.files_opened == files_opened + 1);
+  SVN_ERR(svn_fs_fs__close_revision_file(rev_file));
+
+  /* Explicitly closed files get reused, including their footer data. */
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rev, subpool,
+                                           pool));
+  SVN_TEST_ASSERT(ffd->io_stats.files_opened == files_opened + 1);
+  SVN_TEST_ASSERT(rev_file->l2p_offset != -1);
+
+  /* So do files whose pool got cleaned up. */
+  svn_pool_clear(subpool);
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rev, subpool,
+                                           pool));
+  SVN_TEST_ASSERT(ffd->io_stats.files_opened == files_opened + 1);
+
+  /* After clearing the cache, files in use get closed upon release. */
+  svn_fs_fs__rev_file_cache_clear(fs);
+  svn_pool_clear(subpool);
+  SVN_ERR(svn_fs_fs__open_pack_or_rev_file(&rev_file, fs, rev, subpool,
+                                           pool));
+  SVN_TEST_ASSERT(ffd->io_stats.files_opened == files_opened + 2);
+  SVN_TEST_ASSERT(rev_file->l2p_offset == -1);
+
+  svn_pool_destroy(subpool);
+
+  return SVN_NO_ERROR;
+}
+
 
 
 /* The test table.  */
@@ -516,6 +890,16 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "load the P2L index"),
     SVN_TEST_OPTS_PASS(build_rep_cache,
                        "build the representation cache"),
+    SVN_TEST_OPTS_PASS(batch_item_offsets,
+                       "batched l2p index lookups"),
+    SVN_TEST_OPTS_PASS(contents_location,
+                       "locate verbatim file contents"),
+    SVN_TEST_OPTS_PASS(replay_trace,
+                       "record and replay an access trace"),
+    SVN_TEST_OPTS_PASS(deflated_contents,
+                       "get zlib-compressed file contents as stored"),
+    SVN_TEST_OPTS_PASS(rev_file_reuse,
+                       "reuse open revision files"),
     SVN_TEST_NULL
   };
 
@@ -116,17 +116,16 @@ pack_notify(void *baton,
 
 #define R1_LOG_MSG "Let's serf"
 
-/* Create a packed filesystem in DIR.  Set the shard size to
-   SHARD_SIZE and create NUM_REVS number of revisions (in addition to
-   r0).  Use POOL for allocations.  After this function successfully
-   completes, the filesystem's youngest revision number will be the
-   same as NUM_REVS.  */
+/* Create a filesystem in DIR.  Set the shard size to SHARD_SIZE and create
+   NUM_REVS number of revisions (in addition to r0).  Use POOL for
+   allocations.  After this function successfully completes, the
+   filesystem's youngest revision number will be the same as NUM_REVS.  */
 static svn_error_t *
-create_packed_filesystem(const char *dir,
-                         const svn_test_opts_t *opts,
-                         int num_revs,
-                         int shard_size,
-                         apr_pool_t *pool)
+create_non_packed_filesystem(const char *dir,
+                             const svn_test_opts_t *opts,
+                             int num_revs,
+                             int shard_size,
+                             apr_pool_t *pool)
 {
   svn_fs_t *fs;
   svn_fs_txn_t *txn;
@@ -134,7 +133,6 @@ create_packed_filesystem(const char *dir,
   const char *conflict;
   svn_revnum_t after_rev;
   apr_pool_t *subpool = svn_pool_create(pool);
-  struct pack_notify_baton pnb;
   apr_pool_t *iterpool;
   int version;
 
@@ -189,6 +187,26 @@ create_packed_filesystem(const char *dir,
   svn_pool_destroy(iterpool);
   svn_pool_destroy(subpool);
 
+  return SVN_NO_ERROR;
+}
+
+/* Create a packed filesystem in DIR.  Set the shard size to
+   SHARD_SIZE and create NUM_REVS number of revisions (in addition to
+   r0).  Use POOL for allocations.  After this function successfully
+   completes, the filesystem's youngest revision number will be the
+   same as NUM_REVS.  */
+static svn_error_t *
+create_packed_filesystem(const char *dir,
+                         const svn_test_opts_t *opts,
+                         int num_revs,
+                         int shard_size,
+                         apr_pool_t *pool)
+{
+  struct pack_notify_baton pnb;
+
+  SVN_ERR(create_non_packed_filesystem(dir, opts, num_revs, shard_size,
+                                       pool));
+
   /* Now pack the FS */
   pnb.expected_shard = 0;
   pnb.expected_action = svn_fs_pack_notify_start;
@@ -929,6 +947,135 @@ test_batch_fsync(const svn_test_opts_t *opts,
 }
 #undef REPO_NAME
 /* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-fsx-pack-in-parallel"
+#define SHARD_SIZE 4
+#define MAX_REV 43
+static svn_error_t *
+pack_in_parallel(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  struct pack_notify_baton pnb;
+  svn_fs_t *fs;
+  const svn_fs_fsx_info_t *fsx_info;
+  const svn_fs_info_placeholder_t *info;
+  svn_revnum_t i;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* Create the repo and pack it using multiple jobs.  Notifications must
+     still arrive in shard order. */
+  SVN_ERR(create_non_packed_filesystem(REPO_NAME, opts, MAX_REV, SHARD_SIZE,
+                                       pool));
+
+  pnb.expected_shard = 0;
+  pnb.expected_action = svn_fs_pack_notify_start;
+  SVN_ERR(svn_fs_pack2(REPO_NAME, 4, pack_notify, &pnb, NULL, NULL, pool));
+  SVN_TEST_ASSERT(pnb.expected_shard == (MAX_REV + 1) / SHARD_SIZE);
+
+  SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, pool, pool));
+  SVN_ERR(svn_fs_info(&info, fs, pool, pool));
+  fsx_info = (const void *)info;
+  SVN_TEST_ASSERT(fsx_info->min_unpacked_rev == MAX_REV + 1);
+
+  /* The contents must be the same as after a sequential pack. */
+  for (i = 2; i <= MAX_REV; i++)
+    {
+      svn_fs_root_t *rev_root;
+      svn_stream_t *rstream;
+      svn_stringbuf_t *rstring;
+      svn_string_t *propval;
+
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_fs_revision_root(&rev_root, fs, i, iterpool));
+      SVN_ERR(svn_fs_file_contents(&rstream, rev_root, "iota", iterpool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, iterpool));
+      SVN_TEST_STRING_ASSERT(rstring->data, get_rev_contents(i, iterpool));
+
+      SVN_ERR(svn_fs_revision_prop(&propval, fs, i, SVN_PROP_REVISION_DATE,
+                                   iterpool));
+      SVN_TEST_ASSERT(propval != NULL);
+    }
+
+  SVN_ERR(svn_fs_verify(REPO_NAME, NULL, 0, MAX_REV, NULL, NULL, NULL, NULL,
+                        pool));
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+#undef SHARD_SIZE
+#undef MAX_REV
+/* ------------------------------------------------------------------------ */
+#define REPO_NAME "test-repo-fsx-shared-dag-paths"
+/* Resolve the same deep paths through several FS instances.  All but the
+   first will find them in the shared DAG path cache. */
+static svn_error_t *
+shared_dag_paths(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t rev;
+  int i;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  /* r1: Greek tree.  r2: modified 'A/D/G/rho'. */
+  SVN_ERR(svn_test__create_fs(&fs, REPO_NAME, opts, pool));
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 1);
+
+  SVN_ERR(svn_fs_begin_txn(&txn, fs, 1, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__set_file_contents(txn_root, "A/D/G/rho",
+                                      "new rho\n", pool));
+  SVN_ERR(svn_fs_commit_txn(NULL, &rev, txn, pool));
+  SVN_TEST_ASSERT(rev == 2);
+
+  for (i = 0; i < 3; i++)
+    {
+      svn_fs_root_t *root1, *root2;
+      svn_stream_t *rstream;
+      svn_stringbuf_t *rstring;
+      svn_node_kind_t kind;
+
+      svn_pool_clear(iterpool);
+
+      /* Each iteration uses a fresh FS instance, i.e. a cold 1st level
+         DAG cache. */
+      SVN_ERR(svn_fs_open2(&fs, REPO_NAME, NULL, iterpool, iterpool));
+      SVN_ERR(svn_fs_revision_root(&root1, fs, 1, iterpool));
+      SVN_ERR(svn_fs_revision_root(&root2, fs, 2, iterpool));
+
+      SVN_ERR(svn_fs_file_contents(&rstream, root1, "/A/D/G/rho",
+                                   iterpool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, iterpool));
+      SVN_TEST_STRING_ASSERT(rstring->data, "This is the file 'rho'.\n");
+
+      SVN_ERR(svn_fs_file_contents(&rstream, root2, "/A/D/G/rho",
+                                   iterpool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, iterpool));
+      SVN_TEST_STRING_ASSERT(rstring->data, "new rho\n");
+
+      /* Siblings and non-existent paths must not be confused. */
+      SVN_ERR(svn_fs_file_contents(&rstream, root2, "/A/D/G/pi",
+                                   iterpool));
+      SVN_ERR(svn_test__stream_to_string(&rstring, rstream, iterpool));
+      SVN_TEST_STRING_ASSERT(rstring->data, "This is the file 'pi'.\n");
+
+      SVN_ERR(svn_fs_check_path(&kind, root1, "/A/D/G/nope", iterpool));
+      SVN_TEST_ASSERT(kind == svn_node_none);
+    }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+#undef REPO_NAME
+/* ------------------------------------------------------------------------ */
 
 /* The test table.  */
 
@@ -963,6 +1110,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test packing with shard size = 1"),
     SVN_TEST_OPTS_PASS(test_batch_fsync,
                        "test batch fsync"),
+    SVN_TEST_OPTS_PASS(pack_in_parallel,
+                       "pack multiple FSX shards in parallel"),
+    SVN_TEST_OPTS_PASS(shared_dag_paths,
+                       "share DAG path lookups between FS instances"),
     SVN_TEST_NULL
   };
 
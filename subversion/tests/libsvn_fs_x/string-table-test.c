@@ -238,6 +238,69 @@ many_strings_table_body(svn_boolean_t do_load_store,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+path_strings_table_body(svn_boolean_t do_load_store,
+                        apr_pool_t *pool)
+{
+  /* Paths that are prefixes of one another and share long heads, i.e.
+     typical noderev and changes container contents. */
+  enum { COUNT = 6 * 40 };
+
+  const char *strings[COUNT] = { 0 };
+  apr_size_t indexes[COUNT] = { 0 };
+
+  string_table_builder_t *builder;
+  string_table_t *table;
+  int i;
+
+  builder = svn_fs_x__string_table_builder_create(pool);
+  for (i = 0; i < COUNT; ++i)
+    {
+      const char *base = "/trunk/subversion/libsvn_fs_x/some/deeper";
+      switch (i % 6)
+        {
+          case 0: strings[i] = apr_psprintf(pool, "%s/%d", base, i / 6);
+                  break;
+          case 1: strings[i] = apr_psprintf(pool, "%s/%d/file", base, i / 6);
+                  break;
+          case 2: strings[i] = apr_psprintf(pool, "%s/%d/file.c", base,
+                                            i / 6);
+                  break;
+          case 3: strings[i] = apr_psprintf(pool, "%s/%d", base, i / 6 + 1);
+                  break;
+          case 4: strings[i] = apr_psprintf(pool, "%s", base);
+                  break;
+          default: strings[i] = apr_psprintf(pool, "%.*s", i / 6, base);
+                   break;
+        }
+
+      indexes[i] = svn_fs_x__string_table_builder_add(builder, strings[i],
+                                                      strlen(strings[i]));
+    }
+
+  /* Identical strings must be stored only once. */
+  for (i = 6; i < COUNT; i += 6)
+    SVN_TEST_ASSERT(indexes[i + 4] == indexes[4]);
+  for (i = 6; i < COUNT; i += 6)
+    SVN_TEST_ASSERT(indexes[i] == indexes[i - 3]);
+
+  table = svn_fs_x__string_table_create(builder, pool);
+  if (do_load_store)
+    SVN_ERR(store_and_load_table(&table, pool));
+
+  for (i = 0; i < COUNT; ++i)
+    {
+      apr_size_t len;
+      const char *string
+        = svn_fs_x__string_table_get(table, indexes[i], &len, pool);
+
+      SVN_TEST_STRING_ASSERT(string, strings[i]);
+      SVN_TEST_ASSERT(len == strlen(strings[i]));
+    }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 create_empty_table(apr_pool_t *pool)
 {
@@ -262,6 +325,12 @@ many_strings_table(apr_pool_t *pool)
   return svn_error_trace(many_strings_table_body(FALSE, pool));
 }
 
+static svn_error_t *
+path_strings_table(apr_pool_t *pool)
+{
+  return svn_error_trace(path_strings_table_body(FALSE, pool));
+}
+
 static svn_error_t *
 store_load_short_string_table(apr_pool_t *pool)
 {
@@ -286,6 +355,12 @@ store_load_many_strings_table(apr_pool_t *pool)
   return svn_error_trace(many_strings_table_body(TRUE, pool));
 }
 
+static svn_error_t *
+store_load_path_strings_table(apr_pool_t *pool)
+{
+  return svn_error_trace(path_strings_table_body(TRUE, pool));
+}
+
 
 /* ------------------------------------------------------------------------ */
 
@@ -312,6 +387,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "store and load table with large strings only"),
     SVN_TEST_PASS2(store_load_many_strings_table,
                    "store and load string table with many strings"),
+    SVN_TEST_PASS2(path_strings_table,
+                   "string table with shared path prefixes"),
+    SVN_TEST_PASS2(store_load_path_strings_table,
+                   "store and load table with shared path prefixes"),
     SVN_TEST_NULL
   };
 
@@ -40,6 +40,7 @@
 #include "../svn_test.h"
 #include "../svn_test_fs.h"
 #include "../../libsvn_ra_local/ra_local.h"
+#include "private/svn_ra_private.h"
 
 /*-------------------------------------------------------------------*/
 
@@ -1877,11 +1878,199 @@ test_get_deleted_rev_errors(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Read the entry KEY of CACHE into *VALUE, or set it to NULL on a miss. */
+static svn_error_t *
+read_cache_entry(const char **value,
+                 svn_ra__cache_t *cache,
+                 const char *key,
+                 apr_pool_t *pool)
+{
+  svn_stream_t *stream;
+  svn_stringbuf_t *buf;
+
+  SVN_ERR(svn_ra__cache_get(&stream, cache, key, pool, pool));
+  if (!stream)
+    {
+      *value = NULL;
+      return SVN_NO_ERROR;
+    }
+
+  SVN_ERR(svn_stringbuf_from_stream(&buf, stream, 0, pool));
+  SVN_ERR(svn_stream_close(stream));
+  *value = buf->data;
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+ra_cache_test(const svn_test_opts_t *opts,
+              apr_pool_t *pool)
+{
+  const char *cache_dir;
+  svn_ra__cache_t *cache;
+  svn_stream_t *stream;
+  const char *value;
+  apr_pool_t *put_pool;
+  int found = 0;
+  int i;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&cache_dir, "ra-cache", pool));
+  SVN_ERR(svn_ra__cache_create(&cache, cache_dir, 1000, pool));
+
+  /* Misses. */
+  SVN_ERR(read_cache_entry(&value, cache, "file uuid 1 A/mu", pool));
+  SVN_TEST_ASSERT(value == NULL);
+
+  /* Entries only appear once their stream got closed. */
+  put_pool = svn_pool_create(pool);
+  SVN_ERR(svn_ra__cache_put(&stream, cache, "file uuid 1 A/mu", put_pool,
+                            put_pool));
+  SVN_ERR(svn_stream_puts(stream, "contents of mu"));
+  SVN_ERR(read_cache_entry(&value, cache, "file uuid 1 A/mu", pool));
+  SVN_TEST_ASSERT(value == NULL);
+
+  /* Destroying the pool instead discards the entry. */
+  svn_pool_destroy(put_pool);
+  SVN_ERR(read_cache_entry(&value, cache, "file uuid 1 A/mu", pool));
+  SVN_TEST_ASSERT(value == NULL);
+
+  SVN_ERR(svn_ra__cache_put(&stream, cache, "file uuid 1 A/mu", pool, pool));
+  SVN_ERR(svn_stream_puts(stream, "contents of mu"));
+  SVN_ERR(svn_stream_close(stream));
+  SVN_ERR(read_cache_entry(&value, cache, "file uuid 1 A/mu", pool));
+  SVN_TEST_STRING_ASSERT(value, "contents of mu");
+
+  /* Different keys, different entries. */
+  SVN_ERR(read_cache_entry(&value, cache, "file uuid 2 A/mu", pool));
+  SVN_TEST_ASSERT(value == NULL);
+
+  /* Exceeding the size limit evicts entries. */
+  for (i = 0; i < 20; i++)
+    {
+      const char *key = apr_psprintf(pool, "file uuid %d iota", i);
+
+      SVN_ERR(svn_ra__cache_put(&stream, cache, key, pool, pool));
+      SVN_ERR(svn_stream_puts(stream, apr_psprintf(pool, "%100d", i)));
+      SVN_ERR(svn_stream_close(stream));
+    }
+
+  for (i = 0; i < 20; i++)
+    {
+      const char *key = apr_psprintf(pool, "file uuid %d iota", i);
+
+      SVN_ERR(read_cache_entry(&value, cache, key, pool));
+      if (value)
+        found++;
+    }
+
+  SVN_TEST_ASSERT(found > 0 && found <= 10);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* The test table.  */
 
 static int max_threads = 4;
 
+/* Stat several paths at once, including missing ones. */
+static svn_error_t *
+stat_many_test(const svn_test_opts_t *opts,
+               apr_pool_t *pool)
+{
+  svn_ra_session_t *ra_session;
+  apr_array_header_t *paths = apr_array_make(pool, 4, sizeof(const char *));
+  apr_hash_t *dirents;
+  svn_dirent_t *dirent;
+
+  SVN_ERR(make_and_open_repos(&ra_session, "test-repo-stat-many", opts,
+                              pool));
+  SVN_ERR(commit_changes(ra_session, pool));
+  SVN_ERR(commit_two_changes(ra_session, pool));
+
+  APR_ARRAY_PUSH(paths, const char *) = "";
+  APR_ARRAY_PUSH(paths, const char *) = "A";
+  APR_ARRAY_PUSH(paths, const char *) = "B";
+  APR_ARRAY_PUSH(paths, const char *) = "C";
+
+  /* A got deleted in r3. */
+  SVN_ERR(svn_ra_stat_many(ra_session, &dirents, paths, 2, pool, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(dirents), 3);
+  dirent = svn_hash_gets(dirents, "A");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_dir);
+  SVN_TEST_INT_ASSERT(dirent->created_rev, 1);
+  dirent = svn_hash_gets(dirents, "B");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_dir);
+  SVN_TEST_INT_ASSERT(dirent->created_rev, 2);
+
+  SVN_ERR(svn_ra_stat_many(ra_session, &dirents, paths, SVN_INVALID_REVNUM,
+                           pool, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(dirents), 2);
+  SVN_TEST_ASSERT(svn_hash_gets(dirents, "") != NULL);
+  SVN_TEST_ASSERT(svn_hash_gets(dirents, "A") == NULL);
+  SVN_TEST_ASSERT(svn_hash_gets(dirents, "B") != NULL);
+
+  /* The session is still usable. */
+  SVN_ERR(svn_ra_stat(ra_session, "B", 3, &dirent, pool));
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_dir);
+
+  return SVN_NO_ERROR;
+}
+
+/* List several directories at once. */
+static svn_error_t *
+get_dirs_test(const svn_test_opts_t *opts,
+              apr_pool_t *pool)
+{
+  svn_ra_session_t *ra_session;
+  apr_array_header_t *paths = apr_array_make(pool, 3, sizeof(const char *));
+  apr_hash_t *dirents;
+  apr_hash_t *entries;
+  svn_dirent_t *dirent;
+
+  SVN_ERR(make_and_open_repos(&ra_session, "test-repo-get-dirs", opts,
+                              pool));
+  SVN_ERR(commit_changes(ra_session, pool));
+  SVN_ERR(commit_two_changes(ra_session, pool));
+
+  APR_ARRAY_PUSH(paths, const char *) = "";
+  APR_ARRAY_PUSH(paths, const char *) = "A";
+  APR_ARRAY_PUSH(paths, const char *) = "B";
+
+  /* A got deleted in r3. */
+  SVN_ERR(svn_ra_get_dirs(ra_session, &dirents, paths, 2, SVN_DIRENT_ALL,
+                          pool, pool));
+  SVN_TEST_INT_ASSERT(apr_hash_count(dirents), 3);
+  entries = svn_hash_gets(dirents, "");
+  SVN_TEST_ASSERT(entries != NULL);
+  SVN_TEST_INT_ASSERT(apr_hash_count(entries), 2);
+  dirent = svn_hash_gets(entries, "A");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_dir);
+  SVN_TEST_INT_ASSERT(dirent->created_rev, 1);
+  dirent = svn_hash_gets(entries, "B");
+  SVN_TEST_ASSERT(dirent && dirent->kind == svn_node_dir);
+  SVN_TEST_INT_ASSERT(dirent->created_rev, 2);
+  entries = svn_hash_gets(dirents, "A");
+  SVN_TEST_ASSERT(entries && apr_hash_count(entries) == 0);
+  entries = svn_hash_gets(dirents, "B");
+  SVN_TEST_ASSERT(entries && apr_hash_count(entries) == 0);
+
+  SVN_TEST_ASSERT_ANY_ERROR(svn_ra_get_dirs(ra_session, &dirents, paths,
+                                            SVN_INVALID_REVNUM,
+                                            SVN_DIRENT_KIND, pool, pool));
+
+  apr_array_clear(paths);
+  APR_ARRAY_PUSH(paths, const char *) = "";
+  SVN_ERR(svn_ra_get_dirs(ra_session, &dirents, paths, SVN_INVALID_REVNUM,
+                          SVN_DIRENT_KIND, pool, pool));
+  entries = svn_hash_gets(dirents, "");
+  SVN_TEST_ASSERT(entries && apr_hash_count(entries) == 1);
+  SVN_TEST_ASSERT(svn_hash_gets(entries, "B") != NULL);
+
+  return SVN_NO_ERROR;
+}
+
+
 static struct svn_test_descriptor_t test_funcs[] =
   {
     SVN_TEST_NULL,
@@ -1917,6 +2106,12 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test get-deleted-rev no delete"),
     SVN_TEST_OPTS_PASS(test_get_deleted_rev_errors,
                        "test get-deleted-rev errors"),
+    SVN_TEST_OPTS_PASS(ra_cache_test,
+                       "test the persistent RA cache"),
+    SVN_TEST_OPTS_PASS(stat_many_test,
+                       "test svn_ra_stat_many"),
+    SVN_TEST_OPTS_PASS(get_dirs_test,
+                       "test svn_ra_get_dirs"),
     SVN_TEST_NULL
   };
 
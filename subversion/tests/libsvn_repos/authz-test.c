@@ -511,6 +511,183 @@ reposful_reposless_stanzas_inherit(apr_pool_t *pool)
    return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+cached_decisions(apr_pool_t *pool)
+{
+  const char rules[] =
+    "[/]"                    NL
+    "* = r"                  NL
+    ""                       NL
+    "[/secret]"              NL
+    "* ="                    NL
+    "user1 = rw"             NL
+    ""                       NL
+    "[/secret/public]"       NL
+    "* = r"                  NL
+    ""                       NL
+    "[/trunk/**/*.key]"      NL
+    "* ="                    NL;
+
+  const char *paths[] =
+    {
+      "/", "/trunk", "/trunk/a", "/trunk/a/b.key", "/trunk/a/c",
+      "/secret", "/secret/x/y", "/secret/public", "/secret/public/z",
+      "/secret/", "/trunk/b.key", "/other/deep/path", "/trunk/a/b.key/d"
+    };
+  const char *users[] = { "user1", "user2", NULL };
+  const svn_repos_authz_access_t checks[] =
+    {
+      svn_authz_read, svn_authz_write,
+      svn_authz_read | svn_authz_recursive,
+      svn_authz_write | svn_authz_recursive
+    };
+  const apr_size_t path_count = sizeof(paths) / sizeof(paths[0]);
+  const apr_size_t user_count = sizeof(users) / sizeof(users[0]);
+  const apr_size_t check_count = sizeof(checks) / sizeof(checks[0]);
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_authz_t *authz;
+  apr_size_t round, u, c, i;
+
+  SVN_ERR(svn_repos_authz_parse2(&authz,
+                                 svn_stream_from_string(
+                                   svn_string_create(rules, pool), pool),
+                                 NULL, NULL, NULL, pool, pool));
+
+  /* Results of the same AUTHZ, which remembers its previous decisions,
+   * in the second round and in any order must match those of a fresh
+   * instance. */
+  for (round = 0; round < 2; ++round)
+    for (u = 0; u < user_count; ++u)
+      for (c = 0; c < check_count; ++c)
+        for (i = 0; i < path_count; ++i)
+          {
+            const char *path = paths[round ? path_count - 1 - i : i];
+            svn_authz_t *fresh;
+            svn_boolean_t expected, granted;
+
+            svn_pool_clear(iterpool);
+            SVN_ERR(svn_repos_authz_parse2(&fresh,
+                                           svn_stream_from_string(
+                                             svn_string_create(rules,
+                                                               iterpool),
+                                             iterpool),
+                                           NULL, NULL, NULL,
+                                           iterpool, iterpool));
+
+            SVN_ERR(svn_repos_authz_check_access(fresh, "repo", path,
+                                                 users[u], checks[c],
+                                                 &expected, iterpool));
+            SVN_ERR(svn_repos_authz_check_access(authz, "repo", path,
+                                                 users[u], checks[c],
+                                                 &granted, iterpool));
+            if (granted != expected)
+              return svn_error_createf(SVN_ERR_TEST_FAILED, NULL,
+                                       "Cached check %d of '%s' for '%s' "
+                                       "returned %d instead of %d",
+                                       (int)checks[c], path,
+                                       users[u] ? users[u] : "(anonymous)",
+                                       granted, expected);
+          }
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_authz_cache(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  const char *srcdir;
+  const char *sandbox;
+  const char *cache_path;
+  svn_stream_t *rules;
+  svn_stream_t *groups;
+  authz_full_t *parsed;
+  authz_full_t *loaded;
+  svn_authz_t parsed_authz = { 0 };
+  svn_authz_t loaded_authz = { 0 };
+  svn_error_t *err;
+  apr_size_t u, r, p;
+
+  const char *users[] = { NULL, "a", "b", "c", "luser", "wunga" };
+  const char *repos[] = { "bloop", "blip", "" };
+  const char *paths[] =
+    {
+      "/", "/abc", "/xabc/def/x/y/z/ghi1jkl/mno/p", "/abc/def/1/2/ghi?jkl"
+    };
+
+  SVN_ERR(svn_test_get_srcdir(&srcdir, opts, pool));
+  SVN_ERR(svn_stream_open_readonly(&rules,
+                                   svn_dirent_join(srcdir, "authz.rules",
+                                                   pool),
+                                   pool, pool));
+  SVN_ERR(svn_stream_open_readonly(&groups,
+                                   svn_dirent_join(srcdir, "authz.groups",
+                                                   pool),
+                                   pool, pool));
+  SVN_ERR(svn_authz__parse(&parsed, rules, groups, NULL, NULL, pool, pool));
+
+  SVN_ERR(svn_test_make_sandbox_dir(&sandbox, "authz-cache", pool));
+  cache_path = svn_dirent_join(sandbox, "model", pool);
+
+  /* No cache file yet. */
+  SVN_ERR(svn_authz__read_cache(&loaded, cache_path, pool, pool));
+  SVN_TEST_ASSERT(loaded == NULL);
+
+  SVN_ERR(svn_authz__write_cache(parsed, cache_path, pool));
+  SVN_ERR(svn_authz__read_cache(&loaded, cache_path, pool, pool));
+  SVN_TEST_ASSERT(loaded != NULL);
+  SVN_TEST_INT_ASSERT(loaded->acls->nelts, parsed->acls->nelts);
+  SVN_TEST_INT_ASSERT(apr_hash_count(loaded->user_rights),
+                      apr_hash_count(parsed->user_rights));
+
+  /* Both models must grant the same rights. */
+  parsed_authz.full = parsed;
+  parsed_authz.pool = pool;
+  loaded_authz.full = loaded;
+  loaded_authz.pool = pool;
+
+  for (u = 0; u < sizeof(users) / sizeof(users[0]); ++u)
+    for (r = 0; r < sizeof(repos) / sizeof(repos[0]); ++r)
+      {
+        authz_rights_t expected, actual;
+        svn_boolean_t expected_explicit, actual_explicit;
+
+        expected_explicit = svn_authz__get_global_rights(&expected, parsed,
+                                                         users[u], repos[r]);
+        actual_explicit = svn_authz__get_global_rights(&actual, loaded,
+                                                       users[u], repos[r]);
+        SVN_TEST_ASSERT(expected_explicit == actual_explicit);
+        SVN_TEST_ASSERT(expected.min_access == actual.min_access);
+        SVN_TEST_ASSERT(expected.max_access == actual.max_access);
+
+        for (p = 0; p < sizeof(paths) / sizeof(paths[0]); ++p)
+          {
+            svn_boolean_t expected_access, actual_access;
+
+            SVN_ERR(svn_repos_authz_check_access(&parsed_authz, repos[r],
+                                                 paths[p], users[u],
+                                                 svn_authz_write,
+                                                 &expected_access, pool));
+            SVN_ERR(svn_repos_authz_check_access(&loaded_authz, repos[r],
+                                                 paths[p], users[u],
+                                                 svn_authz_write,
+                                                 &actual_access, pool));
+            SVN_TEST_ASSERT(expected_access == actual_access);
+          }
+      }
+
+  /* Damaged cache files must be detected. */
+  SVN_ERR(svn_io_write_atomic2(cache_path, "garbage", 7, NULL, FALSE,
+                               pool));
+  err = svn_authz__read_cache(&loaded, cache_path, pool, pool);
+  SVN_TEST_ASSERT(err != SVN_NO_ERROR);
+  svn_error_clear(err);
+
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = 4;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -524,6 +701,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "issue 4741 groups"),
     SVN_TEST_PASS2(reposful_reposless_stanzas_inherit,
                     "[foo:/] inherits [/]"),
+    SVN_TEST_PASS2(cached_decisions,
+                   "cached authz decisions"),
+    SVN_TEST_OPTS_PASS(test_authz_cache,
+                       "test svn_authz__write_cache and read_cache"),
     SVN_TEST_NULL
   };
 
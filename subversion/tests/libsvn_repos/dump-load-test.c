@@ -76,8 +76,8 @@ test_dump_bad_props(svn_stringbuf_t **dump_data_p,
   SVN_TEST_ASSERT(SVN_IS_VALID_REVNUM(youngest_rev));
 
   /* Test that a dump completes without error. */
-  SVN_ERR(svn_repos_dump_fs4(repos, stream, start_rev, end_rev,
-                             FALSE, FALSE, TRUE, TRUE,
+  SVN_ERR(svn_repos_dump_fs5(repos, stream, start_rev, end_rev,
+                             FALSE, FALSE, TRUE, TRUE, 1,
                              notify_func, notify_baton,
                              NULL, NULL, NULL, NULL,
                              pool));
@@ -120,7 +120,7 @@ test_load_bad_props(svn_stringbuf_t *dump_data,
   svn_revnum_t youngest_rev;
   svn_string_t *loaded_prop_val;
 
-  SVN_ERR(svn_repos_load_fs6(repos, stream,
+  SVN_ERR(svn_repos_load_fs7(repos, stream,
                              SVN_INVALID_REVNUM, SVN_INVALID_REVNUM,
                              svn_repos_load_uuid_default,
                              parent_fspath,
@@ -128,6 +128,7 @@ test_load_bad_props(svn_stringbuf_t *dump_data,
                              validate_props,
                              FALSE /*ignore_dates*/,
                              FALSE /*normalize_props*/,
+                             1 /*jobs*/,
                              notify_func, notify_baton,
                              NULL, NULL, /*cancellation*/
                              pool));
@@ -273,6 +274,87 @@ test_load_r0_mergeinfo(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+/* Dump revisions START_REV to END_REV of REPOS with deltas using JOBS
+ * threads and return the dump data in *DUMP_DATA_P. */
+static svn_error_t *
+dump_with_jobs(svn_stringbuf_t **dump_data_p,
+               svn_repos_t *repos,
+               svn_revnum_t start_rev,
+               svn_revnum_t end_rev,
+               int jobs,
+               apr_pool_t *pool)
+{
+  svn_stringbuf_t *dump_data = svn_stringbuf_create_empty(pool);
+  svn_stream_t *stream = svn_stream_from_stringbuf(dump_data, pool);
+
+  SVN_ERR(svn_repos_dump_fs5(repos, stream, start_rev, end_rev,
+                             FALSE, TRUE, TRUE, TRUE, jobs,
+                             NULL, NULL, NULL, NULL, NULL, NULL,
+                             pool));
+  SVN_ERR(svn_stream_close(stream));
+
+  *dump_data_p = dump_data;
+  return SVN_NO_ERROR;
+}
+
+/* Parallel dumps must produce exactly the same data as sequential ones. */
+static svn_error_t *
+test_dump_parallel(const svn_test_opts_t *opts,
+                   apr_pool_t *pool)
+{
+  svn_repos_t *repos;
+  svn_fs_t *fs;
+  svn_fs_txn_t *txn;
+  svn_fs_root_t *txn_root;
+  svn_revnum_t youngest_rev = 0;
+  svn_stringbuf_t *expected, *actual;
+  int i;
+
+  SVN_ERR(svn_test__create_repos(&repos, "test-repo-dump-parallel",
+                                 opts, pool));
+  fs = svn_repos_fs(repos);
+
+  /* r1: The Greek tree. */
+  SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+  SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+  SVN_ERR(svn_test__create_greek_tree(txn_root, pool));
+  SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn, pool));
+
+  /* r2 .. r9: Some file modifications and a copy. */
+  for (i = 0; i < 8; ++i)
+    {
+      SVN_ERR(svn_fs_begin_txn2(&txn, fs, youngest_rev, 0, pool));
+      SVN_ERR(svn_fs_txn_root(&txn_root, txn, pool));
+      SVN_ERR(svn_test__set_file_contents(txn_root,
+                                          i % 2 ? "A/mu" : "A/B/E/beta",
+                                          apr_psprintf(pool,
+                                                       "Version %d.\n", i),
+                                          pool));
+      if (i == 4)
+        {
+          svn_fs_root_t *rev_root;
+
+          SVN_ERR(svn_fs_revision_root(&rev_root, fs, youngest_rev, pool));
+          SVN_ERR(svn_fs_copy(rev_root, "A/D", txn_root, "A/D2", pool));
+        }
+
+      SVN_ERR(svn_repos_fs_commit_txn(NULL, repos, &youngest_rev, txn,
+                                      pool));
+    }
+
+  /* Full dump. */
+  SVN_ERR(dump_with_jobs(&expected, repos, 0, youngest_rev, 1, pool));
+  SVN_ERR(dump_with_jobs(&actual, repos, 0, youngest_rev, 4, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(expected, actual));
+
+  /* Partial dump, starting with a full tree. */
+  SVN_ERR(dump_with_jobs(&expected, repos, 3, youngest_rev, 1, pool));
+  SVN_ERR(dump_with_jobs(&actual, repos, 3, youngest_rev, 3, pool));
+  SVN_TEST_ASSERT(svn_stringbuf_compare(expected, actual));
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 4;
@@ -284,6 +366,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "test dumping with r0 mergeinfo"),
     SVN_TEST_OPTS_PASS(test_load_r0_mergeinfo,
                        "test loading with r0 mergeinfo"),
+    SVN_TEST_OPTS_PASS(test_dump_parallel,
+                       "test dumping with multiple threads"),
     SVN_TEST_NULL
   };
 
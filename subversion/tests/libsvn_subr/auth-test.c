@@ -459,6 +459,125 @@ test_save_cleartext(apr_pool_t *pool)
 
   return SVN_NO_ERROR;
 }
+
+/* Provider baton counting the calls of the counting provider. */
+struct counting_baton_t
+{
+  int nr_fetches;
+  int nr_saves;
+};
+
+/* Implements svn_auth_provider_t.first_credentials. */
+static svn_error_t *
+counting_first_creds(void **credentials,
+                     void **iter_baton,
+                     void *provider_baton,
+                     apr_hash_t *parameters,
+                     const char *realmstring,
+                     apr_pool_t *pool)
+{
+  struct counting_baton_t *b = provider_baton;
+  svn_auth_cred_simple_t *creds = apr_pcalloc(pool, sizeof(*creds));
+
+  creds->username = "jrandom";
+  creds->password = "rayjandom";
+  creds->may_save = TRUE;
+
+  b->nr_fetches++;
+  *credentials = creds;
+  *iter_baton = NULL;
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_auth_provider_t.save_credentials. */
+static svn_error_t *
+counting_save_creds(svn_boolean_t *saved,
+                    void *credentials,
+                    void *provider_baton,
+                    apr_hash_t *parameters,
+                    const char *realmstring,
+                    apr_pool_t *pool)
+{
+  struct counting_baton_t *b = provider_baton;
+
+  b->nr_saves++;
+  *saved = TRUE;
+
+  return SVN_NO_ERROR;
+}
+
+static const svn_auth_provider_t counting_provider = {
+  SVN_AUTH_CRED_SIMPLE,
+  counting_first_creds,
+  NULL,
+  counting_save_creds
+};
+
+static svn_error_t *
+test_creds_cache(apr_pool_t *pool)
+{
+  svn_auth_provider_object_t *provider;
+  svn_auth_baton_t *baton, *slave;
+  apr_array_header_t *providers;
+  void *credentials;
+  svn_auth_iterstate_t *state;
+  struct counting_baton_t cb = { 0 };
+
+  provider = apr_pcalloc(pool, sizeof(*provider));
+  provider->vtable = &counting_provider;
+  provider->provider_baton = &cb;
+
+  providers = apr_array_make(pool, 1, sizeof(svn_auth_provider_object_t *));
+  APR_ARRAY_PUSH(providers, svn_auth_provider_object_t *) = provider;
+
+  svn_auth_open(&baton, providers, pool);
+
+  /* Fetch and save once. */
+  SVN_ERR(svn_auth_first_credentials(&credentials, &state,
+                                     SVN_AUTH_CRED_SIMPLE, "realm",
+                                     baton, pool));
+  SVN_TEST_ASSERT(credentials != NULL);
+  SVN_ERR(svn_auth_save_credentials(state, pool));
+  SVN_TEST_INT_ASSERT(cb.nr_fetches, 1);
+  SVN_TEST_INT_ASSERT(cb.nr_saves, 1);
+
+  /* Another session gets the cached creds and doesn't save them again. */
+  SVN_ERR(svn_auth__make_session_auth(&slave, baton, NULL, "dummy",
+                                      pool, pool));
+  SVN_ERR(svn_auth_first_credentials(&credentials, &state,
+                                     SVN_AUTH_CRED_SIMPLE, "realm",
+                                     slave, pool));
+  SVN_TEST_ASSERT(credentials != NULL);
+  SVN_ERR(svn_auth_save_credentials(state, pool));
+  SVN_TEST_INT_ASSERT(cb.nr_fetches, 1);
+  SVN_TEST_INT_ASSERT(cb.nr_saves, 1);
+
+  /* Rejected creds get fetched again and the new ones are cached. */
+  SVN_ERR(svn_auth_next_credentials(&credentials, state, pool));
+  SVN_TEST_ASSERT(credentials != NULL);
+  SVN_TEST_INT_ASSERT(cb.nr_fetches, 2);
+  SVN_ERR(svn_auth_save_credentials(state, pool));
+  SVN_TEST_INT_ASSERT(cb.nr_saves, 2);
+
+  SVN_ERR(svn_auth_first_credentials(&credentials, &state,
+                                     SVN_AUTH_CRED_SIMPLE, "realm",
+                                     baton, pool));
+  SVN_TEST_ASSERT(credentials != NULL);
+  SVN_TEST_INT_ASSERT(cb.nr_fetches, 2);
+
+  /* Expired creds get fetched again. */
+  svn_auth__set_credentials_cache_ttl(baton, 1);
+  apr_sleep(1000);
+  SVN_ERR(svn_auth_first_credentials(&credentials, &state,
+                                     SVN_AUTH_CRED_SIMPLE, "realm",
+                                     baton, pool));
+  SVN_TEST_ASSERT(credentials != NULL);
+  SVN_TEST_INT_ASSERT(cb.nr_fetches, 3);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* The test table.  */
 
@@ -473,6 +592,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_auth_clear()"),
     SVN_TEST_PASS2(test_save_cleartext,
                    "test save cleartext info"),
+    SVN_TEST_PASS2(test_creds_cache,
+                   "test the in-memory credentials cache"),
     SVN_TEST_NULL
   };
 
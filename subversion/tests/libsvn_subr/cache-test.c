@@ -26,8 +26,15 @@
 #include <apr_general.h>
 #include <apr_lib.h>
 #include <apr_time.h>
+#include <apr_thread_proc.h>
+
+#if APR_HAS_FORK
+#include <unistd.h>   /* For _exit() */
+#endif
 
 #include "svn_pools.h"
+#include "svn_dirent_uri.h"
+#include "svn_io.h"
 
 #include "private/svn_cache.h"
 #include "svn_private_config.h"
@@ -156,6 +163,40 @@ basic_cache_test(svn_cache__t *cache,
   return SVN_NO_ERROR;
 }
 
+/* Store a few values in CACHE and look them up, together with some keys
+ * that aren't there, using a single svn_cache__get_many() call. */
+static svn_error_t *
+get_many_cache_test(svn_cache__t *cache,
+                    apr_pool_t *pool)
+{
+  svn_revnum_t twenty = 20, thirty = 30;
+  apr_array_header_t *keys = apr_array_make(pool, 5, sizeof(const void *));
+  apr_array_header_t *values;
+
+  SVN_ERR(svn_cache__set(cache, "twenty", &twenty, pool));
+  SVN_ERR(svn_cache__set(cache, "thirty", &thirty, pool));
+
+  APR_ARRAY_PUSH(keys, const void *) = "thirty";
+  APR_ARRAY_PUSH(keys, const void *) = "forty";
+  APR_ARRAY_PUSH(keys, const void *) = NULL;
+  APR_ARRAY_PUSH(keys, const void *) = "twenty";
+  APR_ARRAY_PUSH(keys, const void *) = "thirty";
+
+  SVN_ERR(svn_cache__get_many(&values, cache, keys, pool));
+
+  SVN_TEST_INT_ASSERT(values->nelts, keys->nelts);
+  SVN_TEST_ASSERT(APR_ARRAY_IDX(values, 0, svn_revnum_t *) != NULL);
+  SVN_TEST_INT_ASSERT(*APR_ARRAY_IDX(values, 0, svn_revnum_t *), 30);
+  SVN_TEST_ASSERT(APR_ARRAY_IDX(values, 1, svn_revnum_t *) == NULL);
+  SVN_TEST_ASSERT(APR_ARRAY_IDX(values, 2, svn_revnum_t *) == NULL);
+  SVN_TEST_ASSERT(APR_ARRAY_IDX(values, 3, svn_revnum_t *) != NULL);
+  SVN_TEST_INT_ASSERT(*APR_ARRAY_IDX(values, 3, svn_revnum_t *), 20);
+  SVN_TEST_ASSERT(APR_ARRAY_IDX(values, 4, svn_revnum_t *) != NULL);
+  SVN_TEST_INT_ASSERT(*APR_ARRAY_IDX(values, 4, svn_revnum_t *), 30);
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_inprocess_cache_basic(apr_pool_t *pool)
 {
@@ -203,6 +244,56 @@ test_memcache_basic(const svn_test_opts_t *opts,
   return basic_cache_test(cache, FALSE, pool);
 }
 
+static svn_error_t *
+test_memcache_get_many(const svn_test_opts_t *opts,
+                       apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_memcache_t *memcache = NULL;
+  const char *prefix = apr_psprintf(pool,
+                                    "test_memcache_get_many-%" APR_TIME_T_FMT,
+                                    apr_time_now());
+
+  SVN_ERR(create_memcache(&memcache, opts, pool, pool));
+  if (! memcache)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "not configured to use memcached");
+
+  SVN_ERR(svn_cache__create_memcache(&cache,
+                                     memcache,
+                                     serialize_revnum,
+                                     deserialize_revnum,
+                                     APR_HASH_KEY_STRING,
+                                     prefix,
+                                     pool));
+
+  return get_many_cache_test(cache, pool);
+}
+
+static svn_error_t *
+test_membuffer_get_many(apr_pool_t *pool)
+{
+  svn_cache__t *cache;
+  svn_membuffer_t *membuffer;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+                                            TRUE, TRUE, pool));
+
+  /* Membuffer caches look up one key after the other. */
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE,
+                                            FALSE,
+                                            pool, pool));
+
+  return get_many_cache_test(cache, pool);
+}
+
 static svn_error_t *
 test_membuffer_cache_basic(apr_pool_t *pool)
 {
@@ -590,6 +681,352 @@ test_membuffer_unaligned_fixed_keys(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Return the element of INFOS, an array of svn_cache__info_t *, with the
+ * given ID.  Return NULL if there is none. */
+static const svn_cache__info_t *
+find_prefix_info(const apr_array_header_t *infos,
+                 const char *id)
+{
+  int i;
+  for (i = 0; i < infos->nelts; ++i)
+    {
+      const svn_cache__info_t *info
+        = APR_ARRAY_IDX(infos, i, const svn_cache__info_t *);
+      if (strcmp(info->id, id) == 0)
+        return info;
+    }
+
+  return NULL;
+}
+
+static svn_error_t *
+test_membuffer_prefix_info(apr_pool_t *pool)
+{
+  svn_cache__t *cache_a, *cache_b, *cache_c;
+  svn_membuffer_t *membuffer;
+  apr_pool_t *subpool = svn_pool_create(pool);
+  apr_array_header_t *infos;
+  const svn_cache__info_t *info;
+  svn_revnum_t rev = 42;
+  svn_revnum_t *value;
+  svn_boolean_t found;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 10*1024, 1, 0,
+                                            TRUE, TRUE, pool));
+
+  /* Two instances of the same cache and an unrelated one. */
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache_a, membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "cache-a:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE,
+                                            subpool, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache_b, membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "cache-a:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE,
+                                            subpool, pool));
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache_c, membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            sizeof(rev),
+                                            "cache-c:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE,
+                                            subpool, pool));
+
+  SVN_ERR(svn_cache__set(cache_a, "one", &rev, pool));
+  SVN_ERR(svn_cache__set(cache_b, "two", &rev, pool));
+  SVN_ERR(svn_cache__get((void **)&value, &found, cache_b, "one", pool));
+  SVN_TEST_ASSERT(found);
+  SVN_ERR(svn_cache__get((void **)&value, &found, cache_a, "three", pool));
+  SVN_TEST_ASSERT(!found);
+
+  SVN_ERR(svn_cache__set(cache_c, &rev, &rev, pool));
+  SVN_ERR(svn_cache__get((void **)&value, &found, cache_c, &rev, pool));
+  SVN_TEST_ASSERT(found);
+
+  /* Destroying the cache front-ends must not lose any statistics. */
+  svn_pool_destroy(subpool);
+
+  infos = svn_cache__membuffer_get_prefix_info(membuffer, pool);
+  SVN_TEST_ASSERT(infos->nelts == 2);
+
+  info = find_prefix_info(infos, "cache-a:");
+  SVN_TEST_ASSERT(info);
+  SVN_TEST_ASSERT(info->gets == 2);
+  SVN_TEST_ASSERT(info->hits == 1);
+  SVN_TEST_ASSERT(info->sets == 2);
+  SVN_TEST_ASSERT(info->used_entries == 2);
+  SVN_TEST_ASSERT(info->used_size > 0);
+
+  info = find_prefix_info(infos, "cache-c:");
+  SVN_TEST_ASSERT(info);
+  SVN_TEST_ASSERT(info->gets == 1);
+  SVN_TEST_ASSERT(info->hits == 1);
+  SVN_TEST_ASSERT(info->sets == 1);
+  SVN_TEST_ASSERT(info->used_entries == 1);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_cache_shared(apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer;
+  svn_cache__t *cache;
+  svn_error_t *err;
+
+  err = svn_cache__membuffer_cache_create_shared(&membuffer, 10*1024, 1, 0,
+                                                 TRUE, pool);
+  if (err && err->apr_err == SVN_ERR_UNSUPPORTED_FEATURE)
+    {
+      svn_error_clear(err);
+      return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                              "shared caches are not supported");
+    }
+  SVN_ERR(err);
+
+  SVN_ERR(svn_cache__create_membuffer_cache(&cache,
+                                            membuffer,
+                                            serialize_revnum,
+                                            deserialize_revnum,
+                                            APR_HASH_KEY_STRING,
+                                            "cache:",
+                                            SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            TRUE,
+                                            FALSE,
+                                            pool, pool));
+
+  SVN_ERR(basic_cache_test(cache, FALSE, pool));
+
+#if APR_HAS_FORK
+  {
+    /* Entries added by a child process must be visible to the parent. */
+    apr_proc_t proc;
+    apr_exit_why_e why;
+    int exit_code;
+    svn_revnum_t *value;
+    svn_boolean_t found;
+    apr_status_t status = apr_proc_fork(&proc, pool);
+
+    if (status == APR_INCHILD)
+      {
+        svn_revnum_t forty = 40;
+
+        err = svn_cache__set(cache, "forty", &forty, pool);
+        _exit(err ? 1 : 0);
+      }
+
+    if (status != APR_INPARENT)
+      return svn_error_wrap_apr(status, "Can't fork");
+
+    status = apr_proc_wait(&proc, &exit_code, &why, APR_WAIT);
+    if (status != APR_CHILD_DONE)
+      return svn_error_wrap_apr(status, "Can't wait for child");
+
+    SVN_TEST_ASSERT(APR_PROC_CHECK_EXIT(why) && exit_code == 0);
+
+    SVN_ERR(svn_cache__get((void **)&value, &found, cache, "forty", pool));
+    SVN_TEST_ASSERT(found && *value == 40);
+  }
+#endif
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_persistent_cache(apr_pool_t *pool)
+{
+  svn_cache__persistent_t *store;
+  svn_cache__t *l1_cache, *cache;
+  const char *sandbox, *path, *copy_path;
+  apr_file_t *file;
+  apr_finfo_t finfo;
+  apr_off_t size;
+  svn_revnum_t *value;
+  svn_boolean_t found;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&sandbox, "cache-test-persistent",
+                                    pool));
+  path = svn_dirent_join(sandbox, "store", pool);
+  copy_path = svn_dirent_join(sandbox, "copy", pool);
+
+  SVN_ERR(svn_cache__get_persistent_store(&store, path, 0x10000, pool));
+  if (!store)
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "persistent caches require mmap support");
+
+  /* Only one entry fits into the first level. */
+  SVN_ERR(svn_cache__create_inprocess(&l1_cache,
+                                      serialize_revnum,
+                                      deserialize_revnum,
+                                      APR_HASH_KEY_STRING,
+                                      1, 1, FALSE, "", pool));
+  SVN_ERR(svn_cache__create_persistent(&cache, l1_cache, store,
+                                       serialize_revnum,
+                                       deserialize_revnum,
+                                       APR_HASH_KEY_STRING,
+                                       "revnums:", pool));
+  SVN_ERR(basic_cache_test(cache, FALSE, pool));
+
+  /* New entries only become visible to new instances of the file.
+   * Emulate one with a torn record left behind by a crashed process. */
+  SVN_ERR(svn_io_copy_file(path, copy_path, FALSE, pool));
+  SVN_ERR(svn_io_stat(&finfo, copy_path, APR_FINFO_SIZE, pool));
+  size = finfo.size;
+
+  SVN_ERR(svn_io_file_open(&file, copy_path, APR_WRITE | APR_APPEND,
+                           APR_OS_DEFAULT, pool));
+  SVN_ERR(svn_io_file_write_full(file, "\0\0\0\4\0\0", 6, NULL, pool));
+  SVN_ERR(svn_io_file_close(file, pool));
+
+  SVN_ERR(svn_cache__get_persistent_store(&store, copy_path, 0x10000,
+                                          pool));
+  SVN_ERR(svn_cache__create_inprocess(&l1_cache,
+                                      serialize_revnum,
+                                      deserialize_revnum,
+                                      APR_HASH_KEY_STRING,
+                                      1, 1, FALSE, "", pool));
+  SVN_ERR(svn_cache__create_persistent(&cache, l1_cache, store,
+                                       serialize_revnum,
+                                       deserialize_revnum,
+                                       APR_HASH_KEY_STRING,
+                                       "revnums:", pool));
+
+  SVN_ERR(svn_cache__get((void **)&value, &found, cache, "twenty", pool));
+  SVN_TEST_ASSERT(found && *value == 20);
+  SVN_ERR(svn_cache__get((void **)&value, &found, cache, "thirty", pool));
+  SVN_TEST_ASSERT(found && *value == 30);
+  SVN_ERR(svn_cache__get((void **)&value, &found, cache, "forty", pool));
+  SVN_TEST_ASSERT(!found);
+
+  /* Keys are specific to their prefix. */
+  SVN_ERR(svn_cache__create_persistent(&cache, l1_cache, store,
+                                       serialize_revnum,
+                                       deserialize_revnum,
+                                       APR_HASH_KEY_STRING,
+                                       "others:", pool));
+  SVN_ERR(svn_cache__has_key(&found, cache, "twenty", pool));
+  SVN_TEST_ASSERT(!found);
+
+  /* The torn record has been removed. */
+  SVN_ERR(svn_io_stat(&finfo, copy_path, APR_FINFO_SIZE, pool));
+  SVN_TEST_ASSERT(finfo.size == size);
+
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__partial_getter_func_t, returning a copy of the
+ * serialized item as an svn_stringbuf_t. */
+static svn_error_t *
+copy_partial_getter_func(void **out,
+                         const void *data,
+                         apr_size_t data_len,
+                         void *baton,
+                         apr_pool_t *result_pool)
+{
+  *out = svn_stringbuf_ncreate(data, data_len, result_pool);
+  return SVN_NO_ERROR;
+}
+
+/* Implements svn_cache__partial_setter_func_t, upper-casing the first
+ * character of a serialized svn_stringbuf_t in place. */
+static svn_error_t *
+upcase_partial_setter_func(void **data,
+                           apr_size_t *data_len,
+                           void *baton,
+                           apr_pool_t *result_pool)
+{
+  char *text = *data;
+  text[0] = (char)apr_toupper(text[0]);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_membuffer_cache_compression(apr_pool_t *pool)
+{
+  svn_membuffer_t *membuffer;
+  svn_cache__t *cache;
+  svn_cache__t *plain_cache;
+  svn_stringbuf_t *large = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *noise = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *small = svn_stringbuf_create("small", pool);
+  svn_stringbuf_t *value;
+  svn_boolean_t found;
+  apr_uint32_t seed = 1;
+  int i;
+
+  SVN_ERR(svn_cache__membuffer_cache_create(&membuffer, 1024*1024, 1, 0,
+                                            TRUE, TRUE, pool));
+
+  /* Store compressible and incompressible items above the threshold as
+   * well as one below it. */
+  SVN_ERR(svn_cache__create_membuffer_cache2(&cache, membuffer, NULL, NULL,
+                                             APR_HASH_KEY_STRING, "cache:",
+                                          SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                             1024, FALSE, FALSE,
+                                             pool, pool));
+
+  for (i = 0; i < 1000; ++i)
+    svn_stringbuf_appendcstr(large, "compressible line of text\n");
+  for (i = 0; i < 4096; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      svn_stringbuf_appendbyte(noise, (char)(seed >> 16));
+    }
+
+  SVN_ERR(svn_cache__set(cache, "large", large, pool));
+  SVN_ERR(svn_cache__set(cache, "noise", noise, pool));
+  SVN_ERR(svn_cache__set(cache, "small", small, pool));
+
+  SVN_ERR(svn_cache__get((void **)&value, &found, cache, "large", pool));
+  SVN_TEST_ASSERT(found && svn_stringbuf_compare(value, large));
+  SVN_ERR(svn_cache__get((void **)&value, &found, cache, "noise", pool));
+  SVN_TEST_ASSERT(found && svn_stringbuf_compare(value, noise));
+  SVN_ERR(svn_cache__get((void **)&value, &found, cache, "small", pool));
+  SVN_TEST_ASSERT(found && svn_stringbuf_compare(value, small));
+
+  /* Partial getters see the uncompressed item including the NUL. */
+  SVN_ERR(svn_cache__get_partial((void **)&value, &found, cache, "large",
+                                 copy_partial_getter_func, NULL, pool));
+  SVN_TEST_ASSERT(found && value->len == large->len + 1);
+  SVN_TEST_ASSERT(memcmp(value->data, large->data, large->len) == 0);
+  SVN_ERR(svn_cache__get_partial((void **)&value, &found, cache, "small",
+                                 copy_partial_getter_func, NULL, pool));
+  SVN_TEST_ASSERT(found && value->len == small->len + 1);
+
+  /* Partial setters modify compressed and uncompressed items alike. */
+  SVN_ERR(svn_cache__set_partial(cache, "large",
+                                 upcase_partial_setter_func, NULL, pool));
+  SVN_ERR(svn_cache__set_partial(cache, "small",
+                                 upcase_partial_setter_func, NULL, pool));
+
+  SVN_ERR(svn_cache__get((void **)&value, &found, cache, "large", pool));
+  SVN_TEST_ASSERT(found && value->len == large->len);
+  SVN_TEST_ASSERT(value->data[0] == 'C');
+  SVN_TEST_ASSERT(strcmp(value->data + 1, large->data + 1) == 0);
+  SVN_ERR(svn_cache__get((void **)&value, &found, cache, "small", pool));
+  SVN_TEST_ASSERT(found && strcmp(value->data, "Small") == 0);
+
+  /* Caches without compression don't see these entries. */
+  SVN_ERR(svn_cache__create_membuffer_cache(&plain_cache, membuffer,
+                                            NULL, NULL,
+                                            APR_HASH_KEY_STRING, "cache:",
+                                          SVN_CACHE__MEMBUFFER_DEFAULT_PRIORITY,
+                                            FALSE, FALSE, pool, pool));
+  SVN_ERR(svn_cache__get((void **)&value, &found, plain_cache, "small",
+                         pool));
+  SVN_TEST_ASSERT(!found);
+
+  return SVN_NO_ERROR;
+}
+
 
 /* The test table.  */
 
@@ -616,6 +1053,18 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test membuffer cache with unaligned string keys"),
     SVN_TEST_PASS2(test_membuffer_unaligned_fixed_keys,
                    "test membuffer cache with unaligned fixed keys"),
+    SVN_TEST_PASS2(test_membuffer_prefix_info,
+                   "test membuffer statistics per key prefix"),
+    SVN_TEST_PASS2(test_membuffer_cache_shared,
+                   "test membuffer cache in shared memory"),
+    SVN_TEST_PASS2(test_persistent_cache,
+                   "test persistent second-level svn_cache"),
+    SVN_TEST_OPTS_PASS(test_memcache_get_many,
+                       "memcache svn_cache multi-key lookup"),
+    SVN_TEST_PASS2(test_membuffer_get_many,
+                   "membuffer svn_cache multi-key lookup"),
+    SVN_TEST_PASS2(test_membuffer_cache_compression,
+                   "membuffer svn_cache with compressed items"),
     SVN_TEST_NULL
   };
 
@@ -28,6 +28,9 @@
 #include "svn_error.h"
 #include "svn_io.h"
 
+#include "private/svn_io_private.h"
+#include "private/svn_subr_private.h"
+
 #include "../svn_test.h"
 
 /* Verify that DIGEST of checksum type KIND can be parsed and
@@ -364,6 +367,52 @@ test_checksummed_stream_reset(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_multi_checksum_stream(apr_pool_t *pool)
+{
+  svn_stringbuf_t *data = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *copy = svn_stringbuf_create_empty(pool);
+  svn_checksum_t *expected_md5, *expected_sha1;
+  svn_checksum_t *md5 = NULL, *sha1 = NULL;
+  svn_stream_t *stream;
+  apr_size_t len;
+  int i;
+
+  /* Large enough to be processed in several slices. */
+  for (i = 0; i < 10000; ++i)
+    svn_stringbuf_appendcstr(data, "0123456789");
+
+  SVN_ERR(svn_checksum(&expected_md5, svn_checksum_md5,
+                       data->data, data->len, pool));
+  SVN_ERR(svn_checksum(&expected_sha1, svn_checksum_sha1,
+                       data->data, data->len, pool));
+
+  stream = svn_stream__checksummed_md5_sha1(
+             svn_stream_from_stringbuf(copy, pool), &md5, &sha1, pool);
+  len = data->len;
+  SVN_ERR(svn_stream_write(stream, data->data, &len));
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_TEST_ASSERT(svn_stringbuf_compare(data, copy));
+  SVN_TEST_ASSERT(svn_checksum_match(expected_md5, md5));
+  SVN_TEST_ASSERT(svn_checksum_match(expected_sha1, sha1));
+  SVN_TEST_ASSERT(md5->kind == svn_checksum_md5);
+  SVN_TEST_ASSERT(sha1->kind == svn_checksum_sha1);
+
+  /* Only one of the checksums requested. */
+  sha1 = NULL;
+  stream = svn_stream__checksummed_md5_sha1(svn_stream_empty(pool),
+                                            NULL, &sha1, pool);
+  len = data->len;
+  SVN_ERR(svn_stream_write(stream, data->data, &len));
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_TEST_ASSERT(svn_checksum_match(expected_sha1, sha1));
+  SVN_TEST_ASSERT(sha1->kind == svn_checksum_sha1);
+
+  return SVN_NO_ERROR;
+}
+
 /* An array of all test functions */
 
 static int max_threads = 1;
@@ -389,6 +438,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "read from checksummed stream"),
     SVN_TEST_PASS2(test_checksummed_stream_reset,
                    "reset checksummed stream"),
+    SVN_TEST_PASS2(test_multi_checksum_stream,
+                   "calculate MD5 and SHA-1 in one pass"),
     SVN_TEST_NULL
   };
 
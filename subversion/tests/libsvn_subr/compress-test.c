@@ -76,6 +76,74 @@ test_compress_lz4_empty(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_compress_zstd(apr_pool_t *pool)
+{
+  const char input[] =
+    "aaaabbbbccccaaaaccccbbbbaaaabbbb"
+    "aaaabbbbccccaaaaccccbbbbaaaabbbb"
+    "aaaabbbbccccaaaaccccbbbbaaaabbbb";
+  svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *decompressed = svn_stringbuf_create_empty(pool);
+  int level;
+
+  if (!svn_zstd__is_available())
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "Zstandard support not compiled in");
+
+  for (level = 1; level <= SVN__ZSTD_MAX_LEVEL; ++level)
+    {
+      SVN_ERR(svn__compress_zstd(input, sizeof(input), compressed, level));
+      SVN_TEST_ASSERT(compressed->len < sizeof(input));
+      SVN_ERR(svn__decompress_zstd(compressed->data, compressed->len,
+                                   decompressed, 100));
+      SVN_TEST_INT_ASSERT(decompressed->len, sizeof(input));
+      SVN_TEST_STRING_ASSERT(decompressed->data, input);
+    }
+
+  /* The decompressed size must not exceed the limit. */
+  SVN_TEST_ASSERT_ERROR(svn__decompress_zstd(compressed->data,
+                                             compressed->len,
+                                             decompressed, 50),
+                        SVN_ERR_SVNDIFF_INVALID_COMPRESSED_DATA);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_compress_zstd_incompressible(apr_pool_t *pool)
+{
+  char input[256];
+  svn_stringbuf_t *compressed = svn_stringbuf_create_empty(pool);
+  svn_stringbuf_t *decompressed = svn_stringbuf_create_empty(pool);
+  apr_uint32_t seed = 42;
+  apr_size_t i;
+
+  if (!svn_zstd__is_available())
+    return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                            "Zstandard support not compiled in");
+
+  for (i = 0; i < sizeof(input); ++i)
+    input[i] = (char)svn_test_rand(&seed);
+
+  /* Incompressible data gets stored as is, following the length header. */
+  SVN_ERR(svn__compress_zstd(input, sizeof(input), compressed,
+                             SVN__ZSTD_DEFAULT_LEVEL));
+  SVN_TEST_ASSERT(compressed->len > sizeof(input));
+  SVN_ERR(svn__decompress_zstd(compressed->data, compressed->len,
+                               decompressed, sizeof(input)));
+  SVN_TEST_INT_ASSERT(decompressed->len, sizeof(input));
+  SVN_TEST_ASSERT(memcmp(decompressed->data, input, sizeof(input)) == 0);
+
+  /* Same for empty input. */
+  SVN_ERR(svn__compress_zstd("", 0, compressed, SVN__ZSTD_DEFAULT_LEVEL));
+  SVN_ERR(svn__decompress_zstd(compressed->data, compressed->len,
+                               decompressed, 100));
+  SVN_TEST_STRING_ASSERT(decompressed->data, "");
+
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = -1;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -87,6 +155,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                  "test svn__compress_lz4()"),
   SVN_TEST_PASS2(test_compress_lz4_empty,
                  "test svn__compress_lz4() with empty input"),
+  SVN_TEST_PASS2(test_compress_zstd,
+                 "test svn__compress_zstd()"),
+  SVN_TEST_PASS2(test_compress_zstd_incompressible,
+                 "test svn__compress_zstd() with incompressible input"),
   SVN_TEST_NULL
 };
 
@@ -36,6 +36,7 @@
 #include "svn_dirent_uri.h"
 #include "svn_error.h"
 #include "svn_config.h"
+#include "svn_io.h"
 #include "private/svn_subr_private.h"
 #include "private/svn_config_private.h"
 
@@ -458,6 +459,38 @@ test_serialization(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_reread(apr_pool_t *pool)
+{
+  const char *sandbox;
+  const char *path;
+  svn_config_t *cfg;
+  const char *val;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&sandbox, "config-test-reread", pool));
+  path = svn_dirent_join(sandbox, "config", pool);
+
+  SVN_ERR(svn_io_file_create(path, "[section]\noption=value\n", pool));
+  SVN_ERR(svn_config_read3(&cfg, path, TRUE, FALSE, FALSE, pool));
+  svn_config_get(cfg, &val, "section", "option", NULL);
+  SVN_TEST_STRING_ASSERT(val, "value");
+
+  /* Changes to the result must not show up when reading the file again. */
+  svn_config_set(cfg, "section", "option", "changed");
+  SVN_ERR(svn_config_read3(&cfg, path, TRUE, FALSE, FALSE, pool));
+  svn_config_get(cfg, &val, "section", "option", NULL);
+  SVN_TEST_STRING_ASSERT(val, "value");
+
+  /* But changes to the file must. */
+  SVN_ERR(svn_io_remove_file2(path, FALSE, pool));
+  SVN_ERR(svn_io_file_create(path, "[section]\noption=new value\n", pool));
+  SVN_ERR(svn_config_read3(&cfg, path, TRUE, FALSE, FALSE, pool));
+  svn_config_get(cfg, &val, "section", "option", NULL);
+  SVN_TEST_STRING_ASSERT(val, "new value");
+
+  return SVN_NO_ERROR;
+}
+
 /*
    ====================================================================
    If you add a new test to this file, update this array.
@@ -494,6 +527,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test parsing config file with invalid BOM"),
     SVN_TEST_PASS2(test_serialization,
                    "test writing a config"),
+    SVN_TEST_PASS2(test_reread,
+                   "test reading a config file again"),
     SVN_TEST_NULL
   };
 
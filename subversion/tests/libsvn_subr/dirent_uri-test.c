@@ -885,6 +885,7 @@ static const testcase_canonicalize_t uri_canonical_tests[] =
     { "svn://server:3690/",    "svn://server" },
     { "svn://sERVER:3690/r",   "svn://server/r" },
     { "svn://server:/r",       "svn://server/r" },
+    { "svns://server:3691/",   "svns://server" },
     /* With non-default port number; both canonical and non-c. examples */
     { "http://server:1",       "http://server:1" },
     { "http://server:443",     "http://server:443" },
@@ -894,6 +895,8 @@ static const testcase_canonicalize_t uri_canonical_tests[] =
     { "https://SERVER:80/",    "https://server:80" },
     { "svn://server:80",       "svn://server:80" },
     { "svn://SERVER:443/",     "svn://server:443" },
+    { "svns://server:3690/",   "svns://server:3690" },
+    { "svn://server:3691",     "svn://server:3691" },
     { "file:///C%7C/temp/REPOS", "file:///C%7C/temp/REPOS" },
     { "file:///C|/temp/REPOS", "file:///C%7C/temp/REPOS" },
     { "file:///C:/",           "file:///C:" },
@@ -2890,6 +2893,53 @@ static struct cert_match_dns_test cert_match_dns_tests[] = {
   { NULL }
 };
 
+static svn_error_t *
+test_relpath_intern(apr_pool_t *pool)
+{
+  svn_relpath__intern_pool_t *ipool = svn_relpath__intern_pool_create(pool);
+  const svn_relpath__interned_t *root, *a, *ab, *abc, *abd, *ab2, *x;
+
+  abc = svn_relpath__intern(ipool, "a/b/c");
+  SVN_TEST_STRING_ASSERT(abc->data, "a/b/c");
+  SVN_TEST_INT_ASSERT(abc->len, 5);
+  SVN_TEST_INT_ASSERT(abc->depth, 3);
+
+  /* Ancestors got interned as well. */
+  ab = abc->parent;
+  a = ab->parent;
+  root = a->parent;
+  SVN_TEST_STRING_ASSERT(ab->data, "a/b");
+  SVN_TEST_STRING_ASSERT(a->data, "a");
+  SVN_TEST_STRING_ASSERT(root->data, "");
+  SVN_TEST_ASSERT(root->parent == NULL);
+  SVN_TEST_INT_ASSERT(root->depth, 0);
+
+  /* Same path, same object. */
+  SVN_TEST_ASSERT(svn_relpath__intern(ipool, "a/b") == ab);
+  SVN_TEST_ASSERT(svn_relpath__intern(ipool, "") == root);
+  SVN_TEST_ASSERT(svn_relpath__intern_join(ipool, ab, "c") == abc);
+  SVN_TEST_ASSERT(svn_relpath__intern_join(ipool, root, "a") == a);
+
+  abd = svn_relpath__intern_join(ipool, ab, "d");
+  SVN_TEST_STRING_ASSERT(abd->data, "a/b/d");
+  SVN_TEST_ASSERT(abd->parent == ab);
+
+  /* Not a path-wise child even though it is a string prefix. */
+  ab2 = svn_relpath__intern(ipool, "a/b2");
+  x = svn_relpath__intern(ipool, "x");
+
+  SVN_TEST_ASSERT(svn_relpath__interned_is_ancestor(root, abc));
+  SVN_TEST_ASSERT(svn_relpath__interned_is_ancestor(a, abc));
+  SVN_TEST_ASSERT(svn_relpath__interned_is_ancestor(ab, abc));
+  SVN_TEST_ASSERT(svn_relpath__interned_is_ancestor(abc, abc));
+  SVN_TEST_ASSERT(!svn_relpath__interned_is_ancestor(abc, ab));
+  SVN_TEST_ASSERT(!svn_relpath__interned_is_ancestor(abd, abc));
+  SVN_TEST_ASSERT(!svn_relpath__interned_is_ancestor(ab, ab2));
+  SVN_TEST_ASSERT(!svn_relpath__interned_is_ancestor(x, abc));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_cert_match_dns_identity(apr_pool_t *pool)
 {
@@ -3017,6 +3067,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_fspath__dirname/basename/split"),
     SVN_TEST_PASS2(test_fspath_get_longest_ancestor,
                    "test svn_fspath__get_longest_ancestor"),
+    SVN_TEST_PASS2(test_relpath_intern,
+                   "test interned relpaths"),
     SVN_TEST_PASS2(test_cert_match_dns_identity,
                    "test svn_cert__match_dns_identity"),
     SVN_TEST_XFAIL2(test_rule3,
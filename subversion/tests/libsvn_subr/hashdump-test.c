@@ -35,6 +35,10 @@
 #include "svn_string.h"
 #include "svn_error.h"
 #include "svn_hash.h"
+#include "svn_sorts.h"
+
+#include "private/svn_sorts_private.h"
+#include "private/svn_subr_private.h"
 
 
 /* Our own global variables */
@@ -230,6 +234,79 @@ read_hash_buffered_test(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+parse_in_place_test(apr_pool_t *pool)
+{
+  const char *text = "K 4\nkey3\nV 6\nvalue3\n"
+                     "K 4\nkey1\nV 0\n\n"
+                     "K 4\nkey2\nV 7\nval\nue2\n"
+                     "K 4\nkey1\nV 6\nvalue1\n"
+                     "END\n";
+  svn_stringbuf_t *buf;
+  apr_array_header_t *entries;
+  apr_hash_t *ht;
+  svn_sort__item_t *item;
+  svn_hash__entry_t *entry;
+
+  /* Entries come in order and point into the buffer. */
+  buf = svn_stringbuf_create(text, pool);
+  SVN_ERR(svn_hash__parse_entries(&entries, buf->data, buf->len,
+                                  SVN_HASH_TERMINATOR, FALSE, pool));
+  SVN_TEST_ASSERT(entries->nelts == 4);
+  entry = &APR_ARRAY_IDX(entries, 2, svn_hash__entry_t);
+  SVN_TEST_STRING_ASSERT(entry->key, "key2");
+  SVN_TEST_STRING_ASSERT(entry->val, "val\nue2");
+  SVN_TEST_ASSERT(entry->vallen == 7);
+  SVN_TEST_ASSERT(entry->key > buf->data && entry->key < buf->data + buf->len);
+
+  /* Hash mode, the last value wins. */
+  buf = svn_stringbuf_create(text, pool);
+  ht = apr_hash_make(pool);
+  SVN_ERR(svn_hash__parse(ht, buf->data, buf->len, SVN_HASH_TERMINATOR,
+                          pool));
+  SVN_TEST_ASSERT(apr_hash_count(ht) == 3);
+  SVN_TEST_STRING_ASSERT(hash_gets_stringt(ht, "key1"), "value1");
+  SVN_TEST_STRING_ASSERT(hash_gets_stringt(ht, "key2"), "val\nue2");
+  SVN_TEST_STRING_ASSERT(hash_gets_stringt(ht, "key3"), "value3");
+
+  /* Sorted mode. */
+  buf = svn_stringbuf_create(text, pool);
+  SVN_ERR(svn_hash__parse_sorted(&entries, buf->data, buf->len,
+                                 SVN_HASH_TERMINATOR, pool));
+  SVN_TEST_ASSERT(entries->nelts == 3);
+  item = &APR_ARRAY_IDX(entries, 0, svn_sort__item_t);
+  SVN_TEST_STRING_ASSERT(item[0].key, "key1");
+  SVN_TEST_STRING_ASSERT(((svn_string_t *)item[0].value)->data, "value1");
+  SVN_TEST_STRING_ASSERT(item[1].key, "key2");
+  SVN_TEST_STRING_ASSERT(item[2].key, "key3");
+  SVN_TEST_STRING_ASSERT(((svn_string_t *)item[2].value)->data, "value3");
+
+  /* Incremental mode and the end of the data as terminator. */
+  buf = svn_stringbuf_create("K 1\na\nV 1\nb\nD 1\na\n", pool);
+  SVN_ERR(svn_hash__parse_entries(&entries, buf->data, buf->len,
+                                  NULL, TRUE, pool));
+  SVN_TEST_ASSERT(entries->nelts == 2);
+  entry = &APR_ARRAY_IDX(entries, 1, svn_hash__entry_t);
+  SVN_TEST_STRING_ASSERT(entry->key, "a");
+  SVN_TEST_ASSERT(entry->val == NULL);
+
+  /* Malformed data. */
+  buf = svn_stringbuf_create("K 4\nkey\nV 1\nx\nEND\n", pool);
+  SVN_TEST_ASSERT_ERROR(svn_hash__parse_entries(&entries, buf->data,
+                                                buf->len,
+                                                SVN_HASH_TERMINATOR, FALSE,
+                                                pool),
+                        SVN_ERR_MALFORMED_FILE);
+  buf = svn_stringbuf_create("K 3\nkey\nV 1\nx\n", pool);
+  SVN_TEST_ASSERT_ERROR(svn_hash__parse_entries(&entries, buf->data,
+                                                buf->len,
+                                                SVN_HASH_TERMINATOR, FALSE,
+                                                pool),
+                        SVN_ERR_MALFORMED_FILE);
+
+  return SVN_NO_ERROR;
+}
+
 
 /*
    ====================================================================
@@ -252,6 +329,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "write hash out, read back in, compare"),
     SVN_TEST_PASS2(read_hash_buffered_test,
                    "read hash from buffered file"),
+    SVN_TEST_PASS2(parse_in_place_test,
+                   "parse hash in memory without copying"),
     SVN_TEST_NULL
   };
 
@@ -2480,6 +2480,85 @@ test_mergeinfo_merge_random_non_validated_inputs(apr_pool_t *pool)
 
   return SVN_NO_ERROR;
 }
+
+/* Fail if the packed rangelist ACTUAL differs from EXPECTED. */
+static svn_error_t *
+verify_packed_rangelist(const svn_rangelist__packed_t *actual,
+                        const svn_rangelist_t *expected,
+                        const char *func_verified,
+                        apr_pool_t *pool)
+{
+  const char *actual_str = rangelist_to_string(svn_rangelist__unpack(actual,
+                                                                     pool),
+                                               pool);
+  const char *expected_str = rangelist_to_string(expected, pool);
+
+  if (strcmp(actual_str, expected_str))
+    return fail(pool, "%s should return '%s' but returned '%s'",
+                func_verified, expected_str, actual_str);
+
+  return SVN_NO_ERROR;
+}
+
+/* Test the operations on packed rangelists against their counterparts
+ * on random canonical inputs. */
+static svn_error_t *
+test_rangelist_packed_random(apr_pool_t *pool)
+{
+  static apr_uint32_t seed = 0;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  svn_rangelist__packed_t *px = svn_rangelist__packed_create(0, pool);
+  svn_rangelist__packed_t *py = svn_rangelist__packed_create(0, pool);
+  svn_rangelist__packed_t *pout = svn_rangelist__packed_create(0, pool);
+  int i;
+
+  for (i = 0; i < 1000; i++)
+    {
+      svn_rangelist_t *rlx, *rly, *expected;
+
+      svn_pool_clear(iterpool);
+
+      rangelist_random_canonical(&rlx, &seed, iterpool);
+      rangelist_random_canonical(&rly, &seed, iterpool);
+      SVN_ERR(svn_rangelist__packed_set(px, rlx));
+      SVN_ERR(svn_rangelist__packed_set(py, rly));
+
+      expected = svn_rangelist_dup(rlx, iterpool);
+      SVN_ERR(svn_rangelist_merge2(expected, rly, iterpool, iterpool));
+      SVN_ERR(svn_rangelist__packed_merge(pout, px, py));
+      SVN_ERR(verify_packed_rangelist(pout, expected,
+                                      "svn_rangelist__packed_merge",
+                                      iterpool));
+
+      SVN_ERR(svn_rangelist_intersect(&expected, rlx, rly, FALSE, iterpool));
+      SVN_ERR(svn_rangelist__packed_intersect(pout, px, py, FALSE));
+      SVN_ERR(verify_packed_rangelist(pout, expected,
+                                      "svn_rangelist__packed_intersect",
+                                      iterpool));
+
+      SVN_ERR(svn_rangelist_remove(&expected, rlx, rly, FALSE, iterpool));
+      SVN_ERR(svn_rangelist__packed_remove(pout, px, py, FALSE));
+      SVN_ERR(verify_packed_rangelist(pout, expected,
+                                      "svn_rangelist__packed_remove",
+                                      iterpool));
+    }
+
+  /* With CONSIDER_INHERITANCE, only ranges of the same inheritability
+     get removed. */
+  SVN_ERR(svn_rangelist__packed_set(px, svn_rangelist__initialize(
+                                          36, 52, FALSE, pool)));
+  SVN_ERR(svn_rangelist__packed_set(py, svn_rangelist__initialize(
+                                          47, 58, TRUE, pool)));
+  SVN_ERR(svn_rangelist__packed_remove(pout, px, py, TRUE));
+  SVN_ERR(verify_packed_rangelist(pout,
+                                  svn_rangelist__initialize(47, 58, TRUE,
+                                                            pool),
+                                  "svn_rangelist__packed_remove", pool));
+
+  svn_pool_destroy(iterpool);
+
+  return SVN_NO_ERROR;
+}
 
 /* The test table.  */
 
@@ -2540,6 +2619,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test rangelist merge random non-validated inputs"),
     SVN_TEST_PASS2(test_mergeinfo_merge_random_non_validated_inputs,
                    "test mergeinfo merge random non-validated inputs"),
+    SVN_TEST_PASS2(test_rangelist_packed_random,
+                   "test packed rangelist operations"),
     SVN_TEST_NULL
   };
 
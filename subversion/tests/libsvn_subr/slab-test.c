@@ -0,0 +1,114 @@
+/*
+ * slab-test.c:  a collection of svn_slab__* tests
+ *
+ * ====================================================================
+ *    Licensed to the Apache Software Foundation (ASF) under one
+ *    or more contributor license agreements.  See the NOTICE file
+ *    distributed with this work for additional information
+ *    regarding copyright ownership.  The ASF licenses this file
+ *    to you under the Apache License, Version 2.0 (the
+ *    "License"); you may not use this file except in compliance
+ *    with the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing,
+ *    software distributed under the License is distributed on an
+ *    "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ *    KIND, either express or implied.  See the License for the
+ *    specific language governing permissions and limitations
+ *    under the License.
+ * ====================================================================
+ */
+
+/* ====================================================================
+   To add tests, look toward the bottom of this file.
+
+*/
+
+
+
+#include <stdio.h>
+#include <string.h>
+#include <apr_pools.h>
+#include <apr_hash.h>
+
+#include "../svn_test.h"
+
+#include "svn_error.h"
+#include "private/svn_subr_private.h"
+
+/* Number of objects to allocate in the tests.  Must span several slabs. */
+#define COUNT 10000
+
+static svn_error_t *
+test_alloc_distinct(apr_pool_t *pool)
+{
+  svn_slab__t *slab = svn_slab__create(3, pool);
+  char **objects = apr_palloc(pool, COUNT * sizeof(*objects));
+  int i;
+
+  /* All objects must be usable at the same time. */
+  for (i = 0; i < COUNT; ++i)
+    {
+      objects[i] = svn_slab__alloc(slab);
+      SVN_TEST_ASSERT(APR_ALIGN_DEFAULT((apr_uintptr_t)objects[i])
+                      == (apr_uintptr_t)objects[i]);
+      memset(objects[i], i & 0xff, 3);
+    }
+
+  for (i = 0; i < COUNT; ++i)
+    {
+      SVN_TEST_ASSERT(objects[i][0] == (char)(i & 0xff));
+      SVN_TEST_ASSERT(objects[i][2] == (char)(i & 0xff));
+    }
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_free_reuse(apr_pool_t *pool)
+{
+  svn_slab__t *slab = svn_slab__create(sizeof(apr_uint64_t), pool);
+  void **objects = apr_palloc(pool, COUNT * sizeof(*objects));
+  apr_hash_t *freed = apr_hash_make(pool);
+  int i;
+
+  for (i = 0; i < COUNT; ++i)
+    objects[i] = svn_slab__alloc(slab);
+
+  /* Release every other object. */
+  for (i = 0; i < COUNT; i += 2)
+    {
+      svn_slab__free(slab, objects[i]);
+      apr_hash_set(freed, &objects[i], sizeof(objects[i]), objects[i]);
+    }
+
+  /* These must be handed out again before any new memory gets used. */
+  for (i = 0; i < COUNT; i += 2)
+    {
+      void *object = svn_slab__alloc(slab);
+      SVN_TEST_ASSERT(apr_hash_get(freed, &object, sizeof(object)));
+      apr_hash_set(freed, &object, sizeof(object), NULL);
+    }
+
+  SVN_TEST_ASSERT(apr_hash_count(freed) == 0);
+
+  return SVN_NO_ERROR;
+}
+
+/* An array of all test functions */
+
+static int max_threads = 1;
+
+static struct svn_test_descriptor_t test_funcs[] =
+  {
+    SVN_TEST_NULL,
+    SVN_TEST_PASS2(test_alloc_distinct,
+                   "allocate distinct objects"),
+    SVN_TEST_PASS2(test_free_reuse,
+                   "reuse released objects"),
+    SVN_TEST_NULL
+  };
+
+SVN_TEST_MAIN
@@ -558,6 +558,44 @@ test_spillbuf_file_attrs_spill_all(apr_pool_t *pool)
   return test_spillbuf__file_attrs(pool, TRUE, buf);
 }
 
+static svn_error_t *
+test_spillbuf_write_behind(apr_pool_t *pool)
+{
+  svn_spillbuf_t *buf = svn_spillbuf__create(8 /* blocksize */,
+                                             8 /* maxsize */,
+                                             pool);
+  svn_filesize_t filesize;
+
+  SVN_ERR(svn_spillbuf__write(buf, "abcdef", 6, pool));
+  SVN_ERR(svn_spillbuf__write(buf, "ghi", 3, pool));
+  SVN_ERR(svn_spillbuf__write(buf, "jkl", 3, pool));
+  /* now: one block of 6 bytes, and 6 bytes pending for the spill file.  */
+
+  SVN_TEST_ASSERT(svn_spillbuf__get_file(buf) != NULL);
+  SVN_ERR(svn_io_file_size_get(&filesize, svn_spillbuf__get_file(buf), pool));
+  SVN_TEST_ASSERT(filesize == 0);
+  SVN_TEST_ASSERT(svn_spillbuf__get_memory_size(buf) == 12);
+
+  SVN_ERR(svn_spillbuf__write(buf, "mnopq", 5, pool));
+  /* now: one block of 6 bytes, 6 bytes in the spill file and 5 bytes
+     pending.  */
+
+  SVN_ERR(svn_io_file_size_get(&filesize, svn_spillbuf__get_file(buf), pool));
+  SVN_TEST_ASSERT(filesize == 6);
+  SVN_TEST_ASSERT(svn_spillbuf__get_memory_size(buf) == 11);
+
+  CHECK_READ(buf, 17, "abcdef", pool);
+  CHECK_READ(buf, 11, "ghijkl", pool);
+  /* The reader caught up, so the pending data comes from memory.  */
+  SVN_TEST_ASSERT(svn_spillbuf__get_file(buf) == NULL);
+
+  SVN_ERR(svn_spillbuf__write(buf, "rs", 2, pool));
+  CHECK_READ(buf, 7, "mnopqrs", pool);
+  SVN_TEST_ASSERT(svn_spillbuf__get_size(buf) == 0);
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 1;
@@ -589,6 +627,8 @@ static struct svn_test_descriptor_t test_funcs[] =
     SVN_TEST_PASS2(test_spillbuf_file_attrs, "check spill file properties"),
     SVN_TEST_PASS2(test_spillbuf_file_attrs_spill_all,
                    "check spill file properties (spill-all-data)"),
+    SVN_TEST_PASS2(test_spillbuf_write_behind,
+                   "collect small writes to the spill file"),
     SVN_TEST_NULL
   };
 
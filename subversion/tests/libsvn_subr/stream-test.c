@@ -29,6 +29,7 @@
 #include <apr_general.h>
 
 #include "private/svn_io_private.h"
+#include "private/svn_subr_private.h"
 
 #include "../svn_test.h"
 
@@ -1065,6 +1066,46 @@ test_stream_readline_file_nul(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_stream_read_buffer(apr_pool_t *pool)
+{
+  static const char data[] = "abcdefghijklmnopqrstuvwxyz0123456789"
+                             "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+  svn_string_t *str = svn_string_create(data, pool);
+  svn_stringbuf_t *copy = svn_stringbuf_create_empty(pool);
+  svn_spillbuf_t *buf = svn_spillbuf__create(16, 32, pool);
+  svn_checksum_t *expected, *actual;
+  svn_stream_t *stream;
+  const char *ptr;
+  apr_size_t len;
+
+  /* String streams hand out their contents without copying. */
+  stream = svn_stream_from_string(str, pool);
+  len = 10;
+  SVN_ERR(svn_stream__read_buffer(stream, &ptr, &len, NULL));
+  SVN_TEST_ASSERT(len == 10 && ptr == str->data);
+  len = 100;
+  SVN_ERR(svn_stream__read_buffer(stream, &ptr, &len, NULL));
+  SVN_TEST_ASSERT(len == str->len - 10 && ptr == str->data + 10);
+  SVN_ERR(svn_stream__read_buffer(stream, &ptr, &len, NULL));
+  SVN_TEST_ASSERT(len == 0);
+
+  /* Copy from a partly spilled spillbuf through a checksumming stream. */
+  SVN_ERR(svn_spillbuf__write(buf, data, sizeof(data) - 1, pool));
+  stream = svn_stream_checksummed2(svn_stream__from_spillbuf(buf, pool),
+                                   &actual, NULL, svn_checksum_md5, FALSE,
+                                   pool);
+  SVN_ERR(svn_stream_copy3(stream, svn_stream_from_stringbuf(copy, pool),
+                           NULL, NULL, pool));
+  SVN_TEST_STRING_ASSERT(copy->data, data);
+
+  SVN_ERR(svn_checksum(&expected, svn_checksum_md5, data, sizeof(data) - 1,
+                       pool));
+  SVN_TEST_ASSERT(svn_checksum_match(expected, actual));
+
+  return SVN_NO_ERROR;
+}
+
 /* The test table.  */
 
 static int max_threads = 1;
@@ -1104,6 +1145,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test reading CRLF-terminated lines from file"),
     SVN_TEST_PASS2(test_stream_readline_file_nul,
                    "test reading line from file with nul bytes"),
+    SVN_TEST_PASS2(test_stream_read_buffer,
+                   "test reading from stream buffers"),
     SVN_TEST_NULL
   };
 
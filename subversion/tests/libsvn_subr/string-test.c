@@ -872,6 +872,36 @@ test_string_matching(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_string_matching_long(apr_pool_t *pool)
+{
+  /* Long enough to cover several chunks of any word or vector size. */
+  enum { LEN = 100 };
+  char a[LEN];
+  char b[LEN];
+  apr_size_t len, mismatch;
+
+  for (len = 0; len < LEN; ++len)
+    a[len] = (char)('a' + len % 26);
+
+  /* Try every prefix length with every mismatch position as well as
+     without any mismatch. */
+  for (len = 0; len <= LEN; ++len)
+    for (mismatch = 0; mismatch <= len; ++mismatch)
+      {
+        memcpy(b, a, sizeof(b));
+        if (mismatch < len)
+          b[mismatch] = '_';
+
+        SVN_TEST_ASSERT(svn_cstring__match_length(a, b, len) == mismatch);
+        SVN_TEST_ASSERT(svn_cstring__reverse_match_length(a + len, b + len,
+                                                          len)
+                        == (mismatch < len ? len - mismatch - 1 : len));
+      }
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_cstring_skip_prefix(apr_pool_t *pool)
 {
@@ -1067,6 +1097,39 @@ test_cstring_join(apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_cstring_glob_list(apr_pool_t *pool)
+{
+  static const char * const patterns[] = {
+    "*.o", "*.lo", "*~", "#*#", ".*.swp", "Makefile", "build*",
+    "*.[ao]", "foo?bar", "\\*", NULL
+  };
+  static const char * const names[] = {
+    "a.o", ".o", "o", "a.lo", "a.l", "x~", "~", "#x#", "#", ".a.swp",
+    "a.swp", "Makefile", "Makefile.in", "build", "build-dir", "rebuild",
+    "lib.a", "foo-bar", "foobar", "*", "\\x", "", NULL
+  };
+  apr_array_header_t *arr = apr_array_make(pool, 0, sizeof(const char *));
+  svn_cstring__glob_list_t *list;
+  int i;
+
+  for (i = 0; patterns[i]; i++)
+    APR_ARRAY_PUSH(arr, const char *) = patterns[i];
+
+  list = svn_cstring__glob_list_create(arr, pool);
+  for (i = 0; names[i]; i++)
+    SVN_TEST_ASSERT(svn_cstring__glob_list_match(list, names[i])
+                    == svn_cstring_match_glob_list(names[i], arr));
+
+  /* A lone "*" matches everything. */
+  APR_ARRAY_PUSH(arr, const char *) = "*";
+  list = svn_cstring__glob_list_create(arr, pool);
+  for (i = 0; names[i]; i++)
+    SVN_TEST_ASSERT(svn_cstring__glob_list_match(list, names[i]));
+
+  return SVN_NO_ERROR;
+}
+
 /*
    ====================================================================
    If you add a new test to this file, update this array.
@@ -1141,6 +1204,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test string similarity scores"),
     SVN_TEST_PASS2(test_string_matching,
                    "test string matching"),
+    SVN_TEST_PASS2(test_string_matching_long,
+                   "test string matching with long strings"),
     SVN_TEST_PASS2(test_cstring_skip_prefix,
                    "test svn_cstring_skip_prefix()"),
     SVN_TEST_PASS2(test_stringbuf_replace_all,
@@ -1151,6 +1216,8 @@ static struct svn_test_descriptor_t test_funcs[] =
                    "test svn_stringbuf_set()"),
     SVN_TEST_PASS2(test_cstring_join,
                    "test svn_cstring_join2()"),
+    SVN_TEST_PASS2(test_cstring_glob_list,
+                   "test svn_cstring__glob_list_match()"),
     SVN_TEST_NULL
   };
 
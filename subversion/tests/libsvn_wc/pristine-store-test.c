@@ -542,6 +542,150 @@ pristine_dehydrate(const svn_test_opts_t *opts,
 }
 
 
+/* Install the same text into two working copies that share a pristine
+ * store and check that both end up with a link to the same file. */
+static svn_error_t *
+pristine_shared_store(const svn_test_opts_t *opts,
+                      apr_pool_t *pool)
+{
+  svn_wc__db_t *sandbox_db;
+  svn_wc__db_t *db;
+  svn_config_t *cfg;
+  const char *store_abspath;
+  const char *wc_abspath[2];
+  const char *pristine_abspath[2];
+  const char *shared_abspath;
+  svn_checksum_t *data_sha1, *data_md5;
+  const char data[] = "Blah";
+  apr_finfo_t finfo;
+  int i;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&store_abspath,
+                                    "pristine_shared_store", pool));
+  SVN_ERR(create_repos_and_wc(&wc_abspath[0], &sandbox_db,
+                              "pristine_shared_store_1", opts, pool));
+  SVN_ERR(create_repos_and_wc(&wc_abspath[1], &sandbox_db,
+                              "pristine_shared_store_2", opts, pool));
+
+  SVN_ERR(svn_config_create2(&cfg, FALSE, FALSE, pool));
+  svn_config_set(cfg, SVN_CONFIG_SECTION_WORKING_COPY,
+                 SVN_CONFIG_OPTION_SHARED_PRISTINE_STORE, store_abspath);
+  SVN_ERR(svn_wc__db_open(&db, cfg, FALSE, TRUE, pool, pool));
+
+  for (i = 0; i < 2; i++)
+    {
+      svn_wc__db_install_data_t *install_data;
+      svn_stream_t *pristine_stream;
+      svn_stream_t *data_read_back;
+      svn_boolean_t same;
+      apr_size_t sz;
+
+      SVN_ERR(svn_wc__db_pristine_prepare_install(&pristine_stream,
+                                                  &install_data,
+                                                  &data_sha1, &data_md5,
+                                                  db, wc_abspath[i], TRUE,
+                                                  pool, pool));
+      sz = strlen(data);
+      SVN_ERR(svn_stream_write(pristine_stream, data, &sz));
+      SVN_ERR(svn_stream_close(pristine_stream));
+      SVN_ERR(svn_wc__db_pristine_install(install_data,
+                                          data_sha1, data_md5, pool));
+
+      SVN_ERR(svn_wc__db_pristine_read(&data_read_back, NULL, db,
+                                       wc_abspath[i], data_sha1, pool, pool));
+      SVN_ERR(svn_stream_contents_same2(&same, data_read_back,
+                                        svn_stream_from_string(
+                                          svn_string_create(data, pool),
+                                          pool),
+                                        pool));
+      SVN_TEST_ASSERT(same);
+
+      SVN_ERR(svn_wc__db_pristine_get_future_path(&pristine_abspath[i],
+                                                  wc_abspath[i], data_sha1,
+                                                  pool, pool));
+    }
+
+  shared_abspath = svn_dirent_join_many(
+                     pool, store_abspath,
+                     apr_pstrndup(pool,
+                                  svn_checksum_to_cstring(data_sha1, pool), 2),
+                     apr_pstrcat(pool,
+                                 svn_checksum_to_cstring(data_sha1, pool),
+                                 ".svn-base", SVN_VA_NULL),
+                     SVN_VA_NULL);
+
+  /* The shared file and both pristine files are the same file. */
+  SVN_ERR(svn_io_stat(&finfo, shared_abspath, APR_FINFO_NLINK, pool));
+  SVN_TEST_INT_ASSERT(finfo.nlink, 3);
+
+  /* Dropping one working copy's link keeps the shared file around. */
+  SVN_ERR(svn_wc__db_pristine_dehydrate(db, wc_abspath[0], data_sha1, pool));
+  SVN_ERR(svn_io_stat(&finfo, shared_abspath, APR_FINFO_NLINK, pool));
+  SVN_TEST_INT_ASSERT(finfo.nlink, 2);
+
+  /* The text is unreferenced in the second working copy as well, so its
+     cleanup removes the last link and then the shared file. */
+  SVN_ERR(svn_wc__db_pristine_cleanup(db, wc_abspath[1], pool));
+  {
+    svn_node_kind_t kind;
+
+    SVN_ERR(svn_io_check_path(pristine_abspath[1], &kind, pool));
+    SVN_TEST_ASSERT(kind == svn_node_none);
+  }
+  {
+    svn_node_kind_t kind;
+
+    SVN_ERR(svn_io_check_path(shared_abspath, &kind, pool));
+    SVN_TEST_ASSERT(kind == svn_node_none);
+  }
+
+  return SVN_NO_ERROR;
+}
+
+/* Install an unreferenced text and check that the incremental cleanup
+ * removes it. */
+static svn_error_t *
+pristine_reclaim(const svn_test_opts_t *opts,
+                 apr_pool_t *pool)
+{
+  svn_wc__db_t *db;
+  const char *wc_abspath;
+  svn_wc__db_install_data_t *install_data;
+  svn_stream_t *pristine_stream;
+  svn_checksum_t *data_sha1, *data_md5;
+  svn_boolean_t present;
+  svn_boolean_t hydrated;
+  const char data[] = "Blah";
+  apr_size_t sz;
+
+  SVN_ERR(create_repos_and_wc(&wc_abspath, &db,
+                              "pristine_reclaim", opts, pool));
+
+  SVN_ERR(svn_wc__db_pristine_prepare_install(&pristine_stream,
+                                              &install_data,
+                                              &data_sha1, &data_md5,
+                                              db, wc_abspath, TRUE,
+                                              pool, pool));
+  sz = strlen(data);
+  SVN_ERR(svn_stream_write(pristine_stream, data, &sz));
+  SVN_ERR(svn_stream_close(pristine_stream));
+  SVN_ERR(svn_wc__db_pristine_install(install_data,
+                                      data_sha1, data_md5, pool));
+
+  SVN_ERR(svn_wc__db_pristine_check(&present, &hydrated, db, wc_abspath,
+                                    data_sha1, pool));
+  SVN_TEST_ASSERT(present);
+
+  SVN_ERR(svn_wc__db_pristine_reclaim(db, wc_abspath, NULL, NULL, pool));
+
+  SVN_ERR(svn_wc__db_pristine_check(&present, &hydrated, db, wc_abspath,
+                                    data_sha1, pool));
+  SVN_TEST_ASSERT(! present);
+  SVN_TEST_ASSERT(! hydrated);
+
+  return SVN_NO_ERROR;
+}
+
 static int max_threads = -1;
 
 static struct svn_test_descriptor_t test_funcs[] =
@@ -557,6 +701,10 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "pristine_install_dehydrated"),
     SVN_TEST_OPTS_PASS(pristine_dehydrate,
                        "pristine_dehydrate"),
+    SVN_TEST_OPTS_PASS(pristine_shared_store,
+                       "pristine_shared_store"),
+    SVN_TEST_OPTS_PASS(pristine_reclaim,
+                       "pristine_reclaim"),
     SVN_TEST_NULL
   };
 
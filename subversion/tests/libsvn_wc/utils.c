@@ -156,7 +156,8 @@ svn_test__create_fake_wc(const char *wc_abspath,
   SVN_ERR(svn_io_make_dir_recursively(dotsvn_abspath, scratch_pool));
   SVN_ERR(svn_wc__db_util_open_db(&sdb, wc_abspath, "wc.db",
                                   svn_sqlite__mode_rwcreate,
-                                  FALSE /* exclusive */, 0 /* timeout */,
+                                  FALSE /* exclusive */, FALSE /* wal */,
+                                  0 /* timeout */,
                                   my_statements,
                                   scratch_pool, scratch_pool));
   for (i = 0; my_statements[i] != NULL; i++)
@@ -170,7 +171,8 @@ svn_test__create_fake_wc(const char *wc_abspath,
   /* Re-open with normal set of statements */
   SVN_ERR(svn_wc__db_util_open_db(&sdb, wc_abspath, "wc.db",
                                   svn_sqlite__mode_readwrite,
-                                  FALSE /* exclusive */, 0 /* timeout */,
+                                  FALSE /* exclusive */, FALSE /* wal */,
+                                  0 /* timeout */,
                                   statements,
                                   scratch_pool, scratch_pool));
 
@@ -83,6 +83,9 @@ static const int schema_statements[] =
   STMT_CREATE_REVERT_LIST,
   STMT_CREATE_DELETE_LIST,
   STMT_CREATE_UPDATE_MOVE_LIST,
+  /* Created on demand */
+  STMT_CREATE_FILE_FINGERPRINTS,
+  STMT_CREATE_DETRANSLATED_CHECKSUMS,
   -1 /* final marker */
 };
 
@@ -110,10 +113,19 @@ static const int slow_statements[] =
    * STMT_DELETE_PRISTINE_IF_UNREFERENCED,
    */
   STMT_HAVE_STAT1_TABLE, /* Queries sqlite_master which has no index */
+  STMT_HAVE_FILE_FINGERPRINTS_TABLE, /* Likewise */
+  STMT_HAVE_DETRANSLATED_CHECKSUMS_TABLE, /* Likewise */
+
+  /* Full table scan, only while vacuuming */
+  STMT_DELETE_STALE_FILE_FINGERPRINTS,
+  STMT_DELETE_STALE_DETRANSLATED_CHECKSUMS,
 
   /* Currently uses a temporary B-tree for GROUP BY */
   STMT_TEXTBASE_SYNC,
 
+  /* Scans the pristine table, but only with a text-base cache */
+  STMT_SELECT_UNREFERENCED_TEXTBASES,
+
   -1 /* final marker */
 };
 
@@ -136,6 +148,7 @@ static const int primary_key_statements[] =
      and primary key instead of adding a list? */
   STMT_LOOK_FOR_WORK,
   STMT_SELECT_WORK_ITEM,
+  STMT_SELECT_WORK_ITEMS,
 
   -1 /* final marker */
 };
@@ -252,6 +265,7 @@ stmt_matches_wc_format(int stmt_num,
     case STMT_TEXTBASE_REMOVE_REF:
     case STMT_TEXTBASE_WALK:
     case STMT_TEXTBASE_SYNC:
+    case STMT_SELECT_UNREFERENCED_TEXTBASES:
     case STMT_SELECT_SETTINGS:
     case STMT_UPSERT_SETTINGS:
       return (wc_format >= 32);
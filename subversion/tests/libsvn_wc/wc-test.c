@@ -24,6 +24,7 @@
 #include <apr_pools.h>
 #include <apr_general.h>
 #include <apr_md5.h>
+#include <apr_strings.h>
 
 #define SVN_DEPRECATED
 
@@ -34,6 +35,7 @@
 #include "svn_repos.h"
 #include "svn_wc.h"
 #include "svn_client.h"
+#include "svn_config.h"
 #include "svn_hash.h"
 #include "svn_props.h"
 
@@ -44,6 +46,7 @@
 #include "private/svn_dep_compat.h"
 #include "../../libsvn_wc/wc.h"
 #include "../../libsvn_wc/wc_db.h"
+#include "../../libsvn_wc/write_behind.h"
 #define SVN_WC__I_AM_WC_DB
 #include "../../libsvn_wc/wc_db_private.h"
 
@@ -604,6 +607,64 @@ test_working_file_writer_eol_inconsistent(const svn_test_opts_t *opts,
   return SVN_NO_ERROR;
 }
 
+static svn_error_t *
+test_working_file_writer_write_behind(const svn_test_opts_t *opts,
+                                      apr_pool_t *pool)
+{
+  const char *tmp_dir;
+  svn_wc__write_behind_t *wb;
+  apr_pool_t *install_pool;
+  svn_wc__working_file_writer_t *writer;
+  svn_stream_t *stream;
+  const char *final_abspath;
+  svn_stringbuf_t *actual_content;
+  svn_stringbuf_t *expected_content;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+  int i;
+
+  SVN_ERR(svn_test_make_sandbox_dir(&tmp_dir,
+                                    "working_file_writer_write_behind",
+                                    pool));
+
+  SVN_ERR(svn_wc__write_behind_create(&wb, pool));
+  install_pool = svn_wc__write_behind_pool(wb, pool);
+
+  SVN_ERR(svn_wc__working_file_writer_open(&writer, tmp_dir, -1,
+                                           svn_subst_eol_style_fixed, "\r\n",
+                                           TRUE /* repair_eol */,
+                                           NULL, FALSE, FALSE,
+                                           FALSE,
+                                           install_pool, pool));
+
+  /* Write enough data for most of it to be written by the worker. */
+  stream = svn_wc__write_behind_stream(
+             wb, svn_wc__working_file_writer_get_stream(writer), pool);
+  expected_content = svn_stringbuf_create_empty(pool);
+  for (i = 0; i < 100000; i++)
+    {
+      svn_pool_clear(iterpool);
+
+      SVN_ERR(svn_stream_puts(stream,
+                              apr_psprintf(iterpool, "line %d\n", i)));
+      svn_stringbuf_appendcstr(expected_content,
+                               apr_psprintf(iterpool, "line %d\r\n", i));
+    }
+  svn_pool_destroy(iterpool);
+  SVN_ERR(svn_stream_close(stream));
+
+  SVN_ERR(svn_wc__working_file_writer_finalize(NULL, NULL, writer, pool));
+  final_abspath = svn_dirent_join(tmp_dir, "file", pool);
+  SVN_ERR(svn_wc__working_file_writer_install(writer, final_abspath, pool));
+
+  SVN_ERR(svn_stringbuf_from_file2(&actual_content,
+                                   final_abspath,
+                                   pool));
+
+  SVN_TEST_ASSERT(svn_stringbuf_compare(actual_content, expected_content));
+
+  return SVN_NO_ERROR;
+}
+
 static svn_error_t *
 test_internal_file_modified_keywords(const svn_test_opts_t *opts,
                                      apr_pool_t *pool)
@@ -817,6 +878,495 @@ test_get_pristine_copy_path(const svn_test_opts_t *opts, apr_pool_t *pool)
   return SVN_NO_ERROR;
 }
 
+/* Baton for collect_status_path(). */
+typedef struct status_paths_baton_t
+{
+  const char *wc_abspath;
+  apr_array_header_t *paths;
+} status_paths_baton_t;
+
+/* Implements svn_wc_status_func4_t.  Append the path of LOCAL_ABSPATH
+   relative to the working copy root to the list in BATON. */
+static svn_error_t *
+collect_status_path(void *baton,
+                    const char *local_abspath,
+                    const svn_wc_status3_t *status,
+                    apr_pool_t *scratch_pool)
+{
+  status_paths_baton_t *spb = baton;
+
+  APR_ARRAY_PUSH(spb->paths, const char *)
+    = apr_pstrdup(spb->paths->pool,
+                  svn_dirent_skip_ancestor(spb->wc_abspath, local_abspath));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_walk_status_order(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  status_paths_baton_t spb;
+  const char *expected[] = { "", "A", "A/B", "A/B/C", "A/B/C/f1", "A/B/u",
+                             "A/D", "A/D/f2", "E", "E/f3", "E/x", "iota" };
+  int i;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "walk_status_order", opts, pool));
+
+  SVN_ERR(sbox_wc_mkdir(&b, "A"));
+  SVN_ERR(sbox_wc_mkdir(&b, "A/B"));
+  SVN_ERR(sbox_wc_mkdir(&b, "A/B/C"));
+  SVN_ERR(sbox_wc_mkdir(&b, "A/D"));
+  SVN_ERR(sbox_wc_mkdir(&b, "E"));
+  SVN_ERR(sbox_file_write(&b, "A/B/C/f1", "f1\n"));
+  SVN_ERR(sbox_wc_add(&b, "A/B/C/f1"));
+  SVN_ERR(sbox_file_write(&b, "A/D/f2", "f2\n"));
+  SVN_ERR(sbox_wc_add(&b, "A/D/f2"));
+  SVN_ERR(sbox_file_write(&b, "E/f3", "f3\n"));
+  SVN_ERR(sbox_wc_add(&b, "E/f3"));
+  SVN_ERR(sbox_file_write(&b, "iota", "iota\n"));
+  SVN_ERR(sbox_wc_add(&b, "iota"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  /* Unversioned nodes are reported, but not descended into. */
+  SVN_ERR(sbox_file_write(&b, "A/B/u", "u\n"));
+  SVN_ERR(sbox_disk_mkdir(&b, "E/x"));
+  SVN_ERR(sbox_file_write(&b, "E/x/y", "y\n"));
+  SVN_ERR(sbox_file_write(&b, "A/D/f2", "modified\n"));
+
+  /* The directories get read ahead by other threads, but the statuses
+     must still arrive in depth-first order. */
+  spb.wc_abspath = b.wc_abspath;
+  spb.paths = apr_array_make(pool, 0, sizeof(const char *));
+  SVN_ERR(svn_wc_walk_status(b.wc_ctx, b.wc_abspath, svn_depth_infinity,
+                             TRUE /* get_all */, FALSE /* no_ignore */,
+                             FALSE /* ignore_text_mods */,
+                             NULL /* ignore_patterns */,
+                             collect_status_path, &spb,
+                             NULL, NULL, pool));
+
+  SVN_TEST_INT_ASSERT(spb.paths->nelts,
+                      sizeof(expected) / sizeof(expected[0]));
+  for (i = 0; i < spb.paths->nelts; i++)
+    SVN_TEST_STRING_ASSERT(APR_ARRAY_IDX(spb.paths, i, const char *),
+                           expected[i]);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_find_commit_candidates(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  apr_array_header_t *candidates;
+  const char *expected[] = { "", "A/B/n", "A/D/f2", "E", "iota" };
+  int i;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "find_commit_candidates", opts,
+                                   pool));
+
+  SVN_ERR(sbox_wc_mkdir(&b, "A"));
+  SVN_ERR(sbox_wc_mkdir(&b, "A/B"));
+  SVN_ERR(sbox_wc_mkdir(&b, "A/D"));
+  SVN_ERR(sbox_wc_mkdir(&b, "E"));
+  SVN_ERR(sbox_file_write(&b, "A/B/f1", "f1\n"));
+  SVN_ERR(sbox_wc_add(&b, "A/B/f1"));
+  SVN_ERR(sbox_file_write(&b, "A/D/f2", "f2\n"));
+  SVN_ERR(sbox_wc_add(&b, "A/D/f2"));
+  SVN_ERR(sbox_file_write(&b, "iota", "iota\n"));
+  SVN_ERR(sbox_wc_add(&b, "iota"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  /* One change of every kind; unversioned nodes are no candidates. */
+  SVN_ERR(sbox_file_write(&b, "A/D/f2", "modified\n"));
+  SVN_ERR(sbox_wc_propset(&b, "p", "v", "E"));
+  SVN_ERR(sbox_wc_delete(&b, "iota"));
+  SVN_ERR(sbox_file_write(&b, "A/B/n", "n\n"));
+  SVN_ERR(sbox_wc_add(&b, "A/B/n"));
+  SVN_ERR(sbox_file_write(&b, "A/B/u", "u\n"));
+
+  SVN_ERR(svn_wc__find_commit_candidates(&candidates, b.wc_ctx,
+                                         b.wc_abspath, NULL, NULL,
+                                         pool, pool));
+
+  SVN_TEST_ASSERT(candidates != NULL);
+  SVN_TEST_INT_ASSERT(candidates->nelts,
+                      sizeof(expected) / sizeof(expected[0]));
+  for (i = 0; i < candidates->nelts; i++)
+    SVN_TEST_STRING_ASSERT(
+      svn_dirent_skip_ancestor(b.wc_abspath,
+                               APR_ARRAY_IDX(candidates, i, const char *)),
+      expected[i]);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_revision_status_fast(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_wc_revision_status_t *res;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "revision_status_fast", opts, pool));
+
+  SVN_ERR(sbox_wc_mkdir(&b, "A"));
+  SVN_ERR(sbox_file_write(&b, "A/f", "f\n"));
+  SVN_ERR(sbox_wc_add(&b, "A/f"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+  SVN_ERR(sbox_wc_update(&b, "", 1));
+
+  SVN_ERR(svn_wc__revision_status_fast(&res, b.wc_ctx, b.wc_abspath, NULL,
+                                       FALSE, NULL, NULL, pool, pool));
+  SVN_TEST_INT_ASSERT(res->min_rev, 1);
+  SVN_TEST_INT_ASSERT(res->max_rev, 1);
+  SVN_TEST_ASSERT(!res->modified);
+
+  /* Unversioned nodes don't count. */
+  SVN_ERR(sbox_file_write(&b, "A/u", "u\n"));
+  SVN_ERR(svn_wc__revision_status_fast(&res, b.wc_ctx, b.wc_abspath, NULL,
+                                       FALSE, NULL, NULL, pool, pool));
+  SVN_TEST_ASSERT(!res->modified);
+
+  SVN_ERR(sbox_file_write(&b, "A/f", "modified\n"));
+  SVN_ERR(svn_wc__revision_status_fast(&res, b.wc_ctx, b.wc_abspath, NULL,
+                                       FALSE, NULL, NULL, pool, pool));
+  SVN_TEST_ASSERT(res->modified);
+
+  return SVN_NO_ERROR;
+}
+
+/* Baton for get_text_status(). */
+typedef struct text_status_baton_t
+{
+  const char *target_abspath;
+  enum svn_wc_status_kind text_status;
+} text_status_baton_t;
+
+/* Implements svn_wc_status_func4_t.  Store the text status of
+   BATON->TARGET_ABSPATH in BATON. */
+static svn_error_t *
+get_text_status(void *baton,
+                const char *local_abspath,
+                const svn_wc_status3_t *status,
+                apr_pool_t *scratch_pool)
+{
+  text_status_baton_t *tsb = baton;
+
+  if (strcmp(tsb->target_abspath, local_abspath) == 0)
+    tsb->text_status = status->text_status;
+
+  return SVN_NO_ERROR;
+}
+
+/* Set *TEXT_STATUS to the text status of RELPATH as reported by a status
+   walk of the whole working copy of B, using WC_CTX. */
+static svn_error_t *
+walk_text_status(enum svn_wc_status_kind *text_status,
+                 svn_test__sandbox_t *b,
+                 svn_wc_context_t *wc_ctx,
+                 const char *relpath,
+                 apr_pool_t *pool)
+{
+  text_status_baton_t tsb;
+
+  tsb.target_abspath = sbox_wc_path(b, relpath);
+  tsb.text_status = svn_wc_status_none;
+  SVN_ERR(svn_wc_walk_status(wc_ctx, b->wc_abspath, svn_depth_infinity,
+                             TRUE /* get_all */, FALSE /* no_ignore */,
+                             FALSE /* ignore_text_mods */,
+                             NULL /* ignore_patterns */,
+                             get_text_status, &tsb,
+                             NULL, NULL, pool));
+
+  *text_status = tsb.text_status;
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_walk_status_fsmonitor(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+#ifdef WIN32
+  return svn_error_create(SVN_ERR_TEST_SKIPPED, NULL,
+                          "Test requires a POSIX shell");
+#else
+  svn_test__sandbox_t b;
+  svn_config_t *cfg;
+  svn_wc_context_t *wc_ctx;
+  const char *hook_path, *changes_path;
+  enum svn_wc_status_kind text_status;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "walk_status_fsmonitor", opts, pool));
+
+  SVN_ERR(sbox_wc_mkdir(&b, "A"));
+  SVN_ERR(sbox_file_write(&b, "A/f", "f\n"));
+  SVN_ERR(sbox_wc_add(&b, "A/f"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  /* A monitor that reports the paths listed in CHANGES_PATH. */
+  changes_path = apr_pstrcat(pool, b.wc_abspath, "-changes", SVN_VA_NULL);
+  hook_path = apr_pstrcat(pool, b.wc_abspath, "-hook", SVN_VA_NULL);
+  SVN_ERR(svn_io_file_create(hook_path,
+                             apr_psprintf(pool,
+                                          "#!/bin/sh\n"
+                                          "printf 'token\\000'\n"
+                                          "if test -z \"$2\"; then\n"
+                                          "  printf '/\\000'\n"
+                                          "elif test -f '%s'; then\n"
+                                          "  tr '\\n' '\\000' < '%s'\n"
+                                          "fi\n",
+                                          changes_path, changes_path),
+                             pool));
+  SVN_ERR(svn_io_set_file_executable(hook_path, TRUE, FALSE, pool));
+
+  SVN_ERR(svn_config_create2(&cfg, FALSE, FALSE, pool));
+  svn_config_set(cfg, SVN_CONFIG_SECTION_WORKING_COPY,
+                 SVN_CONFIG_OPTION_FSMONITOR_HOOK, hook_path);
+  SVN_ERR(svn_wc_context_create(&wc_ctx, cfg, pool, pool));
+
+  /* The first walk has to scan everything. */
+  SVN_ERR(walk_text_status(&text_status, &b, wc_ctx, "A/f", pool));
+  SVN_TEST_INT_ASSERT(text_status, svn_wc_status_normal);
+
+  /* Changes that the monitor does not report go unnoticed ... */
+  SVN_ERR(sbox_file_write(&b, "A/f", "changed\n"));
+  SVN_ERR(walk_text_status(&text_status, &b, wc_ctx, "A/f", pool));
+  SVN_TEST_INT_ASSERT(text_status, svn_wc_status_normal);
+
+  /* ... unless there is no monitor ... */
+  SVN_ERR(walk_text_status(&text_status, &b, b.wc_ctx, "A/f", pool));
+  SVN_TEST_INT_ASSERT(text_status, svn_wc_status_modified);
+
+  /* ... or the monitor reports them. */
+  SVN_ERR(svn_io_file_create(changes_path, "A/f\n", pool));
+  SVN_ERR(walk_text_status(&text_status, &b, wc_ctx, "A/f", pool));
+  SVN_TEST_INT_ASSERT(text_status, svn_wc_status_modified);
+
+  return SVN_NO_ERROR;
+#endif
+}
+
+static svn_error_t *
+test_read_info_node_cache(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_wc__db_t *db;
+  svn_wc__db_status_t status;
+  svn_node_kind_t kind;
+  svn_revnum_t revision;
+  svn_boolean_t props_mod;
+  svn_boolean_t have_base;
+  svn_error_t *err;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "read_info_node_cache", opts, pool));
+  db = b.wc_ctx->db;
+
+  SVN_ERR(sbox_wc_mkdir(&b, "A"));
+  SVN_ERR(sbox_wc_mkdir(&b, "A/B"));
+  SVN_ERR(sbox_file_write(&b, "A/f", "f\n"));
+  SVN_ERR(sbox_wc_add(&b, "A/f"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+  SVN_ERR(sbox_wc_delete(&b, "A/B"));
+  SVN_ERR(sbox_wc_mkdir(&b, "A/C"));
+
+  SVN_ERR(svn_wc__db_cache_nodes(db, sbox_wc_path(&b, "A"), pool));
+
+  /* Nodes of the cached subtree, including nodes with multiple layers */
+  SVN_ERR(svn_wc__db_read_info(&status, &kind, &revision, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, &props_mod, &have_base, NULL, NULL,
+                               db, sbox_wc_path(&b, "A/f"), pool, pool));
+  SVN_TEST_INT_ASSERT(status, svn_wc__db_status_normal);
+  SVN_TEST_INT_ASSERT(kind, svn_node_file);
+  SVN_TEST_INT_ASSERT(revision, 1);
+  SVN_TEST_ASSERT(!props_mod && have_base);
+
+  SVN_ERR(svn_wc__db_read_info(&status, &kind, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, &have_base, NULL, NULL,
+                               db, sbox_wc_path(&b, "A/B"), pool, pool));
+  SVN_TEST_INT_ASSERT(status, svn_wc__db_status_deleted);
+  SVN_TEST_ASSERT(have_base);
+
+  SVN_ERR(svn_wc__db_read_info(&status, &kind, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, &have_base, NULL, NULL,
+                               db, sbox_wc_path(&b, "A/C"), pool, pool));
+  SVN_TEST_INT_ASSERT(status, svn_wc__db_status_added);
+  SVN_TEST_ASSERT(!have_base);
+
+  /* Nodes that don't exist */
+  err = svn_wc__db_read_info(&status, NULL, NULL, NULL, NULL, NULL,
+                             NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                             NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                             NULL, NULL, NULL, NULL, NULL, NULL,
+                             db, sbox_wc_path(&b, "A/g"), pool, pool);
+  SVN_TEST_ASSERT_ERROR(err, SVN_ERR_WC_PATH_NOT_FOUND);
+
+  /* Modifying the working copy invalidates the cache */
+  SVN_ERR(sbox_wc_propset(&b, "p", "v", "A/f"));
+  SVN_ERR(svn_wc__db_read_info(NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                               NULL, NULL, &props_mod, NULL, NULL, NULL,
+                               db, sbox_wc_path(&b, "A/f"), pool, pool));
+  SVN_TEST_ASSERT(props_mod);
+
+  SVN_ERR(svn_wc__db_uncache_nodes(db, b.wc_abspath, pool));
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_wq_run_file_installs(const svn_test_opts_t *opts, apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  const svn_test__tree_entry_t *node;
+  apr_pool_t *iterpool = svn_pool_create(pool);
+
+  SVN_ERR(svn_test__sandbox_create(&b, "wq_run_file_installs", opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  /* Let the work queue install all files again, in a single batch */
+  SVN_ERR(sbox_wc_update(&b, "", 0));
+  SVN_ERR(sbox_wc_update(&b, "", 1));
+
+  for (node = svn_test__greek_tree_nodes; node->path; node++)
+    {
+      const char *local_abspath;
+      svn_stringbuf_t *contents;
+      svn_filesize_t recorded_size;
+      apr_time_t recorded_time;
+
+      if (!node->contents)
+        continue;
+
+      svn_pool_clear(iterpool);
+      local_abspath = sbox_wc_path(&b, node->path);
+
+      SVN_ERR(svn_stringbuf_from_file2(&contents, local_abspath, iterpool));
+      SVN_TEST_STRING_ASSERT(contents->data, node->contents);
+
+      /* The file info of every install got recorded */
+      SVN_ERR(svn_wc__db_read_info(NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, NULL, NULL, NULL,
+                                   &recorded_size, &recorded_time,
+                                   NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                   NULL, b.wc_ctx->db, local_abspath,
+                                   iterpool, iterpool));
+      SVN_TEST_INT_ASSERT(recorded_size, strlen(node->contents));
+      SVN_TEST_ASSERT(recorded_time != 0);
+    }
+
+  svn_pool_destroy(iterpool);
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_internal_file_modified_fingerprint(const svn_test_opts_t *opts,
+                                        apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_boolean_t modified;
+  const char *iota_path;
+  const svn_checksum_t *fingerprint;
+  apr_time_t time;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "internal_file_modified_fingerprint",
+                                   opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+
+  /* Installing the working files records their fingerprints */
+  SVN_ERR(sbox_wc_update(&b, "", 0));
+  SVN_ERR(sbox_wc_update(&b, "", 1));
+
+  iota_path = sbox_wc_path(&b, "iota");
+
+  SVN_ERR(svn_wc__db_read_fingerprint(&fingerprint, b.wc_ctx->db, iota_path,
+                                      strlen("This is the file 'iota'.\n"),
+                                      pool, pool));
+  SVN_TEST_ASSERT(fingerprint != NULL);
+  SVN_TEST_ASSERT(fingerprint->kind == svn_checksum_fnv1a_32x4);
+
+  /* A fingerprint for a different size is never valid */
+  SVN_ERR(svn_wc__db_read_fingerprint(&fingerprint, b.wc_ctx->db, iota_path,
+                                      1, pool, pool));
+  SVN_TEST_ASSERT(fingerprint == NULL);
+
+  /* Touched, but not modified. */
+  SVN_ERR(svn_io_file_affected_time(&time, iota_path, pool));
+  SVN_ERR(svn_io_set_file_affected_time(time + apr_time_from_sec(1),
+                                        iota_path, pool));
+  SVN_ERR(svn_wc__internal_file_modified_p(&modified, b.wc_ctx->db,
+                                           iota_path, FALSE, pool));
+  SVN_TEST_ASSERT(!modified);
+
+  /* Modified without changing the size. */
+  SVN_ERR(sbox_file_write(&b, iota_path, "This is the file 'IOTA'.\n"));
+  SVN_ERR(svn_io_set_file_affected_time(time + apr_time_from_sec(2),
+                                        iota_path, pool));
+  SVN_ERR(svn_wc__internal_file_modified_p(&modified, b.wc_ctx->db,
+                                           iota_path, FALSE, pool));
+  SVN_TEST_ASSERT(modified);
+
+  return SVN_NO_ERROR;
+}
+
+static svn_error_t *
+test_internal_file_modified_detranslated(const svn_test_opts_t *opts,
+                                         apr_pool_t *pool)
+{
+  svn_test__sandbox_t b;
+  svn_boolean_t modified;
+  const char *iota_path;
+  apr_time_t time;
+
+  SVN_ERR(svn_test__sandbox_create(&b, "internal_file_modified_detranslated",
+                                   opts, pool));
+  SVN_ERR(sbox_add_and_commit_greek_tree(&b));
+  SVN_ERR(sbox_wc_propset(&b, SVN_PROP_EOL_STYLE, "native", "iota"));
+  SVN_ERR(sbox_wc_commit(&b, ""));
+
+  /* A local property change keeps fingerprints out of the picture. */
+  SVN_ERR(sbox_wc_propset(&b, "p", "v", "iota"));
+
+  iota_path = sbox_wc_path(&b, "iota");
+
+  /* Detranslating the modified file records its checksum. */
+  SVN_ERR(sbox_file_write(&b, "iota", "This is the file 'IOTA'.\n"));
+  SVN_ERR(svn_io_file_affected_time(&time, iota_path, pool));
+  time += apr_time_from_sec(2);
+  SVN_ERR(svn_io_set_file_affected_time(time, iota_path, pool));
+  SVN_ERR(svn_wc__internal_file_modified_p(&modified, b.wc_ctx->db,
+                                           iota_path, FALSE, pool));
+  SVN_TEST_ASSERT(modified);
+
+  /* As long as size and timestamp don't change, the recorded checksum
+     is being used instead of the actual contents. */
+  SVN_ERR(sbox_file_write(&b, "iota", "This is the file 'iota'.\n"));
+  SVN_ERR(svn_io_set_file_affected_time(time, iota_path, pool));
+  SVN_ERR(svn_wc__internal_file_modified_p(&modified, b.wc_ctx->db,
+                                           iota_path, FALSE, pool));
+  SVN_TEST_ASSERT(modified);
+
+  /* But not for exact comparisons. */
+  SVN_ERR(svn_wc__internal_file_modified_p(&modified, b.wc_ctx->db,
+                                           iota_path, TRUE, pool));
+  SVN_TEST_ASSERT(!modified);
+
+  /* A new timestamp makes us read the file again. */
+  SVN_ERR(svn_io_set_file_affected_time(time + apr_time_from_sec(1),
+                                        iota_path, pool));
+  SVN_ERR(svn_wc__internal_file_modified_p(&modified, b.wc_ctx->db,
+                                           iota_path, FALSE, pool));
+  SVN_TEST_ASSERT(!modified);
+
+  return SVN_NO_ERROR;
+}
+
 /* ---------------------------------------------------------------------- */
 /* The list of test functions */
 
@@ -845,12 +1395,30 @@ static struct svn_test_descriptor_t test_funcs[] =
                        "working file writer eol repair"),
     SVN_TEST_OPTS_PASS(test_working_file_writer_eol_inconsistent,
                        "working file writer eol inconsistent"),
+    SVN_TEST_OPTS_PASS(test_working_file_writer_write_behind,
+                       "working file writer with write-behind"),
     SVN_TEST_OPTS_PASS(test_internal_file_modified_keywords,
                        "test internal_file_modified with keywords"),
     SVN_TEST_OPTS_PASS(test_internal_file_modified_eol_style,
                        "test internal_file_modified with eol-style"),
     SVN_TEST_OPTS_PASS(test_get_pristine_copy_path,
                        "test svn_wc_get_pristine_copy_path"),
+    SVN_TEST_OPTS_PASS(test_walk_status_order,
+                       "test svn_wc_walk_status order"),
+    SVN_TEST_OPTS_PASS(test_walk_status_fsmonitor,
+                       "test svn_wc_walk_status with fsmonitor-hook"),
+    SVN_TEST_OPTS_PASS(test_read_info_node_cache,
+                       "test svn_wc__db_read_info with node cache"),
+    SVN_TEST_OPTS_PASS(test_wq_run_file_installs,
+                       "test running file installs from the work queue"),
+    SVN_TEST_OPTS_PASS(test_internal_file_modified_fingerprint,
+                       "test internal_file_modified with a fingerprint"),
+    SVN_TEST_OPTS_PASS(test_internal_file_modified_detranslated,
+                       "test internal_file_modified with translation"),
+    SVN_TEST_OPTS_PASS(test_find_commit_candidates,
+                       "test svn_wc__find_commit_candidates"),
+    SVN_TEST_OPTS_PASS(test_revision_status_fast,
+                       "test svn_wc__revision_status_fast"),
     SVN_TEST_NULL
   };
 
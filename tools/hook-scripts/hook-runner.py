@@ -0,0 +1,217 @@
+#!/usr/bin/env python
+#
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+#
+
+"""\
+A persistent runner for Subversion repository hooks.
+
+Usage:
+
+   hook-runner.py [-p MODULE[,MODULE...]] [-l LOCKFILE] [HOST:]PORT
+
+Listen on HOST:PORT (localhost by default) for hook invocations sent by
+the Subversion server when the [hook-runner] section of the repository's
+hooks-env file lists the hook.  Hook scripts written in Python are run
+in a forked copy of this process, so they don't pay for the interpreter
+startup and the import of the MODULEs given with -p.  All other hooks
+are started as usual.
+
+Hooks that the server sends as asynchronous (see the 'async-hooks'
+option) are acknowledged right away and then run one at a time, in
+the order in which they arrived.  LOCKFILE (default: a file in the
+system's temporary directory) serializes them.
+
+Protocol:
+
+   Every field is a netstring, i.e. '<length>:<bytes>,'.  The server
+   sends the protocol version '1', the mode 'run' or 'queue', the hook
+   name, the path of the hook program, the number of arguments followed
+   by the arguments, the number of environment variables followed by
+   the variables as 'NAME=VALUE' and finally the standard input of the
+   hook.  The runner answers with the exit code, the standard output and
+   the standard error output of the hook and closes the connection.
+"""
+
+import fcntl
+import getopt
+import importlib
+import io
+import os
+import runpy
+import socketserver
+import subprocess
+import sys
+import tempfile
+
+
+def read_netstring(rfile):
+  length = b''
+  while True:
+    c = rfile.read(1)
+    if not c:
+      raise EOFError('truncated request')
+    if c == b':':
+      break
+    length += c
+  data = rfile.read(int(length))
+  if rfile.read(1) != b',':
+    raise ValueError('malformed netstring')
+  return data
+
+
+def netstring(data):
+  return str(len(data)).encode() + b':' + data + b','
+
+
+def is_python_script(path):
+  if path.endswith('.py'):
+    return True
+  try:
+    with open(path, 'rb') as f:
+      first_line = f.readline()
+  except IOError:
+    return False
+  return first_line.startswith(b'#!') and b'python' in first_line
+
+
+def run_python_hook(path, args, env, stdin):
+  """Run the Python script PATH in a forked child with sys.argv set to
+  ARGS, return (exitcode, stdout, stderr)."""
+
+  out = tempfile.TemporaryFile()
+  err = tempfile.TemporaryFile()
+  pid = os.fork()
+  if pid == 0:
+    exitcode = 0
+    try:
+      os.dup2(out.fileno(), 1)
+      os.dup2(err.fileno(), 2)
+      os.environ.clear()
+      os.environ.update(env)
+      sys.argv = args
+      sys.stdin = io.TextIOWrapper(io.BytesIO(stdin))
+      runpy.run_path(path, run_name='__main__')
+    except SystemExit as e:
+      if e.code is None:
+        exitcode = 0
+      elif isinstance(e.code, int):
+        exitcode = e.code
+      else:
+        sys.stderr.write('%s\n' % (e.code,))
+        exitcode = 1
+    except BaseException:
+      import traceback
+      traceback.print_exc()
+      exitcode = 1
+    sys.stdout.flush()
+    sys.stderr.flush()
+    os._exit(exitcode)
+
+  exitcode = os.waitpid(pid, 0)[1]
+  exitcode = os.WEXITSTATUS(exitcode) if os.WIFEXITED(exitcode) else 1
+  out.seek(0)
+  err.seek(0)
+  return exitcode, out.read(), err.read()
+
+
+def run_hook(path, args, env, stdin):
+  if is_python_script(path):
+    return run_python_hook(path, args, env, stdin)
+
+  proc = subprocess.Popen(args, executable=path, env=env,
+                          stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                          stderr=subprocess.PIPE)
+  out, err = proc.communicate(stdin)
+  return proc.returncode, out, err
+
+
+class HookHandler(socketserver.StreamRequestHandler):
+  def handle(self):
+    rfile = self.rfile
+    if read_netstring(rfile) != b'1':
+      raise ValueError('unsupported protocol version')
+    mode = read_netstring(rfile)
+    name = read_netstring(rfile).decode()
+    path = os.fsdecode(read_netstring(rfile))
+    args = [os.fsdecode(read_netstring(rfile))
+            for i in range(int(read_netstring(rfile)))]
+    env = dict(os.fsdecode(read_netstring(rfile)).split('=', 1)
+               for i in range(int(read_netstring(rfile))))
+    stdin = read_netstring(rfile)
+
+    if mode == b'queue':
+      # Let the server go on and run the hook when it is our turn.
+      self.wfile.write(netstring(b'0') + netstring(b'') + netstring(b''))
+      self.wfile.flush()
+      self.request.close()
+      with open(self.server.lockfile, 'a') as lock:
+        fcntl.flock(lock, fcntl.LOCK_EX)
+        exitcode, out, err = run_hook(path, args, env, stdin)
+      if exitcode:
+        sys.stderr.write("'%s' hook failed (exit code %d):\n%s\n"
+                         % (name, exitcode, err.decode(errors='replace')))
+      return
+
+    exitcode, out, err = run_hook(path, args, env, stdin)
+    self.wfile.write(netstring(str(exitcode).encode())
+                     + netstring(out) + netstring(err))
+
+
+class HookServer(socketserver.ForkingTCPServer):
+  allow_reuse_address = True
+
+
+def usage_and_exit(errmsg=None):
+  stream = errmsg and sys.stderr or sys.stdout
+  stream.write(__doc__)
+  if errmsg:
+    stream.write('\nERROR: %s\n' % errmsg)
+  sys.exit(errmsg and 1 or 0)
+
+
+def main():
+  try:
+    opts, args = getopt.getopt(sys.argv[1:], 'hp:l:',
+                               ['help', 'preload=', 'lockfile='])
+  except getopt.GetoptError as e:
+    usage_and_exit(str(e))
+
+  lockfile = os.path.join(tempfile.gettempdir(), 'svn-hook-runner.lock')
+  for opt, value in opts:
+    if opt in ('-h', '--help'):
+      usage_and_exit()
+    elif opt in ('-p', '--preload'):
+      for module in value.split(','):
+        importlib.import_module(module)
+    elif opt in ('-l', '--lockfile'):
+      lockfile = value
+
+  if len(args) != 1:
+    usage_and_exit('Not enough arguments.')
+
+  host, _, port = args[0].rpartition(':')
+  server = HookServer((host or 'localhost', int(port)), HookHandler)
+  server.lockfile = lockfile
+  server.serve_forever()
+
+
+if __name__ == '__main__':
+  main()
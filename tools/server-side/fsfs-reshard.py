@@ -27,6 +27,11 @@
 # same 'large number of files in a directory' problem that sharding is
 # intended to solve.
 #
+# For repositories that are already sharded, 'svnfsfs reshard' is usually
+# the better choice.  It supports packed and logically addressed (format 7)
+# repositories, processes shards in parallel and works on a copy, so that
+# the repository only needs to be offline for the final swap.
+#
 # ====================================================================
 #    Licensed to the Apache Software Foundation (ASF) under one
 #    or more contributor license agreements.  See the NOTICE file